@@ -146,6 +146,20 @@ bishop_matching_state_t BishopMapper::get_current_state(
                                                                const Task& task)
 //------------------------------------------------------------------------------
 {
+  MatchKey key;
+  key.state = curr_state;
+  key.task_id = task.task_id;
+  key.proc_kind = task.target_proc.exists() ? task.target_proc.kind()
+                                            : Processor::NO_KIND;
+  std::map<MatchKey, bishop_matching_state_t>::const_iterator finder =
+    match_cache.find(key);
+  if (finder != match_cache.end())
+  {
+    log_bishop.debug("[get_current_state] state %d --> state %d (cached)",
+        curr_state, finder->second);
+    return finder->second;
+  }
+
   bishop_matching_state_t prev_state = curr_state;
   legion_task_t task_ = CObjectWrapper::wrap_const(&task);
   while (true)
@@ -157,9 +171,19 @@ bishop_matching_state_t BishopMapper::get_current_state(
     prev_state = curr_state;
   }
 
+  match_cache[key] = curr_state;
   return curr_state;
 }
 
+//------------------------------------------------------------------------------
+bool BishopMapper::MatchKey::operator<(const MatchKey& rhs) const
+//------------------------------------------------------------------------------
+{
+  if (state != rhs.state) return state < rhs.state;
+  if (task_id != rhs.task_id) return task_id < rhs.task_id;
+  return proc_kind < rhs.proc_kind;
+}
+
 }; // namespace Mapping
 
 }; // namespace Legion
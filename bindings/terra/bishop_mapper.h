@@ -57,8 +57,20 @@ namespace Legion {
         bishop_matching_state_t get_current_state(bishop_matching_state_t prev_state,
                                                   const Task& task);
       private:
+        // Transitions only inspect the task ID and the ISA of the target
+        // processor, so the matching state reached from a given tag can
+        // be memoized on these three values.
+        struct MatchKey {
+          bishop_matching_state_t state;
+          TaskID task_id;
+          Processor::Kind proc_kind;
+
+          bool operator<(const MatchKey& rhs) const;
+        };
+
         std::vector<bishop_mapper_impl_t> mapper_impls;
         std::vector<bishop_transition_fn_t> transitions;
+        std::map<MatchKey, bishop_matching_state_t> match_cache;
 
         bishop_mapper_state_init_fn_t mapper_init;
         bishop_mapper_state_t mapper_state;
@@ -32,7 +32,8 @@ Logger log_circuit("circuit");
 void parse_input_args(char **argv, int argc, int &num_loops, int &num_pieces,
                       int &nodes_per_piece, int &wires_per_piece,
                       int &pct_wire_in_piece, int &random_seed,
-                      int &steps, int &sync, bool &perform_checks, bool &dump_values);
+                      int &steps, int &sync, bool &perform_checks, bool &dump_values,
+                      bool &use_tracing);
 
 Partitions load_circuit(Circuit &ckt, std::vector<CircuitPiece> &pieces, Context ctx,
                         Runtime *runtime, int num_pieces, int nodes_per_piece,
@@ -57,6 +58,7 @@ void top_level_task(const Task *task,
   int sync = 0;
   bool perform_checks = false;
   bool dump_values = false;
+  bool use_tracing = false;
   {
     const InputArgs &command_args = Runtime::get_input_args();
     char **argv = command_args.argv;
@@ -64,12 +66,12 @@ void top_level_task(const Task *task,
 
     parse_input_args(argv, argc, num_loops, num_pieces, nodes_per_piece, 
 		     wires_per_piece, pct_wire_in_piece, random_seed,
-		     steps, sync, perform_checks, dump_values);
+		     steps, sync, perform_checks, dump_values, use_tracing);
 
     log_circuit.print("circuit settings: loops=%d pieces=%d nodes/piece=%d "
-                            "wires/piece=%d pct_in_piece=%d seed=%d",
+                            "wires/piece=%d pct_in_piece=%d seed=%d tracing=%d",
        num_loops, num_pieces, nodes_per_piece, wires_per_piece,
-       pct_wire_in_piece, random_seed);
+       pct_wire_in_piece, random_seed, use_tracing ? 1 : 0);
   }
 
   Circuit circuit;
@@ -135,6 +137,11 @@ void top_level_task(const Task *task,
   bool simulation_success = true;
   for (int i = 0; i < num_loops; i++)
   {
+    // The checks launch a data-dependent number of tasks and the last
+    // iteration waits on its results, so neither can be traced.
+    const bool trace_iter = use_tracing && !perform_checks && ((i+1) < num_loops);
+    if (trace_iter)
+      runtime->begin_trace(ctx, TRACE_ID_CIRCUIT_LOOP);
     TaskHelper::dispatch_task<CalcNewCurrentsTask>(cnc_launcher, ctx, runtime, 
                                                    perform_checks, simulation_success);
     TaskHelper::dispatch_task<DistributeChargeTask>(dsc_launcher, ctx, runtime, 
@@ -142,6 +149,8 @@ void top_level_task(const Task *task,
     TaskHelper::dispatch_task<UpdateVoltagesTask>(upv_launcher, ctx, runtime, 
                                                   perform_checks, simulation_success,
                                                   ((i+1)==num_loops));
+    if (trace_iter)
+      runtime->end_trace(ctx, TRACE_ID_CIRCUIT_LOOP);
   }
   ts_end = Realm::Clock::current_time_in_microseconds();
   if (simulation_success)
@@ -151,6 +160,7 @@ void top_level_task(const Task *task,
   {
     double sim_time = 1e-6 * (ts_end - ts_start);
     printf("ELAPSED TIME = %7.3f s\n", sim_time);
+    printf("ITERATION TIME = %7.3f us\n", (ts_end - ts_start) / num_loops);
 
     // Compute the floating point operations per second
     long num_circuit_nodes = num_pieces * nodes_per_piece;
@@ -235,7 +245,7 @@ void parse_input_args(char **argv, int argc, int &num_loops, int &num_pieces,
                       int &nodes_per_piece, int &wires_per_piece,
                       int &pct_wire_in_piece, int &random_seed,
                       int &steps, int &sync, bool &perform_checks,
-                      bool &dump_values)
+                      bool &dump_values, bool &use_tracing)
 {
   for (int i = 1; i < argc; i++) 
   {
@@ -298,6 +308,12 @@ void parse_input_args(char **argv, int argc, int &num_loops, int &num_pieces,
       dump_values = true;
       continue;
     }
+
+    if(!strcmp(argv[i], "-t"))
+    {
+      use_tracing = (atoi(argv[++i]) != 0);
+      continue;
+    }
   }
 }
 
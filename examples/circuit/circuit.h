@@ -56,6 +56,10 @@ enum {
   REDUCE_ID = 1,
 };
 
+enum {
+  TRACE_ID_CIRCUIT_LOOP = 1,
+};
+
 enum NodeFields {
   FID_NODE_CAP,
   FID_LEAKAGE,
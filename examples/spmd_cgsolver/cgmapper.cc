@@ -33,9 +33,17 @@ namespace std {
   }
 };
 
+/*static*/ std::set<TaskID> CGMapper::gpu_tasks;
+
+/*static*/ void CGMapper::register_gpu_task(TaskID taskid)
+{
+  gpu_tasks.insert(taskid);
+}
+
 CGMapper::CGMapper(Machine machine, Runtime *rt, Processor local)
   : ShimMapper(machine, rt, rt->get_mapper_runtime(), local)
   , shard_per_proc(false)
+  , shard_per_gpu(false)
   , runtime(rt)
 {
   // check to see if there any input arguments to parse
@@ -48,7 +56,48 @@ CGMapper::CGMapper(Machine machine, Runtime *rt, Processor local)
 	shard_per_proc = true;
 	continue;
       }
+      if(!strcmp(argv[i], "-gpu")) {
+	shard_per_gpu = true;
+	continue;
+      }
+    }
+  }
+
+  if(shard_per_gpu) {
+    // one shard per GPU, each with a CPU of its own (for the spmd_main_task
+    //  and any leaf tasks without a GPU variant) and the node's zero-copy
+    //  memory for the shared instances, which both can access
+    Machine::MemoryQuery zq = Machine::MemoryQuery(machine)
+      .only_kind(Memory::Z_COPY_MEM);
+    for(Machine::MemoryQuery::iterator it = zq.begin(); it != zq.end(); it++) {
+      Memory m = *it;
+
+      Machine::ProcessorQuery gq = Machine::ProcessorQuery(machine)
+	.only_kind(Processor::TOC_PROC)
+	.has_affinity_to(m);
+      Machine::ProcessorQuery cq = Machine::ProcessorQuery(machine)
+	.only_kind(Processor::LOC_PROC)
+	.has_affinity_to(m);
+      std::vector<Processor> gs(gq.begin(), gq.end());
+      std::vector<Processor> cs(cq.begin(), cq.end());
+      if(cs.size() < gs.size()) {
+	log_cgmap.fatal() << "-gpu needs at least one CPU per GPU: zcmem=" << m
+			  << " gpus=" << gs << " cpus=" << cs;
+	assert(false);
+      }
+      for(size_t i = 0; i < gs.size(); i++) {
+	sysmems.push_back(m);
+	procs.push_back(std::vector<Processor>(1, cs[i]));
+	gpus.push_back(gs[i]);
+	proc_to_shard[cs[i]] = sysmems.size() - 1;
+	log_cgmap.debug() << "zcmem=" << m << " proc=" << cs[i] << " gpu=" << gs[i];
+      }
+    }
+    if(sysmems.empty()) {
+      log_cgmap.fatal() << "HELP!  -gpu given but no GPUs (or zero-copy memories) found!?";
+      assert(false);
     }
+    return;
   }
 
   // we're going to do a SPMD distribution with one shard per "system memory"
@@ -166,6 +215,10 @@ void CGMapper::select_task_options(Task *task)
     task->map_locally = true; 
     task->profile_task = false;
     task->task_priority = 0;
+    if(shard_per_gpu && (gpu_tasks.count(task->task_id) > 0)) {
+      task->target_proc = gpus[shard];
+      return;
+    }
     task->target_proc = procs[shard][0];
     task->additional_procs.insert(procs[shard].begin(), procs[shard].end());
     return;
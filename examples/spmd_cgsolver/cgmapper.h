@@ -27,6 +27,10 @@ public:
 
   static MappingTagID SHARD_TAG(int shard) { return TAG_SHARD_BASE + shard; }
 
+  // leaf tasks with a GPU variant - when run with -gpu, LOCAL_SHARD launches
+  //  of these are sent to the shard's GPU instead of its CPUs
+  static void register_gpu_task(TaskID taskid);
+
   virtual void select_task_options(Task *task);
 
   virtual bool pre_map_task(Task *task);
@@ -50,8 +54,14 @@ public:
 
 protected:
   bool shard_per_proc;
+  bool shard_per_gpu;
+  // with -gpu, these are the zero-copy memories so that the GPUs can access
+  //  the shared instances directly
   std::vector<Memory> sysmems;
   std::vector<std::vector<Processor> > procs;
+  std::vector<Processor> gpus;
   std::map<Processor, int> proc_to_shard;
   Runtime *runtime;
+
+  static std::set<TaskID> gpu_tasks;
 };
@@ -945,6 +945,7 @@ bool spmd_main_task(const Task *task,
 
   int iter = 0;
   bool ok = false;
+  double ts_start = Realm::Clock::current_time_in_microseconds();
   while(true) {
     iter++;
 
@@ -1115,6 +1116,16 @@ bool spmd_main_task(const Task *task,
   if(args.use_tracing)
     runtime->end_trace(ctx, TRACE_ID_CG_ITER);
 
+  // the residual futures still queued cover the iterations that were
+  //  speculated past the last one we checked, so wait for them too
+  if(!f_residuals.empty())
+    f_residuals.back().get_void_result();
+  double ts_end = Realm::Clock::current_time_in_microseconds();
+  if(shard == 0) {
+    printf("ELAPSED TIME = %7.3f s\n", 1e-6 * (ts_end - ts_start));
+    printf("ITERATION TIME = %7.3f us\n", (ts_end - ts_start) / iter);
+  }
+
   if(0)
     PrintField::compute(myblocks, runtime, ctx,
 			"x", fid_sol_x, true /*private*/,
@@ -169,6 +169,16 @@ extern Logger log_app;
   tvr.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
   tvr.set_leaf(true);
   Runtime::preregister_task_variant<double, dotp_field_task>(tvr, "dotp_field_task");
+
+#ifdef USE_CUDA
+  {
+    TaskVariantRegistrar tvr_gpu(taskid, "dotp_field_task");
+    tvr_gpu.add_constraint(ProcessorConstraint(Processor::TOC_PROC));
+    tvr_gpu.set_leaf(true);
+    Runtime::preregister_task_variant<double, dotp_field_task_gpu>(tvr_gpu, "dotp_field_task");
+    CGMapper::register_gpu_task(taskid);
+  }
+#endif
 }
 
 /*static*/ double DotProduct::dotp_field_task(const Task *task,
@@ -251,6 +261,16 @@ extern Logger log_app;
   tvr.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
   tvr.set_leaf(true);
   Runtime::preregister_task_variant<add_field_task>(tvr, "add_field_task");
+
+#ifdef USE_CUDA
+  {
+    TaskVariantRegistrar tvr_gpu(taskid, "add_field_task");
+    tvr_gpu.add_constraint(ProcessorConstraint(Processor::TOC_PROC));
+    tvr_gpu.set_leaf(true);
+    Runtime::preregister_task_variant<add_field_task_gpu>(tvr_gpu, "add_field_task");
+    CGMapper::register_gpu_task(taskid);
+  }
+#endif
 }
 
 /*static*/ void VectorAdd::add_field_task(const Task *task,
@@ -333,6 +353,16 @@ extern Logger log_app;
   tvr.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
   tvr.set_leaf(true);
   Runtime::preregister_task_variant<acc_field_task>(tvr, "acc_field_task");
+
+#ifdef USE_CUDA
+  {
+    TaskVariantRegistrar tvr_gpu(taskid, "acc_field_task");
+    tvr_gpu.add_constraint(ProcessorConstraint(Processor::TOC_PROC));
+    tvr_gpu.set_leaf(true);
+    Runtime::preregister_task_variant<acc_field_task_gpu>(tvr_gpu, "acc_field_task");
+    CGMapper::register_gpu_task(taskid);
+  }
+#endif
 }
 
 /*static*/ void VectorAcc::acc_field_task(const Task *task,
@@ -50,6 +50,12 @@ public:
   static double dotp_field_task(const Task *task,
 				const std::vector<PhysicalRegion> &regions,
 				Context ctx, Runtime *runtime);
+
+#ifdef USE_CUDA
+  static double dotp_field_task_gpu(const Task *task,
+				    const std::vector<PhysicalRegion> &regions,
+				    Context ctx, Runtime *runtime);
+#endif
 };
 
 // computes fid_sum = alpha1 * fid1 + alpha2 * fid2
@@ -75,6 +81,12 @@ public:
   static void add_field_task(const Task *task,
 			     const std::vector<PhysicalRegion> &regions,
 			     Context ctx, Runtime *runtime);
+
+#ifdef USE_CUDA
+  static void add_field_task_gpu(const Task *task,
+				 const std::vector<PhysicalRegion> &regions,
+				 Context ctx, Runtime *runtime);
+#endif
 };
 
 // computes fid_acc = alpha1 * fid_acc + alpha2 * fid_in
@@ -99,6 +111,12 @@ public:
   static void acc_field_task(const Task *task,
 			     const std::vector<PhysicalRegion> &regions,
 			     Context ctx, Runtime *runtime);
+
+#ifdef USE_CUDA
+  static void acc_field_task_gpu(const Task *task,
+				 const std::vector<PhysicalRegion> &regions,
+				 Context ctx, Runtime *runtime);
+#endif
 };
 
 #endif
@@ -0,0 +1,163 @@
+// GPU variants of the leaf tasks for CG solver
+
+#include "cgtasks.h"
+
+#define THREADS_PER_BLOCK 256
+#define DOTP_BLOCKS 256
+
+extern Logger log_app;
+
+typedef RegionAccessor<AccessorType::Affine<3>, double> AffineAccessor;
+
+// each thread handles a subset of the points in the (dense) block, using a
+//  grid-stride loop over the linearized bounds with x varying fastest
+struct BlockShape {
+  Point<3> lo;
+  coord_t nx, nxy;
+  coord_t volume;
+};
+
+static BlockShape block_shape(const Rect<3>& bounds)
+{
+  BlockShape bs;
+  bs.lo = bounds.lo;
+  bs.nx = bounds.hi.x[0] - bounds.lo.x[0] + 1;
+  bs.nxy = bs.nx * (bounds.hi.x[1] - bounds.lo.x[1] + 1);
+  bs.volume = bs.nxy * (bounds.hi.x[2] - bounds.lo.x[2] + 1);
+  return bs;
+}
+
+static __device__ __forceinline__
+Point<3> block_point(const BlockShape& bs, coord_t idx)
+{
+  return make_point(bs.lo.x[0] + (idx % bs.nx),
+		    bs.lo.x[1] + ((idx % bs.nxy) / bs.nx),
+		    bs.lo.x[2] + (idx / bs.nxy));
+}
+
+static int num_blocks(const BlockShape& bs)
+{
+  coord_t blocks = (bs.volume + THREADS_PER_BLOCK - 1) / THREADS_PER_BLOCK;
+  // the grid-stride loops cover anything past the cap
+  return (blocks > 65535) ? 65535 : ((blocks > 0) ? blocks : 1);
+}
+
+// per-block partial sums for the dot product - a GPU processor runs one task
+//  at a time and the result is copied back before the task returns, so a
+//  single buffer per device is sufficient
+__device__ double dotp_partials[DOTP_BLOCKS];
+
+__global__
+void dotp_kernel(BlockShape bs, AffineAccessor fa1, AffineAccessor fa2)
+{
+  __shared__ double sums[THREADS_PER_BLOCK];
+
+  double sum = 0.0;
+  for(coord_t idx = blockIdx.x * blockDim.x + threadIdx.x;
+      idx < bs.volume;
+      idx += gridDim.x * blockDim.x) {
+    Point<3> p = block_point(bs, idx);
+    sum += fa1[p] * fa2[p];
+  }
+  sums[threadIdx.x] = sum;
+  __syncthreads();
+
+  for(unsigned stride = THREADS_PER_BLOCK / 2; stride > 0; stride >>= 1) {
+    if(threadIdx.x < stride)
+      sums[threadIdx.x] += sums[threadIdx.x + stride];
+    __syncthreads();
+  }
+  if(threadIdx.x == 0)
+    dotp_partials[blockIdx.x] = sums[0];
+}
+
+__global__
+void add_kernel(BlockShape bs, AffineAccessor fa_sum,
+		double alpha1, AffineAccessor fa1,
+		double alpha2, AffineAccessor fa2)
+{
+  for(coord_t idx = blockIdx.x * blockDim.x + threadIdx.x;
+      idx < bs.volume;
+      idx += gridDim.x * blockDim.x) {
+    Point<3> p = block_point(bs, idx);
+    fa_sum[p] = alpha1 * fa1[p] + alpha2 * fa2[p];
+  }
+}
+
+__global__
+void acc_kernel(BlockShape bs, AffineAccessor fa_acc, double alpha_acc,
+		AffineAccessor fa_in, double alpha_in)
+{
+  for(coord_t idx = blockIdx.x * blockDim.x + threadIdx.x;
+      idx < bs.volume;
+      idx += gridDim.x * blockDim.x) {
+    Point<3> p = block_point(bs, idx);
+    fa_acc[p] = alpha_in * fa_in[p] + alpha_acc * fa_acc[p];
+  }
+}
+
+/*static*/ double DotProduct::dotp_field_task_gpu(const Task *task,
+						  const std::vector<PhysicalRegion> &regions,
+						  Context ctx, Runtime *runtime)
+{
+  const DotpFieldArgs& args = *(const DotpFieldArgs *)(task->args);
+
+  log_app.info() << "dotp_field task (gpu) - bounds=" << args.bounds
+		 << ", fid1=" << task->regions[0].instance_fields[0]
+		 << ", fid2=" << task->regions[1].instance_fields[0]
+		 << ", proc=" << runtime->get_executing_processor(ctx);
+
+  AffineAccessor fa1 = regions[0].get_field_accessor(task->regions[0].instance_fields[0]).typeify<double>().convert<AccessorType::Affine<3> >();
+  AffineAccessor fa2 = regions[1].get_field_accessor(task->regions[1].instance_fields[0]).typeify<double>().convert<AccessorType::Affine<3> >();
+
+  BlockShape bs = block_shape(args.bounds);
+  dotp_kernel<<<DOTP_BLOCKS, THREADS_PER_BLOCK>>>(bs, fa1, fa2);
+
+  double partials[DOTP_BLOCKS];
+  cudaMemcpyFromSymbol(partials, dotp_partials, sizeof(partials));
+  double sum = 0.0;
+  for(int i = 0; i < DOTP_BLOCKS; i++)
+    sum += partials[i];
+  return sum;
+}
+
+/*static*/ void VectorAdd::add_field_task_gpu(const Task *task,
+					      const std::vector<PhysicalRegion> &regions,
+					      Context ctx, Runtime *runtime)
+{
+  const AddFieldArgs& args = *(const AddFieldArgs *)(task->args);
+
+  log_app.info() << "add_field task (gpu) - bounds=" << args.bounds
+		 << ", sum=" << task->regions[0].instance_fields[0]
+		 << ", fid1=" << task->regions[1].instance_fields[0]
+		 << ", fid2=" << task->regions[2].instance_fields[0]
+		 << ", proc=" << runtime->get_executing_processor(ctx);
+
+  AffineAccessor fa_sum = regions[0].get_field_accessor(task->regions[0].instance_fields[0]).typeify<double>().convert<AccessorType::Affine<3> >();
+  AffineAccessor fa1 = regions[1].get_field_accessor(task->regions[1].instance_fields[0]).typeify<double>().convert<AccessorType::Affine<3> >();
+  AffineAccessor fa2 = regions[2].get_field_accessor(task->regions[2].instance_fields[0]).typeify<double>().convert<AccessorType::Affine<3> >();
+
+  BlockShape bs = block_shape(args.bounds);
+  add_kernel<<<num_blocks(bs), THREADS_PER_BLOCK>>>(bs, fa_sum,
+						    args.alpha1, fa1,
+						    args.alpha2, fa2);
+}
+
+/*static*/ void VectorAcc::acc_field_task_gpu(const Task *task,
+					      const std::vector<PhysicalRegion> &regions,
+					      Context ctx, Runtime *runtime)
+{
+  const AccFieldArgs& args = *(const AccFieldArgs *)(task->args);
+
+  log_app.info() << "acc_field task (gpu) - bounds=" << args.bounds
+		 << ", acc=" << task->regions[0].instance_fields[0]
+		 << ", in=" << task->regions[1].instance_fields[0]
+		 << ", proc=" << runtime->get_executing_processor(ctx);
+
+  AffineAccessor fa_acc = regions[0].get_field_accessor(task->regions[0].instance_fields[0]).typeify<double>().convert<AccessorType::Affine<3> >();
+  AffineAccessor fa_in = regions[1].get_field_accessor(task->regions[1].instance_fields[0]).typeify<double>().convert<AccessorType::Affine<3> >();
+
+  BlockShape bs = block_shape(args.bounds);
+  acc_kernel<<<num_blocks(bs), THREADS_PER_BLOCK>>>(bs, fa_acc, args.alpha_acc,
+						    fa_in, args.alpha_in);
+}
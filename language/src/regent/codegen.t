@@ -2564,8 +2564,14 @@ local function expr_call_setup_list_of_regions_arg(
 end
 
 local function expr_call_setup_partition_arg(
-    cx, task, arg_type, param_type, partition, launcher, index, args_setup)
+    cx, task, arg_type, param_type, partition, launcher, index, args_setup,
+    projection)
   assert(index)
+  local projection_id = 0 --[[ default projection ID ]]
+  if projection then
+    projection_id = std.get_affine_projection_id(
+      projection.scale, projection.offsets)
+  end
   local privileges, privilege_field_paths, privilege_field_types, coherences, flags =
     std.find_task_privileges(param_type, task)
   local privilege_modes = privileges:map(std.privilege_mode)
@@ -2602,7 +2608,7 @@ local function expr_call_setup_partition_arg(
 
     local requirement = terralib.newsymbol(uint, "requirement")
     local requirement_args = terralib.newlist({
-        launcher, `([partition].impl), 0 --[[ default projection ID ]]})
+        launcher, `([partition].impl), projection_id})
     if reduction_op then
       requirement_args:insert(reduction_op)
     else
@@ -7296,8 +7302,61 @@ function codegen.stat_for_list(cx, node)
   end
 end
 
+-- Runs a vectorized loop body on all OpenMP threads. The body reads
+-- the loop bounds from 'rect' (a value of a legion_rect_Nd_t), which is
+-- handed to the workers by pointer along with the loop's free symbols.
+local function generate_vectorized_omp_launch(cx, node, rect, body)
+  local rect_ptr = terralib.newsymbol(&rect.type, "rect_ptr")
+  local symbols, reductions = collect_symbols(cx,
+    { symbol = node.symbol, block = node.orig_block })
+  symbols:insert(rect_ptr)
+  local arg_type, mapping = openmphelper.generate_argument_type(symbols, reductions)
+  local arg = terralib.newsymbol(&arg_type, "arg")
+  local worker_init, launch_init =
+    openmphelper.generate_argument_init(arg, arg_type, mapping, reductions)
+  local worker_cleanup =
+    openmphelper.generate_worker_cleanup(arg, arg_type, mapping, reductions)
+  local launcher_cleanup =
+    openmphelper.generate_launcher_cleanup(arg, arg_type, mapping, reductions)
+  local terra omp_worker(data : &opaque)
+    var [arg] = [&arg_type](data)
+    [worker_init]
+    var [rect] = @[rect_ptr]
+    [body]
+    [worker_cleanup]
+  end
+  return quote
+    var [rect_ptr] = &[rect]
+    var arg_obj : arg_type
+    var [arg] = &arg_obj
+    [launch_init]
+    [openmphelper.launch]([omp_worker], [arg], [openmphelper.get_max_threads](), 0)
+    [launcher_cleanup]
+  end
+end
+
+-- OpenMP loops over structured index spaces keep their vectorized
+-- bodies: the threads split the outermost dimension and each runs the
+-- vectorized innermost loop over its slice. Loops that reduce to
+-- scalars still fall back to the scalar OpenMP code path.
+local function can_vectorize_with_openmp(cx, node)
+  if not openmphelper.check_openmp_available() then return false end
+  local value_type = std.as_read(node.value.expr_type)
+  local ispace_type = value_type
+  if std.is_region(value_type) then ispace_type = value_type:ispace() end
+  if not std.is_ispace(ispace_type) or ispace_type.dim == 0 then
+    return false
+  end
+  local _, reductions = collect_symbols(cx,
+    { symbol = node.symbol, block = node.orig_block })
+  return next(reductions) == nil
+end
+
 function codegen.stat_for_list_vectorized(cx, node)
-  if cx.variant:is_cuda() or node.annotations.openmp:is(ast.annotation.Demand) then
+  local openmp = node.annotations.openmp:is(ast.annotation.Demand)
+  if cx.variant:is_cuda() or
+     (openmp and not can_vectorize_with_openmp(cx, node))
+  then
     return codegen.stat_for_list(cx,
       ast.typed.stat.ForList {
         symbol = node.symbol,
@@ -7439,17 +7498,26 @@ function codegen.stat_for_list_vectorized(cx, node)
           [ index[1] ] = [ index[1] ] + 1
         end
       end
+      local start_idx = terralib.newsymbol(int64, "start_idx")
+      local end_idx = terralib.newsymbol(int64, "end_idx")
       for i = 2, ispace_type.dim do
         local rect_i = i - 1 -- C is zero-based, Lua is one-based
-        body = quote
-          for [ index[i] ] = [rect].lo.x[rect_i], [rect].hi.x[rect_i] + 1 do
-            [body]
+        if openmp and i == ispace_type.dim then
+          body = quote
+            [openmphelper.generate_preamble_structured(rect, rect_i, start_idx, end_idx)]
+            for [ index[i] ] = [start_idx], [end_idx] do
+              [body]
+            end
+          end
+        else
+          body = quote
+            for [ index[i] ] = [rect].lo.x[rect_i], [rect].hi.x[rect_i] + 1 do
+              [body]
+            end
           end
         end
       end
-      return quote
-        [actions]
-        var [rect] = [domain_get_rect]([domain])
+      body = quote
         var alignment = [vector_width]
         var [base] = [rect].lo.x[0]
         var [count] = [rect].hi.x[0] - [rect].lo.x[0] + 1
@@ -7457,15 +7525,40 @@ function codegen.stat_for_list_vectorized(cx, node)
         var [stop] = ([base] + [count]) and not (alignment - 1)
         var [final] = [base] + [count]
         [body]
-        [cleanup_actions]
+      end
+      if not openmp then
+        return quote
+          [actions]
+          var [rect] = [domain_get_rect]([domain])
+          [body]
+          [cleanup_actions]
+        end
+      else
+        return quote
+          [actions]
+          var [rect] = [domain_get_rect]([domain])
+          [generate_vectorized_omp_launch(cx, node, rect, body)]
+          [cleanup_actions]
+        end
       end
     else
-      return quote
-        [actions]
-        var rect = c.legion_domain_get_rect_1d([domain])
+      local rect = terralib.newsymbol(c.legion_rect_1d_t, "rect")
+      local start_idx = terralib.newsymbol(int64, "start_idx")
+      local end_idx = terralib.newsymbol(int64, "end_idx")
+      local bounds
+      if not openmp then
+        bounds = quote
+          var [start_idx] = [rect].lo.x[0]
+          var [end_idx] = [rect].hi.x[0] + 1
+        end
+      else
+        bounds = openmphelper.generate_preamble_structured(rect, 0, start_idx, end_idx)
+      end
+      local body = quote
+        [bounds]
         var alignment = [vector_width]
-        var base = rect.lo.x[0]
-        var count = rect.hi.x[0] - rect.lo.x[0] + 1
+        var base = [start_idx]
+        var count = [end_idx] - [start_idx]
         var start = (base + alignment - 1) and not (alignment - 1)
         var stop = (base + count) and not (alignment - 1)
         var final = base + count
@@ -7494,7 +7587,21 @@ function codegen.stat_for_list_vectorized(cx, node)
           end
           i = i + 1
         end
-        [cleanup_actions]
+      end
+      if not openmp then
+        return quote
+          [actions]
+          var [rect] = c.legion_domain_get_rect_1d([domain])
+          [body]
+          [cleanup_actions]
+        end
+      else
+        return quote
+          [actions]
+          var [rect] = c.legion_domain_get_rect_1d([domain])
+          [generate_vectorized_omp_launch(cx, node, rect, body)]
+          [cleanup_actions]
+        end
       end
     end
   end
@@ -7723,7 +7830,7 @@ local function stat_index_launch_setup(cx, node, domain, actions)
       assert(partition)
       expr_call_setup_partition_arg(
         cx, fn.value, arg_type, param_type, partition.value, launcher, true,
-        args_setup)
+        args_setup, node.args_provably.projection[i])
     end
   end
 
@@ -59,6 +59,7 @@ local default_options = {
   ["pretty"] = false,
   ["layout-constraints"] = true,
   ["trace"] = true,
+  ["trace-infer"] = true,
   ["validate"] = true,
   ["emergency-gc"] = false,
 
@@ -322,6 +322,110 @@ local function analyze_is_loop_invariant(cx, node)
     node, true)
 end
 
+-- Affine index analysis. Recognizes partition indices of the form
+-- a*i + b, where i is the loop variable, a is a non-zero integer
+-- constant and b is an integer (or, for multi-dimensional colors, a
+-- constant vector). Each sub-expression is summarized as a pair
+-- {scale, offsets}; offsets is nil when it is known to be zero.
+
+local function affine_add(lhs, rhs, sign)
+  local offsets = lhs.offsets
+  if rhs.offsets then
+    if offsets and #offsets ~= #rhs.offsets then return end
+    offsets = data.zip(offsets or rhs.offsets:map(function() return 0 end),
+                       rhs.offsets):map(
+      function(pair)
+        local a, b = unpack(pair)
+        return a + sign * b
+      end)
+  end
+  return { scale = lhs.scale + sign * rhs.scale, offsets = offsets }
+end
+
+local function affine_mul(affine, factor)
+  return {
+    scale = affine.scale * factor,
+    offsets = affine.offsets and affine.offsets:map(
+      function(offset) return offset * factor end),
+  }
+end
+
+local function is_integer_constant(node)
+  return node:is(ast.typed.expr.Constant) and
+    type(node.value) == "number" and node.value == math.floor(node.value)
+end
+
+local function analyze_affine_index(loop_symbol, node)
+  if node:is(ast.typed.expr.ID) then
+    if node.value == loop_symbol then
+      return { scale = 1, offsets = false }
+    end
+  elseif is_integer_constant(node) then
+    return { scale = 0, offsets = terralib.newlist({node.value}) }
+  elseif node:is(ast.typed.expr.Ctor) then
+    local offsets = terralib.newlist()
+    for i, field in ipairs(node.fields) do
+      if not is_integer_constant(field.value) or
+        (field:is(ast.typed.expr.CtorRecField) and
+           field.name ~= ({"x", "y", "z"})[i])
+      then
+        return
+      end
+      offsets:insert(field.value.value)
+    end
+    return { scale = 0, offsets = offsets }
+  elseif node:is(ast.typed.expr.Cast) then
+    return analyze_affine_index(loop_symbol, node.arg)
+  elseif node:is(ast.typed.expr.Unary) and node.op == "-" then
+    local rhs = analyze_affine_index(loop_symbol, node.rhs)
+    return rhs and affine_mul(rhs, -1)
+  elseif node:is(ast.typed.expr.Binary) then
+    local lhs = analyze_affine_index(loop_symbol, node.lhs)
+    local rhs = analyze_affine_index(loop_symbol, node.rhs)
+    if not (lhs and rhs) then return end
+    if node.op == "+" then
+      return affine_add(lhs, rhs, 1)
+    elseif node.op == "-" then
+      return affine_add(lhs, rhs, -1)
+    elseif node.op == "*" then
+      -- Only scalar constant factors keep the index affine.
+      if lhs.scale == 0 and lhs.offsets and #lhs.offsets == 1 then
+        return affine_mul(rhs, lhs.offsets[1])
+      elseif rhs.scale == 0 and rhs.offsets and #rhs.offsets == 1 then
+        return affine_mul(lhs, rhs.offsets[1])
+      end
+    end
+  end
+end
+
+-- Returns the projection for indexing a partition with the given
+-- colors by the given index: true for the identity, a table {scale,
+-- offsets} for a non-trivial affine projection, or nil when the index
+-- is not provably an injective affine function of the loop variable.
+local function analyze_index_projection(loop_symbol, index, colors_type)
+  local affine = analyze_affine_index(loop_symbol, index)
+  if not affine or affine.scale == 0 then
+    return
+  end
+
+  local dim = data.max(colors_type.dim, 1)
+  local offsets = affine.offsets
+  if not offsets then
+    offsets = data.range(dim):map(function() return 0 end)
+  elseif #offsets == 1 and dim > 1 then
+    return
+  elseif #offsets ~= dim then
+    return
+  end
+
+  if affine.scale == 1 and data.all(unpack(offsets:map(
+    function(offset) return offset == 0 end)))
+  then
+    return true
+  end
+  return { scale = affine.scale, offsets = offsets }
+end
+
 local optimize_index_launch = {}
 
 local function ignore(...) end
@@ -468,6 +572,7 @@ local function optimize_loop_body(cx, node, report_pass, report_fail)
   local args_provably = ast.IndexLaunchArgsProvably {
     invariant = terralib.newlist(),
     variant = terralib.newlist(),
+    projection = terralib.newlist(),
   }
   local regions_previously_used = terralib.newlist()
   local mapping = {}
@@ -480,6 +585,7 @@ local function optimize_loop_body(cx, node, report_pass, report_fail)
     local arg_invariant = analyze_is_loop_invariant(loop_cx, arg)
 
     local arg_variant = false
+    local arg_projection = false
     local partition_type
 
     local arg_type = std.as_read(arg.expr_type)
@@ -500,6 +606,24 @@ local function optimize_loop_body(cx, node, report_pass, report_fail)
         then
           partition_type = std.as_read(arg.value.expr_type)
           arg_variant = true
+        elseif not arg_invariant and
+          std.is_partition(std.as_read(arg.value.expr_type)) and
+          analyze_is_loop_invariant(loop_cx, arg.value)
+        then
+          -- Otherwise the index may still be an affine function of
+          -- the loop variable, which is launched with a projection
+          -- functor. Since the function is injective, disjoint
+          -- partitions remain non-interfering.
+          local value_type = std.as_read(arg.value.expr_type)
+          local projection = analyze_index_projection(
+            node.symbol, arg.index, value_type:colors())
+          if projection then
+            partition_type = value_type
+            arg_variant = true
+            if projection ~= true then
+              arg_projection = projection
+            end
+          end
         end
       end
 
@@ -552,6 +676,7 @@ local function optimize_loop_body(cx, node, report_pass, report_fail)
 
     args_provably.invariant[i] = arg_invariant
     args_provably.variant[i] = arg_variant
+    args_provably.projection[i] = arg_projection
 
     regions_previously_used[i] = nil
     if std.is_region(arg_type) then
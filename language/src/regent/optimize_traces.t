@@ -15,8 +15,14 @@
 -- Legion Trace Optimizer
 --
 -- Inserts begin/end trace calls to control runtime tracing.
+--
+-- Loops annotated with __demand(__trace) are always traced. In
+-- addition, unless -ftrace-infer 0 is passed, outer loops are traced
+-- automatically when every iteration provably issues the same sequence
+-- of operations (see analyze_is_traceable below).
 
 local ast = require("regent/ast")
+local data = require("common/data")
 local std = require("regent/std")
 
 local c = std.c
@@ -47,42 +53,47 @@ function context.new_global_scope()
   return setmetatable(cx, context)
 end
 
+local function make_trace(cx, node)
+  local trace_id = ast.typed.expr.Constant {
+    value = cx.next_trace_id,
+    expr_type = c.legion_trace_id_t,
+    annotations = ast.default_annotations(),
+    span = node.span,
+  }
+  cx.next_trace_id = cx.next_trace_id + 1
+
+  local stats = terralib.newlist()
+  stats:insert(
+    ast.typed.stat.BeginTrace {
+      trace_id = trace_id,
+      annotations = ast.default_annotations(),
+      span = node.span,
+  })
+  stats:insertall(node.block.stats)
+  stats:insert(
+    ast.typed.stat.EndTrace {
+      trace_id = trace_id,
+      annotations = ast.default_annotations(),
+      span = node.span,
+  })
+
+  return node { block = node.block { stats = stats } }
+end
+
+local function is_loop(node)
+  return node:is(ast.typed.stat.While) or
+    node:is(ast.typed.stat.ForNum) or
+    node:is(ast.typed.stat.ForList) or
+    node:is(ast.typed.stat.Repeat)
+end
+
 local function apply_tracing_node(cx)
   return function(node)
-    if node:is(ast.typed.stat.While) or
-      node:is(ast.typed.stat.ForNum) or
-      node:is(ast.typed.stat.ForList) or
-      node:is(ast.typed.stat.Repeat) or
-      node:is(ast.typed.stat.Block)
-    then
+    if is_loop(node) or node:is(ast.typed.stat.Block) then
       if not node.annotations.trace:is(ast.annotation.Demand) then
         return node
       end
-
-      local trace_id = ast.typed.expr.Constant {
-        value = cx.next_trace_id,
-        expr_type = c.legion_trace_id_t,
-        annotations = ast.default_annotations(),
-        span = node.span,
-      }
-      cx.next_trace_id = cx.next_trace_id + 1
-
-      local stats = terralib.newlist()
-      stats:insert(
-        ast.typed.stat.BeginTrace {
-          trace_id = trace_id,
-          annotations = ast.default_annotations(),
-          span = node.span,
-      })
-      stats:insertall(node.block.stats)
-      stats:insert(
-        ast.typed.stat.EndTrace {
-          trace_id = trace_id,
-          annotations = ast.default_annotations(),
-          span = node.span,
-      })
-
-      return node { block = node.block { stats = stats } }
+      return make_trace(cx, node)
 
     else
       return node
@@ -94,11 +105,232 @@ local function apply_tracing(cx, node)
   return ast.map_node_postorder(apply_tracing_node(cx), node)
 end
 
+-- Trace inference. A loop body is traceable when every iteration
+-- issues the same operations with the same region arguments: the
+-- body has no data-dependent control flow, creates no resources,
+-- touches no region data inline, and the region arguments of every
+-- launch are computed only from values that do not change between
+-- iterations (or from the indices of inner loops with invariant
+-- bounds).
+
+local function collect_variant_symbols(symbol, block)
+  local variant = {}
+  if symbol then
+    variant[symbol] = true
+  end
+  local function mark_ids(node)
+    if node:is(ast.typed.expr.ID) then
+      variant[node.value] = true
+    end
+  end
+  ast.traverse_node_postorder(
+    function(node)
+      if node:is(ast.typed.stat.Var) or node:is(ast.typed.stat.VarUnpack) then
+        for _, symbol in ipairs(node.symbols) do
+          variant[symbol] = true
+        end
+      elseif node:is(ast.typed.stat.Assignment) or
+        node:is(ast.typed.stat.Reduce)
+      then
+        ast.traverse_node_postorder(mark_ids, node.lhs)
+      end
+    end,
+    block)
+  return variant
+end
+
+local function is_loop_variant(variant, node)
+  return ast.mapreduce_node_postorder(
+    function(node)
+      return node:is(ast.typed.expr.ID) and variant[node.value] or false
+    end,
+    data.any,
+    node, false)
+end
+
+local function has_variant_region_args(variant, call)
+  for _, arg in ipairs(call.args) do
+    local arg_type = std.as_read(arg.expr_type)
+    if (std.is_region(arg_type) or std.is_ispace(arg_type) or
+          std.is_partition(arg_type) or std.is_cross_product(arg_type) or
+          std.is_list(arg_type)) and
+      is_loop_variant(variant, arg)
+    then
+      return true
+    end
+  end
+  return false
+end
+
+local function analyze_is_traceable_node(variant)
+  return function(node)
+    -- Expressions:
+    if node:is(ast.typed.expr.Call) then
+      return not (std.is_task(node.fn.value) and
+                  (#node.conditions > 0 or
+                   has_variant_region_args(variant, node)))
+
+    elseif node:is(ast.typed.expr.Internal) or
+      node:is(ast.typed.expr.RawPhysical) or
+      node:is(ast.typed.expr.Ispace) or
+      node:is(ast.typed.expr.Region) or
+      node:is(ast.typed.expr.Partition) or
+      node:is(ast.typed.expr.PartitionEqual) or
+      node:is(ast.typed.expr.PartitionByField) or
+      node:is(ast.typed.expr.Image) or
+      node:is(ast.typed.expr.ImageByTask) or
+      node:is(ast.typed.expr.Preimage) or
+      node:is(ast.typed.expr.CrossProduct) or
+      node:is(ast.typed.expr.CrossProductArray) or
+      node:is(ast.typed.expr.ListSlicePartition) or
+      node:is(ast.typed.expr.ListDuplicatePartition) or
+      node:is(ast.typed.expr.ListSliceCrossProduct) or
+      node:is(ast.typed.expr.ListCrossProduct) or
+      node:is(ast.typed.expr.ListCrossProductComplete) or
+      node:is(ast.typed.expr.ListPhaseBarriers) or
+      node:is(ast.typed.expr.ListInvert) or
+      node:is(ast.typed.expr.ListRange) or
+      node:is(ast.typed.expr.ListIspace) or
+      node:is(ast.typed.expr.ListFromElement) or
+      node:is(ast.typed.expr.PhaseBarrier) or
+      node:is(ast.typed.expr.DynamicCollective) or
+      node:is(ast.typed.expr.DynamicCollectiveGetResult) or
+      node:is(ast.typed.expr.Advance) or
+      node:is(ast.typed.expr.Adjust) or
+      node:is(ast.typed.expr.Arrive) or
+      node:is(ast.typed.expr.Await) or
+      node:is(ast.typed.expr.Copy) or
+      node:is(ast.typed.expr.Fill) or
+      node:is(ast.typed.expr.Acquire) or
+      node:is(ast.typed.expr.Release) or
+      node:is(ast.typed.expr.AllocateScratchFields) or
+      node:is(ast.typed.expr.WithScratchFields) or
+      node:is(ast.typed.expr.Condition) or
+      node:is(ast.typed.expr.Deref)
+    then
+      return false
+
+    elseif node:is(ast.typed.expr) then
+      -- Inline accesses to region data require the parent task to
+      -- map the region, which is not permitted inside a trace.
+      return not (std.is_ref(node.expr_type) or
+                  std.is_rawref(node.expr_type))
+
+    -- Statements:
+    elseif node:is(ast.typed.stat.ForNum) then
+      return not (node.annotations.trace:is(ast.annotation.Demand) or
+                  is_loop_variant(variant, node.values))
+    elseif node:is(ast.typed.stat.ForList) then
+      return not (node.annotations.trace:is(ast.annotation.Demand) or
+                  is_loop_variant(variant, node.value))
+    elseif node:is(ast.typed.stat.IndexLaunchNum) then
+      return not (is_loop_variant(variant, node.values) or
+                  has_variant_region_args(variant, node.call))
+    elseif node:is(ast.typed.stat.IndexLaunchList) then
+      return not (is_loop_variant(variant, node.value) or
+                  has_variant_region_args(variant, node.call))
+    elseif node:is(ast.typed.stat.Block) then
+      return not node.annotations.trace:is(ast.annotation.Demand)
+
+    elseif node:is(ast.typed.stat.Var) or
+      node:is(ast.typed.stat.VarUnpack) or
+      node:is(ast.typed.stat.Assignment) or
+      node:is(ast.typed.stat.Reduce) or
+      node:is(ast.typed.stat.Expr)
+    then
+      return true
+
+    elseif node:is(ast.typed.stat) then
+      -- Control flow, nested traces, explicit mapping, etc.
+      return false
+
+    -- Miscellaneous:
+    else
+      return true
+    end
+  end
+end
+
+local function contains_launch(node)
+  return ast.mapreduce_node_postorder(
+    function(node)
+      return (node:is(ast.typed.expr.Call) and std.is_task(node.fn.value)) or
+        node:is(ast.typed.stat.IndexLaunchNum) or
+        node:is(ast.typed.stat.IndexLaunchList)
+    end,
+    data.any,
+    node, false)
+end
+
+local function analyze_is_traceable(node)
+  local symbol = (node:is(ast.typed.stat.ForNum) or
+                    node:is(ast.typed.stat.ForList)) and
+    node.symbol
+  local variant = collect_variant_symbols(symbol, node.block)
+  return contains_launch(node.block) and
+    ast.mapreduce_node_postorder(
+      analyze_is_traceable_node(variant),
+      data.all,
+      node.block, true)
+end
+
+local infer_tracing_block
+
+local function infer_tracing_stat(cx, node)
+  if (is_loop(node) or node:is(ast.typed.stat.Block)) and
+    node.annotations.trace:is(ast.annotation.Demand)
+  then
+    -- Traced explicitly, so nothing inside may be traced.
+    return node
+
+  elseif is_loop(node) then
+    if node.annotations.trace:is(ast.annotation.Allow) and
+      analyze_is_traceable(node)
+    then
+      return make_trace(cx, node)
+    end
+    return node { block = infer_tracing_block(cx, node.block) }
+
+  elseif node:is(ast.typed.stat.Block) then
+    return node { block = infer_tracing_block(cx, node.block) }
+
+  elseif node:is(ast.typed.stat.If) then
+    return node {
+      then_block = infer_tracing_block(cx, node.then_block),
+      elseif_blocks = node.elseif_blocks:map(
+        function(elseif_block)
+          return elseif_block {
+            block = infer_tracing_block(cx, elseif_block.block),
+          }
+        end),
+      else_block = infer_tracing_block(cx, node.else_block),
+    }
+
+  else
+    -- Must epochs and parallelized blocks are left to their own
+    -- passes.
+    return node
+  end
+end
+
+function infer_tracing_block(cx, node)
+  return node {
+    stats = node.stats:map(
+      function(stat) return infer_tracing_stat(cx, stat) end),
+  }
+end
+
 local optimize_traces = {}
 
 function optimize_traces.top_task(cx, node)
+  if not node.body then return node end
+
   local cx = cx:new_task_scope()
-  local body = apply_tracing(cx, node.body)
+  local body = node.body
+  if std.config["trace-infer"] then
+    body = infer_tracing_block(cx, body)
+  end
+  body = apply_tracing(cx, body)
 
   return node { body = body }
 end
@@ -3416,6 +3416,7 @@ end
 -- #################
 
 std.initial_regent_task_id = base.initial_regent_task_id
+std.initial_regent_projection_id = base.initial_regent_projection_id
 
 std.new_variant = base.new_variant
 std.is_variant = base.is_variant
@@ -3601,6 +3602,52 @@ do
   end
 end
 
+-- Projection functors for index launches whose region arguments are
+-- affine functions of the loop index (i.e. p[a*i + b]). Functors are
+-- created on demand by the index launch optimizer and memoized on
+-- their coefficients, then preregistered by std.setup.
+std.projection_functors = terralib.newlist()
+do
+  local projection_ids = {}
+  local next_projection_id = std.initial_regent_projection_id
+
+  local function make_affine_projection_functor(scale, offsets)
+    local terra functor(runtime : c.legion_runtime_t,
+                        ctx : c.legion_context_t,
+                        task : c.legion_task_t,
+                        index : uint,
+                        upper_bound : c.legion_logical_partition_t,
+                        point : c.legion_domain_point_t)
+      var color = point
+      [data.range(#offsets):map(
+         function(i)
+           return quote
+             color.point_data[i] = [scale] * point.point_data[i] + [offsets[i+1]]
+           end
+         end)]
+      return c.legion_logical_partition_get_logical_subregion_by_color_domain_point(
+        runtime, upper_bound, color)
+    end
+    functor:setname("__projection_affine_" .. tostring(next_projection_id))
+    return functor
+  end
+
+  function std.get_affine_projection_id(scale, offsets)
+    assert(scale ~= 0 and #offsets >= 1)
+    local key = tostring(scale) .. ":" .. offsets:map(tostring):concat(",")
+    if not projection_ids[key] then
+      local id = next_projection_id
+      std.projection_functors:insert({
+        id = id,
+        partition_functor = make_affine_projection_functor(scale, offsets),
+      })
+      projection_ids[key] = id
+      next_projection_id = next_projection_id + 1
+    end
+    return projection_ids[key]
+  end
+end
+
 local function make_task_wrapper(task_body)
   local return_type = task_body:gettype().returntype
   if return_type == terralib.types.unit then
@@ -3735,6 +3782,14 @@ function std.setup(main_task, extra_setup_thunk, registration_name)
     end
   end
 
+  local projection_registrations = std.projection_functors:map(
+    function(functor)
+      return quote
+        c.legion_runtime_preregister_projection_functor(
+          [functor.id], 0 --[[ depth ]], nil, [functor.partition_functor])
+      end
+    end)
+
   local layout_registrations = terralib.newlist()
   local layout_normal = data.newmap()
   do
@@ -3906,6 +3961,7 @@ function std.setup(main_task, extra_setup_thunk, registration_name)
 
   local terra main([argc], [argv])
     [reduction_registrations];
+    [projection_registrations];
     [layout_registrations];
     [task_registrations];
     [cuda_setup];
@@ -184,6 +184,7 @@ end
 -- #################
 
 base.initial_regent_task_id = 10000
+base.initial_regent_projection_id = 10000
 
 base.task = {}
 function base.task:__index(field)
@@ -22,6 +22,13 @@
 #define CUDAPREFIX
 #endif
 
+// restrict qualifier for the base pointers of the fast accessors
+#if defined(__GNUC__) || defined(__CUDACC__)
+#define ACCESSOR_RESTRICT __restrict__
+#else
+#define ACCESSOR_RESTRICT
+#endif
+
 #include "arrays.h"
 
 #ifndef __GNUC__
@@ -30,6 +37,22 @@
 
 // for fprintf
 #include <stdio.h>
+// for ptrdiff_t and uintptr_t
+#include <stddef.h>
+#include <stdint.h>
+
+// for malloc/free of private reduction buffers
+#include <stdlib.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// SSE2 is used for the strided transposes in read_span
+#if defined(__SSE2__) && !defined(__CUDACC__)
+#define ACCESSOR_USE_SSE
+#include <emmintrin.h>
+#endif
 
 // Imported ptr_t definition from old common.h
 struct ptr_t
@@ -252,6 +275,92 @@ namespace LegionRuntime {
       extern const char *(*find_privilege_task_name)(void *region);
     };
 
+    namespace SpanOps {
+      // transposes a run of elements of the given size spaced 'stride'
+      //  bytes apart into a dense array, returning how many elements were
+      //  handled - the caller finishes the tail with scalar copies; the
+      //  vector loops always stop at least one element short of the end
+      //  so that wide loads never read past the last element
+      template <size_t SIZE>
+      struct Transpose {
+	static inline size_t gather(void *dst, const char *src,
+				    size_t stride, size_t count)
+	{ return 0; }
+      };
+
+#ifdef ACCESSOR_USE_SSE
+      template <>
+      struct Transpose<4> {
+	static inline size_t gather(void *dst, const char *src,
+				    size_t stride, size_t count)
+	{
+	  float *out = (float *)dst;
+	  size_t i = 0;
+	  if(stride == 8) {
+	    // pairs: two loads cover four elements
+	    for(; (i + 4) < count; i += 4) {
+	      __m128 a = _mm_loadu_ps((const float *)(src + i * 8));
+	      __m128 b = _mm_loadu_ps((const float *)(src + i * 8 + 16));
+	      _mm_storeu_ps(out + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2,0,2,0)));
+	    }
+	  } else {
+	    for(; (i + 4) < count; i += 4) {
+	      __m128 a = _mm_loadu_ps((const float *)(src + (i + 0) * stride));
+	      __m128 b = _mm_loadu_ps((const float *)(src + (i + 1) * stride));
+	      __m128 c = _mm_loadu_ps((const float *)(src + (i + 2) * stride));
+	      __m128 d = _mm_loadu_ps((const float *)(src + (i + 3) * stride));
+	      _mm_storeu_ps(out + i, _mm_movelh_ps(_mm_unpacklo_ps(a, b),
+						   _mm_unpacklo_ps(c, d)));
+	    }
+	  }
+	  return i;
+	}
+      };
+
+      template <>
+      struct Transpose<8> {
+	static inline size_t gather(void *dst, const char *src,
+				    size_t stride, size_t count)
+	{
+	  double *out = (double *)dst;
+	  size_t i = 0;
+	  for(; (i + 2) < count; i += 2) {
+	    __m128d a = _mm_loadu_pd((const double *)(src + (i + 0) * stride));
+	    __m128d b = _mm_loadu_pd((const double *)(src + (i + 1) * stride));
+	    _mm_storeu_pd(out + i, _mm_unpacklo_pd(a, b));
+	  }
+	  return i;
+	}
+      };
+#endif
+
+      template <typename T>
+      inline void gather(T *dst, const char *src, size_t stride, size_t count)
+      {
+	if(stride == sizeof(T)) {
+	  memcpy(dst, src, count * sizeof(T));
+	  return;
+	}
+	size_t i = Transpose<sizeof(T)>::gather(dst, src, stride, count);
+	for(; i < count; i++)
+	  dst[i] = *(const T *)(src + i * stride);
+      }
+
+      // scatters are never done with full-width vector stores since those
+      //  would also rewrite the interleaved fields between our elements,
+      //  which may be owned by another task running concurrently
+      template <typename T>
+      inline void scatter(char *dst, size_t stride, const T *src, size_t count)
+      {
+	if(stride == sizeof(T)) {
+	  memcpy(dst, src, count * sizeof(T));
+	  return;
+	}
+	for(size_t i = 0; i < count; i++)
+	  *(T *)(dst + i * stride) = src[i];
+      }
+    };
+
     namespace AccessorType {
       template <typename T, off_t val> 
       struct Const {
@@ -277,9 +386,11 @@ namespace LegionRuntime {
       template <size_t STRIDE> struct SOA;
       template <size_t STRIDE, size_t BLOCK_SIZE, size_t BLOCK_STRIDE> struct HybridSOA;
       template <unsigned DIM> struct Affine;
+      template <unsigned DIM, size_t ALIGN = 0> struct FastAffine;
 
       template <typename REDOP> struct ReductionFold;
       template <typename REDOP> struct ReductionList;
+      template <typename REDOP> struct ReductionPrivate;
 
 #ifdef PRIVILEGE_CHECKS
       // TODO: Make these functions work for GPUs
@@ -627,6 +738,27 @@ namespace LegionRuntime {
 	    return result;
 	  }
 
+	  template <typename AT, unsigned DIM, size_t ALIGN>
+	  bool can_convert_helper(FastAffine<DIM, ALIGN> *dummy) const {
+	    ByteOffset offsets[DIM];
+	    T *ptr = raw_rect_ptr<DIM>(offsets);
+	    if(ptr == 0) return false;
+	    // strides must be a whole number of elements
+	    for(unsigned i = 0; i < DIM; i++)
+	      if((offsets[i].offset % (int)sizeof(T)) != 0) return false;
+	    if((ALIGN > 0) && ((((uintptr_t)ptr) % ALIGN) != 0)) return false;
+	    return true;
+	  }
+
+	  template <typename AT, unsigned DIM, size_t ALIGN>
+	  RegionAccessor<FastAffine<DIM, ALIGN>, T> convert_helper(FastAffine<DIM, ALIGN> *dummy) const {
+	    ByteOffset offsets[DIM];
+	    T *ptr = raw_rect_ptr<DIM>(offsets);
+	    assert(ptr != 0);
+	    typename FastAffine<DIM, ALIGN>::template Typed<T, T> t(ptr, offsets);
+	    return RegionAccessor<FastAffine<DIM, ALIGN>, T>(t);
+	  }
+
 	  template <typename AT, typename REDOP>
 	  bool can_convert_helper(ReductionFold<REDOP> *dummy) const {
 	    void *redfold_base = 0;
@@ -818,6 +950,36 @@ namespace LegionRuntime {
 	    REDOP::template apply<false>(*(T *)Untyped::elem_ptr(ptr), newval);
 	  }
 
+	  // bulk copies of the 'count' elements starting at 'start' to and
+	  //  from a dense user buffer
+	  inline void read_span(ptr_t start, size_t count, T *dst) const
+	  {
+#ifdef PRIVILEGE_CHECKS
+            check_privileges<ACCESSOR_READ>(this->template priv, this->region);
+#endif
+	    if(count == 0) return;
+#ifdef BOUNDS_CHECKS 
+            DebugHooks::check_bounds(this->region, start);
+            DebugHooks::check_bounds(this->region, start + (int)(count - 1));
+#endif
+	    SpanOps::gather(dst, (const char *)(this->base + (start.value * Stride<STRIDE>::value)),
+			    Stride<STRIDE>::value, count);
+	  }
+
+	  inline void write_span(ptr_t start, size_t count, const T *src) const
+	  {
+#ifdef PRIVILEGE_CHECKS
+            check_privileges<ACCESSOR_WRITE>(this->template priv, this->region);
+#endif
+	    if(count == 0) return;
+#ifdef BOUNDS_CHECKS 
+            DebugHooks::check_bounds(this->region, start);
+            DebugHooks::check_bounds(this->region, start + (int)(count - 1));
+#endif
+	    SpanOps::scatter(this->base + (start.value * Stride<STRIDE>::value),
+			     Stride<STRIDE>::value, src, count);
+	  }
+
 	  //T *elem_ptr(const Realm::DomainPoint& dp) const { return (T*)(Untyped::elem_ptr(dp)); }
 	  //T *elem_ptr_linear(const Realm::Domain& d, Realm::Domain& subrect, ByteOffset *offsets)
 	  //{ return (T*)(Untyped::elem_ptr_linear(d, subrect, offsets)); }
@@ -940,6 +1102,36 @@ namespace LegionRuntime {
 #endif
 	    REDOP::template apply<false>(*(T *)Untyped::elem_ptr(ptr), newval);
 	  }
+
+	  // bulk copies of the 'count' elements starting at 'start' to and
+	  //  from a dense user buffer
+	  inline void read_span(ptr_t start, size_t count, T *dst) const
+	  {
+#ifdef PRIVILEGE_CHECKS
+            check_privileges<ACCESSOR_READ>(this->template priv, this->region);
+#endif
+	    if(count == 0) return;
+#ifdef BOUNDS_CHECKS 
+            DebugHooks::check_bounds(this->region, start);
+            DebugHooks::check_bounds(this->region, start + (int)(count - 1));
+#endif
+	    SpanOps::gather(dst, (const char *)(this->base + (start.value * Stride<STRIDE>::value)),
+			    Stride<STRIDE>::value, count);
+	  }
+
+	  inline void write_span(ptr_t start, size_t count, const T *src) const
+	  {
+#ifdef PRIVILEGE_CHECKS
+            check_privileges<ACCESSOR_WRITE>(this->template priv, this->region);
+#endif
+	    if(count == 0) return;
+#ifdef BOUNDS_CHECKS 
+            DebugHooks::check_bounds(this->region, start);
+            DebugHooks::check_bounds(this->region, start + (int)(count - 1));
+#endif
+	    SpanOps::scatter(this->base + (start.value * Stride<STRIDE>::value),
+			     Stride<STRIDE>::value, src, count);
+	  }
 	};
       };
 
@@ -1051,6 +1243,36 @@ namespace LegionRuntime {
 #endif
 	    REDOP::template apply<false>(*(T *)Untyped::elem_ptr(ptr), newval);
 	  }
+
+	  // bulk copies of the 'count' elements starting at 'start' to and
+	  //  from a dense user buffer
+	  inline void read_span(ptr_t start, size_t count, T *dst) const
+	  {
+#ifdef PRIVILEGE_CHECKS
+            check_privileges<ACCESSOR_READ>(this->template priv, this->region);
+#endif
+	    if(count == 0) return;
+#ifdef BOUNDS_CHECKS 
+            DebugHooks::check_bounds(this->region, start);
+            DebugHooks::check_bounds(this->region, start + (int)(count - 1));
+#endif
+	    SpanOps::gather(dst, (const char *)(this->base + (start.value * Stride<STRIDE>::value)),
+			    Stride<STRIDE>::value, count);
+	  }
+
+	  inline void write_span(ptr_t start, size_t count, const T *src) const
+	  {
+#ifdef PRIVILEGE_CHECKS
+            check_privileges<ACCESSOR_WRITE>(this->template priv, this->region);
+#endif
+	    if(count == 0) return;
+#ifdef BOUNDS_CHECKS 
+            DebugHooks::check_bounds(this->region, start);
+            DebugHooks::check_bounds(this->region, start + (int)(count - 1));
+#endif
+	    SpanOps::scatter(this->base + (start.value * Stride<STRIDE>::value),
+			     Stride<STRIDE>::value, src, count);
+	  }
 	};
       };
 
@@ -1110,6 +1332,124 @@ namespace LegionRuntime {
 	};
       };
 
+      // Affine accessor with the dimension and element type fixed at compile
+      //  time and the strides held in elements rather than bytes.  The base
+      //  pointer is restrict-qualified (and assumed to be ALIGN-byte aligned
+      //  if ALIGN is non-zero) so that loops over operator[] can be
+      //  vectorized.  Bounds are only checked when BOUNDS_CHECKS is defined
+      //  and the accessor was given a rectangle to check against.
+      template <unsigned DIM, size_t ALIGN>
+      struct FastAffine {
+	template <typename T, typename PT>
+	struct Typed {
+          CUDAPREFIX
+	  Typed(void) : base(0)
+	  {
+	    for(unsigned i = 0; i < DIM; i++)
+	      strides[i] = 0;
+#ifdef BOUNDS_CHECKS
+	    has_bounds = false;
+#endif
+	  }
+
+	  // strides in bytes, as returned by raw_rect_ptr
+          CUDAPREFIX
+	  Typed(T *_base, const ByteOffset *byte_strides)
+	    : base(_base)
+	  {
+	    for(unsigned i = 0; i < DIM; i++) {
+	      assert((byte_strides[i].offset % (int)sizeof(T)) == 0);
+	      strides[i] = byte_strides[i].offset / (int)sizeof(T);
+	    }
+	    assert((ALIGN == 0) || ((((uintptr_t)_base) % ALIGN) == 0));
+#ifdef BOUNDS_CHECKS
+	    has_bounds = false;
+#endif
+	  }
+
+	  // strides in elements
+          CUDAPREFIX
+	  Typed(T *_base, const ptrdiff_t *elem_strides)
+	    : base(_base)
+	  {
+	    for(unsigned i = 0; i < DIM; i++)
+	      strides[i] = elem_strides[i];
+	    assert((ALIGN == 0) || ((((uintptr_t)_base) % ALIGN) == 0));
+#ifdef BOUNDS_CHECKS
+	    has_bounds = false;
+#endif
+	  }
+
+	  // restricts the accessor to the points in 'r'; a no-op unless
+	  //  BOUNDS_CHECKS is defined
+          CUDAPREFIX
+	  inline void set_bounds(const LegionRuntime::Arrays::Rect<DIM>& r)
+	  {
+#ifdef BOUNDS_CHECKS
+	    bounds = r;
+	    has_bounds = true;
+#endif
+	  }
+
+          CUDAPREFIX
+	  inline T *ACCESSOR_RESTRICT get_base(void) const
+	  {
+#if !defined(__CUDACC__) && (defined(__clang__) || \
+    (defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 7)))))
+	    if(ALIGN > 0)
+	      return (T *)__builtin_assume_aligned(base, (ALIGN > 0) ? ALIGN : 1);
+#endif
+	    return base;
+	  }
+
+          CUDAPREFIX
+	  inline ptrdiff_t offset(const LegionRuntime::Arrays::Point<DIM>& p) const
+	  {
+#ifdef BOUNDS_CHECKS
+	    if(has_bounds && !bounds.contains(p)) {
+	      fprintf(stderr, "BOUNDS CHECK ERROR: point out of bounds of FastAffine<%u> accessor\n", DIM);
+	      assert(false);
+	    }
+#endif
+	    ptrdiff_t off = 0;
+	    for(unsigned i = 0; i < DIM; i++)
+	      off += strides[i] * p.x[i];
+	    return off;
+	  }
+
+          CUDAPREFIX
+	  inline T *ptr(const LegionRuntime::Arrays::Point<DIM>& p) const
+	  {
+	    return get_base() + offset(p);
+	  }
+
+          CUDAPREFIX
+	  inline T& operator[](const LegionRuntime::Arrays::Point<DIM>& p) const
+	  {
+	    return get_base()[offset(p)];
+	  }
+
+          CUDAPREFIX
+	  inline T read(const LegionRuntime::Arrays::Point<DIM>& p) const
+	  {
+	    return get_base()[offset(p)];
+	  }
+
+          CUDAPREFIX
+	  inline void write(const LegionRuntime::Arrays::Point<DIM>& p, T newval) const
+	  {
+	    get_base()[offset(p)] = newval;
+	  }
+
+	  T *ACCESSOR_RESTRICT base;
+	  ptrdiff_t strides[DIM];
+#ifdef BOUNDS_CHECKS
+	  LegionRuntime::Arrays::Rect<DIM> bounds;
+	  bool has_bounds;
+#endif
+	};
+      };
+
       template <typename REDOP>
       struct ReductionFold {
 	struct Untyped {
@@ -1179,6 +1519,192 @@ namespace LegionRuntime {
 	};
       };
 
+      // exclusive bulk applies/folds, using the reduction op's DenseKernels
+      //  (see Realm::ReductionOp) when it has them
+      template <typename REDOP>
+      struct HasDenseKernels {
+	typedef char yes;
+	typedef long no;
+	template <typename T> static yes test(typename T::DenseKernels *);
+	template <typename T> static no test(...);
+	static const bool value = (sizeof(test<REDOP>(0)) == sizeof(yes));
+      };
+
+      template <typename REDOP, bool DENSE = HasDenseKernels<REDOP>::value>
+      struct ExclusiveReduce {
+	static void apply(typename REDOP::LHS *lhs, const typename REDOP::RHS *rhs, size_t count)
+	{
+	  for(size_t i = 0; i < count; i++)
+	    REDOP::template apply<true>(lhs[i], rhs[i]);
+	}
+
+	static void fold(typename REDOP::RHS *rhs1, const typename REDOP::RHS *rhs2, size_t count)
+	{
+	  for(size_t i = 0; i < count; i++)
+	    REDOP::template fold<true>(rhs1[i], rhs2[i]);
+	}
+      };
+
+      template <typename REDOP>
+      struct ExclusiveReduce<REDOP, true> {
+	static void apply(typename REDOP::LHS *lhs, const typename REDOP::RHS *rhs, size_t count)
+	{
+	  REDOP::DenseKernels::apply(lhs, rhs, count);
+	}
+
+	static void fold(typename REDOP::RHS *rhs1, const typename REDOP::RHS *rhs2, size_t count)
+	{
+	  REDOP::DenseKernels::fold(rhs1, rhs2, count);
+	}
+      };
+
+      // Reduction accessor that accumulates into per-thread private buffers
+      //  so that concurrent reducers (e.g. the threads of an OpenMP task)
+      //  need no atomics.  Each buffer covers the 'extent' elements starting
+      //  at 'lo' and is filled with REDOP::identity by its thread on first
+      //  use.  combine() folds the buffers into the target instance with the
+      //  bulk kernels and must be called exactly once, after all reductions
+      //  are done - it releases the buffers shared by all copies of the
+      //  accessor.  The target is either a reduction fold instance (buffers
+      //  are folded in) or a normal instance (buffers are applied).
+      template <typename REDOP>
+      struct ReductionPrivate {
+	template <typename T, typename PT>
+	struct Typed {
+	  typedef typename REDOP::LHS LHS;
+	  typedef typename REDOP::RHS RHS;
+
+	  struct State {
+	    char *target;
+	    size_t stride;
+	    bool fold;
+	    long long lo;
+	    size_t extent;
+	    unsigned num_threads;
+	    RHS **buffers;
+	  };
+
+	  Typed(void) : state(0) {}
+
+	  Typed(void *_target, size_t _stride, bool _fold,
+		ptr_t _lo, size_t _extent, unsigned _num_threads)
+	    : state(0)
+	  {
+	    init(_target, _stride, _fold, _lo, _extent, _num_threads);
+	  }
+
+	  // reduce into the instance behind a generic accessor - a reduction
+	  //  fold instance if it is one, otherwise a strided normal instance
+	  Typed(const Generic::Untyped& generic,
+		ptr_t _lo, size_t _extent, unsigned _num_threads)
+	    : state(0)
+	  {
+	    void *base = 0;
+	    size_t stride = 0;
+	    if(generic.get_redfold_parameters(base)) {
+	      init(base, sizeof(RHS), true, _lo, _extent, _num_threads);
+	    } else {
+#ifndef NDEBUG
+	      bool ok =
+#endif
+		generic.get_soa_parameters(base, stride);
+	      assert(ok);
+	      init(base, stride, false, _lo, _extent, _num_threads);
+	    }
+	  }
+
+	  inline void reduce(unsigned thread, ptr_t ptr, RHS newval) const
+	  {
+	    assert(thread < state->num_threads);
+	    RHS *buffer = state->buffers[thread];
+	    if(buffer == 0)
+	      buffer = allocate_buffer(thread);
+	    long long index = ptr.value - state->lo;
+#ifdef BOUNDS_CHECKS
+	    if((index < 0) || (index >= (long long)state->extent)) {
+	      fprintf(stderr, "BOUNDS CHECK ERROR: pointer %lld outside of private "
+		      "reduction buffer [%lld, %lld)\n", ptr.value, state->lo,
+		      state->lo + (long long)state->extent);
+	      assert(false);
+	    }
+#endif
+	    REDOP::template fold<true>(buffer[index], newval);
+	  }
+
+#ifdef _OPENMP
+	  inline void reduce(ptr_t ptr, RHS newval) const
+	  {
+	    reduce(omp_get_thread_num(), ptr, newval);
+	  }
+#endif
+
+	  // pass exclusive=false if other tasks may be reducing to the same
+	  //  instance at the same time (e.g. with simultaneous coherence)
+	  void combine(bool exclusive = true)
+	  {
+	    assert(state != 0);
+	    for(unsigned t = 0; t < state->num_threads; t++) {
+	      RHS *buffer = state->buffers[t];
+	      if(buffer == 0) continue;
+	      if(state->fold) {
+		RHS *dst = ((RHS *)state->target) + state->lo;
+		if(exclusive) {
+		  ExclusiveReduce<REDOP>::fold(dst, buffer, state->extent);
+		} else {
+		  for(size_t i = 0; i < state->extent; i++)
+		    REDOP::template fold<false>(dst[i], buffer[i]);
+		}
+	      } else {
+		char *dst = state->target + (state->lo * (long long)state->stride);
+		if(exclusive && (state->stride == sizeof(LHS))) {
+		  ExclusiveReduce<REDOP>::apply((LHS *)dst, buffer, state->extent);
+		} else if(exclusive) {
+		  for(size_t i = 0; i < state->extent; i++)
+		    REDOP::template apply<true>(*(LHS *)(dst + i * state->stride), buffer[i]);
+		} else {
+		  for(size_t i = 0; i < state->extent; i++)
+		    REDOP::template apply<false>(*(LHS *)(dst + i * state->stride), buffer[i]);
+		}
+	      }
+	      free(buffer);
+	    }
+	    free(state->buffers);
+	    delete state;
+	    state = 0;
+	  }
+
+	protected:
+	  void init(void *_target, size_t _stride, bool _fold,
+		    ptr_t _lo, size_t _extent, unsigned _num_threads)
+	  {
+	    assert(_num_threads > 0);
+	    state = new State;
+	    state->target = (char *)_target;
+	    state->stride = _stride;
+	    state->fold = _fold;
+	    state->lo = _lo.value;
+	    state->extent = _extent;
+	    state->num_threads = _num_threads;
+	    state->buffers = (RHS **)calloc(_num_threads, sizeof(RHS *));
+	    assert(state->buffers != 0);
+	  }
+
+	  // called by the owning thread, so the buffer is first touched (and
+	  //  placed) by the thread that will use it
+	  RHS *allocate_buffer(unsigned thread) const
+	  {
+	    RHS *buffer = (RHS *)malloc(state->extent * sizeof(RHS));
+	    assert(buffer != 0);
+	    for(size_t i = 0; i < state->extent; i++)
+	      buffer[i] = REDOP::identity;
+	    state->buffers[thread] = buffer;
+	    return buffer;
+	  }
+
+	  State *state;
+	};
+      };
+
       template <typename REDOP>
       struct ReductionList {
 	struct ReductionListEntry {
@@ -1285,5 +1811,7 @@ namespace LegionRuntime {
 };
 
 #undef CUDAPREFIX
+#undef ACCESSOR_RESTRICT
+#undef ACCESSOR_USE_SSE
       
 #endif
@@ -30,6 +30,7 @@
 
 #include "realm/timers.h"
 #include "realm/logging.h"
+#include "realm/sampling.h"
 
 #define NO_DEBUG_AMREQUESTS
 
@@ -73,34 +74,60 @@ static bool is_registered(void *ptr)
   return false;
 }
 
+// incoming messages are handed from the polling threads to the handler
+//  threads without taking a lock - each handler thread owns a queue that
+//  polling threads push onto with a CAS and that the handler thread drains
+//  all at once with an atomic exchange (so there's no ABA problem), and a
+//  given sender always maps to the same handler thread so that its messages
+//  are handled in order
 class IncomingMessageManager {
 public:
-  IncomingMessageManager(int _nodes, Realm::CoreReservationSet& crs);
+  IncomingMessageManager(int _nodes, int _num_threads,
+			 Realm::CoreReservationSet& crs);
   ~IncomingMessageManager(void);
 
   void add_incoming_message(int sender, IncomingMessage *msg);
 
-  void start_handler_threads(int count, size_t stack_size);
+  void start_handler_threads(size_t stack_size);
 
   void shutdown(void);
 
-  IncomingMessage *get_messages(int &sender, bool wait = true);
-
   void handler_thread_loop(void);
 
 protected:
+  struct HandlerQueue {
+    // most recently added message first - reversed by the consumer
+    IncomingMessage * volatile head;
+    // set by the handler thread (with the mutex held) before it sleeps
+    volatile int sleeping;
+    gasnet_hsl_t mutex;
+    gasnett_cond_t condvar;
+  };
+
+  IncomingMessage *get_messages(HandlerQueue& q, bool wait = true);
+
   int nodes;
-  int shutdown_flag;
-  IncomingMessage **heads;
-  IncomingMessage ***tails;
-  int *todo_list; // list of nodes with non-empty message lists
-  int todo_oldest, todo_newest;
-  gasnet_hsl_t mutex;
-  gasnett_cond_t condvar;
+  int num_threads;
+  volatile int shutdown_flag;
+  int next_thread_index;
+  HandlerQueue *queues; // [num_threads]
   Realm::CoreReservation *core_rsrv;
   std::vector<Realm::Thread *> handler_threads;
+  Realm::ProfilingGauges::EventCounter<int> messages_received;
 };
 
+// short messages whose handlers do a small, bounded amount of work and
+//  never block can be run directly on the polling thread that received
+//  them, skipping the handoff to a handler thread entirely
+static bool inline_handlers_enabled = true;
+static bool inline_handler_ok[256];
+
+void allow_inline_handler(int msgid)
+{
+  assert((msgid >= 0) && (msgid < 256));
+  inline_handler_ok[msgid] = true;
+}
+
 void init_deferred_frees(void)
 {
   gasnet_hsl_init(&deferred_free_mutex);
@@ -182,6 +209,7 @@ struct OutgoingMessage {
 		   int _payload_mode, void *_dstptr = 0);
   inline void set_payload_empty(void) { payload_mode = PAYLOAD_EMPTY; }
   void reserve_srcdata(void);
+  void place_in_srcdatapool(void);
 #if 0
   void set_payload(void *_payload, size_t _payload_size,
 		   int _payload_mode, void *_dstptr = 0);
@@ -225,6 +253,13 @@ public:
   // allocators must already hold the lock - prove it by passing a reference
   void *alloc_srcptr(size_t size_needed, Lock& held_lock);
 
+  // like alloc_srcptr, but waits for space to be released rather than
+  //  failing - this is the backpressure that keeps normal senders from
+  //  spilling
+  void *alloc_srcptr_blocking(size_t size_needed, Lock& held_lock);
+
+  bool can_ever_fit(size_t size_needed) const;
+
   // enqueuing a pending message must also hold the lock
   void add_pending(OutgoingMessage *msg, Lock& held_lock);
 
@@ -245,16 +280,32 @@ public:
 protected:
   size_t round_up_size(size_t size);
 
+  // the pool is managed as a ring - allocations are carved off the head,
+  //  and space is reclaimed from the tail as soon as the oldest allocation
+  //  (and anything released after it) is freed
+  struct ChunkHeader {
+    size_t size;  // including this header
+    int in_use;
+    int pad;
+  };
+  static const size_t HEADER_SIZE = sizeof(ChunkHeader);
+
+  void *ring_alloc(size_t size_needed);
+  void ring_release(void *srcptr);
+
   friend class SrcDataPool::Lock;
   gasnet_hsl_t mutex;
   gasnett_cond_t condvar;
+  char *base;
   size_t total_size;
-  std::map<char *, size_t> free_list;
+  size_t ring_head, ring_tail, ring_used;
   std::queue<OutgoingMessage *> pending_allocations;
   // debug
-  std::map<char *, size_t> in_use;
   std::map<void *, ssize_t> alloc_counts;
 
+  int current_blocked_allocs, total_blocked_allocs;
+  double total_blocked_time;
+
   size_t current_spill_bytes, peak_spill_bytes, current_spill_threshold;
 #define TRACK_PER_MESSAGE_SPILLING
 #ifdef TRACK_PER_MESSAGE_SPILLING
@@ -266,6 +317,7 @@ protected:
 public:
   static size_t max_spill_bytes;
   static size_t print_spill_threshold, print_spill_step;
+  static bool backpressure;
 };
 
 static SrcDataPool *srcdatapool = 0;
@@ -273,6 +325,7 @@ static SrcDataPool *srcdatapool = 0;
 size_t SrcDataPool::max_spill_bytes = 0;  // default = no limit
 size_t SrcDataPool::print_spill_threshold = 1 << 30;  // default = 1 GB
 size_t SrcDataPool::print_spill_step = 1 << 30;       // default = 1 GB
+bool SrcDataPool::backpressure = true;
 
 // certain threads are exempt from the max spillage due to deadlock concerns
 namespace ThreadLocal {
@@ -286,12 +339,16 @@ void release_srcptr(void *srcptr)
   srcdatapool->release_srcptr(srcptr);
 }
 
-SrcDataPool::SrcDataPool(void *base, size_t size)
+SrcDataPool::SrcDataPool(void *_base, size_t size)
 {
   gasnet_hsl_init(&mutex);
   gasnett_cond_init(&condvar);
-  free_list[(char *)base] = size;
-  total_size = size;
+  base = (char *)_base;
+  // every chunk is a multiple of the block size, so the ring must be too
+  total_size = size - (size % round_up_size(1));
+  ring_head = ring_tail = ring_used = 0;
+  current_blocked_allocs = total_blocked_allocs = 0;
+  total_blocked_time = 0;
 
   current_spill_bytes = peak_spill_bytes = 0;
 #ifdef TRACK_PER_MESSAGE_SPILLING
@@ -328,10 +385,79 @@ size_t SrcDataPool::round_up_size(size_t size)
     return size;
 }
 
+bool SrcDataPool::can_ever_fit(size_t size_needed) const
+{
+  return (HEADER_SIZE + size_needed) <= total_size;
+}
+
+void *SrcDataPool::ring_alloc(size_t size_needed)
+{
+  size_t chunk_size = round_up_size(HEADER_SIZE + size_needed);
+
+  // an empty ring can start over at the beginning
+  if(ring_used == 0)
+    ring_head = ring_tail = 0;
+
+  size_t offset;
+  if((ring_head > ring_tail) || (ring_used == 0)) {
+    // free space is [head, end) and [0, tail)
+    if((total_size - ring_head) >= chunk_size) {
+      offset = ring_head;
+    } else if(ring_tail >= chunk_size) {
+      // fill the end with a free chunk that the tail will skip over
+      if(ring_head < total_size) {
+	ChunkHeader *skip = (ChunkHeader *)(base + ring_head);
+	skip->size = total_size - ring_head;
+	skip->in_use = 0;
+	ring_used += skip->size;
+      }
+      offset = 0;
+    } else
+      return 0;
+  } else {
+    // free space is [head, tail) unless we're completely full
+    if((ring_head < ring_tail) && ((ring_tail - ring_head) >= chunk_size))
+      offset = ring_head;
+    else
+      return 0;
+  }
+
+  ChunkHeader *hdr = (ChunkHeader *)(base + offset);
+  hdr->size = chunk_size;
+  hdr->in_use = 1;
+  ring_head = offset + chunk_size;
+  if(ring_head == total_size)
+    ring_head = 0;
+  ring_used += chunk_size;
+
+  void *srcptr = base + offset + HEADER_SIZE;
+  log_sdp.debug("allocated %p + %zd (head=%zd tail=%zd used=%zd)",
+		srcptr, chunk_size, ring_head, ring_tail, ring_used);
+  return srcptr;
+}
+
+void SrcDataPool::ring_release(void *srcptr)
+{
+  ChunkHeader *hdr = (ChunkHeader *)(((char *)srcptr) - HEADER_SIZE);
+  assert((((char *)hdr) >= base) && (((char *)hdr) < (base + total_size)));
+  assert(hdr->in_use);
+  hdr->in_use = 0;
+
+  // reclaim everything from the tail up to the oldest chunk still in use
+  while(ring_used > 0) {
+    ChunkHeader *oldest = (ChunkHeader *)(base + ring_tail);
+    if(oldest->in_use) break;
+    ring_used -= oldest->size;
+    ring_tail += oldest->size;
+    if(ring_tail == total_size)
+      ring_tail = 0;
+  }
+}
+
 void *SrcDataPool::alloc_srcptr(size_t size_needed, Lock& held_lock)
 {
   // sanity check - if the requested size is larger than will ever fit, fail
-  if(size_needed > total_size)
+  if(!can_ever_fit(size_needed))
     assert(0);
 
   // early out - if our pending allocation queue is non-empty, they're
@@ -339,57 +465,26 @@ void *SrcDataPool::alloc_srcptr(size_t size_needed, Lock& held_lock)
   if(!pending_allocations.empty())
     return 0;
 
-  // round up size to something reasonable
-  size_needed = round_up_size(size_needed);
-
-  // walk the free list until we find something big enough
-  // only use the a bigger chunk if we absolutely have to 
-  // in order to avoid segmentation problems.
-  std::map<char *, size_t>::iterator it = free_list.begin();
-  char *smallest_upper_bound = 0;
-  size_t smallest_upper_size = 0;
-  while(it != free_list.end()) {
-    if(it->second == size_needed) {
-      // exact match
-      log_sdp.debug("found %p + %zd - exact", it->first, it->second);
-
-      char *srcptr = it->first;
-      free_list.erase(it);
-      in_use[srcptr] = size_needed;
-
-      return srcptr;
-    }
-
-    if(it->second > size_needed) {
-      // match with some left over
-      // Check to see if it is smaller
-      // than the largest upper bound
-      if (smallest_upper_bound == 0) {
-        smallest_upper_bound = it->first;
-        smallest_upper_size = it->second;
-      } else if (it->second < smallest_upper_size) {
-        smallest_upper_bound = it->first;
-        smallest_upper_size = it->second;
-      }
-    }
+  return ring_alloc(size_needed);
+}
 
-    // not big enough - keep looking
-    it++;
-  }
-  if (smallest_upper_bound != 0) {
-    it = free_list.find(smallest_upper_bound);
-    char *srcptr = it->first + (it->second - size_needed);
-    it->second -= size_needed;
-    in_use[srcptr] = size_needed;
+void *SrcDataPool::alloc_srcptr_blocking(size_t size_needed, Lock& held_lock)
+{
+  void *srcptr = alloc_srcptr(size_needed, held_lock);
+  if(srcptr) return srcptr;
 
-    log_sdp.debug("found %p + %zd > %zd", it->first, it->second, size_needed);
+  current_blocked_allocs++;
+  total_blocked_allocs++;
+  double t1 = Realm::Clock::current_time();
 
-    return srcptr;
-  }
+  do {
+    gasnett_cond_wait(&condvar, &mutex.lock);
+    srcptr = alloc_srcptr(size_needed, held_lock);
+  } while(!srcptr);
 
-  // allocation failed - let caller decide what to do (probably add it as a
-  //   pending allocation after maybe moving data)
-  return 0;
+  current_blocked_allocs--;
+  total_blocked_time += Realm::Clock::current_time() - t1;
+  return srcptr;
 }
 
 void SrcDataPool::add_pending(OutgoingMessage *msg, Lock& held_lock)
@@ -399,7 +494,7 @@ void SrcDataPool::add_pending(OutgoingMessage *msg, Lock& held_lock)
 
   // sanity check - if the requested size is larger than will ever fit, 
   //  we're just dead
-  if(msg->payload_size > total_size) {
+  if(!can_ever_fit(msg->payload_size)) {
     log_sdp.error("allocation of %zd can never be satisfied! (max = %zd)",
 		  msg->payload_size, total_size);
     assert(0);
@@ -410,87 +505,30 @@ void SrcDataPool::add_pending(OutgoingMessage *msg, Lock& held_lock)
 
 void SrcDataPool::release_srcptr(void *srcptr)
 {
-  char *srcptr_c = (char *)srcptr;
-
   log_sdp.debug("releasing srcptr = %p", srcptr);
 
-  // releasing a srcptr span may result in some pending allocations being
+  // releasing a srcptr may result in some pending allocations being
   //   satisfied - keep a list so their actual copies can happen without
   //   holding the SDP lock
   std::vector<std::pair<OutgoingMessage *, void *> > satisfied;
   {
     Lock held_lock(*this);
 
-    // look up the pointer to find its size
-    std::map<char *, size_t>::iterator it = in_use.find(srcptr_c);
-    assert(it != in_use.end());
-    size_t size = it->second;
-    in_use.erase(it);  // remove from in use list
-
-    // we'd better not be in the free list ourselves
-    assert(free_list.find(srcptr_c) == free_list.end());
+    ring_release(srcptr);
 
-    // see if we can absorb any adjacent ranges
-    if(!free_list.empty()) {
-      std::map<char *, size_t>::iterator above = free_list.lower_bound(srcptr_c);
-      
-      // look below first
-      while(above != free_list.begin()) {
-	std::map<char *, size_t>::iterator below = above;  below--;
-	
-	log_sdp.spew("merge?  %p+%zd %p+%zd NONE", below->first, below->second, srcptr_c, size);
-
-	if((below->first + below->second) != srcptr_c)
-	  break;
-
-	srcptr_c = below->first;
-	size += below->second;
-	free_list.erase(below);
-      }
-
-      // now look above
-      while(above != free_list.end()) {
-	log_sdp.spew("merge?  NONE %p+%zd %p+%zd", srcptr_c, size, above->first, above->second);
-
-	if((srcptr_c + size) != above->first)
-	  break;
-
-	size += above->second;
-	std::map<char *, size_t>::iterator to_nuke(above++);
-	free_list.erase(to_nuke);
-      }
-    }
-
-    // is this possibly-merged span large enough to satisfy the first pending
-    //  allocation (if any)?
-    if(!pending_allocations.empty() && 
-       (size >= pending_allocations.front()->payload_size)) {
+    // pending allocations are first in line, and are satisfied in order
+    while(!pending_allocations.empty()) {
       OutgoingMessage *msg = pending_allocations.front();
+      void *ptr = ring_alloc(msg->payload_size);
+      if(!ptr) break;
+
+      satisfied.push_back(std::make_pair(msg, ptr));
       pending_allocations.pop();
-      size_t act_size = round_up_size(msg->payload_size);
-      in_use[srcptr_c] = act_size;
-      satisfied.push_back(std::make_pair(msg, srcptr_c));
-
-      // was anything left?  if so, add it to the list of free spans
-      if(size > act_size)
-	free_list[srcptr_c + act_size] = size - act_size;
-
-      // now see if we can satisfy any other pending allocations - use the
-      //  normal allocator routine here because there might be better choices
-      //  to use than the span we just freed (assuming any of it is left)
-      while(!pending_allocations.empty()) {
-	OutgoingMessage *msg = pending_allocations.front();
-	void *ptr = alloc_srcptr(msg->payload_size, held_lock);
-	if(!ptr) break;
-
-	satisfied.push_back(std::make_pair(msg, ptr));
-	pending_allocations.pop();
-      }
-    } else {
-      // no?  then no other span will either, so just add this to the free list
-      //  and return
-      free_list[srcptr_c] = size;
     }
+
+    // anybody waiting for space can try again once the pending ones are done
+    if((current_blocked_allocs > 0) && pending_allocations.empty())
+      gasnett_cond_broadcast(&condvar);
   }
 
   // with the lock released, tell any messages that got srcptr's so they can
@@ -601,6 +639,10 @@ void SrcDataPool::print_spill_data(Realm::Logger::LoggingLevel level)
     msg << "\n"
 	<< "   suspensions=" << total_suspended_spillers
 	<< " avg time=" << (total_suspended_time / total_suspended_spillers);
+  if(total_blocked_allocs > 0)
+    msg << "\n"
+	<< "   blocked allocations=" << total_blocked_allocs
+	<< " avg time=" << (total_blocked_time / total_blocked_allocs);
 }
 
 #if 0
@@ -714,11 +756,39 @@ OutgoingMessage::~OutgoingMessage(void)
 }
 
 // these values can be overridden by command-line parameters
-static int num_lmbs = 2;
+static int num_lmbs = 4;  // reserved per peer - the most an endpoint can use
+static int min_lmbs = 2;  // what an endpoint starts with and shrinks back to
 static size_t lmb_size = 1 << 20; // 1 MB
+static size_t lmb_budget = 0; // limit on LMBs in use across all peers (0 = none)
 static bool force_long_messages = true;
 static int max_msgs_to_send = 8;
 
+// LMB space is carved out of the segment at attach time, so adapting to
+//  traffic means changing how many of a peer's reserved LMBs are in use -
+//  an endpoint that stalls waiting for a flip ack takes another one (if the
+//  budget allows), and one that's gone idle gives its extras back
+static int lmbs_in_use = 0;
+static const long long LMB_IDLE_SHRINK_NS = 100000000LL; // 100 ms
+
+static bool reserve_lmb(void)
+{
+  int max_in_use = (int)(lmb_budget / lmb_size);
+  if(lmb_budget == 0) {
+    __sync_fetch_and_add(&lmbs_in_use, 1);
+    return true;
+  }
+  int newval = __sync_add_and_fetch(&lmbs_in_use, 1);
+  if(newval <= max_in_use)
+    return true;
+  __sync_fetch_and_sub(&lmbs_in_use, 1);
+  return false;
+}
+
+static void release_lmb(void)
+{
+  __sync_fetch_and_sub(&lmbs_in_use, 1);
+}
+
 // returns the largest payload that can be sent to a node (to a non-pinned
 //   address)
 size_t get_lmb_size(int target_node)
@@ -845,19 +915,19 @@ protected:
 static DetailedMessageTiming detailed_message_timing;
 #endif
 
-IncomingMessageManager::IncomingMessageManager(int _nodes, Realm::CoreReservationSet& crs)
-  : nodes(_nodes), shutdown_flag(0)
+IncomingMessageManager::IncomingMessageManager(int _nodes, int _num_threads,
+					       Realm::CoreReservationSet& crs)
+  : nodes(_nodes), num_threads(_num_threads), shutdown_flag(0),
+    next_thread_index(0), messages_received("realm/active messages received")
 {
-  heads = new IncomingMessage *[nodes];
-  tails = new IncomingMessage **[nodes];
-  for(int i = 0; i < nodes; i++) {
-    heads[i] = 0;
-    tails[i] = 0;
-  }
-  todo_list = new int[nodes + 1];  // an extra entry to distinguish full from empty
-  todo_oldest = todo_newest = 0;
-  gasnet_hsl_init(&mutex);
-  gasnett_cond_init(&condvar);
+  assert(num_threads > 0);
+  queues = new HandlerQueue[num_threads];
+  for(int i = 0; i < num_threads; i++) {
+    queues[i].head = 0;
+    queues[i].sleeping = 0;
+    gasnet_hsl_init(&queues[i].mutex);
+    gasnett_cond_init(&queues[i].condvar);
+  }
 
   core_rsrv = new Realm::CoreReservation("AM handlers", crs,
 					 Realm::CoreReservationParameters());
@@ -865,44 +935,61 @@ IncomingMessageManager::IncomingMessageManager(int _nodes, Realm::CoreReservatio
 
 IncomingMessageManager::~IncomingMessageManager(void)
 {
-  delete[] heads;
-  delete[] tails;
-  delete[] todo_list;
+  delete[] queues;
 }
 
+// set on the polling threads, which are the only places it's safe to run a
+//  handler inline (other callers of gasnet_AMPoll may be holding locks)
+namespace ThreadLocal {
+  __thread bool inline_handlers_ok = false;
+};
+
 void IncomingMessageManager::add_incoming_message(int sender, IncomingMessage *msg)
 {
 #ifdef DEBUG_INCOMING
   printf("adding incoming message from %d\n", sender);
 #endif
-  gasnet_hsl_lock(&mutex);
-  if(heads[sender]) {
-    // tack this on to the existing list
-    assert(tails[sender]);
-    *(tails[sender]) = msg;
-    tails[sender] = &(msg->next_msg);
-  } else {
-    // this starts a list, and the node needs to be added to the todo list
-    heads[sender] = msg;
-    tails[sender] = &(msg->next_msg);
-    todo_list[todo_newest] = sender;
-    todo_newest++;
-    if(todo_newest > nodes)
-      todo_newest = 0;
-    assert(todo_newest != todo_oldest);  // should never wrap around
-    gasnett_cond_broadcast(&condvar);  // wake up any sleepers
+  messages_received += 1;
+  if(ThreadLocal::inline_handlers_ok && inline_handler_ok[msg->get_msgid()]) {
+#ifdef DETAILED_MESSAGE_TIMING
+    int timing_idx = detailed_message_timing.get_next_index();
+    CurrentTime start_time;
+#endif
+    msg->run_handler();
+#ifdef DETAILED_MESSAGE_TIMING
+    detailed_message_timing.record(timing_idx, sender, msg->get_msgid(),
+				   -18, // 0xee - flagged as an incoming message,
+				   msg->get_msgsize(), 0, start_time, CurrentTime());
+#endif
+    delete msg;
+    return;
+  }
+
+  HandlerQueue& q = queues[sender % num_threads];
+  IncomingMessage *old_head;
+  do {
+    old_head = q.head;
+    msg->next_msg = old_head;
+  } while(!__sync_bool_compare_and_swap(&q.head, old_head, msg));
+
+  // the CAS above is a full barrier, so if the handler thread hasn't
+  //  announced it's going to sleep yet, it will see our message when it
+  //  rechecks the queue
+  if(!old_head && q.sleeping) {
+    gasnet_hsl_lock(&q.mutex);
+    gasnett_cond_signal(&q.condvar);
+    gasnet_hsl_unlock(&q.mutex);
   }
-  gasnet_hsl_unlock(&mutex);
 }
 
-void IncomingMessageManager::start_handler_threads(int count, size_t stack_size)
+void IncomingMessageManager::start_handler_threads(size_t stack_size)
 {
-  handler_threads.resize(count);
+  handler_threads.resize(num_threads);
 
   Realm::ThreadLaunchParameters tlp;
   tlp.set_stack_size(stack_size);
 
-  for(int i = 0; i < count; i++)
+  for(int i = 0; i < num_threads; i++)
     handler_threads[i] = Realm::Thread::create_kernel_thread<IncomingMessageManager, 
 							     &IncomingMessageManager::handler_thread_loop>(this,
 													   tlp,
@@ -911,12 +998,13 @@ void IncomingMessageManager::start_handler_threads(int count, size_t stack_size)
 
 void IncomingMessageManager::shutdown(void)
 {
-  gasnet_hsl_lock(&mutex);
-  if(!shutdown_flag) {
-    shutdown_flag = true;
-    gasnett_cond_broadcast(&condvar);  // wake up any sleepers
+  shutdown_flag = 1;
+  __sync_synchronize();
+  for(int i = 0; i < num_threads; i++) {
+    gasnet_hsl_lock(&queues[i].mutex);
+    gasnett_cond_signal(&queues[i].condvar);  // wake up any sleepers
+    gasnet_hsl_unlock(&queues[i].mutex);
   }
-  gasnet_hsl_unlock(&mutex);
 
   for(std::vector<Realm::Thread *>::iterator it = handler_threads.begin();
       it != handler_threads.end();
@@ -927,40 +1015,35 @@ void IncomingMessageManager::shutdown(void)
   handler_threads.clear();
 }
 
-IncomingMessage *IncomingMessageManager::get_messages(int &sender, bool wait)
+// takes every message currently in the queue, returning them oldest first
+IncomingMessage *IncomingMessageManager::get_messages(HandlerQueue& q, bool wait)
 {
-  gasnet_hsl_lock(&mutex);
-  while(todo_oldest == todo_newest) {
-    // todo list is empty
-    if(shutdown_flag || !wait)
-      break;
+  IncomingMessage *list = __sync_lock_test_and_set(&q.head, (IncomingMessage *)0);
+
+  if(!list && wait) {
+    gasnet_hsl_lock(&q.mutex);
+    q.sleeping = 1;
+    __sync_synchronize();
+    while(!q.head && !shutdown_flag) {
 #ifdef DEBUG_INCOMING
-    printf("incoming message list is empty - sleeping\n");
+      printf("incoming message list is empty - sleeping\n");
 #endif
-    gasnett_cond_wait(&condvar, &mutex.lock);
+      gasnett_cond_wait(&q.condvar, &q.mutex.lock);
+    }
+    q.sleeping = 0;
+    gasnet_hsl_unlock(&q.mutex);
+
+    list = __sync_lock_test_and_set(&q.head, (IncomingMessage *)0);
   }
-  IncomingMessage *retval;
-  if(todo_oldest == todo_newest) {
-    // still empty
-    sender = -1;
-    retval = 0;
-#ifdef DEBUG_INCOMING
-    printf("incoming message list is still empty!\n");
-#endif
-  } else {
-    // pop the oldest entry off the todo list
-    sender = todo_list[todo_oldest];
-    todo_oldest++;
-    if(todo_oldest > nodes)
-      todo_oldest = 0;
-    retval = heads[sender];
-    heads[sender] = 0;
-    tails[sender] = 0;
-#ifdef DEBUG_INCOMING
-    printf("handling incoming messages from %d\n", sender);
-#endif
+
+  // reverse the list to get back to arrival order
+  IncomingMessage *retval = 0;
+  while(list) {
+    IncomingMessage *next = list->next_msg;
+    list->next_msg = retval;
+    retval = list;
+    list = next;
   }
-  gasnet_hsl_unlock(&mutex);
   return retval;
 }    
 
@@ -977,14 +1060,23 @@ void IncomingMessageManager::handler_thread_loop(void)
   // messages enqueued in response to incoming messages can never be stalled
   ThreadLocal::always_allow_spilling = true;
 
+  int thread_index = __sync_fetch_and_add(&next_thread_index, 1);
+  assert(thread_index < num_threads);
+  HandlerQueue& q = queues[thread_index];
+
   while (true) {
-    int sender = -1;
-    IncomingMessage *current_msg = get_messages(sender);
+    IncomingMessage *current_msg = get_messages(q);
     if(!current_msg) {
+      // we only come back empty-handed on shutdown, but messages might
+      //  have snuck in as we noticed it
+      if(!shutdown_flag) continue;
+      current_msg = get_messages(q, false /*!wait*/);
+      if(!current_msg) {
 #ifdef DEBUG_INCOMING
-      printf("received empty list - assuming shutdown!\n");
+	printf("received empty list - assuming shutdown!\n");
 #endif
-      break;
+	break;
+      }
     }
 #ifdef DETAILED_MESSAGE_TIMING
     int count = 0;
@@ -1034,6 +1126,14 @@ public:
     cur_write_offset = 0;
     cur_write_count = 0;
 
+    // every endpoint gets its minimum regardless of the budget
+    active_lmbs = min_lmbs;
+    __sync_fetch_and_add(&lmbs_in_use, active_lmbs);
+    last_lmb_activity = 0;
+    stall_start = 0;
+    stall_ns = 0;
+    stall_count = 0;
+
     //cur_long_ptr = 0;
     //cur_long_chunk_idx = 0;
     //cur_long_size = 0;
@@ -1187,8 +1287,18 @@ public:
 	  continue;
 	}
 
-	// are we waiting for the next LMB to become available?
+	// are we waiting for the next LMB to become available?  if we have
+	//  more reserved and the budget allows, use one of those instead
+	if(!lmb_w_avail[cur_write_lmb] && (cur_write_count == 0) &&
+	   (active_lmbs < num_lmbs) && lmb_w_avail[active_lmbs] &&
+	   reserve_lmb()) {
+	  log_amsg.info("growing LMBs for %d->%d to %d",
+			gasnet_mynode(), peer, active_lmbs + 1);
+	  cur_write_lmb = active_lmbs++;
+	}
 	if(!lmb_w_avail[cur_write_lmb]) {
+	  if(stall_start == 0)
+	    stall_start = Realm::Clock::current_time_in_nanoseconds();
 #ifdef DETAILED_MESSAGE_TIMING
 	  // log this if we haven't already
 	  int timing_idx = -1;
@@ -1206,6 +1316,13 @@ public:
 	  break;
 	}
 
+	// if we were stalled, we aren't any more
+	if(stall_start) {
+	  stall_ns += Realm::Clock::current_time_in_nanoseconds() - stall_start;
+	  stall_count++;
+	  stall_start = 0;
+	}
+
 	// do we have enough room in the current LMB?
 	assert(hdr->payload_size <= lmb_size);
 	if((cur_write_offset + hdr->payload_size) <= lmb_size) {
@@ -1214,6 +1331,7 @@ public:
 	  //  sending the message
 	  char *dest_ptr = lmb_w_bases[cur_write_lmb] + cur_write_offset;
 	  cur_write_offset += hdr->payload_size;
+	  last_lmb_activity = Realm::Clock::current_time_in_nanoseconds();
           // keep write offset aligned to 128B
           if(cur_write_offset & 0x7f)
             cur_write_offset = ((cur_write_offset >> 7) + 1) << 7;
@@ -1247,7 +1365,7 @@ public:
 	  int flip_buffer = cur_write_lmb;
 	  int flip_count = cur_write_count;
 	  lmb_w_avail[cur_write_lmb] = false;
-	  cur_write_lmb = (cur_write_lmb + 1) % num_lmbs;
+	  cur_write_lmb = (cur_write_lmb + 1) % active_lmbs;
 	  cur_write_offset = 0;
 	  cur_write_count = 0;
 
@@ -1300,6 +1418,17 @@ public:
 
   bool enqueue_message(OutgoingMessage *hdr, bool in_order)
   {
+    // a payload we'd have to copy goes straight into the srcdatapool, waiting
+    //  for space if necessary - this has to happen before we take the
+    //  endpoint's mutex, as the sends that will free up space need it, and
+    //  isn't allowed on threads that are exempt from spilling limits (i.e.
+    //  the ones that keep messages moving)
+    if((hdr->payload_size > 0) && (hdr->payload_mode == PAYLOAD_COPY) &&
+       srcdatapool && SrcDataPool::backpressure &&
+       !ThreadLocal::always_allow_spilling &&
+       srcdatapool->can_ever_fit(hdr->payload_size))
+      hdr->place_in_srcdatapool();
+
     // BEFORE we take the message manager's mutex, we reserve the ability to
     //  allocate spill data
     if((hdr->payload_size > 0) &&
@@ -1480,6 +1609,23 @@ public:
     gasnet_hsl_unlock(&mutex);
   }
 
+  // gives back one extra LMB if we haven't written to one in a while - the
+  //  highest one can only go if it's not the one we're writing into
+  void shrink_idle_lmbs(long long now)
+  {
+    if(active_lmbs <= min_lmbs) return; // early out without the lock
+    gasnet_hsl_lock(&mutex);
+    if((active_lmbs > min_lmbs) &&
+       ((now - last_lmb_activity) > LMB_IDLE_SHRINK_NS) &&
+       (cur_write_lmb != (active_lmbs - 1))) {
+      active_lmbs--;
+      release_lmb();
+      log_amsg.info("shrinking LMBs for %d->%d to %d",
+		    gasnet_mynode(), peer, active_lmbs);
+    }
+    gasnet_hsl_unlock(&mutex);
+  }
+
 protected:
   void send_short(OutgoingMessage *hdr)
   {
@@ -1882,6 +2028,11 @@ public:
   char **lmb_r_bases; // [num_lmbs]
   int *lmb_r_counts; // [num_lmbs]
   bool *lmb_w_avail; // [num_lmbs]
+  int active_lmbs; // how many of our LMBs on the peer we're cycling through
+  long long last_lmb_activity;
+  long long stall_start; // when we started waiting on a flip ack (0 = not)
+  long long stall_ns;
+  int stall_count;
   //void *cur_long_ptr;
   //int cur_long_chunk_idx;
   //size_t cur_long_size;
@@ -1922,11 +2073,30 @@ void OutgoingMessage::set_payload(PayloadSource *_payload_src,
 // called once we have reserved a space in a given outgoing queue so that
 //  we can't get put behind somebody who failed a srcptr allocation (and might
 //  need us to go out the door to remove the blockage)
+void OutgoingMessage::place_in_srcdatapool(void)
+{
+  void *srcptr;
+  {
+    SrcDataPool::Lock held_lock(*srcdatapool);
+    srcptr = srcdatapool->alloc_srcptr_blocking(payload_size, held_lock);
+  }
+  log_sdp.info("placed %p (%d)", srcptr, payload_mode);
+
+  // serialize directly into the pool
+  payload_src->copy_data(srcptr);
+  delete payload_src;
+  payload_src = 0;
+  payload = srcptr;
+  payload_mode = PAYLOAD_SRCPTR;
+}
+
 void OutgoingMessage::reserve_srcdata(void)
 {
-  // no or empty payload cases are easy
+  // no or empty payload cases are easy, and a payload that's already in the
+  //  srcdatapool has nothing left to do
   if((payload_mode == PAYLOAD_NONE) ||
-     (payload_mode == PAYLOAD_EMPTY)) return;
+     (payload_mode == PAYLOAD_EMPTY) ||
+     (payload_mode == PAYLOAD_SRCPTR)) return;
 
   // if the payload is stable and in registered memory AND contiguous, we can
   //  just use it
@@ -2057,6 +2227,7 @@ public:
 
     // for worker threads
     shutdown_flag = false;
+    last_lmb_sweep = 0;
     core_rsrv = new Realm::CoreReservation("EndpointManager workers", crs,
 					   Realm::CoreReservationParameters());
   }
@@ -2182,14 +2353,15 @@ public:
 
       ActiveMessageEndpoint *e = endpoints[i];
 
-      fprintf(f, "AMS: %d->%d: S=%zd L=%zd(%zd) W=%d,%d,%zd,%c,%c R=%d,%d\n",
+      fprintf(f, "AMS: %d->%d: S=%zd L=%zd(%zd) W=%d,%d,%zd,%c,%c R=%d,%d A=%d F=%d,%.3fms\n",
               mynode, i,
               e->out_short_hdrs.size(),
               e->out_long_hdrs.size(), (e->out_long_hdrs.size() ? 
                                         (e->out_long_hdrs.front())->payload_size : 0),
               e->cur_write_lmb, e->cur_write_count, e->cur_write_offset,
               (e->lmb_w_avail[0] ? 'y' : 'n'), (e->lmb_w_avail[1] ? 'y' : 'n'),
-              e->lmb_r_counts[0], e->lmb_r_counts[1]);
+              e->lmb_r_counts[0], e->lmb_r_counts[1],
+              e->active_lmbs, e->stall_count, 1e-6 * e->stall_ns);
     }
     fflush(f);
 #endif
@@ -2203,6 +2375,18 @@ public:
 
   void stop_threads(void);
 
+  // called periodically by the polling threads
+  void shrink_idle_lmbs(void)
+  {
+    long long now = Realm::Clock::current_time_in_nanoseconds();
+    long long old = last_lmb_sweep;
+    if((now - old) < LMB_IDLE_SHRINK_NS) return;
+    if(!__sync_bool_compare_and_swap(&last_lmb_sweep, old, now)) return;
+    for(int i = 0; i < total_endpoints; i++)
+      if(endpoints[i])
+	endpoints[i]->shrink_idle_lmbs(now);
+  }
+
 protected:
   // runs in a separeate thread
   void polling_worker_loop(void);
@@ -2215,6 +2399,7 @@ private:
   int *todo_list;
   int todo_oldest, todo_newest;
   bool shutdown_flag;
+  long long last_lmb_sweep;
   Realm::CoreReservation *core_rsrv;
   std::vector<Realm::Thread *> polling_threads;
 #ifdef TRACE_MESSAGES
@@ -2256,6 +2441,16 @@ void init_endpoints(gasnet_handlerentry_t *handlers, int hcount,
       continue;
     }
 
+    if(!strcmp(argv[i], "-ll:minlmbs")) {
+      min_lmbs = atoi(argv[++i]);
+      continue;
+    }
+
+    if(!strcmp(argv[i], "-ll:lmbbudget")) {
+      lmb_budget = ((size_t)atoi(argv[++i])) << 20; // convert MB to bytes
+      continue;
+    }
+
     if(!strcmp(argv[i], "-ll:lmbsize")) {
       lmb_size = ((size_t)atoi(argv[++i])) << 10; // convert KB to bytes
       continue;
@@ -2276,6 +2471,11 @@ void init_endpoints(gasnet_handlerentry_t *handlers, int hcount,
       continue;
     }
 
+    if(!strcmp(argv[i], "-ll:inlinehandlers")) {
+      inline_handlers_enabled = atoi(argv[++i]) != 0;
+      continue;
+    }
+
     if(!strcmp(argv[i], "-ll:spillwarn")) {
       SrcDataPool::print_spill_threshold = ((size_t)atoi(argv[++i])) << 20; // convert MB to bytes
       continue;
@@ -2286,12 +2486,22 @@ void init_endpoints(gasnet_handlerentry_t *handlers, int hcount,
       continue;
     }
 
+    if(!strcmp(argv[i], "-ll:sdpblock")) {
+      SrcDataPool::backpressure = atoi(argv[++i]) != 0;
+      continue;
+    }
+
     if(!strcmp(argv[i], "-ll:spillstall")) {
       SrcDataPool::max_spill_bytes = ((size_t)atoi(argv[++i])) << 20; // convert MB to bytes
       continue;
     }
   }
 
+  // min can't be more than we reserve (and an endpoint needs at least one)
+  if(min_lmbs > num_lmbs)
+    min_lmbs = num_lmbs;
+  assert(min_lmbs > 0);
+
   size_t total_lmb_size = (gasnet_nodes() * 
 			   num_lmbs *
 			   lmb_size);
@@ -2441,6 +2651,11 @@ void EndpointManager::stop_threads(void)
 
 void EndpointManager::polling_worker_loop(void)
 {
+  if(inline_handlers_enabled)
+    ThreadLocal::inline_handlers_ok = true;
+  // messages sent by inline handlers can't be stalled either
+  ThreadLocal::always_allow_spilling = true;
+
   while(true) {
     bool still_more = endpoint_manager->push_messages(max_msgs_to_send);
 
@@ -2450,6 +2665,9 @@ void EndpointManager::polling_worker_loop(void)
 
     CHECK_GASNET( gasnet_AMPoll() );
 
+    if(min_lmbs < num_lmbs)
+      shrink_idle_lmbs();
+
 #ifdef TRACE_MESSAGES
     // see if it's time to write out another update
     int now = (int)(Realm::Clock::current_time());
@@ -2470,9 +2688,9 @@ void start_polling_threads(int count)
 
 void start_handler_threads(int count, Realm::CoreReservationSet& crs, size_t stack_size)
 {
-  incoming_message_manager = new IncomingMessageManager(gasnet_nodes(), crs);
+  incoming_message_manager = new IncomingMessageManager(gasnet_nodes(), count, crs);
 
-  incoming_message_manager->start_handler_threads(count, stack_size);
+  incoming_message_manager->start_handler_threads(stack_size);
 }
 
 void stop_activemsg_threads(void)
@@ -77,6 +77,15 @@
       REMOTE_IB_ALLOC_REQUEST_MSGID,
       REMOTE_IB_ALLOC_RESPONSE_MSGID,
       REMOTE_IB_FREE_REQUEST_MSGID,
+      BARRIER_COMBINE_ACK_MSGID,
+      EVENT_SUBSCRIBE_BATCH_MSGID,
+      EVENT_UPDATE_BATCH_MSGID,
+      CREATE_INST_BATCH_MSGID,
+      CREATE_INST_BATCH_RPLID,
+      XFERDES_COMPRESSED_WRITE_MSGID,
+      NODE_ANNOUNCE_TREE_MSGID,
+      COLLECTIVE_MSGID,
+      DEPPART_DATA_MSGID,
     };
 
 
@@ -262,6 +271,10 @@ class IncomingMessageManager;
 
 extern void enqueue_incoming(gasnet_node_t sender, IncomingMessage *msg);
 
+// marks a message's handler as safe to run directly on a polling thread
+//  (i.e. it does a small, bounded amount of work and never blocks)
+extern void allow_inline_handler(int msgid);
+
 extern void handle_long_msgptr(gasnet_node_t source, const void *ptr);
 //extern size_t adjust_long_msgsize(gasnet_node_t source, void *ptr, size_t orig_size);
 extern bool adjust_long_msgsize(gasnet_node_t source, void *&ptr, size_t &buffer_size,
@@ -607,11 +620,14 @@ class ActiveMessageShortNoReply {
 #endif
   }
 
-  static int add_handler_entries(gasnet_handlerentry_t *entries, const char *description)
+  static int add_handler_entries(gasnet_handlerentry_t *entries, const char *description,
+				 bool run_inline = false)
   {
     assert(sizeof(MessageRawArgsType) <= 64);  // max of 16 4-byte args
     entries[0].index = MSGID;
     entries[0].fnptr = (void (*)()) (MessageRawArgsType::handler_short);
+    if(run_inline)
+      allow_inline_handler(MSGID);
 #ifdef ACTIVE_MESSAGE_TRACE
     record_am_handler(MSGID, description);
 #endif
@@ -838,7 +854,8 @@ class BaseReply {};
 
 class ActiveMessagesNotImplemented {
 public:
-  static int add_handler_entries(gasnet_handlerentry_t *entries, const char *description)
+  static int add_handler_entries(gasnet_handlerentry_t *entries, const char *description,
+				 bool run_inline = false)
   {
     // no error here - want to allow startup code to run ok
     return 0;
@@ -0,0 +1,338 @@
+/* Copyright 2017 Stanford University, NVIDIA Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef __LEGION_DOMAIN_TREE_H__
+#define __LEGION_DOMAIN_TREE_H__
+
+#include "legion_types.h"
+
+#include <set>
+#include <vector>
+#include <algorithm>
+
+namespace Legion {
+  namespace Internal {
+
+    /**
+     * \class DomainTree
+     * A bounding volume hierarchy over a set of rectangular
+     * domains that can find all the domains intersecting a
+     * query domain in time logarithmic in the number of domains
+     * plus the size of the output. The tree is immutable once
+     * built. Unstructured domains have no bounds that we can
+     * cheaply index, so a set of domains that contains any of
+     * them (or that mixes dimensions) is not indexed and callers
+     * must fall back to testing each domain.
+     */
+    class DomainTree {
+    public:
+      // Below this many domains a linear scan is just as fast
+      static const size_t MIN_INDEXED_DOMAINS = 16;
+      static const unsigned MAX_LEAF_DOMAINS = 4;
+    public:
+      struct Bounds {
+      public:
+        coord_t lo[Domain::MAX_RECT_DIM];
+        coord_t hi[Domain::MAX_RECT_DIM];
+      };
+      struct TreeNode {
+      public:
+        Bounds bounds;
+        // Leaves hold entries [first,first+count), interior nodes
+        // have their left child right after them and their right
+        // child at index 'first'
+        unsigned first, count;
+      };
+      class CenterCompare {
+      public:
+        CenterCompare(const std::vector<Bounds> &b, int d)
+          : bounds(b), dim(d) { }
+      public:
+        inline bool operator()(unsigned left, unsigned right) const
+        {
+          return ((bounds[left].lo[dim] + bounds[left].hi[dim]) <
+                  (bounds[right].lo[dim] + bounds[right].hi[dim]));
+        }
+      private:
+        const std::vector<Bounds> &bounds;
+        const int dim;
+      };
+    public:
+      DomainTree(const std::set<Domain> &domains);
+      DomainTree(const DomainTree &rhs);
+      ~DomainTree(void);
+    public:
+      DomainTree& operator=(const DomainTree &rhs);
+    public:
+      inline bool is_indexed(void) const { return (dim > 0); }
+      // Same contract as IndexTreeNode::compute_intersections: if
+      // compute is false we stop at the first intersection found
+      bool intersect(const Domain &query,
+                     std::set<Domain> &result, bool compute) const;
+    protected:
+      unsigned build(unsigned first, unsigned last);
+      template<int DIM>
+      bool intersect_rects(const Domain &query,
+                           std::set<Domain> &result, bool compute) const;
+    protected:
+      int dim;
+      std::vector<Domain> domains;
+      std::vector<Bounds> bounds;
+      std::vector<unsigned> order;
+      std::vector<TreeNode> nodes;
+    };
+
+    /////////////////////////////////////////////////////////////
+    // Domain Tree
+    /////////////////////////////////////////////////////////////
+
+    //--------------------------------------------------------------------------
+    inline DomainTree::DomainTree(const std::set<Domain> &input)
+      : dim(0)
+    //--------------------------------------------------------------------------
+    {
+      if (input.size() < MIN_INDEXED_DOMAINS)
+        return;
+      const int input_dim = input.begin()->get_dim();
+      if (input_dim == 0)
+        return;
+      domains.reserve(input.size());
+      bounds.reserve(input.size());
+      for (std::set<Domain>::const_iterator it = input.begin();
+            it != input.end(); it++)
+      {
+        if (it->get_dim() != input_dim)
+        {
+          // Mixed dimensions so we can't index these
+          domains.clear();
+          bounds.clear();
+          return;
+        }
+        Bounds b;
+        bool empty = false;
+        switch (input_dim)
+        {
+          case 1:
+            {
+              LegionRuntime::Arrays::Rect<1> r = it->get_rect<1>();
+              r.lo.to_array(b.lo);
+              r.hi.to_array(b.hi);
+              empty = (r.volume() == 0);
+              break;
+            }
+          case 2:
+            {
+              LegionRuntime::Arrays::Rect<2> r = it->get_rect<2>();
+              r.lo.to_array(b.lo);
+              r.hi.to_array(b.hi);
+              empty = (r.volume() == 0);
+              break;
+            }
+          case 3:
+            {
+              LegionRuntime::Arrays::Rect<3> r = it->get_rect<3>();
+              r.lo.to_array(b.lo);
+              r.hi.to_array(b.hi);
+              empty = (r.volume() == 0);
+              break;
+            }
+          default:
+            assert(false);
+        }
+        // Empty domains can never intersect anything
+        if (empty)
+          continue;
+        domains.push_back(*it);
+        bounds.push_back(b);
+      }
+      dim = input_dim;
+      if (domains.empty())
+        return;
+      order.resize(domains.size());
+      for (unsigned idx = 0; idx < order.size(); idx++)
+        order[idx] = idx;
+      nodes.reserve(2 * (domains.size() / MAX_LEAF_DOMAINS + 1));
+      build(0, order.size());
+    }
+
+    //--------------------------------------------------------------------------
+    inline DomainTree::DomainTree(const DomainTree &rhs)
+    //--------------------------------------------------------------------------
+    {
+      // should never be called
+      assert(false);
+    }
+
+    //--------------------------------------------------------------------------
+    inline DomainTree::~DomainTree(void)
+    //--------------------------------------------------------------------------
+    {
+    }
+
+    //--------------------------------------------------------------------------
+    inline DomainTree& DomainTree::operator=(const DomainTree &rhs)
+    //--------------------------------------------------------------------------
+    {
+      // should never be called
+      assert(false);
+      return *this;
+    }
+
+    //--------------------------------------------------------------------------
+    inline unsigned DomainTree::build(unsigned first, unsigned last)
+    //--------------------------------------------------------------------------
+    {
+      const unsigned index = nodes.size();
+      nodes.push_back(TreeNode());
+      // Compute the bounds of the entries and of their centers
+      Bounds node_bounds = bounds[order[first]];
+      Bounds center_bounds;
+      for (int d = 0; d < dim; d++)
+        center_bounds.lo[d] = center_bounds.hi[d] =
+          node_bounds.lo[d] + node_bounds.hi[d];
+      for (unsigned idx = first+1; idx < last; idx++)
+      {
+        const Bounds &b = bounds[order[idx]];
+        for (int d = 0; d < dim; d++)
+        {
+          node_bounds.lo[d] = std::min(node_bounds.lo[d], b.lo[d]);
+          node_bounds.hi[d] = std::max(node_bounds.hi[d], b.hi[d]);
+          const coord_t center = b.lo[d] + b.hi[d];
+          center_bounds.lo[d] = std::min(center_bounds.lo[d], center);
+          center_bounds.hi[d] = std::max(center_bounds.hi[d], center);
+        }
+      }
+      nodes[index].bounds = node_bounds;
+      if ((last - first) <= MAX_LEAF_DOMAINS)
+      {
+        nodes[index].first = first;
+        nodes[index].count = last - first;
+        return index;
+      }
+      // Split at the median center along the dimension
+      // where the centers are the most spread out
+      int split_dim = 0;
+      for (int d = 1; d < dim; d++)
+        if ((center_bounds.hi[d] - center_bounds.lo[d]) >
+            (center_bounds.hi[split_dim] - center_bounds.lo[split_dim]))
+          split_dim = d;
+      const unsigned middle = first + (last - first) / 2;
+      std::nth_element(order.begin() + first, order.begin() + middle,
+                       order.begin() + last, CenterCompare(bounds, split_dim));
+      build(first, middle);
+      const unsigned right = build(middle, last);
+      // The vector may have moved so index again
+      nodes[index].first = right;
+      nodes[index].count = 0;
+      return index;
+    }
+
+    //--------------------------------------------------------------------------
+    inline bool DomainTree::intersect(const Domain &query,
+                                 std::set<Domain> &result, bool compute) const
+    //--------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(is_indexed());
+      assert(query.get_dim() == dim);
+#endif
+      if (nodes.empty())
+        return false;
+      switch (dim)
+      {
+        case 1:
+          return intersect_rects<1>(query, result, compute);
+        case 2:
+          return intersect_rects<2>(query, result, compute);
+        case 3:
+          return intersect_rects<3>(query, result, compute);
+        default:
+          assert(false);
+      }
+      return false;
+    }
+
+    //--------------------------------------------------------------------------
+    template<int DIM>
+    inline bool DomainTree::intersect_rects(const Domain &query,
+                                 std::set<Domain> &result, bool compute) const
+    //--------------------------------------------------------------------------
+    {
+      const LegionRuntime::Arrays::Rect<DIM> rect = query.get_rect<DIM>();
+      if (rect.volume() == 0)
+        return false;
+      coord_t lo[DIM], hi[DIM];
+      rect.lo.to_array(lo);
+      rect.hi.to_array(hi);
+      bool found = false;
+      std::vector<unsigned> stack;
+      stack.push_back(0);
+      while (!stack.empty())
+      {
+        const unsigned index = stack.back();
+        stack.pop_back();
+        const TreeNode &node = nodes[index];
+        bool overlaps = true;
+        for (int d = 0; d < DIM; d++)
+        {
+          if ((node.bounds.hi[d] < lo[d]) || (hi[d] < node.bounds.lo[d]))
+          {
+            overlaps = false;
+            break;
+          }
+        }
+        if (!overlaps)
+          continue;
+        if (node.count == 0)
+        {
+          stack.push_back(node.first);
+          stack.push_back(index + 1);
+          continue;
+        }
+        for (unsigned idx = node.first; idx < (node.first+node.count); idx++)
+        {
+          const unsigned entry = order[idx];
+          const Bounds &b = bounds[entry];
+          bool hit = true;
+          for (int d = 0; d < DIM; d++)
+          {
+            if ((b.hi[d] < lo[d]) || (hi[d] < b.lo[d]))
+            {
+              hit = false;
+              break;
+            }
+          }
+          if (!hit)
+            continue;
+          // Two non-empty rectangles that overlap in every
+          // dimension always have a non-empty intersection
+          if (!compute)
+            return true;
+          found = true;
+          result.insert(Domain::from_rect<DIM>(
+                domains[entry].get_rect<DIM>().intersection(rect)));
+        }
+      }
+      return found;
+    }
+
+  }; // namespace Internal
+}; // namespace Legion
+
+#endif // __LEGION_DOMAIN_TREE_H__
+
+// EOF
+
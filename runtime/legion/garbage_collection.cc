@@ -1219,18 +1219,6 @@ namespace Legion {
         return runtime->recycle_distributed_id(did, RtEvent::NO_RT_EVENT);
     }
 
-    //--------------------------------------------------------------------------
-    void DistributedCollectable::UnregisterFunctor::apply(AddressSpaceID target)
-    //--------------------------------------------------------------------------
-    {
-      RtUserEvent done_event = Runtime::create_rt_user_event();
-      Serializer rez;
-      rez.serialize(did);
-      rez.serialize(done_event); 
-      runtime->send_did_remote_unregister(target, rez, vc);
-      done_events.insert(done_event);
-    }
-
     //--------------------------------------------------------------------------
     RtEvent DistributedCollectable::send_unregister_messages(
                                                     VirtualChannelKind vc) const
@@ -1240,13 +1228,79 @@ namespace Legion {
       assert(is_owner());
       assert(!remote_instances.empty());
 #endif
-      std::set<RtEvent> done_events;
-      UnregisterFunctor functor(runtime, did, vc, done_events); 
+      std::vector<AddressSpaceID> targets;
+      GatherFunctor functor(targets); 
       // No need for the lock since we're being destroyed
       remote_instances.map(functor);
+      // Most targets will hear about this from another remote node
+      // instead of from us, so record when everything we have already
+      // sent them on this channel is handled so they can wait for it
+      std::map<AddressSpaceID,RtEvent> fences;
+      for (std::vector<AddressSpaceID>::const_iterator it = 
+            targets.begin(); it != targets.end(); it++)
+      {
+        const RtEvent fence = runtime->find_message_fence(*it, vc);
+        if (fence.exists() && !fence.has_triggered())
+          fences[*it] = fence;
+      }
+      std::set<RtEvent> done_events;
+      send_unregister_tree(runtime, did, vc, targets, fences, done_events);
       return Runtime::merge_events(done_events);
     }
 
+    //--------------------------------------------------------------------------
+    /*static*/ void DistributedCollectable::send_unregister_tree(
+                                  Runtime *runtime, DistributedID did,
+                                  VirtualChannelKind vc,
+                                  const std::vector<AddressSpaceID> &targets,
+                                  const std::map<AddressSpaceID,RtEvent> &fences,
+                                  std::set<RtEvent> &done_events)
+    //--------------------------------------------------------------------------
+    {
+      // Split the targets into contiguous subtrees, one for each of our
+      // children, and send the rest of each subtree along with its root
+      // so it can do the same thing for its own children
+      const size_t total = targets.size();
+      const size_t radix = Runtime::legion_collective_radix;
+      const size_t chunk = (total + radix - 1) / radix;
+      for (size_t start = 0; start < total; start += chunk)
+      {
+        const size_t stop = ((start + chunk) < total) ? (start + chunk) : total;
+        const AddressSpaceID target = targets[start];
+        RtUserEvent done_event = Runtime::create_rt_user_event();
+        NodeSet subtree;
+        std::vector<std::pair<AddressSpaceID,RtEvent> > subtree_fences;
+        for (size_t idx = start + 1; idx < stop; idx++)
+        {
+          subtree.add(targets[idx]);
+          std::map<AddressSpaceID,RtEvent>::const_iterator finder = 
+            fences.find(targets[idx]);
+          if (finder != fences.end())
+            subtree_fences.push_back(*finder);
+        }
+        std::map<AddressSpaceID,RtEvent>::const_iterator finder = 
+          fences.find(target);
+        Serializer rez;
+        rez.serialize(did);
+        rez.serialize(done_event); 
+        rez.serialize(vc);
+        if (finder != fences.end())
+          rez.serialize(finder->second);
+        else
+          rez.serialize(RtEvent::NO_RT_EVENT);
+        rez.serialize(subtree);
+        rez.serialize<size_t>(subtree_fences.size());
+        for (std::vector<std::pair<AddressSpaceID,RtEvent> >::const_iterator
+              it = subtree_fences.begin(); it != subtree_fences.end(); it++)
+        {
+          rez.serialize(it->first);
+          rez.serialize(it->second);
+        }
+        runtime->send_did_remote_unregister(target, rez, vc);
+        done_events.insert(done_event);
+      }
+    }
+
     //--------------------------------------------------------------------------
     void DistributedCollectable::unregister_collectable(void)
     //--------------------------------------------------------------------------
@@ -1268,9 +1322,67 @@ namespace Legion {
       derez.deserialize(did);
       RtUserEvent done_event;
       derez.deserialize(done_event);
+      VirtualChannelKind vc;
+      derez.deserialize(vc);
+      RtEvent fence;
+      derez.deserialize(fence);
+      NodeSet subtree;
+      derez.deserialize(subtree);
+      std::map<AddressSpaceID,RtEvent> fences;
+      size_t num_fences;
+      derez.deserialize(num_fences);
+      for (unsigned idx = 0; idx < num_fences; idx++)
+      {
+        AddressSpaceID target;
+        derez.deserialize(target);
+        derez.deserialize(fences[target]);
+      }
+      std::set<RtEvent> done_events;
+      // Pass it on down the tree first
+      if (!subtree.empty())
+      {
+        std::vector<AddressSpaceID> targets;
+        GatherFunctor functor(targets);
+        subtree.map(functor);
+        send_unregister_tree(runtime, did, vc, targets, fences, done_events);
+      }
       DistributedCollectable *dc = runtime->find_distributed_collectable(did);
+      // If this came from another remote node then we have to wait
+      // for any messages the owner sent us before it to be handled
+      if (fence.exists() && !fence.has_triggered())
+      {
+        DeferUnregisterArgs args;
+        args.dc = dc;
+        args.done_event = Runtime::create_rt_user_event();
+        runtime->issue_runtime_meta_task(args, LG_LATENCY_PRIORITY,
+                                         NULL/*op*/, fence);
+        done_events.insert(args.done_event);
+      }
+      else
+        finish_unregister(dc);
+      if (!done_events.empty())
+        Runtime::trigger_event(done_event, 
+                               Runtime::merge_events(done_events));
+      else
+        Runtime::trigger_event(done_event);
+    }
+
+    //--------------------------------------------------------------------------
+    /*static*/ void DistributedCollectable::handle_deferred_unregister(
+                                                               const void *args)
+    //--------------------------------------------------------------------------
+    {
+      const DeferUnregisterArgs *dargs = (const DeferUnregisterArgs*)args;
+      finish_unregister(dargs->dc);
+      Runtime::trigger_event(dargs->done_event);
+    }
+
+    //--------------------------------------------------------------------------
+    /*static*/ void DistributedCollectable::finish_unregister(
+                                                     DistributedCollectable *dc)
+    //--------------------------------------------------------------------------
+    {
       dc->unregister_collectable();
-      Runtime::trigger_event(done_event);
       // Now remove the resource reference we were holding
       if (dc->remove_base_resource_ref(REMOTE_DID_REF))
         delete dc;
@@ -1305,6 +1417,24 @@ namespace Legion {
       assert(count != 0);
       assert(registered_with_runtime);
 #endif
+      // Removals are held back so they can cancel with later additions
+      // or go to the owner together with other removals in one message
+      if (Runtime::remote_reference_delay > 0)
+      {
+        if (add)
+        {
+          count = runtime->cancel_remote_reference_removal(target, did,
+                                                  VALID_REF_KIND, count);
+          if (count == 0)
+            return;
+        }
+        else
+        {
+          runtime->defer_remote_reference_removal(target, did,
+                                                  VALID_REF_KIND, count);
+          return;
+        }
+      }
       int signed_count = count;
       RtUserEvent done_event = RtUserEvent::NO_RT_USER_EVENT;
       if (!add)
@@ -1333,6 +1463,24 @@ namespace Legion {
       assert(count != 0);
       assert(registered_with_runtime);
 #endif
+      // Removals are held back so they can cancel with later additions
+      // or go to the owner together with other removals in one message
+      if (Runtime::remote_reference_delay > 0)
+      {
+        if (add)
+        {
+          count = runtime->cancel_remote_reference_removal(target, did,
+                                                  GC_REF_KIND, count);
+          if (count == 0)
+            return;
+        }
+        else
+        {
+          runtime->defer_remote_reference_removal(target, did,
+                                                  GC_REF_KIND, count);
+          return;
+        }
+      }
       int signed_count = count;
       RtUserEvent done_event = RtUserEvent::NO_RT_USER_EVENT;
       if (!add)
@@ -1361,6 +1509,24 @@ namespace Legion {
       assert(count != 0);
       assert(registered_with_runtime);
 #endif
+      // Removals are held back so they can cancel with later additions
+      // or go to the owner together with other removals in one message
+      if (Runtime::remote_reference_delay > 0)
+      {
+        if (add)
+        {
+          count = runtime->cancel_remote_reference_removal(target, did,
+                                                  RESOURCE_REF_KIND, count);
+          if (count == 0)
+            return;
+        }
+        else
+        {
+          runtime->defer_remote_reference_removal(target, did,
+                                                  RESOURCE_REF_KIND, count);
+          return;
+        }
+      }
       int signed_count = count;
       if (!add)
         signed_count = -signed_count;
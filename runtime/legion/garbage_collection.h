@@ -234,18 +234,22 @@ namespace Legion {
         ReferenceMutator *const mutator;
         unsigned count;
       };
-      class UnregisterFunctor {
+      class GatherFunctor {
       public:
-        UnregisterFunctor(Runtime *rt, const DistributedID d,
-                          VirtualChannelKind v, std::set<RtEvent> &done)
-          : runtime(rt), did(d), vc(v), done_events(done) { }
+        GatherFunctor(std::vector<AddressSpaceID> &t)
+          : targets(t) { }
       public:
-        void apply(AddressSpaceID target);
+        inline void apply(AddressSpaceID target) 
+          { targets.push_back(target); }
       protected:
-        Runtime *const runtime;
-        const DistributedID did;
-        const VirtualChannelKind vc;
-        std::set<RtEvent> &done_events;
+        std::vector<AddressSpaceID> &targets;
+      };
+      struct DeferUnregisterArgs : public LgTaskArgs<DeferUnregisterArgs> {
+      public:
+        static const LgTaskID TASK_ID = LG_DEFER_UNREGISTER_TASK_ID;
+      public:
+        DistributedCollectable *dc;
+        RtUserEvent done_event;
       };
     public:
       DistributedCollectable(Runtime *rt, DistributedID did,
@@ -352,6 +356,15 @@ namespace Legion {
       void unregister_collectable(void);
       static void handle_unregister_collectable(Runtime *runtime,
                                                 Deserializer &derez);
+      static void handle_deferred_unregister(const void *args);
+    protected:
+      // Unregistration goes out as a tree over the remote instances
+      static void send_unregister_tree(Runtime *runtime, DistributedID did,
+                                       VirtualChannelKind vc,
+                      const std::vector<AddressSpaceID> &targets,
+                      const std::map<AddressSpaceID,RtEvent> &fences,
+                                       std::set<RtEvent> &done_events);
+      static void finish_unregister(DistributedCollectable *dc);
     public:
       virtual void send_remote_registration(ReferenceMutator *mutator);
       void send_remote_valid_update(AddressSpaceID target, 
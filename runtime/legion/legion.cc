@@ -4139,6 +4139,35 @@ namespace Legion {
       return runtime->get_executing_processor(ctx);
     }
 
+    //--------------------------------------------------------------------------
+    unsigned Runtime::get_num_shards(Context ctx)
+    //--------------------------------------------------------------------------
+    {
+      return runtime->get_num_shards(ctx);
+    }
+
+    //--------------------------------------------------------------------------
+    unsigned Runtime::get_shard_id(Context ctx)
+    //--------------------------------------------------------------------------
+    {
+      return runtime->get_shard_id(ctx);
+    }
+
+    //--------------------------------------------------------------------------
+    Domain Runtime::get_shard_domain(Context ctx, const Domain &launch_domain)
+    //--------------------------------------------------------------------------
+    {
+      return runtime->get_shard_domain(ctx, launch_domain);
+    }
+
+    //--------------------------------------------------------------------------
+    size_t Runtime::get_runtime_memory_usage(
+                                     std::map<std::string,size_t> *by_kind)
+    //--------------------------------------------------------------------------
+    {
+      return runtime->get_runtime_memory_usage(by_kind);
+    }
+
     //--------------------------------------------------------------------------
     void Runtime::raise_region_exception(Context ctx, 
                                                   PhysicalRegion region,
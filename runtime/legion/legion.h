@@ -1200,6 +1200,8 @@ namespace Legion {
     public:
       inline void set_predicate_false_future(Future f);
       inline void set_predicate_false_result(TaskArgument arg);
+    public:
+      inline void set_argument_future(Future f);
     public:
       inline void set_independent_requirements(bool independent);
     public:
@@ -1223,6 +1225,13 @@ namespace Legion {
       // can be used if the task's return type is void.
       Future                             predicate_false_future;
       TaskArgument                       predicate_false_result;
+    public:
+      // If an argument future is set, the task becomes a continuation
+      // of that future: the launch returns immediately and the runtime
+      // defers mapping the task until the future resolves, at which
+      // point the value of the future replaces 'argument' as the task
+      // argument. No thread ever has to block waiting on the future.
+      Future                             argument_future;
     public:
       // Inform the runtime about any static dependences
       // These will be ignored outside of static traces
@@ -4815,6 +4824,53 @@ namespace Legion {
        */
       Processor get_executing_processor(Context ctx);
 
+      /**
+       * Return the number of shards of the top-level task. This is
+       * the number of nodes when the runtime was started with
+       * -lg:replicate and one otherwise.
+       * @param ctx enclosing task context
+       * @return the number of replicated copies of the top-level task
+       */
+      unsigned get_num_shards(Context ctx);
+
+      /**
+       * Return the shard of the top-level task that runs on the
+       * local node. When the top-level task is replicated each copy
+       * also sees its shard ID as its index point.
+       * @param ctx enclosing task context
+       * @return the shard ID in the range [0,get_num_shards)
+       */
+      unsigned get_shard_id(Context ctx);
+
+      /**
+       * Return the subset of a launch domain that the local shard is
+       * responsible for. The domain is blocked along its first
+       * dimension so that every shard can issue index launches over
+       * just its own share of the points and only analyze those.
+       * The result may be empty if there are more shards than points.
+       * @param ctx enclosing task context
+       * @param launch_domain the full launch domain
+       * @return the local shard's share of the launch domain
+       */
+      Domain get_shard_domain(Context ctx, const Domain &launch_domain);
+
+      /**
+       * Return the number of bytes that the runtime on the local node
+       * is currently using for its own data structures such as
+       * operations, views, and region tree state. The runtime always
+       * keeps a count of these bytes for each kind of allocation so
+       * this call is cheap but only approximate while other threads
+       * are still allocating. Optionally a breakdown by the name of
+       * each kind of allocation can be returned as well. The slab
+       * pools that back many small runtime objects show up in the
+       * breakdown but are not included in the total since those
+       * objects are already counted under their own kinds.
+       * @param by_kind optional map to fill in with bytes per kind
+       * @return total bytes used by runtime data structures on this node
+       */
+      size_t get_runtime_memory_usage(
+                          std::map<std::string,size_t> *by_kind = NULL);
+
       /**
        * Indicate that data in a particular physical region
        * appears to be incorrect for whatever reason.  This
@@ -5296,6 +5352,11 @@ namespace Legion {
        *              to launch more tasks than the allotted window
        *              will stall the parent task until child tasks
        *              begin completing.  The default is 1024.
+       * -lg:adaptive_window Let each context resize its window within
+       *              a factor of 8 of the configured size, shrinking
+       *              it when the runtime's analysis falls behind and
+       *              growing it when the parent task stalls on a
+       *              window that execution is not keeping full.
        * -lg:sched <int> The run-ahead factor for the runtime.  How many
        *              outstanding tasks ready to run should be on each
        *              processor before backing off the mapping procedure.
@@ -5306,6 +5367,18 @@ namespace Legion {
        *              flag will actually run the entire operation through
        *              the pipeline and wait for it to complete before
        *              permitting the next operation to start.
+       * -lg:lanes    Run the dependence analysis of tasks, copies,
+       *              fills and inline mappings that use disjoint region
+       *              trees concurrently instead of in program order.
+       * -lg:point_chunk <int> Map the points of slices with more than
+       *              this many points in chunks of this size on all
+       *              the utility processors in parallel. Zero (the
+       *              default) maps each slice on a single processor.
+       * -lg:fold_tree <int> Fold reduction instances together pairwise
+       *              in temporary instances before applying them to a
+       *              target when at least this many reduction instances
+       *              with the same operator need to be applied. Zero
+       *              disables folding. Default is 16.
        * -------------
        *  Messaging
        * -------------
@@ -5315,6 +5388,29 @@ namespace Legion {
        *              per-pair-of-node RDMA buffers in the low-level
        *              runtime.  Default value is 4K which should guarantee
        *              medium sized active messages on Infiniband clusters.
+       * -lg:no_aggregate Don't combine messages from different virtual
+       *              channels that are flushed to the same node while
+       *              another message to that node is being sent.
+       * -lg:batch <channel> <us> <bytes> Hold messages flushed on the
+       *              given virtual channel for up to <us> microseconds
+       *              or until <bytes> bytes are waiting (zero means a
+       *              full message) so that they are sent together. A
+       *              delay of zero sends them immediately, which is the
+       *              default for all channels but semantic info.
+       * -lg:no_batch Send all flushed messages immediately.
+       * -lg:ref_delay <us> Hold the removal of references to remote
+       *              distributed collectables for up to <us> microseconds
+       *              so they can cancel with later additions or be sent
+       *              to the owner together. Default is 100 and zero sends
+       *              every reference update immediately.
+       * -lg:shared_args <int> Task arguments of at least this many
+       *              bytes are kept in shared immutable buffers that
+       *              local launches reuse and that are sent to each
+       *              node only once. Default is 64K and zero disables
+       *              sharing.
+       * -lg:shared_args_cache <int> Maximum number of bytes of shared
+       *              task arguments cached locally and pinned on each
+       *              remote node. Default is 64M.
        * ---------------------
        *  Configuration Flags 
        * ---------------------
@@ -5326,6 +5422,15 @@ namespace Legion {
        *              the garbage collection but makes it more efficient.
        *              Decreasing the value reduces latency, but adds
        *              inefficiency to the collection.
+       * -lg:gc_slice <int> Collect the views of a garbage collection
+       *              epoch in background meta-tasks of at most this
+       *              many views each, spread over the utility
+       *              processors. The default is 8.
+       * -lg:gc_pause <us> Target for how long a single garbage
+       *              collection meta-task may run. A task that reaches
+       *              it hands its remaining views to a new background
+       *              task. The default is 500 and zero disables the
+       *              target.
        * -lg:unsafe_launch Tell the runtime to skip any checks for 
        *              checking for deadlock between a parent task and
        *              the sub-operations that it is launching. Note
@@ -5345,6 +5450,23 @@ namespace Legion {
        *              false in release mode.)
        * -lg:local <int> Specify the maximum number of local fields
        *              permitted in any field space within a context.
+       * -lg:intersect_cache <int> Bound the size of the cache of
+       *              intersection tests kept by each index space and
+       *              partition. Each cached test counts one plus the
+       *              number of domains in its intersection. The least
+       *              recently used tests are evicted first. The default
+       *              is 4096, and 0 leaves the caches unbounded.
+       * -lg:auto_trace <int> Look for repeating sequences of up to
+       *              <int> task launches in each context and trace
+       *              them as if they had been annotated with begin
+       *              and end trace calls. The default of 0 disables
+       *              automatic tracing.
+       * -lg:replicate Run a copy (shard) of the top-level task on every
+       *              node instead of only on node 0. Each shard uses
+       *              get_shard_id and get_shard_domain to launch and
+       *              analyze only its share of each index launch, and
+       *              shards synchronize through phase barriers and
+       *              must epochs. Not supported with -lg:separate.
        * ---------------------
        *  Resiliency
        * ---------------------
@@ -5399,6 +5521,9 @@ namespace Legion {
        *              all nodes are disabled. Zero will disable all
        *              profiling while each number greater than zero will
        *              profile on that number of nodes.
+       * -lg:prof_memory <us> How often in microseconds to record the
+       *              bytes used by each kind of runtime data structure
+       *              into the profiling logs. Zero disables sampling.
        *
        * @param argc the number of input arguments
        * @param argv pointer to an array of string arguments of size argc
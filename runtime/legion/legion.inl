@@ -875,6 +875,13 @@ namespace Legion {
       predicate_false_result = arg;
     }
 
+    //--------------------------------------------------------------------------
+    inline void TaskLauncher::set_argument_future(Future f)
+    //--------------------------------------------------------------------------
+    {
+      argument_future = f;
+    }
+
     //--------------------------------------------------------------------------
     inline void TaskLauncher::set_independent_requirements(bool independent)
     //--------------------------------------------------------------------------
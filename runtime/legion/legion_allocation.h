@@ -139,6 +139,7 @@ namespace Legion {
       TASK_IMPL_ALLOC,
       VARIANT_IMPL_ALLOC,
       LAYOUT_CONSTRAINTS_ALLOC,
+      SLAB_POOL_ALLOC,
       LAST_ALLOC, // must be last
     };
 
@@ -196,10 +197,63 @@ namespace Legion {
               AlignmentTrait<T>::AlignmentOf,BYTES>(cnt);
     }
 
-#ifdef TRACE_ALLOCATION
     // forward declaration of runtime
     class Runtime;
 
+    /**
+     * \class LegionMemoryCounters
+     * Always-on counters of the bytes and number of allocations that
+     * are live for each kind of allocation. Every thread updates its
+     * own set of counters without any synchronization and readers sum
+     * over all the sets, so a snapshot is only approximate while other
+     * threads are allocating. Sets are never reclaimed so the counts
+     * of threads that have exited remain part of the totals.
+     */
+    class LegionMemoryCounters {
+    public:
+      struct ThreadCounters {
+      public:
+        long long bytes[LAST_ALLOC];
+        // Counts objects, or elements for containers
+        long long allocations[LAST_ALLOC];
+        ThreadCounters *next;
+      };
+    public:
+      static inline void record_allocation(AllocationType a, 
+                                           size_t size, size_t elems = 1)
+      {
+        // Untracked containers use LAST_ALLOC so skip them
+        if (a == LAST_ALLOC)
+          return;
+        ThreadCounters *counters = local_counters;
+        if (counters == NULL)
+          counters = create_thread_counters();
+        counters->bytes[a] += size * elems;
+        counters->allocations[a] += elems;
+      }
+      static inline void record_free(AllocationType a, 
+                                     size_t size, size_t elems = 1)
+      {
+        if (a == LAST_ALLOC)
+          return;
+        ThreadCounters *counters = local_counters;
+        if (counters == NULL)
+          counters = create_thread_counters();
+        counters->bytes[a] -= size * elems;
+        counters->allocations[a] -= elems;
+      }
+    public:
+      // Implementations in runtime.cc
+      static void snapshot(long long bytes[LAST_ALLOC],
+                           long long allocations[LAST_ALLOC]);
+    protected:
+      static ThreadCounters* create_thread_counters(void);
+    protected:
+      static __thread ThreadCounters *local_counters;
+      static ThreadCounters *volatile all_counters;
+    };
+
+#ifdef TRACE_ALLOCATION
     // Implementations in runtime.cc
     struct LegionAllocation {
     public:
@@ -211,6 +265,7 @@ namespace Legion {
       static void trace_free(Runtime *&rt, AllocationType a, 
                              size_t size, int elems=1);
     };
+#endif
 
     // A Helper class for determining if we have an allocation type
     template<typename T>
@@ -236,6 +291,15 @@ namespace Legion {
 
     template<typename T, bool HAS_ALLOC_TYPE>
     struct HandleAllocation {
+      static inline void record_allocation(void)
+      {
+        LegionMemoryCounters::record_allocation(T::alloc_type, sizeof(T));
+      }
+      static inline void record_free(void)
+      {
+        LegionMemoryCounters::record_free(T::alloc_type, sizeof(T));
+      }
+#ifdef TRACE_ALLOCATION
       static inline void trace_allocation(void)
       {
         LegionAllocation::trace_allocation(T::alloc_type, sizeof(T));
@@ -244,20 +308,25 @@ namespace Legion {
       {
         LegionAllocation::trace_free(T::alloc_type, sizeof(T));
       }
+#endif
     };
 
     template<typename T>
     struct HandleAllocation<T,false> {
+      static inline void record_allocation(void) { /*nothing*/ }
+      static inline void record_free(void) { /*nothing*/ }
+#ifdef TRACE_ALLOCATION
       static inline void trace_allocation(void) { /*nothing*/ }
       static inline void trace_free(void) { /*nothing*/ }
-    };
 #endif
+    };
 
     // Helper methods for doing tracing of memory allocations
     //--------------------------------------------------------------------------
     inline void* legion_malloc(AllocationType a, size_t size)
     //--------------------------------------------------------------------------
     {
+      LegionMemoryCounters::record_allocation(a, size);
 #ifdef TRACE_ALLOCATION
       LegionAllocation::trace_allocation(a, size);
 #endif
@@ -269,6 +338,8 @@ namespace Legion {
                                 size_t old_size, size_t new_size)
     //--------------------------------------------------------------------------
     {
+      LegionMemoryCounters::record_free(a, old_size);
+      LegionMemoryCounters::record_allocation(a, new_size);
 #ifdef TRACE_ALLOCATION
       Runtime *rt = LegionAllocation::find_runtime(); 
       LegionAllocation::trace_free(rt, a, old_size);
@@ -281,14 +352,70 @@ namespace Legion {
     inline void legion_free(AllocationType a, void *ptr, size_t size)
     //--------------------------------------------------------------------------
     {
+      LegionMemoryCounters::record_free(a, size);
 #ifdef TRACE_ALLOCATION
       LegionAllocation::trace_free(a, size);
 #endif
       free(ptr);
     }
 
+    /**
+     * \class LegionSlabPool
+     * A pool of fixed size blocks that backs the allocations of all
+     * the LegionHeapify types that fall in the same size class. Each
+     * thread allocates from and frees to its own cache of free blocks
+     * without any synchronization and only goes to the global free
+     * list of the pool to move whole batches of blocks. New blocks are
+     * carved out of large slabs which are never handed back to the
+     * system, so the footprint of a pool is its high-water mark.
+     */
+    template<size_t SIZE, size_t ALIGNMENT>
+    class LegionSlabPool {
+    public:
+      struct FreeBlock {
+        FreeBlock *next; // next block in the same batch
+        FreeBlock *next_batch; // only valid for the first block of a batch
+      };
+      struct ThreadCache {
+        FreeBlock *head;
+        unsigned size;
+      };
+    public:
+      static const size_t BLOCK_SIZE = 
+        ((((SIZE > sizeof(FreeBlock)) ? SIZE : sizeof(FreeBlock)) + 
+          ALIGNMENT - 1) / ALIGNMENT) * ALIGNMENT;
+      static const size_t BLOCKS_PER_SLAB = 
+        ((LEGION_SLAB_SIZE / BLOCK_SIZE) > LEGION_SLAB_BATCH_SIZE) ?
+          (LEGION_SLAB_SIZE / BLOCK_SIZE) : LEGION_SLAB_BATCH_SIZE;
+    public:
+      static inline void* allocate(void);
+      static inline void deallocate(void *ptr);
+    protected:
+      static inline ThreadCache& get_thread_cache(void);
+      static inline void acquire_pool_lock(void);
+      static inline void release_pool_lock(void);
+      static FreeBlock* refill_batch(void);
+      static void release_batch(FreeBlock *batch);
+    protected:
+      // Chain of batches of LEGION_SLAB_BATCH_SIZE free blocks
+      static FreeBlock *free_batches;
+      // Remainder of the most recent slab not yet carved into blocks
+      static char *slab_remaining;
+      static size_t blocks_remaining;
+      static volatile int pool_lock;
+    };
+
+    // Pick the slab pool for a type by rounding its size up to a size class
+    template<typename T>
+    struct SlabPoolTrait {
+      typedef LegionSlabPool<((sizeof(T) + LEGION_MAX_ALIGNMENT - 1) / 
+          LEGION_MAX_ALIGNMENT) * LEGION_MAX_ALIGNMENT,
+          AlignmentTrait<T>::AlignmentOf> Pool;
+    };
+
     // A class for Legion objects to inherit from to have their dynamic
-    // memory allocations managed for alignment and tracing
+    // memory allocations managed for alignment and tracing, objects
+    // of the heapified type are allocated from slab pools
     template<typename T>
     class LegionHeapify {
     public:
@@ -298,21 +425,165 @@ namespace Legion {
       static inline void* operator new(size_t count, void *ptr);
       static inline void* operator new[](size_t count, void *ptr);
     public:
-      static inline void operator delete(void *ptr);
+      static inline void operator delete(void *ptr, size_t count);
       static inline void operator delete[](void *ptr);
     public:
       static inline void operator delete(void *ptr, void *place);
       static inline void operator delete[](void *ptr, void *place);
     };
 
+    template<size_t SIZE, size_t ALIGNMENT>
+    /*static*/ typename LegionSlabPool<SIZE,ALIGNMENT>::FreeBlock*
+      LegionSlabPool<SIZE,ALIGNMENT>::free_batches = NULL;
+    template<size_t SIZE, size_t ALIGNMENT>
+    /*static*/ char* LegionSlabPool<SIZE,ALIGNMENT>::slab_remaining = NULL;
+    template<size_t SIZE, size_t ALIGNMENT>
+    /*static*/ size_t LegionSlabPool<SIZE,ALIGNMENT>::blocks_remaining = 0;
+    template<size_t SIZE, size_t ALIGNMENT>
+    /*static*/ volatile int LegionSlabPool<SIZE,ALIGNMENT>::pool_lock = 0;
+
+    //--------------------------------------------------------------------------
+    template<size_t SIZE, size_t ALIGNMENT>
+    /*static*/ inline typename LegionSlabPool<SIZE,ALIGNMENT>::ThreadCache&
+                          LegionSlabPool<SIZE,ALIGNMENT>::get_thread_cache(void)
+    //--------------------------------------------------------------------------
+    {
+      static __thread ThreadCache cache;
+      return cache;
+    }
+
+    //--------------------------------------------------------------------------
+    template<size_t SIZE, size_t ALIGNMENT>
+    /*static*/ inline void LegionSlabPool<SIZE,ALIGNMENT>::acquire_pool_lock(
+                                                                           void)
+    //--------------------------------------------------------------------------
+    {
+      // Only ever held long enough to splice a batch so just spin
+      while (__sync_lock_test_and_set(&pool_lock, 1))
+        while (pool_lock) { }
+    }
+
+    //--------------------------------------------------------------------------
+    template<size_t SIZE, size_t ALIGNMENT>
+    /*static*/ inline void LegionSlabPool<SIZE,ALIGNMENT>::release_pool_lock(
+                                                                           void)
+    //--------------------------------------------------------------------------
+    {
+      __sync_lock_release(&pool_lock);
+    }
+
+    //--------------------------------------------------------------------------
+    template<size_t SIZE, size_t ALIGNMENT>
+    /*static*/ inline void* LegionSlabPool<SIZE,ALIGNMENT>::allocate(void)
+    //--------------------------------------------------------------------------
+    {
+      ThreadCache &cache = get_thread_cache();
+      if (cache.head == NULL)
+      {
+        cache.head = refill_batch();
+        cache.size = LEGION_SLAB_BATCH_SIZE;
+      }
+      FreeBlock *result = cache.head;
+      cache.head = result->next;
+      cache.size--;
+      return result;
+    }
+
+    //--------------------------------------------------------------------------
+    template<size_t SIZE, size_t ALIGNMENT>
+    /*static*/ inline void LegionSlabPool<SIZE,ALIGNMENT>::deallocate(void *ptr)
+    //--------------------------------------------------------------------------
+    {
+      ThreadCache &cache = get_thread_cache();
+      FreeBlock *block = static_cast<FreeBlock*>(ptr);
+      block->next = cache.head;
+      cache.head = block;
+      // Once we have two batches worth give one back to the pool
+      // so threads that mostly free don't hoard all the blocks
+      if (++cache.size == (2 * LEGION_SLAB_BATCH_SIZE))
+      {
+        FreeBlock *batch = cache.head;
+        FreeBlock *last = batch;
+        for (unsigned idx = 1; idx < LEGION_SLAB_BATCH_SIZE; idx++)
+          last = last->next;
+        cache.head = last->next;
+        cache.size -= LEGION_SLAB_BATCH_SIZE;
+        last->next = NULL;
+        release_batch(batch);
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    template<size_t SIZE, size_t ALIGNMENT>
+    /*static*/ typename LegionSlabPool<SIZE,ALIGNMENT>::FreeBlock* 
+                              LegionSlabPool<SIZE,ALIGNMENT>::refill_batch(void)
+    //--------------------------------------------------------------------------
+    {
+      acquire_pool_lock();
+      if (free_batches != NULL)
+      {
+        FreeBlock *result = free_batches;
+        free_batches = result->next_batch;
+        release_pool_lock();
+        return result;
+      }
+      if (blocks_remaining < LEGION_SLAB_BATCH_SIZE)
+      {
+        // Any leftover blocks at the end of the last slab are
+        // too few to make a batch so they are simply dropped
+        slab_remaining = static_cast<char*>(
+            legion_alloc_aligned<BLOCK_SIZE,ALIGNMENT,false/*bytes*/>(
+                                                          BLOCKS_PER_SLAB));
+        LegionMemoryCounters::record_allocation(SLAB_POOL_ALLOC,
+                                              BLOCK_SIZE * BLOCKS_PER_SLAB);
+#ifdef TRACE_ALLOCATION
+        LegionAllocation::trace_allocation(SLAB_POOL_ALLOC, 
+                                           BLOCK_SIZE * BLOCKS_PER_SLAB);
+#endif
+        blocks_remaining = BLOCKS_PER_SLAB;
+      }
+      char *carve = slab_remaining;
+      slab_remaining += LEGION_SLAB_BATCH_SIZE * BLOCK_SIZE;
+      blocks_remaining -= LEGION_SLAB_BATCH_SIZE;
+      release_pool_lock();
+      // Thread the new blocks together outside the lock
+      FreeBlock *result = reinterpret_cast<FreeBlock*>(carve);
+      for (unsigned idx = 0; idx < (LEGION_SLAB_BATCH_SIZE-1); idx++)
+      {
+        FreeBlock *block = reinterpret_cast<FreeBlock*>(carve);
+        carve += BLOCK_SIZE;
+        block->next = reinterpret_cast<FreeBlock*>(carve);
+      }
+      reinterpret_cast<FreeBlock*>(carve)->next = NULL;
+      return result;
+    }
+
+    //--------------------------------------------------------------------------
+    template<size_t SIZE, size_t ALIGNMENT>
+    /*static*/ void LegionSlabPool<SIZE,ALIGNMENT>::release_batch(
+                                                              FreeBlock *batch)
+    //--------------------------------------------------------------------------
+    {
+      acquire_pool_lock();
+      batch->next_batch = free_batches;
+      free_batches = batch;
+      release_pool_lock();
+    }
+
     //--------------------------------------------------------------------------
     template<typename T>
     /*static*/ inline void* LegionHeapify<T>::operator new(size_t count)
     //--------------------------------------------------------------------------
     {
+      HandleAllocation<T,HasAllocType<T>::value>::record_allocation();
 #ifdef TRACE_ALLOCATION
       HandleAllocation<T,HasAllocType<T>::value>::trace_allocation();
 #endif
+      // Derived types without their own heapify are bigger than
+      // our size class so they go straight to the system allocator
+      typedef typename SlabPoolTrait<T>::Pool SlabPool;
+      if (count <= SlabPool::BLOCK_SIZE)
+        return SlabPool::allocate();
       return legion_alloc_aligned<T,true/*bytes*/>(count);  
     }
 
@@ -321,6 +592,7 @@ namespace Legion {
     /*static*/ inline void* LegionHeapify<T>::operator new[](size_t count)
     //--------------------------------------------------------------------------
     {
+      HandleAllocation<T,HasAllocType<T>::value>::record_allocation();
 #ifdef TRACE_ALLOCATION
       HandleAllocation<T,HasAllocType<T>::value>::trace_allocation();
 #endif
@@ -353,13 +625,19 @@ namespace Legion {
 
     //--------------------------------------------------------------------------
     template<typename T>
-    /*static*/ inline void LegionHeapify<T>::operator delete(void *ptr)
+    /*static*/ inline void LegionHeapify<T>::operator delete(void *ptr,
+                                                             size_t count)
     //--------------------------------------------------------------------------
     {
+      HandleAllocation<T,HasAllocType<T>::value>::record_free();
 #ifdef TRACE_ALLOCATION
       HandleAllocation<T,HasAllocType<T>::value>::trace_free();
 #endif
-      free(ptr);
+      typedef typename SlabPoolTrait<T>::Pool SlabPool;
+      if (count <= SlabPool::BLOCK_SIZE)
+        SlabPool::deallocate(ptr);
+      else
+        free(ptr);
     }
 
     //--------------------------------------------------------------------------
@@ -367,6 +645,7 @@ namespace Legion {
     /*static*/ inline void LegionHeapify<T>::operator delete[](void *ptr)
     //--------------------------------------------------------------------------
     {
+      HandleAllocation<T,HasAllocType<T>::value>::record_free();
 #ifdef TRACE_ALLOCATION
       HandleAllocation<T,HasAllocType<T>::value>::trace_free();
 #endif
@@ -500,12 +779,14 @@ namespace Legion {
         // Hopefully this gets fixed soon
         T *result = static_cast<T*>(::operator new (cnt*sizeof(T),
                                     std::align_val_t(alignof(T))));
+        LegionMemoryCounters::record_allocation(A, sizeof(T), cnt);
 #ifdef TRACE_ALLOCATION
         LegionAllocation::trace_allocation(runtime, A, sizeof(T), cnt);
 #endif
         return result;
       }
       inline void deallocate(T *ptr, std::size_t size) { 
+        LegionMemoryCounters::record_free(A, sizeof(T), size);
 #ifdef TRACE_ALLOCATION
         LegionAllocation::trace_free(runtime, A, sizeof(T), size);
 #endif
@@ -514,6 +795,7 @@ namespace Legion {
 #else
       inline pointer allocate(size_type cnt,
                       typename std::allocator<void>::const_pointer = 0) {
+        LegionMemoryCounters::record_allocation(A, sizeof(T), cnt);
 #ifdef TRACE_ALLOCATION
         LegionAllocation::trace_allocation(runtime, A, sizeof(T), cnt);
 #endif
@@ -525,6 +807,7 @@ namespace Legion {
         return reinterpret_cast<pointer>(result);
       }
       inline void deallocate(pointer p, size_type size) {
+        LegionMemoryCounters::record_free(A, sizeof(T), size);
 #ifdef TRACE_ALLOCATION
         LegionAllocation::trace_free(runtime, A, sizeof(T), size);
 #endif
@@ -2270,16 +2270,14 @@ namespace Legion {
     bool CurrentInitializer::visit_region(RegionNode *node)
     //--------------------------------------------------------------------------
     {
-      node->initialize_current_state(ctx); 
-      return true;
+      return node->initialize_current_state(ctx); 
     }
 
     //--------------------------------------------------------------------------
     bool CurrentInitializer::visit_partition(PartitionNode *node)
     //--------------------------------------------------------------------------
     {
-      node->initialize_current_state(ctx);
-      return true;
+      return node->initialize_current_state(ctx);
     }
 
     /////////////////////////////////////////////////////////////
@@ -2329,16 +2327,14 @@ namespace Legion {
     bool CurrentInvalidator::visit_region(RegionNode *node)
     //--------------------------------------------------------------------------
     {
-      node->invalidate_current_state(ctx, users_only); 
-      return true;
+      return node->invalidate_current_state(ctx, users_only); 
     }
 
     //--------------------------------------------------------------------------
     bool CurrentInvalidator::visit_partition(PartitionNode *node)
     //--------------------------------------------------------------------------
     {
-      node->invalidate_current_state(ctx, users_only);
-      return true;
+      return node->invalidate_current_state(ctx, users_only);
     }
 
     /////////////////////////////////////////////////////////////
@@ -2454,7 +2450,7 @@ namespace Legion {
 
     //--------------------------------------------------------------------------
     LogicalState::LogicalState(RegionTreeNode *node, ContextID ctx)
-      : owner(node)
+      : owner(node), touched(false)
     //--------------------------------------------------------------------------
     {
     }
@@ -2504,9 +2500,8 @@ namespace Legion {
     {
       if (!curr_epoch_users.empty())
       {
-        for (LegionList<LogicalUser,CURR_LOGICAL_ALLOC>::track_aligned::
-              const_iterator it = curr_epoch_users.begin(); it != 
-              curr_epoch_users.end(); it++)
+        for (LogicalUserList<CURR_LOGICAL_ALLOC>::const_iterator it = 
+              curr_epoch_users.begin(); it != curr_epoch_users.end(); it++)
         {
           it->op->remove_mapping_reference(it->gen); 
         }
@@ -2514,9 +2509,8 @@ namespace Legion {
       }
       if (!prev_epoch_users.empty())
       {
-        for (LegionList<LogicalUser,PREV_LOGICAL_ALLOC>::track_aligned::
-              const_iterator it = prev_epoch_users.begin(); it != 
-              prev_epoch_users.end(); it++)
+        for (LogicalUserList<PREV_LOGICAL_ALLOC>::const_iterator it = 
+              prev_epoch_users.begin(); it != prev_epoch_users.end(); it++)
         {
           it->op->remove_mapping_reference(it->gen); 
         }
@@ -2538,6 +2532,7 @@ namespace Legion {
             projection_epochs.begin(); it != projection_epochs.end(); it++)
         delete *it;
       projection_epochs.clear();
+      touched = false;
     } 
 
     //--------------------------------------------------------------------------
@@ -3668,8 +3663,8 @@ namespace Legion {
     //--------------------------------------------------------------------------
     void LogicalCloser::perform_dependence_analysis(const LogicalUser &current,
                                                     const FieldMask &open_below,
-              LegionList<LogicalUser,CURR_LOGICAL_ALLOC>::track_aligned &cusers,
-              LegionList<LogicalUser,PREV_LOGICAL_ALLOC>::track_aligned &pusers)
+                                    LogicalUserList<CURR_LOGICAL_ALLOC> &cusers,
+                                    LogicalUserList<PREV_LOGICAL_ALLOC> &pusers)
     //--------------------------------------------------------------------------
     {
       // We also need to do dependence analysis against all the other operations
@@ -3752,7 +3747,7 @@ namespace Legion {
 
     //--------------------------------------------------------------------------
     void LogicalCloser::register_close_operations(
-               LegionList<LogicalUser,CURR_LOGICAL_ALLOC>::track_aligned &users)
+                                     LogicalUserList<CURR_LOGICAL_ALLOC> &users)
     //--------------------------------------------------------------------------
     {
       // No need to add mapping references, we did that in 
@@ -4176,6 +4171,7 @@ namespace Legion {
         current_version_infos.clear();
       if (!previous_version_infos.empty())
         previous_version_infos.clear();
+      current_field_versions.clear();
     }
 
     //--------------------------------------------------------------------------
@@ -4219,6 +4215,7 @@ namespace Legion {
         current_version_infos[init_version].insert(init_state, user_mask);
       else
         finder->second.insert(init_state, user_mask);
+      update_current_field_versions(user_mask, init_version);
 #ifdef DEBUG_LEGION
       sanity_check();
 #endif
@@ -4283,18 +4280,18 @@ namespace Legion {
         // Just capture the current versions for now if we end
         // up mapping a physical instance then we'll advance 
         // later and record those versions as necessary
-        for (LegionMap<VersionID,ManagerVersions>::aligned::const_iterator 
-              vit = current_version_infos.begin(); vit !=
-              current_version_infos.end(); vit++)
+        LegionMap<VersionID,FieldMask>::aligned current_versions;
+        find_current_field_versions(version_mask, current_versions);
+        for (LegionMap<VersionID,FieldMask>::aligned::const_iterator cit =
+              current_versions.begin(); cit != current_versions.end(); cit++)
         {
-          FieldMask local_overlap = vit->second.get_valid_mask() & version_mask;
-          if (!local_overlap)
-            continue;
+          const ManagerVersions &info = find_current_versions(cit->first);
+          const FieldMask &local_overlap = cit->second;
 #ifdef UNVERSIONED_READ_WRITE_WARNING
           unversioned -= local_overlap;
 #endif
-          for (ManagerVersions::iterator it = vit->second.begin();
-                it != vit->second.end(); it++)
+          for (ManagerVersions::iterator it = info.begin();
+                it != info.end(); it++)
           {
             FieldMask overlap = it->second & local_overlap;
             if (!overlap)
@@ -4342,15 +4339,15 @@ namespace Legion {
 #endif
         // We only need the current versions, but we record them
         // as both the previous and the advance
-        for (LegionMap<VersionID,ManagerVersions>::aligned::const_iterator
-              vit = current_version_infos.begin(); vit != 
-              current_version_infos.end(); vit++)
-        {
-          FieldMask local_overlap = vit->second.get_valid_mask() & version_mask;
-          if (!local_overlap)
-            continue;
-          for (ManagerVersions::iterator it = vit->second.begin();
-                it != vit->second.end(); it++)
+        LegionMap<VersionID,FieldMask>::aligned current_versions;
+        find_current_field_versions(version_mask, current_versions);
+        for (LegionMap<VersionID,FieldMask>::aligned::const_iterator cit =
+              current_versions.begin(); cit != current_versions.end(); cit++)
+        {
+          const ManagerVersions &info = find_current_versions(cit->first);
+          const FieldMask &local_overlap = cit->second;
+          for (ManagerVersions::iterator it = info.begin();
+                it != info.end(); it++)
           {
             FieldMask overlap = it->second & local_overlap;
             if (!overlap)
@@ -4376,16 +4373,16 @@ namespace Legion {
 #endif
         // Retake the lock in exclusive mode and see if we lost any races
         AutoLock m_lock(manager_lock);
-        for (LegionMap<VersionID,ManagerVersions>::aligned::const_iterator
-              vit = current_version_infos.begin(); vit != 
-              current_version_infos.end(); vit++)
+        LegionMap<VersionID,FieldMask>::aligned current_versions;
+        find_current_field_versions(unversioned, current_versions);
+        for (LegionMap<VersionID,FieldMask>::aligned::const_iterator cit =
+              current_versions.begin(); cit != current_versions.end(); cit++)
         {
           // Only need to check against unversioned this time
-          FieldMask local_overlap = vit->second.get_valid_mask() & unversioned;
-          if (!local_overlap)
-            continue;
-          for (ManagerVersions::iterator it = vit->second.begin();
-                it != vit->second.end(); it++)
+          const ManagerVersions &info = find_current_versions(cit->first);
+          const FieldMask &local_overlap = cit->second;
+          for (ManagerVersions::iterator it = info.begin();
+                it != info.end(); it++)
           {
             FieldMask overlap = it->second & local_overlap;
             if (!overlap)
@@ -4410,6 +4407,7 @@ namespace Legion {
           WrapperReferenceMutator mutator(ready_events);
           current_version_infos[init_version].insert(new_state, 
                                                      unversioned, &mutator);
+          update_current_field_versions(unversioned, init_version);
           // Keep any unversioned fields
           unversioned_mask &= unversioned;
         }
@@ -4458,15 +4456,15 @@ namespace Legion {
 #endif
         }
       }
-      for (LegionMap<VersionID,ManagerVersions>::aligned::const_iterator
-            vit = current_version_infos.begin(); vit != 
-            current_version_infos.end(); vit++)
+      LegionMap<VersionID,FieldMask>::aligned current_versions;
+      find_current_field_versions(version_mask, current_versions);
+      for (LegionMap<VersionID,FieldMask>::aligned::const_iterator cit =
+            current_versions.begin(); cit != current_versions.end(); cit++)
       {
-        FieldMask local_overlap = version_mask & vit->second.get_valid_mask();
-        if (!local_overlap)
-          continue;
-        for (ManagerVersions::iterator it = vit->second.begin();
-              it != vit->second.end(); it++)
+        const ManagerVersions &info = find_current_versions(cit->first);
+        const FieldMask &local_overlap = cit->second;
+        for (ManagerVersions::iterator it = info.begin();
+              it != info.end(); it++)
         {
           FieldMask overlap = it->second & local_overlap;
           if (!overlap)
@@ -4648,15 +4646,15 @@ namespace Legion {
               break;
           }
         }
-        for (LegionMap<VersionID,ManagerVersions>::aligned::const_iterator
-              vit = current_version_infos.begin(); vit !=
-              current_version_infos.end(); vit++)
+        LegionMap<VersionID,FieldMask>::aligned current_versions;
+        find_current_field_versions(version_mask, current_versions);
+        for (LegionMap<VersionID,FieldMask>::aligned::const_iterator cit =
+              current_versions.begin(); cit != current_versions.end(); cit++)
         {
-          FieldMask local_overlap = vit->second.get_valid_mask() & version_mask;
-          if (!local_overlap)
-            continue;
-          for (ManagerVersions::iterator it = vit->second.begin();
-                it != vit->second.end(); it++)
+          const ManagerVersions &info = find_current_versions(cit->first);
+          const FieldMask &local_overlap = cit->second;
+          for (ManagerVersions::iterator it = info.begin();
+                it != info.end(); it++)
           {
             FieldMask overlap = it->second & local_overlap;
             if (!overlap)
@@ -4698,15 +4696,15 @@ namespace Legion {
         FieldMask non_split = version_mask - split_mask;
         if (!!non_split)
         {
-          for (LegionMap<VersionID,ManagerVersions>::aligned::const_iterator
-                vit = current_version_infos.begin(); vit !=
-                current_version_infos.end(); vit++)
+          LegionMap<VersionID,FieldMask>::aligned current_versions;
+          find_current_field_versions(non_split, current_versions);
+          for (LegionMap<VersionID,FieldMask>::aligned::const_iterator cit =
+                current_versions.begin(); cit != current_versions.end(); cit++)
           {
-            FieldMask local_overlap = vit->second.get_valid_mask() & non_split;
-            if (!local_overlap)
-              continue;
-            for (ManagerVersions::iterator it = vit->second.begin();
-                  it != vit->second.end(); it++)
+            const ManagerVersions &info = find_current_versions(cit->first);
+            const FieldMask &local_overlap = cit->second;
+            for (ManagerVersions::iterator it = info.begin();
+                  it != info.end(); it++)
             {
               FieldMask overlap = it->second & local_overlap;
               if (!overlap)
@@ -4731,15 +4729,15 @@ namespace Legion {
       {
         // We are read-only with no split fields so everything is easy
         // We do have to request the initial version of the states
-        for (LegionMap<VersionID,ManagerVersions>::aligned::const_iterator
-              vit = current_version_infos.begin(); vit !=
-              current_version_infos.end(); vit++)
-        {
-          FieldMask local_overlap = vit->second.get_valid_mask() & version_mask;
-          if (!local_overlap)
-            continue;
-          for (ManagerVersions::iterator it = vit->second.begin();
-                it != vit->second.end(); it++)
+        LegionMap<VersionID,FieldMask>::aligned current_versions;
+        find_current_field_versions(version_mask, current_versions);
+        for (LegionMap<VersionID,FieldMask>::aligned::const_iterator cit =
+              current_versions.begin(); cit != current_versions.end(); cit++)
+        {
+          const ManagerVersions &info = find_current_versions(cit->first);
+          const FieldMask &local_overlap = cit->second;
+          for (ManagerVersions::iterator it = info.begin();
+                it != info.end(); it++)
           {
             FieldMask overlap = it->second & local_overlap;
             if (!overlap)
@@ -4813,15 +4811,15 @@ namespace Legion {
       // their open children information up to date because
       // it is the current version state objects that are 
       // tracking which children are dirty below 
-      for (LegionMap<VersionID,ManagerVersions>::aligned::const_iterator vit =
-            current_version_infos.begin(); vit != 
-            current_version_infos.end(); vit++)
+      LegionMap<VersionID,FieldMask>::aligned current_versions;
+      find_current_field_versions(version_mask, current_versions);
+      for (LegionMap<VersionID,FieldMask>::aligned::const_iterator cit =
+            current_versions.begin(); cit != current_versions.end(); cit++)
       {
-        FieldMask local_overlap = vit->second.get_valid_mask() & version_mask;
-        if (!local_overlap)
-          continue;
-        for (ManagerVersions::iterator it = vit->second.begin();
-              it != vit->second.end(); it++)
+        const ManagerVersions &info = find_current_versions(cit->first);
+        const FieldMask &local_overlap = cit->second;
+        for (ManagerVersions::iterator it = info.begin();
+              it != info.end(); it++)
         {
           FieldMask overlap = it->second & local_overlap;
           if (!overlap)
@@ -5152,11 +5150,18 @@ namespace Legion {
         // Keep a set of version states that have to be added
         LegionMap<VersionState*,FieldMask>::aligned to_add;
         std::set<VersionID> to_delete_current;
+        LegionMap<VersionID,FieldMask>::aligned current_versions;
+        find_current_field_versions(mask, current_versions);
         // Do this in reverse order so we can add new states earlier
-        for (LegionMap<VersionID,ManagerVersions>::aligned::reverse_iterator 
-              vit = current_version_infos.rbegin(); vit != 
-              current_version_infos.rend(); vit++)
+        for (LegionMap<VersionID,FieldMask>::aligned::const_reverse_iterator
+              cit = current_versions.rbegin(); cit != 
+              current_versions.rend(); cit++)
         {
+          LegionMap<VersionID,ManagerVersions>::aligned::iterator vit = 
+            current_version_infos.find(cit->first);
+#ifdef DEBUG_LEGION
+          assert(vit != current_version_infos.end());
+#endif
           FieldMask version_overlap = 
             vit->second.get_valid_mask() & current_filter;
           if (!version_overlap)
@@ -5268,6 +5273,8 @@ namespace Legion {
           current_version_infos[init_version].insert(new_state, 
                                                      current_filter, &mutator);
         }
+        // Every field in the mask has moved on to its next version
+        advance_current_field_versions(mask);
         // Finally add in our new states
         if (!to_add.empty())
         {
@@ -5419,16 +5426,19 @@ namespace Legion {
 #endif
         }
       }
-      for (LegionMap<VersionID,ManagerVersions>::aligned::const_iterator vit = 
-            current_version_infos.begin(); vit != 
-            current_version_infos.end(); vit++)
+      LegionMap<VersionID,FieldMask>::aligned current_versions;
+      find_current_field_versions(new_states.get_valid_mask(), current_versions);
+      for (LegionMap<VersionID,FieldMask>::aligned::const_iterator cit =
+            current_versions.begin(); cit != current_versions.end(); cit++)
       {
-        FieldMask version_overlap = 
-          vit->second.get_valid_mask() & new_states.get_valid_mask();
+        const ManagerVersions &info = find_current_versions(cit->first);
+        // Reducing open children can prune the new states as we go
+        const FieldMask version_overlap = 
+          cit->second & new_states.get_valid_mask();
         if (!version_overlap)
           continue;
-        for (ManagerVersions::iterator it = vit->second.begin();
-              it != vit->second.end(); it++)
+        for (ManagerVersions::iterator it = info.begin();
+              it != info.end(); it++)
         {
           FieldMask overlap = it->second & version_overlap;
           if (!overlap)
@@ -5458,6 +5468,7 @@ namespace Legion {
       remote_valid_fields -= invalid_mask;
       filter_version_info(invalid_mask, current_version_infos);
       filter_version_info(invalid_mask, previous_version_infos);
+      update_current_field_versions(invalid_mask, 0/*unversioned*/);
 #ifdef DEBUG_LEGION
       sanity_check();
 #endif
@@ -5957,6 +5968,10 @@ namespace Legion {
 #endif
         merge_send_infos(current_version_infos, current_update);
         merge_send_infos(previous_version_infos, previous_update);
+        for (LegionMap<VersionState*,FieldMask>::aligned::const_iterator it =
+              current_update.begin(); it != current_update.end(); it++)
+          update_current_field_versions(it->second,
+                                        it->first->version_number);
         // Update the remote valid fields
         remote_valid_fields |= update_mask;
         // Remove our outstanding request
@@ -6021,6 +6036,70 @@ namespace Legion {
                                      update_mask, applied_events);
     }
 
+    //--------------------------------------------------------------------------
+    void VersionManager::find_current_field_versions(const FieldMask &mask,
+                      LegionMap<VersionID,FieldMask>::aligned &versions) const
+    //--------------------------------------------------------------------------
+    {
+      // Only visit the fields that are set, anything past the end of
+      // the table has never been versioned
+      const int num_fields = current_field_versions.size();
+      for (int fidx = mask.find_first_set(); 
+            (fidx >= 0) && (fidx < num_fields); 
+            fidx = mask.find_next_set(fidx+1))
+      {
+        const VersionID vid = current_field_versions[fidx];
+        if (vid > 0)
+          versions[vid].set_bit(fidx);
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    const VersionManager::ManagerVersions& 
+                      VersionManager::find_current_versions(VersionID vid) const
+    //--------------------------------------------------------------------------
+    {
+      LegionMap<VersionID,ManagerVersions>::aligned::const_iterator finder = 
+        current_version_infos.find(vid);
+#ifdef DEBUG_LEGION
+      assert(finder != current_version_infos.end());
+#endif
+      return finder->second;
+    }
+
+    //--------------------------------------------------------------------------
+    void VersionManager::update_current_field_versions(const FieldMask &mask,
+                                                       VersionID vid)
+    //--------------------------------------------------------------------------
+    {
+      for (int fidx = mask.find_first_set(); fidx >= 0; 
+            fidx = mask.find_next_set(fidx+1))
+      {
+        if (unsigned(fidx) >= current_field_versions.size())
+        {
+          // Nothing to remove past the end of the table
+          if (vid == 0)
+            break;
+          current_field_versions.resize(fidx+1, 0);
+        }
+        current_field_versions[fidx] = vid;
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    void VersionManager::advance_current_field_versions(const FieldMask &mask)
+    //--------------------------------------------------------------------------
+    {
+      for (int fidx = mask.find_first_set(); fidx >= 0; 
+            fidx = mask.find_next_set(fidx+1))
+      {
+        if (unsigned(fidx) >= current_field_versions.size())
+          current_field_versions.resize(fidx+1, 0);
+        VersionID &vid = current_field_versions[fidx];
+        vid = (vid == 0) ? init_version : (vid + 1);
+      }
+    }
+
     //--------------------------------------------------------------------------
     void VersionManager::sanity_check(void)
     //--------------------------------------------------------------------------
@@ -6051,7 +6130,17 @@ namespace Legion {
         // Should not overlap with other fields in the current version
         assert(current_version_fields * local_version_fields);
         current_version_fields |= local_version_fields;
-      }
+        // The field index should agree about where these fields are
+        LegionMap<VersionID,FieldMask>::aligned indexed;
+        find_current_field_versions(local_version_fields, indexed);
+        assert(indexed.size() == 1);
+        assert(indexed.begin()->first == vit->first);
+        assert(indexed.begin()->second == local_version_fields);
+      }
+      // And it should not have any fields that are not current
+      for (unsigned fidx = 0; fidx < current_field_versions.size(); fidx++)
+        if (current_field_versions[fidx] > 0)
+          assert(current_version_fields.is_set(fidx));
       FieldMask previous_version_fields;
       for (LegionMap<VersionID,ManagerVersions>::aligned::const_iterator vit =
             previous_version_infos.begin(); vit != 
@@ -6098,6 +6187,8 @@ namespace Legion {
       // If we are not the owner, add a valid reference
       if (!is_owner())
         add_base_valid_ref(REMOTE_DID_REF);
+      // Keep the region tree alive as long as we are
+      logical_node->add_tree_reference();
 #ifdef LEGION_GC
       log_garbage.info("GC Version State %lld %d", 
           LEGION_DISTRIBUTED_ID_FILTER(did), local_space);
@@ -6131,6 +6222,7 @@ namespace Legion {
       log_garbage.info("GC Deletion %lld %d", 
           LEGION_DISTRIBUTED_ID_FILTER(did), local_space);
 #endif
+      logical_node->remove_tree_reference();
     }
 
     //--------------------------------------------------------------------------
@@ -6580,7 +6672,7 @@ namespace Legion {
         return;
       RtUserEvent ready_event = Runtime::create_rt_user_event();
       proxy_this->send_version_state_update_request(target, context, 
-          requestor, ready_event, mask, KIND);
+          requestor, ready_event, mask, KIND, skip_mask);
       preconditions.insert(ready_event);
     }
 
@@ -6653,6 +6745,18 @@ namespace Legion {
             if (!needed_fields)
               return; 
           }
+          // The final state contains everything in the initial state
+          for (LegionMap<RtEvent,FieldMask>::aligned::const_iterator it = 
+                final_events.begin(); it != final_events.end(); it++)
+          {
+            FieldMask overlap = it->second & needed_fields;
+            if (!overlap)
+              continue;
+            preconditions.insert(it->first);
+            needed_fields -= overlap;
+            if (!needed_fields)
+              return; 
+          }
           // If we still have remaining fields, we have to send requests to
           // all the other nodes asking for their data
           if (!!needed_fields)
@@ -6682,6 +6786,19 @@ namespace Legion {
           if (!needed_fields)
             return;
         }
+        // The final state contains everything in the initial state so
+        // there is no need to ask again for fields we requested it for
+        for (LegionMap<RtEvent,FieldMask>::aligned::const_iterator it = 
+              final_events.begin(); it != final_events.end(); it++)
+        {
+          FieldMask overlap = needed_fields & it->second;
+          if (!overlap)
+            continue;
+          preconditions.insert(it->first);
+          needed_fields -= overlap;
+          if (!needed_fields)
+            return;
+        }
         // If we still have remaining fields, make a new event and 
         // send a request to the intial owner
         if (!!needed_fields)
@@ -6759,9 +6876,30 @@ namespace Legion {
         }
         if (!!remaining_mask)
         {
+          // If we already received the initial state for some of these
+          // fields and have valid views for them, then the final state
+          // only has to send us what else is there for those fields
+          FieldMask skip_mask;
+          for (LegionMap<RtEvent,FieldMask>::aligned::const_iterator it = 
+                initial_events.begin(); it != initial_events.end(); it++)
+          {
+            if (!it->first.has_triggered())
+              continue;
+            skip_mask |= (it->second & remaining_mask);
+          }
+          if (!!skip_mask)
+          {
+            FieldMask valid_mask;
+            for (LegionMap<LogicalView*,FieldMask,VALID_VIEW_ALLOC>::
+                  track_aligned::const_iterator it = valid_views.begin(); 
+                  it != valid_views.end(); it++)
+              valid_mask |= it->second;
+            skip_mask &= valid_mask;
+          }
           RtUserEvent ready_event = Runtime::create_rt_user_event();
           send_version_state_update_request(owner_space, context, local_space,
-              ready_event, remaining_mask, FINAL_VERSION_REQUEST);
+              ready_event, remaining_mask, FINAL_VERSION_REQUEST,
+              !skip_mask ? NULL : &skip_mask);
           // Save the event indicating when the fields will be ready
           final_events[ready_event] = remaining_mask;
           preconditions.insert(ready_event);
@@ -6774,7 +6912,8 @@ namespace Legion {
                                                 InnerContext *context,
                                                 const FieldMask &request_mask,
                                                 VersionRequestKind request_kind,
-                                                RtUserEvent to_trigger)
+                                                RtUserEvent to_trigger,
+                                                const FieldMask *skip_mask)
     //--------------------------------------------------------------------------
     {
       DETAILED_PROFILER(logical_node->context->runtime,
@@ -6790,7 +6929,7 @@ namespace Legion {
         // Hold the lock in read-only mode while iterating these structures
         AutoLock s_lock(state_lock,1,false/*exclusive*/);
         // See if we should send all the fields or just do a partial send
-        if (!(update_fields - request_mask))
+        if (!(update_fields - request_mask) && (skip_mask == NULL))
         {
           // Send everything
           if (request_kind != CHILD_VERSION_REQUEST)
@@ -6911,7 +7050,10 @@ namespace Legion {
           }
           if (request_kind != CHILD_VERSION_REQUEST)
           {
-            if (!valid_views.empty())
+            // No need to send valid views the requestor already has
+            const FieldMask view_mask = (skip_mask == NULL) ? request_mask :
+                                          request_mask - *skip_mask;
+            if (!valid_views.empty() && !!view_mask)
             {
               // Sort into materialized and deferred
               LegionMap<MaterializedView*,FieldMask>::aligned materialized;
@@ -6921,7 +7063,7 @@ namespace Legion {
                     track_aligned::const_iterator it = valid_views.begin(); 
                     it != valid_views.end(); it++)
               {
-                FieldMask overlap = it->second & request_mask;
+                FieldMask overlap = it->second & view_mask;
                 if (!overlap)
                   continue;
                 if (it->first->is_materialized_view())
@@ -6986,7 +7128,8 @@ namespace Legion {
                                                 AddressSpaceID source,
                                                 RtUserEvent to_trigger,
                                                 const FieldMask &request_mask, 
-                                                VersionRequestKind request_kind) 
+                                                VersionRequestKind request_kind,
+                                                const FieldMask *skip_mask) 
     //--------------------------------------------------------------------------
     {
 #ifdef DEBUG_LEGION
@@ -7001,6 +7144,13 @@ namespace Legion {
         rez.serialize(to_trigger);
         rez.serialize(request_kind);
         rez.serialize(request_mask);
+        if (skip_mask != NULL)
+        {
+          rez.serialize<bool>(true);
+          rez.serialize(*skip_mask);
+        }
+        else
+          rez.serialize<bool>(false);
       }
       runtime->send_version_state_update_request(target, rez);
     }
@@ -7011,7 +7161,8 @@ namespace Legion {
                                                 RtUserEvent to_trigger, 
                                                 const FieldMask &request_mask, 
                                                 VersionRequestKind request_kind,
-                                                RtEvent precondition)
+                                                RtEvent precondition,
+                                                const FieldMask *skip_mask)
     //--------------------------------------------------------------------------
     {
 #ifdef DEBUG_LEGION
@@ -7022,6 +7173,7 @@ namespace Legion {
       args.target = target;
       args.context = context;
       args.request_mask = new FieldMask(request_mask);
+      args.skip_mask = (skip_mask == NULL) ? NULL : new FieldMask(*skip_mask);
       args.request_kind = request_kind;
       args.to_trigger = to_trigger;
       // There is imprecision in our tracking of which nodes have valid
@@ -7117,7 +7269,8 @@ namespace Legion {
     //--------------------------------------------------------------------------
     void VersionState::handle_version_state_update_request(
           AddressSpaceID source, InnerContext *context, RtUserEvent to_trigger, 
-          VersionRequestKind request_kind, FieldMask &request_mask)
+          VersionRequestKind request_kind, FieldMask &request_mask,
+          const FieldMask *skip_mask)
     //--------------------------------------------------------------------------
     {
       DETAILED_PROFILER(logical_node->context->runtime,
@@ -7157,7 +7310,7 @@ namespace Legion {
                  (request_kind == FINAL_VERSION_REQUEST));
 #endif
           launch_send_version_state_update(source, context, to_trigger, 
-                                           overlap, request_kind);
+                     overlap, request_kind, RtEvent::NO_RT_EVENT, skip_mask);
         }
       }
       else
@@ -7251,7 +7404,7 @@ namespace Legion {
             else
             {
               RequestFunctor<FINAL_VERSION_REQUEST> functor(this, context,
-                  source, request_mask, local_preconditions);
+                  source, request_mask, local_preconditions, skip_mask);
               remote_valid_instances.map(functor);
             }
             if (!local_preconditions.empty())
@@ -7261,7 +7414,7 @@ namespace Legion {
               {
                 RtUserEvent local_event = Runtime::create_rt_user_event();
                 launch_send_version_state_update(source, context, local_event, 
-                                                 overlap, request_kind);
+                         overlap, request_kind, RtEvent::NO_RT_EVENT, skip_mask);
                 local_preconditions.insert(local_event);
               }
               Runtime::trigger_event(to_trigger,
@@ -7275,7 +7428,7 @@ namespace Legion {
                 Runtime::trigger_event(to_trigger);
               else
                 launch_send_version_state_update(source, context, to_trigger,
-                                                 overlap, request_kind);
+                         overlap, request_kind, RtEvent::NO_RT_EVENT, skip_mask);
             }
           }
           else // We just have to send our local state
@@ -7285,7 +7438,7 @@ namespace Legion {
               Runtime::trigger_event(to_trigger);
             else
               launch_send_version_state_update(source, context, to_trigger,
-                                               overlap, request_kind);
+                         overlap, request_kind, RtEvent::NO_RT_EVENT, skip_mask);
           }
         }
       }
@@ -7787,6 +7940,11 @@ namespace Legion {
       derez.deserialize(request_kind);
       FieldMask request_mask;
       derez.deserialize(request_mask);
+      bool has_skip;
+      derez.deserialize(has_skip);
+      FieldMask skip_mask;
+      if (has_skip)
+        derez.deserialize(skip_mask);
       DistributedCollectable *target = rt->find_distributed_collectable(did);
 #ifdef DEBUG_LEGION
       VersionState *vs = dynamic_cast<VersionState*>(target);
@@ -7795,7 +7953,7 @@ namespace Legion {
       VersionState *vs = static_cast<VersionState*>(target);
 #endif
       vs->handle_version_state_update_request(source, context, to_trigger, 
-                                              request_kind, request_mask);
+                      request_kind, request_mask, has_skip ? &skip_mask : NULL);
     }
 
     //--------------------------------------------------------------------------
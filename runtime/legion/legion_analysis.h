@@ -71,6 +71,111 @@ namespace Legion {
       static const int TIMEOUT = DEFAULT_LOGICAL_USER_TIMEOUT;
     };
 
+    /**
+     * \class LogicalUserList
+     * The epoch user lists of a logical state are scanned in
+     * their entirety by every dependence test, so we store 
+     * them contiguously instead of in a linked list.  Erasing
+     * a user only marks its slot dead (the op is cleared) and
+     * the dead slots are compacted away the next time a user
+     * is added once they make up half of the list.  The 
+     * interface mirrors the subset of std::list that the 
+     * logical analysis uses.
+     */
+    template<AllocationType ALLOC>
+    class LogicalUserList {
+    public:
+      template<typename LIST, typename USER>
+      class Iterator {
+      public:
+        Iterator(LIST *l, size_t i)
+          : list(l), index(i) { skip_dead(); }
+        template<typename L2, typename U2>
+        Iterator(const Iterator<L2,U2> &rhs)
+          : list(rhs.list), index(rhs.index) { }
+      public:
+        inline USER& operator*(void) const { return list->users[index]; }
+        inline USER* operator->(void) const { return &list->users[index]; }
+        inline Iterator& operator++(void) 
+          { index++; skip_dead(); return *this; }
+        inline Iterator operator++(int)
+          { Iterator result(*this); index++; skip_dead(); return result; }
+        inline bool operator==(const Iterator &rhs) const
+          { return (index == rhs.index); }
+        inline bool operator!=(const Iterator &rhs) const
+          { return (index != rhs.index); }
+      protected:
+        inline void skip_dead(void)
+        {
+          while ((index < list->users.size()) && 
+                 (list->users[index].op == NULL))
+            index++;
+        }
+      public:
+        LIST *list;
+        size_t index;
+      };
+      typedef Iterator<LogicalUserList,LogicalUser> iterator;
+      typedef Iterator<const LogicalUserList,const LogicalUser> const_iterator;
+    public:
+      LogicalUserList(void) : dead(0) { }
+    public:
+      inline iterator begin(void) { return iterator(this, 0); }
+      inline iterator end(void) { return iterator(this, users.size()); }
+      inline const_iterator begin(void) const 
+        { return const_iterator(this, 0); }
+      inline const_iterator end(void) const 
+        { return const_iterator(this, users.size()); }
+      inline bool empty(void) const { return (users.size() == dead); }
+      inline size_t size(void) const { return (users.size() - dead); }
+    public:
+      inline iterator erase(iterator it)
+      {
+#ifdef DEBUG_LEGION
+        assert(it.index < users.size());
+        assert(users[it.index].op != NULL);
+#endif
+        users[it.index].op = NULL;
+        dead++;
+        return ++it;
+      }
+      inline void push_back(const LogicalUser &user)
+      {
+        if ((dead > 0) && ((2*dead) >= users.size()))
+          compact();
+        users.push_back(user);
+      }
+      inline LogicalUser& back(void)
+      {
+        size_t index = users.size();
+        do {
+#ifdef DEBUG_LEGION
+          assert(index > 0);
+#endif
+          index--;
+        } while (users[index].op == NULL);
+        return users[index];
+      }
+      inline void clear(void) { users.clear(); dead = 0; }
+      void compact(void)
+      {
+        size_t next = 0;
+        for (size_t idx = 0; idx < users.size(); idx++)
+        {
+          if (users[idx].op == NULL)
+            continue;
+          if (next != idx)
+            users[next] = users[idx];
+          next++;
+        }
+        users.erase(users.begin() + next, users.end());
+        dead = 0;
+      }
+    protected:
+      typename LegionVector<LogicalUser,ALLOC>::track_aligned users;
+      size_t dead;
+    };
+
     /**
      * \struct VersioningSet
      * A small helper class for tracking collections of 
@@ -607,10 +712,8 @@ namespace Legion {
     public:
       LegionList<FieldState,
                  LOGICAL_FIELD_STATE_ALLOC>::track_aligned field_states;
-      LegionList<LogicalUser,CURR_LOGICAL_ALLOC>::track_aligned 
-                                                            curr_epoch_users;
-      LegionList<LogicalUser,PREV_LOGICAL_ALLOC>::track_aligned 
-                                                            prev_epoch_users;
+      LogicalUserList<CURR_LOGICAL_ALLOC> curr_epoch_users;
+      LogicalUserList<PREV_LOGICAL_ALLOC> prev_epoch_users;
     public:
       // Fields which we know have been mutated below in the region tree
       FieldMask dirty_below;
@@ -622,6 +725,11 @@ namespace Legion {
       LegionMap<ReductionOpID,FieldMask>::aligned outstanding_reductions;
       // Keep track of the current projection epoch for each field
       std::list<ProjectionEpoch*> projection_epochs;
+    public:
+      // Whether this state has been used since it was last reset,
+      // analysis always walks down from the root of the context so
+      // nothing below an untouched state can have been used either
+      bool touched;
     };
 
     typedef DynamicTableAllocator<LogicalState,10,8> LogicalStateAllocator;
@@ -719,11 +827,11 @@ namespace Legion {
                                        const TraceInfo &trace_info);
       void perform_dependence_analysis(const LogicalUser &current,
                                        const FieldMask &open_below,
-             LegionList<LogicalUser,CURR_LOGICAL_ALLOC>::track_aligned &cusers,
-             LegionList<LogicalUser,PREV_LOGICAL_ALLOC>::track_aligned &pusers);
+                                 LogicalUserList<CURR_LOGICAL_ALLOC> &cusers,
+                                 LogicalUserList<PREV_LOGICAL_ALLOC> &pusers);
       void update_state(LogicalState &state);
       void register_close_operations(
-              LegionList<LogicalUser,CURR_LOGICAL_ALLOC>::track_aligned &users);
+                                  LogicalUserList<CURR_LOGICAL_ALLOC> &users);
     protected:
       void register_dependences(CloseOp *close_op, 
                                 const LogicalUser &close_user,
@@ -731,8 +839,8 @@ namespace Legion {
                                 const FieldMask &open_below,
              LegionList<LogicalUser,CLOSE_LOGICAL_ALLOC>::track_aligned &husers,
              LegionList<LogicalUser,LOGICAL_REC_ALLOC>::track_aligned &ausers,
-             LegionList<LogicalUser,CURR_LOGICAL_ALLOC>::track_aligned &cusers,
-             LegionList<LogicalUser,PREV_LOGICAL_ALLOC>::track_aligned &pusers);
+                                LogicalUserList<CURR_LOGICAL_ALLOC> &cusers,
+                                LogicalUserList<PREV_LOGICAL_ALLOC> &pusers);
     public:
       ContextID ctx;
       const LogicalUser &user;
@@ -1006,6 +1114,14 @@ namespace Legion {
       static void handle_response(Deserializer &derez);
     public:
       static void process_capture_dirty(const void *args);
+    protected:
+      // Batched lookups and updates of the field version index
+      void find_current_field_versions(const FieldMask &mask,
+                      LegionMap<VersionID,FieldMask>::aligned &versions) const;
+      const VersioningSet<VERSION_MANAGER_REF>& 
+                                  find_current_versions(VersionID vid) const;
+      void update_current_field_versions(const FieldMask &mask, VersionID vid);
+      void advance_current_field_versions(const FieldMask &mask);
     protected:
       void sanity_check(void);
     public:
@@ -1024,6 +1140,10 @@ namespace Legion {
       typedef VersioningSet<VERSION_MANAGER_REF> ManagerVersions;
       LegionMap<VersionID,ManagerVersions>::aligned current_version_infos;
       LegionMap<VersionID,ManagerVersions>::aligned previous_version_infos;
+      // Index from each field to the version number in current version 
+      // infos that has its version state(s), zero if it is unversioned,
+      // so lookups only have to visit the fields that they touch
+      std::vector<VersionID> current_field_versions;
     protected:
       // On the owner node this is the set of fields for which there are
       // remote copies. On remote nodes this is the set of fields which
@@ -1074,6 +1194,7 @@ namespace Legion {
         AddressSpaceID target;
         InnerContext *context;
         FieldMask *request_mask;
+        FieldMask *skip_mask;
         VersionRequestKind request_kind;
         RtUserEvent to_trigger;
       };
@@ -1113,9 +1234,10 @@ namespace Legion {
       struct RequestFunctor {
       public:
         RequestFunctor(VersionState *proxy, InnerContext *ctx,
-            AddressSpaceID r, const FieldMask &m, std::set<RtEvent> &pre)
+            AddressSpaceID r, const FieldMask &m, std::set<RtEvent> &pre,
+            const FieldMask *skip = NULL)
           : proxy_this(proxy), context(ctx), requestor(r), 
-            mask(m), preconditions(pre) { }
+            mask(m), preconditions(pre), skip_mask(skip) { }
       public:
         void apply(AddressSpaceID target);
       private:
@@ -1124,6 +1246,7 @@ namespace Legion {
         AddressSpaceID requestor;
         const FieldMask &mask;
         std::set<RtEvent> &preconditions;
+        const FieldMask *const skip_mask;
       };
     public:
       VersionState(VersionID vid, Runtime *rt, DistributedID did,
@@ -1181,21 +1304,26 @@ namespace Legion {
                                        const FieldMask &request_mask,
                                        std::set<RtEvent> &preconditions);
     public:
+      // The skip mask names fields for which the requestor already
+      // has valid views so only the rest of the state has to be sent
       void send_version_state_update(AddressSpaceID target,
                                      InnerContext *context,
                                      const FieldMask &request_mask, 
                                      VersionRequestKind request_kind,
-                                     RtUserEvent to_trigger);
+                                     RtUserEvent to_trigger,
+                                     const FieldMask *skip_mask = NULL);
       void send_version_state_update_request(AddressSpaceID target, 
                           InnerContext *context, AddressSpaceID src, 
                           RtUserEvent to_trigger, const FieldMask &request_mask,
-                          VersionRequestKind request_kind);
+                          VersionRequestKind request_kind,
+                          const FieldMask *skip_mask = NULL);
       void launch_send_version_state_update(AddressSpaceID target,
                                      InnerContext *context,
                                      RtUserEvent to_trigger, 
                                      const FieldMask &request_mask, 
                                      VersionRequestKind request_kind,
-                                     RtEvent precondition=RtEvent::NO_RT_EVENT);
+                                     RtEvent precondition=RtEvent::NO_RT_EVENT,
+                                     const FieldMask *skip_mask = NULL);
     public:
       void send_version_state(AddressSpaceID source);
       static void handle_version_state_request(Deserializer &derez,
@@ -1207,7 +1335,8 @@ namespace Legion {
                                         InnerContext *context,
                                         RtUserEvent to_trigger, 
                                         VersionRequestKind request_kind,
-                                        FieldMask &request_mask);
+                                        FieldMask &request_mask,
+                                        const FieldMask *skip_mask = NULL);
       void handle_version_state_update_response(InnerContext *context,
                                                RtUserEvent to_trigger, 
                                                Deserializer &derez, 
@@ -4267,6 +4267,33 @@ legion_runtime_get_executing_processor(legion_runtime_t runtime_,
   return CObjectWrapper::wrap(proc);
 }
 
+size_t
+legion_runtime_get_memory_usage(legion_runtime_t runtime_)
+{
+  Runtime *runtime = CObjectWrapper::unwrap(runtime_);
+
+  return runtime->get_runtime_memory_usage();
+}
+
+size_t
+legion_runtime_get_memory_usage_by_kind(legion_runtime_t runtime_,
+                                        char **names,
+                                        size_t *bytes,
+                                        size_t max_kinds)
+{
+  Runtime *runtime = CObjectWrapper::unwrap(runtime_);
+
+  std::map<std::string,size_t> by_kind;
+  runtime->get_runtime_memory_usage(&by_kind);
+  size_t idx = 0;
+  for (std::map<std::string,size_t>::const_iterator it = by_kind.begin();
+       (it != by_kind.end()) && (idx < max_kinds); it++, idx++) {
+    names[idx] = strdup(it->first.c_str());
+    bytes[idx] = it->second;
+  }
+  return by_kind.size();
+}
+
 // -----------------------------------------------------------------------
 // Physical Data Operations
 // -----------------------------------------------------------------------
@@ -4492,6 +4519,200 @@ legion_accessor_generic_get_soa_parameters(legion_accessor_generic_t handle_,
   return handle->get_soa_parameters(*base, *stride);
 }
 
+static bool
+get_affine_descriptor(AccessorGeneric *handle, int dim,
+                      legion_accessor_affine_descriptor_t *desc)
+{
+  LegionRuntime::Accessor::ByteOffset offsets[MAX_POINT_DIM];
+  void *base = NULL;
+  switch (dim) {
+  case 1:
+    base = handle->raw_rect_ptr<1>(&offsets[0]);
+    break;
+  case 2:
+    base = handle->raw_rect_ptr<2>(&offsets[0]);
+    break;
+  case 3:
+    base = handle->raw_rect_ptr<3>(&offsets[0]);
+    break;
+  default:
+    assert(false);
+  }
+  if (base == NULL)
+    return false;
+  desc->base = base;
+  desc->dim = dim;
+  for (int i = 0; i < dim; i++)
+    desc->strides[i] = CObjectWrapper::wrap(offsets[i]);
+  return true;
+}
+
+bool
+legion_accessor_generic_get_affine_descriptor(
+  legion_accessor_generic_t handle_,
+  int dim,
+  legion_accessor_affine_descriptor_t *desc)
+{
+  AccessorGeneric *handle = CObjectWrapper::unwrap(handle_);
+
+  return get_affine_descriptor(handle, dim, desc);
+}
+
+void
+legion_accessor_generic_read_span(legion_accessor_generic_t handle_,
+                                  legion_ptr_t ptr_,
+                                  size_t count,
+                                  void *dst_,
+                                  size_t dst_stride,
+                                  size_t bytes)
+{
+  AccessorGeneric *handle = CObjectWrapper::unwrap(handle_);
+  ptr_t ptr = CObjectWrapper::unwrap(ptr_);
+  char *dst = static_cast<char *>(dst_);
+  if (dst_stride == 0)
+    dst_stride = bytes;
+  if (count == 0)
+    return;
+
+  // Use a direct pointer when the instance has one, otherwise fall
+  // back to element-wise reads (still without crossing the FFI)
+  void *base = NULL;
+  size_t stride = 0;
+  if (handle->get_soa_parameters(base, stride)) {
+    size_t act_count = 0;
+    LegionRuntime::Accessor::ByteOffset elem_stride;
+    const char *src = static_cast<const char *>(
+      handle->raw_span_ptr(ptr, count, act_count, elem_stride));
+    assert(act_count == count);
+    if ((size_t(elem_stride.offset) == bytes) && (dst_stride == bytes))
+      memcpy(dst, src, count * bytes);
+    else
+      for (size_t i = 0; i < count; i++)
+        memcpy(dst + i * dst_stride, src + i * elem_stride.offset, bytes);
+  } else {
+    for (size_t i = 0; i < count; i++)
+      handle->read_untyped(ptr_t(ptr.value + i), dst + i * dst_stride, bytes);
+  }
+}
+
+void
+legion_accessor_generic_write_span(legion_accessor_generic_t handle_,
+                                   legion_ptr_t ptr_,
+                                   size_t count,
+                                   const void *src_,
+                                   size_t src_stride,
+                                   size_t bytes)
+{
+  AccessorGeneric *handle = CObjectWrapper::unwrap(handle_);
+  ptr_t ptr = CObjectWrapper::unwrap(ptr_);
+  const char *src = static_cast<const char *>(src_);
+  if (src_stride == 0)
+    src_stride = bytes;
+  if (count == 0)
+    return;
+
+  void *base = NULL;
+  size_t stride = 0;
+  if (handle->get_soa_parameters(base, stride)) {
+    size_t act_count = 0;
+    LegionRuntime::Accessor::ByteOffset elem_stride;
+    char *dst = static_cast<char *>(
+      handle->raw_span_ptr(ptr, count, act_count, elem_stride));
+    assert(act_count == count);
+    if ((size_t(elem_stride.offset) == bytes) && (src_stride == bytes))
+      memcpy(dst, src, count * bytes);
+    else
+      for (size_t i = 0; i < count; i++)
+        memcpy(dst + i * elem_stride.offset, src + i * src_stride, bytes);
+  } else {
+    for (size_t i = 0; i < count; i++)
+      handle->write_untyped(ptr_t(ptr.value + i), src + i * src_stride, bytes);
+  }
+}
+
+void
+legion_accessor_generic_read_indexed(legion_accessor_generic_t handle_,
+                                     const legion_ptr_t *ptrs,
+                                     size_t count,
+                                     void *dst_,
+                                     size_t bytes)
+{
+  AccessorGeneric *handle = CObjectWrapper::unwrap(handle_);
+  char *dst = static_cast<char *>(dst_);
+
+  for (size_t i = 0; i < count; i++)
+    handle->read_untyped(CObjectWrapper::unwrap(ptrs[i]), dst + i * bytes, bytes);
+}
+
+void
+legion_accessor_generic_write_indexed(legion_accessor_generic_t handle_,
+                                      const legion_ptr_t *ptrs,
+                                      size_t count,
+                                      const void *src_,
+                                      size_t bytes)
+{
+  AccessorGeneric *handle = CObjectWrapper::unwrap(handle_);
+  const char *src = static_cast<const char *>(src_);
+
+  for (size_t i = 0; i < count; i++)
+    handle->write_untyped(CObjectWrapper::unwrap(ptrs[i]), src + i * bytes, bytes);
+}
+
+static inline char *
+affine_element_ptr(const legion_accessor_affine_descriptor_t &desc,
+                   const legion_domain_point_t &dp)
+{
+  assert(dp.dim == desc.dim);
+  char *ptr = static_cast<char *>(desc.base);
+  for (int d = 0; d < desc.dim; d++)
+    ptr += dp.point_data[d] * desc.strides[d].offset;
+  return ptr;
+}
+
+void
+legion_accessor_generic_read_domain_points(legion_accessor_generic_t handle_,
+                                           const legion_domain_point_t *dps,
+                                           size_t count,
+                                           void *dst_,
+                                           size_t bytes)
+{
+  AccessorGeneric *handle = CObjectWrapper::unwrap(handle_);
+  char *dst = static_cast<char *>(dst_);
+  if (count == 0)
+    return;
+
+  legion_accessor_affine_descriptor_t desc;
+  if ((dps[0].dim > 0) && get_affine_descriptor(handle, dps[0].dim, &desc)) {
+    for (size_t i = 0; i < count; i++)
+      memcpy(dst + i * bytes, affine_element_ptr(desc, dps[i]), bytes);
+  } else {
+    for (size_t i = 0; i < count; i++)
+      handle->read_untyped(CObjectWrapper::unwrap(dps[i]), dst + i * bytes, bytes);
+  }
+}
+
+void
+legion_accessor_generic_write_domain_points(legion_accessor_generic_t handle_,
+                                            const legion_domain_point_t *dps,
+                                            size_t count,
+                                            const void *src_,
+                                            size_t bytes)
+{
+  AccessorGeneric *handle = CObjectWrapper::unwrap(handle_);
+  const char *src = static_cast<const char *>(src_);
+  if (count == 0)
+    return;
+
+  legion_accessor_affine_descriptor_t desc;
+  if ((dps[0].dim > 0) && get_affine_descriptor(handle, dps[0].dim, &desc)) {
+    for (size_t i = 0; i < count; i++)
+      memcpy(affine_element_ptr(desc, dps[i]), src + i * bytes, bytes);
+  } else {
+    for (size_t i = 0; i < count; i++)
+      handle->write_untyped(CObjectWrapper::unwrap(dps[i]), src + i * bytes, bytes);
+  }
+}
+
 void
 legion_accessor_array_destroy(legion_accessor_array_t handle_)
 {
@@ -5361,6 +5582,16 @@ legion_task_postamble(
 
 class FunctorWrapper : public ProjectionFunctor {
 public:
+  FunctorWrapper(unsigned dep,
+                 legion_projection_functor_logical_region_t region_fn,
+                 legion_projection_functor_logical_partition_t partition_fn)
+    : ProjectionFunctor()
+    , depth(dep)
+    , region_functor(region_fn)
+    , partition_functor(partition_fn)
+  {
+  }
+
   FunctorWrapper(Runtime *rt, unsigned dep,
                  legion_projection_functor_logical_region_t region_fn,
                  legion_projection_functor_logical_partition_t partition_fn)
@@ -5415,6 +5646,18 @@ private:
   legion_projection_functor_logical_partition_t partition_functor;
 };
 
+void
+legion_runtime_preregister_projection_functor(
+  legion_projection_id_t id,
+  unsigned depth,
+  legion_projection_functor_logical_region_t region_functor,
+  legion_projection_functor_logical_partition_t partition_functor)
+{
+  FunctorWrapper *functor =
+    new FunctorWrapper(depth, region_functor, partition_functor);
+  Runtime::preregister_projection_functor(id, functor);
+}
+
 void
 legion_runtime_register_projection_functor(
   legion_runtime_t runtime_,
@@ -210,6 +210,18 @@ extern "C" {
     int offset;
   } legion_byte_offset_t;
 
+  /**
+   * Element (p) of an affine instance lives at
+   * base + sum(p[i] * strides[i].offset) bytes.
+   *
+   * @see legion_accessor_generic_get_affine_descriptor()
+   */
+  typedef struct legion_accessor_affine_descriptor_t {
+    void *base;
+    int dim;
+    legion_byte_offset_t strides[MAX_POINT_DIM];
+  } legion_accessor_affine_descriptor_t;
+
   /**
    * @see Legion::InputArgs
    */
@@ -2578,6 +2590,28 @@ extern "C" {
   legion_runtime_get_executing_processor(legion_runtime_t runtime,
                                          legion_context_t ctx);
 
+  /**
+   * @see Legion::Runtime::get_runtime_memory_usage()
+   */
+  size_t
+  legion_runtime_get_memory_usage(legion_runtime_t runtime);
+
+  /**
+   * Fills in the names and bytes of up to `max_kinds` kinds of runtime
+   * data structures and returns the total number of kinds in use, which
+   * may be larger than `max_kinds`.
+   *
+   * @param names Caller takes ownership of the strings written to
+   *   `names` and must release them with free().
+   *
+   * @see Legion::Runtime::get_runtime_memory_usage()
+   */
+  size_t
+  legion_runtime_get_memory_usage_by_kind(legion_runtime_t runtime,
+                                          char **names,
+                                          size_t *bytes,
+                                          size_t max_kinds);
+
   // -----------------------------------------------------------------------
   // Physical Data Operations
   // -----------------------------------------------------------------------
@@ -2729,6 +2763,105 @@ extern "C" {
                                              void **base,
                                              size_t *stride);
 
+  /**
+   * Fills in `desc` with the base pointer and per-dimension byte
+   * strides of the whole instance, so that bindings can address
+   * elements directly. `dim` must be the dimensionality of the
+   * instance's index space.
+   *
+   * @return false if the instance is not directly addressable from
+   * this processor.
+   *
+   * @see LegionRuntime::Accessor::Generic::Untyped::raw_rect_ptr()
+   */
+  bool
+  legion_accessor_generic_get_affine_descriptor(
+    legion_accessor_generic_t handle,
+    int dim,
+    legion_accessor_affine_descriptor_t *desc);
+
+  /**
+   * Reads `count` consecutive elements of `bytes` bytes each starting
+   * at `ptr` into `dst`, placing element i at `dst + i * dst_stride`.
+   * A `dst_stride` of zero means `bytes`.
+   *
+   * @see LegionRuntime::Accessor::Generic::Untyped::read_untyped()
+   */
+  void
+  legion_accessor_generic_read_span(legion_accessor_generic_t handle,
+                                    legion_ptr_t ptr,
+                                    size_t count,
+                                    void *dst,
+                                    size_t dst_stride,
+                                    size_t bytes);
+
+  /**
+   * Writes `count` consecutive elements of `bytes` bytes each starting
+   * at `ptr` from `src`, taking element i from `src + i * src_stride`.
+   * A `src_stride` of zero means `bytes`.
+   *
+   * @see LegionRuntime::Accessor::Generic::Untyped::write_untyped()
+   */
+  void
+  legion_accessor_generic_write_span(legion_accessor_generic_t handle,
+                                     legion_ptr_t ptr,
+                                     size_t count,
+                                     const void *src,
+                                     size_t src_stride,
+                                     size_t bytes);
+
+  /**
+   * Reads the elements at `ptrs[0 .. count-1]` into the dense array
+   * `dst`.
+   *
+   * @see LegionRuntime::Accessor::Generic::Untyped::read_untyped()
+   */
+  void
+  legion_accessor_generic_read_indexed(legion_accessor_generic_t handle,
+                                       const legion_ptr_t *ptrs,
+                                       size_t count,
+                                       void *dst,
+                                       size_t bytes);
+
+  /**
+   * Writes the elements at `ptrs[0 .. count-1]` from the dense array
+   * `src`.
+   *
+   * @see LegionRuntime::Accessor::Generic::Untyped::write_untyped()
+   */
+  void
+  legion_accessor_generic_write_indexed(legion_accessor_generic_t handle,
+                                        const legion_ptr_t *ptrs,
+                                        size_t count,
+                                        const void *src,
+                                        size_t bytes);
+
+  /**
+   * Reads the elements at `dps[0 .. count-1]` into the dense array
+   * `dst`.
+   *
+   * @see LegionRuntime::Accessor::Generic::Untyped::read_untyped()
+   */
+  void
+  legion_accessor_generic_read_domain_points(legion_accessor_generic_t handle,
+                                             const legion_domain_point_t *dps,
+                                             size_t count,
+                                             void *dst,
+                                             size_t bytes);
+
+  /**
+   * Writes the elements at `dps[0 .. count-1]` from the dense array
+   * `src`.
+   *
+   * @see LegionRuntime::Accessor::Generic::Untyped::write_untyped()
+   */
+  void
+  legion_accessor_generic_write_domain_points(legion_accessor_generic_t handle,
+                                              const legion_domain_point_t *dps,
+                                              size_t count,
+                                              const void *src,
+                                              size_t bytes);
+
   /**
    * @param handle Caller must have ownership of parameter `handle`.
    */
@@ -3333,12 +3466,24 @@ extern "C" {
     const void *retval,
     size_t retsize);
 
+  /**
+   * @see Legion::Runtime::preregister_projection_functor()
+   */
+  void
+  legion_runtime_preregister_projection_functor(
+    legion_projection_id_t id,
+    unsigned depth,
+    legion_projection_functor_logical_region_t region_functor,
+    legion_projection_functor_logical_partition_t partition_functor);
+
   /**
    * @see Legion::Runtime::register_projection_functor()
    */
   void
   legion_runtime_register_projection_functor(
+    legion_runtime_t runtime,
     legion_projection_id_t id,
+    unsigned depth,
     legion_projection_functor_logical_region_t region_functor,
     legion_projection_functor_logical_partition_t partition_functor);
 
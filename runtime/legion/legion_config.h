@@ -54,6 +54,10 @@
 #ifndef MAX_FIELDS
 #define MAX_FIELDS         512 // must be a power of 2
 #endif
+// Define LEGION_SPARSE_FIELD_MASKS to store field masks with only a few
+// fields set as a short list of field indexes instead of MAX_FIELDS bits,
+// which saves space and time when MAX_FIELDS is large but most operations
+// only name a handful of fields
 
 // Some default values
 
@@ -85,6 +89,16 @@
 #ifndef DEFAULT_LOCAL_FIELDS
 #define DEFAULT_LOCAL_FIELDS            4
 #endif
+// Default bound on the intersection cache of each index tree
+// node, counted as one per entry plus one per cached domain
+#ifndef DEFAULT_MAX_INTERSECTION_CACHE
+#define DEFAULT_MAX_INTERSECTION_CACHE  4096
+#endif
+// Longest window of repeating task launches that a context will
+// look for and trace automatically (zero disables auto-tracing)
+#ifndef DEFAULT_AUTO_TRACE_WINDOW
+#define DEFAULT_AUTO_TRACE_WINDOW       0
+#endif
 // Default number of mapper slots
 #ifndef DEFAULT_MAPPER_SLOTS
 #define DEFAULT_MAPPER_SLOTS            8
@@ -103,6 +117,11 @@
 #ifndef DEFAULT_TASK_WINDOW_HYSTERESIS
 #define DEFAULT_TASK_WINDOW_HYSTERESIS  75
 #endif
+// How far an adaptive task window may move away from its initial
+// size as a factor in each direction (see -lg:adaptive_window)
+#ifndef DEFAULT_TASK_WINDOW_ADAPT_RANGE
+#define DEFAULT_TASK_WINDOW_ADAPT_RANGE 8
+#endif
 // How many tasks to group together for runtime operations
 #ifndef DEFAULT_MIN_TASKS_TO_SCHEDULE
 #define DEFAULT_MIN_TASKS_TO_SCHEDULE   32
@@ -112,6 +131,26 @@
 #ifndef DEFAULT_SUPERSCALAR_WIDTH
 #define DEFAULT_SUPERSCALAR_WIDTH       4
 #endif
+// How many points of a slice to map in each meta-task
+// so the points of large slices can be mapped in parallel
+// on the utility processors (zero maps all points of a
+// slice in a single meta-task)
+#ifndef DEFAULT_POINT_MAPPING_CHUNK
+#define DEFAULT_POINT_MAPPING_CHUNK     0
+#endif
+// How many reduction instances with the same reduction operator
+// need to be applied to an instance before they are first folded
+// together pairwise in a tree of temporary reduction instances
+// (zero always applies them to the instance one at a time)
+#ifndef DEFAULT_REDUCTION_FOLD_THRESHOLD
+#define DEFAULT_REDUCTION_FOLD_THRESHOLD 16
+#endif
+// The largest number of points in an identity projection that
+// will be tested against the children written by an aliased
+// partition in order to prove a close operation is unnecessary
+#ifndef DEFAULT_MAX_CLOSE_ELISION_COLORS
+#define DEFAULT_MAX_CLOSE_ELISION_COLORS 64
+#endif
 // The maximum size of active messages sent by the runtime in bytes
 // Note this value was picked based on making a tradeoff between
 // latency and bandwidth numbers on both Cray and Infiniband
@@ -119,6 +158,34 @@
 #ifndef DEFAULT_MAX_MESSAGE_SIZE
 #define DEFAULT_MAX_MESSAGE_SIZE        16384
 #endif
+// How long in microseconds and for how many bytes messages
+// on the semantic info virtual channel are held back in
+// order to batch them up before they are sent
+#ifndef DEFAULT_SEMANTIC_FLUSH_DELAY
+#define DEFAULT_SEMANTIC_FLUSH_DELAY    100
+#endif
+#ifndef DEFAULT_SEMANTIC_FLUSH_BYTES
+#define DEFAULT_SEMANTIC_FLUSH_BYTES    4096
+#endif
+// How long in microseconds the removal of remote references
+// to distributed collectables are held back so that they can
+// cancel out with later additions and be sent in batches
+// (zero sends every reference update immediately)
+#ifndef DEFAULT_REMOTE_REFERENCE_DELAY
+#define DEFAULT_REMOTE_REFERENCE_DELAY  100
+#endif
+// Task arguments of at least this many bytes are stored in
+// shared immutable buffers deduplicated by content hash so that
+// local launches share one copy and each node receives a buffer
+// only once (zero disables sharing)
+#ifndef DEFAULT_SHARED_ARGUMENT_THRESHOLD
+#define DEFAULT_SHARED_ARGUMENT_THRESHOLD  65536
+#endif
+// Upper bound in bytes on the shared task arguments that are
+// cached locally and that will be pinned on each remote node
+#ifndef DEFAULT_SHARED_ARGUMENT_CACHE
+#define DEFAULT_SHARED_ARGUMENT_CACHE   67108864
+#endif
 // Timeout before checking for whether a logical user
 // should be pruned from the logical region tree data strucutre
 // Making the value less than or equal to zero will
@@ -133,6 +200,31 @@
 #ifndef DEFAULT_GC_EPOCH_SIZE
 #define DEFAULT_GC_EPOCH_SIZE           64
 #endif
+// How many views of a GC epoch are collected in each
+// background meta-task, and how many microseconds one
+// of those meta-tasks may run before it yields the rest
+// of its views to a new meta-task (zero never yields)
+#ifndef DEFAULT_GC_SLICE_SIZE
+#define DEFAULT_GC_SLICE_SIZE           8
+#endif
+#ifndef DEFAULT_GC_PAUSE_TARGET
+#define DEFAULT_GC_PAUSE_TARGET         500
+#endif
+// How often in microseconds the bytes used by each kind
+// of runtime data structure are sampled into the profiler
+#ifndef DEFAULT_PROF_MEMORY_INTERVAL
+#define DEFAULT_PROF_MEMORY_INTERVAL    100000
+#endif
+// When the profiler is given a memory cap (-lg:prof_footprint) each
+// thread hands off its records to be written out in chunks of this
+// many bytes. If the chunks waiting to be written exceed the cap then
+// only one in this many runtime records is kept (-lg:prof_sample)
+#ifndef DEFAULT_PROF_CHUNK_SIZE
+#define DEFAULT_PROF_CHUNK_SIZE         (1 << 20)
+#endif
+#ifndef DEFAULT_PROF_SAMPLE_RATE
+#define DEFAULT_PROF_SAMPLE_RATE        16
+#endif
 
 // Used for debugging memory leaks
 // How often tracing information is dumped
@@ -157,6 +249,25 @@
 #define LEGION_MAX_RECYCLABLE_OBJECTS      1024
 #endif
 
+// How many operations of each kind a thread can
+// keep to itself for recycling without going back
+// to the runtime's shared lists. Threads refill
+// and drain their caches half of this at a time.
+#ifndef LEGION_OPERATION_CACHE_SIZE
+#define LEGION_OPERATION_CACHE_SIZE        32
+#endif
+
+// How many bytes of memory the slab pools behind
+// LegionHeapify objects reserve at a time, and how
+// many free blocks threads move to and from the
+// global free list of a pool in each batch
+#ifndef LEGION_SLAB_SIZE
+#define LEGION_SLAB_SIZE                   65536
+#endif
+#ifndef LEGION_SLAB_BATCH_SIZE
+#define LEGION_SLAB_BATCH_SIZE             32
+#endif
+
 // An initial seed for random numbers
 // generated by the high-level runtime.
 #ifndef LEGION_INIT_SEED
@@ -207,6 +318,14 @@
 #define LEGION_DISTRIBUTED_HELP_DECODE(x)   ((x) >> 56)
 #define LEGION_DISTRIBUTED_HELP_ENCODE(x,y) ((x) | ((y) << 56))
 
+// Region tree IDs are recycled after a destroyed region tree has been
+// reclaimed, the top bits of a tree ID record how many times its slot
+// has been reused so stale handles do not alias newer trees
+#define LEGION_TREE_ID_MASK           0x0FFFFFFFU
+#define LEGION_TREE_ID_FILTER(x)      ((x) & 0x0FFFFFFFU)
+#define LEGION_TREE_ID_GENERATION(x)  ((x) >> 28)
+#define LEGION_TREE_ID_ENCODE(x,y)    ((x) | (((y) & 0xFU) << 28))
+
 // The following enums are all re-exported by
 // namespace Legion. These versions are here to facilitate the
 // C API. If you are writing C++ code, use the namespaced versions.
@@ -442,6 +561,14 @@ typedef enum legion_external_resource_t {
   EXTERNAL_FORTRAN_ARRAY,
 } legion_external_resource_t;
 
+// Order in which a memory collects instances to make space
+typedef enum legion_eviction_policy_t {
+  EVICT_BEST_FIT, // closest in size first (the default)
+  EVICT_LRU,      // least recently used first
+  EVICT_LFU,      // least frequently used first
+  EVICT_ARC,      // adaptive between recency and frequency
+} legion_eviction_policy_t;
+
 typedef enum legion_timing_measurement_t {
   MEASURE_SECONDS,
   MEASURE_MICRO_SECONDS,
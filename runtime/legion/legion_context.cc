@@ -19,6 +19,7 @@
 #include "legion_context.h"
 #include "legion_instances.h"
 #include "legion_views.h"
+#include "legion_profiling.h"
 
 namespace Legion {
   namespace Internal {
@@ -301,7 +302,10 @@ namespace Legion {
           deleted_regions.insert(handle);
       }
       if (finalize)
+      {
+        invalidate_region_tree_owners(handle.get_tree_id());
         runtime->finalize_logical_region_destroy(handle);
+      }
     }
 
     //--------------------------------------------------------------------------
@@ -531,7 +535,10 @@ namespace Legion {
       {
         for (std::vector<LogicalRegion>::const_iterator it = 
               to_finalize.begin(); it != to_finalize.end(); it++)
+        {
+          invalidate_region_tree_owners(it->get_tree_id());
           runtime->finalize_logical_region_destroy(*it);
+        }
       }
     } 
 
@@ -2238,7 +2245,12 @@ namespace Legion {
         parent_req_indexes(parent_indexes), virtual_mapped(virt_mapped), 
         total_children_count(0), total_close_count(0), 
         outstanding_children_count(0), current_trace(NULL), 
-        valid_wait_event(false), outstanding_subtasks(0), pending_subtasks(0), 
+        auto_trace(NULL), auto_trace_index(0), auto_trace_pending(0),
+        has_auto_trace_pending(false), issuing_auto_trace_op(false),
+        auto_traces_detected(0), auto_trace_hits(0), auto_trace_misses(0),
+        valid_wait_event(false), window_lower_bound(0), window_upper_bound(0),
+        analysis_lag(0), execution_lag(0), window_samples(0), 
+        window_stalled(false), outstanding_subtasks(0), pending_subtasks(0), 
         pending_frames(0), currently_active_context(false),
         current_fence(NULL), fence_gen(0) 
     //--------------------------------------------------------------------------
@@ -2290,6 +2302,13 @@ namespace Legion {
     {
       if (!remote_instances.empty())
         invalidate_remote_contexts();
+      // Remote contexts never invalidate their region tree owners
+      // so release their references on the region trees here
+      for (std::map<RegionTreeNode*,
+                    std::pair<AddressSpaceID,bool> >::const_iterator it =
+            region_tree_owners.begin(); it != region_tree_owners.end(); it++)
+        it->first->remove_tree_reference();
+      region_tree_owners.clear();
       for (std::map<TraceID,DynamicTrace*>::const_iterator it = traces.begin();
             it != traces.end(); it++)
       {
@@ -2297,6 +2316,8 @@ namespace Legion {
           delete (it->second);
       }
       traces.clear();
+      if ((auto_trace != NULL) && auto_trace->remove_reference())
+        delete auto_trace;
       // Clean up any locks and barriers that the user
       // asked us to destroy
       while (!context_locks.empty())
@@ -2410,6 +2431,8 @@ namespace Legion {
       region_tree_owners[node] = 
         std::pair<AddressSpaceID,bool>(source, 
                                       (source != runtime->address_space));
+      // Keep the region tree alive until we are done with it
+      node->add_tree_reference();
       return source;
     } 
 
@@ -2526,7 +2549,7 @@ namespace Legion {
       int depth = get_depth();
       rez.serialize(depth);
       // See if we need to pack up base task information
-      owner_task->pack_external_task(rez, target);
+      owner_task->pack_external_task(rez, target, runtime);
 #ifdef DEBUG_LEGION
       assert(regions.size() == parent_req_indexes.size());
 #endif
@@ -4171,6 +4194,8 @@ namespace Legion {
         result->complete_future();
         return Future(result);
       }
+      if (Runtime::auto_trace_window > 0)
+        record_auto_trace_launch(launcher);
       IndividualTask *task = runtime->get_available_individual_task(true);
 #ifdef DEBUG_LEGION
       Future result = 
@@ -4284,6 +4309,8 @@ namespace Legion {
         result->complete_all_futures();
         return FutureMap(result);
       }
+      if (Runtime::auto_trace_window > 0)
+        record_auto_trace_launch(launcher);
       IndexTask *task = runtime->get_available_index_task(true);
 #ifdef DEBUG_LEGION
       FutureMap result = 
@@ -4348,6 +4375,8 @@ namespace Legion {
         result->complete_future();
         return Future(result);
       }
+      if (Runtime::auto_trace_window > 0)
+        record_auto_trace_launch(launcher);
       IndexTask *task = runtime->get_available_index_task(true);
 #ifdef DEBUG_LEGION
       Future result = 
@@ -4982,10 +5011,15 @@ namespace Legion {
                       const std::vector<StaticDependence> *dependences)
     //--------------------------------------------------------------------------
     {
+      // See if this operation continues or breaks an automatic trace
+      if ((Runtime::auto_trace_window > 0) && !issuing_auto_trace_op)
+        advance_auto_trace();
       // If we are performing a trace mark that the child has a trace
       if (current_trace != NULL)
         op->set_trace(current_trace, !current_trace->is_fixed(), dependences);
       unsigned result = total_children_count++;
+      if (window_upper_bound > 0)
+        op->record_issue_time(Realm::Clock::current_time_in_nanoseconds());
       unsigned outstanding_count = 
         __sync_add_and_fetch(&outstanding_children_count,1);
       // Only need to check if we are not tracing by frames
@@ -5032,8 +5066,9 @@ namespace Legion {
     unsigned InnerContext::register_new_close_operation(CloseOp *op)
     //--------------------------------------------------------------------------
     {
-      // For now we just bump our counter
-      unsigned result = total_close_count++;
+      // For now we just bump our counter, atomically since close
+      // operations can be made by analyses in different lanes
+      unsigned result = __sync_fetch_and_add(&total_close_count, 1);
       if (Runtime::legion_spy_enabled)
         LegionSpy::log_close_operation_index(get_context_uid(), result, 
                                              op->get_unique_op_id());
@@ -5054,6 +5089,7 @@ namespace Legion {
         window_wait = Runtime::create_rt_user_event();
         valid_wait_event = true;
         wait_event = window_wait;
+        window_stalled = true;
       }
       // Release our lock now
       context_lock.release();
@@ -5095,30 +5131,58 @@ namespace Legion {
       // Issue the next dependence analysis task
       DeferredDependenceArgs args;
       args.op = op;
+      // Operations whose analysis only touches the logical state of
+      // a few region trees only have to follow the previous analyses
+      // in those trees (and the last one that waited on everything)
+      std::set<RegionTreeID> trees;
+#ifndef LEGION_SPY
+      const bool use_lanes = Runtime::dependence_lanes &&
+                              op->find_dependence_trees(trees);
+#else
+      // Legion Spy validates against a serial analysis order
+      const bool use_lanes = false;
+#endif
+      std::set<RtEvent> preconditions;
+      if (op_precondition.exists())
+        preconditions.insert(op_precondition);
+      if (dependence_precondition.exists())
+        preconditions.insert(dependence_precondition);
+      if (use_lanes)
+      {
+        for (std::set<RegionTreeID>::const_iterator it = trees.begin();
+              it != trees.end(); it++)
+        {
+          std::map<RegionTreeID,RtEvent>::const_iterator finder = 
+            dependence_lanes.find(*it);
+          if ((finder != dependence_lanes.end()) && finder->second.exists())
+            preconditions.insert(finder->second);
+        }
+      }
+      else
+      {
+        for (std::map<RegionTreeID,RtEvent>::const_iterator it = 
+              dependence_lanes.begin(); it != dependence_lanes.end(); it++)
+          if (it->second.exists())
+            preconditions.insert(it->second);
+        dependence_lanes.clear();
+      }
       // If we're ahead we give extra priority to the logical analysis
       // since it is on the critical path, but if not we give it the 
       // normal priority so that we can balance doing logical analysis
       // and actually mapping and running tasks
-      if (op_precondition.exists())
+      RtEvent next = runtime->issue_runtime_meta_task(args,
+                                      currently_active_context ? 
+                                        LG_THROUGHPUT_PRIORITY :
+                                        LG_DEFERRED_THROUGHPUT_PRIORITY,
+                                      op, Runtime::merge_events(preconditions));
+      if (use_lanes)
       {
-        RtEvent pre = Runtime::merge_events(op_precondition, 
-                                            dependence_precondition);
-        RtEvent next = runtime->issue_runtime_meta_task(args,
-                                        currently_active_context ? 
-                                          LG_THROUGHPUT_PRIORITY :
-                                          LG_DEFERRED_THROUGHPUT_PRIORITY,
-                                        op, pre);
-        dependence_precondition = next;
+        for (std::set<RegionTreeID>::const_iterator it = trees.begin();
+              it != trees.end(); it++)
+          dependence_lanes[*it] = next;
       }
       else
-      {
-        RtEvent next = runtime->issue_runtime_meta_task(args,
-                                        currently_active_context ? 
-                                          LG_THROUGHPUT_PRIORITY :
-                                          LG_DEFERRED_THROUGHPUT_PRIORITY,
-                                        op, dependence_precondition);
         dependence_precondition = next;
-      }
       // Now we can release the lock
       context_lock.release();
     }
@@ -5149,6 +5213,8 @@ namespace Legion {
 #ifdef DEBUG_LEGION
         assert(outstanding_count >= 0);
 #endif
+        if (window_upper_bound > 0)
+          update_task_window(op);
         if (valid_wait_event && (context_configuration.max_window_size > 0) &&
             (outstanding_count <=
              int(context_configuration.hysteresis_percentage * 
@@ -5162,6 +5228,62 @@ namespace Legion {
         Runtime::trigger_event(to_trigger);
     }
 
+    //--------------------------------------------------------------------------
+    void InnerContext::update_task_window(Operation *op)
+    //--------------------------------------------------------------------------
+    {
+      // We should already be holding the context lock
+      const long long issued = op->get_issue_time();
+      const long long mapped = op->get_mapped_time();
+      if ((issued == 0) || (mapped < issued))
+        return;
+      const long long current = Realm::Clock::current_time_in_nanoseconds();
+      // Keep moving averages of how long children spend in the runtime
+      // before they are mapped and how long they then take to execute
+      const long long analysis = mapped - issued;
+      const long long execution = current - mapped;
+      if ((analysis_lag == 0) && (execution_lag == 0))
+      {
+        analysis_lag = analysis;
+        execution_lag = execution;
+      }
+      else
+      {
+        analysis_lag += (analysis - analysis_lag) / 8;
+        execution_lag += (execution - execution_lag) / 8;
+      }
+      const unsigned window = context_configuration.max_window_size;
+      // Only revisit the decision every quarter of a window
+      const unsigned period = (window < 64) ? 16 : (window / 4);
+      if (++window_samples < period)
+        return;
+      unsigned next = window;
+      if (analysis_lag > execution_lag)
+      {
+        // The analysis is falling behind, so running further ahead
+        // only makes children wait longer to be mapped
+        next = (window * 3) / 4;
+        if (next < window_lower_bound)
+          next = window_lower_bound;
+      }
+      else if (window_stalled && ((2 * analysis_lag) < execution_lag))
+      {
+        // The parent had to wait on the window while the analysis
+        // was keeping up, so there is room to expose more work
+        next = window + ((window < 4) ? 1 : (window / 4));
+        if (next > window_upper_bound)
+          next = window_upper_bound;
+      }
+      window_samples = 0;
+      window_stalled = false;
+      if (next == window)
+        return;
+      context_configuration.max_window_size = next;
+      if (runtime->profiler != NULL)
+        runtime->profiler->record_task_window(get_unique_id(), next,
+                                              analysis_lag, execution_lag);
+    }
+
     //--------------------------------------------------------------------------
     void InnerContext::register_child_complete(Operation *op)
     //--------------------------------------------------------------------------
@@ -5281,11 +5403,14 @@ namespace Legion {
     void InnerContext::register_fence_dependence(Operation *op)
     //--------------------------------------------------------------------------
     {
-      if (current_fence != NULL)
+      // Read the fence once since analyses in different lanes
+      // can prune it concurrently
+      FenceOp *fence = current_fence;
+      if (fence != NULL)
       {
 #ifdef LEGION_SPY
         // Can't prune when doing legion spy
-        op->register_dependence(current_fence, fence_gen);
+        op->register_dependence(fence, fence_gen);
         unsigned num_regions = op->get_region_count();
         if (num_regions > 0)
         {
@@ -5304,7 +5429,7 @@ namespace Legion {
         // If we can prune it then go ahead and do so
         // No need to remove the mapping reference because 
         // the fence has already been committed
-        if (op->register_dependence(current_fence, fence_gen))
+        if (op->register_dependence(fence, fence_gen))
           current_fence = NULL;
 #endif
       }
@@ -5423,6 +5548,8 @@ namespace Legion {
 #endif
       // No need to hold the lock here, this is only ever called
       // by the one thread that is running the task.
+      if ((current_trace != NULL) && (current_trace == auto_trace))
+        end_auto_trace();
       if (current_trace != NULL)
       {
         log_task.error("Illegal nested trace with ID %d attempted in "
@@ -5460,7 +5587,7 @@ namespace Legion {
       log_run.debug("Ending a trace in task %s (ID %lld)",
                     get_task_name(), get_unique_id());
 #endif
-      if (current_trace == NULL)
+      if ((current_trace == NULL) || (current_trace == auto_trace))
       {
         log_task.error("Unmatched end trace for ID %d in task %s "
                        "(ID %lld)", tid, get_task_name(),
@@ -5506,6 +5633,8 @@ namespace Legion {
 #endif
       // No need to hold the lock here, this is only ever called
       // by the one thread that is running the task.
+      if ((current_trace != NULL) && (current_trace == auto_trace))
+        end_auto_trace();
       if (current_trace != NULL)
       {
         log_task.error("Illegal nested static trace attempted in "
@@ -5558,6 +5687,242 @@ namespace Legion {
       current_trace = NULL;
     }
 
+    //--------------------------------------------------------------------------
+    /*static*/ void InnerContext::hash_requirements(uint64_t &hash,
+                                    const std::vector<RegionRequirement> &reqs)
+    //--------------------------------------------------------------------------
+    {
+      // FNV-1a over everything that the dependence analysis looks at
+#define HASH_AUTO_TRACE(value)                            \
+      hash = (hash ^ (uint64_t)(value)) * 1099511628211ULL
+      HASH_AUTO_TRACE(reqs.size());
+      for (std::vector<RegionRequirement>::const_iterator it = 
+            reqs.begin(); it != reqs.end(); it++)
+      {
+        HASH_AUTO_TRACE(it->handle_type);
+        if (it->handle_type == PART_PROJECTION)
+        {
+          HASH_AUTO_TRACE(it->partition.get_index_partition().get_id());
+          HASH_AUTO_TRACE(it->partition.get_field_space().get_id());
+          HASH_AUTO_TRACE(it->partition.get_tree_id());
+        }
+        else
+        {
+          HASH_AUTO_TRACE(it->region.get_index_space().get_id());
+          HASH_AUTO_TRACE(it->region.get_field_space().get_id());
+          HASH_AUTO_TRACE(it->region.get_tree_id());
+        }
+        HASH_AUTO_TRACE(it->parent.get_index_space().get_id());
+        HASH_AUTO_TRACE(it->parent.get_tree_id());
+        HASH_AUTO_TRACE(it->projection);
+        HASH_AUTO_TRACE(it->privilege);
+        HASH_AUTO_TRACE(it->prop);
+        HASH_AUTO_TRACE(it->redop);
+        HASH_AUTO_TRACE(it->flags);
+        HASH_AUTO_TRACE(it->privilege_fields.size());
+        for (std::set<FieldID>::const_iterator fit = 
+              it->privilege_fields.begin(); fit != 
+              it->privilege_fields.end(); fit++)
+          HASH_AUTO_TRACE(*fit);
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    void InnerContext::record_auto_trace_launch(const TaskLauncher &launcher)
+    //--------------------------------------------------------------------------
+    {
+      uint64_t hash = 14695981039346656037ULL;
+      HASH_AUTO_TRACE(Operation::TASK_OP_KIND);
+      HASH_AUTO_TRACE(launcher.task_id);
+      hash_requirements(hash, launcher.region_requirements);
+      auto_trace_pending = hash;
+      has_auto_trace_pending = true;
+    }
+
+    //--------------------------------------------------------------------------
+    void InnerContext::record_auto_trace_launch(
+                                              const IndexTaskLauncher &launcher)
+    //--------------------------------------------------------------------------
+    {
+      uint64_t hash = 14695981039346656037ULL;
+      HASH_AUTO_TRACE(Operation::TASK_OP_KIND);
+      HASH_AUTO_TRACE(launcher.task_id);
+      const Domain &domain = launcher.launch_domain;
+      HASH_AUTO_TRACE(domain.is_id);
+      HASH_AUTO_TRACE(domain.dim);
+      for (int idx = 0; idx < (2 * domain.dim); idx++)
+        HASH_AUTO_TRACE(domain.rect_data[idx]);
+      hash_requirements(hash, launcher.region_requirements);
+#undef HASH_AUTO_TRACE
+      auto_trace_pending = hash;
+      has_auto_trace_pending = true;
+    }
+
+    //--------------------------------------------------------------------------
+    void InnerContext::advance_auto_trace(void)
+    //--------------------------------------------------------------------------
+    {
+      // Only task launches record a hash before they are registered,
+      // every other kind of operation breaks any window of launches
+      const bool has_hash = has_auto_trace_pending;
+      const uint64_t hash = auto_trace_pending;
+      has_auto_trace_pending = false;
+      // Stay out of the way of any traces the user asked for
+      if ((current_trace != NULL) && (current_trace != auto_trace))
+        return;
+      if (current_trace != NULL)
+      {
+        // Keep going as long as we match the window we are tracing
+        if (has_hash && (auto_trace_index < auto_trace_window.size()) &&
+            (auto_trace_window[auto_trace_index] == hash))
+        {
+          auto_trace_index++;
+          auto_trace_history.push_back(hash);
+          if (auto_trace_history.size() > (2 * Runtime::auto_trace_window))
+            auto_trace_history.pop_front();
+          return;
+        }
+        const bool complete = (auto_trace_index == auto_trace_window.size());
+        const bool captured = auto_trace->is_fixed();
+        end_auto_trace();
+        if (complete)
+        {
+          if (captured)
+            auto_trace_hits++;
+        }
+        else
+        {
+          auto_trace_misses++;
+          // A window that did not repeat while we were capturing it
+          // has a trace that is too short to be replayed again
+          if (!captured)
+            discard_auto_trace();
+        }
+      }
+      if (!has_hash)
+      {
+        auto_trace_history.clear();
+        return;
+      }
+      auto_trace_history.push_back(hash);
+      if (auto_trace_history.size() > (2 * Runtime::auto_trace_window))
+        auto_trace_history.pop_front();
+      // See if this launch starts another copy of the window
+      if (!auto_trace_window.empty() && (auto_trace_window[0] == hash))
+      {
+        begin_auto_trace();
+        auto_trace_index = 1;
+        return;
+      }
+      // Otherwise see if the recent launches have started to repeat
+      // and if they have then start tracing with the next launch
+      detect_auto_trace_window();
+    }
+
+    //--------------------------------------------------------------------------
+    void InnerContext::detect_auto_trace_window(void)
+    //--------------------------------------------------------------------------
+    {
+      const size_t total = auto_trace_history.size();
+      const uint64_t last = auto_trace_history.back();
+      // Find the shortest period that the last launches repeat with, only
+      // checking the periods that end in a copy of the last launch
+      for (size_t period = 1; (2 * period) <= total; period++)
+      {
+        if (auto_trace_history[total - 1 - period] != last)
+          continue;
+        bool repeated = true;
+        for (size_t idx = 1; idx < period; idx++)
+        {
+          if (auto_trace_history[total - 1 - idx] != 
+              auto_trace_history[total - 1 - period - idx])
+          {
+            repeated = false;
+            break;
+          }
+        }
+        if (!repeated)
+          continue;
+        // Trace as many copies of the period as fit in the window
+        // so that we don't pay for the trace fences on every copy
+        std::vector<uint64_t> window;
+        const size_t copies = Runtime::auto_trace_window / period;
+        window.reserve(copies * period);
+        for (size_t copy = 0; copy < copies; copy++)
+          for (size_t idx = 0; idx < period; idx++)
+            window.push_back(auto_trace_history[total - period + idx]);
+        if (window == auto_trace_window)
+          return;
+        discard_auto_trace();
+        auto_trace_window.swap(window);
+        auto_traces_detected++;
+        return;
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    void InnerContext::begin_auto_trace(void)
+    //--------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(current_trace == NULL);
+#endif
+      if (auto_trace == NULL)
+      {
+        auto_trace = new DynamicTrace(auto_traces_detected, this);
+        auto_trace->add_reference();
+      }
+      else
+      {
+        // Same as replaying a user trace, start with a mapping fence
+        issuing_auto_trace_op = true;
+        runtime->issue_mapping_fence(this);
+        issuing_auto_trace_op = false;
+      }
+      current_trace = auto_trace;
+    }
+
+    //--------------------------------------------------------------------------
+    void InnerContext::end_auto_trace(void)
+    //--------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(current_trace == auto_trace);
+#endif
+      issuing_auto_trace_op = true;
+      if (auto_trace->is_fixed())
+      {
+        TraceCompleteOp *complete_op = runtime->get_available_trace_op(true);
+        complete_op->initialize_complete(this);
+        runtime->add_to_dependence_queue(this, executing_processor, complete_op);
+      }
+      else
+      {
+        TraceCaptureOp *capture_op = runtime->get_available_capture_op(true); 
+        capture_op->initialize_capture(this);
+        runtime->add_to_dependence_queue(this, executing_processor, capture_op);
+        auto_trace->fix_trace();
+      }
+      issuing_auto_trace_op = false;
+      current_trace = NULL;
+    }
+
+    //--------------------------------------------------------------------------
+    void InnerContext::discard_auto_trace(void)
+    //--------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert((current_trace == NULL) || (current_trace != auto_trace));
+#endif
+      auto_trace_window.clear();
+      if (auto_trace == NULL)
+        return;
+      // Any operations still using the trace hold their own references
+      if (auto_trace->remove_reference())
+        delete auto_trace;
+      auto_trace = NULL;
+    }
+
     //--------------------------------------------------------------------------
     void InnerContext::issue_frame(FrameOp *frame, ApEvent frame_termination)
     //--------------------------------------------------------------------------
@@ -5995,6 +6360,16 @@ namespace Legion {
       if (context_configuration.min_frames_to_schedule > 0)
         context_configuration.min_tasks_to_schedule = 0;
       // otherwise we know min_frames_to_schedule is zero
+      else if (Runtime::adaptive_task_window && 
+               (context_configuration.max_window_size > 0))
+      {
+        // Let the window move within a range around what was asked for
+        const unsigned window = context_configuration.max_window_size;
+        window_lower_bound = window / DEFAULT_TASK_WINDOW_ADAPT_RANGE;
+        if (window_lower_bound == 0)
+          window_lower_bound = 1;
+        window_upper_bound = window * DEFAULT_TASK_WINDOW_ADAPT_RANGE;
+      }
     }
 
     //--------------------------------------------------------------------------
@@ -6150,6 +6525,7 @@ namespace Legion {
           // If this is a remote only then we don't need to invalidate it
           if (!it->second.second)
             it->first->invalidate_version_state(tree_context.get_id()); 
+          it->first->remove_tree_reference();
         }
         region_tree_owners.clear();
       }
@@ -6157,6 +6533,40 @@ namespace Legion {
       runtime->free_region_tree_context(tree_context);
     }
 
+    //--------------------------------------------------------------------------
+    void InnerContext::invalidate_region_tree_owners(RegionTreeID tid)
+    //--------------------------------------------------------------------------
+    {
+      std::vector<std::pair<RegionTreeNode*,bool> > to_invalidate;
+      {
+        AutoLock ctx_lock(context_lock);
+        std::map<RegionTreeNode*,
+                 std::pair<AddressSpaceID,bool> >::iterator it = 
+          region_tree_owners.begin();
+        while (it != region_tree_owners.end())
+        {
+          if (it->first->get_tree_id() != tid)
+          {
+            it++;
+            continue;
+          }
+          to_invalidate.push_back(
+              std::pair<RegionTreeNode*,bool>(it->first, it->second.second));
+          std::map<RegionTreeNode*,
+                   std::pair<AddressSpaceID,bool> >::iterator to_delete = it++;
+          region_tree_owners.erase(to_delete);
+        }
+      }
+      for (std::vector<std::pair<RegionTreeNode*,bool> >::const_iterator it =
+            to_invalidate.begin(); it != to_invalidate.end(); it++)
+      {
+        // If this is a remote only then we don't need to invalidate it
+        if (!it->second)
+          it->first->invalidate_version_state(tree_context.get_id());
+        it->first->remove_tree_reference();
+      }
+    }
+
     //--------------------------------------------------------------------------
     InstanceView* InnerContext::create_instance_top_view(
                         PhysicalManager *manager, AddressSpaceID request_source,
@@ -6440,6 +6850,14 @@ namespace Legion {
           }
         }
       }
+      // Close out any automatic trace that is still open
+      if ((current_trace != NULL) && (current_trace == auto_trace))
+        end_auto_trace();
+      if (auto_traces_detected > 0)
+        log_run.print("Automatic tracing in task %s (UID %lld) detected %d "
+                      "repeated windows with %d replays and %d misses",
+                      get_task_name(), get_unique_id(), auto_traces_detected,
+                      auto_trace_hits, auto_trace_misses);
       // Quick check to make sure the user didn't forget to end a trace
       if (current_trace != NULL)
       {
@@ -6696,6 +7114,7 @@ namespace Legion {
 #endif
         region_tree_owners[node] = 
           std::pair<AddressSpaceID,bool>(result, false/*remote only*/); 
+        node->add_tree_reference();
         // Find the event to trigger
         std::map<RegionTreeNode*,RtUserEvent>::iterator finder = 
           pending_version_owner_requests.find(node);
@@ -7052,6 +7471,8 @@ namespace Legion {
     RemoteTask::~RemoteTask(void)
     //--------------------------------------------------------------------------
     {
+      if ((arg_manager != NULL) && arg_manager->remove_reference())
+        delete (arg_manager);
     }
 
     //--------------------------------------------------------------------------
@@ -8843,6 +9264,13 @@ namespace Legion {
       // Nothing to do
     }
 
+    //--------------------------------------------------------------------------
+    void LeafContext::invalidate_region_tree_owners(RegionTreeID tid)
+    //--------------------------------------------------------------------------
+    {
+      // Nothing to do
+    }
+
     //--------------------------------------------------------------------------
     void LeafContext::send_back_created_state(AddressSpaceID target)
     //--------------------------------------------------------------------------
@@ -9991,6 +10419,13 @@ namespace Legion {
       assert(false);
     }
 
+    //--------------------------------------------------------------------------
+    void InlineContext::invalidate_region_tree_owners(RegionTreeID tid)
+    //--------------------------------------------------------------------------
+    {
+      enclosing->invalidate_region_tree_owners(tid);
+    }
+
     //--------------------------------------------------------------------------
     void InlineContext::send_back_created_state(AddressSpaceID target)
     //--------------------------------------------------------------------------
@@ -338,6 +338,8 @@ namespace Legion {
           std::set<ApEvent> &preconditions,
           std::set<RtEvent> &applied_events) = 0;
       virtual void invalidate_region_tree_contexts(void) = 0;
+      // Release any state held for a region tree that has been destroyed
+      virtual void invalidate_region_tree_owners(RegionTreeID tid) = 0;
       virtual void send_back_created_state(AddressSpaceID target) = 0;
     public:
       virtual InstanceView* create_instance_top_view(PhysicalManager *manager,
@@ -650,6 +652,7 @@ namespace Legion {
     public:
       void print_children(void);
       void perform_window_wait(void);
+      void update_task_window(Operation *op);
     public:
       // Interface for task contexts
       virtual RegionTreeContext get_context(void) const;
@@ -913,6 +916,7 @@ namespace Legion {
           std::set<ApEvent> &preconditions,
           std::set<RtEvent> &applied_events);
       virtual void invalidate_region_tree_contexts(void);
+      virtual void invalidate_region_tree_owners(RegionTreeID tid);
       virtual void send_back_created_state(AddressSpaceID target);
     public:
       virtual InstanceView* create_instance_top_view(PhysicalManager *manager,
@@ -958,6 +962,17 @@ namespace Legion {
     public:
       void clone_local_fields(
           std::map<FieldSpace,std::vector<LocalFieldInfo> > &child_local) const;
+    protected:
+      // Automatic tracing of repeated task launches
+      void record_auto_trace_launch(const TaskLauncher &launcher);
+      void record_auto_trace_launch(const IndexTaskLauncher &launcher);
+      void advance_auto_trace(void);
+      void detect_auto_trace_window(void);
+      void begin_auto_trace(void);
+      void end_auto_trace(void);
+      void discard_auto_trace(void);
+      static void hash_requirements(uint64_t &hash,
+                              const std::vector<RegionRequirement> &reqs);
     public:
       const RegionTreeContext tree_context; 
       const UniqueID context_uid;
@@ -986,13 +1001,36 @@ namespace Legion {
       // Traces for this task's execution
       LegionMap<TraceID,DynamicTrace*,TASK_TRACES_ALLOC>::tracked traces;
       LegionTrace *current_trace;
+    protected:
+      // State for finding repeated windows of task launches and
+      // tracing them automatically (see -lg:auto_trace)
+      std::deque<uint64_t> auto_trace_history;
+      std::vector<uint64_t> auto_trace_window;
+      DynamicTrace *auto_trace;
+      unsigned auto_trace_index;
+      uint64_t auto_trace_pending;
+      bool has_auto_trace_pending;
+      bool issuing_auto_trace_op;
+      unsigned auto_traces_detected;
+      unsigned auto_trace_hits;
+      unsigned auto_trace_misses;
+    protected:
       // Event for waiting when the number of mapping+executing
       // child operations has grown too large.
       bool valid_wait_event;
       RtUserEvent window_wait;
+      // Bounds and measurements for resizing the window of outstanding
+      // child operations at runtime (see -lg:adaptive_window)
+      unsigned window_lower_bound, window_upper_bound;
+      long long analysis_lag, execution_lag;
+      unsigned window_samples;
+      bool window_stalled;
       std::deque<ApEvent> frame_events;
       RtEvent last_registration;
       RtEvent dependence_precondition;
+      // With -lg:lanes, the last dependence analysis in each region
+      // tree since the most recent one that had to wait for everything
+      std::map<RegionTreeID,RtEvent> dependence_lanes;
     protected:
       // Number of sub-tasks ready to map
       unsigned outstanding_subtasks;
@@ -1412,6 +1450,7 @@ namespace Legion {
           std::set<ApEvent> &preconditions,
           std::set<RtEvent> &applied_events);
       virtual void invalidate_region_tree_contexts(void);
+      virtual void invalidate_region_tree_owners(RegionTreeID tid);
       virtual void send_back_created_state(AddressSpaceID target);
     public:
       virtual InstanceView* create_instance_top_view(PhysicalManager *manager,
@@ -1712,6 +1751,7 @@ namespace Legion {
           std::set<ApEvent> &preconditions,
           std::set<RtEvent> &applied_events);
       virtual void invalidate_region_tree_contexts(void);
+      virtual void invalidate_region_tree_owners(RegionTreeID tid);
       virtual void send_back_created_state(AddressSpaceID target);
     public:
       virtual InstanceView* create_instance_top_view(PhysicalManager *manager,
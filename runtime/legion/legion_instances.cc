@@ -503,7 +503,10 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       if (region_node != NULL)
+      {
         region_node->register_physical_manager(this);
+        region_node->add_tree_reference();
+      }
       // Add a reference to the layout
       if (layout != NULL)
         layout->add_reference();
@@ -515,8 +518,6 @@ namespace Legion {
     {
       if (is_owner() && registered_with_runtime)
         unregister_with_runtime(MANAGER_VIRTUAL_CHANNEL);
-      if (region_node != NULL)
-        region_node->unregister_physical_manager(this);
       // Remote references removed by DistributedCollectable destructor
       if (!is_owner())
         memory_manager->unregister_remote_instance(this);
@@ -528,6 +529,12 @@ namespace Legion {
       }
       if ((layout != NULL) && layout->remove_reference())
         delete layout;
+      // Do this last since it might reclaim the region tree
+      if (region_node != NULL)
+      {
+        region_node->unregister_physical_manager(this);
+        region_node->remove_tree_reference();
+      }
     }
 
     //--------------------------------------------------------------------------
@@ -946,7 +953,7 @@ namespace Legion {
       layout->compute_destroyed_fields(serdez_fields); 
       if (!serdez_fields.empty())
         instance.destroy(serdez_fields, deferred_event);
-      else
+      else if (!memory_manager->recycle_instance(instance, deferred_event))
         instance.destroy(deferred_event);
 #endif
       // Notify any contexts of our deletion
@@ -2035,9 +2042,22 @@ namespace Legion {
       ApEvent ready = forest->create_instance(instance_domain, 
                   memory_manager->memory, field_sizes, instance, constraints);
 #else
-      PhysicalInstance instance = forest->create_instance(instance_domain,
+      // See if we can recycle a collected instance of the same shape
+      // before asking Realm for a new one, skipping instances whose 
+      // index space we own since it is destroyed along with them
+      PhysicalInstance instance = own_domain ? PhysicalInstance::NO_INST :
+        memory_manager->find_pooled_instance(instance_domain, sizes_only,
+                                             block_size, redop_id);
+      if (!instance.exists())
+      {
+        instance = forest->create_instance(instance_domain,
                                        memory_manager->memory, sizes_only, 
                                        block_size, redop_id, creator_id);
+        if (instance.exists() && !own_domain)
+          memory_manager->record_pool_candidate(instance, instance_domain,
+                sizes_only, block_size, redop_id, 
+                compute_needed_size(forest));
+      }
       ApEvent ready = ApEvent::NO_AP_EVENT;
 #endif
       // If we couldn't make it then we are done
@@ -2047,6 +2067,9 @@ namespace Legion {
       DistributedID did = forest->runtime->get_available_distributed_id(false);
       AddressSpaceID local_space = forest->runtime->address_space;
       FieldSpaceNode *field_node = ancestor->column_source;
+      if (forest->runtime->profiler != NULL)
+        forest->runtime->profiler->record_instance_fields(instance, creator_id,
+                                              field_node->handle, field_sizes);
       // Important implementation detail here: we pull the pointer constraint
       // out of the set of constraints here and don't include it in the layout
       // constraints so we can abstract over lots of different layouts. We'll
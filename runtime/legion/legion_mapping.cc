@@ -283,6 +283,16 @@ namespace Legion {
     {
     }
 
+    //--------------------------------------------------------------------------
+    void Mapper::map_task_batch(const MapperContext ctx,
+                                const MapTaskBatchInput &input,
+                                      MapTaskBatchOutput &output)
+    //--------------------------------------------------------------------------
+    {
+      // By default we don't map anything here and let the runtime
+      // call map_task for each of the tasks
+    }
+
     /////////////////////////////////////////////////////////////
     // MapperRuntime
     /////////////////////////////////////////////////////////////
@@ -405,6 +415,14 @@ namespace Legion {
       ctx->manager->wait_on_mapper_event(ctx, event);
     }
 
+    //--------------------------------------------------------------------------
+    void MapperRuntime::get_speculation_statistics(MapperContext ctx,
+                             unsigned &correct, unsigned &misspeculated) const
+    //--------------------------------------------------------------------------
+    {
+      ctx->manager->get_speculation_statistics(ctx, correct, misspeculated);
+    }
+
     //--------------------------------------------------------------------------
     const ExecutionConstraintSet& MapperRuntime::find_execution_constraints(
                          MapperContext ctx, TaskID task_id, VariantID vid) const
@@ -680,6 +698,67 @@ namespace Legion {
       ctx->manager->release_instances(ctx, instances);
     }
 
+    //--------------------------------------------------------------------------
+    void MapperRuntime::get_memory_usage(MapperContext ctx, 
+                                         Memory target_memory,
+                                         size_t &current_bytes,
+                                         size_t &peak_bytes) const
+    //--------------------------------------------------------------------------
+    {
+      ctx->manager->get_memory_usage(ctx, target_memory, 
+                                     current_bytes, peak_bytes);
+    }
+
+    //--------------------------------------------------------------------------
+    void MapperRuntime::get_task_memory_usage(MapperContext ctx,
+                                              Memory target_memory,
+                                              TaskID task_id,
+                                              size_t &current_bytes,
+                                              size_t &peak_bytes) const
+    //--------------------------------------------------------------------------
+    {
+      ctx->manager->get_task_memory_usage(ctx, target_memory, task_id,
+                                          current_bytes, peak_bytes);
+    }
+
+    //--------------------------------------------------------------------------
+    void MapperRuntime::set_instance_pool_limit(MapperContext ctx,
+                                                Memory target_memory,
+                                                size_t max_bytes) const
+    //--------------------------------------------------------------------------
+    {
+      ctx->manager->set_instance_pool_limit(ctx, target_memory, max_bytes);
+    }
+
+    //--------------------------------------------------------------------------
+    void MapperRuntime::set_eviction_policy(MapperContext ctx,
+                                            Memory target_memory,
+                                            EvictionPolicy policy) const
+    //--------------------------------------------------------------------------
+    {
+      ctx->manager->set_eviction_policy(ctx, target_memory, policy);
+    }
+
+    //--------------------------------------------------------------------------
+    bool MapperRuntime::is_memory_under_pressure(MapperContext ctx,
+                                                 Memory target_memory) const
+    //--------------------------------------------------------------------------
+    {
+      return ctx->manager->is_memory_under_pressure(ctx, target_memory);
+    }
+
+    //--------------------------------------------------------------------------
+    void MapperRuntime::prefetch_instance(MapperContext ctx, 
+                                    Memory target_memory,
+                                    const LayoutConstraintSet &constraints,
+                                    const std::vector<LogicalRegion> &regions,
+                                    GCPriority priority) const
+    //--------------------------------------------------------------------------
+    {
+      ctx->manager->prefetch_instance(ctx, target_memory, constraints, 
+                                      regions, priority);
+    }
+
     //--------------------------------------------------------------------------
     IndexPartition MapperRuntime::get_index_partition(MapperContext ctx,
                                            IndexSpace parent, Color color) const
@@ -459,10 +459,19 @@ namespace Legion {
        * also ask for profiling information for the copies generated
        * as part of the mapping of the task through the 
        * 'copy_prof_requests' field.
+       *
+       * The 'traced' flag tells the mapper whether the task was launched
+       * inside a dynamic trace. If it is, the mapper can set the
+       * 'memoize' flag to allow the runtime to reuse this mapping when
+       * the trace is replayed. On a replay the runtime will skip calling
+       * map_task for the same task in the trace as long as it is mapping
+       * the same regions and all the chosen instances can still be
+       * acquired, and will call map_task again otherwise.
        */
       struct MapTaskInput {
         std::vector<std::vector<PhysicalInstance> >     valid_instances;
         std::vector<unsigned>                           premapped_regions;
+        bool                                            traced; // = false
       };
       struct MapTaskOutput {
         std::vector<std::vector<PhysicalInstance> >     chosen_instances; 
@@ -472,6 +481,7 @@ namespace Legion {
         ProfilingRequest                                copy_prof_requests;
         TaskPriority                                    task_priority;  // = 0
         bool                                            postmap_task; // = false
+        bool                                            memoize; // = false
       };
       //------------------------------------------------------------------------
       virtual void map_task(const MapperContext      ctx,
@@ -1297,6 +1307,8 @@ namespace Legion {
        * by doing nothing. Note that if the mapper continues to leave
        * tasks on the ready queue after repeated invocations of the 
        * 'select_tasks_to_map' mapper call, it may appear like livelock.
+       * Setting 'batch_map_tasks' asks the runtime to hand the selected
+       * tasks back to the mapper in a single 'map_task_batch' call.
        */
       struct SelectMappingInput {
         std::list<const Task*>                  ready_tasks;
@@ -1304,12 +1316,46 @@ namespace Legion {
       struct SelectMappingOutput {
         std::set<const Task*>                   map_tasks;
         std::map<const Task*,Processor>         relocate_tasks;
+        bool                                    batch_map_tasks; // = false
       };
       //------------------------------------------------------------------------
       virtual void select_tasks_to_map(const MapperContext          ctx,
                                        const SelectMappingInput&    input,
                                              SelectMappingOutput&   output) = 0;
       //------------------------------------------------------------------------
+
+      /**
+       * ----------------------------------------------------------------------
+       *  Map Task Batch
+       * ----------------------------------------------------------------------
+       * If the mapper set 'batch_map_tasks' in 'select_tasks_to_map', the
+       * runtime will immediately invoke this call with the individual
+       * tasks from 'map_tasks' that are going to be mapped on this
+       * processor in 'tasks'. The mapper can pick the mapping for any
+       * of them by adding an entry to 'task_mappings', filled in
+       * exactly as it would fill in the output of 'map_task'. Instances
+       * acquired during this call stay acquired until the task maps.
+       * When the task reaches its mapping stage the runtime will use
+       * the batched mapping in place of calling 'map_task' as long
+       * as all the chosen instances can still be acquired, and will
+       * call 'map_task' otherwise. Since the runtime has not yet
+       * computed the valid instances of the tasks when this call is
+       * made, any premapped regions keep their premapped instances.
+       * Tasks without an entry in 'task_mappings' are mapped with
+       * 'map_task' as usual, which is all the default implementation
+       * of this call does.
+       */
+      struct MapTaskBatchInput {
+        std::vector<const Task*>                tasks;
+      };
+      struct MapTaskBatchOutput {
+        std::map<const Task*,MapTaskOutput>     task_mappings;
+      };
+      //------------------------------------------------------------------------
+      virtual void map_task_batch(const MapperContext          ctx,
+                                  const MapTaskBatchInput&     input,
+                                        MapTaskBatchOutput&    output);
+      //------------------------------------------------------------------------
     public: // Stealing
       /**
        * ----------------------------------------------------------------------
@@ -1485,6 +1531,12 @@ namespace Legion {
                                           MapperEvent event) const;
       void wait_on_mapper_event(MapperContext ctx,
                                           MapperEvent event) const;
+    public:
+      //------------------------------------------------------------------------
+      // Methods for learning how past speculation by this mapper turned out
+      //------------------------------------------------------------------------
+      void get_speculation_statistics(MapperContext ctx, unsigned &correct,
+                                      unsigned &misspeculated) const;
     public:
       //------------------------------------------------------------------------
       // Methods for managing constraint information
@@ -1604,6 +1656,58 @@ namespace Legion {
                           const std::vector<PhysicalInstance> &instances) const;
       void release_instances(MapperContext ctx,
             const std::vector<std::vector<PhysicalInstance> > &instances) const;
+    public:
+      //------------------------------------------------------------------------
+      // Memory usage of the instances created by this mapper, or on 
+      // behalf of a task kind, in a memory: the bytes currently allocated
+      // and the high-water mark. The counts are maintained by the node that
+      // owns the memory, so queries for remote memories report zero.
+      //------------------------------------------------------------------------
+      void get_memory_usage(MapperContext ctx, Memory target_memory,
+                            size_t &current_bytes, size_t &peak_bytes) const;
+      void get_task_memory_usage(MapperContext ctx, Memory target_memory,
+                                 TaskID task_id, size_t &current_bytes,
+                                 size_t &peak_bytes) const;
+    public:
+      //------------------------------------------------------------------------
+      // Bound the bytes of collected instances that a memory keeps around
+      // to satisfy later requests for instances of exactly the same shape
+      // without going back to Realm. The default of zero disables the
+      // pool. The pool lives on the node owning the memory so this must
+      // be called by a mapper on that node.
+      //------------------------------------------------------------------------
+      void set_instance_pool_limit(MapperContext ctx, Memory target_memory,
+                                   size_t max_bytes) const;
+    public:
+      //------------------------------------------------------------------------
+      // Pick the order in which a memory collects instances when it runs
+      // out of space. GC priorities set by mappers always come first, then
+      // the policy: best fit by size (the default), least recently used,
+      // least frequently used, or ARC, which adapts between the two.
+      // Like the pool limit this must be called on the owner node. A
+      // memory is under pressure once it has had to collect instances
+      // to make space or is nearly full, which lets mappers move new
+      // instances elsewhere before allocations start failing. Remote
+      // memories never report being under pressure.
+      //------------------------------------------------------------------------
+      void set_eviction_policy(MapperContext ctx, Memory target_memory,
+                               EvictionPolicy policy) const;
+      bool is_memory_under_pressure(MapperContext ctx, 
+                                    Memory target_memory) const;
+    public:
+      //------------------------------------------------------------------------
+      // Ask the runtime to find or make an instance with the given 
+      // constraints in the background, so a later call to 
+      // find_or_create_physical_instance with the same arguments finds
+      // it without waiting on the allocation. The instance is not 
+      // acquired and can be collected like any other. Its contents are
+      // only made valid once an operation maps onto it, at which point
+      // it is treated like any other valid instance.
+      //------------------------------------------------------------------------
+      void prefetch_instance(MapperContext ctx, Memory target_memory,
+                             const LayoutConstraintSet &constraints,
+                             const std::vector<LogicalRegion> &regions,
+                             GCPriority priority = 0) const;
     public:
       //------------------------------------------------------------------------
       // Methods for introspecting index space trees 
@@ -93,6 +93,9 @@ namespace Legion {
         commit_event = Runtime::create_rt_user_event(); 
       trace = NULL;
       tracing = false;
+      trace_local_id = 0;
+      issue_time = 0;
+      mapped_time = 0;
       must_epoch = NULL;
 #ifdef DEBUG_LEGION
       assert(mapped_event.exists());
@@ -139,6 +142,13 @@ namespace Legion {
       return 0;
     }
 
+    //--------------------------------------------------------------------------
+    bool Operation::find_dependence_trees(std::set<RegionTreeID> &trees) const
+    //--------------------------------------------------------------------------
+    {
+      return false;
+    }
+
     //--------------------------------------------------------------------------
     Mappable* Operation::get_mappable(void)
     //--------------------------------------------------------------------------
@@ -686,6 +696,8 @@ namespace Legion {
         mapped = true;
       }
 #endif
+      if (Runtime::adaptive_task_window && (issue_time > 0))
+        mapped_time = Realm::Clock::current_time_in_nanoseconds();
       Runtime::trigger_event(mapped_event, wait_on);
     }
 
@@ -1056,6 +1068,34 @@ namespace Legion {
       return prune;
     }
 
+    //--------------------------------------------------------------------------
+    void Operation::register_replay_dependence(Operation *target,
+                                GenerationID target_gen, int validated_idx)
+    //--------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(!tracing);
+      assert(must_epoch == NULL);
+#endif
+      // The target finished and was recycled for us
+      if (target == this)
+        return;
+      bool registered_dependence = false;
+      AutoLock o_lock(op_lock);
+#ifdef DEBUG_LEGION
+      assert(dependence_tracker.mapping != NULL);
+#endif
+      target->perform_registration(target_gen, this, gen,
+                                   registered_dependence,
+                                   dependence_tracker.mapping, commit_event);
+      if (registered_dependence)
+      {
+        incoming[target] = target_gen;
+        if (validated_idx >= 0)
+          verify_regions[target].insert(validated_idx);
+      }
+    }
+
     //--------------------------------------------------------------------------
     bool Operation::perform_registration(GenerationID our_gen, 
                                          Operation *op, GenerationID op_gen,
@@ -1824,6 +1864,7 @@ namespace Legion {
       predicate = NULL;
       speculate_mapping_only = false;
       received_trigger_resolution = false;
+      speculation_mapper = NULL;
       predicate_waiter = RtUserEvent::NO_RT_USER_EVENT;
     }
 
@@ -2097,6 +2138,7 @@ namespace Legion {
       bool continue_false = false;
       bool need_trigger = false;
       bool need_resolve = false;
+      bool speculated_correctly = false;
       {
         AutoLock o_lock(op_lock);
 #ifdef DEBUG_LEGION
@@ -2116,6 +2158,7 @@ namespace Legion {
             }
           case SPECULATE_TRUE_STATE:
             {
+              speculated_correctly = value;
               if (value) // We guessed right
               {
                 speculation_state = RESOLVE_TRUE_STATE;
@@ -2131,6 +2174,7 @@ namespace Legion {
             }
           case SPECULATE_FALSE_STATE:
             {
+              speculated_correctly = !value;
               if (value)
               {
                 speculation_state = RESOLVE_TRUE_STATE;
@@ -2149,6 +2193,10 @@ namespace Legion {
       }
       if (need_trigger)
         Runtime::trigger_event(predicate_waiter);
+      // Let the mapper know how its guess turned out before
+      // resolving since that can end up recycling this operation
+      if ((continue_true || continue_false) && (speculation_mapper != NULL))
+        speculation_mapper->record_speculation(speculated_correctly);
       if (continue_true)
         resolve_true(true/*speculated*/, true/*launched*/);
       else if (continue_false)
@@ -2310,6 +2358,16 @@ namespace Legion {
       return 1;
     }
 
+    //--------------------------------------------------------------------------
+    bool MapOp::find_dependence_trees(std::set<RegionTreeID> &trees) const
+    //--------------------------------------------------------------------------
+    {
+      if ((trace != NULL) || (must_epoch != NULL))
+        return false;
+      trees.insert(requirement.parent.get_tree_id());
+      return true;
+    }
+
     //--------------------------------------------------------------------------
     Mappable* MapOp::get_mappable(void)
     //--------------------------------------------------------------------------
@@ -3534,6 +3592,19 @@ namespace Legion {
       return src_requirements.size() + dst_requirements.size();
     }
 
+    //--------------------------------------------------------------------------
+    bool CopyOp::find_dependence_trees(std::set<RegionTreeID> &trees) const
+    //--------------------------------------------------------------------------
+    {
+      if ((trace != NULL) || (must_epoch != NULL) || is_predicated_op())
+        return false;
+      for (unsigned idx = 0; idx < src_requirements.size(); idx++)
+        trees.insert(src_requirements[idx].parent.get_tree_id());
+      for (unsigned idx = 0; idx < dst_requirements.size(); idx++)
+        trees.insert(dst_requirements[idx].parent.get_tree_id());
+      return true;
+    }
+
     //--------------------------------------------------------------------------
     Mappable* CopyOp::get_mappable(void)
     //--------------------------------------------------------------------------
@@ -3653,6 +3724,7 @@ namespace Legion {
         return false;
       value = output.speculative_value;
       mapping_only = output.speculate_mapping_only;
+      speculation_mapper = mapper;
       // Make our predicate guard
 #ifdef DEBUG_LEGION
       assert(!predication_guard.exists());
@@ -8261,6 +8333,7 @@ namespace Legion {
       {
         value = output.speculative_value;
         mapping_only = output.speculate_mapping_only;
+        speculation_mapper = mapper;
         return true;
       }
       return false;
@@ -8900,6 +8973,7 @@ namespace Legion {
       {
         value = output.speculative_value;
         mapping_only = output.speculate_mapping_only;
+        speculation_mapper = mapper;
         return true;
       }
       return false;
@@ -12089,6 +12163,17 @@ namespace Legion {
       return 1;
     }
 
+    //--------------------------------------------------------------------------
+    bool FillOp::find_dependence_trees(std::set<RegionTreeID> &trees) const
+    //--------------------------------------------------------------------------
+    {
+      if ((trace != NULL) || (must_epoch != NULL) || is_predicated_op() ||
+          (future.impl != NULL))
+        return false;
+      trees.insert(requirement.parent.get_tree_id());
+      return true;
+    }
+
     //--------------------------------------------------------------------------
     Mappable* FillOp::get_mappable(void)
     //--------------------------------------------------------------------------
@@ -13405,7 +13490,7 @@ namespace Legion {
       file_instance = runtime->forest->create_file_instance(this, requirement);
       file_instance->memory_manager->record_created_instance(
           file_instance, false, 0, parent_ctx->get_executing_processor(),
-          GC_NEVER_PRIORITY, false);
+          GC_NEVER_PRIORITY, 0/*no task*/, false);
       parent_ctx->add_restriction(this, file_instance, requirement);
     }
 
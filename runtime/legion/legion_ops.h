@@ -202,6 +202,10 @@ namespace Legion {
       virtual OpKind get_operation_kind(void) const  = 0;
       virtual size_t get_region_count(void) const;
       virtual Mappable* get_mappable(void);
+      // Find the region trees whose logical state dependence analysis
+      // of this operation touches, returning false if there is other
+      // context state involved and it must be ordered with everything
+      virtual bool find_dependence_trees(std::set<RegionTreeID> &trees) const;
     protected:
       // Base call
       void activate_operation(void);
@@ -219,6 +223,13 @@ namespace Legion {
       inline bool already_traced(void) const 
         { return ((trace != NULL) && !tracing); }
       inline LegionTrace* get_trace(void) const { return trace; }
+      inline MustEpochOp* get_must_epoch(void) const { return must_epoch; }
+      inline unsigned get_trace_local_id(void) const { return trace_local_id; }
+      inline void set_trace_local_id(unsigned id) { trace_local_id = id; }
+      // Timestamps used for sizing adaptive task windows
+      inline void record_issue_time(long long t) { issue_time = t; }
+      inline long long get_issue_time(void) const { return issue_time; }
+      inline long long get_mapped_time(void) const { return mapped_time; }
       inline unsigned get_ctx_index(void) const { return context_index; }
     public:
       // Be careful using this call as it is only valid when the operation
@@ -410,6 +421,11 @@ namespace Legion {
                               GenerationID target_gen, unsigned target_idx,
                               DependenceType dtype, bool validates,
                               const FieldMask &dependent_mask);
+      // This is the form used when replaying a trace which has already
+      // folded all the recorded dependences on the same target together
+      // so the registration only has to be done once per target
+      void register_replay_dependence(Operation *target, 
+                              GenerationID target_gen, int validated_idx);
       // This method is invoked by one of the two above to perform
       // the registration.  Returns true if we have not yet commited
       // and should therefore be notified once the dependent operation
@@ -534,6 +550,10 @@ namespace Legion {
       LegionTrace *trace;
       // Track whether we are tracing this operation
       bool tracing;
+      // Our index in the trace if we are part of a dynamic trace
+      unsigned trace_local_id;
+      // When we were issued and finished mapping (-lg:adaptive_window)
+      long long issue_time, mapped_time;
       // Our must epoch if we have one
       MustEpochOp *must_epoch;
       // A set list or recorded dependences during logical traversal
@@ -658,6 +678,8 @@ namespace Legion {
       PredicateOp *predicate;
       bool speculate_mapping_only;
       bool received_trigger_resolution;
+      // The mapper that chose to speculate, told how it went
+      MapperManager *speculation_mapper;
     protected:
       RtUserEvent predicate_waiter; // used only when needed
     };
@@ -701,6 +723,7 @@ namespace Legion {
       virtual OpKind get_operation_kind(void) const;
       virtual size_t get_region_count(void) const;
       virtual Mappable* get_mappable(void);
+      virtual bool find_dependence_trees(std::set<RegionTreeID> &trees) const;
     public:
       virtual bool has_prepipeline_stage(void) const { return true; }
       virtual void trigger_prepipeline_stage(void);
@@ -784,6 +807,7 @@ namespace Legion {
       virtual OpKind get_operation_kind(void) const;
       virtual size_t get_region_count(void) const;
       virtual Mappable* get_mappable(void);
+      virtual bool find_dependence_trees(std::set<RegionTreeID> &trees) const;
     public:
       virtual bool has_prepipeline_stage(void) const { return true; }
       virtual void trigger_prepipeline_stage(void);
@@ -2280,6 +2304,7 @@ namespace Legion {
       virtual size_t get_region_count(void) const;
       virtual OpKind get_operation_kind(void) const;
       virtual Mappable* get_mappable(void);
+      virtual bool find_dependence_trees(std::set<RegionTreeID> &trees) const;
       virtual UniqueID get_unique_id(void) const;
       virtual unsigned get_context_index(void) const;
       virtual int get_depth(void) const;
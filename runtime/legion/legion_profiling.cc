@@ -32,6 +32,8 @@ namespace Legion {
     // be thread safe no matter what Realm decides to do 
     __thread LegionProfInstance *thread_local_profiling_instance = NULL;
 
+    __thread UniqueID implicit_provenance = 0;
+
     //--------------------------------------------------------------------------
     LegionProfMarker::LegionProfMarker(const char* _name)
       : name(_name), stopped(false)
@@ -60,7 +62,7 @@ namespace Legion {
 
     //--------------------------------------------------------------------------
     LegionProfInstance::LegionProfInstance(LegionProfiler *own)
-      : owner(own)
+      : owner(own), footprint(0), sample_count(0), dropped(0)
     //--------------------------------------------------------------------------
     {
     }
@@ -90,12 +92,25 @@ namespace Legion {
       return *this;
     }
 
+    //--------------------------------------------------------------------------
+    bool LegionProfInstance::keep_sample(void)
+    //--------------------------------------------------------------------------
+    {
+      // A sample rate of zero drops everything we can while over the cap
+      if ((owner->sample_rate > 0) && 
+          ((sample_count++ % owner->sample_rate) == 0))
+        return true;
+      dropped++;
+      return false;
+    }
+
     //--------------------------------------------------------------------------
     void LegionProfInstance::register_task_kind(TaskID task_id,
                                                 const char *name,bool overwrite)
     //--------------------------------------------------------------------------
     {
       task_kinds.push_back(TaskKind());
+      footprint += sizeof(TaskKind);
       TaskKind &kind = task_kinds.back();
       kind.task_id = task_id;
       kind.name = strdup(name);
@@ -109,6 +124,7 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       task_variants.push_back(TaskVariant()); 
+      footprint += sizeof(TaskVariant);
       TaskVariant &var = task_variants.back();
       var.task_id = task_id;
       var.variant_id = variant_id;
@@ -120,6 +136,7 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       operation_instances.push_back(OperationInstance());
+      footprint += sizeof(OperationInstance);
       OperationInstance &inst = operation_instances.back();
       inst.op_id = op->get_unique_op_id();
       inst.kind = op->get_operation_kind();
@@ -130,6 +147,7 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       multi_tasks.push_back(MultiTask());
+      footprint += sizeof(MultiTask);
       MultiTask &task = multi_tasks.back();
       task.op_id = op->get_unique_op_id();
       task.task_id = task_id;
@@ -140,6 +158,7 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       slice_owners.push_back(SliceOwner());
+      footprint += sizeof(SliceOwner);
       SliceOwner &task = slice_owners.back();
       task.parent_id = pid;
       task.op_id = id;
@@ -156,6 +175,7 @@ namespace Legion {
       assert(timeline->is_valid());
 #endif
       task_infos.push_back(TaskInfo()); 
+      footprint += sizeof(TaskInfo);
       TaskInfo &info = task_infos.back();
       info.op_id = op_id;
       info.variant_id = variant_id;
@@ -171,6 +191,7 @@ namespace Legion {
         for (unsigned idx = 0; idx < num_intervals; ++idx)
         {
           info.wait_intervals.push_back(WaitInfo());
+          footprint += sizeof(WaitInfo);
           WaitInfo& wait_info = info.wait_intervals.back();
           wait_info.wait_start = waits->intervals[idx].wait_start;
           wait_info.wait_ready = waits->intervals[idx].wait_ready;
@@ -179,6 +200,76 @@ namespace Legion {
       }
     }
 
+    //--------------------------------------------------------------------------
+    void LegionProfInstance::process_task_counters(UniqueID op_id,
+                                      const Realm::ProfilingResponse &response)
+    //--------------------------------------------------------------------------
+    {
+      // Realm only reports the counters that the hardware supports
+      Realm::ProfilingMeasurements::IPCPerfCounters *ipc = 
+        response.get_measurement<Realm::ProfilingMeasurements::IPCPerfCounters>();
+      Realm::ProfilingMeasurements::L2CachePerfCounters *l2 = 
+        response.get_measurement<
+                        Realm::ProfilingMeasurements::L2CachePerfCounters>();
+      Realm::ProfilingMeasurements::L3CachePerfCounters *l3 = 
+        response.get_measurement<
+                        Realm::ProfilingMeasurements::L3CachePerfCounters>();
+      Realm::ProfilingMeasurements::StallPerfCounters *stalls = 
+        response.get_measurement<
+                        Realm::ProfilingMeasurements::StallPerfCounters>();
+      if ((ipc != NULL) || (l2 != NULL) || (l3 != NULL) || (stalls != NULL))
+      {
+        task_counter_infos.push_back(TaskCounterInfo());
+        footprint += sizeof(TaskCounterInfo);
+        TaskCounterInfo &info = task_counter_infos.back();
+        info.op_id = op_id;
+        info.instructions = (ipc != NULL) ? ipc->total_insts : -1;
+        info.cycles = (ipc != NULL) ? ipc->total_cycles : -1;
+        info.l2_accesses = (l2 != NULL) ? l2->accesses : -1;
+        info.l2_misses = (l2 != NULL) ? l2->misses : -1;
+        info.l3_accesses = (l3 != NULL) ? l3->accesses : -1;
+        info.l3_misses = (l3 != NULL) ? l3->misses : -1;
+        info.stalled_cycles = (stalls != NULL) ? stalls->stalled_cycles : -1;
+      }
+      if (ipc != NULL)
+        delete ipc;
+      if (l2 != NULL)
+        delete l2;
+      if (l3 != NULL)
+        delete l3;
+      if (stalls != NULL)
+        delete stalls;
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfInstance::process_task_gpu_activity(UniqueID op_id,
+                      ProcID proc_id, const Realm::ProfilingResponse &response)
+    //--------------------------------------------------------------------------
+    {
+      // Realm only reports this when it is tracing the device
+      Realm::ProfilingMeasurements::OperationGPUActivity *activity = 
+        response.get_measurement<
+                        Realm::ProfilingMeasurements::OperationGPUActivity>();
+      if (activity == NULL)
+        return;
+      for (unsigned idx = 0; idx < activity->intervals.size(); idx++)
+      {
+        const Realm::ProfilingMeasurements::OperationGPUActivity::Interval
+          &interval = activity->intervals[idx];
+        gpu_activity_infos.push_back(GPUActivityInfo());
+        footprint += sizeof(GPUActivityInfo);
+        GPUActivityInfo &info = gpu_activity_infos.back();
+        info.op_id = op_id;
+        info.proc_id = proc_id;
+        info.stream = interval.stream;
+        info.kind = interval.kind;
+        info.bytes = interval.bytes;
+        info.start = interval.start;
+        info.stop = interval.end;
+      }
+      delete activity;
+    }
+
     //--------------------------------------------------------------------------
     void LegionProfInstance::process_meta(size_t id, UniqueID op_id,
                   Realm::ProfilingMeasurements::OperationTimeline *timeline,
@@ -189,7 +280,10 @@ namespace Legion {
 #ifdef DEBUG_LEGION
       assert(timeline->is_valid());
 #endif
+      if (owner->is_sampling() && !keep_sample())
+        return;
       meta_infos.push_back(MetaInfo());
+      footprint += sizeof(MetaInfo);
       MetaInfo &info = meta_infos.back();
       info.op_id = op_id;
       info.lg_id = id;
@@ -205,6 +299,7 @@ namespace Legion {
         for (unsigned idx = 0; idx < num_intervals; ++idx)
         {
           info.wait_intervals.push_back(WaitInfo());
+          footprint += sizeof(WaitInfo);
           WaitInfo& wait_info = info.wait_intervals.back();
           wait_info.wait_start = waits->intervals[idx].wait_start;
           wait_info.wait_ready = waits->intervals[idx].wait_ready;
@@ -223,7 +318,10 @@ namespace Legion {
 #ifdef DEBUG_LEGION
       assert(timeline->is_valid());
 #endif
+      if (owner->is_sampling() && !keep_sample())
+        return;
       meta_infos.push_back(MetaInfo());
+      footprint += sizeof(MetaInfo);
       MetaInfo &info = meta_infos.back();
       info.op_id = 0;
       info.lg_id = LG_MESSAGE_ID;
@@ -239,6 +337,7 @@ namespace Legion {
         for (unsigned idx = 0; idx < num_intervals; ++idx)
         {
           info.wait_intervals.push_back(WaitInfo());
+          footprint += sizeof(WaitInfo);
           WaitInfo& wait_info = info.wait_intervals.back();
           wait_info.wait_start = waits->intervals[idx].wait_start;
           wait_info.wait_ready = waits->intervals[idx].wait_ready;
@@ -257,6 +356,7 @@ namespace Legion {
       assert(timeline->is_valid());
 #endif
       copy_infos.push_back(CopyInfo());
+      footprint += sizeof(CopyInfo);
       CopyInfo &info = copy_infos.back();
       info.op_id = op_id;
       info.src = usage->source.id;
@@ -279,6 +379,7 @@ namespace Legion {
       assert(timeline->is_valid());
 #endif
       fill_infos.push_back(FillInfo());
+      footprint += sizeof(FillInfo);
       FillInfo &info = fill_infos.back();
       info.op_id = op_id;
       info.dst = usage->target.id;
@@ -295,6 +396,7 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       inst_create_infos.push_back(InstCreateInfo());
+      footprint += sizeof(InstCreateInfo);
       InstCreateInfo &info = inst_create_infos.back();
       info.op_id = op_id;
       info.inst_id = inst.id;
@@ -307,6 +409,7 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       inst_usage_infos.push_back(InstUsageInfo());
+      footprint += sizeof(InstUsageInfo);
       InstUsageInfo &info = inst_usage_infos.back();
       info.op_id = op_id;
       info.inst_id = usage->instance.id;
@@ -320,6 +423,7 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       inst_timeline_infos.push_back(InstTimelineInfo());
+      footprint += sizeof(InstTimelineInfo);
       InstTimelineInfo &info = inst_timeline_infos.back();
       info.op_id = op_id;
       info.inst_id = timeline->instance.id;
@@ -327,13 +431,45 @@ namespace Legion {
       info.destroy = timeline->delete_time;
     }
 
+    //--------------------------------------------------------------------------
+    void LegionProfInstance::record_instance_field(UniqueID op_id,
+               PhysicalInstance inst, FieldSpace handle, FieldID fid, size_t size)
+    //--------------------------------------------------------------------------
+    {
+      inst_field_infos.push_back(InstFieldInfo());
+      footprint += sizeof(InstFieldInfo);
+      InstFieldInfo &info = inst_field_infos.back();
+      info.op_id = op_id;
+      info.inst_id = inst.id;
+      info.fspace_id = handle.get_id();
+      info.field_id = fid;
+      info.size = size;
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfInstance::record_instance_deletion(PhysicalInstance inst,
+                                  Memory mem, bool evicted, timestamp_t time)
+    //--------------------------------------------------------------------------
+    {
+      inst_deletion_infos.push_back(InstDeletionInfo());
+      footprint += sizeof(InstDeletionInfo);
+      InstDeletionInfo &info = inst_deletion_infos.back();
+      info.inst_id = inst.id;
+      info.mem_id = mem.id;
+      info.evicted = evicted ? 1 : 0;
+      info.time = time;
+    }
+
     //--------------------------------------------------------------------------
     void LegionProfInstance::record_message(Processor proc, MessageKind kind, 
                                             unsigned long long start,
                                             unsigned long long stop)
     //--------------------------------------------------------------------------
     {
+      if (owner->is_sampling() && !keep_sample())
+        return;
       message_infos.push_back(MessageInfo());
+      footprint += sizeof(MessageInfo);
       MessageInfo &info = message_infos.back();
       info.kind = kind;
       info.start = start;
@@ -341,19 +477,118 @@ namespace Legion {
       info.proc_id = proc.id;
     }
 
+    //--------------------------------------------------------------------------
+    void LegionProfInstance::record_message_stats(AddressSpaceID source,
+                                                  AddressSpaceID target,
+                                                  MessageKind kind,
+                                                  size_t bytes,
+                                                  unsigned long long duration)
+    //--------------------------------------------------------------------------
+    {
+      std::vector<MessageStatsInfo> &stats = message_stats[source];
+      if (stats.empty())
+      {
+        stats.resize(LAST_SEND_KIND);
+        for (unsigned idx = 0; idx < LAST_SEND_KIND; idx++)
+        {
+          MessageStatsInfo &info = stats[idx];
+          info.source = source;
+          info.target = target;
+          info.kind = (MessageKind)idx;
+          info.count = 0;
+          info.total_bytes = 0;
+          for (unsigned b = 0; b < LEGION_PROF_MESSAGE_BUCKETS; b++)
+            info.latency[b] = 0;
+        }
+      }
+#ifdef DEBUG_LEGION
+      assert(kind < LAST_SEND_KIND);
+#endif
+      MessageStatsInfo &info = stats[kind];
+      info.count++;
+      info.total_bytes += bytes;
+      // Find the power-of-two microsecond bucket for the duration
+      unsigned bucket = 0;
+      unsigned long long micros = duration / 1000;
+      while ((micros > 0) && (bucket < (LEGION_PROF_MESSAGE_BUCKETS-1)))
+      {
+        micros >>= 1;
+        bucket++;
+      }
+      info.latency[bucket]++;
+    }
+
     //--------------------------------------------------------------------------
     void LegionProfInstance::record_mapper_call(Processor proc, 
                               MappingCallKind kind, UniqueID uid,
-                              unsigned long long start, unsigned long long stop)
+                              unsigned long long start, unsigned long long stop,
+                              MapperID mapper_id, Processor mapper_proc,
+                              unsigned long long wait)
     //--------------------------------------------------------------------------
     {
+      if (owner->is_sampling() && !keep_sample())
+        return;
       mapper_call_infos.push_back(MapperCallInfo());
+      footprint += sizeof(MapperCallInfo);
       MapperCallInfo &info = mapper_call_infos.back();
       info.kind = kind;
       info.op_id = uid;
       info.start = start;
       info.stop = stop;
       info.proc_id = proc.id;
+      info.mapper_id = mapper_id;
+      info.mapper_proc = mapper_proc.id;
+      info.wait = wait;
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfInstance::record_memory_usage(Memory mem, 
+                           MapperID mapper_id, size_t mapper_bytes, 
+                           TaskID task_id, size_t task_bytes, 
+                           unsigned long long time)
+    //--------------------------------------------------------------------------
+    {
+      mem_usage_infos.push_back(MemUsageInfo());
+      footprint += sizeof(MemUsageInfo);
+      MemUsageInfo &info = mem_usage_infos.back();
+      info.mem_id = mem.id;
+      info.mapper_id = mapper_id;
+      info.mapper_bytes = mapper_bytes;
+      info.task_id = task_id;
+      info.task_bytes = task_bytes;
+      info.time = time;
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfInstance::record_task_window(UniqueID op_id, 
+                 unsigned window_size, unsigned long long analysis_lag,
+                 unsigned long long execution_lag, unsigned long long time)
+    //--------------------------------------------------------------------------
+    {
+      task_window_infos.push_back(TaskWindowInfo());
+      footprint += sizeof(TaskWindowInfo);
+      TaskWindowInfo &info = task_window_infos.back();
+      info.op_id = op_id;
+      info.window_size = window_size;
+      info.analysis_lag = analysis_lag;
+      info.execution_lag = execution_lag;
+      info.time = time;
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfInstance::record_runtime_memory(AddressSpaceID node,
+                 unsigned kind, unsigned long long bytes,
+                 unsigned long long allocations, unsigned long long time)
+    //--------------------------------------------------------------------------
+    {
+      runtime_memory_infos.push_back(RuntimeMemoryInfo());
+      footprint += sizeof(RuntimeMemoryInfo);
+      RuntimeMemoryInfo &info = runtime_memory_infos.back();
+      info.node = node;
+      info.kind = kind;
+      info.bytes = bytes;
+      info.allocations = allocations;
+      info.time = time;
     }
 
     //--------------------------------------------------------------------------
@@ -361,7 +596,10 @@ namespace Legion {
         RuntimeCallKind kind, unsigned long long start, unsigned long long stop)
     //--------------------------------------------------------------------------
     {
+      if (owner->is_sampling() && !keep_sample())
+        return;
       runtime_call_infos.push_back(RuntimeCallInfo());
+      footprint += sizeof(RuntimeCallInfo);
       RuntimeCallInfo &info = runtime_call_infos.back();
       info.kind = kind;
       info.start = start;
@@ -377,6 +615,7 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       prof_task_infos.push_back(ProfTaskInfo());
+      footprint += sizeof(ProfTaskInfo);
       ProfTaskInfo &info = prof_task_infos.back();
       info.proc_id = proc.id;
       info.op_id = op_id;
@@ -426,6 +665,16 @@ namespace Legion {
           serializer->serialize(*wit, *it);
         }
       }
+      for (std::deque<TaskCounterInfo>::const_iterator it = 
+            task_counter_infos.begin(); it != task_counter_infos.end(); it++)
+      {
+        serializer->serialize(*it);
+      }
+      for (std::deque<GPUActivityInfo>::const_iterator it = 
+            gpu_activity_infos.begin(); it != gpu_activity_infos.end(); it++)
+      {
+        serializer->serialize(*it);
+      }
       for (std::deque<MetaInfo>::const_iterator it = meta_infos.begin();
             it != meta_infos.end(); it++)
       {
@@ -461,11 +710,48 @@ namespace Legion {
       {
         serializer->serialize(*it);
       }
+      for (std::deque<InstFieldInfo>::const_iterator it = 
+            inst_field_infos.begin(); it != inst_field_infos.end(); it++)
+      {
+        serializer->serialize(*it);
+      }
+      for (std::deque<InstDeletionInfo>::const_iterator it = 
+            inst_deletion_infos.begin(); it != inst_deletion_infos.end(); it++)
+      {
+        serializer->serialize(*it);
+      }
+      for (std::deque<MemUsageInfo>::const_iterator it = 
+            mem_usage_infos.begin(); it != mem_usage_infos.end(); it++)
+      {
+        serializer->serialize(*it);
+      }
+      for (std::deque<TaskWindowInfo>::const_iterator it = 
+            task_window_infos.begin(); it != task_window_infos.end(); it++)
+      {
+        serializer->serialize(*it);
+      }
+      for (std::deque<RuntimeMemoryInfo>::const_iterator it = 
+            runtime_memory_infos.begin(); it != 
+            runtime_memory_infos.end(); it++)
+      {
+        serializer->serialize(*it);
+      }
       for (std::deque<MessageInfo>::const_iterator it = message_infos.begin();
             it != message_infos.end(); it++)
       {
         serializer->serialize(*it);
       }
+      for (std::map<AddressSpaceID,std::vector<MessageStatsInfo> >::
+            const_iterator sit = message_stats.begin(); 
+            sit != message_stats.end(); sit++)
+      {
+        for (std::vector<MessageStatsInfo>::const_iterator it = 
+              sit->second.begin(); it != sit->second.end(); it++)
+        {
+          if (it->count > 0)
+            serializer->serialize(*it);
+        }
+      }
       for (std::deque<MapperCallInfo>::const_iterator it = 
             mapper_call_infos.begin(); it != mapper_call_infos.end(); it++)
       {
@@ -488,13 +774,22 @@ namespace Legion {
       operation_instances.clear();
       multi_tasks.clear();
       task_infos.clear();
+      task_counter_infos.clear();
+      gpu_activity_infos.clear();
       meta_infos.clear();
       copy_infos.clear();
       inst_create_infos.clear();
       inst_usage_infos.clear();
       inst_timeline_infos.clear();
+      inst_field_infos.clear();
+      inst_deletion_infos.clear();
+      mem_usage_infos.clear();
+      task_window_infos.clear();
+      runtime_memory_infos.clear();
       message_infos.clear();
+      message_stats.clear();
       mapper_call_infos.clear();
+      footprint = 0;
     }
 
     //--------------------------------------------------------------------------
@@ -505,8 +800,12 @@ namespace Legion {
                                    const char *const *const 
                                                   operation_kind_descriptions,
                                    const char *serializer_type,
-                                   const char *prof_logfile)
-      : target_proc(target), total_outstanding_requests(0)
+                                   const char *prof_logfile, Runtime *rt,
+                                   size_t cap, unsigned rate, bool counters)
+      : target_proc(target), runtime(rt), footprint_cap(cap), 
+        chunk_size(((cap > 0) && (cap < DEFAULT_PROF_CHUNK_SIZE)) ? 
+                   cap : DEFAULT_PROF_CHUNK_SIZE), sample_rate(rate),
+        collect_counters(counters), total_outstanding_requests(0), pending_bytes(0), dropped_records(0)
     //--------------------------------------------------------------------------
     {
       profiler_lock = Reservation::create_reservation();
@@ -584,7 +883,9 @@ namespace Legion {
 
     //--------------------------------------------------------------------------
     LegionProfiler::LegionProfiler(const LegionProfiler &rhs)
-      : target_proc(rhs.target_proc)
+      : target_proc(rhs.target_proc), runtime(rhs.runtime), 
+        footprint_cap(rhs.footprint_cap), chunk_size(rhs.chunk_size),
+        sample_rate(rhs.sample_rate), collect_counters(rhs.collect_counters)
     //--------------------------------------------------------------------------
     {
       // should never be called
@@ -624,6 +925,7 @@ namespace Legion {
         create_thread_local_profiling_instance();
       thread_local_profiling_instance->register_task_kind(task_id, task_name,
                                                           overwrite);
+      check_thread_local_footprint();
     }
 
     //--------------------------------------------------------------------------
@@ -636,6 +938,7 @@ namespace Legion {
         create_thread_local_profiling_instance();
       thread_local_profiling_instance->register_task_variant(task_id, 
                                                       variant_id, variant_name);
+      check_thread_local_footprint();
     }
 
     //--------------------------------------------------------------------------
@@ -645,6 +948,7 @@ namespace Legion {
       if (thread_local_profiling_instance == NULL)
         create_thread_local_profiling_instance();
       thread_local_profiling_instance->register_operation(op);
+      check_thread_local_footprint();
     }
 
     //--------------------------------------------------------------------------
@@ -654,6 +958,7 @@ namespace Legion {
       if (thread_local_profiling_instance == NULL)
         create_thread_local_profiling_instance();
       thread_local_profiling_instance->register_multi_task(op, task_id);
+      check_thread_local_footprint();
     }
 
     //--------------------------------------------------------------------------
@@ -663,6 +968,7 @@ namespace Legion {
       if (thread_local_profiling_instance == NULL)
         create_thread_local_profiling_instance();
       thread_local_profiling_instance->register_slice_owner(pid, id);
+      check_thread_local_footprint();
     }
 
     //--------------------------------------------------------------------------
@@ -683,17 +989,36 @@ namespace Legion {
                 Realm::ProfilingMeasurements::OperationProcessorUsage>();
       req.add_measurement<
                 Realm::ProfilingMeasurements::OperationEventWaits>();
+      // Only filled in by GPUs whose device work is being traced
+      req.add_measurement<
+                Realm::ProfilingMeasurements::OperationGPUActivity>();
+      if (collect_counters)
+        add_counter_measurements(req);
     }
 
     //--------------------------------------------------------------------------
-    void LegionProfiler::add_meta_request(Realm::ProfilingRequestSet &requests,
+    /*static*/ void LegionProfiler::add_counter_measurements(
+                                                  Realm::ProfilingRequest &req)
+    //--------------------------------------------------------------------------
+    {
+      req.add_measurement<Realm::ProfilingMeasurements::IPCPerfCounters>();
+      req.add_measurement<Realm::ProfilingMeasurements::L2CachePerfCounters>();
+      req.add_measurement<Realm::ProfilingMeasurements::L3CachePerfCounters>();
+      req.add_measurement<Realm::ProfilingMeasurements::StallPerfCounters>();
+    }
+
+    //--------------------------------------------------------------------------
+    UniqueID LegionProfiler::add_meta_request(
+                                          Realm::ProfilingRequestSet &requests,
                                           LgTaskID tid, Operation *op)
     //--------------------------------------------------------------------------
     {
       increment_total_outstanding_requests();
       ProfilingInfo info(LEGION_PROF_META); 
       info.id = tid;
-      info.op_id = (op != NULL) ? op->get_unique_op_id() : 0;
+      // Meta-tasks launched without an operation are charged to the
+      // operation of the meta-task that launched them
+      info.op_id = (op != NULL) ? op->get_unique_op_id() : implicit_provenance;
       Realm::ProfilingRequest &req = requests.add_request((target_proc.exists())
                         ? target_proc : Processor::get_executing_processor(),
                         LG_LEGION_PROFILING_ID, &info, sizeof(info));
@@ -703,6 +1028,7 @@ namespace Legion {
                 Realm::ProfilingMeasurements::OperationProcessorUsage>();
       req.add_measurement<
                 Realm::ProfilingMeasurements::OperationEventWaits>();
+      return info.op_id;
     }
 
     //--------------------------------------------------------------------------
@@ -795,6 +1121,10 @@ namespace Legion {
                 Realm::ProfilingMeasurements::OperationProcessorUsage>();
       req.add_measurement<
                 Realm::ProfilingMeasurements::OperationEventWaits>();
+      req.add_measurement<
+                Realm::ProfilingMeasurements::OperationGPUActivity>();
+      if (collect_counters)
+        add_counter_measurements(req);
     }
 
     //--------------------------------------------------------------------------
@@ -912,8 +1242,15 @@ namespace Legion {
                     Realm::ProfilingMeasurements::OperationEventWaits>();
             // Ignore anything that was predicated false for now
             if (usage != NULL)
+            {
               thread_local_profiling_instance->process_task(info->id, 
                   info->op_id, timeline, usage, waits);
+              if (collect_counters)
+                thread_local_profiling_instance->process_task_counters(
+                    info->op_id, response);
+              thread_local_profiling_instance->process_task_gpu_activity(
+                  info->op_id, usage->proc.id, response);
+            }
             if (timeline != NULL)
               delete timeline;
             if (timeline != NULL)
@@ -1061,6 +1398,7 @@ namespace Legion {
       thread_local_profiling_instance->record_proftask(p, info->op_id, 
                                                        t_start, t_stop);
 #endif
+      check_thread_local_footprint();
     }
 
     //--------------------------------------------------------------------------
@@ -1070,7 +1408,37 @@ namespace Legion {
       for (std::vector<LegionProfInstance*>::const_iterator it = 
             instances.begin(); it != instances.end(); it++) {
         (*it)->dump_state(serializer);
+        dropped_records += (*it)->get_dropped();
       }  
+      if (dropped_records > 0)
+        log_prof.warning("Dropped %llu profiling records after exceeding "
+                         "the profiler memory cap of %zd MB. Consider "
+                         "increasing -lg:prof_footprint.", dropped_records,
+                         footprint_cap >> 20);
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfiler::drain_instance(LegionProfInstance *instance)
+    //--------------------------------------------------------------------------
+    {
+      const size_t bytes = instance->get_footprint();
+      {
+        AutoLock p_lock(profiler_lock);
+        instance->dump_state(serializer);
+        serializer->flush();
+        dropped_records += instance->get_dropped();
+      }
+      delete instance;
+      __sync_fetch_and_sub(&pending_bytes, bytes);
+      decrement_total_outstanding_requests();
+    }
+
+    //--------------------------------------------------------------------------
+    /*static*/ void LegionProfiler::handle_drain(const void *args)
+    //--------------------------------------------------------------------------
+    {
+      const DrainArgs *dargs = (const DrainArgs*)args;
+      dargs->profiler->drain_instance(dargs->instance);
     }
 
     //--------------------------------------------------------------------------
@@ -1081,6 +1449,102 @@ namespace Legion {
       if (thread_local_profiling_instance == NULL)
         create_thread_local_profiling_instance();
       thread_local_profiling_instance->process_inst_create(op_id, inst, create);
+      check_thread_local_footprint();
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfiler::record_instance_fields(PhysicalInstance inst,
+                                     UniqueID op_id, FieldSpace handle,
+                     const std::vector<std::pair<FieldID,size_t> > &fields)
+    //--------------------------------------------------------------------------
+    {
+      if (thread_local_profiling_instance == NULL)
+        create_thread_local_profiling_instance();
+      for (std::vector<std::pair<FieldID,size_t> >::const_iterator it = 
+            fields.begin(); it != fields.end(); it++)
+        thread_local_profiling_instance->record_instance_field(op_id, inst,
+                                                handle, it->first, it->second);
+      check_thread_local_footprint();
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfiler::record_instance_deletion(PhysicalInstance inst,
+                                                  Memory memory, bool evicted)
+    //--------------------------------------------------------------------------
+    {
+      unsigned long long time = Realm::Clock::current_time_in_nanoseconds();
+      if (thread_local_profiling_instance == NULL)
+        create_thread_local_profiling_instance();
+      thread_local_profiling_instance->record_instance_deletion(inst, memory,
+                                                                evicted, time);
+      check_thread_local_footprint();
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfiler::record_memory_usage(Memory mem, MapperID mapper_id,
+                                             size_t mapper_bytes, 
+                                             TaskID task_id, size_t task_bytes)
+    //--------------------------------------------------------------------------
+    {
+      unsigned long long time = Realm::Clock::current_time_in_nanoseconds();
+      if (thread_local_profiling_instance == NULL)
+        create_thread_local_profiling_instance();
+      thread_local_profiling_instance->record_memory_usage(mem, mapper_id,
+                                   mapper_bytes, task_id, task_bytes, time);
+      check_thread_local_footprint();
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfiler::record_task_window(UniqueID op_id, 
+                                            unsigned window_size,
+                                            unsigned long long analysis_lag,
+                                            unsigned long long execution_lag)
+    //--------------------------------------------------------------------------
+    {
+      unsigned long long time = Realm::Clock::current_time_in_nanoseconds();
+      if (thread_local_profiling_instance == NULL)
+        create_thread_local_profiling_instance();
+      thread_local_profiling_instance->record_task_window(op_id, window_size,
+                                          analysis_lag, execution_lag, time);
+      check_thread_local_footprint();
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfiler::record_allocation_kinds(const char *const *const
+                                      alloc_names, unsigned int num_alloc_kinds)
+    //--------------------------------------------------------------------------
+    {
+      for (unsigned idx = 0; idx < num_alloc_kinds; idx++)
+      {
+        LegionProfDesc::AllocDesc alloc_desc;
+        alloc_desc.kind = idx;
+        alloc_desc.name = alloc_names[idx];
+        serializer->serialize(alloc_desc);
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfiler::record_runtime_memory(AddressSpaceID node,
+                                               const long long *bytes,
+                                               const long long *allocations,
+                                               unsigned int num_alloc_kinds)
+    //--------------------------------------------------------------------------
+    {
+      unsigned long long time = Realm::Clock::current_time_in_nanoseconds();
+      if (thread_local_profiling_instance == NULL)
+        create_thread_local_profiling_instance();
+      for (unsigned idx = 0; idx < num_alloc_kinds; idx++)
+      {
+        // Skip any kinds of allocations that have never been used
+        if ((bytes[idx] == 0) && (allocations[idx] == 0))
+          continue;
+        // Counts can be transiently negative when a free on one thread
+        // is observed before the allocation on another thread
+        thread_local_profiling_instance->record_runtime_memory(node, idx,
+            (bytes[idx] > 0) ? bytes[idx] : 0,
+            (allocations[idx] > 0) ? allocations[idx] : 0, time);
+      }
+      check_thread_local_footprint();
     }
 
     //--------------------------------------------------------------------------
@@ -1100,7 +1564,8 @@ namespace Legion {
     //--------------------------------------------------------------------------
     void LegionProfiler::record_message(MessageKind kind, 
                                         unsigned long long start,
-                                        unsigned long long stop)
+                                        unsigned long long stop,
+                                        AddressSpaceID source, size_t bytes)
     //--------------------------------------------------------------------------
     {
       Processor current = Processor::get_executing_processor();
@@ -1108,6 +1573,9 @@ namespace Legion {
         create_thread_local_profiling_instance();
       thread_local_profiling_instance->record_message(current, kind, 
                                                       start, stop);
+      thread_local_profiling_instance->record_message_stats(source,
+          current.address_space(), kind, bytes, stop - start);
+      check_thread_local_footprint();
     }
 
     //--------------------------------------------------------------------------
@@ -1126,14 +1594,17 @@ namespace Legion {
 
     //--------------------------------------------------------------------------
     void LegionProfiler::record_mapper_call(MappingCallKind kind, UniqueID uid,
-                              unsigned long long start, unsigned long long stop)
+                              unsigned long long start, unsigned long long stop,
+                              MapperID mapper_id, Processor mapper_proc,
+                              unsigned long long wait)
     //--------------------------------------------------------------------------
     {
       Processor current = Processor::get_executing_processor();
       if (thread_local_profiling_instance == NULL)
         create_thread_local_profiling_instance();
       thread_local_profiling_instance->record_mapper_call(current, kind, uid, 
-                                                   start, stop);
+                                 start, stop, mapper_id, mapper_proc, wait);
+      check_thread_local_footprint();
     }
 
     //--------------------------------------------------------------------------
@@ -1160,6 +1631,7 @@ namespace Legion {
         create_thread_local_profiling_instance();
       thread_local_profiling_instance->record_runtime_call(current, kind, 
                                                            start, stop);
+      check_thread_local_footprint();
     }
 
     //--------------------------------------------------------------------------
@@ -1172,6 +1644,36 @@ namespace Legion {
       instances.push_back(thread_local_profiling_instance);
     }
 
+    //--------------------------------------------------------------------------
+    void LegionProfiler::check_thread_local_footprint(void)
+    //--------------------------------------------------------------------------
+    {
+      if ((footprint_cap == 0) || 
+          (thread_local_profiling_instance->get_footprint() < chunk_size))
+        return;
+      // Hand off the full buffer to be written out in the background
+      // and start a new one for this thread so we never wait on the 
+      // file system while recording
+      LegionProfInstance *full = thread_local_profiling_instance;
+      thread_local_profiling_instance = NULL;
+      {
+        AutoLock p_lock(profiler_lock);
+        std::vector<LegionProfInstance*>::iterator finder = 
+          std::find(instances.begin(), instances.end(), full);
+#ifdef DEBUG_LEGION
+        assert(finder != instances.end());
+#endif
+        instances.erase(finder);
+      }
+      __sync_fetch_and_add(&pending_bytes, full->get_footprint());
+      // Shutdown waits for outstanding requests so this will be written
+      increment_total_outstanding_requests();
+      DrainArgs args;
+      args.profiler = this;
+      args.instance = full;
+      runtime->issue_runtime_meta_task(args, LG_THROUGHPUT_PRIORITY);
+    }
+
     //--------------------------------------------------------------------------
     DetailedProfiler::DetailedProfiler(Runtime *runtime, RuntimeCallKind call)
       : profiler(runtime->profiler), call_kind(call), start_time(0)
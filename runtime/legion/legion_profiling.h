@@ -41,6 +41,11 @@
 #define gasnet_mynode() 0
 #endif
 
+// Number of buckets in the per-message-kind handler latency histograms:
+// bucket 0 is for handlers under 1us, bucket b covers [2^(b-1),2^b) us,
+// and the last bucket holds everything longer than that
+#define LEGION_PROF_MESSAGE_BUCKETS 12
+
 
 namespace Legion {
   namespace Internal { 
@@ -53,6 +58,10 @@ namespace Legion {
     typedef ::legion_lowlevel_id_t MemID;
     typedef ::legion_lowlevel_id_t InstID;
 
+    // The application operation on whose behalf the current meta-task is
+    // running, which is inherited by any meta-tasks that it launches
+    extern __thread UniqueID implicit_provenance;
+
     class LegionProfSerializer; // forward declaration
 
     class LegionProfMarker {
@@ -105,6 +114,11 @@ namespace Legion {
         MemKind kind;
         unsigned long long capacity;
       };
+      struct AllocDesc {
+      public:
+        unsigned kind;
+        const char *name;
+      };
     };
 
     class LegionProfInstance {
@@ -188,18 +202,72 @@ namespace Legion {
         InstID inst_id;
         timestamp_t create, destroy;
       };
+      struct InstFieldInfo {
+      public:
+        UniqueID op_id;
+        InstID inst_id;
+        unsigned fspace_id;
+        FieldID field_id;
+        unsigned long long size;
+      };
+      struct InstDeletionInfo {
+      public:
+        InstID inst_id;
+        MemID mem_id;
+        unsigned evicted;
+        timestamp_t time;
+      };
+      struct MemUsageInfo {
+      public:
+        MemID mem_id;
+        MapperID mapper_id;
+        unsigned long long mapper_bytes;
+        TaskID task_id;
+        unsigned long long task_bytes;
+        timestamp_t time;
+      };
+      struct TaskWindowInfo {
+      public:
+        UniqueID op_id;
+        unsigned window_size;
+        timestamp_t analysis_lag, execution_lag;
+        timestamp_t time;
+      };
+      // Bytes and allocations live in the runtime's own data
+      // structures for one kind of allocation on one node
+      struct RuntimeMemoryInfo {
+      public:
+        AddressSpaceID node;
+        unsigned kind;
+        unsigned long long bytes;
+        unsigned long long allocations;
+        timestamp_t time;
+      };
       struct MessageInfo {
       public:
         MessageKind kind;
         timestamp_t start, stop;
         ProcID proc_id;
       };
+      // Aggregate counts for all the messages of one kind sent from
+      // one node to another, handled by a single thread
+      struct MessageStatsInfo {
+      public:
+        AddressSpaceID source, target;
+        MessageKind kind;
+        unsigned long long count;
+        unsigned long long total_bytes;
+        unsigned long long latency[LEGION_PROF_MESSAGE_BUCKETS];
+      };
       struct MapperCallInfo {
       public:
         MappingCallKind kind;
         UniqueID op_id;
         timestamp_t start, stop;
         ProcID proc_id;
+        MapperID mapper_id;
+        ProcID mapper_proc;
+        timestamp_t wait; // time spent waiting on the mapper
       };
       struct RuntimeCallInfo {
       public:
@@ -207,6 +275,25 @@ namespace Legion {
         timestamp_t start, stop;
         ProcID proc_id;
       };
+      // Hardware counters for a task, -1 where a counter is unavailable
+      struct TaskCounterInfo {
+      public:
+        UniqueID op_id;
+        long long instructions, cycles;
+        long long l2_accesses, l2_misses;
+        long long l3_accesses, l3_misses;
+        long long stalled_cycles;
+      };
+      // A kernel, copy or fill issued by a GPU task, as seen by the device
+      struct GPUActivityInfo {
+      public:
+        UniqueID op_id;
+        ProcID proc_id;
+        unsigned stream;
+        unsigned kind;
+        unsigned long long bytes;
+        timestamp_t start, stop;
+      };
 #ifdef LEGION_PROF_SELF_PROFILE
       struct ProfTaskInfo {
       public:
@@ -234,6 +321,10 @@ namespace Legion {
                   Realm::ProfilingMeasurements::OperationTimeline *timeline,
                   Realm::ProfilingMeasurements::OperationProcessorUsage *usage,
                   Realm::ProfilingMeasurements::OperationEventWaits *waits);
+      void process_task_counters(UniqueID op_id,
+                  const Realm::ProfilingResponse &response);
+      void process_task_gpu_activity(UniqueID op_id, ProcID proc_id,
+                  const Realm::ProfilingResponse &response);
       void process_meta(size_t id, UniqueID op_id,
                   Realm::ProfilingMeasurements::OperationTimeline *timeline,
                   Realm::ProfilingMeasurements::OperationProcessorUsage *usage,
@@ -255,11 +346,29 @@ namespace Legion {
       void process_inst_timeline(UniqueID op_id,
                   Realm::ProfilingMeasurements::InstanceTimeline *timeline);
     public:
+      void record_instance_field(UniqueID op_id, PhysicalInstance inst,
+                                 FieldSpace handle, FieldID fid, size_t size);
+      void record_instance_deletion(PhysicalInstance inst, Memory mem,
+                                    bool evicted, timestamp_t time);
+      void record_memory_usage(Memory mem, MapperID mapper_id, 
+                               size_t mapper_bytes, TaskID task_id,
+                               size_t task_bytes, timestamp_t time);
+      void record_task_window(UniqueID op_id, unsigned window_size,
+                              timestamp_t analysis_lag, 
+                              timestamp_t execution_lag, timestamp_t time);
+      void record_runtime_memory(AddressSpaceID node, unsigned kind,
+                                 unsigned long long bytes,
+                                 unsigned long long allocations,
+                                 timestamp_t time);
       void record_message(Processor proc, MessageKind kind, timestamp_t start,
                           timestamp_t stop);
+      void record_message_stats(AddressSpaceID source, AddressSpaceID target,
+                                MessageKind kind, size_t bytes,
+                                timestamp_t duration);
       void record_mapper_call(Processor proc, MappingCallKind kind, 
                               UniqueID uid, timestamp_t start,
-                              timestamp_t stop);
+                              timestamp_t stop, MapperID mapper_id,
+                              Processor mapper_proc, timestamp_t wait);
       void record_runtime_call(Processor proc, RuntimeCallKind kind,
                                timestamp_t start, timestamp_t stop);
 #ifdef LEGION_PROF_SELF_PROFILE
@@ -269,8 +378,16 @@ namespace Legion {
 #endif
     public:
       void dump_state(LegionProfSerializer *serializer);
+      // Approximate bytes of records buffered since the last dump
+      inline size_t get_footprint(void) const { return footprint; }
+      inline unsigned long long get_dropped(void) const { return dropped; }
+    private:
+      bool keep_sample(void);
     private:
       LegionProfiler *const owner;
+      size_t footprint;
+      unsigned long long sample_count;
+      unsigned long long dropped;
       std::deque<TaskKind>          task_kinds;
       std::deque<TaskVariant>       task_variants;
       std::deque<OperationInstance> operation_instances;
@@ -278,14 +395,23 @@ namespace Legion {
       std::deque<SliceOwner>        slice_owners;
     private:
       std::deque<TaskInfo> task_infos;
+      std::deque<TaskCounterInfo> task_counter_infos;
+      std::deque<GPUActivityInfo> gpu_activity_infos;
       std::deque<MetaInfo> meta_infos;
       std::deque<CopyInfo> copy_infos;
       std::deque<FillInfo> fill_infos;
       std::deque<InstCreateInfo> inst_create_infos;
       std::deque<InstUsageInfo> inst_usage_infos;
       std::deque<InstTimelineInfo> inst_timeline_infos;
+      std::deque<InstFieldInfo> inst_field_infos;
+      std::deque<InstDeletionInfo> inst_deletion_infos;
+      std::deque<MemUsageInfo> mem_usage_infos;
+      std::deque<TaskWindowInfo> task_window_infos;
+      std::deque<RuntimeMemoryInfo> runtime_memory_infos;
     private:
       std::deque<MessageInfo> message_infos;
+      // One entry for each message kind from each source node
+      std::map<AddressSpaceID,std::vector<MessageStatsInfo> > message_stats;
       std::deque<MapperCallInfo> mapper_call_infos;
       std::deque<RuntimeCallInfo> runtime_call_infos;
 #ifdef LEGION_PROF_SELF_PROFILE
@@ -296,6 +422,13 @@ namespace Legion {
 
     class LegionProfiler {
     public:
+      struct DrainArgs : public LgTaskArgs<DrainArgs> {
+      public:
+        static const LgTaskID TASK_ID = LG_PROFILER_DRAIN_TASK_ID;
+      public:
+        LegionProfiler *profiler;
+        LegionProfInstance *instance;
+      };
       enum ProfilingKind {
         LEGION_PROF_TASK,
         LEGION_PROF_META,
@@ -322,7 +455,9 @@ namespace Legion {
                      unsigned num_operation_kinds,
                      const char *const *const operation_kind_descriptions,
                      const char *serializer_type,
-                     const char *prof_logname);
+                     const char *prof_logname, Runtime *runtime,
+                     size_t footprint_cap, unsigned sample_rate,
+                     bool collect_counters);
       LegionProfiler(const LegionProfiler &rhs);
       ~LegionProfiler(void);
     public:
@@ -342,8 +477,9 @@ namespace Legion {
     public:
       void add_task_request(Realm::ProfilingRequestSet &requests, 
                             TaskID tid, SingleTask *task);
-      void add_meta_request(Realm::ProfilingRequestSet &requests,
-                            LgTaskID tid, Operation *op);
+      // Returns the operation the meta-task was charged to
+      UniqueID add_meta_request(Realm::ProfilingRequestSet &requests,
+                                LgTaskID tid, Operation *op);
       void add_copy_request(Realm::ProfilingRequestSet &requests, 
                             Operation *op);
       void add_fill_request(Realm::ProfilingRequestSet &requests,
@@ -375,23 +511,66 @@ namespace Legion {
     public:
       void record_instance_creation(PhysicalInstance inst, Memory memory,
                                     UniqueID op_id, timestamp_t create);
+      // Record the fields of an instance so memory can be broken down
+      // by the data that occupies it
+      void record_instance_fields(PhysicalInstance inst, UniqueID op_id,
+                                  FieldSpace handle,
+                  const std::vector<std::pair<FieldID,size_t> > &fields);
+      // Record that the runtime deleted an instance, either because it was
+      // collected or because it was evicted to make room for another one
+      void record_instance_deletion(PhysicalInstance inst, Memory memory,
+                                    bool evicted);
+      // Record the bytes currently charged to a mapper and a task kind
+      // in a memory after one of their instances is created or deleted
+      void record_memory_usage(Memory mem, MapperID mapper_id, 
+                               size_t mapper_bytes, TaskID task_id,
+                               size_t task_bytes);
+      // Record a change to the size of the window of outstanding
+      // child operations of a task and the lags that caused it
+      void record_task_window(UniqueID op_id, unsigned window_size,
+                              timestamp_t analysis_lag,
+                              timestamp_t execution_lag);
+    public:
+      void record_allocation_kinds(const char *const *const alloc_names,
+                                   unsigned int num_alloc_kinds);
+      // Record the bytes and allocations that are live in each kind
+      // of runtime data structure on this node
+      void record_runtime_memory(AddressSpaceID node,
+                                 const long long *bytes,
+                                 const long long *allocations,
+                                 unsigned int num_alloc_kinds);
     public:
       void record_message_kinds(const char *const *const message_names,
                                 unsigned int num_message_kinds);
       void record_message(MessageKind kind, timestamp_t start,
-                          timestamp_t stop);
+                          timestamp_t stop, AddressSpaceID source,
+                          size_t bytes);
     public:
       void record_mapper_call_kinds(const char *const *const mapper_call_names,
                                     unsigned int num_mapper_call_kinds);
       void record_mapper_call(MappingCallKind kind, UniqueID uid,
-                              timestamp_t start, timestamp_t stop);
+                              timestamp_t start, timestamp_t stop,
+                              MapperID mapper_id, Processor mapper_proc,
+                              timestamp_t wait);
     public:
       void record_runtime_call_kinds(const char *const *const runtime_calls,
                                      unsigned int num_runtime_call_kinds);
       void record_runtime_call(RuntimeCallKind kind, timestamp_t start,
                                timestamp_t stop);
+    public:
+      // Write out a chunk of records handed off by a thread
+      void drain_instance(LegionProfInstance *instance);
+      static void handle_drain(const void *args);
+      // Only true when the writer has fallen behind the memory cap
+      inline bool is_sampling(void) const
+        { return (footprint_cap > 0) && (pending_bytes > footprint_cap); }
     public:
       const Processor target_proc;
+      Runtime *const runtime;
+      const size_t footprint_cap;
+      const size_t chunk_size;
+      const unsigned sample_rate;
+      const bool collect_counters;
       inline bool has_outstanding_requests(void)
         { return total_outstanding_requests != 0; }
     public:
@@ -401,11 +580,16 @@ namespace Legion {
         { __sync_fetch_and_sub(&total_outstanding_requests,1); }
     private:
       void create_thread_local_profiling_instance(void);
+      static void add_counter_measurements(Realm::ProfilingRequest &req);
+      void check_thread_local_footprint(void);
     private:
       LegionProfSerializer* serializer;
       Reservation profiler_lock;
       std::vector<LegionProfInstance*> instances;
       unsigned total_outstanding_requests;
+      // Bytes handed off by threads that have not been written yet
+      volatile size_t pending_bytes;
+      unsigned long long dropped_records;
     };
 
     class DetailedProfiler {
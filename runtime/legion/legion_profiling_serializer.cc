@@ -84,6 +84,12 @@ namespace Legion {
               << "capacity:unsigned long long:" << sizeof(unsigned long long)
          << "}" << std::endl;
 
+      ss << "AllocDesc {" 
+              << "id:" << ALLOC_DESC_ID                   << delim
+              << "kind:unsigned:"     << sizeof(unsigned) << delim
+              << "name:string:" << "-1"
+         << "}" << std::endl;
+
       ss << "TaskKind {" 
               << "id:" << TASK_KIND_ID                 << delim
               << "task_id:TaskID:"   << sizeof(TaskID) << delim
@@ -145,6 +151,30 @@ namespace Legion {
               << "stop:timestamp_t:"    << sizeof(timestamp_t)
          << "}" << std::endl;
 
+      ss << "TaskCounterInfo {"
+              << "id:" << TASK_COUNTER_INFO_ID                   << delim
+              << "op_id:UniqueID:"          << sizeof(UniqueID)   << delim
+              << "instructions:long long:"  << sizeof(long long)  << delim
+              << "cycles:long long:"        << sizeof(long long)  << delim
+              << "l2_accesses:long long:"   << sizeof(long long)  << delim
+              << "l2_misses:long long:"     << sizeof(long long)  << delim
+              << "l3_accesses:long long:"   << sizeof(long long)  << delim
+              << "l3_misses:long long:"     << sizeof(long long)  << delim
+              << "stalled_cycles:long long:" << sizeof(long long)
+         << "}" << std::endl;
+
+      ss << "GPUActivityInfo {"
+              << "id:" << GPU_ACTIVITY_INFO_ID                     << delim
+              << "op_id:UniqueID:"         << sizeof(UniqueID)    << delim
+              << "proc_id:ProcID:"         << sizeof(ProcID)      << delim
+              << "stream:unsigned:"        << sizeof(unsigned)    << delim
+              << "kind:unsigned:"          << sizeof(unsigned)    << delim
+              << "bytes:unsigned long long:" << sizeof(unsigned long long)
+                                                                  << delim
+              << "start:timestamp_t:"      << sizeof(timestamp_t) << delim
+              << "stop:timestamp_t:"       << sizeof(timestamp_t)
+         << "}" << std::endl;
+
       ss << "MetaInfo {"
               << "id:" << META_INFO_ID                         << delim
               << "op_id:UniqueID:"     << sizeof(UniqueID)     << delim
@@ -201,6 +231,51 @@ namespace Legion {
               << "destroy:timestamp_t:" << sizeof(timestamp_t)
          << "}" << std::endl;
 
+      ss << "InstFieldInfo {"
+              << "id:" << INST_FIELD_INFO_ID                       << delim
+              << "op_id:UniqueID:"          << sizeof(UniqueID)    << delim
+              << "inst_id:InstID:"          << sizeof(InstID)      << delim
+              << "fspace_id:unsigned:"      << sizeof(unsigned)    << delim
+              << "field_id:unsigned:"       << sizeof(FieldID)     << delim
+              << "size:unsigned long long:" << sizeof(unsigned long long)
+         << "}" << std::endl;
+
+      ss << "InstDeletionInfo {"
+              << "id:" << INST_DELETION_INFO_ID                << delim
+              << "inst_id:InstID:"      << sizeof(InstID)      << delim
+              << "mem_id:MemID:"        << sizeof(MemID)       << delim
+              << "evicted:unsigned:"    << sizeof(unsigned)    << delim
+              << "time:timestamp_t:"    << sizeof(timestamp_t)
+         << "}" << std::endl;
+
+      ss << "MemUsageInfo {"
+              << "id:" << MEM_USAGE_INFO_ID                                     << delim
+              << "mem_id:MemID:"                    << sizeof(MemID)              << delim
+              << "mapper_id:MapperID:"              << sizeof(MapperID)           << delim
+              << "mapper_bytes:unsigned long long:" << sizeof(unsigned long long) << delim
+              << "task_id:TaskID:"                  << sizeof(TaskID)             << delim
+              << "task_bytes:unsigned long long:"   << sizeof(unsigned long long) << delim
+              << "time:timestamp_t:"                << sizeof(timestamp_t)
+         << "}" << std::endl;
+
+      ss << "TaskWindowInfo {"
+              << "id:" << TASK_WINDOW_INFO_ID                         << delim
+              << "op_id:UniqueID:"            << sizeof(UniqueID)     << delim
+              << "window_size:unsigned:"      << sizeof(unsigned)     << delim
+              << "analysis_lag:timestamp_t:"  << sizeof(timestamp_t)  << delim
+              << "execution_lag:timestamp_t:" << sizeof(timestamp_t)  << delim
+              << "time:timestamp_t:"          << sizeof(timestamp_t)
+         << "}" << std::endl;
+
+      ss << "RuntimeMemoryInfo {"
+              << "id:" << RUNTIME_MEMORY_INFO_ID                                  << delim
+              << "node:AddressSpaceID:"            << sizeof(AddressSpaceID)     << delim
+              << "kind:unsigned:"                  << sizeof(unsigned)           << delim
+              << "bytes:unsigned long long:"       << sizeof(unsigned long long) << delim
+              << "allocations:unsigned long long:" << sizeof(unsigned long long) << delim
+              << "time:timestamp_t:"               << sizeof(timestamp_t)
+         << "}" << std::endl;
+
       ss << "MessageInfo {"
               << "id:" << MESSAGE_INFO_ID                           << delim
               << "kind:MessageKind:"  << sizeof(MessageKind)        << delim
@@ -209,13 +284,28 @@ namespace Legion {
               << "proc_id:ProcID:"    << sizeof(ProcID)
          << "}" << std::endl;
 
+      ss << "MessageStatsInfo {"
+              << "id:" << MESSAGE_STATS_INFO_ID                            << delim
+              << "source:AddressSpaceID:"          << sizeof(AddressSpaceID) << delim
+              << "target:AddressSpaceID:"          << sizeof(AddressSpaceID) << delim
+              << "kind:MessageKind:"               << sizeof(MessageKind)    << delim
+              << "count:unsigned long long:"       << sizeof(unsigned long long) << delim
+              << "total_bytes:unsigned long long:" << sizeof(unsigned long long);
+      for (unsigned idx = 0; idx < LEGION_PROF_MESSAGE_BUCKETS; idx++)
+        ss << delim << "latency" << idx << ":unsigned long long:"
+           << sizeof(unsigned long long);
+      ss << "}" << std::endl;
+
       ss << "MapperCallInfo {"
               << "id:" << MAPPER_CALL_INFO_ID                          << delim
               << "kind:MappingCallKind:" << sizeof(MappingCallKind)    << delim
               << "op_id:UniqueID:"       << sizeof(UniqueID)           << delim
               << "start:timestamp_t:"    << sizeof(timestamp_t)        << delim
               << "stop:timestamp_t:"     << sizeof(timestamp_t)        << delim
-              << "proc_id:ProcID:"       << sizeof(ProcID)
+              << "proc_id:ProcID:"       << sizeof(ProcID)             << delim
+              << "mapper_id:MapperID:"   << sizeof(MapperID)           << delim
+              << "mapper_proc:ProcID:"   << sizeof(ProcID)             << delim
+              << "wait:timestamp_t:"     << sizeof(timestamp_t)
          << "}" << std::endl;
 
       ss << "RuntimeCallInfo {"
@@ -302,6 +392,14 @@ namespace Legion {
       lp_fwrite(f, (char*)&(mem_desc.capacity), sizeof(mem_desc.capacity));
     }
 
+    void LegionProfBinarySerializer::serialize(const LegionProfDesc::AllocDesc &alloc_desc)
+    {
+      int ID = ALLOC_DESC_ID;
+      lp_fwrite(f, (char*)&ID, sizeof(ID));
+      lp_fwrite(f, (char*)&(alloc_desc.kind), sizeof(alloc_desc.kind));
+      lp_fwrite(f, alloc_desc.name, strlen(alloc_desc.name) + 1);
+    }
+
     // Serialize Methods
     void LegionProfBinarySerializer::serialize(const LegionProfInstance::TaskKind& task_kind)
     {
@@ -378,6 +476,31 @@ namespace Legion {
       lp_fwrite(f, (char*)&(task_info.start),      sizeof(task_info.start));
       lp_fwrite(f, (char*)&(task_info.stop),       sizeof(task_info.stop));
     }
+    void LegionProfBinarySerializer::serialize(const LegionProfInstance::TaskCounterInfo& counter_info)
+    {
+      int ID = TASK_COUNTER_INFO_ID;
+      lp_fwrite(f, (char*)&ID, sizeof(ID));
+      lp_fwrite(f, (char*)&(counter_info.op_id),          sizeof(counter_info.op_id));
+      lp_fwrite(f, (char*)&(counter_info.instructions),   sizeof(counter_info.instructions));
+      lp_fwrite(f, (char*)&(counter_info.cycles),         sizeof(counter_info.cycles));
+      lp_fwrite(f, (char*)&(counter_info.l2_accesses),    sizeof(counter_info.l2_accesses));
+      lp_fwrite(f, (char*)&(counter_info.l2_misses),      sizeof(counter_info.l2_misses));
+      lp_fwrite(f, (char*)&(counter_info.l3_accesses),    sizeof(counter_info.l3_accesses));
+      lp_fwrite(f, (char*)&(counter_info.l3_misses),      sizeof(counter_info.l3_misses));
+      lp_fwrite(f, (char*)&(counter_info.stalled_cycles), sizeof(counter_info.stalled_cycles));
+    }
+    void LegionProfBinarySerializer::serialize(const LegionProfInstance::GPUActivityInfo& activity_info)
+    {
+      int ID = GPU_ACTIVITY_INFO_ID;
+      lp_fwrite(f, (char*)&ID, sizeof(ID));
+      lp_fwrite(f, (char*)&(activity_info.op_id),   sizeof(activity_info.op_id));
+      lp_fwrite(f, (char*)&(activity_info.proc_id), sizeof(activity_info.proc_id));
+      lp_fwrite(f, (char*)&(activity_info.stream),  sizeof(activity_info.stream));
+      lp_fwrite(f, (char*)&(activity_info.kind),    sizeof(activity_info.kind));
+      lp_fwrite(f, (char*)&(activity_info.bytes),   sizeof(activity_info.bytes));
+      lp_fwrite(f, (char*)&(activity_info.start),   sizeof(activity_info.start));
+      lp_fwrite(f, (char*)&(activity_info.stop),    sizeof(activity_info.stop));
+    }
     void LegionProfBinarySerializer::serialize(const LegionProfInstance::MetaInfo& meta_info)
     {
       int ID = META_INFO_ID;
@@ -442,6 +565,56 @@ namespace Legion {
       lp_fwrite(f, (char*)&(inst_timeline_info.create),  sizeof(inst_timeline_info.create));
       lp_fwrite(f, (char*)&(inst_timeline_info.destroy), sizeof(inst_timeline_info.destroy));
     }
+    void LegionProfBinarySerializer::serialize(const LegionProfInstance::InstFieldInfo& inst_field_info)
+    {
+      int ID = INST_FIELD_INFO_ID;
+      lp_fwrite(f, (char*)&ID, sizeof(ID));
+      lp_fwrite(f, (char*)&(inst_field_info.op_id),     sizeof(inst_field_info.op_id));
+      lp_fwrite(f, (char*)&(inst_field_info.inst_id),   sizeof(inst_field_info.inst_id));
+      lp_fwrite(f, (char*)&(inst_field_info.fspace_id), sizeof(inst_field_info.fspace_id));
+      lp_fwrite(f, (char*)&(inst_field_info.field_id),  sizeof(inst_field_info.field_id));
+      lp_fwrite(f, (char*)&(inst_field_info.size),      sizeof(inst_field_info.size));
+    }
+    void LegionProfBinarySerializer::serialize(const LegionProfInstance::InstDeletionInfo& inst_deletion_info)
+    {
+      int ID = INST_DELETION_INFO_ID;
+      lp_fwrite(f, (char*)&ID, sizeof(ID));
+      lp_fwrite(f, (char*)&(inst_deletion_info.inst_id), sizeof(inst_deletion_info.inst_id));
+      lp_fwrite(f, (char*)&(inst_deletion_info.mem_id),  sizeof(inst_deletion_info.mem_id));
+      lp_fwrite(f, (char*)&(inst_deletion_info.evicted), sizeof(inst_deletion_info.evicted));
+      lp_fwrite(f, (char*)&(inst_deletion_info.time),    sizeof(inst_deletion_info.time));
+    }
+    void LegionProfBinarySerializer::serialize(const LegionProfInstance::MemUsageInfo& mem_usage_info)
+    {
+      int ID = MEM_USAGE_INFO_ID;
+      lp_fwrite(f, (char*)&ID, sizeof(ID));
+      lp_fwrite(f, (char*)&(mem_usage_info.mem_id),       sizeof(mem_usage_info.mem_id));
+      lp_fwrite(f, (char*)&(mem_usage_info.mapper_id),    sizeof(mem_usage_info.mapper_id));
+      lp_fwrite(f, (char*)&(mem_usage_info.mapper_bytes), sizeof(mem_usage_info.mapper_bytes));
+      lp_fwrite(f, (char*)&(mem_usage_info.task_id),      sizeof(mem_usage_info.task_id));
+      lp_fwrite(f, (char*)&(mem_usage_info.task_bytes),   sizeof(mem_usage_info.task_bytes));
+      lp_fwrite(f, (char*)&(mem_usage_info.time),         sizeof(mem_usage_info.time));
+    }
+    void LegionProfBinarySerializer::serialize(const LegionProfInstance::TaskWindowInfo& task_window_info)
+    {
+      int ID = TASK_WINDOW_INFO_ID;
+      lp_fwrite(f, (char*)&ID, sizeof(ID));
+      lp_fwrite(f, (char*)&(task_window_info.op_id),         sizeof(task_window_info.op_id));
+      lp_fwrite(f, (char*)&(task_window_info.window_size),   sizeof(task_window_info.window_size));
+      lp_fwrite(f, (char*)&(task_window_info.analysis_lag),  sizeof(task_window_info.analysis_lag));
+      lp_fwrite(f, (char*)&(task_window_info.execution_lag), sizeof(task_window_info.execution_lag));
+      lp_fwrite(f, (char*)&(task_window_info.time),          sizeof(task_window_info.time));
+    }
+    void LegionProfBinarySerializer::serialize(const LegionProfInstance::RuntimeMemoryInfo& runtime_memory_info)
+    {
+      int ID = RUNTIME_MEMORY_INFO_ID;
+      lp_fwrite(f, (char*)&ID, sizeof(ID));
+      lp_fwrite(f, (char*)&(runtime_memory_info.node),        sizeof(runtime_memory_info.node));
+      lp_fwrite(f, (char*)&(runtime_memory_info.kind),        sizeof(runtime_memory_info.kind));
+      lp_fwrite(f, (char*)&(runtime_memory_info.bytes),       sizeof(runtime_memory_info.bytes));
+      lp_fwrite(f, (char*)&(runtime_memory_info.allocations), sizeof(runtime_memory_info.allocations));
+      lp_fwrite(f, (char*)&(runtime_memory_info.time),        sizeof(runtime_memory_info.time));
+    }
     void LegionProfBinarySerializer::serialize(const LegionProfInstance::MessageInfo& message_info)
     {
       int ID = MESSAGE_INFO_ID;
@@ -451,6 +624,17 @@ namespace Legion {
       lp_fwrite(f, (char*)&(message_info.stop),    sizeof(message_info.stop));
       lp_fwrite(f, (char*)&(message_info.proc_id), sizeof(message_info.proc_id));
     }
+    void LegionProfBinarySerializer::serialize(const LegionProfInstance::MessageStatsInfo& message_stats_info)
+    {
+      int ID = MESSAGE_STATS_INFO_ID;
+      lp_fwrite(f, (char*)&ID, sizeof(ID));
+      lp_fwrite(f, (char*)&(message_stats_info.source),      sizeof(message_stats_info.source));
+      lp_fwrite(f, (char*)&(message_stats_info.target),      sizeof(message_stats_info.target));
+      lp_fwrite(f, (char*)&(message_stats_info.kind),        sizeof(message_stats_info.kind));
+      lp_fwrite(f, (char*)&(message_stats_info.count),       sizeof(message_stats_info.count));
+      lp_fwrite(f, (char*)&(message_stats_info.total_bytes), sizeof(message_stats_info.total_bytes));
+      lp_fwrite(f, (char*)message_stats_info.latency,        sizeof(message_stats_info.latency));
+    }
     void LegionProfBinarySerializer::serialize(const LegionProfInstance::MapperCallInfo& mapper_call_info)
     {
       int ID = MAPPER_CALL_INFO_ID;
@@ -460,6 +644,9 @@ namespace Legion {
       lp_fwrite(f, (char*)&(mapper_call_info.start),   sizeof(mapper_call_info.start));
       lp_fwrite(f, (char*)&(mapper_call_info.stop),    sizeof(mapper_call_info.stop));
       lp_fwrite(f, (char*)&(mapper_call_info.proc_id), sizeof(mapper_call_info.proc_id));
+      lp_fwrite(f, (char*)&(mapper_call_info.mapper_id), sizeof(mapper_call_info.mapper_id));
+      lp_fwrite(f, (char*)&(mapper_call_info.mapper_proc), sizeof(mapper_call_info.mapper_proc));
+      lp_fwrite(f, (char*)&(mapper_call_info.wait),    sizeof(mapper_call_info.wait));
     }
     void LegionProfBinarySerializer::serialize(const LegionProfInstance::RuntimeCallInfo& runtime_call_info)
     {
@@ -483,6 +670,11 @@ namespace Legion {
     }
 #endif
 
+    void LegionProfBinarySerializer::flush(void)
+    {
+      lp_fflush(f, Z_SYNC_FLUSH);
+    }
+
     LegionProfBinarySerializer::~LegionProfBinarySerializer()
     {
       lp_fflush(f, Z_FULL_FLUSH);
@@ -537,6 +729,11 @@ namespace Legion {
       log_prof.print("Prof Mem Desc " IDFMT " %d %llu", mem_desc.mem_id, mem_desc.kind, mem_desc.capacity);
     }
 
+    void LegionProfASCIISerializer::serialize(const LegionProfDesc::AllocDesc &alloc_desc)
+    {
+      log_prof.print("Prof Alloc Desc %u %s", alloc_desc.kind, alloc_desc.name);
+    }
+
     void LegionProfASCIISerializer::serialize(const LegionProfInstance::TaskKind &task_kind)
     {
       log_prof.print("Prof Task Kind %u %s %d", task_kind.task_id, task_kind.name, 
@@ -585,6 +782,23 @@ namespace Legion {
          task_info.create, task_info.ready, task_info.start, task_info.stop);
     }
 
+    void LegionProfASCIISerializer::serialize(const LegionProfInstance::TaskCounterInfo& counter_info)
+    {
+      log_prof.print("Prof Task Counters %llu %lld %lld %lld %lld %lld %lld %lld",
+         counter_info.op_id, counter_info.instructions, counter_info.cycles,
+         counter_info.l2_accesses, counter_info.l2_misses,
+         counter_info.l3_accesses, counter_info.l3_misses,
+         counter_info.stalled_cycles);
+    }
+
+    void LegionProfASCIISerializer::serialize(const LegionProfInstance::GPUActivityInfo& activity_info)
+    {
+      log_prof.print("Prof GPU Activity %llu " IDFMT " %u %u %llu %llu %llu",
+         activity_info.op_id, activity_info.proc_id, activity_info.stream,
+         activity_info.kind, activity_info.bytes, activity_info.start,
+         activity_info.stop);
+    }
+
     void LegionProfASCIISerializer::serialize(const LegionProfInstance::MetaInfo& meta_info)
     {
       log_prof.print("Prof Meta Info %llu %u " IDFMT " %llu %llu %llu %llu",
@@ -626,17 +840,69 @@ namespace Legion {
          inst_timeline_info.create, inst_timeline_info.destroy);
     }
 
+    void LegionProfASCIISerializer::serialize(const LegionProfInstance::InstFieldInfo& inst_field_info)
+    {
+      log_prof.print("Prof Inst Field %llu " IDFMT " %u %u %llu",
+         inst_field_info.op_id, inst_field_info.inst_id,
+         inst_field_info.fspace_id, inst_field_info.field_id,
+         inst_field_info.size);
+    }
+
+    void LegionProfASCIISerializer::serialize(const LegionProfInstance::InstDeletionInfo& inst_deletion_info)
+    {
+      log_prof.print("Prof Inst Deletion " IDFMT " " IDFMT " %u %llu",
+         inst_deletion_info.inst_id, inst_deletion_info.mem_id,
+         inst_deletion_info.evicted, inst_deletion_info.time);
+    }
+
+    void LegionProfASCIISerializer::serialize(const LegionProfInstance::MemUsageInfo& mem_usage_info)
+    {
+      log_prof.print("Prof Mem Usage " IDFMT " %u %llu %u %llu %llu",
+         mem_usage_info.mem_id, mem_usage_info.mapper_id, 
+         mem_usage_info.mapper_bytes, mem_usage_info.task_id,
+         mem_usage_info.task_bytes, mem_usage_info.time);
+    }
+
+    void LegionProfASCIISerializer::serialize(const LegionProfInstance::TaskWindowInfo& task_window_info)
+    {
+      log_prof.print("Prof Task Window %llu %u %llu %llu %llu",
+         task_window_info.op_id, task_window_info.window_size,
+         task_window_info.analysis_lag, task_window_info.execution_lag,
+         task_window_info.time);
+    }
+
+    void LegionProfASCIISerializer::serialize(const LegionProfInstance::RuntimeMemoryInfo& runtime_memory_info)
+    {
+      log_prof.print("Prof Runtime Memory %u %u %llu %llu %llu",
+         runtime_memory_info.node, runtime_memory_info.kind,
+         runtime_memory_info.bytes, runtime_memory_info.allocations,
+         runtime_memory_info.time);
+    }
+
     void LegionProfASCIISerializer::serialize(const LegionProfInstance::MessageInfo& message_info)
     {
       log_prof.print("Prof Message Info %u " IDFMT " %llu %llu",
          message_info.kind, message_info.proc_id, message_info.start, message_info.stop);
     }
 
+    void LegionProfASCIISerializer::serialize(const LegionProfInstance::MessageStatsInfo& message_stats_info)
+    {
+      std::stringstream ss;
+      for (unsigned idx = 0; idx < LEGION_PROF_MESSAGE_BUCKETS; idx++)
+        ss << " " << message_stats_info.latency[idx];
+      log_prof.print("Prof Message Stats %u %u %u %llu %llu%s",
+         message_stats_info.source, message_stats_info.target,
+         message_stats_info.kind, message_stats_info.count,
+         message_stats_info.total_bytes, ss.str().c_str());
+    }
+
     void LegionProfASCIISerializer::serialize(const LegionProfInstance::MapperCallInfo& mapper_call_info)
     {
-      log_prof.print("Prof Mapper Call Info %u " IDFMT " %llu %llu %llu",
-         mapper_call_info.kind, mapper_call_info.proc_id, mapper_call_info.op_id,
-         mapper_call_info.start, mapper_call_info.stop);
+      log_prof.print("Prof Mapper Call Info %u " IDFMT " %llu %llu %llu %u " 
+         IDFMT " %llu", mapper_call_info.kind, mapper_call_info.proc_id, 
+         mapper_call_info.op_id, mapper_call_info.start, mapper_call_info.stop,
+         mapper_call_info.mapper_id, mapper_call_info.mapper_proc,
+         mapper_call_info.wait);
     }
 
     void LegionProfASCIISerializer::serialize(const LegionProfInstance::RuntimeCallInfo& runtime_call_info)
@@ -40,6 +40,8 @@ namespace Legion {
     public:
       LegionProfSerializer() {};
       virtual ~LegionProfSerializer() {};
+      // Called after each chunk of records is written out
+      virtual void flush(void) {};
 
       // You must override the following functions in your implementation
       virtual void serialize(const LegionProfDesc::MessageDesc&) = 0;
@@ -49,6 +51,7 @@ namespace Legion {
       virtual void serialize(const LegionProfDesc::OpDesc&) = 0;
       virtual void serialize(const LegionProfDesc::ProcDesc&) = 0;
       virtual void serialize(const LegionProfDesc::MemDesc&) = 0;
+      virtual void serialize(const LegionProfDesc::AllocDesc&) = 0;
       virtual void serialize(const LegionProfInstance::TaskKind&) = 0;
       virtual void serialize(const LegionProfInstance::TaskVariant&) = 0;
       virtual void serialize(const LegionProfInstance::OperationInstance&) = 0;
@@ -57,13 +60,21 @@ namespace Legion {
       virtual void serialize(const LegionProfInstance::WaitInfo, const LegionProfInstance::TaskInfo&) = 0;
       virtual void serialize(const LegionProfInstance::WaitInfo, const LegionProfInstance::MetaInfo&) = 0;
       virtual void serialize(const LegionProfInstance::TaskInfo&) = 0;
+      virtual void serialize(const LegionProfInstance::TaskCounterInfo&) = 0;
+      virtual void serialize(const LegionProfInstance::GPUActivityInfo&) = 0;
       virtual void serialize(const LegionProfInstance::MetaInfo&) = 0;
       virtual void serialize(const LegionProfInstance::CopyInfo&) = 0;
       virtual void serialize(const LegionProfInstance::FillInfo&) = 0;
       virtual void serialize(const LegionProfInstance::InstCreateInfo&) = 0;
       virtual void serialize(const LegionProfInstance::InstUsageInfo&) = 0;
       virtual void serialize(const LegionProfInstance::InstTimelineInfo&) = 0;
+      virtual void serialize(const LegionProfInstance::InstFieldInfo&) = 0;
+      virtual void serialize(const LegionProfInstance::InstDeletionInfo&) = 0;
+      virtual void serialize(const LegionProfInstance::MemUsageInfo&) = 0;
+      virtual void serialize(const LegionProfInstance::TaskWindowInfo&) = 0;
+      virtual void serialize(const LegionProfInstance::RuntimeMemoryInfo&) = 0;
       virtual void serialize(const LegionProfInstance::MessageInfo&) = 0;
+      virtual void serialize(const LegionProfInstance::MessageStatsInfo&) = 0;
       virtual void serialize(const LegionProfInstance::MapperCallInfo&) = 0;
       virtual void serialize(const LegionProfInstance::RuntimeCallInfo&) = 0;
 #ifdef LEGION_PROF_SELF_PROFILE
@@ -78,6 +89,8 @@ namespace Legion {
       ~LegionProfBinarySerializer();
 
       void writePreamble();
+      // Make each chunk of records a complete (compressed) block
+      virtual void flush(void);
 
       // Serialize Methods
       void serialize(const LegionProfDesc::MessageDesc&);
@@ -87,6 +100,7 @@ namespace Legion {
       void serialize(const LegionProfDesc::OpDesc&);
       void serialize(const LegionProfDesc::ProcDesc&);
       void serialize(const LegionProfDesc::MemDesc&);
+      void serialize(const LegionProfDesc::AllocDesc&);
       void serialize(const LegionProfInstance::TaskKind&);
       void serialize(const LegionProfInstance::TaskVariant&);
       void serialize(const LegionProfInstance::OperationInstance&);
@@ -95,13 +109,21 @@ namespace Legion {
       void serialize(const LegionProfInstance::WaitInfo, const LegionProfInstance::TaskInfo&);
       void serialize(const LegionProfInstance::WaitInfo, const LegionProfInstance::MetaInfo&);
       void serialize(const LegionProfInstance::TaskInfo&);
+      void serialize(const LegionProfInstance::TaskCounterInfo&);
+      void serialize(const LegionProfInstance::GPUActivityInfo&);
       void serialize(const LegionProfInstance::MetaInfo&);
       void serialize(const LegionProfInstance::CopyInfo&);
       void serialize(const LegionProfInstance::FillInfo&);
       void serialize(const LegionProfInstance::InstCreateInfo&);
       void serialize(const LegionProfInstance::InstUsageInfo&);
       void serialize(const LegionProfInstance::InstTimelineInfo&);
+      void serialize(const LegionProfInstance::InstFieldInfo&);
+      void serialize(const LegionProfInstance::InstDeletionInfo&);
+      void serialize(const LegionProfInstance::MemUsageInfo&);
+      void serialize(const LegionProfInstance::TaskWindowInfo&);
+      void serialize(const LegionProfInstance::RuntimeMemoryInfo&);
       void serialize(const LegionProfInstance::MessageInfo&);
+      void serialize(const LegionProfInstance::MessageStatsInfo&);
       void serialize(const LegionProfInstance::MapperCallInfo&);
       void serialize(const LegionProfInstance::RuntimeCallInfo&);
 #ifdef LEGION_PROF_SELF_PROFILE
@@ -121,6 +143,7 @@ namespace Legion {
         OP_DESC_ID,
         PROC_DESC_ID,
         MEM_DESC_ID,
+        ALLOC_DESC_ID,
         TASK_KIND_ID,
         TASK_VARIANT_ID,
         OPERATION_INSTANCE_ID,
@@ -135,9 +158,17 @@ namespace Legion {
         INST_CREATE_INFO_ID,
         INST_USAGE_INFO_ID,
         INST_TIMELINE_INFO_ID,
+        MEM_USAGE_INFO_ID,
+        TASK_WINDOW_INFO_ID,
+        RUNTIME_MEMORY_INFO_ID,
         MESSAGE_INFO_ID,
+        MESSAGE_STATS_INFO_ID,
         MAPPER_CALL_INFO_ID,
         RUNTIME_CALL_INFO_ID,
+        TASK_COUNTER_INFO_ID,
+        GPU_ACTIVITY_INFO_ID,
+        INST_FIELD_INFO_ID,
+        INST_DELETION_INFO_ID,
 #ifdef LEGION_PROF_SELF_PROFILE
         PROFTASK_INFO_ID
 #endif
@@ -158,6 +189,7 @@ namespace Legion {
       void serialize(const LegionProfDesc::OpDesc&);
       void serialize(const LegionProfDesc::ProcDesc&);
       void serialize(const LegionProfDesc::MemDesc&);
+      void serialize(const LegionProfDesc::AllocDesc&);
       void serialize(const LegionProfInstance::TaskKind&);
       void serialize(const LegionProfInstance::TaskVariant&);
       void serialize(const LegionProfInstance::OperationInstance&);
@@ -166,13 +198,21 @@ namespace Legion {
       void serialize(const LegionProfInstance::WaitInfo, const LegionProfInstance::TaskInfo&);
       void serialize(const LegionProfInstance::WaitInfo, const LegionProfInstance::MetaInfo&);
       void serialize(const LegionProfInstance::TaskInfo&);
+      void serialize(const LegionProfInstance::TaskCounterInfo&);
+      void serialize(const LegionProfInstance::GPUActivityInfo&);
       void serialize(const LegionProfInstance::MetaInfo&);
       void serialize(const LegionProfInstance::CopyInfo&);
       void serialize(const LegionProfInstance::FillInfo&);
       void serialize(const LegionProfInstance::InstCreateInfo&);
       void serialize(const LegionProfInstance::InstUsageInfo&);
       void serialize(const LegionProfInstance::InstTimelineInfo&);
+      void serialize(const LegionProfInstance::InstFieldInfo&);
+      void serialize(const LegionProfInstance::InstDeletionInfo&);
+      void serialize(const LegionProfInstance::MemUsageInfo&);
+      void serialize(const LegionProfInstance::TaskWindowInfo&);
+      void serialize(const LegionProfInstance::RuntimeMemoryInfo&);
       void serialize(const LegionProfInstance::MessageInfo&);
+      void serialize(const LegionProfInstance::MessageStatsInfo&);
       void serialize(const LegionProfInstance::MapperCallInfo&);
       void serialize(const LegionProfInstance::RuntimeCallInfo&);
 #ifdef LEGION_PROF_SELF_PROFILE
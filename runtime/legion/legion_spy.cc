@@ -19,8 +19,322 @@
 #include "legion_spy.h"
 #include "runtime.h"
 
+#include <stdarg.h>
+
 namespace Legion {
   namespace Internal {
+    namespace LegionSpy {
+
+      /////////////////////////////////////////////////////////////
+      // Binary Legion Spy Logging 
+      /////////////////////////////////////////////////////////////
+      // A binary log starts with the line "LegionSpyBinary 1 <node>"
+      // followed by blocks, each introduced by a single byte:
+      //   'F' u16 id, u16 length, argument types, u16 length, format
+      //       the first time any thread uses a format string; the
+      //       types are one character per conversion in the format
+      //       (i/I: int/unsigned, q/Q: 64-bit signed/unsigned, 
+      //        d: double, s: interned string)
+      //   'C' u32 thread, u32 length, records
+      //       a chunk of one thread's buffer, where each record is a 
+      //       u16 format id followed by its raw arguments, and strings
+      //       are u32 ids that the same thread defined earlier with a
+      //       record of format id 0: u32 id, u16 length, characters
+      // Formatting is left entirely to the reader, so logging a record
+      // costs a lookup of its format and copying its arguments.
+
+      static const size_t BINARY_CHUNK_SIZE = 1 << 16;
+
+      struct BinaryFormat {
+      public:
+        unsigned short id;
+        std::string types;
+      };
+
+      struct BinaryThreadLog {
+      public:
+        unsigned thread;
+        std::vector<char> buffer;
+        std::map<const char*,const BinaryFormat*> formats;
+        std::map<std::string,unsigned> strings;
+      };
+
+      static LocalLock binary_lock;
+      static FILE *binary_file = NULL;
+      static std::map<const char*,BinaryFormat*> binary_formats;
+      static std::vector<BinaryThreadLog*> binary_thread_logs;
+      static __thread BinaryThreadLog *binary_thread_log = NULL;
+
+      //------------------------------------------------------------------------
+      static void compute_format_types(const char *fmt, std::string &types)
+      //------------------------------------------------------------------------
+      {
+        for (const char *p = fmt; *p != '\0'; p++)
+        {
+          if (*p != '%')
+            continue;
+          p++;
+          if (*p == '%')
+            continue;
+          // Skip flags, width, and precision
+          while ((*p != '\0') && (strchr("-+ #0123456789.", *p) != NULL))
+            p++;
+          bool wide = false;
+          while ((*p == 'l') || (*p == 'z') || (*p == 'j') || 
+                 (*p == 't') || (*p == 'h'))
+          {
+            if (*p != 'h')
+              wide = true;
+            p++;
+          }
+          switch (*p)
+          {
+            case 'd':
+            case 'i':
+            case 'c':
+              types.push_back(wide ? 'q' : 'i');
+              break;
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+              types.push_back(wide ? 'Q' : 'I');
+              break;
+            case 'p':
+              types.push_back('Q');
+              break;
+            case 'f':
+            case 'e':
+            case 'g':
+              types.push_back('d');
+              break;
+            case 's':
+              types.push_back('s');
+              break;
+            default:
+              assert(false); // unsupported conversion
+          }
+        }
+      }
+
+      //------------------------------------------------------------------------
+      static void write_binary_chunk(BinaryThreadLog *log)
+      //------------------------------------------------------------------------
+      {
+        // Called with the binary lock held
+        if (log->buffer.empty())
+          return;
+        const unsigned length = log->buffer.size();
+        fputc('C', binary_file);
+        fwrite(&log->thread, sizeof(log->thread), 1, binary_file);
+        fwrite(&length, sizeof(length), 1, binary_file);
+        fwrite(&log->buffer[0], 1, length, binary_file);
+        log->buffer.clear();
+      }
+
+      //------------------------------------------------------------------------
+      static const BinaryFormat* find_binary_format(BinaryThreadLog *log,
+                                                    const char *fmt)
+      //------------------------------------------------------------------------
+      {
+        std::map<const char*,const BinaryFormat*>::const_iterator finder = 
+          log->formats.find(fmt);
+        if (finder != log->formats.end())
+          return finder->second;
+        const BinaryFormat *result = NULL;
+        {
+          AutoLock b_lock(binary_lock);
+          std::map<const char*,BinaryFormat*>::const_iterator global = 
+            binary_formats.find(fmt);
+          if (global == binary_formats.end())
+          {
+            BinaryFormat *format = new BinaryFormat();
+            // Id zero is reserved for string definitions
+            format->id = binary_formats.size() + 1;
+            compute_format_types(fmt, format->types);
+            binary_formats[fmt] = format;
+            // Formats go straight to the file (or wait for it to be opened)
+            // so they always precede the chunks that use them
+            if (binary_file != NULL)
+            {
+              const unsigned short types_length = format->types.size();
+              const unsigned short fmt_length = strlen(fmt);
+              fputc('F', binary_file);
+              fwrite(&format->id, sizeof(format->id), 1, binary_file);
+              fwrite(&types_length, sizeof(types_length), 1, binary_file);
+              fwrite(format->types.c_str(), 1, types_length, binary_file);
+              fwrite(&fmt_length, sizeof(fmt_length), 1, binary_file);
+              fwrite(fmt, 1, fmt_length, binary_file);
+            }
+            result = format;
+          }
+          else
+            result = global->second;
+        }
+        log->formats[fmt] = result;
+        return result;
+      }
+
+      template<typename T>
+      static inline void append_binary(std::vector<char> &buffer, T value)
+      {
+        const char *bytes = (const char*)&value;
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(value));
+      }
+
+      //------------------------------------------------------------------------
+      static void log_binary(const char *fmt, va_list args)
+      //------------------------------------------------------------------------
+      {
+        BinaryThreadLog *log = binary_thread_log;
+        if (log == NULL)
+        {
+          log = new BinaryThreadLog();
+          log->buffer.reserve(BINARY_CHUNK_SIZE);
+          AutoLock b_lock(binary_lock);
+          log->thread = binary_thread_logs.size();
+          binary_thread_logs.push_back(log);
+          binary_thread_log = log;
+        }
+        const BinaryFormat *format = find_binary_format(log, fmt);
+        std::vector<char> &buffer = log->buffer;
+        // Strings are defined ahead of the record that uses them
+        const size_t record_start = buffer.size();
+        append_binary(buffer, format->id);
+        for (std::string::const_iterator it = format->types.begin();
+              it != format->types.end(); it++)
+        {
+          switch (*it)
+          {
+            case 'i':
+              append_binary(buffer, va_arg(args, int));
+              break;
+            case 'I':
+              append_binary(buffer, va_arg(args, unsigned));
+              break;
+            case 'q':
+              append_binary(buffer, va_arg(args, long long));
+              break;
+            case 'Q':
+              append_binary(buffer, va_arg(args, unsigned long long));
+              break;
+            case 'd':
+              append_binary(buffer, va_arg(args, double));
+              break;
+            case 's':
+              {
+                const char *str = va_arg(args, const char*);
+                std::string name((str == NULL) ? "(null)" : str);
+                std::map<std::string,unsigned>::const_iterator finder = 
+                  log->strings.find(name);
+                unsigned string_id;
+                if (finder == log->strings.end())
+                {
+                  string_id = log->strings.size();
+                  log->strings[name] = string_id;
+                  std::vector<char> definition;
+                  append_binary(definition, (unsigned short)0);
+                  append_binary(definition, string_id);
+                  append_binary(definition, (unsigned short)name.size());
+                  definition.insert(definition.end(), 
+                                    name.begin(), name.end());
+                  buffer.insert(buffer.begin() + record_start,
+                                definition.begin(), definition.end());
+                }
+                else
+                  string_id = finder->second;
+                append_binary(buffer, string_id);
+                break;
+              }
+            default:
+              assert(false);
+          }
+        }
+        if ((buffer.size() >= BINARY_CHUNK_SIZE) && (binary_file != NULL))
+        {
+          AutoLock b_lock(binary_lock);
+          if (binary_file != NULL)
+            write_binary_chunk(log);
+        }
+      }
+
+      //------------------------------------------------------------------------
+      void spy_print(const char *fmt, ...)
+      //------------------------------------------------------------------------
+      {
+        va_list args;
+        va_start(args, fmt);
+        if (Runtime::legion_spy_logfile != NULL)
+          log_binary(fmt, args);
+        else
+          log_spy.print().vprintf(fmt, args);
+        va_end(args);
+      }
+
+      //------------------------------------------------------------------------
+      void open_binary_log(const char *filename, AddressSpaceID node)
+      //------------------------------------------------------------------------
+      {
+        std::string name(filename);
+        size_t pct = name.find_first_of('%', 0);
+        if (pct == std::string::npos)
+        {
+          fprintf(stderr, "ERROR: The Legion Spy logfile name must contain "
+                          "'%%' which will be replaced with the node id\n");
+          exit(-1);
+        }
+        std::stringstream ss;
+        ss << name.substr(0, pct) << node << name.substr(pct + 1);
+        AutoLock b_lock(binary_lock);
+        // With separate runtime instances every instance shares the file
+        if (binary_file != NULL)
+          return;
+        binary_file = fopen(ss.str().c_str(), "wb");
+        if (binary_file == NULL)
+        {
+          fprintf(stderr, "ERROR: Unable to open Legion Spy logfile %s\n",
+                  ss.str().c_str());
+          exit(-1);
+        }
+        fprintf(binary_file, "LegionSpyBinary 1 %d\n", node);
+        // Write out the formats that were used before the file was opened
+        std::vector<std::pair<unsigned short,const char*> > early;
+        for (std::map<const char*,BinaryFormat*>::const_iterator it = 
+              binary_formats.begin(); it != binary_formats.end(); it++)
+          early.push_back(std::pair<unsigned short,const char*>(
+                                            it->second->id, it->first));
+        std::sort(early.begin(), early.end());
+        for (unsigned idx = 0; idx < early.size(); idx++)
+        {
+          const BinaryFormat *format = binary_formats[early[idx].second];
+          const unsigned short types_length = format->types.size();
+          const unsigned short fmt_length = strlen(early[idx].second);
+          fputc('F', binary_file);
+          fwrite(&format->id, sizeof(format->id), 1, binary_file);
+          fwrite(&types_length, sizeof(types_length), 1, binary_file);
+          fwrite(format->types.c_str(), 1, types_length, binary_file);
+          fwrite(&fmt_length, sizeof(fmt_length), 1, binary_file);
+          fwrite(early[idx].second, 1, fmt_length, binary_file);
+        }
+      }
+
+      //------------------------------------------------------------------------
+      void close_binary_log(void)
+      //------------------------------------------------------------------------
+      {
+        AutoLock b_lock(binary_lock);
+        if (binary_file == NULL)
+          return;
+        // Everything has stopped logging by now, so the buffers of the
+        // other threads are safe to drain
+        for (std::vector<BinaryThreadLog*>::const_iterator it = 
+              binary_thread_logs.begin(); it != binary_thread_logs.end(); it++)
+          write_binary_chunk(*it);
+        fclose(binary_file);
+        binary_file = NULL;
+      }
+
+    }; // namespace LegionSpy
 
     //--------------------------------------------------------------------------
     TreeStateLogger::TreeStateLogger(void)
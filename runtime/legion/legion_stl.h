@@ -19,6 +19,7 @@
 #include <set>
 #include <map>
 #include <vector>
+#include <algorithm>
 #include "legion.h"
 
 namespace Legion {
@@ -1185,6 +1186,84 @@ namespace Legion {
     static T raw_dense_task_wrapper(const Task *task, 
        const std::vector<PhysicalRegion>& regions, Context ctx, Runtime *runtime);
 
+    /*
+     * A region-backed vector: a one-dimensional array of elements of
+     * type T stored in a single field of a logical region and blocked
+     * into equal pieces by a disjoint partition. The handles are only
+     * valid in the task that created the vector, and the elements must
+     * be trivially copyable. The parallel algorithms below launch one
+     * point task per piece.
+     */
+    template<typename T>
+    class RegionVector {
+    public:
+      RegionVector(Context ctx, Runtime *runtime, 
+                   size_t size, size_t pieces = 1);
+    public:
+      void destroy(void);
+    public:
+      inline size_t size(void) const { return num_elements; }
+      inline size_t num_pieces(void) const { return pieces; }
+      inline FieldID get_field(void) const { return fid; }
+      inline LogicalRegion get_region(void) const { return region; }
+      inline LogicalPartition get_partition(void) const { return partition; }
+      inline Domain get_launch_domain(void) const { return color_domain; }
+    public:
+      void fill(const T &value);
+      void copy_from(const std::vector<T> &values);
+      void copy_to(std::vector<T> &values) const;
+    protected:
+      Context ctx;
+      Runtime *runtime;
+      size_t num_elements, pieces;
+      FieldID fid;
+      LogicalRegion region;
+      LogicalPartition partition;
+      Domain color_domain;
+    };
+
+    /*
+     * Parallel algorithms on region-backed vectors, performed as index
+     * launches over the pieces of the vector. The tasks that implement
+     * them are templates which must be preregistered on every node
+     * before Runtime::start with the corresponding register function;
+     * the returned task ID is then passed to the algorithm. Functors,
+     * comparators and reduction operators are passed to the tasks by
+     * value and so must be trivially copyable.
+     */
+
+    // dst[i] = functor(src[i]), or src[i] = functor(src[i]) in place
+    // using a task registered for <T,T,F>
+    template<typename T, typename U, typename F>
+    static TaskID register_transform_task(const char *task_name = NULL);
+
+    template<typename T, typename U, typename F>
+    static void transform(Context ctx, Runtime *runtime, TaskID task_id,
+                          const RegionVector<T> &src, RegionVector<U> &dst,
+                          const F &functor);
+
+    template<typename T, typename F>
+    static void transform(Context ctx, Runtime *runtime, TaskID task_id,
+                          RegionVector<T> &vec, const F &functor);
+
+    // Folds all the elements with REDOP, which must also have been
+    // registered with Runtime::register_reduction_op as redop_id
+    template<typename T, typename REDOP>
+    static TaskID register_reduce_task(const char *task_name = NULL);
+
+    template<typename T, typename REDOP>
+    static typename REDOP::RHS reduce(Context ctx, Runtime *runtime, 
+                                      TaskID task_id, ReductionOpID redop_id,
+                                      const RegionVector<T> &vec);
+
+    // Sorts each piece in parallel and then merges the sorted pieces
+    template<typename T, typename COMPARE>
+    static TaskID register_sort_task(const char *task_name = NULL);
+
+    template<typename T, typename COMPARE>
+    static void sort(Context ctx, Runtime *runtime, TaskID task_id,
+                     RegionVector<T> &vec, const COMPARE &compare);
+
   }; // namespace STL
 }; // namespace Legion
 
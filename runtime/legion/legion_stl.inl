@@ -2309,6 +2309,328 @@ namespace Legion {
 
 #undef GET_RAW_POINTERS
 #undef GET_DENSE_POINTERS
+
+    template<typename T>
+    RegionVector<T>::RegionVector(Context c, Runtime *rt, 
+                                  size_t size, size_t p)
+      : ctx(c), runtime(rt), num_elements(size), pieces(p)
+    {
+      assert(pieces > 0);
+      assert(pieces <= num_elements);
+      LegionRuntime::Arrays::Rect<1> bounds(
+          LegionRuntime::Arrays::Point<1>(0),
+          LegionRuntime::Arrays::Point<1>(num_elements - 1));
+      IndexSpace is = runtime->create_index_space(ctx, 
+                                Domain::from_rect<1>(bounds));
+      FieldSpace fs = runtime->create_field_space(ctx);
+      {
+        FieldAllocator allocator = runtime->create_field_allocator(ctx, fs);
+        fid = allocator.allocate_field(sizeof(T));
+      }
+      region = runtime->create_logical_region(ctx, is, fs);
+      LegionRuntime::Arrays::Rect<1> colors(
+          LegionRuntime::Arrays::Point<1>(0),
+          LegionRuntime::Arrays::Point<1>(pieces - 1));
+      color_domain = Domain::from_rect<1>(colors);
+      IndexPartition ip = 
+        runtime->create_equal_partition(ctx, is, color_domain);
+      partition = runtime->get_logical_partition(ctx, region, ip);
+    }
+
+    template<typename T>
+    void RegionVector<T>::destroy(void)
+    {
+      runtime->destroy_logical_region(ctx, region);
+      runtime->destroy_field_space(ctx, region.get_field_space());
+      runtime->destroy_index_space(ctx, region.get_index_space());
+    }
+
+    template<typename T>
+    void RegionVector<T>::fill(const T &value)
+    {
+      runtime->fill_field<T>(ctx, region, region, fid, value);
+    }
+
+    template<typename T>
+    void RegionVector<T>::copy_from(const std::vector<T> &values)
+    {
+      assert(values.size() == num_elements);
+      InlineLauncher launcher(
+          RegionRequirement(region, WRITE_DISCARD, EXCLUSIVE, region));
+      launcher.add_field(fid);
+      PhysicalRegion pr = runtime->map_region(ctx, launcher);
+      pr.wait_until_valid();
+      LegionRuntime::Accessor::RegionAccessor<
+        LegionRuntime::Accessor::AccessorType::Generic,T> acc = 
+        pr.get_field_accessor(fid).template typeify<T>();
+      for (size_t idx = 0; idx < num_elements; idx++)
+        acc.write(DomainPoint::from_point<1>(
+              LegionRuntime::Arrays::Point<1>(idx)), values[idx]);
+      runtime->unmap_region(ctx, pr);
+    }
+
+    template<typename T>
+    void RegionVector<T>::copy_to(std::vector<T> &values) const
+    {
+      values.resize(num_elements);
+      InlineLauncher launcher(
+          RegionRequirement(region, READ_ONLY, EXCLUSIVE, region));
+      launcher.add_field(fid);
+      PhysicalRegion pr = runtime->map_region(ctx, launcher);
+      pr.wait_until_valid();
+      LegionRuntime::Accessor::RegionAccessor<
+        LegionRuntime::Accessor::AccessorType::Generic,T> acc = 
+        pr.get_field_accessor(fid).template typeify<T>();
+      for (size_t idx = 0; idx < num_elements; idx++)
+        values[idx] = acc.read(DomainPoint::from_point<1>(
+              LegionRuntime::Arrays::Point<1>(idx)));
+      runtime->unmap_region(ctx, pr);
+    }
+
+    namespace Detail {
+      // Vectors have a single field, so dense instances are arrays
+      template<typename T>
+      static inline T* get_dense_array(const Task *task, unsigned index,
+          const std::vector<PhysicalRegion> &regions, 
+          Runtime *runtime, Context ctx, size_t &count)
+      {
+        std::vector<T*> ptrs(1, NULL);
+        ByteOffset offset;
+        get_dense_pointers<T,1>(task->regions[index], regions[index],
+                                ptrs, offset, runtime, ctx);
+        assert(offset == ByteOffset((int)sizeof(T)));
+        count = runtime->get_index_space_domain(
+            task->regions[index].region.get_index_space()).get_volume();
+        return ptrs[0];
+      }
+
+      template<typename T, typename U, typename F>
+      struct TransformInPlace {
+        static inline void apply(T *data, size_t count, const F &functor)
+        {
+          // Only tasks registered for <T,T,F> can transform in place
+          assert(false);
+        }
+      };
+
+      template<typename T, typename F>
+      struct TransformInPlace<T,T,F> {
+        static inline void apply(T *data, size_t count, const F &functor)
+        {
+          for (size_t idx = 0; idx < count; idx++)
+            data[idx] = functor(data[idx]);
+        }
+      };
+
+      template<typename T, typename U, typename F>
+      struct TransformTask {
+        static void cpu_variant(const Task *task,
+            const std::vector<PhysicalRegion> &regions, 
+            Context ctx, Runtime *runtime)
+        {
+          assert(task->arglen == sizeof(F));
+          const F &functor = *(const F*)task->args;
+          size_t count;
+          T *src = get_dense_array<T>(task, 0, regions, runtime, ctx, count);
+          if (regions.size() == 1)
+          {
+            TransformInPlace<T,U,F>::apply(src, count, functor);
+            return;
+          }
+          size_t dst_count;
+          U *dst = get_dense_array<U>(task, 1, regions, runtime, ctx,
+                                      dst_count);
+          assert(count == dst_count);
+          for (size_t idx = 0; idx < count; idx++)
+            dst[idx] = functor(src[idx]);
+        }
+      };
+
+      template<typename T, typename REDOP>
+      struct ReduceTask {
+        static typename REDOP::RHS cpu_variant(const Task *task,
+            const std::vector<PhysicalRegion> &regions, 
+            Context ctx, Runtime *runtime)
+        {
+          size_t count;
+          const T *data = 
+            get_dense_array<T>(task, 0, regions, runtime, ctx, count);
+          typename REDOP::RHS result = REDOP::identity;
+          for (size_t idx = 0; idx < count; idx++)
+            REDOP::template fold<true>(result, data[idx]);
+          return result;
+        }
+      };
+
+      template<typename T, typename COMPARE>
+      struct SortTask {
+        // The point tasks sort their pieces, then a single task merges 
+        // the sorted pieces whose offsets follow the comparator in the
+        // task arguments
+        static void cpu_variant(const Task *task,
+            const std::vector<PhysicalRegion> &regions, 
+            Context ctx, Runtime *runtime)
+        {
+          Deserializer derez(task->args, task->arglen);
+          COMPARE compare;
+          derez.deserialize(compare);
+          size_t count;
+          T *data = get_dense_array<T>(task, 0, regions, runtime, ctx, count);
+          if (task->is_index_space)
+          {
+            std::sort(data, data + count, compare);
+            return;
+          }
+          size_t num_bounds;
+          derez.deserialize(num_bounds);
+          std::vector<size_t> bounds(num_bounds);
+          for (unsigned idx = 0; idx < num_bounds; idx++)
+            derez.deserialize(bounds[idx]);
+          // Merge neighbouring runs pairwise until one run is left
+          while (bounds.size() > 2)
+          {
+            std::vector<size_t> merged;
+            unsigned idx = 0;
+            for ( ; (idx + 2) < bounds.size(); idx += 2)
+            {
+              std::inplace_merge(data + bounds[idx], data + bounds[idx+1],
+                                 data + bounds[idx+2], compare);
+              merged.push_back(bounds[idx]);
+            }
+            for ( ; idx < bounds.size(); idx++)
+              merged.push_back(bounds[idx]);
+            bounds.swap(merged);
+          }
+        }
+      };
+    };
+
+    template<typename T, typename U, typename F>
+    static TaskID register_transform_task(const char *task_name)
+    {
+      TaskID task_id = Runtime::generate_static_task_id();
+      TaskVariantRegistrar registrar(task_id, task_name);
+      registrar.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
+      registrar.set_leaf();
+      Runtime::preregister_task_variant<
+        Detail::TransformTask<T,U,F>::cpu_variant>(registrar, task_name);
+      return task_id;
+    }
+
+    template<typename T, typename U, typename F>
+    static void transform(Context ctx, Runtime *runtime, TaskID task_id,
+                          const RegionVector<T> &src, RegionVector<U> &dst,
+                          const F &functor)
+    {
+      // Equal partitions of the same size and number of pieces agree
+      assert(src.size() == dst.size());
+      assert(src.num_pieces() == dst.num_pieces());
+      IndexLauncher launcher(task_id, src.get_launch_domain(),
+                     TaskArgument(&functor, sizeof(functor)), ArgumentMap());
+      launcher.add_region_requirement(
+          RegionRequirement(src.get_partition(), 0/*identity projection*/,
+                            READ_ONLY, EXCLUSIVE, src.get_region()));
+      launcher.region_requirements[0].add_field(src.get_field());
+      launcher.add_region_requirement(
+          RegionRequirement(dst.get_partition(), 0/*identity projection*/,
+                            WRITE_DISCARD, EXCLUSIVE, dst.get_region()));
+      launcher.region_requirements[1].add_field(dst.get_field());
+      runtime->execute_index_space(ctx, launcher);
+    }
+
+    template<typename T, typename F>
+    static void transform(Context ctx, Runtime *runtime, TaskID task_id,
+                          RegionVector<T> &vec, const F &functor)
+    {
+      IndexLauncher launcher(task_id, vec.get_launch_domain(),
+                     TaskArgument(&functor, sizeof(functor)), ArgumentMap());
+      launcher.add_region_requirement(
+          RegionRequirement(vec.get_partition(), 0/*identity projection*/,
+                            READ_WRITE, EXCLUSIVE, vec.get_region()));
+      launcher.region_requirements[0].add_field(vec.get_field());
+      runtime->execute_index_space(ctx, launcher);
+    }
+
+    template<typename T, typename REDOP>
+    static TaskID register_reduce_task(const char *task_name)
+    {
+      TaskID task_id = Runtime::generate_static_task_id();
+      TaskVariantRegistrar registrar(task_id, task_name);
+      registrar.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
+      registrar.set_leaf();
+      Runtime::preregister_task_variant<typename REDOP::RHS,
+        Detail::ReduceTask<T,REDOP>::cpu_variant>(registrar, task_name);
+      return task_id;
+    }
+
+    template<typename T, typename REDOP>
+    static typename REDOP::RHS reduce(Context ctx, Runtime *runtime, 
+                                      TaskID task_id, ReductionOpID redop_id,
+                                      const RegionVector<T> &vec)
+    {
+      IndexLauncher launcher(task_id, vec.get_launch_domain(),
+                             TaskArgument(), ArgumentMap());
+      launcher.add_region_requirement(
+          RegionRequirement(vec.get_partition(), 0/*identity projection*/,
+                            READ_ONLY, EXCLUSIVE, vec.get_region()));
+      launcher.region_requirements[0].add_field(vec.get_field());
+      Future result = runtime->execute_index_space(ctx, launcher, redop_id);
+      return result.get_result<typename REDOP::RHS>();
+    }
+
+    template<typename T, typename COMPARE>
+    static TaskID register_sort_task(const char *task_name)
+    {
+      TaskID task_id = Runtime::generate_static_task_id();
+      TaskVariantRegistrar registrar(task_id, task_name);
+      registrar.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
+      registrar.set_leaf();
+      Runtime::preregister_task_variant<
+        Detail::SortTask<T,COMPARE>::cpu_variant>(registrar, task_name);
+      return task_id;
+    }
+
+    template<typename T, typename COMPARE>
+    static void sort(Context ctx, Runtime *runtime, TaskID task_id,
+                     RegionVector<T> &vec, const COMPARE &compare)
+    {
+      std::vector<size_t> bounds;
+      for (Domain::DomainPointIterator itr(vec.get_launch_domain()); 
+            itr; itr++)
+      {
+        LogicalRegion piece = runtime->get_logical_subregion_by_color(ctx,
+                                      vec.get_partition(), itr.p);
+        Domain piece_domain = runtime->get_index_space_domain(ctx, 
+                                      piece.get_index_space());
+        bounds.push_back(piece_domain.get_rect<1>().lo[0]);
+      }
+      std::sort(bounds.begin(), bounds.end());
+      bounds.push_back(vec.size());
+      Serializer rez;
+      rez.serialize(compare);
+      rez.serialize<size_t>(bounds.size());
+      for (unsigned idx = 0; idx < bounds.size(); idx++)
+        rez.serialize(bounds[idx]);
+      TaskArgument args(rez.get_buffer(), rez.get_used_bytes());
+      {
+        IndexLauncher launcher(task_id, vec.get_launch_domain(),
+                               args, ArgumentMap());
+        launcher.add_region_requirement(
+            RegionRequirement(vec.get_partition(), 0/*identity projection*/,
+                              READ_WRITE, EXCLUSIVE, vec.get_region()));
+        launcher.region_requirements[0].add_field(vec.get_field());
+        runtime->execute_index_space(ctx, launcher);
+      }
+      if (vec.num_pieces() > 1)
+      {
+        TaskLauncher launcher(task_id, args);
+        launcher.add_region_requirement(
+            RegionRequirement(vec.get_region(), READ_WRITE, EXCLUSIVE,
+                              vec.get_region()));
+        launcher.region_requirements[0].add_field(vec.get_field());
+        runtime->execute_task(ctx, launcher);
+      }
+    }
   }; 
 };
 
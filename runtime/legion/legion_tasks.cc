@@ -379,13 +379,14 @@ namespace Legion {
 
     //--------------------------------------------------------------------------
     ExternalTask::ExternalTask(void)
-      : Task(), arg_manager(NULL)
+      : Task(), arg_manager(NULL), shared_args(false), arg_hash(0)
     //--------------------------------------------------------------------------
     {
     }
 
     //--------------------------------------------------------------------------
-    void ExternalTask::pack_external_task(Serializer &rez,AddressSpaceID target)
+    void ExternalTask::pack_external_task(Serializer &rez,AddressSpaceID target,
+                                          Runtime *runtime)
     //--------------------------------------------------------------------------
     {
       RezCheck z(rez);
@@ -411,7 +412,28 @@ namespace Legion {
         pack_phase_barrier(arrive_barriers[idx], rez);
       rez.serialize<bool>((arg_manager != NULL));
       rez.serialize(arglen);
-      rez.serialize(args,arglen);
+      if (arglen > 0)
+      {
+        // Shared buffers only need to be sent to each node once
+        bool pin = false;
+        if (shared_args && 
+            runtime->check_shared_argument_sent(target, arg_hash, arglen, pin))
+        {
+          rez.serialize(HASHED_ARGUMENTS);
+          rez.serialize(arg_hash);
+        }
+        else if (pin)
+        {
+          rez.serialize(PINNED_ARGUMENTS);
+          rez.serialize(arg_hash);
+          rez.serialize(args,arglen);
+        }
+        else
+        {
+          rez.serialize(INLINE_ARGUMENTS);
+          rez.serialize(args,arglen);
+        }
+      }
       rez.serialize(map_id);
       rez.serialize(tag);
       rez.serialize(is_index_space);
@@ -475,7 +497,23 @@ namespace Legion {
       derez.deserialize(arglen);
       if (arglen > 0)
       {
-        if (has_arg_manager)
+        ArgumentMode mode;
+        derez.deserialize(mode);
+        if (mode != INLINE_ARGUMENTS)
+        {
+#ifdef DEBUG_LEGION
+          assert(arg_manager == NULL);
+#endif
+          derez.deserialize(arg_hash);
+          if (mode == PINNED_ARGUMENTS)
+            arg_manager = 
+              runtime->register_remote_shared_argument(arg_hash, arglen, derez);
+          else
+            arg_manager = runtime->find_remote_shared_argument(arg_hash,arglen);
+          shared_args = true;
+          args = arg_manager->get_allocation();
+        }
+        else if (has_arg_manager)
         {
 #ifdef DEBUG_LEGION
           assert(arg_manager == NULL);
@@ -483,10 +521,13 @@ namespace Legion {
           arg_manager = new AllocManager(arglen);
           arg_manager->add_reference();
           args = arg_manager->get_allocation();
+          derez.deserialize(args,arglen);
         }
         else
+        {
           args = legion_malloc(TASK_ARGS_ALLOC, arglen);
-        derez.deserialize(args,arglen);
+          derez.deserialize(args,arglen);
+        }
       }
       derez.deserialize(map_id);
       derez.deserialize(tag);
@@ -731,6 +772,7 @@ namespace Legion {
       false_guard = PredEvent::NO_PRED_EVENT;
       local_cached = false;
       arg_manager = NULL;
+      shared_args = false;
       target_proc = Processor::NO_PROC;
       mapper = NULL;
       must_epoch = NULL;
@@ -784,13 +826,47 @@ namespace Legion {
       must_epoch_index = index;
     }
 
+    //--------------------------------------------------------------------------
+    void TaskOp::initialize_arguments(const void *src, size_t size, 
+                                      bool managed)
+    //--------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(args == NULL);
+      assert(arg_manager == NULL);
+#endif
+      arglen = size;
+      if (arglen == 0)
+        return;
+      if ((Runtime::shared_argument_threshold > 0) &&
+          (arglen >= Runtime::shared_argument_threshold))
+      {
+        // Large arguments go in an immutable buffer that is shared
+        // with any other launches using the same argument bytes
+        arg_manager = 
+          runtime->find_or_create_shared_argument(src, arglen, arg_hash);
+        shared_args = true;
+        args = arg_manager->get_allocation();
+        return;
+      }
+      if (managed)
+      {
+        arg_manager = new AllocManager(arglen);
+        arg_manager->add_reference();
+        args = arg_manager->get_allocation();
+      }
+      else
+        args = legion_malloc(TASK_ARGS_ALLOC, arglen);
+      memcpy(args, src, arglen);
+    }
+
     //--------------------------------------------------------------------------
     void TaskOp::pack_base_task(Serializer &rez, AddressSpaceID target)
     //--------------------------------------------------------------------------
     {
       DETAILED_PROFILER(runtime, PACK_BASE_TASK_CALL);
       // pack all the user facing data first
-      pack_external_task(rez, target); 
+      pack_external_task(rez, target, runtime); 
       RezCheck z(rez);
 #ifdef DEBUG_LEGION
       assert(regions.size() == parent_req_indexes.size());
@@ -1024,6 +1100,20 @@ namespace Legion {
       return regions.size();
     }
 
+    //--------------------------------------------------------------------------
+    bool TaskOp::find_dependence_trees(std::set<RegionTreeID> &trees) const
+    //--------------------------------------------------------------------------
+    {
+      // Traces, must epochs, predicates and futures all tie us to
+      // operations that might not be in the same lanes
+      if ((trace != NULL) || (must_epoch != NULL) || is_predicated_op() ||
+          !futures.empty())
+        return false;
+      for (unsigned idx = 0; idx < regions.size(); idx++)
+        trees.insert(regions[idx].parent.get_tree_id());
+      return true;
+    }
+
     //--------------------------------------------------------------------------
     Mappable* TaskOp::get_mappable(void)
     //--------------------------------------------------------------------------
@@ -1084,6 +1174,7 @@ namespace Legion {
       {
         value = output.speculative_value;
         mapping_only = output.speculate_mapping_only;
+        speculation_mapper = mapper;
         if (!mapping_only)
         {
           MessageDescriptor MAPPER_REQUESTED_EXECUTION(2301, "undefined");
@@ -1855,6 +1946,8 @@ namespace Legion {
           this->arg_manager = rhs->arg_manager; 
           this->arg_manager->add_reference();
           this->args = arg_manager->get_allocation();
+          this->shared_args = rhs->shared_args;
+          this->arg_hash = rhs->arg_hash;
         }
       }
       else if (arglen > 0)
@@ -2445,6 +2538,8 @@ namespace Legion {
       selected_variant = 0;
       task_priority = 0;
       perform_postmap = false;
+      batched_mapper = NULL;
+      batched_mapping = NULL;
       execution_context = NULL;
       leaf_cached = false;
       inner_cached = false;
@@ -2465,6 +2560,11 @@ namespace Legion {
       map_applied_conditions.clear();
       task_profiling_requests.clear();
       copy_profiling_requests.clear();
+      if (batched_mapping != NULL)
+      {
+        delete batched_mapping;
+        batched_mapping = NULL;
+      }
       if ((execution_context != NULL) && execution_context->remove_reference())
         delete execution_context;
     }
@@ -2708,6 +2808,7 @@ namespace Legion {
       // their valid instances, then fill in the mapper input structure
       valid.resize(regions.size());
       input.valid_instances.resize(regions.size());
+      input.traced = false;
       output.chosen_instances.resize(regions.size());
       // If we have must epoch owner, we have to check for any 
       // constrained mappings which must be heeded
@@ -2793,6 +2894,7 @@ namespace Legion {
       output.chosen_variant = 0;
       output.postmap_task = false;
       output.task_priority = 0;
+      output.memoize = false;
     }
 
     //--------------------------------------------------------------------------
@@ -3489,10 +3591,50 @@ namespace Legion {
       std::vector<InstanceSet> valid_instances(regions.size());
       initialize_map_task_input(input, output, must_epoch_owner, 
                                 valid_instances);
+      // If we are part of a dynamic trace, see if we can reuse the 
+      // mapping that was memoized the last time the trace was captured
+      Operation *trace_owner = 
+        (must_epoch_owner == NULL) ? find_trace_owner() : NULL;
+      input.traced = (trace_owner != NULL);
+      bool memoized = false;
+      if ((trace_owner != NULL) && !trace_owner->is_tracing())
+      {
+        DynamicTrace *dynamic_trace = 
+          trace_owner->get_trace()->as_dynamic_trace();
+        Mapper::MapTaskOutput memoized_output;
+        if (dynamic_trace->find_mapping(trace_owner, this, memoized_output) &&
+            acquire_memoized_instances(memoized_output))
+        {
+          output = memoized_output;
+          memoized = true;
+        }
+      }
       // Now we can invoke the mapper to do the mapping
       if (mapper == NULL)
         mapper = runtime->find_mapper(current_proc, map_id);
-      mapper->invoke_map_task(this, &input, &output);
+      // See if our mapper already picked a mapping for us in a batch
+      if (batched_mapping != NULL)
+      {
+        if (!memoized && (batched_mapper == mapper) &&
+            acquire_memoized_instances(*batched_mapping))
+        {
+          // Premapped regions keep the instances they premapped to
+          for (std::vector<unsigned>::const_iterator it = 
+                input.premapped_regions.begin(); it !=
+                input.premapped_regions.end(); it++)
+          {
+            if ((*it) < batched_mapping->chosen_instances.size())
+              batched_mapping->chosen_instances[*it] = 
+                output.chosen_instances[*it];
+          }
+          output = *batched_mapping;
+          memoized = true;
+        }
+        delete batched_mapping;
+        batched_mapping = NULL;
+      }
+      if (!memoized)
+        mapper->invoke_map_task(this, &input, &output);
       // Sort out any profiling requests that we need to perform
       if (!output.task_prof_requests.empty())
       {
@@ -3556,6 +3698,83 @@ namespace Legion {
       // Now we can convert the mapper output into our physical instances
       finalize_map_task_output(input, output, must_epoch_owner, 
                                valid_instances);
+      // Once it has been validated we can remember it for replays
+      if (!memoized && output.memoize && 
+          (trace_owner != NULL) && trace_owner->is_tracing())
+      {
+        DynamicTrace *dynamic_trace = 
+          trace_owner->get_trace()->as_dynamic_trace();
+        dynamic_trace->record_mapping(trace_owner, this, output);
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    void SingleTask::record_batched_mapping(MapperManager *batch_mapper,
+                                  const Mapper::MapTaskOutput &output,
+                                  const std::map<PhysicalManager*,
+                                    std::pair<unsigned,bool> > &acquired)
+    //--------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(batched_mapping == NULL);
+#endif
+      batched_mapper = batch_mapper;
+      batched_mapping = new Mapper::MapTaskOutput(output);
+      // Take our own references on any instances the mapper acquired
+      // for us so they can't be collected before we get to map
+      std::map<PhysicalManager*,std::pair<unsigned,bool> > *our_acquired = 
+        get_acquired_instances_ref();
+      LocalReferenceMutator mutator;
+      for (unsigned idx = 0; idx < output.chosen_instances.size(); idx++)
+      {
+        const std::vector<MappingInstance> &chosen = 
+          output.chosen_instances[idx];
+        for (unsigned idx2 = 0; idx2 < chosen.size(); idx2++)
+        {
+          PhysicalManager *manager = chosen[idx2].impl;
+          if ((manager == NULL) || 
+              (our_acquired->find(manager) != our_acquired->end()))
+            continue;
+          std::map<PhysicalManager*,std::pair<unsigned,bool> >::
+            const_iterator finder = acquired.find(manager);
+          if (finder == acquired.end())
+            continue;
+          manager->add_base_valid_ref(MAPPING_ACQUIRE_REF, &mutator);
+          (*our_acquired)[manager] = 
+            std::pair<unsigned,bool>(1/*first ref*/, finder->second.second);
+        }
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    bool SingleTask::acquire_memoized_instances(
+                                        const Mapper::MapTaskOutput &output)
+    //--------------------------------------------------------------------------
+    {
+      std::map<PhysicalManager*,std::pair<unsigned,bool> > *acquired = 
+        get_acquired_instances_ref();
+      for (unsigned idx = 0; idx < output.chosen_instances.size(); idx++)
+      {
+        const std::vector<MappingInstance> &chosen = 
+          output.chosen_instances[idx];
+        for (unsigned idx2 = 0; idx2 < chosen.size(); idx2++)
+        {
+          PhysicalManager *manager = chosen[idx2].impl;
+          if ((manager == NULL) || manager->is_virtual_manager())
+            continue;
+          if (acquired->find(manager) != acquired->end())
+            continue;
+          // If the instance has been collected since we recorded the
+          // mapping then we need to ask the mapper again, any instances
+          // we already acquired are released after the mapping as usual
+          if (!manager->try_add_base_valid_ref(MAPPING_ACQUIRE_REF, this,
+                                               !manager->is_owner()))
+            return false;
+          (*acquired)[manager] = 
+            std::pair<unsigned,bool>(1/*first ref*/, false/*created*/);
+        }
+      }
+      return true;
     }
 
     //--------------------------------------------------------------------------
@@ -3876,6 +4095,13 @@ namespace Legion {
     //--------------------------------------------------------------------------
     void SingleTask::launch_task(void)
     //--------------------------------------------------------------------------
+    {
+      launch_task(NULL/*no batch*/);
+    }
+
+    //--------------------------------------------------------------------------
+    void SingleTask::launch_task(Realm::SpawnBatch *batch)
+    //--------------------------------------------------------------------------
     {
       DETAILED_PROFILER(runtime, LAUNCH_TASK_CALL);
 #ifdef DEBUG_LEGION
@@ -4119,9 +4345,26 @@ namespace Legion {
         }
       }
 #endif
+      // Give memories that migrate data on demand (e.g. GPU managed
+      // memory) a head start on moving our instances to where we will run
+      for (unsigned idx = 0; idx < physical_instances.size(); idx++)
+      {
+        if (virtual_mapped[idx] || no_access_regions[idx])
+          continue;
+        const InstanceSet &instances = physical_instances[idx];
+        for (unsigned idx2 = 0; idx2 < instances.size(); idx2++)
+        {
+          const InstanceRef &ref = instances[idx2];
+          if (!ref.has_ref() || 
+              (ref.get_memory().kind() != Memory::GPU_MANAGED_MEM))
+            continue;
+          ref.get_manager()->get_instance().prefetch(target_processors[0],
+                                                     start_condition);
+        }
+      }
       ApEvent task_launch_event = variant->dispatch_task(launch_processor, this,
                                  execution_context, start_condition, true_guard, 
-                                 task_priority, profiling_requests);
+                                 task_priority, profiling_requests, batch);
       // Finish the chaining optimization if we're doing it
       if (perform_chaining_optimization)
         Runtime::trigger_event(chain_complete_event, task_launch_event);
@@ -4753,6 +4996,7 @@ namespace Legion {
       // Remove our reference on the future
       result = Future();
       predicate_false_future = Future();
+      argument_future = Future();
       privilege_paths.clear();
       version_infos.clear();
       restrict_infos.clear();
@@ -4779,12 +5023,9 @@ namespace Legion {
       grants = launcher.grants;
       wait_barriers = launcher.wait_barriers;
       arrive_barriers = launcher.arrive_barriers;
-      arglen = launcher.argument.get_size();
-      if (arglen > 0)
-      {
-        args = legion_malloc(TASK_ARGS_ALLOC, arglen);
-        memcpy(args,launcher.argument.get_ptr(),arglen);
-      }
+      initialize_arguments(launcher.argument.get_ptr(),
+                           launcher.argument.get_size(), false/*managed*/);
+      argument_future = launcher.argument_future;
       map_id = launcher.map_id;
       tag = launcher.tag;
       index_point = launcher.point;
@@ -4971,6 +5212,17 @@ namespace Legion {
               parent_ctx->get_unique_id(), 
               predicate_false_future.impl->producer_uid, 0,
               get_unique_id(), 0, TRUE_DEPENDENCE);
+#endif
+      }
+      if (argument_future.impl != NULL)
+      {
+        argument_future.impl->register_dependence(this);
+#ifdef LEGION_SPY
+        if (argument_future.impl->producer_op != NULL)
+          LegionSpy::log_mapping_dependence(
+              parent_ctx->get_unique_id(), 
+              argument_future.impl->producer_uid, 0,
+              get_unique_id(), 0, TRUE_DEPENDENCE);
 #endif
       }
       // Also have to register any dependences on our predicate
@@ -5133,11 +5385,59 @@ namespace Legion {
       trigger_children_complete();
     }
 
+    //--------------------------------------------------------------------------
+    void IndividualTask::trigger_ready(void)
+    //--------------------------------------------------------------------------
+    {
+      // If our argument comes from a future then we don't go on to the
+      // ready queue until that future resolves. The deferral is done
+      // with an event precondition so no thread ever waits on it.
+      if (argument_future.impl != NULL)
+      {
+        ApEvent arg_ready = argument_future.impl->get_ready_event();
+        if (!arg_ready.has_triggered())
+        {
+          enqueue_ready_operation(Runtime::protect_event(arg_ready));
+          return;
+        }
+      }
+      enqueue_ready_operation();
+    }
+
     //--------------------------------------------------------------------------
     void IndividualTask::early_map_task(void)
     //--------------------------------------------------------------------------
     {
-      // Nothing to do for now
+      // We are still on the origin node so pull in the value of our
+      // argument future before the mapper sees us or we are packed
+      forward_argument_future();
+    }
+
+    //--------------------------------------------------------------------------
+    void IndividualTask::forward_argument_future(void)
+    //--------------------------------------------------------------------------
+    {
+      if (argument_future.impl == NULL)
+        return;
+      FutureImpl *impl = argument_future.impl;
+      // Should be ready by now unless we are being inlined
+      const void *result = impl->get_untyped_result(true/*silence warnings*/);
+      const size_t result_size = impl->get_untyped_size();
+      if (args != NULL)
+      {
+        if (arg_manager != NULL)
+        {
+          if (arg_manager->remove_reference())
+            delete (arg_manager);
+          arg_manager = NULL;
+          shared_args = false;
+        }
+        else
+          legion_free(TASK_ARGS_ALLOC, args, arglen);
+        args = NULL;
+      }
+      initialize_arguments(result, result_size, false/*managed*/);
+      argument_future = Future();
     }
 
     //--------------------------------------------------------------------------
@@ -5652,10 +5952,22 @@ namespace Legion {
       return true;
     }
 
+    //--------------------------------------------------------------------------
+    Operation* IndividualTask::find_trace_owner(void)
+    //--------------------------------------------------------------------------
+    {
+      // Remote copies of the task never know about the trace
+      if ((trace == NULL) || is_remote() || !trace->is_dynamic_trace())
+        return NULL;
+      return this;
+    }
+
     //--------------------------------------------------------------------------
     void IndividualTask::perform_inlining(void)
     //--------------------------------------------------------------------------
     {
+      // Inlined tasks run in our parent so they need the argument now
+      forward_argument_future();
       // See if there is anything that we need to wait on before running
       std::set<ApEvent> wait_on_events;
       for (unsigned idx = 0; idx < futures.size(); idx++)
@@ -5888,6 +6200,9 @@ namespace Legion {
         remote_instances.clear();
       }
       version_infos.clear();
+      if (!acquired_instances.empty())
+        release_acquired_instances(acquired_instances);
+      acquired_instances.clear();
       runtime->free_point_task(this);
     }
 
@@ -6136,6 +6451,8 @@ namespace Legion {
       // then we are done mapping
       if (is_leaf() && !has_virtual_instances()) 
       {
+        if (!acquired_instances.empty())
+          release_acquired_instances(acquired_instances);
         if (!map_applied_conditions.empty())
         {
           RtEvent done = Runtime::merge_events(map_applied_conditions);
@@ -6259,7 +6576,7 @@ namespace Legion {
                                      PointTask::get_acquired_instances_ref(void)
     //--------------------------------------------------------------------------
     {
-      return slice_owner->get_acquired_instances_ref();
+      return &acquired_instances;
     }
 
     //--------------------------------------------------------------------------
@@ -6269,6 +6586,21 @@ namespace Legion {
       restrict_postconditions.insert(postcondition);
     }
 
+    //--------------------------------------------------------------------------
+    Operation* PointTask::find_trace_owner(void)
+    //--------------------------------------------------------------------------
+    {
+      // Only slices that are still on the node of their index
+      // task can find the trace that the index task was part of
+      if (slice_owner->is_remote() || (slice_owner->index_owner == NULL))
+        return NULL;
+      IndexTask *owner = slice_owner->index_owner;
+      LegionTrace *owner_trace = owner->get_trace();
+      if ((owner_trace == NULL) || !owner_trace->is_dynamic_trace())
+        return NULL;
+      return owner;
+    }
+
     //--------------------------------------------------------------------------
     void PointTask::send_remote_context(AddressSpaceID remote_instance,
                                         RemoteTask *remote_ctx)
@@ -6418,6 +6750,8 @@ namespace Legion {
       }
       if (Runtime::legion_spy_enabled)
         execution_context->log_created_requirements();
+      if (!acquired_instances.empty())
+        release_acquired_instances(acquired_instances);
       if (!map_applied_conditions.empty())
       {
         RtEvent done = Runtime::merge_events(map_applied_conditions);
@@ -6593,6 +6927,7 @@ namespace Legion {
       committed_points = 0;
       complete_received = false;
       commit_received = false;
+      reduction_future_set = false;
       need_intra_task_alias_analysis = true;
     }
 
@@ -6642,17 +6977,8 @@ namespace Legion {
       update_grants(launcher.grants);
       wait_barriers = launcher.wait_barriers;
       update_arrival_barriers(launcher.arrive_barriers);
-      arglen = launcher.global_arg.get_size();
-      if (arglen > 0)
-      {
-#ifdef DEBUG_LEGION
-        assert(arg_manager == NULL);
-#endif
-        arg_manager = new AllocManager(arglen);
-        arg_manager->add_reference();
-        args = arg_manager->get_allocation();
-        memcpy(args, launcher.global_arg.get_ptr(), arglen);
-      }
+      initialize_arguments(launcher.global_arg.get_ptr(),
+                           launcher.global_arg.get_size(), true/*managed*/);
       point_arguments = 
         FutureMap(launcher.argument_map.impl->freeze(parent_ctx));
       map_id = launcher.map_id;
@@ -6708,17 +7034,8 @@ namespace Legion {
       update_grants(launcher.grants);
       wait_barriers = launcher.wait_barriers;
       update_arrival_barriers(launcher.arrive_barriers);
-      arglen = launcher.global_arg.get_size();
-      if (arglen > 0)
-      {
-#ifdef DEBUG_LEGION
-        assert(arg_manager == NULL);
-#endif
-        arg_manager = new AllocManager(arglen);
-        arg_manager->add_reference();
-        args = arg_manager->get_allocation();
-        memcpy(args, launcher.global_arg.get_ptr(), arglen);
-      }
+      initialize_arguments(launcher.global_arg.get_ptr(),
+                           launcher.global_arg.get_size(), true/*managed*/);
       point_arguments = 
         FutureMap(launcher.argument_map.impl->freeze(parent_ctx));
       map_id = launcher.map_id;
@@ -7260,12 +7577,17 @@ namespace Legion {
       // and then trigger it
       if (redop != 0)
       {
-        // Set the future if we actually ran the task or we speculated
-        if ((speculation_state != RESOLVE_FALSE_STATE) || false_guard.exists())
-          reduction_future.impl->set_result(reduction_state,
-                                            reduction_state_size, 
-                                            false/*owner*/);
-        reduction_future.impl->complete_future();
+        // We might have already set it when the last slice came back
+        if (!reduction_future_set)
+        {
+          // Set the future if we actually ran the task or we speculated
+          if ((speculation_state != RESOLVE_FALSE_STATE) || 
+              false_guard.exists())
+            reduction_future.impl->set_result(reduction_state,
+                                              reduction_state_size, 
+                                              false/*owner*/);
+          reduction_future.impl->complete_future();
+        }
       }
       else
         future_map.impl->complete_all_futures();
@@ -7577,6 +7899,17 @@ namespace Legion {
           }
         }
       }
+      // Every slice has folded its partial result into ours so the value
+      // of the reduction is final and we can hand it out now instead of
+      // waiting for the rest of the index task to complete
+      if (trigger_execution && (redop != 0) && 
+          (speculation_state == RESOLVE_TRUE_STATE))
+      {
+        reduction_future_set = true;
+        reduction_future.impl->set_result(reduction_state,
+                                          reduction_state_size,false/*owner*/);
+        reduction_future.impl->complete_future();
+      }
       if (trigger_execution)
         complete_execution();
       if (need_trigger)
@@ -8107,9 +8440,13 @@ namespace Legion {
 #ifdef DEBUG_LEGION
       assert(!points.empty());
 #endif
-      // Launch all of our child points
+      // Launch all of our child points, handing them to Realm together
+      // Keep the batch on the stack since this slice can be recycled
+      // as soon as the last point has been launched
+      Realm::SpawnBatch batch;
       for (unsigned idx = 0; idx < points.size(); idx++)
-        points[idx]->launch_task();
+        points[idx]->launch_task(&batch);
+      batch.submit();
     }
 
     //--------------------------------------------------------------------------
@@ -8163,19 +8500,57 @@ namespace Legion {
       // at the index of the last known good index
       // Copy the points onto the stack to avoid them being
       // cleaned up while we are still iterating through the loop
-      std::vector<PointTask*> local_points(points);
-      for (std::vector<PointTask*>::const_iterator it = local_points.begin();
-            it != local_points.end(); it++)
+      const unsigned chunk = Runtime::point_mapping_chunk;
+      if ((chunk > 0) && (points.size() > chunk) && (must_epoch == NULL))
+      {
+        // Hand all but the first chunk of points off to meta-tasks
+        // on the utility processors so they are mapped in parallel,
+        // the physical analysis synchronizes on the region tree state
+        std::vector<PointTask*> local_points(points.begin(),
+                                             points.begin() + chunk);
+        for (unsigned idx = chunk; idx < points.size(); idx += chunk)
+        {
+          const unsigned last = ((idx + chunk) < points.size()) ?
+            (idx + chunk) : points.size();
+          MapPointsArgs args;
+          args.points = new std::vector<PointTask*>(points.begin() + idx,
+                                                    points.begin() + last);
+          runtime->issue_runtime_meta_task(args,
+              LG_DEFERRED_THROUGHPUT_PRIORITY, this);
+        }
+        map_and_launch_points(local_points);
+      }
+      else
+      {
+        std::vector<PointTask*> local_points(points);
+        map_and_launch_points(local_points);
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    /*static*/ void SliceTask::map_and_launch_points(
+                                            const std::vector<PointTask*> &pts)
+    //--------------------------------------------------------------------------
+    {
+      // Points that map right away are handed to Realm together,
+      // but don't hold them back while waiting on a deferred mapping
+      Realm::SpawnBatch batch;
+      for (std::vector<PointTask*>::const_iterator it = pts.begin();
+            it != pts.end(); it++)
       {
         PointTask *next_point = *it;
         RtEvent map_event = next_point->perform_mapping();
         // Once we call this function on the last point it
         // is possible that this slice task object can be recycled
         if (map_event.exists() && !map_event.has_triggered())
+        {
+          batch.submit();
           next_point->defer_launch_task(map_event);
+        }
         else
-          next_point->launch_task();
+          next_point->launch_task(&batch);
       }
+      batch.submit();
     }
 
     //--------------------------------------------------------------------------
@@ -8392,34 +8767,33 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       DETAILED_PROFILER(runtime, SLICE_HANDLE_FUTURE_CALL);
-      // If we're remote, just handle it ourselves, otherwise pass
-      // it back to the enclosing index owner
-      if (is_remote())
+      // Reductions are always folded into our own partial result first
+      // so that only one value per slice has to be folded by the index 
+      // task. For other futures, if we're remote, just handle it 
+      // ourselves, otherwise pass it back to the enclosing index owner
+      if (redop != 0)
+        fold_reduction_future(result, result_size, owner, false/*exclusive*/);
+      else if (is_remote())
       {
-        if (redop != 0)
-          fold_reduction_future(result, result_size, owner, false/*exclusive*/);
-        else
-        {
-          // Store it in our temporary futures
+        // Store it in our temporary futures
 #ifdef DEBUG_LEGION
-          assert(temporary_futures.find(point) == temporary_futures.end());
+        assert(temporary_futures.find(point) == temporary_futures.end());
 #endif
-          if (owner)
-          {
-            // Hold the lock to protect the data structure
-            AutoLock o_lock(op_lock);
-            temporary_futures[point] = 
-              std::pair<void*,size_t>(const_cast<void*>(result),result_size);
-          }
-          else
-          {
-            void *copy = legion_malloc(FUTURE_RESULT_ALLOC, result_size);
-            memcpy(copy,result,result_size);
-            // Hold the lock to protect the data structure
-            AutoLock o_lock(op_lock);
-            temporary_futures[point] = 
-              std::pair<void*,size_t>(copy,result_size);
-          }
+        if (owner)
+        {
+          // Hold the lock to protect the data structure
+          AutoLock o_lock(op_lock);
+          temporary_futures[point] = 
+            std::pair<void*,size_t>(const_cast<void*>(result),result_size);
+        }
+        else
+        {
+          void *copy = legion_malloc(FUTURE_RESULT_ALLOC, result_size);
+          memcpy(copy,result,result_size);
+          // Hold the lock to protect the data structure
+          AutoLock o_lock(op_lock);
+          temporary_futures[point] = 
+            std::pair<void*,size_t>(copy,result_size);
         }
       }
       else
@@ -8713,6 +9087,10 @@ namespace Legion {
       }
       else
       {
+        // Hand our partial reduction result to the index task
+        if (redop != 0)
+          index_owner->fold_reduction_future(reduction_state, 
+              reduction_state_size, false/*owner*/, false/*exclusive*/);
         index_owner->return_slice_complete(points.size());
       }
       complete_operation();
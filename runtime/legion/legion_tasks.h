@@ -99,13 +99,25 @@ namespace Legion {
     public:
       ExternalTask(void);
     public:
-      void pack_external_task(Serializer &rez, AddressSpaceID target);
+      void pack_external_task(Serializer &rez, AddressSpaceID target,
+                              Runtime *runtime);
       void unpack_external_task(Deserializer &derez, Runtime *runtime,
                                 ReferenceMutator *mutator);
     public:
       virtual void set_context_index(unsigned index) = 0;
+    protected:
+      // How the task arguments are sent to another node
+      enum ArgumentMode {
+        INLINE_ARGUMENTS, // copied into the message
+        PINNED_ARGUMENTS, // copied and cached by the target by hash
+        HASHED_ARGUMENTS  // only the hash of a buffer the target has
+      };
     protected:
       AllocManager *arg_manager;
+      // Set when the arguments live in a shared immutable buffer
+      // that the runtime deduplicated by this content hash
+      bool shared_args;
+      uint64_t arg_hash;
     public:
       static void pack_index_space_requirement(
           const IndexSpaceRequirement &req, Serializer &rez);
@@ -179,6 +191,7 @@ namespace Legion {
     protected:
       void activate_task(void);
       void deactivate_task(void); 
+      void initialize_arguments(const void *src, size_t size, bool managed);
     public:
       void set_must_epoch(MustEpochOp *epoch, unsigned index, 
                           bool do_registration);
@@ -205,6 +218,7 @@ namespace Legion {
       virtual OpKind get_operation_kind(void) const;
       virtual size_t get_region_count(void) const;
       virtual Mappable* get_mappable(void);
+      virtual bool find_dependence_trees(std::set<RegionTreeID> &trees) const;
     public:
       virtual void trigger_dependence_analysis(void) = 0;
       virtual void trigger_complete(void);
@@ -411,8 +425,14 @@ namespace Legion {
       void validate_target_processors(const std::vector<Processor> &prcs) const;
       void validate_variant_selection(MapperManager *local_mapper,
                     VariantImpl *impl, const char *call_name) const;
+    public:
+      void record_batched_mapping(MapperManager *batch_mapper,
+                                  const Mapper::MapTaskOutput &output,
+                                  const std::map<PhysicalManager*,
+                                    std::pair<unsigned,bool> > &acquired);
     protected:
       void invoke_mapper(MustEpochOp *must_epoch_owner);
+      bool acquire_memoized_instances(const Mapper::MapTaskOutput &output);
       void map_all_regions(ApEvent user_event,
                            MustEpochOp *must_epoch_owner = NULL); 
       void perform_post_mapping(void);
@@ -429,9 +449,14 @@ namespace Legion {
       virtual void activate(void) = 0;
       virtual void deactivate(void) = 0;
       virtual bool is_top_level_task(void) const { return false; }
+      // The operation in a dynamic trace that issued this task, if any
+      virtual Operation* find_trace_owner(void) = 0;
     public:
       virtual void resolve_false(bool speculated, bool launched) = 0;
       virtual void launch_task(void);
+      // Same as above, but the Realm task is held in the batch
+      // until the caller submits it
+      void launch_task(Realm::SpawnBatch *batch);
       virtual void early_map_task(void) = 0;
       virtual bool distribute_task(void) = 0;
       virtual RtEvent perform_must_epoch_version_analysis(MustEpochOp *own) = 0;
@@ -476,6 +501,9 @@ namespace Legion {
       VariantID                             selected_variant;
       TaskPriority                          task_priority;
       bool                                  perform_postmap;
+      // Mapping chosen ahead of time by a map_task_batch call
+      MapperManager*                        batched_mapper;
+      Mapper::MapTaskOutput*                batched_mapping;
     protected:
       // Events that must be triggered before we are done mapping
       std::set<RtEvent> map_applied_conditions;
@@ -613,6 +641,7 @@ namespace Legion {
       virtual bool has_prepipeline_stage(void) const { return true; }
       virtual void trigger_prepipeline_stage(void);
       virtual void trigger_dependence_analysis(void);
+      virtual void trigger_ready(void);
       virtual void report_interfering_requirements(unsigned idx1,unsigned idx2);
       virtual std::map<PhysicalManager*,std::pair<unsigned,bool> >*
                                        get_acquired_instances_ref(void);
@@ -655,6 +684,7 @@ namespace Legion {
                                std::set<RtEvent> &ready_events);
       virtual void perform_inlining(void);
       virtual bool is_top_level_task(void) const { return top_level_task; }
+      virtual Operation* find_trace_owner(void);
       virtual void end_inline_task(const void *result, 
                                    size_t result_size, bool owned);
     protected:
@@ -663,6 +693,7 @@ namespace Legion {
       void unpack_remote_mapped(Deserializer &derez);
       void unpack_remote_complete(Deserializer &derez);
       void unpack_remote_commit(Deserializer &derez);
+      void forward_argument_future(void);
     public:
       static void process_unpack_remote_mapped(Deserializer &derez);
       static void process_unpack_remote_complete(Deserializer &derez);
@@ -685,6 +716,9 @@ namespace Legion {
       Future predicate_false_future;
       void *predicate_false_result;
       size_t predicate_false_size;
+    protected:
+      // Future whose value becomes our argument once it resolves
+      Future argument_future;
     protected:
       bool sent_remotely;
     protected:
@@ -758,6 +792,7 @@ namespace Legion {
       virtual std::map<PhysicalManager*,std::pair<unsigned,bool> >*
                                        get_acquired_instances_ref(void);
       virtual void record_restrict_postcondition(ApEvent postcondition);
+      virtual Operation* find_trace_owner(void);
     public:
       virtual void handle_future(const void *res, 
                                  size_t res_size, bool owned);
@@ -782,6 +817,9 @@ namespace Legion {
       std::map<AddressSpaceID,RemoteTask*> remote_instances;
     protected:
       std::vector<VersionInfo>    version_infos;
+      // Kept per point rather than on the slice so that points
+      // of the same slice can be mapped in parallel
+      std::map<PhysicalManager*,std::pair<unsigned,bool> > acquired_instances;
     };
 
     /**
@@ -890,6 +928,8 @@ namespace Legion {
       // Track whether or not we've received our commit command
       bool complete_received;
       bool commit_received; 
+      // Whether we've already set the result of our reduction future
+      bool reduction_future_set;
     protected:
       std::vector<RegionTreePath> privilege_paths;
       std::deque<SliceTask*> locally_mapped_slices;
@@ -928,6 +968,14 @@ namespace Legion {
       public:
         SliceTask *proxy_this;
       };
+      struct MapPointsArgs : public LgTaskArgs<MapPointsArgs> {
+      public:
+        static const LgTaskID TASK_ID = LG_MAP_SLICE_POINTS_TASK_ID;
+      public:
+        // Owned by the meta-task since the slice can be
+        // recycled once the last of its points has launched
+        std::vector<PointTask*> *points;
+      };
     public:
       SliceTask(Runtime *rt);
       SliceTask(const SliceTask &rhs);
@@ -995,6 +1043,7 @@ namespace Legion {
       void pack_remote_commit(Serializer &rez);
     public:
       RtEvent defer_map_and_launch(RtEvent precondition);
+      static void map_and_launch_points(const std::vector<PointTask*> &pts);
     public:
       static void handle_slice_return(Runtime *rt, Deserializer &derez);
     public: // Privilege tracker methods
@@ -363,7 +363,8 @@ namespace Legion {
 
     //--------------------------------------------------------------------------
     DynamicTrace::DynamicTrace(TraceID t, TaskContext *c)
-      : LegionTrace(c), tid(t), fixed(false), tracing(true)
+      : LegionTrace(c), mapping_lock(Reservation::create_reservation()),
+        tid(t), fixed(false), tracing(true)
     //--------------------------------------------------------------------------
     {
     }
@@ -381,6 +382,8 @@ namespace Legion {
     DynamicTrace::~DynamicTrace(void)
     //--------------------------------------------------------------------------
     {
+      mapping_lock.destroy_reservation();
+      mapping_lock = Reservation::NO_RESERVATION;
     }
 
     //--------------------------------------------------------------------------
@@ -413,6 +416,26 @@ namespace Legion {
       op_map.clear();
       internal_dependences.clear();
       tracing = false;
+      // Fold the dependences of each operation by the operation they are
+      // on, registration only happens for the first record on each target
+      // so that is the only one whose validated region matters
+      replay_dependences.resize(dependences.size());
+      for (unsigned idx = 0; idx < dependences.size(); idx++)
+      {
+        const LegionVector<DependenceRecord>::aligned &deps = dependences[idx];
+        std::vector<ReplayDependence> &replay = replay_dependences[idx];
+        std::map<int,unsigned> targets;
+        for (LegionVector<DependenceRecord>::aligned::const_iterator it = 
+              deps.begin(); it != deps.end(); it++)
+        {
+          if (targets.find(it->operation_idx) != targets.end())
+            continue;
+          targets[it->operation_idx] = replay.size();
+          const bool region = (it->prev_idx != -1) && (it->next_idx != -1);
+          replay.push_back(ReplayDependence(it->operation_idx,
+                (region && it->validates) ? it->next_idx : -1));
+        }
+      }
 #ifdef LEGION_SPY
       current_uids.clear();
       num_regions.clear();
@@ -441,6 +464,7 @@ namespace Legion {
     {
       std::pair<Operation*,GenerationID> key(op,gen);
       const unsigned index = operations.size();
+      op->set_trace_local_id(index);
       // Only need to save this in the map if we are not done tracing
       if (tracing)
       {
@@ -526,6 +550,28 @@ namespace Legion {
           // Add a mapping reference since people will be 
           // registering dependences
           op->add_mapping_reference(gen);  
+#ifndef LEGION_SPY
+          // Unless we need to record every dependence for Legion Spy
+          // or must epoch operations, only register the folded ones
+          if (op->get_must_epoch() == NULL)
+          {
+            const std::vector<ReplayDependence> &replay = 
+                                                  replay_dependences[index];
+            for (std::vector<ReplayDependence>::const_iterator it = 
+                  replay.begin(); it != replay.end(); it++)
+            {
+#ifdef DEBUG_LEGION
+              assert((it->operation_idx >= 0) &&
+                     ((size_t)it->operation_idx < operations.size()));
+#endif
+              const std::pair<Operation*,GenerationID> &target = 
+                                                  operations[it->operation_idx];
+              op->register_replay_dependence(target.first, target.second,
+                                             it->validated_idx);
+            }
+            return;
+          }
+#endif
           // Then compute all the dependences on this operation from
           // our previous recording of the trace
           for (LegionVector<DependenceRecord>::aligned::const_iterator it = 
@@ -806,6 +852,55 @@ namespace Legion {
       aliased_children[index].push_back(AliasChildren(req_index, depth, mask));
     } 
 
+    //--------------------------------------------------------------------------
+    void DynamicTrace::record_mapping(Operation *op, SingleTask *task,
+                                      const Mapper::MapTaskOutput &output)
+    //--------------------------------------------------------------------------
+    {
+      const std::pair<unsigned,DomainPoint> 
+        key(op->get_trace_local_id(), task->index_point);
+      AutoLock m_lock(mapping_lock);
+      // First one to record wins
+      if (mappings.find(key) != mappings.end())
+        return;
+      MappingRecord &record = mappings[key];
+      record.regions.resize(task->regions.size());
+      record.fields.resize(task->regions.size());
+      for (unsigned idx = 0; idx < task->regions.size(); idx++)
+      {
+        record.regions[idx] = task->regions[idx].region;
+        record.fields[idx] = task->regions[idx].privilege_fields;
+      }
+      record.output = output;
+    }
+
+    //--------------------------------------------------------------------------
+    bool DynamicTrace::find_mapping(Operation *op, SingleTask *task,
+                                    Mapper::MapTaskOutput &output)
+    //--------------------------------------------------------------------------
+    {
+      const std::pair<unsigned,DomainPoint> 
+        key(op->get_trace_local_id(), task->index_point);
+      AutoLock m_lock(mapping_lock,1,false/*exclusive*/);
+      std::map<std::pair<unsigned,DomainPoint>,MappingRecord>::const_iterator
+        finder = mappings.find(key);
+      if (finder == mappings.end())
+        return false;
+      const MappingRecord &record = finder->second;
+      // The recorded instances are only good for the same regions
+      if (record.regions.size() != task->regions.size())
+        return false;
+      for (unsigned idx = 0; idx < task->regions.size(); idx++)
+      {
+        if (record.regions[idx] != task->regions[idx].region)
+          return false;
+        if (record.fields[idx] != task->regions[idx].privilege_fields)
+          return false;
+      }
+      output = record.output;
+      return true;
+    }
+
     //--------------------------------------------------------------------------
     void DynamicTrace::insert_dependence(const DependenceRecord &record)
     //--------------------------------------------------------------------------
@@ -212,6 +212,12 @@ namespace Legion {
                                     const FieldMask &dependent_mask);
       virtual void record_aliased_children(unsigned req_index, unsigned depth,
                                            const FieldMask &aliased_mask);
+    public:
+      // Called by mapping threads
+      void record_mapping(Operation *op, SingleTask *task,
+                          const Mapper::MapTaskOutput &output);
+      bool find_mapping(Operation *op, SingleTask *task,
+                        Mapper::MapTaskOutput &output);
     protected:
       // Insert a normal dependence for the current operation
       void insert_dependence(const DependenceRecord &record);
@@ -237,6 +243,30 @@ namespace Legion {
       std::deque<LegionVector<DependenceRecord>::aligned> dependences;
       // Metadata for checking the validity of a trace when it is replayed
       std::vector<OperationInfo> op_info;
+      // The same dependences with all the records on the same operation
+      // folded together, which is all that a replay needs to register
+      struct ReplayDependence {
+      public:
+        ReplayDependence(int idx, int val)
+          : operation_idx(idx), validated_idx(val) { }
+      public:
+        int operation_idx;
+        // The region requirement that will be validated if any 
+        int validated_idx;
+      };
+      std::deque<std::vector<ReplayDependence> > replay_dependences;
+    protected:
+      // Mapper decisions for tasks in the trace that asked to be memoized
+      // so that replays of the trace can skip calling map_task, keyed by
+      // the index of the operation in the trace and the point of the task
+      struct MappingRecord {
+      public:
+        std::vector<LogicalRegion> regions;
+        std::vector<std::set<FieldID> > fields;
+        Mapper::MapTaskOutput output;
+      };
+      Reservation mapping_lock;
+      std::map<std::pair<unsigned,DomainPoint>,MappingRecord> mappings;
     protected:
       const TraceID tid;
       bool fixed;
@@ -61,6 +61,7 @@ namespace Legion {
   typedef ::legion_partition_kind_t PartitionKind;
   typedef ::legion_external_resource_t ExternalResource;
   typedef ::legion_timing_measurement_t TimingMeasurement;
+  typedef ::legion_eviction_policy_t EvictionPolicy;
   typedef ::legion_dependence_type_t DependenceType;
   typedef ::legion_index_space_kind_t IndexSpaceKind;
   typedef ::legion_file_mode_t LegionFileMode;
@@ -166,6 +167,12 @@ namespace Legion {
   template<unsigned int MAX> class AVXBitMask;
   template<unsigned int MAX> class AVXTLBitMask;
 #endif
+#ifdef __AVX512F__
+  template<unsigned int MAX> class AVX512BitMask;
+  template<unsigned int MAX> class AVX512TLBitMask;
+#endif
+  template<typename BITMASK, unsigned int MAX, 
+           unsigned int CNT = 7> class SparseBitMask;
   template<typename T, unsigned LOG2MAX> class BitPermutation;
   template<typename IT, typename DT, bool BIDIR = false> class IntegerSet;
 
@@ -313,6 +320,7 @@ namespace Legion {
       LG_DEFER_PERFORM_MAPPING_TASK_ID,
       LG_DEFER_LAUNCH_TASK_ID,
       LG_DEFER_MAP_AND_LAUNCH_TASK_ID,
+      LG_MAP_SLICE_POINTS_TASK_ID,
       LG_ADD_VERSIONING_SET_REF_TASK_ID,
       LG_VERSION_STATE_CAPTURE_DIRTY_TASK_ID,
       LG_DISJOINT_CLOSE_TASK_ID,
@@ -320,6 +328,11 @@ namespace Legion {
       LG_MISSPECULATE_TASK_ID,
       LG_DEFER_PHI_VIEW_REF_TASK_ID,
       LG_DEFER_PHI_VIEW_REGISTRATION_TASK_ID,
+      LG_DEFER_CHANNEL_FLUSH_TASK_ID,
+      LG_DEFER_REFERENCE_FLUSH_TASK_ID,
+      LG_DEFER_UNREGISTER_TASK_ID,
+      LG_PREFETCH_INSTANCE_TASK_ID,
+      LG_PROFILER_DRAIN_TASK_ID,
       LG_MESSAGE_ID, // These two must be the last two
       LG_RETRY_SHUTDOWN_TASK_ID,
       LG_LAST_TASK_ID, // This one should always be last
@@ -409,6 +422,7 @@ namespace Legion {
         "Defer Task Perform Mapping",                             \
         "Defer Task Launch",                                      \
         "Defer Task Map and Launch",                              \
+        "Map Slice Points",                                       \
         "Defer Versioning Set Reference",                         \
         "Version State Capture Dirty",                            \
         "Disjoint Close",                                         \
@@ -416,6 +430,11 @@ namespace Legion {
         "Handle Mapping Misspeculation",                          \
         "Defer Phi View Reference",                               \
         "Defer Phi View Registration",                            \
+        "Defer Virtual Channel Flush",                            \
+        "Defer Remote Reference Flush",                           \
+        "Defer Collectable Unregistration",                       \
+        "Prefetch Physical Instance",                             \
+        "Drain Profiler Records",                                 \
         "Remote Message",                                         \
         "Retry Shutdown",                                         \
       };
@@ -463,6 +482,7 @@ namespace Legion {
       PERMIT_STEAL_REQUEST_CALL,
       HANDLE_MESSAGE_CALL,
       HANDLE_TASK_RESULT_CALL,
+      MAP_TASK_BATCH_CALL,
       LAST_MAPPER_CALL,
     };
 
@@ -510,10 +530,14 @@ namespace Legion {
       "permit_steal_request",                       \
       "handle_message",                             \
       "handle_task_result",                         \
+      "map_task_batch",                             \
     }
 
     // Methodology for assigning priorities to meta-tasks
-    // The lowest priority is for the heavy lifting meta
+    // Background priority is for deferrable work such as
+    // garbage collection that should only run when no
+    // other meta-tasks are waiting for the processor.
+    // The throughput priority is for the heavy lifting meta
     // tasks, so they go through the queue at low priority.
     // The deferred-throughput priority is for tasks that
     // have already gone through the queue once with 
@@ -527,6 +551,7 @@ namespace Legion {
     // Realm resource (e.g. reservation) and therefore 
     // shouldn't be stuck behind anything.
     enum LgPriority {
+      LG_BACKGROUND_PRIORITY = -1,
       LG_THROUGHPUT_PRIORITY = 0,
       LG_DEFERRED_THROUGHPUT_PRIORITY = 1,
       LG_LATENCY_PRIORITY = 2,
@@ -677,7 +702,6 @@ namespace Legion {
       SEND_CONSTRAINT_REMOVAL,
       SEND_TOP_LEVEL_TASK_REQUEST,
       SEND_TOP_LEVEL_TASK_COMPLETE,
-      SEND_MPI_RANK_EXCHANGE,
       SEND_SHUTDOWN_NOTIFICATION,
       SEND_SHUTDOWN_RESPONSE,
       LAST_SEND_KIND, // This one must be last
@@ -807,7 +831,6 @@ namespace Legion {
         "Send Constraint Removal",                                    \
         "Top Level Task Request",                                     \
         "Top Level Task Complete",                                    \
-        "Send MPI Rank Exchange",                                     \
         "Send Shutdown Notification",                                 \
         "Send Shutdown Response",                                     \
       };
@@ -1536,38 +1559,51 @@ namespace Legion {
 #define LEGION_FIELD_MASK_FIELD_MASK          0x3F
 #define LEGION_FIELD_MASK_FIELD_ALL_ONES      0xFFFFFFFFFFFFFFFF
 
-#if defined(__AVX__)
+#if defined(__AVX512F__) && (MAX_FIELDS > 256) && ((MAX_FIELDS % 512) == 0)
+    // Wide masks are handled 512 bits at a time
+#if (MAX_FIELDS > 512)
+    typedef AVX512TLBitMask<MAX_FIELDS> DenseFieldMask;
+#else
+    typedef AVX512BitMask<MAX_FIELDS> DenseFieldMask;
+#endif
+#elif defined(__AVX__)
 #if (MAX_FIELDS > 256)
-    typedef AVXTLBitMask<MAX_FIELDS> FieldMask;
+    typedef AVXTLBitMask<MAX_FIELDS> DenseFieldMask;
 #elif (MAX_FIELDS > 128)
-    typedef AVXBitMask<MAX_FIELDS> FieldMask;
+    typedef AVXBitMask<MAX_FIELDS> DenseFieldMask;
 #elif (MAX_FIELDS > 64)
-    typedef SSEBitMask<MAX_FIELDS> FieldMask;
+    typedef SSEBitMask<MAX_FIELDS> DenseFieldMask;
 #else
     typedef BitMask<LEGION_FIELD_MASK_FIELD_TYPE,MAX_FIELDS,
                     LEGION_FIELD_MASK_FIELD_SHIFT,
-                    LEGION_FIELD_MASK_FIELD_MASK> FieldMask;
+                    LEGION_FIELD_MASK_FIELD_MASK> DenseFieldMask;
 #endif
 #elif defined(__SSE2__)
 #if (MAX_FIELDS > 128)
-    typedef SSETLBitMask<MAX_FIELDS> FieldMask;
+    typedef SSETLBitMask<MAX_FIELDS> DenseFieldMask;
 #elif (MAX_FIELDS > 64)
-    typedef SSEBitMask<MAX_FIELDS> FieldMask;
+    typedef SSEBitMask<MAX_FIELDS> DenseFieldMask;
 #else
     typedef BitMask<LEGION_FIELD_MASK_FIELD_TYPE,MAX_FIELDS,
                     LEGION_FIELD_MASK_FIELD_SHIFT,
-                    LEGION_FIELD_MASK_FIELD_MASK> FieldMask;
+                    LEGION_FIELD_MASK_FIELD_MASK> DenseFieldMask;
 #endif
 #else
 #if (MAX_FIELDS > 64)
     typedef TLBitMask<LEGION_FIELD_MASK_FIELD_TYPE,MAX_FIELDS,
                       LEGION_FIELD_MASK_FIELD_SHIFT,
-                      LEGION_FIELD_MASK_FIELD_MASK> FieldMask;
+                      LEGION_FIELD_MASK_FIELD_MASK> DenseFieldMask;
 #else
     typedef BitMask<LEGION_FIELD_MASK_FIELD_TYPE,MAX_FIELDS,
                     LEGION_FIELD_MASK_FIELD_SHIFT,
-                    LEGION_FIELD_MASK_FIELD_MASK> FieldMask;
+                    LEGION_FIELD_MASK_FIELD_MASK> DenseFieldMask;
+#endif
 #endif
+#ifdef LEGION_SPARSE_FIELD_MASKS
+    // Masks with only a few fields set are stored as a list of indexes
+    typedef SparseBitMask<DenseFieldMask,MAX_FIELDS> FieldMask;
+#else
+    typedef DenseFieldMask FieldMask;
 #endif
     typedef BitPermutation<FieldMask,LEGION_FIELD_LOG2> FieldPermutation;
     typedef Fraction<unsigned long> InstFrac;
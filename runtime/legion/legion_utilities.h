@@ -20,6 +20,8 @@
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
+#include <algorithm>
+#include <sched.h>
 
 #include "legion_types.h"
 #include "legion.h"
@@ -38,7 +40,7 @@
 #ifdef __SSE4_1__
 #include <smmintrin.h>
 #endif
-#if defined(__AVX__) || defined(__AVX2__)
+#if defined(__AVX__) || defined(__AVX2__) || defined(__AVX512F__)
 #include <immintrin.h>
 #endif
 #endif
@@ -188,6 +190,51 @@ namespace Legion {
       }
     } 
 
+    /////////////////////////////////////////////////////////////
+    // Local Lock 
+    /////////////////////////////////////////////////////////////
+    // A lightweight reader-writer spin lock for state that is only
+    // ever touched on this node. Uncontended acquires are a single
+    // atomic operation and waiting threads back off from spinning
+    // to yielding the core. Since waiters never give up their 
+    // processor, a local lock must only guard short critical 
+    // sections that do not wait on events or acquire Reservations
+    // (which includes sending messages through the runtime); anything
+    // that needs deferred acquisition stays a Reservation.
+    class LocalLock {
+    public:
+      static const unsigned WRITER_HELD    = 0x80000000;
+      static const unsigned WRITER_WAITING = 0x40000000;
+      static const unsigned READER_MASK    = 0x3FFFFFFF;
+    public:
+      LocalLock(void) : state(0) { }
+      LocalLock(const LocalLock &rhs) : state(0) { assert(rhs.state == 0); }
+      ~LocalLock(void) { }
+    public:
+      LocalLock& operator=(const LocalLock &rhs)
+        { assert((state == 0) && (rhs.state == 0)); return *this; }
+    public:
+      inline void lock(bool exclusive = true) const
+        { if (exclusive) lock_exclusive(); else lock_shared(); }
+      inline void unlock(bool exclusive = true) const
+      {
+#ifdef DEBUG_LEGION
+        assert(exclusive ? (state & WRITER_HELD) : (state & READER_MASK));
+#endif
+        if (exclusive)
+          __sync_fetch_and_and(&state, ~WRITER_HELD);
+        else
+          __sync_fetch_and_sub(&state, 1);
+      }
+    protected:
+      inline void lock_exclusive(void) const;
+      inline void lock_shared(void) const;
+      static inline void backoff(unsigned &spins);
+    protected:
+      // mutable so const accessors can still take the lock
+      mutable volatile unsigned state;
+    };
+
     /////////////////////////////////////////////////////////////
     // AutoLock 
     /////////////////////////////////////////////////////////////
@@ -195,9 +242,14 @@ namespace Legion {
     // the object goes out of scope
     class AutoLock { 
     public:
+      AutoLock(const LocalLock &l, unsigned mode = 0, bool exclusive = true)
+        : local_lock(&l), local_exclusive(exclusive)
+      {
+        l.lock(exclusive);
+      }
       AutoLock(Reservation r, unsigned mode = 0, bool exclusive = true, 
                RtEvent wait_on = RtEvent::NO_RT_EVENT) 
-        : low_lock(r)
+        : low_lock(r), local_lock(NULL), local_exclusive(false)
       {
 #define AUTOLOCK_USE_TRY_ACQUIRE
 #ifdef AUTOLOCK_USE_TRY_ACQUIRE
@@ -216,13 +268,17 @@ namespace Legion {
       }
     public:
       AutoLock(const AutoLock &rhs)
+        : local_lock(NULL), local_exclusive(false)
       {
         // should never be called
         assert(false);
       }
       ~AutoLock(void)
       {
-        low_lock.release();
+        if (local_lock != NULL)
+          local_lock->unlock(local_exclusive);
+        else
+          low_lock.release();
       }
     public:
       AutoLock& operator=(const AutoLock &rhs)
@@ -233,6 +289,8 @@ namespace Legion {
       }
     private:
       Reservation low_lock;
+      const LocalLock *const local_lock;
+      const bool local_exclusive;
     };
 
     /////////////////////////////////////////////////////////////
@@ -355,13 +413,37 @@ namespace Legion {
     /////////////////////////////////////////////////////////////
     class Serializer {
     public:
-      Serializer(size_t base_bytes = 4096)
-        : total_bytes(base_bytes), buffer((char*)malloc(base_bytes)), 
-          index(0) 
+      // Space left in front of the buffer so that the message
+      // headers can be written there and a message sent straight
+      // out of the serializer without copying it first
+      static const size_t MESSAGE_HEADROOM = 64;
+      // Small messages are serialized into a buffer inside the
+      // serializer itself so they never touch the heap
+      static const size_t INLINE_BYTES = 256;
+      // Larger buffers come from per-thread caches of power-of-two
+      // size classes starting at MIN_POOLED_BYTES
+      static const size_t MIN_POOLED_BYTES = 4096;
+      static const unsigned POOLED_SIZE_CLASSES = 4;
+      static const unsigned POOLED_BUFFERS_PER_CLASS = 2;
+      struct BufferCache {
+        char *buffers[POOLED_SIZE_CLASSES][POOLED_BUFFERS_PER_CLASS];
+        unsigned counts[POOLED_SIZE_CLASSES];
+      };
+    public:
+      Serializer(size_t base_bytes = INLINE_BYTES)
+        : total_bytes(INLINE_BYTES), allocation(inline_storage),
+          buffer(inline_storage + MESSAGE_HEADROOM), index(0) 
 #ifdef DEBUG_LEGION
           , context_bytes(0)
 #endif
-      { }
+      { 
+        if (base_bytes > INLINE_BYTES)
+        {
+          total_bytes = base_bytes;
+          allocation = allocate_buffer(total_bytes);
+          buffer = allocation + MESSAGE_HEADROOM;
+        }
+      }
       Serializer(const Serializer &rhs)
       {
         // should never be called
@@ -370,7 +452,8 @@ namespace Legion {
     public:
       ~Serializer(void)
       {
-        free(buffer);
+        if (allocation != inline_storage)
+          release_buffer(allocation, total_bytes);
       }
     public:
       inline Serializer& operator=(const Serializer &rhs);
@@ -394,6 +477,14 @@ namespace Legion {
       template<unsigned int MAX>
       inline void serialize(const AVXTLBitMask<MAX> &mask);
 #endif
+#ifdef __AVX512F__
+      template<unsigned int MAX>
+      inline void serialize(const AVX512BitMask<MAX> &mask);
+      template<unsigned int MAX>
+      inline void serialize(const AVX512TLBitMask<MAX> &mask);
+#endif
+      template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+      inline void serialize(const SparseBitMask<BITMASK,MAX,CNT> &mask);
       template<typename IT, typename DT, bool BIDIR>
       inline void serialize(const IntegerSet<IT,DT,BIDIR> &index_set);
       inline void serialize(const ColorPoint &point);
@@ -409,15 +500,24 @@ namespace Legion {
       inline size_t get_buffer_size(void) const { return total_bytes; }
       inline size_t get_used_bytes(void) const { return index; }
       inline void* reserve_bytes(size_t size);
+      // Get a pointer to the last 'bytes' bytes of the headroom
+      // directly in front of the serialized data
+      inline void* get_headroom(size_t bytes);
     private:
       inline void resize(void);
+      static inline BufferCache& get_buffer_cache(void);
+      static inline char* allocate_buffer(size_t &bytes);
+      static inline void release_buffer(char *allocation, size_t bytes);
     private:
       size_t total_bytes;
+      char *allocation;
       char *buffer;
       size_t index;
 #ifdef DEBUG_LEGION
       size_t context_bytes;
 #endif
+      char inline_storage[MESSAGE_HEADROOM + INLINE_BYTES] 
+        __attribute__((aligned(16)));
     };
 
     /////////////////////////////////////////////////////////////
@@ -467,6 +567,14 @@ namespace Legion {
       template<unsigned int MAX>
       inline void deserialize(AVXTLBitMask<MAX> &mask);
 #endif
+#ifdef __AVX512F__
+      template<unsigned int MAX>
+      inline void deserialize(AVX512BitMask<MAX> &mask);
+      template<unsigned int MAX>
+      inline void deserialize(AVX512TLBitMask<MAX> &mask);
+#endif
+      template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+      inline void deserialize(SparseBitMask<BITMASK,MAX,CNT> &mask);
       template<typename IT, typename DT, bool BIDIR>
       inline void deserialize(IntegerSet<IT,DT,BIDIR> &index_set);
       inline void deserialize(ColorPoint &color);
@@ -1010,6 +1118,153 @@ namespace Legion {
     } __attribute__((aligned(32)));
 #endif // __AVX__
 
+#ifdef __AVX512F__
+    /////////////////////////////////////////////////////////////
+    // AVX-512 Bit Mask  
+    /////////////////////////////////////////////////////////////
+    template<unsigned int MAX>
+    class AVX512BitMask : public Internal::LegionHeapify<AVX512BitMask<MAX> > {
+    public:
+      explicit AVX512BitMask(uint64_t init = 0);
+      AVX512BitMask(const AVX512BitMask &rhs);
+      ~AVX512BitMask(void);
+    public:
+      inline void set_bit(unsigned bit);
+      inline void unset_bit(unsigned bit);
+      inline void assign_bit(unsigned bit, bool val);
+      inline bool is_set(unsigned bit) const;
+      inline int find_first_set(void) const;
+      inline int find_index_set(int index) const;
+      inline int find_next_set(int start) const;
+      inline void clear(void);
+    public:
+      inline bool operator==(const AVX512BitMask &rhs) const;
+      inline bool operator<(const AVX512BitMask &rhs) const;
+      inline bool operator!=(const AVX512BitMask &rhs) const;
+    public:
+      inline const __m512i& operator()(const unsigned &idx) const;
+      inline __m512i& operator()(const unsigned &idx);
+      inline const uint64_t& operator[](const unsigned &idx) const;
+      inline uint64_t& operator[](const unsigned &idx);
+      inline AVX512BitMask& operator=(const AVX512BitMask &rhs);
+    public:
+      inline AVX512BitMask operator~(void) const;
+      inline AVX512BitMask operator|(const AVX512BitMask &rhs) const;
+      inline AVX512BitMask operator&(const AVX512BitMask &rhs) const;
+      inline AVX512BitMask operator^(const AVX512BitMask &rhs) const;
+    public:
+      inline AVX512BitMask& operator|=(const AVX512BitMask &rhs);
+      inline AVX512BitMask& operator&=(const AVX512BitMask &rhs);
+      inline AVX512BitMask& operator^=(const AVX512BitMask &rhs);
+    public:
+      // Use * for disjointness testing
+      inline bool operator*(const AVX512BitMask &rhs) const;
+      // Set difference
+      inline AVX512BitMask operator-(const AVX512BitMask &rhs) const;
+      inline AVX512BitMask& operator-=(const AVX512BitMask &rhs);
+      // Test to see if everything is zeros
+      inline bool operator!(void) const;
+    public:
+      inline AVX512BitMask operator<<(unsigned shift) const;
+      inline AVX512BitMask operator>>(unsigned shift) const;
+    public:
+      inline AVX512BitMask& operator<<=(unsigned shift);
+      inline AVX512BitMask& operator>>=(unsigned shift);
+    public:
+      inline uint64_t get_hash_key(void) const;
+      inline const uint64_t* base(void) const;
+      inline void serialize(Serializer &rez) const;
+      inline void deserialize(Deserializer &derez);
+    public:
+      // Allocates memory that becomes owned by the caller
+      inline char* to_string(void) const;
+    public:
+      static inline int pop_count(const AVX512BitMask<MAX> &mask);
+    protected:
+      union {
+        __m512i avx512_vector[MAX/512];
+        uint64_t bit_vector[MAX/64];
+      } bits;
+    public:
+      static const unsigned ELEMENT_SIZE = 64;
+      static const unsigned ELEMENTS = MAX/ELEMENT_SIZE;
+    } __attribute__((aligned(64)));
+    
+    /////////////////////////////////////////////////////////////
+    // AVX-512 Two-Level Bit Mask  
+    /////////////////////////////////////////////////////////////
+    template<unsigned int MAX>
+    class AVX512TLBitMask : 
+          public Internal::LegionHeapify<AVX512TLBitMask<MAX> > {
+    public:
+      explicit AVX512TLBitMask(uint64_t init = 0);
+      AVX512TLBitMask(const AVX512TLBitMask &rhs);
+      ~AVX512TLBitMask(void);
+    public:
+      inline void set_bit(unsigned bit);
+      inline void unset_bit(unsigned bit);
+      inline void assign_bit(unsigned bit, bool val);
+      inline bool is_set(unsigned bit) const;
+      inline int find_first_set(void) const;
+      inline int find_index_set(int index) const;
+      inline int find_next_set(int start) const;
+      inline void clear(void);
+    public:
+      inline bool operator==(const AVX512TLBitMask &rhs) const;
+      inline bool operator<(const AVX512TLBitMask &rhs) const;
+      inline bool operator!=(const AVX512TLBitMask &rhs) const;
+    public:
+      inline const __m512i& operator()(const unsigned &idx) const;
+      inline __m512i& operator()(const unsigned &idx);
+      inline const uint64_t& operator[](const unsigned &idx) const;
+      inline uint64_t& operator[](const unsigned &idx);
+      inline AVX512TLBitMask& operator=(const AVX512TLBitMask &rhs);
+    public:
+      inline AVX512TLBitMask operator~(void) const;
+      inline AVX512TLBitMask operator|(const AVX512TLBitMask &rhs) const;
+      inline AVX512TLBitMask operator&(const AVX512TLBitMask &rhs) const;
+      inline AVX512TLBitMask operator^(const AVX512TLBitMask &rhs) const;
+    public:
+      inline AVX512TLBitMask& operator|=(const AVX512TLBitMask &rhs);
+      inline AVX512TLBitMask& operator&=(const AVX512TLBitMask &rhs);
+      inline AVX512TLBitMask& operator^=(const AVX512TLBitMask &rhs);
+    public:
+      // Use * for disjointness testing
+      inline bool operator*(const AVX512TLBitMask &rhs) const;
+      // Set difference
+      inline AVX512TLBitMask operator-(const AVX512TLBitMask &rhs) const;
+      inline AVX512TLBitMask& operator-=(const AVX512TLBitMask &rhs);
+      // Test to see if everything is zeros
+      inline bool operator!(void) const;
+    public:
+      inline AVX512TLBitMask operator<<(unsigned shift) const;
+      inline AVX512TLBitMask operator>>(unsigned shift) const;
+    public:
+      inline AVX512TLBitMask& operator<<=(unsigned shift);
+      inline AVX512TLBitMask& operator>>=(unsigned shift);
+    public:
+      inline uint64_t get_hash_key(void) const;
+      inline const uint64_t* base(void) const;
+      inline void serialize(Serializer &rez) const;
+      inline void deserialize(Deserializer &derez);
+    public:
+      // Allocates memory that becomes owned by the caller
+      inline char* to_string(void) const;
+    public:
+      static inline int pop_count(const AVX512TLBitMask<MAX> &mask);
+      static inline uint64_t extract_mask(__m512i value);
+    protected:
+      union {
+        __m512i avx512_vector[MAX/512];
+        uint64_t bit_vector[MAX/64];
+      } bits;
+      uint64_t sum_mask;
+    public:
+      static const unsigned ELEMENT_SIZE = 64;
+      static const unsigned ELEMENTS = MAX/ELEMENT_SIZE;
+    } __attribute__((aligned(64)));
+#endif // __AVX512F__
+
     template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
     class CompoundBitMask {
     public:
@@ -1107,6 +1362,102 @@ namespace Legion {
       static const int ELEMENT_SIZE = MAX;
     };
 
+    /////////////////////////////////////////////////////////////
+    // Sparse Bit Mask 
+    /////////////////////////////////////////////////////////////
+    /*
+     * A bit mask that stores up to CNT set bits inline as a sorted
+     * list of indexes and switches over to a heap allocated BITMASK
+     * once it has more bits than that. The representation is always
+     * canonical (a mask is dense if and only if it has more than CNT
+     * bits set), so equal masks have equal representations. For the
+     * common case of only a few fields being named, this makes a mask
+     * 16 bytes independent of MAX, at the cost of an allocation for
+     * every dense mask.
+     */
+    template<typename BITMASK, unsigned int MAX, 
+             unsigned int CNT/* = 7 (inline indexes)*/>
+    class SparseBitMask : 
+      public Internal::LegionHeapify<SparseBitMask<BITMASK,MAX,CNT> > {
+    public:
+      explicit SparseBitMask(uint64_t init = 0);
+      SparseBitMask(const SparseBitMask &rhs);
+      ~SparseBitMask(void);
+    public:
+      inline void set_bit(unsigned bit);
+      inline void unset_bit(unsigned bit);
+      inline void assign_bit(unsigned bit, bool val);
+      inline bool is_set(unsigned bit) const;
+      inline int find_first_set(void) const;
+      inline int find_index_set(int index) const;
+      inline int find_next_set(int start) const;
+      inline void clear(void);
+    public:
+      inline bool operator==(const SparseBitMask &rhs) const;
+      inline bool operator<(const SparseBitMask &rhs) const;
+      inline bool operator!=(const SparseBitMask &rhs) const;
+    public:
+      inline SparseBitMask& operator=(const SparseBitMask &rhs);
+    public:
+      inline SparseBitMask operator~(void) const;
+      inline SparseBitMask operator|(const SparseBitMask &rhs) const;
+      inline SparseBitMask operator&(const SparseBitMask &rhs) const;
+      inline SparseBitMask operator^(const SparseBitMask &rhs) const;
+    public:
+      inline SparseBitMask& operator|=(const SparseBitMask &rhs);
+      inline SparseBitMask& operator&=(const SparseBitMask &rhs);
+      inline SparseBitMask& operator^=(const SparseBitMask &rhs);
+    public:
+      // Use * for disjointness testing
+      inline bool operator*(const SparseBitMask &rhs) const;
+      // Set difference
+      inline SparseBitMask operator-(const SparseBitMask &rhs) const;
+      inline SparseBitMask& operator-=(const SparseBitMask &rhs);
+      // Test to see if everything is zeros
+      inline bool operator!(void) const;
+    public:
+      inline SparseBitMask operator<<(unsigned shift) const;
+      inline SparseBitMask operator>>(unsigned shift) const;
+    public:
+      inline SparseBitMask& operator<<=(unsigned shift);
+      inline SparseBitMask& operator>>=(unsigned shift);
+    public:
+      inline uint64_t get_hash_key(void) const;
+      inline void serialize(Serializer &rez) const;
+      inline void deserialize(Deserializer &derez);
+    public:
+      // Allocates memory that becomes owned by the caller
+      inline char* to_string(void) const;
+    public:
+      static inline int pop_count(const SparseBitMask &mask);
+    protected:
+      enum MergeKind {
+        MERGE_UNION,
+        MERGE_INTERSECT,
+        MERGE_DIFFERENCE,
+        MERGE_SYMMETRIC,
+      };
+      inline bool is_dense(void) const { return (count == DENSE_CNT); }
+      // Returns this mask as a dense mask, using scratch if needed
+      inline const BITMASK& dense_view(BITMASK &scratch) const;
+      // Converts this mask to the dense representation in place 
+      inline BITMASK& make_dense(void);
+      // Goes back to the sparse representation if few enough bits are set
+      inline void normalize(void);
+      inline void merge_sparse(const SparseBitMask &rhs, MergeKind kind);
+      inline void assign_indexes(const uint16_t *indexes, unsigned num);
+    protected:
+      union {
+        uint16_t sparse[CNT];
+        BITMASK *dense;
+      } bits;
+      uint16_t count;
+    public:
+      static const unsigned DENSE_CNT = 0xFFFF;
+      static const int ELEMENTS = 1;
+      static const int ELEMENT_SIZE = MAX;
+    };
+
     /////////////////////////////////////////////////////////////
     // Bit Permutation 
     /////////////////////////////////////////////////////////////
@@ -1167,10 +1518,25 @@ namespace Legion {
       // implementations but in general it should be close
       static const size_t STL_SET_NODE_SIZE = 32;
     public:
+      // Sets switch between three representations depending on which
+      // is smallest: an STL set for a few scattered values, a list of
+      // inclusive ranges for values that come in long runs (so the set
+      // of all nodes 0..N is a single range), and a dense bit mask 
+      enum Representation {
+        SPARSE_REPRESENTATION,
+        RANGE_REPRESENTATION,
+        DENSE_REPRESENTATION
+      };
+      typedef std::pair<IT,IT> Range;
       struct DenseSet {
       public:
         DT set;
       };
+      struct RangeSet {
+      public:
+        // sorted, disjoint, and never adjacent
+        std::vector<Range> ranges;
+      };
       struct UnionFunctor {
       public:
         UnionFunctor(IntegerSet &t) : target(t) { }
@@ -1207,6 +1573,8 @@ namespace Legion {
     public:
       inline bool contains(IT index) const;
       inline void add(IT index);
+      // Add all the values in [first,last] inclusive
+      inline void add_range(IT first, IT last);
       inline void remove(IT index);
       inline IT find_first_set(void) const;
       inline IT find_index_set(int index) const;
@@ -1233,9 +1601,27 @@ namespace Legion {
       inline void clear(void);
       inline IntegerSet& swap(IntegerSet &rhs);
     protected:
-      bool sparse;
+      inline void release(void);
+      inline void copy_from(const IntegerSet &rhs);
+      inline void convert_to_dense(void);
+      inline void convert_to_sparse(void);
+      inline void convert_to_ranges(void);
+      // Pick a new representation after range updates if needed
+      inline void check_ranges(void);
+      static inline void insert_range(std::vector<Range> &ranges,
+                                      IT first, IT last);
+      static inline void remove_value(std::vector<Range> &ranges, IT index);
+      static inline void intersect_ranges(const std::vector<Range> &lhs,
+                                          const std::vector<Range> &rhs,
+                                          std::vector<Range> &result);
+      static inline void subtract_ranges(const std::vector<Range> &lhs,
+                                         const std::vector<Range> &rhs,
+                                         std::vector<Range> &result);
+    protected:
+      Representation representation;
       union {
         typename std::set<IT>* sparse;
+        RangeSet*              ranged;
         DenseSet*              dense;
       } set_ptr;
     };
@@ -1327,6 +1713,8 @@ namespace Legion {
     public:
       size_t max_entries(void) const;
       bool has_entry(IT index) const;
+      // Return the entry if it has already been made, NULL otherwise
+      ET* find_entry(IT index) const;
       ET* lookup_entry(IT index);
       template<typename T>
       ET* lookup_entry(IT index, const T &arg);
@@ -1336,6 +1724,9 @@ namespace Legion {
       NodeBase* new_tree_node(int level, IT first_index, IT last_index);
       NodeBase* lookup_leaf(IT index);
     protected:
+      // Child pointers and the root are published with release stores
+      // and read with acquire loads, so lookups of populated entries 
+      // never take a lock; the locks only serialize growing the tree
       NodeBase *volatile root;
       Reservation lock; 
     };
@@ -1359,10 +1750,286 @@ namespace Legion {
       }
     };
 
+    /////////////////////////////////////////////////////////////
+    // Flat Hash Map 
+    /////////////////////////////////////////////////////////////
+    // Default hash for flat hash maps. Keys are converted to a
+    // 64-bit integer and then mixed so that dense ranges of IDs 
+    // still spread across the whole table.
+    template<typename T>
+    struct FlatHash {
+    public:
+      inline size_t operator()(const T &key) const
+        { return mix(static_cast<uint64_t>(key)); }
+    public:
+      static inline size_t mix(uint64_t key);
+    };
+
+    template<typename T>
+    struct FlatHash<T*> {
+    public:
+      inline size_t operator()(T *key) const
+        { return FlatHash<uintptr_t>::mix(reinterpret_cast<uintptr_t>(key)); }
+    };
+
+    // An open-addressing hash map with linear probing for hot lookup
+    // tables that would otherwise be an STL map. All entries live in 
+    // one array so a lookup touches a couple of cache lines and an
+    // insertion does no allocation unless the table has to grow.
+    // Deletions shift later entries back so there are no tombstones.
+    // Unlike std::map, any insertion or deletion invalidates all 
+    // iterators, and iteration order is unspecified.
+    template<typename KEY, typename VAL, typename HASH, typename ALLOCATOR>
+    class FlatHashMap {
+    public:
+      typedef KEY                           key_type;
+      typedef VAL                        mapped_type;
+      typedef std::pair<const KEY,VAL>    value_type;
+      typedef size_t                       size_type;
+    public:
+      // Tables never shrink and never exceed 3/4 full
+      static const size_t MIN_CAPACITY = 8;
+    protected:
+      typedef typename ALLOCATOR::template 
+                rebind<value_type>::other    SlotAllocator;
+      typedef typename ALLOCATOR::template 
+                rebind<unsigned char>::other StateAllocator;
+    public:
+      template<typename MAP, typename VT>
+      class IteratorBase {
+      public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef VT                               value_type;
+        typedef ptrdiff_t                   difference_type;
+        typedef VT*                                 pointer;
+        typedef VT&                               reference;
+      public:
+        IteratorBase(void) : map(NULL), slot(0) { }
+        IteratorBase(MAP *m, size_t s) : map(m), slot(s) { }
+        template<typename M2, typename V2>
+        IteratorBase(const IteratorBase<M2,V2> &rhs)
+          : map(rhs.map), slot(rhs.slot) { }
+      public:
+        inline reference operator*(void) const 
+          { return map->slots[slot]; }
+        inline pointer operator->(void) const 
+          { return &(map->slots[slot]); }
+        inline IteratorBase& operator++(void)
+          { slot = map->next_occupied(slot+1); return *this; }
+        inline IteratorBase operator++(int)
+          { IteratorBase result = *this; ++(*this); return result; }
+        template<typename M2, typename V2>
+        inline bool operator==(const IteratorBase<M2,V2> &rhs) const
+          { return (slot == rhs.slot); }
+        template<typename M2, typename V2>
+        inline bool operator!=(const IteratorBase<M2,V2> &rhs) const
+          { return (slot != rhs.slot); }
+      public:
+        MAP *map;
+        size_t slot;
+      };
+      typedef IteratorBase<FlatHashMap,value_type> iterator;
+      typedef IteratorBase<const FlatHashMap,const value_type> const_iterator;
+    public:
+      FlatHashMap(void);
+      FlatHashMap(const FlatHashMap &rhs);
+      ~FlatHashMap(void);
+    public:
+      FlatHashMap& operator=(const FlatHashMap &rhs);
+    public:
+      inline iterator begin(void) 
+        { return iterator(this, next_occupied(0)); }
+      inline iterator end(void) { return iterator(this, capacity); }
+      inline const_iterator begin(void) const
+        { return const_iterator(this, next_occupied(0)); }
+      inline const_iterator end(void) const 
+        { return const_iterator(this, capacity); }
+      inline size_t size(void) const { return num_entries; }
+      inline bool empty(void) const { return (num_entries == 0); }
+    public:
+      inline iterator find(const KEY &key)
+        { return iterator(this, find_slot(key)); }
+      inline const_iterator find(const KEY &key) const
+        { return const_iterator(this, find_slot(key)); }
+      inline size_t count(const KEY &key) const
+        { return (find_slot(key) < capacity) ? 1 : 0; }
+      std::pair<iterator,bool> insert(const value_type &value);
+      VAL& operator[](const KEY &key);
+      size_t erase(const KEY &key);
+      void erase(iterator it);
+      void clear(void);
+      void reserve(size_t entries);
+      void swap(FlatHashMap &rhs);
+    protected:
+      inline size_t ideal_slot(const KEY &key) const
+        { return (hasher(key) & (capacity - 1)); }
+      size_t find_slot(const KEY &key) const;
+      size_t next_occupied(size_t slot) const;
+      void rehash(size_t new_capacity);
+      void erase_slot(size_t slot);
+    protected:
+      value_type *slots;
+      unsigned char *states;
+      size_t capacity;
+      size_t num_entries;
+      HASH hasher;
+      SlotAllocator slot_allocator;
+      StateAllocator state_allocator;
+    };
+
+    /////////////////////////////////////////////////////////////
+    // Flat Vector Map 
+    /////////////////////////////////////////////////////////////
+    // A map kept as a sorted vector of pairs. Lookups are binary
+    // searches over contiguous memory and insertions shift the tail
+    // of the vector, so this is best for small maps that are read
+    // much more often than they are modified, or that need ordered
+    // iteration. Keys must not be modified through iterators, and
+    // any insertion or deletion invalidates all iterators.
+    template<typename KEY, typename VAL, typename COMPARATOR, 
+             typename ALLOCATOR>
+    class FlatVectorMap {
+    public:
+      typedef KEY                           key_type;
+      typedef VAL                        mapped_type;
+      typedef std::pair<KEY,VAL>          value_type;
+      typedef size_t                       size_type;
+      typedef std::vector<value_type, typename ALLOCATOR::template
+                            rebind<value_type>::other> VectorType;
+      typedef typename VectorType::iterator             iterator;
+      typedef typename VectorType::const_iterator const_iterator;
+    protected:
+      struct EntryComparator {
+      public:
+        inline bool operator()(const value_type &lhs, const KEY &rhs) const
+          { return comp(lhs.first, rhs); }
+      public:
+        COMPARATOR comp;
+      };
+    public:
+      inline iterator begin(void) { return entries.begin(); }
+      inline iterator end(void) { return entries.end(); }
+      inline const_iterator begin(void) const { return entries.begin(); }
+      inline const_iterator end(void) const { return entries.end(); }
+      inline size_t size(void) const { return entries.size(); }
+      inline bool empty(void) const { return entries.empty(); }
+    public:
+      inline iterator lower_bound(const KEY &key)
+        { return std::lower_bound(entries.begin(), entries.end(), 
+                                  key, EntryComparator()); }
+      inline const_iterator lower_bound(const KEY &key) const
+        { return std::lower_bound(entries.begin(), entries.end(), 
+                                  key, EntryComparator()); }
+      iterator find(const KEY &key);
+      const_iterator find(const KEY &key) const;
+      inline size_t count(const KEY &key) const
+        { return (find(key) != entries.end()) ? 1 : 0; }
+      std::pair<iterator,bool> insert(const value_type &value);
+      VAL& operator[](const KEY &key);
+      size_t erase(const KEY &key);
+      inline iterator erase(iterator it) { return entries.erase(it); }
+      inline void clear(void) { entries.clear(); }
+      inline void reserve(size_t count) { entries.reserve(count); }
+      inline void swap(FlatVectorMap &rhs) { entries.swap(rhs.entries); }
+    protected:
+      inline bool matches(const_iterator it, const KEY &key) const
+        { return (it != entries.end()) && !comp(key, it->first); }
+    protected:
+      VectorType entries;
+      COMPARATOR comp;
+    };
+
+    // Analogues of LegionMap for the flat containers, with the same 
+    // allocation tracking options, so that hot maps can be switched
+    // over by changing only their declarations
+    template<typename T1, typename T2, 
+             Internal::AllocationType A = Internal::LAST_ALLOC,
+             typename HASH = FlatHash<T1> >
+    struct LegionHashMap {
+      typedef FlatHashMap<T1, T2, HASH, Internal::LegionAllocator<
+                std::pair<const T1, T2>, A, false/*aligned*/> > tracked;
+      typedef FlatHashMap<T1, T2, HASH, 
+                Internal::AlignedAllocator<std::pair<const T1, T2> > > aligned;
+      typedef FlatHashMap<T1, T2, HASH, Internal::LegionAllocator<
+                std::pair<const T1, T2>, A, true/*aligned*/> > track_aligned;
+    };
+
+    template<typename T1, typename T2, 
+             Internal::AllocationType A = Internal::LAST_ALLOC,
+             typename COMPARATOR = std::less<T1> >
+    struct LegionFlatMap {
+      typedef FlatVectorMap<T1, T2, COMPARATOR, Internal::LegionAllocator<
+                std::pair<T1, T2>, A, false/*aligned*/> > tracked;
+      typedef FlatVectorMap<T1, T2, COMPARATOR,
+                Internal::AlignedAllocator<std::pair<T1, T2> > > aligned;
+      typedef FlatVectorMap<T1, T2, COMPARATOR, Internal::LegionAllocator<
+                std::pair<T1, T2>, A, true/*aligned*/> > track_aligned;
+    };
+
     //--------------------------------------------------------------------------
     // Give the implementations here so the templates get instantiated
     //--------------------------------------------------------------------------
 
+    //--------------------------------------------------------------------------
+    inline void LocalLock::lock_exclusive(void) const
+    //--------------------------------------------------------------------------
+    {
+      unsigned spins = 0;
+      while (true)
+      {
+        const unsigned current = state;
+        // Free except for other waiting writers, try to take it
+        if ((current & ~WRITER_WAITING) == 0)
+        {
+          if (__sync_bool_compare_and_swap(&state, current, WRITER_HELD))
+            return;
+          continue;
+        }
+        // Otherwise hold off new readers until we get our turn
+        if (!(current & WRITER_WAITING))
+          __sync_fetch_and_or(&state, WRITER_WAITING);
+        backoff(spins);
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    inline void LocalLock::lock_shared(void) const
+    //--------------------------------------------------------------------------
+    {
+      unsigned spins = 0;
+      while (true)
+      {
+        const unsigned current = state;
+        // Readers yield to both holding and waiting writers
+        if (!(current & (WRITER_HELD | WRITER_WAITING)))
+        {
+          if (__sync_bool_compare_and_swap(&state, current, current + 1))
+            return;
+          continue;
+        }
+        backoff(spins);
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    /*static*/ inline void LocalLock::backoff(unsigned &spins)
+    //--------------------------------------------------------------------------
+    {
+      // Spin for exponentially longer stretches before giving up the core
+      if (spins < 10)
+      {
+        for (unsigned idx = 0; idx < (1U << spins); idx++)
+        {
+#if defined(__i386__) || defined(__x86_64__)
+          _mm_pause();
+#endif
+        }
+        spins++;
+      }
+      else
+        sched_yield();
+    }
+
     //--------------------------------------------------------------------------
     inline Serializer& Serializer::operator=(const Serializer &rhs)
     //--------------------------------------------------------------------------
@@ -1452,6 +2119,33 @@ namespace Legion {
     }
 #endif
 
+#ifdef __AVX512F__
+    //--------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline void Serializer::serialize(const AVX512BitMask<MAX> &mask)
+    //--------------------------------------------------------------------------
+    {
+      mask.serialize(*this);
+    }
+
+    //--------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline void Serializer::serialize(const AVX512TLBitMask<MAX> &mask)
+    //--------------------------------------------------------------------------
+    {
+      mask.serialize(*this);
+    }
+#endif
+
+    //--------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline void Serializer::serialize(
+                                  const SparseBitMask<BITMASK,MAX,CNT> &mask)
+    //--------------------------------------------------------------------------
+    {
+      mask.serialize(*this);
+    }
+
     //--------------------------------------------------------------------------
     template<typename IT, typename DT, bool BIDIR>
     inline void Serializer::serialize(const IntegerSet<IT,DT,BIDIR> &int_set)
@@ -1550,19 +2244,88 @@ namespace Legion {
     }
 
     //--------------------------------------------------------------------------
-    inline void Serializer::resize(void)
+    inline void* Serializer::get_headroom(size_t bytes)
     //--------------------------------------------------------------------------
     {
-      // Double the buffer size
-      total_bytes *= 2;
-#ifdef DEBUG_LEGION
-      assert(total_bytes != 0); // this would cause deallocation
-#endif
-      char *next = (char*)realloc(buffer,total_bytes);
 #ifdef DEBUG_LEGION
-      assert(next != NULL);
+      assert(bytes <= MESSAGE_HEADROOM);
 #endif
-      buffer = next;
+      return buffer - bytes;
+    }
+
+    //--------------------------------------------------------------------------
+    inline void Serializer::resize(void)
+    //--------------------------------------------------------------------------
+    {
+      // Double the buffer size
+      size_t next_bytes = 2 * total_bytes;
+#ifdef DEBUG_LEGION
+      assert(next_bytes != 0); // this would cause deallocation
+#endif
+      char *next = allocate_buffer(next_bytes);
+      memcpy(next + MESSAGE_HEADROOM, buffer, index);
+      if (allocation != inline_storage)
+        release_buffer(allocation, total_bytes);
+      total_bytes = next_bytes;
+      allocation = next;
+      buffer = next + MESSAGE_HEADROOM;
+    }
+
+    //--------------------------------------------------------------------------
+    /*static*/ inline Serializer::BufferCache& 
+                                          Serializer::get_buffer_cache(void)
+    //--------------------------------------------------------------------------
+    {
+      static __thread BufferCache cache;
+      return cache;
+    }
+
+    //--------------------------------------------------------------------------
+    /*static*/ inline char* Serializer::allocate_buffer(size_t &bytes)
+    //--------------------------------------------------------------------------
+    {
+      // Round up to the next size class so the buffer can be recycled
+      size_t class_bytes = MIN_POOLED_BYTES;
+      for (unsigned idx = 0; idx < POOLED_SIZE_CLASSES; idx++)
+      {
+        if (bytes <= class_bytes)
+        {
+          bytes = class_bytes;
+          BufferCache &cache = get_buffer_cache();
+          if (cache.counts[idx] > 0)
+            return cache.buffers[idx][--cache.counts[idx]];
+          break;
+        }
+        class_bytes *= 2;
+      }
+      char *result = (char*)malloc(bytes + MESSAGE_HEADROOM);
+#ifdef DEBUG_LEGION
+      assert(result != NULL);
+#endif
+      return result;
+    }
+
+    //--------------------------------------------------------------------------
+    /*static*/ inline void Serializer::release_buffer(char *allocation,
+                                                      size_t bytes)
+    //--------------------------------------------------------------------------
+    {
+      size_t class_bytes = MIN_POOLED_BYTES;
+      for (unsigned idx = 0; idx < POOLED_SIZE_CLASSES; idx++)
+      {
+        if (bytes == class_bytes)
+        {
+          BufferCache &cache = get_buffer_cache();
+          if (cache.counts[idx] < POOLED_BUFFERS_PER_CLASS)
+          {
+            cache.buffers[idx][cache.counts[idx]++] = allocation;
+            return;
+          }
+          break;
+        }
+        class_bytes *= 2;
+      }
+      free(allocation);
     }
 
     //--------------------------------------------------------------------------
@@ -1658,6 +2421,32 @@ namespace Legion {
     }
 #endif
 
+#ifdef __AVX512F__
+    //--------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline void Deserializer::deserialize(AVX512BitMask<MAX> &mask)
+    //--------------------------------------------------------------------------
+    {
+      mask.deserialize(*this);
+    }
+
+    //--------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline void Deserializer::deserialize(AVX512TLBitMask<MAX> &mask)
+    //--------------------------------------------------------------------------
+    {
+      mask.deserialize(*this);
+    }
+#endif
+
+    //--------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline void Deserializer::deserialize(SparseBitMask<BITMASK,MAX,CNT> &mask)
+    //--------------------------------------------------------------------------
+    {
+      mask.deserialize(*this);
+    }
+
     //--------------------------------------------------------------------------
     template<typename IT, typename DT, bool BIDIR>
     inline void Deserializer::deserialize(IntegerSet<IT,DT,BIDIR> &int_set)
@@ -4715,9 +5504,9 @@ namespace Legion {
       uint64_t left = _mm_extract_epi64(value, 0);
       uint64_t right = _mm_extract_epi64(value, 1);
 #else
-      // Assume we have sse 2
+      // Assume we have sse 2, move the upper 64 bits down to read them
       uint64_t left = _mm_cvtsi128_si64(value);
-      uint64_t right = _mm_cvtsi128_si64(_mm_shuffle_epi32(value, 7));
+      uint64_t right = _mm_cvtsi128_si64(_mm_unpackhi_epi64(value, value));
 #endif
       return (left | right);
     }
@@ -6242,1092 +7031,2871 @@ namespace Legion {
 #undef AVX_ELMTS
 #endif // __AVX__
 
+#ifdef __AVX512F__
+#define AVX512_ELMTS (MAX/512)
+#define BIT_ELMTS (MAX/64)
     //-------------------------------------------------------------------------
-    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    CompoundBitMask<BITMASK,MAX,WORDS>::CompoundBitMask(uint64_t init)
+    template<unsigned int MAX>
+    AVX512BitMask<MAX>::AVX512BitMask(uint64_t init /*= 0*/)
     //-------------------------------------------------------------------------
     {
-      LEGION_STATIC_ASSERT(WORDS >= 2);
-      LEGION_STATIC_ASSERT(VAL_BITS <= (8*sizeof(uint64_t)));
-      LEGION_STATIC_ASSERT((1 << VAL_BITS) >= MAX);
-      if (init == 0)
-      {
-        set_count(0);
-      }
-      else
+      LEGION_STATIC_ASSERT((MAX % 512) == 0);
+      for (unsigned idx = 0; idx < BIT_ELMTS; idx++)
       {
-        set_count(DENSE_CNT);
-        set_dense(new BITMASK(init));
+        bits.bit_vector[idx] = init;
       }
     }
 
     //-------------------------------------------------------------------------
-    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    CompoundBitMask<BITMASK,MAX,WORDS>::CompoundBitMask(
-                                                    const CompoundBitMask &rhs)
+    template<unsigned int MAX>
+    AVX512BitMask<MAX>::AVX512BitMask(const AVX512BitMask &rhs)
     //-------------------------------------------------------------------------
     {
-      int rhs_count = rhs.get_count();
-      if (rhs_count == SPARSE_CNT)
-      {
-        set_count(SPARSE_CNT);
-        set_sparse(new SparseSet(*rhs.get_sparse()));
-      }
-      else if (rhs_count == DENSE_CNT)
-      {
-        set_count(DENSE_CNT); 
-        set_dense(new BITMASK(*rhs.get_dense()));
-      }
-      else
+      LEGION_STATIC_ASSERT((MAX % 512) == 0);
+      for (unsigned idx = 0; idx < AVX512_ELMTS; idx++)
       {
-        for (unsigned idx = 0; idx < WORDS; idx++)
-          bits[idx] = rhs.bits[idx];
+        bits.avx512_vector[idx] = rhs(idx);
       }
     }
 
     //-------------------------------------------------------------------------
-    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    CompoundBitMask<BITMASK,MAX,WORDS>::~CompoundBitMask(void) 
+    template<unsigned int MAX>
+    AVX512BitMask<MAX>::~AVX512BitMask(void)
     //-------------------------------------------------------------------------
     {
-      int count = get_count();
-      if (count == SPARSE_CNT)
-        delete get_sparse();
-      else if (count == DENSE_CNT)
-        delete get_dense();
     }
 
     //-------------------------------------------------------------------------
-    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline int CompoundBitMask<BITMASK,MAX,WORDS>::get_count(void) const
+    template<unsigned int MAX>
+    inline void AVX512BitMask<MAX>::set_bit(unsigned bit)
     //-------------------------------------------------------------------------
     {
-      return (CNT_MASK & bits[0]); 
+#ifdef DEBUG_LEGION
+      assert(bit < MAX);
+#endif
+      unsigned idx = bit >> 6;
+      bits.bit_vector[idx] |= (1UL << (bit & 0x3F));
     }
 
     //-------------------------------------------------------------------------
-    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline void CompoundBitMask<BITMASK,MAX,WORDS>::set_count(int size) 
+    template<unsigned int MAX>
+    inline void AVX512BitMask<MAX>::unset_bit(unsigned bit)
     //-------------------------------------------------------------------------
     {
-      bits[0] = (size & CNT_MASK) | (bits[0] & ~CNT_MASK);
+#ifdef DEBUG_LEGION
+      assert(bit < MAX);
+#endif
+      unsigned idx = bit >> 6;
+      bits.bit_vector[idx] &= ~(1UL << (bit & 0x3F));
     }
 
     //-------------------------------------------------------------------------
-    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline typename CompoundBitMask<BITMASK,MAX,WORDS>::SparseSet* 
-                    CompoundBitMask<BITMASK,MAX,WORDS>::get_sparse(void) const
+    template<unsigned int MAX>
+    inline void AVX512BitMask<MAX>::assign_bit(unsigned bit, bool val)
     //-------------------------------------------------------------------------
     {
-#ifdef DEBUG_LEGION
-      assert(get_count() == SPARSE_CNT);
-#endif
-      return reinterpret_cast<SparseSet*>(bits[1]);
+      if (val)
+        set_bit(bit);
+      else
+        unset_bit(bit);
     }
 
     //-------------------------------------------------------------------------
-    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline void CompoundBitMask<BITMASK,MAX,WORDS>::set_sparse(SparseSet *ptr)
+    template<unsigned int MAX>
+    inline bool AVX512BitMask<MAX>::is_set(unsigned bit) const
     //-------------------------------------------------------------------------
     {
 #ifdef DEBUG_LEGION
-      assert(get_count() == SPARSE_CNT);
+      assert(bit < MAX);
 #endif
-      bits[1] = reinterpret_cast<uint64_t>(ptr);
+      unsigned idx = bit >> 6;
+      return (bits.bit_vector[idx] & (1UL << (bit & 0x3F)));
     }
 
     //-------------------------------------------------------------------------
-    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline BITMASK* CompoundBitMask<BITMASK,MAX,WORDS>::get_dense(void) const
+    template<unsigned int MAX>
+    inline int AVX512BitMask<MAX>::find_first_set(void) const
     //-------------------------------------------------------------------------
     {
-#ifdef DEBUG_LEGION
-      assert(get_count() == DENSE_CNT);
-#endif
-      return reinterpret_cast<BITMASK*>(bits[1]);
+      for (unsigned idx = 0; idx < BIT_ELMTS; idx++)
+      {
+        if (bits.bit_vector[idx])
+        {
+          for (unsigned j = 0; j < ELEMENT_SIZE; j++)
+          {
+            if (bits.bit_vector[idx] & (1UL << j))
+            {
+              return (idx*ELEMENT_SIZE + j);
+            }
+          }
+        }
+      }
+      return -1;
     }
 
     //-------------------------------------------------------------------------
-    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline void CompoundBitMask<BITMASK,MAX,WORDS>::set_dense(BITMASK *ptr) 
+    template<unsigned int MAX>
+    inline int AVX512BitMask<MAX>::find_index_set(int index) const
     //-------------------------------------------------------------------------
     {
-#ifdef DEBUG_LEGION
-      assert(get_count() == DENSE_CNT);
-#endif
-      bits[1] = reinterpret_cast<uint64_t>(ptr);
+      int offset = 0;
+      for (unsigned idx = 0; idx < BIT_ELMTS; idx++)
+      {
+        int local = __builtin_popcount(bits.bit_vector[idx]);
+        if (index <= local)
+        {
+          for (unsigned j = 0; j < ELEMENT_SIZE; j++)
+          {
+            if (bits.bit_vector[idx] & (1ULL << j))
+            {
+              if (index == 0)
+                return (offset + j);
+              index--;
+            }
+          }
+        }
+        index -= local;
+        offset += ELEMENT_SIZE;
+      }
+      return -1;
     }
 
     //-------------------------------------------------------------------------
-    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-      template<bool CAN_OVERLAP>
-    inline int CompoundBitMask<BITMASK,MAX,WORDS>::get_value(int idx) const
+    template<unsigned int MAX>
+    inline int AVX512BitMask<MAX>::find_next_set(int start) const
     //-------------------------------------------------------------------------
     {
-#ifdef DEBUG_LEGION
-      assert(idx < MAX_CNT);
-#endif
-      int start_bit = CNT_BITS + idx*VAL_BITS;
-      int start_index = start_bit >> WORD_BITS;
-      start_bit &= WORD_MASK;
-      if (CAN_OVERLAP)
+      if (start < 0)
+        start = 0;
+      int idx = start / ELEMENT_SIZE; // truncate
+      int offset = idx * ELEMENT_SIZE; 
+      int j = start % ELEMENT_SIZE;
+      if (j > 0) // if we are already in the middle of element search it
       {
-        // See if we straddle words 
-        if ((start_bit + (VAL_BITS-1)) < WORD_SIZE)
-        {
-#ifdef DEBUG_LEGION
-          assert(start_index < WORDS);
-#endif
-          // Common case, all in one word
-          return (bits[start_index] & (VAL_MASK << start_bit)) >> start_bit;
-        }
-        else
+        for ( ; j < int(ELEMENT_SIZE); j++)
         {
-#ifdef DEBUG_LEGION
-          assert((start_index+1) < WORDS);
-#endif
-          // Value split across words
-          int first_word_bits = WORD_SIZE - start_bit;
-          // Okay to shit off the end here
-          int result = 
-            int((bits[start_index] & (VAL_MASK << start_bit)) >> start_bit);
-          // Okay to shift off the end here
-          uint64_t next_mask = VAL_MASK >> first_word_bits;
-          result |= int((bits[start_index+1] & next_mask) << first_word_bits);
-          return result;
+          if (bits.bit_vector[idx] & (1ULL << j))
+            return (offset + j);
         }
+        idx++;
+        offset += ELEMENT_SIZE;
       }
-      else
+      for ( ; idx < int(BIT_ELMTS); idx++)
       {
-#ifdef DEBUG_LEGION
-        assert(start_index < WORDS);
-#endif
-        return (bits[start_index] & (VAL_MASK << start_bit)) >> start_bit;
+        if (bits.bit_vector[idx] > 0) // if it has any valid entries, find next
+        {
+          for (j = 0; j < int(ELEMENT_SIZE); j++)
+          {
+            if (bits.bit_vector[idx] & (1ULL << j))
+              return (offset + j);
+          }
+        }
+        offset += ELEMENT_SIZE;
       }
+      return -1;
     }
 
     //-------------------------------------------------------------------------
-    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-      template<bool CAN_OVERLAP>
-    inline void CompoundBitMask<BITMASK,MAX,WORDS>::set_value(int idx, 
-                                                              int value) 
+    template<unsigned int MAX>
+    inline void AVX512BitMask<MAX>::clear(void)
     //-------------------------------------------------------------------------
     {
-#ifdef DEBUG_LEGION
-      assert(idx < MAX_CNT);
-#endif
-      // Cast up the value
-      uint64_t up_value = value;
-      int start_bit = CNT_BITS + idx*VAL_BITS;
-      int start_index = start_bit >> WORD_BITS;
-      start_bit &= WORD_MASK;
-      uint64_t negative_mask = ~(VAL_MASK << start_bit);
-      if (CAN_OVERLAP)
-      {
-        // See if we straddle words
-        if ((start_bit + (VAL_BITS-1)) < WORD_SIZE)
-        {
-#ifdef DEBUG_LEGION
-          assert(start_index < WORDS);
-#endif
-          // Common case, all in one word
-          bits[start_index] = (bits[start_index] & negative_mask) |
-                              (up_value << start_bit);
-        }
-        else
-        {
-#ifdef DEBUG_LEGION
-          assert((start_index+1) < WORDS);
-#endif
-          // Value split across words
-          // Okay to shift off the end here
-          bits[start_index] = (bits[start_index] & negative_mask) |
-                              (up_value << start_bit);
-          int first_word_bits = WORD_SIZE - start_bit;
-          // Okay to shift off the end here
-          uint64_t next_negative = ~(VAL_MASK >> first_word_bits);
-          bits[start_index+1] = (bits[start_index+1] & next_negative) |
-                                (up_value >> first_word_bits);
-        }
-      }
-      else
+      for (unsigned idx = 0; idx < AVX512_ELMTS; idx++)
       {
-#ifdef DEBUG_LEGION
-        assert(start_index < WORDS);
-#endif
-        bits[start_index] = (bits[start_index] & negative_mask) |
-                            (up_value << start_bit);
+        bits.avx512_vector[idx] = _mm512_setzero_si512();
       }
     }
 
     //-------------------------------------------------------------------------
-    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline void CompoundBitMask<BITMASK,MAX,WORDS>::set_bit(unsigned bit)
+    template<unsigned int MAX>
+    inline const __m512i& AVX512BitMask<MAX>::operator()(
+                                                 const unsigned int &idx) const
     //-------------------------------------------------------------------------
     {
-      int count = get_count();
-      if (count < MAX_CNT)
-      {
-        // Check to make sure it isn't already in our list
-        for (int idx = 0; idx < count; idx++)
-          if (get_value<OVERLAP>(idx) == bit)
-            return;
-        // Add it at the next available location
-        set_value<OVERLAP>(count, bit); 
-        set_count(count+1);
-      }
-      else if (count == MAX_CNT)
-      {
-        // We've maxed out, go to sparse or dense 
-        if (SPARSE_MAX > MAX_CNT)
-        {
-          SparseSet *next = new SparseSet();
-          next->insert(bit);
-          for (int idx = 0; idx < MAX_CNT; idx++)
-            next->insert(get_value<OVERLAP>(idx));
-          set_count(SPARSE_CNT);
-          set_sparse(next);
-        }
-        else
-        {
-          BITMASK *next = new BITMASK();
-          next->set_bit(bit);
-          for (int idx = 0; idx < MAX_CNT; idx++)
-            next->set_bit(get_value<OVERLAP>(idx));
-          set_count(DENSE_CNT);
-          set_dense(next);
-        }
-      }
-      else if (count == SPARSE_CNT)
-      {
-        // sparse case 
-        SparseSet *sparse = get_sparse();
-        if (sparse->size() == SPARSE_MAX)
-        {
-          // upgrade to dense 
-          BITMASK *next = new BITMASK();
-          for (SparseSet::const_iterator it = sparse->begin();
-                it != sparse->end(); it++)
-            next->set_bit(*it);
-          delete sparse;
-          set_count(DENSE_CNT);
-          set_dense(next);
-        }
-        else // otherwise just insert
-          sparse->insert(bit);
-      }
-      else
-      {
-        // Dense case
-        get_dense()->set_bit(bit);
-      }
+      return bits.avx512_vector[idx];
     }
 
     //-------------------------------------------------------------------------
-    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline void CompoundBitMask<BITMASK,MAX,WORDS>::unset_bit(unsigned bit)
+    template<unsigned int MAX>
+    inline __m512i& AVX512BitMask<MAX>::operator()(const unsigned int &idx)
     //-------------------------------------------------------------------------
     {
-      int count = get_count(); 
-      if (count == 0)
-        return;
-      else if (count == SPARSE_CNT)
-      {
-        SparseSet *sparse = get_sparse();
-        sparse->erase(bit);
-        if (sparse->size() == MAX_CNT)
-        {
-          set_count(MAX_CNT);
-          unsigned idx = 0;
-          for (SparseSet::const_iterator it = sparse->begin();
-                it != sparse->end(); it++, idx++)
-            set_value<OVERLAP>(idx, *it);   
-          delete sparse;
-        }
-      }
-      else if (count == DENSE_CNT)
-      {
-        BITMASK *dense = get_dense();
-        dense->unset_bit(bit);
-        // If dense is empty come back to zero
-        if (!(*dense))
-        {
-          delete dense;
-          set_count(0);
-        }
-      }
-      else
-      {
-        // Iterate through our elements and see if we find it
-        int found_idx = -1;
-        for (int idx = 0; idx < count; idx++)
-        {
-          if (get_value<OVERLAP>(idx) == bit)
-          {
-            found_idx = idx;
-            break;
-          }
-        }
-        if (found_idx >= 0)
-        {
-          // If we found it shift everyone down and decrement the count
-          for (int idx = found_idx; idx < (count-1); idx++)
-          {
-            int next = get_value<OVERLAP>(idx+1);
-            set_value<OVERLAP>(idx, next);
-          }
-          set_count(count-1);
-        }
-      }
+      return bits.avx512_vector[idx];
     }
 
     //-------------------------------------------------------------------------
-    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline void CompoundBitMask<BITMASK,MAX,WORDS>::assign_bit(unsigned bit,  
-                                                               bool val)
+    template<unsigned int MAX>
+    inline const uint64_t& AVX512BitMask<MAX>::operator[](
+                                                 const unsigned int &idx) const
     //-------------------------------------------------------------------------
     {
-      if (val)
-        set_bit(bit);
-      else
-        unset_bit(bit);
+      return bits.bit_vector[idx];
     }
 
     //-------------------------------------------------------------------------
-    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline bool CompoundBitMask<BITMASK,MAX,WORDS>::is_set(unsigned bit) const
+    template<unsigned int MAX>
+    inline uint64_t& AVX512BitMask<MAX>::operator[](const unsigned int &idx) 
     //-------------------------------------------------------------------------
     {
-      int count = get_count();
-      if (count == 0)
-        return false;
-      else if (count == DENSE_CNT)
-        return get_dense()->is_set(bit);
-      else if (count == SPARSE_CNT)
+      return bits.bit_vector[idx]; 
+    }
+
+
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline bool AVX512BitMask<MAX>::operator==(
+                                                const AVX512BitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      for (unsigned idx = 0; idx < AVX512_ELMTS; idx++)
       {
-        SparseSet *sparse = get_sparse();
-        return (sparse->find(bit) != sparse->end());
+        if (_mm512_cmpneq_epi64_mask(bits.avx512_vector[idx], rhs(idx)))
+          return false;
       }
-      else
+      return true;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline bool AVX512BitMask<MAX>::operator<(const AVX512BitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      // Only be less than if the bits are a subset of the rhs bits
+      for (unsigned idx = 0; idx < BIT_ELMTS; idx++)
       {
-        // Iterate through our elements and see if we have it
-        for (int idx = 0; idx < count; idx++)
-        {
-          if (get_value<OVERLAP>(idx) == bit)
-            return true;
-        }
+        if (bits.bit_vector[idx] < rhs[idx])
+          return true;
+        else if (bits.bit_vector[idx] > rhs[idx])
+          return false;
       }
+      // Otherwise they are equal so false
       return false;
     }
 
     //-------------------------------------------------------------------------
-    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline int CompoundBitMask<BITMASK,MAX,WORDS>::find_first_set(void) const
+    template<unsigned int MAX>
+    inline bool AVX512BitMask<MAX>::operator!=(const AVX512BitMask &rhs) const
     //-------------------------------------------------------------------------
     {
-      int count = get_count();
-      if (count == 0)
-        return -1;
-      if (count == SPARSE_CNT)
-        return (*(get_sparse()->begin()));
-      if (count == DENSE_CNT)
-        return get_dense()->find_first_set();
-      return get_value<OVERLAP>(0);
+      return !(*this == rhs);
     }
 
     //-------------------------------------------------------------------------
-    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline int CompoundBitMask<BITMASK,MAX,WORDS>::find_index_set(
-                                                               int index) const
+    template<unsigned int MAX>
+    inline AVX512BitMask<MAX>& AVX512BitMask<MAX>::operator=(
+                                                      const AVX512BitMask &rhs)
     //-------------------------------------------------------------------------
     {
-      int count = get_count();
-      if (count == DENSE_CNT)
-        return get_dense()->find_index_set(index);
-      if (count == SPARSE_CNT)
+      for (unsigned idx = 0; idx < AVX512_ELMTS; idx++)
       {
-        SparseSet *sparse = get_sparse();
-        if (index >= sparse->size())
-          return -1;
-        SparseSet::const_iterator it = sparse->begin();
-        while (index > 0)
-        {
-          index--;
-          it++;
-        }
-        return (*it);
+        bits.avx512_vector[idx] = rhs(idx);
       }
-      if (index >= count)
-        return -1;
-      return get_value<OVERLAP>(index);
+      return *this;
     }
-    
+
     //-------------------------------------------------------------------------
-    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline void CompoundBitMask<BITMASK,MAX,WORDS>::clear(void)
+    template<unsigned int MAX>
+    inline AVX512BitMask<MAX> AVX512BitMask<MAX>::operator~(void) const
     //-------------------------------------------------------------------------
     {
-      int count = get_count();
-      if (count == SPARSE_CNT)
-        delete get_sparse();
-      if (count == DENSE_CNT)
-        delete get_dense();
-      set_count(0);
+      AVX512BitMask<MAX> result;
+      for (unsigned idx = 0; idx < BIT_ELMTS; idx++)
+      {
+        result[idx] = ~(bits.bit_vector[idx]);
+      }
+      return result;
     }
 
     //-------------------------------------------------------------------------
-    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline bool CompoundBitMask<BITMASK,MAX,WORDS>::operator==(
-                                              const CompoundBitMask &rhs) const
+    template<unsigned int MAX>
+    inline AVX512BitMask<MAX> AVX512BitMask<MAX>::operator|(
+                                                const AVX512BitMask &rhs) const
     //-------------------------------------------------------------------------
     {
-      int count = get_count();
-      int rhs_count = rhs.get_count();
-      if (count != rhs_count)
-        return false;
-      // If they are dense see if they are equal
-      if (count == DENSE_CNT)
-        return (*get_dense() == *rhs.get_dense());
-      if (count == SPARSE_CNT)
-        return (*get_sparse() == *rhs.get_sparse());
-      // See if there are all matching bits
-      for (int idx = 0; idx < count; idx++)
-        if (!rhs.is_set(get_value<OVERLAP>(idx)))
-          return false;
-      return true;
+      AVX512BitMask<MAX> result;
+      // If we have this instruction use it because it has higher throughput
+      for (unsigned idx = 0; idx < AVX512_ELMTS; idx++)
+      {
+        result(idx) = _mm512_or_si512(bits.avx512_vector[idx], rhs(idx));
+      }
+      return result;
     }
 
     //-------------------------------------------------------------------------
-    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline bool CompoundBitMask<BITMASK,MAX,WORDS>::operator<(
-                                              const CompoundBitMask &rhs) const
+    template<unsigned int MAX>
+    inline AVX512BitMask<MAX> AVX512BitMask<MAX>::operator&(
+                                                const AVX512BitMask &rhs) const
     //-------------------------------------------------------------------------
     {
-      int count = get_count();
-      int rhs_count = rhs.get_count();
-      if (count < rhs_count)
-        return true;
-      else if (count > rhs_count)
-        return false;
-      // Otherwise they are equal in size, see if they are actually equal
-      if (count == DENSE_CNT)
-        return (*get_dense() < *rhs.get_dense());
-      if (count == SPARSE_CNT)
-        return (*get_sparse() < *rhs.get_sparse());
-      // Now we just have indexes, nothing good to do here, we
-      // need to sort them so put them in stl sets and compare them
-      std::set<int> local_set, rhs_set;
-      for (int idx = 0; idx < count; idx++)
-        local_set.insert(get_value<OVERLAP>(idx));
-      for (int idx = 0; idx < rhs_count; idx++)
-        rhs_set.insert(rhs.get_value<OVERLAP>(idx));
-      return (local_set < rhs_set);
+      AVX512BitMask<MAX> result;
+      for (unsigned idx = 0; idx < AVX512_ELMTS; idx++)
+      {
+        result(idx) = _mm512_and_si512(bits.avx512_vector[idx], rhs(idx));
+      }
+      return result;
     }
 
     //-------------------------------------------------------------------------
-    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline bool CompoundBitMask<BITMASK,MAX,WORDS>::operator!=(
-                                              const CompoundBitMask &rhs) const
+    template<unsigned int MAX>
+    inline AVX512BitMask<MAX> AVX512BitMask<MAX>::operator^(
+                                                const AVX512BitMask &rhs) const
     //-------------------------------------------------------------------------
     {
-      return !(*this == rhs);
+      AVX512BitMask<MAX> result;
+      for (unsigned idx = 0; idx < AVX512_ELMTS; idx++)
+      {
+        result(idx) = _mm512_xor_si512(bits.avx512_vector[idx], rhs(idx));
+      }
+      return result;
     }
 
     //-------------------------------------------------------------------------
-    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline CompoundBitMask<BITMASK,MAX,WORDS>& 
-      CompoundBitMask<BITMASK,MAX,WORDS>::operator=(const CompoundBitMask &rhs)
+    template<unsigned int MAX>
+    inline AVX512BitMask<MAX>& AVX512BitMask<MAX>::operator|=(
+                                                      const AVX512BitMask &rhs)
     //-------------------------------------------------------------------------
     {
-      int count = get_count();
-      int rhs_count = rhs.get_count();
-      if (count != rhs_count)
+      for (unsigned idx = 0; idx < AVX512_ELMTS; idx++)
       {
-        if (count == DENSE_CNT)
-        {
-          // Free our dense count and copy over bits
-          delete get_dense();
-          if (rhs_count == SPARSE_CNT)
-          {
-            set_count(SPARSE_CNT);
-            set_sparse(new SparseSet(*rhs.get_sparse()));
-          }
-          else
-          {
-            for (int idx = 0; idx < WORDS; idx++)
-              bits[idx] = rhs.bits[idx];
-          }
-        }
-        else if (count == SPARSE_CNT)
-        {
-          // Free our set
-          delete get_sparse();
-          if (rhs_count == DENSE_CNT)
-          {
-            // If the rhs is dense copy it over
-            set_count(DENSE_CNT);
-            set_dense(new BITMASK(*rhs.get_dense()));
-          }
-          else
-          {
-            // Otherwise it is just bit, so copy it over
-            for (int idx = 0; idx < WORDS; idx++)
-              bits[idx] = rhs.bits[idx];
-          }
-        }
-        else
-        {
-          // We are just bits, see if we need to copy over a set or a mask
-          if (rhs_count == SPARSE_CNT)
-          {
-            set_count(SPARSE_CNT);
-            set_sparse(new SparseSet(*rhs.get_sparse()));
-          }
-          else if (rhs_count == DENSE_CNT)
-          {
-            set_count(DENSE_CNT);
-            set_dense(new BITMASK(*rhs.get_dense()));
-          }
-          else
-          {
-            for (int idx = 0; idx < WORDS; idx++)
-              bits[idx] = rhs.bits[idx];
-          }
-        }
+        bits.avx512_vector[idx] = _mm512_or_si512(bits.avx512_vector[idx],
+                                                  rhs(idx));
       }
-      else
+      return *this;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline AVX512BitMask<MAX>& AVX512BitMask<MAX>::operator&=(
+                                                      const AVX512BitMask &rhs)
+    //-------------------------------------------------------------------------
+    {
+      for (unsigned idx = 0; idx < AVX512_ELMTS; idx++)
       {
-        if (count == DENSE_CNT)
-        {
-          // both dense, just copy over dense masks
-          *get_dense() = *rhs.get_dense();
-        }
-        else if (count == SPARSE_CNT)
-        {
-          *get_sparse() = *rhs.get_sparse();
-        }
-        else
-        {
-          // both not dense, copy over bits
-          for (int idx = 0; idx < WORDS; idx++)
-            bits[idx] = rhs.bits[idx];
-        }
+        bits.avx512_vector[idx] = _mm512_and_si512(bits.avx512_vector[idx],
+                                                   rhs(idx));
       }
       return *this;
     }
 
     //-------------------------------------------------------------------------
-    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline CompoundBitMask<BITMASK,MAX,WORDS> 
-                      CompoundBitMask<BITMASK,MAX,WORDS>::operator~(void) const
+    template<unsigned int MAX>
+    inline AVX512BitMask<MAX>& AVX512BitMask<MAX>::operator^=(
+                                                      const AVX512BitMask &rhs)
     //-------------------------------------------------------------------------
     {
-      CompoundBitMask<BITMASK,MAX,WORDS> result;
-      int count = get_count();
-      if (count == DENSE_CNT)
+      for (unsigned idx = 0; idx < AVX512_ELMTS; idx++)
       {
-        BITMASK next = ~(*get_dense());
-        if (!!next)
-        {
-          result.set_count(DENSE_CNT);
-          result.set_dense(new BITMASK(next));
-        }
+        bits.avx512_vector[idx] = _mm512_xor_si512(bits.avx512_vector[idx],
+                                                   rhs(idx));
       }
-      else if (count == SPARSE_CNT)
+      return *this;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline bool AVX512BitMask<MAX>::operator*(
+                                                const AVX512BitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      // Test 512 bits at a time for any common bits
+      for (unsigned idx = 0; idx < AVX512_ELMTS; idx++)
       {
-        BITMASK *dense = new BITMASK(0xFFFFFFFFFFFFFFFF);
-        SparseSet *sparse = get_sparse();
-        for (SparseSet::const_iterator it = sparse->begin();
-              it != sparse->end(); it++)
-          dense->unset_bit(*it);
-        result.set_count(DENSE_CNT);
-        result.set_dense(dense);
+        if (_mm512_test_epi64_mask(bits.avx512_vector[idx], rhs(idx)))
+          return false;
       }
-      else
+      return true;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline AVX512BitMask<MAX> AVX512BitMask<MAX>::operator-(
+                                                const AVX512BitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      AVX512BitMask<MAX> result;
+      for (unsigned idx = 0; idx < AVX512_ELMTS; idx++)
       {
-        BITMASK *dense = new BITMASK(0xFFFFFFFFFFFFFFFF); 
-        for (int idx = 0; idx < count; idx++)
-          dense->unset_bit(get_value<OVERLAP>(idx));
-        result.set_count(DENSE_CNT);
-        result.set_dense(dense);
+        result(idx) = _mm512_andnot_si512(rhs(idx), bits.avx512_vector[idx]);
       }
       return result;
     }
 
     //-------------------------------------------------------------------------
-    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline CompoundBitMask<BITMASK,MAX,WORDS> 
-      CompoundBitMask<BITMASK,MAX,WORDS>::operator|(
-                                              const CompoundBitMask &rhs) const
+    template<unsigned int MAX>
+    inline AVX512BitMask<MAX>& AVX512BitMask<MAX>::operator-=(
+                                                      const AVX512BitMask &rhs)
     //-------------------------------------------------------------------------
     {
-      CompoundBitMask<BITMASK,MAX,WORDS> result;
-      int count = get_count();
-      int rhs_count = rhs.get_count();
-      if (count == DENSE_CNT)
+      for (unsigned idx = 0; idx < AVX512_ELMTS; idx++)
       {
-        if (rhs_count == DENSE_CNT)
-        {
-          BITMASK *next = new BITMASK((*get_dense()) | (*rhs.get_dense()));
-          result.set_count(DENSE_CNT);
-          result.set_dense(next);
-        }
-        else if (rhs_count == SPARSE_CNT)
-        {
-          BITMASK *next = new BITMASK(*get_dense());
-          SparseSet *other = rhs.get_sparse();
-          for (SparseSet::const_iterator it = other->begin();
-                it != other->end(); it++)
-            next->set_bit(*it);
-          result.set_count(DENSE_CNT);
-          result.set_dense(next);
-        }
-        else
-        {
-          BITMASK *next = new BITMASK(*get_dense());
-          for (int idx = 0; idx < rhs_count; idx++)
-            next->set_bit(rhs.get_value<OVERLAP>(idx));
-          result.set_count(DENSE_CNT);
-          result.set_dense(next);
-        }
+        bits.avx512_vector[idx] = _mm512_andnot_si512(rhs(idx), 
+                                                   bits.avx512_vector[idx]);
       }
-      else if (rhs_count == DENSE_CNT)
+      return *this;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline bool AVX512BitMask<MAX>::operator!(void) const
+    //-------------------------------------------------------------------------
+    {
+      for (unsigned idx = 0; idx < AVX512_ELMTS; idx++)
       {
-        BITMASK *next = new BITMASK(*rhs.get_dense());
-        if (count == SPARSE_CNT)
-        {
-          SparseSet *other = get_sparse();
-          for (SparseSet::const_iterator it = other->begin();
-                it != other->end(); it++)
-            next->set_bit(*it);
-        }
-        else
+        if (_mm512_test_epi64_mask(bits.avx512_vector[idx], 
+                                   bits.avx512_vector[idx]))
+          return false;
+      }
+      return true;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline AVX512BitMask<MAX> AVX512BitMask<MAX>::operator<<(
+                                                          unsigned shift) const
+    //-------------------------------------------------------------------------
+    {
+      // Find the range
+      unsigned range = shift >> 6;
+      unsigned local = shift & 0x3F;
+      AVX512BitMask<MAX> result;
+      if (!local)
+      {
+        // Fast case where we just have to move the individual words
+        for (int idx = (BIT_ELMTS-1); idx >= int(range); idx--)
         {
-          for (int idx = 0; idx < count; idx++)
-            next->set_bit(get_value<OVERLAP>(idx));
+          result[idx] = bits.bit_vector[idx-range]; 
         }
-        result.set_count(DENSE_CNT);
-        result.set_dense(next);
+        // fill in everything else with zeros
+        for (unsigned idx = 0; idx < range; idx++)
+          result[idx] = 0;
       }
-      else if (count == SPARSE_CNT)
+      else
+      {
+        // Slow case with merging words
+        for (int idx = (BIT_ELMTS-1); idx > int(range); idx--)
+        {
+          uint64_t left = bits.bit_vector[idx-range] << local;
+          uint64_t right = bits.bit_vector[idx-(range+1)] >> ((1 << 6) - local);
+          result[idx] = left | right;
+        }
+        // Handle the last case
+        result[range] = bits.bit_vector[0] << local; 
+        // Fill in everything else with zeros
+        for (unsigned idx = 0; idx < range; idx++)
+          result[idx] = 0;
+      }
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline AVX512BitMask<MAX> AVX512BitMask<MAX>::operator>>(
+                                                          unsigned shift) const
+    //-------------------------------------------------------------------------
+    {
+      unsigned range = shift >> 6;
+      unsigned local = shift & 0x3F;
+      AVX512BitMask<MAX> result;
+      if (!local)
+      {
+        // Fast case where we just have to move individual words
+        for (unsigned idx = 0; idx < (BIT_ELMTS-range); idx++)
+        {
+          result[idx] = bits.bit_vector[idx+range];
+        }
+        // Fill in everything else with zeros
+        for (unsigned idx = (BIT_ELMTS-range); idx < (BIT_ELMTS); idx++)
+          result[idx] = 0;
+      }
+      else
+      {
+        // Slow case with merging words
+        for (unsigned idx = 0; idx < (BIT_ELMTS-(range+1)); idx++)
+        {
+          uint64_t right = bits.bit_vector[idx+range] >> local;
+          uint64_t left = bits.bit_vector[idx+range+1] << ((1 << 6) - local);
+          result[idx] = left | right;
+        }
+        // Handle the last case
+        result[BIT_ELMTS-(range+1)] = bits.bit_vector[BIT_ELMTS-1] >> local;
+        // Fill in everything else with zeros
+        for (unsigned idx = (BIT_ELMTS-range); idx < BIT_ELMTS; idx++)
+          result[idx] = 0;
+      }
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline AVX512BitMask<MAX>& AVX512BitMask<MAX>::operator<<=(unsigned shift)
+    //-------------------------------------------------------------------------
+    {
+      // Find the range
+      unsigned range = shift >> 6;
+      unsigned local = shift & 0x3F;
+      if (!local)
+      {
+        // Fast case where we just have to move the individual words
+        for (int idx = (BIT_ELMTS-1); idx >= int(range); idx--)
+        {
+          bits.bit_vector[idx] = bits.bit_vector[idx-range]; 
+        }
+        // fill in everything else with zeros
+        for (unsigned idx = 0; idx < range; idx++)
+          bits.bit_vector[idx] = 0;
+      }
+      else
+      {
+        // Slow case with merging words
+        for (int idx = (BIT_ELMTS-1); idx > int(range); idx--)
+        {
+          uint64_t left = bits.bit_vector[idx-range] << local;
+          uint64_t right = bits.bit_vector[idx-(range+1)] >> ((1 << 6) - local);
+          bits.bit_vector[idx] = left | right;
+        }
+        // Handle the last case
+        bits.bit_vector[range] = bits.bit_vector[0] << local; 
+        // Fill in everything else with zeros
+        for (unsigned idx = 0; idx < range; idx++)
+          bits.bit_vector[idx] = 0;
+      }
+      return *this;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline AVX512BitMask<MAX>& AVX512BitMask<MAX>::operator>>=(unsigned shift)
+    //-------------------------------------------------------------------------
+    {
+      unsigned range = shift >> 6;
+      unsigned local = shift & 0x3F;
+      if (!local)
+      {
+        // Fast case where we just have to move individual words
+        for (unsigned idx = 0; idx < (BIT_ELMTS-range); idx++)
+        {
+          bits.bit_vector[idx] = bits.bit_vector[idx+range];
+        }
+        // Fill in everything else with zeros
+        for (unsigned idx = (BIT_ELMTS-range); idx < (BIT_ELMTS); idx++)
+          bits.bit_vector[idx] = 0;
+      }
+      else
+      {
+        // Slow case with merging words
+        uint64_t carry_mask = 0;
+        for (unsigned idx = 0; idx < local; idx++)
+          carry_mask |= (1 << idx);
+        for (unsigned idx = 0; idx < (BIT_ELMTS-(range+1)); idx++)
+        {
+          uint64_t right = bits.bit_vector[idx+range] >> local;
+          uint64_t left = bits.bit_vector[idx+range+1] << ((1 << 6) - local);
+          bits.bit_vector[idx] = left | right;
+        }
+        // Handle the last case
+        bits.bit_vector[BIT_ELMTS-(range+1)] = 
+                                      bits.bit_vector[BIT_ELMTS-1] >> local;
+        // Fill in everything else with zeros
+        for (unsigned idx = (BIT_ELMTS-range); idx < BIT_ELMTS; idx++)
+          bits.bit_vector[idx] = 0;
+      }
+      return *this;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline uint64_t AVX512BitMask<MAX>::get_hash_key(void) const
+    //-------------------------------------------------------------------------
+    {
+      uint64_t result = 0;
+      for (unsigned idx = 0; idx < BIT_ELMTS; idx++)
+      {
+        result |= bits.bit_vector[idx];
+      }
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline const uint64_t* AVX512BitMask<MAX>::base(void) const
+    //-------------------------------------------------------------------------
+    {
+      return bits.bit_vector;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline void AVX512BitMask<MAX>::serialize(Serializer &rez) const
+    //-------------------------------------------------------------------------
+    {
+      rez.serialize(bits.bit_vector, (MAX/8));
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline void AVX512BitMask<MAX>::deserialize(Deserializer &derez)
+    //-------------------------------------------------------------------------
+    {
+      derez.deserialize(bits.bit_vector, (MAX/8));
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline char* AVX512BitMask<MAX>::to_string(void) const
+    //-------------------------------------------------------------------------
+    {
+      return BitMaskHelper::to_string(bits.bit_vector, MAX);
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    /*static*/ inline int AVX512BitMask<MAX>::pop_count(
+                                                const AVX512BitMask<MAX> &mask)
+    //-------------------------------------------------------------------------
+    {
+      int result = 0;
+#ifndef VALGRIND
+#ifdef __AVX512VPOPCNTDQ__
+      // Count all the words of a vector at once
+      __m512i counts = _mm512_setzero_si512();
+      for (unsigned idx = 0; idx < AVX512_ELMTS; idx++)
+        counts = _mm512_add_epi64(counts, _mm512_popcnt_epi64(mask(idx)));
+      result = _mm512_reduce_add_epi64(counts);
+#else
+      for (unsigned idx = 0; idx < BIT_ELMTS; idx++)
+      {
+        result += __builtin_popcountl(mask[idx]);
+      }
+#endif
+#else
+      for (unsigned idx = 0; idx < MAX; idx++)
+      {
+        if (mask.is_set(idx))
+          result++;
+      }
+#endif
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    AVX512TLBitMask<MAX>::AVX512TLBitMask(uint64_t init /*= 0*/)
+      : sum_mask(init)
+    //-------------------------------------------------------------------------
+    {
+      LEGION_STATIC_ASSERT((MAX % 512) == 0);
+      for (unsigned idx = 0; idx < BIT_ELMTS; idx++)
+      {
+        bits.bit_vector[idx] = init;
+      }
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    AVX512TLBitMask<MAX>::AVX512TLBitMask(const AVX512TLBitMask &rhs)
+      : sum_mask(rhs.sum_mask)
+    //-------------------------------------------------------------------------
+    {
+      LEGION_STATIC_ASSERT((MAX % 512) == 0);
+      for (unsigned idx = 0; idx < AVX512_ELMTS; idx++)
+      {
+        bits.avx512_vector[idx] = rhs(idx);
+      }
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    AVX512TLBitMask<MAX>::~AVX512TLBitMask(void)
+    //-------------------------------------------------------------------------
+    {
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline void AVX512TLBitMask<MAX>::set_bit(unsigned bit)
+    //-------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(bit < MAX);
+#endif
+      unsigned idx = bit >> 6;
+      const uint64_t set_mask = (1UL << (bit & 0x3F));
+      bits.bit_vector[idx] |= set_mask;
+      sum_mask |= set_mask;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline void AVX512TLBitMask<MAX>::unset_bit(unsigned bit)
+    //-------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(bit < MAX);
+#endif
+      unsigned idx = bit >> 6;
+      const uint64_t set_mask = (1UL << (bit & 0x3F));
+      const uint64_t unset_mask = ~set_mask;
+      bits.bit_vector[idx] &= unset_mask;
+      // Unset the summary mask and then reset if necessary
+      sum_mask &= unset_mask;
+      for (unsigned i = 0; i < BIT_ELMTS; i++)
+        sum_mask |= bits.bit_vector[i];
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline void AVX512TLBitMask<MAX>::assign_bit(unsigned bit, bool val)
+    //-------------------------------------------------------------------------
+    {
+      if (val)
+        set_bit(bit);
+      else
+        unset_bit(bit);
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline bool AVX512TLBitMask<MAX>::is_set(unsigned bit) const
+    //-------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(bit < MAX);
+#endif
+      unsigned idx = bit >> 6;
+      return (bits.bit_vector[idx] & (1UL << (bit & 0x3F)));
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline int AVX512TLBitMask<MAX>::find_first_set(void) const
+    //-------------------------------------------------------------------------
+    {
+      for (unsigned idx = 0; idx < BIT_ELMTS; idx++)
+      {
+        if (bits.bit_vector[idx])
+        {
+          for (unsigned j = 0; j < ELEMENT_SIZE; j++)
+          {
+            if (bits.bit_vector[idx] & (1UL << j))
+            {
+              return (idx*ELEMENT_SIZE+ j);
+            }
+          }
+        }
+      }
+      return -1;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline int AVX512TLBitMask<MAX>::find_index_set(int index) const
+    //-------------------------------------------------------------------------
+    {
+      int offset = 0;
+      for (unsigned idx = 0; idx < BIT_ELMTS; idx++)
+      {
+        int local = __builtin_popcount(bits.bit_vector[idx]);
+        if (index <= local)
+        {
+          for (unsigned j = 0; j < ELEMENT_SIZE; j++)
+          {
+            if (bits.bit_vector[idx] & (1ULL << j))
+            {
+              if (index == 0)
+                return (offset + j);
+              index--;
+            }
+          }
+        }
+        index -= local;
+        offset += ELEMENT_SIZE;
+      }
+      return -1;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline int AVX512TLBitMask<MAX>::find_next_set(int start) const
+    //-------------------------------------------------------------------------
+    {
+      if (start < 0)
+        start = 0;
+      int idx = start / ELEMENT_SIZE; // truncate
+      int offset = idx * ELEMENT_SIZE; 
+      int j = start % ELEMENT_SIZE;
+      if (j > 0) // if we are already in the middle of element search it
+      {
+        for ( ; j < int(ELEMENT_SIZE); j++)
+        {
+          if (bits.bit_vector[idx] & (1ULL << j))
+            return (offset + j);
+        }
+        idx++;
+        offset += ELEMENT_SIZE;
+      }
+      for ( ; idx < int(BIT_ELMTS); idx++)
+      {
+        if (bits.bit_vector[idx] > 0) // if it has any valid entries, find next
+        {
+          for (j = 0; j < int(ELEMENT_SIZE); j++)
+          {
+            if (bits.bit_vector[idx] & (1ULL << j))
+              return (offset + j);
+          }
+        }
+        offset += ELEMENT_SIZE;
+      }
+      return -1;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline void AVX512TLBitMask<MAX>::clear(void)
+    //-------------------------------------------------------------------------
+    {
+      for (unsigned idx = 0; idx < AVX512_ELMTS; idx++)
+      {
+        bits.avx512_vector[idx] = _mm512_setzero_si512();
+      }
+      sum_mask = 0;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline const __m512i& AVX512TLBitMask<MAX>::operator()(
+                                                 const unsigned int &idx) const
+    //-------------------------------------------------------------------------
+    {
+      return bits.avx512_vector[idx];
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline __m512i& AVX512TLBitMask<MAX>::operator()(const unsigned int &idx)
+    //-------------------------------------------------------------------------
+    {
+      return bits.avx512_vector[idx];
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline const uint64_t& AVX512TLBitMask<MAX>::operator[](
+                                                 const unsigned int &idx) const
+    //-------------------------------------------------------------------------
+    {
+      return bits.bit_vector[idx];
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline uint64_t& AVX512TLBitMask<MAX>::operator[](const unsigned int &idx) 
+    //-------------------------------------------------------------------------
+    {
+      return bits.bit_vector[idx]; 
+    }
+
+
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline bool AVX512TLBitMask<MAX>::operator==(
+                                              const AVX512TLBitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      if (sum_mask != rhs.sum_mask)
+        return false;
+      for (unsigned idx = 0; idx < AVX512_ELMTS; idx++)
+      {
+        if (_mm512_cmpneq_epi64_mask(bits.avx512_vector[idx], rhs(idx)))
+          return false;
+      }
+      return true;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline bool AVX512TLBitMask<MAX>::operator<(
+                                              const AVX512TLBitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      // Only be less than if the bits are a subset of the rhs bits
+      for (unsigned idx = 0; idx < BIT_ELMTS; idx++)
+      {
+        if (bits.bit_vector[idx] < rhs[idx])
+          return true;
+        else if (bits.bit_vector[idx] > rhs[idx])
+          return false;
+      }
+      // Otherwise they are equal so false
+      return false;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline bool AVX512TLBitMask<MAX>::operator!=(
+                                              const AVX512TLBitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      return !(*this == rhs);
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline AVX512TLBitMask<MAX>& AVX512TLBitMask<MAX>::operator=(
+                                                    const AVX512TLBitMask &rhs)
+    //-------------------------------------------------------------------------
+    {
+      sum_mask = rhs.sum_mask;
+      for (unsigned idx = 0; idx < AVX512_ELMTS; idx++)
+      {
+        bits.avx512_vector[idx] = rhs(idx);
+      }
+      return *this;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline AVX512TLBitMask<MAX> AVX512TLBitMask<MAX>::operator~(void) const
+    //-------------------------------------------------------------------------
+    {
+      AVX512TLBitMask<MAX> result;
+      for (unsigned idx = 0; idx < BIT_ELMTS; idx++)
+      {
+        result[idx] = ~(bits.bit_vector[idx]);
+        result.sum_mask |= result[idx];
+      }
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline AVX512TLBitMask<MAX> AVX512TLBitMask<MAX>::operator|(
+                                              const AVX512TLBitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      AVX512TLBitMask<MAX> result;
+      result.sum_mask = sum_mask | rhs.sum_mask;
+      for (unsigned idx = 0; idx < AVX512_ELMTS; idx++)
+      {
+        result(idx) = _mm512_or_si512(bits.avx512_vector[idx], rhs(idx));
+      }
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline AVX512TLBitMask<MAX> AVX512TLBitMask<MAX>::operator&(
+                                              const AVX512TLBitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      AVX512TLBitMask<MAX> result;
+      // If they are independent then we are done
+      if (sum_mask & rhs.sum_mask)
+      {
+        __m512i temp_sum = _mm512_setzero_si512();
+        for (unsigned idx = 0; idx < AVX512_ELMTS; idx++)
+        {
+          result(idx) = _mm512_and_si512(bits.avx512_vector[idx], rhs(idx));
+          temp_sum = _mm512_or_si512(temp_sum, result(idx));
+        }
+        result.sum_mask = extract_mask(temp_sum); 
+      }
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline AVX512TLBitMask<MAX> AVX512TLBitMask<MAX>::operator^(
+                                              const AVX512TLBitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      AVX512TLBitMask<MAX> result;
+      __m512i temp_sum = _mm512_setzero_si512();
+      for (unsigned idx = 0; idx < AVX512_ELMTS; idx++)
+      {
+        result(idx) = _mm512_xor_si512(bits.avx512_vector[idx], rhs(idx));
+        temp_sum = _mm512_or_si512(temp_sum, result(idx));
+      }
+      result.sum_mask = extract_mask(temp_sum);
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline AVX512TLBitMask<MAX>& AVX512TLBitMask<MAX>::operator|=(
+                                                    const AVX512TLBitMask &rhs)
+    //-------------------------------------------------------------------------
+    {
+      sum_mask |= rhs.sum_mask;
+      for (unsigned idx = 0; idx < AVX512_ELMTS; idx++)
+      {
+        bits.avx512_vector[idx] = _mm512_or_si512(bits.avx512_vector[idx],
+                                                  rhs(idx));
+      }
+      return *this;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline AVX512TLBitMask<MAX>& AVX512TLBitMask<MAX>::operator&=(
+                                                    const AVX512TLBitMask &rhs)
+    //-------------------------------------------------------------------------
+    {
+      if (sum_mask & rhs.sum_mask)
+      {
+        __m512i temp_sum = _mm512_setzero_si512();
+        for (unsigned idx = 0; idx < AVX512_ELMTS; idx++)
+        {
+          bits.avx512_vector[idx] = _mm512_and_si512(bits.avx512_vector[idx], 
+                                                  rhs(idx));
+          temp_sum = _mm512_or_si512(temp_sum, bits.avx512_vector[idx]);
+        }
+        sum_mask = extract_mask(temp_sum); 
+      }
+      else
+      {
+        sum_mask = 0;
+        for (unsigned idx = 0; idx < AVX512_ELMTS; idx++)
+          bits.avx512_vector[idx] = _mm512_setzero_si512();
+      }
+      return *this;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline AVX512TLBitMask<MAX>& AVX512TLBitMask<MAX>::operator^=(
+                                                    const AVX512TLBitMask &rhs)
+    //-------------------------------------------------------------------------
+    {
+      __m512i temp_sum = _mm512_setzero_si512();
+      for (unsigned idx = 0; idx < AVX512_ELMTS; idx++)
+      {
+        bits.avx512_vector[idx] = _mm512_xor_si512(bits.avx512_vector[idx],
+                                                   rhs(idx));
+        temp_sum = _mm512_or_si512(temp_sum, bits.avx512_vector[idx]);
+      }
+      sum_mask = extract_mask(temp_sum);
+      return *this;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline bool AVX512TLBitMask<MAX>::operator*(
+                                              const AVX512TLBitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      if (sum_mask & rhs.sum_mask)
+      {
+        // Test 512 bits at a time for any common bits
+        for (unsigned idx = 0; idx < AVX512_ELMTS; idx++)
+        {
+          if (_mm512_test_epi64_mask(bits.avx512_vector[idx], rhs(idx)))
+            return false;
+        }
+      }
+      return true;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline AVX512TLBitMask<MAX> AVX512TLBitMask<MAX>::operator-(
+                                              const AVX512TLBitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      AVX512TLBitMask<MAX> result;
+      __m512i temp_sum = _mm512_setzero_si512();
+      for (unsigned idx = 0; idx < AVX512_ELMTS; idx++)
+      {
+        result(idx) = _mm512_andnot_si512(rhs(idx), bits.avx512_vector[idx]);
+        temp_sum = _mm512_or_si512(temp_sum, result(idx));
+      }
+      result.sum_mask = extract_mask(temp_sum);
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline AVX512TLBitMask<MAX>& AVX512TLBitMask<MAX>::operator-=(
+                                                    const AVX512TLBitMask &rhs)
+    //-------------------------------------------------------------------------
+    {
+      __m512i temp_sum = _mm512_setzero_si512();
+      for (unsigned idx = 0; idx < AVX512_ELMTS; idx++)
+      {
+        bits.avx512_vector[idx] = _mm512_andnot_si512(rhs(idx), 
+                                                   bits.avx512_vector[idx]);
+        temp_sum = _mm512_or_si512(temp_sum, bits.avx512_vector[idx]);
+      }
+      sum_mask = extract_mask(temp_sum);
+      return *this;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline bool AVX512TLBitMask<MAX>::operator!(void) const
+    //-------------------------------------------------------------------------
+    {
+      // A great reason to have a summary mask
+      return (sum_mask == 0);
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline AVX512TLBitMask<MAX> AVX512TLBitMask<MAX>::operator<<(
+                                                          unsigned shift) const
+    //-------------------------------------------------------------------------
+    {
+      // Find the range
+      unsigned range = shift >> 6;
+      unsigned local = shift & 0x3F;
+      AVX512TLBitMask<MAX> result;
+      if (!local)
+      {
+        // Fast case where we just have to move the individual words
+        for (int idx = (BIT_ELMTS-1); idx >= int(range); idx--)
+        {
+          result[idx] = bits.bit_vector[idx-range]; 
+          result.sum_mask |= result[idx];
+        }
+        // fill in everything else with zeros
+        for (unsigned idx = 0; idx < range; idx++)
+          result[idx] = 0;
+      }
+      else
+      {
+        // Slow case with merging words
+        for (int idx = (BIT_ELMTS-1); idx > int(range); idx--)
+        {
+          uint64_t left = bits.bit_vector[idx-range] << local;
+          uint64_t right = bits.bit_vector[idx-(range+1)] >> ((1 << 6) - local);
+          result[idx] = left | right;
+          result.sum_mask |= result[idx];
+        }
+        // Handle the last case
+        result[range] = bits.bit_vector[0] << local; 
+        result.sum_mask |= result[range];
+        // Fill in everything else with zeros
+        for (unsigned idx = 0; idx < range; idx++)
+          result[idx] = 0;
+      }
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline AVX512TLBitMask<MAX> AVX512TLBitMask<MAX>::operator>>(
+                                                          unsigned shift) const
+    //-------------------------------------------------------------------------
+    {
+      unsigned range = shift >> 6;
+      unsigned local = shift & 0x3F;
+      AVX512TLBitMask<MAX> result;
+      if (!local)
+      {
+        // Fast case where we just have to move individual words
+        for (unsigned idx = 0; idx < (BIT_ELMTS-range); idx++)
+        {
+          result[idx] = bits.bit_vector[idx+range];
+          result.sum_mask |= result[idx];
+        }
+        // Fill in everything else with zeros
+        for (unsigned idx = (BIT_ELMTS-range); idx < (BIT_ELMTS); idx++)
+          result[idx] = 0;
+      }
+      else
+      {
+        // Slow case with merging words
+        for (unsigned idx = 0; idx < (BIT_ELMTS-(range+1)); idx++)
+        {
+          uint64_t right = bits.bit_vector[idx+range] >> local;
+          uint64_t left = bits.bit_vector[idx+range+1] << ((1 << 6) - local);
+          result[idx] = left | right;
+          result.sum_mask |= result[idx];
+        }
+        // Handle the last case
+        result[BIT_ELMTS-(range+1)] = bits.bit_vector[BIT_ELMTS-1] >> local;
+        result.sum_mask |= result[BIT_ELMTS-(range+1)];
+        // Fill in everything else with zeros
+        for (unsigned idx = (BIT_ELMTS-range); idx < BIT_ELMTS; idx++)
+          result[idx] = 0;
+      }
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline AVX512TLBitMask<MAX>& AVX512TLBitMask<MAX>::operator<<=(
+                                                                unsigned shift)
+    //-------------------------------------------------------------------------
+    {
+      // Find the range
+      unsigned range = shift >> 6;
+      unsigned local = shift & 0x3F;
+      sum_mask = 0;
+      if (!local)
+      {
+        // Fast case where we just have to move the individual words
+        for (int idx = (BIT_ELMTS-1); idx >= int(range); idx--)
+        {
+          bits.bit_vector[idx] = bits.bit_vector[idx-range]; 
+          sum_mask |= bits.bit_vector[idx];
+        }
+        // fill in everything else with zeros
+        for (unsigned idx = 0; idx < range; idx++)
+          bits.bit_vector[idx] = 0;
+      }
+      else
+      {
+        // Slow case with merging words
+        for (int idx = (BIT_ELMTS-1); idx > int(range); idx--)
+        {
+          uint64_t left = bits.bit_vector[idx-range] << local;
+          uint64_t right = bits.bit_vector[idx-(range+1)] >> ((1 << 6) - local);
+          bits.bit_vector[idx] = left | right;
+          sum_mask |= bits.bit_vector[idx];
+        }
+        // Handle the last case
+        bits.bit_vector[range] = bits.bit_vector[0] << local; 
+        sum_mask |= bits.bit_vector[range];
+        // Fill in everything else with zeros
+        for (unsigned idx = 0; idx < range; idx++)
+          bits.bit_vector[idx] = 0;
+      }
+      return *this;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline AVX512TLBitMask<MAX>& AVX512TLBitMask<MAX>::operator>>=(
+                                                                unsigned shift)
+    //-------------------------------------------------------------------------
+    {
+      unsigned range = shift >> 6;
+      unsigned local = shift & 0x3F;
+      sum_mask = 0;
+      if (!local)
+      {
+        // Fast case where we just have to move individual words
+        for (unsigned idx = 0; idx < (BIT_ELMTS-range); idx++)
+        {
+          bits.bit_vector[idx] = bits.bit_vector[idx+range];
+          sum_mask |= bits.bit_vector[idx];
+        }
+        // Fill in everything else with zeros
+        for (unsigned idx = (BIT_ELMTS-range); idx < (BIT_ELMTS); idx++)
+          bits.bit_vector[idx] = 0;
+      }
+      else
+      {
+        // Slow case with merging words
+        uint64_t carry_mask = 0;
+        for (unsigned idx = 0; idx < local; idx++)
+          carry_mask |= (1 << idx);
+        for (unsigned idx = 0; idx < (BIT_ELMTS-(range+1)); idx++)
+        {
+          uint64_t right = bits.bit_vector[idx+range] >> local;
+          uint64_t left = bits.bit_vector[idx+range+1] << ((1 << 6) - local);
+          bits.bit_vector[idx] = left | right;
+          sum_mask |= bits.bit_vector[idx];
+        }
+        // Handle the last case
+        bits.bit_vector[BIT_ELMTS-(range+1)] = 
+                                        bits.bit_vector[BIT_ELMTS-1] >> local;
+        sum_mask |= bits.bit_vector[BIT_ELMTS-(range+1)];
+        // Fill in everything else with zeros
+        for (unsigned idx = (BIT_ELMTS-range); idx < BIT_ELMTS; idx++)
+          bits.bit_vector[idx] = 0;
+      }
+      return *this;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline uint64_t AVX512TLBitMask<MAX>::get_hash_key(void) const
+    //-------------------------------------------------------------------------
+    {
+      return sum_mask;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline const uint64_t* AVX512TLBitMask<MAX>::base(void) const
+    //-------------------------------------------------------------------------
+    {
+      return bits.bit_vector;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline void AVX512TLBitMask<MAX>::serialize(Serializer &rez) const
+    //-------------------------------------------------------------------------
+    {
+      rez.serialize(sum_mask);
+      rez.serialize(bits.bit_vector, (MAX/8));
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline void AVX512TLBitMask<MAX>::deserialize(Deserializer &derez)
+    //-------------------------------------------------------------------------
+    {
+      derez.deserialize(sum_mask);
+      derez.deserialize(bits.bit_vector, (MAX/8));
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline char* AVX512TLBitMask<MAX>::to_string(void) const
+    //-------------------------------------------------------------------------
+    {
+      return BitMaskHelper::to_string(bits.bit_vector, MAX);
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    /*static*/ inline int AVX512TLBitMask<MAX>::pop_count(
+                                              const AVX512TLBitMask<MAX> &mask)
+    //-------------------------------------------------------------------------
+    {
+      int result = 0;
+#ifndef VALGRIND
+#ifdef __AVX512VPOPCNTDQ__
+      // Count all the words of a vector at once
+      __m512i counts = _mm512_setzero_si512();
+      for (unsigned idx = 0; idx < AVX512_ELMTS; idx++)
+        counts = _mm512_add_epi64(counts, _mm512_popcnt_epi64(mask(idx)));
+      result = _mm512_reduce_add_epi64(counts);
+#else
+      for (unsigned idx = 0; idx < BIT_ELMTS; idx++)
+      {
+        result += __builtin_popcountl(mask[idx]);
+      }
+#endif
+#else
+      for (unsigned idx = 0; idx < MAX; idx++)
+      {
+        if (mask.is_set(idx))
+          result++;
+      }
+#endif
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<unsigned int MAX>
+    /*static*/ inline uint64_t AVX512TLBitMask<MAX>::extract_mask(
+                                                                 __m512i value)
+    //-------------------------------------------------------------------------
+    {
+      return _mm512_reduce_or_epi64(value);
+    }
+#undef BIT_ELMTS
+#undef AVX512_ELMTS
+#endif // __AVX512F__
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
+    CompoundBitMask<BITMASK,MAX,WORDS>::CompoundBitMask(uint64_t init)
+    //-------------------------------------------------------------------------
+    {
+      LEGION_STATIC_ASSERT(WORDS >= 2);
+      LEGION_STATIC_ASSERT(VAL_BITS <= (8*sizeof(uint64_t)));
+      LEGION_STATIC_ASSERT((1 << VAL_BITS) >= MAX);
+      if (init == 0)
+      {
+        set_count(0);
+      }
+      else
+      {
+        set_count(DENSE_CNT);
+        set_dense(new BITMASK(init));
+      }
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
+    CompoundBitMask<BITMASK,MAX,WORDS>::CompoundBitMask(
+                                                    const CompoundBitMask &rhs)
+    //-------------------------------------------------------------------------
+    {
+      int rhs_count = rhs.get_count();
+      if (rhs_count == SPARSE_CNT)
+      {
+        set_count(SPARSE_CNT);
+        set_sparse(new SparseSet(*rhs.get_sparse()));
+      }
+      else if (rhs_count == DENSE_CNT)
+      {
+        set_count(DENSE_CNT); 
+        set_dense(new BITMASK(*rhs.get_dense()));
+      }
+      else
+      {
+        for (unsigned idx = 0; idx < WORDS; idx++)
+          bits[idx] = rhs.bits[idx];
+      }
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
+    CompoundBitMask<BITMASK,MAX,WORDS>::~CompoundBitMask(void) 
+    //-------------------------------------------------------------------------
+    {
+      int count = get_count();
+      if (count == SPARSE_CNT)
+        delete get_sparse();
+      else if (count == DENSE_CNT)
+        delete get_dense();
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
+    inline int CompoundBitMask<BITMASK,MAX,WORDS>::get_count(void) const
+    //-------------------------------------------------------------------------
+    {
+      return (CNT_MASK & bits[0]); 
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
+    inline void CompoundBitMask<BITMASK,MAX,WORDS>::set_count(int size) 
+    //-------------------------------------------------------------------------
+    {
+      bits[0] = (size & CNT_MASK) | (bits[0] & ~CNT_MASK);
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
+    inline typename CompoundBitMask<BITMASK,MAX,WORDS>::SparseSet* 
+                    CompoundBitMask<BITMASK,MAX,WORDS>::get_sparse(void) const
+    //-------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(get_count() == SPARSE_CNT);
+#endif
+      return reinterpret_cast<SparseSet*>(bits[1]);
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
+    inline void CompoundBitMask<BITMASK,MAX,WORDS>::set_sparse(SparseSet *ptr)
+    //-------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(get_count() == SPARSE_CNT);
+#endif
+      bits[1] = reinterpret_cast<uint64_t>(ptr);
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
+    inline BITMASK* CompoundBitMask<BITMASK,MAX,WORDS>::get_dense(void) const
+    //-------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(get_count() == DENSE_CNT);
+#endif
+      return reinterpret_cast<BITMASK*>(bits[1]);
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
+    inline void CompoundBitMask<BITMASK,MAX,WORDS>::set_dense(BITMASK *ptr) 
+    //-------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(get_count() == DENSE_CNT);
+#endif
+      bits[1] = reinterpret_cast<uint64_t>(ptr);
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
+      template<bool CAN_OVERLAP>
+    inline int CompoundBitMask<BITMASK,MAX,WORDS>::get_value(int idx) const
+    //-------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(idx < MAX_CNT);
+#endif
+      int start_bit = CNT_BITS + idx*VAL_BITS;
+      int start_index = start_bit >> WORD_BITS;
+      start_bit &= WORD_MASK;
+      if (CAN_OVERLAP)
+      {
+        // See if we straddle words 
+        if ((start_bit + (VAL_BITS-1)) < WORD_SIZE)
+        {
+#ifdef DEBUG_LEGION
+          assert(start_index < WORDS);
+#endif
+          // Common case, all in one word
+          return (bits[start_index] & (VAL_MASK << start_bit)) >> start_bit;
+        }
+        else
+        {
+#ifdef DEBUG_LEGION
+          assert((start_index+1) < WORDS);
+#endif
+          // Value split across words
+          int first_word_bits = WORD_SIZE - start_bit;
+          // Okay to shit off the end here
+          int result = 
+            int((bits[start_index] & (VAL_MASK << start_bit)) >> start_bit);
+          // Okay to shift off the end here
+          uint64_t next_mask = VAL_MASK >> first_word_bits;
+          result |= int((bits[start_index+1] & next_mask) << first_word_bits);
+          return result;
+        }
+      }
+      else
+      {
+#ifdef DEBUG_LEGION
+        assert(start_index < WORDS);
+#endif
+        return (bits[start_index] & (VAL_MASK << start_bit)) >> start_bit;
+      }
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
+      template<bool CAN_OVERLAP>
+    inline void CompoundBitMask<BITMASK,MAX,WORDS>::set_value(int idx, 
+                                                              int value) 
+    //-------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(idx < MAX_CNT);
+#endif
+      // Cast up the value
+      uint64_t up_value = value;
+      int start_bit = CNT_BITS + idx*VAL_BITS;
+      int start_index = start_bit >> WORD_BITS;
+      start_bit &= WORD_MASK;
+      uint64_t negative_mask = ~(VAL_MASK << start_bit);
+      if (CAN_OVERLAP)
+      {
+        // See if we straddle words
+        if ((start_bit + (VAL_BITS-1)) < WORD_SIZE)
+        {
+#ifdef DEBUG_LEGION
+          assert(start_index < WORDS);
+#endif
+          // Common case, all in one word
+          bits[start_index] = (bits[start_index] & negative_mask) |
+                              (up_value << start_bit);
+        }
+        else
+        {
+#ifdef DEBUG_LEGION
+          assert((start_index+1) < WORDS);
+#endif
+          // Value split across words
+          // Okay to shift off the end here
+          bits[start_index] = (bits[start_index] & negative_mask) |
+                              (up_value << start_bit);
+          int first_word_bits = WORD_SIZE - start_bit;
+          // Okay to shift off the end here
+          uint64_t next_negative = ~(VAL_MASK >> first_word_bits);
+          bits[start_index+1] = (bits[start_index+1] & next_negative) |
+                                (up_value >> first_word_bits);
+        }
+      }
+      else
+      {
+#ifdef DEBUG_LEGION
+        assert(start_index < WORDS);
+#endif
+        bits[start_index] = (bits[start_index] & negative_mask) |
+                            (up_value << start_bit);
+      }
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
+    inline void CompoundBitMask<BITMASK,MAX,WORDS>::set_bit(unsigned bit)
+    //-------------------------------------------------------------------------
+    {
+      int count = get_count();
+      if (count < MAX_CNT)
+      {
+        // Check to make sure it isn't already in our list
+        for (int idx = 0; idx < count; idx++)
+          if (get_value<OVERLAP>(idx) == bit)
+            return;
+        // Add it at the next available location
+        set_value<OVERLAP>(count, bit); 
+        set_count(count+1);
+      }
+      else if (count == MAX_CNT)
+      {
+        // We've maxed out, go to sparse or dense 
+        if (SPARSE_MAX > MAX_CNT)
+        {
+          SparseSet *next = new SparseSet();
+          next->insert(bit);
+          for (int idx = 0; idx < MAX_CNT; idx++)
+            next->insert(get_value<OVERLAP>(idx));
+          set_count(SPARSE_CNT);
+          set_sparse(next);
+        }
+        else
+        {
+          BITMASK *next = new BITMASK();
+          next->set_bit(bit);
+          for (int idx = 0; idx < MAX_CNT; idx++)
+            next->set_bit(get_value<OVERLAP>(idx));
+          set_count(DENSE_CNT);
+          set_dense(next);
+        }
+      }
+      else if (count == SPARSE_CNT)
+      {
+        // sparse case 
+        SparseSet *sparse = get_sparse();
+        if (sparse->size() == SPARSE_MAX)
+        {
+          // upgrade to dense 
+          BITMASK *next = new BITMASK();
+          for (SparseSet::const_iterator it = sparse->begin();
+                it != sparse->end(); it++)
+            next->set_bit(*it);
+          delete sparse;
+          set_count(DENSE_CNT);
+          set_dense(next);
+        }
+        else // otherwise just insert
+          sparse->insert(bit);
+      }
+      else
+      {
+        // Dense case
+        get_dense()->set_bit(bit);
+      }
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
+    inline void CompoundBitMask<BITMASK,MAX,WORDS>::unset_bit(unsigned bit)
+    //-------------------------------------------------------------------------
+    {
+      int count = get_count(); 
+      if (count == 0)
+        return;
+      else if (count == SPARSE_CNT)
+      {
+        SparseSet *sparse = get_sparse();
+        sparse->erase(bit);
+        if (sparse->size() == MAX_CNT)
+        {
+          set_count(MAX_CNT);
+          unsigned idx = 0;
+          for (SparseSet::const_iterator it = sparse->begin();
+                it != sparse->end(); it++, idx++)
+            set_value<OVERLAP>(idx, *it);   
+          delete sparse;
+        }
+      }
+      else if (count == DENSE_CNT)
+      {
+        BITMASK *dense = get_dense();
+        dense->unset_bit(bit);
+        // If dense is empty come back to zero
+        if (!(*dense))
+        {
+          delete dense;
+          set_count(0);
+        }
+      }
+      else
+      {
+        // Iterate through our elements and see if we find it
+        int found_idx = -1;
+        for (int idx = 0; idx < count; idx++)
+        {
+          if (get_value<OVERLAP>(idx) == bit)
+          {
+            found_idx = idx;
+            break;
+          }
+        }
+        if (found_idx >= 0)
+        {
+          // If we found it shift everyone down and decrement the count
+          for (int idx = found_idx; idx < (count-1); idx++)
+          {
+            int next = get_value<OVERLAP>(idx+1);
+            set_value<OVERLAP>(idx, next);
+          }
+          set_count(count-1);
+        }
+      }
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
+    inline void CompoundBitMask<BITMASK,MAX,WORDS>::assign_bit(unsigned bit,  
+                                                               bool val)
+    //-------------------------------------------------------------------------
+    {
+      if (val)
+        set_bit(bit);
+      else
+        unset_bit(bit);
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
+    inline bool CompoundBitMask<BITMASK,MAX,WORDS>::is_set(unsigned bit) const
+    //-------------------------------------------------------------------------
+    {
+      int count = get_count();
+      if (count == 0)
+        return false;
+      else if (count == DENSE_CNT)
+        return get_dense()->is_set(bit);
+      else if (count == SPARSE_CNT)
+      {
+        SparseSet *sparse = get_sparse();
+        return (sparse->find(bit) != sparse->end());
+      }
+      else
+      {
+        // Iterate through our elements and see if we have it
+        for (int idx = 0; idx < count; idx++)
+        {
+          if (get_value<OVERLAP>(idx) == bit)
+            return true;
+        }
+      }
+      return false;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
+    inline int CompoundBitMask<BITMASK,MAX,WORDS>::find_first_set(void) const
+    //-------------------------------------------------------------------------
+    {
+      int count = get_count();
+      if (count == 0)
+        return -1;
+      if (count == SPARSE_CNT)
+        return (*(get_sparse()->begin()));
+      if (count == DENSE_CNT)
+        return get_dense()->find_first_set();
+      return get_value<OVERLAP>(0);
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
+    inline int CompoundBitMask<BITMASK,MAX,WORDS>::find_index_set(
+                                                               int index) const
+    //-------------------------------------------------------------------------
+    {
+      int count = get_count();
+      if (count == DENSE_CNT)
+        return get_dense()->find_index_set(index);
+      if (count == SPARSE_CNT)
+      {
+        SparseSet *sparse = get_sparse();
+        if (index >= sparse->size())
+          return -1;
+        SparseSet::const_iterator it = sparse->begin();
+        while (index > 0)
+        {
+          index--;
+          it++;
+        }
+        return (*it);
+      }
+      if (index >= count)
+        return -1;
+      return get_value<OVERLAP>(index);
+    }
+    
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
+    inline void CompoundBitMask<BITMASK,MAX,WORDS>::clear(void)
+    //-------------------------------------------------------------------------
+    {
+      int count = get_count();
+      if (count == SPARSE_CNT)
+        delete get_sparse();
+      if (count == DENSE_CNT)
+        delete get_dense();
+      set_count(0);
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
+    inline bool CompoundBitMask<BITMASK,MAX,WORDS>::operator==(
+                                              const CompoundBitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      int count = get_count();
+      int rhs_count = rhs.get_count();
+      if (count != rhs_count)
+        return false;
+      // If they are dense see if they are equal
+      if (count == DENSE_CNT)
+        return (*get_dense() == *rhs.get_dense());
+      if (count == SPARSE_CNT)
+        return (*get_sparse() == *rhs.get_sparse());
+      // See if there are all matching bits
+      for (int idx = 0; idx < count; idx++)
+        if (!rhs.is_set(get_value<OVERLAP>(idx)))
+          return false;
+      return true;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
+    inline bool CompoundBitMask<BITMASK,MAX,WORDS>::operator<(
+                                              const CompoundBitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      int count = get_count();
+      int rhs_count = rhs.get_count();
+      if (count < rhs_count)
+        return true;
+      else if (count > rhs_count)
+        return false;
+      // Otherwise they are equal in size, see if they are actually equal
+      if (count == DENSE_CNT)
+        return (*get_dense() < *rhs.get_dense());
+      if (count == SPARSE_CNT)
+        return (*get_sparse() < *rhs.get_sparse());
+      // Now we just have indexes, nothing good to do here, we
+      // need to sort them so put them in stl sets and compare them
+      std::set<int> local_set, rhs_set;
+      for (int idx = 0; idx < count; idx++)
+        local_set.insert(get_value<OVERLAP>(idx));
+      for (int idx = 0; idx < rhs_count; idx++)
+        rhs_set.insert(rhs.get_value<OVERLAP>(idx));
+      return (local_set < rhs_set);
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
+    inline bool CompoundBitMask<BITMASK,MAX,WORDS>::operator!=(
+                                              const CompoundBitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      return !(*this == rhs);
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
+    inline CompoundBitMask<BITMASK,MAX,WORDS>& 
+      CompoundBitMask<BITMASK,MAX,WORDS>::operator=(const CompoundBitMask &rhs)
+    //-------------------------------------------------------------------------
+    {
+      int count = get_count();
+      int rhs_count = rhs.get_count();
+      if (count != rhs_count)
+      {
+        if (count == DENSE_CNT)
+        {
+          // Free our dense count and copy over bits
+          delete get_dense();
+          if (rhs_count == SPARSE_CNT)
+          {
+            set_count(SPARSE_CNT);
+            set_sparse(new SparseSet(*rhs.get_sparse()));
+          }
+          else
+          {
+            for (int idx = 0; idx < WORDS; idx++)
+              bits[idx] = rhs.bits[idx];
+          }
+        }
+        else if (count == SPARSE_CNT)
+        {
+          // Free our set
+          delete get_sparse();
+          if (rhs_count == DENSE_CNT)
+          {
+            // If the rhs is dense copy it over
+            set_count(DENSE_CNT);
+            set_dense(new BITMASK(*rhs.get_dense()));
+          }
+          else
+          {
+            // Otherwise it is just bit, so copy it over
+            for (int idx = 0; idx < WORDS; idx++)
+              bits[idx] = rhs.bits[idx];
+          }
+        }
+        else
+        {
+          // We are just bits, see if we need to copy over a set or a mask
+          if (rhs_count == SPARSE_CNT)
+          {
+            set_count(SPARSE_CNT);
+            set_sparse(new SparseSet(*rhs.get_sparse()));
+          }
+          else if (rhs_count == DENSE_CNT)
+          {
+            set_count(DENSE_CNT);
+            set_dense(new BITMASK(*rhs.get_dense()));
+          }
+          else
+          {
+            for (int idx = 0; idx < WORDS; idx++)
+              bits[idx] = rhs.bits[idx];
+          }
+        }
+      }
+      else
+      {
+        if (count == DENSE_CNT)
+        {
+          // both dense, just copy over dense masks
+          *get_dense() = *rhs.get_dense();
+        }
+        else if (count == SPARSE_CNT)
+        {
+          *get_sparse() = *rhs.get_sparse();
+        }
+        else
+        {
+          // both not dense, copy over bits
+          for (int idx = 0; idx < WORDS; idx++)
+            bits[idx] = rhs.bits[idx];
+        }
+      }
+      return *this;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
+    inline CompoundBitMask<BITMASK,MAX,WORDS> 
+                      CompoundBitMask<BITMASK,MAX,WORDS>::operator~(void) const
+    //-------------------------------------------------------------------------
+    {
+      CompoundBitMask<BITMASK,MAX,WORDS> result;
+      int count = get_count();
+      if (count == DENSE_CNT)
+      {
+        BITMASK next = ~(*get_dense());
+        if (!!next)
+        {
+          result.set_count(DENSE_CNT);
+          result.set_dense(new BITMASK(next));
+        }
+      }
+      else if (count == SPARSE_CNT)
+      {
+        BITMASK *dense = new BITMASK(0xFFFFFFFFFFFFFFFF);
+        SparseSet *sparse = get_sparse();
+        for (SparseSet::const_iterator it = sparse->begin();
+              it != sparse->end(); it++)
+          dense->unset_bit(*it);
+        result.set_count(DENSE_CNT);
+        result.set_dense(dense);
+      }
+      else
+      {
+        BITMASK *dense = new BITMASK(0xFFFFFFFFFFFFFFFF); 
+        for (int idx = 0; idx < count; idx++)
+          dense->unset_bit(get_value<OVERLAP>(idx));
+        result.set_count(DENSE_CNT);
+        result.set_dense(dense);
+      }
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
+    inline CompoundBitMask<BITMASK,MAX,WORDS> 
+      CompoundBitMask<BITMASK,MAX,WORDS>::operator|(
+                                              const CompoundBitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      CompoundBitMask<BITMASK,MAX,WORDS> result;
+      int count = get_count();
+      int rhs_count = rhs.get_count();
+      if (count == DENSE_CNT)
+      {
+        if (rhs_count == DENSE_CNT)
+        {
+          BITMASK *next = new BITMASK((*get_dense()) | (*rhs.get_dense()));
+          result.set_count(DENSE_CNT);
+          result.set_dense(next);
+        }
+        else if (rhs_count == SPARSE_CNT)
+        {
+          BITMASK *next = new BITMASK(*get_dense());
+          SparseSet *other = rhs.get_sparse();
+          for (SparseSet::const_iterator it = other->begin();
+                it != other->end(); it++)
+            next->set_bit(*it);
+          result.set_count(DENSE_CNT);
+          result.set_dense(next);
+        }
+        else
+        {
+          BITMASK *next = new BITMASK(*get_dense());
+          for (int idx = 0; idx < rhs_count; idx++)
+            next->set_bit(rhs.get_value<OVERLAP>(idx));
+          result.set_count(DENSE_CNT);
+          result.set_dense(next);
+        }
+      }
+      else if (rhs_count == DENSE_CNT)
+      {
+        BITMASK *next = new BITMASK(*rhs.get_dense());
+        if (count == SPARSE_CNT)
+        {
+          SparseSet *other = get_sparse();
+          for (SparseSet::const_iterator it = other->begin();
+                it != other->end(); it++)
+            next->set_bit(*it);
+        }
+        else
+        {
+          for (int idx = 0; idx < count; idx++)
+            next->set_bit(get_value<OVERLAP>(idx));
+        }
+        result.set_count(DENSE_CNT);
+        result.set_dense(next);
+      }
+      else if (count == SPARSE_CNT)
+      {
+        SparseSet *next = new SparseSet(*get_sparse());
+        result.set_count(SPARSE_CNT);
+        result.set_sparse(next);
+        if (rhs_count == SPARSE_CNT)
+        {
+          SparseSet *other = rhs.get_sparse();
+          for (SparseSet::const_iterator it = other->begin();
+                it != other->end(); it++)
+            result.set_bit(*it);
+        }
+        else
+        {
+          for (int idx = 0; idx < rhs_count; idx++)
+            result.set_bit(rhs.get_value<OVERLAP>(idx));
+        }
+      }
+      else if (rhs_count == SPARSE_CNT)
+      {
+        SparseSet *next = new SparseSet(*rhs.get_sparse());
+        result.set_count(SPARSE_CNT);
+        result.set_sparse(next);
+        for (int idx = 0; idx < count; idx++)
+          result.set_bit(get_value<OVERLAP>(idx));
+      }
+      else
+      {
+        for (int idx = 0; idx < count; idx++)
+          result.set_bit(get_value<OVERLAP>(idx));
+        for (int idx = 0; idx < rhs_count; idx++)
+          result.set_bit(rhs.get_value<OVERLAP>(idx));
+      }
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
+    inline CompoundBitMask<BITMASK,MAX,WORDS> 
+      CompoundBitMask<BITMASK,MAX,WORDS>::operator&(
+                                              const CompoundBitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      CompoundBitMask<BITMASK,MAX,WORDS> result;
+      int count = get_count();
+      int rhs_count = rhs.get_count();
+      if (count < SPARSE_CNT)
+      {
+        for (int idx = 0; idx < count; idx++) 
+        {
+          int bit = get_value<OVERLAP>(idx);
+          if (rhs.is_set(bit))
+            result.set_bit(bit);
+        }
+      }
+      else if (rhs_count < SPARSE_CNT)
+      {
+        for (int idx = 0; idx < rhs_count; idx++)
+        {
+          int bit = rhs.get_value<OVERLAP>(idx);
+          if (is_set(bit))
+            result.set_bit(bit);
+        }
+      }
+      else if (count == SPARSE_CNT)
+      {
+        SparseSet *sparse = get_sparse();
+        for (SparseSet::const_iterator it = sparse->begin();
+              it != sparse->end(); it++)
+        {
+          if (rhs.is_set(*it))
+            result.set_bit(*it);
+        }
+      }
+      else if (rhs_count == SPARSE_CNT)
+      {
+        SparseSet *sparse = rhs.get_sparse();
+        for (SparseSet::const_iterator it = sparse->begin();
+              it != sparse->end(); it++)
+        {
+          if (is_set(*it))
+            result.set_bit(*it);
+        }
+      }
+      else
+      {
+        // both dense
+        BITMASK next((*get_dense()) & (*rhs.get_dense()));
+        if (!!next)
+        {
+          result.set_count(DENSE_CNT);
+          result.set_dense(new BITMASK(next));
+        }
+      }
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
+    inline CompoundBitMask<BITMASK,MAX,WORDS> 
+      CompoundBitMask<BITMASK,MAX,WORDS>::operator^(
+                                              const CompoundBitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      CompoundBitMask<BITMASK,MAX,WORDS> result;
+      int count = get_count();
+      int rhs_count = rhs.get_count();
+      if (count == DENSE_CNT)
+      {
+        if (rhs_count == DENSE_CNT)
+        {
+          // both dense
+          BITMASK next((*get_dense()) ^ (*rhs.get_dense()));
+          if (!!next)
+          {
+            result.set_count(DENSE_CNT);
+            result.set_dense(new BITMASK(next));
+          }
+        }
+        else if (rhs_count == SPARSE_CNT)
+        {
+          BITMASK next((*get_dense()));
+          SparseSet *sparse = rhs.get_sparse();
+          for (SparseSet::const_iterator it = sparse->begin();
+                it != sparse->end(); it++)
+          {
+            if (!next.is_set(*it))
+              next.set_bit(*it);
+            else
+              next.unset_bit(*it);
+          }
+          if (!!next)
+          {
+            result.set_count(DENSE_CNT);
+            result.set_dense(new BITMASK(next));
+          }
+        }
+        else
+        {
+          BITMASK next((*get_dense()));
+          for (int idx = 0; idx < rhs_count; idx++)
+          {
+            int bit = rhs.get_value<OVERLAP>(idx);
+            if (!next.is_set(bit))
+              next.set_bit(bit);
+            else
+              next.unset_bit(bit);
+          }
+          if (!!next)
+          {
+            result.set_count(DENSE_CNT);
+            result.set_dense(new BITMASK(next));
+          }
+        }
+      }
+      else if (rhs_count == DENSE_CNT)
+      {
+        BITMASK next(*(rhs.get_dense()));
+        if (count == SPARSE_CNT)
+        {
+          SparseSet *sparse = get_sparse();
+          for (SparseSet::const_iterator it = sparse->begin();
+                it != sparse->end(); it++)
+          {
+            if (!next.is_set(*it))
+              next.set_bit(*it);
+            else
+              next.unset_bit(*it);
+          }
+        }
+        else
+        {
+          for (int idx = 0; idx < count; idx++)
+          {
+            int bit = get_value<OVERLAP>(idx);
+            if (!next.is_set(bit))
+              next.set_bit(bit);
+            else
+              next.unset_bit(bit);
+          }
+        }
+        if (!!next)
+        {
+          result.set_count(DENSE_CNT);
+          result.set_dense(new BITMASK(next));
+        }
+      }
+      else if (count == SPARSE_CNT)
       {
         SparseSet *next = new SparseSet(*get_sparse());
-        result.set_count(SPARSE_CNT);
-        result.set_sparse(next);
         if (rhs_count == SPARSE_CNT)
         {
           SparseSet *other = rhs.get_sparse();
           for (SparseSet::const_iterator it = other->begin();
                 it != other->end(); it++)
-            result.set_bit(*it);
+          {
+            SparseSet::iterator finder = next->find(*it);
+            if (finder != next->end())
+              next->erase(finder);
+            else
+              next->insert(*it);
+          }
         }
         else
         {
           for (int idx = 0; idx < rhs_count; idx++)
-            result.set_bit(rhs.get_value<OVERLAP>(idx));
+          {
+            int bit = rhs.get_value<OVERLAP>(idx);
+            SparseSet::iterator finder = next->find(bit);
+            if (finder != next->end())
+              next->erase(finder);
+            else
+              next->insert(bit);
+          }
+        }
+        if (!next->empty())
+        {
+          if (next->size() <= MAX_CNT)
+          {
+            for (SparseSet::const_iterator it = next->begin();
+                  it != next->end(); it++)
+              result.set_bit(*it);
+            delete next;
+          }
+          else
+          {
+            result.set_count(SPARSE_CNT);
+            result.set_sparse(next);
+          }
         }
+        else
+          delete next;
       }
       else if (rhs_count == SPARSE_CNT)
       {
         SparseSet *next = new SparseSet(*rhs.get_sparse());
-        result.set_count(SPARSE_CNT);
-        result.set_sparse(next);
         for (int idx = 0; idx < count; idx++)
-          result.set_bit(get_value<OVERLAP>(idx));
+        {
+          int bit = get_value<OVERLAP>(idx);
+          SparseSet::iterator finder = next->find(bit);
+          if (finder != next->end())
+            next->erase(finder);
+          else
+            next->insert(bit);
+        }
+        if (!next->empty())
+        {
+          if (next->size() <= MAX_CNT)
+          {
+            for (SparseSet::const_iterator it = next->begin();
+                  it != next->end(); it++)
+              result.set_bit(*it);
+            delete next;
+          }
+          else
+          {
+            result.set_count(SPARSE_CNT);
+            result.set_sparse(next);
+          }
+        }
+        else
+          delete next;
       }
       else
       {
-        for (int idx = 0; idx < count; idx++)
-          result.set_bit(get_value<OVERLAP>(idx));
-        for (int idx = 0; idx < rhs_count; idx++)
-          result.set_bit(rhs.get_value<OVERLAP>(idx));
+        if (count < rhs_count)
+        {
+          for (int idx = 0; idx < WORDS; idx++)
+            result.bits[idx] = rhs.bits[idx];
+          for (int idx = 0; idx < count; idx++)
+          {
+            int bit = get_value<OVERLAP>(idx); 
+            if (!rhs.is_set(bit))
+              result.set_bit(bit);
+            else
+              result.unset_bit(bit);
+          }  
+        }
+        else
+        {
+          for (int idx = 0; idx < WORDS; idx++)
+            result.bits[idx] = bits[idx];
+          for (int idx = 0; idx < rhs_count; idx++)
+          {
+            int bit = rhs.get_value<OVERLAP>(idx);
+            if (!is_set(bit))
+              result.set_bit(bit);
+            else
+              result.unset_bit(bit);
+          }
+        }
       }
       return result;
     }
 
     //-------------------------------------------------------------------------
     template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline CompoundBitMask<BITMASK,MAX,WORDS> 
-      CompoundBitMask<BITMASK,MAX,WORDS>::operator&(
-                                              const CompoundBitMask &rhs) const
+    inline CompoundBitMask<BITMASK,MAX,WORDS>& 
+     CompoundBitMask<BITMASK,MAX,WORDS>::operator|=(const CompoundBitMask &rhs)
     //-------------------------------------------------------------------------
     {
-      CompoundBitMask<BITMASK,MAX,WORDS> result;
-      int count = get_count();
       int rhs_count = rhs.get_count();
-      if (count < SPARSE_CNT)
+      if (rhs_count == DENSE_CNT)
       {
-        for (int idx = 0; idx < count; idx++) 
+        int count = get_count();
+        if (count == DENSE_CNT)
         {
-          int bit = get_value<OVERLAP>(idx);
-          if (rhs.is_set(bit))
-            result.set_bit(bit);
+          BITMASK *mask = get_dense();
+          (*mask) |= (*rhs.get_dense());
+        }
+        else
+        {
+          BITMASK *mask = new BITMASK(*rhs.get_dense());
+          if (count == SPARSE_CNT)
+          {
+            SparseSet *sparse = get_sparse();
+            for (SparseSet::const_iterator it = sparse->begin();
+                  it != sparse->end(); it++)
+              mask->set_bit(*it);
+            delete sparse;
+          }
+          else
+          {
+            for (unsigned idx = 0; idx < count; idx++)
+              mask->set_bit(get_value<OVERLAP>(idx));
+          }
+          set_count(DENSE_CNT);
+          set_dense(mask);
+        }
+      }
+      else if (rhs_count == SPARSE_CNT)
+      {
+        SparseSet *other = rhs.get_sparse();
+        for (SparseSet::const_iterator it = other->begin();
+              it != other->end(); it++)
+          set_bit(*it);
+      }
+      else
+      {
+        for (int idx = 0; idx < rhs_count; idx++)
+          set_bit(rhs.get_value<OVERLAP>(idx));
+      }
+      return *this;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
+    inline CompoundBitMask<BITMASK,MAX,WORDS>& 
+     CompoundBitMask<BITMASK,MAX,WORDS>::operator&=(const CompoundBitMask &rhs)
+    //-------------------------------------------------------------------------
+    {
+      int count = get_count();
+      if (count == DENSE_CNT)
+      {
+        int rhs_count = rhs.get_count();
+        BITMASK *dense = get_dense();
+        if (rhs_count == DENSE_CNT)
+        {
+          (*dense) &= (*rhs.get_dense());  
+          if (!(*dense))
+          {
+            delete dense;
+            set_count(0);
+          }
+        }
+        else if (rhs_count == SPARSE_CNT)
+        {
+          SparseSet *other = rhs.get_sparse();
+          set_count(0);
+          for (SparseSet::const_iterator it = other->begin();
+                it != other->end(); it++)
+          {
+            if (dense->is_set(*it))
+              set_bit(*it);
+          }
+          delete dense;
         }
-      }
-      else if (rhs_count < SPARSE_CNT)
-      {
-        for (int idx = 0; idx < rhs_count; idx++)
+        else
         {
-          int bit = rhs.get_value<OVERLAP>(idx);
-          if (is_set(bit))
-            result.set_bit(bit);
+          set_count(0);
+          for (unsigned idx = 0; idx < rhs_count; idx++)
+          {
+            int bit = rhs.get_value<OVERLAP>(idx);
+            if (dense->is_set(bit))
+              set_bit(bit);
+          }
+          delete dense;
         }
       }
       else if (count == SPARSE_CNT)
       {
         SparseSet *sparse = get_sparse();
+        std::vector<int> to_delete;
         for (SparseSet::const_iterator it = sparse->begin();
               it != sparse->end(); it++)
         {
-          if (rhs.is_set(*it))
-            result.set_bit(*it);
+          if (!rhs.is_set(*it))
+            to_delete.push_back(*it);
         }
-      }
-      else if (rhs_count == SPARSE_CNT)
-      {
-        SparseSet *sparse = rhs.get_sparse();
-        for (SparseSet::const_iterator it = sparse->begin();
-              it != sparse->end(); it++)
+        if (!to_delete.empty())
         {
-          if (is_set(*it))
-            result.set_bit(*it);
+          for (std::vector<int>::const_iterator it = to_delete.begin();
+                it != to_delete.end(); it++)
+            unset_bit(*it);
         }
       }
       else
       {
-        // both dense
-        BITMASK next((*get_dense()) & (*rhs.get_dense()));
-        if (!!next)
+        int next_idx = 0;
+        for (int idx = 0; idx < count; idx++)
         {
-          result.set_count(DENSE_CNT);
-          result.set_dense(new BITMASK(next));
+          int bit = get_value<OVERLAP>(idx);
+          if (rhs.is_set(bit))
+          {
+            if (next_idx != idx)
+              set_value<OVERLAP>(next_idx++, bit);
+            else
+              next_idx++;
+          }
         }
+        if (next_idx != count)
+          set_count(next_idx);
       }
-      return result;
+      return *this;
     }
 
     //-------------------------------------------------------------------------
     template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline CompoundBitMask<BITMASK,MAX,WORDS> 
-      CompoundBitMask<BITMASK,MAX,WORDS>::operator^(
-                                              const CompoundBitMask &rhs) const
+    inline CompoundBitMask<BITMASK,MAX,WORDS>& 
+     CompoundBitMask<BITMASK,MAX,WORDS>::operator^=(const CompoundBitMask &rhs)
     //-------------------------------------------------------------------------
     {
-      CompoundBitMask<BITMASK,MAX,WORDS> result;
       int count = get_count();
       int rhs_count = rhs.get_count();
       if (count == DENSE_CNT)
       {
+        BITMASK *dense = get_dense();
         if (rhs_count == DENSE_CNT)
-        {
-          // both dense
-          BITMASK next((*get_dense()) ^ (*rhs.get_dense()));
-          if (!!next)
-          {
-            result.set_count(DENSE_CNT);
-            result.set_dense(new BITMASK(next));
-          }
-        }
+          (*dense) ^= (*rhs.get_dense());
         else if (rhs_count == SPARSE_CNT)
         {
-          BITMASK next((*get_dense()));
-          SparseSet *sparse = rhs.get_sparse();
-          for (SparseSet::const_iterator it = sparse->begin();
-                it != sparse->end(); it++)
+          SparseSet *other = rhs.get_sparse();
+          for (SparseSet::const_iterator it = other->begin();
+                it != other->end(); it++)
           {
-            if (!next.is_set(*it))
-              next.set_bit(*it);
+            if (dense->is_set(*it))
+              dense->unset_bit(*it);
             else
-              next.unset_bit(*it);
-          }
-          if (!!next)
-          {
-            result.set_count(DENSE_CNT);
-            result.set_dense(new BITMASK(next));
+              dense->set_bit(*it);
           }
         }
         else
         {
-          BITMASK next((*get_dense()));
-          for (int idx = 0; idx < rhs_count; idx++)
+          for (unsigned idx = 0; idx < rhs_count; idx++)
           {
             int bit = rhs.get_value<OVERLAP>(idx);
-            if (!next.is_set(bit))
-              next.set_bit(bit);
+            if (dense->is_set(bit))
+              dense->unset_bit(bit);
             else
-              next.unset_bit(bit);
-          }
-          if (!!next)
-          {
-            result.set_count(DENSE_CNT);
-            result.set_dense(new BITMASK(next));
+              dense->set_bit(bit);
           }
         }
+        if (!(*dense))
+        {
+          delete dense;
+          set_count(0);
+        }
       }
       else if (rhs_count == DENSE_CNT)
       {
-        BITMASK next(*(rhs.get_dense()));
+        BITMASK next = *rhs.get_dense();
         if (count == SPARSE_CNT)
         {
           SparseSet *sparse = get_sparse();
           for (SparseSet::const_iterator it = sparse->begin();
                 it != sparse->end(); it++)
           {
-            if (!next.is_set(*it))
-              next.set_bit(*it);
-            else
+            if (next.is_set(*it))
               next.unset_bit(*it);
+            else
+              next.set_bit(*it);
           }
+          delete sparse;
         }
         else
         {
-          for (int idx = 0; idx < count; idx++)
+          for (unsigned idx = 0; idx < count; idx++)
           {
             int bit = get_value<OVERLAP>(idx);
-            if (!next.is_set(bit))
-              next.set_bit(bit);
-            else
+            if (next.is_set(bit))
               next.unset_bit(bit);
+            else
+              next.set_bit(bit);
           }
         }
-        if (!!next)
+        if (!!next)
+        {
+          set_count(DENSE_CNT);
+          set_dense(new BITMASK(next));
+        }
+        else
+          set_count(0);
+      }
+      else if (rhs_count == SPARSE_CNT)
+      {
+        SparseSet *other = rhs.get_sparse();
+        for (SparseSet::const_iterator it = other->begin();
+              it != other->end(); it++)
+        {
+          if (is_set(*it))
+            unset_bit(*it);
+          else
+            set_bit(*it);
+        }
+      }
+      else
+      {
+        for (unsigned idx = 0; idx < rhs_count; idx++)
+        {
+          int bit = rhs.get_value<OVERLAP>(idx);
+          if (is_set(bit))
+            unset_bit(bit);
+          else
+            set_bit(bit);
+        }
+      }
+      return *this;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
+    inline bool CompoundBitMask<BITMASK,MAX,WORDS>::operator*(
+                                              const CompoundBitMask &rhs) const 
+    //-------------------------------------------------------------------------
+    {
+      int count = get_count();
+      if (count == 0)
+        return true;
+      int rhs_count = rhs.get_count();
+      if (rhs_count == 0)
+        return true;
+      if (count == DENSE_CNT)
+      {
+        if (rhs_count == DENSE_CNT)
+          return ((*get_dense()) * (*rhs.get_dense()));
+        else if (rhs_count == SPARSE_CNT)
+        {
+          SparseSet *other = rhs.get_sparse();
+          for (SparseSet::const_iterator it = other->begin();
+                it != other->end(); it++)
+            if (is_set(*it))
+              return false;
+        }
+        else
+          for (int idx = 0; idx < rhs_count; idx++)
+            if (is_set(rhs.get_value<OVERLAP>(idx)))
+              return false;
+      }
+      else if (count == SPARSE_CNT)
+      {
+        SparseSet *sparse = get_sparse();
+        for (SparseSet::const_iterator it = sparse->begin();
+              it != sparse->end(); it++)
+          if (rhs.is_set(*it))
+            return false;
+      }
+      else
+      {
+        for (int idx = 0; idx < count; idx++)
+          if (rhs.is_set(get_value<OVERLAP>(idx)))
+            return false;
+      }
+      return true;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
+    inline bool CompoundBitMask<BITMASK,MAX,WORDS>::operator!(void) const
+    //-------------------------------------------------------------------------
+    {
+      return (get_count() == 0); 
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
+    inline CompoundBitMask<BITMASK,MAX,WORDS> 
+      CompoundBitMask<BITMASK,MAX,WORDS>::operator-(
+                                              const CompoundBitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      CompoundBitMask<BITMASK,MAX,WORDS> result;
+      int count = get_count();
+      if (count == DENSE_CNT)
+      {
+        BITMASK next = *(get_dense());
+        int rhs_count = rhs.get_count();
+        if (rhs_count == DENSE_CNT)
+        {
+          next -= (*rhs.get_dense());
+        }
+        else if (rhs_count == SPARSE_CNT)
+        {
+          SparseSet *other = rhs.get_sparse();
+          for (SparseSet::const_iterator it = other->begin();
+                it != other->end(); it++)
+            next.unset_bit(*it);
+        }
+        else
+        {
+          for (int idx = 0; idx < rhs_count; idx++)
+            next.unset_bit(rhs.get_value<OVERLAP>(idx));
+        }
+        if (!!next)
+        {
+          result.set_count(DENSE_CNT);
+          result.set_dense(new BITMASK(next));
+        }
+      }
+      else if (count == SPARSE_CNT)
+      {
+        SparseSet *sparse = get_sparse();
+        for (SparseSet::const_iterator it = sparse->begin();
+              it != sparse->end(); it++)
+        {
+          if (!rhs.is_set(*it))
+            result.set_bit(*it);
+        }
+      }
+      else
+      {
+        for (int idx = 0; idx < count; idx++)
         {
-          result.set_count(DENSE_CNT);
-          result.set_dense(new BITMASK(next));
+          int bit = get_value<OVERLAP>(idx);
+          if (!rhs.is_set(bit))
+            result.set_bit(bit);
         }
       }
-      else if (count == SPARSE_CNT)
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
+    inline CompoundBitMask<BITMASK,MAX,WORDS>&
+     CompoundBitMask<BITMASK,MAX,WORDS>::operator-=(const CompoundBitMask &rhs)
+    //-------------------------------------------------------------------------
+    {
+      int count = get_count();
+      if (count == DENSE_CNT)
       {
-        SparseSet *next = new SparseSet(*get_sparse());
-        if (rhs_count == SPARSE_CNT)
+        int rhs_count = rhs.get_count();
+        BITMASK *dense = get_dense();
+        if (rhs_count == DENSE_CNT)
+        {
+          (*dense) -= (*rhs.get_dense());
+        }
+        else if (rhs_count == SPARSE_CNT)
         {
           SparseSet *other = rhs.get_sparse();
           for (SparseSet::const_iterator it = other->begin();
                 it != other->end(); it++)
-          {
-            SparseSet::iterator finder = next->find(*it);
-            if (finder != next->end())
-              next->erase(finder);
-            else
-              next->insert(*it);
-          }
+            dense->unset_bit(*it);
         }
         else
         {
           for (int idx = 0; idx < rhs_count; idx++)
-          {
-            int bit = rhs.get_value<OVERLAP>(idx);
-            SparseSet::iterator finder = next->find(bit);
-            if (finder != next->end())
-              next->erase(finder);
-            else
-              next->insert(bit);
-          }
+            dense->unset_bit(rhs.get_value<OVERLAP>(idx));
         }
-        if (!next->empty())
+        if (!(*dense))
         {
-          if (next->size() <= MAX_CNT)
-          {
-            for (SparseSet::const_iterator it = next->begin();
-                  it != next->end(); it++)
-              result.set_bit(*it);
-            delete next;
-          }
-          else
-          {
-            result.set_count(SPARSE_CNT);
-            result.set_sparse(next);
-          }
+          delete dense;
+          set_count(0);
         }
-        else
-          delete next;
       }
-      else if (rhs_count == SPARSE_CNT)
+      else if (count == SPARSE_CNT)
       {
-        SparseSet *next = new SparseSet(*rhs.get_sparse());
-        for (int idx = 0; idx < count; idx++)
+        std::vector<int> to_delete;
+        SparseSet *sparse = get_sparse();
+        for (SparseSet::const_iterator it = sparse->begin();
+              it != sparse->end(); it++)
         {
-          int bit = get_value<OVERLAP>(idx);
-          SparseSet::iterator finder = next->find(bit);
-          if (finder != next->end())
-            next->erase(finder);
-          else
-            next->insert(bit);
+          if (rhs.is_set(*it))
+            to_delete.push_back(*it);
         }
-        if (!next->empty())
+        if (!to_delete.empty())
         {
-          if (next->size() <= MAX_CNT)
-          {
-            for (SparseSet::const_iterator it = next->begin();
-                  it != next->end(); it++)
-              result.set_bit(*it);
-            delete next;
-          }
-          else
-          {
-            result.set_count(SPARSE_CNT);
-            result.set_sparse(next);
-          }
+          for (std::vector<int>::const_iterator it = to_delete.begin();
+                it != to_delete.end(); it++)
+            unset_bit(*it);
         }
-        else
-          delete next;
       }
       else
       {
-        if (count < rhs_count)
-        {
-          for (int idx = 0; idx < WORDS; idx++)
-            result.bits[idx] = rhs.bits[idx];
-          for (int idx = 0; idx < count; idx++)
-          {
-            int bit = get_value<OVERLAP>(idx); 
-            if (!rhs.is_set(bit))
-              result.set_bit(bit);
-            else
-              result.unset_bit(bit);
-          }  
-        }
-        else
+        int next_idx = 0;
+        for (int idx = 0; idx < count; idx++)
         {
-          for (int idx = 0; idx < WORDS; idx++)
-            result.bits[idx] = bits[idx];
-          for (int idx = 0; idx < rhs_count; idx++)
+          int bit = get_value<OVERLAP>(idx);
+          if (!rhs.is_set(bit))
           {
-            int bit = rhs.get_value<OVERLAP>(idx);
-            if (!is_set(bit))
-              result.set_bit(bit);
+            if (next_idx != idx)
+              set_value<OVERLAP>(next_idx++, bit);
             else
-              result.unset_bit(bit);
+              next_idx++;
           }
         }
+        if (next_idx != count)
+          set_count(next_idx);
       }
-      return result;
+      return *this;
     }
 
     //-------------------------------------------------------------------------
     template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline CompoundBitMask<BITMASK,MAX,WORDS>& 
-     CompoundBitMask<BITMASK,MAX,WORDS>::operator|=(const CompoundBitMask &rhs)
+    inline CompoundBitMask<BITMASK,MAX,WORDS> 
+           CompoundBitMask<BITMASK,MAX,WORDS>::operator<<(unsigned shift) const
     //-------------------------------------------------------------------------
     {
-      int rhs_count = rhs.get_count();
-      if (rhs_count == DENSE_CNT)
+      CompoundBitMask<BITMASK,MAX,WORDS> result;
+      int count = get_count();
+      if (count == DENSE_CNT)
       {
-        int count = get_count();
-        if (count == DENSE_CNT)
+        BITMASK dense = (*get_dense()) << shift;
+        if (!!dense)
         {
-          BITMASK *mask = get_dense();
-          (*mask) |= (*rhs.get_dense());
+          result.set_count(DENSE_CNT);
+          result.set_dense(new BITMASK(dense));
         }
-        else
+      }
+      else if (count == SPARSE_CNT)
+      {
+        SparseSet *sparse = get_sparse();
+        for (SparseSet::const_iterator it = sparse->begin();
+              it != sparse->end(); it++)
         {
-          BITMASK *mask = new BITMASK(*rhs.get_dense());
-          if (count == SPARSE_CNT)
-          {
-            SparseSet *sparse = get_sparse();
-            for (SparseSet::const_iterator it = sparse->begin();
-                  it != sparse->end(); it++)
-              mask->set_bit(*it);
-            delete sparse;
-          }
-          else
-          {
-            for (unsigned idx = 0; idx < count; idx++)
-              mask->set_bit(get_value<OVERLAP>(idx));
-          }
-          set_count(DENSE_CNT);
-          set_dense(mask);
+          int bit = (*it) + shift;
+          if (bit < MAX)
+            result.set_bit(bit);
         }
       }
-      else if (rhs_count == SPARSE_CNT)
+      else
       {
-        SparseSet *other = rhs.get_sparse();
-        for (SparseSet::const_iterator it = other->begin();
-              it != other->end(); it++)
-          set_bit(*it);
+        int next_idx = 0;
+        for (int idx = 0; idx < count; idx++)
+        {
+          int bit = get_value<OVERLAP>(idx) + shift;
+          if (bit < MAX)
+            result.set_value<OVERLAP>(next_idx++, bit);
+        }
+        if (next_idx > 0)
+          result.set_count(next_idx);
+      }
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
+    inline CompoundBitMask<BITMASK,MAX,WORDS> 
+           CompoundBitMask<BITMASK,MAX,WORDS>::operator>>(unsigned shift) const
+    //-------------------------------------------------------------------------
+    {
+      CompoundBitMask<BITMASK,MAX,WORDS> result;
+      int count = get_count();
+      if (count == DENSE_CNT)
+      {
+        BITMASK dense = (*get_dense()) >> shift;
+        if (!!dense)
+        {
+          result.set_count(DENSE_CNT);
+          result.set_dense(new BITMASK(dense));
+        }
+      }
+      else if (count == SPARSE_CNT)
+      {
+        SparseSet *sparse = get_sparse();
+        for (SparseSet::const_iterator it = sparse->begin();
+              it != sparse->end(); it++)
+        {
+          int bit = (*it) - shift;
+          if (bit >= 0)
+            result.set_bit(bit);
+        }
       }
       else
       {
-        for (int idx = 0; idx < rhs_count; idx++)
-          set_bit(rhs.get_value<OVERLAP>(idx));
+        int next_idx = 0;
+        for (int idx = 0; idx < count; idx++)
+        {
+          int bit = get_value<OVERLAP>(idx) - shift;
+          if (bit >= 0)
+            result.set_value<OVERLAP>(next_idx++, bit);
+        }
+        if (next_idx > 0)
+          result.set_count(next_idx);
       }
-      return *this;
+      return result;
     }
 
     //-------------------------------------------------------------------------
     template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
     inline CompoundBitMask<BITMASK,MAX,WORDS>& 
-     CompoundBitMask<BITMASK,MAX,WORDS>::operator&=(const CompoundBitMask &rhs)
+                CompoundBitMask<BITMASK,MAX,WORDS>::operator<<=(unsigned shift)
     //-------------------------------------------------------------------------
     {
-      int count = get_count();
+      int count = get_count(); 
       if (count == DENSE_CNT)
       {
-        int rhs_count = rhs.get_count();
         BITMASK *dense = get_dense();
-        if (rhs_count == DENSE_CNT)
-        {
-          (*dense) &= (*rhs.get_dense());  
-          if (!(*dense))
-          {
-            delete dense;
-            set_count(0);
-          }
-        }
-        else if (rhs_count == SPARSE_CNT)
+        (*dense) <<= shift;
+        if (!(*dense))
         {
-          SparseSet *other = rhs.get_sparse();
-          set_count(0);
-          for (SparseSet::const_iterator it = other->begin();
-                it != other->end(); it++)
-          {
-            if (dense->is_set(*it))
-              set_bit(*it);
-          }
           delete dense;
-        }
-        else
-        {
           set_count(0);
-          for (unsigned idx = 0; idx < rhs_count; idx++)
-          {
-            int bit = rhs.get_value<OVERLAP>(idx);
-            if (dense->is_set(bit))
-              set_bit(bit);
-          }
-          delete dense;
         }
       }
       else if (count == SPARSE_CNT)
       {
-        SparseSet *sparse = get_sparse();
         std::vector<int> to_delete;
+        SparseSet *sparse = get_sparse();
+        set_count(0);
         for (SparseSet::const_iterator it = sparse->begin();
               it != sparse->end(); it++)
         {
-          if (!rhs.is_set(*it))
-            to_delete.push_back(*it);
-        }
-        if (!to_delete.empty())
-        {
-          for (std::vector<int>::const_iterator it = to_delete.begin();
-                it != to_delete.end(); it++)
-            unset_bit(*it);
+          int bit = (*it) + shift;
+          if (bit < MAX)
+            set_bit(bit);
         }
+        delete sparse;
       }
       else
       {
-        int next_idx = 0;
+        int next_idx = 0; 
         for (int idx = 0; idx < count; idx++)
         {
-          int bit = get_value<OVERLAP>(idx);
-          if (rhs.is_set(bit))
-          {
-            if (next_idx != idx)
-              set_value<OVERLAP>(next_idx++, bit);
-            else
-              next_idx++;
-          }
+          int bit = get_value<OVERLAP>(idx) + shift;
+          if (bit < MAX)
+            set_value<OVERLAP>(next_idx++, bit);
         }
         if (next_idx != count)
           set_count(next_idx);
@@ -7338,616 +9906,870 @@ namespace Legion {
     //-------------------------------------------------------------------------
     template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
     inline CompoundBitMask<BITMASK,MAX,WORDS>& 
-     CompoundBitMask<BITMASK,MAX,WORDS>::operator^=(const CompoundBitMask &rhs)
+                CompoundBitMask<BITMASK,MAX,WORDS>::operator>>=(unsigned shift)
     //-------------------------------------------------------------------------
     {
       int count = get_count();
-      int rhs_count = rhs.get_count();
       if (count == DENSE_CNT)
       {
         BITMASK *dense = get_dense();
-        if (rhs_count == DENSE_CNT)
-          (*dense) ^= (*rhs.get_dense());
-        else if (rhs_count == SPARSE_CNT)
-        {
-          SparseSet *other = rhs.get_sparse();
-          for (SparseSet::const_iterator it = other->begin();
-                it != other->end(); it++)
-          {
-            if (dense->is_set(*it))
-              dense->unset_bit(*it);
-            else
-              dense->set_bit(*it);
-          }
-        }
-        else
-        {
-          for (unsigned idx = 0; idx < rhs_count; idx++)
-          {
-            int bit = rhs.get_value<OVERLAP>(idx);
-            if (dense->is_set(bit))
-              dense->unset_bit(bit);
-            else
-              dense->set_bit(bit);
-          }
-        }
+        (*dense) >>= shift;
         if (!(*dense))
         {
           delete dense;
           set_count(0);
         }
       }
-      else if (rhs_count == DENSE_CNT)
-      {
-        BITMASK next = *rhs.get_dense();
-        if (count == SPARSE_CNT)
-        {
-          SparseSet *sparse = get_sparse();
-          for (SparseSet::const_iterator it = sparse->begin();
-                it != sparse->end(); it++)
-          {
-            if (next.is_set(*it))
-              next.unset_bit(*it);
-            else
-              next.set_bit(*it);
-          }
-          delete sparse;
-        }
-        else
-        {
-          for (unsigned idx = 0; idx < count; idx++)
-          {
-            int bit = get_value<OVERLAP>(idx);
-            if (next.is_set(bit))
-              next.unset_bit(bit);
-            else
-              next.set_bit(bit);
-          }
-        }
-        if (!!next)
-        {
-          set_count(DENSE_CNT);
-          set_dense(new BITMASK(next));
-        }
-        else
-          set_count(0);
-      }
-      else if (rhs_count == SPARSE_CNT)
+      else if (count == SPARSE_CNT)
       {
-        SparseSet *other = rhs.get_sparse();
-        for (SparseSet::const_iterator it = other->begin();
-              it != other->end(); it++)
+        SparseSet *sparse = get_sparse();
+        set_count(0);
+        for (SparseSet::const_iterator it = sparse->begin();
+              it != sparse->end(); it++)
         {
-          if (is_set(*it))
-            unset_bit(*it);
-          else
-            set_bit(*it);
+          int bit = (*it) - shift;
+          if (bit >= 0)
+            set_bit(bit);
         }
+        delete sparse;
       }
       else
       {
-        for (unsigned idx = 0; idx < rhs_count; idx++)
+        int next_idx = 0;
+        for (int idx = 0; idx < count; idx++)
         {
-          int bit = rhs.get_value<OVERLAP>(idx);
-          if (is_set(bit))
-            unset_bit(bit);
-          else
-            set_bit(bit);
+          int bit = get_value<OVERLAP>(idx) - shift;
+          if (bit >= 0)
+            set_value<OVERLAP>(next_idx++, bit);
         }
+        if (next_idx != count)
+          set_count(next_idx);
       }
       return *this;
     }
 
     //-------------------------------------------------------------------------
     template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline bool CompoundBitMask<BITMASK,MAX,WORDS>::operator*(
-                                              const CompoundBitMask &rhs) const 
+    inline uint64_t CompoundBitMask<BITMASK,MAX,WORDS>::get_hash_key(void) 
+                                                                          const
     //-------------------------------------------------------------------------
     {
       int count = get_count();
-      if (count == 0)
-        return true;
-      int rhs_count = rhs.get_count();
-      if (rhs_count == 0)
-        return true;
       if (count == DENSE_CNT)
-      {
-        if (rhs_count == DENSE_CNT)
-          return ((*get_dense()) * (*rhs.get_dense()));
-        else if (rhs_count == SPARSE_CNT)
-        {
-          SparseSet *other = rhs.get_sparse();
-          for (SparseSet::const_iterator it = other->begin();
-                it != other->end(); it++)
-            if (is_set(*it))
-              return false;
-        }
-        else
-          for (int idx = 0; idx < rhs_count; idx++)
-            if (is_set(rhs.get_value<OVERLAP>(idx)))
-              return false;
-      }
-      else if (count == SPARSE_CNT)
+        return get_dense()->get_hash_key();
+      uint64_t result = 0;
+      if (count == SPARSE_CNT)
       {
         SparseSet *sparse = get_sparse();
         for (SparseSet::const_iterator it = sparse->begin();
               it != sparse->end(); it++)
-          if (rhs.is_set(*it))
-            return false;
+          result |= (1UL << ((*it) % (8*sizeof(result))));
       }
       else
       {
         for (int idx = 0; idx < count; idx++)
-          if (rhs.is_set(get_value<OVERLAP>(idx)))
-            return false;
+          result |= (1UL << (get_value<OVERLAP>(idx) % (8*sizeof(result))));
       }
-      return true;
+      return result;
     }
 
     //-------------------------------------------------------------------------
     template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline bool CompoundBitMask<BITMASK,MAX,WORDS>::operator!(void) const
+    inline void CompoundBitMask<BITMASK,MAX,WORDS>::serialize(Serializer &rez) 
+                                                                          const
     //-------------------------------------------------------------------------
     {
-      return (get_count() == 0); 
+      int count = get_count();
+      rez.serialize(count);
+      if (count == DENSE_CNT)
+        get_dense()->serialize(rez); 
+      else if (count == SPARSE_CNT)
+      {
+        SparseSet *sparse = get_sparse();
+        rez.serialize<size_t>(sparse->size());
+        for (SparseSet::const_iterator it = sparse->begin();
+              it != sparse->end(); it++)
+          rez.serialize(*it);
+      }
+      else
+      {
+        // Just serialize all the words, won't be that hard
+        for (unsigned idx = 0; idx < WORDS; idx++)
+          rez.serialize(bits[idx]);
+      }
     }
 
     //-------------------------------------------------------------------------
     template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline CompoundBitMask<BITMASK,MAX,WORDS> 
-      CompoundBitMask<BITMASK,MAX,WORDS>::operator-(
-                                              const CompoundBitMask &rhs) const
+    inline void CompoundBitMask<BITMASK,MAX,WORDS>::deserialize(
+                                                           Deserializer &derez)
     //-------------------------------------------------------------------------
     {
-      CompoundBitMask<BITMASK,MAX,WORDS> result;
-      int count = get_count();
-      if (count == DENSE_CNT)
+      int current_count = get_count();
+      int next_count;
+      derez.deserialize(next_count);
+      if (next_count == DENSE_CNT)
       {
-        BITMASK next = *(get_dense());
-        int rhs_count = rhs.get_count();
-        if (rhs_count == DENSE_CNT)
-        {
-          next -= (*rhs.get_dense());
-        }
-        else if (rhs_count == SPARSE_CNT)
+        BITMASK *dense;
+        if (current_count != DENSE_CNT)
         {
-          SparseSet *other = rhs.get_sparse();
-          for (SparseSet::const_iterator it = other->begin();
-                it != other->end(); it++)
-            next.unset_bit(*it);
+          if (current_count == SPARSE_CNT)
+            delete get_sparse();
+          set_count(DENSE_CNT);
+          dense = new BITMASK();
+          set_dense(dense);
         }
         else
-        {
-          for (int idx = 0; idx < rhs_count; idx++)
-            next.unset_bit(rhs.get_value<OVERLAP>(idx));
-        }
-        if (!!next)
-        {
-          result.set_count(DENSE_CNT);
-          result.set_dense(new BITMASK(next));
-        }
+          dense = get_dense();
+        dense->deserialize(derez);
       }
-      else if (count == SPARSE_CNT)
+      else if (next_count == SPARSE_CNT)
       {
-        SparseSet *sparse = get_sparse();
-        for (SparseSet::const_iterator it = sparse->begin();
-              it != sparse->end(); it++)
+        SparseSet *sparse = new SparseSet();
+        if (current_count == DENSE_CNT)
+          delete get_dense();
+        size_t num_elements;
+        derez.deserialize(num_elements);
+        for (unsigned idx = 0; idx < num_elements; idx++)
         {
-          if (!rhs.is_set(*it))
-            result.set_bit(*it);
+          int bit;
+          derez.deserialize(bit);
+          sparse->insert(bit);
         }
+        set_count(SPARSE_CNT);
+        set_sparse(sparse);
       }
       else
       {
-        for (int idx = 0; idx < count; idx++)
-        {
-          int bit = get_value<OVERLAP>(idx);
-          if (!rhs.is_set(bit))
-            result.set_bit(bit);
-        }
+        if (current_count == DENSE_CNT)
+          delete get_dense();
+        else if (current_count == SPARSE_CNT)
+          delete get_sparse();
+        for (unsigned idx = 0; idx < WORDS; idx++)
+          derez.deserialize(bits[idx]);
       }
-      return result;
     }
 
     //-------------------------------------------------------------------------
     template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline CompoundBitMask<BITMASK,MAX,WORDS>&
-     CompoundBitMask<BITMASK,MAX,WORDS>::operator-=(const CompoundBitMask &rhs)
+    inline char* CompoundBitMask<BITMASK,MAX,WORDS>::to_string(void) const
     //-------------------------------------------------------------------------
     {
       int count = get_count();
       if (count == DENSE_CNT)
       {
-        int rhs_count = rhs.get_count();
-        BITMASK *dense = get_dense();
-        if (rhs_count == DENSE_CNT)
-        {
-          (*dense) -= (*rhs.get_dense());
-        }
-        else if (rhs_count == SPARSE_CNT)
-        {
-          SparseSet *other = rhs.get_sparse();
-          for (SparseSet::const_iterator it = other->begin();
-                it != other->end(); it++)
-            dense->unset_bit(*it);
-        }
-        else
-        {
-          for (int idx = 0; idx < rhs_count; idx++)
-            dense->unset_bit(rhs.get_value<OVERLAP>(idx));
-        }
-        if (!(*dense))
-        {
-          delete dense;
-          set_count(0);
-        }
+        return get_dense()->to_string(); 
       }
       else if (count == SPARSE_CNT)
       {
-        std::vector<int> to_delete;
+        char *result = (char*)malloc(1024*sizeof(char));
+        sprintf(result,"Compound Sparse %d:", count);
         SparseSet *sparse = get_sparse();
         for (SparseSet::const_iterator it = sparse->begin();
               it != sparse->end(); it++)
         {
-          if (rhs.is_set(*it))
-            to_delete.push_back(*it);
-        }
-        if (!to_delete.empty())
-        {
-          for (std::vector<int>::const_iterator it = to_delete.begin();
-                it != to_delete.end(); it++)
-            unset_bit(*it);
+          char temp[64];
+          sprintf(temp, " %d", (*it));
+          strcat(result,temp);
         }
+        return result;
       }
       else
       {
-        int next_idx = 0;
+        char *result = (char*)malloc(1024*sizeof(char));
+        sprintf(result,"Compound Base %d:", count);
         for (int idx = 0; idx < count; idx++)
         {
-          int bit = get_value<OVERLAP>(idx);
-          if (!rhs.is_set(bit))
-          {
-            if (next_idx != idx)
-              set_value<OVERLAP>(next_idx++, bit);
-            else
-              next_idx++;
-          }
+          char temp[64];
+          sprintf(temp, " %d", get_value<OVERLAP>(idx));
+          strcat(result,temp);
         }
-        if (next_idx != count)
-          set_count(next_idx);
+        return result;
       }
-      return *this;
     }
 
     //-------------------------------------------------------------------------
     template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline CompoundBitMask<BITMASK,MAX,WORDS> 
-           CompoundBitMask<BITMASK,MAX,WORDS>::operator<<(unsigned shift) const
+    /*static*/ inline int CompoundBitMask<BITMASK,MAX,WORDS>::pop_count(
+                                                   const CompoundBitMask &mask)
     //-------------------------------------------------------------------------
     {
-      CompoundBitMask<BITMASK,MAX,WORDS> result;
-      int count = get_count();
+      int count = mask.get_count();
       if (count == DENSE_CNT)
+        count = BITMASK::pop_count(*mask.get_dense());
+      else if (count == SPARSE_CNT)
+        count = mask.get_sparse()->size();
+      return count;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    SparseBitMask<BITMASK,MAX,CNT>::SparseBitMask(uint64_t init /*= 0*/)
+      : count(0)
+    //-------------------------------------------------------------------------
+    {
+      LEGION_STATIC_ASSERT(MAX <= DENSE_CNT);
+      LEGION_STATIC_ASSERT(CNT < DENSE_CNT);
+      if (init != 0)
       {
-        BITMASK dense = (*get_dense()) << shift;
-        if (!!dense)
-        {
-          result.set_count(DENSE_CNT);
-          result.set_dense(new BITMASK(dense));
-        }
+        bits.dense = new BITMASK(init);
+        count = DENSE_CNT;
+        normalize();
       }
-      else if (count == SPARSE_CNT)
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    SparseBitMask<BITMASK,MAX,CNT>::SparseBitMask(const SparseBitMask &rhs)
+      : count(rhs.count)
+    //-------------------------------------------------------------------------
+    {
+      if (rhs.is_dense())
+        bits.dense = new BITMASK(*rhs.bits.dense);
+      else
+        for (unsigned idx = 0; idx < count; idx++)
+          bits.sparse[idx] = rhs.bits.sparse[idx];
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    SparseBitMask<BITMASK,MAX,CNT>::~SparseBitMask(void)
+    //-------------------------------------------------------------------------
+    {
+      if (is_dense())
+        delete bits.dense;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline void SparseBitMask<BITMASK,MAX,CNT>::set_bit(unsigned bit)
+    //-------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(bit < MAX);
+#endif
+      if (is_dense())
       {
-        SparseSet *sparse = get_sparse();
-        for (SparseSet::const_iterator it = sparse->begin();
-              it != sparse->end(); it++)
-        {
-          int bit = (*it) + shift;
-          if (bit < MAX)
-            result.set_bit(bit);
-        }
+        bits.dense->set_bit(bit);
+        return;
       }
+      unsigned pos = 0;
+      while ((pos < count) && (bits.sparse[pos] < bit))
+        pos++;
+      if ((pos < count) && (bits.sparse[pos] == bit))
+        return;
+      if (count == CNT)
+      {
+        // Full, time to go dense
+        make_dense().set_bit(bit);
+        return;
+      }
+      for (unsigned idx = count; idx > pos; idx--)
+        bits.sparse[idx] = bits.sparse[idx-1];
+      bits.sparse[pos] = bit;
+      count++;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline void SparseBitMask<BITMASK,MAX,CNT>::unset_bit(unsigned bit)
+    //-------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(bit < MAX);
+#endif
+      if (is_dense())
+      {
+        bits.dense->unset_bit(bit);
+        normalize();
+        return;
+      }
+      for (unsigned idx = 0; idx < count; idx++)
+      {
+        if (bits.sparse[idx] != bit)
+          continue;
+        for ( ; idx < unsigned(count-1); idx++)
+          bits.sparse[idx] = bits.sparse[idx+1];
+        count--;
+        return;
+      }
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline void SparseBitMask<BITMASK,MAX,CNT>::assign_bit(unsigned bit, 
+                                                           bool val)
+    //-------------------------------------------------------------------------
+    {
+      if (val)
+        set_bit(bit);
       else
+        unset_bit(bit);
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline bool SparseBitMask<BITMASK,MAX,CNT>::is_set(unsigned bit) const
+    //-------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(bit < MAX);
+#endif
+      if (is_dense())
+        return bits.dense->is_set(bit);
+      for (unsigned idx = 0; idx < count; idx++)
       {
-        int next_idx = 0;
-        for (int idx = 0; idx < count; idx++)
-        {
-          int bit = get_value<OVERLAP>(idx) + shift;
-          if (bit < MAX)
-            result.set_value<OVERLAP>(next_idx++, bit);
-        }
-        if (next_idx > 0)
-          result.set_count(next_idx);
+        if (bits.sparse[idx] == bit)
+          return true;
+        if (bits.sparse[idx] > bit)
+          break;
+      }
+      return false;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline int SparseBitMask<BITMASK,MAX,CNT>::find_first_set(void) const
+    //-------------------------------------------------------------------------
+    {
+      if (is_dense())
+        return bits.dense->find_first_set();
+      if (count == 0)
+        return -1;
+      return bits.sparse[0];
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline int SparseBitMask<BITMASK,MAX,CNT>::find_index_set(int index) const
+    //-------------------------------------------------------------------------
+    {
+      if (is_dense())
+        return bits.dense->find_index_set(index);
+      if ((index < 0) || (index >= int(count)))
+        return -1;
+      return bits.sparse[index];
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline int SparseBitMask<BITMASK,MAX,CNT>::find_next_set(int start) const
+    //-------------------------------------------------------------------------
+    {
+      if (is_dense())
+        return bits.dense->find_next_set(start);
+      for (unsigned idx = 0; idx < count; idx++)
+        if (int(bits.sparse[idx]) >= start)
+          return bits.sparse[idx];
+      return -1;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline void SparseBitMask<BITMASK,MAX,CNT>::clear(void)
+    //-------------------------------------------------------------------------
+    {
+      if (is_dense())
+        delete bits.dense;
+      count = 0;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline bool SparseBitMask<BITMASK,MAX,CNT>::operator==(
+                                                const SparseBitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      // The representation is canonical so we can compare it directly
+      if (count != rhs.count)
+        return false;
+      if (is_dense())
+        return (*bits.dense == *rhs.bits.dense);
+      for (unsigned idx = 0; idx < count; idx++)
+        if (bits.sparse[idx] != rhs.bits.sparse[idx])
+          return false;
+      return true;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline bool SparseBitMask<BITMASK,MAX,CNT>::operator<(
+                                                const SparseBitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      // Any strict ordering will do, order by count first 
+      if (count != rhs.count)
+        return (count < rhs.count);
+      if (is_dense())
+        return (*bits.dense < *rhs.bits.dense);
+      for (unsigned idx = 0; idx < count; idx++)
+      {
+        if (bits.sparse[idx] < rhs.bits.sparse[idx])
+          return true;
+        if (bits.sparse[idx] > rhs.bits.sparse[idx])
+          return false;
+      }
+      return false;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline bool SparseBitMask<BITMASK,MAX,CNT>::operator!=(
+                                                const SparseBitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      return !(*this == rhs);
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline SparseBitMask<BITMASK,MAX,CNT>& 
+      SparseBitMask<BITMASK,MAX,CNT>::operator=(const SparseBitMask &rhs)
+    //-------------------------------------------------------------------------
+    {
+      if (this == &rhs)
+        return *this;
+      if (rhs.is_dense())
+      {
+        if (is_dense())
+          *bits.dense = *rhs.bits.dense;
+        else
+          bits.dense = new BITMASK(*rhs.bits.dense);
+      }
+      else
+      {
+        if (is_dense())
+          delete bits.dense;
+        for (unsigned idx = 0; idx < rhs.count; idx++)
+          bits.sparse[idx] = rhs.bits.sparse[idx];
       }
+      count = rhs.count;
+      return *this;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline SparseBitMask<BITMASK,MAX,CNT> 
+                          SparseBitMask<BITMASK,MAX,CNT>::operator~(void) const
+    //-------------------------------------------------------------------------
+    {
+      SparseBitMask<BITMASK,MAX,CNT> result(*this);
+      BITMASK &dense = result.make_dense();
+      dense = ~dense;
+      result.normalize();
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline SparseBitMask<BITMASK,MAX,CNT> 
+      SparseBitMask<BITMASK,MAX,CNT>::operator|(const SparseBitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      SparseBitMask<BITMASK,MAX,CNT> result(*this);
+      result |= rhs;
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline SparseBitMask<BITMASK,MAX,CNT> 
+      SparseBitMask<BITMASK,MAX,CNT>::operator&(const SparseBitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      SparseBitMask<BITMASK,MAX,CNT> result(*this);
+      result &= rhs;
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline SparseBitMask<BITMASK,MAX,CNT> 
+      SparseBitMask<BITMASK,MAX,CNT>::operator^(const SparseBitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      SparseBitMask<BITMASK,MAX,CNT> result(*this);
+      result ^= rhs;
       return result;
     }
 
     //-------------------------------------------------------------------------
-    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline CompoundBitMask<BITMASK,MAX,WORDS> 
-           CompoundBitMask<BITMASK,MAX,WORDS>::operator>>(unsigned shift) const
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline SparseBitMask<BITMASK,MAX,CNT>& 
+            SparseBitMask<BITMASK,MAX,CNT>::operator|=(const SparseBitMask &rhs)
     //-------------------------------------------------------------------------
     {
-      CompoundBitMask<BITMASK,MAX,WORDS> result;
-      int count = get_count();
-      if (count == DENSE_CNT)
+      if (!is_dense() && !rhs.is_dense())
+        merge_sparse(rhs, MERGE_UNION);
+      else
       {
-        BITMASK dense = (*get_dense()) >> shift;
-        if (!!dense)
-        {
-          result.set_count(DENSE_CNT);
-          result.set_dense(new BITMASK(dense));
-        }
+        // Unions can only grow so no need to normalize
+        BITMASK scratch;
+        make_dense() |= rhs.dense_view(scratch);
       }
-      else if (count == SPARSE_CNT)
+      return *this;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline SparseBitMask<BITMASK,MAX,CNT>& 
+            SparseBitMask<BITMASK,MAX,CNT>::operator&=(const SparseBitMask &rhs)
+    //-------------------------------------------------------------------------
+    {
+      if (!is_dense())
       {
-        SparseSet *sparse = get_sparse();
-        for (SparseSet::const_iterator it = sparse->begin();
-              it != sparse->end(); it++)
+        if (!rhs.is_dense())
+          merge_sparse(rhs, MERGE_INTERSECT);
+        else
         {
-          int bit = (*it) - shift;
-          if (bit >= 0)
-            result.set_bit(bit);
+          // Keep our indexes that are also in the dense mask
+          unsigned next = 0;
+          for (unsigned idx = 0; idx < count; idx++)
+            if (rhs.bits.dense->is_set(bits.sparse[idx]))
+              bits.sparse[next++] = bits.sparse[idx];
+          count = next;
         }
       }
       else
       {
-        int next_idx = 0;
-        for (int idx = 0; idx < count; idx++)
-        {
-          int bit = get_value<OVERLAP>(idx) - shift;
-          if (bit >= 0)
-            result.set_value<OVERLAP>(next_idx++, bit);
-        }
-        if (next_idx > 0)
-          result.set_count(next_idx);
+        BITMASK scratch;
+        (*bits.dense) &= rhs.dense_view(scratch);
+        normalize();
       }
-      return result;
+      return *this;
     }
 
     //-------------------------------------------------------------------------
-    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline CompoundBitMask<BITMASK,MAX,WORDS>& 
-                CompoundBitMask<BITMASK,MAX,WORDS>::operator<<=(unsigned shift)
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline SparseBitMask<BITMASK,MAX,CNT>& 
+            SparseBitMask<BITMASK,MAX,CNT>::operator^=(const SparseBitMask &rhs)
     //-------------------------------------------------------------------------
     {
-      int count = get_count(); 
-      if (count == DENSE_CNT)
+      if (!is_dense() && !rhs.is_dense())
+        merge_sparse(rhs, MERGE_SYMMETRIC);
+      else
       {
-        BITMASK *dense = get_dense();
-        (*dense) <<= shift;
-        if (!(*dense))
-        {
-          delete dense;
-          set_count(0);
-        }
+        BITMASK scratch;
+        make_dense() ^= rhs.dense_view(scratch);
+        normalize();
       }
-      else if (count == SPARSE_CNT)
+      return *this;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline bool SparseBitMask<BITMASK,MAX,CNT>::operator*(
+                                                const SparseBitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      if (is_dense() && rhs.is_dense())
+        return ((*bits.dense) * (*rhs.bits.dense));
+      if (is_dense())
+        return (rhs * (*this));
+      // We're sparse, check each of our bits
+      for (unsigned idx = 0; idx < count; idx++)
+        if (rhs.is_set(bits.sparse[idx]))
+          return false;
+      return true;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline SparseBitMask<BITMASK,MAX,CNT> 
+      SparseBitMask<BITMASK,MAX,CNT>::operator-(const SparseBitMask &rhs) const
+    //-------------------------------------------------------------------------
+    {
+      SparseBitMask<BITMASK,MAX,CNT> result(*this);
+      result -= rhs;
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline SparseBitMask<BITMASK,MAX,CNT>& 
+            SparseBitMask<BITMASK,MAX,CNT>::operator-=(const SparseBitMask &rhs)
+    //-------------------------------------------------------------------------
+    {
+      if (!is_dense())
       {
-        std::vector<int> to_delete;
-        SparseSet *sparse = get_sparse();
-        set_count(0);
-        for (SparseSet::const_iterator it = sparse->begin();
-              it != sparse->end(); it++)
+        if (!rhs.is_dense())
+          merge_sparse(rhs, MERGE_DIFFERENCE);
+        else
         {
-          int bit = (*it) + shift;
-          if (bit < MAX)
-            set_bit(bit);
+          // Keep our indexes that are not in the dense mask
+          unsigned next = 0;
+          for (unsigned idx = 0; idx < count; idx++)
+            if (!rhs.bits.dense->is_set(bits.sparse[idx]))
+              bits.sparse[next++] = bits.sparse[idx];
+          count = next;
         }
-        delete sparse;
       }
       else
       {
-        int next_idx = 0; 
-        for (int idx = 0; idx < count; idx++)
-        {
-          int bit = get_value<OVERLAP>(idx) + shift;
-          if (bit < MAX)
-            set_value<OVERLAP>(next_idx++, bit);
-        }
-        if (next_idx != count)
-          set_count(next_idx);
+        BITMASK scratch;
+        (*bits.dense) -= rhs.dense_view(scratch);
+        normalize();
       }
       return *this;
     }
 
     //-------------------------------------------------------------------------
-    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline CompoundBitMask<BITMASK,MAX,WORDS>& 
-                CompoundBitMask<BITMASK,MAX,WORDS>::operator>>=(unsigned shift)
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline bool SparseBitMask<BITMASK,MAX,CNT>::operator!(void) const
     //-------------------------------------------------------------------------
     {
-      int count = get_count();
-      if (count == DENSE_CNT)
-      {
-        BITMASK *dense = get_dense();
-        (*dense) >>= shift;
-        if (!(*dense))
-        {
-          delete dense;
-          set_count(0);
-        }
-      }
-      else if (count == SPARSE_CNT)
+      // Dense masks always have bits set
+      return (count == 0);
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline SparseBitMask<BITMASK,MAX,CNT> 
+              SparseBitMask<BITMASK,MAX,CNT>::operator<<(unsigned shift) const
+    //-------------------------------------------------------------------------
+    {
+      SparseBitMask<BITMASK,MAX,CNT> result(*this);
+      result <<= shift;
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline SparseBitMask<BITMASK,MAX,CNT> 
+              SparseBitMask<BITMASK,MAX,CNT>::operator>>(unsigned shift) const
+    //-------------------------------------------------------------------------
+    {
+      SparseBitMask<BITMASK,MAX,CNT> result(*this);
+      result >>= shift;
+      return result;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline SparseBitMask<BITMASK,MAX,CNT>& 
+                  SparseBitMask<BITMASK,MAX,CNT>::operator<<=(unsigned shift)
+    //-------------------------------------------------------------------------
+    {
+      if (is_dense())
       {
-        SparseSet *sparse = get_sparse();
-        set_count(0);
-        for (SparseSet::const_iterator it = sparse->begin();
-              it != sparse->end(); it++)
-        {
-          int bit = (*it) - shift;
-          if (bit >= 0)
-            set_bit(bit);
-        }
-        delete sparse;
+        (*bits.dense) <<= shift;
+        normalize();
       }
       else
       {
-        int next_idx = 0;
-        for (int idx = 0; idx < count; idx++)
-        {
-          int bit = get_value<OVERLAP>(idx) - shift;
-          if (bit >= 0)
-            set_value<OVERLAP>(next_idx++, bit);
-        }
-        if (next_idx != count)
-          set_count(next_idx);
+        // Bits shifted past the end fall off
+        unsigned next = 0;
+        for (unsigned idx = 0; idx < count; idx++)
+          if ((bits.sparse[idx] + shift) < MAX)
+            bits.sparse[next++] = bits.sparse[idx] + shift;
+        count = next;
       }
       return *this;
     }
 
     //-------------------------------------------------------------------------
-    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline uint64_t CompoundBitMask<BITMASK,MAX,WORDS>::get_hash_key(void) 
-                                                                          const
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline SparseBitMask<BITMASK,MAX,CNT>& 
+                  SparseBitMask<BITMASK,MAX,CNT>::operator>>=(unsigned shift)
     //-------------------------------------------------------------------------
     {
-      int count = get_count();
-      if (count == DENSE_CNT)
-        return get_dense()->get_hash_key();
-      uint64_t result = 0;
-      if (count == SPARSE_CNT)
+      if (is_dense())
       {
-        SparseSet *sparse = get_sparse();
-        for (SparseSet::const_iterator it = sparse->begin();
-              it != sparse->end(); it++)
-          result |= (1UL << ((*it) % (8*sizeof(result))));
+        (*bits.dense) >>= shift;
+        normalize();
       }
       else
       {
-        for (int idx = 0; idx < count; idx++)
-          result |= (1UL << (get_value<OVERLAP>(idx) % (8*sizeof(result))));
+        unsigned next = 0;
+        for (unsigned idx = 0; idx < count; idx++)
+          if (bits.sparse[idx] >= shift)
+            bits.sparse[next++] = bits.sparse[idx] - shift;
+        count = next;
       }
+      return *this;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline uint64_t SparseBitMask<BITMASK,MAX,CNT>::get_hash_key(void) const
+    //-------------------------------------------------------------------------
+    {
+      if (is_dense())
+        return bits.dense->get_hash_key();
+      // Same as or-ing together all the words of the dense mask
+      uint64_t result = 0;
+      for (unsigned idx = 0; idx < count; idx++)
+        result |= (1ULL << (bits.sparse[idx] & 0x3F));
       return result;
     }
 
     //-------------------------------------------------------------------------
-    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline void CompoundBitMask<BITMASK,MAX,WORDS>::serialize(Serializer &rez) 
-                                                                          const
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline void SparseBitMask<BITMASK,MAX,CNT>::serialize(
+                                                        Serializer &rez) const
     //-------------------------------------------------------------------------
     {
-      int count = get_count();
       rez.serialize(count);
-      if (count == DENSE_CNT)
-        get_dense()->serialize(rez); 
-      else if (count == SPARSE_CNT)
-      {
-        SparseSet *sparse = get_sparse();
-        rez.serialize<size_t>(sparse->size());
-        for (SparseSet::const_iterator it = sparse->begin();
-              it != sparse->end(); it++)
-          rez.serialize(*it);
-      }
+      if (is_dense())
+        rez.serialize(*bits.dense);
       else
-      {
-        // Just serialize all the words, won't be that hard
-        for (unsigned idx = 0; idx < WORDS; idx++)
-          rez.serialize(bits[idx]);
-      }
+        for (unsigned idx = 0; idx < count; idx++)
+          rez.serialize(bits.sparse[idx]);
     }
 
     //-------------------------------------------------------------------------
-    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline void CompoundBitMask<BITMASK,MAX,WORDS>::deserialize(
-                                                           Deserializer &derez)
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline void SparseBitMask<BITMASK,MAX,CNT>::deserialize(
+                                                          Deserializer &derez)
     //-------------------------------------------------------------------------
     {
-      int current_count = get_count();
-      int next_count;
-      derez.deserialize(next_count);
-      if (next_count == DENSE_CNT)
-      {
-        BITMASK *dense;
-        if (current_count != DENSE_CNT)
-        {
-          if (current_count == SPARSE_CNT)
-            delete get_sparse();
-          set_count(DENSE_CNT);
-          dense = new BITMASK();
-          set_dense(dense);
-        }
-        else
-          dense = get_dense();
-        dense->deserialize(derez);
-      }
-      else if (next_count == SPARSE_CNT)
+      clear();
+      uint16_t new_count;
+      derez.deserialize(new_count);
+      if (new_count == DENSE_CNT)
       {
-        SparseSet *sparse = new SparseSet();
-        if (current_count == DENSE_CNT)
-          delete get_dense();
-        size_t num_elements;
-        derez.deserialize(num_elements);
-        for (unsigned idx = 0; idx < num_elements; idx++)
-        {
-          int bit;
-          derez.deserialize(bit);
-          sparse->insert(bit);
-        }
-        set_count(SPARSE_CNT);
-        set_sparse(sparse);
+        bits.dense = new BITMASK();
+        derez.deserialize(*bits.dense);
       }
       else
-      {
-        if (current_count == DENSE_CNT)
-          delete get_dense();
-        else if (current_count == SPARSE_CNT)
-          delete get_sparse();
-        for (unsigned idx = 0; idx < WORDS; idx++)
-          derez.deserialize(bits[idx]);
-      }
+        for (unsigned idx = 0; idx < new_count; idx++)
+          derez.deserialize(bits.sparse[idx]);
+      count = new_count;
     }
 
     //-------------------------------------------------------------------------
-    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    inline char* CompoundBitMask<BITMASK,MAX,WORDS>::to_string(void) const
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline char* SparseBitMask<BITMASK,MAX,CNT>::to_string(void) const
     //-------------------------------------------------------------------------
     {
-      int count = get_count();
-      if (count == DENSE_CNT)
+      BITMASK scratch;
+      return dense_view(scratch).to_string();
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    /*static*/ inline int SparseBitMask<BITMASK,MAX,CNT>::pop_count(
+                                                   const SparseBitMask &mask)
+    //-------------------------------------------------------------------------
+    {
+      if (mask.is_dense())
+        return BITMASK::pop_count(*mask.bits.dense);
+      return mask.count;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline const BITMASK& SparseBitMask<BITMASK,MAX,CNT>::dense_view(
+                                                        BITMASK &scratch) const
+    //-------------------------------------------------------------------------
+    {
+      if (is_dense())
+        return *bits.dense;
+      scratch.clear();
+      for (unsigned idx = 0; idx < count; idx++)
+        scratch.set_bit(bits.sparse[idx]);
+      return scratch;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline BITMASK& SparseBitMask<BITMASK,MAX,CNT>::make_dense(void)
+    //-------------------------------------------------------------------------
+    {
+      if (!is_dense())
       {
-        return get_dense()->to_string(); 
+        BITMASK *dense = new BITMASK();
+        for (unsigned idx = 0; idx < count; idx++)
+          dense->set_bit(bits.sparse[idx]);
+        bits.dense = dense;
+        count = DENSE_CNT;
       }
-      else if (count == SPARSE_CNT)
+      return *bits.dense;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline void SparseBitMask<BITMASK,MAX,CNT>::normalize(void)
+    //-------------------------------------------------------------------------
+    {
+      if (!is_dense())
+        return;
+      if (BITMASK::pop_count(*bits.dense) > int(CNT))
+        return;
+      BITMASK *dense = bits.dense;
+      unsigned next = 0;
+      for (int bit = dense->find_first_set(); bit >= 0; 
+            bit = dense->find_next_set(bit+1))
+        bits.sparse[next++] = bit;
+      count = next;
+      delete dense;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline void SparseBitMask<BITMASK,MAX,CNT>::merge_sparse(
+                                   const SparseBitMask &rhs, MergeKind kind)
+    //-------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(!is_dense());
+      assert(!rhs.is_dense());
+#endif
+      uint16_t merged[2*CNT];
+      unsigned num = 0, left = 0, right = 0;
+      while ((left < count) || (right < rhs.count))
       {
-        char *result = (char*)malloc(1024*sizeof(char));
-        sprintf(result,"Compound Sparse %d:", count);
-        SparseSet *sparse = get_sparse();
-        for (SparseSet::const_iterator it = sparse->begin();
-              it != sparse->end(); it++)
+        if ((right == rhs.count) || 
+            ((left < count) && (bits.sparse[left] < rhs.bits.sparse[right])))
         {
-          char temp[64];
-          sprintf(temp, " %d", (*it));
-          strcat(result,temp);
+          // Only in this mask
+          if (kind != MERGE_INTERSECT)
+            merged[num++] = bits.sparse[left];
+          left++;
         }
-        return result;
-      }
-      else
-      {
-        char *result = (char*)malloc(1024*sizeof(char));
-        sprintf(result,"Compound Base %d:", count);
-        for (int idx = 0; idx < count; idx++)
+        else if ((left == count) || 
+                 (rhs.bits.sparse[right] < bits.sparse[left]))
         {
-          char temp[64];
-          sprintf(temp, " %d", get_value<OVERLAP>(idx));
-          strcat(result,temp);
+          // Only in the rhs mask
+          if ((kind == MERGE_UNION) || (kind == MERGE_SYMMETRIC))
+            merged[num++] = rhs.bits.sparse[right];
+          right++;
+        }
+        else
+        {
+          // In both masks
+          if ((kind == MERGE_UNION) || (kind == MERGE_INTERSECT))
+            merged[num++] = bits.sparse[left];
+          left++;
+          right++;
         }
-        return result;
       }
+      assign_indexes(merged, num);
     }
 
     //-------------------------------------------------------------------------
-    template<typename BITMASK, unsigned int MAX, unsigned int WORDS>
-    /*static*/ inline int CompoundBitMask<BITMASK,MAX,WORDS>::pop_count(
-                                                   const CompoundBitMask &mask)
+    template<typename BITMASK, unsigned int MAX, unsigned int CNT>
+    inline void SparseBitMask<BITMASK,MAX,CNT>::assign_indexes(
+                                     const uint16_t *indexes, unsigned num)
     //-------------------------------------------------------------------------
     {
-      int count = mask.get_count();
-      if (count == DENSE_CNT)
-        count = BITMASK::pop_count(*mask.get_dense());
-      else if (count == SPARSE_CNT)
-        count = mask.get_sparse()->size();
-      return count;
+#ifdef DEBUG_LEGION
+      assert(!is_dense());
+#endif
+      if (num > CNT)
+      {
+        BITMASK *dense = new BITMASK();
+        for (unsigned idx = 0; idx < num; idx++)
+          dense->set_bit(indexes[idx]);
+        bits.dense = dense;
+        count = DENSE_CNT;
+      }
+      else
+      {
+        for (unsigned idx = 0; idx < num; idx++)
+          bits.sparse[idx] = indexes[idx];
+        count = num;
+      }
     }
 
     //-------------------------------------------------------------------------
@@ -8172,480 +10994,978 @@ namespace Legion {
             comp[idx] = sheep_and_goats(comp[idx],comp[i]);
         }
       }
-      dirty = false;
+      dirty = false;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename BITMASK, unsigned LOG2MAX>
+    void BitPermutation<BITMASK,LOG2MAX>::test_identity(void)
+    //-------------------------------------------------------------------------
+    {
+      // If we're still the identity then we're done
+      if (identity)
+        return;
+      for (unsigned idx = 0; idx < (1 << LOG2MAX); idx++)
+      {
+        unsigned src = 1 << idx;
+        unsigned dst = get_dst(src);
+        if (src != dst)
+        {
+          identity = false;
+          return;
+        }
+      }
+      identity = true;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename IT, typename DT, bool BIDIR>
+    IntegerSet<IT,DT,BIDIR>::IntegerSet(void)
+      : representation(SPARSE_REPRESENTATION)
+    //-------------------------------------------------------------------------
+    {
+      set_ptr.sparse = new typename std::set<IT>();
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename IT, typename DT, bool BIDIR>
+    IntegerSet<IT,DT,BIDIR>::IntegerSet(const IntegerSet &rhs)
+      : representation(SPARSE_REPRESENTATION)
+    //-------------------------------------------------------------------------
+    {
+      copy_from(rhs);
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename IT, typename DT, bool BIDIR>
+    IntegerSet<IT,DT,BIDIR>::~IntegerSet(void)
+    //-------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(set_ptr.sparse != NULL);
+#endif
+      release();
+    }
+    
+    //-------------------------------------------------------------------------
+    template<typename IT, typename DT, bool BIDIR>
+    IntegerSet<IT,DT,BIDIR>& 
+                      IntegerSet<IT,DT,BIDIR>::operator=(const IntegerSet &rhs)
+    //-------------------------------------------------------------------------
+    {
+      if (this == &rhs)
+        return *this;
+      if (representation == rhs.representation)
+      {
+        // Reuse our storage if it already matches
+        switch (representation)
+        {
+          case SPARSE_REPRESENTATION:
+            {
+              *(set_ptr.sparse) = *(rhs.set_ptr.sparse);
+              break;
+            }
+          case RANGE_REPRESENTATION:
+            {
+              set_ptr.ranged->ranges = rhs.set_ptr.ranged->ranges;
+              break;
+            }
+          case DENSE_REPRESENTATION:
+            {
+              set_ptr.dense->set = rhs.set_ptr.dense->set;
+              break;
+            }
+        }
+      }
+      else
+      {
+        release();
+        copy_from(rhs);
+      }
+      return *this;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename IT, typename DT, bool BIDIR>
+    inline bool IntegerSet<IT,DT,BIDIR>::contains(IT index) const
+    //-------------------------------------------------------------------------
+    {
+      switch (representation)
+      {
+        case SPARSE_REPRESENTATION:
+          return (set_ptr.sparse->find(index) != set_ptr.sparse->end());
+        case RANGE_REPRESENTATION:
+          {
+            // Binary search for the last range starting at or before index
+            const std::vector<Range> &ranges = set_ptr.ranged->ranges;
+            size_t lo = 0, hi = ranges.size();
+            while (lo < hi)
+            {
+              const size_t mid = lo + (hi - lo) / 2;
+              if (ranges[mid].first <= index)
+                lo = mid + 1;
+              else
+                hi = mid;
+            }
+            return ((lo > 0) && (index <= ranges[lo-1].second));
+          }
+        case DENSE_REPRESENTATION:
+          return set_ptr.dense->set.is_set(index);
+      }
+      return false;
+    }
+    
+    //-------------------------------------------------------------------------
+    template<typename IT, typename DT, bool BIDIR>
+    inline void IntegerSet<IT,DT,BIDIR>::add(IT index)
+    //-------------------------------------------------------------------------
+    {
+      switch (representation)
+      {
+        case SPARSE_REPRESENTATION:
+          {
+            // Add it and see if it is too big
+            set_ptr.sparse->insert(index);
+            if (sizeof(DT) < (set_ptr.sparse->size() * 
+                              (sizeof(IT) + STL_SET_NODE_SIZE)))
+            {
+              // Count the runs to see if ranges would be smaller
+              size_t runs = 0;
+              IT previous = 0;
+              for (typename std::set<IT>::const_iterator it = 
+                    set_ptr.sparse->begin(); it != 
+                    set_ptr.sparse->end(); it++)
+              {
+                if ((runs == 0) || ((*it - previous) > 1))
+                  runs++;
+                previous = *it;
+              }
+              // Leave some headroom so we don't immediately go dense
+              if ((2 * runs * sizeof(Range)) <= sizeof(DT))
+                convert_to_ranges();
+              else
+                convert_to_dense();
+            }
+            break;
+          }
+        case RANGE_REPRESENTATION:
+          {
+            insert_range(set_ptr.ranged->ranges, index, index);
+            check_ranges();
+            break;
+          }
+        case DENSE_REPRESENTATION:
+          {
+            set_ptr.dense->set.set_bit(index);
+            break;
+          }
+      }
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename IT, typename DT, bool BIDIR>
+    inline void IntegerSet<IT,DT,BIDIR>::add_range(IT first, IT last)
+    //-------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(first <= last);
+#endif
+      if (representation == SPARSE_REPRESENTATION)
+      {
+        // A single value is no different than an add
+        if (first == last)
+        {
+          add(first);
+          return;
+        }
+        convert_to_ranges();
+      }
+      if (representation == RANGE_REPRESENTATION)
+      {
+        insert_range(set_ptr.ranged->ranges, first, last);
+        check_ranges();
+      }
+      else
+      {
+        for (IT value = first; value < last; value++)
+          set_ptr.dense->set.set_bit(value);
+        set_ptr.dense->set.set_bit(last);
+      }
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename IT, typename DT, bool BIDIR>
+    inline void IntegerSet<IT,DT,BIDIR>::remove(IT index)
+    //-------------------------------------------------------------------------
+    {
+      switch (representation)
+      {
+        case SPARSE_REPRESENTATION:
+          {
+            set_ptr.sparse->erase(index);
+            break;
+          }
+        case RANGE_REPRESENTATION:
+          {
+            remove_value(set_ptr.ranged->ranges, index);
+            check_ranges();
+            break;
+          }
+        case DENSE_REPRESENTATION:
+          {
+            set_ptr.dense->set.unset_bit(index); 
+            // Only check for flip back if we are bi-directional
+            if (BIDIR)
+            {
+              IT count = DT::pop_count(set_ptr.dense->set);
+              if ((count * (sizeof(IT) + STL_SET_NODE_SIZE)) < sizeof(DT))
+                convert_to_sparse();
+            }
+            break;
+          }
+      }
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename IT, typename DT, bool BIDIR>
+    inline IT IntegerSet<IT,DT,BIDIR>::find_first_set(void) const
+    //-------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(!empty());
+#endif
+      switch (representation)
+      {
+        case SPARSE_REPRESENTATION:
+          return *(set_ptr.sparse->begin());
+        case RANGE_REPRESENTATION:
+          return set_ptr.ranged->ranges.front().first;
+        case DENSE_REPRESENTATION:
+          return set_ptr.dense->set.find_first_set();
+      }
+      return 0;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename IT, typename DT, bool BIDIR>
+    inline IT IntegerSet<IT,DT,BIDIR>::find_index_set(int index) const
+    //-------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(index >= 0);
+      assert(index < int(size()));
+#endif
+      if (index == 0)
+        return find_first_set();
+      switch (representation)
+      {
+        case SPARSE_REPRESENTATION:
+          {
+            typename std::set<IT>::const_iterator it = 
+              set_ptr.sparse->begin();
+            while (index > 0)
+            {
+              it++;
+              index--;
+            }
+            return *it;
+          }
+        case RANGE_REPRESENTATION:
+          {
+            for (typename std::vector<Range>::const_iterator it = 
+                  set_ptr.ranged->ranges.begin(); it !=
+                  set_ptr.ranged->ranges.end(); it++)
+            {
+              const size_t extent = size_t(it->second - it->first) + 1;
+              if (size_t(index) < extent)
+                return (it->first + index);
+              index -= extent;
+            }
+            assert(false);
+            break;
+          }
+        case DENSE_REPRESENTATION:
+          return set_ptr.dense->set.find_index_set(index);
+      }
+      return 0;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename IT, typename DT, bool BIDIR> template<typename FUNCTOR>
+    inline void IntegerSet<IT,DT,BIDIR>::map(FUNCTOR &functor) const
+    //-------------------------------------------------------------------------
+    {
+      switch (representation)
+      {
+        case SPARSE_REPRESENTATION:
+          {
+            for (typename std::set<IT>::const_iterator it = 
+                  set_ptr.sparse->begin(); it != set_ptr.sparse->end(); it++)
+            {
+              functor.apply(*it);
+            }
+            break;
+          }
+        case RANGE_REPRESENTATION:
+          {
+            for (typename std::vector<Range>::const_iterator it = 
+                  set_ptr.ranged->ranges.begin(); it !=
+                  set_ptr.ranged->ranges.end(); it++)
+            {
+              for (IT value = it->first; value < it->second; value++)
+                functor.apply(value);
+              functor.apply(it->second);
+            }
+            break;
+          }
+        case DENSE_REPRESENTATION:
+          {
+            for (IT idx = 0; idx < DT::ELEMENTS; idx++)
+            {
+              if (set_ptr.dense->set[idx])
+              {
+                IT value = idx * DT::ELEMENT_SIZE;
+                for (IT i = 0; i < DT::ELEMENT_SIZE; i++, value++)
+                {
+                  if (set_ptr.dense->set.is_set(value))
+                    functor.apply(value);
+                }
+              }
+            }
+            break;
+          }
+      }
     }
 
     //-------------------------------------------------------------------------
-    template<typename BITMASK, unsigned LOG2MAX>
-    void BitPermutation<BITMASK,LOG2MAX>::test_identity(void)
+    template<typename IT, typename DT, bool BIDIR>
+    inline void IntegerSet<IT,DT,BIDIR>::serialize(Serializer &rez) const
     //-------------------------------------------------------------------------
     {
-      // If we're still the identity then we're done
-      if (identity)
-        return;
-      for (unsigned idx = 0; idx < (1 << LOG2MAX); idx++)
+      rez.serialize(representation);
+      switch (representation)
       {
-        unsigned src = 1 << idx;
-        unsigned dst = get_dst(src);
-        if (src != dst)
-        {
-          identity = false;
-          return;
-        }
+        case SPARSE_REPRESENTATION:
+          {
+            rez.serialize<size_t>(set_ptr.sparse->size());
+            for (typename std::set<IT>::const_iterator it = 
+                  set_ptr.sparse->begin(); it != set_ptr.sparse->end(); it++)
+            {
+              rez.serialize(*it);
+            }
+            break;
+          }
+        case RANGE_REPRESENTATION:
+          {
+            rez.serialize<size_t>(set_ptr.ranged->ranges.size());
+            for (typename std::vector<Range>::const_iterator it = 
+                  set_ptr.ranged->ranges.begin(); it !=
+                  set_ptr.ranged->ranges.end(); it++)
+            {
+              rez.serialize(it->first);
+              rez.serialize(it->second);
+            }
+            break;
+          }
+        case DENSE_REPRESENTATION:
+          {
+            rez.serialize(set_ptr.dense->set);
+            break;
+          }
       }
-      identity = true;
     }
 
     //-------------------------------------------------------------------------
     template<typename IT, typename DT, bool BIDIR>
-    IntegerSet<IT,DT,BIDIR>::IntegerSet(void)
-      : sparse(true)
-    //-------------------------------------------------------------------------
-    {
-      set_ptr.sparse = new typename std::set<IT>();
-    }
-
-    //-------------------------------------------------------------------------
-    template<typename IT, typename DT, bool BIDIR>
-    IntegerSet<IT,DT,BIDIR>::IntegerSet(const IntegerSet &rhs)
-      : sparse(rhs.sparse)
+    inline void IntegerSet<IT,DT,BIDIR>::deserialize(Deserializer &derez)
     //-------------------------------------------------------------------------
     {
-      if (rhs.sparse)
+      Representation rep;
+      derez.deserialize(rep);
+      // If it doesn't match then replace the old one
+      if (rep != representation)
       {
-        set_ptr.sparse = new typename std::set<IT>();
-        *(set_ptr.sparse) = *(rhs.set_ptr.sparse);
+        release();
+        representation = rep;
+        switch (representation)
+        {
+          case SPARSE_REPRESENTATION:
+            {
+              set_ptr.sparse = new typename std::set<IT>();
+              break;
+            }
+          case RANGE_REPRESENTATION:
+            {
+              set_ptr.ranged = new RangeSet();
+              break;
+            }
+          case DENSE_REPRESENTATION:
+            {
+              set_ptr.dense = new DenseSet();
+              break;
+            }
+        }
       }
-      else
+      switch (representation)
       {
-        set_ptr.dense = new DenseSet();
-        set_ptr.dense->set = rhs.set_ptr.dense->set;
+        case SPARSE_REPRESENTATION:
+          {
+            set_ptr.sparse->clear();
+            size_t num_elements;
+            derez.deserialize<size_t>(num_elements);
+            for (unsigned idx = 0; idx < num_elements; idx++)
+            {
+              IT element;
+              derez.deserialize(element);
+              set_ptr.sparse->insert(element);
+            }
+            break;
+          }
+        case RANGE_REPRESENTATION:
+          {
+            size_t num_ranges;
+            derez.deserialize<size_t>(num_ranges);
+            set_ptr.ranged->ranges.resize(num_ranges);
+            for (unsigned idx = 0; idx < num_ranges; idx++)
+            {
+              derez.deserialize(set_ptr.ranged->ranges[idx].first);
+              derez.deserialize(set_ptr.ranged->ranges[idx].second);
+            }
+            break;
+          }
+        case DENSE_REPRESENTATION:
+          {
+            set_ptr.dense->set.clear();
+            derez.deserialize(set_ptr.dense->set);
+            break;
+          }
       }
     }
 
     //-------------------------------------------------------------------------
     template<typename IT, typename DT, bool BIDIR>
-    IntegerSet<IT,DT,BIDIR>::~IntegerSet(void)
+    inline IntegerSet<IT,DT,BIDIR>
+                IntegerSet<IT,DT,BIDIR>::operator|(const IntegerSet &rhs) const
     //-------------------------------------------------------------------------
     {
-#ifdef DEBUG_LEGION
-      assert(set_ptr.sparse != NULL);
-#endif
-      if (sparse)
-        delete set_ptr.sparse;
-      else
-        delete set_ptr.dense;
+      // Start from whichever side is not sparse so the other
+      // side gets folded into the more compact representation
+      if ((representation == SPARSE_REPRESENTATION) &&
+          (rhs.representation != SPARSE_REPRESENTATION))
+      {
+        IntegerSet<IT,DT,BIDIR> result(rhs);
+        result |= *this;
+        return result;
+      }
+      IntegerSet<IT,DT,BIDIR> result(*this);
+      result |= rhs;
+      return result;
     }
-    
+
     //-------------------------------------------------------------------------
     template<typename IT, typename DT, bool BIDIR>
-    IntegerSet<IT,DT,BIDIR>& 
-                      IntegerSet<IT,DT,BIDIR>::operator=(const IntegerSet &rhs)
+    inline IntegerSet<IT,DT,BIDIR>
+                IntegerSet<IT,DT,BIDIR>::operator&(const IntegerSet &rhs) const
     //-------------------------------------------------------------------------
     {
-      if (rhs.sparse)
+      // Do the fast cases here
+      if ((representation == DENSE_REPRESENTATION) && 
+          (rhs.representation == DENSE_REPRESENTATION))
       {
-        if (!sparse)
-        {
-          delete set_ptr.dense;
-          set_ptr.sparse = new typename std::set<IT>();
-        }
-        else
-          set_ptr.sparse->clear();
-        *(set_ptr.sparse) = *(rhs.set_ptr.sparse);
+        IntegerSet<IT,DT,BIDIR> result(*this);
+        result.set_ptr.dense->set &= rhs.set_ptr.dense->set;
+        return result;
+      }
+      if ((representation == RANGE_REPRESENTATION) &&
+          (rhs.representation == RANGE_REPRESENTATION))
+      {
+        IntegerSet<IT,DT,BIDIR> result;
+        result.convert_to_ranges();
+        intersect_ranges(set_ptr.ranged->ranges, rhs.set_ptr.ranged->ranges,
+                         result.set_ptr.ranged->ranges);
+        result.check_ranges();
+        return result;
+      }
+      // Walk the sparse side if there is one since it is the smallest
+      IntegerSet<IT,DT,BIDIR> result;
+      if (representation == SPARSE_REPRESENTATION)
+      {
+        IntersectFunctor functor(result, rhs);
+        this->map(functor);
       }
       else
       {
-        if (sparse)
-        {
-          delete set_ptr.sparse;
-          set_ptr.dense = new DenseSet();
-        }
-        else
-          set_ptr.dense->set.clear();
-        set_ptr.dense->set = rhs.set_ptr.dense->set;
+        IntersectFunctor functor(result, *this);
+        rhs.map(functor);
       }
-      sparse = rhs.sparse;
-      return *this;
+      return result;
     }
 
     //-------------------------------------------------------------------------
     template<typename IT, typename DT, bool BIDIR>
-    inline bool IntegerSet<IT,DT,BIDIR>::contains(IT index) const
+    inline IntegerSet<IT,DT,BIDIR>
+                IntegerSet<IT,DT,BIDIR>::operator-(const IntegerSet &rhs) const
     //-------------------------------------------------------------------------
     {
-      if (sparse)
-        return (set_ptr.sparse->find(index) != set_ptr.sparse->end());
-      else
-        return set_ptr.dense->set.is_set(index);
+      IntegerSet<IT,DT,BIDIR> result(*this);
+      result -= rhs;
+      return result;
     }
-    
+
     //-------------------------------------------------------------------------
     template<typename IT, typename DT, bool BIDIR>
-    inline void IntegerSet<IT,DT,BIDIR>::add(IT index)
+    inline IntegerSet<IT,DT,BIDIR>&
+                     IntegerSet<IT,DT,BIDIR>::operator|=(const IntegerSet &rhs)
     //-------------------------------------------------------------------------
     {
-      if (sparse)
+      if (this == &rhs)
+        return *this;
+      switch (rhs.representation)
       {
-        // Add it and see if it is too big
-        set_ptr.sparse->insert(index);
-        if (sizeof(DT) < (set_ptr.sparse->size() * 
-                          (sizeof(IT) + STL_SET_NODE_SIZE)))
-        {
-          DenseSet *dense_set = new DenseSet();
-          for (typename std::set<IT>::const_iterator it = 
-                set_ptr.sparse->begin(); it != set_ptr.sparse->end(); it++)
+        case SPARSE_REPRESENTATION:
           {
-            dense_set->set.set_bit(*it);
+            UnionFunctor functor(*this);
+            rhs.map(functor);
+            break;
+          }
+        case RANGE_REPRESENTATION:
+          {
+            // Whole ranges at a time
+            for (typename std::vector<Range>::const_iterator it = 
+                  rhs.set_ptr.ranged->ranges.begin(); it !=
+                  rhs.set_ptr.ranged->ranges.end(); it++)
+              add_range(it->first, it->second);
+            break;
+          }
+        case DENSE_REPRESENTATION:
+          {
+            // Go dense ourselves so we can use the vector union
+            if (representation != DENSE_REPRESENTATION)
+              convert_to_dense();
+            set_ptr.dense->set |= rhs.set_ptr.dense->set;
+            break;
           }
-          // Delete the sparse set
-          delete set_ptr.sparse;
-          set_ptr.dense = dense_set;
-          sparse = false;
-        }
       }
-      else
-        set_ptr.dense->set.set_bit(index);
+      return *this;
     }
 
     //-------------------------------------------------------------------------
     template<typename IT, typename DT, bool BIDIR>
-    inline void IntegerSet<IT,DT,BIDIR>::remove(IT index)
+    inline IntegerSet<IT,DT,BIDIR>&
+                     IntegerSet<IT,DT,BIDIR>::operator&=(const IntegerSet &rhs)
     //-------------------------------------------------------------------------
     {
-      if (!sparse)
+      // Do the fast case
+      if ((representation == DENSE_REPRESENTATION) && 
+          (rhs.representation == DENSE_REPRESENTATION))
       {
-        set_ptr.dense->set.unset_bit(index); 
-        // Only check for flip back if we are bi-directional
-        if (BIDIR)
-        {
-          IT count = DT::pop_count(set_ptr.dense->set);
-          if ((count * (sizeof(IT) + STL_SET_NODE_SIZE)) < sizeof(DT))
-          {
-            typename std::set<IT> *sparse_set = new typename std::set<IT>();
-            for (IT idx = 0; idx < DT::ELEMENTS; idx++)
-            {
-              if (set_ptr.dense->set[idx])
-              {
-                for (IT i = 0; i < DT::ELEMENT_SIZE; i++)
-                {
-                  IT value = idx * DT::ELEMENT_SIZE + i;
-                  if (set_ptr.dense->set.is_set(value))
-                    sparse_set->insert(value);
-                }
-              }
-            }
-            // Delete the dense set
-            delete set_ptr.dense;
-            set_ptr.sparse = sparse_set;
-            sparse = true;
-          }
-        }
+        set_ptr.dense->set &= rhs.set_ptr.dense->set;
+        return *this;
       }
-      else
-        set_ptr.sparse->erase(index);
+      // Can't overwrite ourselves
+      IntegerSet<IT,DT,BIDIR> temp = (*this) & rhs;
+      swap(temp);
+      return *this;
     }
 
     //-------------------------------------------------------------------------
     template<typename IT, typename DT, bool BIDIR>
-    inline IT IntegerSet<IT,DT,BIDIR>::find_first_set(void) const
+    inline IntegerSet<IT,DT,BIDIR>&
+                     IntegerSet<IT,DT,BIDIR>::operator-=(const IntegerSet &rhs)
     //-------------------------------------------------------------------------
     {
-      if (sparse)
+      // Do the fast cases
+      if ((representation == DENSE_REPRESENTATION) && 
+          (rhs.representation == DENSE_REPRESENTATION))
       {
-#ifdef DEBUG_LEGION
-        assert(!set_ptr.sparse->empty());
-#endif
-        return *(set_ptr.sparse->begin());
+        set_ptr.dense->set -= rhs.set_ptr.dense->set;
+        return *this;
       }
-      else
+      if ((representation == RANGE_REPRESENTATION) &&
+          (rhs.representation == RANGE_REPRESENTATION))
       {
-#ifdef DEBUG_LEGION
-        assert(!!(set_ptr.dense->set));
-#endif
-        return set_ptr.dense->set.find_first_set();
+        std::vector<Range> result;
+        subtract_ranges(set_ptr.ranged->ranges, 
+                        rhs.set_ptr.ranged->ranges, result);
+        set_ptr.ranged->ranges.swap(result);
+        check_ranges();
+        return *this;
       }
-    }
-
-    //-------------------------------------------------------------------------
-    template<typename IT, typename DT, bool BIDIR>
-    inline IT IntegerSet<IT,DT,BIDIR>::find_index_set(int index) const
-    //-------------------------------------------------------------------------
-    {
-#ifdef DEBUG_LEGION
-      assert(index >= 0);
-      assert(index < int(size()));
-#endif
-      if (index == 0)
-        return find_first_set();
-      if (sparse)
+      // Walk whichever side is sparse since it is the smallest
+      if (representation == SPARSE_REPRESENTATION)
       {
-        typename std::set<IT>::const_iterator it = set_ptr.sparse->begin();
-        while (index > 0)
+        typename std::set<IT>::iterator it = set_ptr.sparse->begin();
+        while (it != set_ptr.sparse->end())
         {
-          it++;
-          index--;
+          if (rhs.contains(*it))
+            set_ptr.sparse->erase(it++);
+          else
+            it++;
         }
-        return *it;
       }
       else
-        return set_ptr.dense->set.find_index_set(index);
+      {
+        DifferenceFunctor functor(*this);
+        rhs.map(functor);
+      }
+      return *this;
     }
 
     //-------------------------------------------------------------------------
-    template<typename IT, typename DT, bool BIDIR> template<typename FUNCTOR>
-    inline void IntegerSet<IT,DT,BIDIR>::map(FUNCTOR &functor) const
+    template<typename IT, typename DT, bool BIDIR>
+    inline bool IntegerSet<IT,DT,BIDIR>::operator!(void) const
     //-------------------------------------------------------------------------
     {
-      if (sparse)
-      {
-        for (typename std::set<IT>::const_iterator it = 
-              set_ptr.sparse->begin(); it != set_ptr.sparse->end(); it++)
-        {
-          functor.apply(*it);
-        }
-      }
-      else
+      switch (representation)
       {
-        for (IT idx = 0; idx < DT::ELEMENTS; idx++)
-        {
-          if (set_ptr.dense->set[idx])
-          {
-            IT value = idx * DT::ELEMENT_SIZE;
-            for (IT i = 0; i < DT::ELEMENT_SIZE; i++, value++)
-            {
-              if (set_ptr.dense->set.is_set(value))
-                functor.apply(value);
-            }
-          }
-        }
+        case SPARSE_REPRESENTATION:
+          return set_ptr.sparse->empty();
+        case RANGE_REPRESENTATION:
+          return set_ptr.ranged->ranges.empty();
+        case DENSE_REPRESENTATION:
+          return !(set_ptr.dense->set);
       }
+      return true;
     }
 
     //-------------------------------------------------------------------------
     template<typename IT, typename DT, bool BIDIR>
-    inline void IntegerSet<IT,DT,BIDIR>::serialize(Serializer &rez) const
+    inline size_t IntegerSet<IT,DT,BIDIR>::size(void) const
     //-------------------------------------------------------------------------
     {
-      rez.serialize<bool>(sparse);
-      if (sparse)
+      switch (representation)
       {
-        rez.serialize<size_t>(set_ptr.sparse->size());
-        for (typename std::set<IT>::const_iterator it = 
-              set_ptr.sparse->begin(); it != set_ptr.sparse->end(); it++)
-        {
-          rez.serialize(*it);
-        }
+        case SPARSE_REPRESENTATION:
+          return set_ptr.sparse->size();
+        case RANGE_REPRESENTATION:
+          {
+            size_t result = 0;
+            for (typename std::vector<Range>::const_iterator it = 
+                  set_ptr.ranged->ranges.begin(); it !=
+                  set_ptr.ranged->ranges.end(); it++)
+              result += size_t(it->second - it->first) + 1;
+            return result;
+          }
+        case DENSE_REPRESENTATION:
+          return set_ptr.dense->set.pop_count(set_ptr.dense->set);
       }
-      else
-        rez.serialize(set_ptr.dense->set);
+      return 0;
     }
 
     //-------------------------------------------------------------------------
     template<typename IT, typename DT, bool BIDIR>
-    inline void IntegerSet<IT,DT,BIDIR>::deserialize(Deserializer &derez)
+    inline void IntegerSet<IT,DT,BIDIR>::clear(void)
     //-------------------------------------------------------------------------
     {
-      bool is_sparse;
-      derez.deserialize<bool>(is_sparse);
-      if (is_sparse)
-      {
-        // If it doesn't match then replace the old one
-        if (!sparse)
-        {
-          delete set_ptr.dense;
-          set_ptr.sparse = new typename std::set<IT>();
-        }
-        else
-          set_ptr.sparse->clear();
-        size_t num_elements;
-        derez.deserialize<size_t>(num_elements);
-        for (unsigned idx = 0; idx < num_elements; idx++)
-        {
-          IT element;
-          derez.deserialize(element);
-          set_ptr.sparse->insert(element);
-        }
-      }
-      else
+      // always switch back to set on a clear
+      if (representation != SPARSE_REPRESENTATION)
       {
-        // If it doesn't match then replace the old one
-        if (sparse)
-        {
-          delete set_ptr.sparse;
-          set_ptr.dense = new DenseSet();
-        }
-        else
-          set_ptr.dense->set.clear();
-        derez.deserialize(set_ptr.dense->set);
-      }
-      sparse = is_sparse;
+        release();
+        set_ptr.sparse = new typename std::set<IT>();
+        representation = SPARSE_REPRESENTATION;
+      } else
+	set_ptr.sparse->clear();
     }
 
     //-------------------------------------------------------------------------
     template<typename IT, typename DT, bool BIDIR>
-    inline IntegerSet<IT,DT,BIDIR>
-                IntegerSet<IT,DT,BIDIR>::operator|(const IntegerSet &rhs) const
+    inline IntegerSet<IT,DT,BIDIR>& 
+                                 IntegerSet<IT,DT,BIDIR>::swap(IntegerSet &rhs)
     //-------------------------------------------------------------------------
     {
-      // Do the fast case here
-      if (!sparse)
-      {
-        IntegerSet<IT,DT,BIDIR> result(*this);
-        if (rhs.sparse)
-        {
-          UnionFunctor functor(result);
-          rhs.map(functor);
-        }
-        else
-          result.set_ptr.dense->set |= rhs.set_ptr.dense->set;
-        return result;
-      }
-      IntegerSet<IT,DT,BIDIR> result(rhs); 
-      UnionFunctor functor(result);
-      this->map(functor);
-      return result;
+      std::swap(representation, rhs.representation);
+      std::swap(set_ptr.sparse, rhs.set_ptr.sparse);
+      // don't do the others because it's a union and 
+      // that'd just swap things back
+      return *this;
     }
 
     //-------------------------------------------------------------------------
     template<typename IT, typename DT, bool BIDIR>
-    inline IntegerSet<IT,DT,BIDIR>
-                IntegerSet<IT,DT,BIDIR>::operator&(const IntegerSet &rhs) const
+    inline void IntegerSet<IT,DT,BIDIR>::release(void)
     //-------------------------------------------------------------------------
     {
-      // Do the fast case here
-      if (!sparse && !rhs.sparse)
+      switch (representation)
       {
-        IntegerSet<IT,DT,BIDIR> result(*this);
-        result.set_ptr.dense->set &= rhs.set_ptr.dense->set;
-        return result;
+        case SPARSE_REPRESENTATION:
+          {
+            delete set_ptr.sparse;
+            break;
+          }
+        case RANGE_REPRESENTATION:
+          {
+            delete set_ptr.ranged;
+            break;
+          }
+        case DENSE_REPRESENTATION:
+          {
+            delete set_ptr.dense;
+            break;
+          }
       }
-      IntegerSet<IT,DT,BIDIR> result;
-      IntersectFunctor functor(result, *this);
-      rhs.map(functor);
-      return result;
+      set_ptr.sparse = NULL;
     }
 
     //-------------------------------------------------------------------------
     template<typename IT, typename DT, bool BIDIR>
-    inline IntegerSet<IT,DT,BIDIR>
-                IntegerSet<IT,DT,BIDIR>::operator-(const IntegerSet &rhs) const
+    inline void IntegerSet<IT,DT,BIDIR>::copy_from(const IntegerSet &rhs)
     //-------------------------------------------------------------------------
     {
-      // Do the fast case here
-      if (!sparse && !rhs.sparse)
+      representation = rhs.representation;
+      switch (representation)
       {
-        IntegerSet<IT,DT,BIDIR> result(*this); 
-        result.set_ptr.dense->set -= rhs.set_ptr.dense->set;
-        return result;
+        case SPARSE_REPRESENTATION:
+          {
+            set_ptr.sparse = 
+              new typename std::set<IT>(*(rhs.set_ptr.sparse));
+            break;
+          }
+        case RANGE_REPRESENTATION:
+          {
+            set_ptr.ranged = new RangeSet(*(rhs.set_ptr.ranged));
+            break;
+          }
+        case DENSE_REPRESENTATION:
+          {
+            set_ptr.dense = new DenseSet();
+            set_ptr.dense->set = rhs.set_ptr.dense->set;
+            break;
+          }
       }
-      IntegerSet<IT,DT,BIDIR> result(*this);
-      DifferenceFunctor functor(result);
-      rhs.map(functor);
-      return result;
     }
 
     //-------------------------------------------------------------------------
     template<typename IT, typename DT, bool BIDIR>
-    inline IntegerSet<IT,DT,BIDIR>&
-                     IntegerSet<IT,DT,BIDIR>::operator|=(const IntegerSet &rhs)
+    inline void IntegerSet<IT,DT,BIDIR>::convert_to_dense(void)
     //-------------------------------------------------------------------------
     {
-      // Do the fast case here
-      if (!sparse && !rhs.sparse)
+#ifdef DEBUG_LEGION
+      assert(representation != DENSE_REPRESENTATION);
+#endif
+      DenseSet *dense_set = new DenseSet();
+      if (representation == SPARSE_REPRESENTATION)
       {
-        set_ptr.dense->set |= rhs.set_ptr.dense->set;
-        return *this;
+        for (typename std::set<IT>::const_iterator it = 
+              set_ptr.sparse->begin(); it != set_ptr.sparse->end(); it++)
+          dense_set->set.set_bit(*it);
       }
-      UnionFunctor functor(*this);
-      rhs.map(functor);
-      return *this;
+      else
+      {
+        for (typename std::vector<Range>::const_iterator it = 
+              set_ptr.ranged->ranges.begin(); it !=
+              set_ptr.ranged->ranges.end(); it++)
+        {
+          for (IT value = it->first; value < it->second; value++)
+            dense_set->set.set_bit(value);
+          dense_set->set.set_bit(it->second);
+        }
+      }
+      release();
+      set_ptr.dense = dense_set;
+      representation = DENSE_REPRESENTATION;
     }
 
     //-------------------------------------------------------------------------
     template<typename IT, typename DT, bool BIDIR>
-    inline IntegerSet<IT,DT,BIDIR>&
-                     IntegerSet<IT,DT,BIDIR>::operator&=(const IntegerSet &rhs)
+    inline void IntegerSet<IT,DT,BIDIR>::convert_to_sparse(void)
     //-------------------------------------------------------------------------
     {
-      // Do the fast case
-      if (!sparse && !rhs.sparse)
+#ifdef DEBUG_LEGION
+      assert(representation != SPARSE_REPRESENTATION);
+#endif
+      typename std::set<IT> *sparse_set = new typename std::set<IT>();
+      if (representation == RANGE_REPRESENTATION)
       {
-        set_ptr.dense->set &= rhs.set_ptr.dense->set;
-        return *this;
+        for (typename std::vector<Range>::const_iterator it = 
+              set_ptr.ranged->ranges.begin(); it !=
+              set_ptr.ranged->ranges.end(); it++)
+        {
+          for (IT value = it->first; value < it->second; value++)
+            sparse_set->insert(value);
+          sparse_set->insert(it->second);
+        }
       }
-      // Can't overwrite ourselves
-      IntegerSet<IT,DT,BIDIR> temp;
-      IntersectFunctor functor(temp, *this);
-      rhs.map(functor);
-      (*this) = temp;
-      return *this;
+      else
+      {
+        for (IT idx = 0; idx < DT::ELEMENTS; idx++)
+        {
+          if (set_ptr.dense->set[idx])
+          {
+            for (IT i = 0; i < DT::ELEMENT_SIZE; i++)
+            {
+              IT value = idx * DT::ELEMENT_SIZE + i;
+              if (set_ptr.dense->set.is_set(value))
+                sparse_set->insert(value);
+            }
+          }
+        }
+      }
+      release();
+      set_ptr.sparse = sparse_set;
+      representation = SPARSE_REPRESENTATION;
     }
 
     //-------------------------------------------------------------------------
     template<typename IT, typename DT, bool BIDIR>
-    inline IntegerSet<IT,DT,BIDIR>&
-                     IntegerSet<IT,DT,BIDIR>::operator-=(const IntegerSet &rhs)
+    inline void IntegerSet<IT,DT,BIDIR>::convert_to_ranges(void)
     //-------------------------------------------------------------------------
     {
-      // Do the fast case
-      if (!sparse && !rhs.sparse)
+#ifdef DEBUG_LEGION
+      assert(representation == SPARSE_REPRESENTATION);
+#endif
+      RangeSet *range_set = new RangeSet();
+      // The set is sorted so we only ever extend the last range
+      for (typename std::set<IT>::const_iterator it = 
+            set_ptr.sparse->begin(); it != set_ptr.sparse->end(); it++)
       {
-        set_ptr.dense->set -= rhs.set_ptr.dense->set;
-        return *this;
+        if (range_set->ranges.empty() || 
+            ((*it - range_set->ranges.back().second) > 1))
+          range_set->ranges.push_back(Range(*it, *it));
+        else
+          range_set->ranges.back().second = *it;
       }
-      DifferenceFunctor functor(*this);
-      rhs.map(functor);
-      return *this;
+      release();
+      set_ptr.ranged = range_set;
+      representation = RANGE_REPRESENTATION;
     }
 
     //-------------------------------------------------------------------------
     template<typename IT, typename DT, bool BIDIR>
-    inline bool IntegerSet<IT,DT,BIDIR>::operator!(void) const
+    inline void IntegerSet<IT,DT,BIDIR>::check_ranges(void)
     //-------------------------------------------------------------------------
     {
-      if (sparse)
-        return set_ptr.sparse->empty();
-      else
-        return !(set_ptr.dense->set);
+#ifdef DEBUG_LEGION
+      assert(representation == RANGE_REPRESENTATION);
+#endif
+      // Too fragmented to be worth it so go dense
+      if (sizeof(DT) < (set_ptr.ranged->ranges.size() * sizeof(Range)))
+        convert_to_dense();
+      else if (BIDIR && (set_ptr.ranged->ranges.size() > 1) &&
+          ((size() * (sizeof(IT) + STL_SET_NODE_SIZE)) < 
+           (set_ptr.ranged->ranges.size() * sizeof(Range))))
+        convert_to_sparse();
     }
 
     //-------------------------------------------------------------------------
     template<typename IT, typename DT, bool BIDIR>
-    inline size_t IntegerSet<IT,DT,BIDIR>::size(void) const
+    /*static*/ inline void IntegerSet<IT,DT,BIDIR>::insert_range(
+                            std::vector<Range> &ranges, IT first, IT last)
     //-------------------------------------------------------------------------
     {
-      if (sparse)
-        return set_ptr.sparse->size();
-      else
-        return set_ptr.dense->set.pop_count(set_ptr.dense->set);
+      // Skip any ranges that end before this one and are not adjacent
+      typename std::vector<Range>::iterator it = ranges.begin();
+      while ((it != ranges.end()) && (it->second < first) &&
+             ((first - it->second) > 1))
+        it++;
+      if ((it == ranges.end()) || 
+          ((last < it->first) && ((it->first - last) > 1)))
+      {
+        ranges.insert(it, Range(first, last));
+        return;
+      }
+      // Overlapping or adjacent so merge into this range
+      if (first < it->first)
+        it->first = first;
+      if (it->second < last)
+        it->second = last;
+      // Absorb any following ranges that we now touch
+      typename std::vector<Range>::iterator next = it + 1;
+      while ((next != ranges.end()) && ((next->first <= it->second) ||
+             ((next->first - it->second) == 1)))
+      {
+        if (it->second < next->second)
+          it->second = next->second;
+        next++;
+      }
+      ranges.erase(it + 1, next);
     }
 
     //-------------------------------------------------------------------------
     template<typename IT, typename DT, bool BIDIR>
-    inline void IntegerSet<IT,DT,BIDIR>::clear(void)
+    /*static*/ inline void IntegerSet<IT,DT,BIDIR>::remove_value(
+                                        std::vector<Range> &ranges, IT index)
     //-------------------------------------------------------------------------
     {
-      // always switch back to set on a clear
-      if (!sparse)
+      for (typename std::vector<Range>::iterator it = 
+            ranges.begin(); it != ranges.end(); it++)
       {
-	delete set_ptr.dense;
-	set_ptr.sparse = new typename std::set<IT>();
-	sparse = true;
-      } else
-	set_ptr.sparse->clear();
+        if (index < it->first)
+          return;
+        if (it->second < index)
+          continue;
+        if (it->first == it->second)
+          ranges.erase(it);
+        else if (index == it->first)
+          it->first++;
+        else if (index == it->second)
+          it->second--;
+        else
+        {
+          // Split the range in two
+          const Range upper(index + 1, it->second);
+          it->second = index - 1;
+          ranges.insert(it + 1, upper);
+        }
+        return;
+      }
     }
 
     //-------------------------------------------------------------------------
     template<typename IT, typename DT, bool BIDIR>
-    inline IntegerSet<IT,DT,BIDIR>& 
-                                 IntegerSet<IT,DT,BIDIR>::swap(IntegerSet &rhs)
+    /*static*/ inline void IntegerSet<IT,DT,BIDIR>::intersect_ranges(
+                                            const std::vector<Range> &lhs,
+                                            const std::vector<Range> &rhs,
+                                            std::vector<Range> &result)
+    //-------------------------------------------------------------------------
+    {
+      typename std::vector<Range>::const_iterator left = lhs.begin();
+      typename std::vector<Range>::const_iterator right = rhs.begin();
+      while ((left != lhs.end()) && (right != rhs.end()))
+      {
+        const IT first = std::max(left->first, right->first);
+        const IT last = std::min(left->second, right->second);
+        if (first <= last)
+          result.push_back(Range(first, last));
+        // Advance whichever range ends first
+        if (left->second < right->second)
+          left++;
+        else
+          right++;
+      }
+    }
+
     //-------------------------------------------------------------------------
-    {
-      std::swap(sparse, rhs.sparse);
-      std::swap(set_ptr.sparse, rhs.set_ptr.sparse);
-      // don't do dense because it's a union and that'd just swap things back
-      return *this;
+    template<typename IT, typename DT, bool BIDIR>
+    /*static*/ inline void IntegerSet<IT,DT,BIDIR>::subtract_ranges(
+                                            const std::vector<Range> &lhs,
+                                            const std::vector<Range> &rhs,
+                                            std::vector<Range> &result)
+    //-------------------------------------------------------------------------
+    {
+      typename std::vector<Range>::const_iterator right = rhs.begin();
+      for (typename std::vector<Range>::const_iterator left = 
+            lhs.begin(); left != lhs.end(); left++)
+      {
+        IT current = left->first;
+        bool consumed = false;
+        // Skip subtracted ranges that end before this one starts
+        while ((right != rhs.end()) && (right->second < current))
+          right++;
+        while ((right != rhs.end()) && (right->first <= left->second))
+        {
+          if (current < right->first)
+            result.push_back(Range(current, right->first - 1));
+          if (left->second <= right->second)
+          {
+            consumed = true;
+            break;
+          }
+          current = right->second + 1;
+          right++;
+        }
+        if (!consumed)
+          result.push_back(Range(current, left->second));
+      }
     }
 
     //-------------------------------------------------------------------------
@@ -8712,10 +12032,11 @@ namespace Legion {
     size_t DynamicTable<ALLOCATOR>::max_entries(void) const
     //-------------------------------------------------------------------------
     {
-      if (!root)
+      NodeBase *n = __atomic_load_n(&root, __ATOMIC_ACQUIRE);
+      if (!n)
         return 0;
       size_t elems_addressable = 1 << ALLOCATOR::LEAF_BITS;
-      for (int i = 0; i < root->level; i++)
+      for (int i = 0; i < n->level; i++)
         elems_addressable <<= ALLOCATOR::INNER_BITS;
       return elems_addressable;
     }
@@ -8733,7 +12054,7 @@ namespace Legion {
 	elems_addressable <<= ALLOCATOR::INNER_BITS;
       }
 
-      NodeBase *n = root;
+      NodeBase *n = __atomic_load_n(&root, __ATOMIC_ACQUIRE);
       if (!n || (n->level < level_needed))
         return false;
 
@@ -8754,7 +12075,7 @@ namespace Legion {
 #ifdef DEBUG_LEGION
         assert((i >= 0) && (((size_t)i) < ALLOCATOR::INNER_TYPE::SIZE));
 #endif
-        NodeBase *child = inner->elems[i];
+        NodeBase *child = __atomic_load_n(&inner->elems[i], __ATOMIC_ACQUIRE);
         if (child == 0)
           return false;
 #ifdef DEBUG_LEGION
@@ -8768,6 +12089,40 @@ namespace Legion {
       return true;
     }
 
+    //-------------------------------------------------------------------------
+    template<typename ALLOCATOR>
+    typename DynamicTable<ALLOCATOR>::ET* 
+                            DynamicTable<ALLOCATOR>::find_entry(IT index) const
+    //-------------------------------------------------------------------------
+    {
+      int level_needed = 0;
+      int elems_addressable = 1 << ALLOCATOR::LEAF_BITS;
+      while (index >= elems_addressable)
+      {
+        level_needed++;
+        elems_addressable <<= ALLOCATOR::INNER_BITS;
+      }
+      NodeBase *n = __atomic_load_n(&root, __ATOMIC_ACQUIRE);
+      if (!n || (n->level < level_needed))
+        return 0;
+      // Walk the tree without instantiating anything along the way
+      while (n->level > 0)
+      {
+        typename ALLOCATOR::INNER_TYPE *inner = 
+          static_cast<typename ALLOCATOR::INNER_TYPE*>(n);
+        IT i = ((index >> (ALLOCATOR::LEAF_BITS + (n->level - 1) *
+            ALLOCATOR::INNER_BITS)) & ((((IT)1) << ALLOCATOR::INNER_BITS) - 1));
+        NodeBase *child = __atomic_load_n(&inner->elems[i], __ATOMIC_ACQUIRE);
+        if (child == 0)
+          return 0;
+        n = child;
+      }
+      typename ALLOCATOR::LEAF_TYPE *leaf = 
+        static_cast<typename ALLOCATOR::LEAF_TYPE*>(n);
+      int offset = (index & ((((IT)1) << ALLOCATOR::LEAF_BITS) - 1));
+      return __atomic_load_n(&leaf->elems[offset], __ATOMIC_ACQUIRE);
+    }
+
     //-------------------------------------------------------------------------
     template<typename ALLOCATOR>
     typename DynamicTable<ALLOCATOR>::ET* 
@@ -8779,13 +12134,14 @@ namespace Legion {
       typename ALLOCATOR::LEAF_TYPE *leaf = 
         static_cast<typename ALLOCATOR::LEAF_TYPE*>(n);
       int offset = (index & ((((IT)1) << ALLOCATOR::LEAF_BITS) - 1));
-      ET *result = leaf->elems[offset];
+      ET *result = __atomic_load_n(&leaf->elems[offset], __ATOMIC_ACQUIRE);
       if (result == 0)
       {
         AutoLock l(leaf->lock);
         // Now that we have the lock, check to see if we lost the race
         if (leaf->elems[offset] == 0)
-          leaf->elems[offset] = new ET();
+          __atomic_store_n(&leaf->elems[offset], new ET(),
+                           __ATOMIC_RELEASE);
         result = leaf->elems[offset];
       }
 #ifdef DEBUG_LEGION
@@ -8805,13 +12161,14 @@ namespace Legion {
       typename ALLOCATOR::LEAF_TYPE *leaf = 
         static_cast<typename ALLOCATOR::LEAF_TYPE*>(n);
       int offset = (index & ((((IT)1) << ALLOCATOR::LEAF_BITS) - 1));
-      ET *result = leaf->elems[offset];
+      ET *result = __atomic_load_n(&leaf->elems[offset], __ATOMIC_ACQUIRE);
       if (result == 0)
       {
         AutoLock l(leaf->lock);
         // Now that we have the lock, check to see if we lost the race
         if (leaf->elems[offset] == 0)
-          leaf->elems[offset] = new ET(arg);
+          __atomic_store_n(&leaf->elems[offset], new ET(arg),
+                           __ATOMIC_RELEASE);
         result = leaf->elems[offset];
       }
 #ifdef DEBUG_LEGION
@@ -8832,13 +12189,14 @@ namespace Legion {
       typename ALLOCATOR::LEAF_TYPE *leaf = 
         static_cast<typename ALLOCATOR::LEAF_TYPE*>(n);
       int offset = (index & ((((IT)1) << ALLOCATOR::LEAF_BITS) - 1));
-      ET *result = leaf->elems[offset];
+      ET *result = __atomic_load_n(&leaf->elems[offset], __ATOMIC_ACQUIRE);
       if (result == 0)
       {
         AutoLock l(leaf->lock);
         // Now that we have the lock, check to see if we lost the race
         if (leaf->elems[offset] == 0)
-          leaf->elems[offset] = new ET(arg1, arg2);
+          __atomic_store_n(&leaf->elems[offset], new ET(arg1, arg2),
+                           __ATOMIC_RELEASE);
         result = leaf->elems[offset];
       }
 #ifdef DEBUG_LEGION
@@ -8864,7 +12222,7 @@ namespace Legion {
 
       // In most cases we won't need to add levels to the tree, but
       // if we do, then do it now
-      NodeBase *n = root;
+      NodeBase *n = __atomic_load_n(&root, __ATOMIC_ACQUIRE);
       if (!n || (n->level < level_needed)) 
       {
         AutoLock l(lock); 
@@ -8882,11 +12240,12 @@ namespace Legion {
             typename ALLOCATOR::INNER_TYPE *inner = 
               static_cast<typename ALLOCATOR::INNER_TYPE*>(parent);
             inner->elems[0] = root;
-            root = parent;
+            __atomic_store_n(&root, parent, __ATOMIC_RELEASE);
           }
         }
         else
-          root = new_tree_node(level_needed, 0, elems_addressable - 1);
+          __atomic_store_n(&root, new_tree_node(level_needed, 0, 
+                           elems_addressable - 1), __ATOMIC_RELEASE);
         n = root;
       }
       // root should be high-enough now
@@ -8907,7 +12266,7 @@ namespace Legion {
 #ifdef DEBUG_LEGION
         assert((i >= 0) && (((size_t)i) < ALLOCATOR::INNER_TYPE::SIZE));
 #endif
-        NodeBase *child = inner->elems[i];
+        NodeBase *child = __atomic_load_n(&inner->elems[i], __ATOMIC_ACQUIRE);
         if (child == 0)
         {
           AutoLock l(inner->lock);
@@ -8920,8 +12279,8 @@ namespace Legion {
             IT child_first = inner->first_index + (i << child_shift);
             IT child_last = inner->first_index + ((i + 1) << child_shift) - 1;
 
-            inner->elems[i] = new_tree_node(child_level, 
-                                            child_first, child_last);
+            __atomic_store_n(&inner->elems[i], new_tree_node(child_level,
+                             child_first, child_last), __ATOMIC_RELEASE);
           }
           child = inner->elems[i];
         }
@@ -8939,6 +12298,324 @@ namespace Legion {
       return n;
     }
 
+    //--------------------------------------------------------------------------
+    template<typename T>
+    /*static*/ inline size_t FlatHash<T>::mix(uint64_t key)
+    //--------------------------------------------------------------------------
+    {
+      // Finalizer from MurmurHash3
+      key ^= (key >> 33);
+      key *= 0xff51afd7ed558ccdULL;
+      key ^= (key >> 33);
+      key *= 0xc4ceb9fe1a85ec53ULL;
+      key ^= (key >> 33);
+      return size_t(key);
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename KEY, typename VAL, typename HASH, typename ALLOCATOR>
+    FlatHashMap<KEY,VAL,HASH,ALLOCATOR>::FlatHashMap(void)
+      : slots(NULL), states(NULL), capacity(0), num_entries(0)
+    //--------------------------------------------------------------------------
+    {
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename KEY, typename VAL, typename HASH, typename ALLOCATOR>
+    FlatHashMap<KEY,VAL,HASH,ALLOCATOR>::FlatHashMap(const FlatHashMap &rhs)
+      : slots(NULL), states(NULL), capacity(0), num_entries(0)
+    //--------------------------------------------------------------------------
+    {
+      reserve(rhs.num_entries);
+      for (const_iterator it = rhs.begin(); it != rhs.end(); it++)
+        insert(*it);
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename KEY, typename VAL, typename HASH, typename ALLOCATOR>
+    FlatHashMap<KEY,VAL,HASH,ALLOCATOR>::~FlatHashMap(void)
+    //--------------------------------------------------------------------------
+    {
+      if (capacity == 0)
+        return;
+      clear();
+      slot_allocator.deallocate(slots, capacity);
+      state_allocator.deallocate(states, capacity);
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename KEY, typename VAL, typename HASH, typename ALLOCATOR>
+    FlatHashMap<KEY,VAL,HASH,ALLOCATOR>& 
+      FlatHashMap<KEY,VAL,HASH,ALLOCATOR>::operator=(const FlatHashMap &rhs)
+    //--------------------------------------------------------------------------
+    {
+      if (this == &rhs)
+        return *this;
+      clear();
+      reserve(rhs.num_entries);
+      for (const_iterator it = rhs.begin(); it != rhs.end(); it++)
+        insert(*it);
+      return *this;
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename KEY, typename VAL, typename HASH, typename ALLOCATOR>
+    std::pair<typename FlatHashMap<KEY,VAL,HASH,ALLOCATOR>::iterator,bool>
+          FlatHashMap<KEY,VAL,HASH,ALLOCATOR>::insert(const value_type &value)
+    //--------------------------------------------------------------------------
+    {
+      const size_t existing = find_slot(value.first);
+      if (existing < capacity)
+        return std::pair<iterator,bool>(iterator(this, existing), false);
+      // Grow before inserting so we never exceed 3/4 full
+      if ((4 * (num_entries + 1)) > (3 * capacity))
+        rehash((capacity == 0) ? size_t(MIN_CAPACITY) : 2 * capacity);
+      size_t slot = ideal_slot(value.first);
+      while (states[slot])
+        slot = (slot + 1) & (capacity - 1);
+      new (slots + slot) value_type(value);
+      states[slot] = 1;
+      num_entries++;
+      return std::pair<iterator,bool>(iterator(this, slot), true);
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename KEY, typename VAL, typename HASH, typename ALLOCATOR>
+    VAL& FlatHashMap<KEY,VAL,HASH,ALLOCATOR>::operator[](const KEY &key)
+    //--------------------------------------------------------------------------
+    {
+      const size_t existing = find_slot(key);
+      if (existing < capacity)
+        return slots[existing].second;
+      return insert(value_type(key, VAL())).first->second;
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename KEY, typename VAL, typename HASH, typename ALLOCATOR>
+    size_t FlatHashMap<KEY,VAL,HASH,ALLOCATOR>::erase(const KEY &key)
+    //--------------------------------------------------------------------------
+    {
+      const size_t slot = find_slot(key);
+      if (slot == capacity)
+        return 0;
+      erase_slot(slot);
+      return 1;
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename KEY, typename VAL, typename HASH, typename ALLOCATOR>
+    void FlatHashMap<KEY,VAL,HASH,ALLOCATOR>::erase(iterator it)
+    //--------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert((it.map == this) && (it.slot < capacity) && states[it.slot]);
+#endif
+      erase_slot(it.slot);
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename KEY, typename VAL, typename HASH, typename ALLOCATOR>
+    void FlatHashMap<KEY,VAL,HASH,ALLOCATOR>::clear(void)
+    //--------------------------------------------------------------------------
+    {
+      if (num_entries == 0)
+        return;
+      for (size_t idx = 0; idx < capacity; idx++)
+      {
+        if (!states[idx])
+          continue;
+        slots[idx].~value_type();
+        states[idx] = 0;
+      }
+      num_entries = 0;
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename KEY, typename VAL, typename HASH, typename ALLOCATOR>
+    void FlatHashMap<KEY,VAL,HASH,ALLOCATOR>::reserve(size_t entries)
+    //--------------------------------------------------------------------------
+    {
+      size_t needed = (capacity == 0) ? size_t(MIN_CAPACITY) : capacity;
+      while ((4 * entries) > (3 * needed))
+        needed *= 2;
+      if (needed > capacity)
+        rehash(needed);
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename KEY, typename VAL, typename HASH, typename ALLOCATOR>
+    void FlatHashMap<KEY,VAL,HASH,ALLOCATOR>::swap(FlatHashMap &rhs)
+    //--------------------------------------------------------------------------
+    {
+      std::swap(slots, rhs.slots);
+      std::swap(states, rhs.states);
+      std::swap(capacity, rhs.capacity);
+      std::swap(num_entries, rhs.num_entries);
+      std::swap(hasher, rhs.hasher);
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename KEY, typename VAL, typename HASH, typename ALLOCATOR>
+    size_t FlatHashMap<KEY,VAL,HASH,ALLOCATOR>::find_slot(const KEY &key) const
+    //--------------------------------------------------------------------------
+    {
+      if (num_entries == 0)
+        return capacity;
+      size_t slot = ideal_slot(key);
+      // The table is never full so this always hits an empty slot
+      while (states[slot])
+      {
+        if (slots[slot].first == key)
+          return slot;
+        slot = (slot + 1) & (capacity - 1);
+      }
+      return capacity;
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename KEY, typename VAL, typename HASH, typename ALLOCATOR>
+    size_t FlatHashMap<KEY,VAL,HASH,ALLOCATOR>::next_occupied(size_t slot) const
+    //--------------------------------------------------------------------------
+    {
+      while ((slot < capacity) && !states[slot])
+        slot++;
+      return slot;
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename KEY, typename VAL, typename HASH, typename ALLOCATOR>
+    void FlatHashMap<KEY,VAL,HASH,ALLOCATOR>::rehash(size_t new_capacity)
+    //--------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      // Must be a power of two for the slot masks to work
+      assert((new_capacity & (new_capacity - 1)) == 0);
+      assert((4 * num_entries) <= (3 * new_capacity));
+#endif
+      value_type *old_slots = slots;
+      unsigned char *old_states = states;
+      const size_t old_capacity = capacity;
+      slots = slot_allocator.allocate(new_capacity);
+      states = state_allocator.allocate(new_capacity);
+      memset(states, 0, new_capacity);
+      capacity = new_capacity;
+      for (size_t idx = 0; idx < old_capacity; idx++)
+      {
+        if (!old_states[idx])
+          continue;
+        size_t slot = ideal_slot(old_slots[idx].first);
+        while (states[slot])
+          slot = (slot + 1) & (capacity - 1);
+        new (slots + slot) value_type(old_slots[idx]);
+        states[slot] = 1;
+        old_slots[idx].~value_type();
+      }
+      if (old_capacity > 0)
+      {
+        slot_allocator.deallocate(old_slots, old_capacity);
+        state_allocator.deallocate(old_states, old_capacity);
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename KEY, typename VAL, typename HASH, typename ALLOCATOR>
+    void FlatHashMap<KEY,VAL,HASH,ALLOCATOR>::erase_slot(size_t slot)
+    //--------------------------------------------------------------------------
+    {
+      const size_t mask = capacity - 1;
+      slots[slot].~value_type();
+      states[slot] = 0;
+      num_entries--;
+      // Shift back any later entries in this run whose probe sequence 
+      // passes through the hole so that lookups never stop too early
+      size_t hole = slot;
+      size_t next = (slot + 1) & mask;
+      while (states[next])
+      {
+        const size_t ideal = ideal_slot(slots[next].first);
+        // Leave the entry alone if its ideal slot is cyclically 
+        // in (hole, next] since it can still be found from there
+        const bool stays = (hole <= next) ? 
+          ((hole < ideal) && (ideal <= next)) : 
+          ((hole < ideal) || (ideal <= next));
+        if (!stays)
+        {
+          new (slots + hole) value_type(slots[next]);
+          states[hole] = 1;
+          slots[next].~value_type();
+          states[next] = 0;
+          hole = next;
+        }
+        next = (next + 1) & mask;
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename KEY, typename VAL, typename COMPARATOR, 
+             typename ALLOCATOR>
+    typename FlatVectorMap<KEY,VAL,COMPARATOR,ALLOCATOR>::iterator
+                   FlatVectorMap<KEY,VAL,COMPARATOR,ALLOCATOR>::find(const KEY &key)
+    //--------------------------------------------------------------------------
+    {
+      iterator finder = lower_bound(key);
+      if (!matches(finder, key))
+        return entries.end();
+      return finder;
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename KEY, typename VAL, typename COMPARATOR, 
+             typename ALLOCATOR>
+    typename FlatVectorMap<KEY,VAL,COMPARATOR,ALLOCATOR>::const_iterator
+             FlatVectorMap<KEY,VAL,COMPARATOR,ALLOCATOR>::find(const KEY &key) const
+    //--------------------------------------------------------------------------
+    {
+      const_iterator finder = lower_bound(key);
+      if (!matches(finder, key))
+        return entries.end();
+      return finder;
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename KEY, typename VAL, typename COMPARATOR, 
+             typename ALLOCATOR>
+    std::pair<typename FlatVectorMap<KEY,VAL,COMPARATOR,ALLOCATOR>::iterator,
+              bool> FlatVectorMap<KEY,VAL,COMPARATOR,ALLOCATOR>::insert(
+                                                      const value_type &value)
+    //--------------------------------------------------------------------------
+    {
+      iterator finder = lower_bound(value.first);
+      if (matches(finder, value.first))
+        return std::pair<iterator,bool>(finder, false);
+      return std::pair<iterator,bool>(entries.insert(finder, value), true);
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename KEY, typename VAL, typename COMPARATOR, 
+             typename ALLOCATOR>
+    VAL& FlatVectorMap<KEY,VAL,COMPARATOR,ALLOCATOR>::operator[](
+                                                                const KEY &key)
+    //--------------------------------------------------------------------------
+    {
+      iterator finder = lower_bound(key);
+      if (!matches(finder, key))
+        finder = entries.insert(finder, value_type(key, VAL()));
+      return finder->second;
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename KEY, typename VAL, typename COMPARATOR, 
+             typename ALLOCATOR>
+    size_t FlatVectorMap<KEY,VAL,COMPARATOR,ALLOCATOR>::erase(const KEY &key)
+    //--------------------------------------------------------------------------
+    {
+      iterator finder = lower_bound(key);
+      if (!matches(finder, key))
+        return 0;
+      entries.erase(finder);
+      return 1;
+    }
+
 }; // namespace Legion 
 
 #endif // __LEGION_UTILITIES_H__
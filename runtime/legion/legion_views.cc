@@ -43,6 +43,8 @@ namespace Legion {
         view_lock(Reservation::create_reservation()) 
     //--------------------------------------------------------------------------
     {
+      // Keep the region tree alive as long as we are
+      logical_node->add_tree_reference();
     }
 
     //--------------------------------------------------------------------------
@@ -53,6 +55,7 @@ namespace Legion {
         unregister_with_runtime(VIEW_VIRTUAL_CHANNEL);
       view_lock.destroy_reservation();
       view_lock = Reservation::NO_RESERVATION;
+      logical_node->remove_tree_reference();
     }
 
     //--------------------------------------------------------------------------
@@ -212,7 +215,8 @@ namespace Legion {
       : InstanceView(ctx, encode_materialized_did(did, par == NULL), own_addr, 
                      log_own, node, own_ctx, register_now), 
         manager(man), parent(par), 
-        disjoint_children(node->are_all_children_disjoint())
+        disjoint_children(node->are_all_children_disjoint()), 
+        interfering_users(0)
     //--------------------------------------------------------------------------
     {
       // Otherwise the instance lock will get filled in when we are unpacked
@@ -975,27 +979,86 @@ namespace Legion {
                           std::set<RtEvent> &applied_events)
     //--------------------------------------------------------------------------
     {
+      MaterializedView *memo_top = NULL;
+      uint64_t memo_stamp = 0;
+      const bool memoize = IS_READ_ONLY(usage) && 
+        compute_read_stamp(versions, memo_top, memo_stamp);
+      if (memoize)
+      {
+        AutoLock v_lock(view_lock,1,false/*exclusive*/);
+        for (LegionVector<ReadPrecondition>::aligned::const_iterator it = 
+              read_preconditions.begin(); it != 
+              read_preconditions.end(); it++)
+        {
+          if ((it->stamp == memo_stamp) && (it->top == memo_top) &&
+              (it->prop == usage.prop) && (it->user_mask == user_mask))
+            return it->precondition;
+        }
+      }
       std::set<ApEvent> wait_on_events;
       ApEvent start_use_event = manager->get_use_event();
       if (start_use_event.exists())
         wait_on_events.insert(start_use_event);
-      UniqueID op_id = op->get_unique_op_id();
+      // A memoized precondition can be used by any operation, so don't
+      // skip the users of this one. It is still in its precondition
+      // pass, so it can only have copies registered here, and waiting
+      // on those is just conservative.
+      const UniqueID op_id = memoize ? 0 : op->get_unique_op_id();
+      const ApEvent skip_event = memoize ? ApEvent::NO_AP_EVENT : term_event;
       RegionNode *origin_node = logical_node->is_region() ? 
         logical_node->as_region_node() : 
         logical_node->as_partition_node()->parent;
       // Find our local preconditions
-      find_local_user_preconditions(usage, term_event, ColorPoint(), 
+      find_local_user_preconditions(usage, skip_event, ColorPoint(), 
           origin_node, versions, op_id, index, user_mask, 
           wait_on_events, applied_events);
       // Go up the tree if we have to
       if ((parent != NULL) && !versions->is_upper_bound_node(logical_node))
       {
         const ColorPoint &local_color = logical_node->get_color();
-        parent->find_user_preconditions_above(usage, term_event, local_color, 
+        parent->find_user_preconditions_above(usage, skip_event, local_color, 
                               origin_node, versions, op_id, index, user_mask, 
                               wait_on_events, applied_events);
       }
-      return Runtime::merge_events(wait_on_events); 
+      const ApEvent result = Runtime::merge_events(wait_on_events); 
+      if (memoize)
+      {
+        AutoLock v_lock(view_lock);
+        if (read_preconditions.size() == MAX_READ_PRECONDITIONS)
+          read_preconditions.erase(read_preconditions.begin());
+        read_preconditions.resize(read_preconditions.size() + 1);
+        ReadPrecondition &memo = read_preconditions.back();
+        memo.user_mask = user_mask;
+        memo.prop = usage.prop;
+        memo.top = memo_top;
+        memo.stamp = memo_stamp;
+        memo.precondition = result;
+      }
+      return result;
+    }
+
+    //--------------------------------------------------------------------------
+    bool MaterializedView::compute_read_stamp(VersionTracker *versions,
+                                             MaterializedView *&top,
+                                             uint64_t &stamp)
+    //--------------------------------------------------------------------------
+    {
+      // Walk the same views that the precondition analysis will
+      MaterializedView *view = this;
+      stamp = 0;
+      while (true)
+      {
+        // Remote copies of views might have to be updated first
+        if (!view->is_logical_owner())
+          return false;
+        stamp += __sync_fetch_and_add(&view->interfering_users, 0);
+        if ((view->parent == NULL) || 
+            versions->is_upper_bound_node(view->logical_node))
+          break;
+        view = view->parent;
+      }
+      top = view;
+      return true;
     }
 
     //--------------------------------------------------------------------------
@@ -1949,7 +2012,11 @@ namespace Legion {
     {
       // Must be called while holding the lock
       // Reference should already have been added
+      if (!IS_READ_ONLY(user->usage))
+        __sync_fetch_and_add(&interfering_users, 1);
       EventUsers &event_users = current_epoch_users[term_event];
+      if (!user->child.is_valid())
+        current_local_events.insert(term_event);
       if (event_users.single)
       {
         if (event_users.users.single_user == NULL)
@@ -2038,6 +2105,8 @@ namespace Legion {
           }
           previous_epoch_users.erase(previous_finder);
         }
+        current_local_events.erase(term_event);
+        previous_local_events.erase(term_event);
         outstanding_gc_events.erase(event_finder);
       }
 #endif
@@ -2174,6 +2243,8 @@ namespace Legion {
         return;
       current_users.user_mask -= summary_overlap;
       EventUsers &prev_users = previous_epoch_users[cit->first];
+      if (current_local_events.find(cit->first) != current_local_events.end())
+        previous_local_events.insert(cit->first);
       if (current_users.single)
       {
         PhysicalUser *user = current_users.users.single_user;
@@ -2536,8 +2607,13 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       // Caller must be holding the lock
-      for (LegionMap<ApEvent,EventUsers>::aligned::const_iterator cit = 
-           current_epoch_users.begin(); cit != current_epoch_users.end(); cit++)
+      // Users from other disjoint children can never be preconditions,
+      // but we still have to observe them when tracking domination
+      const std::set<ApEvent> *event_index = 
+        (!TRACK_DOM && child_color.is_valid() && disjoint_children) ?
+          &current_local_events : NULL;
+      for (EpochCursor cit(current_epoch_users, event_index); 
+            cit.valid(); cit.step())
       {
         if (cit->first == term_event)
           continue;
@@ -2608,9 +2684,12 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       // Caller must be holding the lock
-      for (LegionMap<ApEvent,EventUsers>::aligned::const_iterator pit = 
-            previous_epoch_users.begin(); pit != 
-            previous_epoch_users.end(); pit++)
+      // Users from other disjoint children can never be preconditions
+      const std::set<ApEvent> *event_index = 
+        (child_color.is_valid() && disjoint_children) ?
+          &previous_local_events : NULL;
+      for (EpochCursor pit(previous_epoch_users, event_index); 
+            pit.valid(); pit.step())
       {
         if (pit->first == term_event)
           continue;
@@ -2668,8 +2747,13 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       // Caller must be holding the lock
-      for (LegionMap<ApEvent,EventUsers>::aligned::const_iterator cit = 
-           current_epoch_users.begin(); cit != current_epoch_users.end(); cit++)
+      // Users from other disjoint children can never be preconditions,
+      // but we still have to observe them when tracking domination
+      const std::set<ApEvent> *event_index = 
+        (!TRACK_DOM && child_color.is_valid() && disjoint_children) ?
+          &current_local_events : NULL;
+      for (EpochCursor cit(current_epoch_users, event_index); 
+            cit.valid(); cit.step())
       {
 #if !defined(LEGION_SPY) && !defined(EVENT_GRAPH_TRACE)
         // We're about to do a bunch of expensive tests, 
@@ -2751,9 +2835,12 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       // Caller must be holding the lock
-      for (LegionMap<ApEvent,EventUsers>::aligned::const_iterator pit = 
-            previous_epoch_users.begin(); pit != 
-            previous_epoch_users.end(); pit++)
+      // Users from other disjoint children can never be preconditions
+      const std::set<ApEvent> *event_index = 
+        (child_color.is_valid() && disjoint_children) ?
+          &previous_local_events : NULL;
+      for (EpochCursor pit(previous_epoch_users, event_index); 
+            pit.valid(); pit.step())
       {
 #if !defined(LEGION_SPY) && !defined(EVENT_GRAPH_TRACE)
         // We're about to do a bunch of expensive tests, 
@@ -3547,6 +3634,8 @@ namespace Legion {
           derez.deserialize(current_event);
           size_t num_users;
           derez.deserialize(num_users);
+          // Be conservative and index all remote users
+          current_local_events.insert(current_event);
           // See if we already have a users for this event
           LegionMap<ApEvent,EventUsers>::aligned::iterator finder = 
             current_epoch_users.find(current_event);
@@ -3617,6 +3706,8 @@ namespace Legion {
           derez.deserialize(previous_event);
           size_t num_users;
           derez.deserialize(num_users);
+          // Be conservative and index all remote users
+          previous_local_events.insert(previous_event);
           // See if we already have a users for this event
           LegionMap<ApEvent,EventUsers>::aligned::iterator finder = 
             previous_epoch_users.find(previous_event);
@@ -4034,6 +4125,202 @@ namespace Legion {
       reduction_views[reduction_view] = reduction_mask;
     }
 
+    //--------------------------------------------------------------------------
+    void CompositeCopyNode::merge_child_copies(void)
+    //--------------------------------------------------------------------------
+    {
+      // Bottom-up so merged copies can keep going up the tree
+      for (LegionMap<CompositeCopyNode*,FieldMask>::aligned::const_iterator it =
+            child_nodes.begin(); it != child_nodes.end(); it++)
+        it->first->merge_child_copies();
+      for (LegionMap<CompositeCopyNode*,FieldMask>::aligned::const_iterator it =
+            nested_nodes.begin(); it != nested_nodes.end(); it++)
+        it->first->merge_child_copies();
+      // We can only issue a copy over the union of the children of a 
+      // partition, so all the children of the partition must be here
+      if (logical_node->is_region() || child_nodes.empty() ||
+          (child_nodes.size() != logical_node->get_num_children()))
+        return;
+      // Find the fields that every child just copies from its source
+      // views without any older, finer, or reduction data to apply
+      FieldMask candidates = child_nodes.begin()->second;
+      for (LegionMap<CompositeCopyNode*,FieldMask>::aligned::const_iterator it =
+            child_nodes.begin(); it != child_nodes.end(); it++)
+      {
+        candidates &= it->second;
+        if (!candidates)
+          return;
+        const CompositeCopyNode *child = it->first;
+        for (LegionMap<CompositeCopyNode*,FieldMask>::aligned::const_iterator
+              cit = child->child_nodes.begin(); 
+              cit != child->child_nodes.end(); cit++)
+          candidates -= cit->second;
+        for (LegionMap<CompositeCopyNode*,FieldMask>::aligned::const_iterator
+              nit = child->nested_nodes.begin(); 
+              nit != child->nested_nodes.end(); nit++)
+          candidates -= nit->second;
+        for (LegionMap<ReductionView*,FieldMask>::aligned::const_iterator
+              rit = child->reduction_views.begin(); 
+              rit != child->reduction_views.end(); rit++)
+          candidates -= rit->second;
+        if (!candidates)
+          return;
+      }
+      // Find the instances that are valid in every child for those fields
+      // using their views for this partition
+      LegionMap<MaterializedView*,FieldMask>::aligned common_views;
+      for (LegionMap<CompositeCopyNode*,FieldMask>::aligned::const_iterator it =
+            child_nodes.begin(); it != child_nodes.end(); it++)
+      {
+        LegionMap<MaterializedView*,FieldMask>::aligned child_views;
+        for (LegionMap<LogicalView*,FieldMask>::aligned::const_iterator vit =
+              it->first->source_views.begin(); vit != 
+              it->first->source_views.end(); vit++)
+        {
+          if (!vit->first->is_materialized_view())
+            continue;
+          const FieldMask overlap = vit->second & candidates;
+          if (!overlap)
+            continue;
+          MaterializedView *parent_view = 
+            vit->first->as_materialized_view()->get_materialized_parent_view();
+          if ((parent_view == NULL) || 
+              (parent_view->logical_node != logical_node))
+            continue;
+          child_views[parent_view] |= overlap;
+        }
+        if (it == child_nodes.begin())
+        {
+          common_views.swap(child_views);
+          continue;
+        }
+        std::vector<MaterializedView*> to_delete;
+        for (LegionMap<MaterializedView*,FieldMask>::aligned::iterator cit =
+              common_views.begin(); cit != common_views.end(); cit++)
+        {
+          LegionMap<MaterializedView*,FieldMask>::aligned::const_iterator
+            finder = child_views.find(cit->first);
+          if (finder != child_views.end())
+            cit->second &= finder->second;
+          else
+            cit->second.clear();
+          if (!cit->second)
+            to_delete.push_back(cit->first);
+        }
+        for (std::vector<MaterializedView*>::const_iterator dit = 
+              to_delete.begin(); dit != to_delete.end(); dit++)
+          common_views.erase(*dit);
+        if (common_views.empty())
+          break;
+      }
+      // Pick one instance for each field and move the copies up here
+      FieldMask merged;
+      LegionMap<MaterializedView*,FieldMask>::aligned merged_views;
+      for (LegionMap<MaterializedView*,FieldMask>::aligned::const_iterator it =
+            common_views.begin(); it != common_views.end(); it++)
+      {
+        const FieldMask fields = it->second - merged;
+        if (!fields)
+          continue;
+        merged_views[it->first] = fields;
+        merged |= fields;
+      }
+      // For the remaining fields see if every child is filled with the 
+      // same value so that we can issue one fill over the partition
+      const FieldMask fill_candidates = candidates - merged;
+      if (!!fill_candidates)
+      {
+        LegionMap<FillView*,FieldMask>::aligned common_fills;
+        for (LegionMap<CompositeCopyNode*,FieldMask>::aligned::const_iterator 
+              it = child_nodes.begin(); it != child_nodes.end(); it++)
+        {
+          LegionMap<FillView*,FieldMask>::aligned child_fills;
+          for (LegionMap<LogicalView*,FieldMask>::aligned::const_iterator vit =
+                it->first->source_views.begin(); vit != 
+                it->first->source_views.end(); vit++)
+          {
+            if (!vit->first->is_fill_view())
+              continue;
+            const FieldMask overlap = vit->second & fill_candidates;
+            if (!overlap)
+              continue;
+            child_fills[vit->first->as_fill_view()] = overlap;
+          }
+          if (it == child_nodes.begin())
+          {
+            common_fills.swap(child_fills);
+            if (common_fills.empty())
+              break;
+            continue;
+          }
+          std::vector<FillView*> to_delete;
+          for (LegionMap<FillView*,FieldMask>::aligned::iterator cit = 
+                common_fills.begin(); cit != common_fills.end(); cit++)
+          {
+            FieldMask same_value;
+            for (LegionMap<FillView*,FieldMask>::aligned::const_iterator 
+                  fit = child_fills.begin(); fit != child_fills.end(); fit++)
+            {
+              if (cit->first->has_same_value(fit->first))
+                same_value |= fit->second;
+            }
+            cit->second &= same_value;
+            if (!cit->second)
+              to_delete.push_back(cit->first);
+          }
+          for (std::vector<FillView*>::const_iterator dit = 
+                to_delete.begin(); dit != to_delete.end(); dit++)
+            common_fills.erase(*dit);
+          if (common_fills.empty())
+            break;
+        }
+        for (LegionMap<FillView*,FieldMask>::aligned::const_iterator it = 
+              common_fills.begin(); it != common_fills.end(); it++)
+        {
+          const FieldMask fields = it->second - merged;
+          if (!fields)
+            continue;
+          merged_fills[it->first] |= fields;
+          merged |= fields;
+        }
+      }
+      if (!merged)
+        return;
+      // Any local copies for these fields would be overwritten by 
+      // the copies to the children anyway, so they can be dropped
+      if (!source_views.empty())
+      {
+        std::vector<LogicalView*> to_delete;
+        for (LegionMap<LogicalView*,FieldMask>::aligned::iterator it = 
+              source_views.begin(); it != source_views.end(); it++)
+        {
+          it->second -= merged;
+          if (!it->second)
+            to_delete.push_back(it->first);
+        }
+        for (std::vector<LogicalView*>::const_iterator it = 
+              to_delete.begin(); it != to_delete.end(); it++)
+          source_views.erase(*it);
+      }
+      for (LegionMap<MaterializedView*,FieldMask>::aligned::const_iterator it =
+            merged_views.begin(); it != merged_views.end(); it++)
+        source_views[it->first] |= it->second;
+      std::vector<CompositeCopyNode*> to_delete;
+      for (LegionMap<CompositeCopyNode*,FieldMask>::aligned::iterator it = 
+            child_nodes.begin(); it != child_nodes.end(); it++)
+      {
+        it->second -= merged;
+        if (!it->second)
+          to_delete.push_back(it->first);
+      }
+      for (std::vector<CompositeCopyNode*>::const_iterator it = 
+            to_delete.begin(); it != to_delete.end(); it++)
+      {
+        child_nodes.erase(*it);
+        delete (*it);
+      }
+    }
+
     //--------------------------------------------------------------------------
     void CompositeCopyNode::issue_copies(const TraversalInfo &traversal_info,
                               MaterializedView *dst, const FieldMask &copy_mask,
@@ -4061,8 +4348,8 @@ namespace Legion {
         postconditions.insert(nested_postconditions.begin(),
                               nested_postconditions.end());
         // See if we need to update our local or child preconditions
-        if (!source_views.empty() || !child_nodes.empty() || 
-            !reduction_views.empty())
+        if (!source_views.empty() || !merged_fills.empty() || 
+            !child_nodes.empty() || !reduction_views.empty())
         {
           // Makes new local_preconditions
           local_preconditions = &temp_local;
@@ -4073,7 +4360,7 @@ namespace Legion {
         }
       }
       // Next issue copies from any of our source views 
-      if (!source_views.empty())
+      if (!source_views.empty() || !merged_fills.empty())
       {
         // Uses local_preconditions
         LegionMap<ApEvent,FieldMask>::aligned local_postconditions;
@@ -4391,6 +4678,28 @@ namespace Legion {
               deferred_preconditions, postconditions, guard, across_helper);
         }
       }
+      if (!merged_fills.empty())
+      {
+        for (LegionMap<FillView*,FieldMask>::aligned::const_iterator it = 
+              merged_fills.begin(); it != merged_fills.end(); it++)
+        {
+          const FieldMask fill_mask = it->second & copy_mask;
+          if (!fill_mask)
+            continue;
+          LegionMap<ApEvent,FieldMask>::aligned fill_preconditions;
+          for (LegionMap<ApEvent,FieldMask>::aligned::const_iterator pre_it =
+                preconditions.begin(); pre_it != preconditions.end(); pre_it++)
+          {
+            const FieldMask overlap = pre_it->second & fill_mask;
+            if (!overlap)
+              continue;
+            fill_preconditions[pre_it->first] = overlap;
+          }
+          // The fill covers all of our children so we are the intersection
+          it->first->issue_fills(info, dst, fill_mask, logical_node,
+              fill_preconditions, postconditions, guard, across_helper);
+        }
+      }
     }
 
     //--------------------------------------------------------------------------
@@ -4463,12 +4772,77 @@ namespace Legion {
                     PredEvent pred_guard, CopyAcrossHelper *across_helper) const
     //--------------------------------------------------------------------------
     {
-      for (LegionMap<ReductionView*,FieldMask>::aligned::const_iterator it =
-            reduction_views.begin(); it != reduction_views.end(); it++)
+      // If there are lots of reductions with the same operator on the 
+      // same fields then fold them together first in a tree so that
+      // the destination only sees one reduction for each group
+      std::vector<ReductionView*> to_apply;
+      std::vector<FieldMask> apply_masks;
+      std::vector<ReductionView*> temporaries;
+      // We need at least a pair of reductions to fold anything
+      const unsigned threshold = (Runtime::reduction_fold_threshold < 2) ?
+        2 : Runtime::reduction_fold_threshold;
+      if ((Runtime::reduction_fold_threshold > 0) && 
+          (reduction_views.size() >= threshold))
+      {
+        std::vector<std::vector<ReductionView*> > groups;
+        std::vector<FieldMask> group_masks;
+        for (LegionMap<ReductionView*,FieldMask>::aligned::const_iterator it =
+              reduction_views.begin(); it != reduction_views.end(); it++)
+        {
+          const FieldMask overlap = copy_mask & it->second;
+          if (!overlap)
+            continue;
+          unsigned idx = 0;
+          for ( ; idx < groups.size(); idx++)
+          {
+            ReductionView *first = groups[idx].front();
+            if ((first->manager->redop == it->first->manager->redop) &&
+                (first->logical_node == it->first->logical_node) &&
+                (group_masks[idx] == overlap))
+              break;
+          }
+          if (idx == groups.size())
+          {
+            groups.resize(idx + 1);
+            group_masks.push_back(overlap);
+          }
+          groups[idx].push_back(it->first);
+        }
+        for (unsigned idx = 0; idx < groups.size(); idx++)
+        {
+          ReductionView *folded = NULL;
+          if (groups[idx].size() >= threshold)
+            folded = fold_reductions(info, groups[idx], group_masks[idx],
+                         src_version_tracker, pred_guard, temporaries);
+          if (folded != NULL)
+          {
+            to_apply.push_back(folded);
+            apply_masks.push_back(group_masks[idx]);
+          }
+          else
+          {
+            to_apply.insert(to_apply.end(), 
+                            groups[idx].begin(), groups[idx].end());
+            apply_masks.resize(to_apply.size(), group_masks[idx]);
+          }
+        }
+      }
+      else
       {
-        const FieldMask overlap = copy_mask & it->second;
-        if (!overlap)
-          continue;
+        for (LegionMap<ReductionView*,FieldMask>::aligned::const_iterator it =
+              reduction_views.begin(); it != reduction_views.end(); it++)
+        {
+          const FieldMask overlap = copy_mask & it->second;
+          if (!overlap)
+            continue;
+          to_apply.push_back(it->first);
+          apply_masks.push_back(overlap);
+        }
+      }
+      for (unsigned idx = 0; idx < to_apply.size(); idx++)
+      {
+        ReductionView *reduction = to_apply[idx];
+        const FieldMask &overlap = apply_masks[idx];
         // This is precise but maybe unecessary
         std::set<ApEvent> local_preconditions;
         for (LegionMap<ApEvent,FieldMask>::aligned::const_iterator pre_it = 
@@ -4479,14 +4853,105 @@ namespace Legion {
             continue;
           local_preconditions.insert(pre_it->first);
         }
-        ApEvent reduce_event = it->first->perform_deferred_reduction(dst,
+        ApEvent reduce_event = reduction->perform_deferred_reduction(dst,
             overlap, src_version_tracker, local_preconditions, info.op,
             info.index, pred_guard, across_helper, 
-            (dst->logical_node == it->first->logical_node) ?
-              NULL : it->first->logical_node, info.map_applied_events);
+            (dst->logical_node == reduction->logical_node) ?
+              NULL : reduction->logical_node, info.map_applied_events);
         if (reduce_event.exists())
           postreductions[reduce_event] = overlap;
       }
+      // All the users of the temporaries are recorded so they can go
+      for (std::vector<ReductionView*>::const_iterator it = 
+            temporaries.begin(); it != temporaries.end(); it++)
+      {
+        PhysicalManager *temporary = (*it)->get_manager();
+        if (temporary->remove_base_valid_ref(MAPPING_ACQUIRE_REF, info.op))
+          delete temporary;
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    ReductionView* CompositeCopyNode::fold_reductions(const TraversalInfo &info,
+                               const std::vector<ReductionView*> &reductions,
+                               const FieldMask &fold_mask,
+                               VersionTracker *src_version_tracker,
+                               PredEvent pred_guard,
+                               std::vector<ReductionView*> &temporaries) const
+    //--------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(reductions.size() > 1);
+#endif
+      // The reduction instances might be read again so the first level
+      // folds pairs into new temporaries, after that we fold in place
+      std::vector<ReductionView*> level;
+      std::vector<bool> temporary;
+      for (unsigned idx = 0; (idx+1) < reductions.size(); idx += 2)
+      {
+        ReductionView *target = 
+          reductions[idx]->create_fold_temporary(info.op, fold_mask);
+        if (target == NULL)
+        {
+          // Out of memory or not foldable so it's not worth it, any 
+          // temporaries we did make will never be read so just let them go
+          for (std::vector<ReductionView*>::const_iterator it = 
+                level.begin(); it != level.end(); it++)
+          {
+            PhysicalManager *manager = (*it)->get_manager();
+            if (manager->remove_base_valid_ref(MAPPING_ACQUIRE_REF, info.op))
+              delete manager;
+          }
+          return NULL;
+        }
+        level.push_back(target);
+      }
+      for (unsigned idx = 0; idx < level.size(); idx++)
+      {
+        reductions[2*idx]->perform_reduction(level[idx], fold_mask,
+            src_version_tracker, info.op, info.index, 
+            info.map_applied_events, pred_guard);
+        reductions[2*idx+1]->perform_reduction(level[idx], fold_mask,
+            src_version_tracker, info.op, info.index, 
+            info.map_applied_events, pred_guard);
+      }
+      temporaries.insert(temporaries.end(), level.begin(), level.end());
+      temporary.resize(level.size(), true);
+      if ((reductions.size() % 2) == 1)
+      {
+        level.push_back(reductions.back());
+        temporary.push_back(false);
+      }
+      while (level.size() > 1)
+      {
+        std::vector<ReductionView*> next_level;
+        std::vector<bool> next_temporary;
+        for (unsigned idx = 0; (idx+1) < level.size(); idx += 2)
+        {
+          // At most one of each pair is an original reduction instance
+          const unsigned dst_idx = temporary[idx] ? idx : idx+1;
+          const unsigned src_idx = temporary[idx] ? idx+1 : idx;
+#ifdef DEBUG_LEGION
+          assert(temporary[dst_idx]);
+#endif
+          level[src_idx]->perform_reduction(level[dst_idx], fold_mask,
+              src_version_tracker, info.op, info.index,
+              info.map_applied_events, pred_guard);
+          next_level.push_back(level[dst_idx]);
+          next_temporary.push_back(true);
+        }
+        if ((level.size() % 2) == 1)
+        {
+          next_level.push_back(level.back());
+          next_temporary.push_back(temporary.back());
+        }
+        level.swap(next_level);
+        temporary.swap(next_temporary);
+      }
+#ifdef DEBUG_LEGION
+      assert(temporary.front());
+#endif
+      return level.front();
     }
 
     /////////////////////////////////////////////////////////////
@@ -5276,6 +5741,7 @@ namespace Legion {
 #ifdef DEBUG_LEGION
       assert(copy_tree != NULL);
 #endif
+      copy_tree->merge_child_copies();
       copy_mask -= copier.get_already_valid_fields();       
       // If we have any reduction fields though we still need to 
       copy_mask |= copier.get_reduction_fields();
@@ -5387,6 +5853,7 @@ namespace Legion {
 #ifdef DEBUG_LEGION
       assert(copy_tree != NULL);
 #endif
+      copy_tree->merge_child_copies();
       copy_tree->issue_copies(info, dst, copy_mask, this, preconditions, 
               postconditions, postreductions, pred_guard, across_helper);
       delete copy_tree;
@@ -6642,6 +7109,19 @@ namespace Legion {
                           LegionMap<ApEvent,FieldMask>::aligned &postconditions,
                           PredEvent pred_guard, CopyAcrossHelper *across_helper)
     //--------------------------------------------------------------------------
+    {
+      issue_fills(info, dst, copy_mask, logical_node, preconditions,
+                  postconditions, pred_guard, across_helper);
+    }
+
+    //--------------------------------------------------------------------------
+    void FillView::issue_fills(const TraversalInfo &info, MaterializedView *dst,
+                               FieldMask copy_mask, RegionTreeNode *fill_node,
+                    const LegionMap<ApEvent,FieldMask>::aligned &preconditions,
+                          LegionMap<ApEvent,FieldMask>::aligned &postconditions,
+                               PredEvent pred_guard, 
+                               CopyAcrossHelper *across_helper)
+    //--------------------------------------------------------------------------
     {
       // Compute the precondition sets
       LegionList<EventSet>::aligned precondition_sets;
@@ -6659,18 +7139,30 @@ namespace Legion {
         ApEvent fill_pre = Runtime::merge_events(pre_set.preconditions);
         // Issue the fill command
         // Only apply an intersection if the destination logical node
-        // is different than our logical node
+        // is different than the node we are filling
         ApEvent fill_post = dst->logical_node->issue_fill(info.op, dst_fields,
                         value->value, value->value_size, fill_pre, pred_guard, 
 #ifdef LEGION_SPY
                         fill_op_uid,
 #endif
-                  (logical_node == dst->logical_node) ? NULL : logical_node);
+                  (fill_node == dst->logical_node) ? NULL : fill_node);
         if (fill_post.exists())
           postconditions[fill_post] = pre_set.set_mask;
       }
     }
 
+    //--------------------------------------------------------------------------
+    bool FillView::has_same_value(const FillView *other) const
+    //--------------------------------------------------------------------------
+    {
+      if (value == other->value)
+        return true;
+      if (value->value_size != other->value->value_size)
+        return false;
+      return (memcmp(value->value, other->value->value, 
+                     value->value_size) == 0);
+    }
+
     //--------------------------------------------------------------------------
     /*static*/ void FillView::handle_send_fill_view(Runtime *runtime,
                                      Deserializer &derez, AddressSpaceID source)
@@ -7393,6 +7885,39 @@ namespace Legion {
         op->record_restrict_postcondition(reduce_post);
     } 
 
+    //--------------------------------------------------------------------------
+    ReductionView* ReductionView::create_fold_temporary(Operation *op,
+                                            const FieldMask &fold_mask) const
+    //--------------------------------------------------------------------------
+    {
+      // Only fold instances covering the same region can be made
+      if (!manager->is_foldable() || (logical_node != manager->region_node))
+        return NULL;
+      std::vector<FieldID> fold_fields;
+      manager->region_node->column_source->get_field_set(fold_mask, 
+                                                         fold_fields);
+      LayoutConstraintSet constraints;
+      constraints.add_constraint(
+          SpecializedConstraint(REDUCTION_FOLD_SPECIALIZE, manager->redop));
+      constraints.add_constraint(
+          FieldConstraint(fold_fields, false/*contiguous*/, false/*inorder*/));
+      std::vector<LogicalRegion> regions(1, manager->region_node->handle);
+      // The instance is acquired until the caller has recorded all
+      // of its users, after that it can be collected right away
+      MappingInstance result;
+      if (!manager->memory_manager->create_physical_instance(constraints,
+            regions, result, 0/*mapper id*/, Processor::NO_PROC, 
+            true/*acquire*/, GC_FIRST_PRIORITY, op->get_unique_op_id(),
+            0/*task id*/))
+        return NULL;
+      InstanceView *view = 
+        op->get_context()->create_instance_top_view(result.impl, local_space);
+#ifdef DEBUG_LEGION
+      assert(view->is_reduction_view());
+#endif
+      return view->as_reduction_view();
+    }
+
     //--------------------------------------------------------------------------
     ApEvent ReductionView::perform_deferred_reduction(MaterializedView *target,
                                                     const FieldMask &red_mask,
@@ -263,6 +263,56 @@ namespace Legion {
         } users;
         bool single;
       };
+      // Walks all the events of an epoch, or only the events of 
+      // the epoch that are named in an index if one is given
+      class EpochCursor {
+      public:
+        EpochCursor(const LegionMap<ApEvent,EventUsers>::aligned &epoch,
+                    const std::set<ApEvent> *index)
+          : epoch_users(epoch), event_index(index)
+        {
+          if (event_index != NULL)
+          {
+            index_it = event_index->begin();
+            find_indexed();
+          }
+          else
+            current = epoch_users.begin();
+        }
+      public:
+        inline bool valid(void) const 
+          { return (current != epoch_users.end()); }
+        inline void step(void)
+        {
+          if (event_index != NULL)
+          {
+            index_it++;
+            find_indexed();
+          }
+          else
+            current++;
+        }
+        inline const std::pair<const ApEvent,EventUsers>* 
+          operator->(void) const { return &(*current); }
+      protected:
+        inline void find_indexed(void)
+        {
+          // Index entries can be stale, skip events that are gone
+          current = epoch_users.end();
+          while (index_it != event_index->end())
+          {
+            current = epoch_users.find(*index_it);
+            if (current != epoch_users.end())
+              break;
+            index_it++;
+          }
+        }
+      protected:
+        const LegionMap<ApEvent,EventUsers>::aligned &epoch_users;
+        const std::set<ApEvent> *const event_index;
+        LegionMap<ApEvent,EventUsers>::aligned::const_iterator current;
+        std::set<ApEvent>::const_iterator index_it;
+      };
     public:
       MaterializedView(RegionTreeForest *ctx, DistributedID did,
                        AddressSpaceID owner_proc, 
@@ -519,6 +569,9 @@ namespace Legion {
       void sanity_check_versions(void);
 #endif
     protected:
+      // Returns false if read-only preconditions can't be memoized
+      bool compute_read_stamp(VersionTracker *versions,
+                              MaterializedView *&top, uint64_t &stamp);
       void add_current_user(PhysicalUser *user, ApEvent term_event,
                             const FieldMask &user_mask);
       void filter_local_users(ApEvent term_event);
@@ -662,6 +715,14 @@ namespace Legion {
       // the view tree that less frequently filter their sub-users.
       LegionMap<ApEvent,EventUsers>::aligned current_epoch_users;
       LegionMap<ApEvent,EventUsers>::aligned previous_epoch_users;
+      // The events in each epoch with at least one user that was not
+      // registered through one of our children. If our children are
+      // disjoint, a user coming up from a child can only depend on
+      // these users so its precondition searches only walk these
+      // events instead of every user from every other child. The
+      // entries can outlive the events' users, they are pruned when
+      // the events are garbage collected.
+      std::set<ApEvent> current_local_events, previous_local_events;
       // Also keep a set of events for which we have outstanding
       // garbage collection meta-tasks so we don't launch more than one
       // We need this even though we have the data structures above because
@@ -674,6 +735,25 @@ namespace Legion {
       // resilience or mis-speculation.
       LegionMap<VersionID,FieldMask,
                 PHYSICAL_VERSION_ALLOC>::track_aligned current_versions;
+    protected:
+      // Readers never depend on each other, so the preconditions for a
+      // read-only user stay the same until a user that is not a reader
+      // is registered with this view or one of the views above it.
+      // Each view counts those users and a memoized precondition is
+      // stamped with the sum of the counts from here to the top view
+      // of its analysis, so an iteration that reads the same fields of
+      // an unchanged instance reuses the event from the last iteration.
+      struct ReadPrecondition {
+      public:
+        FieldMask user_mask;
+        CoherenceProperty prop;
+        MaterializedView *top;
+        uint64_t stamp;
+        ApEvent precondition;
+      };
+      LegionVector<ReadPrecondition>::aligned read_preconditions;
+      uint64_t interfering_users; // atomic
+      static const size_t MAX_READ_PRECONDITIONS = 4;
     protected:
       // The scheme for tracking whether remote copies of the meta-data
       // are valid is as follows:
@@ -755,6 +835,8 @@ namespace Legion {
                              Operation *op, unsigned index,
                              std::set<RtEvent> &map_applied_events,
                              PredEvent pred_guard, bool restrict_out = false);
+      ReductionView* create_fold_temporary(Operation *op,
+                                           const FieldMask &fold_mask) const;
       ApEvent perform_deferred_reduction(MaterializedView *target,
                                         const FieldMask &copy_mask,
                                         VersionTracker *version_tracker,
@@ -996,6 +1078,10 @@ namespace Legion {
                            const FieldMask &source_mask);
       void add_reduction_view(ReductionView *reduction_view,
                               const FieldMask &reduction_mask);
+      // Merge copies from the same instance or fills of the same value
+      // into every child of a partition into a single copy or fill 
+      // over the whole partition
+      void merge_child_copies(void);
     public:
       void issue_copies(const TraversalInfo &traversal_info,
                         MaterializedView *dst, const FieldMask &copy_mask,
@@ -1037,6 +1123,12 @@ namespace Legion {
             const LegionMap<ApEvent,FieldMask>::aligned &preconditions,
                   LegionMap<ApEvent,FieldMask>::aligned &postreductions,
                   PredEvent pred_guard, CopyAcrossHelper *helper) const;
+      ReductionView* fold_reductions(const TraversalInfo &traversal_info,
+                        const std::vector<ReductionView*> &reductions,
+                        const FieldMask &fold_mask,
+                        VersionTracker *src_version_tracker,
+                        PredEvent pred_guard,
+                        std::vector<ReductionView*> &temporaries) const;
     public:
       RegionTreeNode *const logical_node;
       // Only valid at roots of copy trees
@@ -1048,6 +1140,8 @@ namespace Legion {
       LegionMap<CompositeCopyNode*,FieldMask>::aligned nested_nodes;
       // Instances that we need to issue copies from
       LegionMap<LogicalView*,FieldMask>::aligned source_views;
+      // Fills from our children that have been merged to cover all of us
+      LegionMap<FillView*,FieldMask>::aligned merged_fills;
       // Reductions that we need to apply
       LegionMap<ReductionView*,FieldMask>::aligned reduction_views;
     };
@@ -1421,6 +1515,14 @@ namespace Legion {
                           LegionMap<ApEvent,FieldMask>::aligned &postconditions,
                                          PredEvent pred_guard,
                                          CopyAcrossHelper *helper = NULL);
+      // Issue our fill over the part of the destination in the fill node
+      // which does not need to be the logical node of this view
+      void issue_fills(const TraversalInfo &info, MaterializedView *dst,
+                       FieldMask fill_mask, RegionTreeNode *fill_node,
+                    const LegionMap<ApEvent,FieldMask>::aligned &preconditions,
+                          LegionMap<ApEvent,FieldMask>::aligned &postconditions,
+                       PredEvent pred_guard, CopyAcrossHelper *helper);
+      bool has_same_value(const FillView *other) const;
     public:
       static void handle_send_fill_view(Runtime *runtime, Deserializer &derez,
                                         AddressSpaceID source);
@@ -35,7 +35,8 @@ namespace Legion {
                                      Operation *op /*= NULL*/)
       : manager(man), resume(RtUserEvent::NO_RT_USER_EVENT), 
         kind(k), operation(op), acquired_instances((op == NULL) ? NULL :
-             operation->get_acquired_instances_ref()), start_time(0)
+             operation->get_acquired_instances_ref()), start_time(0),
+        wait_time(0)
     //--------------------------------------------------------------------------
     {
     }
@@ -48,7 +49,8 @@ namespace Legion {
     MapperManager::MapperManager(Runtime *rt, Mapping::Mapper *mp, 
                                  MapperID mid, Processor p)
       : runtime(rt), mapper(mp), mapper_id(mid), processor(p),
-        mapper_lock(Reservation::create_reservation()), next_mapper_event(1)
+        mapper_lock(Reservation::create_reservation()), next_mapper_event(1),
+        correct_speculations(0), misspeculations(0)
     //--------------------------------------------------------------------------
     {
     }
@@ -1012,6 +1014,42 @@ namespace Legion {
       finish_mapper_call(info);
     }
 
+    //--------------------------------------------------------------------------
+    void MapperManager::invoke_map_task_batch(
+                                    Mapper::MapTaskBatchInput *input,
+                                    Mapper::MapTaskBatchOutput *output,
+                                    std::map<PhysicalManager*,
+                                      std::pair<unsigned,bool> > *acquired,
+                                    bool first_invocation,
+                                    MappingCallInfo *info)
+    //--------------------------------------------------------------------------
+    {
+      if (info == NULL)
+      {
+        RtEvent continuation_precondition;
+        info = begin_mapper_call(MAP_TASK_BATCH_CALL,
+                             NULL, first_invocation, continuation_precondition);
+        if (continuation_precondition.exists())
+        {
+          MapperContinuation3<Mapper::MapTaskBatchInput,
+                              Mapper::MapTaskBatchOutput,
+                              std::map<PhysicalManager*,
+                                       std::pair<unsigned,bool> >,
+                              &MapperManager::invoke_map_task_batch>
+                                continuation(this, input, output, 
+                                             acquired, info);
+          continuation.defer(runtime, continuation_precondition);
+          return;
+        }
+      }
+      // There is no single operation for this call so the caller
+      // holds on to any instances the mapper acquires until it can 
+      // hand them off to the tasks that were mapped
+      info->acquired_instances = acquired;
+      mapper->map_task_batch(info, *input, *output);
+      finish_mapper_call(info);
+    }
+
     //--------------------------------------------------------------------------
     void MapperManager::invoke_select_steal_targets(
                                      Mapper::SelectStealingInput *input,
@@ -1254,6 +1292,25 @@ namespace Legion {
       resume_mapper_call(ctx);
     }
 
+    //--------------------------------------------------------------------------
+    void MapperManager::record_speculation(bool correct)
+    //--------------------------------------------------------------------------
+    {
+      if (correct)
+        __sync_fetch_and_add(&correct_speculations, 1);
+      else
+        __sync_fetch_and_add(&misspeculations, 1);
+    }
+
+    //--------------------------------------------------------------------------
+    void MapperManager::get_speculation_statistics(MappingCallInfo *ctx,
+                                  unsigned &correct, unsigned &misspeculated)
+    //--------------------------------------------------------------------------
+    {
+      correct = correct_speculations;
+      misspeculated = misspeculations;
+    }
+
     //--------------------------------------------------------------------------
     const ExecutionConstraintSet& MapperManager::find_execution_constraints(
                             MappingCallInfo *ctx, TaskID task_id, VariantID vid)
@@ -1645,7 +1702,8 @@ namespace Legion {
       pause_mapper_call(ctx);
       bool success = runtime->create_physical_instance(target_memory, 
         constraints, regions, result, mapper_id, processor, acquire, priority,
-        (ctx->operation == NULL) ? 0 : ctx->operation->get_unique_op_id());
+        (ctx->operation == NULL) ? 0 : ctx->operation->get_unique_op_id(),
+        find_creator_task_id(ctx));
       if (success && acquire)
         record_acquired_instance(ctx, result.impl, true/*created*/);
       resume_mapper_call(ctx);
@@ -1679,7 +1737,8 @@ namespace Legion {
       pause_mapper_call(ctx);
       bool success = runtime->create_physical_instance(target_memory, layout_id,
                       regions, result, mapper_id, processor, acquire, priority,
-             (ctx->operation == NULL) ? 0 : ctx->operation->get_unique_op_id());
+             (ctx->operation == NULL) ? 0 : ctx->operation->get_unique_op_id(),
+             find_creator_task_id(ctx));
       if (success && acquire)
         record_acquired_instance(ctx, result.impl, true/*created*/);
       resume_mapper_call(ctx);
@@ -1717,7 +1776,8 @@ namespace Legion {
                   constraints, regions, result, created, mapper_id, processor, 
                   acquire, priority, tight_region_bounds,
                   (ctx->operation == NULL) ? 0 :
-                   ctx->operation->get_unique_op_id());
+                   ctx->operation->get_unique_op_id(),
+                  find_creator_task_id(ctx));
       if (success && acquire)
         record_acquired_instance(ctx, result.impl, created);
       resume_mapper_call(ctx);
@@ -1755,7 +1815,8 @@ namespace Legion {
                    layout_id, regions, result, created, mapper_id, processor, 
                    acquire, priority, tight_region_bounds,
                    (ctx->operation == NULL) ? 0 : 
-                    ctx->operation->get_unique_op_id());
+                    ctx->operation->get_unique_op_id(),
+                   find_creator_task_id(ctx));
       if (success && acquire)
         record_acquired_instance(ctx, result.impl, created);
       resume_mapper_call(ctx);
@@ -2239,6 +2300,99 @@ namespace Legion {
       resume_mapper_call(ctx);
     }
 
+    //--------------------------------------------------------------------------
+    void MapperManager::get_memory_usage(MappingCallInfo *ctx,
+                                         Memory target_memory,
+                                         size_t &current_bytes,
+                                         size_t &peak_bytes)
+    //--------------------------------------------------------------------------
+    {
+      MemoryManager *manager = runtime->find_memory_manager(target_memory);
+      manager->find_mapper_usage(mapper_id, current_bytes, peak_bytes);
+    }
+
+    //--------------------------------------------------------------------------
+    void MapperManager::get_task_memory_usage(MappingCallInfo *ctx,
+                                              Memory target_memory,
+                                              TaskID task_id,
+                                              size_t &current_bytes,
+                                              size_t &peak_bytes)
+    //--------------------------------------------------------------------------
+    {
+      MemoryManager *manager = runtime->find_memory_manager(target_memory);
+      manager->find_task_usage(task_id, current_bytes, peak_bytes);
+    }
+
+    //--------------------------------------------------------------------------
+    void MapperManager::set_instance_pool_limit(MappingCallInfo *ctx,
+                                                Memory target_memory,
+                                                size_t max_bytes)
+    //--------------------------------------------------------------------------
+    {
+      if (target_memory.address_space() != runtime->address_space)
+      {
+        MessageDescriptor IGNORING_REMOTE_POOL_LIMIT(1723, "undefined");
+        log_run.warning(IGNORING_REMOTE_POOL_LIMIT.id(),
+                        "Ignoring request to set the instance pool limit "
+                        "of remote memory " IDFMT " in mapper call %s of "
+                        "mapper %s", target_memory.id, 
+                        get_mapper_call_name(ctx->kind), get_mapper_name());
+        return;
+      }
+      pause_mapper_call(ctx);
+      MemoryManager *manager = runtime->find_memory_manager(target_memory);
+      manager->set_instance_pool_limit(max_bytes);
+      resume_mapper_call(ctx);
+    }
+
+    //--------------------------------------------------------------------------
+    void MapperManager::set_eviction_policy(MappingCallInfo *ctx,
+                                            Memory target_memory,
+                                            EvictionPolicy policy)
+    //--------------------------------------------------------------------------
+    {
+      if (target_memory.address_space() != runtime->address_space)
+      {
+        MessageDescriptor IGNORING_REMOTE_EVICTION_POLICY(1724, "undefined");
+        log_run.warning(IGNORING_REMOTE_EVICTION_POLICY.id(),
+                        "Ignoring request to set the eviction policy "
+                        "of remote memory " IDFMT " in mapper call %s of "
+                        "mapper %s", target_memory.id, 
+                        get_mapper_call_name(ctx->kind), get_mapper_name());
+        return;
+      }
+      MemoryManager *manager = runtime->find_memory_manager(target_memory);
+      manager->set_eviction_policy(policy);
+    }
+
+    //--------------------------------------------------------------------------
+    bool MapperManager::is_memory_under_pressure(MappingCallInfo *ctx,
+                                                 Memory target_memory)
+    //--------------------------------------------------------------------------
+    {
+      MemoryManager *manager = runtime->find_memory_manager(target_memory);
+      return manager->is_under_pressure();
+    }
+
+    //--------------------------------------------------------------------------
+    void MapperManager::prefetch_instance(MappingCallInfo *ctx,
+                                    Memory target_memory,
+                                    const LayoutConstraintSet &constraints,
+                                    const std::vector<LogicalRegion> &regions,
+                                    GCPriority priority)
+    //--------------------------------------------------------------------------
+    {
+      if (!target_memory.exists() || regions.empty())
+        return;
+      if (regions.size() > 1)
+        check_region_consistency(ctx, "prefetch_instance", regions);
+      MemoryManager *manager = runtime->find_memory_manager(target_memory);
+      manager->prefetch_instance(constraints, regions, mapper_id, processor,
+                    priority, (ctx->operation == NULL) ? 0 :
+                      ctx->operation->get_unique_op_id(),
+                    find_creator_task_id(ctx));
+    }
+
     //--------------------------------------------------------------------------
     void MapperManager::record_acquired_instance(MappingCallInfo *ctx,
                                          PhysicalManager *manager, bool created)
@@ -2282,6 +2436,18 @@ namespace Legion {
       acquired.erase(finder);
     }
 
+    //--------------------------------------------------------------------------
+    /*static*/ TaskID MapperManager::find_creator_task_id(MappingCallInfo *info)
+    //--------------------------------------------------------------------------
+    {
+      // Instances made on behalf of anything other than a task are
+      // accounted to task ID 0
+      if ((info->operation == NULL) ||
+          (info->operation->get_operation_kind() != Operation::TASK_OP_KIND))
+        return 0;
+      return static_cast<TaskOp*>(info->operation)->task_id;
+    }
+
     //--------------------------------------------------------------------------
     void MapperManager::check_region_consistency(MappingCallInfo *info,
                                                  const char *call_name,
@@ -2910,12 +3076,14 @@ namespace Legion {
           Realm::Clock::current_time_in_nanoseconds();
         runtime->profiler->record_mapper_call(info->kind, 
             (info->operation == NULL) ? 0 : info->operation->get_unique_op_id(),
-            info->start_time, stop_time); 
+            info->start_time, stop_time, mapper_id, processor, 
+            info->wait_time); 
       }
       info->resume = RtUserEvent::NO_RT_USER_EVENT;
       info->operation = NULL;
       info->acquired_instances = NULL;
       info->start_time = 0;
+      info->wait_time = 0;
       available_infos.push_back(info);
     }
 
@@ -3179,7 +3347,18 @@ namespace Legion {
           executing_call = info;
       }
       if (wait_on.exists())
-        wait_on.lg_wait();
+      {
+        if (runtime->profiler != NULL)
+        {
+          const unsigned long long start = 
+            Realm::Clock::current_time_in_nanoseconds();
+          wait_on.lg_wait();
+          info->wait_time += 
+            Realm::Clock::current_time_in_nanoseconds() - start;
+        }
+        else
+          wait_on.lg_wait();
+      }
 #ifdef DEBUG_LEGION
       assert(executing_call == info);
 #endif
@@ -3346,7 +3525,18 @@ namespace Legion {
         }
       }
       if (wait_on.exists())
-        wait_on.lg_wait();
+      {
+        if (runtime->profiler != NULL)
+        {
+          const unsigned long long start = 
+            Realm::Clock::current_time_in_nanoseconds();
+          wait_on.lg_wait();
+          info->wait_time += 
+            Realm::Clock::current_time_in_nanoseconds() - start;
+        }
+        else
+          wait_on.lg_wait();
+      }
     }
 
     //--------------------------------------------------------------------------
@@ -3522,7 +3712,7 @@ namespace Legion {
     //--------------------------------------------------------------------------
     MapperContinuation::MapperContinuation(MapperManager *man,
                                            MappingCallInfo *i)
-      : manager(man), info(i)
+      : manager(man), info(i), defer_time(0)
     //--------------------------------------------------------------------------
     {
     }
@@ -3534,6 +3724,8 @@ namespace Legion {
     {
       ContinuationArgs args;
       args.continuation = this;
+      if (runtime->profiler != NULL)
+        defer_time = Realm::Clock::current_time_in_nanoseconds();
       RtEvent wait_on = runtime->issue_runtime_meta_task(args,
                        LG_LATENCY_PRIORITY, op, precondition);
       wait_on.lg_wait();
@@ -3544,7 +3736,14 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       const ContinuationArgs *conargs = (const ContinuationArgs*)args;
-      conargs->continuation->execute();
+      // Calls queued behind other calls in the mapper were waiting 
+      // from the time they were deferred until now
+      MapperContinuation *continuation = conargs->continuation;
+      if ((continuation->info != NULL) && (continuation->defer_time > 0))
+        continuation->info->wait_time += 
+          Realm::Clock::current_time_in_nanoseconds() - 
+          continuation->defer_time;
+      continuation->execute();
     }
 
   };
@@ -34,6 +34,8 @@ namespace Legion {
       std::map<PhysicalManager*,
         std::pair<unsigned/*count*/,bool/*created*/> >* acquired_instances;
       unsigned long long                start_time;
+      // Time spent waiting to run in the mapper (for the profiler)
+      unsigned long long                wait_time;
     };
 
     /**
@@ -244,6 +246,12 @@ namespace Legion {
                                       Mapper::SelectMappingOutput *output,
                                       bool first_invocation = true,
                                       MappingCallInfo *info = NULL);
+      void invoke_map_task_batch(Mapper::MapTaskBatchInput *input,
+                                 Mapper::MapTaskBatchOutput *output,
+                                 std::map<PhysicalManager*,
+                                  std::pair<unsigned,bool> > *acquired,
+                                 bool first_invocation = true,
+                                 MappingCallInfo *info = NULL);
       void invoke_select_steal_targets(Mapper::SelectStealingInput *input,
                                        Mapper::SelectStealingOutput *output,
                                        bool first_invocation = true,
@@ -294,6 +302,10 @@ namespace Legion {
       bool has_mapper_event_triggered(MappingCallInfo *ctx, MapperEvent event);
       void trigger_mapper_event(MappingCallInfo *ctx, MapperEvent event);
       void wait_on_mapper_event(MappingCallInfo *ctx, MapperEvent event);
+    public:
+      void record_speculation(bool correct);
+      void get_speculation_statistics(MappingCallInfo *ctx, 
+                                unsigned &correct, unsigned &misspeculated);
     public:
       const ExecutionConstraintSet& 
         find_execution_constraints(MappingCallInfo *ctx, 
@@ -387,6 +399,22 @@ namespace Legion {
                                     const std::vector<MappingInstance> &insts);
       void release_instances(       MappingCallInfo *ctx, const std::vector<
                                     std::vector<MappingInstance> > &instances);
+    public:
+      void get_memory_usage(MappingCallInfo *ctx, Memory target_memory,
+                            size_t &current_bytes, size_t &peak_bytes);
+      void get_task_memory_usage(MappingCallInfo *ctx, Memory target_memory,
+                                 TaskID task_id, size_t &current_bytes,
+                                 size_t &peak_bytes);
+      void set_instance_pool_limit(MappingCallInfo *ctx, 
+                                   Memory target_memory, size_t max_bytes);
+      void set_eviction_policy(MappingCallInfo *ctx, Memory target_memory,
+                               EvictionPolicy policy);
+      bool is_memory_under_pressure(MappingCallInfo *ctx, 
+                                    Memory target_memory);
+      void prefetch_instance(MappingCallInfo *ctx, Memory target_memory,
+                             const LayoutConstraintSet &constraints,
+                             const std::vector<LogicalRegion> &regions,
+                             GCPriority priority);
     public:
       void record_acquired_instance(MappingCallInfo *info, 
                                     PhysicalManager *manager, bool created);
@@ -394,6 +422,7 @@ namespace Legion {
                                      PhysicalManager *manager);
       void check_region_consistency(MappingCallInfo *info, const char *call,
                                     const std::vector<LogicalRegion> &regions);
+      static TaskID find_creator_task_id(MappingCallInfo *info);
       bool perform_local_acquires(MappingCallInfo *info,
                                   const std::vector<MappingInstance> &instances,
                        std::map<MemoryManager*,AcquireStatus> &acquire_requests,
@@ -536,6 +565,10 @@ namespace Legion {
     protected:
       unsigned next_mapper_event;
       std::map<unsigned,RtUserEvent> mapper_events;
+    protected:
+      // Outcomes of the predicated operations this mapper speculated on
+      unsigned correct_speculations;
+      unsigned misspeculations;
     };
 
     /**
@@ -655,6 +688,7 @@ namespace Legion {
     public:
       MapperManager *const manager;
       MappingCallInfo *const info;
+      unsigned long long defer_time;
     };
 
     template<typename T1,
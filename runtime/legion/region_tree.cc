@@ -39,15 +39,23 @@ namespace Legion {
 
     //--------------------------------------------------------------------------
     RegionTreeForest::RegionTreeForest(Runtime *rt)
-      : runtime(rt)
+      : runtime(rt), intersection_hits(0), intersection_misses(0),
+        intersection_evictions(0)
     //--------------------------------------------------------------------------
     {
       this->lookup_lock = Reservation::create_reservation();
+      index_nodes.initialize(runtime->runtime_stride);
+      index_parts.initialize(runtime->runtime_stride);
+      field_nodes.initialize(runtime->runtime_stride);
+      region_nodes.initialize(runtime->runtime_stride);
+      part_nodes.initialize(runtime->runtime_stride);
+      tree_nodes.initialize(runtime->runtime_stride, LEGION_TREE_ID_MASK);
     }
 
     //--------------------------------------------------------------------------
     RegionTreeForest::RegionTreeForest(const RegionTreeForest &rhs)
-      : runtime(NULL)
+      : runtime(NULL), intersection_hits(0), intersection_misses(0),
+        intersection_evictions(0)
     //--------------------------------------------------------------------------
     {
       // should never be called
@@ -58,34 +66,57 @@ namespace Legion {
     RegionTreeForest::~RegionTreeForest(void)
     //--------------------------------------------------------------------------
     {
+      std::vector<IndexSpaceNode*> index_space_nodes;
+      index_nodes.get_values(index_space_nodes);
       // Log any index spaces with allocators
       if (Runtime::legion_spy_enabled)
       {
-        for (std::map<IndexSpace,IndexSpaceNode*>::const_iterator it = 
-              index_nodes.begin(); it != index_nodes.end(); it++)
+        for (std::vector<IndexSpaceNode*>::const_iterator it = 
+              index_space_nodes.begin(); it != index_space_nodes.end(); it++)
         {
-          const Domain &dom = it->second->get_domain_no_wait();
+          const Domain &dom = (*it)->get_domain_no_wait();
           if (dom.get_dim() == 0)
-            IndexSpaceNode::log_index_space_domain(it->first, dom);
+            IndexSpaceNode::log_index_space_domain((*it)->handle, dom);
         }
       }
+      const unsigned long long lookups = 
+        intersection_hits + intersection_misses;
+      if (lookups > 0)
+        log_index.info("Intersection cache: %llu hits, %llu misses "
+                       "(%.1f%% hit rate), %llu evictions",
+                       intersection_hits, intersection_misses,
+                       100.0 * intersection_hits / lookups,
+                       intersection_evictions);
       lookup_lock.destroy_reservation();
       lookup_lock = Reservation::NO_RESERVATION;
-      for (std::map<LogicalPartition,PartitionNode*>::const_iterator it = 
-            part_nodes.begin(); it != part_nodes.end(); it++)
-        delete it->second;
-      for (std::map<LogicalRegion,RegionNode*>::const_iterator it = 
-            region_nodes.begin(); it != region_nodes.end(); it++)
-        delete it->second;
-      for (std::map<FieldSpace,FieldSpaceNode*>::const_iterator it = 
-            field_nodes.begin(); it != field_nodes.end(); it++)
-        delete it->second;
-      for (std::map<IndexPartition,IndexPartNode*>::const_iterator it = 
-            index_parts.begin(); it != index_parts.end(); it++)
-        delete it->second;
-      for (std::map<IndexSpace,IndexSpaceNode*>::const_iterator it = 
-            index_nodes.begin(); it != index_nodes.end(); it++)
-        delete it->second;
+      std::vector<std::vector<PartitionNode*> > partition_nodes;
+      part_nodes.get_values(partition_nodes);
+      for (std::vector<std::vector<PartitionNode*> >::const_iterator it = 
+            partition_nodes.begin(); it != partition_nodes.end(); it++)
+        for (std::vector<PartitionNode*>::const_iterator pit = 
+              it->begin(); pit != it->end(); pit++)
+          delete (*pit);
+      std::vector<std::vector<RegionNode*> > logical_region_nodes;
+      region_nodes.get_values(logical_region_nodes);
+      for (std::vector<std::vector<RegionNode*> >::const_iterator it = 
+            logical_region_nodes.begin(); it != 
+            logical_region_nodes.end(); it++)
+        for (std::vector<RegionNode*>::const_iterator rit = 
+              it->begin(); rit != it->end(); rit++)
+          delete (*rit);
+      std::vector<FieldSpaceNode*> field_space_nodes;
+      field_nodes.get_values(field_space_nodes);
+      for (std::vector<FieldSpaceNode*>::const_iterator it = 
+            field_space_nodes.begin(); it != field_space_nodes.end(); it++)
+        delete (*it);
+      std::vector<IndexPartNode*> index_part_nodes;
+      index_parts.get_values(index_part_nodes);
+      for (std::vector<IndexPartNode*>::const_iterator it = 
+            index_part_nodes.begin(); it != index_part_nodes.end(); it++)
+        delete (*it);
+      for (std::vector<IndexSpaceNode*>::const_iterator it = 
+            index_space_nodes.begin(); it != index_space_nodes.end(); it++)
+        delete (*it);
     }
 
     //--------------------------------------------------------------------------
@@ -647,12 +678,11 @@ namespace Legion {
 #ifdef DEBUG_LEGION
         assert(disjointness_event.exists());
 #endif
-        // Launch a task to compute the disjointness
-        DisjointnessArgs args;
-        args.handle = pid;
-        args.ready = disjointness_event;
-        runtime->issue_runtime_meta_task(args, LG_LATENCY_PRIORITY, NULL,
-                                         Runtime::protect_event(domain_ready));
+        // The domains of the children are computed by an operation
+        // that might still be far away, and nobody may ever ask if
+        // they are disjoint, so only test it once someone does
+        partition_node->defer_disjointness(disjointness_event,
+                                      Runtime::protect_event(domain_ready));
 #ifdef LEGION_SPY
         LegionSpy::log_event_dependence(domain_ready, disjointness_event);
 #endif
@@ -1378,6 +1408,10 @@ namespace Legion {
                                                   AddressSpaceID source)
     //--------------------------------------------------------------------------
     {
+      // A late destruction message can arrive after the
+      // tree has already been reclaimed on this node
+      if (!has_tree(handle.get_tree_id(), true/*local only*/))
+        return;
       RegionNode *node = get_node(handle);
       node->destroy_node(source);
     }
@@ -1387,6 +1421,8 @@ namespace Legion {
                                                      AddressSpaceID source)
     //--------------------------------------------------------------------------
     {
+      if (!has_tree(handle.get_tree_id(), true/*local only*/))
+        return;
       PartitionNode *node = get_node(handle);
       node->destroy_node(source);
     }
@@ -1774,6 +1810,8 @@ namespace Legion {
                                                LogicalRegion handle)
     //--------------------------------------------------------------------------
     {
+      if (!has_tree(handle.get_tree_id(), true/*local only*/))
+        return;
       RegionNode *node = get_node(handle);
       VersioningInvalidator invalidator(ctx);
       node->visit_node(&invalidator);
@@ -1783,15 +1821,15 @@ namespace Legion {
     void RegionTreeForest::invalidate_all_versions(RegionTreeContext ctx)
     //--------------------------------------------------------------------------
     {
-      std::map<RegionTreeID,RegionNode*> trees;
+      std::vector<RegionNode*> trees;
       {
         AutoLock l_lock(lookup_lock,1,false/*exclusive*/);
-        trees = tree_nodes;
+        tree_nodes.get_values(trees);
       }
       VersioningInvalidator invalidator(ctx); 
-      for (std::map<RegionTreeID,RegionNode*>::const_iterator it = 
+      for (std::vector<RegionNode*>::const_iterator it = 
             trees.begin(); it != trees.end(); it++)
-        it->second->visit_node(&invalidator);
+        (*it)->visit_node(&invalidator);
     }
 
     //--------------------------------------------------------------------------
@@ -1908,6 +1946,10 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       DETAILED_PROFILER(runtime, REGION_TREE_INVALIDATE_CONTEXT_CALL);
+      // If the tree has been destroyed and reclaimed, or was never
+      // made here, then there is no state to invalidate
+      if (!has_tree(handle.get_tree_id(), true/*local only*/))
+        return;
       RegionNode *top_node = get_node(handle);
       CurrentInvalidator invalidator(ctx.get_id(), users_only);
       top_node->visit_node(&invalidator);
@@ -3394,16 +3436,16 @@ namespace Legion {
     void RegionTreeForest::check_context_state(RegionTreeContext ctx)
     //--------------------------------------------------------------------------
     {
-      std::map<RegionTreeID,RegionNode*> trees;
+      std::vector<RegionNode*> trees;
       {
         AutoLock l_lock(lookup_lock,1,false/*exclusive*/);
-        trees = tree_nodes;
+        tree_nodes.get_values(trees);
       }
       CurrentInitializer init(ctx.get_id());
-      for (std::map<RegionTreeID,RegionNode*>::const_iterator it = 
+      for (std::vector<RegionNode*>::const_iterator it = 
             trees.begin(); it != trees.end(); it++)
       {
-        it->second->visit_node(&init);
+        (*it)->visit_node(&init);
       }
     }
 
@@ -3424,14 +3466,13 @@ namespace Legion {
       {
         // Hold the lookup lock while modifying the lookup table
         AutoLock l_lock(lookup_lock);
-        std::map<IndexSpace,IndexSpaceNode*>::const_iterator it =
-          index_nodes.find(sp);
-        if (it != index_nodes.end())
+        IndexSpaceNode *&entry = index_nodes.insert(sp.id);
+        if (entry != NULL)
         {
           delete result;
-          return it->second;
+          return entry;
         }
-        index_nodes[sp] = result;
+        entry = result;
         index_space_requests.erase(sp);
       }
       if (parent != NULL)
@@ -3458,14 +3499,13 @@ namespace Legion {
       {
         // Hold the lookup lock while modifying the lookup table
         AutoLock l_lock(lookup_lock);
-        std::map<IndexSpace,IndexSpaceNode*>::const_iterator it =
-          index_nodes.find(sp);
-        if (it != index_nodes.end())
+        IndexSpaceNode *&entry = index_nodes.insert(sp.id);
+        if (entry != NULL)
         {
           delete result;
-          return it->second;
+          return entry;
         }
-        index_nodes[sp] = result;
+        entry = result;
         index_space_requests.erase(sp);
       }
       if (parent != NULL)
@@ -3494,14 +3534,13 @@ namespace Legion {
       {
         // Hold the lookup lock while modifying the lookup table
         AutoLock l_lock(lookup_lock);
-        std::map<IndexSpace,IndexSpaceNode*>::const_iterator it =
-          index_nodes.find(sp);
-        if (it != index_nodes.end())
+        IndexSpaceNode *&entry = index_nodes.insert(sp.id);
+        if (entry != NULL)
         {
           delete result;
-          return it->second;
+          return entry;
         }
-        index_nodes[sp] = result;
+        entry = result;
         index_space_requests.erase(sp);
       }
       if (parent != NULL)
@@ -3529,14 +3568,13 @@ namespace Legion {
       {
         // Hold the lookup lock while modifying the lookup table
         AutoLock l_lock(lookup_lock);
-        std::map<IndexPartition,IndexPartNode*>::const_iterator it =
-          index_parts.find(p);
-        if (it != index_parts.end())
+        IndexPartNode *&entry = index_parts.insert(p.id);
+        if (entry != NULL)
         {
           delete result;
-          return it->second;
+          return entry;
         }
-        index_parts[p] = result;
+        entry = result;
         index_part_requests.erase(p);
       }
       if (parent != NULL)
@@ -3564,14 +3602,13 @@ namespace Legion {
       {
         // Hold the lookup lock while modifying the lookup table
         AutoLock l_lock(lookup_lock);
-        std::map<IndexPartition,IndexPartNode*>::const_iterator it =
-          index_parts.find(p);
-        if (it != index_parts.end())
+        IndexPartNode *&entry = index_parts.insert(p.id);
+        if (entry != NULL)
         {
           delete result;
-          return it->second;
+          return entry;
         }
-        index_parts[p] = result;
+        entry = result;
         index_part_requests.erase(p);
       }
       if (parent != NULL)
@@ -3590,14 +3627,13 @@ namespace Legion {
 #endif
       // Hold the lookup lock while modifying the lookup table
       AutoLock l_lock(lookup_lock);
-      std::map<FieldSpace,FieldSpaceNode*>::const_iterator it =
-        field_nodes.find(space);
-      if (it != field_nodes.end())
+      FieldSpaceNode *&entry = field_nodes.insert(space.id);
+      if (entry != NULL)
       {
         delete result;
-        return it->second;
+        return entry;
       }
-      field_nodes[space] = result;
+      entry = result;
       field_space_requests.erase(space);
       return result;
     }
@@ -3613,14 +3649,13 @@ namespace Legion {
 #endif
       // Hold the lookup lock while modifying the lookup table
       AutoLock l_lock(lookup_lock);
-      std::map<FieldSpace,FieldSpaceNode*>::const_iterator it =
-        field_nodes.find(space);
-      if (it != field_nodes.end())
+      FieldSpaceNode *&entry = field_nodes.insert(space.id);
+      if (entry != NULL)
       {
         delete result;
-        return it->second;
+        return entry;
       }
-      field_nodes[space] = result;
+      entry = result;
       field_space_requests.erase(space);
       return result;
     }
@@ -3650,25 +3685,25 @@ namespace Legion {
         // Hold the lookup lock when modifying the lookup table
         AutoLock l_lock(lookup_lock);
         // Check to see if it already exists
-        std::map<LogicalRegion,RegionNode*>::const_iterator it =
-          region_nodes.find(r);
-        if (it != region_nodes.end())
+        RegionNode *existing = find_local_node(r);
+        if (existing != NULL)
         {
           // It already exists, delete our copy and return
           // the one that has already been made
           delete result;
-          return it->second;
+          return existing;
         }
-        // Now we can add it to the map
-        region_nodes[r] = result;
+        // Now we can add it to the table
+        region_nodes.insert(r.index_space.id).push_back(result);
         // If this is a top level region add it to the collection
         // of top level tree IDs
         if (parent == NULL)
         {
+          RegionNode *&tree_entry = tree_nodes.insert(r.tree_id);
 #ifdef DEBUG_LEGION
-          assert(tree_nodes.find(r.tree_id) == tree_nodes.end());
+          assert(tree_entry == NULL);
 #endif
-          tree_nodes[r.tree_id] = result;
+          tree_entry = result;
           region_tree_requests.erase(r.tree_id);
         }
       }
@@ -3704,17 +3739,16 @@ namespace Legion {
       {
         // Hole the lookup lock when modifying the lookup table
         AutoLock l_lock(lookup_lock);
-        std::map<LogicalPartition,PartitionNode*>::const_iterator it =
-          part_nodes.find(p);
-        if (it != part_nodes.end())
+        PartitionNode *existing = find_local_node(p);
+        if (existing != NULL)
         {
           // It already exists, delete our copy and
           // return the one that has already been made
           delete result;
-          return it->second;
+          return existing;
         }
-        // Now we can put the node in the map
-        part_nodes[p] = result;
+        // Now we can put the node in the table
+        part_nodes.insert(p.index_partition.id).push_back(result);
       }
       // Now we can make the other ways of accessing the node available
       row_src->add_instance(result);
@@ -3737,10 +3771,9 @@ namespace Legion {
       }
       {
         AutoLock l_lock(lookup_lock,1,false/*exclusive*/); 
-        std::map<IndexSpace,IndexSpaceNode*>::const_iterator finder = 
-          index_nodes.find(space);
-        if (finder != index_nodes.end())
-          return finder->second;
+        IndexSpaceNode **finder = index_nodes.find(space.id);
+        if (finder != NULL)
+          return *finder;
       }
       // Couldn't find it, so send a request to the owner node
       AddressSpace owner = IndexSpaceNode::get_owner_space(space, runtime);
@@ -3757,10 +3790,9 @@ namespace Legion {
       {
         AutoLock l_lock(lookup_lock);
         // Check to make sure we didn't loose the race
-        std::map<IndexSpace,IndexSpaceNode*>::const_iterator finder = 
-          index_nodes.find(space);
-        if (finder != index_nodes.end())
-          return finder->second;
+        IndexSpaceNode **finder = index_nodes.find(space.id);
+        if (finder != NULL)
+          return *finder;
         // Still doesn't exists, see if we sent a request already
         std::map<IndexSpace,RtEvent>::const_iterator wait_finder = 
           index_space_requests.find(space);
@@ -3780,9 +3812,8 @@ namespace Legion {
       // Wait on the event
       wait_on.lg_wait();
       AutoLock l_lock(lookup_lock,1,false/*exclusive*/);
-      std::map<IndexSpace,IndexSpaceNode*>::const_iterator finder = 
-          index_nodes.find(space);
-      if (finder == index_nodes.end())
+      IndexSpaceNode **finder = index_nodes.find(space.id);
+      if (finder == NULL)
       {
         log_index.error("Unable to find entry for index space %x."
                         "This is definitely a runtime bug.", space.id);
@@ -3791,7 +3822,7 @@ namespace Legion {
 #endif
         exit(ERROR_INVALID_INDEX_SPACE_ENTRY);
       }
-      return finder->second;
+      return *finder;
     }
 
     //--------------------------------------------------------------------------
@@ -3808,10 +3839,9 @@ namespace Legion {
       }
       {
         AutoLock l_lock(lookup_lock,1,false/*exclusive*/);
-        std::map<IndexPartition,IndexPartNode*>::const_iterator finder =
-          index_parts.find(part);
-        if (finder != index_parts.end())
-          return finder->second;
+        IndexPartNode **finder = index_parts.find(part.id);
+        if (finder != NULL)
+          return *finder;
       }
       // Couldn't find it, so send a request to the owner node
       AddressSpace owner = IndexPartNode::get_owner_space(part, runtime);
@@ -3828,10 +3858,9 @@ namespace Legion {
         // Retake the lock in exclusive mode and make
         // sure we didn't loose the race
         AutoLock l_lock(lookup_lock);
-        std::map<IndexPartition,IndexPartNode*>::const_iterator finder =
-          index_parts.find(part);
-        if (finder != index_parts.end())
-          return finder->second;
+        IndexPartNode **finder = index_parts.find(part.id);
+        if (finder != NULL)
+          return *finder;
         // See if we've already sent the request or not
         std::map<IndexPartition,RtEvent>::const_iterator wait_finder = 
           index_part_requests.find(part);
@@ -3851,9 +3880,8 @@ namespace Legion {
       // Wait for the event
       wait_on.lg_wait();
       AutoLock l_lock(lookup_lock,1,false/*exclusive*/);
-      std::map<IndexPartition,IndexPartNode*>::const_iterator finder = 
-        index_parts.find(part);
-      if (finder == index_parts.end())
+      IndexPartNode **finder = index_parts.find(part.id);
+      if (finder == NULL)
       {
         log_index.error("Unable to find entry for index partition %x. "
                         "This is definitely a runtime bug.", part.id);
@@ -3862,7 +3890,7 @@ namespace Legion {
 #endif
         exit(ERROR_INVALID_INDEX_PART_ENTRY);
       }
-      return finder->second;
+      return *finder;
     }
 
     //--------------------------------------------------------------------------
@@ -3879,10 +3907,9 @@ namespace Legion {
       }
       {
         AutoLock l_lock(lookup_lock,1,false/*exclusive*/);
-        std::map<FieldSpace,FieldSpaceNode*>::const_iterator finder = 
-          field_nodes.find(space);
-        if (finder != field_nodes.end())
-          return finder->second;
+        FieldSpaceNode **finder = field_nodes.find(space.id);
+        if (finder != NULL)
+          return *finder;
       }
       // Couldn't find it, so send a request to the owner node
       AddressSpaceID owner = FieldSpaceNode::get_owner_space(space, runtime); 
@@ -3899,10 +3926,9 @@ namespace Legion {
         // Retake the lock in exclusive mode and 
         // check to make sure we didn't loose the race
         AutoLock l_lock(lookup_lock);
-        std::map<FieldSpace,FieldSpaceNode*>::const_iterator finder = 
-          field_nodes.find(space);
-        if (finder != field_nodes.end())
-          return finder->second;
+        FieldSpaceNode **finder = field_nodes.find(space.id);
+        if (finder != NULL)
+          return *finder;
         // Now see if we've already sent a request
         std::map<FieldSpace,RtEvent>::const_iterator wait_finder = 
           field_space_requests.find(space);
@@ -3922,9 +3948,8 @@ namespace Legion {
       // Wait for the event to be ready
       wait_on.lg_wait();
       AutoLock l_lock(lookup_lock,1,false/*exclusive*/);
-      std::map<FieldSpace,FieldSpaceNode*>::const_iterator finder = 
-        field_nodes.find(space);
-      if (finder == field_nodes.end())
+      FieldSpaceNode **finder = field_nodes.find(space.id);
+      if (finder == NULL)
       {
         log_field.error("Unable to find entry for field space %x. "
                         "This is definitely a runtime bug.", space.id);
@@ -3933,7 +3958,7 @@ namespace Legion {
 #endif
         exit(ERROR_INVALID_FIELD_SPACE_ENTRY);
       }
-      return finder->second;
+      return *finder;
     }
 
     //--------------------------------------------------------------------------
@@ -3953,14 +3978,13 @@ namespace Legion {
       bool has_top_level_region;
       {
         AutoLock l_lock(lookup_lock,1,false/*exclusive*/);
-        std::map<LogicalRegion,RegionNode*>::const_iterator it = 
-          region_nodes.find(handle);
-        if (it != region_nodes.end())
-          return it->second;
+        RegionNode *result = find_local_node(handle);
+        if (result != NULL)
+          return result;
         // Check to see if we have the top level region
         if (need_check)
           has_top_level_region = 
-            (tree_nodes.find(handle.get_tree_id()) != tree_nodes.end());
+            (tree_nodes.find(handle.get_tree_id()) != NULL);
         else
           has_top_level_region = true;
       }
@@ -3980,7 +4004,7 @@ namespace Legion {
         {
           // Retake the lock and make sure we didn't loose the race
           AutoLock l_lock(lookup_lock);
-          if (tree_nodes.find(handle.get_tree_id()) == tree_nodes.end())
+          if (tree_nodes.find(handle.get_tree_id()) == NULL)
           {
             // Still don't have it, see if we need to request it
             std::map<RegionTreeID,RtEvent>::const_iterator finder = 
@@ -4001,10 +4025,9 @@ namespace Legion {
           else
           {
             // We lost the race and it may be here now
-            std::map<LogicalRegion,RegionNode*>::const_iterator it = 
-              region_nodes.find(handle);
-            if (it != region_nodes.end())
-              return it->second;
+            RegionNode *result = find_local_node(handle);
+            if (result != NULL)
+              return result;
           }
         }
         // If we did find something to wait on, do that now
@@ -4014,10 +4037,9 @@ namespace Legion {
           // Retake the lock and see again if the handle we
           // were looking for was the top-level node or not
           AutoLock l_lock(lookup_lock,1,false/*exclusive*/);
-          std::map<LogicalRegion,RegionNode*>::const_iterator it = 
-            region_nodes.find(handle);
-          if (it != region_nodes.end())
-            return it->second;
+          RegionNode *result = find_local_node(handle);
+          if (result != NULL)
+            return result;
         }
       }
       // Otherwise it hasn't been made yet, so make it
@@ -4054,10 +4076,9 @@ namespace Legion {
       // Check to see if the node already exists
       {
         AutoLock l_lock(lookup_lock,1,false/*exclusive*/);
-        std::map<LogicalPartition,PartitionNode*>::const_iterator it =
-          part_nodes.find(handle);
-        if (it != part_nodes.end())
-          return it->second;
+        PartitionNode *result = find_local_node(handle);
+        if (result != NULL)
+          return result;
       }
       // Otherwise it hasn't been made yet so make it
       IndexPartNode *index_node = get_node(handle.index_partition);
@@ -4087,10 +4108,9 @@ namespace Legion {
       }
       {
         AutoLock l_lock(lookup_lock,1,false/*exclusive*/);
-        std::map<RegionTreeID,RegionNode*>::const_iterator finder = 
-          tree_nodes.find(tid);
-        if (finder != tree_nodes.end())
-          return finder->second;
+        RegionNode **finder = tree_nodes.find(tid);
+        if (finder != NULL)
+          return *finder;
       }
       // Couldn't find it, so send a request to the owner node
       AddressSpaceID owner = RegionTreeNode::get_owner_space(tid, runtime);
@@ -4107,10 +4127,9 @@ namespace Legion {
         // Retake the lock in exclusive mode and check to
         // make sure that we didn't lose the race
         AutoLock l_lock(lookup_lock);
-        std::map<RegionTreeID,RegionNode*>::const_iterator finder = 
-          tree_nodes.find(tid);
-        if (finder != tree_nodes.end())
-          return finder->second;
+        RegionNode **finder = tree_nodes.find(tid);
+        if (finder != NULL)
+          return *finder;
         // Now see if we've already send a request
         std::map<RegionTreeID,RtEvent>::const_iterator req_finder =
           region_tree_requests.find(tid);
@@ -4129,9 +4148,8 @@ namespace Legion {
       }
       wait_on.lg_wait();
       AutoLock l_lock(lookup_lock,1,false/*exclusive*/);
-      std::map<RegionTreeID,RegionNode*>::const_iterator finder = 
-          tree_nodes.find(tid);
-      if (finder == tree_nodes.end())
+      RegionNode **finder = tree_nodes.find(tid);
+      if (finder == NULL)
       {
         log_region.error("Unable to find top-level tree entry for "
                          "region tree %d.  This is either a runtime "
@@ -4143,7 +4161,7 @@ namespace Legion {
 #endif
         exit(ERROR_INVALID_TREE_ENTRY);
       }
-      return finder->second;
+      return *finder;
     }
 
     //--------------------------------------------------------------------------
@@ -4152,9 +4170,7 @@ namespace Legion {
     {
       {
         AutoLock l_lock(lookup_lock,1,false/*exclusive*/); 
-        std::map<IndexSpace,IndexSpaceNode*>::const_iterator finder = 
-          index_nodes.find(space);
-        if (finder != index_nodes.end())
+        if (index_nodes.find(space.id) != NULL)
           return RtEvent::NO_RT_EVENT;
       }
       // Couldn't find it, so send a request to the owner node
@@ -4169,9 +4185,7 @@ namespace Legion {
       }
       AutoLock l_lock(lookup_lock);
       // Check to make sure we didn't loose the race
-      std::map<IndexSpace,IndexSpaceNode*>::const_iterator finder = 
-        index_nodes.find(space);
-      if (finder != index_nodes.end())
+      if (index_nodes.find(space.id) != NULL)
         return RtEvent::NO_RT_EVENT;
       // Still doesn't exists, see if we sent a request already
       std::map<IndexSpace,RtEvent>::const_iterator wait_finder = 
@@ -4190,13 +4204,120 @@ namespace Legion {
         return wait_finder->second;
     }
 
+    //--------------------------------------------------------------------------
+    void RegionTreeForest::reclaim_region_tree(RegionNode *root)
+    //--------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(root->parent == NULL);
+      assert(root->destroyed);
+      assert(root->tree_references == 0);
+#endif
+      const RegionTreeID tid = root->handle.get_tree_id();
+      // Nobody else is using this tree anymore so no need for node locks
+      std::vector<RegionNode*> regions;
+      std::vector<PartitionNode*> partitions;
+      root->gather_tree_nodes(regions, partitions);
+      // Pull the nodes out of the look-up tables before deleting them
+      {
+        AutoLock l_lock(lookup_lock);
+        tree_nodes.erase(tid);
+        for (std::vector<RegionNode*>::const_iterator it = 
+              regions.begin(); it != regions.end(); it++)
+        {
+          const IndexSpaceID key = (*it)->handle.index_space.id;
+          std::vector<RegionNode*> *nodes = region_nodes.find(key);
+#ifdef DEBUG_LEGION
+          assert(nodes != NULL);
+#endif
+          std::vector<RegionNode*>::iterator finder = 
+            std::find(nodes->begin(), nodes->end(), *it);
+#ifdef DEBUG_LEGION
+          assert(finder != nodes->end());
+#endif
+          nodes->erase(finder);
+          if (nodes->empty())
+            region_nodes.erase(key);
+        }
+        for (std::vector<PartitionNode*>::const_iterator it = 
+              partitions.begin(); it != partitions.end(); it++)
+        {
+          const IndexPartitionID key = (*it)->handle.index_partition.id;
+          std::vector<PartitionNode*> *nodes = part_nodes.find(key);
+#ifdef DEBUG_LEGION
+          assert(nodes != NULL);
+#endif
+          std::vector<PartitionNode*>::iterator finder = 
+            std::find(nodes->begin(), nodes->end(), *it);
+#ifdef DEBUG_LEGION
+          assert(finder != nodes->end());
+#endif
+          nodes->erase(finder);
+          if (nodes->empty())
+            part_nodes.erase(key);
+        }
+      }
+      // Unhook the nodes from their index space and field space nodes
+      root->column_source->remove_instance(root);
+      for (std::vector<PartitionNode*>::const_iterator it = 
+            partitions.begin(); it != partitions.end(); it++)
+      {
+        (*it)->row_source->remove_instance(*it);
+        delete (*it);
+      }
+      for (std::vector<RegionNode*>::const_iterator it = 
+            regions.begin(); it != regions.end(); it++)
+      {
+        (*it)->row_source->remove_instance(*it);
+        delete (*it);
+      }
+      // Only the node that handed out the tree ID can hand it out again
+      if (RegionTreeNode::get_owner_space(tid, runtime) == 
+          runtime->address_space)
+        runtime->free_region_tree_id(tid);
+    }
+
+    //--------------------------------------------------------------------------
+    RegionNode* RegionTreeForest::find_local_node(LogicalRegion handle)
+    //--------------------------------------------------------------------------
+    {
+      std::vector<RegionNode*> *nodes = 
+        region_nodes.find(handle.index_space.id);
+      if (nodes == NULL)
+        return NULL;
+      for (std::vector<RegionNode*>::const_iterator it = 
+            nodes->begin(); it != nodes->end(); it++)
+      {
+        if ((*it)->handle == handle)
+          return (*it);
+      }
+      return NULL;
+    }
+
+    //--------------------------------------------------------------------------
+    PartitionNode* RegionTreeForest::find_local_node(LogicalPartition handle)
+    //--------------------------------------------------------------------------
+    {
+      std::vector<PartitionNode*> *nodes = 
+        part_nodes.find(handle.index_partition.id);
+      if (nodes == NULL)
+        return NULL;
+      for (std::vector<PartitionNode*>::const_iterator it = 
+            nodes->begin(); it != nodes->end(); it++)
+      {
+        if ((*it)->handle == handle)
+          return (*it);
+      }
+      return NULL;
+    }
+
     //--------------------------------------------------------------------------
     bool RegionTreeForest::has_node(IndexSpace space, bool local_only)
     //--------------------------------------------------------------------------
     {
       {
         AutoLock l_lock(lookup_lock,1,false/*exclusive*/);
-        if (index_nodes.find(space) != index_nodes.end())
+        if (index_nodes.find(space.id) != NULL)
           return true;
         if (local_only)
           return false;
@@ -4210,7 +4331,7 @@ namespace Legion {
     {
       {
         AutoLock l_lock(lookup_lock,1,false/*exclusive*/);
-        if (index_parts.find(part) != index_parts.end())
+        if (index_parts.find(part.id) != NULL)
           return true;
         if (local_only)
           return false;
@@ -4224,7 +4345,7 @@ namespace Legion {
     {
       {
         AutoLock l_lock(lookup_lock,1,false/*exclusive*/);
-        if (field_nodes.find(space) != field_nodes.end())
+        if (field_nodes.find(space.id) != NULL)
           return true;
         if (local_only)
           return false;
@@ -4258,7 +4379,7 @@ namespace Legion {
     {
       {
         AutoLock l_lock(lookup_lock,1,false/*exclusive*/);
-        if (tree_nodes.find(tid) != tree_nodes.end())
+        if (tree_nodes.find(tid) != NULL)
           return true;
         if (local_only)
           return false;
@@ -4644,8 +4765,9 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       TreeStateLogger dump_logger; 
-      assert(region_nodes.find(region) != region_nodes.end());
-      region_nodes[region]->dump_logical_context(ctx, &dump_logger,
+      RegionNode *node = find_local_node(region);
+      assert(node != NULL);
+      node->dump_logical_context(ctx, &dump_logger,
                                  FieldMask(LEGION_FIELD_MASK_FIELD_ALL_ONES));
     }
 
@@ -4655,8 +4777,9 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       TreeStateLogger dump_logger;
-      assert(region_nodes.find(region) != region_nodes.end());
-      region_nodes[region]->dump_physical_context(ctx, &dump_logger,
+      RegionNode *node = find_local_node(region);
+      assert(node != NULL);
+      node->dump_physical_context(ctx, &dump_logger,
                                 FieldMask(LEGION_FIELD_MASK_FIELD_ALL_ONES));
     }
 #endif
@@ -4958,7 +5081,8 @@ namespace Legion {
 
     //--------------------------------------------------------------------------
     IndexTreeNode::IndexTreeNode(void)
-      : depth(0), color(ColorPoint()), context(NULL), destroyed(false)
+      : depth(0), color(ColorPoint()), context(NULL), destroyed(false),
+        intersection_cache_size(0), intersection_clock(0)
     //--------------------------------------------------------------------------
     {
     }
@@ -4967,7 +5091,7 @@ namespace Legion {
     IndexTreeNode::IndexTreeNode(ColorPoint c, unsigned d, 
                                  RegionTreeForest *ctx)
       : depth(d), color(c), context(ctx), destroyed(false),
-        node_lock(Reservation::create_reservation())
+        intersection_cache_size(0), intersection_clock(0)
     //--------------------------------------------------------------------------
     {
 #ifdef DEBUG_LEGION
@@ -4979,8 +5103,6 @@ namespace Legion {
     IndexTreeNode::~IndexTreeNode(void)
     //--------------------------------------------------------------------------
     {
-      node_lock.destroy_reservation();
-      node_lock = Reservation::NO_RESERVATION;
       for (LegionMap<SemanticTag,SemanticInfo>::aligned::iterator it = 
             semantic_info.begin(); it != semantic_info.end(); it++)
       {
@@ -4990,7 +5112,7 @@ namespace Legion {
             intersections.begin(); it != intersections.end(); it++)
       {
         IntersectInfo &info = it->second; 
-        for (std::set<Domain>::iterator dit = info.intersections.begin();
+        for (std::vector<Domain>::iterator dit = info.intersections.begin();
               dit != info.intersections.end(); dit++)
         {
           Realm::IndexSpace space = dit->get_index_space();
@@ -5001,6 +5123,93 @@ namespace Legion {
       intersections.clear();
     }
 
+    //--------------------------------------------------------------------------
+    const IndexTreeNode::IntersectInfo* IndexTreeNode::find_intersection(
+                                      IndexTreeNode *other, bool need_domains)
+    //--------------------------------------------------------------------------
+    {
+      std::map<IndexTreeNode*,IntersectInfo>::iterator finder = 
+        intersections.find(other);
+      // Only return the value if we didn't want the domains
+      // or we already have valid intersections
+      if ((finder == intersections.end()) || 
+          (need_domains && !finder->second.intersections_valid))
+      {
+        __sync_fetch_and_add(&context->intersection_misses, 1);
+        return NULL;
+      }
+      __sync_fetch_and_add(&context->intersection_hits, 1);
+      // We might only hold the lock in read-only mode, but it doesn't
+      // matter which of several racing lookups gets to set the time
+      finder->second.last_use = __sync_add_and_fetch(&intersection_clock, 1);
+      return &finder->second;
+    }
+
+    //--------------------------------------------------------------------------
+    const IndexTreeNode::IntersectInfo& IndexTreeNode::record_intersection(
+                                IndexTreeNode *other, const IntersectInfo &info)
+    //--------------------------------------------------------------------------
+    {
+      std::map<IndexTreeNode*,IntersectInfo>::iterator finder = 
+        intersections.find(other);
+      if (finder != intersections.end())
+      {
+        // If we lost the race to someone who did at least as much
+        // work as we did then keep what they recorded
+        if (finder->second.intersections_valid)
+        {
+          finder->second.last_use = 
+            __sync_add_and_fetch(&intersection_clock, 1);
+          return finder->second;
+        }
+        intersection_cache_size -= finder->second.cost();
+        finder->second = info;
+      }
+      else
+        finder = intersections.insert(
+            std::pair<IndexTreeNode*,IntersectInfo>(other, info)).first;
+      finder->second.last_use = __sync_add_and_fetch(&intersection_clock, 1);
+      intersection_cache_size += finder->second.cost();
+      if ((Runtime::max_intersection_cache > 0) &&
+          (intersection_cache_size > Runtime::max_intersection_cache))
+        evict_intersections(other);
+      return finder->second;
+    }
+
+    //--------------------------------------------------------------------------
+    void IndexTreeNode::evict_intersections(IndexTreeNode *keep)
+    //--------------------------------------------------------------------------
+    {
+      // Evict down to three quarters of the bound at a time so that
+      // the cost of finding the oldest entries is amortized
+      const size_t target = 3 * (size_t(Runtime::max_intersection_cache) / 4);
+      std::vector<std::pair<unsigned long long,IndexTreeNode*> > candidates;
+      candidates.reserve(intersections.size());
+      for (std::map<IndexTreeNode*,IntersectInfo>::const_iterator it = 
+            intersections.begin(); it != intersections.end(); it++)
+      {
+        if ((it->first == keep) || it->second.owns_spaces)
+          continue;
+        candidates.push_back(
+            std::pair<unsigned long long,IndexTreeNode*>(it->second.last_use,
+                                                         it->first));
+      }
+      std::sort(candidates.begin(), candidates.end());
+      unsigned long long evicted = 0;
+      for (std::vector<std::pair<unsigned long long,IndexTreeNode*> >::
+            const_iterator it = candidates.begin(); 
+            (it != candidates.end()) && (intersection_cache_size > target); it++)
+      {
+        std::map<IndexTreeNode*,IntersectInfo>::iterator finder = 
+          intersections.find(it->second);
+        intersection_cache_size -= finder->second.cost();
+        intersections.erase(finder);
+        evicted++;
+      }
+      if (evicted > 0)
+        __sync_fetch_and_add(&context->intersection_evictions, evicted);
+    }
+
     //--------------------------------------------------------------------------
     void IndexTreeNode::attach_semantic_information(SemanticTag tag,
                                                     AddressSpaceID source,
@@ -5126,9 +5335,10 @@ namespace Legion {
           {
             if (can_fail)
             {
-              // Have to make our own event
-              request = Runtime::create_rt_user_event();
-              wait_on = request;
+              // Share any request that is still in flight, otherwise
+              // we have to make our own event
+              wait_on = Runtime::find_or_create_pending_request(
+                                semantic_requests, tag, request);
             }
             else // can use the canonical event
               wait_on = finder->second.ready_event; 
@@ -5148,9 +5358,10 @@ namespace Legion {
           }
           else if (is_remote)
           {
-            // Make an event just for us to use
-            request = Runtime::create_rt_user_event();
-            wait_on = request;
+            // Share any request that is still in flight, otherwise
+            // make an event just for us to use
+            wait_on = Runtime::find_or_create_pending_request(
+                              semantic_requests, tag, request);
           }
         }
       }
@@ -6219,6 +6430,17 @@ namespace Legion {
       logical_nodes.insert(inst);
     }
 
+    //--------------------------------------------------------------------------
+    void IndexSpaceNode::remove_instance(RegionNode *inst)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock n_lock(node_lock);
+#ifdef DEBUG_LEGION
+      assert(logical_nodes.find(inst) != logical_nodes.end());
+#endif
+      logical_nodes.erase(inst);
+    }
+
     //--------------------------------------------------------------------------
     bool IndexSpaceNode::has_instance(RegionTreeID tid)
     //--------------------------------------------------------------------------
@@ -6255,20 +6477,24 @@ namespace Legion {
       // If we've already been destroyed then we are done
       if (destroyed)
         return;
+      NodeSet destruction_targets;
       std::set<RegionNode*> to_destroy;
       {
         AutoLock n_lock(node_lock);
         if (!destroyed)
         {
           destroyed = true;
-          if (!creation_set.empty())
-          {
-            DestructionFunctor functor(handle, context->runtime);
-            creation_set.map(functor);
-          }
+          destruction_targets = creation_set;
           to_destroy = logical_nodes;
         }
       }
+      // Send the destructions after releasing the lock since
+      // sending messages can block on the message manager
+      if (!destruction_targets.empty())
+      {
+        DestructionFunctor functor(handle, context->runtime);
+        destruction_targets.map(functor);
+      }
       for (std::set<RegionNode*>::const_iterator it = to_destroy.begin();
             it != to_destroy.end(); it++)
       {
@@ -6321,13 +6547,9 @@ namespace Legion {
         return true;
       {
         AutoLock n_lock(node_lock,1,false/*exclusive*/);
-        std::map<IndexTreeNode*,IntersectInfo>::const_iterator finder = 
-          intersections.find(other);
-        // Only return the value if we either didn't want to compute
-        // or we already have valid intersections
-        if ((finder != intersections.end()) && 
-            (!compute || finder->second.intersections_valid))
-          return finder->second.has_intersects;
+        const IntersectInfo *info = find_intersection(other, compute);
+        if (info != NULL)
+          return info->has_intersects;
       }
       if (!compute)
       {
@@ -6339,7 +6561,7 @@ namespace Legion {
           if (temp == this)
           {
             AutoLock n_lock(node_lock);
-            intersections[other] = IntersectInfo(true/*result*/);
+            record_intersection(other, IntersectInfo(true/*result*/));
             return true;
           }
           if (temp->parent == NULL)
@@ -6377,22 +6599,12 @@ namespace Legion {
                                          intersect, compute); 
       }
       AutoLock n_lock(node_lock);
-      if (result)
-      {
-        std::map<IndexTreeNode*,IntersectInfo>::const_iterator finder = 
-          intersections.find(other);
-        // Check to make sure we didn't lose the race
-        if ((finder == intersections.end()) || 
-            (compute && !finder->second.intersections_valid))
-        {
-          if (compute)
-            intersections[other] = IntersectInfo(intersect);
-          else
-            intersections[other] = IntersectInfo(true/*result*/);
-        }
-      }
+      if (!result)
+        record_intersection(other, IntersectInfo(false/*result*/));
+      else if (compute)
+        record_intersection(other, IntersectInfo(intersect));
       else
-        intersections[other] = IntersectInfo(false/*result*/);
+        record_intersection(other, IntersectInfo(true/*result*/));
       return result;
     }
 
@@ -6402,13 +6614,9 @@ namespace Legion {
     {
       {
         AutoLock n_lock(node_lock,1,false/*exclusive*/);
-        std::map<IndexTreeNode*,IntersectInfo>::const_iterator finder = 
-          intersections.find(other);
-        // Only return the value if we know we are valid and we didn't
-        // want to compute anything or we already did compute it
-        if ((finder != intersections.end()) &&
-            (!compute || finder->second.intersections_valid))
-          return finder->second.has_intersects;
+        const IntersectInfo *info = find_intersection(other, compute);
+        if (info != NULL)
+          return info->has_intersects;
       }
       if (!compute)
       {
@@ -6420,7 +6628,7 @@ namespace Legion {
           if (temp->parent == this)
           {
             AutoLock n_lock(node_lock);
-            intersections[other] = IntersectInfo(true/*result*/);
+            record_intersection(other, IntersectInfo(true/*result*/));
             return true;
           }
           temp = temp->parent->parent;
@@ -6428,51 +6636,37 @@ namespace Legion {
         // Otherwise we fall through and do the expensive test
       }
       // Build up the set of domains for the partition
-      std::set<Domain> other_domains, intersect;
-      other->get_subspace_domains(other_domains);
+      std::set<Domain> intersect;
       bool result;
       if (component_domains.empty())
-      {
-        result = compute_intersections(other_domains, get_domain_blocking(), 
-                                       intersect, compute);
-      }
+        result = other->intersect_subspaces(get_domain_blocking(), 
+                                            intersect, compute);
       else
-      {
-        result = compute_intersections(component_domains, other_domains,
-                                       intersect, compute);
-      }
+        result = other->intersect_subspaces(component_domains,
+                                            intersect, compute);
       AutoLock n_lock(node_lock);
-      if (result)
-      {
-        // Check to make sure we didn't lose the race
-        std::map<IndexTreeNode*,IntersectInfo>::const_iterator finder = 
-          intersections.find(other);
-        if ((finder == intersections.end()) ||
-            (compute && !finder->second.intersections_valid))
-        {
-          if (compute)
-            intersections[other] = IntersectInfo(intersect);
-          else
-            intersections[other] = IntersectInfo(true/*result*/);
-        }
-      }
+      if (!result)
+        record_intersection(other, IntersectInfo(false/*result*/));
+      else if (compute)
+        record_intersection(other, IntersectInfo(intersect));
       else
-        intersections[other] = IntersectInfo(false/*result*/);
+        record_intersection(other, IntersectInfo(true/*result*/));
       return result;
     }
 
     //--------------------------------------------------------------------------
-    const std::set<Domain>& IndexSpaceNode::get_intersection_domains(
-                                                          IndexSpaceNode *other)
+    void IndexSpaceNode::get_intersection_domains(IndexSpaceNode *other,
+                                                  std::vector<Domain> &domains)
     //--------------------------------------------------------------------------
     {
       {
         AutoLock n_lock(node_lock,1,false/*exclusive*/);
-        std::map<IndexTreeNode*,IntersectInfo>::const_iterator finder = 
-          intersections.find(other);
-        if ((finder != intersections.end()) &&
-            finder->second.intersections_valid)
-          return finder->second.intersections;
+        const IntersectInfo *info = find_intersection(other, true/*domains*/);
+        if (info != NULL)
+        {
+          domains = info->intersections;
+          return;
+        }
       }
       std::set<Domain> intersect;
       bool result;
@@ -6505,59 +6699,41 @@ namespace Legion {
       }
       AutoLock n_lock(node_lock);
       if (result)
-      {
-        // Check again to make sure we didn't lose the race
-        std::map<IndexTreeNode*,IntersectInfo>::const_iterator finder = 
-          intersections.find(other);
-        if ((finder == intersections.end()) ||
-            !finder->second.intersections_valid)
-          intersections[other] = IntersectInfo(intersect);
-      }
+        domains = record_intersection(other, 
+                                      IntersectInfo(intersect)).intersections;
       else
-        intersections[other] = IntersectInfo(false/*result*/);
-      return intersections[other].intersections;
+        record_intersection(other, IntersectInfo(false/*result*/));
     }
 
     //--------------------------------------------------------------------------
-    const std::set<Domain>& IndexSpaceNode::get_intersection_domains(
-                                                           IndexPartNode *other)
+    void IndexSpaceNode::get_intersection_domains(IndexPartNode *other,
+                                                  std::vector<Domain> &domains)
     //--------------------------------------------------------------------------
     {
       {
         AutoLock n_lock(node_lock,1,false/*exclusive*/);
-        std::map<IndexTreeNode*,IntersectInfo>::const_iterator finder = 
-          intersections.find(other);
-        if ((finder != intersections.end()) &&
-            finder->second.intersections_valid)
-          return finder->second.intersections;
+        const IntersectInfo *info = find_intersection(other, true/*domains*/);
+        if (info != NULL)
+        {
+          domains = info->intersections;
+          return;
+        }
       }
       // Build up the set of domains for the partition
-      std::set<Domain> other_domains, intersect;
-      other->get_subspace_domains(other_domains);
+      std::set<Domain> intersect;
       bool result;
       if (component_domains.empty())
-      {
-        result = compute_intersections(other_domains, get_domain_blocking(), 
-                                       intersect, true/*compute*/);
-      }
+        result = other->intersect_subspaces(get_domain_blocking(), 
+                                            intersect, true/*compute*/);
       else
-      {
-        result = compute_intersections(component_domains, other_domains,
-                                       intersect, true/*compute*/);
-      }
+        result = other->intersect_subspaces(component_domains,
+                                            intersect, true/*compute*/);
       AutoLock n_lock(node_lock);
       if (result)
-      {
-        // Check again to make sure we didn't lose the race
-        std::map<IndexTreeNode*,IntersectInfo>::const_iterator finder = 
-          intersections.find(other);
-        if ((finder == intersections.end()) ||
-            !finder->second.intersections_valid)
-          intersections[other] = IntersectInfo(intersect);
-      }
+        domains = record_intersection(other, 
+                                      IntersectInfo(intersect)).intersections;
       else
-        intersections[other] = IntersectInfo(false/*result*/);
-      return intersections[other].intersections;
+        record_intersection(other, IntersectInfo(false/*result*/));
     }
 
     //--------------------------------------------------------------------------
@@ -6744,11 +6920,14 @@ namespace Legion {
       handle_ready.lg_wait();
       // Check to see if our creation set includes the target
       std::map<ColorPoint,IndexPartNode*> valid_copy;
+      bool send_destruction;
       {
-        AutoLock n_lock(node_lock);
-        if (!creation_set.contains(target))
+        Serializer rez;
+        bool send_creation;
         {
-          Serializer rez;
+          AutoLock n_lock(node_lock);
+          send_creation = !creation_set.contains(target);
+          if (send_creation)
           {
             RezCheck z(rez);
             rez.serialize(handle);
@@ -6778,19 +6957,30 @@ namespace Legion {
               rez.serialize(it->second.is_mutable);
             }
           }
+          // Also check to see if we need to go down
+          if (down && child_creation.contains(target))
+            down = false;
+          // If we need to go down, make a copy of the valid children
+          if (down)
+            valid_copy = valid_map;
+          send_destruction = destroyed;
+        }
+        // Sending can block on the message manager so never do it
+        // while holding the node lock
+        if (send_creation)
+        {
           context->runtime->send_index_space_node(target, rez); 
+          // Only record the target once the message is sent so nothing
+          // that depends on this node can be sent ahead of it, racing
+          // senders may duplicate the node but the receiver handles that
+          AutoLock n_lock(node_lock);
           creation_set.add(target);
+          send_destruction = destroyed;
         }
-        // Also check to see if we need to go down
-        if (down && child_creation.contains(target))
-          down = false;
-        if (destroyed)
-          // Now we need to send a destruction
-          context->runtime->send_index_space_destruction(handle, target);
-        // If we need to go down, make a copy of the valid children
-        if (down)
-          valid_copy = valid_map;
       }
+      if (send_destruction)
+        // Now we need to send a destruction
+        context->runtime->send_index_space_destruction(handle, target);
       if (down)
       {
         for (std::map<ColorPoint,IndexPartNode*>::const_iterator it = 
@@ -7088,7 +7278,8 @@ namespace Legion {
                                  RegionTreeForest *ctx)
       : IndexTreeNode(c, par->depth+1, ctx), handle(p), color_space(cspace),
         mode(m), parent(par), total_children(cspace.get_volume()), 
-        disjoint(dis), disjoint_ready(RtEvent::NO_RT_EVENT), has_complete(false)
+        disjoint(dis), disjoint_ready(RtEvent::NO_RT_EVENT), 
+        has_complete(false), subspace_tree(NULL)
     //--------------------------------------------------------------------------
     { 
     }
@@ -7100,7 +7291,8 @@ namespace Legion {
                                  RegionTreeForest *ctx)
       : IndexTreeNode(c, par->depth+1, ctx), handle(p), color_space(cspace),
         mode(m), parent(par), total_children(cspace.get_volume()), 
-        disjoint(false), disjoint_ready(ready), has_complete(false)
+        disjoint(false), disjoint_ready(ready), has_complete(false),
+        subspace_tree(NULL)
     //--------------------------------------------------------------------------
     {
     }
@@ -7109,7 +7301,8 @@ namespace Legion {
     IndexPartNode::IndexPartNode(const IndexPartNode &rhs)
       : IndexTreeNode(), handle(IndexPartition::NO_PART), 
         color_space(Domain::NO_DOMAIN), mode(NO_MEMORY), 
-        parent(NULL), total_children(0), disjoint(false), has_complete(false)
+        parent(NULL), total_children(0), disjoint(false), has_complete(false),
+        subspace_tree(NULL)
     //--------------------------------------------------------------------------
     {
       // should never be called
@@ -7120,6 +7313,8 @@ namespace Legion {
     IndexPartNode::~IndexPartNode(void)
     //--------------------------------------------------------------------------
     {
+      if (subspace_tree != NULL)
+        delete subspace_tree;
     }
 
     //--------------------------------------------------------------------------
@@ -7497,6 +7692,12 @@ namespace Legion {
               color_map.begin(); it != color_map.end(); it++)
           current_colors.insert(it->first);
       }
+      // See if we can avoid doing all the pairwise tests
+      if (sweep_disjointness(current_colors, disjoint))
+      {
+        Runtime::trigger_event(ready_event);
+        return;
+      }
       // Now do the pairwise disjointness tests
       disjoint = true;
       for (std::set<ColorPoint>::const_iterator it1 = current_colors.begin();
@@ -7516,12 +7717,137 @@ namespace Legion {
       Runtime::trigger_event(ready_event);
     }
 
+    //--------------------------------------------------------------------------
+    bool IndexPartNode::sweep_disjointness(const std::set<ColorPoint> &colors,
+                                           bool &result)
+    //--------------------------------------------------------------------------
+    {
+      std::vector<Domain> domains;
+      domains.reserve(colors.size());
+      for (std::set<ColorPoint>::const_iterator it = colors.begin();
+            it != colors.end(); it++)
+      {
+        IndexSpaceNode *child = get_child(*it);
+        if (child->has_component_domains())
+          return false;
+        domains.push_back(child->get_domain_blocking());
+        if (domains.back().get_dim() != domains.front().get_dim())
+          return false;
+      }
+      if (domains.size() < 2)
+      {
+        result = true;
+        return true;
+      }
+      if (domains.front().get_dim() == 0)
+      {
+        // Accumulate the union of the subspaces, any subspace that
+        // overlaps the ones before it means we are aliased
+        coord_t lo = -1, hi = -1;
+        for (unsigned idx = 0; idx < domains.size(); idx++)
+        {
+          const Realm::ElementMask &mask = 
+            domains[idx].get_index_space().get_valid_mask();
+          const coord_t end = mask.get_first_element() + mask.get_num_elmts();
+          if ((lo < 0) || (mask.get_first_element() < lo))
+            lo = mask.get_first_element();
+          if (end > hi)
+            hi = end;
+        }
+        Realm::ElementMask seen(hi - lo, lo);
+        for (unsigned idx = 0; idx < domains.size(); idx++)
+        {
+          const Realm::ElementMask &mask = 
+            domains[idx].get_index_space().get_valid_mask();
+          if (seen.overlaps_with(mask) != Realm::ElementMask::OVERLAP_NO)
+          {
+            result = false;
+            return true;
+          }
+          seen |= mask;
+        }
+        result = true;
+        return true;
+      }
+      // For rectangles, look up each subspace in a spatial index over
+      // all of them, the only thing it should hit is itself
+      std::set<Domain> unique(domains.begin(), domains.end());
+      DomainTree tree(unique);
+      if (!tree.is_indexed())
+        return false;
+      // Subspaces with the same domain collapse into one in the tree
+      size_t non_empty = 0, unique_non_empty = 0;
+      for (std::vector<Domain>::const_iterator it = domains.begin();
+            it != domains.end(); it++)
+        if (it->get_volume() > 0)
+          non_empty++;
+      for (std::set<Domain>::const_iterator it = unique.begin();
+            it != unique.end(); it++)
+        if (it->get_volume() > 0)
+          unique_non_empty++;
+      if (unique_non_empty < non_empty)
+      {
+        result = false;
+        return true;
+      }
+      for (std::set<Domain>::const_iterator it = unique.begin();
+            it != unique.end(); it++)
+      {
+        std::set<Domain> hits;
+        if (tree.intersect(*it, hits, true/*compute*/) && (hits.size() > 1))
+        {
+          result = false;
+          return true;
+        }
+      }
+      result = true;
+      return true;
+    }
+
+    //--------------------------------------------------------------------------
+    void IndexPartNode::defer_disjointness(RtUserEvent ready_event,
+                                           RtEvent precondition)
+    //--------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(disjoint_ready.exists() && !disjoint_ready.has_triggered());
+      assert(ready_event == disjoint_ready);
+#endif
+      AutoLock n_lock(node_lock);
+      deferred_disjoint_ready = ready_event;
+      deferred_disjoint_precondition = precondition;
+    }
+
+    //--------------------------------------------------------------------------
+    void IndexPartNode::launch_deferred_disjointness(void)
+    //--------------------------------------------------------------------------
+    {
+      RegionTreeForest::DisjointnessArgs args;
+      RtEvent precondition;
+      {
+        AutoLock n_lock(node_lock);
+        // Only the first one to ask gets to launch it
+        if (!deferred_disjoint_ready.exists())
+          return;
+        args.ready = deferred_disjoint_ready;
+        precondition = deferred_disjoint_precondition;
+        deferred_disjoint_ready = RtUserEvent::NO_RT_USER_EVENT;
+        deferred_disjoint_precondition = RtEvent::NO_RT_EVENT;
+      }
+      args.handle = handle;
+      context->runtime->issue_runtime_meta_task(args, LG_LATENCY_PRIORITY, 
+                                                NULL, precondition);
+    }
+
     //--------------------------------------------------------------------------
     bool IndexPartNode::is_disjoint(bool app_query)
     //--------------------------------------------------------------------------
     {
       if (!disjoint_ready.has_triggered())
+      {
+        launch_deferred_disjointness();
         disjoint_ready.lg_wait();
+      }
       return disjoint;
     }
 
@@ -7718,6 +8044,17 @@ namespace Legion {
       logical_nodes.insert(inst);
     }
 
+    //--------------------------------------------------------------------------
+    void IndexPartNode::remove_instance(PartitionNode *inst)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock n_lock(node_lock);
+#ifdef DEBUG_LEGION
+      assert(logical_nodes.find(inst) != logical_nodes.end());
+#endif
+      logical_nodes.erase(inst);
+    }
+
     //--------------------------------------------------------------------------
     bool IndexPartNode::has_instance(RegionTreeID tid)
     //--------------------------------------------------------------------------
@@ -7754,21 +8091,23 @@ namespace Legion {
       // If we've already been destroyed then we are done
       if (destroyed)
         return;
+      NodeSet destruction_targets;
       std::set<PartitionNode*> to_destroy;
       {
         AutoLock n_lock(node_lock);
         if (!destroyed)
         {
           destroyed = true;
-          if (!creation_set.empty())
-          {
-            DestructionFunctor functor(handle, context->runtime);
-            creation_set.map(functor);
-          }
+          destruction_targets = creation_set;
           to_destroy = logical_nodes;
           
         }
       }
+      if (!destruction_targets.empty())
+      {
+        DestructionFunctor functor(handle, context->runtime);
+        destruction_targets.map(functor);
+      }
       for (std::set<PartitionNode*>::const_iterator it = 
             to_destroy.begin(); it != to_destroy.end(); it++)
       {
@@ -8141,17 +8480,73 @@ namespace Legion {
       get_subspace_domains(subspaces);
     }
 
+    //--------------------------------------------------------------------------
+    const DomainTree* IndexPartNode::get_subspace_tree(void)
+    //--------------------------------------------------------------------------
+    {
+      {
+        AutoLock n_lock(node_lock,1,false/*exclusive*/);
+        if (subspace_tree != NULL)
+          return subspace_tree;
+      }
+      // The subspaces of a partition never change once they are all
+      // known, so the first one to build the tree gets to keep it
+      std::set<Domain> subspaces;
+      get_subspace_domains(subspaces);
+      DomainTree *tree = new DomainTree(subspaces);
+      AutoLock n_lock(node_lock);
+      if (subspace_tree == NULL)
+        subspace_tree = tree;
+      else
+        delete tree;
+      return subspace_tree;
+    }
+
+    //--------------------------------------------------------------------------
+    bool IndexPartNode::intersect_subspaces(const std::set<Domain> &domains,
+                                     std::set<Domain> &result, bool compute)
+    //--------------------------------------------------------------------------
+    {
+      const DomainTree *tree = get_subspace_tree();
+      if (!tree->is_indexed())
+      {
+        std::set<Domain> subspaces;
+        get_subspace_domains(subspaces);
+        return compute_intersections(subspaces, domains, result, compute);
+      }
+      for (std::set<Domain>::const_iterator it = domains.begin();
+            it != domains.end(); it++)
+      {
+        if (tree->intersect(*it, result, compute) && !compute)
+          return true;
+      }
+      return !result.empty();
+    }
+
+    //--------------------------------------------------------------------------
+    bool IndexPartNode::intersect_subspaces(const Domain &domain,
+                                     std::set<Domain> &result, bool compute)
+    //--------------------------------------------------------------------------
+    {
+      const DomainTree *tree = get_subspace_tree();
+      if (!tree->is_indexed())
+      {
+        std::set<Domain> subspaces;
+        get_subspace_domains(subspaces);
+        return compute_intersections(subspaces, domain, result, compute);
+      }
+      return tree->intersect(domain, result, compute);
+    }
+
     //--------------------------------------------------------------------------
     bool IndexPartNode::intersects_with(IndexSpaceNode *other, bool compute)
     //--------------------------------------------------------------------------
     {
       {
         AutoLock n_lock(node_lock,1,false/*exclusive*/);
-        std::map<IndexTreeNode*,IntersectInfo>::const_iterator finder = 
-          intersections.find(other);
-        if ((finder != intersections.end()) &&
-            (!compute || finder->second.intersections_valid))
-          return finder->second.has_intersects;
+        const IntersectInfo *info = find_intersection(other, compute);
+        if (info != NULL)
+          return info->has_intersects;
       }
       if (!compute)
       {
@@ -8163,44 +8558,28 @@ namespace Legion {
           if (temp->parent == this)
           {
             AutoLock n_lock(node_lock);
-            intersections[other] = IntersectInfo(true/*result*/);
+            record_intersection(other, IntersectInfo(true/*result*/));
             return true;
           }
           temp = temp->parent->parent;
         }
         // Otherwise fall through and do the expensive test
       }
-      std::set<Domain> local_domains, intersect;
+      std::set<Domain> intersect;
       bool result;
-      get_subspace_domains(local_domains);
       if (other->has_component_domains())
-      {
-        result = compute_intersections(local_domains, 
-                   other->get_component_domains_blocking(), intersect, compute);
-      }
+        result = intersect_subspaces(other->get_component_domains_blocking(),
+                                     intersect, compute);
       else
-      {
-        result = compute_intersections(local_domains, 
-                                       other->get_domain_blocking(), 
-                                       intersect, compute);
-      }
+        result = intersect_subspaces(other->get_domain_blocking(), 
+                                     intersect, compute);
       AutoLock n_lock(node_lock);
-      if (result)
-      {
-        // Check to make sure we didn't lose the race
-        std::map<IndexTreeNode*,IntersectInfo>::const_iterator finder = 
-          intersections.find(other);
-        if ((finder == intersections.end()) ||
-            (compute && !finder->second.intersections_valid))
-        {
-          if (compute)
-            intersections[other] = IntersectInfo(intersect);
-          else
-            intersections[other] = IntersectInfo(true/*result*/);
-        }
-      }
+      if (!result)
+        record_intersection(other, IntersectInfo(false/*result*/));
+      else if (compute)
+        record_intersection(other, IntersectInfo(intersect));
       else
-        intersections[other] = IntersectInfo(false/*result*/);
+        record_intersection(other, IntersectInfo(true/*result*/));
       return result;
     }
 
@@ -8212,13 +8591,9 @@ namespace Legion {
         return true;
       {
         AutoLock n_lock(node_lock,1,false/*exclusive*/);
-        std::map<IndexTreeNode*,IntersectInfo>::const_iterator finder = 
-          intersections.find(other);
-        // Only return the value if we know we are valid and we didn't
-        // want to compute anything or we already did compute it
-        if ((finder != intersections.end()) &&
-            (!compute || finder->second.intersections_valid))
-          return finder->second.has_intersects;
+        const IntersectInfo *info = find_intersection(other, compute);
+        if (info != NULL)
+          return info->has_intersects;
       }
       if (!compute)
       {
@@ -8230,108 +8605,106 @@ namespace Legion {
           if (temp == this)
           {
             AutoLock n_lock(node_lock);
-            intersections[other] = IntersectInfo(true/*result*/);
+            record_intersection(other, IntersectInfo(true/*result*/));
             return true;
           }
           temp = temp->parent->parent;
         }
       }
-      std::set<Domain> local_domains, other_domains, intersect;
-      get_subspace_domains(local_domains);
-      other->get_subspace_domains(other_domains);
-      bool result = compute_intersections(local_domains, other_domains, 
-                                          intersect, compute);
-      AutoLock n_lock(node_lock);
-      if (result)
+      // Look up the subspaces of the smaller partition
+      // in the spatial index of the larger one
+      std::set<Domain> intersect;
+      bool result;
+      if (other->total_children > total_children)
       {
-        // Check to make sure we didn't lose the race
-        std::map<IndexTreeNode*,IntersectInfo>::const_iterator finder = 
-          intersections.find(other);
-        if ((finder == intersections.end()) ||
-            (compute && !finder->second.intersections_valid))
-        {
-          if (compute)
-            intersections[other] = IntersectInfo(intersect);
-          else
-            intersections[other] = IntersectInfo(false/*result*/);
-        }
+        std::set<Domain> local_domains;
+        get_subspace_domains(local_domains);
+        result = other->intersect_subspaces(local_domains, intersect, compute);
+      }
+      else
+      {
+        std::set<Domain> other_domains;
+        other->get_subspace_domains(other_domains);
+        result = intersect_subspaces(other_domains, intersect, compute);
       }
+      AutoLock n_lock(node_lock);
+      if (!result)
+        record_intersection(other, IntersectInfo(false/*result*/));
+      else if (compute)
+        record_intersection(other, IntersectInfo(intersect));
       else
-        intersections[other] = IntersectInfo(false/*result*/);
+        record_intersection(other, IntersectInfo(true/*result*/));
       return result;
     }
 
     //--------------------------------------------------------------------------
-    const std::set<Domain>& IndexPartNode::get_intersection_domains(
-                                                          IndexSpaceNode *other)
+    void IndexPartNode::get_intersection_domains(IndexSpaceNode *other,
+                                                 std::vector<Domain> &domains)
     //--------------------------------------------------------------------------
     {
       {
         AutoLock n_lock(node_lock,1,false/*exclusive*/);
-        std::map<IndexTreeNode*,IntersectInfo>::const_iterator finder = 
-          intersections.find(other);
-        if ((finder != intersections.end()) &&
-            finder->second.intersections_valid)
-          return finder->second.intersections;
+        const IntersectInfo *info = find_intersection(other, true/*domains*/);
+        if (info != NULL)
+        {
+          domains = info->intersections;
+          return;
+        }
       }
-      std::set<Domain> local_domains, intersect;
+      std::set<Domain> intersect;
       bool result;
-      get_subspace_domains(local_domains);
       if (other->has_component_domains())
-      {
-        result = compute_intersections(local_domains, 
-           other->get_component_domains_blocking(), intersect, true/*compute*/);
-      }
+        result = intersect_subspaces(other->get_component_domains_blocking(),
+                                     intersect, true/*compute*/);
       else
-      {
-        result = compute_intersections(local_domains, 
-                                       other->get_domain_blocking(), 
-                                       intersect, true/*compute*/);
-      }
+        result = intersect_subspaces(other->get_domain_blocking(), 
+                                     intersect, true/*compute*/);
       AutoLock n_lock(node_lock);
       if (result)
-      {
-        std::map<IndexTreeNode*,IntersectInfo>::const_iterator finder = 
-          intersections.find(other);
-        if ((finder == intersections.end()) ||
-            !finder->second.intersections_valid)
-          intersections[other] = IntersectInfo(intersect);
-      }
+        domains = record_intersection(other, 
+                                      IntersectInfo(intersect)).intersections;
       else
-        intersections[other] = IntersectInfo(false/*false*/);
-      return intersections[other].intersections;
+        record_intersection(other, IntersectInfo(false/*result*/));
     }
 
     //--------------------------------------------------------------------------
-    const std::set<Domain>& IndexPartNode::get_intersection_domains(
-                                                           IndexPartNode *other)
+    void IndexPartNode::get_intersection_domains(IndexPartNode *other,
+                                                 std::vector<Domain> &domains)
     //--------------------------------------------------------------------------
     {
       {
         AutoLock n_lock(node_lock,1,false/*exclusive*/);
-        std::map<IndexTreeNode*,IntersectInfo>::const_iterator finder = 
-          intersections.find(other);
-        if ((finder != intersections.end()) &&
-            finder->second.intersections_valid)
-          return finder->second.intersections;
-      }
-      std::set<Domain> local_domains, other_domains, intersect;
-      get_subspace_domains(local_domains);
-      other->get_subspace_domains(other_domains);
-      bool result = compute_intersections(local_domains, other_domains, 
-                                          intersect, true/*compute*/);
-      AutoLock n_lock(node_lock);
-      if (result)
+        const IntersectInfo *info = find_intersection(other, true/*domains*/);
+        if (info != NULL)
+        {
+          domains = info->intersections;
+          return;
+        }
+      }
+      // Look up the subspaces of the smaller partition
+      // in the spatial index of the larger one
+      std::set<Domain> intersect;
+      bool result;
+      if (other->total_children > total_children)
       {
-        std::map<IndexTreeNode*,IntersectInfo>::const_iterator finder = 
-          intersections.find(other);
-        if ((finder == intersections.end()) ||
-            !finder->second.intersections_valid)
-          intersections[other] = IntersectInfo(intersect);
+        std::set<Domain> local_domains;
+        get_subspace_domains(local_domains);
+        result = other->intersect_subspaces(local_domains, intersect, 
+                                            true/*compute*/);
       }
       else
-        intersections[other] = IntersectInfo(false/*result*/);
-      return intersections[other].intersections;
+      {
+        std::set<Domain> other_domains;
+        other->get_subspace_domains(other_domains);
+        result = intersect_subspaces(other_domains, intersect, 
+                                     true/*compute*/);
+      }
+      AutoLock n_lock(node_lock);
+      if (result)
+        domains = record_intersection(other, 
+                                      IntersectInfo(intersect)).intersections;
+      else
+        record_intersection(other, IntersectInfo(false/*result*/));
     }
 
     //--------------------------------------------------------------------------
@@ -8431,13 +8804,16 @@ namespace Legion {
       if (up)
         parent->send_node(target, true/*up*/, false/*down*/);
       std::map<ColorPoint,IndexSpaceNode*> valid_copy;
+      bool send_destruction;
       {
         // Make sure we know if this is disjoint or not yet
         bool disjoint_result = is_disjoint();
-        AutoLock n_lock(node_lock);
-        if (!creation_set.contains(target))
+        Serializer rez;
+        bool send_creation;
         {
-          Serializer rez;
+          AutoLock n_lock(node_lock);
+          send_creation = !creation_set.contains(target);
+          if (send_creation)
           {
             RezCheck z(rez);
             rez.serialize(handle);
@@ -8467,18 +8843,25 @@ namespace Legion {
               rez.serialize(it->second.second);
             }
           }
+          // See if we need to go down
+          if (down && child_creation.contains(target))
+            down = false;
+          if (down)
+            valid_copy = valid_map;
+          send_destruction = destroyed;
+        }
+        // Send outside the node lock, see IndexSpaceNode::send_node
+        if (send_creation)
+        {
           context->runtime->send_index_partition_node(target, rez);
+          AutoLock n_lock(node_lock);
           creation_set.add(target);
+          send_destruction = destroyed;
         }
-        // See if we need to go down
-        if (down && child_creation.contains(target))
-          down = false;
-        if (destroyed)
-          // Send the deletion notification
-          context->runtime->send_index_partition_destruction(handle, target);
-        if (down)
-          valid_copy = valid_map;
       }
+      if (send_destruction)
+        // Send the deletion notification
+        context->runtime->send_index_partition_destruction(handle, target);
       if (down)
       {
         for (std::map<ColorPoint,IndexSpaceNode*>::const_iterator it = 
@@ -9040,9 +9423,10 @@ namespace Legion {
           {
             if (can_fail)
             {
-              // Have to make our own event
-              request = Runtime::create_rt_user_event();
-              wait_on = request;
+              // Share any request that is still in flight, otherwise
+              // we have to make our own event
+              wait_on = Runtime::find_or_create_pending_request(
+                                semantic_requests, tag, request);
             }
             else // can use the canonical event
               wait_on = finder->second.ready_event; 
@@ -9062,9 +9446,10 @@ namespace Legion {
           }
           else if (is_remote)
           {
-            // Make an event just for us to use
-            request = Runtime::create_rt_user_event();
-            wait_on = request;
+            // Share any request that is still in flight, otherwise
+            // make an event just for us to use
+            wait_on = Runtime::find_or_create_pending_request(
+                              semantic_requests, tag, request);
           }
         }
       }
@@ -9146,9 +9531,11 @@ namespace Legion {
           {
             if (can_fail)
             {
-              // Have to make our own event
-              request = Runtime::create_rt_user_event();
-              wait_on = request;
+              // Share any request that is still in flight, otherwise
+              // we have to make our own event
+              wait_on = Runtime::find_or_create_pending_request(
+                  semantic_field_requests,
+                  std::pair<FieldID,SemanticTag>(fid,tag), request);
             }
             else // can use the canonical event
               wait_on = finder->second.ready_event; 
@@ -9163,14 +9550,17 @@ namespace Legion {
           {
             // Make a canonical ready event
             request = Runtime::create_rt_user_event();
-            semantic_info[tag] = SemanticInfo(request);
+            semantic_field_info[std::pair<FieldID,SemanticTag>(fid,tag)] = 
+              SemanticInfo(request);
             wait_on = request;
           }
           else if (is_remote)
           {
-            // Make an event just for us to use
-            request = Runtime::create_rt_user_event();
-            wait_on = request;
+            // Share any request that is still in flight, otherwise
+            // make an event just for us to use
+            wait_on = Runtime::find_or_create_pending_request(
+                semantic_field_requests,
+                std::pair<FieldID,SemanticTag>(fid,tag), request);
           }
         }
       }
@@ -10112,6 +10502,16 @@ namespace Legion {
       return false;
     }
 
+    //--------------------------------------------------------------------------
+    void FieldSpaceNode::remove_instance(RegionNode *inst)
+    //--------------------------------------------------------------------------
+    {
+      // Only forget about the tree locally, other nodes will 
+      // do the same when they reclaim their copies of it
+      AutoLock n_lock(node_lock);
+      logical_trees.erase(inst->handle);
+    }
+
     //--------------------------------------------------------------------------
     void FieldSpaceNode::DestructionFunctor::apply(AddressSpaceID target)
     //--------------------------------------------------------------------------
@@ -10933,15 +11333,12 @@ namespace Legion {
       : context(ctx), column_source(column_src), destroyed(false)
     //--------------------------------------------------------------------------
     {
-      this->node_lock = Reservation::create_reservation(); 
     }
 
     //--------------------------------------------------------------------------
     RegionTreeNode::~RegionTreeNode(void)
     //--------------------------------------------------------------------------
     {
-      node_lock.destroy_reservation();
-      node_lock = Reservation::NO_RESERVATION;
       for (LegionMap<SemanticTag,SemanticInfo>::aligned::iterator it = 
             semantic_info.begin(); it != semantic_info.end(); it++)
       {
@@ -10954,7 +11351,7 @@ namespace Legion {
                                                               Runtime *runtime)
     //--------------------------------------------------------------------------
     {
-      return (tid % runtime->runtime_stride);
+      return (LEGION_TREE_ID_FILTER(tid) % runtime->runtime_stride);
     }
 
     //--------------------------------------------------------------------------
@@ -11081,9 +11478,10 @@ namespace Legion {
           {
             if (can_fail)
             {
-              // Have to make our own event
-              request = Runtime::create_rt_user_event();
-              wait_on = request;
+              // Share any request that is still in flight, otherwise
+              // we have to make our own event
+              wait_on = Runtime::find_or_create_pending_request(
+                                semantic_requests, tag, request);
             }
             else // can use the canonical event
               wait_on = finder->second.ready_event; 
@@ -11103,9 +11501,10 @@ namespace Legion {
           }
           else if (is_remote)
           {
-            // Make an event just for us to use
-            request = Runtime::create_rt_user_event();
-            wait_on = request;
+            // Share any request that is still in flight, otherwise
+            // make an event just for us to use
+            wait_on = Runtime::find_or_create_pending_request(
+                              semantic_requests, tag, request);
           }
         }
       }
@@ -11195,8 +11594,15 @@ namespace Legion {
         else
         {
           const FieldMask *aliased_children = path.get_aliased_children(depth);
+          // If the next child is a partition being projected through
+          // then pass the projection along so we can try to prove 
+          // that some close operations are unnecessary
+          const ProjectionInfo *next_projection = 
+            (proj_info.is_projecting() && 
+             (path.get_max_depth() == (depth+1))) ? &proj_info : NULL;
           siphon_logical_children(closer, state, unopened_field_mask, 
-              aliased_children, captures_closes, next_child, open_below);
+                                  aliased_children, captures_closes, 
+                                  next_child, next_projection, open_below);
         }
         // We always need to create and register close operations
         // regardless of whether we are tracing or not
@@ -11306,7 +11712,7 @@ namespace Legion {
       // any dynamic open, advance, or close operations that we need to do
       // Now that we registered any close operation, do our analysis
       FieldMask dominator_mask = 
-             perform_dependence_checks<CURR_LOGICAL_ALLOC,
+             perform_dependence_checks<
                        true/*record*/,false/*has skip*/,true/*track dom*/>(
                           user, state.curr_epoch_users, user.field_mask, 
                           open_below, arrived/*validates*/ && 
@@ -11316,7 +11722,7 @@ namespace Legion {
       // those fields against the previous epoch's users
       if (!!non_dominated_mask)
       {
-        perform_dependence_checks<PREV_LOGICAL_ALLOC,
+        perform_dependence_checks<
                       true/*record*/, false/*has skip*/, false/*track dom*/>(
                         user, state.prev_epoch_users, non_dominated_mask, 
                         open_below, arrived/*validates*/ && 
@@ -11515,7 +11921,7 @@ namespace Legion {
       open->begin_dependence_analysis();
       LegionList<LogicalUser,LOGICAL_REC_ALLOC>::track_aligned &above_users =
         creator.op->get_logical_records();
-      perform_dependence_checks<LOGICAL_REC_ALLOC,
+      perform_dependence_checks<
             false/*record*/, false/*has skip*/, false/*track dom*/>(
                 open_user, above_users, open_mask, 
                 open_mask/*doesn't matter*/, false/*validates*/);
@@ -11552,7 +11958,7 @@ namespace Legion {
       LegionList<LogicalUser,LOGICAL_REC_ALLOC>::track_aligned &above_users = 
         creator.op->get_logical_records();
       if (!above_users.empty())
-        perform_dependence_checks<LOGICAL_REC_ALLOC,
+        perform_dependence_checks<
           false/*record*/, false/*has skip*/, false/*track dom*/>(
               advance_user, above_users, advance_mask,
               advance_mask/*doesn't matter*/, false/*validates*/);
@@ -11564,7 +11970,7 @@ namespace Legion {
       LegionList<LogicalUser,LOGICAL_REC_ALLOC>::track_aligned &above_advances =
         creator.op->get_logical_advances();
       if (!above_advances.empty())
-        perform_dependence_checks<LOGICAL_REC_ALLOC,
+        perform_dependence_checks<
           false/*record*/, false/*has skip*/, false/*track dom*/>(
           advance_user, above_advances, advance_mask,
           advance_mask/*doesn't matter*/, false/*validates*/);
@@ -11689,14 +12095,14 @@ namespace Legion {
       // open below fields for advance analysis
       FieldMask empty_below;
       FieldMask dominator_mask = 
-            perform_dependence_checks<CURR_LOGICAL_ALLOC,
+            perform_dependence_checks<
                     false/*record*/, true/*has skip*/, true/*track dom*/>(
               advance_user, state.curr_epoch_users, advance_user.field_mask,
               empty_below, false/*validates*/, create_user.op, create_user.gen);
       FieldMask non_dominated_mask = advance_user.field_mask - dominator_mask;
       if (!!non_dominated_mask)
       {
-        perform_dependence_checks<PREV_LOGICAL_ALLOC,
+        perform_dependence_checks<
                     false/*record*/, true/*has skip*/, false/*track dom*/>(
               advance_user, state.prev_epoch_users, non_dominated_mask,
               empty_below, false/*validates*/, create_user.op, create_user.gen);
@@ -11715,9 +12121,9 @@ namespace Legion {
       LogicalState &state = get_logical_state(closer.ctx);
       // Perform closing checks on both the current epoch users
       // as well as the previous epoch users
-      perform_closing_checks<CURR_LOGICAL_ALLOC>(closer, read_only_close,
+      perform_closing_checks(closer, read_only_close,
                                      state.curr_epoch_users, closing_mask);
-      perform_closing_checks<PREV_LOGICAL_ALLOC>(closer, read_only_close,
+      perform_closing_checks(closer, read_only_close,
                                      state.prev_epoch_users, closing_mask);
       // If this is not a read-only close, then capture the 
       // close information
@@ -11799,6 +12205,7 @@ namespace Legion {
                                               const FieldMask *aliased_children,
                                               bool record_close_operations,
                                               const ColorPoint &next_child,
+                                         const ProjectionInfo *next_projection,
                                               FieldMask &open_below)
     //--------------------------------------------------------------------------
     {
@@ -11899,6 +12306,28 @@ namespace Legion {
             }
           case OPEN_READ_WRITE:
             {
+              // If we are reading through a projection and we can prove
+              // that none of the children written by the projections 
+              // of any aliased partitions overlap with the children that
+              // we are going to read then we can leave them all open
+              if ((next_projection != NULL) && 
+                  IS_READ_ONLY(closer.user.usage) &&
+                  as_region_node()->are_projections_disjoint(closer.ctx,
+                            *it, current_mask, next_child, *next_projection))
+              {
+                const FieldMask overlap = it->valid_fields & current_mask;
+                it->open_children[next_child] |= overlap;
+                open_below |= overlap;
+                it++;
+                break;
+              }
+              // Aliased partitions that were left open above by readers 
+              // only need read-only closes, so do those now which will
+              // leave our child open if it is the only one left
+              if ((next_projection != NULL) && is_region() &&
+                  (it->open_children.size() > 1))
+                close_read_only_projections(closer, *it, current_mask,
+                                    next_child, record_close_operations);
               // Close up any open partitions that conflict with ours
               perform_close_operations(closer, current_mask, 
                                        *it, next_child,
@@ -12198,6 +12627,41 @@ namespace Legion {
 #endif 
     }
 
+    //--------------------------------------------------------------------------
+    void RegionTreeNode::close_read_only_projections(LogicalCloser &closer,
+                                                     FieldState &state,
+                                                 const FieldMask &closing_mask,
+                                                 const ColorPoint &next_child,
+                                                 bool record_close_operations)
+    //--------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(is_region());
+      assert(state.open_state == OPEN_READ_WRITE);
+#endif
+      std::vector<ColorPoint> to_delete;
+      for (LegionMap<ColorPoint,FieldMask>::aligned::iterator it = 
+            state.open_children.begin(); it != state.open_children.end(); it++)
+      {
+        const FieldMask overlap = it->second & closing_mask;
+        if (!overlap || (it->first == next_child) ||
+            are_children_disjoint(it->first, next_child))
+          continue;
+        PartitionNode *child = as_region_node()->get_child(it->first);
+        if (!child->has_only_read_projections(closer.ctx, overlap))
+          continue;
+        child->close_logical_node(closer, overlap, true/*read only*/);
+        if (record_close_operations)
+          closer.record_read_only_close(overlap, false/*projection*/);
+        it->second -= overlap;
+        if (!it->second)
+          to_delete.push_back(it->first);
+      }
+      for (std::vector<ColorPoint>::const_iterator it = to_delete.begin();
+            it != to_delete.end(); it++)
+        state.open_children.erase(*it);
+    }
+
     //--------------------------------------------------------------------------
     void RegionTreeNode::siphon_logical_projection(LogicalCloser &closer,
                                                 LogicalState &state,
@@ -12935,7 +13399,7 @@ namespace Legion {
                                                  const FieldMask &field_mask)
     //--------------------------------------------------------------------------
     {
-      for (LegionList<LogicalUser,PREV_LOGICAL_ALLOC>::track_aligned::iterator 
+      for (LogicalUserList<PREV_LOGICAL_ALLOC>::iterator 
             it = state.prev_epoch_users.begin(); it != 
             state.prev_epoch_users.end(); /*nothing*/)
       {
@@ -12956,7 +13420,7 @@ namespace Legion {
                                                  const FieldMask &field_mask)
     //--------------------------------------------------------------------------
     {
-      for (LegionList<LogicalUser,CURR_LOGICAL_ALLOC>::track_aligned::iterator 
+      for (LogicalUserList<CURR_LOGICAL_ALLOC>::iterator 
             it = state.curr_epoch_users.begin(); it !=
             state.curr_epoch_users.end(); /*nothing*/)
       {
@@ -13138,7 +13602,7 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       LogicalState &state = get_logical_state(ctx);
-      for (LegionList<LogicalUser,CURR_LOGICAL_ALLOC>::track_aligned::iterator 
+      for (LogicalUserList<CURR_LOGICAL_ALLOC>::iterator 
             it = state.curr_epoch_users.begin(); it != 
             state.curr_epoch_users.end(); /*nothing*/)
       {
@@ -13171,7 +13635,7 @@ namespace Legion {
         else
           it++;
       }
-      for (LegionList<LogicalUser,PREV_LOGICAL_ALLOC>::track_aligned::iterator 
+      for (LogicalUserList<PREV_LOGICAL_ALLOC>::iterator 
             it = state.prev_epoch_users.begin(); it != 
             state.prev_epoch_users.end(); /*nothing*/)
       {
@@ -13258,7 +13722,7 @@ namespace Legion {
           }
           // Perform our checks on dependences
           FieldMask dominator_mask = 
-                 perform_dependence_checks<CURR_LOGICAL_ALLOC,
+                 perform_dependence_checks<
                            true/*record*/,false/*has skip*/,true/*track dom*/>(
                               user, state.curr_epoch_users, check_mask, 
                               open_below, false/*validates*/);
@@ -13267,7 +13731,7 @@ namespace Legion {
           // those fields against the previous epoch's users
           if (!!non_dominated_mask)
           {
-            perform_dependence_checks<PREV_LOGICAL_ALLOC,
+            perform_dependence_checks<
                          true/*record*/, false/*has skip*/, false/*track dom*/>(
                          user, state.prev_epoch_users, non_dominated_mask, 
                          open_below, false/*validates*/);
@@ -15053,26 +15517,32 @@ namespace Legion {
     }
 
     //--------------------------------------------------------------------------
-    void RegionTreeNode::initialize_current_state(ContextID ctx)
+    bool RegionTreeNode::initialize_current_state(ContextID ctx)
     //--------------------------------------------------------------------------
     {
-      if (!logical_states.has_entry(ctx))
-        return;
-      LogicalState &state = get_logical_state(ctx);
-      state.check_init();
+      // Look for the state without making it so we don't allocate
+      // states for every node in the tree just to check them
+      LogicalState *state = logical_states.find_entry(ctx);
+      if (state == NULL)
+        return true;
+      state->check_init();
+      return true;
     }
 
     //--------------------------------------------------------------------------
-    void RegionTreeNode::invalidate_current_state(ContextID ctx,bool users_only)
+    bool RegionTreeNode::invalidate_current_state(ContextID ctx,bool users_only)
     //--------------------------------------------------------------------------
     {
-      if (!logical_states.has_entry(ctx))
-        return;
-      LogicalState &state = get_logical_state(ctx);
+      LogicalState *state = logical_states.find_entry(ctx);
+      // If this state was never used in this context since it was last
+      // reset then nothing below it was either so we can stop here
+      if ((state == NULL) || !state->touched)
+        return false;
       if (users_only)
-        state.clear_logical_users();
+        state->clear_logical_users();
       else
-        state.reset(); 
+        state->reset(); 
+      return true;
     }
 
     //--------------------------------------------------------------------------
@@ -15175,6 +15645,44 @@ namespace Legion {
       physical_managers.erase(manager->did);
     }
 
+    //--------------------------------------------------------------------------
+    RegionNode* RegionTreeNode::find_tree_root(void) const
+    //--------------------------------------------------------------------------
+    {
+      const RegionTreeNode *node = this;
+      RegionTreeNode *parent = node->get_parent();
+      while (parent != NULL)
+      {
+        node = parent;
+        parent = node->get_parent();
+      }
+      return node->as_region_node();
+    }
+
+    //--------------------------------------------------------------------------
+    void RegionTreeNode::add_tree_reference(void)
+    //--------------------------------------------------------------------------
+    {
+      RegionNode *root = find_tree_root();
+#ifdef DEBUG_LEGION
+      // Can't resurrect a tree once the last reference is gone
+      assert(root->tree_references > 0);
+#endif
+      __sync_fetch_and_add(&root->tree_references, 1);
+    }
+
+    //--------------------------------------------------------------------------
+    void RegionTreeNode::remove_tree_reference(void)
+    //--------------------------------------------------------------------------
+    {
+      RegionNode *root = find_tree_root();
+#ifdef DEBUG_LEGION
+      assert(root->tree_references > 0);
+#endif
+      if (__sync_add_and_fetch(&root->tree_references, -1) == 0)
+        context->reclaim_region_tree(root);
+    }
+
     //--------------------------------------------------------------------------
     PhysicalManager* RegionTreeNode::find_manager(DistributedID did)
     //--------------------------------------------------------------------------
@@ -15190,10 +15698,9 @@ namespace Legion {
     }
 
     //--------------------------------------------------------------------------
-    template<AllocationType ALLOC, bool RECORD, bool HAS_SKIP, bool TRACK_DOM>
+    template<bool RECORD, bool HAS_SKIP, bool TRACK_DOM, typename USERS>
     /*static*/ FieldMask RegionTreeNode::perform_dependence_checks(
-      const LogicalUser &user, 
-      typename LegionList<LogicalUser, ALLOC>::track_aligned &prev_users,
+      const LogicalUser &user, USERS &prev_users,
       const FieldMask &check_mask, const FieldMask &open_below,
       bool validates_regions, Operation *to_skip /*= NULL*/, 
       GenerationID skip_gen /* = 0*/)
@@ -15207,8 +15714,8 @@ namespace Legion {
       FieldMask observed_mask; 
       FieldMask user_check_mask = user.field_mask & check_mask;
       const bool tracing = user.op->is_tracing();
-      for (typename LegionList<LogicalUser, ALLOC>::track_aligned::iterator 
-            it = prev_users.begin(); it != prev_users.end(); /*nothing*/)
+      for (typename USERS::iterator it = prev_users.begin(); 
+            it != prev_users.end(); /*nothing*/)
       {
         if (HAS_SKIP && (to_skip == it->op) && (skip_gen == it->gen))
         {
@@ -15354,8 +15861,8 @@ namespace Legion {
                                              const FieldMask &open_below,
            LegionList<LogicalUser,CLOSE_LOGICAL_ALLOC>::track_aligned &ch_users,
            LegionList<LogicalUser,LOGICAL_REC_ALLOC >::track_aligned &abv_users,
-           LegionList<LogicalUser,CURR_LOGICAL_ALLOC>::track_aligned &cur_users,
-           LegionList<LogicalUser,PREV_LOGICAL_ALLOC>::track_aligned &pre_users)
+                                LogicalUserList<CURR_LOGICAL_ALLOC> &cur_users,
+                                LogicalUserList<PREV_LOGICAL_ALLOC> &pre_users)
     //--------------------------------------------------------------------------
     {
       // Mark that we are starting our dependence analysis
@@ -15370,7 +15877,7 @@ namespace Legion {
       // so we can't have the close operation register depencnes
       // on any other users from the same op as the current one
       // we are doing the analysis for (e.g. other region reqs)
-      RegionTreeNode::perform_dependence_checks<CLOSE_LOGICAL_ALLOC,
+      RegionTreeNode::perform_dependence_checks<
         false/*record*/, true/*has skip*/, false/*track dom*/>(
                                     close_user, ch_users,
                                     close_op_mask, open_below,
@@ -15381,7 +15888,7 @@ namespace Legion {
       // here because we know the operation didn't register any 
       // dependences against itself.
       if (!abv_users.empty())
-        RegionTreeNode::perform_dependence_checks<LOGICAL_REC_ALLOC,
+        RegionTreeNode::perform_dependence_checks<
             false/*record*/, false/*has skip*/, false/*track dom*/>(
                                        close_user, abv_users,
                                        close_op_mask, open_below,
@@ -15392,7 +15899,7 @@ namespace Legion {
       FieldMask dominator_mask; 
       if (!cur_users.empty())
         dominator_mask = 
-          RegionTreeNode::perform_dependence_checks<CURR_LOGICAL_ALLOC,
+          RegionTreeNode::perform_dependence_checks<
             false/*record*/, true/*has skip*/, true/*track dom*/>(
                                       close_user, cur_users,
                                       close_op_mask, open_below,
@@ -15400,7 +15907,7 @@ namespace Legion {
                                       current.op, current.gen);
       FieldMask non_dominated_mask = close_op_mask - dominator_mask;
       if (!!non_dominated_mask && !pre_users.empty())
-        RegionTreeNode::perform_dependence_checks<PREV_LOGICAL_ALLOC,
+        RegionTreeNode::perform_dependence_checks<
           false/*record*/, true/*has skip*/, false/*track dom*/>(
                                close_user, pre_users, 
                                non_dominated_mask, open_below,
@@ -15416,10 +15923,9 @@ namespace Legion {
     }
 
     //--------------------------------------------------------------------------
-    template<AllocationType ALLOC>
+    template<typename USERS>
     /*static*/ void RegionTreeNode::perform_closing_checks(
-        LogicalCloser &closer, bool read_only_close,
-        typename LegionList<LogicalUser, ALLOC>::track_aligned &users, 
+        LogicalCloser &closer, bool read_only_close, USERS &users, 
         const FieldMask &check_mask)
     //--------------------------------------------------------------------------
     {
@@ -15431,8 +15937,8 @@ namespace Legion {
       // privilege to read-write to ensure that anyone that comes
       // later also records mapping dependences on the users.
       const FieldMask user_check_mask = closer.user.field_mask & check_mask; 
-      for (typename LegionList<LogicalUser, ALLOC>::track_aligned::iterator 
-            it = users.begin(); it != users.end(); /*nothing*/)
+      for (typename USERS::iterator it = users.begin(); 
+            it != users.end(); /*nothing*/)
       {
         FieldMask overlap = user_check_mask & it->field_mask;
         if (!overlap)
@@ -15538,7 +16044,8 @@ namespace Legion {
                            IndexSpaceNode *row_src, FieldSpaceNode *col_src,
                            RegionTreeForest *ctx)
       : RegionTreeNode(ctx, col_src), handle(r), 
-        parent(par), row_source(row_src)
+        parent(par), row_source(row_src), 
+        tree_references((par == NULL) ? 1 : 0)
     //--------------------------------------------------------------------------
     {
     }
@@ -15546,7 +16053,7 @@ namespace Legion {
     //--------------------------------------------------------------------------
     RegionNode::RegionNode(const RegionNode &rhs)
       : RegionTreeNode(NULL, NULL), handle(LogicalRegion::NO_REGION), 
-        parent(NULL), row_source(NULL)
+        parent(NULL), row_source(NULL), tree_references(0)
     //--------------------------------------------------------------------------
     {
       // should never be called
@@ -15649,6 +16156,7 @@ namespace Legion {
       // If we've already been destroyed then we are done
       if (destroyed)
         return;
+      NodeSet destruction_targets;
       bool release_tree_instances = false;
       bool perform_invalidations = false;
       {
@@ -15662,13 +16170,14 @@ namespace Legion {
           // for any instances in this region tree
           if (parent == NULL)
             release_tree_instances = true;
-          if (!creation_set.empty())
-          {
-            DestructionFunctor functor(handle, context->runtime);
-            creation_set.map(functor);
-          }
+          destruction_targets = creation_set;
         }
       }
+      if (!destruction_targets.empty())
+      {
+        DestructionFunctor functor(handle, context->runtime);
+        destruction_targets.map(functor);
+      }
       if (perform_invalidations)
       {
         // TODO: Make this more precise so that it happens on 
@@ -15679,7 +16188,23 @@ namespace Legion {
         visit_node(&invalidator);
       }
       if (release_tree_instances)
+      {
         context->runtime->release_tree_instances(handle.get_tree_id());
+        // Remove the reference the forest held on the tree, 
+        // this might reclaim the whole tree including us
+        remove_tree_reference();
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    void RegionNode::gather_tree_nodes(std::vector<RegionNode*> &regions,
+                                 std::vector<PartitionNode*> &partitions) const
+    //--------------------------------------------------------------------------
+    {
+      regions.push_back(const_cast<RegionNode*>(this));
+      for (std::map<ColorPoint,PartitionNode*>::const_iterator it = 
+            color_map.begin(); it != color_map.end(); it++)
+        it->second->gather_tree_nodes(regions, partitions);
     }
 
     //--------------------------------------------------------------------------
@@ -15793,29 +16318,29 @@ namespace Legion {
       else
       {
         // This is a copy between the intersection of two regions
-        const std::set<Domain> *intersection_doms;
+        std::vector<Domain> intersection_doms;
         if (intersect->is_region())
-          intersection_doms = &(row_source->get_intersection_domains(
-                intersect->as_region_node()->row_source));
+          row_source->get_intersection_domains(
+                intersect->as_region_node()->row_source, intersection_doms);
         else
-          intersection_doms = &(row_source->get_intersection_domains(
-                intersect->as_partition_node()->row_source));
+          row_source->get_intersection_domains(
+                intersect->as_partition_node()->row_source, intersection_doms);
         std::set<ApEvent> done_events;
         if (predicate_guard.exists())
         {
           // have to protect against misspeculation
           ApEvent pred_pre = Runtime::merge_events(precondition,
                                                    ApEvent(predicate_guard));
-          for (std::set<Domain>::const_iterator it = intersection_doms->begin();
-                it != intersection_doms->end(); it++)
+          for (std::vector<Domain>::const_iterator it = 
+                intersection_doms.begin(); it != intersection_doms.end(); it++)
             done_events.insert(Runtime::ignorefaults(it->copy(
                     src_fields, dst_fields, requests, pred_pre, 
                     redop, reduction_fold)));
         }
         else
         {
-          for (std::set<Domain>::const_iterator it = intersection_doms->begin();
-                it != intersection_doms->end(); it++)
+          for (std::vector<Domain>::const_iterator it = 
+                intersection_doms.begin(); it != intersection_doms.end(); it++)
             done_events.insert(ApEvent(it->copy(src_fields, dst_fields, 
                                                 requests, precondition,
                                                 redop, reduction_fold)));
@@ -15925,28 +16450,28 @@ namespace Legion {
       else
       {
         // This is the fill between the intersection of two regions
-        const std::set<Domain> *intersection_doms;
+        std::vector<Domain> intersection_doms;
         if (intersect->is_region())
-          intersection_doms = &(row_source->get_intersection_domains(
-                intersect->as_region_node()->row_source));
+          row_source->get_intersection_domains(
+                intersect->as_region_node()->row_source, intersection_doms);
         else
-          intersection_doms = &(row_source->get_intersection_domains(
-                intersect->as_partition_node()->row_source));
+          row_source->get_intersection_domains(
+                intersect->as_partition_node()->row_source, intersection_doms);
         std::set<ApEvent> done_events;
         if (predicate_guard.exists())
         {
           ApEvent pred_pre = Runtime::merge_events(precondition,
                                                    ApEvent(predicate_guard));
           // Have to protect the against misspeculation
-          for (std::set<Domain>::const_iterator it = intersection_doms->begin();
-                it != intersection_doms->end(); it++)
+          for (std::vector<Domain>::const_iterator it = 
+                intersection_doms.begin(); it != intersection_doms.end(); it++)
             done_events.insert(Runtime::ignorefaults(it->fill(dst_fields, 
                     requests, fill_value, fill_size, pred_pre)));
         }
         else
         {
-          for (std::set<Domain>::const_iterator it = intersection_doms->begin();
-                it != intersection_doms->end(); it++)
+          for (std::vector<Domain>::const_iterator it = 
+                intersection_doms.begin(); it != intersection_doms.end(); it++)
             done_events.insert(ApEvent(it->fill(dst_fields, requests,
                                        fill_value, fill_size, precondition)));
         }
@@ -15999,6 +16524,57 @@ namespace Legion {
       return false;
     }
 
+    //--------------------------------------------------------------------------
+    bool RegionNode::are_projections_disjoint(ContextID ctx, 
+                                              const FieldState &state,
+                                              const FieldMask &mask,
+                                              const ColorPoint &next_child,
+                                         const ProjectionInfo &next_projection)
+    //--------------------------------------------------------------------------
+    {
+      // We can only know which children are going to be touched without
+      // invoking the projection functor if it is the identity projection
+      if ((next_projection.projection_type != PART_PROJECTION) ||
+          (next_projection.projection->projection_id != 0))
+        return false;
+      const Domain &next_domain = next_projection.projection_domain;
+      if (next_domain.get_volume() > DEFAULT_MAX_CLOSE_ELISION_COLORS)
+        return false;
+      PartitionNode *next_node = get_child(next_child);
+      std::vector<IndexSpaceNode*> next_spaces;
+      for (Domain::DomainPointIterator itr(next_domain); itr; itr++)
+      {
+        const ColorPoint color(itr.p);
+        if (!next_node->has_color(color))
+          return false;
+        next_spaces.push_back(next_node->get_child(color)->row_source);
+      }
+      for (LegionMap<ColorPoint,FieldMask>::aligned::const_iterator it = 
+            state.open_children.begin(); it != state.open_children.end(); it++)
+      {
+        const FieldMask overlap = it->second & mask;
+        if (!overlap || (it->first == next_child) ||
+            are_children_disjoint(it->first, next_child))
+          continue;
+        PartitionNode *child = get_child(it->first);
+        std::set<ColorPoint> written_colors;
+        if (!child->find_projection_write_colors(ctx, overlap, written_colors))
+          return false;
+        for (std::set<ColorPoint>::const_iterator cit = 
+              written_colors.begin(); cit != written_colors.end(); cit++)
+        {
+          if (!child->has_color(*cit))
+            return false;
+          IndexSpaceNode *written = child->get_child(*cit)->row_source;
+          for (std::vector<IndexSpaceNode*>::const_iterator nit = 
+                next_spaces.begin(); nit != next_spaces.end(); nit++)
+            if (written->intersects_with(*nit))
+              return false;
+        }
+      }
+      return true;
+    }
+
     //--------------------------------------------------------------------------
     void RegionNode::instantiate_children(void)
     //--------------------------------------------------------------------------
@@ -16047,7 +16623,8 @@ namespace Legion {
                                                           Runtime *runtime)
     //--------------------------------------------------------------------------
     {
-      return (handle.tree_id % runtime->runtime_stride);
+      return (LEGION_TREE_ID_FILTER(handle.tree_id) % 
+              runtime->runtime_stride);
     }
 
     //--------------------------------------------------------------------------
@@ -16195,18 +16772,34 @@ namespace Legion {
         {
           // Send the parent node first
           parent->send_node(target);
-          AutoLock n_lock(node_lock);
-          for (LegionMap<SemanticTag,SemanticInfo>::aligned::iterator it = 
-                semantic_info.begin(); it != semantic_info.end(); it++)
+          // Pack each piece of semantic information under the lock
+          // but send it without holding the lock since sending can
+          // block on the message manager
+          std::vector<SemanticTag> tags;
+          {
+            AutoLock n_lock(node_lock,1,false/*exclusive*/);
+            for (LegionMap<SemanticTag,SemanticInfo>::aligned::iterator it = 
+                  semantic_info.begin(); it != semantic_info.end(); it++)
+              tags.push_back(it->first);
+          }
+          for (std::vector<SemanticTag>::const_iterator it = 
+                tags.begin(); it != tags.end(); it++)
           {
             Serializer rez;
             {
+              AutoLock n_lock(node_lock,1,false/*exclusive*/);
+              LegionMap<SemanticTag,SemanticInfo>::aligned::const_iterator
+                finder = semantic_info.find(*it);
+#ifdef DEBUG_LEGION
+              assert(finder != semantic_info.end());
+#endif
+              const SemanticInfo &info = finder->second;
               RezCheck z(rez);
               rez.serialize(handle);
-              rez.serialize(it->first);
-              rez.serialize(it->second.size);
-              rez.serialize(it->second.buffer, it->second.size);
-              rez.serialize(it->second.is_mutable);
+              rez.serialize(*it);
+              rez.serialize(info.size);
+              rez.serialize(info.buffer, info.size);
+              rez.serialize(info.is_mutable);
             }
             context->runtime->send_logical_region_semantic_info(target, rez);
           }
@@ -17672,6 +18265,7 @@ namespace Legion {
       // If we've already been destroyed then we are done
       if (destroyed)
         return;
+      NodeSet destruction_targets;
       bool perform_invalidations = false;
       {
         AutoLock n_lock(node_lock);
@@ -17679,13 +18273,14 @@ namespace Legion {
         {
           destroyed = true;
           perform_invalidations = true;
-          if (!creation_set.empty())
-          {
-            DestructionFunctor functor(handle, context->runtime);
-            creation_set.map(functor);
-          }
+          destruction_targets = creation_set;
         }
       }
+      if (!destruction_targets.empty())
+      {
+        DestructionFunctor functor(handle, context->runtime);
+        destruction_targets.map(functor);
+      }
       if (perform_invalidations)
       {
         // TODO: Make this more precise so that it happens on 
@@ -17697,6 +18292,17 @@ namespace Legion {
       }
     }
 
+    //--------------------------------------------------------------------------
+    void PartitionNode::gather_tree_nodes(std::vector<RegionNode*> &regions,
+                                 std::vector<PartitionNode*> &partitions) const
+    //--------------------------------------------------------------------------
+    {
+      partitions.push_back(const_cast<PartitionNode*>(this));
+      for (std::map<ColorPoint,RegionNode*>::const_iterator it = 
+            color_map.begin(); it != color_map.end(); it++)
+        it->second->gather_tree_nodes(regions, partitions);
+    }
+
     //--------------------------------------------------------------------------
     unsigned PartitionNode::get_depth(void) const
     //--------------------------------------------------------------------------
@@ -17786,6 +18392,89 @@ namespace Legion {
       return row_source->is_disjoint();
     }
 
+    //--------------------------------------------------------------------------
+    bool PartitionNode::find_projection_write_colors(ContextID ctx,
+                                                     const FieldMask &mask,
+                                                   std::set<ColorPoint> &colors)
+    //--------------------------------------------------------------------------
+    {
+      LogicalState &state = get_logical_state(ctx);
+      // If anything was closed or reduced at this level 
+      // then the dirty data could be anywhere below us
+      if (!(mask * state.dirty_fields) || !(mask * state.reduction_fields))
+        return false;
+      std::vector<Domain> domains;
+      for (LegionList<FieldState>::aligned::const_iterator it = 
+            state.field_states.begin(); it != state.field_states.end(); it++)
+      {
+        if (it->valid_fields * mask)
+          continue;
+        switch (it->open_state)
+        {
+          case OPEN_READ_ONLY_PROJ:
+            break;
+          case OPEN_READ_WRITE_PROJ:
+          case OPEN_READ_WRITE_PROJ_DISJOINT_SHALLOW:
+            {
+              if (it->projection->projection_id != 0)
+                return false;
+              domains.push_back(it->projection_domain);
+              break;
+            }
+          default:
+            // Anything else has dirty children we can't enumerate
+            return false;
+        }
+      }
+      // The projection epochs record every projection that has 
+      // written to the children since they were last closed
+      for (std::list<ProjectionEpoch*>::const_iterator it = 
+            state.projection_epochs.begin(); it != 
+            state.projection_epochs.end(); it++)
+      {
+        if ((*it)->valid_fields * mask)
+          continue;
+        for (std::map<ProjectionFunction*,std::set<Domain> >::const_iterator
+              pit = (*it)->projections.begin(); 
+              pit != (*it)->projections.end(); pit++)
+        {
+          if (pit->first->projection_id != 0)
+            return false;
+          domains.insert(domains.end(), pit->second.begin(), 
+                         pit->second.end());
+        }
+      }
+      for (std::vector<Domain>::const_iterator it = 
+            domains.begin(); it != domains.end(); it++)
+      {
+        if (it->get_volume() > DEFAULT_MAX_CLOSE_ELISION_COLORS)
+          return false;
+        for (Domain::DomainPointIterator itr(*it); itr; itr++)
+          colors.insert(ColorPoint(itr.p));
+      }
+      return true;
+    }
+
+    //--------------------------------------------------------------------------
+    bool PartitionNode::has_only_read_projections(ContextID ctx,
+                                                  const FieldMask &mask)
+    //--------------------------------------------------------------------------
+    {
+      LogicalState &state = get_logical_state(ctx);
+      if (!(mask * state.dirty_fields) || !(mask * state.reduction_fields) ||
+          !(mask * state.dirty_below))
+        return false;
+      for (LegionList<FieldState>::aligned::const_iterator it = 
+            state.field_states.begin(); it != state.field_states.end(); it++)
+      {
+        if (it->valid_fields * mask)
+          continue;
+        if (it->open_state != OPEN_READ_ONLY_PROJ)
+          return false;
+      }
+      return true;
+    }
+
     //--------------------------------------------------------------------------
     void PartitionNode::instantiate_children(void)
     //--------------------------------------------------------------------------
@@ -17834,7 +18523,8 @@ namespace Legion {
                                      LogicalPartition handle, Runtime *runtime)
     //--------------------------------------------------------------------------
     {
-      return (handle.tree_id % runtime->runtime_stride);
+      return (LEGION_TREE_ID_FILTER(handle.tree_id) % 
+              runtime->runtime_stride);
     }
 
     //--------------------------------------------------------------------------
@@ -17990,18 +18680,32 @@ namespace Legion {
 #endif
         // Send the parent node first
         parent->send_node(target);
-        AutoLock n_lock(node_lock);
-        for (LegionMap<SemanticTag,SemanticInfo>::aligned::iterator it = 
-              semantic_info.begin(); it != semantic_info.end(); it++)
+        // Send semantic information outside the lock, see RegionNode
+        std::vector<SemanticTag> tags;
+        {
+          AutoLock n_lock(node_lock,1,false/*exclusive*/);
+          for (LegionMap<SemanticTag,SemanticInfo>::aligned::iterator it = 
+                semantic_info.begin(); it != semantic_info.end(); it++)
+            tags.push_back(it->first);
+        }
+        for (std::vector<SemanticTag>::const_iterator it = 
+              tags.begin(); it != tags.end(); it++)
         {
           Serializer rez;
           {
+            AutoLock n_lock(node_lock,1,false/*exclusive*/);
+            LegionMap<SemanticTag,SemanticInfo>::aligned::const_iterator
+              finder = semantic_info.find(*it);
+#ifdef DEBUG_LEGION
+            assert(finder != semantic_info.end());
+#endif
+            const SemanticInfo &info = finder->second;
             RezCheck z(rez);
             rez.serialize(handle);
-            rez.serialize(it->first);
-            rez.serialize(it->second.size);
-            rez.serialize(it->second.buffer, it->second.size);
-            rez.serialize(it->second.is_mutable);
+            rez.serialize(*it);
+            rez.serialize(info.size);
+            rez.serialize(info.buffer, info.size);
+            rez.serialize(info.is_mutable);
           }
           context->runtime->send_logical_partition_semantic_info(target, rez);
         }
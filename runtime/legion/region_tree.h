@@ -23,10 +23,109 @@
 #include "legion_analysis.h"
 #include "garbage_collection.h"
 #include "field_tree.h"
+#include "domain_tree.h"
 
 namespace Legion {
   namespace Internal {
-    
+
+    /**
+     * \class NodeTable
+     * A dense look-up table for the nodes of the region tree forest
+     * indexed by handle ID. Every address space hands out IDs with a
+     * stride of the number of address spaces, so the table keeps one
+     * vector of entries per creating address space indexed by the ID
+     * divided by the stride. Entries record the full ID of their value
+     * so that a stale handle whose slot has been recycled for a newer
+     * generation never finds the wrong node. If two generations of the
+     * same slot are alive at once the later one goes in an overflow
+     * map until the earlier one is removed. The table does no locking
+     * of its own.
+     */
+    template<typename IT, typename T>
+    class NodeTable {
+    public:
+      struct Entry {
+      public:
+        Entry(void) : id(0), value() { }
+      public:
+        IT id;
+        T value;
+      };
+    public:
+      NodeTable(void) : stride(1), id_mask(~IT(0)) { }
+    public:
+      inline void initialize(unsigned s, IT mask = ~IT(0))
+        { stride = s; id_mask = mask; }
+      inline T* find(IT id)
+      {
+        const IT base = id & id_mask;
+        const size_t owner = base % stride;
+        const size_t index = base / stride;
+        if ((owner < entries.size()) && (index < entries[owner].size()) &&
+            (entries[owner][index].id == id))
+          return &(entries[owner][index].value);
+        if (!overflow.empty())
+        {
+          typename std::map<IT,T>::iterator finder = overflow.find(id);
+          if (finder != overflow.end())
+            return &(finder->second);
+        }
+        return NULL;
+      }
+      // Find the value for the ID or make an empty one for it
+      inline T& insert(IT id)
+      {
+        const IT base = id & id_mask;
+        const size_t owner = base % stride;
+        const size_t index = base / stride;
+        if (owner >= entries.size())
+          entries.resize(owner + 1);
+        std::vector<Entry> &slots = entries[owner];
+        if (index >= slots.size())
+          slots.resize(index + 1);
+        Entry &entry = slots[index];
+        if (entry.id == id)
+          return entry.value;
+        if (entry.id == 0)
+        {
+          entry.id = id;
+          return entry.value;
+        }
+        // Another generation of this slot is still alive
+        return overflow[id];
+      }
+      inline void erase(IT id)
+      {
+        const IT base = id & id_mask;
+        const size_t owner = base % stride;
+        const size_t index = base / stride;
+        if ((owner < entries.size()) && (index < entries[owner].size()) &&
+            (entries[owner][index].id == id))
+        {
+          entries[owner][index] = Entry();
+          return;
+        }
+        overflow.erase(id);
+      }
+      inline void get_values(std::vector<T> &values) const
+      {
+        for (typename std::vector<std::vector<Entry> >::const_iterator it =
+              entries.begin(); it != entries.end(); it++)
+          for (typename std::vector<Entry>::const_iterator eit =
+                it->begin(); eit != it->end(); eit++)
+            if (eit->id != 0)
+              values.push_back(eit->value);
+        for (typename std::map<IT,T>::const_iterator it =
+              overflow.begin(); it != overflow.end(); it++)
+          values.push_back(it->second);
+      }
+    protected:
+      unsigned stride;
+      IT id_mask;
+      std::vector<std::vector<Entry> > entries;
+      std::map<IT,T> overflow;
+    };
+
     /**
      * \class RegionTreeForest
      * "In the darkness of the forest resides the one true magic..."
@@ -497,6 +596,13 @@ namespace Legion {
       RegionNode*     get_tree(RegionTreeID tid);
       // Request but don't block
       RtEvent request_node(IndexSpace space);
+      // Free all the nodes of a destroyed region tree once the last
+      // reference to the tree has been removed
+      void reclaim_region_tree(RegionNode *root);
+    protected:
+      // The lookup lock must be held when calling these
+      RegionNode*     find_local_node(LogicalRegion handle);
+      PartitionNode*  find_local_node(LogicalPartition handle);
     public:
       bool has_node(IndexSpace space, bool local_only = false);
       bool has_node(IndexPartition part, bool local_only = false);
@@ -614,17 +720,25 @@ namespace Legion {
                                          bool can_fail, bool wait_until);
     public:
       Runtime *const runtime;
+    public:
+      // Statistics for the intersection caches of all the index tree
+      // nodes in this forest, updated with atomics
+      unsigned long long intersection_hits;
+      unsigned long long intersection_misses;
+      unsigned long long intersection_evictions;
     protected:
       Reservation lookup_lock;
     private:
       // The lookup lock must be held when accessing these
       // data structures
-      std::map<IndexSpace,IndexSpaceNode*>     index_nodes;
-      std::map<IndexPartition,IndexPartNode*>  index_parts;
-      std::map<FieldSpace,FieldSpaceNode*>     field_nodes;
-      std::map<LogicalRegion,RegionNode*>     region_nodes;
-      std::map<LogicalPartition,PartitionNode*> part_nodes;
-      std::map<RegionTreeID,RegionNode*>        tree_nodes;
+      NodeTable<IndexSpaceID,IndexSpaceNode*>               index_nodes;
+      NodeTable<IndexPartitionID,IndexPartNode*>            index_parts;
+      NodeTable<FieldSpaceID,FieldSpaceNode*>               field_nodes;
+      // Logical nodes are kept with their row source's ID, one
+      // for each region tree that has been made on that row source
+      NodeTable<IndexSpaceID,std::vector<RegionNode*> >     region_nodes;
+      NodeTable<IndexPartitionID,std::vector<PartitionNode*> > part_nodes;
+      NodeTable<RegionTreeID,RegionNode*>                   tree_nodes;
     private:
       // pending events for requested nodes
       std::map<IndexSpace,RtEvent>       index_space_requests;
@@ -648,17 +762,32 @@ namespace Legion {
       public:
         IntersectInfo(void)
           : has_intersects(false),
-            intersections_valid(false) { }
+            intersections_valid(false), owns_spaces(false), last_use(0) { }
         IntersectInfo(bool has)
           : has_intersects(has), 
-            intersections_valid(!has) { }
+            intersections_valid(!has), owns_spaces(false), last_use(0) { }
         IntersectInfo(const std::set<Domain> &ds)
           : has_intersects(true), intersections_valid(true),
-            intersections(ds) { }
+            owns_spaces(false), last_use(0),
+            intersections(ds.begin(), ds.end()) 
+        {
+          // Unstructured intersections are index spaces that we made
+          for (std::set<Domain>::const_iterator it = ds.begin();
+                it != ds.end(); it++)
+            if (it->get_dim() == 0)
+              owns_spaces = true;
+        }
+      public:
+        inline size_t cost(void) const { return (1 + intersections.size()); }
       public:
         bool has_intersects;
         bool intersections_valid;
-        std::set<Domain> intersections;
+        // Entries that own index spaces are never evicted since
+        // someone might still be using them
+        bool owns_spaces;
+        unsigned long long last_use;
+        // Sorted like a set, but without the per-element overhead
+        std::vector<Domain> intersections;
       };
     public:
       IndexTreeNode(void);
@@ -704,6 +833,16 @@ namespace Legion {
                                        Domain &result, bool compute);
       static bool compute_dominates(const std::set<Domain> &left_set,
                                     const std::set<Domain> &right_set);
+    protected:
+      // The intersection cache is bounded by Runtime::max_intersection_cache
+      // (counting one per entry plus one per cached domain) and evicts the
+      // least recently used entries. Lookups can be done holding the node
+      // lock in any mode, but recording must hold it exclusively.
+      const IntersectInfo* find_intersection(IndexTreeNode *other,
+                                             bool need_domains);
+      const IntersectInfo& record_intersection(IndexTreeNode *other,
+                                               const IntersectInfo &info);
+      void evict_intersections(IndexTreeNode *keep);
     public:
       const unsigned depth;
       const ColorPoint color;
@@ -713,12 +852,15 @@ namespace Legion {
       NodeSet child_creation;
       bool destroyed;
     protected:
-      Reservation node_lock;
+      LocalLock node_lock;
     protected:
       std::map<IndexTreeNode*,IntersectInfo> intersections;
+      size_t intersection_cache_size;
+      unsigned long long intersection_clock;
       std::map<IndexTreeNode*,bool> dominators;
     protected:
       LegionMap<SemanticTag,SemanticInfo>::aligned semantic_info;
+      std::map<SemanticTag,RtUserEvent> semantic_requests;
     protected:
       std::map<std::pair<ColorPoint,ColorPoint>,RtEvent> pending_tests;
     };
@@ -822,6 +964,7 @@ namespace Legion {
       Color generate_color(void);
     public:
       void add_instance(RegionNode *inst);
+      void remove_instance(RegionNode *inst);
       bool has_instance(RegionTreeID tid);
       void add_creation_source(AddressSpaceID source);
       void destroy_node(AddressSpaceID source);
@@ -832,8 +975,10 @@ namespace Legion {
       const std::set<Domain>& get_component_domains(ApEvent &pre) const;
       bool intersects_with(IndexSpaceNode *other, bool compute = true);
       bool intersects_with(IndexPartNode *other, bool compute = true);
-      const std::set<Domain>& get_intersection_domains(IndexSpaceNode *other);
-      const std::set<Domain>& get_intersection_domains(IndexPartNode *other);
+      void get_intersection_domains(IndexSpaceNode *other,
+                                    std::vector<Domain> &domains);
+      void get_intersection_domains(IndexPartNode *other,
+                                    std::vector<Domain> &domains);
       bool dominates(IndexSpaceNode *other);
       bool dominates(IndexPartNode *other);
     public:
@@ -987,14 +1132,24 @@ namespace Legion {
       void get_children(std::map<ColorPoint,IndexSpaceNode*> &children);
     public:
       void compute_disjointness(RtUserEvent ready_event);
+      // Record that the disjointness test should only be launched
+      // (once the precondition triggers) when someone asks for it
+      void defer_disjointness(RtUserEvent ready_event, RtEvent precondition);
       bool is_disjoint(bool from_app = false);
       bool are_disjoint(const ColorPoint &c1, const ColorPoint &c2,
                         bool force_compute = false);
       void record_disjointness(bool disjoint,
                                const ColorPoint &c1, const ColorPoint &c2);
       bool is_complete(void);
+    protected:
+      void launch_deferred_disjointness(void);
+      // Tests disjointness in time linear in the number of children
+      // plus the size of the overlaps, returns false if it can't
+      bool sweep_disjointness(const std::set<ColorPoint> &colors,
+                              bool &result);
     public:
       void add_instance(PartitionNode *inst);
+      void remove_instance(PartitionNode *inst);
       bool has_instance(RegionTreeID tid);
       void add_creation_source(AddressSpaceID source);
       void destroy_node(AddressSpaceID source);
@@ -1016,10 +1171,21 @@ namespace Legion {
     public:
       void get_subspace_domain_preconditions(std::set<ApEvent> &preconditions);
       void get_subspace_domains(std::set<Domain> &subspaces);
+      // Intersect the subspaces of this partition with the given domains
+      // using a spatial index over the subspaces when we can build one
+      bool intersect_subspaces(const std::set<Domain> &domains,
+                               std::set<Domain> &result, bool compute);
+      bool intersect_subspaces(const Domain &domain,
+                               std::set<Domain> &result, bool compute);
+    protected:
+      const DomainTree* get_subspace_tree(void);
+    public:
       bool intersects_with(IndexSpaceNode *other, bool compute = true);
       bool intersects_with(IndexPartNode *other, bool compute = true);
-      const std::set<Domain>& get_intersection_domains(IndexSpaceNode *other);
-      const std::set<Domain>& get_intersection_domains(IndexPartNode *other);
+      void get_intersection_domains(IndexSpaceNode *other,
+                                    std::vector<Domain> &domains);
+      void get_intersection_domains(IndexPartNode *other,
+                                    std::vector<Domain> &domains);
       bool dominates(IndexSpaceNode *other);
       bool dominates(IndexPartNode *other);
     public:
@@ -1054,6 +1220,8 @@ namespace Legion {
     protected:
       bool disjoint;
       ApEvent disjoint_ready;
+      RtUserEvent deferred_disjoint_ready;
+      RtEvent deferred_disjoint_precondition;
       RtEvent all_children_request;
     protected:
       bool has_complete, complete;
@@ -1065,6 +1233,8 @@ namespace Legion {
       std::set<PartitionNode*> logical_nodes;
       std::set<std::pair<ColorPoint,ColorPoint> > disjoint_subspaces;
       std::set<std::pair<ColorPoint,ColorPoint> > aliased_subspaces;
+      // Built lazily once all the subspaces are known
+      DomainTree *subspace_tree;
     protected:
       // Support for pending child spaces that still need to be computed
       std::map<ColorPoint,std::pair<ApUserEvent,ApUserEvent> > pending_children;
@@ -1214,6 +1384,7 @@ namespace Legion {
       void add_instance(RegionNode *inst);
       RtEvent add_instance(LogicalRegion top_handle, AddressSpaceID source);
       bool has_instance(RegionTreeID tid);
+      void remove_instance(RegionNode *inst);
       void destroy_node(AddressSpaceID source);
     public:
       FieldMask get_field_mask(const std::set<FieldID> &fields) const;
@@ -1295,6 +1466,9 @@ namespace Legion {
       NodeSet creation_set;
       bool destroyed;
     private:
+      // Stays a Reservation: send_node must hold it while sending so
+      // that field allocations can't slip in between packing the node
+      // and adding the target to the creation set
       Reservation node_lock;
       // Top nodes in the trees for which this field space is used
       std::set<LogicalRegion> logical_trees;
@@ -1310,6 +1484,9 @@ namespace Legion {
       LegionMap<SemanticTag,SemanticInfo>::aligned semantic_info;
       LegionMap<std::pair<FieldID,SemanticTag>,SemanticInfo>::aligned 
                                                     semantic_field_info;
+      std::map<SemanticTag,RtUserEvent> semantic_requests;
+      std::map<std::pair<FieldID,SemanticTag>,RtUserEvent> 
+                                                    semantic_field_requests;
     private:
       // Local field information
       std::vector<LocalFieldInfo> local_field_infos;
@@ -1341,11 +1518,15 @@ namespace Legion {
       }
       inline LogicalState& get_logical_state(ContextID ctx)
       {
-        return *(logical_states.lookup_entry(ctx, this, ctx));
+        LogicalState *result = logical_states.lookup_entry(ctx, this, ctx);
+        result->touched = true;
+        return *result;
       }
       inline LogicalState* get_logical_state_ptr(ContextID ctx)
       {
-        return logical_states.lookup_entry(ctx, this, ctx);
+        LogicalState *result = logical_states.lookup_entry(ctx, this, ctx);
+        result->touched = true;
+        return result;
       }
       inline VersionManager& get_current_version_manager(ContextID ctx)
       {
@@ -1416,7 +1597,13 @@ namespace Legion {
                                    const FieldMask *aliased_children,
                                    bool record_close_operations,
                                    const ColorPoint &next_child,
+                                   const ProjectionInfo *next_projection,
                                    FieldMask &open_below);
+      void close_read_only_projections(LogicalCloser &closer,
+                                       FieldState &state,
+                                       const FieldMask &closing_mask,
+                                       const ColorPoint &next_child,
+                                       bool record_close_operations);
       void siphon_logical_projection(LogicalCloser &closer,
                                      LogicalState &state,
                                      const FieldMask &closing_mask,
@@ -1506,8 +1693,8 @@ namespace Legion {
             const LegionMap<unsigned,FieldMask>::aligned &dirty_previous,
                                    std::set<RtEvent> &ready_events);
     public:
-      void initialize_current_state(ContextID ctx);
-      void invalidate_current_state(ContextID ctx, bool users_only);
+      bool initialize_current_state(ContextID ctx);
+      bool invalidate_current_state(ContextID ctx, bool users_only);
       void invalidate_deleted_state(ContextID ctx, 
                                     const FieldMask &deleted_mask);
       bool invalidate_version_state(ContextID ctx);
@@ -1635,6 +1822,12 @@ namespace Legion {
       bool register_physical_manager(PhysicalManager *manager);
       void unregister_physical_manager(PhysicalManager *manager);
       PhysicalManager* find_manager(DistributedID did);
+    public:
+      // References that keep all the nodes of this region tree alive,
+      // these are always counted on the root of the tree
+      RegionNode* find_tree_root(void) const;
+      void add_tree_reference(void);
+      void remove_tree_reference(void);
     public:
       virtual unsigned get_depth(void) const = 0;
       virtual const ColorPoint& get_color(void) const = 0;
@@ -1704,15 +1897,15 @@ namespace Legion {
 #endif
     public:
       // Logical helper operations
-      template<AllocationType ALLOC, bool RECORD, bool HAS_SKIP, bool TRACK_DOM>
+      template<bool RECORD, bool HAS_SKIP, bool TRACK_DOM, typename USERS>
       static FieldMask perform_dependence_checks(const LogicalUser &user, 
-          typename LegionList<LogicalUser, ALLOC>::track_aligned &users, 
+          USERS &users, 
           const FieldMask &check_mask, const FieldMask &open_below,
           bool validates_regions, Operation *to_skip = NULL, 
           GenerationID skip_gen = 0);
-      template<AllocationType ALLOC>
+      template<typename USERS>
       static void perform_closing_checks(LogicalCloser &closer, bool read_only,
-          typename LegionList<LogicalUser, ALLOC>::track_aligned &users, 
+          USERS &users, 
           const FieldMask &check_mask);
     public:
       inline FieldSpaceNode* get_column_source(void) const 
@@ -1727,7 +1920,7 @@ namespace Legion {
       DynamicTable<LogicalStateAllocator> logical_states;
       DynamicTable<VersionManagerAllocator> current_versions;
     protected:
-      Reservation node_lock;
+      LocalLock node_lock;
       // While logical states and version managers have dense keys
       // within a node, distributed IDs don't so we use a map that
       // should rarely need to be accessed for tracking views
@@ -1739,6 +1932,7 @@ namespace Legion {
                 PHYSICAL_MANAGER_ALLOC>::tracked physical_managers;
     protected:
       LegionMap<SemanticTag,SemanticInfo>::aligned semantic_info;
+      std::map<SemanticTag,RtUserEvent> semantic_requests;
     };
 
     /**
@@ -1808,6 +2002,10 @@ namespace Legion {
       virtual bool are_all_children_disjoint(void);
       virtual void instantiate_children(void);
       virtual bool is_region(void) const;
+      bool are_projections_disjoint(ContextID ctx, const FieldState &state,
+                                    const FieldMask &mask,
+                                    const ColorPoint &next_child,
+                                    const ProjectionInfo &next_projection);
 #ifdef DEBUG_LEGION
       virtual RegionNode* as_region_node(void) const;
       virtual PartitionNode* as_partition_node(void) const;
@@ -1933,10 +2131,18 @@ namespace Legion {
                               const std::vector<PhysicalManager*> &managers,
                               std::vector<bool> &up_mask, InnerContext *context,
                               std::vector<InstanceView*> &results);
+    public:
+      void gather_tree_nodes(std::vector<RegionNode*> &regions,
+                             std::vector<PartitionNode*> &partitions) const;
     public:
       const LogicalRegion handle;
       PartitionNode *const parent;
       IndexSpaceNode *const row_source;
+    public:
+      // Only used on the root of a region tree, one reference is held
+      // by the forest until the root is destroyed and the rest come
+      // from views, managers, version states, and contexts
+      unsigned tree_references;
     protected:
       std::map<ColorPoint,PartitionNode*> color_map;
       std::map<ColorPoint,PartitionNode*> valid_map;
@@ -2011,6 +2217,9 @@ namespace Legion {
       virtual bool are_all_children_disjoint(void);
       virtual void instantiate_children(void);
       virtual bool is_region(void) const;
+      bool find_projection_write_colors(ContextID ctx, const FieldMask &mask,
+                                        std::set<ColorPoint> &colors);
+      bool has_only_read_projections(ContextID ctx, const FieldMask &mask);
 #ifdef DEBUG_LEGION
       virtual RegionNode* as_region_node(void) const;
       virtual PartitionNode* as_partition_node(void) const;
@@ -2077,6 +2286,9 @@ namespace Legion {
                                          TreeStateLogger *logger,
                                          const FieldMask &mask);
 #endif
+    public:
+      void gather_tree_nodes(std::vector<RegionNode*> &regions,
+                             std::vector<PartitionNode*> &partitions) const;
     public:
       const LogicalPartition handle;
       RegionNode *const parent;
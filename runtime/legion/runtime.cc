@@ -1913,36 +1913,9 @@ namespace Legion {
     
     //--------------------------------------------------------------------------
     MPIRankTable::MPIRankTable(Runtime *rt)
-    : runtime(rt), participating(int(runtime->address_space) <
-                                 Runtime::legion_collective_participating_spaces),
-    reservation(Reservation::create_reservation())
-    //--------------------------------------------------------------------------
-    {
-      // We already have our contributions for each stage so
-      // we can set the inditial participants to 1
-      if (participating)
-      {
-        sent_stages.resize(Runtime::legion_collective_stages, false);
-#ifdef DEBUG_LEGION
-        assert(Runtime::legion_collective_stages > 0);
-#endif
-        stage_notifications.resize(Runtime::legion_collective_stages, 1);
-        // Stage 0 always starts with 0 notifications since we'll
-        // explictcly arrive on it
-        // Special case: if we expect a stage -1 message from a
-        // non-participating space, we'll count that as part of
-        // stage 0, it will make it a negative count, but the
-        // type is 'int' so we're good
-        if ((Runtime::legion_collective_stages > 0) &&
-            (runtime->address_space <
-             (runtime->total_address_spaces -
-              Runtime::legion_collective_participating_spaces)))
-          stage_notifications[0] = -1;
-        else
-          stage_notifications[0] = 0;
-      }
-      if (runtime->total_address_spaces > 1)
-        done_event = Runtime::create_rt_user_event();
+    : runtime(rt)
+    //--------------------------------------------------------------------------
+    {
       // Add ourselves to the set before any exchanges start
 #ifdef DEBUG_LEGION
       assert(Runtime::mpi_rank >= 0);
@@ -1952,7 +1925,7 @@ namespace Legion {
     
     //--------------------------------------------------------------------------
     MPIRankTable::MPIRankTable(const MPIRankTable &rhs)
-    : runtime(NULL), participating(false)
+    : runtime(NULL)
     //--------------------------------------------------------------------------
     {
       // should never be called
@@ -1963,8 +1936,6 @@ namespace Legion {
     MPIRankTable::~MPIRankTable(void)
     //--------------------------------------------------------------------------
     {
-      reservation.destroy_reservation();
-      reservation = Reservation::NO_RESERVATION;
     }
     
     //--------------------------------------------------------------------------
@@ -1983,30 +1954,22 @@ namespace Legion {
       // We can skip this part if there are not multiple nodes
       if (runtime->total_address_spaces > 1)
       {
-        // See if we are participating node or not
-        if (participating)
+        // Every node runs this exactly once at start-up, so we can just
+        // do an all-gather of the MPI ranks with Realm, which gives them 
+        // to us in address space order
+        std::vector<int> ranks(runtime->total_address_spaces);
+        const int local_rank = Runtime::mpi_rank;
+        RtEvent exchanged(Realm::Runtime::get_runtime().allgather(&local_rank,
+                                                 &ranks[0], sizeof(local_rank)));
+        exchanged.lg_wait();
+        for (unsigned idx = 0; idx < ranks.size(); idx++)
         {
-          // We are a participating node
-          // See if we are waiting for an initial notification
-          // if not we can just send our message now
-          if ((int(runtime->total_address_spaces) ==
-               Runtime::legion_collective_participating_spaces) ||
-              (runtime->address_space >= (runtime->total_address_spaces -
-                                          Runtime::legion_collective_participating_spaces)))
-          {
-            const bool all_stages_done =  send_explicit_stage(0);
-            if (all_stages_done)
-              complete_exchange();
-          }
-        }
-        else
-        {
-          // We are not a participating node
-          // so we just have to send notification to one node
-          send_explicit_stage(-1);
+#ifdef DEBUG_LEGION
+          assert(forward_mapping.find(ranks[idx]) == forward_mapping.end() ||
+                 (forward_mapping[ranks[idx]] == idx));
+#endif
+          forward_mapping[ranks[idx]] = idx;
         }
-        // Wait for our done event to be ready
-        done_event.lg_wait();
       }
 #ifdef DEBUG_LEGION
       assert(forward_mapping.size() == runtime->total_address_spaces);
@@ -2017,288 +1980,6 @@ namespace Legion {
         reverse_mapping[it->second] = it->first;
     }
     
-    //--------------------------------------------------------------------------
-    bool MPIRankTable::send_explicit_stage(int stage)
-    //--------------------------------------------------------------------------
-    {
-      bool all_stages_done = false;
-      Serializer rez;
-      {
-        RezCheck z(rez);
-        rez.serialize(stage);
-        AutoLock r_lock(reservation);
-#ifdef DEBUG_LEGION
-        {
-          size_t expected_size = 1;
-          for (int idx = 0; idx < stage; idx++)
-            expected_size *= Runtime::legion_collective_radix;
-          assert(expected_size <= forward_mapping.size());
-        }
-        if (stage >= 0)
-        {
-          assert(stage < int(sent_stages.size()));
-          assert(!sent_stages[stage]);
-        }
-#endif
-        rez.serialize<size_t>(forward_mapping.size());
-        for (std::map<int,AddressSpace>::const_iterator it =
-             forward_mapping.begin(); it != forward_mapping.end(); it++)
-        {
-          rez.serialize(it->first);
-          rez.serialize(it->second);
-        }
-        // Mark that we're sending this stage
-        if (stage >= 0)
-        {
-#ifdef DEBUG_LEGION
-          assert(stage < int(stage_notifications.size()));
-          if (stage == (Runtime::legion_collective_stages-1))
-            assert(stage_notifications[stage] <
-                   Runtime::legion_collective_last_radix);
-          else
-            assert(stage_notifications[stage] <
-                   Runtime::legion_collective_radix);
-#endif
-          stage_notifications[stage]++;
-          sent_stages[stage] = true;
-          // Check to see if all the stages are done
-          all_stages_done = (stage_notifications.back() ==
-                             Runtime::legion_collective_last_radix);
-          if (all_stages_done)
-          {
-            for (int stage = 1;
-                 stage < Runtime::legion_collective_stages; stage++)
-            {
-              if (stage_notifications[stage-1] ==
-                  Runtime::legion_collective_radix)
-                continue;
-              all_stages_done = false;
-              break;
-            }
-          }
-        }
-      }
-      if (stage == -1)
-      {
-        if (participating)
-        {
-          // Send back to the nodes that are not participating
-          AddressSpaceID target = runtime->address_space +
-          Runtime::legion_collective_participating_spaces;
-#ifdef DEBUG_LEGION
-          assert(target < runtime->total_address_spaces);
-#endif
-          runtime->send_mpi_rank_exchange(target, rez);
-        }
-        else
-        {
-          // Sent to a node that is participating
-          AddressSpaceID target = runtime->address_space %
-          Runtime::legion_collective_participating_spaces;
-          runtime->send_mpi_rank_exchange(target, rez);
-        }
-      }
-      else
-      {
-#ifdef DEBUG_LEGION
-        assert(stage >= 0);
-#endif
-        if (stage == (Runtime::legion_collective_stages-1))
-        {
-          for (int r = 1; r < Runtime::legion_collective_last_radix; r++)
-          {
-            AddressSpaceID target = runtime->address_space ^
-            (r << (stage * Runtime::legion_collective_log_radix));
-#ifdef DEBUG_LEGION
-            assert(int(target) <
-                   Runtime::legion_collective_participating_spaces);
-#endif
-            runtime->send_mpi_rank_exchange(target, rez);
-          }
-        }
-        else
-        {
-          for (int r = 1; r < Runtime::legion_collective_radix; r++)
-          {
-            AddressSpaceID target = runtime->address_space ^
-            (r << (stage * Runtime::legion_collective_log_radix));
-#ifdef DEBUG_LEGION
-            assert(int(target) <
-                   Runtime::legion_collective_participating_spaces);
-#endif
-            runtime->send_mpi_rank_exchange(target, rez);
-          }
-        }
-      }
-      return all_stages_done;
-    }
-    
-    //--------------------------------------------------------------------------
-    bool MPIRankTable::send_ready_stages(void)
-    //--------------------------------------------------------------------------
-    {
-#ifdef DEBUG_LEGION
-      assert(participating);
-#endif
-      // Iterate through the stages and send any that are ready
-      // Remember that stages have to be done in order
-      for (int stage = 1; stage < Runtime::legion_collective_stages; stage++)
-      {
-        Serializer rez;
-        {
-          RezCheck z(rez);
-          rez.serialize(stage);
-          AutoLock r_lock(reservation);
-          // If this stage has already been sent then we can keep going
-          if (sent_stages[stage])
-            continue;
-          // Check to see if we're sending this stage
-          // We need all the notifications from the previous stage before
-          // we can send this stage
-          if (stage_notifications[stage-1] < Runtime::legion_collective_radix)
-            return false;
-          // If we get here then we can send the stage
-          sent_stages[stage] = true;
-#ifdef DEBUG_LEGION
-          {
-            size_t expected_size = 1;
-            for (int idx = 0; idx < stage; idx++)
-              expected_size *= Runtime::legion_collective_radix;
-            assert(expected_size <= forward_mapping.size());
-          }
-#endif
-          rez.serialize<size_t>(forward_mapping.size());
-          for (std::map<int,AddressSpace>::const_iterator it =
-               forward_mapping.begin(); it != forward_mapping.end(); it++)
-          {
-            rez.serialize(it->first);
-            rez.serialize(it->second);
-          }
-        }
-        // Now we can do the send
-        if (stage == (Runtime::legion_collective_stages-1))
-        {
-          for (int r = 1; r < Runtime::legion_collective_last_radix; r++)
-          {
-            AddressSpaceID target = runtime->address_space ^
-            (r << (stage * Runtime::legion_collective_log_radix));
-#ifdef DEBUG_LEGION
-            assert(int(target) <
-                   Runtime::legion_collective_participating_spaces);
-#endif
-            runtime->send_mpi_rank_exchange(target, rez);
-          }
-        }
-        else
-        {
-          for (int r = 1; r < Runtime::legion_collective_radix; r++)
-          {
-            AddressSpaceID target = runtime->address_space ^
-            (r << (stage * Runtime::legion_collective_log_radix));
-#ifdef DEBUG_LEGION
-            assert(int(target) <
-                   Runtime::legion_collective_participating_spaces);
-#endif
-            runtime->send_mpi_rank_exchange(target, rez);
-          }
-        }
-      }
-      // If we make it here, then we sent the last stage, check to see
-      // if we've seen all the notifications for it
-      AutoLock r_lock(reservation,1,false/*exclusive*/);
-      return (stage_notifications.back() ==
-              Runtime::legion_collective_last_radix);
-    }
-    
-    //--------------------------------------------------------------------------
-    void MPIRankTable::handle_mpi_rank_exchange(Deserializer &derez)
-    //--------------------------------------------------------------------------
-    {
-      DerezCheck z(derez);
-      int stage;
-      derez.deserialize(stage);
-#ifdef DEBUG_LEGION
-      assert(participating || (stage == -1));
-#endif
-      unpack_exchange(stage, derez);
-      bool all_stages_done = false;
-      if (stage == -1)
-      {
-        if (!participating)
-        {
-#ifdef DEBUG_LEGION
-          assert(forward_mapping.size() == runtime->total_address_spaces);
-#endif
-          Runtime::trigger_event(done_event);
-        }
-        else // we can now send our stage 0
-          all_stages_done = send_explicit_stage(0);
-      }
-      else
-        all_stages_done = send_ready_stages();
-      if (all_stages_done)
-        complete_exchange();
-    }
-    
-    //--------------------------------------------------------------------------
-    void MPIRankTable::unpack_exchange(int stage, Deserializer &derez)
-    //--------------------------------------------------------------------------
-    {
-      size_t num_entries;
-      derez.deserialize(num_entries);
-      AutoLock r_lock(reservation);
-      for (unsigned idx = 0; idx < num_entries; idx++)
-      {
-        int rank;
-        derez.deserialize(rank);
-        unsigned space;
-        derez.deserialize(space);
-#ifdef DEBUG_LEGION
-        // Duplicates are possible because later messages aren't "held", but
-        // they should be exact matches
-        assert ((forward_mapping.count(rank) == 0) ||
-                (forward_mapping[rank] == space));
-#endif
-        forward_mapping[rank] = space;
-      }
-      // A stage -1 message is counted as part of stage 0 (if it exists
-      //  and we are participating)
-      if ((stage == -1) && participating &&
-          (Runtime::legion_collective_stages > 0))
-        stage = 0;
-      if (stage >= 0)
-      {
-#ifdef DEBUG_LEGION
-        assert(stage < int(stage_notifications.size()));
-        if (stage < (Runtime::legion_collective_stages-1))
-          assert(stage_notifications[stage] <
-                 Runtime::legion_collective_radix);
-        else
-          assert(stage_notifications[stage] <
-                 Runtime::legion_collective_last_radix);
-#endif
-        stage_notifications[stage]++;
-      }
-    }
-    
-    //--------------------------------------------------------------------------
-    void MPIRankTable::complete_exchange(void)
-    //--------------------------------------------------------------------------
-    {
-#ifdef DEBUG_LEGION
-      assert(forward_mapping.size() == runtime->total_address_spaces);
-#endif
-      // We are done
-      Runtime::trigger_event(done_event);
-      // See if we have to send a message back to a
-      // non-participating node
-      if ((int(runtime->total_address_spaces) >
-           Runtime::legion_collective_participating_spaces) &&
-          (int(runtime->address_space) < int(runtime->total_address_spaces -
-                                             Runtime::legion_collective_participating_spaces)))
-        send_explicit_stage(-1);
-    }
-    
     /////////////////////////////////////////////////////////////
     // Processor Manager
     /////////////////////////////////////////////////////////////
@@ -2804,6 +2485,7 @@ namespace Legion {
         }
         // Ask the mapper which tasks it would like to schedule
         Mapper::SelectMappingOutput output;
+        output.batch_map_tasks = false;
         if (!visible_tasks.empty())
           mapper->invoke_select_tasks_to_map(&input, &output);
         if (!stealing_disabled)
@@ -2906,6 +2588,10 @@ namespace Legion {
           if (!rqueue.empty())
             mappers_with_work.push_back(map_id);
         }
+        // If the mapper asked for it, let it pick the mappings for all
+        // the individual tasks staying on this processor in one call
+        if (output.batch_map_tasks && !visible_tasks.empty())
+          perform_batch_mapping(mapper, visible_tasks, output);
         // Now that we've removed them from the queue, issue the
         // mapping analysis calls
         TriggerTaskArgs trigger_args;
@@ -2943,6 +2629,53 @@ namespace Legion {
         runtime->send_steal_request(stealing_targets, local_proc);
     }
     
+    //--------------------------------------------------------------------------
+    void ProcessorManager::perform_batch_mapping(MapperManager *mapper,
+                                      const std::list<const Task*> &selected,
+                                      const Mapper::SelectMappingOutput &output)
+    //--------------------------------------------------------------------------
+    {
+      // Only individual tasks that are mapping here get a batched mapping,
+      // slices still have to be broken into points before they can map
+      Mapper::MapTaskBatchInput input;
+      for (std::list<const Task*>::const_iterator it = 
+            selected.begin(); it != selected.end(); it++)
+      {
+        if (output.relocate_tasks.find(*it) != output.relocate_tasks.end())
+          continue;
+        const TaskOp *task = static_cast<const TaskOp*>(*it);
+        if (task->get_task_kind() != TaskOp::INDIVIDUAL_TASK_KIND)
+          continue;
+        input.tasks.push_back(*it);
+      }
+      if (input.tasks.empty())
+        return;
+      Mapper::MapTaskBatchOutput batch_output;
+      std::map<PhysicalManager*,std::pair<unsigned,bool> > acquired;
+      mapper->invoke_map_task_batch(&input, &batch_output, &acquired);
+      for (std::map<const Task*,Mapper::MapTaskOutput>::const_iterator it = 
+            batch_output.task_mappings.begin(); it != 
+            batch_output.task_mappings.end(); it++)
+      {
+        // Ignore anything the mapper made up that wasn't in the batch
+        if (std::find(input.tasks.begin(), input.tasks.end(), it->first) ==
+            input.tasks.end())
+          continue;
+        SingleTask *task = 
+          static_cast<SingleTask*>(const_cast<Task*>(it->first));
+        task->record_batched_mapping(mapper, it->second, acquired);
+      }
+      // The tasks took their own references so we can drop ours
+      LocalReferenceMutator mutator;
+      for (std::map<PhysicalManager*,std::pair<unsigned,bool> >::iterator it =
+            acquired.begin(); it != acquired.end(); it++)
+      {
+        if (it->first->remove_base_valid_ref(MAPPING_ACQUIRE_REF, &mutator,
+                                             it->second.first))
+          delete it->first;
+      }
+    }
+
     //--------------------------------------------------------------------------
     void ProcessorManager::issue_advertisements(MapperID map_id)
     //--------------------------------------------------------------------------
@@ -2980,7 +2713,9 @@ namespace Legion {
     : memory(m), owner_space(m.address_space()),
     is_owner(m.address_space() == rt->address_space),
     capacity(m.capacity()), remaining_capacity(capacity), runtime(rt),
-    manager_lock(Reservation::create_reservation())
+    manager_lock(Reservation::create_reservation()),
+    pooled_bytes(0), pool_limit(0), eviction_policy(EVICT_BEST_FIT),
+    use_clock(0), arc_recent_target(capacity / 2), evicting(false)
     //--------------------------------------------------------------------------
     {
     }
@@ -3051,6 +2786,8 @@ namespace Legion {
           RtEvent wait_on = Runtime::merge_events(wait_for);
           wait_on.lg_wait();
         }
+        // Stop parking instances and free the ones that are parked
+        set_instance_pool_limit(0);
       }
     }
     
@@ -3094,6 +2831,7 @@ namespace Legion {
 #endif
       if (finder->second.current_state != VALID_STATE)
         finder->second.current_state = ACTIVE_STATE;
+      record_instance_use(finder->second, true/*new use*/);
     }
     
     //--------------------------------------------------------------------------
@@ -3127,7 +2865,10 @@ namespace Legion {
             remove_reference = true;
         }
         else // didn't collect it yet
+        {
           info.current_state = COLLECTABLE_STATE;
+          record_instance_use(info, false/*new use*/);
+        }
       }
       // If we are the owner and this is a reduction instance
       // then let's just delete it now
@@ -3156,6 +2897,7 @@ namespace Legion {
         assert(finder->second.current_state == ACTIVE_STATE);
 #endif
       finder->second.current_state = VALID_STATE;
+      record_instance_use(finder->second, true/*new use*/);
     }
     
     //--------------------------------------------------------------------------
@@ -3170,6 +2912,7 @@ namespace Legion {
       assert(finder->second.current_state == VALID_STATE);
 #endif
       finder->second.current_state = ACTIVE_STATE;
+      record_instance_use(finder->second, false/*new use*/);
     }
     
     //--------------------------------------------------------------------------
@@ -3179,7 +2922,7 @@ namespace Legion {
                                                  MappingInstance &result, MapperID mapper_id,
                                                  Processor processor, bool acquire,
                                                  GCPriority priority, UniqueID creator_id,
-                                                 bool remote)
+                                                 TaskID task_id, bool remote)
     //--------------------------------------------------------------------------
     {
       volatile bool success = false;
@@ -3202,6 +2945,7 @@ namespace Legion {
           rez.serialize(processor);
           rez.serialize(priority);
           rez.serialize(creator_id);
+          rez.serialize(task_id);
           rez.serialize(&success);
           rez.serialize(&result);
         }
@@ -3219,7 +2963,7 @@ namespace Legion {
           if (Runtime::legion_spy_enabled)
             manager->log_instance_creation(creator_id, processor, regions);
           record_created_instance(manager, acquire, mapper_id, processor,
-                                  priority, remote);
+                                  priority, task_id, remote);
           result = MappingInstance(manager);
           success = true;
         }
@@ -3233,7 +2977,7 @@ namespace Legion {
                                                  MappingInstance &result,MapperID mapper_id,
                                                  Processor processor, bool acquire,
                                                  GCPriority priority, UniqueID creator_id,
-                                                 bool remote)
+                                                 TaskID task_id, bool remote)
     //--------------------------------------------------------------------------
     {
       volatile bool success = false;
@@ -3256,6 +3000,7 @@ namespace Legion {
           rez.serialize(processor);
           rez.serialize(priority);
           rez.serialize(creator_id);
+          rez.serialize(task_id);
           rez.serialize(&success);
           rez.serialize(&result);
         }
@@ -3273,7 +3018,7 @@ namespace Legion {
           if (Runtime::legion_spy_enabled)
             manager->log_instance_creation(creator_id, processor, regions);
           record_created_instance(manager, acquire, mapper_id, processor,
-                                  priority, remote);
+                                  priority, task_id, remote);
           result = MappingInstance(manager);
           success = true;
         }
@@ -3289,7 +3034,8 @@ namespace Legion {
                                                          MapperID mapper_id, Processor processor,
                                                          bool acquire, GCPriority priority,
                                                          bool tight_region_bounds,
-                                                         UniqueID creator_id, bool remote)
+                                                         UniqueID creator_id, TaskID task_id,
+                                                         bool remote)
     //--------------------------------------------------------------------------
     {
       volatile bool success = false;
@@ -3320,6 +3066,7 @@ namespace Legion {
           rez.serialize(priority);
           rez.serialize<bool>(tight_region_bounds);
           rez.serialize(creator_id);
+          rez.serialize(task_id);
           rez.serialize(&success);
           rez.serialize(&result);
           rez.serialize(&created);
@@ -3351,7 +3098,7 @@ namespace Legion {
             PhysicalManager *actual_manager =
             find_and_record(manager, constraints, regions, candidates,
                             acquire, mapper_id, processor, priority,
-                            tight_region_bounds, remote);
+                            task_id, tight_region_bounds, remote);
             // If they are still the same then we succeeded
             if (actual_manager == manager)
               created = true;
@@ -3372,7 +3119,8 @@ namespace Legion {
                                                          MapperID mapper_id, Processor processor,
                                                          bool acquire, GCPriority priority,
                                                          bool tight_region_bounds,
-                                                         UniqueID creator_id, bool remote)
+                                                         UniqueID creator_id, TaskID task_id,
+                                                         bool remote)
     //--------------------------------------------------------------------------
     {
       volatile bool success = false;
@@ -3403,6 +3151,7 @@ namespace Legion {
           rez.serialize(priority);
           rez.serialize<bool>(tight_region_bounds);
           rez.serialize(creator_id);
+          rez.serialize(task_id);
           rez.serialize(&success);
           rez.serialize(&result);
           rez.serialize(&created);
@@ -3434,7 +3183,7 @@ namespace Legion {
             PhysicalManager *actual_manager =
             find_and_record(manager, constraints, regions, candidates,
                             acquire, mapper_id, processor, priority,
-                            tight_region_bounds, remote);
+                            task_id, tight_region_bounds, remote);
             // If they are still the same then we succeeded
             if (actual_manager == manager)
               created = true;
@@ -3822,6 +3571,8 @@ namespace Legion {
           derez.deserialize(priority);
           UniqueID creator_id;
           derez.deserialize(creator_id);
+          TaskID task_id;
+          derez.deserialize(task_id);
           bool *remote_success;
           derez.deserialize(remote_success);
           MappingInstance *remote_target;
@@ -3829,7 +3580,8 @@ namespace Legion {
           MappingInstance result;
           bool success = create_physical_instance(constraints, regions,
                                                   result, mapper_id, processor, acquire,
-                                                  priority, creator_id, true/*remote*/);
+                                                  priority, creator_id, task_id,
+                                                  true/*remote*/);
           if (success)
           {
             // Send back the response starting with the instance
@@ -3870,6 +3622,8 @@ namespace Legion {
           derez.deserialize(priority);
           UniqueID creator_id;
           derez.deserialize(creator_id);
+          TaskID task_id;
+          derez.deserialize(task_id);
           bool *remote_success;
           derez.deserialize(remote_success);
           MappingInstance *remote_target;
@@ -3879,7 +3633,8 @@ namespace Legion {
           MappingInstance result;
           bool success = create_physical_instance(constraints, regions,
                                                   result, mapper_id, processor, acquire,
-                                                  priority, creator_id, true/*remote*/);
+                                                  priority, creator_id, task_id,
+                                                  true/*remote*/);
           if (success)
           {
             PhysicalManager *manager = result.impl;
@@ -3921,6 +3676,8 @@ namespace Legion {
           derez.deserialize(tight_bounds);
           UniqueID creator_id;
           derez.deserialize(creator_id);
+          TaskID task_id;
+          derez.deserialize(task_id);
           bool *remote_success, *remote_created;
           derez.deserialize(remote_success);
           MappingInstance *remote_target;
@@ -3931,7 +3688,7 @@ namespace Legion {
           bool success = find_or_create_physical_instance(constraints,
                                                           regions, result, created, mapper_id,
                                                           processor, acquire, priority, tight_bounds,
-                                                          creator_id, true/*remote*/);
+                                                          creator_id, task_id, true/*remote*/);
           if (success)
           {
             PhysicalManager *manager = result.impl;
@@ -3978,6 +3735,8 @@ namespace Legion {
           derez.deserialize(tight_bounds);
           UniqueID creator_id;
           derez.deserialize(creator_id);
+          TaskID task_id;
+          derez.deserialize(task_id);
           bool *remote_success, *remote_created;
           derez.deserialize(remote_success);
           MappingInstance *remote_target;
@@ -3990,7 +3749,7 @@ namespace Legion {
           bool success = find_or_create_physical_instance(constraints,
                                                           regions, result, created, mapper_id,
                                                           processor, acquire, priority, tight_bounds,
-                                                          creator_id, true/*remote*/);
+                                                          creator_id, task_id, true/*remote*/);
           if (success)
           {
             PhysicalManager *manager = result.impl;
@@ -4857,6 +4616,69 @@ namespace Legion {
       return false;
     }
     
+    //--------------------------------------------------------------------------
+    bool MemoryManager::EvictionCandidate::operator<(
+                                       const EvictionCandidate &rhs) const
+    //--------------------------------------------------------------------------
+    {
+      // Mapper priorities always come first, then the policy
+      if (priority != rhs.priority)
+        return (priority > rhs.priority);
+      if (drain_later != rhs.drain_later)
+        return !drain_later;
+      if (rank != rhs.rank)
+        return (rank < rhs.rank);
+      if (last_use != rhs.last_use)
+        return (last_use < rhs.last_use);
+      return (((unsigned long)manager) < ((unsigned long)rhs.manager));
+    }
+
+    //--------------------------------------------------------------------------
+    void MemoryManager::find_instances_by_policy(InstanceState state,
+                         std::vector<CollectableInfo<true> > &ordered) const
+    //--------------------------------------------------------------------------
+    {
+      AutoLock m_lock(manager_lock,1,false/*exclusive*/);
+      // ARC drains whichever of the recently used and frequently
+      // used lists is holding more than its share of the memory
+      bool drain_recent_first = true;
+      if (eviction_policy == EVICT_ARC)
+      {
+        size_t recent_bytes = 0;
+        for (std::map<PhysicalManager*,InstanceInfo>::const_iterator it =
+             current_instances.begin(); it != current_instances.end(); it++)
+        {
+          if (it->second.use_count <= 1)
+            recent_bytes += it->second.instance_size;
+        }
+        drain_recent_first = (recent_bytes > arc_recent_target);
+      }
+      std::vector<EvictionCandidate> candidates;
+      for (std::map<PhysicalManager*,InstanceInfo>::const_iterator it =
+           current_instances.begin(); it != current_instances.end(); it++)
+      {
+        if (it->second.current_state != state)
+          continue;
+        EvictionCandidate candidate;
+        candidate.manager = it->first;
+        candidate.instance_size = it->second.instance_size;
+        candidate.priority = it->second.min_priority;
+        candidate.drain_later = (eviction_policy == EVICT_ARC) &&
+          ((it->second.use_count <= 1) != drain_recent_first);
+        candidate.rank = (eviction_policy == EVICT_LFU) ? 
+          it->second.use_count : it->second.last_use;
+        candidate.last_use = it->second.last_use;
+        candidates.push_back(candidate);
+      }
+      std::sort(candidates.begin(), candidates.end());
+      // Take our references while we still hold the lock
+      ordered.reserve(candidates.size());
+      for (std::vector<EvictionCandidate>::const_iterator it = 
+            candidates.begin(); it != candidates.end(); it++)
+        ordered.push_back(CollectableInfo<true>(it->manager, 
+                                  it->instance_size, it->priority));
+    }
+
     //--------------------------------------------------------------------------
     void MemoryManager::find_instances_by_state(size_t needed_size,
                                                 InstanceState state,
@@ -4894,7 +4716,27 @@ namespace Legion {
       PhysicalManager *manager =
       builder.create_physical_instance(runtime->forest);
       if (manager != NULL)
+      {
+        if (evicting)
+        {
+          AutoLock m_lock(manager_lock);
+          evicting = false;
+        }
         return manager;
+      }
+      EvictionPolicy policy;
+      {
+        AutoLock m_lock(manager_lock);
+        evicting = true;
+        policy = eviction_policy;
+      }
+      // Parked instances go before any live instance does
+      if (release_pooled_instances(0))
+      {
+        manager = builder.create_physical_instance(runtime->forest);
+        if (manager != NULL)
+          return manager;
+      }
       // If that didn't work find the set of immediately collectable regions
       // Rank them by size and then by GC priority
       // Start with all the ones larger than given size and try to
@@ -4902,11 +4744,26 @@ namespace Legion {
       // If that didnt' work try to delete enough from the small set to
       // open up space.
       const size_t needed_size = builder.compute_needed_size(runtime->forest);
+      size_t total_bytes_deleted = 0;
+      if (policy != EVICT_BEST_FIT)
+      {
+        // Walk the collectable and then the active instances in the 
+        // order picked by the policy until enough space opens up
+        std::vector<CollectableInfo<true> > ordered;
+        find_instances_by_policy(COLLECTABLE_STATE, ordered);
+        PhysicalManager *result = delete_and_allocate(builder, needed_size,
+                                            total_bytes_deleted, ordered);
+        if (result != NULL)
+          return result;
+        ordered.clear();
+        find_instances_by_policy(ACTIVE_STATE, ordered);
+        return delete_and_allocate(builder, needed_size, 
+                                   total_bytes_deleted, ordered);
+      }
       std::set<CollectableInfo<true> > smaller_instances;
       std::set<CollectableInfo<false> > larger_instances;
       find_instances_by_state(needed_size, COLLECTABLE_STATE,
                               smaller_instances, larger_instances);
-      size_t total_bytes_deleted = 0;
       if (!larger_instances.empty())
       {
         PhysicalManager *result =
@@ -4956,6 +4813,7 @@ namespace Legion {
                                                     const std::set<PhysicalManager*> &previous_cands,
                                                     bool acquire, MapperID mapper_id,
                                                     Processor proc, GCPriority priority,
+                                                    TaskID task_id,
                                                     bool tight_region_bounds, bool remote)
     //--------------------------------------------------------------------------
     {
@@ -4999,6 +4857,10 @@ namespace Legion {
         info.instance_size = instance_size;
         info.mapper_priorities[
                                std::pair<MapperID,Processor>(mapper_id,proc)] = priority;
+        info.creator_mapper = mapper_id;
+        info.creator_task = task_id;
+        update_usage(info, true/*allocated*/);
+        record_instance_use(info, false/*new use*/);
       }
       // Now see if we can find a matching candidate
       if (!candidates.empty())
@@ -5059,6 +4921,7 @@ namespace Legion {
                                                     const std::set<PhysicalManager*> &previous_cands,
                                                     bool acquire, MapperID mapper_id,
                                                     Processor proc, GCPriority priority,
+                                                    TaskID task_id,
                                                     bool tight_region_bounds, bool remote)
     //--------------------------------------------------------------------------
     {
@@ -5102,6 +4965,10 @@ namespace Legion {
         info.instance_size = instance_size;
         info.mapper_priorities[
                                std::pair<MapperID,Processor>(mapper_id,proc)] = priority;
+        info.creator_mapper = mapper_id;
+        info.creator_task = task_id;
+        update_usage(info, true/*allocated*/);
+        record_instance_use(info, false/*new use*/);
       }
       // Now see if we can find a matching candidate
       if (!candidates.empty())
@@ -5157,7 +5024,8 @@ namespace Legion {
     //--------------------------------------------------------------------------
     void MemoryManager::record_created_instance(PhysicalManager *manager,
                                                 bool acquire, MapperID mapper_id, Processor p,
-                                                GCPriority priority, bool remote)
+                                                GCPriority priority, TaskID task_id,
+                                                bool remote)
     //--------------------------------------------------------------------------
     {
 #ifdef DEBUG_LEGION
@@ -5183,6 +5051,10 @@ namespace Legion {
         info.instance_size = instance_size;
         info.mapper_priorities[
                                std::pair<MapperID,Processor>(mapper_id,p)] = priority;
+        info.creator_mapper = mapper_id;
+        info.creator_task = task_id;
+        update_usage(info, true/*allocated*/);
+        record_instance_use(info, false/*new use*/);
       }
       // Now we can add any references that we need to
       if (acquire)
@@ -5197,9 +5069,302 @@ namespace Legion {
     }
     
     //--------------------------------------------------------------------------
-    void MemoryManager::record_deleted_instance(PhysicalManager *manager)
+    void MemoryManager::prefetch_instance(
+                                    const LayoutConstraintSet &constraints,
+                                    const std::vector<LogicalRegion> &regions,
+                                    MapperID mapper_id, Processor processor,
+                                    GCPriority priority, UniqueID creator_id,
+                                    TaskID task_id)
     //--------------------------------------------------------------------------
     {
+      PrefetchInstanceArgs args;
+      args.manager = this;
+      args.constraints = new LayoutConstraintSet(constraints);
+      args.regions = new std::vector<LogicalRegion>(regions);
+      args.mapper_id = mapper_id;
+      args.processor = processor;
+      args.priority = priority;
+      args.creator_id = creator_id;
+      args.task_id = task_id;
+      runtime->issue_runtime_meta_task(args, LG_THROUGHPUT_PRIORITY);
+    }
+
+    //--------------------------------------------------------------------------
+    /*static*/ void MemoryManager::handle_prefetch_instance(const void *args)
+    //--------------------------------------------------------------------------
+    {
+      const PrefetchInstanceArgs *pargs = (const PrefetchInstanceArgs*)args;
+      MappingInstance result;
+      bool created;
+      // Nobody holds on to the result, it stays around like any other
+      // instance until it is either used or collected
+      pargs->manager->find_or_create_physical_instance(*(pargs->constraints),
+          *(pargs->regions), result, created, pargs->mapper_id, 
+          pargs->processor, false/*acquire*/, pargs->priority, 
+          false/*tight bounds*/, pargs->creator_id, pargs->task_id);
+      delete pargs->constraints;
+      delete pargs->regions;
+    }
+
+    //--------------------------------------------------------------------------
+    void MemoryManager::find_mapper_usage(MapperID mapper_id,
+                                          size_t &current_bytes,
+                                          size_t &peak_bytes)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock m_lock(manager_lock,1,false/*exclusive*/);
+      std::map<MapperID,UsageInfo>::const_iterator finder = 
+        mapper_usage.find(mapper_id);
+      if (finder != mapper_usage.end())
+      {
+        current_bytes = finder->second.current_bytes;
+        peak_bytes = finder->second.peak_bytes;
+      }
+      else
+      {
+        current_bytes = 0;
+        peak_bytes = 0;
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    void MemoryManager::find_task_usage(TaskID task_id,
+                                        size_t &current_bytes,
+                                        size_t &peak_bytes)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock m_lock(manager_lock,1,false/*exclusive*/);
+      std::map<TaskID,UsageInfo>::const_iterator finder = 
+        task_usage.find(task_id);
+      if (finder != task_usage.end())
+      {
+        current_bytes = finder->second.current_bytes;
+        peak_bytes = finder->second.peak_bytes;
+      }
+      else
+      {
+        current_bytes = 0;
+        peak_bytes = 0;
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    void MemoryManager::set_instance_pool_limit(size_t max_bytes)
+    //--------------------------------------------------------------------------
+    {
+      {
+        AutoLock m_lock(manager_lock);
+        pool_limit = max_bytes;
+        if (pool_limit == 0)
+          pool_candidates.clear();
+      }
+      release_pooled_instances(max_bytes);
+    }
+
+    //--------------------------------------------------------------------------
+    PhysicalInstance MemoryManager::find_pooled_instance(
+              const Domain &instance_domain, 
+              const std::vector<size_t> &field_sizes,
+              size_t block_size, ReductionOpID redop)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock m_lock(manager_lock);
+      for (std::list<PooledInstance>::iterator it = instance_pool.begin();
+            it != instance_pool.end(); it++)
+      {
+        if ((it->block_size != block_size) || (it->redop != redop))
+          continue;
+        if (!(it->instance_domain == instance_domain))
+          continue;
+        if (it->field_sizes != field_sizes)
+          continue;
+        // Don't wait on users of the previous incarnation
+        if (!it->ready.has_triggered())
+          continue;
+        PhysicalInstance result = it->instance;
+#ifdef DEBUG_LEGION
+        assert(pooled_bytes >= it->instance_size);
+#endif
+        pooled_bytes -= it->instance_size;
+        // Still a candidate for parking again once it is collected
+        pool_candidates[result] = *it;
+        instance_pool.erase(it);
+        return result;
+      }
+      return PhysicalInstance::NO_INST;
+    }
+
+    //--------------------------------------------------------------------------
+    void MemoryManager::record_pool_candidate(PhysicalInstance instance,
+                                     const Domain &instance_domain,
+                                     const std::vector<size_t> &field_sizes,
+                                     size_t block_size, ReductionOpID redop,
+                                     size_t instance_size)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock m_lock(manager_lock);
+      if ((pool_limit == 0) || (instance_size > pool_limit))
+        return;
+      PooledInstance &candidate = pool_candidates[instance];
+      candidate.instance = instance;
+      candidate.instance_domain = instance_domain;
+      candidate.field_sizes = field_sizes;
+      candidate.block_size = block_size;
+      candidate.redop = redop;
+      candidate.instance_size = instance_size;
+    }
+
+    //--------------------------------------------------------------------------
+    bool MemoryManager::recycle_instance(PhysicalInstance instance,
+                                         RtEvent deferred_event)
+    //--------------------------------------------------------------------------
+    {
+      {
+        AutoLock m_lock(manager_lock);
+        std::map<PhysicalInstance,PooledInstance>::iterator finder = 
+          pool_candidates.find(instance);
+        if (finder == pool_candidates.end())
+          return false;
+        if ((pooled_bytes + finder->second.instance_size) > pool_limit)
+        {
+          // Make room by evicting the oldest parked instances
+          while (!instance_pool.empty() && 
+                 ((pooled_bytes + finder->second.instance_size) > pool_limit))
+          {
+            PooledInstance &oldest = instance_pool.front();
+            pooled_bytes -= oldest.instance_size;
+            oldest.instance.destroy(oldest.ready);
+            instance_pool.pop_front();
+          }
+          if ((pooled_bytes + finder->second.instance_size) > pool_limit)
+          {
+            pool_candidates.erase(finder);
+            return false;
+          }
+        }
+        finder->second.ready = deferred_event;
+        pooled_bytes += finder->second.instance_size;
+        instance_pool.push_back(finder->second);
+        pool_candidates.erase(finder);
+      }
+      log_garbage.spew("Parked physical instance " IDFMT " in memory " 
+                       IDFMT " for reuse", instance.id, memory.id);
+      return true;
+    }
+
+    //--------------------------------------------------------------------------
+    bool MemoryManager::release_pooled_instances(size_t target_bytes)
+    //--------------------------------------------------------------------------
+    {
+      std::vector<PooledInstance> to_destroy;
+      {
+        AutoLock m_lock(manager_lock);
+        while (!instance_pool.empty() && (pooled_bytes > target_bytes))
+        {
+          to_destroy.push_back(instance_pool.front());
+          pooled_bytes -= instance_pool.front().instance_size;
+          instance_pool.pop_front();
+        }
+      }
+      for (std::vector<PooledInstance>::const_iterator it = 
+            to_destroy.begin(); it != to_destroy.end(); it++)
+        it->instance.destroy(it->ready);
+      return !to_destroy.empty();
+    }
+
+    //--------------------------------------------------------------------------
+    void MemoryManager::update_usage(const InstanceInfo &info, bool allocated)
+    //--------------------------------------------------------------------------
+    {
+      UsageInfo &mapper_info = mapper_usage[info.creator_mapper];
+      UsageInfo &task_info = task_usage[info.creator_task];
+      if (allocated)
+      {
+        if (remaining_capacity > info.instance_size)
+          remaining_capacity -= info.instance_size;
+        else
+          remaining_capacity = 0;
+        mapper_info.current_bytes += info.instance_size;
+        if (mapper_info.current_bytes > mapper_info.peak_bytes)
+          mapper_info.peak_bytes = mapper_info.current_bytes;
+        task_info.current_bytes += info.instance_size;
+        if (task_info.current_bytes > task_info.peak_bytes)
+          task_info.peak_bytes = task_info.current_bytes;
+      }
+      else
+      {
+#ifdef DEBUG_LEGION
+        assert(mapper_info.current_bytes >= info.instance_size);
+        assert(task_info.current_bytes >= info.instance_size);
+#endif
+        mapper_info.current_bytes -= info.instance_size;
+        task_info.current_bytes -= info.instance_size;
+        remaining_capacity += info.instance_size;
+        if (remaining_capacity > capacity)
+          remaining_capacity = capacity;
+      }
+      if (runtime->profiler != NULL)
+        runtime->profiler->record_memory_usage(memory, info.creator_mapper,
+                    mapper_info.current_bytes, info.creator_task, 
+                    task_info.current_bytes);
+    }
+
+    //--------------------------------------------------------------------------
+    void MemoryManager::record_instance_use(InstanceInfo &info, bool new_use)
+    //--------------------------------------------------------------------------
+    {
+      info.last_use = ++use_clock;
+      if (!new_use)
+        return;
+      if (eviction_policy == EVICT_ARC)
+      {
+        // Reuse of an instance on the recent list says that list
+        // deserves more room, reuse on the frequent list says less
+        if (info.use_count == 1)
+        {
+          arc_recent_target += info.instance_size;
+          if (arc_recent_target > capacity)
+            arc_recent_target = capacity;
+        }
+        else if (info.use_count > 1)
+        {
+          if (arc_recent_target > info.instance_size)
+            arc_recent_target -= info.instance_size;
+          else
+            arc_recent_target = 0;
+        }
+      }
+      info.use_count++;
+    }
+
+    //--------------------------------------------------------------------------
+    void MemoryManager::set_eviction_policy(EvictionPolicy policy)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock m_lock(manager_lock);
+      if ((policy == EVICT_ARC) && (eviction_policy != EVICT_ARC))
+        arc_recent_target = capacity / 2;
+      eviction_policy = policy;
+    }
+
+    //--------------------------------------------------------------------------
+    bool MemoryManager::is_under_pressure(void)
+    //--------------------------------------------------------------------------
+    {
+      // Either we just had to make space or less than an eighth 
+      // of the memory is left, in which case we will have to soon
+      AutoLock m_lock(manager_lock,1,false/*exclusive*/);
+      return (evicting || (remaining_capacity < (capacity / 8)));
+    }
+
+    //--------------------------------------------------------------------------
+    void MemoryManager::record_deleted_instance(PhysicalManager *manager,
+                                                bool evicted)
+    //--------------------------------------------------------------------------
+    {
+      if (is_owner && (runtime->profiler != NULL))
+        runtime->profiler->record_instance_deletion(manager->get_instance(),
+                                                    memory, evicted);
       RtEvent deletion_precondition;
       bool remove_reference = false;
       {
@@ -5211,6 +5376,9 @@ namespace Legion {
         assert(finder->second.current_state != VALID_STATE);
         assert(finder->second.current_state != ACTIVE_COLLECTED_STATE);
 #endif
+        // The bytes are released as soon as the deletion is scheduled
+        if (is_owner)
+          update_usage(finder->second, false/*allocated*/);
         // If we are still in an active mode, record the event,
         // otherwise we can delete everything now and trigger
         // the event immediately
@@ -5250,7 +5418,7 @@ namespace Legion {
         PhysicalManager *target_manager = it->manager;
         if (target_manager->try_active_deletion())
         {
-          record_deleted_instance(target_manager);
+          record_deleted_instance(target_manager, true/*evicted*/);
           total_bytes_deleted += it->instance_size;
           // Only need to do the test if we're smaller
           if (!SMALLER || (total_bytes_deleted >= needed_size))
@@ -5265,6 +5433,31 @@ namespace Legion {
       }
       return NULL;
     }
+
+    //--------------------------------------------------------------------------
+    PhysicalManager* MemoryManager::delete_and_allocate(
+                            InstanceBuilder &builder, size_t needed_size,
+                            size_t &total_bytes_deleted,
+                            const std::vector<CollectableInfo<true> > &ordered)
+    //--------------------------------------------------------------------------
+    {
+      for (std::vector<CollectableInfo<true> >::const_iterator it = 
+            ordered.begin(); it != ordered.end(); it++)
+      {
+        PhysicalManager *target_manager = it->manager;
+        if (!target_manager->try_active_deletion())
+          continue;
+        record_deleted_instance(target_manager, true/*evicted*/);
+        total_bytes_deleted += it->instance_size;
+        if (total_bytes_deleted < needed_size)
+          continue;
+        PhysicalManager *manager = 
+          builder.create_physical_instance(runtime->forest);
+        if (manager != NULL)
+          return manager;
+      }
+      return NULL;
+    }
     
     /////////////////////////////////////////////////////////////
     // Virtual Channel
@@ -5273,10 +5466,14 @@ namespace Legion {
     //--------------------------------------------------------------------------
     VirtualChannel::VirtualChannel(VirtualChannelKind kind,
                                    AddressSpaceID local_address_space,
-                                   size_t max_message_size, LegionProfiler *prof)
+                                   size_t max_message_size, LegionProfiler *prof,
+                                   MessageManager *man)
     : sending_buffer((char*)malloc(max_message_size)),
     sending_buffer_size(max_message_size),
-    observed_recent(true), profiler(prof)
+    flush_delay(1000LL * Runtime::channel_flush_delay[kind]),
+    flush_bytes((Runtime::channel_flush_bytes[kind] > 0) ?
+        Runtime::channel_flush_bytes[kind] : max_message_size),
+    observed_recent(true), profiler(prof), manager(man)
     //--------------------------------------------------------------------------
     //
     {
@@ -5304,6 +5501,9 @@ namespace Legion {
       sending_index += sizeof(packaged_messages);
       last_message_event = RtEvent::NO_RT_EVENT;
       partial = false;
+      flush_deadline = 0;
+      held_response = false;
+      flush_pending = false;
       // Set up the receiving buffer
       received_messages = 0;
       receiving_index = 0;
@@ -5311,7 +5511,8 @@ namespace Legion {
     
     //--------------------------------------------------------------------------
     VirtualChannel::VirtualChannel(const VirtualChannel &rhs)
-    : sending_buffer(NULL), sending_buffer_size(0), profiler(NULL)
+    : sending_buffer(NULL), sending_buffer_size(0), flush_delay(0),
+      flush_bytes(0), profiler(NULL), manager(NULL)
     //--------------------------------------------------------------------------
     {
       // should never be called
@@ -5342,6 +5543,17 @@ namespace Legion {
       const char *buffer = (const char*)rez.get_buffer();
       // Need to hold the lock when manipulating the buffer
       AutoLock s_lock(send_lock);
+      // If nothing else is waiting in the buffer and this message is
+      // going to be sent right away then we can send it straight out
+      // of the serializer without copying it into our buffer first
+      if (flush && (packaged_messages == 0) && 
+          ((flush_delay == 0) || shutdown) &&
+          ((sending_index+buffer_size+sizeof(k)+sizeof(buffer_size)) <=
+            sending_buffer_size))
+      {
+        send_direct_message(rez, k, response, shutdown);
+        return;
+      }
       if ((sending_index+buffer_size+sizeof(k)+sizeof(buffer_size)) >
           sending_buffer_size)
       {
@@ -5375,20 +5587,134 @@ namespace Legion {
           sending_index += to_copy;
         }
       }
-      else
+      else
+      {
+        packaged_messages++;
+        // Package up the kind and the size first
+        *((MessageKind*)(sending_buffer+sending_index)) = k;
+        sending_index += sizeof(k);
+        *((size_t*)(sending_buffer+sending_index)) = buffer_size;
+        sending_index += sizeof(buffer_size);
+        // Then copy over the buffer
+        memcpy(sending_buffer+sending_index,buffer,buffer_size);
+        sending_index += buffer_size;
+      }
+      if (flush)
+      {
+        // Shutdown messages are never held since nothing 
+        // would be left running to flush them
+        if ((flush_delay == 0) || shutdown)
+          send_message(true/*complete*/, runtime, target, response, shutdown);
+        else
+          hold_message(runtime, target, response);
+      }
+      else if (flush_deadline > 0)
+        hold_message(runtime, target, response);
+    }
+
+    //--------------------------------------------------------------------------
+    void VirtualChannel::send_direct_message(Serializer &rez, MessageKind k,
+                                             bool response, bool shutdown)
+    //--------------------------------------------------------------------------
+    {
+      // Should be holding the send lock when calling this
+#ifdef DEBUG_LEGION
+      assert(packaged_messages == 0);
+      assert(!partial);
+      assert(header == FULL_MESSAGE);
+#endif
+      const size_t base_size = sizeof(LgTaskID) + sizeof(AddressSpaceID)
+      + sizeof(VirtualChannelKind);
+      const size_t header_size = base_size + sizeof(header) + 
+        sizeof(packaged_messages) + sizeof(k) + sizeof(size_t); 
+      LEGION_STATIC_ASSERT(header_size <= Serializer::MESSAGE_HEADROOM);
+      const size_t buffer_size = rez.get_used_bytes();
+      // Write the same headers we would have put in our buffer
+      // directly in front of the message in the serializer
+      char *message = (char*)rez.get_headroom(header_size);
+      memcpy(message, sending_buffer, base_size);
+      *((MessageHeader*)(message + base_size)) = FULL_MESSAGE;
+      *((unsigned*)(message + base_size + sizeof(header))) = 1;
+      char *record = message + base_size + sizeof(header) + 
+        sizeof(packaged_messages);
+      *((MessageKind*)record) = k;
+      *((size_t*)(record + sizeof(k))) = buffer_size;
+      last_message_event = manager->send_full_message(message,
+                header_size + buffer_size, last_message_event, 
+                response, shutdown);
+    }
+
+    //--------------------------------------------------------------------------
+    void VirtualChannel::hold_message(Runtime *runtime, Processor target,
+                                      bool response)
+    //--------------------------------------------------------------------------
+    {
+      // Should be holding the send lock when calling this
+      const size_t header_size = sizeof(LgTaskID) + sizeof(AddressSpaceID) +
+        sizeof(VirtualChannelKind) + sizeof(header) + sizeof(unsigned);
+      const long long current = Realm::Clock::current_time_in_nanoseconds();
+      if (response)
+        held_response = true;
+      // Send now if we have batched enough bytes or if the oldest 
+      // message has already been held for long enough
+      if (((sending_index - header_size) >= flush_bytes) ||
+          ((flush_deadline > 0) && (current >= flush_deadline)))
+      {
+        send_message(true/*complete*/, runtime, target, 
+                     false/*response*/, false/*shutdown*/);
+        return;
+      }
+      if (flush_deadline > 0)
+        return;
+      flush_deadline = current + flush_delay;
+      held_target = target;
+      // Launch the task that ensures the held messages get sent even
+      // if nothing else is ever sent on this channel
+      if (!flush_pending)
+      {
+        flush_pending = true;
+        DeferredFlushArgs args;
+        args.channel = this;
+        runtime->issue_runtime_meta_task(args, LG_LATENCY_PRIORITY);
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    void VirtualChannel::process_deferred_flush(Runtime *runtime)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock s_lock(send_lock);
+#ifdef DEBUG_LEGION
+      assert(flush_pending);
+#endif
+      // Someone else might have already sent the messages
+      if (flush_deadline == 0)
+      {
+        flush_pending = false;
+        return;
+      }
+      if (Realm::Clock::current_time_in_nanoseconds() >= flush_deadline)
       {
-        packaged_messages++;
-        // Package up the kind and the size first
-        *((MessageKind*)(sending_buffer+sending_index)) = k;
-        sending_index += sizeof(k);
-        *((size_t*)(sending_buffer+sending_index)) = buffer_size;
-        sending_index += sizeof(buffer_size);
-        // Then copy over the buffer
-        memcpy(sending_buffer+sending_index,buffer,buffer_size);
-        sending_index += buffer_size;
+        send_message(true/*complete*/, runtime, held_target,
+                     false/*response*/, false/*shutdown*/);
+        flush_pending = false;
+        return;
       }
-      if (flush)
-        send_message(true/*complete*/, runtime, target, response, shutdown);
+      // Not time yet so check back again later, there is no timer in
+      // Realm so we go to the back of the queue at the lowest priority
+      // which lets any other meta-tasks run ahead of us
+      DeferredFlushArgs args;
+      args.channel = this;
+      runtime->issue_runtime_meta_task(args, LG_THROUGHPUT_PRIORITY);
+    }
+
+    //--------------------------------------------------------------------------
+    /*static*/ void VirtualChannel::handle_deferred_flush(const void *args,
+                                                          Runtime *runtime)
+    //--------------------------------------------------------------------------
+    {
+      const DeferredFlushArgs *fargs = (const DeferredFlushArgs*)args;
+      fargs->channel->process_deferred_flush(runtime);
     }
     
     //--------------------------------------------------------------------------
@@ -5408,31 +5734,25 @@ namespace Legion {
         header = FINAL_MESSAGE;
         partial = false;
       }
+      // Anything that was being held goes out with this message
+      if (held_response)
+        response = true;
+      flush_deadline = 0;
+      held_response = false;
       // Save the header and the number of messages into the buffer
       const size_t base_size = sizeof(LgTaskID) + sizeof(AddressSpaceID)
       + sizeof(VirtualChannelKind);
       *((MessageHeader*)(sending_buffer + base_size)) = header;
       *((unsigned*)(sending_buffer + base_size + sizeof(header))) =
       packaged_messages;
-      // Send the message directly there, don't go through the
-      // runtime interface to avoid being counted, still include
-      // a profiling request though if necessary in order to
-      // see waits on message handlers
-      // Note that we don't profile on shutdown messages or we would
-      // never actually finish running
-      if (!shutdown && (Runtime::num_profiling_nodes > 0) &&
-          (runtime->find_address_space(target) < Runtime::num_profiling_nodes))
-      {
-        Realm::ProfilingRequestSet requests;
-        LegionProfiler::add_message_request(requests, target);
-        last_message_event = RtEvent(target.spawn(LG_TASK_ID, sending_buffer,
-                                                  sending_index, requests, last_message_event,
-                                                  response ? LG_RESPONSE_PRIORITY : LG_LATENCY_PRIORITY));
-      }
+      // Full messages can be combined with those from other channels,
+      // but partial and final messages always go by themselves
+      if (header == FULL_MESSAGE)
+        last_message_event = manager->send_full_message(sending_buffer,
+                  sending_index, last_message_event, response, shutdown);
       else
-        last_message_event = RtEvent(target.spawn(LG_TASK_ID, sending_buffer,
-                                                  sending_index, last_message_event,
-                                                  response ? LG_RESPONSE_PRIORITY : LG_LATENCY_PRIORITY));
+        last_message_event = manager->spawn_message(sending_buffer,
+                  sending_index, last_message_event, response, shutdown);
       // Reset the state of the buffer
       sending_index = base_size + sizeof(header) + sizeof(unsigned);
       if (partial)
@@ -5442,6 +5762,19 @@ namespace Legion {
       packaged_messages = 0;
     }
     
+    //--------------------------------------------------------------------------
+    RtEvent VirtualChannel::find_ordering_fence(Runtime *runtime, 
+                                                Processor target)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock s_lock(send_lock);
+      // Anything still sitting in the buffer has no event yet
+      if (packaged_messages > 0)
+        send_message(true/*complete*/, runtime, target,
+                     false/*response*/, false/*shutdown*/);
+      return last_message_event;
+    }
+
     //--------------------------------------------------------------------------
     void VirtualChannel::confirm_shutdown(ShutdownManager *shutdown_manager,
                                           bool phase_one)
@@ -5489,9 +5822,6 @@ namespace Legion {
                                          Runtime *runtime, AddressSpaceID remote_address_space)
     //--------------------------------------------------------------------------
     {
-      // If we have a profiler we need to increment our requests count
-      if (profiler != NULL)
-        profiler->increment_total_outstanding_requests();
       // Strip off our header and the number of messages, the
       // processor part was already stipped off by the Legion runtime
       const char *buffer = (const char*)args;
@@ -6217,11 +6547,6 @@ namespace Legion {
             runtime->handle_top_level_task_complete(derez);
             break;
           }
-          case SEND_MPI_RANK_EXCHANGE:
-          {
-            runtime->handle_mpi_rank_exchange(derez);
-            break;
-          }
           case SEND_SHUTDOWN_NOTIFICATION:
           {
             // If we have a profiler, we shouldn't have incremented the
@@ -6248,7 +6573,8 @@ namespace Legion {
         if (profiler != NULL)
         {
           stop = Realm::Clock::current_time_in_nanoseconds();
-          profiler->record_message(kind, start, stop);
+          profiler->record_message(kind, start, stop, remote_address_space,
+                                   message_size);
         }
         // Update the args and arglen
         args += message_size;
@@ -6299,7 +6625,8 @@ namespace Legion {
                                    Runtime *rt, size_t max_message_size,
                                    const std::set<Processor> &remote_util_procs)
     : remote_address_space(remote), runtime(rt), channels((VirtualChannel*)
-                                                          malloc(MAX_NUM_VIRTUAL_CHANNELS*sizeof(VirtualChannel)))
+                                                          malloc(MAX_NUM_VIRTUAL_CHANNELS*sizeof(VirtualChannel))),
+      sending_active(false), aggregate_buffer_size(max_message_size)
     //--------------------------------------------------------------------------
     {
 #ifdef DEBUG_LEGION
@@ -6332,13 +6659,39 @@ namespace Legion {
       for (unsigned idx = 0; idx < MAX_NUM_VIRTUAL_CHANNELS; idx++)
       {
         new (channels+idx) VirtualChannel((VirtualChannelKind)idx,
-                                          rt->address_space, max_message_size, runtime->profiler);
+                                          rt->address_space, max_message_size, runtime->profiler,
+                                          this);
+      }
+      // Set up the buffers for combining messages from different channels,
+      // which are marked with MAX_NUM_VIRTUAL_CHANNELS as their channel
+      aggregate_lock = Reservation::create_reservation();
+      aggregate_buffer = (char*)malloc(aggregate_buffer_size);
+      spare_aggregate_buffer = (char*)malloc(aggregate_buffer_size);
+#ifdef DEBUG_LEGION
+      assert(aggregate_buffer != NULL);
+      assert(spare_aggregate_buffer != NULL);
+#endif
+      char *buffers[2] = { aggregate_buffer, spare_aggregate_buffer };
+      for (unsigned idx = 0; idx < 2; idx++)
+      {
+        char *buffer = buffers[idx];
+        *((LgTaskID*)buffer) = LG_MESSAGE_ID;
+        buffer += sizeof(LgTaskID);
+        *((AddressSpaceID*)buffer) = rt->address_space;
+        buffer += sizeof(AddressSpaceID);
+        *((VirtualChannelKind*)buffer) = MAX_NUM_VIRTUAL_CHANNELS;
       }
+      aggregate_index = sizeof(LgTaskID) + sizeof(AddressSpaceID) +
+        sizeof(VirtualChannelKind) + sizeof(aggregate_count);
+      aggregate_count = 0;
+      aggregate_response = false;
+      aggregate_shutdown = false;
     }
     
     //--------------------------------------------------------------------------
     MessageManager::MessageManager(const MessageManager &rhs)
-    : remote_address_space(0), runtime(NULL), channels(NULL)
+    : remote_address_space(0), runtime(NULL), channels(NULL),
+      aggregate_buffer_size(0)
     //--------------------------------------------------------------------------
     {
       // should never be called
@@ -6354,6 +6707,10 @@ namespace Legion {
         channels[idx].~VirtualChannel();
       }
       free(channels);
+      aggregate_lock.destroy_reservation();
+      aggregate_lock = Reservation::NO_RESERVATION;
+      free(aggregate_buffer);
+      free(spare_aggregate_buffer);
     }
     
     //--------------------------------------------------------------------------
@@ -6378,13 +6735,174 @@ namespace Legion {
     void MessageManager::receive_message(const void *args, size_t arglen)
     //--------------------------------------------------------------------------
     {
+      // If we have a profiler we need to increment our requests count
+      if (runtime->profiler != NULL)
+        runtime->profiler->increment_total_outstanding_requests();
       // Pull the channel off to do the receiving
       const char *buffer = (const char*)args;
       VirtualChannelKind channel = *((const VirtualChannelKind*)buffer);
       buffer += sizeof(channel);
       arglen -= sizeof(channel);
-      channels[channel].process_message(buffer, arglen, runtime,
-                                        remote_address_space);
+      if (channel != MAX_NUM_VIRTUAL_CHANNELS)
+      {
+        channels[channel].process_message(buffer, arglen, runtime,
+                                          remote_address_space);
+        return;
+      }
+      // Otherwise this is a combination of full messages from 
+      // different channels, handle them in the order they were added
+      unsigned num_channel_messages = *((const unsigned*)buffer);
+      buffer += sizeof(num_channel_messages);
+      arglen -= sizeof(num_channel_messages);
+      for (unsigned idx = 0; idx < num_channel_messages; idx++)
+      {
+        size_t message_size = *((const size_t*)buffer);
+        buffer += sizeof(message_size);
+        arglen -= sizeof(message_size);
+#ifdef DEBUG_LEGION
+        assert(message_size <= arglen);
+#endif
+        VirtualChannelKind sub_channel = 
+          *((const VirtualChannelKind*)buffer);
+        channels[sub_channel].process_message(buffer + sizeof(sub_channel),
+                                      message_size - sizeof(sub_channel),
+                                      runtime, remote_address_space);
+        buffer += message_size;
+        arglen -= message_size;
+      }
+#ifdef DEBUG_LEGION
+      assert(arglen == 0);
+#endif
+    }
+
+    //--------------------------------------------------------------------------
+    RtEvent MessageManager::send_full_message(const char *buffer, size_t size,
+                                              RtEvent precondition,
+                                              bool response, bool shutdown)
+    //--------------------------------------------------------------------------
+    {
+      if (!Runtime::message_aggregation)
+        return spawn_message(buffer, size, precondition, response, shutdown);
+      // Skip the task ID and address space, every message 
+      // in an aggregate has the same ones
+      const size_t prefix = sizeof(LgTaskID) + sizeof(AddressSpaceID);
+      const char *channel_buffer = buffer + prefix;
+      const size_t channel_size = size - prefix;
+      bool active_sender = false;
+      {
+        AutoLock a_lock(aggregate_lock);
+        if (sending_active)
+        {
+          // Someone else is sending to this node, so see if we can ride
+          // along on the next message that they will send
+          if ((aggregate_index + sizeof(channel_size) + channel_size) <=
+              aggregate_buffer_size)
+          {
+            if (aggregate_count == 0)
+              aggregate_done = Runtime::create_rt_user_event();
+            *((size_t*)(aggregate_buffer+aggregate_index)) = channel_size;
+            aggregate_index += sizeof(channel_size);
+            memcpy(aggregate_buffer+aggregate_index, 
+                   channel_buffer, channel_size);
+            aggregate_index += channel_size;
+            aggregate_count++;
+            // If the channel's last message is in this same aggregate
+            // then it is already ordered before this one
+            if (precondition.exists() && (precondition != aggregate_done))
+              aggregate_preconditions.insert(precondition);
+            if (response)
+              aggregate_response = true;
+            if (shutdown)
+              aggregate_shutdown = true;
+            return aggregate_done;
+          }
+          // Otherwise it doesn't fit so just send it ourselves
+        }
+        else
+        {
+          sending_active = true;
+          active_sender = true;
+        }
+      }
+      // If we get here we're sending this message by ourselves
+      RtEvent result = 
+        spawn_message(buffer, size, precondition, response, shutdown);
+      // If we were the active sender then we have to send on anything
+      // that was combined while we were sending
+      if (active_sender)
+        send_aggregated_messages();
+      return result;
+    }
+
+    //--------------------------------------------------------------------------
+    void MessageManager::send_aggregated_messages(void)
+    //--------------------------------------------------------------------------
+    {
+      const size_t count_offset = sizeof(LgTaskID) + 
+        sizeof(AddressSpaceID) + sizeof(VirtualChannelKind);
+      while (true)
+      {
+        char *to_send = NULL;
+        size_t to_send_size = 0;
+        RtUserEvent done;
+        std::set<RtEvent> preconditions;
+        bool response = false, shutdown = false;
+        {
+          AutoLock a_lock(aggregate_lock);
+#ifdef DEBUG_LEGION
+          assert(sending_active);
+#endif
+          if (aggregate_count == 0)
+          {
+            sending_active = false;
+            return;
+          }
+          *((unsigned*)(aggregate_buffer + count_offset)) = aggregate_count;
+          // Swap buffers so others can keep adding while we send,
+          // we can reuse the spare since only the active sender sends
+          to_send = aggregate_buffer;
+          to_send_size = aggregate_index;
+          aggregate_buffer = spare_aggregate_buffer;
+          spare_aggregate_buffer = to_send;
+          aggregate_index = count_offset + sizeof(aggregate_count);
+          aggregate_count = 0;
+          done = aggregate_done;
+          aggregate_done = RtUserEvent::NO_RT_USER_EVENT;
+          preconditions.swap(aggregate_preconditions);
+          response = aggregate_response;
+          shutdown = aggregate_shutdown;
+          aggregate_response = false;
+          aggregate_shutdown = false;
+        }
+        RtEvent sent = spawn_message(to_send, to_send_size, 
+            Runtime::merge_events(preconditions), response, shutdown);
+        Runtime::trigger_event(done, sent);
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    RtEvent MessageManager::spawn_message(const char *buffer, size_t size,
+                                          RtEvent precondition,
+                                          bool response, bool shutdown)
+    //--------------------------------------------------------------------------
+    {
+      // Send the message directly there, don't go through the
+      // runtime interface to avoid being counted, still include
+      // a profiling request though if necessary in order to
+      // see waits on message handlers
+      // Note that we don't profile on shutdown messages or we would
+      // never actually finish running
+      if (!shutdown && (Runtime::num_profiling_nodes > 0) &&
+          (runtime->find_address_space(target) < Runtime::num_profiling_nodes))
+      {
+        Realm::ProfilingRequestSet requests;
+        LegionProfiler::add_message_request(requests, target);
+        return RtEvent(target.spawn(LG_TASK_ID, buffer, size, requests, 
+              precondition, response ? LG_RESPONSE_PRIORITY : LG_LATENCY_PRIORITY));
+      }
+      else
+        return RtEvent(target.spawn(LG_TASK_ID, buffer, size, precondition,
+                  response ? LG_RESPONSE_PRIORITY : LG_LATENCY_PRIORITY));
     }
     
     //--------------------------------------------------------------------------
@@ -6395,6 +6913,13 @@ namespace Legion {
       for (unsigned idx = 0; idx < MAX_NUM_VIRTUAL_CHANNELS; idx++)
         channels[idx].confirm_shutdown(shutdown_manager, phase_one);
     }
+
+    //--------------------------------------------------------------------------
+    RtEvent MessageManager::find_ordering_fence(VirtualChannelKind channel)
+    //--------------------------------------------------------------------------
+    {
+      return channels[channel].find_ordering_fence(runtime, target);
+    }
     
     /////////////////////////////////////////////////////////////
     // Shutdown Manager
@@ -6705,26 +7230,38 @@ namespace Legion {
     {
       // Set remaining to the total number of collections
       remaining = collections.size();
-      GarbageCollectionArgs args;
-      args.epoch = this;
-      std::set<RtEvent> events;
-      for (std::map<LogicalView*,std::set<ApEvent> >::const_iterator it =
-           collections.begin(); it != collections.end(); /*nothing*/)
-      {
-        args.view = it->first;
-        RtEvent precondition = Runtime::protect_merge_events(it->second);
-        // Avoid the deletion race by testing the condition
-        // before launching the task
-        it++;
-        bool done = (it == collections.end());
-        RtEvent e = runtime->issue_runtime_meta_task(args,
-                                                     LG_THROUGHPUT_PRIORITY, NULL,
-                                                     precondition);
-        events.insert(e);
-        if (done)
-          break;
-      }
-      return Runtime::merge_events(events);
+      views.reserve(collections.size());
+      for (std::map<LogicalView*,std::set<ApEvent> >::iterator it =
+            collections.begin(); it != collections.end(); it++)
+        views.push_back(
+            std::pair<LogicalView*,std::set<ApEvent>*>(it->first, &it->second));
+      // Build all the slices before launching any of them since the
+      // epoch can be deleted as soon as the last slice is launched
+      const unsigned slice_size = 
+        (Runtime::gc_slice_size > 0) ? Runtime::gc_slice_size : 1;
+      std::vector<GarbageCollectionArgs> slices;
+      std::vector<RtEvent> preconditions;
+      for (unsigned first = 0; first < views.size(); first += slice_size)
+      {
+        GarbageCollectionArgs args;
+        args.epoch = this;
+        args.first = first;
+        args.last = std::min<unsigned>(first + slice_size, views.size());
+        std::set<ApEvent> slice_events;
+        for (unsigned idx = args.first; idx < args.last; idx++)
+          slice_events.insert(views[idx].second->begin(),
+                              views[idx].second->end());
+        slices.push_back(args);
+        preconditions.push_back(Runtime::protect_merge_events(slice_events));
+      }
+      if (slices.empty())
+        return RtEvent::NO_RT_EVENT;
+      done_event = Runtime::create_rt_user_event();
+      const RtEvent result = done_event;
+      for (unsigned idx = 0; idx < slices.size(); idx++)
+        runtime->issue_runtime_meta_task(slices[idx], LG_BACKGROUND_PRIORITY,
+                                         NULL, preconditions[idx]);
+      return result;
     }
     
     //--------------------------------------------------------------------------
@@ -6732,14 +7269,35 @@ namespace Legion {
                                                    const GarbageCollectionArgs *args)
     //--------------------------------------------------------------------------
     {
-      std::map<LogicalView*,std::set<ApEvent> >::iterator finder =
-      collections.find(args->view);
-#ifdef DEBUG_LEGION
-      assert(finder != collections.end());
-#endif
-      LogicalView::handle_deferred_collect(args->view, finder->second);
-      // See if we are done
-      return (__sync_add_and_fetch(&remaining, -1) == 0);
+      const long long deadline = (Runtime::gc_pause_target > 0) ?
+        Realm::Clock::current_time_in_microseconds() + 
+          Runtime::gc_pause_target : 0;
+      unsigned next = args->first;
+      while (next < args->last)
+      {
+        LogicalView::handle_deferred_collect(views[next].first,
+                                             *(views[next].second));
+        next++;
+        // If we've hit the pause target then hand the rest of the
+        // slice to a new background task so we yield the processor
+        if ((next < args->last) && (deadline > 0) &&
+            (Realm::Clock::current_time_in_microseconds() >= deadline))
+        {
+          GarbageCollectionArgs rest;
+          rest.epoch = this;
+          rest.first = next;
+          rest.last = args->last;
+          runtime->issue_runtime_meta_task(rest, LG_BACKGROUND_PRIORITY);
+          break;
+        }
+      }
+      // See if we are done, this must be the last thing that we
+      // do since the epoch is deleted once everything is collected
+      const int collected = next - args->first;
+      if (__sync_add_and_fetch(&remaining, -collected) > 0)
+        return false;
+      Runtime::trigger_event(done_event);
+      return true;
     }
     
     /////////////////////////////////////////////////////////////
@@ -7243,9 +7801,10 @@ namespace Legion {
           {
             if (can_fail)
             {
-              // Have to make our own event
-              request = Runtime::create_rt_user_event();
-              wait_on = request;
+              // Share any request that is still in flight, otherwise
+              // we have to make our own event
+              wait_on = Runtime::find_or_create_pending_request(
+                                semantic_requests, tag, request);
             }
             else // can use the canonical event
               wait_on = finder->second.ready_event;
@@ -7265,9 +7824,10 @@ namespace Legion {
           }
           else if (is_remote)
           {
-            // Make an event just for us to use
-            request = Runtime::create_rt_user_event();
-            wait_on = request;
+            // Share any request that is still in flight, otherwise
+            // make an event just for us to use
+            wait_on = Runtime::find_or_create_pending_request(
+                              semantic_requests, tag, request);
           }
         }
       }
@@ -7631,7 +8191,8 @@ namespace Legion {
     ApEvent VariantImpl::dispatch_task(Processor target, SingleTask *task,
                                        TaskContext *ctx, ApEvent precondition,
                                        PredEvent predicate_guard, int priority,
-                                       Realm::ProfilingRequestSet &requests)
+                                       Realm::ProfilingRequestSet &requests,
+                                       Realm::SpawnBatch *batch)
     //--------------------------------------------------------------------------
     {
 #ifdef DEBUG_LEGION
@@ -7650,24 +8211,23 @@ namespace Legion {
 #endif
       DETAILED_PROFILER(runtime, REALM_SPAWN_TASK_CALL);
       // If our ready event hasn't triggered, include it in the precondition
+      ApEvent pre = precondition;
       if (predicate_guard.exists())
-      {
         // Merge in the predicate guard
-        ApEvent pre = Runtime::merge_events(precondition, ready_event,
-                                            ApEvent(predicate_guard));
-        // Have to protect the result in case it misspeculates
-        return Runtime::ignorefaults(target.spawn(descriptor_id, 
-                    &ctx, sizeof(ctx), requests, pre, priority));
-      }
-      else
-      {
-        // No predicate guard
-        if (!ready_event.has_triggered())
-          return ApEvent(target.spawn(descriptor_id, &ctx, sizeof(ctx),requests,
-                   Runtime::merge_events(precondition, ready_event), priority));
-        return ApEvent(target.spawn(descriptor_id, &ctx, sizeof(ctx), requests, 
-                                    precondition, priority));
-      }
+        pre = Runtime::merge_events(precondition, ready_event,
+                                    ApEvent(predicate_guard));
+      else if (!ready_event.has_triggered())
+        pre = Runtime::merge_events(precondition, ready_event);
+      // If we were given a batch then the task is held in it until the
+      // caller submits the whole batch to Realm at once
+      const Realm::Event launch_event = (batch != NULL) ?
+        batch->spawn(target, descriptor_id, &ctx, sizeof(ctx), requests,
+                     pre, priority) :
+        target.spawn(descriptor_id, &ctx, sizeof(ctx), requests, pre, priority);
+      // Have to protect the result in case it misspeculates
+      if (predicate_guard.exists())
+        return Runtime::ignorefaults(launch_event);
+      return ApEvent(launch_event);
     }
     
     //--------------------------------------------------------------------------
@@ -8710,19 +9270,27 @@ namespace Legion {
         machine(m), address_space(unique), 
         total_address_spaces(address_spaces.size()),
         runtime_stride(address_spaces.size()), profiler(NULL),
-        forest(new RegionTreeForest(this)), 
+        next_memory_sample(0), forest(new RegionTreeForest(this)), 
         has_explicit_utility_procs(!local_utilities.empty()), 
         prepared_for_shutdown(false),
 #ifdef DEBUG_LEGION
         outstanding_task_lock(Reservation::create_reservation()),
 #endif
-        total_outstanding_tasks(0), outstanding_top_level_tasks(0), 
+        total_outstanding_tasks(0), 
+        // Node 0 counts the top-level shards on the other nodes up front
+        // so that none of them can finish before the others have started
+        outstanding_top_level_tasks((replicate_top_level_task && 
+              (unique == 0)) ? (address_spaces.size() - 1) : 0), 
         local_procs(locals), local_utils(local_utilities),
         memory_manager_lock(Reservation::create_reservation()),
         message_manager_lock(Reservation::create_reservation()),
+        remote_reference_lock(Reservation::create_reservation()),
+        remote_reference_deadline(0), remote_reference_flush_pending(false),
         proc_spaces(processor_spaces),
         task_variant_lock(Reservation::create_reservation()),
         layout_constraints_lock(Reservation::create_reservation()),
+        shared_argument_lock(Reservation::create_reservation()),
+        local_shared_argument_bytes(0),
         unique_index_space_id((unique == 0) ? runtime_stride : unique),
         unique_index_partition_id((unique == 0) ? runtime_stride : unique), 
         unique_field_space_id((unique == 0) ? runtime_stride : unique),
@@ -8740,6 +9308,7 @@ namespace Legion {
         projection_lock(Reservation::create_reservation()),
         group_lock(Reservation::create_reservation()),
         processor_mapping_lock(Reservation::create_reservation()),
+        region_tree_id_lock(Reservation::create_reservation()),
         distributed_id_lock(Reservation::create_reservation()),
         unique_distributed_id((unique == 0) ? runtime_stride : unique),
         distributed_collectable_lock(Reservation::create_reservation()),
@@ -8888,13 +9457,17 @@ namespace Legion {
       LegionRuntime::Accessor::DebugHooks::check_bounds_dpoint =
       &Legion::Internal::Runtime::check_bounds;
 #endif
+      // Records logged before this point stay buffered until the file exists
+      if (legion_spy_enabled && (legion_spy_logfile != NULL))
+        LegionSpy::open_binary_log(legion_spy_logfile, address_space);
     }
     
     //--------------------------------------------------------------------------
     Runtime::Runtime(const Runtime &rhs)
     : external(NULL), mapper_runtime(NULL), machine(rhs.machine),
     address_space(0), total_address_spaces(0), runtime_stride(0),
-    profiler(NULL), forest(NULL), has_explicit_utility_procs(false),
+    profiler(NULL), next_memory_sample(0), forest(NULL), 
+    has_explicit_utility_procs(false),
     local_procs(rhs.local_procs), proc_spaces(rhs.proc_spaces)
     //--------------------------------------------------------------------------
     {
@@ -8909,6 +9482,8 @@ namespace Legion {
       // Make sure we don't send anymore messages
       message_manager_lock.destroy_reservation();
       message_manager_lock = Reservation::NO_RESERVATION;
+      remote_reference_lock.destroy_reservation();
+      remote_reference_lock = Reservation::NO_RESERVATION;
       for (unsigned idx = 0; idx < MAX_NUM_NODES; idx++)
       {
         if (message_managers[idx] != NULL)
@@ -8923,6 +9498,8 @@ namespace Legion {
         delete profiler;
         profiler = NULL;
       }
+      if (legion_spy_enabled && (legion_spy_logfile != NULL))
+        LegionSpy::close_binary_log();
       delete forest;
       delete external;
       delete mapper_runtime;
@@ -9250,6 +9827,20 @@ namespace Legion {
       }
       layout_constraints_lock.destroy_reservation();
       layout_constraints_lock = Reservation::NO_RESERVATION;
+      for (std::map<SharedArgumentKey,AllocManager*>::const_iterator it = 
+            local_shared_arguments.begin(); it != 
+            local_shared_arguments.end(); it++)
+        if (it->second->remove_reference())
+          delete it->second;
+      local_shared_arguments.clear();
+      for (std::map<SharedArgumentKey,AllocManager*>::const_iterator it = 
+            remote_shared_arguments.begin(); it != 
+            remote_shared_arguments.end(); it++)
+        if (it->second->remove_reference())
+          delete it->second;
+      remote_shared_arguments.clear();
+      shared_argument_lock.destroy_reservation();
+      shared_argument_lock = Reservation::NO_RESERVATION;
       memory_manager_lock.destroy_reservation();
       memory_manager_lock = Reservation::NO_RESERVATION;
       memory_managers.clear();
@@ -9259,6 +9850,8 @@ namespace Legion {
       group_lock = Reservation::NO_RESERVATION;
       processor_mapping_lock.destroy_reservation();
       processor_mapping_lock = Reservation::NO_RESERVATION;
+      region_tree_id_lock.destroy_reservation();
+      region_tree_id_lock = Reservation::NO_RESERVATION;
       distributed_id_lock.destroy_reservation();
       distributed_id_lock = Reservation::NO_RESERVATION;
       distributed_collectable_lock.destroy_reservation();
@@ -9363,9 +9956,15 @@ namespace Legion {
                                     Operation::LAST_OP_KIND,
                                     Operation::op_names,
                                     Runtime::serializer_type,
-                                    Runtime::prof_logfile);
+                                    Runtime::prof_logfile, this,
+                                    size_t(prof_footprint) << 20,
+                                    prof_sample_rate, prof_counters);
       LG_MESSAGE_DESCRIPTIONS(lg_message_descriptions);
       profiler->record_message_kinds(lg_message_descriptions, LAST_SEND_KIND);
+      std::vector<const char*> alloc_names(LAST_ALLOC);
+      for (unsigned idx = 0; idx < LAST_ALLOC; idx++)
+        alloc_names[idx] = get_allocation_name((AllocationType)idx);
+      profiler->record_allocation_kinds(&alloc_names.front(), LAST_ALLOC);
       MAPPER_CALL_NAMES(lg_mapper_calls);
       profiler->record_mapper_call_kinds(lg_mapper_calls, LAST_MAPPER_CALL);
 #ifdef DETAILED_LEGION_PROF
@@ -9461,6 +10060,10 @@ namespace Legion {
       // Set the executing processor
       top_context->set_executing_processor(target);
       TaskLauncher launcher(Runtime::legion_main_id, TaskArgument());
+      // Each shard of a replicated top-level task sees its shard ID
+      if (replicate_top_level_task)
+        launcher.point = DomainPoint::from_point<1>(
+            LegionRuntime::Arrays::Point<1>(address_space));
       // Mark that this task is the top-level task
       top_task->set_top_level();
       top_task->initialize_task(top_context, launcher,
@@ -9479,7 +10082,9 @@ namespace Legion {
                                       top_task->get_unique_id(),
                                       top_task->get_task_name());
       }
-      increment_outstanding_top_level_tasks();
+      // Shards on other nodes were already counted by node 0
+      if (!replicate_top_level_task || (address_space == 0))
+        increment_outstanding_top_level_tasks();
       // Launch a task to deactivate the top-level context
       // when the top-level task is done
       TopFinishArgs args;
@@ -12557,6 +13162,111 @@ namespace Legion {
       return result;
     }
     
+    //--------------------------------------------------------------------------
+    unsigned Runtime::get_num_shards(Context ctx)
+    //--------------------------------------------------------------------------
+    {
+      return replicate_top_level_task ? total_address_spaces : 1;
+    }
+
+    //--------------------------------------------------------------------------
+    unsigned Runtime::get_shard_id(Context ctx)
+    //--------------------------------------------------------------------------
+    {
+      return replicate_top_level_task ? address_space : 0;
+    }
+
+    //--------------------------------------------------------------------------
+    Domain Runtime::get_shard_domain(Context ctx, const Domain &launch_domain)
+    //--------------------------------------------------------------------------
+    {
+      const unsigned num_shards = get_num_shards(ctx);
+      if (num_shards == 1)
+        return launch_domain;
+      const unsigned shard = get_shard_id(ctx);
+      // Block the domain along its first dimension
+      switch (launch_domain.get_dim())
+      {
+        case 1:
+          {
+            LegionRuntime::Arrays::Rect<1> rect = launch_domain.get_rect<1>();
+            const coord_t extent = rect.hi[0] - rect.lo[0] + 1;
+            const coord_t base = rect.lo[0];
+            rect.lo.x[0] = base + (extent * shard) / num_shards;
+            rect.hi.x[0] = base + (extent * (shard+1)) / num_shards - 1;
+            return Domain::from_rect<1>(rect);
+          }
+        case 2:
+          {
+            LegionRuntime::Arrays::Rect<2> rect = launch_domain.get_rect<2>();
+            const coord_t extent = rect.hi[0] - rect.lo[0] + 1;
+            const coord_t base = rect.lo[0];
+            rect.lo.x[0] = base + (extent * shard) / num_shards;
+            rect.hi.x[0] = base + (extent * (shard+1)) / num_shards - 1;
+            return Domain::from_rect<2>(rect);
+          }
+        case 3:
+          {
+            LegionRuntime::Arrays::Rect<3> rect = launch_domain.get_rect<3>();
+            const coord_t extent = rect.hi[0] - rect.lo[0] + 1;
+            const coord_t base = rect.lo[0];
+            rect.lo.x[0] = base + (extent * shard) / num_shards;
+            rect.hi.x[0] = base + (extent * (shard+1)) / num_shards - 1;
+            return Domain::from_rect<3>(rect);
+          }
+        default:
+          assert(false);
+      }
+      return launch_domain;
+    }
+
+    //--------------------------------------------------------------------------
+    size_t Runtime::get_runtime_memory_usage(
+                                     std::map<std::string,size_t> *by_kind)
+    //--------------------------------------------------------------------------
+    {
+      long long bytes[LAST_ALLOC], allocations[LAST_ALLOC];
+      LegionMemoryCounters::snapshot(bytes, allocations);
+      size_t total = 0;
+      for (unsigned idx = 0; idx < LAST_ALLOC; idx++)
+      {
+        // Counts can be transiently negative when a free on one thread
+        // is observed before the matching allocation on another thread
+        if (bytes[idx] <= 0)
+          continue;
+        if (by_kind != NULL)
+          (*by_kind)[get_allocation_name((AllocationType)idx)] = bytes[idx];
+        // Slab pools back objects that are counted under their own kinds
+        if (idx != SLAB_POOL_ALLOC)
+          total += bytes[idx];
+      }
+      return total;
+    }
+
+    //--------------------------------------------------------------------------
+    void Runtime::record_runtime_memory_usage(void)
+    //--------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(profiler != NULL);
+#endif
+      if (prof_memory_interval == 0)
+        return;
+      const unsigned long long now = 
+        Realm::Clock::current_time_in_microseconds();
+      unsigned long long next = next_memory_sample;
+      if (now < next)
+        return;
+      // Only one thread gets to take each sample
+      if (!__sync_bool_compare_and_swap(&next_memory_sample, next,
+                                        now + prof_memory_interval))
+        return;
+      long long bytes[LAST_ALLOC], allocations[LAST_ALLOC];
+      LegionMemoryCounters::snapshot(bytes, allocations);
+      profiler->record_runtime_memory(address_space, bytes, 
+                                      allocations, LAST_ALLOC);
+    }
+
     //--------------------------------------------------------------------------
     void Runtime::raise_region_exception(Context ctx,
                                          PhysicalRegion region, bool nuclear)
@@ -12736,6 +13446,11 @@ namespace Legion {
                                                    MapperID map_id, Processor p)
     //--------------------------------------------------------------------------
     {
+      // Production record/replay of mapping decisions wraps whatever
+      // mapper was given to us (but not the LegionSpy replay mappers)
+      if ((mapping_log_prefix != NULL) && (replay_file == NULL))
+        mapper = new Mapping::RecordReplayMapper(rt->mapper_runtime, mapper,
+                        map_id, p, mapping_log_prefix, mapping_log_replay);
       MapperManager *manager = NULL;
       switch (mapper->get_mapper_sync_model())
       {
@@ -13272,21 +13987,190 @@ namespace Legion {
         if (finder != memory_managers.end())
           return finder->second;
       }
-      // Otherwise, if we haven't made it yet, make it now
-      MemoryManager *result = new MemoryManager(mem, this);
-      // Put it in the map
-      AutoLock m_lock(memory_manager_lock);
-      memory_managers[mem] = result;
-      return result;
-    }
-    
-    //--------------------------------------------------------------------------
-    AddressSpaceID Runtime::find_address_space(Memory handle) const
-    //--------------------------------------------------------------------------
-    {
-      // Just use the standard translation for now
-      AddressSpaceID result = handle.address_space();
-      return result;
+      // Otherwise, if we haven't made it yet, make it now
+      MemoryManager *result = new MemoryManager(mem, this);
+      // Put it in the map
+      AutoLock m_lock(memory_manager_lock);
+      memory_managers[mem] = result;
+      return result;
+    }
+    
+    //--------------------------------------------------------------------------
+    AddressSpaceID Runtime::find_address_space(Memory handle) const
+    //--------------------------------------------------------------------------
+    {
+      // Just use the standard translation for now
+      AddressSpaceID result = handle.address_space();
+      return result;
+    }
+
+    //--------------------------------------------------------------------------
+    void Runtime::defer_remote_reference_removal(AddressSpaceID target,
+                     DistributedID did, ReferenceKind kind, unsigned count)
+    //--------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(count > 0);
+      assert(target != address_space);
+#endif
+      AutoLock r_lock(remote_reference_lock);
+      PendingRemoteReferences &pending = 
+        pending_remote_references[target][did];
+      switch (kind)
+      {
+        case GC_REF_KIND:
+          {
+            pending.gc_references += count;
+            break;
+          }
+        case VALID_REF_KIND:
+          {
+            pending.valid_references += count;
+            break;
+          }
+        case RESOURCE_REF_KIND:
+          {
+            pending.resource_references += count;
+            break;
+          }
+        default:
+          assert(false);
+      }
+      // The deadline is set by the oldest held removal
+      if (remote_reference_deadline > 0)
+        return;
+      remote_reference_deadline = Realm::Clock::current_time_in_nanoseconds()
+                                  + 1000LL * remote_reference_delay;
+      if (!remote_reference_flush_pending)
+      {
+        remote_reference_flush_pending = true;
+        DeferredReferenceFlushArgs args;
+        issue_runtime_meta_task(args, LG_LATENCY_PRIORITY);
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    unsigned Runtime::cancel_remote_reference_removal(AddressSpaceID target,
+                     DistributedID did, ReferenceKind kind, unsigned count)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock r_lock(remote_reference_lock);
+      std::map<AddressSpaceID,std::map<DistributedID,
+        PendingRemoteReferences> >::iterator target_finder = 
+          pending_remote_references.find(target);
+      if (target_finder == pending_remote_references.end())
+        return count;
+      std::map<DistributedID,PendingRemoteReferences>::iterator finder = 
+        target_finder->second.find(did);
+      if (finder == target_finder->second.end())
+        return count;
+      unsigned *pending = NULL;
+      switch (kind)
+      {
+        case GC_REF_KIND:
+          {
+            pending = &finder->second.gc_references;
+            break;
+          }
+        case VALID_REF_KIND:
+          {
+            pending = &finder->second.valid_references;
+            break;
+          }
+        case RESOURCE_REF_KIND:
+          {
+            pending = &finder->second.resource_references;
+            break;
+          }
+        default:
+          assert(false);
+      }
+      // The owner has not seen the held removals yet so it still has
+      // these references and we can just take them back
+      const unsigned cancelled = (count < *pending) ? count : *pending;
+      *pending -= cancelled;
+      if ((finder->second.gc_references == 0) && 
+          (finder->second.valid_references == 0) &&
+          (finder->second.resource_references == 0))
+      {
+        target_finder->second.erase(finder);
+        if (target_finder->second.empty())
+          pending_remote_references.erase(target_finder);
+      }
+      return (count - cancelled);
+    }
+
+    //--------------------------------------------------------------------------
+    void Runtime::process_deferred_reference_flush(void)
+    //--------------------------------------------------------------------------
+    {
+      // Hold the lock while sending so that any additions made after
+      // this point are ordered behind the removals on the channel
+      AutoLock r_lock(remote_reference_lock);
+#ifdef DEBUG_LEGION
+      assert(remote_reference_flush_pending);
+#endif
+      if ((remote_reference_deadline > 0) &&
+          (Realm::Clock::current_time_in_nanoseconds() < 
+           remote_reference_deadline))
+      {
+        // Not time yet so check back again later, there is no timer in
+        // Realm so we go to the back of the queue at the lowest priority
+        DeferredReferenceFlushArgs args;
+        issue_runtime_meta_task(args, LG_THROUGHPUT_PRIORITY);
+        return;
+      }
+      for (std::map<AddressSpaceID,std::map<DistributedID,
+            PendingRemoteReferences> >::const_iterator tit = 
+            pending_remote_references.begin(); tit != 
+            pending_remote_references.end(); tit++)
+      {
+        for (std::map<DistributedID,PendingRemoteReferences>::const_iterator
+              it = tit->second.begin(); it != tit->second.end(); it++)
+        {
+          // Only flush the channel with the last message for the target
+          std::map<DistributedID,PendingRemoteReferences>::const_iterator
+            next = it;
+          next++;
+          const bool last = (next == tit->second.end());
+          if (it->second.gc_references > 0)
+          {
+            Serializer rez;
+            {
+              RezCheck z(rez);
+              rez.serialize(it->first);
+              rez.serialize(-int(it->second.gc_references));
+            }
+            send_did_remote_gc_update(tit->first, rez, last &&
+                (it->second.valid_references == 0) &&
+                (it->second.resource_references == 0));
+          }
+          if (it->second.valid_references > 0)
+          {
+            Serializer rez;
+            {
+              RezCheck z(rez);
+              rez.serialize(it->first);
+              rez.serialize(-int(it->second.valid_references));
+            }
+            send_did_remote_valid_update(tit->first, rez, last &&
+                (it->second.resource_references == 0));
+          }
+          if (it->second.resource_references > 0)
+          {
+            Serializer rez;
+            {
+              RezCheck z(rez);
+              rez.serialize(it->first);
+              rez.serialize(-int(it->second.resource_references));
+            }
+            send_did_remote_resource_update(tit->first, rez, last);
+          }
+        }
+      }
+      pending_remote_references.clear();
+      remote_reference_deadline = 0;
+      remote_reference_flush_pending = false;
     }
     
     //--------------------------------------------------------------------------
@@ -13354,6 +14238,17 @@ namespace Legion {
 #endif
       return finder->second;
     }
+
+    //--------------------------------------------------------------------------
+    RtEvent Runtime::find_message_fence(AddressSpaceID target,
+                                        VirtualChannelKind vc)
+    //--------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(target != address_space);
+#endif
+      return find_messenger(target)->find_ordering_fence(vc);
+    }
     
     //--------------------------------------------------------------------------
     void Runtime::process_mapper_message(Processor target, MapperID map_id,
@@ -14024,29 +14919,29 @@ namespace Legion {
     
     //--------------------------------------------------------------------------
     void Runtime::send_did_remote_valid_update(AddressSpaceID target,
-                                               Serializer &rez)
+                                               Serializer &rez, bool flush)
     //--------------------------------------------------------------------------
     {
       find_messenger(target)->send_message(rez, DISTRIBUTED_VALID_UPDATE,
-                                           DEFAULT_VIRTUAL_CHANNEL, true/*flush*/);
+                                           DEFAULT_VIRTUAL_CHANNEL, flush);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::send_did_remote_gc_update(AddressSpaceID target,
-                                            Serializer &rez)
+                                            Serializer &rez, bool flush)
     //--------------------------------------------------------------------------
     {
       find_messenger(target)->send_message(rez, DISTRIBUTED_GC_UPDATE,
-                                           DEFAULT_VIRTUAL_CHANNEL, true/*flush*/);
+                                           DEFAULT_VIRTUAL_CHANNEL, flush);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::send_did_remote_resource_update(AddressSpaceID target,
-                                                  Serializer &rez)
+                                                  Serializer &rez, bool flush)
     //--------------------------------------------------------------------------
     {
       find_messenger(target)->send_message(rez, DISTRIBUTED_RESOURCE_UPDATE,
-                                           DEFAULT_VIRTUAL_CHANNEL, true/*flush*/);
+                                           DEFAULT_VIRTUAL_CHANNEL, flush);
     }
     
     //--------------------------------------------------------------------------
@@ -14680,14 +15575,6 @@ namespace Legion {
                                            DEFAULT_VIRTUAL_CHANNEL, true/*flush*/);
     }
     
-    //--------------------------------------------------------------------------
-    void Runtime::send_mpi_rank_exchange(AddressSpaceID target, Serializer &rez)
-    //--------------------------------------------------------------------------
-    {
-      find_messenger(target)->send_message(rez, SEND_MPI_RANK_EXCHANGE,
-                                           DEFAULT_VIRTUAL_CHANNEL, true/*flush*/);
-    }
-    
     //--------------------------------------------------------------------------
     void Runtime::send_shutdown_notification(AddressSpaceID target,
                                              Serializer &rez)
@@ -15759,16 +16646,6 @@ namespace Legion {
       decrement_outstanding_top_level_tasks();
     }
     
-    //--------------------------------------------------------------------------
-    void Runtime::handle_mpi_rank_exchange(Deserializer &derez)
-    //--------------------------------------------------------------------------
-    {
-#ifdef DEBUG_LEGION
-      assert(Runtime::mpi_rank_table != NULL);
-#endif
-      Runtime::mpi_rank_table->handle_mpi_rank_exchange(derez);
-    }
-    
     //--------------------------------------------------------------------------
     void Runtime::handle_shutdown_notification(Deserializer &derez,
                                                AddressSpaceID source)
@@ -15791,12 +16668,13 @@ namespace Legion {
                                            MappingInstance &result,
                                            MapperID mapper_id, Processor processor,
                                            bool acquire, GCPriority priority,
-                                           UniqueID creator_id)
+                                           UniqueID creator_id, TaskID task_id)
     //--------------------------------------------------------------------------
     {
       MemoryManager *manager = find_memory_manager(target_memory);
       return manager->create_physical_instance(constraints, regions, result,
-                                               mapper_id, processor, acquire, priority, creator_id);
+                                               mapper_id, processor, acquire, priority, creator_id,
+                                               task_id);
     }
     
     //--------------------------------------------------------------------------
@@ -15806,13 +16684,14 @@ namespace Legion {
                                            MappingInstance &result,
                                            MapperID mapper_id, Processor processor,
                                            bool acquire, GCPriority priority,
-                                           UniqueID creator_id)
+                                           UniqueID creator_id, TaskID task_id)
     //--------------------------------------------------------------------------
     {
       LayoutConstraints *constraints = find_layout_constraints(layout_id);
       MemoryManager *manager = find_memory_manager(target_memory);
       return manager->create_physical_instance(constraints, regions, result,
-                                               mapper_id, processor, acquire, priority, creator_id);
+                                               mapper_id, processor, acquire, priority, creator_id,
+                                               task_id);
     }
     
     //--------------------------------------------------------------------------
@@ -15822,13 +16701,14 @@ namespace Legion {
                                                    MappingInstance &result, bool &created,
                                                    MapperID mapper_id, Processor processor,
                                                    bool acquire, GCPriority priority,
-                                                   bool tight_bounds, UniqueID creator_id)
+                                                   bool tight_bounds, UniqueID creator_id,
+                                                   TaskID task_id)
     //--------------------------------------------------------------------------
     {
       MemoryManager *manager = find_memory_manager(target_memory);
       return manager->find_or_create_physical_instance(constraints, regions,
                                                        result, created, mapper_id, processor, acquire,
-                                                       priority, tight_bounds, creator_id);
+                                                       priority, tight_bounds, creator_id, task_id);
     }
     
     //--------------------------------------------------------------------------
@@ -15838,14 +16718,15 @@ namespace Legion {
                                                    MappingInstance &result, bool &created,
                                                    MapperID mapper_id, Processor processor,
                                                    bool acquire, GCPriority priority,
-                                                   bool tight_bounds, UniqueID creator_id)
+                                                   bool tight_bounds, UniqueID creator_id,
+                                                   TaskID task_id)
     //--------------------------------------------------------------------------
     {
       LayoutConstraints *constraints = find_layout_constraints(layout_id);
       MemoryManager *manager = find_memory_manager(target_memory);
       return manager->find_or_create_physical_instance(constraints, regions,
                                                        result, created, mapper_id, processor, acquire,
-                                                       priority, tight_bounds, creator_id);
+                                                       priority, tight_bounds, creator_id, task_id);
     }
     
     //--------------------------------------------------------------------------
@@ -15905,6 +16786,8 @@ namespace Legion {
       if ((trace_count % TRACE_ALLOCATION_FREQUENCY) == 0)
         dump_allocation_info();
 #endif
+      if (profiler != NULL)
+        record_runtime_memory_usage();
     }
     
     //--------------------------------------------------------------------------
@@ -16231,8 +17114,9 @@ namespace Legion {
     {
       did &= LEGION_DISTRIBUTED_ID_MASK;
       AutoLock d_lock(distributed_collectable_lock,1,false/*exclusive*/);
-      std::map<DistributedID,DistributedCollectable*>::const_iterator finder =
-      dist_collectables.find(did);
+      LegionHashMap<DistributedID,DistributedCollectable*,
+        RUNTIME_DIST_COLLECT_ALLOC>::tracked::const_iterator finder =
+          dist_collectables.find(did);
 #ifdef DEBUG_LEGION
       assert(finder != dist_collectables.end());
 #endif
@@ -16246,8 +17130,9 @@ namespace Legion {
     {
       did &= LEGION_DISTRIBUTED_ID_MASK;
       AutoLock d_lock(distributed_collectable_lock,1,false/*exclusive*/);
-      std::map<DistributedID,DistributedCollectable*>::const_iterator finder =
-      dist_collectables.find(did);
+      LegionHashMap<DistributedID,DistributedCollectable*,
+        RUNTIME_DIST_COLLECT_ALLOC>::tracked::const_iterator finder =
+          dist_collectables.find(did);
       if (finder == dist_collectables.end())
         return NULL;
       return finder->second;
@@ -16343,8 +17228,9 @@ namespace Legion {
       DistributedCollectable *result = NULL;
       {
         AutoLock d_lock(distributed_collectable_lock);
-        std::map<DistributedID,DistributedCollectable*>::const_iterator finder =
-        dist_collectables.find(did);
+        LegionHashMap<DistributedID,DistributedCollectable*,
+          RUNTIME_DIST_COLLECT_ALLOC>::tracked::const_iterator finder =
+            dist_collectables.find(did);
         // If we've already got it, then we are done
         if (finder != dist_collectables.end())
         {
@@ -16389,8 +17275,9 @@ namespace Legion {
       did &= LEGION_DISTRIBUTED_ID_MASK;
       {
         AutoLock d_lock(distributed_collectable_lock,1,false/*exclusive*/);
-        std::map<DistributedID,DistributedCollectable*>::const_iterator
-        finder = dist_collectables.find(did);
+        LegionHashMap<DistributedID,DistributedCollectable*,
+          RUNTIME_DIST_COLLECT_ALLOC>::tracked::const_iterator finder =
+            dist_collectables.find(did);
         if (finder != dist_collectables.end())
         {
 #ifdef DEBUG_LEGION
@@ -16408,8 +17295,9 @@ namespace Legion {
       // Retake the lock and see if we lost the race
       {
         AutoLock d_lock(distributed_collectable_lock);
-        std::map<DistributedID,DistributedCollectable*>::const_iterator
-        finder = dist_collectables.find(did);
+        LegionHashMap<DistributedID,DistributedCollectable*,
+          RUNTIME_DIST_COLLECT_ALLOC>::tracked::const_iterator finder =
+            dist_collectables.find(did);
         if (finder != dist_collectables.end())
         {
           // We lost the race
@@ -16436,8 +17324,9 @@ namespace Legion {
       did &= LEGION_DISTRIBUTED_ID_MASK;
       {
         AutoLock d_lock(distributed_collectable_lock,1,false/*exclusive*/);
-        std::map<DistributedID,DistributedCollectable*>::const_iterator
-        finder = dist_collectables.find(did);
+        LegionHashMap<DistributedID,DistributedCollectable*,
+          RUNTIME_DIST_COLLECT_ALLOC>::tracked::const_iterator finder =
+            dist_collectables.find(did);
         if (finder != dist_collectables.end())
         {
 #ifdef DEBUG_LEGION
@@ -16455,8 +17344,9 @@ namespace Legion {
       // Retake the lock and see if we lost the race
       {
         AutoLock d_lock(distributed_collectable_lock);
-        std::map<DistributedID,DistributedCollectable*>::const_iterator
-        finder = dist_collectables.find(did);
+        LegionHashMap<DistributedID,DistributedCollectable*,
+          RUNTIME_DIST_COLLECT_ALLOC>::tracked::const_iterator finder =
+            dist_collectables.find(did);
         if (finder != dist_collectables.end())
         {
           // We lost the race
@@ -16756,7 +17646,7 @@ namespace Legion {
                                                            bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<IndividualTask>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -16784,7 +17674,7 @@ namespace Legion {
     PointTask* Runtime::get_available_point_task(bool need_cont, bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<PointTask>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -16812,7 +17702,7 @@ namespace Legion {
     IndexTask* Runtime::get_available_index_task(bool need_cont, bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<IndexTask>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -16840,7 +17730,7 @@ namespace Legion {
     SliceTask* Runtime::get_available_slice_task(bool need_cont, bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<SliceTask>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -16868,7 +17758,7 @@ namespace Legion {
     MapOp* Runtime::get_available_map_op(bool need_cont, bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<MapOp>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -16885,7 +17775,7 @@ namespace Legion {
     CopyOp* Runtime::get_available_copy_op(bool need_cont, bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<CopyOp>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -16903,7 +17793,7 @@ namespace Legion {
                                                       bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<IndexCopyOp>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -16921,7 +17811,7 @@ namespace Legion {
                                                       bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<PointCopyOp>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -16938,7 +17828,7 @@ namespace Legion {
     FenceOp* Runtime::get_available_fence_op(bool need_cont, bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<FenceOp>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -16955,7 +17845,7 @@ namespace Legion {
     FrameOp* Runtime::get_available_frame_op(bool need_cont, bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<FrameOp>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -16973,7 +17863,7 @@ namespace Legion {
                                                    bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<DeletionOp>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -16990,7 +17880,7 @@ namespace Legion {
     OpenOp* Runtime::get_available_open_op(bool need_cont, bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<OpenOp>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -17006,7 +17896,7 @@ namespace Legion {
     AdvanceOp* Runtime::get_available_advance_op(bool need_cont, bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<AdvanceOp>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -17024,7 +17914,7 @@ namespace Legion {
                                                         bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<InterCloseOp>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -17043,7 +17933,7 @@ namespace Legion {
                                                       bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<ReadCloseOp>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -17062,7 +17952,7 @@ namespace Legion {
                                                       bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<PostCloseOp>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -17081,7 +17971,7 @@ namespace Legion {
                                                             bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<VirtualCloseOp>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -17100,7 +17990,7 @@ namespace Legion {
                                                                       bool need_cont, bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<DynamicCollectiveOp>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -17119,7 +18009,7 @@ namespace Legion {
                                                         bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<FuturePredOp>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -17137,7 +18027,7 @@ namespace Legion {
     NotPredOp* Runtime::get_available_not_pred_op(bool need_cont,bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<NotPredOp>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -17154,7 +18044,7 @@ namespace Legion {
     AndPredOp* Runtime::get_available_and_pred_op(bool need_cont,bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<AndPredOp>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -17171,7 +18061,7 @@ namespace Legion {
     OrPredOp* Runtime::get_available_or_pred_op(bool need_cont, bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<OrPredOp>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -17188,7 +18078,7 @@ namespace Legion {
     AcquireOp* Runtime::get_available_acquire_op(bool need_cont, bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<AcquireOp>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -17205,7 +18095,7 @@ namespace Legion {
     ReleaseOp* Runtime::get_available_release_op(bool need_cont, bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<ReleaseOp>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -17223,7 +18113,7 @@ namespace Legion {
                                                       bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<TraceCaptureOp>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -17241,7 +18131,7 @@ namespace Legion {
                                                      bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<TraceCompleteOp>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -17258,7 +18148,7 @@ namespace Legion {
     MustEpochOp* Runtime::get_available_epoch_op(bool need_cont, bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<MustEpochOp>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -17287,7 +18177,7 @@ namespace Legion {
                                                                     bool need_cont, bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<PendingPartitionOp>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -17306,7 +18196,7 @@ namespace Legion {
                                                                         bool need_cont, bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<DependentPartitionOp>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -17324,7 +18214,7 @@ namespace Legion {
     FillOp* Runtime::get_available_fill_op(bool need_cont, bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<FillOp>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -17342,7 +18232,7 @@ namespace Legion {
                                                       bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<IndexFillOp>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -17360,7 +18250,7 @@ namespace Legion {
                                                       bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<PointFillOp>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -17377,7 +18267,7 @@ namespace Legion {
     AttachOp* Runtime::get_available_attach_op(bool need_cont, bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<AttachOp>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -17394,7 +18284,7 @@ namespace Legion {
     DetachOp* Runtime::get_available_detach_op(bool need_cont, bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<DetachOp>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -17411,7 +18301,7 @@ namespace Legion {
     TimingOp* Runtime::get_available_timing_op(bool need_cont, bool has_lock)
     //--------------------------------------------------------------------------
     {
-      if (need_cont)
+      if (need_cont && !has_cached_operation<TimingOp>())
       {
 #ifdef DEBUG_LEGION
         assert(!has_lock);
@@ -17428,300 +18318,286 @@ namespace Legion {
     void Runtime::free_individual_task(IndividualTask *task)
     //--------------------------------------------------------------------------
     {
-      AutoLock i_lock(individual_task_lock);
-      release_operation<false>(available_individual_tasks, task);
 #ifdef DEBUG_LEGION
-      out_individual_tasks.erase(task);
+      {
+        AutoLock i_lock(individual_task_lock);
+        out_individual_tasks.erase(task);
+      }
 #endif
+      release_operation<false>(individual_task_lock,
+                               available_individual_tasks, task);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_point_task(PointTask *task)
     //--------------------------------------------------------------------------
     {
-      AutoLock p_lock(point_task_lock);
 #ifdef DEBUG_LEGION
-      out_point_tasks.erase(task);
+      {
+        AutoLock p_lock(point_task_lock);
+        out_point_tasks.erase(task);
+      }
 #endif
       // Note that we can safely delete point tasks because they are
       // never registered in the logical state of the region tree
       // as part of the dependence analysis. This does not apply
       // to all operation objects.
-      release_operation<true>(available_point_tasks, task);
+      release_operation<true>(point_task_lock, available_point_tasks, task);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_index_task(IndexTask *task)
     //--------------------------------------------------------------------------
     {
-      AutoLock i_lock(index_task_lock);
-      release_operation<false>(available_index_tasks, task);
 #ifdef DEBUG_LEGION
-      out_index_tasks.erase(task);
+      {
+        AutoLock i_lock(index_task_lock);
+        out_index_tasks.erase(task);
+      }
 #endif
+      release_operation<false>(index_task_lock, available_index_tasks, task);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_slice_task(SliceTask *task)
     //--------------------------------------------------------------------------
     {
-      AutoLock s_lock(slice_task_lock);
 #ifdef DEBUG_LEGION
-      out_slice_tasks.erase(task);
+      {
+        AutoLock s_lock(slice_task_lock);
+        out_slice_tasks.erase(task);
+      }
 #endif
       // Note that we can safely delete slice tasks because they are
       // never registered in the logical state of the region tree
       // as part of the dependence analysis. This does not apply
       // to all operation objects.
-      release_operation<true>(available_slice_tasks, task);
+      release_operation<true>(slice_task_lock, available_slice_tasks, task);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_map_op(MapOp *op)
     //--------------------------------------------------------------------------
     {
-      AutoLock m_lock(map_op_lock);
-      release_operation<false>(available_map_ops, op);
+      release_operation<false>(map_op_lock, available_map_ops, op);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_copy_op(CopyOp *op)
     //--------------------------------------------------------------------------
     {
-      AutoLock c_lock(copy_op_lock);
-      release_operation<false>(available_copy_ops, op);
+      release_operation<false>(copy_op_lock, available_copy_ops, op);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_index_copy_op(IndexCopyOp *op)
     //--------------------------------------------------------------------------
     {
-      AutoLock c_lock(copy_op_lock);
-      release_operation<false>(available_index_copy_ops, op);
+      release_operation<false>(copy_op_lock, available_index_copy_ops, op);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_point_copy_op(PointCopyOp *op)
     //--------------------------------------------------------------------------
     {
-      AutoLock c_lock(copy_op_lock);
-      release_operation<true>(available_point_copy_ops, op);
+      release_operation<true>(copy_op_lock, available_point_copy_ops, op);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_fence_op(FenceOp *op)
     //--------------------------------------------------------------------------
     {
-      AutoLock f_lock(fence_op_lock);
-      release_operation<false>(available_fence_ops, op);
+      release_operation<false>(fence_op_lock, available_fence_ops, op);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_frame_op(FrameOp *op)
     //--------------------------------------------------------------------------
     {
-      AutoLock f_lock(frame_op_lock);
-      release_operation<false>(available_frame_ops, op);
+      release_operation<false>(frame_op_lock, available_frame_ops, op);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_deletion_op(DeletionOp *op)
     //--------------------------------------------------------------------------
     {
-      AutoLock d_lock(deletion_op_lock);
-      release_operation<false>(available_deletion_ops, op);
+      release_operation<false>(deletion_op_lock, available_deletion_ops, op);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_open_op(OpenOp *op)
     //--------------------------------------------------------------------------
     {
-      AutoLock o_lock(open_op_lock);
-      release_operation<false>(available_open_ops, op);
+      release_operation<false>(open_op_lock, available_open_ops, op);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_advance_op(AdvanceOp *op)
     //--------------------------------------------------------------------------
     {
-      AutoLock a_lock(advance_op_lock);
-      release_operation<false>(available_advance_ops, op);
+      release_operation<false>(advance_op_lock, available_advance_ops, op);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_inter_close_op(InterCloseOp *op)
     //--------------------------------------------------------------------------
     {
-      AutoLock i_lock(inter_close_op_lock);
-      release_operation<false>(available_inter_close_ops, op);
+      release_operation<false>(inter_close_op_lock,
+                               available_inter_close_ops, op);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_read_close_op(ReadCloseOp *op)
     //--------------------------------------------------------------------------
     {
-      AutoLock r_lock(read_close_op_lock);
-      release_operation<false>(available_read_close_ops, op);
+      release_operation<false>(read_close_op_lock,
+                               available_read_close_ops, op);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_post_close_op(PostCloseOp *op)
     //--------------------------------------------------------------------------
     {
-      AutoLock p_lock(post_close_op_lock);
-      release_operation<false>(available_post_close_ops, op);
+      release_operation<false>(post_close_op_lock,
+                               available_post_close_ops, op);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_virtual_close_op(VirtualCloseOp *op)
     //--------------------------------------------------------------------------
     {
-      AutoLock v_lock(virtual_close_op_lock);
-      release_operation<false>(available_virtual_close_ops, op);
+      release_operation<false>(virtual_close_op_lock,
+                               available_virtual_close_ops, op);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_dynamic_collective_op(DynamicCollectiveOp *op)
     //--------------------------------------------------------------------------
     {
-      AutoLock dc_lock(dynamic_collective_op_lock);
-      release_operation<false>(available_dynamic_collective_ops, op);
+      release_operation<false>(dynamic_collective_op_lock,
+                               available_dynamic_collective_ops, op);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_future_predicate_op(FuturePredOp *op)
     //--------------------------------------------------------------------------
     {
-      AutoLock f_lock(future_pred_op_lock);
-      release_operation<false>(available_future_pred_ops, op);
+      release_operation<false>(future_pred_op_lock,
+                               available_future_pred_ops, op);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_not_predicate_op(NotPredOp *op)
     //--------------------------------------------------------------------------
     {
-      AutoLock n_lock(not_pred_op_lock);
-      release_operation<false>(available_not_pred_ops, op);
+      release_operation<false>(not_pred_op_lock, available_not_pred_ops, op);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_and_predicate_op(AndPredOp *op)
     //--------------------------------------------------------------------------
     {
-      AutoLock a_lock(and_pred_op_lock);
-      release_operation<false>(available_and_pred_ops, op);
+      release_operation<false>(and_pred_op_lock, available_and_pred_ops, op);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_or_predicate_op(OrPredOp *op)
     //--------------------------------------------------------------------------
     {
-      AutoLock o_lock(or_pred_op_lock);
-      release_operation<false>(available_or_pred_ops, op);
+      release_operation<false>(or_pred_op_lock, available_or_pred_ops, op);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_acquire_op(AcquireOp *op)
     //--------------------------------------------------------------------------
     {
-      AutoLock a_lock(acquire_op_lock);
-      release_operation<false>(available_acquire_ops, op);
+      release_operation<false>(acquire_op_lock, available_acquire_ops, op);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_release_op(ReleaseOp *op)
     //--------------------------------------------------------------------------
     {
-      AutoLock r_lock(release_op_lock);
-      release_operation<false>(available_release_ops, op);
+      release_operation<false>(release_op_lock, available_release_ops, op);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_capture_op(TraceCaptureOp *op)
     //--------------------------------------------------------------------------
     {
-      AutoLock c_lock(capture_op_lock);
-      release_operation<false>(available_capture_ops, op);
+      release_operation<false>(capture_op_lock, available_capture_ops, op);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_trace_op(TraceCompleteOp *op)
     //--------------------------------------------------------------------------
     {
-      AutoLock t_lock(trace_op_lock);
-      release_operation<false>(available_trace_ops, op);
+      release_operation<false>(trace_op_lock, available_trace_ops, op);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_epoch_op(MustEpochOp *op)
     //--------------------------------------------------------------------------
     {
-      AutoLock e_lock(epoch_op_lock);
-      release_operation<false>(available_epoch_ops, op);
+      release_operation<false>(epoch_op_lock, available_epoch_ops, op);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_pending_partition_op(PendingPartitionOp *op)
     //--------------------------------------------------------------------------
     {
-      AutoLock p_lock(pending_partition_op_lock);
-      release_operation<false>(available_pending_partition_ops, op);
+      release_operation<false>(pending_partition_op_lock,
+                               available_pending_partition_ops, op);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_dependent_partition_op(DependentPartitionOp *op)
     //--------------------------------------------------------------------------
     {
-      AutoLock p_lock(dependent_partition_op_lock);
-      release_operation<false>(available_dependent_partition_ops, op);
+      release_operation<false>(dependent_partition_op_lock,
+                               available_dependent_partition_ops, op);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_fill_op(FillOp *op)
     //--------------------------------------------------------------------------
     {
-      AutoLock f_lock(fill_op_lock);
-      release_operation<false>(available_fill_ops, op);
+      release_operation<false>(fill_op_lock, available_fill_ops, op);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_index_fill_op(IndexFillOp *op)
     //--------------------------------------------------------------------------
     {
-      AutoLock f_lock(fill_op_lock);
-      release_operation<false>(available_index_fill_ops, op);
+      release_operation<false>(fill_op_lock, available_index_fill_ops, op);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_point_fill_op(PointFillOp *op)
     //--------------------------------------------------------------------------
     {
-      AutoLock f_lock(fill_op_lock);
-      release_operation<true>(available_point_fill_ops, op);
+      release_operation<true>(fill_op_lock, available_point_fill_ops, op);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_attach_op(AttachOp *op)
     //--------------------------------------------------------------------------
     {
-      AutoLock a_lock(attach_op_lock);
-      release_operation<false>(available_attach_ops, op);
+      release_operation<false>(attach_op_lock, available_attach_ops, op);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_detach_op(DetachOp *op)
     //--------------------------------------------------------------------------
     {
-      AutoLock d_lock(detach_op_lock);
-      release_operation<false>(available_detach_ops, op);
+      release_operation<false>(detach_op_lock, available_detach_ops, op);
     }
     
     //--------------------------------------------------------------------------
     void Runtime::free_timing_op(TimingOp *op)
     //--------------------------------------------------------------------------
     {
-      AutoLock t_lock(timing_op_lock);
-      release_operation<false>(available_timing_ops, op);
+      release_operation<false>(timing_op_lock, available_timing_ops, op);
     }
     
     //--------------------------------------------------------------------------
@@ -17766,8 +18642,10 @@ namespace Legion {
       assert(context.exists());
       forest->check_context_state(context);
 #endif
+      // Hand out the most recently freed context first so the same 
+      // small set of context IDs and their states keep getting reused
       AutoLock ctx_lock(context_lock);
-      available_contexts.push_back(context);
+      available_contexts.push_front(context);
     }
     
     //--------------------------------------------------------------------------
@@ -18019,6 +18897,15 @@ namespace Legion {
     RegionTreeID Runtime::get_unique_region_tree_id(void)
     //--------------------------------------------------------------------------
     {
+      {
+        AutoLock t_lock(region_tree_id_lock);
+        if (!available_region_tree_ids.empty())
+        {
+          RegionTreeID result = available_region_tree_ids.front();
+          available_region_tree_ids.pop_front();
+          return result;
+        }
+      }
       RegionTreeID result = __sync_fetch_and_add(&unique_region_tree_id,
                                                  runtime_stride);
 #ifdef DEBUG_LEGION
@@ -18026,9 +18913,33 @@ namespace Legion {
       // If we have overflow on the number of region trees
       // created then we are really in a bad place.
       assert(result <= unique_region_tree_id);
+      // The top bits are reserved for the generation
+      assert(result <= LEGION_TREE_ID_MASK);
 #endif
       return result;
     }
+
+    //--------------------------------------------------------------------------
+    void Runtime::free_region_tree_id(RegionTreeID tid)
+    //--------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      // Should only be getting back our own tree IDs
+      assert(RegionTreeNode::get_owner_space(tid, this) == address_space);
+#endif
+      // Don't recycle tree IDs if we're doing LegionSpy since
+      // it expects every region tree to have a unique name
+#ifndef LEGION_SPY
+      if (legion_spy_enabled)
+        return;
+      // Bump the generation so stale handles for the old tree
+      // never match the new one, the generation wraps around
+      const RegionTreeID next = LEGION_TREE_ID_ENCODE(
+          LEGION_TREE_ID_FILTER(tid), LEGION_TREE_ID_GENERATION(tid) + 1);
+      AutoLock t_lock(region_tree_id_lock);
+      available_region_tree_ids.push_back(next);
+#endif
+    }
     
     //--------------------------------------------------------------------------
     UniqueID Runtime::get_unique_operation_id(void)
@@ -18231,6 +19142,7 @@ namespace Legion {
       }
       log_allocation.info(" ");
     }
+#endif
     
     //--------------------------------------------------------------------------
     /*static*/ const char* Runtime::get_allocation_name(AllocationType type)
@@ -18438,12 +19350,13 @@ namespace Legion {
           return "Variant Implementation";
         case LAYOUT_CONSTRAINTS_ALLOC:
           return "Layout Constraints";
+        case SLAB_POOL_ALLOC:
+          return "Slab Pool";
         default:
           assert(false); // should never get here
       }
       return NULL;
     }
-#endif
     
 #ifdef DEBUG_LEGION
     //--------------------------------------------------------------------------
@@ -18906,6 +19819,193 @@ namespace Legion {
       }
       return finder->second;
     }
+
+    //--------------------------------------------------------------------------
+    AllocManager* Runtime::find_or_create_shared_argument(const void *args,
+                                                 size_t arglen, uint64_t &hash)
+    //--------------------------------------------------------------------------
+    {
+      hash = compute_argument_hash(args, arglen);
+      const SharedArgumentKey key(hash, arglen);
+      AutoLock a_lock(shared_argument_lock);
+      std::map<SharedArgumentKey,AllocManager*>::const_iterator finder = 
+        local_shared_arguments.find(key);
+      if ((finder == local_shared_arguments.end()) || 
+          (memcmp(finder->second->get_allocation(), args, arglen) != 0))
+      {
+        finder = remote_shared_arguments.find(key);
+        if ((finder != remote_shared_arguments.end()) &&
+            (memcmp(finder->second->get_allocation(), args, arglen) == 0))
+        {
+          finder->second->add_reference();
+          return finder->second;
+        }
+      }
+      else
+      {
+        finder->second->add_reference();
+        return finder->second;
+      }
+      AllocManager *result = new AllocManager(arglen);
+      memcpy(result->get_allocation(), args, arglen);
+      // One reference for the caller
+      result->add_reference();
+      // Only cache it if it doesn't collide with another buffer
+      if (local_shared_arguments.find(key) == local_shared_arguments.end())
+      {
+        // Drop our references to the old buffers when we are over budget,
+        // any tasks still using them keep them alive until they are done
+        if ((local_shared_argument_bytes + arglen) > 
+            shared_argument_cache_size)
+        {
+          for (std::map<SharedArgumentKey,AllocManager*>::const_iterator it =
+                local_shared_arguments.begin(); it != 
+                local_shared_arguments.end(); it++)
+            if (it->second->remove_reference())
+              delete it->second;
+          local_shared_arguments.clear();
+          local_shared_argument_bytes = 0;
+        }
+        result->add_reference();
+        local_shared_arguments[key] = result;
+        local_shared_argument_bytes += arglen;
+      }
+      return result;
+    }
+
+    //--------------------------------------------------------------------------
+    AllocManager* Runtime::register_remote_shared_argument(uint64_t hash,
+                                          size_t arglen, Deserializer &derez)
+    //--------------------------------------------------------------------------
+    {
+      const SharedArgumentKey key(hash, arglen);
+      RtUserEvent to_trigger;
+      AllocManager *result = NULL;
+      {
+        AutoLock a_lock(shared_argument_lock);
+        std::map<SharedArgumentKey,AllocManager*>::const_iterator finder = 
+          remote_shared_arguments.find(key);
+        if (finder != remote_shared_arguments.end())
+        {
+          // Another node already sent us this buffer
+          derez.advance_pointer(arglen);
+          finder->second->add_reference();
+          return finder->second;
+        }
+        result = new AllocManager(arglen);
+        derez.deserialize(result->get_allocation(), arglen);
+        // One reference for the caller and one for the table
+        result->add_reference(2);
+        remote_shared_arguments[key] = result;
+        std::map<SharedArgumentKey,RtUserEvent>::iterator pending = 
+          pending_shared_arguments.find(key);
+        if (pending != pending_shared_arguments.end())
+        {
+          to_trigger = pending->second;
+          pending_shared_arguments.erase(pending);
+        }
+      }
+      if (to_trigger.exists())
+        Runtime::trigger_event(to_trigger);
+      return result;
+    }
+
+    //--------------------------------------------------------------------------
+    AllocManager* Runtime::find_remote_shared_argument(uint64_t hash, 
+                                                       size_t arglen)
+    //--------------------------------------------------------------------------
+    {
+      const SharedArgumentKey key(hash, arglen);
+      RtEvent wait_on;
+      {
+        AutoLock a_lock(shared_argument_lock);
+        std::map<SharedArgumentKey,AllocManager*>::const_iterator finder = 
+          remote_shared_arguments.find(key);
+        if (finder != remote_shared_arguments.end())
+        {
+          finder->second->add_reference();
+          return finder->second;
+        }
+        // The message with the buffer was sent on a different
+        // virtual channel and hasn't arrived yet so wait for it
+        std::map<SharedArgumentKey,RtUserEvent>::const_iterator pending = 
+          pending_shared_arguments.find(key);
+        if (pending == pending_shared_arguments.end())
+        {
+          RtUserEvent done = Runtime::create_rt_user_event();
+          pending_shared_arguments[key] = done;
+          wait_on = done;
+        }
+        else
+          wait_on = pending->second;
+      }
+      wait_on.lg_wait();
+      AutoLock a_lock(shared_argument_lock,1,false/*exclusive*/);
+      std::map<SharedArgumentKey,AllocManager*>::const_iterator finder = 
+        remote_shared_arguments.find(key);
+#ifdef DEBUG_LEGION
+      assert(finder != remote_shared_arguments.end());
+#endif
+      finder->second->add_reference();
+      return finder->second;
+    }
+
+    //--------------------------------------------------------------------------
+    bool Runtime::check_shared_argument_sent(AddressSpaceID target, 
+                                  uint64_t hash, size_t arglen, bool &pin)
+    //--------------------------------------------------------------------------
+    {
+      const SharedArgumentKey key(hash, arglen);
+      AutoLock a_lock(shared_argument_lock);
+      std::set<SharedArgumentKey> &sent = sent_shared_arguments[target];
+      if (sent.find(key) != sent.end())
+        return true;
+      // Each node pins what we send it so bound how much that is
+      size_t &sent_bytes = sent_shared_argument_bytes[target];
+      if ((sent_bytes + arglen) <= shared_argument_cache_size)
+      {
+        sent.insert(key);
+        sent_bytes += arglen;
+        pin = true;
+      }
+      else
+        pin = false;
+      return false;
+    }
+
+    //--------------------------------------------------------------------------
+    /*static*/ uint64_t Runtime::compute_argument_hash(const void *args,
+                                                       size_t arglen)
+    //--------------------------------------------------------------------------
+    {
+      // 64-bit murmur-style mixing of eight bytes at a time
+      const uint64_t m = 0xc6a4a7935bd1e995ULL;
+      uint64_t h = 0x8445d61a4e774912ULL ^ (arglen * m);
+      const uint8_t *bytes = static_cast<const uint8_t*>(args);
+      const size_t words = arglen / sizeof(uint64_t);
+      for (size_t idx = 0; idx < words; idx++)
+      {
+        uint64_t k;
+        memcpy(&k, bytes + idx * sizeof(uint64_t), sizeof(k));
+        k *= m;
+        k ^= k >> 47;
+        k *= m;
+        h ^= k;
+        h *= m;
+      }
+      const size_t remainder = arglen % sizeof(uint64_t);
+      if (remainder > 0)
+      {
+        uint64_t k = 0;
+        memcpy(&k, bytes + words * sizeof(uint64_t), remainder);
+        h ^= k;
+        h *= m;
+      }
+      h ^= h >> 47;
+      h *= m;
+      h ^= h >> 47;
+      return h;
+    }
     
     /*static*/ Runtime* Runtime::the_runtime = NULL;
     /*static*/ std::map<Processor,Runtime*>* Runtime::runtime_map = NULL;
@@ -18924,8 +20024,16 @@ namespace Legion {
     DEFAULT_MAX_MESSAGE_SIZE;
     /*static*/ unsigned Runtime::gc_epoch_size =
     DEFAULT_GC_EPOCH_SIZE;
+    /*static*/ unsigned Runtime::gc_slice_size =
+    DEFAULT_GC_SLICE_SIZE;
+    /*static*/ unsigned Runtime::gc_pause_target =
+    DEFAULT_GC_PAUSE_TARGET;
     /*static*/ unsigned Runtime::max_local_fields =
     DEFAULT_LOCAL_FIELDS;
+    /*static*/ unsigned Runtime::max_intersection_cache = 
+    DEFAULT_MAX_INTERSECTION_CACHE;
+    /*static*/ unsigned Runtime::auto_trace_window = 
+    DEFAULT_AUTO_TRACE_WINDOW;
     /*static*/ bool Runtime::runtime_started = false;
     /*static*/ bool Runtime::runtime_backgrounded = false;
     /*static*/ bool Runtime::runtime_warnings = false;
@@ -18943,7 +20051,20 @@ namespace Legion {
     /*static*/ bool Runtime::legion_spy_enabled = false;
     /*static*/ bool Runtime::enable_test_mapper = false;
     /*static*/ bool Runtime::legion_ldb_enabled = false;
+    /*static*/ bool Runtime::message_aggregation = true;
+    /*static*/ unsigned Runtime::channel_flush_delay[
+                                        MAX_NUM_VIRTUAL_CHANNELS];
+    /*static*/ unsigned Runtime::channel_flush_bytes[
+                                        MAX_NUM_VIRTUAL_CHANNELS];
+    /*static*/ unsigned Runtime::remote_reference_delay = 
+                                            DEFAULT_REMOTE_REFERENCE_DELAY;
+    /*static*/ unsigned Runtime::shared_argument_threshold = 
+                                          DEFAULT_SHARED_ARGUMENT_THRESHOLD;
+    /*static*/ unsigned Runtime::shared_argument_cache_size = 
+                                              DEFAULT_SHARED_ARGUMENT_CACHE;
     /*static*/ const char* Runtime::replay_file = NULL;
+    /*static*/ const char* Runtime::mapping_log_prefix = NULL;
+    /*static*/ bool Runtime::mapping_log_replay = false;
     /*static*/ int Runtime::legion_collective_radix =
     LEGION_COLLECTIVE_RADIX;
     /*static*/ int Runtime::legion_collective_log_radix = 0;
@@ -18957,6 +20078,13 @@ namespace Legion {
     /*static*/ std::vector<MPILegionHandshake>*
     Runtime::pending_handshakes = NULL;
     /*static*/ bool Runtime::program_order_execution = false;
+    /*static*/ bool Runtime::dependence_lanes = false;
+    /*static*/ bool Runtime::adaptive_task_window = false;
+    /*static*/ bool Runtime::replicate_top_level_task = false;
+    /*static*/ unsigned Runtime::point_mapping_chunk = 
+                                            DEFAULT_POINT_MAPPING_CHUNK;
+    /*static*/ unsigned Runtime::reduction_fold_threshold = 
+                                            DEFAULT_REDUCTION_FOLD_THRESHOLD;
 #ifdef DEBUG_LEGION
     /*static*/ bool Runtime::logging_region_tree_state = false;
     /*static*/ bool Runtime::verbose_logging = false;
@@ -18967,8 +20095,14 @@ namespace Legion {
     /*static*/ bool Runtime::bit_mask_logging = false;
 #endif
     /*static*/ unsigned Runtime::num_profiling_nodes = 0;
+    /*static*/ unsigned Runtime::prof_memory_interval = 
+    DEFAULT_PROF_MEMORY_INTERVAL;
     /*static*/ const char* Runtime::serializer_type = "binary";
     /*static*/ const char* Runtime::prof_logfile = NULL;
+    /*static*/ const char* Runtime::legion_spy_logfile = NULL;
+    /*static*/ unsigned Runtime::prof_footprint = 0;
+    /*static*/ unsigned Runtime::prof_sample_rate = DEFAULT_PROF_SAMPLE_RATE;
+    /*static*/ bool Runtime::prof_counters = false;
 #ifdef TRACE_ALLOCATION
     /*static*/ std::map<AllocationType,Runtime::AllocationTracker>
     Runtime::allocation_manager;
@@ -19054,18 +20188,49 @@ continue;					\
 #endif
         enable_test_mapper = false;
         legion_ldb_enabled = false;
+        message_aggregation = true;
+        // By default only semantic information is held back to be
+        // batched up, since nobody is usually waiting on it
+        for (unsigned idx = 0; idx < MAX_NUM_VIRTUAL_CHANNELS; idx++)
+        {
+          channel_flush_delay[idx] = 0;
+          channel_flush_bytes[idx] = 0;
+        }
+        channel_flush_delay[SEMANTIC_INFO_VIRTUAL_CHANNEL] = 
+          DEFAULT_SEMANTIC_FLUSH_DELAY;
+        channel_flush_bytes[SEMANTIC_INFO_VIRTUAL_CHANNEL] =
+          DEFAULT_SEMANTIC_FLUSH_BYTES;
+        remote_reference_delay = DEFAULT_REMOTE_REFERENCE_DELAY;
+        shared_argument_threshold = DEFAULT_SHARED_ARGUMENT_THRESHOLD;
+        shared_argument_cache_size = DEFAULT_SHARED_ARGUMENT_CACHE;
         replay_file = NULL;
+        mapping_log_prefix = NULL;
+        mapping_log_replay = false;
         initial_task_window_size = DEFAULT_MAX_TASK_WINDOW;
         initial_task_window_hysteresis = DEFAULT_TASK_WINDOW_HYSTERESIS;
         initial_tasks_to_schedule = DEFAULT_MIN_TASKS_TO_SCHEDULE;
         superscalar_width = DEFAULT_SUPERSCALAR_WIDTH;
         max_message_size = DEFAULT_MAX_MESSAGE_SIZE;
         gc_epoch_size = DEFAULT_GC_EPOCH_SIZE;
+        gc_slice_size = DEFAULT_GC_SLICE_SIZE;
+        gc_pause_target = DEFAULT_GC_PAUSE_TARGET;
         max_local_fields = DEFAULT_LOCAL_FIELDS;
+        max_intersection_cache = DEFAULT_MAX_INTERSECTION_CACHE;
+        auto_trace_window = DEFAULT_AUTO_TRACE_WINDOW;
         program_order_execution = false;
+        dependence_lanes = false;
+        adaptive_task_window = false;
+        replicate_top_level_task = false;
+        point_mapping_chunk = DEFAULT_POINT_MAPPING_CHUNK;
+        reduction_fold_threshold = DEFAULT_REDUCTION_FOLD_THRESHOLD;
         num_profiling_nodes = 0;
+        prof_memory_interval = DEFAULT_PROF_MEMORY_INTERVAL;
         serializer_type = "binary";
         prof_logfile = NULL;
+        legion_spy_logfile = NULL;
+        prof_footprint = 0;
+        prof_sample_rate = DEFAULT_PROF_SAMPLE_RATE;
+        prof_counters = false;
         legion_collective_radix = LEGION_COLLECTIVE_RADIX;
         legion_collective_log_radix = 0;
         legion_collective_stages = 0;
@@ -19094,15 +20259,51 @@ continue;					\
           if (!strcmp(argv[i],"-lg:safe_mapper"))
             unsafe_mapper = false;
           BOOL_ARG("-lg:inorder",program_order_execution);
+          BOOL_ARG("-lg:lanes",dependence_lanes);
+          BOOL_ARG("-lg:adaptive_window",adaptive_task_window);
+          BOOL_ARG("-lg:replicate",replicate_top_level_task);
           INT_ARG("-lg:window", initial_task_window_size);
           INT_ARG("-lg:hysteresis", initial_task_window_hysteresis);
           INT_ARG("-lg:sched", initial_tasks_to_schedule);
           INT_ARG("-lg:width", superscalar_width);
+          INT_ARG("-lg:point_chunk", point_mapping_chunk);
+          INT_ARG("-lg:fold_tree", reduction_fold_threshold);
           INT_ARG("-lg:message",max_message_size);
           INT_ARG("-lg:epoch", gc_epoch_size);
+          INT_ARG("-lg:gc_slice", gc_slice_size);
+          INT_ARG("-lg:gc_pause", gc_pause_target);
           INT_ARG("-lg:local", max_local_fields);
+          INT_ARG("-lg:intersect_cache", max_intersection_cache);
+          INT_ARG("-lg:auto_trace", auto_trace_window);
           if (!strcmp(argv[i],"-lg:no_dyn"))
             dynamic_independence_tests = false;
+          if (!strcmp(argv[i],"-lg:no_aggregate"))
+            message_aggregation = false;
+          if (!strcmp(argv[i],"-lg:batch"))
+          {
+            unsigned channel = atoi(argv[++i]);
+            unsigned delay = atoi(argv[++i]);
+            unsigned bytes = atoi(argv[++i]);
+            if (channel >= MAX_NUM_VIRTUAL_CHANNELS)
+            {
+              fprintf(stderr,"Illegal virtual channel %u for -lg:batch, "
+                             "must be less than %d\n", channel,
+                             MAX_NUM_VIRTUAL_CHANNELS);
+              assert(false);
+            }
+            channel_flush_delay[channel] = delay;
+            channel_flush_bytes[channel] = bytes;
+            continue;
+          }
+          if (!strcmp(argv[i],"-lg:no_batch"))
+          {
+            for (unsigned idx = 0; idx < MAX_NUM_VIRTUAL_CHANNELS; idx++)
+              channel_flush_delay[idx] = 0;
+            continue;
+          }
+          INT_ARG("-lg:ref_delay", remote_reference_delay);
+          INT_ARG("-lg:shared_args", shared_argument_threshold);
+          INT_ARG("-lg:shared_args_cache", shared_argument_cache_size);
           BOOL_ARG("-lg:spy",legion_spy_enabled);
           BOOL_ARG("-lg:test",enable_test_mapper);
           INT_ARG("-lg:delay", delay_start);
@@ -19117,6 +20318,18 @@ continue;					\
             legion_ldb_enabled = true;
             continue;
           }
+          if (!strcmp(argv[i],"-lg:record_mappings"))
+          {
+            mapping_log_prefix = argv[++i];
+            mapping_log_replay = false;
+            continue;
+          }
+          if (!strcmp(argv[i],"-lg:replay_mappings"))
+          {
+            mapping_log_prefix = argv[++i];
+            mapping_log_replay = true;
+            continue;
+          }
 #ifdef DEBUG_LEGION
           BOOL_ARG("-lg:tree",logging_region_tree_state);
           BOOL_ARG("-lg:verbose",verbose_logging);
@@ -19139,6 +20352,10 @@ continue;					\
           }
 #endif
           INT_ARG("-lg:prof", num_profiling_nodes);
+          INT_ARG("-lg:prof_memory", prof_memory_interval);
+          INT_ARG("-lg:prof_footprint", prof_footprint);
+          INT_ARG("-lg:prof_sample", prof_sample_rate);
+          BOOL_ARG("-lg:prof_counters", prof_counters);
           if (!strcmp(argv[i],"-lg:serializer"))
           {
             serializer_type = argv[++i];
@@ -19149,6 +20366,11 @@ continue;					\
             prof_logfile = argv[++i];
             continue;
           }
+          if (!strcmp(argv[i],"-lg:spy_logfile"))
+          {
+            legion_spy_logfile = argv[++i];
+            continue;
+          }
           
           // These are all the deprecated versions of these flag
           BOOL_ARG("-hl:separate",separate_runtime_instances);
@@ -19370,6 +20592,13 @@ continue;					\
 #endif
         exit(ERROR_TRACING_ALLOCATION_WITH_SEPARATE);
 #endif
+        if (replicate_top_level_task)
+        {
+          log_run.warning("Replicated top-level tasks are not supported "
+                          "with separate runtime instances. Only node 0 "
+                          "will run the top-level task.");
+          replicate_top_level_task = false;
+        }
         // Check for utility processors
         Machine::ProcessorQuery util_procs(machine);
         util_procs.local_address_space().only_kind(Processor::UTIL_PROC);
@@ -19421,8 +20650,9 @@ continue;					\
           exit(ERROR_MAXIMUM_PROCS_EXCEEDED);
         }
         AddressSpace local_space = local_procs.begin()->address_space();
-        // If we are node 0 then we have to launch the top-level task
-        if (local_space == 0)
+        // If we are node 0 then we have to launch the top-level task,
+        // and if it is replicated then every node launches a shard
+        if ((local_space == 0) || replicate_top_level_task)
         {
           local_procs.only_kind(Processor::LOC_PROC);
           // If we don't have one that is very bad
@@ -20073,6 +21303,11 @@ continue;					\
               LegionSpy::log_memory_kind(kind, "L1");
               break;
             }
+            case GPU_MANAGED_MEM:
+            {
+              LegionSpy::log_memory_kind(kind, "Managed");
+              break;
+            }
             default:
               assert(false); // unknown memory kind
           }
@@ -20249,6 +21484,12 @@ continue;					\
       LgTaskID tid = *((const LgTaskID*)data);
       data += sizeof(tid);
       arglen -= sizeof(tid);
+      // Profiled meta-tasks carry the operation they are charged to
+      // at the end of their arguments (see issue_runtime_meta_task)
+      const UniqueID previous_provenance = implicit_provenance;
+      if ((tid < LG_MESSAGE_ID) && (Runtime::get_runtime(p)->profiler != NULL))
+        memcpy(&implicit_provenance, data + arglen - sizeof(UniqueID),
+               sizeof(UniqueID));
       switch (tid)
       {
         case LG_SCHEDULER_ID:
@@ -20544,8 +21785,11 @@ continue;					\
                                                        vargs->context,
                                                        *(vargs->request_mask),
                                                        vargs->request_kind,
-                                                       vargs->to_trigger);
+                                                       vargs->to_trigger,
+                                                       vargs->skip_mask);
           delete (vargs->request_mask);
+          if (vargs->skip_mask != NULL)
+            delete (vargs->skip_mask);
           break;
         }
         case LG_ADD_TO_DEP_QUEUE_TASK_ID:
@@ -20761,6 +22005,14 @@ continue;					\
           margs->proxy_this->map_and_launch();
           break;
         }
+        case LG_MAP_SLICE_POINTS_TASK_ID:
+        {
+          const SliceTask::MapPointsArgs *margs =
+            (const SliceTask::MapPointsArgs*)args;
+          SliceTask::map_and_launch_points(*margs->points);
+          delete margs->points;
+          break;
+        }
         case LG_ADD_VERSIONING_SET_REF_TASK_ID:
         {
           const VersioningSetRefArgs *ref_args =
@@ -20802,6 +22054,32 @@ continue;					\
           PhiView::handle_deferred_view_registration(args);
           break;
         }
+        case LG_DEFER_CHANNEL_FLUSH_TASK_ID:
+        {
+          VirtualChannel::handle_deferred_flush(args, 
+                                                Runtime::get_runtime(p));
+          break;
+        }
+        case LG_DEFER_REFERENCE_FLUSH_TASK_ID:
+        {
+          Runtime::get_runtime(p)->process_deferred_reference_flush();
+          break;
+        }
+        case LG_DEFER_UNREGISTER_TASK_ID:
+        {
+          DistributedCollectable::handle_deferred_unregister(args);
+          break;
+        }
+        case LG_PREFETCH_INSTANCE_TASK_ID:
+        {
+          MemoryManager::handle_prefetch_instance(args);
+          break;
+        }
+        case LG_PROFILER_DRAIN_TASK_ID:
+        {
+          LegionProfiler::handle_drain(args);
+          break;
+        }
         case LG_RETRY_SHUTDOWN_TASK_ID:
         {
           const ShutdownManager::RetryShutdownArgs *shutdown_args =
@@ -20814,6 +22092,7 @@ continue;					\
         default:
           assert(false); // should never get here
       }
+      implicit_provenance = previous_provenance;
 #ifdef DEBUG_LEGION
       if (tid < LG_MESSAGE_ID)
         Runtime::get_runtime(p)->decrement_total_outstanding_tasks(tid, 
@@ -20964,6 +22243,55 @@ continue;					\
       cargs->continuation->execute();
     }
     
+    /*static*/ __thread LegionMemoryCounters::ThreadCounters*
+                                LegionMemoryCounters::local_counters = NULL;
+    /*static*/ LegionMemoryCounters::ThreadCounters *volatile
+                                LegionMemoryCounters::all_counters = NULL;
+
+    //--------------------------------------------------------------------------
+    /*static*/ LegionMemoryCounters::ThreadCounters* 
+                            LegionMemoryCounters::create_thread_counters(void)
+    //--------------------------------------------------------------------------
+    {
+      // Use calloc directly since we are called from inside the 
+      // allocation routines and these are never freed
+      ThreadCounters *result = 
+        static_cast<ThreadCounters*>(calloc(1, sizeof(ThreadCounters)));
+      assert(result != NULL);
+      // Push ourselves onto the global list of counters
+      while (true)
+      {
+        ThreadCounters *head = all_counters;
+        result->next = head;
+        if (__sync_bool_compare_and_swap(&all_counters, head, result))
+          break;
+      }
+      local_counters = result;
+      return result;
+    }
+
+    //--------------------------------------------------------------------------
+    /*static*/ void LegionMemoryCounters::snapshot(long long bytes[LAST_ALLOC],
+                                           long long allocations[LAST_ALLOC])
+    //--------------------------------------------------------------------------
+    {
+      for (unsigned idx = 0; idx < LAST_ALLOC; idx++)
+      {
+        bytes[idx] = 0;
+        allocations[idx] = 0;
+      }
+      for (ThreadCounters *counters = all_counters; 
+            counters != NULL; counters = counters->next)
+      {
+        for (unsigned idx = 0; idx < LAST_ALLOC; idx++)
+        {
+          bytes[idx] += *((volatile long long*)&counters->bytes[idx]);
+          allocations[idx] += 
+            *((volatile long long*)&counters->allocations[idx]);
+        }
+      }
+    }
+
 #ifdef TRACE_ALLOCATION
     //--------------------------------------------------------------------------
     /*static*/ void LegionAllocation::trace_allocation(
@@ -434,23 +434,11 @@ namespace Legion {
       MPIRankTable& operator=(const MPIRankTable &rhs);
     public:
       void perform_rank_exchange(void);
-      void handle_mpi_rank_exchange(Deserializer &derez);
-    protected:
-      bool send_explicit_stage(int stage);
-      bool send_ready_stages(void);
-      void unpack_exchange(int stage, Deserializer &derez);
-      void complete_exchange(void);
     public:
       Runtime *const runtime;
-      const bool participating;
     public:
       std::map<int,AddressSpace> forward_mapping;
       std::map<AddressSpace,int> reverse_mapping;
-    protected:
-      Reservation reservation;
-      RtUserEvent done_event;
-      std::vector<int> stage_notifications;
-      std::vector<bool> sent_stages;
     };
 
     /**
@@ -532,6 +520,9 @@ namespace Legion {
         { visible = visible_memories; }
     protected:
       void perform_mapping_operations(void);
+      void perform_batch_mapping(MapperManager *mapper,
+                                 const std::list<const Task*> &selected,
+                                 const Mapper::SelectMappingOutput &output);
       void issue_advertisements(MapperID mid);
     protected:
       void increment_active_contexts(void);
@@ -617,13 +608,59 @@ namespace Legion {
         InstanceInfo(void)
           : current_state(COLLECTABLE_STATE), 
             deferred_collect(RtUserEvent::NO_RT_USER_EVENT),
-            instance_size(0), min_priority(0) { }
+            instance_size(0), min_priority(0),
+            creator_mapper(0), creator_task(0),
+            last_use(0), use_count(0) { }
       public:
         InstanceState current_state;
         RtUserEvent deferred_collect;
         size_t instance_size;
         GCPriority min_priority;
         std::map<std::pair<MapperID,Processor>,GCPriority> mapper_priorities;
+        // Who the bytes of this instance are charged to
+        MapperID creator_mapper;
+        TaskID creator_task;
+        // Recency and frequency of use for the eviction policies
+        unsigned long long last_use;
+        unsigned use_count;
+      };
+      struct UsageInfo {
+      public:
+        UsageInfo(void)
+          : current_bytes(0), peak_bytes(0) { }
+      public:
+        size_t current_bytes;
+        size_t peak_bytes;
+      };
+      struct PrefetchInstanceArgs : public LgTaskArgs<PrefetchInstanceArgs> {
+      public:
+        static const LgTaskID TASK_ID = LG_PREFETCH_INSTANCE_TASK_ID;
+      public:
+        MemoryManager *manager;
+        LayoutConstraintSet *constraints;
+        std::vector<LogicalRegion> *regions;
+        MapperID mapper_id;
+        Processor processor;
+        GCPriority priority;
+        UniqueID creator_id;
+        TaskID task_id;
+      };
+      // A collected instance parked for reuse by a later
+      // request for an instance of exactly the same shape
+      struct PooledInstance {
+      public:
+        PooledInstance(void)
+          : instance(PhysicalInstance::NO_INST), block_size(0), 
+            redop(0), instance_size(0) { }
+      public:
+        PhysicalInstance instance;
+        Domain instance_domain;
+        std::vector<size_t> field_sizes;
+        size_t block_size;
+        ReductionOpID redop;
+        size_t instance_size;
+        // Precondition from the deletion of the last user
+        RtEvent ready;
       };
       template<bool SMALLER>
       struct CollectableInfo {
@@ -643,6 +680,20 @@ namespace Legion {
         size_t instance_size;
         GCPriority priority;
       };
+      // Ranking of an instance under one of the recency or 
+      // frequency based eviction policies
+      struct EvictionCandidate {
+      public:
+        bool operator<(const EvictionCandidate &rhs) const;
+      public:
+        PhysicalManager *manager;
+        size_t instance_size;
+        GCPriority priority;
+        // For ARC, whether it is on the list we drain second
+        bool drain_later;
+        unsigned long long rank;
+        unsigned long long last_use;
+      };
     public:
       MemoryManager(Memory mem, Runtime *rt);
       MemoryManager(const MemoryManager &rhs);
@@ -665,13 +716,13 @@ namespace Legion {
                                     MappingInstance &result, MapperID mapper_id,
                                     Processor processor, bool acquire, 
                                     GCPriority priority, UniqueID creator_id,
-                                    bool remote = false);
+                                    TaskID task_id, bool remote = false);
       bool create_physical_instance(LayoutConstraints *constraints,
                                     const std::vector<LogicalRegion> &regions,
                                     MappingInstance &result, MapperID mapper_id,
                                     Processor processor, bool acquire, 
                                     GCPriority priority, UniqueID creator_id,
-                                    bool remote = false);
+                                    TaskID task_id, bool remote = false);
       bool find_or_create_physical_instance(
                                     const LayoutConstraintSet &constraints,
                                     const std::vector<LogicalRegion> &regions,
@@ -679,7 +730,8 @@ namespace Legion {
                                     MapperID mapper_id, Processor processor,
                                     bool acquire, GCPriority priority, 
                                     bool tight_region_bounds,
-                                    UniqueID creator_id, bool remote = false);
+                                    UniqueID creator_id, TaskID task_id,
+                                    bool remote = false);
       bool find_or_create_physical_instance(
                                     LayoutConstraints *constraints,
                                     const std::vector<LogicalRegion> &regions,
@@ -687,7 +739,8 @@ namespace Legion {
                                     MapperID mapper_id, Processor processor,
                                     bool acquire, GCPriority priority, 
                                     bool tight_region_bounds,
-                                    UniqueID creator_id, bool remote = false);
+                                    UniqueID creator_id, TaskID task_id,
+                                    bool remote = false);
       bool find_physical_instance(  const LayoutConstraintSet &constraints,
                                     const std::vector<LogicalRegion> &regions,
                                     MappingInstance &result, bool acquire,
@@ -704,7 +757,16 @@ namespace Legion {
                                     std::vector<bool> &results);
       void record_created_instance( PhysicalManager *manager, bool acquire,
                                     MapperID mapper_id, Processor proc,
-                                    GCPriority priority, bool remote);
+                                    GCPriority priority, TaskID task_id,
+                                    bool remote);
+      // Find or make an instance in the background so it is ready
+      // by the time a mapper asks for it
+      void prefetch_instance(const LayoutConstraintSet &constraints,
+                             const std::vector<LogicalRegion> &regions,
+                             MapperID mapper_id, Processor processor,
+                             GCPriority priority, UniqueID creator_id,
+                             TaskID task_id);
+      static void handle_prefetch_instance(const void *args);
     public:
       void process_instance_request(Deserializer &derez, AddressSpaceID source);
       void process_instance_response(Deserializer &derez,AddressSpaceID source);
@@ -712,6 +774,39 @@ namespace Legion {
       void process_never_gc_response(Deserializer &derez);
       void process_acquire_request(Deserializer &derez, AddressSpaceID source);
       void process_acquire_response(Deserializer &derez);
+    public:
+      // Bytes currently allocated and the high-water mark for the
+      // instances created by a mapper or on behalf of a task kind
+      // (only tracked on the owner node of the memory)
+      void find_mapper_usage(MapperID mapper_id, 
+                             size_t &current_bytes, size_t &peak_bytes);
+      void find_task_usage(TaskID task_id,
+                           size_t &current_bytes, size_t &peak_bytes);
+    public:
+      // Recycling of collected instances, bounded by the mapper limit
+      void set_instance_pool_limit(size_t max_bytes);
+      PhysicalInstance find_pooled_instance(const Domain &instance_domain,
+                                  const std::vector<size_t> &field_sizes,
+                                  size_t block_size, ReductionOpID redop);
+      void record_pool_candidate(PhysicalInstance instance,
+                                 const Domain &instance_domain,
+                                 const std::vector<size_t> &field_sizes,
+                                 size_t block_size, ReductionOpID redop,
+                                 size_t instance_size);
+      bool recycle_instance(PhysicalInstance instance, RtEvent deferred_event);
+    public:
+      // Choose the order in which instances are collected to make space,
+      // and whether the memory is close to having to collect instances
+      // (both only meaningful on the owner node of the memory)
+      void set_eviction_policy(EvictionPolicy policy);
+      bool is_under_pressure(void);
+    protected:
+      // Destroy pooled instances until at most target_bytes remain
+      bool release_pooled_instances(size_t target_bytes);
+    protected:
+      // Must be called while holding the manager lock
+      void update_usage(const InstanceInfo &info, bool allocated);
+      void record_instance_use(InstanceInfo &info, bool new_use);
     protected:
       bool find_satisfying_instance(const LayoutConstraintSet &constraints,
                                     const std::vector<LogicalRegion> &regions,
@@ -754,6 +849,7 @@ namespace Legion {
                                     const std::set<PhysicalManager*> &cands,
                                     bool acquire, MapperID mapper_id, 
                                     Processor proc, GCPriority priority,
+                                    TaskID task_id,
                                     bool tight_region_bounds, bool remote);
       PhysicalManager* find_and_record(PhysicalManager *manager, 
                                     LayoutConstraints *constraints,
@@ -761,8 +857,10 @@ namespace Legion {
                                     const std::set<PhysicalManager*> &cands,
                                     bool acquire, MapperID mapper_id, 
                                     Processor proc, GCPriority priority,
+                                    TaskID task_id,
                                     bool tight_region_bounds, bool remote);
-      void record_deleted_instance(PhysicalManager *manager); 
+      void record_deleted_instance(PhysicalManager *manager, 
+                                   bool evicted = false); 
       void find_instances_by_state(size_t needed_size, InstanceState state, 
                      std::set<CollectableInfo<true> > &smaller_instances,
                      std::set<CollectableInfo<false> > &larger_instances) const;
@@ -770,6 +868,11 @@ namespace Legion {
       PhysicalManager* delete_and_allocate(InstanceBuilder &builder, 
                             size_t needed_size, size_t &total_bytes_deleted,
                       const std::set<CollectableInfo<SMALLER> > &instances);
+      void find_instances_by_policy(InstanceState state,
+                     std::vector<CollectableInfo<true> > &ordered) const;
+      PhysicalManager* delete_and_allocate(InstanceBuilder &builder, 
+                            size_t needed_size, size_t &total_bytes_deleted,
+                      const std::vector<CollectableInfo<true> > &ordered);
     public:
       // The memory that we are managing
       const Memory memory;
@@ -792,6 +895,23 @@ namespace Legion {
       // It is only valid on the owner node
       LegionMap<PhysicalManager*,InstanceInfo,
                 MEMORY_INSTANCES_ALLOC>::tracked current_instances;
+      // Usage accounting by creating mapper and task kind
+      std::map<MapperID,UsageInfo> mapper_usage;
+      std::map<TaskID,UsageInfo> task_usage;
+      // Instances that may be parked when collected and the
+      // parked instances themselves, oldest first
+      std::map<PhysicalInstance,PooledInstance> pool_candidates;
+      std::list<PooledInstance> instance_pool;
+      size_t pooled_bytes;
+      size_t pool_limit;
+      // Eviction policy state, uses are stamped with a logical clock
+      EvictionPolicy eviction_policy;
+      unsigned long long use_clock;
+      // Bytes ARC lets instances used only once hold before it starts
+      // draining them ahead of the frequently used ones
+      size_t arc_recent_target;
+      // Whether the last allocation had to make space
+      bool evicting;
     };
 
     /**
@@ -810,9 +930,16 @@ namespace Legion {
         PARTIAL_MESSAGE,
         FINAL_MESSAGE,
       };
+      struct DeferredFlushArgs : public LgTaskArgs<DeferredFlushArgs> {
+      public:
+        static const LgTaskID TASK_ID = LG_DEFER_CHANNEL_FLUSH_TASK_ID;
+      public:
+        VirtualChannel *channel;
+      };
     public:
       VirtualChannel(VirtualChannelKind kind,AddressSpaceID local_address_space,
-                     size_t max_message_size, LegionProfiler *profiler);
+                     size_t max_message_size, LegionProfiler *profiler,
+                     MessageManager *manager);
       VirtualChannel(const VirtualChannel &rhs);
       ~VirtualChannel(void);
     public:
@@ -824,9 +951,18 @@ namespace Legion {
       void process_message(const void *args, size_t arglen, 
                         Runtime *runtime, AddressSpaceID remote_address_space);
       void confirm_shutdown(ShutdownManager *shutdown_manager, bool phase_one);
+      void process_deferred_flush(Runtime *runtime);
+      // Send anything being held and return the event for the
+      // last message on this channel having been handled
+      RtEvent find_ordering_fence(Runtime *runtime, Processor target);
+    public:
+      static void handle_deferred_flush(const void *args, Runtime *runtime);
     private:
       void send_message(bool complete, Runtime *runtime, 
                         Processor target, bool response, bool shutdown);
+      void send_direct_message(Serializer &rez, MessageKind k,
+                               bool response, bool shutdown);
+      void hold_message(Runtime *runtime, Processor target, bool response);
       void handle_messages(unsigned num_messages, Runtime *runtime, 
                            AddressSpaceID remote_address_space,
                            const char *args, size_t arglen);
@@ -841,6 +977,14 @@ namespace Legion {
       MessageHeader header;
       unsigned packaged_messages;
       bool partial;
+      // State for holding flushed messages to batch them up
+      // until either the delay or the byte bound is reached
+      const long long flush_delay; // in nanoseconds, zero means no holding
+      const size_t flush_bytes;
+      long long flush_deadline; // zero when nothing is being held
+      Processor held_target;
+      bool held_response;
+      bool flush_pending;
       // State for receiving messages
       // No lock for receiving messages since we know
       // that they are ordered
@@ -851,6 +995,7 @@ namespace Legion {
       bool observed_recent;
     private:
       LegionProfiler *const profiler;
+      MessageManager *const manager;
     }; 
 
     /**
@@ -887,6 +1032,17 @@ namespace Legion {
       void receive_message(const void *args, size_t arglen);
       void confirm_shutdown(ShutdownManager *shutdown_manager,
                             bool phase_one);
+      RtEvent find_ordering_fence(VirtualChannelKind channel);
+    public:
+      // Called by the virtual channels with their send lock held
+      RtEvent send_full_message(const char *buffer, size_t size,
+                                RtEvent precondition, 
+                                bool response, bool shutdown);
+      RtEvent spawn_message(const char *buffer, size_t size,
+                            RtEvent precondition, 
+                            bool response, bool shutdown);
+    protected:
+      void send_aggregated_messages(void);
     public:
       const AddressSpaceID remote_address_space;
     private:
@@ -894,6 +1050,20 @@ namespace Legion {
       // State for sending messages
       Processor target;
       VirtualChannel *const channels; 
+    private:
+      // Full messages from different channels that are flushed while
+      // another thread is sending to this node are combined into a 
+      // single message that the sending thread sends when it is done
+      Reservation aggregate_lock;
+      bool sending_active;
+      char *aggregate_buffer;
+      char *spare_aggregate_buffer;
+      size_t aggregate_index;
+      const size_t aggregate_buffer_size;
+      unsigned aggregate_count;
+      RtUserEvent aggregate_done;
+      std::set<RtEvent> aggregate_preconditions;
+      bool aggregate_response, aggregate_shutdown;
     };
 
     /**
@@ -952,7 +1122,10 @@ namespace Legion {
 
     /**
      * \class GarbageCollectionEpoch
-     * A class for managing the a set of garbage collections
+     * A class for managing the a set of garbage collections.
+     * The views of an epoch are collected incrementally in 
+     * slices of background meta-tasks so that no one task
+     * runs for much longer than the GC pause target.
      */
     class GarbageCollectionEpoch {
     public:
@@ -961,7 +1134,8 @@ namespace Legion {
         static const LgTaskID TASK_ID = LG_DEFERRED_COLLECT_ID;
       public:
         GarbageCollectionEpoch *epoch;
-        LogicalView *view;
+        // Range [first,last) of entries in the epoch's views
+        unsigned first, last;
       };
     public:
       GarbageCollectionEpoch(Runtime *runtime);
@@ -978,6 +1152,10 @@ namespace Legion {
       Runtime *const runtime;
       int remaining;
       std::map<LogicalView*,std::set<ApEvent> > collections;
+      // Collections in the order that they are sliced, fixed at launch
+      std::vector<std::pair<LogicalView*,std::set<ApEvent>*> > views;
+      // Triggered once every slice, including yielded ones, is done
+      RtUserEvent done_event;
     };
 
     /**
@@ -1129,6 +1307,7 @@ namespace Legion {
       // VariantIDs that we've handed out but haven't registered yet
       std::set<VariantID> pending_variants;
       std::map<SemanticTag,SemanticInfo> semantic_infos;
+      std::map<SemanticTag,RtUserEvent> semantic_requests;
       // Track whether all these variants have a return type or not
       bool has_return_type;
       // Track whether all these variants are idempotent or not
@@ -1167,7 +1346,8 @@ namespace Legion {
     public:
       ApEvent dispatch_task(Processor target, SingleTask *task, 
           TaskContext *ctx, ApEvent precondition, PredEvent pred,
-          int priority, Realm::ProfilingRequestSet &requests);
+          int priority, Realm::ProfilingRequestSet &requests,
+          Realm::SpawnBatch *batch = NULL);
       void dispatch_inline(Processor current, InlineContext *ctx);
     public:
       Processor::Kind get_processor_kind(bool warn) const;
@@ -1424,6 +1604,21 @@ namespace Legion {
         TaskContext *ctx;
         FutureImpl *result;
       }; 
+      struct DeferredReferenceFlushArgs : 
+        public LgTaskArgs<DeferredReferenceFlushArgs> {
+      public:
+        static const LgTaskID TASK_ID = LG_DEFER_REFERENCE_FLUSH_TASK_ID;
+      };
+    public:
+      struct PendingRemoteReferences {
+      public:
+        PendingRemoteReferences(void)
+          : gc_references(0), valid_references(0), resource_references(0) { }
+      public:
+        unsigned gc_references;
+        unsigned valid_references;
+        unsigned resource_references;
+      };
     public:
       struct ProcessorGroupInfo {
       public:
@@ -1829,6 +2024,11 @@ namespace Legion {
     public:
       Mapper* get_mapper(Context ctx, MapperID id, Processor target);
       Processor get_executing_processor(Context ctx);
+      unsigned get_num_shards(Context ctx);
+      unsigned get_shard_id(Context ctx);
+      Domain get_shard_domain(Context ctx, const Domain &launch_domain);
+      size_t get_runtime_memory_usage(std::map<std::string,size_t> *by_kind);
+      void record_runtime_memory_usage(void);
       void raise_region_exception(Context ctx, PhysicalRegion region, 
                                   bool nuclear);
     public:
@@ -1922,11 +2122,24 @@ namespace Legion {
       // Memory manager functions
       MemoryManager* find_memory_manager(Memory mem);
       AddressSpaceID find_address_space(Memory handle) const;
+    public:
+      // Hold back the removal of remote references so they can either
+      // cancel out with later additions or be sent together in batches
+      void defer_remote_reference_removal(AddressSpaceID target,
+                DistributedID did, ReferenceKind kind, unsigned count);
+      unsigned cancel_remote_reference_removal(AddressSpaceID target,
+                DistributedID did, ReferenceKind kind, unsigned count);
+      void process_deferred_reference_flush(void);
     public:
       // Messaging functions
       MessageManager* find_messenger(AddressSpaceID sid);
       MessageManager* find_messenger(Processor target);
       AddressSpaceID find_address_space(Processor target) const;
+      // Event for all messages sent so far to the target on the
+      // virtual channel having been handled, for anything that 
+      // needs to be ordered behind them without going on the channel
+      RtEvent find_message_fence(AddressSpaceID target, 
+                                 VirtualChannelKind vc);
     public:
       void process_mapper_message(Processor target, MapperID map_id,
                                   Processor source, const void *message, 
@@ -1999,10 +2212,12 @@ namespace Legion {
       void send_slice_remote_complete(Processor target, Serializer &rez);
       void send_slice_remote_commit(Processor target, Serializer &rez);
       void send_did_remote_registration(AddressSpaceID target, Serializer &rez);
-      void send_did_remote_valid_update(AddressSpaceID target, Serializer &rez);
-      void send_did_remote_gc_update(AddressSpaceID target, Serializer &rez);
+      void send_did_remote_valid_update(AddressSpaceID target, 
+                                        Serializer &rez, bool flush = true);
+      void send_did_remote_gc_update(AddressSpaceID target, 
+                                     Serializer &rez, bool flush = true);
       void send_did_remote_resource_update(AddressSpaceID target,
-                                           Serializer &rez);
+                                        Serializer &rez, bool flush = true);
       void send_did_add_create_reference(AddressSpaceID target,Serializer &rez);
       void send_did_remove_create_reference(AddressSpaceID target,
                                             Serializer &rez, bool flush = true);
@@ -2098,7 +2313,6 @@ namespace Legion {
       void send_constraint_response(AddressSpaceID target, Serializer &rez);
       void send_constraint_release(AddressSpaceID target, Serializer &rez);
       void send_constraint_removal(AddressSpaceID target, Serializer &rez);
-      void send_mpi_rank_exchange(AddressSpaceID target, Serializer &rez);
       void send_shutdown_notification(AddressSpaceID target, Serializer &rez);
       void send_shutdown_response(AddressSpaceID target, Serializer &rez);
     public:
@@ -2277,7 +2491,6 @@ namespace Legion {
       void handle_constraint_removal(Deserializer &derez);
       void handle_top_level_task_request(Deserializer &derez);
       void handle_top_level_task_complete(Deserializer &derez);
-      void handle_mpi_rank_exchange(Deserializer &derez);
       void handle_shutdown_notification(Deserializer &derez, 
                                         AddressSpaceID source);
       void handle_shutdown_response(Deserializer &derez);
@@ -2287,27 +2500,31 @@ namespace Legion {
                                     const std::vector<LogicalRegion> &regions,
                                     MappingInstance &result, MapperID mapper_id,
                                     Processor processor, bool acquire, 
-                                    GCPriority priority, UniqueID creator_id);
+                                    GCPriority priority, UniqueID creator_id,
+                                    TaskID task_id);
       bool create_physical_instance(Memory target_memory, 
                                     LayoutConstraintID layout_id,
                                     const std::vector<LogicalRegion> &regions,
                                     MappingInstance &result, MapperID mapper_id,
                                     Processor processor, bool acquire, 
-                                    GCPriority priority, UniqueID creator_id);
+                                    GCPriority priority, UniqueID creator_id,
+                                    TaskID task_id);
       bool find_or_create_physical_instance(Memory target_memory,
                                     const LayoutConstraintSet &constraints,
                                     const std::vector<LogicalRegion> &regions,
                                     MappingInstance &result, bool &created, 
                                     MapperID mapper_id, Processor processor,
                                     bool acquire, GCPriority priority,
-                                    bool tight_bounds, UniqueID creator_id);
+                                    bool tight_bounds, UniqueID creator_id,
+                                    TaskID task_id);
       bool find_or_create_physical_instance(Memory target_memory,
                                     LayoutConstraintID layout_id,
                                     const std::vector<LogicalRegion> &regions,
                                     MappingInstance &result, bool &created, 
                                     MapperID mapper_id, Processor processor,
                                     bool acquire, GCPriority priority,
-                                    bool tight_bounds, UniqueID creator_id);
+                                    bool tight_bounds, UniqueID creator_id,
+                                    TaskID task_id);
       bool find_physical_instance(Memory target_memory,
                                     const LayoutConstraintSet &constraints,
                                     const std::vector<LogicalRegion> &regions,
@@ -2407,7 +2624,27 @@ namespace Legion {
                               std::deque<T*> &queue, bool has_lock);
 
       template<bool CAN_BE_DELETED, typename T>
-      inline void release_operation(std::deque<T*> &queue, T* operation);
+      inline void release_operation(Reservation reservation,
+                                    std::deque<T*> &queue, T* operation);
+    protected:
+      // Each thread keeps a small cache of free operations of each
+      // kind so that it only has to take the reservation for the
+      // shared list once for every batch of operations
+      template<typename T>
+      struct OperationCache {
+      public:
+        T *operations[LEGION_OPERATION_CACHE_SIZE];
+        unsigned size;
+      };
+      template<typename T>
+      static inline OperationCache<T>& get_operation_cache(void);
+      template<typename T>
+      inline bool has_cached_operation(void) const;
+      template<typename T>
+      inline void refill_operation_cache(Reservation reservation,
+                                         std::deque<T*> &queue);
+      template<bool CAN_BE_DELETED, typename T>
+      inline void return_operation(std::deque<T*> &queue, T* operation);
     public:
       IndividualTask*       get_available_individual_task(bool need_cont,
                                                   bool has_lock = false);
@@ -2536,6 +2773,7 @@ namespace Legion {
       FieldSpaceID       get_unique_field_space_id(void);
       IndexTreeID        get_unique_index_tree_id(void);
       RegionTreeID       get_unique_region_tree_id(void);
+      void               free_region_tree_id(RegionTreeID tid);
       UniqueID           get_unique_operation_id(void);
       FieldID            get_unique_field_id(void);
       CodeDescriptorID   get_unique_code_descriptor_id(void);
@@ -2551,12 +2789,13 @@ namespace Legion {
       bool help_reset_future(const Future &f);
     public:
       unsigned generate_random_integer(void);
+    public:
+      static const char* get_allocation_name(AllocationType type);
 #ifdef TRACE_ALLOCATION
     public:
       void trace_allocation(AllocationType type, size_t size, int elems);
       void trace_free(AllocationType type, size_t size, int elems);
       void dump_allocation_info(void);
-      static const char* get_allocation_name(AllocationType type);
 #endif
     public:
       // These are the static methods that become the meta-tasks
@@ -2613,6 +2852,8 @@ namespace Legion {
       const unsigned total_address_spaces;
       const unsigned runtime_stride; // stride for uniqueness
       LegionProfiler *profiler;
+      // Next time in microseconds to sample runtime memory usage
+      volatile unsigned long long next_memory_sample;
       RegionTreeForest *const forest;
       Processor utility_group;
       const bool has_explicit_utility_procs;
@@ -2645,6 +2886,12 @@ namespace Legion {
       std::map<Memory,MemoryManager*> memory_managers;
       // Message managers for each of the other runtimes
       MessageManager *message_managers[MAX_NUM_NODES];
+      // Remote reference removals that have not been sent yet
+      Reservation remote_reference_lock;
+      std::map<AddressSpaceID,std::map<DistributedID,
+               PendingRemoteReferences> > pending_remote_references;
+      long long remote_reference_deadline; // zero when nothing is pending
+      bool remote_reference_flush_pending;
       // For every processor map it to its address space
       const std::map<Processor,AddressSpaceID> proc_spaces;
     protected:
@@ -2657,6 +2904,20 @@ namespace Legion {
       Reservation layout_constraints_lock;
       std::map<LayoutConstraintID,LayoutConstraints*> layout_constraints_table;
       std::map<LayoutConstraintID,RtEvent> pending_constraint_requests;
+    protected:
+      // Shared task argument buffers keyed by content hash and size
+      typedef std::pair<uint64_t,size_t> SharedArgumentKey;
+      Reservation shared_argument_lock;
+      std::map<SharedArgumentKey,AllocManager*> local_shared_arguments;
+      size_t local_shared_argument_bytes;
+      // Buffers sent to us by other nodes which must stay pinned
+      // since the senders will only send us their hashes from now on
+      std::map<SharedArgumentKey,AllocManager*> remote_shared_arguments;
+      std::map<SharedArgumentKey,RtUserEvent> pending_shared_arguments;
+      // Buffers we have sent to each of the other nodes
+      std::map<AddressSpaceID,std::set<SharedArgumentKey> > 
+                                                    sent_shared_arguments;
+      std::map<AddressSpaceID,size_t> sent_shared_argument_bytes;
     protected:
       struct MapperInfo {
         MapperInfo(void)
@@ -2698,6 +2959,10 @@ namespace Legion {
     protected:
       Reservation processor_mapping_lock;
       std::map<Processor,unsigned> processor_mapping;
+    protected:
+      Reservation region_tree_id_lock;
+      // Tree IDs of reclaimed region trees with their generation bumped
+      std::deque<RegionTreeID> available_region_tree_ids;
     protected:
       Reservation distributed_id_lock;
       DistributedID unique_distributed_id;
@@ -2705,8 +2970,8 @@ namespace Legion {
           RUNTIME_DISTRIBUTED_ALLOC>::tracked available_distributed_ids;
     protected:
       Reservation distributed_collectable_lock;
-      LegionMap<DistributedID,DistributedCollectable*,
-                RUNTIME_DIST_COLLECT_ALLOC>::tracked dist_collectables;
+      LegionHashMap<DistributedID,DistributedCollectable*,
+                    RUNTIME_DIST_COLLECT_ALLOC>::tracked dist_collectables;
       std::map<DistributedID,
         std::pair<DistributedCollectable*,RtUserEvent> > pending_collectables;
     protected:
@@ -2852,6 +3117,19 @@ namespace Legion {
       const char* get_layout_constraints_name(LayoutConstraintID layout_id);
       LayoutConstraints* find_layout_constraints(LayoutConstraintID layout_id,
                                                  bool can_fail = false);
+    public:
+      // Shared immutable buffers for large task arguments, each of
+      // these returns a manager with a reference added for the caller
+      AllocManager* find_or_create_shared_argument(const void *args,
+                                             size_t arglen, uint64_t &hash);
+      AllocManager* register_remote_shared_argument(uint64_t hash,
+                                       size_t arglen, Deserializer &derez);
+      AllocManager* find_remote_shared_argument(uint64_t hash, size_t arglen);
+      // Returns true if the target already has the buffer, otherwise
+      // records whether the target should pin the buffer we send it
+      bool check_shared_argument_sent(AddressSpaceID target, uint64_t hash,
+                                      size_t arglen, bool &pin);
+      static uint64_t compute_argument_hash(const void *args, size_t arglen);
     public:
       // Static methods for start-up and callback phases
       static int start(int argc, char **argv, bool background);
@@ -2907,7 +3185,11 @@ namespace Legion {
       static unsigned superscalar_width;
       static unsigned max_message_size;
       static unsigned gc_epoch_size;
+      static unsigned gc_slice_size;
+      static unsigned gc_pause_target;
       static unsigned max_local_fields;
+      static unsigned max_intersection_cache;
+      static unsigned auto_trace_window;
       static bool runtime_started;
       static bool runtime_backgrounded;
       static bool runtime_warnings;
@@ -2921,7 +3203,15 @@ namespace Legion {
       static bool legion_spy_enabled;
       static bool enable_test_mapper;
       static bool legion_ldb_enabled;
+      static bool message_aggregation;
+      static unsigned channel_flush_delay[MAX_NUM_VIRTUAL_CHANNELS];
+      static unsigned channel_flush_bytes[MAX_NUM_VIRTUAL_CHANNELS];
+      static unsigned remote_reference_delay;
+      static unsigned shared_argument_threshold;
+      static unsigned shared_argument_cache_size;
       static const char* replay_file;
+      static const char* mapping_log_prefix;
+      static bool mapping_log_replay;
       // Collective settings
       static int legion_collective_radix;
       static int legion_collective_log_radix;
@@ -2943,10 +3233,22 @@ namespace Legion {
       static bool bit_mask_logging;
 #endif
       static bool program_order_execution;
+      static bool dependence_lanes;
+      static bool adaptive_task_window;
+      static bool replicate_top_level_task;
+      static unsigned point_mapping_chunk;
+      static unsigned reduction_fold_threshold;
     public:
       static unsigned num_profiling_nodes;
+      static unsigned prof_memory_interval;
+      // Cap in MB on buffered profiling records (0 means unbounded)
+      static unsigned prof_footprint;
+      static unsigned prof_sample_rate;
+      // Collect hardware performance counters for each task
+      static bool prof_counters;
       static const char* serializer_type;
       static const char* prof_logfile;
+      static const char* legion_spy_logfile;
     public:
       static inline ApEvent merge_events(ApEvent e1, ApEvent e2);
       static inline ApEvent merge_events(ApEvent e1, ApEvent e2, ApEvent e3);
@@ -2965,6 +3267,12 @@ namespace Legion {
       static inline void trigger_event(RtUserEvent to_trigger,
                                    RtEvent precondition = RtEvent::NO_RT_EVENT);
       static inline void poison_event(RtUserEvent to_poison);
+      // Share requests for remote information that are still in flight
+      // so that only the first of several concurrent lookups for the
+      // same key sends a message, 'request' is only set if it must send
+      template<typename T>
+      static inline RtEvent find_or_create_pending_request(
+          std::map<T,RtUserEvent> &pending, const T &key, RtUserEvent &request);
     public:
       static inline PredEvent create_pred_event(void);
       static inline void trigger_event(PredEvent to_trigger);
@@ -3100,7 +3408,19 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       T *result = NULL;
-      if (!has_lock)
+      // Separate runtime instances can't share operations through
+      // the thread caches since each operation belongs to one runtime
+      if (!has_lock && !separate_runtime_instances)
+      {
+        OperationCache<T> &cache = get_operation_cache<T>();
+        if (cache.size == 0)
+          refill_operation_cache(reservation, queue);
+        // Refilling might have switched threads so look again
+        OperationCache<T> &refilled = get_operation_cache<T>();
+        if (refilled.size > 0)
+          result = refilled.operations[--refilled.size];
+      }
+      else if (!has_lock)
       {
         AutoLock r_lock(reservation);
         if (!queue.empty())
@@ -3129,7 +3449,91 @@ namespace Legion {
 
     //--------------------------------------------------------------------------
     template<bool CAN_BE_DELETED, typename T>
-    inline void Runtime::release_operation(std::deque<T*> &queue, T* operation)
+    inline void Runtime::release_operation(Reservation reservation,
+                                        std::deque<T*> &queue, T* operation)
+    //--------------------------------------------------------------------------
+    {
+      if (!separate_runtime_instances)
+      {
+        OperationCache<T> &cache = get_operation_cache<T>();
+        if (cache.size < LEGION_OPERATION_CACHE_SIZE)
+        {
+          cache.operations[cache.size++] = operation;
+          return;
+        }
+        // The cache is full so give half of it back to the shared list
+        // along with this operation under a single reservation
+        T *batch[LEGION_OPERATION_CACHE_SIZE/2];
+        unsigned count = 0;
+        while (count < (LEGION_OPERATION_CACHE_SIZE/2))
+          batch[count++] = cache.operations[--cache.size];
+        AutoLock r_lock(reservation);
+        for (unsigned idx = 0; idx < count; idx++)
+          return_operation<CAN_BE_DELETED>(queue, batch[idx]);
+        return_operation<CAN_BE_DELETED>(queue, operation);
+        return;
+      }
+      AutoLock r_lock(reservation);
+      return_operation<CAN_BE_DELETED>(queue, operation);
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename T>
+    /*static*/ inline Runtime::OperationCache<T>& 
+                                          Runtime::get_operation_cache(void)
+    //--------------------------------------------------------------------------
+    {
+      static __thread OperationCache<T> cache;
+      return cache;
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename T>
+    inline bool Runtime::has_cached_operation(void) const
+    //--------------------------------------------------------------------------
+    {
+      // If we have one in our cache we won't need a continuation
+      // to wait for the reservation without blocking
+      if (separate_runtime_instances)
+        return false;
+      return (get_operation_cache<T>().size > 0);
+    }
+
+    //--------------------------------------------------------------------------
+    template<typename T>
+    inline void Runtime::refill_operation_cache(Reservation reservation,
+                                                std::deque<T*> &queue)
+    //--------------------------------------------------------------------------
+    {
+      T *batch[LEGION_OPERATION_CACHE_SIZE/2];
+      unsigned count = 0;
+      {
+        AutoLock r_lock(reservation);
+        while (!queue.empty() && (count < (LEGION_OPERATION_CACHE_SIZE/2)))
+        {
+          batch[count++] = queue.front();
+          queue.pop_front();
+        }
+      }
+      if (count == 0)
+        return;
+      // Waiting for the reservation can resume us on a different
+      // thread so only look up the cache once we have the batch
+      OperationCache<T> &cache = get_operation_cache<T>();
+      unsigned idx = 0;
+      while ((idx < count) && (cache.size < LEGION_OPERATION_CACHE_SIZE))
+        cache.operations[cache.size++] = batch[idx++];
+      if (idx < count)
+      {
+        AutoLock r_lock(reservation);
+        while (idx < count)
+          queue.push_front(batch[idx++]);
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    template<bool CAN_BE_DELETED, typename T>
+    inline void Runtime::return_operation(std::deque<T*> &queue, T* operation)
     //--------------------------------------------------------------------------
     {
       if (CAN_BE_DELETED && (queue.size() == LEGION_MAX_RECYCLABLE_OBJECTS))
@@ -3170,8 +3574,14 @@ namespace Legion {
       if ((T::TASK_ID < LG_MESSAGE_ID) && (profiler != NULL))
       {
         Realm::ProfilingRequestSet requests;
-        profiler->add_meta_request(requests, T::TASK_ID, op);
-        return RtEvent(target.spawn(LG_TASK_ID, &args, sizeof(T),
+        const UniqueID provenance = 
+          profiler->add_meta_request(requests, T::TASK_ID, op);
+        // Pass the provenance after the arguments so the meta-task can 
+        // hand it on to any meta-tasks that it launches in turn
+        char buffer[sizeof(T) + sizeof(provenance)];
+        memcpy(buffer, &args, sizeof(T));
+        memcpy(buffer + sizeof(T), &provenance, sizeof(provenance));
+        return RtEvent(target.spawn(LG_TASK_ID, buffer, sizeof(buffer),
                                     requests, precondition, priority));
       }
       else
@@ -3346,6 +3756,21 @@ namespace Legion {
 #endif
     }
 
+    //--------------------------------------------------------------------------
+    template<typename T>
+    /*static*/ inline RtEvent Runtime::find_or_create_pending_request(
+          std::map<T,RtUserEvent> &pending, const T &key, RtUserEvent &request)
+    //--------------------------------------------------------------------------
+    {
+      typename std::map<T,RtUserEvent>::iterator finder = pending.find(key);
+      // Requests that have already been answered are replaced lazily
+      if ((finder != pending.end()) && !finder->second.has_triggered())
+        return finder->second;
+      request = create_rt_user_event();
+      pending[key] = request;
+      return request;
+    }
+
     //--------------------------------------------------------------------------
     /*static*/ inline void Runtime::trigger_event(RtUserEvent to_trigger,
                                                   RtEvent precondition) 
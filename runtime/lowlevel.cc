@@ -88,14 +88,14 @@ namespace LegionRuntime {
 
 	  // print anything with either local or remote waiters
 	  if(e->current_local_waiters.empty() &&
-	     e->future_local_waiters.empty() &&
+	     !e->remote_state &&
 	     e->remote_waiters.empty())
 	    continue;
 
 	  os << "Event " << e->me <<": gen=" << e->generation
 	     << " subscr=" << e->gen_subscribed
 	     << " local=" << e->current_local_waiters.size()
-	     << "+" << e->future_local_waiters.size()
+	     << "+" << (e->remote_state ? e->remote_state->future_local_waiters.size() : 0)
 	     << " remote=" << e->remote_waiters.size() << "\n";
 	  for(std::vector<EventWaiter *>::const_iterator it = e->current_local_waiters.begin();
 	      it != e->current_local_waiters.end();
@@ -104,15 +104,17 @@ namespace LegionRuntime {
 	    (*it)->print(os);
 	    os << "\n";
 	  }
-	  for(std::map<EventImpl::gen_t, std::vector<EventWaiter *> >::const_iterator it = e->future_local_waiters.begin();
-	      it != e->future_local_waiters.end();
-	      it++) {
-	    for(std::vector<EventWaiter *>::const_iterator it2 = it->second.begin();
+	  if(e->remote_state) {
+	    for(std::map<EventImpl::gen_t, std::vector<EventWaiter *> >::const_iterator it = e->remote_state->future_local_waiters.begin();
+	        it != e->remote_state->future_local_waiters.end();
+	        it++) {
+	      for(std::vector<EventWaiter *>::const_iterator it2 = it->second.begin();
 		it2 != it->second.end();
 		it2++) {
-	      os << "  [" << (it->first) << "] L:" << (*it2) << " - ";
-	      (*it2)->print(os);
-	      os << "\n";
+	        os << "  [" << (it->first) << "] L:" << (*it2) << " - ";
+	        (*it2)->print(os);
+	        os << "\n";
+	      }
 	    }
 	  }
 	  // for(std::map<Event::gen_t, NodeMask>::const_iterator it = e->remote_waiters.begin();
@@ -70,6 +70,7 @@ typedef enum legion_lowlevel_memory_kind_t {
   LEVEL3_CACHE, // CPU L3 Visible to all processors on the node, better performance to processors on same socket 
   LEVEL2_CACHE, // CPU L2 Visible to all processors on the node, better performance to one processor
   LEVEL1_CACHE, // CPU L1 Visible to all processors on the node, better performance to one processor
+  GPU_MANAGED_MEM, // Managed memory visible to all CPUs within a node and one or more GPUs, migrated on demand
 } legion_lowlevel_memory_kind_t;
 
 typedef enum legion_lowlevel_file_mode_t {
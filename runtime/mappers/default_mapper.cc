@@ -17,16 +17,29 @@
 #include "default_mapper.h"
 #include "logger_message_descriptor.h"
 
+#include <cstdio>
 #include <cstdlib>
 #include <cassert>
 #include <limits.h>
+#include <float.h>
 #include <algorithm>
 
 #define STATIC_MAX_PERMITTED_STEALS   4
 #define STATIC_MAX_STEAL_COUNT        2
 #define STATIC_BREADTH_FIRST          false
 #define STATIC_STEALING_ENABLED       false
+#define STATIC_STEAL_LOCALITY_BYTES   (1 << 20)
+#define STATIC_CONCURRENT_MAPPING     false
+#define STATIC_BATCH_MAPPING          false
+#define STATIC_SPILL_UNDER_PRESSURE   false
+#define STATIC_PREFETCH               false
 #define STATIC_MAX_SCHEDULE_COUNT     8
+#define STATIC_SLICE_FANOUT           0
+#define STATIC_SPECULATE              false
+#define STATIC_LOCALITY_SLICING       false
+#define STATIC_LOCALITY_TOLERANCE     10
+#define STATIC_ADAPTIVE               false
+#define STATIC_LEARN_SAMPLES          2
 
 // This is the default implementation of the mapper interface for 
 // the general low level runtime
@@ -68,7 +81,22 @@ namespace Legion {
         max_steal_count(STATIC_MAX_STEAL_COUNT),
         breadth_first_traversal(STATIC_BREADTH_FIRST),
         stealing_enabled(STATIC_STEALING_ENABLED),
-        max_schedule_count(STATIC_MAX_SCHEDULE_COUNT)
+        concurrent_mapping(STATIC_CONCURRENT_MAPPING),
+        batch_mapping(STATIC_BATCH_MAPPING),
+        spill_under_pressure(STATIC_SPILL_UNDER_PRESSURE),
+        prefetch_enabled(STATIC_PREFETCH),
+        steal_locality_bytes(STATIC_STEAL_LOCALITY_BYTES),
+        max_schedule_count(STATIC_MAX_SCHEDULE_COUNT),
+        slice_fanout(STATIC_SLICE_FANOUT),
+        speculation_enabled(STATIC_SPECULATE),
+        locality_slicing(STATIC_LOCALITY_SLICING),
+        locality_tolerance(STATIC_LOCALITY_TOLERANCE),
+        adaptive_mapping(STATIC_ADAPTIVE),
+        learn_samples(STATIC_LEARN_SAMPLES),
+        local_queue_depth(0), advertised_queue_class(0), 
+        saw_ready_tasks(false), steal_requests_sent(0), 
+        stolen_tasks_mapped(0), steal_requests_received(0), 
+        steal_requests_denied(0), tasks_given_away(0)
     //--------------------------------------------------------------------------
     {
       log_mapper.spew("Initializing the default mapper for "
@@ -94,19 +122,36 @@ namespace Legion {
           INT_ARG("-dm:thefts", max_steals_per_theft);
           INT_ARG("-dm:count", max_steal_count);
           BOOL_ARG("-dm:steal", stealing_enabled);
+          INT_ARG("-dm:steal_bytes", steal_locality_bytes);
+          BOOL_ARG("-dm:concurrent", concurrent_mapping);
+          BOOL_ARG("-dm:batch_map", batch_mapping);
+          BOOL_ARG("-dm:spill", spill_under_pressure);
+          BOOL_ARG("-dm:prefetch", prefetch_enabled);
           BOOL_ARG("-dm:bft", breadth_first_traversal);
           INT_ARG("-dm:sched", max_schedule_count);
+          INT_ARG("-dm:slice_fanout", slice_fanout);
+          BOOL_ARG("-dm:speculate", speculation_enabled);
+          BOOL_ARG("-dm:locality_slice", locality_slicing);
+          INT_ARG("-dm:locality_tolerance", locality_tolerance);
+          BOOL_ARG("-dm:adaptive", adaptive_mapping);
+          INT_ARG("-dm:learn_samples", learn_samples);
+          if (!strcmp(argv[i], "-dm:learn_file"))
+          {
+            learned_costs_file = argv[++i];
+            continue;
+          }
 #undef BOOL_ARG
 #undef INT_ARG
         }
       }
-      if (stealing_enabled)
-      {
-        log_mapper.warning("Default mapper does not have a stealing algorithm "
-                           "implemented yet so we are ignoring the request "
-                           "for enabling stealing at the moment.");
-        stealing_enabled = false;
-      }
+      // A fanout of one would never split the nodes of a launch
+      if (slice_fanout == 1)
+        slice_fanout = 2;
+      // Persisting learned costs only makes sense if we learn them
+      if (!learned_costs_file.empty())
+        adaptive_mapping = true;
+      if (learn_samples == 0)
+        learn_samples = 1;
       // Get all the processors and gpus on the local node
       Machine::ProcessorQuery all_procs(machine);
       for (Machine::ProcessorQuery::iterator it = all_procs.begin();
@@ -254,6 +299,17 @@ namespace Legion {
       for (int i = 0; i < 3; i++)
         random_number_generator[i] = (unsigned short)((local_proc.id & 
                             (short_mask << (i*short_bits))) >> (i*short_bits));
+      if (!learned_costs_file.empty())
+      {
+        // Every node learns on its own so give each one its own file
+        if (total_nodes > 1)
+        {
+          char suffix[32];
+          snprintf(suffix, sizeof(suffix), ".%d", node_id);
+          learned_costs_file += suffix;
+        }
+        default_read_learned_costs(learned_task_costs, learned_copy_costs);
+      }
     }
 
     //--------------------------------------------------------------------------
@@ -287,6 +343,16 @@ namespace Legion {
     {
       log_mapper.spew("Deleting default mapper for processor " IDFMT "",
                   local_proc.id);
+      if (!learned_costs_file.empty() && 
+          (!measured_task_costs.empty() || !measured_copy_costs.empty()))
+        default_write_learned_costs();
+      if (stealing_enabled)
+        log_mapper.info("%s sent %llu steal requests and mapped %llu stolen "
+                        "tasks, received %llu steal requests, denied %llu "
+                        "of them, and gave away %llu tasks", 
+                        get_mapper_name(), steal_requests_sent,
+                        stolen_tasks_mapped, steal_requests_received,
+                        steal_requests_denied, tasks_given_away);
       free(const_cast<char*>(mapper_name));
     }
 
@@ -311,6 +377,10 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       // Default mapper operates with the serialized re-entrant sync model
+      // unless asked to run concurrently, all its shared state is guarded
+      // with the mapper lock so it is safe either way
+      if (concurrent_mapping)
+        return CONCURRENT_MAPPER_MODEL;
       return SERIALIZED_REENTRANT_MAPPER_MODEL;
     }
 
@@ -334,11 +404,14 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       if (have_proc_kind_variant(ctx, task.task_id, Processor::PROC_SET)) {
+        AutoMapperLock m_lock(this, ctx);
         return default_get_next_global_procset();
       }
  
       VariantInfo info = 
         default_find_preferred_variant(task, ctx, false/*needs tight*/);
+      // The round-robin state is shared by all our mapper calls
+      AutoMapperLock m_lock(this, ctx);
       // If we are the right kind and this is an index space task launch
       // then we return ourselves
       if (task.is_index_space)
@@ -608,12 +681,24 @@ namespace Legion {
                                      Processor::Kind specific)
     //--------------------------------------------------------------------------
     {
-      // Do a quick test to see if we have cached the result
-      std::map<TaskID,VariantInfo>::const_iterator finder = 
+      // Do a quick test to see if we have cached the result, learned
+      // choices depend on the size of each task though so the cached 
+      // choice for the task ID as a whole cannot be trusted then
+      bool has_cached = false;
+      VariantInfo cached;
+      if (!adaptive_mapping)
+      {
+        AutoMapperLock m_lock(this, ctx, true/*read only*/);
+        std::map<TaskID,VariantInfo>::const_iterator finder = 
                                         preferred_variants.find(task.task_id);
-      if (finder != preferred_variants.end() && 
-          (!needs_tight_bound || finder->second.tight_bound))
-        return finder->second;
+        if (finder != preferred_variants.end())
+        {
+          has_cached = true;
+          cached = finder->second;
+        }
+      }
+      if (has_cached && (!needs_tight_bound || cached.tight_bound))
+        return cached;
 
       Machine::ProcessorQuery all_procsets(machine);
       all_procsets.only_kind(Processor::PROC_SET);
@@ -643,8 +728,7 @@ namespace Legion {
       {
         variants.clear();
         Processor::Kind best_kind = Processor::NO_KIND;
-        if (finder == preferred_variants.end() || 
-            (specific != Processor::NO_KIND))
+        if (!has_cached || (specific != Processor::NO_KIND))
         {
           // Do the weak part first and figure out which processor kind
           // we want to focus on first
@@ -719,7 +803,7 @@ namespace Legion {
         {
           // We already know which kind to focus, so just get our 
           // variants for this processor kind
-          best_kind = finder->second.proc_kind;
+          best_kind = cached.proc_kind;
           runtime->find_valid_variants(ctx, task.task_id, 
                                               variants, best_kind);
         }
@@ -804,6 +888,7 @@ namespace Legion {
               }
             }
           }
+          AutoMapperLock m_lock(this, ctx);
           preferred_variants[task.task_id] = result;
         }
         return result;
@@ -830,6 +915,9 @@ namespace Legion {
       if (local_procsets.size() > 0) ranking.push_back(Processor::PROC_SET);
       ranking.push_back(Processor::LOC_PROC);
       if (local_ios.size() > 0) ranking.push_back(Processor::IO_PROC);
+      // If we are learning, reorder by the measured times
+      if (adaptive_mapping && (ranking.size() > 1))
+        default_rank_learned_processor_kinds(ctx, task, ranking);
     }
 
     //--------------------------------------------------------------------------
@@ -843,6 +931,29 @@ namespace Legion {
                                       const TaskLayoutConstraintSet &layout2)
     //--------------------------------------------------------------------------
     {
+      if (adaptive_mapping)
+      {
+        size_t volume, bytes;
+        default_find_problem_size(ctx, task, volume, bytes);
+        const unsigned size_class = compute_size_class(volume);
+        double time1 = 0.0, time2 = 0.0;
+        bool learned1, learned2;
+        {
+          AutoMapperLock m_lock(this, ctx, true/*read only*/);
+          learned1 = 
+            default_find_learned_time(task, vid1, kind, size_class, time1);
+          learned2 = 
+            default_find_learned_time(task, vid2, kind, size_class, time2);
+        }
+        // Try variants we don't know enough about yet first
+        if (learned1 && !learned2)
+          return vid2;
+        if (!learned1 && learned2)
+          return vid1;
+        if (learned1 && learned2)
+          return (time2 < time1) ? vid2 : vid1;
+        // Otherwise fall through to the static choice
+      }
       // TODO: better algorithm for picking the best variants on this machine
       // For now we do something really stupid, chose the larger variant
       // ID because if it was registered later is likely more specialized :)
@@ -1090,6 +1201,7 @@ namespace Legion {
            runtime->find_execution_constraints(ctx, task.task_id, variants[i]);
         if(exset.processor_constraint.kind == Processor::PROC_SET) {
 
+           AutoMapperLock m_lock(this, ctx);
            // Before we do anything else, see if it is in the cache
            std::map<Domain,std::vector<TaskSlice> >::const_iterator finder =
              procset_slices_cache.find(input.domain);
@@ -1121,6 +1233,12 @@ namespace Legion {
       // be scheduled on as determined by select initial task
       Processor::Kind target_kind =
         task.must_epoch_task ? local_proc.kind() : task.target_proc.kind();
+      // Data placement changes between launches so these aren't cached
+      if (locality_slicing && !task.must_epoch_task &&
+          default_locality_slice_task(ctx, task, target_kind, input, output))
+        return;
+      // Slicing reads and updates the slice caches
+      AutoMapperLock m_lock(this, ctx);
       switch (target_kind)
       {
         case Processor::LOC_PROC:
@@ -1158,6 +1276,146 @@ namespace Legion {
       }
     }
 
+    //--------------------------------------------------------------------------
+    bool DefaultMapper::default_locality_slice_task(MapperContext ctx,
+                                           const Task &task,
+                                           Processor::Kind kind,
+                                           const SliceTaskInput &input,
+                                                 SliceTaskOutput &output)
+    //--------------------------------------------------------------------------
+    {
+      // Only identity projections tell us which subregion each point 
+      // will use without having to invoke the projection functor, and
+      // only data that is read has to be where the point runs
+      std::vector<unsigned> locality_reqs;
+      for (unsigned idx = 0; idx < task.regions.size(); idx++)
+      {
+        const RegionRequirement &req = task.regions[idx];
+        if ((req.handle_type != PART_PROJECTION) || (req.projection != 0) ||
+            (req.privilege == NO_ACCESS) || (req.privilege == WRITE_DISCARD) ||
+            req.privilege_fields.empty())
+          continue;
+        locality_reqs.push_back(idx);
+      }
+      if (locality_reqs.empty() || (input.domain.get_dim() == 0))
+        return false;
+      // Group the processors of the right kind by the memory we would
+      // map their instances into, those are the places data can be
+      std::vector<Memory> memories;
+      std::vector<std::vector<Processor> > memory_procs;
+      Machine::ProcessorQuery all_procs(machine);
+      all_procs.only_kind(kind);
+      for (Machine::ProcessorQuery::iterator it = all_procs.begin();
+            it != all_procs.end(); it++)
+      {
+        const Memory memory = default_policy_select_target_memory(ctx, *it);
+        unsigned index = 0;
+        while ((index < memories.size()) && (memories[index] != memory))
+          index++;
+        if (index == memories.size())
+        {
+          memories.push_back(memory);
+          memory_procs.resize(memories.size());
+        }
+        memory_procs[index].push_back(*it);
+      }
+      // Nothing to decide if there is only one place to go
+      if (memories.size() < 2)
+        return false;
+      std::vector<LayoutConstraintSet> constraints(locality_reqs.size());
+      std::vector<size_t> field_sizes(locality_reqs.size(), 0);
+      for (unsigned idx = 0; idx < locality_reqs.size(); idx++)
+      {
+        const RegionRequirement &req = task.regions[locality_reqs[idx]];
+        std::vector<FieldID> fields(req.privilege_fields.begin(),
+                                    req.privilege_fields.end());
+        constraints[idx].add_constraint(
+            FieldConstraint(fields, false/*contig*/, false/*inorder*/));
+        for (std::vector<FieldID>::const_iterator it = 
+              fields.begin(); it != fields.end(); it++)
+          field_sizes[idx] += runtime->get_field_size(ctx, 
+                                req.partition.get_field_space(), *it);
+      }
+      // Find the memory holding the most of each point's data
+      std::vector<DomainPoint> points;
+      std::vector<unsigned> preferred;
+      std::vector<size_t> local_bytes(memories.size());
+      std::vector<LogicalRegion> regions(1);
+      for (Domain::DomainPointIterator itr(input.domain); itr; itr++)
+      {
+        std::fill(local_bytes.begin(), local_bytes.end(), 0);
+        for (unsigned idx = 0; idx < locality_reqs.size(); idx++)
+        {
+          const RegionRequirement &req = task.regions[locality_reqs[idx]];
+          regions[0] = runtime->get_logical_subregion_by_color(ctx,
+                                                  req.partition, itr.p);
+          const size_t bytes = field_sizes[idx] * 
+            runtime->get_index_space_domain(ctx, 
+                regions[0].get_index_space()).get_volume();
+          for (unsigned m = 0; m < memories.size(); m++)
+          {
+            PhysicalInstance instance;
+            if (runtime->find_physical_instance(ctx, memories[m], 
+                  constraints[idx], regions, instance, false/*acquire*/))
+              local_bytes[m] += bytes;
+          }
+        }
+        unsigned best = memories.size();
+        size_t best_bytes = 0;
+        for (unsigned m = 0; m < memories.size(); m++)
+        {
+          if (local_bytes[m] > best_bytes)
+          {
+            best = m;
+            best_bytes = local_bytes[m];
+          }
+        }
+        points.push_back(itr.p);
+        preferred.push_back(best);
+      }
+      // Send points to their data as long as no memory gets more than 
+      // its share of the points plus the tolerance, then spread the
+      // remaining points over the least loaded memories
+      const size_t capacity = 
+        (points.size() * (100 + locality_tolerance) + 
+         100 * memories.size() - 1) / (100 * memories.size());
+      std::vector<size_t> load(memories.size(), 0);
+      std::vector<unsigned> assigned(points.size(), memories.size());
+      for (unsigned idx = 0; idx < points.size(); idx++)
+      {
+        if ((preferred[idx] < memories.size()) && 
+            (load[preferred[idx]] < capacity))
+        {
+          assigned[idx] = preferred[idx];
+          load[preferred[idx]]++;
+        }
+      }
+      for (unsigned idx = 0; idx < points.size(); idx++)
+      {
+        if (assigned[idx] < memories.size())
+          continue;
+        unsigned target = 0;
+        for (unsigned m = 1; m < memories.size(); m++)
+          if (load[m] < load[target])
+            target = m;
+        assigned[idx] = target;
+        load[target]++;
+      }
+      // Round-robin over the processors sharing each memory
+      std::vector<unsigned> next_proc(memories.size(), 0);
+      output.slices.reserve(points.size());
+      for (unsigned idx = 0; idx < points.size(); idx++)
+      {
+        const std::vector<Processor> &procs = memory_procs[assigned[idx]];
+        const Processor target = 
+          procs[next_proc[assigned[idx]]++ % procs.size()];
+        output.slices.push_back(TaskSlice(
+              Domain::from_domain_point(points[idx]), target,
+              false/*recurse*/, stealing_enabled));
+      }
+      return true;
+    }
+
     //--------------------------------------------------------------------------
     void DefaultMapper::default_slice_task(const Task &task,
                                            const std::vector<Processor> &local,
@@ -1167,6 +1425,49 @@ namespace Legion {
                   std::map<Domain,std::vector<TaskSlice> > &cached_slices) const
     //--------------------------------------------------------------------------
     {
+      // If we're distributing launches hierarchically then each node
+      // only splits its part of the launch a little further and
+      // forwards the pieces on, which depends on the whole launch
+      // domain and not just ours so don't use the cache for it
+      if ((slice_fanout > 0) && (total_nodes > 1) && 
+          (remote.size() == total_nodes))
+      {
+        bool has_all_nodes = true;
+        for (unsigned idx = 0; idx < remote.size(); idx++)
+        {
+          if ((idx != node_id) && !remote[idx].exists())
+          {
+            has_all_nodes = false;
+            break;
+          }
+        }
+        if (has_all_nodes)
+        {
+          switch (input.domain.get_dim())
+          {
+            case 1:
+              {
+                default_hierarchical_slice<1>(task.index_domain.get_rect<1>(),
+                    input.domain.get_rect<1>(), local, remote, output.slices);
+                return;
+              }
+            case 2:
+              {
+                default_hierarchical_slice<2>(task.index_domain.get_rect<2>(),
+                    input.domain.get_rect<2>(), local, remote, output.slices);
+                return;
+              }
+            case 3:
+              {
+                default_hierarchical_slice<3>(task.index_domain.get_rect<3>(),
+                    input.domain.get_rect<3>(), local, remote, output.slices);
+                return;
+              }
+            default: // don't support other dimensions right now
+              assert(false);
+          }
+        }
+      }
       // Before we do anything else, see if it is in the cache
       std::map<Domain,std::vector<TaskSlice> >::const_iterator finder = 
         cached_slices.find(input.domain);
@@ -1326,6 +1627,13 @@ namespace Legion {
       // TODO: some criticality analysis to assign priorities
       output.task_priority = 0;
       output.postmap_task = false;
+      if (adaptive_mapping)
+        default_request_task_profiling(ctx, task, chosen.variant, output);
+      if (task.steal_count > 0)
+      {
+        AutoMapperLock m_lock(this, ctx);
+        stolen_tasks_mapped++;
+      }
       // Figure out our target processors
       default_policy_select_target_processors(ctx, task, output.target_procs);
 
@@ -1387,73 +1695,82 @@ namespace Legion {
       // First, let's see if we've cached a result of this task mapping
       const unsigned long long task_hash = compute_task_hash(task);
       std::pair<TaskID,Processor> cache_key(task.task_id, task.target_proc);
-      std::map<std::pair<TaskID,Processor>,
-               std::list<CachedTaskMapping> >::const_iterator 
-        finder = cached_task_mappings.find(cache_key);
       // This flag says whether we need to recheck the field constraints,
       // possibly because a new field was allocated in a region, so our old
       // cached physical instance(s) is(are) no longer valid
       bool needs_field_constraint_check = false;
       Memory target_memory = default_policy_select_target_memory(ctx, 
                                                          task.target_proc);
-      if (finder != cached_task_mappings.end())
+      if (spill_under_pressure)
+        target_memory = default_policy_select_spill_memory(ctx,
+                                        task.target_proc, target_memory);
+      if (prefetch_enabled && input.traced)
+        default_prefetch_next_iteration(ctx, task, target_memory);
+      bool found_cached = false;
+      bool cached_reductions = false;
       {
-        bool found = false;
-        bool has_reductions = false;
-        // Iterate through and see if we can find one with our variant and hash
-        for (std::list<CachedTaskMapping>::const_iterator it = 
-              finder->second.begin(); it != finder->second.end(); it++)
+        AutoMapperLock m_lock(this, ctx, true/*read only*/);
+        std::map<std::pair<TaskID,Processor>,
+                 std::list<CachedTaskMapping> >::const_iterator 
+          finder = cached_task_mappings.find(cache_key);
+        if (finder != cached_task_mappings.end())
         {
-          if ((it->variant == output.chosen_variant) &&
-              (it->task_hash == task_hash))
+          // Iterate through and see if we can find one with our 
+          // variant and hash
+          for (std::list<CachedTaskMapping>::const_iterator it = 
+                finder->second.begin(); it != finder->second.end(); it++)
           {
-            // Have to copy it before we do the external call which 
-            // might invalidate our iterator
-            output.chosen_instances = it->mapping;
-            has_reductions = it->has_reductions;
-            found = true;
-            break;
+            if ((it->variant == output.chosen_variant) &&
+                (it->task_hash == task_hash))
+            {
+              // Have to copy it before we do the external call which 
+              // might invalidate our iterator
+              output.chosen_instances = it->mapping;
+              cached_reductions = it->has_reductions;
+              found_cached = true;
+              break;
+            }
           }
         }
-        if (found)
+      }
+      if (found_cached)
+      {
+        // If we have reductions, make those instances now since we
+        // never cache the reduction instances
+        if (cached_reductions)
         {
-          // If we have reductions, make those instances now since we
-          // never cache the reduction instances
-          if (has_reductions)
+          const TaskLayoutConstraintSet &layout_constraints =
+            runtime->find_task_layout_constraints(ctx,
+                                task.task_id, output.chosen_variant);
+          for (unsigned idx = 0; idx < task.regions.size(); idx++)
           {
-            const TaskLayoutConstraintSet &layout_constraints =
-              runtime->find_task_layout_constraints(ctx,
-                                  task.task_id, output.chosen_variant);
-            for (unsigned idx = 0; idx < task.regions.size(); idx++)
+            if (task.regions[idx].privilege == REDUCE)
             {
-              if (task.regions[idx].privilege == REDUCE)
+              std::set<FieldID> copy = task.regions[idx].privilege_fields;
+              if (!default_create_custom_instances(ctx, task.target_proc,
+                  target_memory, task.regions[idx], idx, copy, 
+                  layout_constraints, needs_field_constraint_check, 
+                  output.chosen_instances[idx]))
               {
-                std::set<FieldID> copy = task.regions[idx].privilege_fields;
-                if (!default_create_custom_instances(ctx, task.target_proc,
-                    target_memory, task.regions[idx], idx, copy, 
-                    layout_constraints, needs_field_constraint_check, 
-                    output.chosen_instances[idx]))
-                {
-                  default_report_failed_instance_creation(task, idx, 
-                                              task.target_proc, target_memory);
-                }
+                default_report_failed_instance_creation(task, idx, 
+                                            task.target_proc, target_memory);
               }
             }
           }
-          // See if we can acquire these instances still
-          if (runtime->acquire_and_filter_instances(ctx, 
-                                                     output.chosen_instances))
-            return;
-          // We need to check the constraints here because we had a
-          // prior mapping and it failed, which may be the result
-          // of a change in the allocated fields of a field space
-          needs_field_constraint_check = true;
-          // If some of them were deleted, go back and remove this entry
-          // Have to renew our iterators since they might have been
-          // invalidated during the 'acquire_and_filter_instances' call
-          default_remove_cached_task(ctx, output.chosen_variant,
-                        task_hash, cache_key, output.chosen_instances);
         }
+        // See if we can acquire these instances still
+        if (runtime->acquire_and_filter_instances(ctx, 
+                                                   output.chosen_instances))
+          return;
+        // We need to check the constraints here because we had a
+        // prior mapping and it failed, which may be the result
+        // of a change in the allocated fields of a field space
+        needs_field_constraint_check = true;
+        // If some of them were deleted, go back and remove this entry
+        // Have to renew our iterators since they might have been
+        // invalidated during the 'acquire_and_filter_instances' call
+        default_remove_cached_task(ctx, output.chosen_variant,
+                      task_hash, cache_key, output.chosen_instances);
       }
       // We didn't find a cached version of the mapping so we need to 
       // do a full mapping, we already know what variant we want to use
@@ -1544,6 +1861,7 @@ namespace Legion {
         }
       }
       // Now that we are done, let's cache the result so we can use it later
+      AutoMapperLock m_lock(this, ctx);
       std::list<CachedTaskMapping> &map_list = cached_task_mappings[cache_key];
       map_list.push_back(CachedTaskMapping());
       CachedTaskMapping &cached_result = map_list.back();
@@ -1636,15 +1954,17 @@ namespace Legion {
         const std::vector<std::vector<PhysicalInstance> > &post_filter)
     //--------------------------------------------------------------------------
     {
-      std::map<std::pair<TaskID,Processor>,
-               std::list<CachedTaskMapping> >::iterator
-                 finder = cached_task_mappings.find(cache_key);
-      if (finder != cached_task_mappings.end())
+      // Keep a list of instances for which we need to downgrade
+      // their garbage collection priorities since we are no
+      // longer caching the results
+      std::deque<PhysicalInstance> to_downgrade;
       {
-        // Keep a list of instances for which we need to downgrade
-        // their garbage collection priorities since we are no
-        // longer caching the results
-        std::deque<PhysicalInstance> to_downgrade;
+        AutoMapperLock m_lock(this, ctx);
+        std::map<std::pair<TaskID,Processor>,
+                 std::list<CachedTaskMapping> >::iterator
+                   finder = cached_task_mappings.find(cache_key);
+        if (finder == cached_task_mappings.end())
+          return;
         for (std::list<CachedTaskMapping>::iterator it = 
               finder->second.begin(); it != finder->second.end(); it++)
         {
@@ -1693,12 +2013,12 @@ namespace Legion {
         }
         if (finder->second.empty())
           cached_task_mappings.erase(finder);
-        if (!to_downgrade.empty())
-        {
-          for (std::deque<PhysicalInstance>::const_iterator it =
-                to_downgrade.begin(); it != to_downgrade.end(); it++)
-            runtime->set_garbage_collection_priority(ctx, *it, 0/*priority*/);
-        }
+      }
+      if (!to_downgrade.empty())
+      {
+        for (std::deque<PhysicalInstance>::const_iterator it =
+              to_downgrade.begin(); it != to_downgrade.end(); it++)
+          runtime->set_garbage_collection_priority(ctx, *it, 0/*priority*/);
       }
     }
 
@@ -1738,6 +2058,20 @@ namespace Legion {
       return result;
     }
 
+    //--------------------------------------------------------------------------
+    /*static*/ unsigned DefaultMapper::compute_size_class(size_t volume)
+    //--------------------------------------------------------------------------
+    {
+      // Bucket problem sizes by powers of two
+      unsigned result = 0;
+      while (volume > 0)
+      {
+        volume >>= 1;
+        result++;
+      }
+      return result;
+    }
+
     //--------------------------------------------------------------------------
     bool DefaultMapper::default_create_custom_instances(MapperContext ctx,
                           Processor target_proc, Memory target_memory,
@@ -1871,9 +2205,12 @@ namespace Legion {
     {
       // TODO: deal with the updates in machine model which will
       //       invalidate this cache
-      std::map<Processor,Memory>::iterator it =
-        cached_target_memory.find(target_proc);
-      if (it != cached_target_memory.end()) return it->second;
+      {
+        AutoMapperLock m_lock(this, ctx, true/*read only*/);
+        std::map<Processor,Memory>::const_iterator it =
+          cached_target_memory.find(target_proc);
+        if (it != cached_target_memory.end()) return it->second;
+      }
 
       // Find the visible memories from the processor for the given kind
       Machine::MemoryQuery visible_memories(machine);
@@ -1901,10 +2238,58 @@ namespace Legion {
         }
       }
       assert(chosen.exists());
+      // If we have learned how expensive it is to copy data into each 
+      // of the visible memories then go with the cheapest one instead
+      if (adaptive_mapping)
+      {
+        AutoMapperLock m_lock(this, ctx, true/*read only*/);
+        Memory cheapest = Memory::NO_MEMORY;
+        double cheapest_cost = 0.0;
+        for (Machine::MemoryQuery::iterator it = visible_memories.begin();
+              it != visible_memories.end(); it++)
+        {
+          double cost;
+          if (!default_find_learned_copy_cost(it->kind(), cost))
+          {
+            cheapest = Memory::NO_MEMORY;
+            break;
+          }
+          if (!cheapest.exists() || (cost < cheapest_cost))
+          {
+            cheapest = *it;
+            cheapest_cost = cost;
+          }
+        }
+        if (cheapest.exists())
+          chosen = cheapest;
+      }
+      AutoMapperLock m_lock(this, ctx);
       cached_target_memory[target_proc] = chosen;
       return chosen;
     }
 
+    //--------------------------------------------------------------------------
+    Memory DefaultMapper::default_policy_select_spill_memory(MapperContext ctx,
+                                    Processor target_proc, Memory target_memory)
+    //--------------------------------------------------------------------------
+    {
+      // Only spill out of the framebuffer and only once the runtime
+      // tells us it is about to start collecting instances there
+      if ((target_memory.kind() != Memory::GPU_FB_MEM) ||
+          !runtime->is_memory_under_pressure(ctx, target_memory))
+        return target_memory;
+      Machine::MemoryQuery zcopy_memories(machine);
+      zcopy_memories.has_affinity_to(target_proc);
+      zcopy_memories.only_kind(Memory::Z_COPY_MEM);
+      if (zcopy_memories.count() == 0)
+        return target_memory;
+      Memory result = zcopy_memories.first();
+      log_mapper.debug("Spilling instances for processor " IDFMT " from "
+                       "framebuffer " IDFMT " to zero-copy memory " IDFMT,
+                       target_proc.id, target_memory.id, result.id);
+      return result;
+    }
+
     //--------------------------------------------------------------------------
     LayoutConstraintID DefaultMapper::default_policy_select_layout_constraints(
                                     MapperContext ctx, Memory target_memory, 
@@ -1922,18 +2307,22 @@ namespace Legion {
         force_new_instances = true;
         std::pair<Memory::Kind,ReductionOpID> constraint_key(
             target_memory.kind(), req.redop);
-        std::map<std::pair<Memory::Kind,ReductionOpID>,LayoutConstraintID>::
-          const_iterator finder = reduction_constraint_cache.find(
+        {
+          AutoMapperLock m_lock(this, ctx, true/*read only*/);
+          std::map<std::pair<Memory::Kind,ReductionOpID>,LayoutConstraintID>::
+            const_iterator finder = reduction_constraint_cache.find(
                                                             constraint_key);
-        // No need to worry about field constraint checks here
-        // since we don't actually have any field constraints
-        if (finder != reduction_constraint_cache.end())
-          return finder->second;
+          // No need to worry about field constraint checks here
+          // since we don't actually have any field constraints
+          if (finder != reduction_constraint_cache.end())
+            return finder->second;
+        }
         LayoutConstraintSet constraints;
         default_policy_select_constraints(ctx, constraints, target_memory, req);
         LayoutConstraintID result = 
           runtime->register_layout(ctx, constraints);
         // Save the result
+        AutoMapperLock m_lock(this, ctx);
         reduction_constraint_cache[constraint_key] = result;
         return result;
       }
@@ -1944,17 +2333,27 @@ namespace Legion {
       // See if we've already made a constraint set for this layout
       std::pair<Memory::Kind,FieldSpace> constraint_key(target_memory.kind(),
                                                req.region.get_field_space());
-      std::map<std::pair<Memory::Kind,FieldSpace>,LayoutConstraintID>::
-        const_iterator finder = layout_constraint_cache.find(constraint_key);
-      if (finder != layout_constraint_cache.end())
+      bool has_cached = false;
+      LayoutConstraintID cached = 0;
+      {
+        AutoMapperLock m_lock(this, ctx, true/*read only*/);
+        std::map<std::pair<Memory::Kind,FieldSpace>,LayoutConstraintID>::
+          const_iterator finder = layout_constraint_cache.find(constraint_key);
+        if (finder != layout_constraint_cache.end())
+        {
+          has_cached = true;
+          cached = finder->second;
+        }
+      }
+      if (has_cached)
       {
         // If we don't need a constraint check we are already good
         if (!needs_field_constraint_check)
-          return finder->second;
+          return cached;
         // Check that the fields still are the same, if not, fall through
         // so that we make a new set of constraints
         const LayoutConstraintSet &old_constraints =
-                runtime->find_layout_constraints(ctx, finder->second);
+                runtime->find_layout_constraints(ctx, cached);
         // Should be only one unless things have changed
         const std::vector<FieldID> &old_set = 
                           old_constraints.field_constraint.get_field_set();
@@ -1975,7 +2374,7 @@ namespace Legion {
             }
           }
           if (still_equal)
-            return finder->second;
+            return cached;
         }
         // Otherwise we fall through and make a new constraint which
         // will also update the cache
@@ -1990,6 +2389,7 @@ namespace Legion {
       // call could have registered the exact same registration constraints
       // here if we were preempted during the registration call. The 
       // constraint sets are identical though so it's all good.
+      AutoMapperLock m_lock(this, ctx);
       layout_constraint_cache[constraint_key] = result;
       return result; 
     }
@@ -2061,9 +2461,15 @@ namespace Legion {
               constraints, target_regions, result))
           return false;
       } else {
+        // See if one of the instances we used recently still works
+        // before asking the runtime to search the whole memory
+        if (default_find_cached_instance(ctx, target_memory, target_region,
+                                         constraints, result))
+          return true;
         if (!runtime->find_or_create_physical_instance(ctx, 
               target_memory, constraints, target_regions, result, created))
           return false;
+        default_cache_instance(ctx, target_memory, target_region, result);
       }
       if (created)
       {
@@ -2075,6 +2481,70 @@ namespace Legion {
       return true;
     }
 
+    //--------------------------------------------------------------------------
+    bool DefaultMapper::default_find_cached_instance(MapperContext ctx,
+                                  Memory target_memory, LogicalRegion region,
+                                  const LayoutConstraintSet &constraints,
+                                  PhysicalInstance &result)
+    //--------------------------------------------------------------------------
+    {
+      const std::pair<Memory,LogicalRegion> key(target_memory, region);
+      // Copy the candidates since acquiring is a runtime call which
+      // can let other calls into this mapper change the cache
+      std::vector<PhysicalInstance> candidates;
+      {
+        AutoMapperLock m_lock(this, ctx, true/*read only*/);
+        std::map<std::pair<Memory,LogicalRegion>,
+                 std::list<PhysicalInstance> >::const_iterator finder = 
+                   cached_instances.find(key);
+        if (finder == cached_instances.end())
+          return false;
+        candidates.assign(finder->second.begin(), finder->second.end());
+      }
+      for (std::vector<PhysicalInstance>::const_iterator it = 
+            candidates.begin(); it != candidates.end(); it++)
+      {
+        // The layout check covers the fields as well
+        if (!it->entails(constraints))
+          continue;
+        if (runtime->acquire_instance(ctx, *it))
+        {
+          result = *it;
+          return true;
+        }
+        // It was collected so forget about it
+        AutoMapperLock m_lock(this, ctx);
+        std::map<std::pair<Memory,LogicalRegion>,
+                 std::list<PhysicalInstance> >::iterator finder = 
+                   cached_instances.find(key);
+        if (finder != cached_instances.end())
+        {
+          finder->second.remove(*it);
+          if (finder->second.empty())
+            cached_instances.erase(finder);
+        }
+      }
+      return false;
+    }
+
+    //--------------------------------------------------------------------------
+    void DefaultMapper::default_cache_instance(MapperContext ctx,
+                      Memory target_memory, LogicalRegion region, 
+                      const PhysicalInstance &instance)
+    //--------------------------------------------------------------------------
+    {
+      AutoMapperLock m_lock(this, ctx);
+      // Only keep a few instances for each region, tasks that want
+      // many different layouts of the same data are rare
+      const size_t max_cached_instances = 4;
+      std::list<PhysicalInstance> &instances = 
+        cached_instances[std::pair<Memory,LogicalRegion>(target_memory,region)];
+      instances.remove(instance);
+      instances.push_front(instance);
+      if (instances.size() > max_cached_instances)
+        instances.pop_back();
+    }
+
     //--------------------------------------------------------------------------
     LogicalRegion DefaultMapper::default_policy_select_instance_region(
                                 MapperContext ctx, Memory target_memory,
@@ -2176,6 +2646,55 @@ namespace Legion {
       return GC_DEFAULT_PRIORITY;
     }
 
+    //--------------------------------------------------------------------------
+    void DefaultMapper::default_prefetch_next_iteration(MapperContext ctx,
+                                      const Task &task, Memory target_memory)
+    //--------------------------------------------------------------------------
+    {
+      // Remember the regions this point used the last time around the
+      // trace. If they changed the application is most likely rotating
+      // buffers, so the next iteration goes back to the previous ones.
+      std::vector<LogicalRegion> previous;
+      {
+        const std::pair<TaskID,DomainPoint> key(task.task_id, 
+                                                task.index_point);
+        AutoMapperLock m_lock(this, ctx);
+        std::vector<LogicalRegion> &history = prefetch_history[key];
+        previous.swap(history);
+        history.resize(task.regions.size());
+        for (unsigned idx = 0; idx < task.regions.size(); idx++)
+          history[idx] = task.regions[idx].region;
+      }
+      if (previous.size() != task.regions.size())
+        return;
+      for (unsigned idx = 0; idx < task.regions.size(); idx++)
+      {
+        const RegionRequirement &req = task.regions[idx];
+        // Only inputs are worth bringing in ahead of time
+        if (((req.privilege != READ_ONLY) && (req.privilege != READ_WRITE)) ||
+            req.privilege_fields.empty())
+          continue;
+        if (!previous[idx].exists() || (previous[idx] == req.region) ||
+            (previous[idx].get_field_space() != req.region.get_field_space()))
+          continue;
+        RegionRequirement next_req = req;
+        next_req.region = previous[idx];
+        bool force_new_instances = false;
+        LayoutConstraintID layout_id = 
+          default_policy_select_layout_constraints(ctx, target_memory, 
+              next_req, TASK_MAPPING, false/*needs check*/, 
+              force_new_instances);
+        if (force_new_instances)
+          continue;
+        const LayoutConstraintSet &constraints = 
+          runtime->find_layout_constraints(ctx, layout_id);
+        std::vector<LogicalRegion> regions(1,
+            default_policy_select_instance_region(ctx, target_memory, 
+              next_req, constraints, false/*force new*/, true/*meets*/));
+        runtime->prefetch_instance(ctx, target_memory, constraints, regions);
+      }
+    }
+
     //--------------------------------------------------------------------------
     void DefaultMapper::default_report_failed_instance_creation(
                                  const Task &task, unsigned index, 
@@ -2344,8 +2863,27 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       log_mapper.spew("Default speculate for Task in %s", get_mapper_name());
-      // Default mapper doesn't speculate
+      default_speculate(ctx, output);
+    }
+
+    //--------------------------------------------------------------------------
+    void DefaultMapper::default_speculate(MapperContext ctx,
+                                          SpeculativeOutput &output)
+    //--------------------------------------------------------------------------
+    {
       output.speculate = false;
+      if (!speculation_enabled)
+        return;
+      // Guess that predicates are true (e.g. a loop that has not converged
+      // yet) and map ahead of the predicate, but only keep doing this
+      // while we are right more often than we are wrong
+      unsigned correct, misspeculated;
+      runtime->get_speculation_statistics(ctx, correct, misspeculated);
+      if (((correct + misspeculated) >= 8) && (misspeculated > correct))
+        return;
+      output.speculate = true;
+      output.speculative_value = true;
+      output.speculate_mapping_only = true;
     }
 
     //--------------------------------------------------------------------------
@@ -2356,8 +2894,59 @@ namespace Legion {
     {
       log_mapper.spew("Default report_profiling for Task in %s", 
                       get_mapper_name());
-      // We don't ask for any task profiling right now so assert if we see this
-      assert(false);
+      // We only ask for task profiling when we are learning
+      assert(adaptive_mapping);
+      using namespace ProfilingMeasurements;
+      OperationTimeline *timeline = 
+        input.profiling_responses.get_measurement<OperationTimeline>();
+      AutoMapperLock m_lock(this, ctx);
+      if (input.task_response)
+      {
+        std::map<UniqueID,std::pair<VariantID,unsigned> >::iterator finder =
+          profiled_tasks.find(task.get_unique_id());
+        if (finder != profiled_tasks.end())
+        {
+          if ((timeline != NULL) && 
+              (timeline->start_time != OperationTimeline::INVALID_TIMESTAMP) &&
+              (timeline->end_time != OperationTimeline::INVALID_TIMESTAMP))
+          {
+            const LearnedTaskKey key(task.task_id, finder->second.first,
+                             task.target_proc.kind(), finder->second.second);
+            LearnedCost sample;
+            sample.samples = 1;
+            sample.total_ns = timeline->end_time - timeline->start_time;
+            learned_task_costs[key].merge(sample);
+            measured_task_costs[key].merge(sample);
+          }
+          profiled_tasks.erase(finder);
+        }
+      }
+      else
+      {
+        // A copy the runtime issued to map one of our task's regions
+        OperationMemoryUsage *usage = 
+          input.profiling_responses.get_measurement<OperationMemoryUsage>();
+        if ((timeline != NULL) && (usage != NULL) && (usage->size > 0) &&
+            (timeline->start_time != OperationTimeline::INVALID_TIMESTAMP) &&
+            (timeline->complete_time != OperationTimeline::INVALID_TIMESTAMP))
+        {
+          const LearnedCopyKey key(usage->source.kind(), 
+                                   usage->target.kind());
+          LearnedCost sample;
+          sample.samples = 1;
+          sample.total_ns = timeline->complete_time - timeline->start_time;
+          sample.total_bytes = usage->size;
+          // A new kind of copy might change which memories we prefer
+          if (learned_copy_costs.find(key) == learned_copy_costs.end())
+            cached_target_memory.clear();
+          learned_copy_costs[key].merge(sample);
+          measured_copy_costs[key].merge(sample);
+        }
+        if (usage != NULL)
+          delete usage;
+      }
+      if (timeline != NULL)
+        delete timeline;
     }
 
     //--------------------------------------------------------------------------
@@ -2590,8 +3179,7 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       log_mapper.spew("Default speculate for Copy in %s", get_mapper_name());
-      // Default mapper doesn't speculate
-      output.speculate = false;
+      default_speculate(ctx, output);
     }
 
     //--------------------------------------------------------------------------
@@ -2900,6 +3488,347 @@ namespace Legion {
       return false; 
     }
 
+    //--------------------------------------------------------------------------
+    void DefaultMapper::default_advertise_queue_depth(MapperContext ctx)
+    //--------------------------------------------------------------------------
+    {
+      // Only tell everyone when our depth changes by a power of two
+      // so we don't flood the machine with messages every pass
+      QueueDepthMsg msg;
+      {
+        AutoMapperLock m_lock(this, ctx);
+        const unsigned depth_class = compute_size_class(local_queue_depth);
+        if (depth_class == advertised_queue_class)
+          return;
+        advertised_queue_class = depth_class;
+        msg.depth = local_queue_depth;
+      }
+      runtime->broadcast(ctx, &msg, sizeof(msg), ADVERTISEMENT);
+    }
+
+    //--------------------------------------------------------------------------
+    bool DefaultMapper::default_permit_steal(MapperContext ctx,
+                                             const Task &task, Processor thief)
+    //--------------------------------------------------------------------------
+    {
+      if (task.steal_count >= max_steal_count)
+        return false;
+      // The thief has to be able to run it
+      std::vector<VariantID> variants;
+      runtime->find_valid_variants(ctx, task.task_id, variants, thief.kind());
+      if (variants.empty())
+        return false;
+      // Don't ship tasks with lots of input data off the node
+      if ((steal_locality_bytes > 0) && (thief.address_space() != node_id))
+      {
+        size_t volume, bytes;
+        default_find_problem_size(ctx, task, volume, bytes);
+        if (bytes > steal_locality_bytes)
+          return false;
+      }
+      return true;
+    }
+
+    //--------------------------------------------------------------------------
+    void DefaultMapper::default_find_problem_size(MapperContext ctx,
+                           const Task &task, size_t &volume, size_t &bytes)
+    //--------------------------------------------------------------------------
+    {
+      volume = 0;
+      bytes = 0;
+      for (unsigned idx = 0; idx < task.regions.size(); idx++)
+      {
+        const RegionRequirement &req = task.regions[idx];
+        if (req.privilege == NO_ACCESS)
+          continue;
+        size_t req_volume = 0;
+        FieldSpace fspace;
+        if (req.region.exists())
+        {
+          req_volume = runtime->get_index_space_domain(ctx,
+                              req.region.get_index_space()).get_volume();
+          fspace = req.region.get_field_space();
+        }
+        else if (req.partition.exists())
+        {
+          // Index space launch that hasn't been sliced yet so estimate
+          // the size of each point from the parent of the partition
+          IndexSpace parent = runtime->get_parent_index_space(ctx,
+                                  req.partition.get_index_partition());
+          req_volume = runtime->get_index_space_domain(ctx, 
+                                                parent).get_volume();
+          const size_t points = task.index_domain.get_volume();
+          if (points > 1)
+            req_volume /= points;
+          fspace = req.partition.get_field_space();
+        }
+        else
+          continue;
+        volume += req_volume;
+        // Data that is written without being read never has to move
+        if (req.privilege == WRITE_DISCARD)
+          continue;
+        size_t field_bytes = 0;
+        for (std::set<FieldID>::const_iterator it = 
+              req.privilege_fields.begin(); it != 
+              req.privilege_fields.end(); it++)
+          field_bytes += runtime->get_field_size(ctx, fspace, *it);
+        bytes += req_volume * field_bytes;
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    bool DefaultMapper::default_find_learned_time(const Task &task,
+                                 VariantID variant, Processor::Kind kind,
+                                 unsigned size_class, double &time) const
+    //--------------------------------------------------------------------------
+    {
+      std::map<LearnedTaskKey,LearnedCost>::const_iterator finder = 
+        learned_task_costs.find(
+            LearnedTaskKey(task.task_id, variant, kind, size_class));
+      if ((finder == learned_task_costs.end()) || 
+          (finder->second.samples < learn_samples))
+        return false;
+      time = finder->second.total_ns / finder->second.samples;
+      return true;
+    }
+
+    //--------------------------------------------------------------------------
+    bool DefaultMapper::default_find_learned_copy_cost(Memory::Kind src,
+                                  Memory::Kind dst, double &ns_per_byte) const
+    //--------------------------------------------------------------------------
+    {
+      std::map<LearnedCopyKey,LearnedCost>::const_iterator finder = 
+        learned_copy_costs.find(LearnedCopyKey(src, dst));
+      if ((finder == learned_copy_costs.end()) || 
+          (finder->second.samples < learn_samples) ||
+          (finder->second.total_bytes <= 0.0))
+        return false;
+      ns_per_byte = finder->second.total_ns / finder->second.total_bytes;
+      return true;
+    }
+
+    //--------------------------------------------------------------------------
+    bool DefaultMapper::default_find_learned_copy_cost(Memory::Kind dst,
+                                                   double &ns_per_byte) const
+    //--------------------------------------------------------------------------
+    {
+      // Average over copies into this kind of memory from anywhere
+      LearnedCost total;
+      for (std::map<LearnedCopyKey,LearnedCost>::const_iterator it = 
+            learned_copy_costs.begin(); it != learned_copy_costs.end(); it++)
+      {
+        if (it->first.second == dst)
+          total.merge(it->second);
+      }
+      if ((total.samples < learn_samples) || (total.total_bytes <= 0.0))
+        return false;
+      ns_per_byte = total.total_ns / total.total_bytes;
+      return true;
+    }
+
+    //--------------------------------------------------------------------------
+    void DefaultMapper::default_rank_learned_processor_kinds(MapperContext ctx,
+                        const Task &task, std::vector<Processor::Kind> &ranking)
+    //--------------------------------------------------------------------------
+    {
+      size_t volume, bytes;
+      default_find_problem_size(ctx, task, volume, bytes);
+      const unsigned size_class = compute_size_class(volume);
+      // Our data most likely lives where we would put it for ourselves
+      const Memory::Kind local_memory = 
+        default_policy_select_target_memory(ctx, local_proc).kind();
+      // Kinds that still have variants without enough samples go first in
+      // their static order so we learn about them, the rest are sorted by
+      // expected completion time with the static order breaking ties
+      std::vector<Processor::Kind> unexplored;
+      std::vector<std::pair<double,unsigned> > expected;
+      std::vector<VariantID> variants;
+      for (unsigned idx = 0; idx < ranking.size(); idx++)
+      {
+        variants.clear();
+        runtime->find_valid_variants(ctx, task.task_id, variants,ranking[idx]);
+        // Kinds without variants will be filtered by the caller anyway
+        if (variants.empty())
+        {
+          expected.push_back(std::pair<double,unsigned>(DBL_MAX, idx));
+          continue;
+        }
+        bool explored = true;
+        double best_time = DBL_MAX;
+        {
+          AutoMapperLock m_lock(this, ctx, true/*read only*/);
+          for (std::vector<VariantID>::const_iterator it = 
+                variants.begin(); it != variants.end(); it++)
+          {
+            double time;
+            if (!default_find_learned_time(task, *it, ranking[idx], 
+                                           size_class, time))
+            {
+              explored = false;
+              break;
+            }
+            if (time < best_time)
+              best_time = time;
+          }
+        }
+        if (!explored)
+        {
+          unexplored.push_back(ranking[idx]);
+          continue;
+        }
+        // Add the cost of moving the task's data to where it would run
+        Processor target = Processor::NO_PROC;
+        switch (ranking[idx])
+        {
+          case Processor::TOC_PROC:
+            {
+              if (!local_gpus.empty()) target = local_gpus.front();
+              break;
+            }
+          case Processor::LOC_PROC:
+            {
+              if (!local_cpus.empty()) target = local_cpus.front();
+              break;
+            }
+          case Processor::IO_PROC:
+            {
+              if (!local_ios.empty()) target = local_ios.front();
+              break;
+            }
+          case Processor::PROC_SET:
+            {
+              if (!local_procsets.empty()) target = local_procsets.front();
+              break;
+            }
+          case Processor::OMP_PROC:
+            {
+              if (!local_omps.empty()) target = local_omps.front();
+              break;
+            }
+          default: // make warnings go away
+            break;
+        }
+        if (target.exists() && (bytes > 0))
+        {
+          const Memory::Kind target_memory = 
+            default_policy_select_target_memory(ctx, target).kind();
+          double ns_per_byte;
+          AutoMapperLock m_lock(this, ctx, true/*read only*/);
+          if ((target_memory != local_memory) &&
+              default_find_learned_copy_cost(local_memory, target_memory,
+                                             ns_per_byte))
+            best_time += ns_per_byte * bytes;
+        }
+        expected.push_back(std::pair<double,unsigned>(best_time, idx));
+      }
+      std::sort(expected.begin(), expected.end());
+      std::vector<Processor::Kind> result(unexplored);
+      for (std::vector<std::pair<double,unsigned> >::const_iterator it = 
+            expected.begin(); it != expected.end(); it++)
+        result.push_back(ranking[it->second]);
+      ranking.swap(result);
+    }
+
+    //--------------------------------------------------------------------------
+    void DefaultMapper::default_request_task_profiling(MapperContext ctx,
+                                    const Task &task, VariantID variant,
+                                    MapTaskOutput &output)
+    //--------------------------------------------------------------------------
+    {
+      using namespace ProfilingMeasurements;
+      size_t volume, bytes;
+      default_find_problem_size(ctx, task, volume, bytes);
+      {
+        AutoMapperLock m_lock(this, ctx);
+        profiled_tasks[task.get_unique_id()] = 
+          std::pair<VariantID,unsigned>(variant, compute_size_class(volume));
+      }
+      output.task_prof_requests.add_measurement<OperationTimeline>();
+      output.copy_prof_requests.add_measurement<OperationTimeline>();
+      output.copy_prof_requests.add_measurement<OperationMemoryUsage>();
+    }
+
+    //--------------------------------------------------------------------------
+    void DefaultMapper::default_read_learned_costs(
+                        std::map<LearnedTaskKey,LearnedCost> &task_costs,
+                        std::map<LearnedCopyKey,LearnedCost> &copy_costs) const
+    //--------------------------------------------------------------------------
+    {
+      FILE *f = fopen(learned_costs_file.c_str(), "r");
+      // Nothing learned yet is fine
+      if (f == NULL)
+        return;
+      char kind[8];
+      while (fscanf(f, "%7s", kind) == 1)
+      {
+        if (!strcmp(kind, "task"))
+        {
+          unsigned task_id, variant, proc_kind, size_class;
+          LearnedCost cost;
+          if (fscanf(f, "%u %u %u %u %llu %lf", &task_id, &variant,
+                     &proc_kind, &size_class, &cost.samples, 
+                     &cost.total_ns) != 6)
+            break;
+          task_costs[LearnedTaskKey(task_id, variant, 
+              (Processor::Kind)proc_kind, size_class)].merge(cost);
+        }
+        else if (!strcmp(kind, "copy"))
+        {
+          unsigned src, dst;
+          LearnedCost cost;
+          if (fscanf(f, "%u %u %llu %lf %lf", &src, &dst, &cost.samples,
+                     &cost.total_ns, &cost.total_bytes) != 5)
+            break;
+          copy_costs[LearnedCopyKey((Memory::Kind)src, 
+                                    (Memory::Kind)dst)].merge(cost);
+        }
+        else
+          break;
+      }
+      if (!feof(f))
+        log_mapper.warning("Ignoring malformed learned costs at the end of "
+                           "%s in %s", learned_costs_file.c_str(), 
+                           get_mapper_name());
+      fclose(f);
+    }
+
+    //--------------------------------------------------------------------------
+    void DefaultMapper::default_write_learned_costs(void) const
+    //--------------------------------------------------------------------------
+    {
+      // Other mappers on this node may have written the file since we read
+      // it so merge what we measured into what is there now
+      std::map<LearnedTaskKey,LearnedCost> task_costs;
+      std::map<LearnedCopyKey,LearnedCost> copy_costs;
+      default_read_learned_costs(task_costs, copy_costs);
+      for (std::map<LearnedTaskKey,LearnedCost>::const_iterator it = 
+            measured_task_costs.begin(); it != measured_task_costs.end(); it++)
+        task_costs[it->first].merge(it->second);
+      for (std::map<LearnedCopyKey,LearnedCost>::const_iterator it = 
+            measured_copy_costs.begin(); it != measured_copy_costs.end(); it++)
+        copy_costs[it->first].merge(it->second);
+      FILE *f = fopen(learned_costs_file.c_str(), "w");
+      if (f == NULL)
+      {
+        log_mapper.warning("Unable to save learned costs to %s in %s",
+                           learned_costs_file.c_str(), get_mapper_name());
+        return;
+      }
+      for (std::map<LearnedTaskKey,LearnedCost>::const_iterator it = 
+            task_costs.begin(); it != task_costs.end(); it++)
+        fprintf(f, "task %u %u %u %u %llu %.17g\n", 
+                (unsigned)it->first.task_id, (unsigned)it->first.variant,
+                (unsigned)it->first.kind, it->first.size_class,
+                it->second.samples, it->second.total_ns);
+      for (std::map<LearnedCopyKey,LearnedCost>::const_iterator it = 
+            copy_costs.begin(); it != copy_costs.end(); it++)
+        fprintf(f, "copy %u %u %llu %.17g %.17g\n", (unsigned)it->first.first,
+                (unsigned)it->first.second, it->second.samples, 
+                it->second.total_ns, it->second.total_bytes);
+      fclose(f);
+    }
+
     //--------------------------------------------------------------------------
     bool DefaultMapper::default_policy_select_must_epoch_processors(
                               MapperContext ctx,
@@ -3371,6 +4300,35 @@ namespace Legion {
           }
         }
       }
+      output.batch_map_tasks = batch_mapping;
+      // Remember how much work we are leaving in the queue for stealing
+      AutoMapperLock m_lock(this, ctx);
+      saw_ready_tasks = true;
+      local_queue_depth = input.ready_tasks.size() - output.map_tasks.size();
+    }
+
+    //--------------------------------------------------------------------------
+    void DefaultMapper::map_task_batch(const MapperContext          ctx,
+                                       const MapTaskBatchInput&     input,
+                                             MapTaskBatchOutput&    output)
+    //--------------------------------------------------------------------------
+    {
+      log_mapper.spew("Default map_task_batch in %s", get_mapper_name());
+      // The runtime hasn't found the valid instances for these tasks yet
+      // so we map them as if there were none, the cached task mappings
+      // and cached instances do most of the work across the batch
+      MapTaskInput task_input;
+      task_input.traced = false;
+      for (std::vector<const Task*>::const_iterator it = 
+            input.tasks.begin(); it != input.tasks.end(); it++)
+      {
+        const Task &task = **it;
+        task_input.valid_instances.clear();
+        task_input.valid_instances.resize(task.regions.size());
+        MapTaskOutput &task_output = output.task_mappings[*it];
+        task_output.chosen_instances.resize(task.regions.size());
+        map_task(ctx, task, task_input, task_output);
+      }
     }
 
     //--------------------------------------------------------------------------
@@ -3380,7 +4338,40 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       log_mapper.spew("Default select_steal_targets in %s", get_mapper_name());
-      // TODO: implement a work-stealing algorithm here 
+      if (!stealing_enabled)
+        return;
+      // The runtime only asks us to select tasks when it has some
+      // so if we weren't asked this time our queue is empty
+      {
+        AutoMapperLock m_lock(this, ctx);
+        if (!saw_ready_tasks)
+          local_queue_depth = 0;
+        saw_ready_tasks = false;
+      }
+      default_advertise_queue_depth(ctx);
+      AutoMapperLock m_lock(this, ctx);
+      // Only go looking for work when we have run out of our own
+      if (local_queue_depth > 0)
+        return;
+      // Pick the processor of our kind that told us it has the most
+      // tasks waiting, stealing from a queue of one is never worth it
+      Processor victim = Processor::NO_PROC;
+      unsigned victim_depth = 1;
+      for (std::map<Processor,unsigned>::const_iterator it = 
+            remote_queue_depths.begin(); it != 
+            remote_queue_depths.end(); it++)
+      {
+        if ((it->second <= victim_depth) || (it->first.kind() != local_kind))
+          continue;
+        if (input.blacklist.find(it->first) != input.blacklist.end())
+          continue;
+        victim = it->first;
+        victim_depth = it->second;
+      }
+      if (!victim.exists())
+        return;
+      output.targets.insert(victim);
+      steal_requests_sent++;
     }
 
     //--------------------------------------------------------------------------
@@ -3390,7 +4381,36 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       log_mapper.spew("Default permit_steal_request in %s", get_mapper_name());
-      // TODO: implement a work stealing algorithm here
+      // Keep at least half of what is waiting for ourselves
+      const size_t max_stolen = std::min<size_t>(max_steals_per_theft,
+                                          input.stealable_tasks.size() / 2);
+      if (stealing_enabled)
+      {
+        for (std::vector<const Task*>::const_iterator it = 
+              input.stealable_tasks.begin(); (output.stolen_tasks.size() < 
+              max_stolen) && (it != input.stealable_tasks.end()); it++)
+        {
+          if (default_permit_steal(ctx, *(*it), input.thief_proc))
+            output.stolen_tasks.insert(*it);
+        }
+      }
+      {
+        AutoMapperLock m_lock(this, ctx);
+        steal_requests_received++;
+        if (output.stolen_tasks.empty())
+          steal_requests_denied++;
+        else
+          tasks_given_away += output.stolen_tasks.size();
+      }
+      if (output.stolen_tasks.empty())
+      {
+        // Tell the thief there is nothing here for it so it stops asking
+        // until our queue changes enough for us to advertise again
+        QueueDepthMsg msg;
+        msg.depth = 0;
+        runtime->send_message(ctx, input.thief_proc, &msg, sizeof(msg),
+                              ADVERTISEMENT);
+      }
     }
 
     //--------------------------------------------------------------------------
@@ -3399,7 +4419,22 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       log_mapper.spew("Default handle_message in %s", get_mapper_name());
-      // We don't send messages in the default mapper so assert if see this
+      if (message.size >= sizeof(MapperMsgHdr))
+      {
+        const MapperMsgHdr *header = 
+          static_cast<const MapperMsgHdr*>(message.message);
+        if (header->is_valid_mapper_msg() && 
+            (header->type == ADVERTISEMENT))
+        {
+          assert(message.size == sizeof(QueueDepthMsg));
+          const QueueDepthMsg *msg = 
+            static_cast<const QueueDepthMsg*>(message.message);
+          AutoMapperLock m_lock(this, ctx);
+          remote_queue_depths[message.sender] = msg->depth;
+          return;
+        }
+      }
+      // We don't send any other messages so assert if see this
       assert(false);
     }
 
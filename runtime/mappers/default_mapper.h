@@ -86,6 +86,48 @@ namespace Legion {
         bool                 tight_bound;
         bool                 is_inner;
       };
+      struct LearnedCost {
+      public:
+        LearnedCost(void) : samples(0), total_ns(0.0), total_bytes(0.0) { }
+      public:
+        inline void merge(const LearnedCost &rhs)
+        {
+          samples += rhs.samples;
+          total_ns += rhs.total_ns;
+          total_bytes += rhs.total_bytes;
+        }
+      public:
+        unsigned long long   samples;
+        double               total_ns;
+        double               total_bytes; // only for copies
+      };
+      // Execution times are learned per variant, processor kind and a
+      // log2 bucket of the problem size so they stay valid across runs
+      struct LearnedTaskKey {
+      public:
+        LearnedTaskKey(void)
+          : task_id(0), variant(0), kind(Processor::NO_KIND), size_class(0) { }
+        LearnedTaskKey(TaskID tid, VariantID vid, 
+                       Processor::Kind k, unsigned size)
+          : task_id(tid), variant(vid), kind(k), size_class(size) { }
+      public:
+        inline bool operator<(const LearnedTaskKey &rhs) const
+        {
+          if (task_id < rhs.task_id) return true;
+          if (task_id > rhs.task_id) return false;
+          if (variant < rhs.variant) return true;
+          if (variant > rhs.variant) return false;
+          if (kind < rhs.kind) return true;
+          if (kind > rhs.kind) return false;
+          return (size_class < rhs.size_class);
+        }
+      public:
+        TaskID               task_id;
+        VariantID            variant;
+        Processor::Kind      kind;
+        unsigned             size_class;
+      };
+      typedef std::pair<Memory::Kind,Memory::Kind> LearnedCopyKey;
       struct CachedTaskMapping {
       public:
         unsigned long long                          task_hash;
@@ -109,6 +151,29 @@ namespace Legion {
         Processor::TaskFuncID task_id;
         Utilities::MappingProfiler::Profile sample;
       };
+      struct QueueDepthMsg : public MapperMsgHdr {
+      public:
+        QueueDepthMsg(void) : MapperMsgHdr(), depth(0) 
+          { type = ADVERTISEMENT; }
+        unsigned depth;
+      };
+      // Holds the mapper lock while touching the mapper's caches and other
+      // shared state so the mapper can run concurrently, the runtime makes
+      // this a no-op for the serialized sync models. Never make other 
+      // runtime calls or take another one of these while holding one.
+      class AutoMapperLock {
+      public:
+        AutoMapperLock(const DefaultMapper *m, MapperContext c, 
+                       bool read_only = false)
+          : mapper(m), ctx(c) { mapper->runtime->lock_mapper(ctx, read_only); }
+        ~AutoMapperLock(void) { mapper->runtime->unlock_mapper(ctx); }
+      private:
+        AutoMapperLock(const AutoMapperLock &rhs);
+        AutoMapperLock& operator=(const AutoMapperLock &rhs);
+      private:
+        const DefaultMapper *const mapper;
+        const MapperContext ctx;
+      };
     public:
       DefaultMapper(MapperRuntime *rt, Machine machine, Processor local, 
                     const char *mapper_name = NULL);
@@ -263,6 +328,9 @@ namespace Legion {
       virtual void select_tasks_to_map(const MapperContext          ctx,
                                        const SelectMappingInput&    input,
                                              SelectMappingOutput&   output);
+      virtual void map_task_batch(const MapperContext          ctx,
+                                  const MapTaskBatchInput&     input,
+                                        MapTaskBatchOutput&    output);
       virtual void select_steal_targets(const MapperContext         ctx,
                                         const SelectStealingInput&  input,
                                               SelectStealingOutput& output);
@@ -301,6 +369,9 @@ namespace Legion {
                                     const TaskLayoutConstraintSet &layout2);
       virtual Memory default_policy_select_target_memory(MapperContext ctx, 
                                     Processor target_proc);
+      virtual Memory default_policy_select_spill_memory(MapperContext ctx,
+                                    Processor target_proc, 
+                                    Memory target_memory);
       virtual LayoutConstraintID default_policy_select_layout_constraints(
                                     MapperContext ctx, Memory target_memory,
                                     const RegionRequirement &req,
@@ -358,6 +429,7 @@ namespace Legion {
       Processor default_get_next_global_io(void);
       Processor default_get_next_local_procset(void);
       Processor default_get_next_global_procset(void);
+      void default_speculate(MapperContext ctx, SpeculativeOutput &output);
       Processor default_get_next_local_omp(void);
       Processor default_get_next_global_omp(void);
       VariantInfo default_find_preferred_variant(
@@ -370,6 +442,17 @@ namespace Legion {
                               const SliceTaskInput &input,
                                     SliceTaskOutput &output,
             std::map<Domain,std::vector<TaskSlice> > &cached_slices) const;
+      bool default_locality_slice_task(MapperContext ctx, const Task &task,
+                              Processor::Kind kind,
+                              const SliceTaskInput &input,
+                                    SliceTaskOutput &output);
+      template<int DIM>
+      void default_hierarchical_slice(
+                              const LegionRuntime::Arrays::Rect<DIM> &launch,
+                              const LegionRuntime::Arrays::Rect<DIM> &points,
+                              const std::vector<Processor> &local_procs,
+                              const std::vector<Processor> &remote_procs,
+                              std::vector<TaskSlice> &slices) const;
       bool default_create_custom_instances(MapperContext ctx, 
                               Processor target, Memory target_memory,
                               const RegionRequirement &req, unsigned index,
@@ -382,6 +465,15 @@ namespace Legion {
                               PhysicalInstance &result, MappingKind kind,
                               bool force_new, bool meets,
                               const RegionRequirement &req);
+      bool default_find_cached_instance(MapperContext ctx,
+                              Memory target_memory, LogicalRegion region,
+                              const LayoutConstraintSet &constraints,
+                              PhysicalInstance &result);
+      void default_cache_instance(MapperContext ctx, 
+                              Memory target_memory, LogicalRegion region,
+                              const PhysicalInstance &instance);
+      void default_prefetch_next_iteration(MapperContext ctx,
+                              const Task &task, Memory target_memory);
       void default_report_failed_instance_creation(const Task &task, 
                               unsigned index, Processor target_proc, 
                               Memory target_memory) const;
@@ -398,6 +490,29 @@ namespace Legion {
                                       const std::set<LogicalRegion> &regions);
       bool have_proc_kind_variant(const MapperContext ctx, TaskID id,
 				  Processor::Kind kind);
+      void default_advertise_queue_depth(MapperContext ctx);
+      bool default_permit_steal(MapperContext ctx, const Task &task,
+                                Processor thief);
+    protected: // helpers for adaptive mapping, the learned cost lookups
+               // must be called while holding the mapper lock
+      void default_find_problem_size(MapperContext ctx, const Task &task,
+                              size_t &volume, size_t &bytes);
+      bool default_find_learned_time(const Task &task, VariantID variant,
+                              Processor::Kind kind, unsigned size_class,
+                              double &time) const;
+      bool default_find_learned_copy_cost(Memory::Kind src, Memory::Kind dst,
+                              double &ns_per_byte) const;
+      bool default_find_learned_copy_cost(Memory::Kind dst,
+                              double &ns_per_byte) const;
+      void default_rank_learned_processor_kinds(MapperContext ctx,
+                              const Task &task,
+                              std::vector<Processor::Kind> &ranking);
+      void default_request_task_profiling(MapperContext ctx, const Task &task,
+                              VariantID variant, MapTaskOutput &output);
+      void default_read_learned_costs(
+                  std::map<LearnedTaskKey,LearnedCost> &task_costs,
+                  std::map<LearnedCopyKey,LearnedCost> &copy_costs) const;
+      void default_write_learned_costs(void) const;
     protected: // static helper methods
       static const char* create_default_name(Processor p);
       template<int DIM>
@@ -412,6 +527,7 @@ namespace Legion {
                             long long int factor, const LegionRuntime::Arrays::
                             Rect<DIM> &rect_to_factor);
       static unsigned long long compute_task_hash(const Task &task);
+      static unsigned compute_size_class(size_t volume);
       static inline bool physical_sort_func(
                          const std::pair<PhysicalInstance,unsigned> &left,
                          const std::pair<PhysicalInstance,unsigned> &right)
@@ -464,6 +580,13 @@ namespace Legion {
       std::map<std::pair<Memory::Kind,ReductionOpID>,
                LayoutConstraintID>             reduction_constraint_cache;
       std::map<Processor,Memory>               cached_target_memory;
+      // Instances we recently found or made for a region in a memory, most
+      // recent first, so we can skip the runtime's search of the memory
+      std::map<std::pair<Memory,LogicalRegion>,
+               std::list<PhysicalInstance> >   cached_instances;
+      // The regions each point of a traced task used last time around
+      std::map<std::pair<TaskID,DomainPoint>,
+               std::vector<LogicalRegion> >    prefetch_history;
     protected:
       // The maximum number of tasks a mapper will allow to be stolen at a time
       // Controlled by -dm:thefts
@@ -476,8 +599,69 @@ namespace Legion {
       bool breadth_first_traversal;
       // Track whether stealing is enabled
       bool stealing_enabled;
+      // Let the runtime run our mapper calls concurrently instead of one
+      // at a time (see -dm:concurrent)
+      bool concurrent_mapping;
+      // Map the tasks we select in a single map_task_batch call
+      // (see -dm:batch_map)
+      bool batch_mapping;
+      // Put new task instances in zero-copy memory when the framebuffer
+      // is under pressure (see -dm:spill)
+      bool spill_under_pressure;
+      // Warm instances for the inputs of the next iteration of
+      // traced tasks (see -dm:prefetch)
+      bool prefetch_enabled;
+      // Don't let tasks reading more than this many bytes be stolen
+      // by processors on other nodes, zero for no limit
+      // Controlled by -dm:steal_bytes
+      size_t steal_locality_bytes;
       // The maximum number of tasks scheduled per step
       unsigned max_schedule_count;
+      // How many nodes each node forwards the slices of an index space
+      // launch to, zero slices flat from the origin (see -dm:slice_fanout)
+      unsigned slice_fanout;
+      // Map predicated tasks and copies ahead of their predicates
+      // resolving, guessing true (see -dm:speculate)
+      bool speculation_enabled;
+      // Slice index space launches by where valid instances of each 
+      // point's subregions already live (see -dm:locality_slice), 
+      // allowing each memory this percentage more than an even share
+      // of the points (see -dm:locality_tolerance)
+      bool locality_slicing;
+      unsigned locality_tolerance;
+    protected:
+      // Choose processor kinds, variants and target memories from measured
+      // execution and copy times instead of the static preferences
+      // (see -dm:adaptive, enabled implicitly by -dm:learn_file)
+      bool adaptive_mapping;
+      // How many samples a choice needs before its learned time is
+      // trusted, choices with fewer samples are explored first
+      // Controlled by -dm:learn_samples
+      unsigned learn_samples;
+      // File the learned costs are loaded from at startup and merged back
+      // into at shutdown (see -dm:learn_file)
+      std::string learned_costs_file;
+      // Everything known, including what was loaded from the file
+      std::map<LearnedTaskKey,LearnedCost>     learned_task_costs;
+      std::map<LearnedCopyKey,LearnedCost>     learned_copy_costs;
+      // Only what was measured in this run, for merging into the file
+      std::map<LearnedTaskKey,LearnedCost>     measured_task_costs;
+      std::map<LearnedCopyKey,LearnedCost>     measured_copy_costs;
+      // Variant and size class of tasks with outstanding profiling
+      std::map<UniqueID,std::pair<VariantID,unsigned> > profiled_tasks;
+    protected:
+      // Work stealing state, the number of tasks left in our ready queue
+      // after the last pass and what other mappers have told us about theirs
+      unsigned                                 local_queue_depth;
+      unsigned                                 advertised_queue_class;
+      bool                                     saw_ready_tasks;
+      std::map<Processor,unsigned>             remote_queue_depths;
+      // Stealing statistics reported when the mapper is deleted
+      unsigned long long                       steal_requests_sent;
+      unsigned long long                       stolen_tasks_mapped;
+      unsigned long long                       steal_requests_received;
+      unsigned long long                       steal_requests_denied;
+      unsigned long long                       tasks_given_away;
     };
 
   }; // namespace Mapping
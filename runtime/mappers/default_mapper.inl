@@ -52,6 +52,99 @@ namespace Legion {
       }
     }
 
+    //--------------------------------------------------------------------------
+    template<int DIM>
+    void DefaultMapper::default_hierarchical_slice(
+                                         const Rect<DIM> &launch_rect,
+                                         const Rect<DIM> &point_rect,
+                                         const std::vector<Processor> &local,
+                                         const std::vector<Processor> &remote,
+                                         std::vector<TaskSlice> &slices) const
+    //--------------------------------------------------------------------------
+    {
+      // Every mapper blocks the whole launch across the nodes the same
+      // way so each node can tell which nodes its part of the launch
+      // covers by looking at nothing more than the slice it was sent
+      const Point<DIM> node_blocks = 
+        default_select_num_blocks<DIM>(total_nodes, launch_rect);
+      const Point<DIM> num_points = 
+        launch_rect.hi - launch_rect.lo + Point<DIM>::ONES();
+      coord_t block_lo[DIM], block_hi[DIM];
+      for (int i = 0; i < DIM; i++)
+      {
+        const coord_t blocks = node_blocks[i];
+        block_lo[i] = (blocks * (point_rect.lo[i] - launch_rect.lo[i]) + 
+                       blocks - 1) / num_points[i];
+        block_hi[i] = (blocks * (point_rect.hi[i] - launch_rect.lo[i]) +
+                       blocks - 1) / num_points[i];
+      }
+      const Point<DIM> covered_lo(block_lo), covered_hi(block_hi);
+      const Rect<DIM> covered(covered_lo, covered_hi);
+      if (covered.volume() == 1)
+      {
+        // This is our part of the launch so we split it across our
+        // local processors the same way as a flat decomposition would
+        Point<DIM> num_blocks = 
+          default_select_num_blocks<DIM>(local.size(), point_rect);
+        default_decompose_points<DIM>(point_rect, local, num_blocks,
+                  false/*recurse*/, stealing_enabled, slices);
+        return;
+      }
+      // Otherwise split the nodes we cover into at most slice_fanout
+      // groups and send each group's points to the first node in the
+      // group so it can keep slicing them in parallel with us
+      const size_t groups = (covered.volume() < slice_fanout) ? 
+        covered.volume() : slice_fanout;
+      const Point<DIM> group_blocks = 
+        default_select_num_blocks<DIM>(groups, covered);
+      const Point<DIM> covered_blocks = 
+        covered.hi - covered.lo + Point<DIM>::ONES();
+      Rect<DIM> all_groups(Point<DIM>::ZEROES(), 
+                           group_blocks - Point<DIM>::ONES());
+      for (GenericPointInRectIterator<DIM> pir(all_groups); pir; pir++)
+      {
+        const Point<DIM> next = pir.p + Point<DIM>::ONES();
+        const Point<DIM> group_lo = 
+          covered_blocks * pir.p / group_blocks + covered.lo;
+        const Point<DIM> group_hi = 
+          covered_blocks * next / group_blocks + covered.lo - Point<DIM>::ONES();
+        const Rect<DIM> group(group_lo, group_hi);
+        if (group.volume() == 0)
+          continue;
+        // Convert the blocks in the group back into points
+        coord_t lo[DIM], hi[DIM];
+        size_t node = 0;
+        for (int i = 0; i < DIM; i++)
+        {
+          lo[i] = num_points[i] * group_lo[i] / node_blocks[i] + 
+                  launch_rect.lo[i];
+          hi[i] = num_points[i] * (group_hi[i] + 1) / node_blocks[i] +
+                  launch_rect.lo[i] - 1;
+          node = node * node_blocks[i] + group_lo[i];
+        }
+        const Point<DIM> points_lo(lo), points_hi(hi);
+        const Rect<DIM> group_rect = 
+          Rect<DIM>(points_lo, points_hi).intersection(point_rect);
+        if (group_rect.volume() == 0)
+          continue;
+        if ((node == node_id) && (group.volume() == 1))
+        {
+          // Our own node so we can finish the slicing here
+          Point<DIM> num_blocks = 
+            default_select_num_blocks<DIM>(local.size(), group_rect);
+          default_decompose_points<DIM>(group_rect, local, num_blocks,
+                    false/*recurse*/, stealing_enabled, slices);
+          continue;
+        }
+        TaskSlice slice;
+        slice.domain = Domain::from_rect<DIM>(group_rect);
+        slice.proc = (node == node_id) ? local[0] : remote[node];
+        slice.recurse = true;
+        slice.stealable = false;
+        slices.push_back(slice);
+      }
+    }
+
     //--------------------------------------------------------------------------
     template<int DIM>
     /*static*/ Point<DIM> DefaultMapper::default_select_num_blocks( 
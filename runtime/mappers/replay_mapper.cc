@@ -1577,6 +1577,936 @@ namespace Legion {
       memcpy(value, tunable_value, tunable_size);
     }
 
+    /////////////////////////////////////////////////////////////
+    // Record Replay Mapper 
+    /////////////////////////////////////////////////////////////
+
+    // Identifies (and versions) the binary mapping log format
+    static const unsigned MAPPING_LOG_MAGIC = 0x4c4d4c47; // "GLML"
+    static const unsigned MAPPING_LOG_VERSION = 1;
+
+    //--------------------------------------------------------------------------
+    RecordReplayMapper::RecordReplayMapper(MapperRuntime *rt, Mapper *wrapped,
+                                  MapperID map_id, Processor local,
+                                  const char *log_prefix, bool rep)
+      : Mapper(rt), mapper(wrapped), local_proc(local), replay(rep),
+        log_file(NULL), replayed_mappings(0), fallback_mappings(0)
+    //--------------------------------------------------------------------------
+    {
+      const size_t buffer_size = 256;
+      mapper_name = (char*)malloc(buffer_size*sizeof(char));
+      snprintf(mapper_name, buffer_size-1, "%s Mapper (%s)",
+               replay ? "Replay" : "Record", mapper->get_mapper_name());
+      // Every mapper gets its own log so no synchronization is needed
+      // between processors and each log only has the decisions that
+      // this mapper is going to be asked about again
+      char file_name[buffer_size];
+      snprintf(file_name, buffer_size-1, "%s." IDFMT ".%u", 
+               log_prefix, local.id, map_id);
+      if (replay)
+      {
+        FILE *f = fopen(file_name, "rb");
+        if (f == NULL)
+        {
+          log_replay.warning("Unable to open mapping log %s. Mapper %s "
+                             "will not replay any mapping decisions.",
+                             file_name, mapper->get_mapper_name());
+          return;
+        }
+        load_log(f);
+        fclose(f);
+      }
+      else
+      {
+        log_file = fopen(file_name, "wb");
+        if (log_file == NULL)
+        {
+          log_replay.error("Unable to open mapping log %s for writing", 
+                           file_name);
+          assert(false);
+        }
+        pack(log_file, MAPPING_LOG_MAGIC);
+        pack(log_file, MAPPING_LOG_VERSION);
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    RecordReplayMapper::RecordReplayMapper(const RecordReplayMapper &rhs)
+      : Mapper(rhs.runtime), mapper(NULL), local_proc(Processor::NO_PROC),
+        replay(false)
+    //--------------------------------------------------------------------------
+    {
+      // should never be called
+      assert(false);
+    }
+
+    //--------------------------------------------------------------------------
+    RecordReplayMapper::~RecordReplayMapper(void)
+    //--------------------------------------------------------------------------
+    {
+      if (log_file != NULL)
+        fclose(log_file);
+      if (replay)
+        log_replay.info("Mapper %s replayed %ld task mappings and fell back "
+                        "for %ld task mappings", mapper_name,
+                        replayed_mappings, fallback_mappings);
+      free(mapper_name);
+      delete mapper;
+    }
+
+    //--------------------------------------------------------------------------
+    RecordReplayMapper& RecordReplayMapper::operator=(
+                                                  const RecordReplayMapper &rhs)
+    //--------------------------------------------------------------------------
+    {
+      // should never be called
+      assert(false);
+      return *this;
+    }
+
+    //--------------------------------------------------------------------------
+    const char* RecordReplayMapper::get_mapper_name(void) const
+    //--------------------------------------------------------------------------
+    {
+      return mapper_name;
+    }
+
+    //--------------------------------------------------------------------------
+    Mapper::MapperSyncModel RecordReplayMapper::get_mapper_sync_model(
+                                                                    void) const
+    //--------------------------------------------------------------------------
+    {
+      // Our own state is protected with the mapper lock, so we can
+      // run under whatever model the wrapped mapper asks for
+      return mapper->get_mapper_sync_model();
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::select_task_options(const MapperContext ctx,
+                                                 const Task& task,
+                                                 TaskOptions& output)
+    //--------------------------------------------------------------------------
+    {
+      const TaskKey key(task.task_id, task.index_point);
+      if (replay)
+      {
+        bool found = false;
+        runtime->lock_mapper(ctx);
+        const unsigned index = option_counts[key]++;
+        std::map<TaskKey,std::vector<TaskOptions> >::const_iterator finder = 
+          logged_options.find(key);
+        if ((finder != logged_options.end()) && 
+            (index < finder->second.size()))
+        {
+          output = finder->second[index];
+          found = true;
+        }
+        runtime->unlock_mapper(ctx);
+        if (!found)
+          mapper->select_task_options(ctx, task, output);
+        return;
+      }
+      mapper->select_task_options(ctx, task, output);
+      runtime->lock_mapper(ctx);
+      option_counts[key]++;
+      pack(log_file, (unsigned char)TASK_OPTIONS_RECORD);
+      pack_key(log_file, key);
+      pack(log_file, output.initial_proc.id);
+      pack(log_file, output.inline_task);
+      pack(log_file, output.stealable);
+      pack(log_file, output.map_locally);
+      runtime->unlock_mapper(ctx);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::map_task(const MapperContext ctx,
+                                      const Task& task,
+                                      const MapTaskInput& input,
+                                      MapTaskOutput& output)
+    //--------------------------------------------------------------------------
+    {
+      if (replay)
+      {
+        LoggedTaskMapping logged;
+        if (find_logged_mapping(ctx, task, logged))
+        {
+          const std::set<unsigned> premapped(input.premapped_regions.begin(),
+                                             input.premapped_regions.end());
+          if (replay_task_mapping(ctx, task, premapped, logged, output))
+            return;
+        }
+        mapper->map_task(ctx, task, input, output);
+        return;
+      }
+      mapper->map_task(ctx, task, input, output);
+      record_task_mapping(ctx, task, output);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::map_task_batch(const MapperContext ctx,
+                                            const MapTaskBatchInput& input,
+                                            MapTaskBatchOutput& output)
+    //--------------------------------------------------------------------------
+    {
+      if (replay)
+      {
+        MapTaskBatchInput remaining;
+        const std::set<unsigned> premapped;
+        for (std::vector<const Task*>::const_iterator it = 
+              input.tasks.begin(); it != input.tasks.end(); it++)
+        {
+          LoggedTaskMapping logged;
+          if (find_logged_mapping(ctx, *(*it), logged))
+          {
+            MapTaskOutput &task_output = output.task_mappings[*it];
+            task_output.chosen_instances.resize((*it)->regions.size());
+            task_output.chosen_variant = 0;
+            task_output.task_priority = 0;
+            task_output.postmap_task = false;
+            task_output.memoize = false;
+            if (replay_task_mapping(ctx, *(*it), premapped, 
+                                    logged, task_output))
+              continue;
+            output.task_mappings.erase(*it);
+          }
+          remaining.tasks.push_back(*it);
+        }
+        if (!remaining.tasks.empty())
+          mapper->map_task_batch(ctx, remaining, output);
+        return;
+      }
+      mapper->map_task_batch(ctx, input, output);
+      for (std::vector<const Task*>::const_iterator it = 
+            input.tasks.begin(); it != input.tasks.end(); it++)
+      {
+        std::map<const Task*,MapTaskOutput>::const_iterator finder = 
+          output.task_mappings.find(*it);
+        // Tasks the mapper left out are mapped individually later
+        if (finder != output.task_mappings.end())
+          record_task_mapping(ctx, *(*it), finder->second);
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    bool RecordReplayMapper::find_logged_mapping(MapperContext ctx,
+                                 const Task &task, LoggedTaskMapping &logged)
+    //--------------------------------------------------------------------------
+    {
+      const TaskKey key(task.task_id, task.index_point);
+      bool found = false;
+      runtime->lock_mapper(ctx);
+      const unsigned index = mapping_counts[key]++;
+      std::map<TaskKey,std::vector<LoggedTaskMapping> >::const_iterator 
+        finder = logged_mappings.find(key);
+      if ((finder != logged_mappings.end()) && 
+          (index < finder->second.size()))
+      {
+        logged = finder->second[index];
+        found = true;
+      }
+      else
+        fallback_mappings++;
+      runtime->unlock_mapper(ctx);
+      return found;
+    }
+
+    //--------------------------------------------------------------------------
+    bool RecordReplayMapper::replay_task_mapping(MapperContext ctx,
+                                        const Task &task,
+                                        const std::set<unsigned> &premapped,
+                                        const LoggedTaskMapping &logged,
+                                        MapTaskOutput &output)
+    //--------------------------------------------------------------------------
+    {
+      bool success = true;
+      if (logged.target_procs.empty() ||
+          (logged.chosen_instances.size() != task.regions.size()))
+        success = false;
+      // Make sure the variant is still good for the processors
+      if (success)
+      {
+        std::vector<VariantID> variants;
+        runtime->find_valid_variants(ctx, task.task_id, variants,
+                                     logged.target_procs[0].kind());
+        if (std::find(variants.begin(), variants.end(), 
+                      logged.chosen_variant) == variants.end())
+          success = false;
+      }
+      std::vector<std::vector<PhysicalInstance> > chosen_instances(
+                                                        task.regions.size());
+      for (unsigned idx = 0; success && (idx < task.regions.size()); idx++)
+      {
+        if (premapped.find(idx) != premapped.end())
+          continue;
+        const RegionRequirement &req = task.regions[idx];
+        const std::vector<LogicalRegion> regions(1, req.region);
+        std::set<FieldID> covered;
+        bool has_virtual = false;
+        for (std::vector<LoggedInstance>::const_iterator it = 
+              logged.chosen_instances[idx].begin(); it != 
+              logged.chosen_instances[idx].end(); it++)
+        {
+          if (!it->memory.exists())
+          {
+            chosen_instances[idx].push_back(
+                PhysicalInstance::get_virtual_instance());
+            has_virtual = true;
+            continue;
+          }
+          LayoutConstraintSet constraints;
+          constraints.add_constraint(SpecializedConstraint(it->kind,it->redop))
+            .add_constraint(FieldConstraint(it->fields, false/*contiguous*/,
+                                            false/*inorder*/))
+            .add_constraint(OrderingConstraint(it->ordering, it->contiguous));
+          PhysicalInstance result;
+          bool created;
+          // Reduction instances are always made fresh for each task
+          if (it->kind != NORMAL_SPECIALIZE)
+            success = runtime->create_physical_instance(ctx, it->memory,
+                                              constraints, regions, result);
+          else
+            success = runtime->find_or_create_physical_instance(ctx, 
+                              it->memory, constraints, regions, result, created);
+          if (!success)
+            break;
+          chosen_instances[idx].push_back(result);
+          covered.insert(it->fields.begin(), it->fields.end());
+        }
+        // The logged instances must still cover all the fields we need
+        if (success && !has_virtual)
+        {
+          for (std::set<FieldID>::const_iterator it = 
+                req.privilege_fields.begin(); it != 
+                req.privilege_fields.end(); it++)
+          {
+            if (covered.find(*it) != covered.end())
+              continue;
+            success = false;
+            break;
+          }
+        }
+      }
+      runtime->lock_mapper(ctx);
+      if (success)
+        replayed_mappings++;
+      else
+        fallback_mappings++;
+      runtime->unlock_mapper(ctx);
+      // Anything we acquired will be released at the end of the call
+      if (!success)
+        return false;
+      for (unsigned idx = 0; idx < task.regions.size(); idx++)
+        if (premapped.find(idx) == premapped.end())
+          output.chosen_instances[idx] = chosen_instances[idx];
+      output.target_procs = logged.target_procs;
+      output.chosen_variant = logged.chosen_variant;
+      output.task_priority = logged.task_priority;
+      output.postmap_task = logged.postmap_task;
+      output.memoize = logged.memoize;
+      return true;
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::record_task_mapping(MapperContext ctx,
+                                const Task &task, const MapTaskOutput &output)
+    //--------------------------------------------------------------------------
+    {
+      // Capture the layouts before taking the lock since looking
+      // up the constraints is a call into the runtime
+      LoggedTaskMapping logged;
+      logged.target_procs = output.target_procs;
+      logged.chosen_variant = output.chosen_variant;
+      logged.task_priority = output.task_priority;
+      logged.postmap_task = output.postmap_task;
+      logged.memoize = output.memoize;
+      logged.chosen_instances.resize(output.chosen_instances.size());
+      for (unsigned idx = 0; idx < output.chosen_instances.size(); idx++)
+      {
+        const std::vector<PhysicalInstance> &instances = 
+          output.chosen_instances[idx];
+        logged.chosen_instances[idx].resize(instances.size());
+        for (unsigned idx2 = 0; idx2 < instances.size(); idx2++)
+        {
+          LoggedInstance &info = logged.chosen_instances[idx][idx2];
+          if (instances[idx2].is_virtual_instance())
+          {
+            info.memory = Memory::NO_MEMORY;
+            info.kind = NORMAL_SPECIALIZE;
+            info.redop = 0;
+            info.contiguous = false;
+            continue;
+          }
+          info.memory = instances[idx2].get_location();
+          const LayoutConstraintSet &constraints = 
+            runtime->find_layout_constraints(ctx, 
+                                      instances[idx2].get_layout_id());
+          info.kind = constraints.specialized_constraint.get_kind();
+          info.redop = constraints.specialized_constraint.get_reduction_op();
+          info.ordering = constraints.ordering_constraint.ordering;
+          info.contiguous = constraints.ordering_constraint.contiguous;
+          std::set<FieldID> fields;
+          instances[idx2].get_fields(fields);
+          info.fields.insert(info.fields.end(), fields.begin(), fields.end());
+        }
+      }
+      const TaskKey key(task.task_id, task.index_point);
+      runtime->lock_mapper(ctx);
+      mapping_counts[key]++;
+      pack(log_file, (unsigned char)MAP_TASK_RECORD);
+      pack_key(log_file, key);
+      pack_mapping(log_file, logged);
+      runtime->unlock_mapper(ctx);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::load_log(FILE *f)
+    //--------------------------------------------------------------------------
+    {
+      unsigned magic = 0, version = 0;
+      if (!unpack(f, magic) || !unpack(f, version) || 
+          (magic != MAPPING_LOG_MAGIC) || (version != MAPPING_LOG_VERSION))
+      {
+        log_replay.warning("Mapping log for mapper %s is not a valid mapping "
+                           "log. No mapping decisions will be replayed.",
+                           mapper->get_mapper_name());
+        return;
+      }
+      unsigned char kind;
+      while (unpack(f, kind))
+      {
+        TaskKey key;
+        if (!unpack_key(f, key))
+          break;
+        if (kind == TASK_OPTIONS_RECORD)
+        {
+          TaskOptions options;
+          if (!unpack(f, options.initial_proc.id) || 
+              !unpack(f, options.inline_task) ||
+              !unpack(f, options.stealable) || 
+              !unpack(f, options.map_locally))
+            break;
+          logged_options[key].push_back(options);
+        }
+        else if (kind == MAP_TASK_RECORD)
+        {
+          std::vector<LoggedTaskMapping> &mappings = logged_mappings[key];
+          mappings.resize(mappings.size() + 1);
+          if (!unpack_mapping(f, mappings.back()))
+          {
+            mappings.pop_back();
+            break;
+          }
+        }
+        else
+          break;
+      }
+      // A truncated log (e.g. from a run that crashed) is still useful
+      // for everything that was written out completely
+      if (!feof(f))
+        log_replay.warning("Ignoring the malformed tail of the mapping log "
+                           "for mapper %s", mapper->get_mapper_name());
+    }
+
+    //--------------------------------------------------------------------------
+    /*static*/ void RecordReplayMapper::pack_key(FILE *f, const TaskKey &key)
+    //--------------------------------------------------------------------------
+    {
+      pack(f, key.first);
+      pack(f, key.second.dim);
+      for (int idx = 0; idx < key.second.dim; idx++)
+        pack(f, key.second.point_data[idx]);
+    }
+
+    //--------------------------------------------------------------------------
+    /*static*/ bool RecordReplayMapper::unpack_key(FILE *f, TaskKey &key)
+    //--------------------------------------------------------------------------
+    {
+      if (!unpack(f, key.first) || !unpack(f, key.second.dim))
+        return false;
+      if ((key.second.dim < 0) || (key.second.dim > DomainPoint::MAX_POINT_DIM))
+        return false;
+      for (int idx = 0; idx < key.second.dim; idx++)
+        if (!unpack(f, key.second.point_data[idx]))
+          return false;
+      return true;
+    }
+
+    //--------------------------------------------------------------------------
+    /*static*/ void RecordReplayMapper::pack_mapping(FILE *f,
+                                            const LoggedTaskMapping &mapping)
+    //--------------------------------------------------------------------------
+    {
+      pack(f, (unsigned)mapping.target_procs.size());
+      for (std::vector<Processor>::const_iterator it = 
+            mapping.target_procs.begin(); it != 
+            mapping.target_procs.end(); it++)
+        pack(f, it->id);
+      pack(f, mapping.chosen_variant);
+      pack(f, mapping.task_priority);
+      pack(f, mapping.postmap_task);
+      pack(f, mapping.memoize);
+      pack(f, (unsigned)mapping.chosen_instances.size());
+      for (unsigned idx = 0; idx < mapping.chosen_instances.size(); idx++)
+      {
+        const std::vector<LoggedInstance> &instances = 
+          mapping.chosen_instances[idx];
+        pack(f, (unsigned)instances.size());
+        for (std::vector<LoggedInstance>::const_iterator it = 
+              instances.begin(); it != instances.end(); it++)
+        {
+          pack(f, it->memory.id);
+          if (!it->memory.exists())
+            continue;
+          pack(f, (int)it->kind);
+          pack(f, it->redop);
+          pack(f, it->contiguous);
+          pack(f, (unsigned)it->ordering.size());
+          for (unsigned idx2 = 0; idx2 < it->ordering.size(); idx2++)
+            pack(f, (int)it->ordering[idx2]);
+          pack(f, (unsigned)it->fields.size());
+          for (unsigned idx2 = 0; idx2 < it->fields.size(); idx2++)
+            pack(f, it->fields[idx2]);
+        }
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    /*static*/ bool RecordReplayMapper::unpack_mapping(FILE *f,
+                                                  LoggedTaskMapping &mapping)
+    //--------------------------------------------------------------------------
+    {
+      unsigned num_procs;
+      if (!unpack(f, num_procs))
+        return false;
+      mapping.target_procs.resize(num_procs);
+      for (unsigned idx = 0; idx < num_procs; idx++)
+        if (!unpack(f, mapping.target_procs[idx].id))
+          return false;
+      unsigned num_regions;
+      if (!unpack(f, mapping.chosen_variant) || 
+          !unpack(f, mapping.task_priority) ||
+          !unpack(f, mapping.postmap_task) || !unpack(f, mapping.memoize) ||
+          !unpack(f, num_regions))
+        return false;
+      mapping.chosen_instances.resize(num_regions);
+      for (unsigned idx = 0; idx < num_regions; idx++)
+      {
+        unsigned num_instances;
+        if (!unpack(f, num_instances))
+          return false;
+        std::vector<LoggedInstance> &instances = mapping.chosen_instances[idx];
+        instances.resize(num_instances);
+        for (unsigned idx2 = 0; idx2 < num_instances; idx2++)
+        {
+          LoggedInstance &info = instances[idx2];
+          info.kind = NORMAL_SPECIALIZE;
+          info.redop = 0;
+          info.contiguous = false;
+          if (!unpack(f, info.memory.id))
+            return false;
+          if (!info.memory.exists())
+            continue;
+          int kind;
+          unsigned num_dims, num_fields;
+          if (!unpack(f, kind) || !unpack(f, info.redop) || 
+              !unpack(f, info.contiguous) || !unpack(f, num_dims))
+            return false;
+          info.kind = (SpecializedKind)kind;
+          info.ordering.resize(num_dims);
+          for (unsigned idx3 = 0; idx3 < num_dims; idx3++)
+          {
+            int dim;
+            if (!unpack(f, dim))
+              return false;
+            info.ordering[idx3] = (DimensionKind)dim;
+          }
+          if (!unpack(f, num_fields))
+            return false;
+          info.fields.resize(num_fields);
+          for (unsigned idx3 = 0; idx3 < num_fields; idx3++)
+            if (!unpack(f, info.fields[idx3]))
+              return false;
+        }
+      }
+      return true;
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::premap_task(const MapperContext ctx,
+                                         const Task& task,
+                                         const PremapTaskInput& input,
+                                         PremapTaskOutput& output)
+    //--------------------------------------------------------------------------
+    {
+      mapper->premap_task(ctx, task, input, output);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::slice_task(const MapperContext ctx,
+                                        const Task& task,
+                                        const SliceTaskInput& input,
+                                        SliceTaskOutput& output)
+    //--------------------------------------------------------------------------
+    {
+      mapper->slice_task(ctx, task, input, output);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::select_task_variant(
+                                    const MapperContext ctx,
+                                    const Task& task,
+                                    const SelectVariantInput& input,
+                                    SelectVariantOutput& output)
+    //--------------------------------------------------------------------------
+    {
+      mapper->select_task_variant(ctx, task, input, output);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::postmap_task(const MapperContext ctx,
+                                          const Task& task,
+                                          const PostMapInput& input,
+                                          PostMapOutput& output)
+    //--------------------------------------------------------------------------
+    {
+      mapper->postmap_task(ctx, task, input, output);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::select_task_sources(
+                                    const MapperContext ctx,
+                                    const Task& task,
+                                    const SelectTaskSrcInput& input,
+                                    SelectTaskSrcOutput& output)
+    //--------------------------------------------------------------------------
+    {
+      mapper->select_task_sources(ctx, task, input, output);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::create_task_temporary_instance(
+                                    const MapperContext ctx,
+                                    const Task& task,
+                                    const CreateTaskTemporaryInput& input,
+                                    CreateTaskTemporaryOutput& output)
+    //--------------------------------------------------------------------------
+    {
+      mapper->create_task_temporary_instance(ctx, task, input, output);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::speculate(const MapperContext ctx,
+                                       const Task& task,
+                                       SpeculativeOutput& output)
+    //--------------------------------------------------------------------------
+    {
+      mapper->speculate(ctx, task, output);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::report_profiling(const MapperContext ctx,
+                                              const Task& task,
+                                              const TaskProfilingInfo& input)
+    //--------------------------------------------------------------------------
+    {
+      mapper->report_profiling(ctx, task, input);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::map_inline(const MapperContext ctx,
+                                        const InlineMapping& inline_op,
+                                        const MapInlineInput& input,
+                                        MapInlineOutput& output)
+    //--------------------------------------------------------------------------
+    {
+      mapper->map_inline(ctx, inline_op, input, output);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::select_inline_sources(
+                                    const MapperContext ctx,
+                                    const InlineMapping& inline_op,
+                                    const SelectInlineSrcInput& input,
+                                    SelectInlineSrcOutput& output)
+    //--------------------------------------------------------------------------
+    {
+      mapper->select_inline_sources(ctx, inline_op, input, output);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::create_inline_temporary_instance(
+                                    const MapperContext ctx,
+                                    const InlineMapping& inline_op,
+                                    const CreateInlineTemporaryInput& input,
+                                    CreateInlineTemporaryOutput& output)
+    //--------------------------------------------------------------------------
+    {
+      mapper->create_inline_temporary_instance(ctx, inline_op, input, output);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::report_profiling(const MapperContext ctx,
+                                              const InlineMapping& inline_op,
+                                              const InlineProfilingInfo& input)
+    //--------------------------------------------------------------------------
+    {
+      mapper->report_profiling(ctx, inline_op, input);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::map_copy(const MapperContext ctx,
+                                      const Copy& copy,
+                                      const MapCopyInput& input,
+                                      MapCopyOutput& output)
+    //--------------------------------------------------------------------------
+    {
+      mapper->map_copy(ctx, copy, input, output);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::select_copy_sources(
+                                    const MapperContext ctx,
+                                    const Copy& copy,
+                                    const SelectCopySrcInput& input,
+                                    SelectCopySrcOutput& output)
+    //--------------------------------------------------------------------------
+    {
+      mapper->select_copy_sources(ctx, copy, input, output);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::create_copy_temporary_instance(
+                                    const MapperContext ctx,
+                                    const Copy& copy,
+                                    const CreateCopyTemporaryInput& input,
+                                    CreateCopyTemporaryOutput& output)
+    //--------------------------------------------------------------------------
+    {
+      mapper->create_copy_temporary_instance(ctx, copy, input, output);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::speculate(const MapperContext ctx,
+                                       const Copy& copy,
+                                       SpeculativeOutput& output)
+    //--------------------------------------------------------------------------
+    {
+      mapper->speculate(ctx, copy, output);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::report_profiling(const MapperContext ctx,
+                                              const Copy& copy,
+                                              const CopyProfilingInfo& input)
+    //--------------------------------------------------------------------------
+    {
+      mapper->report_profiling(ctx, copy, input);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::map_close(const MapperContext ctx,
+                                       const Close& close,
+                                       const MapCloseInput& input,
+                                       MapCloseOutput& output)
+    //--------------------------------------------------------------------------
+    {
+      mapper->map_close(ctx, close, input, output);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::select_close_sources(
+                                    const MapperContext ctx,
+                                    const Close& close,
+                                    const SelectCloseSrcInput& input,
+                                    SelectCloseSrcOutput& output)
+    //--------------------------------------------------------------------------
+    {
+      mapper->select_close_sources(ctx, close, input, output);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::create_close_temporary_instance(
+                                    const MapperContext ctx,
+                                    const Close& close,
+                                    const CreateCloseTemporaryInput& input,
+                                    CreateCloseTemporaryOutput& output)
+    //--------------------------------------------------------------------------
+    {
+      mapper->create_close_temporary_instance(ctx, close, input, output);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::report_profiling(const MapperContext ctx,
+                                              const Close& close,
+                                              const CloseProfilingInfo& input)
+    //--------------------------------------------------------------------------
+    {
+      mapper->report_profiling(ctx, close, input);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::map_acquire(const MapperContext ctx,
+                                         const Acquire& acquire,
+                                         const MapAcquireInput& input,
+                                         MapAcquireOutput& output)
+    //--------------------------------------------------------------------------
+    {
+      mapper->map_acquire(ctx, acquire, input, output);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::speculate(const MapperContext ctx,
+                                       const Acquire& acquire,
+                                       SpeculativeOutput& output)
+    //--------------------------------------------------------------------------
+    {
+      mapper->speculate(ctx, acquire, output);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::report_profiling(const MapperContext ctx,
+                                              const Acquire& acquire,
+                                              const AcquireProfilingInfo& input)
+    //--------------------------------------------------------------------------
+    {
+      mapper->report_profiling(ctx, acquire, input);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::map_release(const MapperContext ctx,
+                                         const Release& release,
+                                         const MapReleaseInput& input,
+                                         MapReleaseOutput& output)
+    //--------------------------------------------------------------------------
+    {
+      mapper->map_release(ctx, release, input, output);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::select_release_sources(
+                                    const MapperContext ctx,
+                                    const Release& release,
+                                    const SelectReleaseSrcInput& input,
+                                    SelectReleaseSrcOutput& output)
+    //--------------------------------------------------------------------------
+    {
+      mapper->select_release_sources(ctx, release, input, output);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::create_release_temporary_instance(
+                                    const MapperContext ctx,
+                                    const Release& release,
+                                    const CreateReleaseTemporaryInput& input,
+                                    CreateReleaseTemporaryOutput& output)
+    //--------------------------------------------------------------------------
+    {
+      mapper->create_release_temporary_instance(ctx, release, input, output);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::speculate(const MapperContext ctx,
+                                       const Release& release,
+                                       SpeculativeOutput& output)
+    //--------------------------------------------------------------------------
+    {
+      mapper->speculate(ctx, release, output);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::report_profiling(const MapperContext ctx,
+                                              const Release& release,
+                                              const ReleaseProfilingInfo& input)
+    //--------------------------------------------------------------------------
+    {
+      mapper->report_profiling(ctx, release, input);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::configure_context(const MapperContext ctx,
+                                               const Task& task,
+                                               ContextConfigOutput& output)
+    //--------------------------------------------------------------------------
+    {
+      mapper->configure_context(ctx, task, output);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::select_tunable_value(
+                                    const MapperContext ctx,
+                                    const Task& task,
+                                    const SelectTunableInput& input,
+                                    SelectTunableOutput& output)
+    //--------------------------------------------------------------------------
+    {
+      mapper->select_tunable_value(ctx, task, input, output);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::map_must_epoch(const MapperContext ctx,
+                                            const MapMustEpochInput& input,
+                                            MapMustEpochOutput& output)
+    //--------------------------------------------------------------------------
+    {
+      mapper->map_must_epoch(ctx, input, output);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::map_dataflow_graph(
+                                    const MapperContext ctx,
+                                    const MapDataflowGraphInput& input,
+                                    MapDataflowGraphOutput& output)
+    //--------------------------------------------------------------------------
+    {
+      mapper->map_dataflow_graph(ctx, input, output);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::select_tasks_to_map(
+                                    const MapperContext ctx,
+                                    const SelectMappingInput& input,
+                                    SelectMappingOutput& output)
+    //--------------------------------------------------------------------------
+    {
+      mapper->select_tasks_to_map(ctx, input, output);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::select_steal_targets(
+                                    const MapperContext ctx,
+                                    const SelectStealingInput& input,
+                                    SelectStealingOutput& output)
+    //--------------------------------------------------------------------------
+    {
+      mapper->select_steal_targets(ctx, input, output);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::permit_steal_request(
+                                    const MapperContext ctx,
+                                    const StealRequestInput& input,
+                                    StealRequestOutput& output)
+    //--------------------------------------------------------------------------
+    {
+      mapper->permit_steal_request(ctx, input, output);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::handle_message(const MapperContext ctx,
+                                            const MapperMessage& message)
+    //--------------------------------------------------------------------------
+    {
+      mapper->handle_message(ctx, message);
+    }
+
+    //--------------------------------------------------------------------------
+    void RecordReplayMapper::handle_task_result(const MapperContext ctx,
+                                                const MapperTaskResult& result)
+    //--------------------------------------------------------------------------
+    {
+      mapper->handle_task_result(ctx, result);
+    }
+
   }; // namespace Mapping 
 }; // namespace Legion
 
@@ -19,6 +19,7 @@
 #include "legion.h"
 #include "legion_mapping.h"
 
+#include <cstdio>
 #include <cstdlib>
 #include <cassert>
 #include <algorithm>
@@ -350,6 +351,252 @@ namespace Legion {
       std::map<unsigned long/*current*/,MapperEvent>     pending_instance_ids;
     };
 
+    /**
+     * \class RecordReplayMapper
+     * The record-replay mapper wraps any other mapper and either
+     * records the task mapping decisions that it makes into a compact
+     * binary log, or replays the decisions from a log recorded by an
+     * earlier run. Unlike the ReplayMapper it does not need LegionSpy
+     * and it can be used for production runs: when replaying, tasks
+     * that match a logged decision are mapped without invoking any of
+     * the policy in the wrapped mapper. Tasks are matched by their task
+     * ID, index point, and the number of times that point has been
+     * mapped before. Any task without a matching decision, or whose
+     * logged decision can no longer be satisfied, falls back to the
+     * wrapped mapper. The runtime installs it around every mapper when
+     * either -lg:record_mappings or -lg:replay_mappings is passed.
+     */
+    class RecordReplayMapper : public Mapper {
+    public:
+      enum RecordKind {
+        TASK_OPTIONS_RECORD = 1,
+        MAP_TASK_RECORD = 2,
+      };
+      struct LoggedInstance {
+      public:
+        Memory memory; // NO_MEMORY for virtual instances
+        SpecializedKind kind;
+        ReductionOpID redop;
+        std::vector<DimensionKind> ordering;
+        bool contiguous;
+        std::vector<FieldID> fields;
+      };
+      struct LoggedTaskMapping {
+      public:
+        std::vector<Processor> target_procs;
+        VariantID chosen_variant;
+        TaskPriority task_priority;
+        bool postmap_task;
+        bool memoize;
+        std::vector<std::vector<LoggedInstance> > chosen_instances;
+      };
+      typedef std::pair<TaskID,DomainPoint> TaskKey;
+    public:
+      RecordReplayMapper(MapperRuntime *rt, Mapper *mapper, MapperID map_id,
+                         Processor local, const char *log_prefix, bool replay);
+      RecordReplayMapper(const RecordReplayMapper &rhs);
+      virtual ~RecordReplayMapper(void);
+    public:
+      RecordReplayMapper& operator=(const RecordReplayMapper &rhs);
+    public:
+      virtual const char* get_mapper_name(void) const;
+      virtual MapperSyncModel get_mapper_sync_model(void) const;
+    public: // Task mapping calls
+      virtual void select_task_options(const MapperContext    ctx,
+                                       const Task&            task,
+                                             TaskOptions&     output);
+      virtual void premap_task(const MapperContext      ctx,
+                               const Task&              task, 
+                               const PremapTaskInput&   input,
+                               PremapTaskOutput&        output);
+      virtual void slice_task(const MapperContext      ctx,
+                              const Task&              task, 
+                              const SliceTaskInput&    input,
+                                    SliceTaskOutput&   output);
+      virtual void map_task(const MapperContext      ctx,
+                            const Task&              task,
+                            const MapTaskInput&      input,
+                                  MapTaskOutput&     output);
+      virtual void select_task_variant(const MapperContext          ctx,
+                                       const Task&                  task,
+                                       const SelectVariantInput&    input,
+                                             SelectVariantOutput&   output);
+      virtual void postmap_task(const MapperContext      ctx,
+                                const Task&              task,
+                                const PostMapInput&      input,
+                                      PostMapOutput&     output);
+      virtual void select_task_sources(const MapperContext        ctx,
+                                       const Task&                task,
+                                       const SelectTaskSrcInput&  input,
+                                             SelectTaskSrcOutput& output);
+      virtual void create_task_temporary_instance(
+                                    const MapperContext              ctx,
+                                    const Task&                      task,
+                                    const CreateTaskTemporaryInput&  input,
+                                          CreateTaskTemporaryOutput& output);
+      virtual void speculate(const MapperContext      ctx,
+                             const Task&              task,
+                                   SpeculativeOutput& output);
+      virtual void report_profiling(const MapperContext      ctx,
+                                    const Task&              task,
+                                    const TaskProfilingInfo& input);
+    public: // Inline mapping calls
+      virtual void map_inline(const MapperContext        ctx,
+                              const InlineMapping&       inline_op,
+                              const MapInlineInput&      input,
+                                    MapInlineOutput&     output);
+      virtual void select_inline_sources(const MapperContext        ctx,
+                                       const InlineMapping&         inline_op,
+                                       const SelectInlineSrcInput&  input,
+                                             SelectInlineSrcOutput& output);
+      virtual void create_inline_temporary_instance(
+                                  const MapperContext                ctx,
+                                  const InlineMapping&               inline_op,
+                                  const CreateInlineTemporaryInput&  input,
+                                        CreateInlineTemporaryOutput& output);
+      virtual void report_profiling(const MapperContext         ctx,
+                                    const InlineMapping&        inline_op,
+                                    const InlineProfilingInfo&  input);
+    public: // Copy mapping calls
+      virtual void map_copy(const MapperContext      ctx,
+                            const Copy&              copy,
+                            const MapCopyInput&      input,
+                                  MapCopyOutput&     output);
+      virtual void select_copy_sources(const MapperContext          ctx,
+                                       const Copy&                  copy,
+                                       const SelectCopySrcInput&    input,
+                                             SelectCopySrcOutput&   output);
+      virtual void create_copy_temporary_instance(
+                                  const MapperContext              ctx,
+                                  const Copy&                      copy,
+                                  const CreateCopyTemporaryInput&  input,
+                                        CreateCopyTemporaryOutput& output);
+      virtual void speculate(const MapperContext      ctx,
+                             const Copy& copy,
+                                   SpeculativeOutput& output);
+      virtual void report_profiling(const MapperContext      ctx,
+                                    const Copy&              copy,
+                                    const CopyProfilingInfo& input);
+    public: // Close mapping calls
+      virtual void map_close(const MapperContext       ctx,
+                             const Close&              close,
+                             const MapCloseInput&      input,
+                                   MapCloseOutput&     output);
+      virtual void select_close_sources(const MapperContext        ctx,
+                                        const Close&               close,
+                                        const SelectCloseSrcInput&  input,
+                                              SelectCloseSrcOutput& output);
+      virtual void create_close_temporary_instance(
+                                  const MapperContext               ctx,
+                                  const Close&                      close,
+                                  const CreateCloseTemporaryInput&  input,
+                                        CreateCloseTemporaryOutput& output);
+      virtual void report_profiling(const MapperContext       ctx,
+                                    const Close&              close,
+                                    const CloseProfilingInfo& input);
+    public: // Acquire mapping calls
+      virtual void map_acquire(const MapperContext         ctx,
+                               const Acquire&              acquire,
+                               const MapAcquireInput&      input,
+                                     MapAcquireOutput&     output);
+      virtual void speculate(const MapperContext         ctx,
+                             const Acquire&              acquire,
+                                   SpeculativeOutput&    output);
+      virtual void report_profiling(const MapperContext         ctx,
+                                    const Acquire&              acquire,
+                                    const AcquireProfilingInfo& input);
+    public: // Release mapping calls
+      virtual void map_release(const MapperContext         ctx,
+                               const Release&              release,
+                               const MapReleaseInput&      input,
+                                     MapReleaseOutput&     output);
+      virtual void select_release_sources(const MapperContext       ctx,
+                                     const Release&                 release,
+                                     const SelectReleaseSrcInput&   input,
+                                           SelectReleaseSrcOutput&  output);
+      virtual void create_release_temporary_instance(
+                                   const MapperContext                 ctx,
+                                   const Release&                      release,
+                                   const CreateReleaseTemporaryInput&  input,
+                                         CreateReleaseTemporaryOutput& output);
+      virtual void speculate(const MapperContext         ctx,
+                             const Release&              release,
+                                   SpeculativeOutput&    output);
+      virtual void report_profiling(const MapperContext         ctx,
+                                    const Release&              release,
+                                    const ReleaseProfilingInfo& input);
+    public: // Task execution mapping calls
+      virtual void configure_context(const MapperContext         ctx,
+                                     const Task&                 task,
+                                           ContextConfigOutput&  output);
+      virtual void select_tunable_value(const MapperContext         ctx,
+                                        const Task&                 task,
+                                        const SelectTunableInput&   input,
+                                              SelectTunableOutput&  output);
+    public: // Must epoch mapping
+      virtual void map_must_epoch(const MapperContext           ctx,
+                                  const MapMustEpochInput&      input,
+                                        MapMustEpochOutput&     output);
+    public: // Dataflow graph mapping
+      virtual void map_dataflow_graph(const MapperContext           ctx,
+                                      const MapDataflowGraphInput&  input,
+                                            MapDataflowGraphOutput& output);
+    public: // Mapping control and stealing
+      virtual void select_tasks_to_map(const MapperContext          ctx,
+                                       const SelectMappingInput&    input,
+                                             SelectMappingOutput&   output);
+      virtual void map_task_batch(const MapperContext          ctx,
+                                  const MapTaskBatchInput&     input,
+                                        MapTaskBatchOutput&    output);
+      virtual void select_steal_targets(const MapperContext         ctx,
+                                        const SelectStealingInput&  input,
+                                              SelectStealingOutput& output);
+      virtual void permit_steal_request(const MapperContext         ctx,
+                                        const StealRequestInput&    input,
+                                              StealRequestOutput&   output);
+    public: // handling
+      virtual void handle_message(const MapperContext           ctx,
+                                  const MapperMessage&          message);
+      virtual void handle_task_result(const MapperContext           ctx,
+                                      const MapperTaskResult&       result);
+    protected:
+      bool replay_task_mapping(MapperContext ctx, const Task &task,
+                               const std::set<unsigned> &premapped,
+                               const LoggedTaskMapping &logged,
+                               MapTaskOutput &output);
+      void record_task_mapping(MapperContext ctx, const Task &task,
+                               const MapTaskOutput &output);
+      bool find_logged_mapping(MapperContext ctx, const Task &task,
+                               LoggedTaskMapping &logged);
+    protected:
+      void load_log(FILE *f);
+      static void pack_key(FILE *f, const TaskKey &key);
+      static bool unpack_key(FILE *f, TaskKey &key);
+      static void pack_mapping(FILE *f, const LoggedTaskMapping &mapping);
+      static bool unpack_mapping(FILE *f, LoggedTaskMapping &mapping);
+      template<typename T>
+      static inline void pack(FILE *f, const T &value)
+        { ignore_result(fwrite(&value, sizeof(value), 1, f)); }
+      template<typename T>
+      static inline bool unpack(FILE *f, T &value)
+        { return (fread(&value, sizeof(value), 1, f) == 1); }
+      template<typename T>
+      static inline void ignore_result(T arg) { }
+    protected:
+      Mapper *const mapper;
+      const Processor local_proc;
+      const bool replay;
+      char *mapper_name;
+      FILE *log_file;
+    protected:
+      std::map<TaskKey,unsigned>                          option_counts;
+      std::map<TaskKey,unsigned>                          mapping_counts;
+      std::map<TaskKey,std::vector<TaskOptions> >         logged_options;
+      std::map<TaskKey,std::vector<LoggedTaskMapping> >   logged_mappings;
+      unsigned long                                       replayed_mappings;
+      unsigned long                                       fallback_mappings;
+    };
+
   }; // namespace Mapping
 }; // namespace Legion
 
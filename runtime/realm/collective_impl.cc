@@ -0,0 +1,337 @@
+/* Copyright 2017 Stanford University, NVIDIA Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// collective operations (broadcast/allgather/allreduce) over active messages
+
+#include "collective_impl.h"
+
+#include "logging.h"
+
+#include <string.h>
+#include <assert.h>
+
+#include <algorithm>
+
+namespace Realm {
+
+  extern Logger log_collective;
+
+  static GASNetHSL collective_mutex;
+  static std::map<unsigned, CollectiveOp *> collective_ops;
+  static unsigned next_collective_seq = 0;
+
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class CollectiveOp
+  //
+
+  CollectiveOp::CollectiveOp(unsigned _seq)
+    : seq(_seq), started(false), kind(COLL_BROADCAST), root(0), bytes(0)
+    , dst(0), redop(0), redop_count(0)
+    , num_steps(0), steps_sent(0), steps_received(0)
+  {
+    done = UserEvent::create_user_event();
+  }
+
+  CollectiveOp::~CollectiveOp(void)
+  {}
+
+  bool CollectiveOp::start(Kind _kind, gasnet_node_t _root, const void *src,
+			   void *_dst, size_t _bytes,
+			   std::vector<Outgoing>& to_send)
+  {
+    assert(!started);
+    started = true;
+    kind = _kind;
+    root = _root;
+    dst = _dst;
+    bytes = _bytes;
+
+    unsigned num_nodes = gasnet_nodes();
+    unsigned me = gasnet_mynode();
+
+    switch(kind) {
+    case COLL_ALLGATHER:
+      {
+	blocks.resize(num_nodes * bytes);
+	if(bytes > 0)
+	  memcpy(&blocks[0], src, bytes);
+	for(unsigned d = 1; d < num_nodes; d <<= 1)
+	  num_steps++;
+	break;
+      }
+
+    case COLL_BROADCAST:
+      {
+	// the root has its data already - everybody else waits for a single
+	//  message from their parent in the tree
+	num_steps = 1;
+	if(me == root) {
+	  if(bytes > 0)
+	    memcpy(dst, src, bytes);
+	  steps_received = 1;
+	}
+	break;
+      }
+    }
+
+    return make_progress(to_send);
+  }
+
+  bool CollectiveOp::receive(int step, const void *data, size_t datalen,
+			     std::vector<Outgoing>& to_send)
+  {
+    assert(early.count(step) == 0);
+    early[step].assign((const char *)data, (const char *)data + datalen);
+    if(!started)
+      return false;
+    return make_progress(to_send);
+  }
+
+  bool CollectiveOp::make_progress(std::vector<Outgoing>& to_send)
+  {
+    unsigned num_nodes = gasnet_nodes();
+    unsigned me = gasnet_mynode();
+
+    if(kind == COLL_BROADCAST) {
+      if(steps_received == 0) {
+	std::map<int, std::vector<char> >::iterator it = early.find(0);
+	if(it == early.end())
+	  return false;
+	assert(it->second.size() == bytes);
+	if(bytes > 0)
+	  memcpy(dst, &(it->second[0]), bytes);
+	early.erase(it);
+	steps_received = 1;
+      }
+
+      // binomial tree on ranks relative to the root: we received from the
+      //  rank with our lowest set bit cleared, and forward to the ranks
+      //  we get by setting each of the bits below that one
+      unsigned rel = (me + num_nodes - root) % num_nodes;
+      unsigned mask = 1;
+      while((mask < num_nodes) && !(rel & mask))
+	mask <<= 1;
+      for(mask >>= 1; mask > 0; mask >>= 1)
+	if((rel + mask) < num_nodes) {
+	  to_send.push_back(Outgoing());
+	  Outgoing& o = to_send.back();
+	  o.target = (rel + mask + root) % num_nodes;
+	  o.step = 0;
+	  o.data.assign((const char *)dst, (const char *)dst + bytes);
+	}
+      finish();
+      return true;
+    }
+
+    // allgather: in step k, with d = 2^k, we already have the blocks of
+    //  nodes me .. me+d-1, send them to me-d, and get those of nodes
+    //  me+d .. me+2d-1 from me+d
+    while(true) {
+      if((steps_sent == steps_received) && (steps_sent < num_steps)) {
+	unsigned d = 1U << steps_sent;
+	unsigned count = std::min(d, num_nodes - d);
+	to_send.push_back(Outgoing());
+	Outgoing& o = to_send.back();
+	o.target = (me + num_nodes - d) % num_nodes;
+	o.step = steps_sent;
+	if(bytes > 0)
+	  o.data.assign(&blocks[0], &blocks[0] + (count * bytes));
+	steps_sent++;
+	continue;
+      }
+
+      if(steps_received < steps_sent) {
+	std::map<int, std::vector<char> >::iterator it = early.find(steps_received);
+	if(it == early.end())
+	  break;
+	unsigned d = 1U << steps_received;
+	unsigned count = std::min(d, num_nodes - d);
+	assert(it->second.size() == (count * bytes));
+	if(bytes > 0)
+	  memcpy(&blocks[d * bytes], &(it->second[0]), count * bytes);
+	early.erase(it);
+	steps_received++;
+	continue;
+      }
+
+      break;
+    }
+
+    if(steps_received < num_steps)
+      return false;
+
+    finish();
+    return true;
+  }
+
+  void CollectiveOp::finish(void)
+  {
+    if(kind != COLL_ALLGATHER)
+      return;
+
+    unsigned num_nodes = gasnet_nodes();
+    unsigned me = gasnet_mynode();
+
+    // undo the rotation so that blocks are in node order
+    char *out = (char *)dst;
+    std::vector<char> gathered;
+    if(redop) {
+      gathered.resize(num_nodes * bytes);
+      out = (bytes > 0) ? &gathered[0] : 0;
+    }
+    if(bytes > 0)
+      for(unsigned i = 0; i < num_nodes; i++)
+	memcpy(out + (((me + i) % num_nodes) * bytes), &blocks[i * bytes], bytes);
+
+    // reductions are folded in node order so that every node gets the
+    //  same answer even for non-associative (e.g. floating point) ops
+    if(redop) {
+      assert(bytes == (redop->sizeof_rhs * redop_count));
+      memcpy(dst, out, bytes);
+      for(unsigned i = 1; i < num_nodes; i++)
+	redop->fold(dst, out + (i * bytes), redop_count, true /*exclusive*/);
+    }
+  }
+
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // struct CollectiveMessage
+  //
+
+  static void send_outgoing(unsigned seq,
+			    const std::vector<CollectiveOp::Outgoing>& to_send)
+  {
+    for(std::vector<CollectiveOp::Outgoing>::const_iterator it = to_send.begin();
+	it != to_send.end();
+	it++)
+      CollectiveMessage::send_request(it->target, seq, it->step,
+				      (it->data.empty() ? 0 : &(it->data[0])),
+				      it->data.size());
+  }
+
+  /*static*/ void CollectiveMessage::handle_request(RequestArgs args,
+						    const void *data,
+						    size_t datalen)
+  {
+    log_collective.debug() << "collective " << args.seq << ": step " << args.step
+			   << " from " << args.sender << " (" << datalen << " bytes)";
+
+    std::vector<CollectiveOp::Outgoing> to_send;
+    CollectiveOp *op = 0;
+    bool complete = false;
+    {
+      AutoHSLLock al(collective_mutex);
+      std::map<unsigned, CollectiveOp *>::iterator it = collective_ops.find(args.seq);
+      if(it != collective_ops.end()) {
+	op = it->second;
+      } else {
+	op = new CollectiveOp(args.seq);
+	collective_ops[args.seq] = op;
+      }
+      complete = op->receive(args.step, data, datalen, to_send);
+      if(complete)
+	collective_ops.erase(args.seq);
+    }
+
+    send_outgoing(args.seq, to_send);
+    if(complete) {
+      op->done.trigger();
+      delete op;
+    }
+  }
+
+  /*static*/ void CollectiveMessage::send_request(gasnet_node_t target,
+						  unsigned seq, int step,
+						  const void *data,
+						  size_t datalen)
+  {
+    RequestArgs args;
+
+    args.sender = gasnet_mynode();
+    args.seq = seq;
+    args.step = step;
+    Message::request(target, args, data, datalen, PAYLOAD_COPY);
+  }
+
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // collective entry points
+  //
+
+  static Event start_collective(CollectiveOp::Kind kind, gasnet_node_t root,
+				const void *src, void *dst, size_t bytes,
+				const ReductionOpUntyped *redop, size_t count)
+  {
+    std::vector<CollectiveOp::Outgoing> to_send;
+    CollectiveOp *op = 0;
+    bool complete = false;
+    Event e;
+    unsigned seq;
+    {
+      AutoHSLLock al(collective_mutex);
+      seq = next_collective_seq++;
+      std::map<unsigned, CollectiveOp *>::iterator it = collective_ops.find(seq);
+      if(it != collective_ops.end()) {
+	op = it->second;
+      } else {
+	op = new CollectiveOp(seq);
+	collective_ops[seq] = op;
+      }
+      op->redop = redop;
+      op->redop_count = count;
+      e = op->done;
+      complete = op->start(kind, root, src, dst, bytes, to_send);
+      if(complete)
+	collective_ops.erase(seq);
+    }
+
+    log_collective.info() << "collective " << seq << ": kind=" << kind
+			  << " root=" << root << " bytes=" << bytes << " done=" << e;
+
+    send_outgoing(seq, to_send);
+    if(complete) {
+      op->done.trigger();
+      delete op;
+    }
+    return e;
+  }
+
+  Event collective_broadcast(gasnet_node_t root, const void *src, void *dst,
+			     size_t bytes)
+  {
+    assert(root < gasnet_nodes());
+    return start_collective(CollectiveOp::COLL_BROADCAST, root,
+			    src, dst, bytes, 0, 0);
+  }
+
+  Event collective_allgather(const void *src, void *dst, size_t bytes)
+  {
+    return start_collective(CollectiveOp::COLL_ALLGATHER, 0,
+			    src, dst, bytes, 0, 0);
+  }
+
+  Event collective_allreduce(const ReductionOpUntyped *redop,
+			     const void *src, void *dst, size_t count)
+  {
+    assert(redop != 0);
+    return start_collective(CollectiveOp::COLL_ALLGATHER, 0,
+			    src, dst, redop->sizeof_rhs * count, redop, count);
+  }
+
+}; // namespace Realm
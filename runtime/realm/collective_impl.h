@@ -0,0 +1,111 @@
+/* Copyright 2017 Stanford University, NVIDIA Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// collective operations (broadcast/allgather/allreduce) over active messages
+
+#ifndef REALM_COLLECTIVE_IMPL_H
+#define REALM_COLLECTIVE_IMPL_H
+
+#include "event.h"
+#include "redop.h"
+
+#include "activemsg.h"
+
+#include <vector>
+#include <map>
+
+namespace Realm {
+
+  // every node must start the same sequence of collectives (that is how
+  //  the messages for each one are matched up), but messages for a
+  //  collective can show up before the local node has started it, so the
+  //  state for a collective is created by whichever happens first
+  class CollectiveOp {
+  public:
+    enum Kind {
+      COLL_BROADCAST,
+      COLL_ALLGATHER,
+    };
+
+    CollectiveOp(unsigned _seq);
+    ~CollectiveOp(void);
+
+    struct Outgoing {
+      gasnet_node_t target;
+      int step;
+      std::vector<char> data;
+    };
+
+    // called with the collective mutex held - any messages that should be
+    //  sent are added to 'to_send', and the return value is true if the
+    //  operation is complete (the caller then triggers 'done' and deletes
+    //  the op once the mutex is released)
+    bool start(Kind _kind, gasnet_node_t _root, const void *src, void *_dst,
+	       size_t _bytes, std::vector<Outgoing>& to_send);
+    bool receive(int step, const void *data, size_t datalen,
+		 std::vector<Outgoing>& to_send);
+
+  protected:
+    bool make_progress(std::vector<Outgoing>& to_send);
+    void finish(void);
+
+  public:
+    unsigned seq;
+    bool started;
+    Kind kind;
+    gasnet_node_t root;
+    size_t bytes;
+    void *dst;
+    // allreduce is an allgather followed by a local fold of the blocks
+    const ReductionOpUntyped *redop;
+    size_t redop_count;
+    UserEvent done;
+
+  protected:
+    // the allgather uses Bruck's algorithm: 'blocks' holds the data of
+    //  nodes (me + i) % N in position i, and step k moves 2^k blocks
+    std::vector<char> blocks;
+    int num_steps, steps_sent, steps_received;
+    // data for steps that arrived before we were ready for it
+    std::map<int, std::vector<char> > early;
+  };
+
+  struct CollectiveMessage {
+    struct RequestArgs : public BaseMedium {
+      gasnet_node_t sender;
+      unsigned seq;
+      int step;
+    };
+
+    static void handle_request(RequestArgs args, const void *data, size_t datalen);
+
+    typedef ActiveMessageMediumNoReply<COLLECTIVE_MSGID,
+				       RequestArgs,
+				       handle_request> Message;
+
+    static void send_request(gasnet_node_t target, unsigned seq, int step,
+			     const void *data, size_t datalen);
+  };
+
+  // entry points used by Realm::Runtime
+  Event collective_broadcast(gasnet_node_t root, const void *src, void *dst,
+			     size_t bytes);
+  Event collective_allgather(const void *src, void *dst, size_t bytes);
+  Event collective_allreduce(const ReductionOpUntyped *redop,
+			     const void *src, void *dst, size_t count);
+
+}; // namespace Realm
+
+#endif // ifndef REALM_COLLECTIVE_IMPL_H
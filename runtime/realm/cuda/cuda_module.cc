@@ -27,8 +27,26 @@
 
 #include "activemsg.h"
 #include "realm/utils.h"
+#include "realm/timers.h"
 
 #include <stdio.h>
+#include <pthread.h>
+#include <algorithm>
+
+#ifdef REALM_USE_CUPTI
+#include <cupti.h>
+
+#define CHECK_CUPTI(cmd) do { \
+  CUptiResult ret = (cmd); \
+  if(ret != CUPTI_SUCCESS) { \
+    const char *str; \
+    cuptiGetResultString(ret, &str); \
+    fprintf(stderr, "CUPTI: %s = %d (%s)\n", #cmd, ret, str); \
+    assert(0); \
+    exit(1); \
+  } \
+} while(0)
+#endif
 
 namespace Realm {
   namespace Cuda {
@@ -116,6 +134,51 @@ namespace Realm {
       add_event(e, 0, notification);
     }
 
+    // a single completion event stands in for a batch of copies
+    class GPUBatchNotification : public GPUCompletionNotification {
+    public:
+      virtual void request_completed(void)
+      {
+	for(std::vector<GPUCompletionNotification *>::const_iterator it = notifications.begin();
+	    it != notifications.end();
+	    it++)
+	  (*it)->request_completed();
+	delete this;
+      }
+
+      std::vector<GPUCompletionNotification *> notifications;
+    };
+
+    void GPUStream::add_batched_notification(GPUCompletionNotification *notification)
+    {
+      AutoHSLLock al(mutex);
+      batched_notifications.push_back(notification);
+    }
+
+    void GPUStream::flush_batched_notifications(void)
+    {
+      GPUCompletionNotification *to_add = 0;
+      {
+	AutoHSLLock al(mutex);
+
+	if(batched_notifications.empty())
+	  return;
+
+	if(batched_notifications.size() == 1) {
+	  to_add = batched_notifications[0];
+	  batched_notifications.clear();
+	} else {
+	  GPUBatchNotification *batch = new GPUBatchNotification;
+	  batch->notifications.swap(batched_notifications);
+	  (*gpu->batched_copies) += batch->notifications.size();
+	  to_add = batch;
+	}
+      }
+
+      (*gpu->copy_batches) += 1;
+      add_notification(to_add);
+    }
+
     void GPUStream::add_event(CUevent event, GPUWorkFence *fence, 
 			      GPUCompletionNotification *notification)
     {
@@ -140,27 +203,53 @@ namespace Realm {
 
     // to be called by a worker (that should already have the GPU context
     //   current) - returns true if any work remains
+    // bounds on how much work is folded together before it's issued
+    static const size_t MAX_MERGED_COPIES = 1024;
+    static const size_t MAX_BATCHED_COPIES = 64;
+
     bool GPUStream::issue_copies(void)
     {
+      size_t batched = 0;
       while(true) {
 	GPUMemcpy *copy = 0;
+	size_t merged = 0;
 	{
 	  AutoHSLLock al(mutex);
 
 	  if(pending_copies.empty())
-	    return false;  // no work left
+	    break;  // no work left
 
 	  copy = pending_copies.front();
 	  pending_copies.pop_front();
+
+	  // fold in any following copies that line up with this one
+	  while(!pending_copies.empty() && (merged < MAX_MERGED_COPIES) &&
+		copy->merge(pending_copies.front())) {
+	    delete pending_copies.front();
+	    pending_copies.pop_front();
+	    merged++;
+	  }
 	}
 
+	if(merged > 0)
+	  (*gpu->merged_copies) += merged;
+
 	{
 	  AutoGPUContext agc(gpu);
 	  copy->execute(this);
 	}
+	delete copy;
 
-	// no backpressure on copies yet - keep going until list is empty
+	// no backpressure on copies yet - keep going until list is empty, but
+	//  don't hold completions back indefinitely
+	if(++batched >= MAX_BATCHED_COPIES) {
+	  flush_batched_notifications();
+	  batched = 0;
+	}
       }
+
+      flush_batched_notifications();
+      return false;
     }
 
     bool GPUStream::reap_events(void)
@@ -214,7 +303,7 @@ namespace Realm {
 	}
 
 	if(fence)
-	  fence->mark_finished(true /*successful*/);
+	  fence->mark_device_work_finished();
 
 	if(notification)
 	  notification->request_completed();
@@ -243,6 +332,7 @@ namespace Realm {
 			     GPUCompletionNotification *_notification)
       : GPUMemcpy(_gpu, _kind), dst(_dst), src(_src), 
 	mask(0), elmt_size(_bytes), notification(_notification)
+      , lines(1), dst_stride(0), src_stride(0)
     {}
 
     GPUMemcpy1D::GPUMemcpy1D(GPU *_gpu,
@@ -252,6 +342,7 @@ namespace Realm {
 			     GPUCompletionNotification *_notification)
       : GPUMemcpy(_gpu, _kind), dst(_dst), src(_src),
 	mask(_mask), elmt_size(_elmt_size), notification(_notification)
+      , lines(1), dst_stride(0), src_stride(0)
     {}
 
     GPUMemcpy1D::~GPUMemcpy1D(void)
@@ -319,18 +410,62 @@ namespace Realm {
       local_stream = stream;
       if(mask) {
         ElementMask::forall_ranges(*this, *mask);
+      } else if(lines > 1) {
+	// merged copies go as a single strided copy
+	GPUMemcpy2D copy2d(gpu, dst, src, dst_stride, src_stride,
+			   elmt_size, lines, kind, 0);
+	copy2d.execute(stream);
       } else {
         do_span(0, 1);
       }
       
       if(notification)
-	stream->add_notification(notification);
+	stream->add_batched_notification(notification);
+      for(std::vector<GPUCompletionNotification *>::const_iterator it = merged_notifications.begin();
+	  it != merged_notifications.end();
+	  it++)
+	stream->add_batched_notification(*it);
 
       log_gpudma.info("gpu memcpy complete: dst=%p src=%p bytes=%zd kind=%d",
                    dst, src, elmt_size, kind);
     }
 
 
+    bool GPUMemcpy1D::merge(GPUMemcpy *next)
+    {
+      GPUMemcpy1D *other = dynamic_cast<GPUMemcpy1D *>(next);
+      if(!other || mask || other->mask ||
+	 (other->kind != kind) || (other->elmt_size != elmt_size) ||
+	 (other->lines != 1))
+	return false;
+
+      // peer copies need the contexts of both sides, which the 2D path
+      //  doesn't look up
+      if(kind == GPU_MEMCPY_PEER_TO_PEER)
+	return false;
+
+      off_t dst_delta = ((char *)(other->dst)) - ((char *)dst);
+      off_t src_delta = ((const char *)(other->src)) - ((const char *)src);
+
+      if(lines == 1) {
+	// the second copy sets the pitch, which must not make rows overlap
+	if((dst_delta < (off_t)elmt_size) || (src_delta < (off_t)elmt_size))
+	  return false;
+	dst_stride = dst_delta;
+	src_stride = src_delta;
+      } else {
+	if((dst_delta != (off_t)(lines * dst_stride)) ||
+	   (src_delta != (off_t)(lines * src_stride)))
+	  return false;
+      }
+
+      lines++;
+      if(other->notification)
+	merged_notifications.push_back(other->notification);
+      return true;
+    }
+
+
   ////////////////////////////////////////////////////////////////////////
   //
   // class GPUMemcpy2D
@@ -463,6 +598,126 @@ namespace Realm {
 		       (long)depth, kind);
     }
 
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class GPUMemset
+
+    GPUMemset::GPUMemset(GPU *_gpu,
+			 void *_dst, size_t _bytes, off_t _dst_stride, size_t _lines,
+			 const void *_fill_data, size_t _fill_data_size,
+			 GPUCompletionNotification *_notification)
+      : GPUMemcpy(_gpu, GPU_MEMCPY_DEVICE_TO_DEVICE), dst(_dst), bytes(_bytes),
+	dst_stride(_dst_stride), lines(_lines),
+	fill_data_size(_fill_data_size), notification(_notification)
+    {
+      // only the two shapes FillRequest generates are supported
+      assert((lines == 1) || (bytes == fill_data_size));
+      assert((bytes % fill_data_size) == 0);
+      fill_data = new char[fill_data_size];
+      memcpy(fill_data, _fill_data, fill_data_size);
+    }
+
+    GPUMemset::~GPUMemset(void)
+    {
+      delete[] fill_data;
+    }
+
+    // returns the smallest of 1, 2 or 4 that the pattern repeats with
+    //  (0 if it doesn't)
+    static size_t memset_period(const char *data, size_t size)
+    {
+      for(size_t period = 1; period <= 4; period <<= 1) {
+	if((size % period) != 0)
+	  break;
+	bool ok = true;
+	for(size_t i = period; ok && (i < size); i++)
+	  if(data[i] != data[i % period])
+	    ok = false;
+	if(ok)
+	  return period;
+      }
+      return 0;
+    }
+
+    void GPUMemset::execute(GPUStream *stream)
+    {
+      log_gpudma.info("gpu memset: dst=%p bytes=%zd stride=%ld lines=%zd fill_size=%zd",
+		      dst, bytes, (long)dst_stride, lines, fill_data_size);
+      CUstream raw_stream = stream->get_stream();
+      CUdeviceptr base = (CUdeviceptr)dst;
+
+      // a pattern that repeats with a (naturally aligned) period of 1, 2
+      //  or 4 bytes can use the plain memsets
+      size_t period = memset_period(fill_data, fill_data_size);
+      if((period > 1) && (((base % period) != 0) ||
+			  ((lines > 1) && ((dst_stride % period) != 0))))
+	period = 0;
+      if(period > 0) {
+	// (the pattern is at least 'period' bytes long)
+	unsigned char v8 = *(const unsigned char *)fill_data;
+	unsigned short v16 = 0;
+	unsigned int v32 = 0;
+	if(period >= 2) memcpy(&v16, fill_data, sizeof(v16));
+	if(period >= 4) memcpy(&v32, fill_data, sizeof(v32));
+	if(lines == 1) {
+	  switch(period) {
+	  case 1: CHECK_CU( cuMemsetD8Async(base, v8, bytes, raw_stream) ); break;
+	  case 2: CHECK_CU( cuMemsetD16Async(base, v16, bytes >> 1, raw_stream) ); break;
+	  case 4: CHECK_CU( cuMemsetD32Async(base, v32, bytes >> 2, raw_stream) ); break;
+	  }
+	} else {
+	  switch(period) {
+	  case 1: CHECK_CU( cuMemsetD2D8Async(base, dst_stride, v8,
+					      bytes, lines, raw_stream) ); break;
+	  case 2: CHECK_CU( cuMemsetD2D16Async(base, dst_stride, v16,
+					       bytes >> 1, lines, raw_stream) ); break;
+	  case 4: CHECK_CU( cuMemsetD2D32Async(base, dst_stride, v32,
+					       bytes >> 2, lines, raw_stream) ); break;
+	  }
+	}
+      } else {
+	// otherwise, treat the pattern as a short row of words and set each
+	//  column of the resulting 2D array (the pitch is the pattern size
+	//  for contiguous runs or the line stride otherwise)
+	size_t word = 1;
+	if(((fill_data_size % 4) == 0) && ((base % 4) == 0) &&
+	   (((lines == 1) ? (off_t)fill_data_size : dst_stride) % 4 == 0))
+	  word = 4;
+	else if(((fill_data_size % 2) == 0) && ((base % 2) == 0) &&
+		(((lines == 1) ? (off_t)fill_data_size : dst_stride) % 2 == 0))
+	  word = 2;
+	size_t pitch = (lines == 1) ? fill_data_size : dst_stride;
+	size_t height = (lines == 1) ? (bytes / fill_data_size) : lines;
+	for(size_t ofs = 0; ofs < fill_data_size; ofs += word) {
+	  switch(word) {
+	  case 1:
+	    {
+	      unsigned char v = *(const unsigned char *)(fill_data + ofs);
+	      CHECK_CU( cuMemsetD2D8Async(base + ofs, pitch, v, 1, height, raw_stream) );
+	      break;
+	    }
+	  case 2:
+	    {
+	      unsigned short v;
+	      memcpy(&v, fill_data + ofs, sizeof(v));
+	      CHECK_CU( cuMemsetD2D16Async(base + ofs, pitch, v, 1, height, raw_stream) );
+	      break;
+	    }
+	  case 4:
+	    {
+	      unsigned int v;
+	      memcpy(&v, fill_data + ofs, sizeof(v));
+	      CHECK_CU( cuMemsetD2D32Async(base + ofs, pitch, v, 1, height, raw_stream) );
+	      break;
+	    }
+	  }
+	}
+      }
+
+      if(notification)
+	stream->add_notification(notification);
+    }
+
     ////////////////////////////////////////////////////////////////////////
     //
     // mem pair copiers for DMA channels
@@ -884,6 +1139,10 @@ namespace Realm {
 	  mma.m2 = *it;
 	  mma.bandwidth = 10; // assuming pcie, this should be ~half the bw and
 	  mma.latency = 400;  // ~twice the latency as zcmem
+	  // if the route was measured, report it in GB/s instead
+	  std::map<Memory, double>::const_iterator it2 = peer_route_bandwidth.find(*it);
+	  if(it2 != peer_route_bandwidth.end())
+	    mma.bandwidth = std::max(1, (int)(it2->second / 1000));
 	  r->add_mem_mem_affinity(mma);
 	}
       }
@@ -896,6 +1155,7 @@ namespace Realm {
 
     GPUWorkFence::GPUWorkFence(Realm::Operation *op)
       : Realm::Operation::AsyncWorkItem(op)
+      , tracer(0), activity_id(0)
     {}
 
     void GPUWorkFence::request_cancellation(void)
@@ -910,22 +1170,273 @@ namespace Realm {
 
     void GPUWorkFence::enqueue_on_stream(GPUStream *stream)
     {
-      if(stream->get_gpu()->module->cfg_fences_use_callbacks) {
+      // traced fences need the worker thread to flush CUPTI when they trigger
+      if(stream->get_gpu()->module->cfg_fences_use_callbacks && !tracer) {
 	CHECK_CU( cuStreamAddCallback(stream->get_stream(), &cuda_callback, (void *)this, 0) );
       } else {
 	stream->add_fence(this);
       }
     }
 
+    void GPUWorkFence::mark_device_work_finished(void)
+    {
+      // the task's device activity has to be in place before the task can
+      //  complete and send its profiling responses
+#ifdef REALM_USE_CUPTI
+      if(tracer)
+	tracer->collect(activity_id, op->get_gpu_activity());
+#endif
+
+      mark_finished(true /*successful*/);
+    }
+
     /*static*/ void GPUWorkFence::cuda_callback(CUstream stream, CUresult res, void *data)
     {
       GPUWorkFence *me = (GPUWorkFence *)data;
 
       assert(res == CUDA_SUCCESS);
-      me->mark_finished(true /*succesful*/);
+      me->mark_device_work_finished();
     }
 
 
+    ////////////////////////////////////////////////////////////////////////
+    //
+    // class GPUActivityTracer
+
+#ifdef REALM_USE_CUPTI
+    // CUPTI's buffer callbacks take no user data
+    static GPUActivityTracer *active_tracer = 0;
+
+    GPUActivityTracer::GPUActivityTracer(size_t _buffer_size, unsigned _num_buffers)
+      : buffer_size(_buffer_size)
+      , next_id(0)
+      , clock_offset(0)
+      , denied_buffers(0)
+    {
+      // CUPTI wants 8-byte aligned buffers, which malloc already provides
+      for(unsigned i = 0; i < _num_buffers; i++) {
+	uint8_t *buffer = (uint8_t *)malloc(buffer_size);
+	assert(buffer != 0);
+	all_buffers.push_back(buffer);
+      }
+      free_buffers = all_buffers;
+    }
+
+    GPUActivityTracer::~GPUActivityTracer(void)
+    {
+      for(std::vector<uint8_t *>::iterator it = all_buffers.begin();
+	  it != all_buffers.end();
+	  ++it)
+	free(*it);
+    }
+
+    bool GPUActivityTracer::start(void)
+    {
+      assert(active_tracer == 0);
+      active_tracer = this;
+
+      CUptiResult ret = cuptiActivityRegisterCallbacks(&buffer_requested,
+						       &buffer_completed);
+      if(ret != CUPTI_SUCCESS) {
+	const char *str;
+	cuptiGetResultString(ret, &str);
+	log_gpu.warning() << "CUPTI unavailable (" << str << ") - GPU activity will not be traced";
+	active_tracer = 0;
+	return false;
+      }
+
+      // CUPTI timestamps are in nanoseconds, but from a different origin
+      uint64_t cupti_now;
+      CHECK_CUPTI( cuptiGetTimestamp(&cupti_now) );
+      clock_offset = Clock::current_time_in_nanoseconds() - (long long)cupti_now;
+
+      CHECK_CUPTI( cuptiActivityEnable(CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL) );
+      CHECK_CUPTI( cuptiActivityEnable(CUPTI_ACTIVITY_KIND_MEMCPY) );
+      CHECK_CUPTI( cuptiActivityEnable(CUPTI_ACTIVITY_KIND_MEMSET) );
+      CHECK_CUPTI( cuptiActivityEnable(CUPTI_ACTIVITY_KIND_EXTERNAL_CORRELATION) );
+      return true;
+    }
+
+    void GPUActivityTracer::stop(void)
+    {
+      CHECK_CUPTI( cuptiActivityFlushAll(CUPTI_ACTIVITY_FLAG_FLUSH_FORCED) );
+      CHECK_CUPTI( cuptiActivityDisable(CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL) );
+      CHECK_CUPTI( cuptiActivityDisable(CUPTI_ACTIVITY_KIND_MEMCPY) );
+      CHECK_CUPTI( cuptiActivityDisable(CUPTI_ACTIVITY_KIND_MEMSET) );
+      CHECK_CUPTI( cuptiActivityDisable(CUPTI_ACTIVITY_KIND_EXTERNAL_CORRELATION) );
+
+      if(denied_buffers > 0)
+	log_gpu.warning() << "CUPTI buffer ring ran dry " << denied_buffers
+			  << " times - some GPU activity was not recorded"
+			  << " (try a larger -cuda:cupti_bufs or -cuda:cupti_bufsize)";
+      active_tracer = 0;
+    }
+
+    unsigned long long GPUActivityTracer::push_task(void)
+    {
+      unsigned long long id = __sync_add_and_fetch(&next_id, 1);
+      CHECK_CUPTI( cuptiActivityPushExternalCorrelationId(CUPTI_EXTERNAL_CORRELATION_KIND_CUSTOM0,
+							  id) );
+      return id;
+    }
+
+    void GPUActivityTracer::pop_task(void)
+    {
+      uint64_t id;
+      CHECK_CUPTI( cuptiActivityPopExternalCorrelationId(CUPTI_EXTERNAL_CORRELATION_KIND_CUSTOM0,
+							 &id) );
+    }
+
+    void GPUActivityTracer::collect(unsigned long long id,
+				    ProfilingMeasurements::OperationGPUActivity *activity)
+    {
+      // only buffers that have completed records are handed back to us
+      CHECK_CUPTI( cuptiActivityFlushAll(0) );
+
+      AutoHSLLock al(mutex);
+      std::map<unsigned long long, std::vector<Interval> >::iterator it =
+	task_intervals.find(id);
+      if(it == task_intervals.end())
+	return;
+      if(activity)
+	activity->intervals.insert(activity->intervals.end(),
+				   it->second.begin(), it->second.end());
+      task_intervals.erase(it);
+    }
+
+    /*static*/ void GPUActivityTracer::buffer_requested(uint8_t **buffer, size_t *size,
+							size_t *max_num_records)
+    {
+      GPUActivityTracer *me = active_tracer;
+      assert(me != 0);
+
+      AutoHSLLock al(me->mutex);
+      if(me->free_buffers.empty()) {
+	// a null buffer tells CUPTI to drop records until one is available
+	me->denied_buffers++;
+	*buffer = 0;
+	*size = 0;
+      } else {
+	*buffer = me->free_buffers.back();
+	me->free_buffers.pop_back();
+	*size = me->buffer_size;
+      }
+      *max_num_records = 0;  // as many as fit
+    }
+
+    /*static*/ void GPUActivityTracer::buffer_completed(CUcontext ctx, uint32_t stream_id,
+							uint8_t *buffer, size_t size,
+							size_t valid_size)
+    {
+      GPUActivityTracer *me = active_tracer;
+      assert(me != 0);
+
+      AutoHSLLock al(me->mutex);
+      me->process_buffer(buffer, valid_size);
+      me->free_buffers.push_back(buffer);
+    }
+
+    template <typename K, typename V>
+    static void trim_oldest(std::map<K, V>& m, size_t max_size)
+    {
+      // CUPTI's correlation ids and our task ids both increase over time
+      while(m.size() > max_size)
+	m.erase(m.begin());
+    }
+
+    // called with the mutex held
+    void GPUActivityTracer::process_buffer(uint8_t *buffer, size_t valid_size)
+    {
+      CUpti_Activity *record = 0;
+      while(cuptiActivityGetNextRecord(buffer, valid_size, &record) == CUPTI_SUCCESS) {
+	Interval interval;
+	uint32_t correlation_id;
+
+	switch(record->kind) {
+	case CUPTI_ACTIVITY_KIND_EXTERNAL_CORRELATION:
+	  {
+	    CUpti_ActivityExternalCorrelation *c = (CUpti_ActivityExternalCorrelation *)record;
+	    if(c->externalKind != CUPTI_EXTERNAL_CORRELATION_KIND_CUSTOM0)
+	      continue;
+	    task_of_launch[c->correlationId] = c->externalId;
+	    // some of the work may have been reported before its launch
+	    std::map<uint32_t, std::vector<Interval> >::iterator it =
+	      unmatched.find(c->correlationId);
+	    if(it != unmatched.end()) {
+	      std::vector<Interval>& dst = task_intervals[c->externalId];
+	      dst.insert(dst.end(), it->second.begin(), it->second.end());
+	      unmatched.erase(it);
+	    }
+	    trim_oldest(task_of_launch, MAX_PENDING);
+	    trim_oldest(task_intervals, MAX_PENDING);
+	    continue;
+	  }
+
+	case CUPTI_ACTIVITY_KIND_KERNEL:
+	case CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL:
+	  {
+	    CUpti_ActivityKernel4 *k = (CUpti_ActivityKernel4 *)record;
+	    interval.kind = ProfilingMeasurements::OperationGPUActivity::KERNEL;
+	    interval.start = k->start;
+	    interval.end = k->end;
+	    interval.stream = k->streamId;
+	    interval.bytes = 0;
+	    correlation_id = k->correlationId;
+	    break;
+	  }
+
+	case CUPTI_ACTIVITY_KIND_MEMCPY:
+	  {
+	    CUpti_ActivityMemcpy *m = (CUpti_ActivityMemcpy *)record;
+	    interval.kind = ProfilingMeasurements::OperationGPUActivity::MEMCPY;
+	    interval.start = m->start;
+	    interval.end = m->end;
+	    interval.stream = m->streamId;
+	    interval.bytes = m->bytes;
+	    correlation_id = m->correlationId;
+	    break;
+	  }
+
+	case CUPTI_ACTIVITY_KIND_MEMSET:
+	  {
+	    CUpti_ActivityMemset *m = (CUpti_ActivityMemset *)record;
+	    interval.kind = ProfilingMeasurements::OperationGPUActivity::MEMSET;
+	    interval.start = m->start;
+	    interval.end = m->end;
+	    interval.stream = m->streamId;
+	    interval.bytes = m->bytes;
+	    correlation_id = m->correlationId;
+	    break;
+	  }
+
+	default:
+	  continue;
+	}
+
+	interval.start += clock_offset;
+	interval.end += clock_offset;
+	add_interval(correlation_id, interval);
+      }
+    }
+
+    // called with the mutex held
+    void GPUActivityTracer::add_interval(uint32_t correlation_id,
+					 const Interval& interval)
+    {
+      std::map<uint32_t, unsigned long long>::iterator it =
+	task_of_launch.find(correlation_id);
+      if(it != task_of_launch.end()) {
+	// a launch can produce several records (e.g. a graph), so the
+	//  mapping is left for the oldest-first trimming to clean up
+	task_intervals[it->second].push_back(interval);
+      } else {
+	unmatched[correlation_id].push_back(interval);
+	trim_oldest(unmatched, MAX_PENDING);
+      }
+    }
+#endif
+
+
     ////////////////////////////////////////////////////////////////////////
     //
     // class GPUMemcpyFence
@@ -940,6 +1451,8 @@ namespace Realm {
     void GPUMemcpyFence::execute(GPUStream *stream)
     {
       //log_stream.info() << "gpu memcpy fence " << this << " (fence = " << fence << ") executed";
+      // completions of the copies ahead of the fence go first
+      stream->flush_batched_notifications();
       fence->enqueue_on_stream(stream);
 #ifdef FORCE_GPU_STREAM_SYNCHRONIZE
       CHECK_CU( cuStreamSynchronize(stream->get_stream()) );
@@ -1024,6 +1537,89 @@ namespace Realm {
     }
 
 
+    ////////////////////////////////////////////////////////////////////////
+    //
+    // class GPUScratchArena
+
+    GPUScratchArena::GPUScratchArena(CUdeviceptr _base, size_t _size)
+      : base(_base), size(_size)
+    {
+      free_blocks[0] = size;
+    }
+
+    CUdeviceptr GPUScratchArena::alloc(size_t bytes)
+    {
+      // round up so that every block stays aligned
+      bytes = (bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+      if(bytes == 0) bytes = ALIGNMENT;
+
+      AutoHSLLock al(mutex);
+
+      for(std::map<size_t, size_t>::iterator it = free_blocks.begin();
+	  it != free_blocks.end();
+	  it++)
+	if(it->second >= bytes) {
+	  size_t offset = it->first;
+	  size_t remain = it->second - bytes;
+	  free_blocks.erase(it);
+	  if(remain > 0)
+	    free_blocks[offset + bytes] = remain;
+	  return base + offset;
+	}
+
+      return 0;
+    }
+
+    void GPUScratchArena::free(CUdeviceptr ptr, size_t bytes)
+    {
+      bytes = (bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+      if(bytes == 0) bytes = ALIGNMENT;
+      assert((ptr >= base) && ((ptr - base) + bytes <= size));
+      size_t offset = ptr - base;
+
+      AutoHSLLock al(mutex);
+
+      std::map<size_t, size_t>::iterator it = free_blocks.insert(std::make_pair(offset, bytes)).first;
+
+      // merge with the following block
+      std::map<size_t, size_t>::iterator next = it;
+      next++;
+      if((next != free_blocks.end()) && (it->first + it->second == next->first)) {
+	it->second += next->second;
+	free_blocks.erase(next);
+      }
+
+      // and the preceding one
+      if(it != free_blocks.begin()) {
+	std::map<size_t, size_t>::iterator prev = it;
+	prev--;
+	if(prev->first + prev->second == it->first) {
+	  prev->second += it->second;
+	  free_blocks.erase(it);
+	}
+      }
+    }
+
+    // returns scratch blocks to the arena once the stream they were used on
+    //  has caught up to the point at which they were freed
+    class GPUScratchRelease : public GPUCompletionNotification {
+    public:
+      GPUScratchRelease(GPUScratchArena *_arena) : arena(_arena) {}
+
+      virtual void request_completed(void)
+      {
+	for(std::map<CUdeviceptr, size_t>::const_iterator it = blocks.begin();
+	    it != blocks.end();
+	    it++)
+	  arena->free(it->first, it->second);
+	delete this;
+      }
+
+      GPUScratchArena *arena;
+      std::map<CUdeviceptr, size_t> blocks;
+    };
+
+
     ////////////////////////////////////////////////////////////////////////
     //
     // class GPUTaskScheduler<T>
@@ -1065,6 +1661,8 @@ namespace Realm {
 
     namespace ThreadLocal {
       static __thread GPUProcessor *current_gpu_proc = 0;
+      static __thread GPUStream *current_gpu_stream = 0;
+      static __thread GPUProcessor::LaunchState *current_launch_state = 0;
     };
 
     // this flag will be set on the first call into any of the hijack code in
@@ -1092,13 +1690,35 @@ namespace Realm {
       // TODO: sanity-check whether this even works right when GPU tasks suspend
       GPUStream *s = gpu_proc->gpu->switch_to_next_task_stream();
 
+      // kernel launch state is private to this task
+      GPUProcessor::LaunchState launch_state;
+      assert(ThreadLocal::current_launch_state == 0);
+      ThreadLocal::current_launch_state = &launch_state;
+
       // we'll use a "work fence" to track when the kernels launched by this task actually
       //  finish - this must be added to the task _BEFORE_ we execute
       GPUWorkFence *fence = new GPUWorkFence(task);
       task->add_async_work_item(fence);
 
+#ifdef REALM_USE_CUPTI
+      // tag the device work this task issues if it wants to hear about it
+      GPUActivityTracer *tracer = gpu_proc->gpu->module->activity_tracer;
+      if(tracer && task->get_gpu_activity()) {
+	fence->tracer = tracer;
+	fence->activity_id = tracer->push_task();
+      }
+#endif
+
       bool ok = T::execute_task(task);
 
+      // issue any kernel launches held back for graph replay
+      gpu_proc->flush_kernel_launches();
+
+#ifdef REALM_USE_CUPTI
+      if(fence->tracer)
+	tracer->pop_task();
+#endif
+
       // now enqueue the fence on the local stream
       fence->enqueue_on_stream(s);
 
@@ -1122,6 +1742,15 @@ namespace Realm {
 	CHECK_CU( cuCtxSynchronize() );
       }
 
+      // scratch memory the task didn't free goes back once its work is done
+      gpu_proc->release_task_scratch(s);
+
+      // later tasks may use this stream - their work is ordered after ours
+      gpu_proc->gpu->release_task_stream(s);
+
+      assert(ThreadLocal::current_launch_state == &launch_state);
+      ThreadLocal::current_launch_state = 0;
+
       // pop the CUDA context for this GPU back off
       gpu_proc->gpu->pop_context();
 
@@ -1154,11 +1783,12 @@ namespace Realm {
 
 #ifdef REALM_USE_USER_THREADS_FOR_GPU
       Realm::UserThreadTaskScheduler *sched = new GPUTaskScheduler<Realm::UserThreadTaskScheduler>(me, *core_rsrv, this);
-      // no config settings we want to tweak yet
 #else
       Realm::KernelThreadTaskScheduler *sched = new GPUTaskScheduler<Realm::KernelThreadTaskScheduler>(me, *core_rsrv, this);
-      // no config settings we want to tweak yet
 #endif
+      // allow as many tasks to run at once as we have been asked for - each
+      //  gets its own task stream so their kernels can overlap on the device
+      sched->cfg_max_active_workers = gpu->module->cfg_task_concurrency;
       set_scheduler(sched);
     }
 
@@ -1297,6 +1927,28 @@ namespace Realm {
       device_to_device_stream->add_copy(copy);
     }
 
+    void GPU::fill_within_fb(off_t dst_offset, size_t bytes,
+			     const void *fill_data, size_t fill_data_size,
+			     GPUCompletionNotification *notification /*= 0*/)
+    {
+      GPUMemcpy *copy = new GPUMemset(this,
+				      (void *)(fbmem->base + dst_offset),
+				      bytes, bytes, 1,
+				      fill_data, fill_data_size, notification);
+      device_to_device_stream->add_copy(copy);
+    }
+
+    void GPU::fill_within_fb_2d(off_t dst_offset, off_t dst_stride, size_t lines,
+				const void *fill_data, size_t fill_data_size,
+				GPUCompletionNotification *notification /*= 0*/)
+    {
+      GPUMemcpy *copy = new GPUMemset(this,
+				      (void *)(fbmem->base + dst_offset),
+				      fill_data_size, dst_stride, lines,
+				      fill_data, fill_data_size, notification);
+      device_to_device_stream->add_copy(copy);
+    }
+
     void GPU::copy_within_fb_3d(off_t dst_offset, off_t src_offset,
                                 off_t dst_stride, off_t src_stride,
                                 off_t dst_height, off_t src_height,
@@ -1313,10 +1965,33 @@ namespace Realm {
       device_to_device_stream->add_copy(copy);
     }
 
+    /*static*/ const size_t GPU::RELAY_STAGING_BYTES;
+
     void GPU::copy_to_peer(GPU *dst, off_t dst_offset,
 			   off_t src_offset, size_t bytes,
 			   GPUCompletionNotification *notification /*= 0*/)
     {
+      std::map<GPU *, PeerRelay>::const_iterator it = peer_relays.find(dst);
+      if((it != peer_relays.end()) && (bytes > 0)) {
+	// stage through the relay's FB a buffer at a time - both hops go on
+	//  our p2p stream, so reuse of the staging buffer is ordered
+	void *staging = (void *)(it->second.relay->fbmem->base + it->second.staging_offset);
+	size_t done = 0;
+	while(done < bytes) {
+	  size_t chunk = std::min(bytes - done, RELAY_STAGING_BYTES);
+	  bool last = ((done + chunk) == bytes);
+	  peer_to_peer_stream->add_copy(new GPUMemcpy1D(this, staging,
+							(const void *)(fbmem->base + src_offset + done),
+							chunk, GPU_MEMCPY_PEER_TO_PEER, 0));
+	  peer_to_peer_stream->add_copy(new GPUMemcpy1D(this,
+							(void *)(dst->fbmem->base + dst_offset + done),
+							staging, chunk, GPU_MEMCPY_PEER_TO_PEER,
+							(last ? notification : 0)));
+	  done += chunk;
+	}
+	return;
+      }
+
       GPUMemcpy *copy = new GPUMemcpy1D(this,
 					(void *)(dst->fbmem->base + dst_offset),
 					(const void *)(fbmem->base + src_offset),
@@ -1330,6 +2005,31 @@ namespace Realm {
 			      size_t bytes, size_t lines,
 			      GPUCompletionNotification *notification /*= 0*/)
     {
+      std::map<GPU *, PeerRelay>::const_iterator it = peer_relays.find(dst);
+      size_t chunk_lines = (bytes > 0) ? (RELAY_STAGING_BYTES / bytes) : 0;
+      if((it != peer_relays.end()) && (chunk_lines > 0) && (lines > 0)) {
+	// as above, with the lines packed in the staging buffer
+	char *staging = (char *)(it->second.relay->fbmem->base + it->second.staging_offset);
+	size_t done = 0;
+	while(done < lines) {
+	  size_t chunk = std::min(lines - done, chunk_lines);
+	  bool last = ((done + chunk) == lines);
+	  peer_to_peer_stream->add_copy(new GPUMemcpy2D(this, staging,
+							(const void *)(fbmem->base + src_offset +
+								       done * src_stride),
+							bytes, src_stride, bytes, chunk,
+							GPU_MEMCPY_PEER_TO_PEER, 0));
+	  peer_to_peer_stream->add_copy(new GPUMemcpy2D(this,
+							(void *)(dst->fbmem->base + dst_offset +
+								 done * dst_stride),
+							staging, dst_stride, bytes, bytes, chunk,
+							GPU_MEMCPY_PEER_TO_PEER,
+							(last ? notification : 0)));
+	  done += chunk;
+	}
+	return;
+      }
+
       GPUMemcpy *copy = new GPUMemcpy2D(this,
 					(void *)(dst->fbmem->base + dst_offset),
 					(const void *)(fbmem->base + src_offset),
@@ -1404,15 +2104,46 @@ namespace Realm {
 
     GPUStream *GPU::get_current_task_stream(void)
     {
+      // a running task uses the stream it was bound to
+      if(ThreadLocal::current_gpu_stream)
+	return ThreadLocal::current_gpu_stream;
       return task_streams[current_stream];
     }
 
     GPUStream *GPU::switch_to_next_task_stream(void)
     {
-      current_stream++;
-      if(current_stream >= task_streams.size())
-	current_stream = 0;
-      return task_streams[current_stream];
+      AutoHSLLock al(task_stream_mutex);
+
+      // round-robin, but skip streams that are bound to other running tasks - if
+      //  they are all busy, share the next one (the tasks' work just serializes)
+      unsigned next = current_stream;
+      for(size_t i = 0; i < task_streams.size(); i++) {
+	next++;
+	if(next >= task_streams.size())
+	  next = 0;
+	if(!task_stream_busy[next])
+	  break;
+      }
+      current_stream = next;
+      task_stream_busy[next] = true;
+
+      assert(ThreadLocal::current_gpu_stream == 0);
+      ThreadLocal::current_gpu_stream = task_streams[next];
+      return task_streams[next];
+    }
+
+    void GPU::release_task_stream(GPUStream *stream)
+    {
+      AutoHSLLock al(task_stream_mutex);
+
+      assert(ThreadLocal::current_gpu_stream == stream);
+      ThreadLocal::current_gpu_stream = 0;
+
+      for(size_t i = 0; i < task_streams.size(); i++)
+	if(task_streams[i] == stream) {
+	  task_stream_busy[i] = false;
+	  break;
+	}
     }
 
     void GPUProcessor::shutdown(void)
@@ -1428,6 +2159,17 @@ namespace Realm {
 	AutoGPUContext agc(gpu);
 
 	CHECK_CU( cuCtxSynchronize() );
+
+#if CUDA_VERSION >= 10000
+	for(std::map<std::string, KernelGraph>::iterator it = kernel_graphs.begin();
+	    it != kernel_graphs.end();
+	    it++)
+	  if(it->second.exec) {
+	    CHECK_CU( cuGraphExecDestroy(it->second.exec) );
+	    CHECK_CU( cuGraphDestroy(it->second.graph) );
+	  }
+#endif
+	kernel_graphs.clear();
       }
     }
 
@@ -1593,7 +2335,7 @@ namespace Realm {
       : MemoryImpl(_me, _size, MKIND_GPUFB, 512, Memory::GPU_FB_MEM)
       , gpu(_gpu), base(_base)
     {
-      free_blocks[0] = size;
+      allocator->add_range(0, size);
     }
 
     GPUFBMemory::~GPUFBMemory(void) {}
@@ -1667,7 +2409,7 @@ namespace Realm {
       : MemoryImpl(_me, _size, MKIND_ZEROCOPY, 256, Memory::Z_COPY_MEM)
       , gpu_base(_gpu_base), cpu_base((char *)_cpu_base)
     {
-      free_blocks[0] = size;
+      allocator->add_range(0, size);
     }
 
     GPUZCMemory::~GPUZCMemory(void) {}
@@ -1724,6 +2466,123 @@ namespace Realm {
       return ID(me).memory.owner_node;
     }
 
+    bool GPUZCMemory::wrap_external(void *ptr, size_t size, off_t& offset)
+    {
+      // the CPU and GPU addresses of pinned memory are the same under
+      //  unified addressing (as for our own allocation), so one offset
+      //  works for both once the module has registered the range
+      offset = (char *)ptr - cpu_base;
+      return true;
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+    //
+    // class GPUManagedMemory
+
+    GPUManagedMemory::GPUManagedMemory(Memory _me, CudaModule *_module,
+				       CUdeviceptr _base, size_t _size)
+      : MemoryImpl(_me, _size, MKIND_ZEROCOPY, 256, Memory::GPU_MANAGED_MEM)
+      , module(_module), base(_base)
+    {
+      allocator->add_range(0, size);
+
+      std::string gname = stringbuilder() << "managed mem " << me;
+      prefetches = new ProfilingGauges::EventCounter<int>(gname + "/prefetches");
+      prefetched_bytes = new ProfilingGauges::EventCounter<long long>(gname + "/prefetched bytes");
+    }
+
+    GPUManagedMemory::~GPUManagedMemory(void)
+    {
+      delete prefetches;
+      delete prefetched_bytes;
+    }
+
+    RegionInstance GPUManagedMemory::create_instance(IndexSpace is,
+						     const int *linearization_bits,
+						     size_t bytes_needed,
+						     size_t block_size,
+						     size_t element_size,
+						     const std::vector<size_t>& field_sizes,
+						     ReductionOpID redopid,
+						     off_t list_size,
+						     const Realm::ProfilingRequestSet &reqs,
+						     RegionInstance parent_inst)
+    {
+      return create_instance_local(is, linearization_bits, bytes_needed,
+				   block_size, element_size, field_sizes, redopid,
+				   list_size, reqs, parent_inst);
+    }
+
+    void GPUManagedMemory::destroy_instance(RegionInstance i, 
+					    bool local_destroy)
+    {
+      destroy_instance_local(i, local_destroy);
+    }
+
+    off_t GPUManagedMemory::alloc_bytes(size_t size)
+    {
+      return alloc_bytes_local(size);
+    }
+
+    void GPUManagedMemory::free_bytes(off_t offset, size_t size)
+    {
+      free_bytes_local(offset, size);
+    }
+
+    void GPUManagedMemory::get_bytes(off_t offset, void *dst, size_t size)
+    {
+      memcpy(dst, (const char *)base + offset, size);
+    }
+
+    void GPUManagedMemory::put_bytes(off_t offset, const void *src, size_t size)
+    {
+      memcpy((char *)base + offset, src, size);
+    }
+
+    void *GPUManagedMemory::get_direct_ptr(off_t offset, size_t size)
+    {
+      return ((char *)base + offset);
+    }
+
+    int GPUManagedMemory::get_home_node(off_t offset, size_t size)
+    {
+      return ID(me).memory.owner_node;
+    }
+
+    void GPUManagedMemory::prefetch(off_t offset, size_t size, Processor target)
+    {
+#if CUDA_VERSION >= 8000
+      if((size == 0) || module->gpus.empty())
+	return;
+
+      // a GPU processor pulls the pages into its FB, on its host-to-device
+      //  stream so that the migration overlaps with other work
+      for(std::vector<GPU *>::const_iterator it = module->gpus.begin();
+	  it != module->gpus.end();
+	  it++)
+	if((*it)->proc && ((*it)->proc->me == target)) {
+	  AutoGPUContext agc(*it);
+	  CHECK_CU( cuMemPrefetchAsync(base + offset, size, (*it)->info->device,
+				       (*it)->host_to_device_stream->get_stream()) );
+	  (*prefetches) += 1;
+	  (*prefetched_bytes) += size;
+	  return;
+	}
+
+      // anything else running on the CPUs wants the pages back in host memory
+      Processor::Kind k = target.kind();
+      if((k == Processor::LOC_PROC) || (k == Processor::UTIL_PROC) ||
+	 (k == Processor::IO_PROC) || (k == Processor::OMP_PROC)) {
+	GPU *gpu = module->gpus[0];
+	AutoGPUContext agc(gpu);
+	CHECK_CU( cuMemPrefetchAsync(base + offset, size, CU_DEVICE_CPU,
+				     gpu->device_to_host_stream->get_stream()) );
+	(*prefetches) += 1;
+	(*prefetched_bytes) += size;
+      }
+#endif
+    }
+
 #ifdef POINTER_CHECKS
     static unsigned *get_gpu_valid_mask(RegionMetaDataUntyped region)
     {
@@ -1777,6 +2636,7 @@ namespace Realm {
 
     void GPUProcessor::device_synchronize(void)
     {
+      flush_kernel_launches();
       GPUStream *current = gpu->get_current_task_stream();
       // We don't actually want to block the GPU processor
       // when synchronizing, so we instead register a cuda
@@ -1816,6 +2676,7 @@ namespace Realm {
     {
       // ignore the provided stream and record the event on this task's assigned stream
       CUevent e = event;
+      flush_kernel_launches();
       GPUStream *current = gpu->get_current_task_stream();
       CHECK_CU( cuEventRecord(e, current->get_stream()) );
     }
@@ -1839,17 +2700,26 @@ namespace Realm {
       : grid(_grid), block(_block), shared(_shared)
     {}
 
+    /*static*/ GPUProcessor::LaunchState& GPUProcessor::get_current_launch_state(void)
+    {
+      // only valid from within a GPU task
+      assert(ThreadLocal::current_launch_state != 0);
+      return *ThreadLocal::current_launch_state;
+    }
+
     void GPUProcessor::configure_call(dim3 grid_dim,
 				      dim3 block_dim,
 				      size_t shared_mem,
 				      cudaStream_t stream)
     {
+      std::vector<LaunchConfig>& launch_configs = get_current_launch_state().launch_configs;
       launch_configs.push_back(LaunchConfig(grid_dim, block_dim, shared_mem));
     }
 
     void GPUProcessor::setup_argument(const void *arg,
 				      size_t size, size_t offset)
     {
+      std::vector<char>& kernel_args = get_current_launch_state().kernel_args;
       size_t required = offset + size;
 
       if(required > kernel_args.size())
@@ -1858,8 +2728,18 @@ namespace Realm {
       memcpy(&kernel_args[offset], arg, size);
     }
 
+    GPUProcessor::PendingLaunch::PendingLaunch(CUfunction _func,
+					       const LaunchConfig& _config,
+					       const std::vector<char>& _args)
+      : func(_func), config(_config), args(_args)
+    {}
+
     void GPUProcessor::launch(const void *func)
     {
+      LaunchState& ls = get_current_launch_state();
+      std::vector<LaunchConfig>& launch_configs = ls.launch_configs;
+      std::vector<char>& kernel_args = ls.kernel_args;
+
       // make sure we have a launch config
       assert(!launch_configs.empty());
       LaunchConfig &config = launch_configs.back();
@@ -1867,6 +2747,14 @@ namespace Realm {
       // Find our function
       CUfunction f = gpu->lookup_function(func);
 
+      if(gpu->module->cfg_graph_min_repeats > 0) {
+	log_stream.debug() << "kernel " << func << " held for graph replay";
+	ls.pending_launches.push_back(PendingLaunch(f, config, kernel_args));
+	launch_configs.pop_back();
+	kernel_args.clear();
+	return;
+      }
+
       size_t arg_size = kernel_args.size();
       void *extra[] = { 
         CU_LAUNCH_PARAM_BUFFER_POINTER, &kernel_args[0],
@@ -1892,9 +2780,159 @@ namespace Realm {
       kernel_args.clear();
     }
 
+    // upper bound on the graphs kept per GPU processor
+    static const size_t MAX_KERNEL_GRAPHS = 64;
+
+    void GPUProcessor::flush_kernel_launches(void)
+    {
+      std::vector<PendingLaunch>& pending_launches = get_current_launch_state().pending_launches;
+      if(pending_launches.empty()) return;
+
+      CUstream raw_stream = gpu->get_current_task_stream()->get_stream();
+
+#if CUDA_VERSION >= 10000
+      // a single kernel gains nothing from a graph
+      if(pending_launches.size() > 1) {
+	// graphs are shared by all tasks running on this processor
+	AutoHSLLock al(kernel_graph_mutex);
+
+	std::string key;
+	for(std::vector<PendingLaunch>::const_iterator it = pending_launches.begin();
+	    it != pending_launches.end();
+	    it++) {
+	  size_t arg_size = it->args.size();
+	  key.append((const char *)&(it->func), sizeof(CUfunction));
+	  key.append((const char *)&(it->config.grid), sizeof(dim3));
+	  key.append((const char *)&(it->config.block), sizeof(dim3));
+	  key.append((const char *)&(it->config.shared), sizeof(size_t));
+	  key.append((const char *)&arg_size, sizeof(size_t));
+	  key.append(it->args.begin(), it->args.end());
+	}
+
+	std::map<std::string, KernelGraph>::iterator it = kernel_graphs.find(key);
+	if((it == kernel_graphs.end()) && (kernel_graphs.size() < MAX_KERNEL_GRAPHS)) {
+	  KernelGraph kg;
+	  kg.times_seen = 0;
+	  kg.graph = 0;
+	  kg.exec = 0;
+	  it = kernel_graphs.insert(std::make_pair(key, kg)).first;
+	}
+
+	if(it != kernel_graphs.end()) {
+	  KernelGraph& kg = it->second;
+	  if(!kg.exec && (++kg.times_seen >= gpu->module->cfg_graph_min_repeats)) {
+	    // build a graph with the launches chained in issue order
+	    CHECK_CU( cuGraphCreate(&kg.graph, 0) );
+	    CUgraphNode prev = 0;
+	    for(std::vector<PendingLaunch>::iterator it2 = pending_launches.begin();
+		it2 != pending_launches.end();
+		it2++) {
+	      size_t arg_size = it2->args.size();
+	      void *extra[] = {
+		CU_LAUNCH_PARAM_BUFFER_POINTER, &(it2->args[0]),
+		CU_LAUNCH_PARAM_BUFFER_SIZE, &arg_size,
+		CU_LAUNCH_PARAM_END
+	      };
+	      CUDA_KERNEL_NODE_PARAMS params;
+	      memset(&params, 0, sizeof(params));
+	      params.func = it2->func;
+	      params.gridDimX = it2->config.grid.x;
+	      params.gridDimY = it2->config.grid.y;
+	      params.gridDimZ = it2->config.grid.z;
+	      params.blockDimX = it2->config.block.x;
+	      params.blockDimY = it2->config.block.y;
+	      params.blockDimZ = it2->config.block.z;
+	      params.sharedMemBytes = it2->config.shared;
+	      params.extra = extra;
+	      CUgraphNode node;
+	      CHECK_CU( cuGraphAddKernelNode(&node, kg.graph,
+					     (prev ? &prev : 0), (prev ? 1 : 0),
+					     &params) );
+	      prev = node;
+	    }
+#if CUDA_VERSION >= 12000
+	    CHECK_CU( cuGraphInstantiate(&kg.exec, kg.graph, 0) );
+#else
+	    CHECK_CU( cuGraphInstantiate(&kg.exec, kg.graph, 0, 0, 0) );
+#endif
+	    log_stream.info() << "built graph of " << pending_launches.size()
+			      << " kernels for processor " << me;
+	  }
+	  if(kg.exec) {
+	    log_stream.debug() << "graph of " << pending_launches.size()
+			       << " kernels added to stream " << raw_stream;
+	    CHECK_CU( cuGraphLaunch(kg.exec, raw_stream) );
+	    pending_launches.clear();
+	    return;
+	  }
+	}
+      }
+#endif
+
+      for(std::vector<PendingLaunch>::iterator it = pending_launches.begin();
+	  it != pending_launches.end();
+	  it++) {
+	size_t arg_size = it->args.size();
+	void *extra[] = {
+	  CU_LAUNCH_PARAM_BUFFER_POINTER, &(it->args[0]),
+	  CU_LAUNCH_PARAM_BUFFER_SIZE, &arg_size,
+	  CU_LAUNCH_PARAM_END
+	};
+	log_stream.debug() << "kernel " << it->func << " added to stream " << raw_stream;
+	CHECK_CU( cuLaunchKernel(it->func,
+				 it->config.grid.x, it->config.grid.y, it->config.grid.z,
+				 it->config.block.x, it->config.block.y, it->config.block.z,
+				 it->config.shared,
+				 raw_stream,
+				 NULL, extra) );
+      }
+      pending_launches.clear();
+    }
+
+    bool GPUProcessor::scratch_malloc(void **ptr, size_t size)
+    {
+      if(!gpu->scratch_arena) return false;
+
+      CUdeviceptr p = gpu->scratch_arena->alloc(size);
+      if(!p) {
+	log_gpu.debug() << "scratch arena exhausted - " << size << " bytes from cuMemAlloc";
+	return false;
+      }
+
+      get_current_launch_state().scratch_allocs[p] = size;
+      *ptr = (void *)p;
+      return true;
+    }
+
+    bool GPUProcessor::scratch_free(void *ptr)
+    {
+      std::map<CUdeviceptr, size_t>& allocs = get_current_launch_state().scratch_allocs;
+      std::map<CUdeviceptr, size_t>::iterator it = allocs.find((CUdeviceptr)ptr);
+      if(it == allocs.end()) return false;
+
+      // work already on the stream may still be using the block
+      GPUScratchRelease *rel = new GPUScratchRelease(gpu->scratch_arena);
+      rel->blocks.insert(*it);
+      allocs.erase(it);
+      flush_kernel_launches();
+      gpu->get_current_task_stream()->add_notification(rel);
+      return true;
+    }
+
+    void GPUProcessor::release_task_scratch(GPUStream *stream)
+    {
+      std::map<CUdeviceptr, size_t>& allocs = get_current_launch_state().scratch_allocs;
+      if(allocs.empty()) return;
+
+      GPUScratchRelease *rel = new GPUScratchRelease(gpu->scratch_arena);
+      rel->blocks.swap(allocs);
+      stream->add_notification(rel);
+    }
+
     void GPUProcessor::gpu_memcpy(void *dst, const void *src, size_t size,
 				  cudaMemcpyKind kind)
     {
+      flush_kernel_launches();
       CUstream current = gpu->get_current_task_stream()->get_stream();
       // the synchronous copy still uses cuMemcpyAsync so that we can limit the
       //  synchronization to just the right stream
@@ -1905,6 +2943,7 @@ namespace Realm {
     void GPUProcessor::gpu_memcpy_async(void *dst, const void *src, size_t size,
 					cudaMemcpyKind kind, cudaStream_t stream)
     {
+      flush_kernel_launches();
       CUstream current = gpu->get_current_task_stream()->get_stream();
       CHECK_CU( cuMemcpyAsync((CUdeviceptr)dst, (CUdeviceptr)src, size, current) );
       // no synchronization here
@@ -1914,6 +2953,7 @@ namespace Realm {
 					    size_t size, size_t offset,
 					    cudaMemcpyKind kind)
     {
+      flush_kernel_launches();
       CUstream current = gpu->get_current_task_stream()->get_stream();
       CUdeviceptr var_base = gpu->lookup_variable(dst);
       CHECK_CU( cuMemcpyAsync(var_base + offset,
@@ -1925,6 +2965,7 @@ namespace Realm {
 						  size_t size, size_t offset,
 						  cudaMemcpyKind kind, cudaStream_t stream)
     {
+      flush_kernel_launches();
       CUstream current = gpu->get_current_task_stream()->get_stream();
       CUdeviceptr var_base = gpu->lookup_variable(dst);
       CHECK_CU( cuMemcpyAsync(var_base + offset,
@@ -1936,6 +2977,7 @@ namespace Realm {
 					      size_t size, size_t offset,
 					      cudaMemcpyKind kind)
     {
+      flush_kernel_launches();
       CUstream current = gpu->get_current_task_stream()->get_stream();
       CUdeviceptr var_base = gpu->lookup_variable(src);
       CHECK_CU( cuMemcpyAsync((CUdeviceptr)dst,
@@ -1948,6 +2990,7 @@ namespace Realm {
 						    size_t size, size_t offset,
 						    cudaMemcpyKind kind, cudaStream_t stream)
     {
+      flush_kernel_launches();
       CUstream current = gpu->get_current_task_stream()->get_stream();
       CUdeviceptr var_base = gpu->lookup_variable(src);
       CHECK_CU( cuMemcpyAsync((CUdeviceptr)dst,
@@ -1958,6 +3001,7 @@ namespace Realm {
 
     void GPUProcessor::gpu_memset(void *dst, int value, size_t count)
     {
+      flush_kernel_launches();
       CUstream current = gpu->get_current_task_stream()->get_stream();
       CHECK_CU( cuMemsetD32Async((CUdeviceptr)dst, unsigned(value), 
                                   count, current) );
@@ -1966,6 +3010,7 @@ namespace Realm {
     void GPUProcessor::gpu_memset_async(void *dst, int value, 
                                         size_t count, cudaStream_t stream)
     {
+      flush_kernel_launches();
       CUstream current = gpu->get_current_task_stream()->get_stream();
       CHECK_CU( cuMemsetD32Async((CUdeviceptr)dst, unsigned(value),
                                   count, current) );
@@ -1979,7 +3024,8 @@ namespace Realm {
     GPU::GPU(CudaModule *_module, GPUInfo *_info, GPUWorker *_worker,
 	     int num_streams)
       : module(_module), info(_info), worker(_worker)
-      , proc(0), fbmem(0), current_stream(0)
+      , proc(0), fbmem(0), scratch_arena(0), current_stream(0)
+      , d2h_bandwidth(0), h2d_bandwidth(0)
     {
       // create a CUDA context for our device - automatically becomes current
       CHECK_CU( cuCtxCreate(&context, 
@@ -1988,12 +3034,18 @@ namespace Realm {
 
       event_pool.init_pool();
 
+      std::string gname = stringbuilder() << "gpu " << info->index;
+      copy_batches = new ProfilingGauges::EventCounter<int>(gname + "/copy batches");
+      batched_copies = new ProfilingGauges::EventCounter<int>(gname + "/batched copies");
+      merged_copies = new ProfilingGauges::EventCounter<int>(gname + "/merged copies");
+
       host_to_device_stream = new GPUStream(this, worker);
       device_to_host_stream = new GPUStream(this, worker);
       device_to_device_stream = new GPUStream(this, worker);
       peer_to_peer_stream = new GPUStream(this, worker);
 
       task_streams.resize(num_streams);
+      task_stream_busy.resize(num_streams, false);
       for(int idx = 0; idx < num_streams; idx++)
 	task_streams[idx] = new GPUStream(this, worker);
 
@@ -2009,6 +3061,10 @@ namespace Realm {
 
       event_pool.empty_pool();
 
+      delete copy_batches;
+      delete batched_copies;
+      delete merged_copies;
+
       // destroy streams
       delete host_to_device_stream;
       delete device_to_host_stream;
@@ -2022,6 +3078,11 @@ namespace Realm {
       // free memory
       CHECK_CU( cuMemFree(fbmem_base) );
 
+      if(scratch_arena) {
+	CHECK_CU( cuMemFree(scratch_arena->base) );
+	delete scratch_arena;
+      }
+
       CHECK_CU( cuCtxDestroy(context) );
     }
 
@@ -2065,6 +3126,15 @@ namespace Realm {
 	runtime->add_proc_mem_affinity(pma);
       }
 
+      if(module->managed_mem) {
+	Machine::ProcessorMemoryAffinity pma;
+	pma.p = p;
+	pma.m = module->managed_mem->me;
+	pma.bandwidth = 100; // FB speed once migrated, less while faulting
+	pma.latency = 50;
+	runtime->add_proc_mem_affinity(pma);
+      }
+
       // peer access
       for(std::vector<GPU *>::iterator it = module->gpus.begin();
 	  it != module->gpus.end();
@@ -2099,20 +3169,30 @@ namespace Realm {
       }
     }
 
-    void GPU::create_fb_memory(RuntimeImpl *runtime, size_t size)
+    void GPU::allocate_fb_memory(size_t size)
     {
       // need the context so we can get an allocation in the right place
-      {
-	AutoGPUContext agc(this);
+      AutoGPUContext agc(this);
 
-	CHECK_CU( cuMemAlloc(&fbmem_base, size) );
-      }
+      CHECK_CU( cuMemAlloc(&fbmem_base, size) );
+    }
 
+    void GPU::create_fb_memory(RuntimeImpl *runtime, size_t size)
+    {
       Memory m = runtime->next_local_memory_id();
       fbmem = new GPUFBMemory(m, this, fbmem_base, size);
       runtime->add_memory(fbmem);
     }
 
+    void GPU::create_scratch_arena(size_t size)
+    {
+      AutoGPUContext agc(this);
+
+      CUdeviceptr base;
+      CHECK_CU( cuMemAlloc(&base, size) );
+      scratch_arena = new GPUScratchArena(base, size);
+    }
+
     void GPU::register_fat_binary(const FatBin *fatbin)
     {
       AutoGPUContext agc(this);
@@ -2269,6 +3349,103 @@ namespace Realm {
     }
 
 
+    ////////////////////////////////////////////////////////////////////////
+    //
+    // per-GPU startup threads
+
+    // context creation and large allocations take a significant fraction of
+    //  a second per device and are independent across devices, so startup
+    //  runs them on one (plain pthread - core reservations have not been
+    //  satisfied yet) thread per GPU
+
+    struct PerGPUInitArgs {
+      void (*fn)(CudaModule *module, unsigned index, void *data);
+      CudaModule *module;
+      unsigned index;
+      void *data;
+    };
+
+    static void *per_gpu_init_thread(void *arg)
+    {
+      PerGPUInitArgs *args = (PerGPUInitArgs *)arg;
+      (args->fn)(args->module, args->index, args->data);
+      return 0;
+    }
+
+    // starts 'fn' for every GPU - if 'parallel' is false, they're just run
+    //  in order before returning
+    static void start_per_gpu_init(void (*fn)(CudaModule *, unsigned, void *),
+				   CudaModule *module, unsigned count, void *data,
+				   bool parallel,
+				   std::vector<PerGPUInitArgs>& args,
+				   std::vector<pthread_t>& threads)
+    {
+      args.resize(count);
+      for(unsigned i = 0; i < count; i++) {
+	args[i].fn = fn;
+	args[i].module = module;
+	args[i].index = i;
+	args[i].data = data;
+      }
+
+      if(!parallel || (count < 2)) {
+	for(unsigned i = 0; i < count; i++)
+	  per_gpu_init_thread(&args[i]);
+	return;
+      }
+
+      threads.resize(count);
+      for(unsigned i = 0; i < count; i++) {
+	int ret = pthread_create(&threads[i], 0,
+				 per_gpu_init_thread, &args[i]);
+	if(ret != 0) {
+	  log_gpu.fatal() << "pthread_create for GPU " << i << " init failed: " << ret;
+	  assert(false);
+	}
+      }
+    }
+
+    static void finish_per_gpu_init(std::vector<pthread_t>& threads)
+    {
+      for(std::vector<pthread_t>::iterator it = threads.begin();
+	  it != threads.end();
+	  it++) {
+	int ret = pthread_join(*it, 0);
+	assert(ret == 0);
+      }
+      threads.clear();
+    }
+
+    struct GPUCreateData {
+      std::vector<GPUWorker *> workers;
+      int num_streams;
+    };
+
+    static void create_gpu_body(CudaModule *module, unsigned index, void *data)
+    {
+      GPUCreateData *cd = (GPUCreateData *)data;
+      long long t_start = Clock::current_time_in_nanoseconds();
+      module->gpus[index] = new GPU(module, module->gpu_info[index],
+				    cd->workers[index], cd->num_streams);
+      long long t_end = Clock::current_time_in_nanoseconds();
+      log_gpu.info() << "GPU " << index << " context created in "
+		     << ((t_end - t_start) / 1000) << " us";
+    }
+
+    static void alloc_gpu_memory_body(CudaModule *module, unsigned index, void *data)
+    {
+      GPU *gpu = module->gpus[index];
+      long long t_start = Clock::current_time_in_nanoseconds();
+      if(module->cfg_fb_mem_size_in_mb > 0)
+	gpu->allocate_fb_memory(module->cfg_fb_mem_size_in_mb << 20);
+      if(module->cfg_scratch_mem_size_in_mb > 0)
+	gpu->create_scratch_arena(module->cfg_scratch_mem_size_in_mb << 20);
+      long long t_end = Clock::current_time_in_nanoseconds();
+      log_gpu.info() << "GPU " << index << " memory allocated in "
+		     << ((t_end - t_start) / 1000) << " us";
+    }
+
+
     ////////////////////////////////////////////////////////////////////////
     //
     // class CudaModule
@@ -2280,6 +3457,7 @@ namespace Realm {
       , cfg_zc_mem_size_in_mb(64)
       , cfg_zc_ib_size_in_mb(256)
       , cfg_fb_mem_size_in_mb(256)
+      , cfg_managed_mem_size_in_mb(0)
       , cfg_num_gpus(0)
       , cfg_gpu_streams(12)
       , cfg_use_background_workers(true)
@@ -2287,7 +3465,16 @@ namespace Realm {
       , cfg_pin_sysmem(true)
       , cfg_fences_use_callbacks(false)
       , cfg_suppress_hijack_warning(false)
+      , cfg_graph_min_repeats(0)
+      , cfg_task_concurrency(1)
+      , cfg_scratch_mem_size_in_mb(0)
+      , cfg_p2p_probe_mb(4)
+      , cfg_parallel_init(true)
+      , cfg_cupti(false)
+      , cfg_cupti_buffers(16)
+      , cfg_cupti_buffer_kb(1024)
       , shared_worker(0), zcmem_cpu_base(0), zcib_cpu_base(0), zcmem(0)
+      , managed_mem(0), activity_tracer(0)
     {}
       
     CudaModule::~CudaModule(void)
@@ -2365,13 +3552,22 @@ namespace Realm {
 
 	cp.add_option_int("-ll:fsize", m->cfg_fb_mem_size_in_mb)
 	  .add_option_int("-ll:zsize", m->cfg_zc_mem_size_in_mb)
+	  .add_option_int("-ll:msize", m->cfg_managed_mem_size_in_mb)
 	  .add_option_int("-ll:ib_zsize", m->cfg_zc_ib_size_in_mb)
 	  .add_option_int("-ll:gpu", m->cfg_num_gpus)
 	  .add_option_int("-ll:streams", m->cfg_gpu_streams)
 	  .add_option_int("-ll:gpuworker", m->cfg_use_shared_worker)
 	  .add_option_int("-ll:pin", m->cfg_pin_sysmem)
 	  .add_option_bool("-cuda:callbacks", m->cfg_fences_use_callbacks)
-	  .add_option_bool("-cuda:nohijack", m->cfg_suppress_hijack_warning);
+	  .add_option_bool("-cuda:nohijack", m->cfg_suppress_hijack_warning)
+	  .add_option_int("-cuda:graphs", m->cfg_graph_min_repeats)
+	  .add_option_int("-cuda:concurrent", m->cfg_task_concurrency)
+	  .add_option_int("-cuda:scratch", m->cfg_scratch_mem_size_in_mb)
+	  .add_option_int("-cuda:p2p_probe", m->cfg_p2p_probe_mb)
+	  .add_option_int("-cuda:parinit", m->cfg_parallel_init)
+	  .add_option_bool("-cuda:cupti", m->cfg_cupti)
+	  .add_option_int("-cuda:cupti_bufs", m->cfg_cupti_buffers)
+	  .add_option_int("-cuda:cupti_bufsize", m->cfg_cupti_buffer_kb);
 	
 	bool ok = cp.parse_command_line(cmdline);
 	if(!ok) {
@@ -2395,6 +3591,20 @@ namespace Realm {
 	assert(false);
       }
 
+      // activity tracing has to start before any contexts are created
+      if(cfg_cupti) {
+#ifdef REALM_USE_CUPTI
+	activity_tracer = new GPUActivityTracer(cfg_cupti_buffer_kb << 10,
+						cfg_cupti_buffers);
+	if(!activity_tracer->start()) {
+	  delete activity_tracer;
+	  activity_tracer = 0;
+	}
+#else
+	log_gpu.warning() << "-cuda:cupti ignored - Realm was built without CUPTI support";
+#endif
+      }
+
       // if we are using a shared worker, create that next
       if(cfg_use_shared_worker) {
 	shared_worker = new GPUWorker;
@@ -2405,27 +3615,36 @@ namespace Realm {
       }
 
       // just use the GPUs in order right now
-      gpus.resize(cfg_num_gpus);
+      GPUCreateData cd;
+      cd.workers.resize(cfg_num_gpus);
+      // every concurrently-running task needs a stream of its own
+      cd.num_streams = std::max(cfg_gpu_streams, cfg_task_concurrency);
       for(unsigned i = 0; i < cfg_num_gpus; i++) {
 	// either create a worker for this GPU or use the shared one
-	GPUWorker *worker;
 	if(cfg_use_shared_worker) {
-	  worker = shared_worker;
+	  cd.workers[i] = shared_worker;
 	} else {
-	  worker = new GPUWorker;
+	  cd.workers[i] = new GPUWorker;
 
 	  if(cfg_use_background_workers)
-	    worker->start_background_thread(runtime->core_reservation_set(),
-					    1 << 20); // hardcoded worker stack size
+	    cd.workers[i]->start_background_thread(runtime->core_reservation_set(),
+						   1 << 20); // hardcoded worker stack size
 	}
+      }
 
-	GPU *g = new GPU(this, gpu_info[i], worker, cfg_gpu_streams);
-
-	if(!cfg_use_shared_worker)
-	  dedicated_workers[g] = worker;
-
-	gpus[i] = g;
+      // contexts for the GPUs are created in parallel
+      gpus.resize(cfg_num_gpus, 0);
+      {
+	std::vector<PerGPUInitArgs> args;
+	std::vector<pthread_t> threads;
+	start_per_gpu_init(create_gpu_body, this, cfg_num_gpus, &cd,
+			   cfg_parallel_init, args, threads);
+	finish_per_gpu_init(threads);
       }
+
+      if(!cfg_use_shared_worker)
+	for(unsigned i = 0; i < cfg_num_gpus; i++)
+	  dedicated_workers[gpus[i]] = cd.workers[i];
     }
 
     // create any memories provided by this module (default == do nothing)
@@ -2434,6 +3653,56 @@ namespace Realm {
     {
       Module::create_memories(runtime);
 
+      // each GPU's FB memory (and optional scratch arena for task-local
+      //  allocations) is allocated by a thread of its own, while this thread
+      //  allocates the pinned host memories below - the actual Realm memories
+      //  are created afterwards, in the usual order
+      std::vector<PerGPUInitArgs> args;
+      std::vector<pthread_t> threads;
+      start_per_gpu_init(alloc_gpu_memory_body, this, gpus.size(), 0,
+			 cfg_parallel_init, args, threads);
+
+      CUdeviceptr zcmem_gpu_base = 0;
+      if((cfg_zc_mem_size_in_mb > 0) && !gpus.empty()) {
+	// borrow GPU 0's context for the allocation call
+	AutoGPUContext agc(gpus[0]);
+
+	CHECK_CU( cuMemHostAlloc(&zcmem_cpu_base, 
+				 cfg_zc_mem_size_in_mb << 20,
+				 CU_MEMHOSTALLOC_PORTABLE | CU_MEMHOSTALLOC_DEVICEMAP) );
+	CHECK_CU( cuMemHostGetDevicePointer(&zcmem_gpu_base,
+					    zcmem_cpu_base,
+					    0) );
+	// right now there are asssumptions in several places that unified addressing keeps
+	//  the CPU and GPU addresses the same
+	assert(zcmem_cpu_base == (void *)zcmem_gpu_base);
+      }
+
+      CUdeviceptr managed_base = 0;
+      if((cfg_managed_mem_size_in_mb > 0) && !gpus.empty()) {
+	AutoGPUContext agc(gpus[0]);
+
+	CHECK_CU( cuMemAllocManaged(&managed_base,
+				    cfg_managed_mem_size_in_mb << 20,
+				    CU_MEM_ATTACH_GLOBAL) );
+      }
+
+      CUdeviceptr zcib_gpu_base = 0;
+      if((cfg_zc_ib_size_in_mb > 0) && !gpus.empty()) {
+	AutoGPUContext agc(gpus[0]);
+
+	CHECK_CU( cuMemHostAlloc(&zcib_cpu_base,
+				 cfg_zc_ib_size_in_mb << 20,
+				 CU_MEMHOSTALLOC_PORTABLE | CU_MEMHOSTALLOC_DEVICEMAP) );
+	CHECK_CU( cuMemHostGetDevicePointer(&zcib_gpu_base,
+					    zcib_cpu_base, 0) );
+	// right now there are asssumptions in several places that unified addressing keeps
+	//  the CPU and GPU addresses the same
+	assert(zcib_cpu_base == (void *)zcib_gpu_base);
+      }
+
+      finish_per_gpu_init(threads);
+
       // each GPU needs its FB memory
       if(cfg_fb_mem_size_in_mb > 0)
 	for(std::vector<GPU *>::iterator it = gpus.begin();
@@ -2443,22 +3712,6 @@ namespace Realm {
 
       // a single ZC memory for everybody
       if((cfg_zc_mem_size_in_mb > 0) && !gpus.empty()) {
-	CUdeviceptr zcmem_gpu_base;
-	// borrow GPU 0's context for the allocation call
-	{
-	  AutoGPUContext agc(gpus[0]);
-
-	  CHECK_CU( cuMemHostAlloc(&zcmem_cpu_base, 
-				   cfg_zc_mem_size_in_mb << 20,
-				   CU_MEMHOSTALLOC_PORTABLE | CU_MEMHOSTALLOC_DEVICEMAP) );
-	  CHECK_CU( cuMemHostGetDevicePointer(&zcmem_gpu_base,
-					      zcmem_cpu_base,
-					      0) );
-	  // right now there are asssumptions in several places that unified addressing keeps
-	  //  the CPU and GPU addresses the same
-	  assert(zcmem_cpu_base == (void *)zcmem_gpu_base);
-	}
-
 	Memory m = runtime->next_local_memory_id();
 	zcmem = new GPUZCMemory(m, zcmem_gpu_base, zcmem_cpu_base, 
 				cfg_zc_mem_size_in_mb << 20);
@@ -2480,20 +3733,20 @@ namespace Realm {
 	}
       }
 
+      // an optional managed memory shared by everybody
+      if((cfg_managed_mem_size_in_mb > 0) && !gpus.empty()) {
+	Memory m = runtime->next_local_memory_id();
+	managed_mem = new GPUManagedMemory(m, this, managed_base,
+					   cfg_managed_mem_size_in_mb << 20);
+	runtime->add_memory(managed_mem);
+
+	// the GPUs copy to/from it like any other host-addressable memory
+	for(unsigned i = 0; i < gpus.size(); i++)
+	  gpus[i]->pinned_sysmems.insert(managed_mem->me);
+      }
+
       // allocate intermediate buffers in ZC memory for DMA engine
       if ((cfg_zc_ib_size_in_mb > 0) && !gpus.empty()) {
-        CUdeviceptr zcib_gpu_base;
-        {
-          AutoGPUContext agc(gpus[0]);
-          CHECK_CU( cuMemHostAlloc(&zcib_cpu_base,
-                                   cfg_zc_ib_size_in_mb << 20,
-                                   CU_MEMHOSTALLOC_PORTABLE | CU_MEMHOSTALLOC_DEVICEMAP) );
-          CHECK_CU( cuMemHostGetDevicePointer(&zcib_gpu_base,
-                                              zcib_cpu_base, 0) );
-          // right now there are asssumptions in several places that unified addressing keeps
-          //  the CPU and GPU addresses the same
-          assert(zcib_cpu_base == (void *)zcib_gpu_base); 
-        }
         Memory m = runtime->next_local_ib_memory_id();
         GPUZCMemory* ib_mem;
         ib_mem = new GPUZCMemory(m, zcib_gpu_base, zcib_cpu_base,
@@ -2591,6 +3844,9 @@ namespace Realm {
 	}
       }
 
+      // decide how copies between GPUs should travel
+      probe_p2p_topology();
+
       // now actually let each GPU make its channels
       for(std::vector<GPU *>::iterator it = gpus.begin();
 	  it != gpus.end();
@@ -2600,6 +3856,140 @@ namespace Realm {
       Module::create_dma_channels(runtime);
     }
 
+    // best-of-three synchronous copy bandwidth in MB/s, issued from the
+    //  given GPU's context (unified addressing covers host and peer pointers)
+    static double measure_copy_bandwidth(GPU *gpu, CUdeviceptr dst, CUdeviceptr src,
+					 size_t bytes)
+    {
+      AutoGPUContext agc(gpu);
+
+      // the first copy warms up the path
+      CHECK_CU( cuMemcpy(dst, src, bytes) );
+      CHECK_CU( cuCtxSynchronize() );
+
+      long long best_ns = -1;
+      for(int i = 0; i < 3; i++) {
+	long long start = Clock::current_time_in_nanoseconds();
+	CHECK_CU( cuMemcpy(dst, src, bytes) );
+	CHECK_CU( cuCtxSynchronize() );
+	long long elapsed = Clock::current_time_in_nanoseconds() - start;
+	if((best_ns < 0) || (elapsed < best_ns))
+	  best_ns = elapsed;
+      }
+      return bytes * 1e3 / ((best_ns > 0) ? best_ns : 1);
+    }
+
+    void CudaModule::probe_p2p_topology(void)
+    {
+      size_t bytes = cfg_p2p_probe_mb << 20;
+      if((bytes == 0) || (gpus.size() < 2))
+	return;
+
+      std::vector<off_t> probe_offsets(gpus.size(), -1);
+      for(size_t i = 0; i < gpus.size(); i++)
+	if(gpus[i]->fbmem)
+	  probe_offsets[i] = gpus[i]->fbmem->alloc_bytes(bytes);
+
+      bool probe_host = (zcmem != 0) && ((cfg_zc_mem_size_in_mb << 20) >= bytes);
+
+      for(size_t i = 0; i < gpus.size(); i++) {
+	if(probe_offsets[i] < 0) continue;
+	GPU *src = gpus[i];
+	CUdeviceptr src_ptr = src->fbmem->base + probe_offsets[i];
+
+	if(probe_host) {
+	  src->d2h_bandwidth = measure_copy_bandwidth(src, (CUdeviceptr)zcmem_cpu_base,
+						      src_ptr, bytes);
+	  src->h2d_bandwidth = measure_copy_bandwidth(src, src_ptr,
+						      (CUdeviceptr)zcmem_cpu_base, bytes);
+	}
+
+	for(size_t j = 0; j < gpus.size(); j++) {
+	  if((j == i) || (probe_offsets[j] < 0)) continue;
+	  GPU *dst = gpus[j];
+	  if(src->peer_fbs.count(dst->fbmem->me) == 0) continue;
+	  src->peer_bandwidth[dst] = measure_copy_bandwidth(src,
+							    dst->fbmem->base + probe_offsets[j],
+							    src_ptr, bytes);
+	}
+      }
+
+      for(size_t i = 0; i < gpus.size(); i++)
+	if(probe_offsets[i] >= 0)
+	  gpus[i]->fbmem->free_bytes(probe_offsets[i], bytes);
+
+      // now pick the fastest route for each pair - relays and host staging
+      //  are assumed not to overlap their two hops
+      for(std::vector<GPU *>::iterator it = gpus.begin(); it != gpus.end(); it++) {
+	GPU *src = *it;
+	for(std::map<GPU *, double>::const_iterator it2 = src->peer_bandwidth.begin();
+	    it2 != src->peer_bandwidth.end();
+	    it2++) {
+	  GPU *dst = it2->first;
+	  double best = it2->second;
+	  GPU *relay = 0;
+	  bool via_host = false;
+
+	  if((src->d2h_bandwidth > 0) && (dst->h2d_bandwidth > 0)) {
+	    double staged = 1.0 / (1.0 / src->d2h_bandwidth + 1.0 / dst->h2d_bandwidth);
+	    if(staged > best) {
+	      best = staged;
+	      via_host = true;
+	    }
+	  }
+
+	  for(std::map<GPU *, double>::const_iterator it3 = src->peer_bandwidth.begin();
+	      it3 != src->peer_bandwidth.end();
+	      it3++) {
+	    if(it3->first == dst) continue;
+	    std::map<GPU *, double>::const_iterator it4 = it3->first->peer_bandwidth.find(dst);
+	    if(it4 == it3->first->peer_bandwidth.end()) continue;
+	    double relayed = 1.0 / (1.0 / it3->second + 1.0 / it4->second);
+	    if(relayed > best) {
+	      best = relayed;
+	      relay = it3->first;
+	      via_host = false;
+	    }
+	  }
+
+	  if(relay) {
+	    off_t ofs = relay->fbmem->alloc_bytes(GPU::RELAY_STAGING_BYTES);
+	    if(ofs < 0) {
+	      // no room for the staging buffer - stay direct
+	      best = it2->second;
+	      relay = 0;
+	    } else {
+	      GPU::PeerRelay& r = src->peer_relays[dst];
+	      r.relay = relay;
+	      r.staging_offset = ofs;
+	    }
+	  }
+
+	  if(via_host) {
+	    // without the peer FB in the visible set, the DMA system stages
+	    //  these copies through zero-copy memory
+	    src->peer_fbs.erase(dst->fbmem->me);
+	    log_gpu.info() << "copies from GPU " << src->info->index << " to GPU "
+			   << dst->info->index << " staged through host ("
+			   << best << " MB/s vs " << it2->second << " MB/s direct)";
+	    continue;
+	  }
+
+	  if(relay)
+	    log_gpu.info() << "copies from GPU " << src->info->index << " to GPU "
+			   << dst->info->index << " relayed through GPU " << relay->info->index
+			   << " (" << best << " MB/s vs " << it2->second << " MB/s direct)";
+	  else
+	    log_gpu.info() << "copies from GPU " << src->info->index << " to GPU "
+			   << dst->info->index << " direct (" << best << " MB/s)";
+
+	  src->peer_route_bandwidth[dst->fbmem->me] = best;
+	  LegionRuntime::LowLevel::set_measured_hop_cost(src->fbmem->me, dst->fbmem->me,
+							  10, best);
+	}
+      }
+    }
+
     // create any code translators provided by the module (default == do nothing)
     void CudaModule::create_code_translators(RuntimeImpl *runtime)
     {
@@ -2608,8 +3998,58 @@ namespace Realm {
 
     // clean up any common resources created by the module - this will be called
     //  after all memories/processors/etc. have been shut down and destroyed
+    void CudaModule::register_external_memory(MemoryImpl *mem, void *ptr, size_t size)
+    {
+      if(gpus.empty())
+	return;
+      // only memories whose contents the GPUs may access or DMA without
+      //  staging need the new range pinned as well
+      if((mem != zcmem) &&
+	 (gpus[0]->pinned_sysmems.count(mem->me) == 0))
+	return;
+
+      CUresult ret;
+      {
+	AutoGPUContext agc(gpus[0]);
+	ret = cuMemHostRegister(ptr, size,
+				CU_MEMHOSTREGISTER_PORTABLE |
+				CU_MEMHOSTREGISTER_DEVICEMAP);
+      }
+      if(ret == CUDA_SUCCESS) {
+	AutoHSLLock al(external_mutex);
+	external_registrations.insert(ptr);
+	log_gpu.info() << "registered external storage " << ptr << " + " << size
+		       << " in memory " << mem->me;
+      } else if(ret == CUDA_ERROR_HOST_MEMORY_ALREADY_REGISTERED) {
+	// the application pinned it itself, and will unpin it
+      } else {
+	log_gpu.warning() << "failed to register external storage " << ptr << " + " << size
+			  << " in memory " << mem->me << " : " << ret;
+      }
+    }
+
+    void CudaModule::unregister_external_memory(MemoryImpl *mem, void *ptr, size_t size)
+    {
+      {
+	AutoHSLLock al(external_mutex);
+	if(external_registrations.erase(ptr) == 0)
+	  return;
+      }
+      AutoGPUContext agc(gpus[0]);
+      CHECK_CU( cuMemHostUnregister(ptr) );
+    }
+
     void CudaModule::cleanup(void)
     {
+#ifdef REALM_USE_CUPTI
+      // any work still in flight has nobody left to report to
+      if(activity_tracer) {
+	activity_tracer->stop();
+	delete activity_tracer;
+	activity_tracer = 0;
+      }
+#endif
+
       // clean up worker(s)
       if(shared_worker) {
 	if(cfg_use_background_workers)
@@ -2637,6 +4077,13 @@ namespace Realm {
 	CHECK_CU( cuMemFreeHost(zcmem_cpu_base) );
       }
 
+      // and managed memory
+      if(managed_mem) {
+	assert(!gpus.empty());
+	AutoGPUContext agc(gpus[0]);
+	CHECK_CU( cuMemFree(managed_mem->base) );
+      }
+
       for(std::vector<GPU *>::iterator it = gpus.begin();
 	  it != gpus.end();
 	  it++)
@@ -70,6 +70,8 @@ namespace Realm {
     class GPUWorker;
     struct GPUInfo;
     class GPUZCMemory;
+    class GPUManagedMemory;
+    class GPUActivityTracer;
 
     // our interface to the rest of the runtime
     class CudaModule : public Module {
@@ -100,17 +102,44 @@ namespace Realm {
       // create any code translators provided by the module (default == do nothing)
       virtual void create_code_translators(RuntimeImpl *runtime);
 
+      // measures the peer bandwidth matrix and picks a route for each pair
+      //  of GPUs - called before the GPUs create their DMA channels
+      void probe_p2p_topology(void);
+
+      // pins application storage used by instances in memories the GPUs
+      //  treat as pinned (i.e. zero-copy and registered system memory)
+      virtual void register_external_memory(MemoryImpl *mem, void *ptr, size_t size);
+      virtual void unregister_external_memory(MemoryImpl *mem, void *ptr, size_t size);
+
       // clean up any common resources created by the module - this will be called
       //  after all memories/processors/etc. have been shut down and destroyed
       virtual void cleanup(void);
 
     public:
       size_t cfg_zc_mem_size_in_mb, cfg_zc_ib_size_in_mb;
-      size_t cfg_fb_mem_size_in_mb;
+      size_t cfg_fb_mem_size_in_mb, cfg_managed_mem_size_in_mb;
       unsigned cfg_num_gpus, cfg_gpu_streams;
       bool cfg_use_background_workers, cfg_use_shared_worker, cfg_pin_sysmem;
       bool cfg_fences_use_callbacks;
       bool cfg_suppress_hijack_warning;
+      // sequences of kernel launches within a task that have been seen
+      //  this many times are replayed as a single CUDA graph (0 = never)
+      unsigned cfg_graph_min_repeats;
+      // number of tasks each GPU processor may have running at once - each
+      //  running task gets a task stream to itself
+      unsigned cfg_task_concurrency;
+      // size of the per-GPU arena used for task-local cudaMalloc's (0 = off)
+      size_t cfg_scratch_mem_size_in_mb;
+      // size of the copies used to measure GPU-to-GPU bandwidth at startup
+      //  (0 = don't measure, and always copy peer-to-peer directly)
+      size_t cfg_p2p_probe_mb;
+      // create contexts and allocate FB memory on a thread per GPU
+      bool cfg_parallel_init;
+      // trace the kernels, copies and fills of GPU tasks with CUPTI, using
+      //  a ring of this many buffers of the given size
+      bool cfg_cupti;
+      unsigned cfg_cupti_buffers;
+      size_t cfg_cupti_buffer_kb;
 
       // "global" variables live here too
       GPUWorker *shared_worker;
@@ -119,6 +148,11 @@ namespace Realm {
       std::vector<GPU *> gpus;
       void *zcmem_cpu_base, *zcib_cpu_base;
       GPUZCMemory *zcmem;
+      GPUManagedMemory *managed_mem;
+      GPUActivityTracer *activity_tracer;  // 0 unless -cuda:cupti is given
+      // external ranges we registered ourselves (and must unregister)
+      GASNetHSL external_mutex;
+      std::set<void *> external_registrations;
     };
 
     REGISTER_REALM_MODULE(CudaModule);
@@ -179,6 +213,11 @@ namespace Realm {
       virtual ~GPUMemcpy(void) { }
     public:
       virtual void execute(GPUStream *stream) = 0;
+
+      // attempts to fold the copy that follows this one on the same stream
+      //  into this one - on success, 'next' has no work left and may be
+      //  deleted
+      virtual bool merge(GPUMemcpy *next) { return false; }
     public:
       GPU *const gpu;
     protected:
@@ -193,12 +232,73 @@ namespace Realm {
 
       void enqueue_on_stream(GPUStream *stream);
 
+      // called once all the work before the fence is done on the device
+      void mark_device_work_finished(void);
+
       virtual void print(std::ostream& os) const;
 
+      // set if the device work of the task is being traced
+      GPUActivityTracer *tracer;
+      unsigned long long activity_id;
+
     protected:
       static void cuda_callback(CUstream stream, CUresult res, void *data);
     };
 
+    // traces the device work issued by GPU tasks with CUPTI's activity API -
+    //  each task's launches are tagged with an external correlation id, and
+    //  CUPTI fills a fixed ring of buffers that is handed back as soon as the
+    //  records in a buffer have been sorted by task (if the ring runs dry,
+    //  CUPTI drops records rather than us allocating more)
+    class GPUActivityTracer {
+    public:
+      GPUActivityTracer(size_t _buffer_size, unsigned _num_buffers);
+      ~GPUActivityTracer(void);
+
+      // returns false if CUPTI could not be set up
+      bool start(void);
+      void stop(void);
+
+      // tags the work launched by the calling thread until pop_task
+      unsigned long long push_task(void);
+      void pop_task(void);
+
+      // flushes CUPTI's buffers and moves the records tagged with 'id' into
+      //  'activity' - CUPTI can't be flushed from a CUDA stream callback
+      void collect(unsigned long long id,
+		   ProfilingMeasurements::OperationGPUActivity *activity);
+
+    protected:
+      typedef ProfilingMeasurements::OperationGPUActivity::Interval Interval;
+
+      static void buffer_requested(uint8_t **buffer, size_t *size,
+				   size_t *max_num_records);
+      static void buffer_completed(CUcontext ctx, uint32_t stream_id,
+				   uint8_t *buffer, size_t size,
+				   size_t valid_size);
+
+      void process_buffer(uint8_t *buffer, size_t valid_size);
+      void add_interval(uint32_t correlation_id, const Interval& interval);
+
+      // records that never find their task (e.g. Realm's own copies, or
+      //  work finishing after its task was reported) are only kept this long
+      static const size_t MAX_PENDING = 4096;
+
+      size_t buffer_size;
+      std::vector<uint8_t *> all_buffers;
+      unsigned long long next_id;
+      long long clock_offset;  // Realm's clock minus CUPTI's
+
+      GASNetHSL mutex;
+      std::vector<uint8_t *> free_buffers;
+      size_t denied_buffers;
+      // CUPTI correlation id -> task, for launches whose work hasn't shown up
+      std::map<uint32_t, unsigned long long> task_of_launch;
+      // work whose launch hasn't been matched to a task yet
+      std::map<uint32_t, std::vector<Interval> > unmatched;
+      std::map<unsigned long long, std::vector<Interval> > task_intervals;
+    };
+
     class GPUMemcpyFence : public GPUMemcpy {
     public:
       GPUMemcpyFence(GPU *_gpu, GPUMemcpyKind _kind,
@@ -227,12 +327,18 @@ namespace Realm {
     public:
       void do_span(off_t pos, size_t len);
       virtual void execute(GPUStream *stream);
+      virtual bool merge(GPUMemcpy *next);
     protected:
       void *dst;
       const void *src;
       const ElementMask *mask;
       size_t elmt_size;
       GPUCompletionNotification *notification;
+      // unmasked copies with regularly-spaced successors become a single
+      //  2D copy of 'lines' rows
+      size_t lines;
+      off_t dst_stride, src_stride;
+      std::vector<GPUCompletionNotification *> merged_notifications;
     private:
       GPUStream *local_stream;  // used by do_span
     };
@@ -280,6 +386,30 @@ namespace Realm {
       GPUCompletionNotification *notification;
     };
 
+    // fills device memory with a repeating pattern using the cuMemset
+    //  family - either a contiguous run of 'bytes' bytes (lines == 1) or
+    //  one pattern element at the start of each of 'lines' lines
+    class GPUMemset : public GPUMemcpy {
+    public:
+      GPUMemset(GPU *_gpu,
+		void *_dst, size_t _bytes, off_t _dst_stride, size_t _lines,
+		const void *_fill_data, size_t _fill_data_size,
+		GPUCompletionNotification *_notification);
+
+      virtual ~GPUMemset(void);
+
+    public:
+      virtual void execute(GPUStream *stream);
+    protected:
+      void *dst;
+      size_t bytes;
+      off_t dst_stride;
+      size_t lines;
+      char *fill_data;
+      size_t fill_data_size;
+      GPUCompletionNotification *notification;
+    };
+
     // a class that represents a CUDA stream and work associated with 
     //  it (e.g. queued copies, events in flight)
     // a stream is also associated with a GPUWorker that it will register
@@ -297,6 +427,11 @@ namespace Realm {
       void add_fence(GPUWorkFence *fence);
       void add_notification(GPUCompletionNotification *notification);
 
+      // copy completions are batched so that a run of copies on the stream
+      //  costs a single event record
+      void add_batched_notification(GPUCompletionNotification *notification);
+      void flush_batched_notifications(void);
+
       // to be called by a worker (that should already have the GPU context
       //   current) - returns true if any work remains
       bool issue_copies(void);
@@ -330,6 +465,8 @@ namespace Realm {
 #else
       std::deque<PendingEvent> pending_events;
 #endif
+
+      std::vector<GPUCompletionNotification *> batched_notifications;
     };
 
     // a GPUWorker is responsible for making progress on one or more GPUStreams -
@@ -386,6 +523,28 @@ namespace Realm {
       std::vector<CUevent> available_events;
     };
 
+    // a first-fit sub-allocator for task-local scratch memory carved out of
+    //  a single device allocation - the GPU processor hands blocks back only
+    //  after the stream that used them has caught up, so freeing never
+    //  requires a device synchronization
+    class GPUScratchArena {
+    public:
+      GPUScratchArena(CUdeviceptr _base, size_t _size);
+
+      // returns 0 if no free block is large enough
+      CUdeviceptr alloc(size_t bytes);
+      void free(CUdeviceptr ptr, size_t bytes);
+
+      static const size_t ALIGNMENT = 256;
+
+      CUdeviceptr base;
+      size_t size;
+
+    protected:
+      GASNetHSL mutex;
+      std::map<size_t, size_t> free_blocks; // offset -> size
+    };
+
     struct FatBin;
     struct RegisteredVariable;
     struct RegisteredFunction;
@@ -410,7 +569,11 @@ namespace Realm {
       CUdeviceptr lookup_variable(const void *var);
 
       void create_processor(RuntimeImpl *runtime, size_t stack_size);
+      // the FB allocation itself is split from the creation of the Realm
+      //  memory so that GPUs can allocate in parallel during startup
+      void allocate_fb_memory(size_t size);
       void create_fb_memory(RuntimeImpl *runtime, size_t size);
+      void create_scratch_arena(size_t size);
 
       void create_dma_channels(Realm::RuntimeImpl *r);
 
@@ -459,6 +622,15 @@ namespace Realm {
                              size_t bytes, size_t height, size_t depth,
 			     GPUCompletionNotification *notification = 0);
 
+      // fills are asynchronous like copies (and use the same fence)
+      void fill_within_fb(off_t dst_offset, size_t bytes,
+			  const void *fill_data, size_t fill_data_size,
+			  GPUCompletionNotification *notification = 0);
+
+      void fill_within_fb_2d(off_t dst_offset, off_t dst_stride, size_t lines,
+			     const void *fill_data, size_t fill_data_size,
+			     GPUCompletionNotification *notification = 0);
+
       void copy_to_peer(GPU *dst, off_t dst_offset, 
                         off_t src_offset, size_t bytes,
 			GPUCompletionNotification *notification = 0);
@@ -493,7 +665,10 @@ namespace Realm {
 
       bool can_access_peer(GPU *peer);
 
+      // picks the next task stream not in use by another running task and
+      //  binds it to the calling thread until release_task_stream is called
       GPUStream *switch_to_next_task_stream(void);
+      void release_task_stream(GPUStream *stream);
       GPUStream *get_current_task_stream(void);
 
     protected:
@@ -505,6 +680,7 @@ namespace Realm {
       GPUWorker *worker;
       GPUProcessor *proc;
       GPUFBMemory *fbmem;
+      GPUScratchArena *scratch_arena;
 
       CUcontext context;
       CUdeviceptr fbmem_base;
@@ -515,16 +691,38 @@ namespace Realm {
       // which other FBs we have peer access to
       std::set<Memory> peer_fbs;
 
+      // measured copy bandwidths in MB/s (see CudaModule::probe_p2p_topology)
+      std::map<GPU *, double> peer_bandwidth;
+      double d2h_bandwidth, h2d_bandwidth;
+      // bandwidth of the route chosen for copies to each peer FB
+      std::map<Memory, double> peer_route_bandwidth;
+
+      // peers that are reached faster by relaying through a third GPU - we
+      //  own a staging buffer in the relay's FB for each of them
+      struct PeerRelay {
+	GPU *relay;
+	off_t staging_offset;
+      };
+      std::map<GPU *, PeerRelay> peer_relays;
+      static const size_t RELAY_STAGING_BYTES = 4 << 20;
+
       // streams for different copy types and a pile for actual tasks
       GPUStream *host_to_device_stream;
       GPUStream *device_to_host_stream;
       GPUStream *device_to_device_stream;
       GPUStream *peer_to_peer_stream;
       std::vector<GPUStream *> task_streams;
+      std::vector<bool> task_stream_busy;
       unsigned current_stream;
+      GASNetHSL task_stream_mutex;
 
       GPUEventPool event_pool;
 
+      // copy batching statistics
+      ProfilingGauges::EventCounter<int> *copy_batches;
+      ProfilingGauges::EventCounter<int> *batched_copies;
+      ProfilingGauges::EventCounter<int> *merged_copies;
+
       std::map<const FatBin *, CUmodule> device_modules;
       std::map<const void *, CUfunction> device_functions;
       std::map<const void *, CUdeviceptr> device_variables;
@@ -582,6 +780,14 @@ namespace Realm {
 
       void gpu_memset(void *dst, int value, size_t count);
       void gpu_memset_async(void *dst, int value, size_t count, cudaStream_t stream);
+
+      // task-local scratch allocations - these return false if the request
+      //  can't be satisfied from (or didn't come from) the scratch arena
+      bool scratch_malloc(void **ptr, size_t size);
+      bool scratch_free(void *ptr);
+      // returns all of the current task's scratch blocks once the given
+      //  stream has finished the task's work
+      void release_task_scratch(GPUStream *stream);
     public:
       GPU *gpu;
 
@@ -592,11 +798,47 @@ namespace Realm {
         size_t shared;
 	LaunchConfig(dim3 _grid, dim3 _block, size_t _shared);
       };
-      std::vector<LaunchConfig> launch_configs;
-      std::vector<char> kernel_args;
+
+      struct PendingLaunch {
+        CUfunction func;
+        LaunchConfig config;
+        std::vector<char> args;
+        PendingLaunch(CUfunction _func, const LaunchConfig& _config,
+                      const std::vector<char>& _args);
+      };
+
+      // launch state is kept per running task (i.e. per thread) so that
+      //  concurrent tasks on the same processor don't see each other's
+      //  configurations and arguments
+      struct LaunchState {
+        std::vector<LaunchConfig> launch_configs;
+        std::vector<char> kernel_args;
+        std::vector<PendingLaunch> pending_launches;
+        // scratch blocks allocated by the task and not yet freed
+        std::map<CUdeviceptr, size_t> scratch_allocs;
+      };
+      static LaunchState& get_current_launch_state(void);
+
+      // with graph replay enabled, a task's kernel launches are held back
+      //  until the end of the task (or until some other operation on the
+      //  task's stream needs them issued) and then issued as a graph if the
+      //  exact same sequence has been launched often enough before
+      void flush_kernel_launches(void);
 
     protected:
       Realm::CoreReservation *core_rsrv;
+
+      struct KernelGraph {
+        unsigned times_seen;
+#if CUDA_VERSION >= 10000
+        CUgraph graph;
+        CUgraphExec exec;
+#endif
+      };
+      // keyed by the functions, configurations and argument bytes of the
+      //  launches, so a graph is only replayed for identical work
+      std::map<std::string, KernelGraph> kernel_graphs;
+      GASNetHSL kernel_graph_mutex;
     };
 
     class GPUFBMemory : public MemoryImpl {
@@ -668,11 +910,60 @@ namespace Realm {
 
       virtual int get_home_node(off_t offset, size_t size);
 
+      virtual bool wrap_external(void *ptr, size_t size, off_t& offset);
+
     public:
       CUdeviceptr gpu_base;
       char *cpu_base;
     };
 
+    // CUDA managed memory - one allocation shared by the CPUs and all GPUs
+    //  whose pages migrate to whoever touches them, which lets a working set
+    //  exceed the FB sizes without the mapper splitting it up
+    class GPUManagedMemory : public MemoryImpl {
+    public:
+      GPUManagedMemory(Memory _me, CudaModule *_module, CUdeviceptr _base, size_t _size);
+
+      virtual ~GPUManagedMemory(void);
+
+      virtual RegionInstance create_instance(IndexSpace is,
+					     const int *linearization_bits,
+					     size_t bytes_needed,
+					     size_t block_size,
+					     size_t element_size,
+					     const std::vector<size_t>& field_sizes,
+					     ReductionOpID redopid,
+					     off_t list_size,
+                                             const Realm::ProfilingRequestSet &reqs,
+					     RegionInstance parent_inst);
+
+      virtual void destroy_instance(RegionInstance i, 
+				    bool local_destroy);
+
+      virtual off_t alloc_bytes(size_t size);
+
+      virtual void free_bytes(off_t offset, size_t size);
+
+      virtual void get_bytes(off_t offset, void *dst, size_t size);
+
+      virtual void put_bytes(off_t offset, const void *src, size_t size);
+
+      virtual void *get_direct_ptr(off_t offset, size_t size);
+
+      virtual int get_home_node(off_t offset, size_t size);
+
+      // migrates the range to the target GPU's FB (or to host memory for a
+      //  CPU processor) ahead of its use
+      virtual void prefetch(off_t offset, size_t size, Processor target);
+
+    public:
+      CudaModule *module;
+      CUdeviceptr base;
+
+      ProfilingGauges::EventCounter<int> *prefetches;
+      ProfilingGauges::EventCounter<long long> *prefetched_bytes;
+    };
+
   }; // namespace LowLevel
 }; // namespace LegionRuntime
 
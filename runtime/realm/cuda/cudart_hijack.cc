@@ -229,7 +229,10 @@ namespace Realm {
 
       cudaError_t cudaMalloc(void **ptr, size_t size)
       {
-	/*GPUProcessor *p =*/ get_gpu_or_die("cudaMalloc");
+	GPUProcessor *p = get_gpu_or_die("cudaMalloc");
+
+	// task-local scratch comes from the GPU's arena when there's room
+	if(p->scratch_malloc(ptr, size)) return cudaSuccess;
 
 	CUresult ret = cuMemAlloc((CUdeviceptr *)ptr, size);
 	if(ret == CUDA_SUCCESS) return cudaSuccess;
@@ -248,7 +251,9 @@ namespace Realm {
 
       cudaError_t cudaFree(void *ptr)
       {
-	/*GPUProcessor *p =*/ get_gpu_or_die("cudaFree");
+	GPUProcessor *p = get_gpu_or_die("cudaFree");
+
+	if(p->scratch_free(ptr)) return cudaSuccess;
 
 	CUresult ret = cuMemFree((CUdeviceptr)ptr);
 	if(ret == CUDA_SUCCESS) return cudaSuccess;
@@ -0,0 +1,1158 @@
+/* Copyright 2017 Stanford University, NVIDIA Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// dependent partitioning (by field/image/preimage) and batched binary
+//  operations for unstructured index spaces
+
+#include "deppart_impl.h"
+
+#include "idx_impl.h"
+#include "inst_impl.h"
+#include "runtime_impl.h"
+#include "serialize.h"
+#include "logging.h"
+#include "id.h"
+
+#include <string.h>
+#include <assert.h>
+
+#include <algorithm>
+
+TYPE_IS_SERIALIZABLE(Realm::IndexSpace);
+TYPE_IS_SERIALIZABLE(Realm::RegionInstance);
+TYPE_IS_SERIALIZABLE(Realm::DomainPoint);
+
+namespace Realm {
+
+  extern Logger log_deppart;
+
+  static DeppartQueue *deppart_queue = 0;
+
+  // largest block of a piece request/result sent in a single message
+  static const size_t DEPPART_BLOCK_SIZE = 64 << 10;
+
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // piece computation
+  //
+
+  // masks are sent trimmed to their enabled range
+  template <typename S>
+  bool serialize_mask(S& s, const ElementMask& m)
+  {
+    ElementMask trimmed(m, true /*trim*/);
+    return ((s << trimmed.first_element) &&
+	    (s << trimmed.num_elements) &&
+	    (s << trimmed.first_enabled_elmt) &&
+	    (s << trimmed.last_enabled_elmt) &&
+	    s.append_bytes(trimmed.get_raw(), trimmed.raw_size()));
+  }
+
+  template <typename S>
+  bool deserialize_mask(S& s, ElementMask& m)
+  {
+    coord_t first_element, first_enabled, last_enabled;
+    size_t num_elements;
+    if(!((s >> first_element) &&
+	 (s >> num_elements) &&
+	 (s >> first_enabled) &&
+	 (s >> last_enabled)))
+      return false;
+
+    m = ElementMask(num_elements, first_element);
+    if(!s.extract_bytes(m.raw_data, m.raw_size()))
+      return false;
+    m.first_enabled_elmt = first_enabled;
+    m.last_enabled_elmt = last_enabled;
+    return true;
+  }
+
+  // everything needed to compute the contribution of a single field data
+  //  descriptor - shipped to the node that owns the instance when the data
+  //  isn't local
+  struct DeppartPiece {
+    DeppartOperation::Kind kind;
+    IndexSpace parent;
+    IndexSpace::FieldDataDescriptor field_data;
+    std::vector<DomainPoint> colors;
+    std::vector<IndexSpace> keys;
+    // for incremental by_field operations, the elements to recolor
+    bool incremental;
+    ElementMask changed;
+  };
+
+  template <typename S>
+  bool serialize(S& s, const DeppartPiece& p)
+  {
+    return ((s << (int)p.kind) &&
+	    (s << p.parent) &&
+	    (s << p.field_data.index_space) &&
+	    (s << p.field_data.inst) &&
+	    (s << p.field_data.field_offset) &&
+	    (s << p.field_data.field_size) &&
+	    (s << p.colors) &&
+	    (s << p.keys) &&
+	    (s << p.incremental) &&
+	    (!p.incremental || serialize_mask(s, p.changed)));
+  }
+
+  template <typename S>
+  bool deserialize(S& s, DeppartPiece& p)
+  {
+    int kind;
+    if(!(s >> kind)) return false;
+    p.kind = (DeppartOperation::Kind)kind;
+    return ((s >> p.parent) &&
+	    (s >> p.field_data.index_space) &&
+	    (s >> p.field_data.inst) &&
+	    (s >> p.field_data.field_offset) &&
+	    (s >> p.field_data.field_size) &&
+	    (s >> p.colors) &&
+	    (s >> p.keys) &&
+	    (s >> p.incremental) &&
+	    (!p.incremental || deserialize_mask(s, p.changed)));
+  }
+
+  // reads a field of an instance, directly if its memory is addressable on
+  //  this node and through the instance otherwise
+  class FieldReader {
+  public:
+    FieldReader(RegionInstance inst, size_t _field_offset)
+      : impl(get_runtime()->get_instance_impl(inst))
+      , field_offset(_field_offset), base(0), stride(0), mapping(0)
+    {
+      void *ptr = 0;
+      if(impl->get_strided_parameters(ptr, stride, field_offset))
+	base = (const char *)ptr;
+      else
+	mapping = impl->metadata.linearization.get_mapping<1>();
+    }
+
+    void read(coord_t index, void *dst, size_t bytes) const
+    {
+      if(base)
+	memcpy(dst, base + (index * stride), bytes);
+      else
+	impl->get_bytes(mapping->image(index), field_offset, dst, bytes);
+    }
+
+  protected:
+    RegionInstanceImpl *impl;
+    off_t field_offset;
+    const char *base;
+    size_t stride;
+    LegionRuntime::Arrays::Mapping<1, 1> *mapping;
+  };
+
+  static const ElementMask& local_valid_mask(IndexSpace is)
+  {
+    IndexSpaceImpl *impl = get_runtime()->get_index_space_impl(is);
+    assert(impl->valid_mask_complete);
+    return *(impl->valid_mask);
+  }
+
+  // results are created empty and filled in once they've been computed
+  static void install_valid_mask(IndexSpace is, const ElementMask& mask)
+  {
+    IndexSpaceImpl *impl = get_runtime()->get_index_space_impl(is);
+    AutoHSLLock al(impl->valid_mask_mutex);
+    if(impl->locked_data.frozen) {
+      *(impl->valid_mask) = ElementMask(mask, true /*trim*/);
+      impl->locked_data.first_elmt = impl->valid_mask->first_enabled();
+      impl->locked_data.last_elmt = impl->valid_mask->last_enabled();
+    } else
+      *(impl->valid_mask) = mask;
+  }
+
+  static void needed_spaces(DeppartOperation::Kind kind, IndexSpace parent,
+			    const IndexSpace::FieldDataDescriptor& field_data,
+			    const std::vector<IndexSpace>& keys,
+			    std::set<IndexSpace>& spaces)
+  {
+    spaces.insert(field_data.index_space);
+    if(kind == DeppartOperation::DEPPART_BY_IMAGE)
+      spaces.insert(parent);
+    spaces.insert(keys.begin(), keys.end());
+  }
+
+  static Event fetch_valid_masks(const std::set<IndexSpace>& spaces)
+  {
+    std::set<Event> events;
+    for(std::set<IndexSpace>::const_iterator it = spaces.begin();
+	it != spaces.end();
+	it++) {
+      Event e = get_runtime()->get_index_space_impl(*it)->fetch_valid_mask();
+      if(e.exists())
+	events.insert(e);
+    }
+    return Event::merge_events(events);
+  }
+
+  // partial results for by_field and by_preimage can only contain elements
+  //  of the piece's own index space, so they are sized to its enabled range
+  static void enable_in(DeppartMasks& results, const ElementMask& src,
+			int idx, coord_t start, size_t count)
+  {
+    if(!results[idx]) {
+      coord_t lo = src.first_enabled() & ~(coord_t)63;
+      results[idx] = new ElementMask(src.last_enabled() + 1 - lo, lo);
+    }
+    results[idx]->enable(start, count);
+  }
+
+  static void compute_piece(DeppartOperation::Kind kind, IndexSpace parent,
+			    const IndexSpace::FieldDataDescriptor& field_data,
+			    const std::vector<DomainPoint>& colors,
+			    const std::vector<IndexSpace>& keys,
+			    const ElementMask *changed,
+			    DeppartMasks& results)
+  {
+    const ElementMask& src = local_valid_mask(field_data.index_space);
+    if(src.first_enabled() < 0)
+      return;
+
+    FieldReader reader(field_data.inst, field_data.field_offset);
+
+    switch(kind) {
+    case DeppartOperation::DEPPART_BY_FIELD:
+      {
+	int dim = (colors.empty() ? 0 : colors[0].get_dim());
+	assert(dim <= DomainPoint::MAX_POINT_DIM);
+	assert(field_data.field_size == (((dim == 0) ? 1 : dim) * sizeof(int)));
+
+	std::map<DomainPoint, int> color_map;
+	for(size_t i = 0; i < colors.size(); i++)
+	  color_map[colors[i]] = i;
+
+	// field values tend to come in runs, so remember the last lookup and
+	//  enable whole runs at once
+	DomainPoint last_color;
+	int last_idx = -1;
+	bool have_last = false;
+	int run_idx = -1;
+	coord_t run_start = 0;
+	size_t run_len = 0;
+
+	// an incremental update only reads the changed elements of the piece
+	ElementMask::Enumerator e((changed ? *changed : src), src.first_enabled(), 1);
+	coord_t pos;
+	size_t len;
+	while(e.get_next(pos, len)) {
+	  if(pos > src.last_enabled())
+	    break;
+	  for(size_t i = 0; i < len; i++) {
+	    if(changed && !src.is_set(pos + i))
+	      continue;
+	    int vals[DomainPoint::MAX_POINT_DIM];
+	    reader.read(pos + i, vals, field_data.field_size);
+	    DomainPoint dp(vals[0]);
+	    dp.dim = dim;
+	    for(int j = 1; j < dim; j++)
+	      dp.point_data[j] = vals[j];
+
+	    if(!have_last || !(dp == last_color)) {
+	      // colors outside the color space don't belong to any output
+	      std::map<DomainPoint, int>::const_iterator it = color_map.find(dp);
+	      last_idx = ((it != color_map.end()) ? it->second : -1);
+	      last_color = dp;
+	      have_last = true;
+	    }
+
+	    coord_t p = pos + i;
+	    if((last_idx != run_idx) || (p != (run_start + (coord_t)run_len))) {
+	      if((run_idx >= 0) && (run_len > 0))
+		enable_in(results, src, run_idx, run_start, run_len);
+	      run_idx = last_idx;
+	      run_start = p;
+	      run_len = 0;
+	    }
+	    run_len++;
+	  }
+	}
+	if((run_idx >= 0) && (run_len > 0))
+	  enable_in(results, src, run_idx, run_start, run_len);
+	break;
+      }
+
+    case DeppartOperation::DEPPART_BY_IMAGE:
+      {
+	assert(field_data.field_size == sizeof(coord_t));
+	const ElementMask& pmask = local_valid_mask(parent);
+
+	for(size_t k = 0; k < keys.size(); k++) {
+	  const ElementMask& kmask = local_valid_mask(keys[k]);
+	  if(kmask.first_enabled() < 0)
+	    continue;
+
+	  // only the part of the piece that overlaps the key has to be read
+	  coord_t lo = std::max(src.first_enabled(), kmask.first_enabled());
+	  coord_t hi = std::min(src.last_enabled(), kmask.last_enabled());
+	  if(lo > hi)
+	    continue;
+
+	  ElementMask::Enumerator e(src, lo, 1);
+	  coord_t pos;
+	  size_t len;
+	  while(e.get_next(pos, len) && (pos <= hi)) {
+	    coord_t end = std::min(pos + (coord_t)len - 1, hi);
+	    for(coord_t p = pos; p <= end; p++) {
+	      if(!kmask.is_set(p))
+		continue;
+	      coord_t ptr;
+	      reader.read(p, &ptr, sizeof(ptr));
+	      // pointers outside the parent are ignored
+	      if(!pmask.is_set(ptr))
+		continue;
+	      if(!results[k])
+		results[k] = new ElementMask(pmask.get_num_elmts(),
+					     pmask.get_first_element());
+	      results[k]->enable(ptr);
+	    }
+	  }
+	}
+	break;
+      }
+
+    case DeppartOperation::DEPPART_BY_PREIMAGE:
+      {
+	assert(field_data.field_size == sizeof(coord_t));
+	std::vector<const ElementMask *> kmasks(keys.size());
+	for(size_t k = 0; k < keys.size(); k++)
+	  kmasks[k] = &local_valid_mask(keys[k]);
+
+	ElementMask::Enumerator e(src, 0, 1);
+	coord_t pos;
+	size_t len;
+	while(e.get_next(pos, len)) {
+	  for(size_t i = 0; i < len; i++) {
+	    coord_t ptr;
+	    reader.read(pos + i, &ptr, sizeof(ptr));
+	    for(size_t k = 0; k < kmasks.size(); k++) {
+	      const ElementMask& kmask = *kmasks[k];
+	      if((kmask.first_enabled() < 0) ||
+		 (ptr < kmask.first_enabled()) || (ptr > kmask.last_enabled()))
+		continue;
+	      if(kmask.is_set(ptr))
+		enable_in(results, src, k, pos + i, 1);
+	    }
+	  }
+	}
+	break;
+      }
+    }
+  }
+
+  static bool mask_covers(const ElementMask& mask, const ElementMask& other)
+  {
+    return ((other.first_enabled() >= mask.get_first_element()) &&
+	    (other.last_enabled() < (mask.get_first_element() +
+				     (coord_t)mask.get_num_elmts())));
+  }
+
+  // unions 'src' into 'dst', consuming the masks in 'src'
+  static void merge_masks(DeppartMasks& dst, DeppartMasks& src)
+  {
+    assert(dst.size() == src.size());
+    for(size_t i = 0; i < dst.size(); i++) {
+      if(!src[i])
+	continue;
+
+      if(!dst[i]) {
+	dst[i] = src[i];
+	src[i] = 0;
+	continue;
+      }
+
+      // partial masks cover different ranges - grow the destination if
+      //  the source doesn't fit in it
+      if(!mask_covers(*dst[i], *src[i])) {
+	if(mask_covers(*src[i], *dst[i])) {
+	  std::swap(dst[i], src[i]);
+	} else {
+	  coord_t lo = std::min(dst[i]->get_first_element(),
+				src[i]->get_first_element());
+	  coord_t hi = std::max(dst[i]->get_first_element() + (coord_t)dst[i]->get_num_elmts(),
+				src[i]->get_first_element() + (coord_t)src[i]->get_num_elmts());
+	  ElementMask *grown = new ElementMask(hi - lo, lo);
+	  *grown |= *dst[i];
+	  delete dst[i];
+	  dst[i] = grown;
+	}
+      }
+
+      *dst[i] |= *src[i];
+      delete src[i];
+      src[i] = 0;
+    }
+  }
+
+  static void delete_masks(DeppartMasks *masks)
+  {
+    for(DeppartMasks::iterator it = masks->begin(); it != masks->end(); it++)
+      delete *it;
+    delete masks;
+  }
+
+  // only the nonempty masks are sent, each trimmed to its enabled range
+  static void serialize_masks(Serialization::DynamicBufferSerializer& dbs,
+			      const DeppartMasks& masks)
+  {
+    int count = 0;
+    for(size_t i = 0; i < masks.size(); i++)
+      if(masks[i])
+	count++;
+
+    bool ok = (dbs << count);
+    for(size_t i = 0; ok && (i < masks.size()); i++) {
+      if(!masks[i])
+	continue;
+      ok = ((dbs << (int)i) &&
+	    serialize_mask(dbs, *masks[i]));
+    }
+    assert(ok);
+  }
+
+  static void deserialize_masks(Serialization::FixedBufferDeserializer& fbd,
+				DeppartMasks& masks)
+  {
+    int count = 0;
+    bool ok = (fbd >> count);
+    for(int j = 0; ok && (j < count); j++) {
+      int idx;
+      ok = (fbd >> idx);
+      if(!ok) break;
+      assert((idx >= 0) && (idx < (int)masks.size()) && !masks[idx]);
+
+      ElementMask *mask = new ElementMask;
+      ok = deserialize_mask(fbd, *mask);
+      if(!ok) {
+	delete mask;
+	break;
+      }
+      masks[idx] = mask;
+    }
+    assert(ok && (fbd.bytes_left() == 0));
+  }
+
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // work items
+  //
+
+  // computes a piece whose field data is on this node and hands the result
+  //  to the operation
+  class DeppartLocalPieceItem : public DeppartWorkItem {
+  public:
+    DeppartLocalPieceItem(DeppartOperation *_op, size_t _idx)
+      : op(_op), idx(_idx) {}
+
+    virtual Event get_precondition(void)
+    {
+      std::set<IndexSpace> spaces;
+      needed_spaces(op->kind, op->parent, op->field_data[idx], op->keys, spaces);
+      return fetch_valid_masks(spaces);
+    }
+
+    virtual void execute(void)
+    {
+      DeppartMasks *result = new DeppartMasks(op->outputs.size(), 0);
+      compute_piece(op->kind, op->parent, op->field_data[idx],
+		    op->colors, op->keys, op->changed, *result);
+      op->add_result(result);
+    }
+
+  protected:
+    DeppartOperation *op;
+    size_t idx;
+  };
+
+  // computes a piece on behalf of another node and sends the result back
+  class DeppartRemotePieceItem : public DeppartWorkItem {
+  public:
+    DeppartRemotePieceItem(gasnet_node_t _requestor, intptr_t _op, int _idx)
+      : requestor(_requestor), op(_op), idx(_idx) {}
+
+    virtual Event get_precondition(void)
+    {
+      std::set<IndexSpace> spaces;
+      needed_spaces(piece.kind, piece.parent, piece.field_data, piece.keys, spaces);
+      return fetch_valid_masks(spaces);
+    }
+
+    virtual void execute(void)
+    {
+      size_t num_outputs = ((piece.kind == DeppartOperation::DEPPART_BY_FIELD) ?
+			      piece.colors.size() :
+			      piece.keys.size());
+      DeppartMasks result(num_outputs, 0);
+      compute_piece(piece.kind, piece.parent, piece.field_data,
+		    piece.colors, piece.keys,
+		    (piece.incremental ? &piece.changed : 0), result);
+
+      Serialization::DynamicBufferSerializer dbs(256);
+      serialize_masks(dbs, result);
+      for(DeppartMasks::iterator it = result.begin(); it != result.end(); it++)
+	delete *it;
+
+      log_deppart.debug() << "remote piece " << idx << " done: op=" << std::hex << op << std::dec
+			  << " requestor=" << requestor << " bytes=" << dbs.bytes_used();
+      DeppartDataMessage::send_request(requestor, DeppartDataMessage::PIECE_RESULT,
+				       op, idx, dbs.get_buffer(), dbs.bytes_used());
+    }
+
+    DeppartPiece piece;
+
+  protected:
+    gasnet_node_t requestor;
+    intptr_t op;
+    int idx;
+  };
+
+  // unpacks a result that came back from a remote piece
+  class DeppartRemoteResultItem : public DeppartWorkItem {
+  public:
+    DeppartRemoteResultItem(DeppartOperation *_op, std::vector<char>& _data)
+      : op(_op)
+    {
+      data.swap(_data);
+    }
+
+    virtual void execute(void)
+    {
+      DeppartMasks *result = new DeppartMasks(op->outputs.size(), 0);
+      Serialization::FixedBufferDeserializer fbd(&data[0], data.size());
+      deserialize_masks(fbd, *result);
+      op->add_result(result);
+    }
+
+  protected:
+    DeppartOperation *op;
+    std::vector<char> data;
+  };
+
+  class DeppartMergeItem : public DeppartWorkItem {
+  public:
+    DeppartMergeItem(DeppartOperation *_op, DeppartMasks *_a, DeppartMasks *_b)
+      : op(_op), a(_a), b(_b) {}
+
+    virtual void execute(void)
+    {
+      merge_masks(*a, *b);
+      delete_masks(b);
+      op->add_result(a);
+    }
+
+  protected:
+    DeppartOperation *op;
+    DeppartMasks *a, *b;
+  };
+
+  template <typename T>
+  class DeferredDeppartStart : public EventWaiter {
+  public:
+    DeferredDeppartStart(T *_op) : op(_op) {}
+
+    virtual bool event_triggered(Event e, bool poisoned)
+    {
+      if(poisoned) {
+	log_poison.info() << "cancelling poisoned deppart operation - op=" << (void *)op
+			  << " after=" << op->get_finish_event();
+	op->handle_poisoned_precondition(e);
+	return true;
+      }
+
+      op->start();
+      return true;
+    }
+
+    virtual void print(std::ostream& os) const
+    {
+      os << "deferred deppart operation: op=" << (void *)op;
+    }
+
+    virtual Event get_finish_event(void) const
+    {
+      return op->get_finish_event();
+    }
+
+  protected:
+    T *op;
+  };
+
+  class BinaryOpItem : public DeppartWorkItem {
+  public:
+    BinaryOpItem(BinaryOpsOperation *_op, size_t _idx)
+      : op(_op), idx(_idx) {}
+
+    virtual void execute(void)
+    {
+      op->compute(idx);
+    }
+
+  protected:
+    BinaryOpsOperation *op;
+    size_t idx;
+  };
+
+  // puts a work item back on the queue once its precondition has triggered
+  class DeferredDeppartWork : public EventWaiter {
+  public:
+    DeferredDeppartWork(DeppartQueue *_queue, DeppartWorkItem *_item)
+      : queue(_queue), item(_item) {}
+
+    virtual bool event_triggered(Event e, bool poisoned)
+    {
+      queue->enqueue_work(item);
+      return true;
+    }
+
+    virtual void print(std::ostream& os) const
+    {
+      os << "deferred deppart work item: item=" << (void *)item;
+    }
+
+    virtual Event get_finish_event(void) const
+    {
+      return Event::NO_EVENT;
+    }
+
+  protected:
+    DeppartQueue *queue;
+    DeppartWorkItem *item;
+  };
+
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class DeppartOperation
+  //
+
+  DeppartOperation::DeppartOperation(Kind _kind, IndexSpace _parent,
+				     const std::vector<IndexSpace::FieldDataDescriptor>& _field_data,
+				     Event _finish_event,
+				     const ProfilingRequestSet& _requests)
+    : Operation(_finish_event, _requests)
+    , kind(_kind), parent(_parent), field_data(_field_data)
+    , changed(0), remaining(0), waiting_result(0)
+  {}
+
+  DeppartOperation::~DeppartOperation(void)
+  {
+    assert(waiting_result == 0);
+    delete changed;
+  }
+
+  void DeppartOperation::set_incremental(const ElementMask& _changed,
+					 const std::vector<IndexSpace>& _bases)
+  {
+    assert(kind == DEPPART_BY_FIELD);
+    assert(_bases.size() == outputs.size());
+    assert(changed == 0);
+    changed = new ElementMask(_changed, true /*trim*/);
+    bases = _bases;
+  }
+
+  void DeppartOperation::launch(Event wait_on)
+  {
+    get_runtime()->optable.add_local_operation(finish_event, this);
+
+    // the previous results are needed (on this node) to finish an
+    //  incremental update
+    if(changed) {
+      std::set<IndexSpace> spaces;
+      for(std::vector<IndexSpace>::const_iterator it = bases.begin();
+	  it != bases.end();
+	  it++)
+	if(it->exists())
+	  spaces.insert(*it);
+      Event fetched = fetch_valid_masks(spaces);
+      if(fetched.exists()) {
+	std::set<Event> events;
+	events.insert(fetched);
+	if(wait_on.exists())
+	  events.insert(wait_on);
+	wait_on = Event::merge_events(events);
+      }
+    }
+
+    bool poisoned = false;
+    if(wait_on.has_triggered_faultaware(poisoned)) {
+      if(poisoned) {
+	log_poison.info() << "cancelling poisoned deppart operation - op=" << (void *)this
+			  << " after=" << finish_event;
+	handle_poisoned_precondition(wait_on);
+	return;
+      }
+      start();
+    } else
+      EventImpl::add_waiter(wait_on, new DeferredDeppartStart<DeppartOperation>(this));
+  }
+
+  void DeppartOperation::start(void)
+  {
+    if(!mark_ready() || !mark_started()) {
+      mark_finished(false /*!successful*/);
+      return;
+    }
+
+    log_deppart.info() << "deppart operation started: op=" << (void *)this
+		       << " kind=" << get_kind_name() << " parent=" << parent
+		       << " pieces=" << field_data.size() << " outputs=" << outputs.size();
+
+    if(field_data.empty()) {
+      finish(new DeppartMasks(outputs.size(), 0));
+      return;
+    }
+
+    remaining = field_data.size();
+    for(size_t i = 0; i < field_data.size(); i++) {
+      gasnet_node_t owner = ID(field_data[i].inst).instance.owner_node;
+      if(owner == gasnet_mynode()) {
+	deppart_queue->enqueue_work(new DeppartLocalPieceItem(this, i));
+	continue;
+      }
+
+      DeppartPiece piece;
+      piece.kind = kind;
+      piece.parent = parent;
+      piece.field_data = field_data[i];
+      if(kind == DEPPART_BY_FIELD)
+	piece.colors = colors;
+      else
+	piece.keys = keys;
+      piece.incremental = (changed != 0);
+      if(changed)
+	piece.changed = *changed;
+
+      Serialization::DynamicBufferSerializer dbs(256);
+#ifndef NDEBUG
+      bool ok =
+#endif
+	(dbs << piece);
+      assert(ok);
+      DeppartDataMessage::send_request(owner, DeppartDataMessage::PIECE_REQUEST,
+				       (intptr_t)this, i,
+				       dbs.get_buffer(), dbs.bytes_used());
+    }
+  }
+
+  void DeppartOperation::add_result(DeppartMasks *result)
+  {
+    DeppartMasks *other = 0;
+    bool last = false;
+    {
+      AutoHSLLock al(mutex);
+      if(remaining == 1) {
+	last = true;
+      } else if(waiting_result) {
+	// the merge turns two results into one
+	other = waiting_result;
+	waiting_result = 0;
+	remaining--;
+      } else
+	waiting_result = result;
+    }
+
+    if(last)
+      finish(result);
+    else if(other)
+      deppart_queue->enqueue_work(new DeppartMergeItem(this, other, result));
+  }
+
+  void DeppartOperation::finish(DeppartMasks *result)
+  {
+    assert(result->size() == outputs.size());
+    size_t num_elmts = StaticAccess<IndexSpaceImpl>(get_runtime()->get_index_space_impl(parent))->num_elmts;
+
+    for(size_t i = 0; i < outputs.size(); i++) {
+      ElementMask mask(num_elmts);
+      // unchanged elements keep the color they had before
+      if(changed && bases[i].exists()) {
+	mask |= local_valid_mask(bases[i]);
+	mask -= *changed;
+      }
+      if((*result)[i])
+	mask |= *(*result)[i];
+
+      install_valid_mask(outputs[i], mask);
+    }
+    delete_masks(result);
+
+    log_deppart.info() << "deppart operation complete: op=" << (void *)this;
+
+    // this triggers the finish event, after which the operation may be
+    //  deleted at any time
+    mark_finished(true /*successful*/);
+  }
+
+  void DeppartOperation::print(std::ostream& os) const
+  {
+    os << "DeppartOperation(" << get_kind_name() << ", parent=" << parent
+       << ", pieces=" << field_data.size() << ", outputs=" << outputs.size() << ")";
+  }
+
+  const char *DeppartOperation::get_kind_name(void) const
+  {
+    switch(kind) {
+    case DEPPART_BY_FIELD: return "deppart_by_field";
+    case DEPPART_BY_IMAGE: return "deppart_by_image";
+    case DEPPART_BY_PREIMAGE: return "deppart_by_preimage";
+    }
+    return "deppart";
+  }
+
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class BinaryOpsOperation
+  //
+
+  BinaryOpsOperation::BinaryOpsOperation(const std::vector<IndexSpace::BinaryOpDescriptor>& _ops,
+					 Event _finish_event,
+					 const ProfilingRequestSet& _requests)
+    : Operation(_finish_event, _requests)
+    , num_descriptors(_ops.size()), remaining(0)
+  {
+    // unions and intersections don't care about operand order, so those
+    //  are normalized before looking for repeats
+    std::map<std::pair<std::pair<int, IndexSpace::id_t>,
+		       std::pair<IndexSpace::id_t, IndexSpace::id_t> >,
+	     size_t> seen;
+    for(std::vector<IndexSpace::BinaryOpDescriptor>::const_iterator it = _ops.begin();
+	it != _ops.end();
+	it++) {
+      IndexSpace left = it->left_operand;
+      IndexSpace right = it->right_operand;
+      if((it->op != IndexSpace::ISO_SUBTRACT) && (right.id < left.id))
+	std::swap(left, right);
+
+      size_t& idx = seen[std::make_pair(std::make_pair((int)it->op, it->parent.id),
+					std::make_pair(left.id, right.id))];
+      if(idx == 0) {
+	distinct.push_back(DistinctOp());
+	DistinctOp& d = distinct.back();
+	d.op = it->op;
+	d.parent = it->parent;
+	d.left = left;
+	d.right = right;
+	idx = distinct.size();
+      }
+      distinct[idx - 1].results.push_back(it->result);
+    }
+  }
+
+  BinaryOpsOperation::~BinaryOpsOperation(void)
+  {}
+
+  void BinaryOpsOperation::launch(Event wait_on)
+  {
+    get_runtime()->optable.add_local_operation(finish_event, this);
+
+    // every operand's valid mask is fetched once, no matter how many
+    //  operations use it
+    std::set<IndexSpace> spaces;
+    for(std::vector<DistinctOp>::const_iterator it = distinct.begin();
+	it != distinct.end();
+	it++) {
+      spaces.insert(it->left);
+      spaces.insert(it->right);
+    }
+    Event fetched = fetch_valid_masks(spaces);
+    if(fetched.exists()) {
+      std::set<Event> events;
+      events.insert(fetched);
+      if(wait_on.exists())
+	events.insert(wait_on);
+      wait_on = Event::merge_events(events);
+    }
+
+    bool poisoned = false;
+    if(wait_on.has_triggered_faultaware(poisoned)) {
+      if(poisoned) {
+	log_poison.info() << "cancelling poisoned binary ops operation - op=" << (void *)this
+			  << " after=" << finish_event;
+	handle_poisoned_precondition(wait_on);
+	return;
+      }
+      start();
+    } else
+      EventImpl::add_waiter(wait_on, new DeferredDeppartStart<BinaryOpsOperation>(this));
+  }
+
+  void BinaryOpsOperation::start(void)
+  {
+    if(!mark_ready() || !mark_started()) {
+      mark_finished(false /*!successful*/);
+      return;
+    }
+
+    log_deppart.info() << "binary ops operation started: op=" << (void *)this
+		       << " descriptors=" << num_descriptors
+		       << " distinct=" << distinct.size();
+
+    if(distinct.empty()) {
+      mark_finished(true /*successful*/);
+      return;
+    }
+
+    remaining = distinct.size();
+    for(size_t i = 0; i < distinct.size(); i++)
+      deppart_queue->enqueue_work(new BinaryOpItem(this, i));
+  }
+
+  void BinaryOpsOperation::compute(size_t idx)
+  {
+    const DistinctOp& d = distinct[idx];
+    size_t num_elmts = StaticAccess<IndexSpaceImpl>(get_runtime()->get_index_space_impl(d.parent))->num_elmts;
+
+    ElementMask mask(num_elmts);
+    mask |= local_valid_mask(d.left);
+    switch(d.op) {
+    case IndexSpace::ISO_UNION: mask |= local_valid_mask(d.right); break;
+    case IndexSpace::ISO_INTERSECT: mask &= local_valid_mask(d.right); break;
+    case IndexSpace::ISO_SUBTRACT: mask -= local_valid_mask(d.right); break;
+    default: assert(0);
+    }
+
+    for(std::vector<IndexSpace>::const_iterator it = d.results.begin();
+	it != d.results.end();
+	it++)
+      install_valid_mask(*it, mask);
+
+    // the last computation to finish completes the operation, after which
+    //  it may be deleted at any time
+    if(__sync_sub_and_fetch(&remaining, 1) == 0) {
+      log_deppart.info() << "binary ops operation complete: op=" << (void *)this;
+      mark_finished(true /*successful*/);
+    }
+  }
+
+  void BinaryOpsOperation::print(std::ostream& os) const
+  {
+    os << "BinaryOpsOperation(descriptors=" << num_descriptors
+       << ", distinct=" << distinct.size() << ")";
+  }
+
+  const char *BinaryOpsOperation::get_kind_name(void) const
+  {
+    return "binary_ops";
+  }
+
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class DeppartQueue
+  //
+
+  DeppartQueue::DeppartQueue(CoreReservationSet& crs)
+    : queue_condvar(queue_mutex)
+    , shutdown_flag(false)
+    , core_rsrv("deppart workers", crs, CoreReservationParameters())
+  {}
+
+  void DeppartQueue::enqueue_work(DeppartWorkItem *item)
+  {
+    AutoHSLLock al(queue_mutex);
+    queue.push_back(item);
+    queue_condvar.signal();
+  }
+
+  void DeppartQueue::start_workers(int count)
+  {
+    ThreadLaunchParameters tlp;
+
+    for(int i = 0; i < count; i++) {
+      Thread *t = Thread::create_kernel_thread<DeppartQueue,
+					       &DeppartQueue::worker_thread_loop>(this,
+										  tlp,
+										  core_rsrv,
+										  0 /* default scheduler*/);
+      worker_threads.push_back(t);
+    }
+  }
+
+  void DeppartQueue::shutdown_queue(void)
+  {
+    {
+      AutoHSLLock al(queue_mutex);
+      assert(queue.empty());
+      shutdown_flag = true;
+      queue_condvar.broadcast();
+    }
+
+    for(std::vector<Thread *>::iterator it = worker_threads.begin();
+	it != worker_threads.end();
+	it++) {
+      (*it)->join();
+      delete (*it);
+    }
+    worker_threads.clear();
+  }
+
+  void DeppartQueue::worker_thread_loop(void)
+  {
+    log_deppart.info("deppart worker thread created");
+
+    while(true) {
+      DeppartWorkItem *item = 0;
+      {
+	AutoHSLLock al(queue_mutex);
+	while(queue.empty() && !shutdown_flag)
+	  queue_condvar.wait();
+	if(queue.empty())
+	  break;
+	item = queue.front();
+	queue.pop_front();
+      }
+
+      // items that need index space data from other nodes come back once
+      //  it has arrived
+      Event pre = item->get_precondition();
+      bool poisoned = false;
+      if(!pre.has_triggered_faultaware(poisoned)) {
+	EventImpl::add_waiter(pre, new DeferredDeppartWork(this, item));
+	continue;
+      }
+
+      item->execute();
+      delete item;
+    }
+
+    log_deppart.info("deppart worker thread terminating");
+  }
+
+  void start_deppart_worker_threads(int count, CoreReservationSet& crs)
+  {
+    // there has to be somebody to run the pieces
+    if(count < 1)
+      count = 1;
+    deppart_queue = new DeppartQueue(crs);
+    deppart_queue->start_workers(count);
+  }
+
+  void stop_deppart_worker_threads(void)
+  {
+    deppart_queue->shutdown_queue();
+    delete deppart_queue;
+    deppart_queue = 0;
+  }
+
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // struct DeppartDataMessage
+  //
+
+  namespace {
+    struct PendingTransfer {
+      std::vector<char> data;
+      unsigned blocks_left;
+    };
+
+    // (sender, type, op, piece) identifies a transfer
+    typedef std::pair<std::pair<int, int>, std::pair<intptr_t, int> > TransferKey;
+  };
+
+  static GASNetHSL transfer_mutex;
+  static std::map<TransferKey, PendingTransfer> pending_transfers;
+
+  /*static*/ void DeppartDataMessage::handle_request(RequestArgs args,
+						     const void *data,
+						     size_t datalen)
+  {
+    std::vector<char> assembled;
+    if(args.num_blocks == 1) {
+      assert(datalen == args.total_bytes);
+      assembled.assign((const char *)data, ((const char *)data) + datalen);
+    } else {
+      TransferKey key(std::make_pair((int)args.sender, args.type),
+		      std::make_pair(args.op, args.piece));
+      AutoHSLLock al(transfer_mutex);
+      std::map<TransferKey, PendingTransfer>::iterator it = pending_transfers.find(key);
+      if(it == pending_transfers.end()) {
+	it = pending_transfers.insert(std::make_pair(key, PendingTransfer())).first;
+	it->second.data.resize(args.total_bytes);
+	it->second.blocks_left = args.num_blocks;
+      }
+      assert((args.offset + datalen) <= it->second.data.size());
+      memcpy(&(it->second.data[args.offset]), data, datalen);
+      if(--(it->second.blocks_left) > 0)
+	return;
+      assembled.swap(it->second.data);
+      pending_transfers.erase(it);
+    }
+
+    switch(args.type) {
+    case PIECE_REQUEST:
+      {
+	DeppartRemotePieceItem *item = new DeppartRemotePieceItem(args.sender,
+								   args.op,
+								   args.piece);
+	Serialization::FixedBufferDeserializer fbd(&assembled[0], assembled.size());
+#ifndef NDEBUG
+	bool ok =
+#endif
+	  (fbd >> item->piece);
+	assert(ok && (fbd.bytes_left() == 0));
+	log_deppart.debug() << "remote piece " << args.piece << " requested: op=" << std::hex << args.op << std::dec
+			    << " requestor=" << args.sender << " inst=" << item->piece.field_data.inst;
+	deppart_queue->enqueue_work(item);
+	break;
+      }
+
+    case PIECE_RESULT:
+      {
+	deppart_queue->enqueue_work(new DeppartRemoteResultItem((DeppartOperation *)(args.op),
+								 assembled));
+	break;
+      }
+
+    default:
+      assert(0);
+    }
+  }
+
+  /*static*/ void DeppartDataMessage::send_request(gasnet_node_t target, Type type,
+						   intptr_t op, int piece,
+						   const void *data, size_t datalen)
+  {
+    size_t block_size = DEPPART_BLOCK_SIZE;
+    size_t lmb_size = get_lmb_size(target);
+    if((lmb_size > 0) && (lmb_size < block_size))
+      block_size = lmb_size;
+
+    unsigned num_blocks = (datalen + block_size - 1) / block_size;
+    assert(num_blocks > 0);
+
+    for(unsigned i = 0; i < num_blocks; i++) {
+      RequestArgs args;
+
+      args.sender = gasnet_mynode();
+      args.type = type;
+      args.op = op;
+      args.piece = piece;
+      args.num_blocks = num_blocks;
+      args.offset = i * block_size;
+      args.total_bytes = datalen;
+      Message::request(target, args,
+		       ((const char *)data) + args.offset,
+		       std::min(block_size, datalen - args.offset),
+		       PAYLOAD_COPY);
+    }
+  }
+
+}; // namespace Realm
@@ -0,0 +1,196 @@
+/* Copyright 2017 Stanford University, NVIDIA Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// dependent partitioning (by field/image/preimage) and batched binary
+//  operations for unstructured index spaces
+
+#ifndef REALM_DEPPART_IMPL_H
+#define REALM_DEPPART_IMPL_H
+
+#include "indexspace.h"
+#include "operation.h"
+#include "threads.h"
+
+#include "activemsg.h"
+
+#include <vector>
+#include <list>
+#include <map>
+
+namespace Realm {
+
+  // one (possibly null) mask per output subspace - a piece's contribution
+  //  to the result, or the union of several of those
+  typedef std::vector<ElementMask *> DeppartMasks;
+
+  class DeppartWorkItem {
+  public:
+    virtual ~DeppartWorkItem(void) {}
+
+    // returns an event that must trigger before execute() is called (the
+    //  queue holds the item until it has)
+    virtual Event get_precondition(void) { return Event::NO_EVENT; }
+
+    virtual void execute(void) = 0;
+  };
+
+  class DeppartOperation : public Operation {
+  public:
+    enum Kind {
+      DEPPART_BY_FIELD,
+      DEPPART_BY_IMAGE,
+      DEPPART_BY_PREIMAGE,
+    };
+
+    DeppartOperation(Kind _kind, IndexSpace _parent,
+		     const std::vector<IndexSpace::FieldDataDescriptor>& _field_data,
+		     Event _finish_event, const ProfilingRequestSet& _requests);
+
+  protected:
+    // deletion performed when reference count goes to zero
+    virtual ~DeppartOperation(void);
+
+  public:
+    // makes a by_field operation only read the field for elements in
+    //  '_changed' - all other elements keep the color they have in
+    //  '_bases' (one per output, NO_SPACE for a color that was empty)
+    void set_incremental(const ElementMask& _changed,
+			 const std::vector<IndexSpace>& _bases);
+
+    // the output subspaces must have been created (and colors/keys filled
+    //  in) before the operation is launched
+    void launch(Event wait_on);
+
+    // called once the precondition has triggered - local pieces are queued
+    //  for the worker threads and remote ones are sent to the node that owns
+    //  the instance holding their field data
+    void start(void);
+
+    // accepts the (merged) contribution of one or more pieces - pairs of
+    //  results are merged by the worker threads in a tree until a single
+    //  result remains, which is installed in the output subspaces
+    void add_result(DeppartMasks *result);
+
+    virtual void print(std::ostream& os) const;
+    virtual const char *get_kind_name(void) const;
+
+    Kind kind;
+    IndexSpace parent;
+    std::vector<IndexSpace::FieldDataDescriptor> field_data;
+    std::vector<DomainPoint> colors;
+    std::vector<IndexSpace> keys;
+    std::vector<IndexSpace> outputs;
+    ElementMask *changed;
+    std::vector<IndexSpace> bases;
+
+  protected:
+    void finish(DeppartMasks *result);
+
+    GASNetHSL mutex;
+    int remaining;
+    DeppartMasks *waiting_result;
+  };
+
+  // a batch of binary operations on index spaces (compute_index_spaces) -
+  //  descriptors that compute the same thing share one computation, and the
+  //  distinct computations run in parallel on the deppart worker threads
+  class BinaryOpsOperation : public Operation {
+  public:
+    BinaryOpsOperation(const std::vector<IndexSpace::BinaryOpDescriptor>& _ops,
+		       Event _finish_event, const ProfilingRequestSet& _requests);
+
+  protected:
+    // deletion performed when reference count goes to zero
+    virtual ~BinaryOpsOperation(void);
+
+  public:
+    // the descriptors' results must have been created before the operation
+    //  is launched
+    void launch(Event wait_on);
+    void start(void);
+
+    // computes one distinct operation and installs it in all of its results
+    void compute(size_t idx);
+
+    virtual void print(std::ostream& os) const;
+    virtual const char *get_kind_name(void) const;
+
+    struct DistinctOp {
+      IndexSpace::IndexSpaceOperation op;
+      IndexSpace parent, left, right;
+      std::vector<IndexSpace> results;
+    };
+    std::vector<DistinctOp> distinct;
+    size_t num_descriptors;
+
+  protected:
+    int remaining;  // uses atomics
+  };
+
+  class DeppartQueue {
+  public:
+    DeppartQueue(CoreReservationSet& crs);
+
+    void enqueue_work(DeppartWorkItem *item);
+
+    void start_workers(int count);
+    void shutdown_queue(void);
+
+    void worker_thread_loop(void);
+
+  protected:
+    GASNetHSL queue_mutex;
+    GASNetCondVar queue_condvar;
+    std::list<DeppartWorkItem *> queue;
+    bool shutdown_flag;
+    CoreReservation core_rsrv;
+    std::vector<Thread *> worker_threads;
+  };
+
+  // requests for remote pieces and their results can both be larger than
+  //  a single message, so they are sent as a sequence of blocks that the
+  //  receiver assembles before acting on them
+  struct DeppartDataMessage {
+    enum Type {
+      PIECE_REQUEST,
+      PIECE_RESULT,
+    };
+
+    struct RequestArgs : public BaseMedium {
+      gasnet_node_t sender;
+      int type;
+      intptr_t op;
+      int piece;
+      unsigned num_blocks;
+      size_t offset;
+      size_t total_bytes;
+    };
+
+    static void handle_request(RequestArgs args, const void *data, size_t datalen);
+
+    typedef ActiveMessageMediumNoReply<DEPPART_DATA_MSGID,
+				       RequestArgs,
+				       handle_request> Message;
+
+    static void send_request(gasnet_node_t target, Type type, intptr_t op,
+			     int piece, const void *data, size_t datalen);
+  };
+
+  void start_deppart_worker_threads(int count, CoreReservationSet& crs);
+  void stop_deppart_worker_threads(void);
+
+}; // namespace Realm
+
+#endif // ifndef REALM_DEPPART_IMPL_H
@@ -64,7 +64,8 @@ namespace Realm {
       NodeBase *new_tree_node(int level, IT first_index, IT last_index,
 			      int owner, typename ALLOCATOR::FreeList *free_list);
 
-      // lock protects _changes_ to 'root', but not access to it
+      // lock protects _changes_ to 'root', but not access to it - readers
+      //  use acquire loads of 'root' and child pointers and never lock
       LT lock;
       NodeBase * volatile root;
     };
@@ -83,10 +83,11 @@ namespace Realm {
   template<typename ALLOCATOR>
   size_t DynamicTable<ALLOCATOR>::max_entries(void) const
   {
-    if (!root)
+    NodeBase *n = __atomic_load_n(&root, __ATOMIC_ACQUIRE);
+    if (!n)
       return 0;
     size_t elems_addressable = 1 << ALLOCATOR::LEAF_BITS;
-    for (int i = 0; i < root->level; i++)
+    for (int i = 0; i < n->level; i++)
       elems_addressable <<= ALLOCATOR::INNER_BITS;
     return elems_addressable;
   }
@@ -102,7 +103,7 @@ namespace Realm {
       elems_addressable <<= ALLOCATOR::INNER_BITS;
     }
 
-    NodeBase *n = root;
+    NodeBase *n = __atomic_load_n(&root, __ATOMIC_ACQUIRE);
     if (!n || (n->level < level_needed))
       return false;
 
@@ -120,7 +121,7 @@ namespace Realm {
 	      ((((IT)1) << ALLOCATOR::INNER_BITS) - 1));
       assert((i >= 0) && (((size_t)i) < ALLOCATOR::INNER_TYPE::SIZE));
 
-      NodeBase *child = inner->elems[i];
+      NodeBase *child = __atomic_load_n(&inner->elems[i], __ATOMIC_ACQUIRE);
       if(child == 0) {
 	return false;	
       }
@@ -145,8 +146,9 @@ namespace Realm {
     }
 
     // in the common case, we won't need to add levels to the tree - grab the root (no lock)
-    // and see if it covers the range that includes our index
-    NodeBase *n = root;
+    // and see if it covers the range that includes our index - nodes are published with
+    // release stores, so an acquire load sees a fully constructed node or nothing
+    NodeBase *n = __atomic_load_n(&root, __ATOMIC_ACQUIRE);
     if(!n || (n->level < level_needed)) {
       // root doesn't appear to be high enough - take lock and fix it if it's really
       //  not high enough
@@ -154,7 +156,9 @@ namespace Realm {
 
       if(!root) {
 	// simple case - just create a root node at the level we want
-	root = new_tree_node(level_needed, 0, elems_addressable - 1, owner, free_list);
+	__atomic_store_n(&root,
+			 new_tree_node(level_needed, 0, elems_addressable - 1, owner, free_list),
+			 __ATOMIC_RELEASE);
       } else {
 	// some of the tree already exists - add new layers on top
 	while(root->level < level_needed) {
@@ -164,7 +168,7 @@ namespace Realm {
 	  NodeBase *parent = new_tree_node(parent_level, parent_first, parent_last, owner, free_list);
 	  typename ALLOCATOR::INNER_TYPE *inner = static_cast<typename ALLOCATOR::INNER_TYPE *>(parent);
 	  inner->elems[0] = root;
-	  root = parent;
+	  __atomic_store_n(&root, parent, __ATOMIC_RELEASE);
 	}
       }
       n = root;
@@ -185,7 +189,7 @@ namespace Realm {
 	      ((((IT)1) << ALLOCATOR::INNER_BITS) - 1));
       assert((i >= 0) && (((size_t)i) < ALLOCATOR::INNER_TYPE::SIZE));
 
-      NodeBase *child = inner->elems[i];
+      NodeBase *child = __atomic_load_n(&inner->elems[i], __ATOMIC_ACQUIRE);
       if(child == 0) {
 	// need to populate subtree
 
@@ -199,7 +203,9 @@ namespace Realm {
 	  IT child_first = inner->first_index + (i << child_shift);
 	  IT child_last = inner->first_index + ((i + 1) << child_shift) - 1;
 
-	  inner->elems[i] = new_tree_node(child_level, child_first, child_last, owner, free_list);
+	  __atomic_store_n(&inner->elems[i],
+			   new_tree_node(child_level, child_first, child_last, owner, free_list),
+			   __ATOMIC_RELEASE);
 	}
 	child = inner->elems[i];
 
@@ -21,6 +21,10 @@
 #include "threads.h"
 #include "profiling.h"
 #include "logger_message_descriptor.h"
+#include "timers.h"
+#include "operation.h"
+
+#include <signal.h>
 
 namespace Realm {
 
@@ -331,6 +335,13 @@ namespace Realm {
     // if non-zero, eagerly checks deferred user event triggers for loops up to the
     //  specified limit
     int event_loop_detection_limit = 0;
+    // subscriber count above which triggers use a spanning tree (0 = never)
+    int event_broadcast_tree_threshold = 0;
+    int event_broadcast_radix = 8;
+    // fan-out of the barrier arrival/trigger trees (0 = no trees)
+    int barrier_tree_radix = 0;
+    int event_message_batching = 1;
+    int event_aliasing = 1;
   };
 
   void UserEvent::trigger(Event wait_on) const
@@ -358,7 +369,18 @@ namespace Realm {
 	  assert(0);
 	}
       }
-      EventImpl::add_waiter(wait_on, new DeferredEventTrigger(*this));
+      // wait on the event at the end of wait_on's alias chain (if any) - the
+      //  chain's triggers then fan out from a single event instead of cascading
+      //  through each link
+      Event root = GenEventImpl::resolve_alias(wait_on);
+      EventImpl::add_waiter(root, new DeferredEventTrigger(*this));
+      // the alias is recorded only after our trigger is queued on the root, so
+      //  anybody that resolves to the root afterward is woken after we trigger
+      if(Config::event_aliasing) {
+	GenEventImpl *impl = get_genevent_impl(*this);
+	if(impl->owner == gasnet_mynode())
+	  impl->set_alias(ID(*this).event.generation, root);
+      }
       return;
     }
 
@@ -526,9 +548,9 @@ namespace Realm {
 	    // current generation
 	    waiters_copy.assign(impl->current_local_waiters.begin(),
 				impl->current_local_waiters.end());
-	  } else {
-	    std::map<EventImpl::gen_t, std::vector<EventWaiter *> >::const_iterator it = impl->future_local_waiters.find(id.event.generation);
-	    if(it != impl->future_local_waiters.end())
+	  } else if(impl->remote_state) {
+	    std::map<EventImpl::gen_t, std::vector<EventWaiter *> >::const_iterator it = impl->remote_state->future_local_waiters.find(id.event.generation);
+	    if(it != impl->remote_state->future_local_waiters.end())
 	      waiters_copy.assign(it->second.begin(), it->second.end());
 	  }
 	}
@@ -614,6 +636,8 @@ namespace Realm {
     num_poisoned_generations = 0;
     poisoned_generations = 0;
     has_local_triggers = false;
+    remote_state = 0;
+    alias_gen = 0;
   }
 
   void GenEventImpl::init(ID _me, unsigned _init_owner)
@@ -626,9 +650,108 @@ namespace Realm {
     num_poisoned_generations = 0;
     poisoned_generations = 0;
     has_local_triggers = false;
+    remote_state = 0;
+    alias_gen = 0;
+  }
+
+  GenEventImpl::RemoteGenState& GenEventImpl::get_remote_state(void)
+  {
+    // only non-owners ever track generations beyond the current one
+    assert(owner != gasnet_mynode());
+    if(!remote_state)
+      remote_state = new RemoteGenState;
+    return *remote_state;
+  }
+
+  void GenEventImpl::release_remote_state_if_empty(void)
+  {
+    if(remote_state &&
+       remote_state->future_local_waiters.empty() &&
+       remote_state->local_triggers.empty()) {
+      delete remote_state;
+      remote_state = 0;
+    }
+  }
+
+  bool GenEventImpl::set_alias(gen_t gen, Event target)
+  {
+    assert(owner == gasnet_mynode());
+    AutoHSLLock a(mutex);
+    if(gen <= generation)
+      return false;
+    alias_gen = gen;
+    alias_target = target;
+    return true;
+  }
+
+  /*static*/ Event GenEventImpl::resolve_alias(Event e)
+  {
+    // the limit only guards against pathological chains - set_alias is handed
+    //  already-resolved targets, so chains are normally a single hop
+    static const int MAX_ALIAS_HOPS = 16;
+
+    if(!Config::event_aliasing)
+      return e;
+
+    for(int hops = 0; hops < MAX_ALIAS_HOPS; hops++) {
+      if(!e.exists() || !ID(e).is_event())
+	break;
+      GenEventImpl *impl = get_genevent_impl(e);
+      if(impl->owner != gasnet_mynode())
+	break;
+      gen_t gen = ID(e).event.generation;
+      // unlocked early out - most events are never aliased
+      if(impl->alias_gen != gen)
+	break;
+      Event next;
+      {
+	AutoHSLLock a(impl->mutex);
+	if((impl->alias_gen != gen) || (gen <= impl->generation))
+	  break;
+	next = impl->alias_target;
+      }
+      e = next;
+    }
+    return e;
   }
 
 
+    /*static*/ ProfilingGauges::EventCounter<int> *GenEventImpl::merges_requested = 0;
+    /*static*/ ProfilingGauges::EventCounter<int> *GenEventImpl::merges_collapsed = 0;
+    /*static*/ ProfilingGauges::EventCounter<int> *GenEventImpl::mergers_reused = 0;
+
+    /*static*/ void GenEventImpl::create_merge_gauges(void)
+    {
+      merges_requested = new ProfilingGauges::EventCounter<int>("realm/event merges");
+      merges_collapsed = new ProfilingGauges::EventCounter<int>("realm/event merges collapsed");
+      mergers_reused = new ProfilingGauges::EventCounter<int>("realm/event mergers reused");
+    }
+
+    /*static*/ void GenEventImpl::destroy_merge_gauges(void)
+    {
+      delete merges_requested;
+      delete merges_collapsed;
+      delete mergers_reused;
+      merges_requested = merges_collapsed = mergers_reused = 0;
+    }
+
+    // a merge that resolves to NO_EVENT or one of its inputs needs no merger
+    static inline Event collapsed_merge(Event result)
+    {
+      if(GenEventImpl::merges_collapsed)
+	(*GenEventImpl::merges_collapsed) += 1;
+      return result;
+    }
+
+    namespace ThreadLocal {
+      // EventMerger storage is recycled through a small per-thread cache -
+      //  a merger is usually freed by whichever thread triggers its last
+      //  input, so this needs no synchronization at all
+      static const size_t MERGER_CACHE_SIZE = 64;
+      __thread void *merger_cache[MERGER_CACHE_SIZE];
+      __thread size_t merger_cache_count = 0;
+    };
+
     // Perform our merging events in a lock free way
     class EventMerger : public EventWaiter {
     public:
@@ -644,6 +767,27 @@ namespace Realm {
       {
       }
 
+      static void *operator new(size_t bytes)
+      {
+	assert(bytes == sizeof(EventMerger));
+	if(ThreadLocal::merger_cache_count > 0) {
+	  if(GenEventImpl::mergers_reused)
+	    (*GenEventImpl::mergers_reused) += 1;
+	  return ThreadLocal::merger_cache[--ThreadLocal::merger_cache_count];
+	}
+	void *ptr = malloc(bytes);
+	assert(ptr != 0);
+	return ptr;
+      }
+
+      static void operator delete(void *ptr)
+      {
+	if(ThreadLocal::merger_cache_count < ThreadLocal::MERGER_CACHE_SIZE)
+	  ThreadLocal::merger_cache[ThreadLocal::merger_cache_count++] = ptr;
+	else
+	  free(ptr);
+      }
+
       void add_event(Event wait_for)
       {
 	bool poisoned = false;
@@ -662,8 +806,9 @@ namespace Realm {
 
         // Increment the count and then add ourselves
         __sync_fetch_and_add(&count_needed, 1);
-	// step 2: enqueue ourselves on the input event
-	EventImpl::add_waiter(wait_for, this);
+	// step 2: enqueue ourselves on the input event (or the event it aliases,
+	//  which triggers just before it)
+	EventImpl::add_waiter(GenEventImpl::resolve_alias(wait_for), this);
       }
 
       // arms the merged event once you're done adding input events - just
@@ -725,8 +870,10 @@ namespace Realm {
     /*static*/ Event GenEventImpl::merge_events(const std::set<Event>& wait_for,
 						bool ignore_faults)
     {
+      if(merges_requested)
+	(*merges_requested) += 1;
       if (wait_for.empty())
-        return Event::NO_EVENT;
+        return collapsed_merge(Event::NO_EVENT);
       // scan through events to see how many exist/haven't fired - we're
       //  interested in counts of 0, 1, or 2+ - also remember the first
       //  event we saw for the count==1 case
@@ -742,7 +889,7 @@ namespace Realm {
 	    //  so by just returning this poisoned event
 	    if(!ignore_faults) {
 	      log_poison.info() << "merging events - " << (*it) << " already poisoned";
-	      return *it;
+	      return collapsed_merge(*it);
 	    }
           }
 	} else {
@@ -757,8 +904,8 @@ namespace Realm {
       //  if we're ignoring faults
 #ifndef EVENT_GRAPH_TRACE
       // counts of 0 or 1 don't require any merging
-      if(wait_count == 0) return Event::NO_EVENT;
-      if((wait_count == 1) && !ignore_faults) return first_wait;
+      if(wait_count == 0) return collapsed_merge(Event::NO_EVENT);
+      if((wait_count == 1) && !ignore_faults) return collapsed_merge(first_wait);
 #else
       if((wait_for.size() == 1) && !ignore_faults)
         return *(wait_for.begin());
@@ -767,21 +914,30 @@ namespace Realm {
       Event finish_event = GenEventImpl::create_genevent()->current_event();
       EventMerger *m = new EventMerger(finish_event, ignore_faults);
 
+      if(CriticalPathRecorder::is_enabled()) {
+	std::vector<Event> inputs(wait_for.begin(), wait_for.end());
+	CriticalPathRecorder::record_merge(finish_event, &inputs[0], inputs.size());
+      }
+
 #ifdef EVENT_GRAPH_TRACE
       log_event_graph.info("Event Merge: (" IDFMT ",%d) %ld", 
 			   finish_event.id, finish_event.gen, wait_for.size());
 #endif
 
-      for(std::set<Event>::const_iterator it = wait_for.begin();
-	  it != wait_for.end();
-	  it++) {
-	log_event.info() << "event merging: event=" << finish_event << " wait_on=" << *it;
-	m->add_event(*it);
+      // subscriptions to remote inputs are sent together once all are added
+      {
+	EventMessageBatch batch;
+	for(std::set<Event>::const_iterator it = wait_for.begin();
+	    it != wait_for.end();
+	    it++) {
+	  log_event.info() << "event merging: event=" << finish_event << " wait_on=" << *it;
+	  m->add_event(*it);
 #ifdef EVENT_GRAPH_TRACE
-        log_event_graph.info("Event Precondition: (" IDFMT ",%d) (" IDFMT ",%d)",
-                             finish_event.id, finish_event.gen,
-                             it->id, it->gen);
+	  log_event_graph.info("Event Precondition: (" IDFMT ",%d) (" IDFMT ",%d)",
+			       finish_event.id, finish_event.gen,
+			       it->id, it->gen);
 #endif
+	}
       }
 
       // once they're all added - arm the thing (it might go off immediately)
@@ -825,6 +981,10 @@ namespace Realm {
       //  event we saw for the count==1 case
       // any poison on input events is immediately propagated (by simply returning
       //  the poisoned input event)
+      if(merges_requested)
+	(*merges_requested) += 1;
+      // an input that repeats the previous untriggered input (e.g. the same
+      //  precondition passed twice) is not counted again
       int wait_count = 0;
       Event first_wait;
 #define CHECK_EVENT(ev) \
@@ -832,8 +992,8 @@ namespace Realm {
 	bool poisoned = false; \
 	if((ev).has_triggered_faultaware(poisoned)) { \
 	  if(poisoned) \
-	    return(ev); \
-	} else { \
+	    return collapsed_merge(ev); \
+	} else if(!wait_count || ((ev) != first_wait)) { \
 	  first_wait = (ev); \
 	  wait_count++; \
 	} \
@@ -850,8 +1010,8 @@ namespace Realm {
       // Avoid these optimizations if we are doing event graph tracing
 #ifndef EVENT_GRAPH_TRACE
       // counts of 0 or 1 don't require any merging
-      if(wait_count == 0) return Event::NO_EVENT;
-      if(wait_count == 1) return first_wait;
+      if(wait_count == 0) return collapsed_merge(Event::NO_EVENT);
+      if(wait_count == 1) return collapsed_merge(first_wait);
 #else
       int existential_count = 0;
       if (ev1.exists()) existential_count++;
@@ -877,29 +1037,37 @@ namespace Realm {
       Event finish_event = GenEventImpl::create_genevent()->current_event();
       EventMerger *m = new EventMerger(finish_event, false /*!ignore faults*/);
 
-      if(ev1.exists()) {
-	log_event.info() << "event merging: event=" << finish_event << " wait_on=" << ev1;
-	m->add_event(ev1);
-      }
-      if(ev2.exists()) {
-	log_event.info() << "event merging: event=" << finish_event << " wait_on=" << ev2;
-	m->add_event(ev2);
-      }
-      if(ev3.exists()) {
-	log_event.info() << "event merging: event=" << finish_event << " wait_on=" << ev3;
-	m->add_event(ev3);
-      }
-      if(ev4.exists()) {
-	log_event.info() << "event merging: event=" << finish_event << " wait_on=" << ev4;
-	m->add_event(ev4);
+      if(CriticalPathRecorder::is_enabled()) {
+	Event inputs[6] = { ev1, ev2, ev3, ev4, ev5, ev6 };
+	CriticalPathRecorder::record_merge(finish_event, inputs, 6);
       }
-      if(ev5.exists()) {
-	log_event.info() << "event merging: event=" << finish_event << " wait_on=" << ev5;
-	m->add_event(ev5);
-      }
-      if(ev6.exists()) {
-	log_event.info() << "event merging: event=" << finish_event << " wait_on=" << ev6;
-	m->add_event(ev6);
+
+      {
+	EventMessageBatch batch;
+	if(ev1.exists()) {
+	  log_event.info() << "event merging: event=" << finish_event << " wait_on=" << ev1;
+	  m->add_event(ev1);
+	}
+	if(ev2.exists()) {
+	  log_event.info() << "event merging: event=" << finish_event << " wait_on=" << ev2;
+	  m->add_event(ev2);
+	}
+	if(ev3.exists()) {
+	  log_event.info() << "event merging: event=" << finish_event << " wait_on=" << ev3;
+	  m->add_event(ev3);
+	}
+	if(ev4.exists()) {
+	  log_event.info() << "event merging: event=" << finish_event << " wait_on=" << ev4;
+	  m->add_event(ev4);
+	}
+	if(ev5.exists()) {
+	  log_event.info() << "event merging: event=" << finish_event << " wait_on=" << ev5;
+	  m->add_event(ev5);
+	}
+	if(ev6.exists()) {
+	  log_event.info() << "event merging: event=" << finish_event << " wait_on=" << ev6;
+	  m->add_event(ev6);
+	}
       }
 
 #ifdef EVENT_GRAPH_TRACE
@@ -948,6 +1116,7 @@ namespace Realm {
 	item.action = EventTraceItem::ACT_CREATE;
       }
 #endif
+      EventSampler::record(EventSampler::ACT_CREATE, impl->current_event());
       return impl;
     }
 
@@ -961,6 +1130,7 @@ namespace Realm {
         item.action = EventTraceItem::ACT_WAIT;
       }
 #endif
+      EventSampler::record(EventSampler::ACT_WAIT, make_event(needed_gen));
       // no early check here as the caller will generally have tried has_triggered()
       //  before allocating its EventWaiter object
 
@@ -979,8 +1149,9 @@ namespace Realm {
 	  trigger_now = true; // actually do trigger outside of mutex
 	  trigger_poisoned = is_generation_poisoned(needed_gen);
 	} else {
-	  std::map<gen_t, bool>::const_iterator it = local_triggers.find(needed_gen);
-	  if(it != local_triggers.end()) {
+	  std::map<gen_t, bool>::const_iterator it;
+	  if(has_local_triggers &&
+	     ((it = remote_state->local_triggers.find(needed_gen)) != remote_state->local_triggers.end())) {
 	    // 2) we're not the owner node, but we've locally triggered this and have correct poison info
 	    assert(owner != gasnet_mynode());
 	    trigger_now = true;
@@ -997,8 +1168,7 @@ namespace Realm {
 	      current_local_waiters.push_back(waiter);
 	    } else {
 	      // no, put it in an appropriate future waiter list - only allowed for non-owners
-	      assert(owner != gasnet_mynode());
-	      future_local_waiters[needed_gen].push_back(waiter);
+	      get_remote_state().future_local_waiters[needed_gen].push_back(waiter);
 	    }
 
 	    // do we need to subscribe to this event?
@@ -1083,30 +1253,246 @@ namespace Realm {
 						   int num_poisoned,
 						   const EventImpl::gen_t *poisoned_generations)
   {
+    if(EventMessageBatch::add_update(target, event, num_poisoned, poisoned_generations))
+      return;
+
     RequestArgs args;
 
     args.event = event;
+    args.forward_count = 0;
 
     Message::request(target, args,
 		     poisoned_generations, num_poisoned * sizeof(EventImpl::gen_t),
 		     PAYLOAD_KEEP);
   }
 
+  // gathers the members of a NodeSet into a vector
+  struct NodeListBuilder {
+    NodeListBuilder(std::vector<gasnet_node_t>& _nodes) : nodes(_nodes) {}
+    inline void apply(gasnet_node_t target) { nodes.push_back(target); }
+    std::vector<gasnet_node_t>& nodes;
+  };
+
   /*static*/ void EventUpdateMessage::broadcast_request(const NodeSet& targets, Event event,
 							int num_poisoned,
 							const EventImpl::gen_t *poisoned_generations)
   {
+    if((Config::event_broadcast_tree_threshold > 0) &&
+       (targets.size() > (size_t)Config::event_broadcast_tree_threshold)) {
+      std::vector<gasnet_node_t> nodes;
+      nodes.reserve(targets.size());
+      NodeListBuilder nlb(nodes);
+      targets.map(nlb);
+      tree_request(&nodes[0], nodes.size(), event,
+		   num_poisoned, poisoned_generations);
+      return;
+    }
+
     MediumBroadcastHelper<EventUpdateMessage> args;
 
     args.event = event;
+    args.forward_count = 0;
 
     args.broadcast(targets,
 		   poisoned_generations, num_poisoned * sizeof(EventImpl::gen_t),
 		   PAYLOAD_KEEP);
   }
 
+  /*static*/ void EventUpdateMessage::tree_request(const gasnet_node_t *nodes, size_t num_nodes,
+						   Event event, int num_poisoned,
+						   const EventImpl::gen_t *poisoned_generations)
+  {
+    size_t radix = std::max(2, Config::event_broadcast_radix);
+    size_t gen_bytes = num_poisoned * sizeof(EventImpl::gen_t);
+
+    // each child gets a contiguous chunk of the list: it is the first entry,
+    //  and will forward to whatever follows it
+    size_t chunk = (num_nodes + radix - 1) / radix;
+    char *buffer = (char *)malloc(gen_bytes + chunk * sizeof(gasnet_node_t));
+    assert(buffer != 0);
+    if(gen_bytes > 0)
+      memcpy(buffer, poisoned_generations, gen_bytes);
+
+    for(size_t start = 0; start < num_nodes; start += chunk) {
+      size_t count = std::min(chunk, num_nodes - start);
+
+      RequestArgs args;
+      args.event = event;
+      args.forward_count = count - 1;
+      if(count > 1)
+	memcpy(buffer + gen_bytes, nodes + start + 1, (count - 1) * sizeof(gasnet_node_t));
+
+      Message::request(nodes[start], args,
+		       buffer, gen_bytes + (count - 1) * sizeof(gasnet_node_t),
+		       PAYLOAD_COPY);
+    }
+
+    free(buffer);
+  }
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class EventMessageBatch
+  //
+
+  namespace ThreadLocal {
+    __thread EventMessageBatch *current_event_batch = 0;
+  };
+
+  EventMessageBatch::EventMessageBatch(void)
+    : outer(ThreadLocal::current_event_batch)
+  {
+    ThreadLocal::current_event_batch = this;
+  }
+
+  EventMessageBatch::~EventMessageBatch(void)
+  {
+    assert(ThreadLocal::current_event_batch == this);
+    ThreadLocal::current_event_batch = outer;
+
+    // nested batches leave everything to the outermost one
+    if(outer)
+      return;
+
+    // a lone subscription goes out in its normal form
+    for(std::map<gasnet_node_t, std::vector<EventSubscribeBatchMessage::Entry> >::const_iterator it = subscriptions.begin();
+	it != subscriptions.end();
+	it++)
+      if(it->second.size() == 1)
+	EventSubscribeMessage::send_request(it->first,
+					    it->second[0].event,
+					    it->second[0].previous_subscribe_gen);
+      else
+	EventSubscribeBatchMessage::send_request(it->first,
+						 &(it->second[0]),
+						 it->second.size());
+
+    for(std::map<gasnet_node_t, PendingUpdates>::const_iterator it = updates.begin();
+	it != updates.end();
+	it++)
+      EventUpdateBatchMessage::send_request(it->first,
+					    &(it->second.data[0]),
+					    it->second.data.size(),
+					    it->second.count);
+  }
+
+  /*static*/ bool EventMessageBatch::add_subscription(gasnet_node_t target, Event event,
+						      EventImpl::gen_t previous_gen)
+  {
+    EventMessageBatch *batch = ThreadLocal::current_event_batch;
+    if(!batch || !Config::event_message_batching)
+      return false;
+
+    // find the outermost batch, which is the one that will send
+    while(batch->outer)
+      batch = batch->outer;
+
+    EventSubscribeBatchMessage::Entry entry;
+    entry.event = event;
+    entry.previous_subscribe_gen = previous_gen;
+    batch->subscriptions[target].push_back(entry);
+    return true;
+  }
+
+  /*static*/ bool EventMessageBatch::add_update(gasnet_node_t target, Event event,
+						int num_poisoned,
+						const EventImpl::gen_t *poisoned_generations)
+  {
+    EventMessageBatch *batch = ThreadLocal::current_event_batch;
+    if(!batch || !Config::event_message_batching)
+      return false;
+
+    while(batch->outer)
+      batch = batch->outer;
+
+    PendingUpdates& pu = batch->updates[target];
+    size_t gen_bytes = num_poisoned * sizeof(EventImpl::gen_t);
+    size_t offset = pu.data.size();
+    pu.data.resize(offset + sizeof(Event) + sizeof(int) + gen_bytes);
+    memcpy(&pu.data[offset], &event, sizeof(Event));
+    memcpy(&pu.data[offset + sizeof(Event)], &num_poisoned, sizeof(int));
+    if(gen_bytes > 0)
+      memcpy(&pu.data[offset + sizeof(Event) + sizeof(int)], poisoned_generations, gen_bytes);
+    pu.count++;
+    return true;
+  }
+
+  /*static*/ void EventSubscribeBatchMessage::send_request(gasnet_node_t target,
+							   const Entry *entries, int count)
+  {
+    RequestArgs args;
+
+    args.node = gasnet_mynode();
+    args.count = count;
+    Message::request(target, args, entries, count * sizeof(Entry), PAYLOAD_COPY);
+  }
+
+  /*static*/ void EventSubscribeBatchMessage::handle_request(RequestArgs args,
+							     const void *data, size_t datalen)
+  {
+    assert(datalen == (args.count * sizeof(Entry)));
+    log_event.debug() << "batched event subscription: node=" << args.node << " count=" << args.count;
+
+    // any immediate triggers we send back are batched as well
+    EventMessageBatch batch;
+    const Entry *entries = (const Entry *)data;
+    for(int i = 0; i < args.count; i++) {
+      EventSubscribeMessage::RequestArgs sub_args;
+      sub_args.node = args.node;
+      sub_args.event = entries[i].event;
+      sub_args.previous_subscribe_gen = entries[i].previous_subscribe_gen;
+      EventSubscribeMessage::handle_request(sub_args);
+    }
+  }
+
+  /*static*/ void EventUpdateBatchMessage::send_request(gasnet_node_t target,
+							const void *data, size_t datalen,
+							int count)
+  {
+    RequestArgs args;
+
+    args.count = count;
+    Message::request(target, args, data, datalen, PAYLOAD_COPY);
+  }
+
+  /*static*/ void EventUpdateBatchMessage::handle_request(RequestArgs args,
+							  const void *data, size_t datalen)
+  {
+    const char *pos = (const char *)data;
+#ifndef NDEBUG
+    const char *end = pos + datalen;
+#endif
+    for(int i = 0; i < args.count; i++) {
+      Event event;
+      int num_poisoned;
+      assert((pos + sizeof(Event) + sizeof(int)) <= end);
+      memcpy(&event, pos, sizeof(Event));
+      memcpy(&num_poisoned, pos + sizeof(Event), sizeof(int));
+      pos += sizeof(Event) + sizeof(int);
+
+      // copy out the generations - the payload has no alignment guarantees
+      EventImpl::gen_t new_poisoned_gens[GenEventImpl::POISONED_GENERATION_LIMIT];
+      assert((num_poisoned >= 0) && (num_poisoned <= GenEventImpl::POISONED_GENERATION_LIMIT));
+      size_t gen_bytes = num_poisoned * sizeof(EventImpl::gen_t);
+      assert((pos + gen_bytes) <= end);
+      if(gen_bytes > 0)
+	memcpy(new_poisoned_gens, pos, gen_bytes);
+      pos += gen_bytes;
+
+      log_event.debug() << "batched event update: event=" << event
+			<< " poisoned=" << num_poisoned;
+
+      GenEventImpl *impl = get_runtime()->get_genevent_impl(event);
+      impl->process_update(ID(event).event.generation, new_poisoned_gens, num_poisoned);
+    }
+    assert(pos == end);
+  }
+
   /*static*/ void EventSubscribeMessage::send_request(gasnet_node_t target, Event event, EventImpl::gen_t previous_gen)
   {
+    if(EventMessageBatch::add_subscription(target, event, previous_gen))
+      return;
+
     RequestArgs args;
 
     args.node = gasnet_mynode();
@@ -1264,7 +1650,8 @@ namespace Realm {
 	to_wake[generation + 1].swap(current_local_waiters);
 
       // now any future waiters up to and including the triggered gen
-      if(!future_local_waiters.empty()) {
+      if(remote_state && !remote_state->future_local_waiters.empty()) {
+	std::map<gen_t, std::vector<EventWaiter *> >& future_local_waiters = remote_state->future_local_waiters;
 	std::map<gen_t, std::vector<EventWaiter *> >::iterator it = future_local_waiters.begin();
 	while((it != future_local_waiters.end()) && (it->first <= current_gen)) {
 	  to_wake[it->first].swap(it->second);
@@ -1281,6 +1668,7 @@ namespace Realm {
 
       // next, clear out any local triggers that have been ack'd
       if(has_local_triggers) {
+	std::map<gen_t, bool>& local_triggers = remote_state->local_triggers;
 	std::map<gen_t, bool>::iterator it = local_triggers.begin();
 	while((it != local_triggers.end()) && (it->first <= current_gen)) {
 	  assert(it->second == is_generation_poisoned(it->first));
@@ -1290,6 +1678,8 @@ namespace Realm {
 	has_local_triggers = !local_triggers.empty();
       }
 
+      release_remote_state_if_empty();
+
       // finally, update the generation count, representing that we have complete information to that point
       __sync_synchronize();
       generation = current_gen;
@@ -1318,10 +1708,20 @@ namespace Realm {
     /*static*/ void EventUpdateMessage::handle_request(EventUpdateMessage::RequestArgs args,
 						       const void *data, size_t datalen)
     {
+      // pass the update on to our subtree (if any) before applying it locally
+      size_t forward_bytes = args.forward_count * sizeof(gasnet_node_t);
+      assert(datalen >= forward_bytes);
+      datalen -= forward_bytes;
+
       const EventImpl::gen_t *new_poisoned_gens = (const EventImpl::gen_t *)data;
       int new_poisoned_count = datalen / sizeof(EventImpl::gen_t);
       assert((new_poisoned_count * sizeof(EventImpl::gen_t)) == datalen);  // no remainders or overflow please
 
+      if(args.forward_count > 0)
+	tree_request((const gasnet_node_t *)(((const char *)data) + datalen),
+		     args.forward_count, args.event,
+		     new_poisoned_count, new_poisoned_gens);
+
       log_event.debug() << "event update: event=" << args.event
 			<< " poisoned=" << ArrayOstreamHelper<EventImpl::gen_t>(new_poisoned_gens, new_poisoned_count);
 
@@ -1367,10 +1767,12 @@ namespace Realm {
       {
 	AutoHSLLock a(mutex);
 
-	std::map<gen_t, bool>::const_iterator it = local_triggers.find(needed_gen);
-	if(it != local_triggers.end()) {
-	  locally_triggered = true;
-	  poisoned = it->second;
+	if(has_local_triggers) {
+	  std::map<gen_t, bool>::const_iterator it = remote_state->local_triggers.find(needed_gen);
+	  if(it != remote_state->local_triggers.end()) {
+	    locally_triggered = true;
+	    poisoned = it->second;
+	  }
 	}
       }
       return locally_triggered;
@@ -1445,6 +1847,9 @@ namespace Realm {
         item.action = EventTraceItem::ACT_TRIGGER;
       }
 #endif
+      EventSampler::record(EventSampler::ACT_TRIGGER, e);
+      if(CriticalPathRecorder::is_enabled())
+	CriticalPathRecorder::record_trigger(e);
 
       std::vector<EventWaiter *> to_wake;
 
@@ -1461,7 +1866,7 @@ namespace Realm {
 	  assert(gen_triggered == (generation + 1));
 
 	  to_wake.swap(current_local_waiters);
-	  assert(future_local_waiters.empty()); // no future waiters here
+	  assert(!remote_state); // no future waiters or local triggers here
 
 	  to_update.swap(remote_waiters);
 
@@ -1516,21 +1921,22 @@ namespace Realm {
 	    // yes, so we have complete information and can update the state directly
 	    to_wake.swap(current_local_waiters);
 	    // any future waiters?
-	    if(!future_local_waiters.empty()) {
-	      std::map<gen_t, std::vector<EventWaiter *> >::iterator it = future_local_waiters.begin();
+	    if(remote_state && !remote_state->future_local_waiters.empty()) {
+	      std::map<gen_t, std::vector<EventWaiter *> >::iterator it = remote_state->future_local_waiters.begin();
 	      log_event.debug() << "future waiters non-empty: first=" << it->first << " (= " << (gen_triggered + 1) << "?)";
 	      if(it->first == (gen_triggered + 1)) {
 		current_local_waiters.swap(it->second);
-		future_local_waiters.erase(it);
+		remote_state->future_local_waiters.erase(it);
 	      }
 	    }
 	    // if this event was poisoned, record it in the local triggers since we only
 	    //  update the official poison list on owner update messages
 	    if(poisoned) {
-	      local_triggers[gen_triggered] = true;
+	      get_remote_state().local_triggers[gen_triggered] = true;
 	      has_local_triggers = true;
               subscribe_needed = true; // make sure we get that update
 	    }
+	    release_remote_state_if_empty();
 
 	    // update generation last, with a synchronization to make sure poisoned generation
 	    // list is valid to any observer of this update
@@ -1543,13 +1949,14 @@ namespace Realm {
 	      //  future waiter list to see who we can wake, and update the local trigger
 	      //  list
 
-	      std::map<gen_t, std::vector<EventWaiter *> >::iterator it = future_local_waiters.find(gen_triggered);
-	      if(it != future_local_waiters.end()) {
+	      RemoteGenState& rs = get_remote_state();
+	      std::map<gen_t, std::vector<EventWaiter *> >::iterator it = rs.future_local_waiters.find(gen_triggered);
+	      if(it != rs.future_local_waiters.end()) {
 		to_wake.swap(it->second);
-		future_local_waiters.erase(it);
+		rs.future_local_waiters.erase(it);
 	      }
 
-	      local_triggers[gen_triggered] = poisoned;
+	      rs.local_triggers[gen_triggered] = poisoned;
 	      has_local_triggers = true;
 
 	      subscribe_needed = true;
@@ -1674,6 +2081,12 @@ namespace Realm {
 	forwarded = true;
 	sender = -1 - args.sender;
       }
+      // a combined arrival is acknowledged right away so that the sender can
+      //  pass on whatever it accumulates in the meantime
+      if(args.combined) {
+	BarrierCombineAckMessage::send_request(sender, args.barrier);
+	sender = gasnet_mynode();
+      }
       impl->adjust_arrival(gen, args.delta, args.barrier.timestamp, args.wait_on,
 			   sender, forwarded,
 			   datalen ? data : 0, datalen);
@@ -1681,7 +2094,8 @@ namespace Realm {
 
     /*static*/ void BarrierAdjustMessage::send_request(gasnet_node_t target, Barrier barrier, int delta, Event wait_on,
 						       gasnet_node_t sender, bool forwarded,
-						       const void *data, size_t datalen)
+						       const void *data, size_t datalen,
+						       bool combined /*= false*/)
     {
       RequestArgs args;
       
@@ -1689,10 +2103,26 @@ namespace Realm {
       args.delta = delta;
       args.wait_on = wait_on;
       args.sender = forwarded ? (-1 - sender) : sender;
+      args.combined = combined;
       
       Message::request(target, args, data, datalen, PAYLOAD_COPY);
     }
 
+    /*static*/ void BarrierCombineAckMessage::send_request(gasnet_node_t target, Barrier barrier)
+    {
+      RequestArgs args;
+
+      args.barrier = barrier;
+
+      Message::request(target, args);
+    }
+
+    /*static*/ void BarrierCombineAckMessage::handle_request(RequestArgs args)
+    {
+      BarrierImpl *impl = get_runtime()->get_barrier_impl(args.barrier);
+      impl->handle_combine_ack(ID(args.barrier).barrier.generation);
+    }
+
     /*static*/ void BarrierSubscribeMessage::send_request(gasnet_node_t target, ID::IDType barrier_id, EventImpl::gen_t subscribe_gen,
 							  gasnet_node_t subscriber, bool forwarded)
     {
@@ -1722,10 +2152,42 @@ namespace Realm {
       args.redop_id = redop_id;
       args.migration_target = migration_target;
       args.base_arrival_count = base_arrival_count;
+      args.forward_count = 0;
 
       Message::request(target, args, data, datalen, PAYLOAD_COPY);
     }
 
+    /*static*/ void BarrierTriggerMessage::tree_request(const gasnet_node_t *nodes, size_t num_nodes,
+							const RequestArgs& args,
+							const void *data, size_t datalen)
+    {
+      size_t radix = std::max(2, Config::barrier_tree_radix);
+
+      // each child gets a contiguous chunk of the list: it is the first entry,
+      //  and will forward to whatever follows it
+      size_t chunk = (num_nodes + radix - 1) / radix;
+      char *buffer = (char *)malloc(datalen + chunk * sizeof(gasnet_node_t));
+      assert(buffer != 0);
+      if(datalen > 0)
+	memcpy(buffer, data, datalen);
+
+      for(size_t start = 0; start < num_nodes; start += chunk) {
+	size_t count = std::min(chunk, num_nodes - start);
+
+	RequestArgs fwd_args = args;
+	fwd_args.node = gasnet_mynode();
+	fwd_args.forward_count = count - 1;
+	if(count > 1)
+	  memcpy(buffer + datalen, nodes + start + 1, (count - 1) * sizeof(gasnet_node_t));
+
+	Message::request(nodes[start], fwd_args,
+			 buffer, datalen + (count - 1) * sizeof(gasnet_node_t),
+			 PAYLOAD_COPY);
+      }
+
+      free(buffer);
+    }
+
 // like strdup, but works on arbitrary byte arrays
 static void *bytedup(const void *data, size_t datalen)
 {
@@ -1841,6 +2303,177 @@ static void *bytedup(const void *data, size_t datalen)
       EventImpl::gen_t trigger_gen, previous_gen;
     };
 
+    // orders notifications by generation range, and then by position
+    //  relative to the owner
+    struct RemoteNotificationOrder {
+      RemoteNotificationOrder(unsigned _owner) : owner(_owner) {}
+      bool operator()(const RemoteNotification& a, const RemoteNotification& b) const
+      {
+	if(a.previous_gen != b.previous_gen) return (a.previous_gen < b.previous_gen);
+	if(a.trigger_gen != b.trigger_gen) return (a.trigger_gen < b.trigger_gen);
+	unsigned n = gasnet_nodes();
+	return (((a.node + n - owner) % n) < ((b.node + n - owner) % n));
+      }
+      unsigned owner;
+    };
+
+    // sends trigger notifications through a tree for every generation range
+    //  needed by more than Config::barrier_tree_radix subscribers - those
+    //  notifications are removed from the list, the rest are left for the
+    //  caller to send directly
+    static void send_tree_notifications(BarrierImpl *impl,
+					std::vector<RemoteNotification>& notifications,
+					EventImpl::gen_t oldest_previous,
+					const void *final_values_copy)
+    {
+      std::sort(notifications.begin(), notifications.end(),
+		RemoteNotificationOrder(impl->owner));
+
+      std::vector<RemoteNotification> leftovers;
+      std::vector<gasnet_node_t> nodes;
+      size_t i = 0;
+      while(i < notifications.size()) {
+	size_t j = i + 1;
+	while((j < notifications.size()) &&
+	      (notifications[j].previous_gen == notifications[i].previous_gen) &&
+	      (notifications[j].trigger_gen == notifications[i].trigger_gen))
+	  j++;
+
+	if((j - i) > (size_t)Config::barrier_tree_radix) {
+	  const RemoteNotification& rn = notifications[i];
+	  log_barrier.info() << "sending tree trigger notification: " << impl->me << "/"
+			     << rn.previous_gen << " -> " << rn.trigger_gen
+			     << ", subscribers=" << (j - i);
+	  nodes.clear();
+	  for(size_t k = i; k < j; k++)
+	    nodes.push_back(notifications[k].node);
+
+	  const void *data = 0;
+	  size_t datalen = 0;
+	  if(final_values_copy) {
+	    data = (const char *)final_values_copy + ((rn.previous_gen - oldest_previous) *
+						      impl->redop->sizeof_lhs);
+	    datalen = (rn.trigger_gen - rn.previous_gen) * impl->redop->sizeof_lhs;
+	  }
+
+	  BarrierTriggerMessage::RequestArgs args;
+	  args.node = gasnet_mynode();
+	  args.barrier_id = impl->me.id;
+	  args.trigger_gen = rn.trigger_gen;
+	  args.previous_gen = rn.previous_gen;
+	  args.first_generation = impl->first_generation;
+	  args.redop_id = impl->redop_id;
+	  args.migration_target = (gasnet_node_t) -1;
+	  args.base_arrival_count = impl->base_arrival_count;
+	  args.forward_count = 0;
+	  BarrierTriggerMessage::tree_request(&nodes[0], nodes.size(), args,
+					      data, datalen);
+	} else
+	  leftovers.insert(leftovers.end(),
+			   notifications.begin() + i, notifications.begin() + j);
+
+	i = j;
+      }
+
+      notifications.swap(leftovers);
+    }
+
+    gasnet_node_t BarrierImpl::tree_parent(void) const
+    {
+      unsigned n = gasnet_nodes();
+      unsigned rel = (gasnet_mynode() + n - owner) % n;
+      assert(rel > 0);
+      unsigned parent_rel = (rel - 1) / Config::barrier_tree_radix;
+      return (parent_rel + owner) % n;
+    }
+
+    // appends reduction values to a combined arrival, folding them together
+    //  if the reduction op is known here and allows it
+    static void add_combined_values(std::vector<char>& values,
+				    const ReductionOpUntyped *redop,
+				    const void *data, size_t datalen)
+    {
+      if(datalen == 0) return;
+      if(redop && redop->is_foldable) {
+	assert((datalen % redop->sizeof_rhs) == 0);
+	size_t ofs = 0;
+	if(values.empty()) {
+	  values.assign((const char *)data, (const char *)data + redop->sizeof_rhs);
+	  ofs = redop->sizeof_rhs;
+	}
+	for(; ofs < datalen; ofs += redop->sizeof_rhs)
+	  redop->fold(&values[0], (const char *)data + ofs, 1, true);
+      } else
+	values.insert(values.end(), (const char *)data, (const char *)data + datalen);
+    }
+
+    bool BarrierImpl::try_combine_arrival(gen_t barrier_gen, int delta,
+					  const void *reduce_value, size_t reduce_value_size)
+    {
+      if(Config::barrier_tree_radix <= 0)
+	return false;
+
+      gasnet_node_t parent;
+      {
+	AutoHSLLock a(mutex);
+
+	// the owner applies arrivals directly, and barriers that have migrated
+	//  use the normal path so that trees built around different owners
+	//  can't form a cycle
+	if((owner == gasnet_mynode()) || (owner != ID(me).barrier.creator_node))
+	  return false;
+
+	CombinedArrivals& ca = combined_arrivals[barrier_gen];
+	if(ca.in_flight) {
+	  // wait for the acknowledgement of the previous adjustment
+	  ca.delta += delta;
+	  add_combined_values(ca.values, redop, reduce_value, reduce_value_size);
+	  return true;
+	}
+	ca.in_flight = true;
+	parent = tree_parent();
+      }
+
+      log_barrier.info() << "sending barrier arrival up tree: " << make_barrier(barrier_gen)
+			 << " delta=" << delta << " parent=" << parent;
+      BarrierAdjustMessage::send_request(parent, make_barrier(barrier_gen), delta, Event::NO_EVENT,
+					 gasnet_mynode(), false /*!forwarded*/,
+					 reduce_value, reduce_value_size,
+					 true /*combined*/);
+      return true;
+    }
+
+    void BarrierImpl::handle_combine_ack(gen_t barrier_gen)
+    {
+      int delta = 0;
+      std::vector<char> values;
+      gasnet_node_t parent;
+      {
+	AutoHSLLock a(mutex);
+
+	std::map<gen_t, CombinedArrivals>::iterator it = combined_arrivals.find(barrier_gen);
+	assert((it != combined_arrivals.end()) && it->second.in_flight);
+
+	if(it->second.delta == 0) {
+	  // nothing accumulated - next arrival goes out right away
+	  combined_arrivals.erase(it);
+	  return;
+	}
+
+	delta = it->second.delta;
+	values.swap(it->second.values);
+	it->second.delta = 0;
+	parent = tree_parent();
+      }
+
+      log_barrier.info() << "sending combined barrier arrivals up tree: " << make_barrier(barrier_gen)
+			 << " delta=" << delta << " parent=" << parent;
+      BarrierAdjustMessage::send_request(parent, make_barrier(barrier_gen), delta, Event::NO_EVENT,
+					 gasnet_mynode(), false /*!forwarded*/,
+					 (values.empty() ? 0 : &values[0]), values.size(),
+					 true /*combined*/);
+    }
+
     // used to adjust a barrier's arrival count either up or down
     // if delta > 0, timestamp is current time (on requesting node)
     // if delta < 0, timestamp says which positive adjustment this arrival must wait for
@@ -1880,6 +2513,12 @@ static void *bytedup(const void *data, size_t datalen)
 	return;
       }
 
+      // untimestamped arrivals may be combined with others on their way to
+      //  the owner
+      if((timestamp == 0) && (delta < 0) &&
+	 try_combine_arrival(barrier_gen, delta, reduce_value, reduce_value_size))
+	return;
+
       log_barrier.info() << "barrier adjustment: event=" << b
 			 << " delta=" << delta << " ts=" << timestamp;
 
@@ -2012,7 +2651,8 @@ static void *bytedup(const void *data, size_t datalen)
 	//  being held - no need to have lots of reduce values lying around
 	if(reduce_value_size > 0) {
 	  assert(redop != 0);
-	  assert(redop->sizeof_rhs == reduce_value_size);
+	  // combined arrivals can carry more than one value
+	  assert((reduce_value_size % redop->sizeof_rhs) == 0);
 
 	  // do we have space for this reduction result yet?
 	  int rel_gen = barrier_gen - first_generation;
@@ -2027,7 +2667,9 @@ static void *bytedup(const void *data, size_t datalen)
 	    }
 	  }
 
-	  redop->apply(final_values + ((rel_gen - 1) * redop->sizeof_lhs), reduce_value, 1, true);
+	  for(size_t ofs = 0; ofs < reduce_value_size; ofs += redop->sizeof_rhs)
+	    redop->apply(final_values + ((rel_gen - 1) * redop->sizeof_lhs),
+			 ((const char *)reduce_value) + ofs, 1, true);
 	}
 
 	// do this AFTER we actually update the reduction value above :)
@@ -2068,6 +2710,14 @@ static void *bytedup(const void *data, size_t datalen)
 	    delete (*it);
 	}
 
+	// with enough subscribers, those that need the same range of
+	//  generations are notified through a tree instead
+	if((Config::barrier_tree_radix > 0) &&
+	   (migration_target == (gasnet_node_t) -1) &&
+	   (remote_notifications.size() > (size_t)Config::barrier_tree_radix))
+	  send_tree_notifications(this, remote_notifications,
+				  oldest_previous, final_values_copy);
+
 	// now do remote notifications
 	for(std::vector<RemoteNotification>::const_iterator it = remote_notifications.begin();
 	    it != remote_notifications.end();
@@ -2271,6 +2921,15 @@ static void *bytedup(const void *data, size_t datalen)
       log_barrier.info("received remote barrier trigger: " IDFMT "/%d -> %d",
 		       args.barrier_id, args.previous_gen, args.trigger_gen);
 
+      // pass the trigger on to our subtree (if any) first
+      if(args.forward_count > 0) {
+	size_t forward_bytes = args.forward_count * sizeof(gasnet_node_t);
+	assert(datalen >= forward_bytes);
+	datalen -= forward_bytes;
+	BarrierTriggerMessage::tree_request((const gasnet_node_t *)(((const char *)data) + datalen),
+					    args.forward_count, args, data, datalen);
+      }
+
       ID id(args.barrier_id);
       id.barrier.generation = args.trigger_gen;
       Barrier b = id.convert<Barrier>();
@@ -2400,4 +3059,131 @@ static void *bytedup(const void *data, size_t datalen)
       Message::request(target, args);
     }
 
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class EventSampler
+  //
+
+  Logger log_evsample("eventsample");
+
+  namespace {
+    struct SampleRecord {
+      long long time;
+      Event event;
+      int action;
+    };
+
+    // rings are never freed before shutdown (a thread's samples are still
+    //  interesting after it exits), and are linked into a global list so a
+    //  dump can find them - the dump reads them without synchronization, so
+    //  a record being written concurrently may be torn
+    struct SampleRing {
+      SampleRing *next;
+      int thread_index;
+      size_t count;  // total records written - current slot is count % depth
+      SampleRecord *records;
+    };
+
+    GASNetHSL sample_ring_mutex;
+    SampleRing *sample_rings = 0;
+    int num_sample_rings = 0;
+
+    __thread SampleRing *my_sample_ring = 0;
+
+    const char *sample_action_names[] = { "create", "wait", "trigger" };
+
+    void handle_dump_signal(int signal)
+    {
+      EventSampler::request_dump();
+    }
+  };
+
+  /*static*/ int EventSampler::sample_rate = 0;
+  /*static*/ int EventSampler::ring_depth = 0;
+  /*static*/ volatile int EventSampler::dump_requested = 0;
+
+  /*static*/ void EventSampler::configure(int _sample_rate, int _ring_depth)
+  {
+    if(_sample_rate <= 0)
+      return;
+
+    assert(_ring_depth > 0);
+    ring_depth = _ring_depth;
+    sample_rate = _sample_rate;
+    signal(SIGUSR2, handle_dump_signal);
+    log_evsample.info() << "event sampling enabled: rate=1/" << sample_rate
+			<< " depth=" << ring_depth;
+  }
+
+  /*static*/ void EventSampler::shutdown(void)
+  {
+    if(sample_rate == 0)
+      return;
+
+    dump();
+    signal(SIGUSR2, SIG_DFL);
+    sample_rate = 0;
+
+    AutoHSLLock al(sample_ring_mutex);
+    while(sample_rings) {
+      SampleRing *ring = sample_rings;
+      sample_rings = ring->next;
+      delete[] ring->records;
+      delete ring;
+    }
+    num_sample_rings = 0;
+  }
+
+  /*static*/ void EventSampler::record_sample(Action action, Event event)
+  {
+    // sample by event (id and generation) rather than by action
+    unsigned long long h = event.id * 0x9E3779B97F4A7C15ULL;
+    if(((h >> 32) % sample_rate) != 0)
+      return;
+
+    SampleRing *ring = my_sample_ring;
+    if(!ring) {
+      ring = new SampleRing;
+      ring->count = 0;
+      ring->records = new SampleRecord[ring_depth];
+      AutoHSLLock al(sample_ring_mutex);
+      ring->thread_index = num_sample_rings++;
+      ring->next = sample_rings;
+      sample_rings = ring;
+      my_sample_ring = ring;
+    }
+
+    SampleRecord& r = ring->records[ring->count % ring_depth];
+    r.time = Clock::current_time_in_nanoseconds();
+    r.event = event;
+    r.action = action;
+    ring->count++;
+
+    if(__builtin_expect(dump_requested, 0) &&
+       __sync_bool_compare_and_swap(&dump_requested, 1, 0))
+      dump();
+  }
+
+  /*static*/ void EventSampler::request_dump(void)
+  {
+    dump_requested = 1;
+  }
+
+  /*static*/ void EventSampler::dump(void)
+  {
+    AutoHSLLock al(sample_ring_mutex);
+    for(SampleRing *ring = sample_rings; ring; ring = ring->next) {
+      size_t count = ring->count;
+      size_t first = ((count > (size_t)ring_depth) ? (count - ring_depth) : 0);
+      log_evsample.print() << "thread " << ring->thread_index << ": "
+			   << (count - first) << " of " << count << " samples";
+      for(size_t i = first; i < count; i++) {
+	const SampleRecord& r = ring->records[i % ring_depth];
+	log_evsample.print() << "  " << r.time << " " << r.event
+			     << " " << sample_action_names[r.action];
+      }
+    }
+  }
+
 }; // namespace Realm
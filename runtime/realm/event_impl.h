@@ -22,6 +22,7 @@
 #include "id.h"
 #include "nodeset.h"
 #include "faults.h"
+#include "sampling.h"
 
 #include "activemsg.h"
 
@@ -45,6 +46,41 @@ namespace Realm {
     };
 #endif
 
+    // unlike EVENT_TRACING, the event sampler is always compiled in and is
+    //  enabled at runtime - a fixed subset of events (chosen by ID, so that
+    //  every action for a sampled event is seen) has its creation, waits and
+    //  triggers recorded in per-thread ring buffers, which are dumped at
+    //  shutdown or on request (e.g. SIGUSR2)
+    class EventSampler {
+    public:
+      enum Action {
+	ACT_CREATE,
+	ACT_WAIT,
+	ACT_TRIGGER,
+      };
+
+      static void configure(int sample_rate, int ring_depth);
+      static void shutdown(void);
+
+      static inline void record(Action action, Event event)
+      {
+	if(__builtin_expect(sample_rate == 0, 1)) return;
+	record_sample(action, event);
+      }
+
+      // async-signal-safe - the dump is performed by the next thread to
+      //  record a sample (or at shutdown)
+      static void request_dump(void);
+      static void dump(void);
+
+    protected:
+      static void record_sample(Action action, Event event);
+
+      static int sample_rate;
+      static int ring_depth;
+      static volatile int dump_requested;
+    };
+
     extern Logger log_poison; // defined in event_impl.cc
 
     class EventWaiter {
@@ -106,6 +142,15 @@ namespace Realm {
 				Event ev5 = Event::NO_EVENT, Event ev6 = Event::NO_EVENT);
       static Event ignorefaults(Event wait_for);
 
+      // counters for how merges are resolved - created once the sampling
+      //  profiler is available (merges before then are not counted)
+      static void create_merge_gauges(void);
+      static void destroy_merge_gauges(void);
+
+      static ProfilingGauges::EventCounter<int> *merges_requested;
+      static ProfilingGauges::EventCounter<int> *merges_collapsed;  // to NO_EVENT or an input
+      static ProfilingGauges::EventCounter<int> *mergers_reused;    // from a cache
+
       // record that the event has triggered and notify anybody who cares
       void trigger(gen_t gen_triggered, int trigger_node, bool poisoned);
 
@@ -140,7 +185,6 @@ namespace Realm {
       //  "future" generations (i.e. ones ahead of what we've heard about if we're
       //  not the owner)
       std::vector<EventWaiter *> current_local_waiters;
-      std::map<gen_t, std::vector<EventWaiter *> > future_local_waiters;
 
       // remote waiters are kept in a bitmask for the current generation - this is
       //  only maintained on the owner, who never has to worry about more than one
@@ -158,11 +202,39 @@ namespace Realm {
       //  any space
       gen_t *poisoned_generations;
 
-      // local triggerings - if we're not the owner, but we've triggered/poisoned events,
-      //  we need to give consistent answers for those generations, so remember what we've
-      //  done until our view of the distributed event catches up
-      // value stored in map is whether generation was poisoned
-      std::map<gen_t, bool> local_triggers;
+      // state that only a non-owner that runs ahead of the owner's updates ever needs
+      //  is kept out of line, so that the (very many) events that never use it cost
+      //  just a pointer - it is allocated on demand and released once it empties
+      struct RemoteGenState {
+	std::map<gen_t, std::vector<EventWaiter *> > future_local_waiters;
+
+	// local triggerings - if we're not the owner, but we've triggered/poisoned events,
+	//  we need to give consistent answers for those generations, so remember what we've
+	//  done until our view of the distributed event catches up
+	// value stored in map is whether generation was poisoned
+	std::map<gen_t, bool> local_triggers;
+      };
+      RemoteGenState *remote_state;
+
+      // helpers for the above - must be called with the mutex held
+      RemoteGenState& get_remote_state(void);
+      void release_remote_state_if_empty(void);
+
+      // if a user event's trigger was deferred on another untriggered event, the
+      //  owner remembers that event as an alias of the pending generation - the
+      //  user event triggers (with the same poison) right after its alias does, so
+      //  later chains and merges can wait on the alias directly
+      // valid only while alias_gen == generation + 1
+      gen_t alias_gen;
+      Event alias_target;
+
+      // records an alias for generation 'gen' (owner only) - returns false if
+      //  that generation has already triggered
+      bool set_alias(gen_t gen, Event target);
+
+      // follows alias links from 'e' (to a bounded depth) and returns the event
+      //  at the end of the chain, or 'e' itself if it has no alias
+      static Event resolve_alias(Event e);
     };
 
     class BarrierImpl : public EventImpl {
@@ -201,6 +273,21 @@ namespace Realm {
 
       bool get_result(gen_t result_gen, void *value, size_t value_size);
 
+      // with Config::barrier_tree_radix > 0, plain arrivals on non-owner nodes
+      //  travel up a tree (rooted at the owner) of nodes, and arrivals that
+      //  meet on the same node while an earlier one is still unacknowledged
+      //  are combined into a single adjustment - returns false if this arrival
+      //  must take the normal path instead
+      bool try_combine_arrival(gen_t barrier_gen, int delta,
+			       const void *reduce_value, size_t reduce_value_size);
+
+      // called when our parent in the arrival tree has received a combined
+      //  arrival - sends whatever has accumulated since then
+      void handle_combine_ack(gen_t barrier_gen);
+
+      // our parent in the arrival tree (relative to the current owner)
+      gasnet_node_t tree_parent(void) const;
+
     public: //protected:
       ID me;
       unsigned owner;
@@ -243,6 +330,15 @@ namespace Realm {
 
       unsigned value_capacity; // how many values the two allocations below can hold
       char *final_values;   // results of completed reductions
+
+      // per-generation state for arrivals combined on their way to the owner
+      struct CombinedArrivals {
+	CombinedArrivals(void) : delta(0), in_flight(false) {}
+	int delta;
+	bool in_flight;  // an adjustment has been sent and not yet acknowledged
+	std::vector<char> values;  // reduction values (folded if possible)
+      };
+      std::map<gen_t, CombinedArrivals> combined_arrivals;
     };
 
   // active messages
@@ -283,9 +379,13 @@ namespace Realm {
     static void send_request(gasnet_node_t target, Event event, bool poisoned);
   };
 
+  // for large subscriber sets, updates can be sent down a spanning tree - the
+  //  payload then carries, after the poisoned generations, the list of nodes
+  //  in the receiver's subtree that it must forward the update to
   struct EventUpdateMessage {
     struct RequestArgs : public BaseMedium {
       Event event;
+      int forward_count;
 
       void apply(gasnet_node_t target);
     };
@@ -300,6 +400,78 @@ namespace Realm {
 			     int num_poisoned, const EventImpl::gen_t *poisoned_generations);
     static void broadcast_request(const NodeSet& targets, Event event,
 				  int num_poisoned, const EventImpl::gen_t *poisoned_generations);
+
+    // splits 'nodes' into up to Config::event_broadcast_radix subtrees and
+    //  sends the update to the root of each
+    static void tree_request(const gasnet_node_t *nodes, size_t num_nodes, Event event,
+			     int num_poisoned, const EventImpl::gen_t *poisoned_generations);
+  };
+
+  // the batched forms of the two messages above carry several events for
+  //  the same node - they are only sent by EventMessageBatch
+
+  struct EventSubscribeBatchMessage {
+    struct RequestArgs : public BaseMedium {
+      gasnet_node_t node;
+      int count;
+    };
+
+    struct Entry {
+      Event event;
+      EventImpl::gen_t previous_subscribe_gen;
+    };
+
+    static void handle_request(RequestArgs args, const void *data, size_t datalen);
+
+    typedef ActiveMessageMediumNoReply<EVENT_SUBSCRIBE_BATCH_MSGID,
+				       RequestArgs,
+				       handle_request> Message;
+
+    static void send_request(gasnet_node_t target, const Entry *entries, int count);
+  };
+
+  struct EventUpdateBatchMessage {
+    struct RequestArgs : public BaseMedium {
+      int count;
+    };
+
+    // payload is 'count' records, each an Event and a poisoned generation
+    //  count followed by that many generations
+    static void handle_request(RequestArgs args, const void *data, size_t datalen);
+
+    typedef ActiveMessageMediumNoReply<EVENT_UPDATE_BATCH_MSGID,
+				       RequestArgs,
+				       handle_request> Message;
+
+    static void send_request(gasnet_node_t target, const void *data, size_t datalen, int count);
+  };
+
+  // while an EventMessageBatch is live on a thread, event subscriptions and
+  //  (unicast) event updates that thread sends are held back and then sent
+  //  as one message per destination node when the outermost batch closes -
+  //  used around loops that wait on or answer for many events at once
+  class EventMessageBatch {
+  public:
+    EventMessageBatch(void);
+    ~EventMessageBatch(void);
+
+    // these return false if no batch is open and the caller should send
+    //  the message itself
+    static bool add_subscription(gasnet_node_t target, Event event,
+				 EventImpl::gen_t previous_gen);
+    static bool add_update(gasnet_node_t target, Event event,
+			   int num_poisoned, const EventImpl::gen_t *poisoned_generations);
+
+  protected:
+    struct PendingUpdates {
+      PendingUpdates(void) : count(0) {}
+      int count;
+      std::vector<char> data;
+    };
+
+    EventMessageBatch *outer;
+    std::map<gasnet_node_t, std::vector<EventSubscribeBatchMessage::Entry> > subscriptions;
+    std::map<gasnet_node_t, PendingUpdates> updates;
   };
 
     struct BarrierAdjustMessage {
@@ -309,6 +481,7 @@ namespace Realm {
 	int delta;
 	Barrier barrier;
         Event wait_on;
+	bool combined;  // sent up the arrival tree - must be acknowledged
       };
 
       static void handle_request(RequestArgs args, const void *data, size_t datalen);
@@ -317,9 +490,25 @@ namespace Realm {
 					 RequestArgs,
 					 handle_request> Message;
 
+      // a reduction barrier adjustment may carry several reduction values
       static void send_request(gasnet_node_t target, Barrier barrier, int delta, Event wait_on,
 			       gasnet_node_t sender, bool forwarded,
-			       const void *data, size_t datalen);
+			       const void *data, size_t datalen,
+			       bool combined = false);
+    };
+
+    struct BarrierCombineAckMessage {
+      struct RequestArgs {
+	Barrier barrier;
+      };
+
+      static void handle_request(RequestArgs args);
+
+      typedef ActiveMessageShortNoReply<BARRIER_COMBINE_ACK_MSGID,
+					RequestArgs,
+					handle_request> Message;
+
+      static void send_request(gasnet_node_t target, Barrier barrier);
     };
 
     struct BarrierSubscribeMessage {
@@ -351,6 +540,9 @@ namespace Realm {
 	ReductionOpID redop_id;
 	gasnet_node_t migration_target;
 	unsigned base_arrival_count;
+	// nodes listed after the reduction data that this node must forward
+	//  the trigger to
+	int forward_count;
       };
 
       static void handle_request(RequestArgs args, const void *data, size_t datalen);
@@ -364,6 +556,12 @@ namespace Realm {
 			       EventImpl::gen_t first_generation, ReductionOpID redop_id,
 			       gasnet_node_t migration_target, unsigned base_arrival_count,
 			       const void *data, size_t datalen);
+
+      // sends the same trigger to every node in 'nodes' down a spanning tree
+      //  with a fan-out of Config::barrier_tree_radix
+      static void tree_request(const gasnet_node_t *nodes, size_t num_nodes,
+			       const RequestArgs& args,
+			       const void *data, size_t datalen);
     };
 
     struct BarrierMigrationMessage {
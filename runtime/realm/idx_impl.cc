@@ -22,11 +22,18 @@
 #include "inst_impl.h"
 #include "mem_impl.h"
 #include "runtime_impl.h"
+#include "deppart_impl.h"
 
 #ifdef USE_HDF
 #include "realm/hdf5/hdf5_module.h"
 #endif
 
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 namespace Realm {
 
   Logger log_meta("meta");
@@ -182,9 +189,8 @@ namespace Realm {
                                            bool mutable_results,
 					   Event wait_on /*= Event::NO_EVENT*/)
     {
-      // TODO: Implement this
-      assert(false);
-      return Event::NO_EVENT;
+      return compute_index_spaces(pairs, ProfilingRequestSet(),
+				  mutable_results, wait_on);
     }
 
     /*static*/
@@ -193,9 +199,21 @@ namespace Realm {
                                            bool mutable_results,
 					   Event wait_on /*= Event::NO_EVENT*/)
     {
-      // TODO: Implement this
-      assert(false);
-      return Event::NO_EVENT;
+      DetailedTimer::ScopedPush sp(TIME_LOW_LEVEL);
+
+      // every descriptor gets its own result, even if it repeats another
+      //  one - the whole batch is a single operation with a single event
+      for(std::vector<BinaryOpDescriptor>::iterator it = pairs.begin();
+	  it != pairs.end();
+	  it++) {
+	ElementMask empty(StaticAccess<IndexSpaceImpl>(get_runtime()->get_index_space_impl(it->parent))->num_elmts);
+	it->result = create_index_space(it->parent, empty, mutable_results);
+      }
+
+      Event finish_event = GenEventImpl::create_genevent()->current_event();
+      BinaryOpsOperation *op = new BinaryOpsOperation(pairs, finish_event, reqs);
+      op->launch(wait_on);
+      return finish_event;
     }
 
     /*static*/
@@ -231,9 +249,46 @@ namespace Realm {
                                 bool mutable_results,
                                 Event wait_on /*= Event::NO_EVENT*/) const
     {
-      // TODO: Implement this
-      assert(false);
-      return Event::NO_EVENT;
+      return create_subspaces_by_field(field_data, subspaces, ProfilingRequestSet(),
+				       mutable_results, wait_on);
+    }
+
+    // a full partitioning by field is an incremental one where everything
+    //  has changed
+    static Event create_subspaces_by_colors(IndexSpace parent,
+					    const std::vector<IndexSpace::FieldDataDescriptor>& field_data,
+					    const ElementMask *changed,
+					    const std::map<DomainPoint, IndexSpace> *previous,
+					    std::map<DomainPoint, IndexSpace>& subspaces,
+					    const ProfilingRequestSet &reqs,
+					    bool mutable_results,
+					    Event wait_on)
+    {
+      Event finish_event = GenEventImpl::create_genevent()->current_event();
+      DeppartOperation *op = new DeppartOperation(DeppartOperation::DEPPART_BY_FIELD,
+						  parent, field_data,
+						  finish_event, reqs);
+
+      // the subspaces are handed back right away, but their valid masks are
+      //  only filled in once the operation completes
+      ElementMask empty(StaticAccess<IndexSpaceImpl>(get_runtime()->get_index_space_impl(parent))->num_elmts);
+      std::vector<IndexSpace> bases;
+      for(std::map<DomainPoint, IndexSpace>::iterator it = subspaces.begin();
+	  it != subspaces.end();
+	  it++) {
+	it->second = IndexSpace::create_index_space(parent, empty, mutable_results);
+	op->colors.push_back(it->first);
+	op->outputs.push_back(it->second);
+	if(previous) {
+	  std::map<DomainPoint, IndexSpace>::const_iterator it2 = previous->find(it->first);
+	  bases.push_back((it2 != previous->end()) ? it2->second : IndexSpace::NO_SPACE);
+	}
+      }
+      if(changed)
+	op->set_incremental(*changed, bases);
+
+      op->launch(wait_on);
+      return finish_event;
     }
 
     Event IndexSpace::create_subspaces_by_field(
@@ -243,9 +298,61 @@ namespace Realm {
                                 bool mutable_results,
                                 Event wait_on /*= Event::NO_EVENT*/) const
     {
-      // TODO: Implement this
-      assert(false);
-      return Event::NO_EVENT;
+      DetailedTimer::ScopedPush sp(TIME_LOW_LEVEL);
+      return create_subspaces_by_colors(*this, field_data, 0, 0, subspaces, reqs,
+					mutable_results, wait_on);
+    }
+
+    Event IndexSpace::update_subspaces_by_field(
+                                const std::vector<FieldDataDescriptor>& field_data,
+                                const ElementMask& changed,
+                                const std::map<DomainPoint, IndexSpace>& previous,
+                                std::map<DomainPoint, IndexSpace>& subspaces,
+                                bool mutable_results,
+                                Event wait_on /*= Event::NO_EVENT*/) const
+    {
+      return update_subspaces_by_field(field_data, changed, previous, subspaces,
+				       ProfilingRequestSet(), mutable_results, wait_on);
+    }
+
+    Event IndexSpace::update_subspaces_by_field(
+                                const std::vector<FieldDataDescriptor>& field_data,
+                                const ElementMask& changed,
+                                const std::map<DomainPoint, IndexSpace>& previous,
+                                std::map<DomainPoint, IndexSpace>& subspaces,
+                                const ProfilingRequestSet &reqs,
+                                bool mutable_results,
+                                Event wait_on /*= Event::NO_EVENT*/) const
+    {
+      DetailedTimer::ScopedPush sp(TIME_LOW_LEVEL);
+      return create_subspaces_by_colors(*this, field_data, &changed, &previous,
+					subspaces, reqs, mutable_results, wait_on);
+    }
+
+    // by_image and by_preimage both have a key space for each output
+    static Event create_subspaces_by_keys(IndexSpace parent,
+					  DeppartOperation::Kind kind,
+					  const std::vector<IndexSpace::FieldDataDescriptor>& field_data,
+					  std::map<IndexSpace, IndexSpace>& subspaces,
+					  const ProfilingRequestSet &reqs,
+					  bool mutable_results,
+					  Event wait_on)
+    {
+      Event finish_event = GenEventImpl::create_genevent()->current_event();
+      DeppartOperation *op = new DeppartOperation(kind, parent, field_data,
+						  finish_event, reqs);
+
+      ElementMask empty(StaticAccess<IndexSpaceImpl>(get_runtime()->get_index_space_impl(parent))->num_elmts);
+      for(std::map<IndexSpace, IndexSpace>::iterator it = subspaces.begin();
+	  it != subspaces.end();
+	  it++) {
+	it->second = IndexSpace::create_index_space(parent, empty, mutable_results);
+	op->keys.push_back(it->first);
+	op->outputs.push_back(it->second);
+      }
+
+      op->launch(wait_on);
+      return finish_event;
     }
 
     Event IndexSpace::create_subspaces_by_image(
@@ -254,9 +361,8 @@ namespace Realm {
                                 bool mutable_results,
                                 Event wait_on /*= Event::NO_EVENT*/) const
     {
-      // TODO: Implement this
-      assert(false);
-      return Event::NO_EVENT;
+      return create_subspaces_by_image(field_data, subspaces, ProfilingRequestSet(),
+				       mutable_results, wait_on);
     }
 
     Event IndexSpace::create_subspaces_by_image(
@@ -266,9 +372,10 @@ namespace Realm {
                                 bool mutable_results,
                                 Event wait_on /*= Event::NO_EVENT*/) const
     {
-      // TODO: Implement this
-      assert(false);
-      return Event::NO_EVENT;
+      DetailedTimer::ScopedPush sp(TIME_LOW_LEVEL);
+      return create_subspaces_by_keys(*this, DeppartOperation::DEPPART_BY_IMAGE,
+				      field_data, subspaces, reqs,
+				      mutable_results, wait_on);
     }
 
     Event IndexSpace::create_subspaces_by_preimage(
@@ -277,9 +384,8 @@ namespace Realm {
                                  bool mutable_results,
                                  Event wait_on /*= Event::NO_EVENT*/) const
     {
-      // TODO: Implement this
-      assert(false);
-      return Event::NO_EVENT;
+      return create_subspaces_by_preimage(field_data, subspaces, ProfilingRequestSet(),
+					  mutable_results, wait_on);
     }
 
     Event IndexSpace::create_subspaces_by_preimage(
@@ -289,9 +395,10 @@ namespace Realm {
                                  bool mutable_results,
                                  Event wait_on /*= Event::NO_EVENT*/) const
     {
-      // TODO: Implement this
-      assert(false);
-      return Event::NO_EVENT;
+      DetailedTimer::ScopedPush sp(TIME_LOW_LEVEL);
+      return create_subspaces_by_keys(*this, DeppartOperation::DEPPART_BY_PREIMAGE,
+				      field_data, subspaces, reqs,
+				      mutable_results, wait_on);
     }
 
   
@@ -332,41 +439,39 @@ namespace Realm {
       return create_instance(memory, field_sizes, block_size, requests, redop_id);
     }
 
-    RegionInstance Domain::create_instance(Memory memory,
-					   const std::vector<size_t> &field_sizes,
-					   size_t block_size,
-                                           const ProfilingRequestSet &reqs,
-					   ReductionOpID redop_id) const
+    // computes the linearization and size of an instance of 'dom' with the
+    //  given fields (possibly adjusting the block size) - shared by the blocking
+    //  and batched creation paths
+    static void compute_instance_layout(const Domain& dom,
+					const std::vector<size_t>& field_sizes,
+					size_t& block_size,
+					int *linearization_bits,
+					size_t& elem_size,
+					size_t& inst_bytes)
     {
-      DetailedTimer::ScopedPush sp(TIME_LOW_LEVEL);      
-      ID id(memory);
-
-      MemoryImpl *m_impl = get_runtime()->get_memory_impl(memory);
-
-      size_t elem_size = 0;
+      elem_size = 0;
       for(std::vector<size_t>::const_iterator it = field_sizes.begin();
 	  it != field_sizes.end();
 	  it++)
 	elem_size += *it;
 
       size_t num_elements;
-      int linearization_bits[RegionInstanceImpl::MAX_LINEARIZATION_LEN];
-      if(get_dim() > 0) {
+      if(dom.get_dim() > 0) {
 	// we have a rectangle - figure out its volume and create based on that
 	LegionRuntime::Arrays::Rect<1> inst_extent;
-	switch(get_dim()) {
+	switch(dom.get_dim()) {
 	case 1:
 	  {
             /*
 	    std::vector<LegionRuntime::Layouts::DimKind> kind_vec;
 	    std::vector<size_t> size_vec;
 	    kind_vec.push_back(LegionRuntime::Layouts::DIM_X);
-	    size_vec.push_back(get_rect<1>().dim_size(0));
-	    LegionRuntime::Layouts::SplitDimLinearization<1> cl(get_rect<1>().lo, make_point(0), kind_vec, size_vec);
+	    size_vec.push_back(dom.get_rect<1>().dim_size(0));
+	    LegionRuntime::Layouts::SplitDimLinearization<1> cl(dom.get_rect<1>().lo, make_point(0), kind_vec, size_vec);
 	    */
-            LegionRuntime::Arrays::FortranArrayLinearization<1> cl(get_rect<1>(), 0);
+            LegionRuntime::Arrays::FortranArrayLinearization<1> cl(dom.get_rect<1>(), 0);
 	    DomainLinearization dl = DomainLinearization::from_mapping<1>(LegionRuntime::Arrays::Mapping<1, 1>::new_dynamic_mapping(cl));
-	    inst_extent = cl.image_convex(get_rect<1>());
+	    inst_extent = cl.image_convex(dom.get_rect<1>());
 	    dl.serialize(linearization_bits);
 	    break;
 	  }
@@ -378,13 +483,13 @@ namespace Realm {
 	    std::vector<size_t> size_vec;
 	    kind_vec.push_back(LegionRuntime::Layouts::DIM_X);
 	    kind_vec.push_back(LegionRuntime::Layouts::DIM_Y);
-	    size_vec.push_back(get_rect<2>().dim_size(0));
-	    size_vec.push_back(get_rect<2>().dim_size(1));
-	    LegionRuntime::Layouts::SplitDimLinearization<2> cl(get_rect<2>().lo, make_point(0), kind_vec, size_vec);
+	    size_vec.push_back(dom.get_rect<2>().dim_size(0));
+	    size_vec.push_back(dom.get_rect<2>().dim_size(1));
+	    LegionRuntime::Layouts::SplitDimLinearization<2> cl(dom.get_rect<2>().lo, make_point(0), kind_vec, size_vec);
 	    */
-            LegionRuntime::Arrays::FortranArrayLinearization<2> cl(get_rect<2>(), 0);
+            LegionRuntime::Arrays::FortranArrayLinearization<2> cl(dom.get_rect<2>(), 0);
 	    DomainLinearization dl = DomainLinearization::from_mapping<2>(LegionRuntime::Arrays::Mapping<2, 1>::new_dynamic_mapping(cl));
-	    inst_extent = cl.image_convex(get_rect<2>());
+	    inst_extent = cl.image_convex(dom.get_rect<2>());
 	    dl.serialize(linearization_bits);
 	    break;
 	  }
@@ -397,26 +502,26 @@ namespace Realm {
 	    kind_vec.push_back(LegionRuntime::Layouts::DIM_X);
 	    kind_vec.push_back(LegionRuntime::Layouts::DIM_Y);
 	    kind_vec.push_back(LegionRuntime::Layouts::DIM_Z);
-	    size_vec.push_back(get_rect<3>().dim_size(0));
-	    size_vec.push_back(get_rect<3>().dim_size(1));
-	    size_vec.push_back(get_rect<3>().dim_size(2));
-	    LegionRuntime:: Layouts::SplitDimLinearization<3> cl(get_rect<3>().lo, make_point(0), kind_vec, size_vec);
+	    size_vec.push_back(dom.get_rect<3>().dim_size(0));
+	    size_vec.push_back(dom.get_rect<3>().dim_size(1));
+	    size_vec.push_back(dom.get_rect<3>().dim_size(2));
+	    LegionRuntime:: Layouts::SplitDimLinearization<3> cl(dom.get_rect<3>().lo, make_point(0), kind_vec, size_vec);
 	    */
-            LegionRuntime::Arrays::FortranArrayLinearization<3> cl(get_rect<3>(), 0);
+            LegionRuntime::Arrays::FortranArrayLinearization<3> cl(dom.get_rect<3>(), 0);
 	    DomainLinearization dl = DomainLinearization::from_mapping<3>(LegionRuntime::Arrays::Mapping<3, 1>::new_dynamic_mapping(cl));
-	    inst_extent = cl.image_convex(get_rect<3>());
+	    inst_extent = cl.image_convex(dom.get_rect<3>());
 	    dl.serialize(linearization_bits);
 	    break;
 	  }
 
-	default: assert(0); return RegionInstance::NO_INST;
+	default: assert(0); return;
 	}
 	num_elements = inst_extent.volume();
 	// always at least one element
 	if(num_elements <= 0) num_elements = 1;
 	//printf("num_elements = %zd\n", num_elements);
       } else {
-	IndexSpaceImpl *r = get_runtime()->get_index_space_impl(get_index_space());
+	IndexSpaceImpl *r = get_runtime()->get_index_space_impl(dom.get_index_space());
 
 	StaticAccess<IndexSpaceImpl> data(r);
 
@@ -476,7 +581,24 @@ namespace Realm {
 	  num_elements += (block_size - leftover);
       }
 
-      size_t inst_bytes = elem_size * num_elements;
+      inst_bytes = elem_size * num_elements;
+    }
+
+    RegionInstance Domain::create_instance(Memory memory,
+					   const std::vector<size_t> &field_sizes,
+					   size_t block_size,
+                                           const ProfilingRequestSet &reqs,
+					   ReductionOpID redop_id) const
+    {
+      DetailedTimer::ScopedPush sp(TIME_LOW_LEVEL);      
+      ID id(memory);
+
+      MemoryImpl *m_impl = get_runtime()->get_memory_impl(memory);
+
+      size_t elem_size, inst_bytes;
+      int linearization_bits[RegionInstanceImpl::MAX_LINEARIZATION_LEN];
+      compute_instance_layout(*this, field_sizes, block_size, linearization_bits,
+			      elem_size, inst_bytes);
 
       RegionInstance i = m_impl->create_instance(get_index_space(), linearization_bits, inst_bytes,
 						 block_size, elem_size, field_sizes,
@@ -488,6 +610,101 @@ namespace Realm {
       return i;
     }
 
+    RegionInstance Domain::create_external_instance(Memory memory, void *base, size_t bytes,
+						    const std::vector<size_t> &field_sizes,
+						    size_t block_size) const
+    {
+      ProfilingRequestSet requests;
+      return create_external_instance(memory, base, bytes, field_sizes, block_size, requests);
+    }
+
+    RegionInstance Domain::create_external_instance(Memory memory, void *base, size_t bytes,
+						    const std::vector<size_t> &field_sizes,
+						    size_t block_size,
+						    const ProfilingRequestSet &reqs) const
+    {
+      DetailedTimer::ScopedPush sp(TIME_LOW_LEVEL);
+      // the storage is only addressable where it lives
+      assert(ID(memory).memory.owner_node == gasnet_mynode());
+
+      MemoryImpl *m_impl = get_runtime()->get_memory_impl(memory);
+
+      size_t elem_size, inst_bytes;
+      int linearization_bits[RegionInstanceImpl::MAX_LINEARIZATION_LEN];
+      compute_instance_layout(*this, field_sizes, block_size, linearization_bits,
+			      elem_size, inst_bytes);
+      if(bytes < inst_bytes) {
+	log_meta.warning("external storage at %p too small for region=" IDFMT ": %zd < %zd bytes",
+			 base, this->is_id, bytes, inst_bytes);
+	return RegionInstance::NO_INST;
+      }
+
+      RegionInstance i = m_impl->create_instance_local(get_index_space(), linearization_bits,
+						       inst_bytes, block_size, elem_size,
+						       field_sizes, 0 /*redop_id*/,
+						       -1 /*list size*/, reqs,
+						       RegionInstance::NO_INST, base);
+      log_meta.info("external instance created: region=" IDFMT " memory=" IDFMT " id=" IDFMT " base=%p bytes=%zd",
+	       this->is_id, memory.id, i.id, base, inst_bytes);
+      return i;
+    }
+
+    /*static*/ Event Domain::create_instances(std::vector<RegionInstance>& results,
+					      const std::vector<InstanceCreationRequest>& requests)
+    {
+      DetailedTimer::ScopedPush sp(TIME_LOW_LEVEL);
+
+      results.assign(requests.size(), RegionInstance::NO_INST);
+
+      ProfilingRequestSet no_reqs;
+      std::vector<CreateInstanceBatchMessage::Entry> remote_entries;
+
+      for(size_t idx = 0; idx < requests.size(); idx++) {
+	const InstanceCreationRequest& req = requests[idx];
+	MemoryImpl *m_impl = get_runtime()->get_memory_impl(req.memory);
+	const ProfilingRequestSet& reqs = (req.reqs ? *req.reqs : no_reqs);
+
+	size_t block_size = req.block_size;
+	size_t elem_size, inst_bytes;
+	int linearization_bits[RegionInstanceImpl::MAX_LINEARIZATION_LEN];
+	compute_instance_layout(req.domain, req.field_sizes, block_size,
+				linearization_bits, elem_size, inst_bytes);
+
+	if(m_impl->is_owned_remotely()) {
+	  // defer to a batched request to the owner
+	  remote_entries.resize(remote_entries.size() + 1);
+	  CreateInstanceBatchMessage::Entry& e = remote_entries.back();
+	  e.index = idx;
+	  e.memory = req.memory;
+	  e.ispace = req.domain.get_index_space();
+	  e.bytes_needed = inst_bytes;
+	  e.block_size = block_size;
+	  e.element_size = elem_size;
+	  e.redopid = req.redop_id;
+	  for(unsigned i = 0; i < RegionInstanceImpl::MAX_LINEARIZATION_LEN; i++)
+	    e.linearization_bits[i] = linearization_bits[i];
+	  e.field_sizes = req.field_sizes;
+	  e.reqs = reqs;
+	  continue;
+	}
+
+	// local creation doesn't block, so do it right away
+	results[idx] = m_impl->create_instance(req.domain.get_index_space(),
+					       linearization_bits, inst_bytes,
+					       block_size, elem_size, req.field_sizes,
+					       req.redop_id,
+					       -1 /*list size*/, reqs,
+					       RegionInstance::NO_INST);
+	log_meta.info("instance created: region=" IDFMT " memory=" IDFMT " id=" IDFMT " bytes=%zd",
+		      req.domain.is_id, req.memory.id, results[idx].id, inst_bytes);
+      }
+
+      if(remote_entries.empty())
+	return Event::NO_EVENT;
+
+      return CreateInstanceBatchMessage::send_requests(results, remote_entries);
+    }
+
     RegionInstance Domain::create_hdf5_instance(const char *file_name,
                                                 const std::vector<size_t> &field_sizes,
                                                 const std::vector<const char*> &field_files,
@@ -739,6 +956,364 @@ namespace Realm {
   // class ElementMask
   //
 
+    // bulk operations on the words of dense masks - the vector versions are
+    //  built with target attributes and picked at runtime based on what the
+    //  cpu supports, and are only used for spans long enough to make up for
+    //  the indirect call
+    static const size_t MIN_VECTOR_WORDS = 16;
+
+    static size_t popcount_words_scalar(const uint64_t *bits, size_t words)
+    {
+      size_t count = 0;
+      for(size_t i = 0; i < words; i++)
+	count += __builtin_popcountll(bits[i]);
+      return count;
+    }
+
+    // returns the index of the first word that isn't 'skip', or 'words'
+    static size_t find_word_scalar(const uint64_t *bits, size_t words,
+				   uint64_t skip)
+    {
+      for(size_t i = 0; i < words; i++)
+	if(bits[i] != skip)
+	  return i;
+      return words;
+    }
+
+    static void or_words_scalar(uint64_t *dst, const uint64_t *src, size_t words)
+    {
+      for(size_t i = 0; i < words; i++)
+	dst[i] |= src[i];
+    }
+
+    static void and_words_scalar(uint64_t *dst, const uint64_t *src, size_t words)
+    {
+      for(size_t i = 0; i < words; i++)
+	dst[i] &= src[i];
+    }
+
+    static void andnot_words_scalar(uint64_t *dst, const uint64_t *src, size_t words)
+    {
+      for(size_t i = 0; i < words; i++)
+	dst[i] &= ~src[i];
+    }
+
+#if defined(__x86_64__) && defined(__GNUC__)
+    __attribute__((target("avx2")))
+    static size_t popcount_words_avx2(const uint64_t *bits, size_t words)
+    {
+      // nibble lookup table, with the byte counts summed per 64-bit lane
+      const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3,
+					      1, 2, 2, 3, 2, 3, 3, 4,
+					      0, 1, 1, 2, 1, 2, 2, 3,
+					      1, 2, 2, 3, 2, 3, 3, 4);
+      const __m256i low_mask = _mm256_set1_epi8(0x0f);
+      __m256i acc = _mm256_setzero_si256();
+      size_t i = 0;
+      for(; i + 4 <= words; i += 4) {
+	__m256i v = _mm256_loadu_si256((const __m256i *)(bits + i));
+	__m256i lo = _mm256_and_si256(v, low_mask);
+	__m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+	__m256i cnt = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+				      _mm256_shuffle_epi8(lookup, hi));
+	acc = _mm256_add_epi64(acc, _mm256_sad_epu8(cnt, _mm256_setzero_si256()));
+      }
+      uint64_t lanes[4];
+      _mm256_storeu_si256((__m256i *)lanes, acc);
+      return (lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+	      popcount_words_scalar(bits + i, words - i));
+    }
+
+    __attribute__((target("avx512f,avx512vpopcntdq")))
+    static size_t popcount_words_avx512(const uint64_t *bits, size_t words)
+    {
+      __m512i acc = _mm512_setzero_si512();
+      size_t i = 0;
+      for(; i + 8 <= words; i += 8)
+	acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(_mm512_loadu_si512(bits + i)));
+      uint64_t lanes[8];
+      _mm512_storeu_si512(lanes, acc);
+      uint64_t count = 0;
+      for(int j = 0; j < 8; j++)
+	count += lanes[j];
+      return count + popcount_words_scalar(bits + i, words - i);
+    }
+
+    __attribute__((target("avx2")))
+    static size_t find_word_avx2(const uint64_t *bits, size_t words,
+				 uint64_t skip)
+    {
+      const __m256i vskip = _mm256_set1_epi64x(skip);
+      size_t i = 0;
+      for(; i + 4 <= words; i += 4) {
+	__m256i eq = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i *)(bits + i)),
+					vskip);
+	unsigned ne = ~_mm256_movemask_pd(_mm256_castsi256_pd(eq)) & 0xf;
+	if(ne)
+	  return i + __builtin_ctz(ne);
+      }
+      return i + find_word_scalar(bits + i, words - i, skip);
+    }
+
+    __attribute__((target("avx512f")))
+    static size_t find_word_avx512(const uint64_t *bits, size_t words,
+				   uint64_t skip)
+    {
+      const __m512i vskip = _mm512_set1_epi64(skip);
+      size_t i = 0;
+      for(; i + 8 <= words; i += 8) {
+	__mmask8 ne = _mm512_cmpneq_epi64_mask(_mm512_loadu_si512(bits + i), vskip);
+	if(ne)
+	  return i + __builtin_ctz(ne);
+      }
+      return i + find_word_scalar(bits + i, words - i, skip);
+    }
+
+    __attribute__((target("avx2")))
+    static void or_words_avx2(uint64_t *dst, const uint64_t *src, size_t words)
+    {
+      size_t i = 0;
+      for(; i + 4 <= words; i += 4) {
+	__m256i v = _mm256_or_si256(_mm256_loadu_si256((const __m256i *)(dst + i)),
+				    _mm256_loadu_si256((const __m256i *)(src + i)));
+	_mm256_storeu_si256((__m256i *)(dst + i), v);
+      }
+      or_words_scalar(dst + i, src + i, words - i);
+    }
+
+    __attribute__((target("avx2")))
+    static void and_words_avx2(uint64_t *dst, const uint64_t *src, size_t words)
+    {
+      size_t i = 0;
+      for(; i + 4 <= words; i += 4) {
+	__m256i v = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(dst + i)),
+				     _mm256_loadu_si256((const __m256i *)(src + i)));
+	_mm256_storeu_si256((__m256i *)(dst + i), v);
+      }
+      and_words_scalar(dst + i, src + i, words - i);
+    }
+
+    __attribute__((target("avx2")))
+    static void andnot_words_avx2(uint64_t *dst, const uint64_t *src, size_t words)
+    {
+      size_t i = 0;
+      for(; i + 4 <= words; i += 4) {
+	// andnot complements its first argument
+	__m256i v = _mm256_andnot_si256(_mm256_loadu_si256((const __m256i *)(src + i)),
+					_mm256_loadu_si256((const __m256i *)(dst + i)));
+	_mm256_storeu_si256((__m256i *)(dst + i), v);
+      }
+      andnot_words_scalar(dst + i, src + i, words - i);
+    }
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+    // NEON is always there on aarch64, so these don't need a runtime check
+    static size_t popcount_words_neon(const uint64_t *bits, size_t words)
+    {
+      uint64x2_t acc = vdupq_n_u64(0);
+      size_t i = 0;
+      for(; i + 2 <= words; i += 2) {
+	uint8x16_t cnt = vcntq_u8(vreinterpretq_u8_u64(vld1q_u64(bits + i)));
+	acc = vaddq_u64(acc, vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(cnt))));
+      }
+      return (vgetq_lane_u64(acc, 0) + vgetq_lane_u64(acc, 1) +
+	      popcount_words_scalar(bits + i, words - i));
+    }
+
+    static size_t find_word_neon(const uint64_t *bits, size_t words,
+				 uint64_t skip)
+    {
+      const uint64x2_t vskip = vdupq_n_u64(skip);
+      size_t i = 0;
+      for(; i + 2 <= words; i += 2) {
+	uint64x2_t eq = vceqq_u64(vld1q_u64(bits + i), vskip);
+	if((vgetq_lane_u64(eq, 0) & vgetq_lane_u64(eq, 1)) != ~(uint64_t)0)
+	  return i + (vgetq_lane_u64(eq, 0) ? 1 : 0);
+      }
+      return i + find_word_scalar(bits + i, words - i, skip);
+    }
+
+    static void or_words_neon(uint64_t *dst, const uint64_t *src, size_t words)
+    {
+      size_t i = 0;
+      for(; i + 2 <= words; i += 2)
+	vst1q_u64(dst + i, vorrq_u64(vld1q_u64(dst + i), vld1q_u64(src + i)));
+      or_words_scalar(dst + i, src + i, words - i);
+    }
+
+    static void and_words_neon(uint64_t *dst, const uint64_t *src, size_t words)
+    {
+      size_t i = 0;
+      for(; i + 2 <= words; i += 2)
+	vst1q_u64(dst + i, vandq_u64(vld1q_u64(dst + i), vld1q_u64(src + i)));
+      and_words_scalar(dst + i, src + i, words - i);
+    }
+
+    static void andnot_words_neon(uint64_t *dst, const uint64_t *src, size_t words)
+    {
+      size_t i = 0;
+      for(; i + 2 <= words; i += 2)
+	vst1q_u64(dst + i, vbicq_u64(vld1q_u64(dst + i), vld1q_u64(src + i)));
+      andnot_words_scalar(dst + i, src + i, words - i);
+    }
+#endif
+
+    struct MaskKernels {
+      size_t (*popcount)(const uint64_t *bits, size_t words);
+      size_t (*find_word)(const uint64_t *bits, size_t words, uint64_t skip);
+      void (*or_words)(uint64_t *dst, const uint64_t *src, size_t words);
+      void (*and_words)(uint64_t *dst, const uint64_t *src, size_t words);
+      void (*andnot_words)(uint64_t *dst, const uint64_t *src, size_t words);
+    };
+
+    static MaskKernels select_mask_kernels(void)
+    {
+      MaskKernels k;
+      k.popcount = popcount_words_scalar;
+      k.find_word = find_word_scalar;
+      k.or_words = or_words_scalar;
+      k.and_words = and_words_scalar;
+      k.andnot_words = andnot_words_scalar;
+#if defined(__x86_64__) && defined(__GNUC__)
+      if(__builtin_cpu_supports("avx2")) {
+	k.popcount = popcount_words_avx2;
+	k.find_word = find_word_avx2;
+	k.or_words = or_words_avx2;
+	k.and_words = and_words_avx2;
+	k.andnot_words = andnot_words_avx2;
+      }
+      if(__builtin_cpu_supports("avx512f")) {
+	k.find_word = find_word_avx512;
+	if(__builtin_cpu_supports("avx512vpopcntdq"))
+	  k.popcount = popcount_words_avx512;
+      }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+      k.popcount = popcount_words_neon;
+      k.find_word = find_word_neon;
+      k.or_words = or_words_neon;
+      k.and_words = and_words_neon;
+      k.andnot_words = andnot_words_neon;
+#endif
+      return k;
+    }
+
+    static const MaskKernels& mask_kernels(void)
+    {
+      static const MaskKernels kernels = select_mask_kernels();
+      return kernels;
+    }
+
+    static inline size_t popcount_words(const uint64_t *bits, size_t words)
+    {
+      if(words < MIN_VECTOR_WORDS)
+	return popcount_words_scalar(bits, words);
+      return mask_kernels().popcount(bits, words);
+    }
+
+    static inline size_t find_word(const uint64_t *bits, size_t words,
+				   uint64_t skip)
+    {
+      if(words < MIN_VECTOR_WORDS)
+	return find_word_scalar(bits, words, skip);
+      return mask_kernels().find_word(bits, words, skip);
+    }
+
+    static inline void or_words(uint64_t *dst, const uint64_t *src, size_t words)
+    {
+      if(words < MIN_VECTOR_WORDS)
+	or_words_scalar(dst, src, words);
+      else
+	mask_kernels().or_words(dst, src, words);
+    }
+
+    static inline void and_words(uint64_t *dst, const uint64_t *src, size_t words)
+    {
+      if(words < MIN_VECTOR_WORDS)
+	and_words_scalar(dst, src, words);
+      else
+	mask_kernels().and_words(dst, src, words);
+    }
+
+    static inline void andnot_words(uint64_t *dst, const uint64_t *src, size_t words)
+    {
+      if(words < MIN_VECTOR_WORDS)
+	andnot_words_scalar(dst, src, words);
+      else
+	mask_kernels().andnot_words(dst, src, words);
+    }
+
+    // sets or clears bits [start, start+count) of a dense mask, a whole word
+    //  at a time where possible
+    static void update_bit_range(uint64_t *bits, coord_t start, size_t count,
+				 bool value)
+    {
+      if(count == 0) return;
+      coord_t last = start + count - 1;
+      coord_t first_word = start >> 6;
+      coord_t last_word = last >> 6;
+      uint64_t first_mask = (~(uint64_t)0) << (start & 63);
+      uint64_t last_mask = (~(uint64_t)0) >> (63 - (last & 63));
+      if(first_word == last_word)
+	first_mask &= last_mask;
+      if(value)
+	bits[first_word] |= first_mask;
+      else
+	bits[first_word] &= ~first_mask;
+      if(first_word == last_word)
+	return;
+      if(last_word > (first_word + 1))
+	memset(bits + first_word + 1, (value ? 0xff : 0),
+	       (last_word - first_word - 1) * sizeof(uint64_t));
+      if(value)
+	bits[last_word] |= last_mask;
+      else
+	bits[last_word] &= ~last_mask;
+    }
+
+    // returns the first bit at or after 'pos' that has the requested
+    //  value, or 'num_bits' if there isn't one
+    static size_t find_next_bit(const uint64_t *bits, size_t num_bits,
+				size_t pos, bool value)
+    {
+      if(pos >= num_bits)
+	return num_bits;
+      size_t idx = pos >> 6;
+      uint64_t v = bits[idx];
+      if(!value) v = ~v;
+      v &= (~(uint64_t)0) << (pos & 63);
+      if(!v) {
+	// skip the words that are entirely the wrong value
+	size_t words = (num_bits + 63) >> 6;
+	idx++;
+	idx += find_word(bits + idx, words - idx, (value ? 0 : ~(uint64_t)0));
+	if(idx >= words)
+	  return num_bits;
+	v = bits[idx];
+	if(!value) v = ~v;
+      }
+      return std::min(num_bits, (idx << 6) + __builtin_ctzll(v));
+    }
+
+    // finds the first run of 'count' bits with the requested value that
+    //  starts at or after 'start' by hopping between the edges of runs
+    //  rather than testing every bit
+    static coord_t find_bit_run(const uint64_t *bits, size_t num_bits,
+				size_t start, size_t count, bool value)
+    {
+      size_t pos = start;
+      while((pos < num_bits) && (count <= (num_bits - pos))) {
+	pos = find_next_bit(bits, num_bits, pos, value);
+	if((pos >= num_bits) || (count > (num_bits - pos)))
+	  break;
+	size_t end = find_next_bit(bits, num_bits, pos, !value);
+	if((end - pos) >= count)
+	  return pos;
+	pos = end;
+      }
+      return -1LL;
+    }
+
     ElementMask::ElementMask(void)
       : first_element(-1LL), num_elements((size_t)-1LL), memory(Memory::NO_MEMORY), offset(-1LL),
 	raw_data(0), first_enabled_elmt(-1LL), last_enabled_elmt(-1LL)
@@ -912,14 +1487,7 @@ namespace Realm {
 
       if(raw_data != 0) {
 	ElementMaskImpl *impl = (ElementMaskImpl *)raw_data;
-	//printf("ENABLE %p %d %d %d " IDFMT "\n", raw_data, offset, start, count, impl->bits[0]);
-	coord_t pos = start;
-	for(size_t i = 0; i < count; i++) {
-	  uint64_t *ptr = &(impl->bits[pos >> 6]);
-	  *ptr |= (1ULL << (pos & 0x3f));
-	  pos++;
-	}
-	//printf("ENABLED %p %d %d %d " IDFMT "\n", raw_data, offset, start, count, impl->bits[0]);
+	update_bit_range(impl->bits, start, count, true);
       } else {
 	//printf("ENABLE(2) " IDFMT " %d %d %d\n", memory.id, offset, start, count);
 	MemoryImpl *m_impl = get_runtime()->get_memory_impl(memory);
@@ -953,12 +1521,7 @@ namespace Realm {
 
       if(raw_data != 0) {
 	ElementMaskImpl *impl = (ElementMaskImpl *)raw_data;
-	coord_t pos = start;
-	for(size_t i = 0; i < count; i++) {
-	  uint64_t *ptr = &(impl->bits[pos >> 6]);
-	  *ptr &= ~(1ULL << (pos & 0x3f));
-	  pos++;
-	}
+	update_bit_range(impl->bits, start, count, false);
       } else {
 	//printf("DISABLE(2) " IDFMT " %d %d %d\n", memory.id, offset, start, count);
 	MemoryImpl *m_impl = get_runtime()->get_memory_impl(memory);
@@ -978,7 +1541,9 @@ namespace Realm {
       start += first_element;
       if(start == first_enabled_elmt) {
 	//printf("pushing first: %d -> %d\n", first_enabled_elmt, first_enabled_elmt+1);
-	first_enabled_elmt = find_enabled(1, first_enabled_elmt + count);
+	// find_enabled wants a position relative to our first element
+	first_enabled_elmt = find_enabled(1, (first_enabled_elmt + count -
+					      first_element));
 	// if we didn't find anything we just cleared the last enabled bit too
 	if(first_enabled_elmt == -1LL)
 	  last_enabled_elmt = -1LL;
@@ -987,20 +1552,21 @@ namespace Realm {
 
     coord_t ElementMask::find_enabled(size_t count /*= 1 */, coord_t start /*= 0*/) const
     {
-      if(start == 0)
+      if(start == 0) {
+	// nothing enabled means there's nothing to find
+	if(first_enabled_elmt < 0)
+	  return -1LL;
 	start = first_enabled_elmt - first_element;
+      }
       if(raw_data != 0) {
 	ElementMaskImpl *impl = (ElementMaskImpl *)raw_data;
-	//printf("FIND_ENABLED %p %d %d " IDFMT "\n", raw_data, first_element, count, impl->bits[0]);
-	for(size_t pos = start; pos <= num_elements - count; pos++) {
-	  size_t run = 0;
-	  while(1) {
-	    uint64_t bit = ((impl->bits[pos >> 6] >> (pos & 0x3f))) & 1;
-	    if(bit != 1) break;
-	    pos++; run++;
-	    if(run >= count) return (pos - run) + first_element;
-	  }
-	}
+	// no run can extend past the last enabled element
+	size_t limit = num_elements;
+	if((last_enabled_elmt >= 0) && 
+	   ((size_t)(last_enabled_elmt - first_element + 1) < limit))
+	  limit = last_enabled_elmt - first_element + 1;
+	coord_t pos = find_bit_run(impl->bits, limit, start, count, true);
+	return ((pos >= 0) ? (pos + first_element) : -1LL);
       } else {
 	MemoryImpl *m_impl = get_runtime()->get_memory_impl(memory);
 	//printf("FIND_ENABLED(2) " IDFMT " %d %d %d\n", memory.id, offset, first_element, count);
@@ -1026,15 +1592,8 @@ namespace Realm {
 	start = first_enabled_elmt - first_element;
       if(raw_data != 0) {
 	ElementMaskImpl *impl = (ElementMaskImpl *)raw_data;
-	for(size_t pos = start; pos <= num_elements - count; pos++) {
-	  size_t run = 0;
-	  while(1) {
-	    uint64_t bit = ((impl->bits[pos >> 6] >> (pos & 0x3f))) & 1;
-	    if(bit != 0) break;
-	    pos++; run++;
-	    if(run >= count) return (pos - run) + first_element;
-	  }
-	}
+	coord_t pos = find_bit_run(impl->bits, num_elements, start, count, false);
+	return ((pos >= 0) ? (pos + first_element) : -1LL);
       } else {
 	assert(0);
       }
@@ -1088,12 +1647,16 @@ namespace Realm {
       size_t count = 0;
       if (raw_data != 0) {
         ElementMaskImpl *impl = (ElementMaskImpl *)raw_data;
-        size_t max_full = (num_elements >> 6);
-        bool remainder = (num_elements % 64) != 0;
-        for (size_t index = 0; index < max_full; index++)
-          count += __builtin_popcountll(impl->bits[index]);
-        if (remainder)
-          count += __builtin_popcountll(impl->bits[max_full]);
+        // all the enabled bits are between the first and last enabled
+        //  elements, so only those words need to be counted
+        if (first_enabled_elmt >= 0) {
+          size_t lo = (first_enabled_elmt - first_element) >> 6;
+          size_t hi = (num_elements + 63) >> 6;
+          if (last_enabled_elmt >= 0)
+            hi = std::min(hi, (size_t)((last_enabled_elmt - first_element) >> 6) + 1);
+          if (hi > lo)
+            count = popcount_words(impl->bits + lo, hi - lo);
+        }
         if (!enabled)
           count = num_elements - count;
       } else {
@@ -1107,11 +1670,15 @@ namespace Realm {
     {
       if (raw_data != 0) {
         ElementMaskImpl *impl = (ElementMaskImpl *)raw_data;
-        const size_t max_full = ((num_elements+63) >> 6);
-        for (size_t index = 0; index < max_full; index++) {
-          if (impl->bits[index])
-            return false;
-        }
+        if (first_enabled_elmt < 0)
+          return true;
+        size_t max_full = ((num_elements+63) >> 6);
+        if (last_enabled_elmt >= 0)
+          max_full = std::min(max_full, (size_t)((last_enabled_elmt - first_element) >> 6) + 1);
+        size_t lo = (first_enabled_elmt - first_element) >> 6;
+        if ((max_full > lo) &&
+            (find_word(impl->bits + lo, max_full - lo, 0) < (max_full - lo)))
+          return false;
       } else {
         // TODO: implement this
         assert(0);
@@ -1228,14 +1795,10 @@ namespace Realm {
 
 	// find first word that isn't 0
 	first_enabled_elmt = -1LL;
-	for(size_t i = 0; i < count; i++) {
-	  uint64_t v = impl->bits[i];
-	  if(v != 0) {
-	    coord_t ofs = __builtin_ctzl(v);
-	    first_enabled_elmt = first_element + (i << 6) + ofs;
-	    //printf("FOUNDFIRST: %lx %d %d %d\n", v, i, ofs, first_enabled_elmt);
-	    break;
-	  }
+	size_t first_word = find_word(impl->bits, count, 0);
+	if(first_word < count) {
+	  coord_t ofs = __builtin_ctzl(impl->bits[first_word]);
+	  first_enabled_elmt = first_element + (first_word << 6) + ofs;
 	}
 
 	// find last word that isn't 0 - no search if the first search failed
@@ -1305,9 +1868,12 @@ namespace Realm {
 	  }
 
 	  // whole words next
-	  while(count >= 64) {
-	    *bits++ |= (*other_bits++);
-	    count -= 64;
+	  if(count >= 64) {
+	    size_t words = count >> 6;
+	    or_words(bits, other_bits, words);
+	    bits += words;
+	    other_bits += words;
+	    count -= (coord_t)(words << 6);
 	  }
 
 	  // trailing bits
@@ -1336,10 +1902,16 @@ namespace Realm {
       //  but only if the bits line up conveniently
       assert((first_element & 63) == (other.first_element & 63));
 
-      // we need to cover our entire range of bits, either and'ing with the other's mask or
-      //  clearing them out
-      coord_t abs_start = first_element;
-      coord_t abs_end = first_element + num_elements;
+      // an empty lhs stays empty
+      if(first_enabled_elmt == -1LL)
+	return *this;
+
+      // we need to cover our range of enabled bits, either and'ing with the other's mask or
+      //  clearing them out - everything outside that range is already clear
+      coord_t abs_start = first_enabled_elmt;
+      coord_t abs_end = ((last_enabled_elmt >= 0) ?
+			 (last_enabled_elmt + 1) :
+			 (first_element + (coord_t)num_elements));
 
       // no overlap case is simple
       if(abs_start >= abs_end)
@@ -1378,14 +1950,21 @@ namespace Realm {
 	    count -= 64;
 	  }
 
-	  // whole words next
+	  // whole words next - the ones outside the rhs's storage are cleared
+	  //  and the rest are and'ed in bulk
 	  while(count >= 64) {
-	    if((other_bits >= other_bits_valid_start) && (other_bits < other_bits_valid_end))
-	      *bits++ &= *other_bits;
-	    else
+	    if((other_bits >= other_bits_valid_start) && (other_bits < other_bits_valid_end)) {
+	      size_t words = std::min((size_t)(count >> 6),
+				      (size_t)(other_bits_valid_end - other_bits));
+	      and_words(bits, other_bits, words);
+	      bits += words;
+	      other_bits += words;
+	      count -= (coord_t)(words << 6);
+	    } else {
 	      *bits++ = 0;
-	    other_bits++;
-	    count -= 64;
+	      other_bits++;
+	      count -= 64;
+	    }
 	  }
 
 	  // trailing bits
@@ -1421,10 +2000,21 @@ namespace Realm {
       //  but only if the bits line up conveniently
       assert((first_element & 63) == (other.first_element & 63));
 
+      // an empty lhs stays empty
+      if(first_enabled_elmt == -1LL)
+	return *this;
+
       // determine the range of bits we're going to cover - trim to both masks
+      //  and to the enabled elements of both
       coord_t abs_start = std::max(first_element, other.first_element);
       coord_t abs_end = std::min(first_element + num_elements,
 			       other.first_element + other.num_elements);
+      abs_start = std::max(abs_start, std::max(first_enabled_elmt,
+					       other.first_enabled_elmt));
+      if(last_enabled_elmt >= 0)
+	abs_end = std::min(abs_end, last_enabled_elmt + 1);
+      if(other.last_enabled_elmt >= 0)
+	abs_end = std::min(abs_end, other.last_enabled_elmt + 1);
       // no overlap case is simple
       if(abs_start >= abs_end)
 	return *this;
@@ -1453,9 +2043,12 @@ namespace Realm {
 	  }
 
 	  // whole words next
-	  while(count >= 64) {
-	    *bits++ &= ~(*other_bits++);
-	    count -= 64;
+	  if(count >= 64) {
+	    size_t words = count >> 6;
+	    andnot_words(bits, other_bits, words);
+	    bits += words;
+	    other_bits += words;
+	    count -= (coord_t)(words << 6);
 	  }
 
 	  // trailing bits
@@ -2028,6 +2621,19 @@ namespace Realm {
     return complete_event;
   }
 
+  Event IndexSpaceImpl::fetch_valid_mask(void)
+  {
+    if(valid_mask_complete)
+      return Event::NO_EVENT;
+
+    Event complete = GenEventImpl::create_genevent()->current_event();
+    FetchISMaskWaiter *waiter = new FetchISMaskWaiter(complete, me);
+    // if the waiter had to sleep, it is deleted once it's done
+    if(waiter->fetch_is_mask())
+      delete waiter;
+    return complete;
+  }
+
   /*static*/ void ValidMaskFetchMessage::handle_request(RequestArgs args)
   {
     FetchISMaskWaiter* waiter = new FetchISMaskWaiter(args.complete, args.is);
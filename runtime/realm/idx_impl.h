@@ -62,6 +62,10 @@ namespace Realm {
 
       Event request_valid_mask(void);
 
+      // like request_valid_mask, but also fetches the index space's metadata
+      //  first if necessary, and never blocks
+      Event fetch_valid_mask(void);
+
       IndexSpace me;
       ReservationImpl lock;
       IndexSpaceImpl *next_free;
@@ -132,6 +132,7 @@ namespace Realm {
     class IndexSpaceAllocator;
     class DomainPoint;
     class Domain;
+    struct InstanceCreationRequest;
 
     class IndexSpace {
     public:
@@ -243,6 +244,17 @@ namespace Realm {
 					 std::map<IndexSpace, IndexSpace>& subspaces,
 					 bool mutable_results,
 					 Event wait_on = Event::NO_EVENT) const;
+      // incremental version of create_subspaces_by_field - 'previous' holds the
+      //  subspaces from an earlier partitioning of this index space by the same
+      //  field and 'changed' must contain every element whose field value might
+      //  be different now: only the changed elements are read, and all others
+      //  keep their previous color (colors missing from 'previous' start empty)
+      Event update_subspaces_by_field(const std::vector<FieldDataDescriptor>& field_data,
+				      const ElementMask& changed,
+				      const std::map<DomainPoint, IndexSpace>& previous,
+				      std::map<DomainPoint, IndexSpace>& subspaces,
+				      bool mutable_results,
+				      Event wait_on = Event::NO_EVENT) const;
       // Variants of the above but with profiling information
       Event create_equal_subspaces(size_t count, size_t granularity,
 				   std::vector<IndexSpace>& subspaces,
@@ -281,6 +293,13 @@ namespace Realm {
                                          const ProfilingRequestSet &reqs,
 					 bool mutable_results,
 					 Event wait_on = Event::NO_EVENT) const;
+      Event update_subspaces_by_field(const std::vector<FieldDataDescriptor>& field_data,
+				      const ElementMask& changed,
+				      const std::map<DomainPoint, IndexSpace>& previous,
+				      std::map<DomainPoint, IndexSpace>& subspaces,
+                                      const ProfilingRequestSet &reqs,
+				      bool mutable_results,
+				      Event wait_on = Event::NO_EVENT) const;
     };
     struct IndexSpace::BinaryOpDescriptor {
       IndexSpaceOperation op;
@@ -1044,6 +1063,131 @@ namespace Realm {
 	DomainPointIterator& operator++(int /*i am postfix*/) { step(); return *this; }
       };
 
+      // visits the same points as a DomainPointIterator, but a span at a
+      //  time - a span is a run of 'count' points that differ only in
+      //  dimension 0 (the fastest-varying one, and the contiguous one in the
+      //  default layout) starting at 'p', so the innermost loop is a simple
+      //  counted loop that the compiler can vectorize
+      class DomainSpanIterator {
+      public:
+        DomainSpanIterator(const Domain& d)
+          : count(0), any_left(false), enumerator(0)
+        {
+          p.dim = d.get_dim();
+          switch(p.get_dim()) {
+          case 0: // index space
+            {
+              const ElementMask& mask = d.get_index_space().get_valid_mask();
+              enumerator = new ElementMask::Enumerator(mask, 0, 1);
+              break;
+            }
+
+          case 1:
+          case 2:
+          case 3:
+            {
+              for(int i = 0; i < p.dim; i++) {
+                lo[i] = d.rect_data[i];
+                hi[i] = d.rect_data[p.dim + i];
+                // an empty rect has no spans at all
+                if(lo[i] > hi[i])
+                  return;
+                p.point_data[i] = lo[i];
+              }
+              count = hi[0] - lo[0] + 1;
+              any_left = true;
+              return;
+            }
+
+          default:
+            assert(0);
+          }
+          step();
+        }
+
+        ~DomainSpanIterator(void)
+        {
+          delete enumerator;
+        }
+
+        DomainPoint p;
+        size_t count;
+        bool any_left;
+
+        bool step(void)
+        {
+          if(enumerator) {
+            coord_t pos;
+            any_left = enumerator->get_next(pos, count);
+            p.point_data[0] = pos;
+            return any_left;
+          }
+
+          // carry through the outer dimensions one span at a time
+          for(int i = 1; i < p.dim; i++) {
+            if(p.point_data[i] < hi[i]) {
+              p.point_data[i]++;
+              return true;
+            }
+            p.point_data[i] = lo[i];
+          }
+          any_left = false;
+          return false;
+        }
+
+        operator bool(void) const { return any_left; }
+        DomainSpanIterator& operator++(int /*i am postfix*/) { step(); return *this; }
+
+      protected:
+        coord_t lo[MAX_RECT_DIM], hi[MAX_RECT_DIM];
+        ElementMask::Enumerator *enumerator;
+
+      private:
+        // not copyable - the enumerator is owned
+        DomainSpanIterator(const DomainSpanIterator& rhs);
+        DomainSpanIterator& operator=(const DomainSpanIterator& rhs);
+      };
+
+      // splits a rect domain into at most 'max_chunks' disjoint rect domains
+      //  of (nearly) equal volume, e.g. one per OpenMP thread or thread pool
+      //  worker - the cut is made along the outermost dimension that has
+      //  enough extent so that every chunk keeps long dimension 0 spans, and
+      //  as much of the balance as possible; unstructured domains are
+      //  returned as a single chunk
+      void split_into_chunks(size_t max_chunks, std::vector<Domain>& chunks) const
+      {
+        assert(max_chunks > 0);
+        chunks.clear();
+        if((dim == 0) || (get_volume() == 0) || (max_chunks == 1)) {
+          chunks.push_back(*this);
+          return;
+        }
+
+        int split_dim = dim - 1;
+        coord_t best_extent = 0;
+        for(int i = dim - 1; i >= 0; i--) {
+          coord_t extent = rect_data[dim + i] - rect_data[i] + 1;
+          if(extent >= (coord_t)max_chunks) {
+            split_dim = i;
+            break;
+          }
+          if(extent > best_extent) {
+            split_dim = i;
+            best_extent = extent;
+          }
+        }
+
+        coord_t base = rect_data[split_dim];
+        coord_t extent = rect_data[dim + split_dim] - base + 1;
+        size_t num_chunks = ((extent < (coord_t)max_chunks) ? (size_t)extent : max_chunks);
+        for(size_t i = 0; i < num_chunks; i++) {
+          Domain chunk = *this;
+          chunk.rect_data[split_dim] = base + (extent * i) / num_chunks;
+          chunk.rect_data[dim + split_dim] = base + (extent * (i + 1)) / num_chunks - 1;
+          chunks.push_back(chunk);
+        }
+      }
+
     protected:
     public:
       IDType is_id;
@@ -1070,6 +1214,14 @@ namespace Realm {
                                      const ProfilingRequestSet &reqs,
 				     ReductionOpID redop_id = 0) const;
 
+      // asynchronous creation of a batch of instances (of any domains, in any
+      //  memories) - 'results' is filled in (with NO_INST for any request that
+      //  could not be satisfied) by the time the returned event triggers, and
+      //  must remain valid until then; requests for memories owned by the same
+      //  remote node are sent to that node in a single message
+      static Event create_instances(std::vector<RegionInstance>& results,
+				    const std::vector<InstanceCreationRequest>& requests);
+
 #ifdef REALM_USE_LEGION_LAYOUT_CONSTRAINTS
       // Note that the constraints are not const so that Realm can add
       // to the set with additional constraints describing the exact 
@@ -1080,6 +1232,20 @@ namespace Realm {
               const ProfilingRequestSet &reqs) const;
 #endif
 
+      // wraps 'bytes' of application storage at 'base' in a local memory
+      //  (e.g. system or zero-copy memory) as an instance, without copying -
+      //  the data must already be laid out as create_instance would lay out
+      //  these fields with this block size, and must stay valid until the
+      //  instance is destroyed
+      RegionInstance create_external_instance(Memory memory, void *base, size_t bytes,
+					      const std::vector<size_t> &field_sizes,
+					      size_t block_size) const;
+
+      RegionInstance create_external_instance(Memory memory, void *base, size_t bytes,
+					      const std::vector<size_t> &field_sizes,
+					      size_t block_size,
+					      const ProfilingRequestSet &reqs) const;
+
       RegionInstance create_hdf5_instance(const char *file_name,
                                           const std::vector<size_t> &field_sizes,
                                           const std::vector<const char*> &field_files,
@@ -1112,6 +1278,17 @@ namespace Realm {
 		 ReductionOpID redop_id = 0, bool red_fold = false) const;
     };
 
+    struct InstanceCreationRequest {
+      InstanceCreationRequest(void) : block_size(1), redop_id(0), reqs(0) {}
+
+      Domain domain;
+      Memory memory;
+      std::vector<size_t> field_sizes;
+      size_t block_size;
+      ReductionOpID redop_id;
+      const ProfilingRequestSet *reqs;  // optional
+    };
+
     inline std::ostream& operator<<(std::ostream& os, Domain d) 
     {
       switch(d.get_dim()) {
@@ -19,6 +19,7 @@
 #include "mem_impl.h"
 #include "logging.h"
 #include "runtime_impl.h"
+#include "realm_config.h"
 #include "logger_message_descriptor.h"
 
 namespace Realm {
@@ -64,6 +65,35 @@ namespace Realm {
       RegionInstanceImpl *impl;
     };
 
+    class DeferredInstPrefetch : public EventWaiter {
+    public:
+      DeferredInstPrefetch(RegionInstance _inst, Processor _target)
+	: inst(_inst), target(_target) { }
+      virtual ~DeferredInstPrefetch(void) { }
+    public:
+      virtual bool event_triggered(Event e, bool poisoned)
+      {
+	// a prefetch is only a hint - skip it if the data won't be used
+	if(!poisoned)
+	  inst.prefetch(target);
+        return true;
+      }
+
+      virtual void print(std::ostream& os) const
+      {
+        os << "deferred instance prefetch";
+      }
+
+      virtual Event get_finish_event(void) const
+      {
+	return Event::NO_EVENT;
+      }
+
+    protected:
+      RegionInstance inst;
+      Processor target;
+    };
+
   
   ////////////////////////////////////////////////////////////////////////
   //
@@ -96,6 +126,23 @@ namespace Realm {
       get_runtime()->get_memory_impl(i_impl->memory)->destroy_instance(*this, true);
     }
 
+    void RegionInstance::prefetch(Processor target, Event wait_on /*= Event::NO_EVENT*/) const
+    {
+      // only the owner has the instance's storage (and valid metadata)
+      if(ID(id).instance.owner_node != gasnet_mynode())
+	return;
+
+      if(!wait_on.has_triggered()) {
+	EventImpl::add_waiter(wait_on, new DeferredInstPrefetch(*this, target));
+	return;
+      }
+
+      RegionInstanceImpl *i_impl = get_runtime()->get_instance_impl(*this);
+      get_runtime()->get_memory_impl(i_impl->memory)->prefetch(i_impl->metadata.alloc_offset,
+							       i_impl->metadata.size,
+							       target);
+    }
+
     void RegionInstance::destroy(const std::vector<DestroyedField>& destroyed_fields,
 				 Event wait_on /*= Event::NO_EVENT*/) const
     {
@@ -139,7 +186,7 @@ namespace Realm {
 					   const ProfilingRequestSet &reqs,
 					   off_t _count_offset /*= 0*/, off_t _red_list_size /*= 0*/,
 					   RegionInstance _parent_inst /*= NO_INST*/)
-      : me(_me), memory(_memory)
+      : me(_me), memory(_memory), external(false)
     {
       metadata.linearization = _linear;
 
@@ -179,7 +226,7 @@ namespace Realm {
 
     // when we auto-create a remote instance, we don't know region/offset
     RegionInstanceImpl::RegionInstanceImpl(RegionInstance _me, Memory _memory)
-      : me(_me), memory(_memory)
+      : me(_me), memory(_memory), external(false)
     {
       lock.init(ID(me).convert<Reservation>(), ID(me).instance.owner_node);
       lock.in_use = true;
@@ -212,6 +259,15 @@ namespace Realm {
       assert(0);
     }
 
+    void RegionInstanceImpl::push_metadata(gasnet_node_t target)
+    {
+      gasnet_node_t owner = ID(me).instance.owner_node;
+      if(!Config::metadata_push || (target == owner))
+	return;
+
+      MetadataRequestMessage::send_push(owner, me.id, target);
+    }
+
     void RegionInstanceImpl::record_instance_usage(void)
     {
       // can't do this in the constructor because our ID isn't right yet...
@@ -64,6 +64,9 @@ namespace Realm {
 
       Event request_metadata(void) { return metadata.request_data(ID(me).instance.owner_node, me.id); }
 
+      // gets the metadata to 'target' ahead of an operation that will need it there
+      void push_metadata(gasnet_node_t target);
+
       void record_instance_usage(void);
       void finalize_instance(void);
 
@@ -96,6 +99,9 @@ namespace Realm {
 
       Metadata metadata;
 
+      // storage is owned by the application (only known on the owner node)
+      bool external;
+
       static const unsigned MAX_LINEARIZATION_LEN = 32;
 
       ReservationImpl lock;
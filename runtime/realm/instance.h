@@ -22,6 +22,7 @@
 
 #include "event.h"
 #include "memory.h"
+#include "processor.h"
 
 #include "accessor.h"
 #include "custom_serdez.h"
@@ -61,6 +62,11 @@ namespace Realm {
 
       AddressSpace address_space(void) const;
 
+      // a hint that 'target' will use this instance once 'wait_on' has
+      //  triggered - memories whose contents migrate on demand (e.g. GPU
+      //  managed memory) start moving the data then, others ignore it
+      void prefetch(Processor target, Event wait_on = Event::NO_EVENT) const;
+
       LegionRuntime::Accessor::RegionAccessor<LegionRuntime::Accessor::AccessorType::Generic> get_accessor(void) const;
 
       void report_instance_fault(int reason,
@@ -18,6 +18,13 @@
 #include "realm/logging.h"
 
 #include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 // xcode's clang isn't defining these?
 #define __STDC_LIMIT_MACROS
@@ -43,6 +50,9 @@
 #include "llvm/Support/raw_os_ostream.h"
 #include "llvm/Support/FormattedStream.h"
 #include "llvm/PassManager.h"
+#include "llvm/ExecutionEngine/ObjectCache.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Config/llvm-config.h"
 
 #ifdef DEBUG_MEMORY_MANAGEMENT
 #include "llvm/ExecutionEngine/SectionMemoryManager.h"
@@ -93,11 +103,108 @@ namespace Realm {
     };
 #endif
 
+    ////////////////////////////////////////////////////////////////////////
+    //
+    // class DiskObjectCache
+
+    // MCJIT asks this before compiling a module and tells it about every
+    //  object it does compile - modules are named by their cache key (see
+    //  llvmir_to_fnptr), so the key is all we need to find the file
+    class DiskObjectCache : public llvm::ObjectCache {
+    public:
+      DiskObjectCache(const std::string& _dir);
+      virtual ~DiskObjectCache(void);
+
+      virtual void notifyObjectCompiled(const llvm::Module *m,
+					const llvm::MemoryBuffer *obj);
+      virtual llvm::MemoryBuffer *getObject(const llvm::Module *m);
+
+    protected:
+      std::string object_filename(const llvm::Module *m) const;
+
+      std::string dir;
+    };
+
+    DiskObjectCache::DiskObjectCache(const std::string& _dir)
+      : dir(_dir)
+    {}
+
+    DiskObjectCache::~DiskObjectCache(void)
+    {}
+
+    std::string DiskObjectCache::object_filename(const llvm::Module *m) const
+    {
+      return dir + "/" + m->getModuleIdentifier() + ".o";
+    }
+
+    void DiskObjectCache::notifyObjectCompiled(const llvm::Module *m,
+					       const llvm::MemoryBuffer *obj)
+    {
+      // write to a private temporary and rename it into place, so that
+      //  concurrent writers (e.g. other nodes sharing the directory) and
+      //  readers never see a partial file
+      std::string filename = object_filename(m);
+      std::ostringstream tmpname;
+      tmpname << filename << ".tmp." << gethostid() << "." << getpid();
+      FILE *f = fopen(tmpname.str().c_str(), "wb");
+      if(!f) {
+	log_llvmjit.warning() << "could not write JIT cache file " << tmpname.str() << ": " << strerror(errno);
+	return;
+      }
+      size_t size = obj->getBufferSize();
+      bool ok = (fwrite(obj->getBufferStart(), 1, size, f) == size);
+      ok = (fclose(f) == 0) && ok;
+      if(ok && (rename(tmpname.str().c_str(), filename.c_str()) == 0)) {
+	log_llvmjit.info() << "cached compiled object " << filename << " (" << size << " bytes)";
+      } else {
+	log_llvmjit.warning() << "could not write JIT cache file " << filename;
+	unlink(tmpname.str().c_str());
+      }
+    }
+
+    llvm::MemoryBuffer *DiskObjectCache::getObject(const llvm::Module *m)
+    {
+      std::string filename = object_filename(m);
+      FILE *f = fopen(filename.c_str(), "rb");
+      if(!f) {
+	log_llvmjit.debug() << "JIT cache miss: " << filename;
+	return 0;
+      }
+      std::string contents;
+      char buffer[65536];
+      size_t amt;
+      while((amt = fread(buffer, 1, sizeof(buffer), f)) > 0)
+	contents.append(buffer, amt);
+      bool ok = !ferror(f);
+      fclose(f);
+      if(!ok || contents.empty()) {
+	log_llvmjit.warning() << "could not read JIT cache file " << filename << " - recompiling";
+	return 0;
+      }
+      log_llvmjit.info() << "JIT cache hit: " << filename << " (" << contents.size() << " bytes)";
+      // caller takes ownership of the copy
+      return llvm::MemoryBuffer::getMemBufferCopy(contents, m->getModuleIdentifier());
+    }
+
+    // FNV-1a, which is plenty for telling IR blobs apart when two
+    //  differently-seeded copies are combined into a 128-bit key
+    static uint64_t fnv1a_hash(const void *data, size_t len, uint64_t hash)
+    {
+      const unsigned char *p = (const unsigned char *)data;
+      for(size_t i = 0; i < len; i++) {
+	hash ^= p[i];
+	hash *= 0x100000001b3ULL;
+      }
+      return hash;
+    }
+
+
     ////////////////////////////////////////////////////////////////////////
     //
     // class LLVMJitInternal
 
-    LLVMJitInternal::LLVMJitInternal(void)
+    LLVMJitInternal::LLVMJitInternal(const std::string& cache_dir)
+      : object_cache(0)
     {
       context = new llvm::LLVMContext;
 
@@ -123,14 +230,43 @@ namespace Realm {
 	llvm::TargetOptions options;
 	options.NoFramePointerElim = true;
 
-	llvm::TargetMachine *host_cpu_machine = target->createTargetMachine(triple, "", 
-									    0/*HostHasAVX()*/ ? "+avx" : "", 
+	std::string cpu = "";
+	std::string features = 0/*HostHasAVX()*/ ? "+avx" : "";
+
+	llvm::TargetMachine *host_cpu_machine = target->createTargetMachine(triple, cpu,
+									    features,
 									    options,
 									    reloc_model,
 									    code_model,
 									    opt_level);
 	assert(host_cpu_machine != 0);
 
+	// everything that changes the generated code goes in the cache key -
+	//  the host cpu/features are included even though we target a generic
+	//  cpu, so that objects are never shared between unlike machines
+	{
+	  std::ostringstream oss;
+	  oss << "llvm" << LLVM_VERSION_MAJOR << "." << LLVM_VERSION_MINOR
+	      << "|" << triple << "|" << cpu << "|" << features
+	      << "|" << reloc_model << "|" << code_model << "|" << opt_level
+	      << "|" << llvm::sys::getHostCPUName().str();
+	  llvm::StringMap<bool> host_features;
+	  if(llvm::sys::getHostCPUFeatures(host_features)) {
+	    // StringMap iteration order is unspecified
+	    std::map<std::string, bool> sorted;
+	    for(llvm::StringMap<bool>::const_iterator it = host_features.begin();
+		it != host_features.end();
+		++it)
+	      sorted[it->getKey().str()] = it->getValue();
+	    for(std::map<std::string, bool>::const_iterator it = sorted.begin();
+		it != sorted.end();
+		++it)
+	      oss << (it->second ? "+" : "-") << it->first;
+	  }
+	  target_key = oss.str();
+	  log_llvmjit.debug() << "JIT cache target key = " << target_key;
+	}
+
 	// you have to have a module to build an execution engine, so create
 	//  a dummy one
 	{
@@ -157,6 +293,16 @@ namespace Realm {
 	    assert(0);
 	  }
 	}
+
+	if(!cache_dir.empty()) {
+	  if((mkdir(cache_dir.c_str(), 0777) == 0) || (errno == EEXIST)) {
+	    object_cache = new DiskObjectCache(cache_dir);
+	    host_exec_engine->setObjectCache(object_cache);
+	    log_llvmjit.info() << "JIT object cache enabled: " << cache_dir;
+	  } else {
+	    log_llvmjit.warning() << "cannot create JIT cache directory " << cache_dir << ": " << strerror(errno) << " - caching disabled";
+	  }
+	}
       }
 
       nvptx_machine = 0;
@@ -165,9 +311,26 @@ namespace Realm {
     LLVMJitInternal::~LLVMJitInternal(void)
     {
       delete host_exec_engine;
+      delete object_cache;
       delete context;
     }
 
+    std::string LLVMJitInternal::compute_cache_key(const ByteArray& ir) const
+    {
+      uint64_t h1 = fnv1a_hash(target_key.data(), target_key.size(),
+			       0xcbf29ce484222325ULL);
+      h1 = fnv1a_hash(ir.base(), ir.size(), h1);
+      uint64_t h2 = fnv1a_hash(target_key.data(), target_key.size(),
+			       0x84222325cbf29ce4ULL);
+      h2 = fnv1a_hash(ir.base(), ir.size(), h2);
+
+      std::ostringstream oss;
+      oss << std::hex << std::setfill('0')
+	  << std::setw(16) << h1 << std::setw(16) << h2
+	  << std::dec << "-" << ir.size();
+      return oss.str();
+    }
+
     void *LLVMJitInternal::llvmir_to_fnptr(const ByteArray& ir,
 					   const std::string& entry_symbol)
     {
@@ -175,6 +338,15 @@ namespace Realm {
       if(!host_exec_engine)
 	return 0;
 
+      // identical IR that we've already jitted can't give a different answer
+      std::string cache_key = compute_cache_key(ir);
+      std::pair<std::string, std::string> jit_key(cache_key, entry_symbol);
+      std::map<std::pair<std::string, std::string>, void *>::const_iterator it = jitted_functions.find(jit_key);
+      if(it != jitted_functions.end()) {
+	log_llvmjit.debug() << "reusing jitted function: " << entry_symbol << " (" << cache_key << ")";
+	return it->second;
+      }
+
       llvm::SMDiagnostic sm;
       // LLVM requires that the data be null-terminated (even for bitcode?)
       //  so make a copy and add one extra byte
@@ -199,6 +371,9 @@ namespace Realm {
 	assert(0);
       }
 
+      // the object cache (if any) finds compiled code by module name
+      m->setModuleIdentifier(cache_key);
+
       host_exec_engine->addModule(m);
 
       // this actually triggers the JIT, allocating space for code and data
@@ -211,6 +386,7 @@ namespace Realm {
       // hopefully it's ok to delete the IR source buffer now...
       delete[] nullterm;
 
+      jitted_functions[jit_key] = fnptr;
       return fnptr;
     }
 
@@ -18,12 +18,16 @@
 
 #include "realm/bytearray.h"
 
+#include <map>
+#include <string>
+
 // instead of including LLVM headers here, we just forward-declare the things that need to
 //  appear inside an LLVMJitInternal
 namespace llvm {
   class LLVMContext;
   class TargetMachine;
   class ExecutionEngine;
+  class ObjectCache;
 };
 
 namespace Realm {
@@ -31,15 +35,26 @@ namespace Realm {
 
     class LLVMJitInternal {
     public:
-      LLVMJitInternal(void);
+      // if 'cache_dir' is non-empty, compiled objects are kept there (keyed
+      //  on the IR contents and the target) and reused by later runs - a
+      //  directory on a shared filesystem lets nodes reuse each other's
+      LLVMJitInternal(const std::string& cache_dir);
       ~LLVMJitInternal(void);
 
       void *llvmir_to_fnptr(const ByteArray& ir, const std::string& entry_symbol);
 
     protected:
+      // content hash of 'ir' combined with everything about the target
+      //  that affects the generated code
+      std::string compute_cache_key(const ByteArray& ir) const;
+
       llvm::LLVMContext *context;
       llvm::ExecutionEngine *host_exec_engine;
       llvm::TargetMachine *nvptx_machine;
+      llvm::ObjectCache *object_cache;
+      std::string target_key;
+      // (cache key, entry symbol) -> already-jitted function
+      std::map<std::pair<std::string, std::string>, void *> jitted_functions;
     };
 
   }; // namespace LLVMJit
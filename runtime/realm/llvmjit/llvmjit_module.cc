@@ -19,6 +19,7 @@
 
 #include "realm/runtime_impl.h"
 #include "realm/logging.h"
+#include "realm/cmdline.h"
 
 namespace Realm {
 
@@ -97,6 +98,19 @@ namespace Realm {
 						    std::vector<std::string>& cmdline)
     {
       LLVMJitModule *m = new LLVMJitModule;
+
+      {
+	CommandLineParser cp;
+
+	cp.add_option_string("-llvm:cache", m->cfg_cache_dir);
+
+	bool ok = cp.parse_command_line(cmdline);
+	if(!ok) {
+	  log_llvmjit.fatal() << "error reading LLVM JIT command line parameters";
+	  assert(false);
+	}
+      }
+
       return m;
     }
 
@@ -106,7 +120,7 @@ namespace Realm {
     {
       Module::initialize(runtime);
 
-      internal = new LLVMJitInternal;
+      internal = new LLVMJitInternal(cfg_cache_dir);
     }
 
     // create any code translators provided by the module (default == do nothing)
@@ -31,6 +31,7 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <errno.h>
+#include <unistd.h>
 
 #include <set>
 #include <map>
@@ -141,6 +142,191 @@ namespace Realm {
     pthread_mutex_t mutex;
   };
 
+  // hands messages to a background thread that does the actual writes -
+  //  each thread appends to its own ring buffer without taking any locks,
+  //  so messages from one thread stay in order, and a message that doesn't
+  //  fit in a full ring is dropped (and counted) rather than blocking
+  class LoggerAsyncStream : public LoggerOutputStream {
+  public:
+    LoggerAsyncStream(LoggerOutputStream *_stream, size_t _ring_size);
+    virtual ~LoggerAsyncStream(void);
+
+    virtual void write(const char *buffer, size_t len);
+    virtual void flush(void);
+
+  protected:
+    // single producer (the owning thread), single consumer (whoever holds
+    //  the drain mutex) - 'head' and 'tail' only ever increase
+    struct Ring {
+      char *data;
+      volatile size_t head, tail;
+      volatile size_t dropped;
+      size_t dropped_reported;
+      unsigned long thread;
+    };
+
+    Ring *get_ring(void);
+    // returns the number of bytes written - caller must hold drain_mutex
+    size_t drain(void);
+    static void *writer_loop(void *arg);
+
+    LoggerOutputStream *stream;
+    size_t ring_size;
+    pthread_mutex_t drain_mutex, rings_mutex;
+    std::vector<Ring *> rings;
+    pthread_t writer;
+    volatile bool shutdown;
+    static __thread Ring *my_ring;
+    static __thread LoggerAsyncStream *my_ring_owner;
+  };
+
+  /*static*/ __thread LoggerAsyncStream::Ring *LoggerAsyncStream::my_ring = 0;
+  /*static*/ __thread LoggerAsyncStream *LoggerAsyncStream::my_ring_owner = 0;
+
+  LoggerAsyncStream::LoggerAsyncStream(LoggerOutputStream *_stream,
+				       size_t _ring_size)
+    : stream(_stream), ring_size(_ring_size), shutdown(false)
+  {
+    pthread_mutex_init(&drain_mutex, 0);
+    pthread_mutex_init(&rings_mutex, 0);
+#ifndef NDEBUG
+    int ret =
+#endif
+      pthread_create(&writer, 0, writer_loop, this);
+    assert(ret == 0);
+  }
+
+  LoggerAsyncStream::~LoggerAsyncStream(void)
+  {
+    shutdown = true;
+    pthread_join(writer, 0);
+    flush();
+    size_t total_dropped = 0;
+    for(std::vector<Ring *>::iterator it = rings.begin();
+	it != rings.end();
+	it++) {
+      total_dropped += (*it)->dropped;
+      free((*it)->data);
+      delete *it;
+    }
+    if(total_dropped > 0)
+      fprintf(stderr, "WARNING: %zd log messages were dropped because the asynchronous logging buffers were full - increase -logasync\n",
+	      total_dropped);
+    pthread_mutex_destroy(&drain_mutex);
+    pthread_mutex_destroy(&rings_mutex);
+    delete stream;
+  }
+
+  LoggerAsyncStream::Ring *LoggerAsyncStream::get_ring(void)
+  {
+    if(my_ring_owner == this)
+      return my_ring;
+
+    // first message from this thread - registration is the only time a
+    //  producer takes a lock
+    Ring *r = new Ring;
+    r->data = (char *)malloc(ring_size);
+    assert(r->data != 0);
+    r->head = r->tail = 0;
+    r->dropped = r->dropped_reported = 0;
+    r->thread = (unsigned long)pthread_self();
+    pthread_mutex_lock(&rings_mutex);
+    rings.push_back(r);
+    pthread_mutex_unlock(&rings_mutex);
+    my_ring = r;
+    my_ring_owner = this;
+    return r;
+  }
+
+  void LoggerAsyncStream::write(const char *buffer, size_t len)
+  {
+    Ring *r = get_ring();
+    size_t head = r->head;
+    size_t tail = r->tail;
+    if((head - tail + len) > ring_size) {
+      // the increment is only ever done by this thread
+      r->dropped = r->dropped + 1;
+      return;
+    }
+    size_t ofs = head % ring_size;
+    size_t first = ring_size - ofs;
+    if(first >= len)
+      memcpy(r->data + ofs, buffer, len);
+    else {
+      memcpy(r->data + ofs, buffer, first);
+      memcpy(r->data, buffer + first, len - first);
+    }
+    // the data must be visible before the writer sees the new head
+    __sync_synchronize();
+    r->head = head + len;
+  }
+
+  size_t LoggerAsyncStream::drain(void)
+  {
+    pthread_mutex_lock(&rings_mutex);
+    std::vector<Ring *> to_drain(rings);
+    pthread_mutex_unlock(&rings_mutex);
+
+    size_t total = 0;
+    for(std::vector<Ring *>::iterator it = to_drain.begin();
+	it != to_drain.end();
+	it++) {
+      Ring *r = *it;
+      size_t dropped = r->dropped;
+      size_t head = r->head;
+      __sync_synchronize();
+      size_t tail = r->tail;
+      // report drops before the messages that made it in after them
+      if(dropped != r->dropped_reported) {
+	char msg[128];
+	int len = snprintf(msg, sizeof(msg),
+			   "[%d - %lx] {%d}{logger}: %zd messages dropped\n",
+			   gasnet_mynode(), r->thread, Logger::LEVEL_WARNING,
+			   dropped - r->dropped_reported);
+	stream->write(msg, len);
+	r->dropped_reported = dropped;
+      }
+      if(head == tail)
+	continue;
+      size_t ofs = tail % ring_size;
+      size_t len = head - tail;
+      size_t first = ring_size - ofs;
+      if(first >= len)
+	stream->write(r->data + ofs, len);
+      else {
+	stream->write(r->data + ofs, first);
+	stream->write(r->data, len - first);
+      }
+      // finish reading before the producer may overwrite the space
+      __sync_synchronize();
+      r->tail = head;
+      total += len;
+    }
+    return total;
+  }
+
+  /*static*/ void *LoggerAsyncStream::writer_loop(void *arg)
+  {
+    LoggerAsyncStream *s = (LoggerAsyncStream *)arg;
+    while(!s->shutdown) {
+      pthread_mutex_lock(&s->drain_mutex);
+      size_t amt = s->drain();
+      pthread_mutex_unlock(&s->drain_mutex);
+      // poll instead of having producers signal us, which would need a lock
+      if(amt == 0)
+	usleep(1000);
+    }
+    return 0;
+  }
+
+  void LoggerAsyncStream::flush(void)
+  {
+    pthread_mutex_lock(&drain_mutex);
+    drain();
+    stream->flush();
+    pthread_mutex_unlock(&drain_mutex);
+  }
+
   class LoggerConfig {
   protected:
     LoggerConfig(void);
@@ -166,6 +352,7 @@ namespace Realm {
     std::string cats_enabled;
     std::set<Logger *> pending_configs;
     LoggerOutputStream *stream, *stderr_stream;
+    size_t async_ring_kb;
   };
 
   LoggerConfig::LoggerConfig(void)
@@ -174,6 +361,7 @@ namespace Realm {
     , stderr_level(Logger::LEVEL_ERROR)
     , stream(0)
     , stderr_stream(0)
+    , async_ring_kb(0)
   {}
 
   LoggerConfig::~LoggerConfig(void)
@@ -299,6 +487,7 @@ namespace Realm {
       .add_option_string("-logfile", logname)
       .add_option_method("-level", this, &LoggerConfig::parse_level_argument)
       .add_option_int("-errlevel", stderr_level)
+      .add_option_int("-logasync", async_ring_kb)
       .parse_command_line(cmdline);
 
     if(!ok) {
@@ -353,10 +542,16 @@ namespace Realm {
 	  exit(1);
 	}
       }
-      // TODO: consider buffering in some cases?
-      setbuf(f, 0); // disable output buffering
-      stream = new LoggerStreamSerialized<LoggerFileStream>(new LoggerFileStream(f, true),
-							    true);
+      if(async_ring_kb > 0) {
+	// only the background writer touches the file, so no mutex is needed,
+	//  and it writes large batches, so let stdio buffer them
+	stream = new LoggerAsyncStream(new LoggerFileStream(f, true),
+				       async_ring_kb << 10);
+      } else {
+	setbuf(f, 0); // disable output buffering
+	stream = new LoggerStreamSerialized<LoggerFileStream>(new LoggerFileStream(f, true),
+							      true);
+      }
 
       // when logging to a file, also sent critical-enough messages to stderr
       if(stderr_level < Logger::LEVEL_NONE)
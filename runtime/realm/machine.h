@@ -52,6 +52,12 @@ namespace Realm {
       bool has_affinity(Processor p, Memory m, AffinityDetails *details = 0) const;
       bool has_affinity(Memory m1, Memory m2, AffinityDetails *details = 0) const;
 
+      // estimated time (in microseconds) for a copy of 'bytes' bytes from
+      //  'src' to 'dst', summed over the hops of the path the DMA system
+      //  would use - returns false if there is no path between them
+      bool estimate_copy_time(Memory src, Memory dst, size_t bytes,
+                              double& usecs) const;
+
       // older queries, to be deprecated
 
       void get_all_memories(std::set<Memory>& mset) const;
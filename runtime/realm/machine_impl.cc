@@ -21,12 +21,30 @@
 #include "runtime_impl.h"
 
 #include "activemsg.h"
+#include <realm/transfer/lowlevel_dma.h>
+
+#include <algorithm>
 
 namespace Realm {
 
   Logger log_machine("machine");
   Logger log_annc("announce");
 
+  namespace Config {
+    int announce_tree_radix = 8;
+    int machine_query_cache_size = 1024;
+  };
+
+  // tags identifying predicates in query cache keys
+  enum {
+    QUERY_KEY_PROC_HAS_AFFINITY = 1,
+    QUERY_KEY_PROC_BEST_AFFINITY,
+    QUERY_KEY_MEM_HAS_PROC_AFFINITY,
+    QUERY_KEY_MEM_HAS_MEM_AFFINITY,
+    QUERY_KEY_MEM_BEST_PROC_AFFINITY,
+    QUERY_KEY_MEM_BEST_MEM_AFFINITY,
+  };
+
   template <typename KT, typename VT>
   inline void delete_map_contents(std::map<KT,VT *>& m)
   {
@@ -319,6 +337,12 @@ namespace Realm {
       return ((MachineImpl *)impl)->has_affinity(m1, m2, details);
     }
 
+    bool Machine::estimate_copy_time(Memory src, Memory dst, size_t bytes,
+                                     double& usecs) const
+    {
+      return LegionRuntime::LowLevel::estimate_copy_time(src, dst, bytes, usecs);
+    }
+
     int Machine::get_proc_mem_affinity(std::vector<Machine::ProcessorMemoryAffinity>& result,
 				       Processor restrict_proc /*= Processor::NO_PROC*/,
 				       Memory restrict_memory /*= Memory::NO_MEMORY*/,
@@ -346,6 +370,68 @@ namespace Realm {
     }
 
 
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class MachineQueryCache<T>
+  //
+
+  template <typename T>
+  MachineQueryCache<T>::MachineQueryCache(void)
+    : generation(0)
+  {}
+
+  template <typename T>
+  MachineQueryCache<T>::~MachineQueryCache(void)
+  {
+    invalidate();
+    for(typename std::vector<std::vector<T> *>::iterator it = retired.begin();
+	it != retired.end();
+	it++)
+      delete *it;
+  }
+
+  template <typename T>
+  const std::vector<T> *MachineQueryCache<T>::lookup(const std::vector<size_t>& key,
+						     unsigned& _generation)
+  {
+    AutoHSLLock al(mutex);
+    _generation = generation;
+    typename std::map<std::vector<size_t>, std::vector<T> *>::const_iterator it = entries.find(key);
+    return ((it != entries.end()) ? it->second : 0);
+  }
+
+  template <typename T>
+  const std::vector<T> *MachineQueryCache<T>::insert(const std::vector<size_t>& key,
+						     unsigned _generation,
+						     const std::vector<T>& matches)
+  {
+    AutoHSLLock al(mutex);
+    if(_generation != generation)
+      return 0;
+    // somebody else may have beaten us to it
+    typename std::map<std::vector<size_t>, std::vector<T> *>::const_iterator it = entries.find(key);
+    if(it != entries.end())
+      return it->second;
+    if(entries.size() >= (size_t)Config::machine_query_cache_size)
+      return 0;
+    std::vector<T> *v = new std::vector<T>(matches);
+    entries[key] = v;
+    return v;
+  }
+
+  template <typename T>
+  void MachineQueryCache<T>::invalidate(void)
+  {
+    AutoHSLLock al(mutex);
+    generation++;
+    for(typename std::map<std::vector<size_t>, std::vector<T> *>::iterator it = entries.begin();
+	it != entries.end();
+	it++)
+      retired.push_back(it->second);
+    entries.clear();
+  }
+
+
   ////////////////////////////////////////////////////////////////////////
   //
   // class MachineImpl
@@ -378,6 +464,7 @@ namespace Realm {
       // these can be the source of a RemoteWrite, but it's non-ideal
     case Memory::SYSTEM_MEM:
     case Memory::Z_COPY_MEM:
+    case Memory::GPU_MANAGED_MEM:
       {
 	send_ok = true;
 	recv_ok = true;
@@ -441,6 +528,28 @@ namespace Realm {
 	  }
 	  break;
 
+	case NODE_ANNOUNCE_PROC_RANGE:
+	  {
+	    ID first((ID::IDType)*cur++);
+	    unsigned count = (unsigned)(*cur++);
+	    Processor::Kind kind = (Processor::Kind)(*cur++);
+            int num_cores = (int)(*cur++);
+	    assert((first.proc.proc_idx + count) <= num_procs);
+            log_annc.debug() << "adding procs " << first.convert<Processor>()
+			     << " + " << count << " (kind = " << kind <<
+                                " num_cores = " << num_cores << ")";
+	    if(remote) {
+	      for(unsigned i = 0; i < count; i++) {
+		ID id = ID::make_processor(first.proc.owner_node,
+					   first.proc.proc_idx + i);
+		RemoteProcessor *proc = new RemoteProcessor(id.convert<Processor>(),
+							    kind, num_cores);
+		get_runtime()->nodes[id.proc.owner_node].processors[id.proc.proc_idx] = proc;
+	      }
+	    }
+	  }
+	  break;
+
 	case NODE_ANNOUNCE_MEM:
 	  {
 	    ID id((ID::IDType)*cur++);
@@ -542,6 +651,26 @@ namespace Realm {
 	  }
 	  break;
 
+	case NODE_ANNOUNCE_PMA_RANGE:
+	  {
+	    ID first((ID::IDType)*cur++);
+	    unsigned count = (unsigned)(*cur++);
+	    Machine::ProcessorMemoryAffinity pma;
+	    pma.m = ID((ID::IDType)*cur++).convert<Memory>();
+	    pma.bandwidth = *cur++;
+	    pma.latency = *cur++;
+	    log_annc.debug() << "adding affinity " << first.convert<Processor>()
+			     << " + " << count << " -> " << pma.m
+			     << " (bw = " << pma.bandwidth << ", latency = " << pma.latency << ")";
+
+	    for(unsigned i = 0; i < count; i++) {
+	      pma.p = ID::make_processor(first.proc.owner_node,
+					 first.proc.proc_idx + i).convert<Processor>();
+	      add_proc_mem_affinity(pma, true /*lock held*/);
+	    }
+	  }
+	  break;
+
 	case NODE_ANNOUNCE_MMA:
 	  {
 	    Machine::MemoryMemoryAffinity mma;
@@ -996,6 +1125,8 @@ namespace Realm {
     if(!lock_held) mutex.lock();
 
     proc_mem_affinities.push_back(pma);
+    proc_query_cache.invalidate();
+    mem_query_cache.invalidate();
 
     int np = ID(pma.p).proc.owner_node;
     int mp = ID(pma.m).memory.owner_node;
@@ -1023,6 +1154,8 @@ namespace Realm {
     if(!lock_held) mutex.lock();
 
     mem_mem_affinities.push_back(mma);
+    proc_query_cache.invalidate();
+    mem_query_cache.invalidate();
 
     int m1p = ID(mma.m1).memory.owner_node;
     int m2p = ID(mma.m2).memory.owner_node;
@@ -1289,6 +1422,15 @@ namespace Realm {
     return new ProcessorHasAffinityPredicate(memory, min_bandwidth, max_latency);
   }
 
+  bool ProcessorHasAffinityPredicate::append_cache_key(std::vector<size_t>& key) const
+  {
+    key.push_back(QUERY_KEY_PROC_HAS_AFFINITY);
+    key.push_back(memory.id);
+    key.push_back(min_bandwidth);
+    key.push_back(max_latency);
+    return true;
+  }
+
   bool ProcessorHasAffinityPredicate::matches_predicate(MachineImpl *machine, Processor thing,
 							const MachineProcInfo *info) const
   {
@@ -1327,6 +1469,15 @@ namespace Realm {
     return new ProcessorBestAffinityPredicate(memory, bandwidth_weight, latency_weight);
   }
 
+  bool ProcessorBestAffinityPredicate::append_cache_key(std::vector<size_t>& key) const
+  {
+    key.push_back(QUERY_KEY_PROC_BEST_AFFINITY);
+    key.push_back(memory.id);
+    key.push_back((size_t)bandwidth_weight);
+    key.push_back((size_t)latency_weight);
+    return true;
+  }
+
   bool ProcessorBestAffinityPredicate::matches_predicate(MachineImpl *machine, Processor thing,
 							 const MachineProcInfo *info) const
   {
@@ -1366,6 +1517,8 @@ namespace Realm {
     , machine((MachineImpl *)_machine.impl)
     , is_restricted_node(false)
     , is_restricted_kind(false)
+    , matches(0)
+    , matches_generation(0)
   {}
      
   ProcessorQueryImpl::ProcessorQueryImpl(const ProcessorQueryImpl& copy_from)
@@ -1375,6 +1528,8 @@ namespace Realm {
     , restricted_node_id(copy_from.restricted_node_id)
     , is_restricted_kind(copy_from.is_restricted_kind)
     , restricted_kind(copy_from.restricted_kind)
+    , matches(0)
+    , matches_generation(0)
   {
     predicates.reserve(copy_from.predicates.size());
     for(std::vector<ProcQueryPredicate *>::const_iterator it = copy_from.predicates.begin();
@@ -1419,6 +1574,7 @@ namespace Realm {
 
   void ProcessorQueryImpl::restrict_to_node(int new_node_id)
   {
+    matches = 0;
     // attempts to restrict to two different nodes results in no possible match
     if(is_restricted_node && (new_node_id != restricted_node_id)) {
       restricted_node_id = -1;
@@ -1430,6 +1586,7 @@ namespace Realm {
 
   void ProcessorQueryImpl::restrict_to_kind(Processor::Kind new_kind)
   {
+    matches = 0;
     // attempts to restrict to two different kind results in no possible match
     // (use node restriction to enforce this)
     if(is_restricted_kind && (new_kind != restricted_kind)) {
@@ -1444,6 +1601,7 @@ namespace Realm {
   void ProcessorQueryImpl::add_predicate(ProcQueryPredicate *pred)
   {
     // a writer is always unique, so no need for mutexes
+    matches = 0;
     predicates.push_back(pred);
   }
 
@@ -1474,6 +1632,10 @@ namespace Realm {
     }
     return lowest;
 #else
+    const std::vector<Processor> *found = cached_matches();
+    if(found)
+      return (found->empty() ? Processor::NO_PROC : (*found)[0]);
+
     std::map<int, MachineNodeInfo *>::const_iterator it;
     if(is_restricted_node)
       it = machine->nodeinfos.lower_bound(restricted_node_id);
@@ -1545,6 +1707,14 @@ namespace Realm {
     }
     return lowest;
 #else
+    const std::vector<Processor> *found = cached_matches();
+    if(found) {
+      std::vector<Processor>::const_iterator it = std::upper_bound(found->begin(),
+							     found->end(),
+							     after);
+      return ((it != found->end()) ? *it : Processor::NO_PROC);
+    }
+
     std::map<int, MachineNodeInfo *>::const_iterator it;
     // start where we left off
     it = machine->nodeinfos.find(ID(after).proc.owner_node);
@@ -1617,6 +1787,10 @@ namespace Realm {
     }
     return pset.size();
 #else
+    const std::vector<Processor> *found = cached_matches();
+    if(found)
+      return found->size();
+
     size_t count = 0;
     std::map<int, MachineNodeInfo *>::const_iterator it;
     if(is_restricted_node)
@@ -1690,6 +1864,10 @@ namespace Realm {
       }
     }
 #else
+    const std::vector<Processor> *found = cached_matches();
+    if(found)
+      return (found->empty() ? Processor::NO_PROC : (*found)[lrand48() % found->size()]);
+
     size_t count = 0;
     std::map<int, MachineNodeInfo *>::const_iterator it;
     if(is_restricted_node)
@@ -1737,6 +1915,83 @@ namespace Realm {
   }
 
 
+  const std::vector<Processor> *ProcessorQueryImpl::cached_matches(void) const
+  {
+    // reuse what we found last time if the machine hasn't changed since
+    if(matches && (matches_generation == machine->proc_query_cache.generation))
+      return matches;
+
+    if(Config::machine_query_cache_size <= 0)
+      return 0;
+
+    std::vector<size_t> key;
+    key.push_back(is_restricted_node);
+    key.push_back(is_restricted_node ? restricted_node_id : 0);
+    key.push_back(is_restricted_kind);
+    key.push_back(is_restricted_kind ? restricted_kind : 0);
+    for(std::vector<ProcQueryPredicate *>::const_iterator it = predicates.begin();
+	it != predicates.end();
+	it++)
+      if(!(*it)->append_cache_key(key))
+	return 0;
+
+    unsigned generation;
+    const std::vector<Processor> *found = machine->proc_query_cache.lookup(key, generation);
+    if(!found) {
+      std::vector<Processor> scanned;
+      scan_matches(scanned);
+      found = machine->proc_query_cache.insert(key, generation, scanned);
+      if(!found)
+	return 0;
+    }
+
+    matches = found;
+    matches_generation = generation;
+    return found;
+  }
+
+  // the matches come out sorted because both the nodes and the processors
+  //  within each node are visited in ID order
+  void ProcessorQueryImpl::scan_matches(std::vector<Processor>& found) const
+  {
+    std::map<int, MachineNodeInfo *>::const_iterator it;
+    if(is_restricted_node)
+      it = machine->nodeinfos.lower_bound(restricted_node_id);
+    else
+      it = machine->nodeinfos.begin();
+    while(it != machine->nodeinfos.end()) {
+      if(is_restricted_node && (it->first != restricted_node_id))
+	break;
+
+      const std::map<Processor, MachineProcInfo *> *plist;
+      if(is_restricted_kind) {
+	std::map<Processor::Kind, std::map<Processor, MachineProcInfo *> >::const_iterator it2 = it->second->proc_by_kind.find(restricted_kind);
+	if(it2 != it->second->proc_by_kind.end())
+	  plist = &(it2->second);
+	else
+	  plist = 0;
+      } else
+	plist = &(it->second->procs);
+
+      if(plist) {
+	for(std::map<Processor, MachineProcInfo *>::const_iterator it2 = plist->begin();
+	    it2 != plist->end();
+	    ++it2) {
+	  bool ok = true;
+	  for(std::vector<ProcQueryPredicate *>::const_iterator it3 = predicates.begin();
+	      ok && (it3 != predicates.end());
+	      it3++)
+	    ok = (*it3)->matches_predicate(machine, it2->first, it2->second);
+	  if(ok)
+	    found.push_back(it2->first);
+	}
+      }
+
+      ++it;
+    }
+  }
+
+
   ////////////////////////////////////////////////////////////////////////
   //
   // class MemoryHasProcAffinityPredicate
@@ -1755,6 +2010,15 @@ namespace Realm {
     return new MemoryHasProcAffinityPredicate(proc, min_bandwidth, max_latency);
   }
 
+  bool MemoryHasProcAffinityPredicate::append_cache_key(std::vector<size_t>& key) const
+  {
+    key.push_back(QUERY_KEY_MEM_HAS_PROC_AFFINITY);
+    key.push_back(proc.id);
+    key.push_back(min_bandwidth);
+    key.push_back(max_latency);
+    return true;
+  }
+
   bool MemoryHasProcAffinityPredicate::matches_predicate(MachineImpl *machine, Memory thing,
 					      const MachineMemInfo *info) const
   {
@@ -1793,6 +2057,15 @@ namespace Realm {
     return new MemoryHasMemAffinityPredicate(memory, min_bandwidth, max_latency);
   }
 
+  bool MemoryHasMemAffinityPredicate::append_cache_key(std::vector<size_t>& key) const
+  {
+    key.push_back(QUERY_KEY_MEM_HAS_MEM_AFFINITY);
+    key.push_back(memory.id);
+    key.push_back(min_bandwidth);
+    key.push_back(max_latency);
+    return true;
+  }
+
   bool MemoryHasMemAffinityPredicate::matches_predicate(MachineImpl *machine, Memory thing,
 							const MachineMemInfo *info) const
   {
@@ -1831,6 +2104,15 @@ namespace Realm {
     return new MemoryBestProcAffinityPredicate(proc, bandwidth_weight, latency_weight);
   }
 
+  bool MemoryBestProcAffinityPredicate::append_cache_key(std::vector<size_t>& key) const
+  {
+    key.push_back(QUERY_KEY_MEM_BEST_PROC_AFFINITY);
+    key.push_back(proc.id);
+    key.push_back((size_t)bandwidth_weight);
+    key.push_back((size_t)latency_weight);
+    return true;
+  }
+
   bool MemoryBestProcAffinityPredicate::matches_predicate(MachineImpl *machine, Memory thing,
 					      const MachineMemInfo *info) const
   {
@@ -1878,6 +2160,15 @@ namespace Realm {
     return new MemoryBestMemAffinityPredicate(memory, bandwidth_weight, latency_weight);
   }
 
+  bool MemoryBestMemAffinityPredicate::append_cache_key(std::vector<size_t>& key) const
+  {
+    key.push_back(QUERY_KEY_MEM_BEST_MEM_AFFINITY);
+    key.push_back(memory.id);
+    key.push_back((size_t)bandwidth_weight);
+    key.push_back((size_t)latency_weight);
+    return true;
+  }
+
   bool MemoryBestMemAffinityPredicate::matches_predicate(MachineImpl *machine, Memory thing,
 					      const MachineMemInfo *info) const
   {
@@ -1917,6 +2208,8 @@ namespace Realm {
     , machine((MachineImpl *)_machine.impl)
     , is_restricted_node(false)
     , is_restricted_kind(false)
+    , matches(0)
+    , matches_generation(0)
   {}
      
   MemoryQueryImpl::MemoryQueryImpl(const MemoryQueryImpl& copy_from)
@@ -1926,6 +2219,8 @@ namespace Realm {
     , restricted_node_id(copy_from.restricted_node_id)
     , is_restricted_kind(copy_from.is_restricted_kind)
     , restricted_kind(copy_from.restricted_kind)
+    , matches(0)
+    , matches_generation(0)
   {
     predicates.reserve(copy_from.predicates.size());
     for(std::vector<MemoryQueryPredicate *>::const_iterator it = copy_from.predicates.begin();
@@ -1970,6 +2265,7 @@ namespace Realm {
 
   void MemoryQueryImpl::restrict_to_node(int new_node_id)
   {
+    matches = 0;
     // attempts to restrict to two different nodes results in no possible match
     if(is_restricted_node && (new_node_id != restricted_node_id)) {
       restricted_node_id = -1;
@@ -1981,6 +2277,7 @@ namespace Realm {
 
   void MemoryQueryImpl::restrict_to_kind(Memory::Kind new_kind)
   {
+    matches = 0;
     // attempts to restrict to two different kind results in no possible match
     // (use node restriction to enforce this)
     if(is_restricted_kind && (new_kind != restricted_kind)) {
@@ -1995,6 +2292,7 @@ namespace Realm {
   void MemoryQueryImpl::add_predicate(MemoryQueryPredicate *pred)
   {
     // a writer is always unique, so no need for mutexes
+    matches = 0;
     predicates.push_back(pred);
   }
 
@@ -2025,6 +2323,10 @@ namespace Realm {
     }
     return lowest;
 #else
+    const std::vector<Memory> *found = cached_matches();
+    if(found)
+      return (found->empty() ? Memory::NO_MEMORY : (*found)[0]);
+
     std::map<int, MachineNodeInfo *>::const_iterator it;
     if(is_restricted_node)
       it = machine->nodeinfos.lower_bound(restricted_node_id);
@@ -2096,6 +2398,14 @@ namespace Realm {
     }
     return lowest;
 #else
+    const std::vector<Memory> *found = cached_matches();
+    if(found) {
+      std::vector<Memory>::const_iterator it = std::upper_bound(found->begin(),
+							     found->end(),
+							     after);
+      return ((it != found->end()) ? *it : Memory::NO_MEMORY);
+    }
+
     std::map<int, MachineNodeInfo *>::const_iterator it;
     // start where we left off
     it = machine->nodeinfos.find(ID(after).memory.owner_node);
@@ -2168,6 +2478,10 @@ namespace Realm {
     }
     return pset.size();
 #else
+    const std::vector<Memory> *found = cached_matches();
+    if(found)
+      return found->size();
+
     size_t count = 0;
     std::map<int, MachineNodeInfo *>::const_iterator it;
     if(is_restricted_node)
@@ -2241,6 +2555,10 @@ namespace Realm {
       }
     }
 #else
+    const std::vector<Memory> *found = cached_matches();
+    if(found)
+      return (found->empty() ? Memory::NO_MEMORY : (*found)[lrand48() % found->size()]);
+
     size_t count = 0;
     std::map<int, MachineNodeInfo *>::const_iterator it;
     if(is_restricted_node)
@@ -2288,6 +2606,83 @@ namespace Realm {
   }
 
 
+  const std::vector<Memory> *MemoryQueryImpl::cached_matches(void) const
+  {
+    // reuse what we found last time if the machine hasn't changed since
+    if(matches && (matches_generation == machine->mem_query_cache.generation))
+      return matches;
+
+    if(Config::machine_query_cache_size <= 0)
+      return 0;
+
+    std::vector<size_t> key;
+    key.push_back(is_restricted_node);
+    key.push_back(is_restricted_node ? restricted_node_id : 0);
+    key.push_back(is_restricted_kind);
+    key.push_back(is_restricted_kind ? restricted_kind : 0);
+    for(std::vector<MemoryQueryPredicate *>::const_iterator it = predicates.begin();
+	it != predicates.end();
+	it++)
+      if(!(*it)->append_cache_key(key))
+	return 0;
+
+    unsigned generation;
+    const std::vector<Memory> *found = machine->mem_query_cache.lookup(key, generation);
+    if(!found) {
+      std::vector<Memory> scanned;
+      scan_matches(scanned);
+      found = machine->mem_query_cache.insert(key, generation, scanned);
+      if(!found)
+	return 0;
+    }
+
+    matches = found;
+    matches_generation = generation;
+    return found;
+  }
+
+  // the matches come out sorted because both the nodes and the memorys
+  //  within each node are visited in ID order
+  void MemoryQueryImpl::scan_matches(std::vector<Memory>& found) const
+  {
+    std::map<int, MachineNodeInfo *>::const_iterator it;
+    if(is_restricted_node)
+      it = machine->nodeinfos.lower_bound(restricted_node_id);
+    else
+      it = machine->nodeinfos.begin();
+    while(it != machine->nodeinfos.end()) {
+      if(is_restricted_node && (it->first != restricted_node_id))
+	break;
+
+      const std::map<Memory, MachineMemInfo *> *plist;
+      if(is_restricted_kind) {
+	std::map<Memory::Kind, std::map<Memory, MachineMemInfo *> >::const_iterator it2 = it->second->mem_by_kind.find(restricted_kind);
+	if(it2 != it->second->mem_by_kind.end())
+	  plist = &(it2->second);
+	else
+	  plist = 0;
+      } else
+	plist = &(it->second->mems);
+
+      if(plist) {
+	for(std::map<Memory, MachineMemInfo *>::const_iterator it2 = plist->begin();
+	    it2 != plist->end();
+	    ++it2) {
+	  bool ok = true;
+	  for(std::vector<MemoryQueryPredicate *>::const_iterator it3 = predicates.begin();
+	      ok && (it3 != predicates.end());
+	      it3++)
+	    ok = (*it3)->matches_predicate(machine, it2->first, it2->second);
+	  if(ok)
+	    found.push_back(it2->first);
+	}
+      }
+
+      ++it;
+    }
+  }
+
+
   ////////////////////////////////////////////////////////////////////////
   //
   // class NodeAnnounceMessage
@@ -2348,4 +2743,147 @@ namespace Realm {
     log_annc.info("node %d has received all of its announcements\n", gasnet_mynode());
   }
 
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class NodeAnnounceTreeMessage
+  //
+
+  static const size_t TREE_ANNOUNCE_HEADER_WORDS = 5;
+
+  static GASNetHSL tree_announce_mutex;
+  // blocks gathered from the subtrees of this node's children
+  static std::vector<size_t> tree_announce_gathered;
+  static int tree_announce_children_received = 0;
+  // the complete set of blocks, received from this node's parent
+  static std::vector<size_t> tree_announce_all;
+  static int tree_announce_all_received = 0;
+
+  /*static*/ void NodeAnnounceTreeMessage::handle_request(RequestArgs args,
+							  const void *data,
+							  size_t datalen)
+  {
+    DetailedTimer::ScopedPush sp(TIME_LOW_LEVEL);
+    log_annc.info() << "received " << (args.broadcast ? "combined" : "subtree")
+		    << " announcements from " << args.sender
+		    << " (" << datalen << " bytes)";
+
+    assert((datalen % sizeof(size_t)) == 0);
+    const size_t *words = (const size_t *)data;
+    size_t count = datalen / sizeof(size_t);
+
+    AutoHSLLock al(tree_announce_mutex);
+    if(args.broadcast) {
+      tree_announce_all.assign(words, words + count);
+      __sync_fetch_and_add(&tree_announce_all_received, 1);
+    } else {
+      tree_announce_gathered.insert(tree_announce_gathered.end(),
+				    words, words + count);
+      __sync_fetch_and_add(&tree_announce_children_received, 1);
+    }
+  }
+
+  /*static*/ void NodeAnnounceTreeMessage::send_request(gasnet_node_t target,
+							int broadcast,
+							const void *data,
+							size_t datalen)
+  {
+    RequestArgs args;
+
+    args.sender = gasnet_mynode();
+    args.broadcast = broadcast;
+    Message::request(target, args, data, datalen, PAYLOAD_COPY);
+  }
+
+  /*static*/ void NodeAnnounceTreeMessage::exchange_announcements(int radix,
+								  unsigned num_procs,
+								  unsigned num_memories,
+								  unsigned num_ib_memories,
+								  const void *data,
+								  size_t datalen)
+  {
+    unsigned num_nodes = gasnet_nodes();
+    unsigned me = gasnet_mynode();
+    if(num_nodes == 1) return;
+
+    assert(radix > 0);
+    unsigned first_child = me * radix + 1;
+    unsigned last_child = std::min(first_child + radix, num_nodes);
+    int num_children = (first_child < num_nodes) ? (last_child - first_child) : 0;
+
+    // wait for the announcements of everybody in our subtree
+    while(tree_announce_children_received < num_children)
+      do_some_polling();
+
+    // our own block goes in front of them
+    std::vector<size_t> combined;
+    assert((datalen % sizeof(size_t)) == 0);
+    size_t nwords = datalen / sizeof(size_t);
+    combined.reserve(TREE_ANNOUNCE_HEADER_WORDS + nwords + tree_announce_gathered.size());
+    combined.push_back(me);
+    combined.push_back(num_procs);
+    combined.push_back(num_memories);
+    combined.push_back(num_ib_memories);
+    combined.push_back(nwords);
+    combined.insert(combined.end(),
+		    (const size_t *)data, (const size_t *)data + nwords);
+    {
+      AutoHSLLock al(tree_announce_mutex);
+      combined.insert(combined.end(),
+		      tree_announce_gathered.begin(), tree_announce_gathered.end());
+      tree_announce_gathered.clear();
+    }
+
+    // everybody but the root sends theirs up and waits for the full set to
+    //  come back down
+    if(me > 0) {
+      send_request((me - 1) / radix, 0,
+		   &combined[0], combined.size() * sizeof(size_t));
+
+      while(tree_announce_all_received == 0)
+	do_some_polling();
+
+      AutoHSLLock al(tree_announce_mutex);
+      combined.swap(tree_announce_all);
+      tree_announce_all.clear();
+    }
+
+    for(unsigned child = first_child; child < last_child; child++)
+      send_request(child, 1, &combined[0], combined.size() * sizeof(size_t));
+
+    // now parse everybody else's blocks
+    int blocks_parsed = 0;
+    size_t pos = 0;
+    while(pos < combined.size()) {
+      assert((pos + TREE_ANNOUNCE_HEADER_WORDS) <= combined.size());
+      gasnet_node_t node_id = combined[pos];
+      unsigned n_procs = combined[pos + 1];
+      unsigned n_mems = combined[pos + 2];
+      unsigned n_ib_mems = combined[pos + 3];
+      size_t len = combined[pos + 4];
+      pos += TREE_ANNOUNCE_HEADER_WORDS;
+      assert((pos + len) <= combined.size());
+
+      if(node_id != me) {
+	log_annc.info("%d: received announce from %d (%d procs, %d memories)\n",
+		      me, node_id, n_procs, n_mems);
+
+	Node *n = &(get_runtime()->nodes[node_id]);
+	n->processors.resize(n_procs);
+	n->memories.resize(n_mems);
+	n->ib_memories.resize(n_ib_mems);
+
+	get_machine()->parse_node_announce_data(node_id, n_procs,
+						n_mems, n_ib_mems,
+						&combined[pos], len * sizeof(size_t),
+						true);
+	blocks_parsed++;
+      }
+      pos += len;
+    }
+    assert(blocks_parsed == (int)(num_nodes - 1));
+
+    log_annc.info("node %d has received all of its announcements\n", me);
+  }
+
 }; // namespace Realm
@@ -80,6 +80,31 @@ namespace Realm {
     std::map<Memory::Kind, std::map<Memory, MachineMemInfo *> > mem_by_kind;
   };
 
+  // remembers the (sorted) matches of processor/memory queries, keyed by
+  //  their restrictions and predicates - entries are never modified once
+  //  inserted, and a change to the machine retires them all (queries may
+  //  still be holding pointers to them, so they're only freed with the cache)
+  template <typename T>
+  struct MachineQueryCache {
+    MachineQueryCache(void);
+    ~MachineQueryCache(void);
+
+    // returns the matches for 'key' if known, and the generation the caller
+    //  should pass to insert() if not
+    const std::vector<T> *lookup(const std::vector<size_t>& key,
+				 unsigned& generation);
+    // returns 0 if the cache is full or changed since the lookup
+    const std::vector<T> *insert(const std::vector<size_t>& key,
+				 unsigned generation,
+				 const std::vector<T>& matches);
+    void invalidate(void);
+
+    GASNetHSL mutex;
+    unsigned generation;
+    std::map<std::vector<size_t>, std::vector<T> *> entries;
+    std::vector<std::vector<T> *> retired;
+  };
+
     class MachineImpl {
     public:
       MachineImpl(void);
@@ -137,6 +162,9 @@ namespace Realm {
 
       std::map<int, MachineNodeInfo *> nodeinfos;
 
+      MachineQueryCache<Processor> proc_query_cache;
+      MachineQueryCache<Memory> mem_query_cache;
+
     protected:
       MachineNodeInfo *get_nodeinfo(int node) const;
       MachineNodeInfo *get_nodeinfo(Processor p) const;
@@ -152,6 +180,10 @@ namespace Realm {
 
       virtual bool matches_predicate(MachineImpl *machine, T thing,
 				     const T2 *info = 0) const = 0;
+
+      // appends a description of the predicate to a query cache key - returns
+      //  false if the results of a query using it should not be cached
+      virtual bool append_cache_key(std::vector<size_t>& key) const { return false; }
     };
 
     typedef QueryPredicate<Processor,MachineProcInfo> ProcQueryPredicate;
@@ -165,6 +197,8 @@ namespace Realm {
       virtual bool matches_predicate(MachineImpl *machine, Processor thing,
 				     const MachineProcInfo *info = 0) const;
 
+      virtual bool append_cache_key(std::vector<size_t>& key) const;
+
     protected:
       Memory memory;
       unsigned min_bandwidth;
@@ -180,6 +214,8 @@ namespace Realm {
       virtual bool matches_predicate(MachineImpl *machine, Processor thing,
 				     const MachineProcInfo *info = 0) const;
 
+      virtual bool append_cache_key(std::vector<size_t>& key) const;
+
     protected:
       Memory memory;
       int bandwidth_weight;
@@ -211,6 +247,11 @@ namespace Realm {
       Processor random_match(void) const;
 
     protected:
+      // all the matches, from the machine's query cache, or 0 if this query
+      //  can't be cached
+      const std::vector<Processor> *cached_matches(void) const;
+      void scan_matches(std::vector<Processor>& found) const;
+
       int references;
       MachineImpl *machine;
       bool is_restricted_node;
@@ -218,6 +259,8 @@ namespace Realm {
       bool is_restricted_kind;
       Processor::Kind restricted_kind;
       std::vector<ProcQueryPredicate *> predicates;     
+      mutable const std::vector<Processor> *matches;
+      mutable unsigned matches_generation;
     };            
 
     typedef QueryPredicate<Memory, MachineMemInfo> MemoryQueryPredicate;
@@ -231,6 +274,8 @@ namespace Realm {
       virtual bool matches_predicate(MachineImpl *machine, Memory thing,
 				     const MachineMemInfo *info = 0) const;
 
+      virtual bool append_cache_key(std::vector<size_t>& key) const;
+
     protected:
       Processor proc;
       unsigned min_bandwidth;
@@ -246,6 +291,8 @@ namespace Realm {
       virtual bool matches_predicate(MachineImpl *machine, Memory thing,
 				     const MachineMemInfo *info = 0) const;
 
+      virtual bool append_cache_key(std::vector<size_t>& key) const;
+
     protected:
       Memory memory;
       unsigned min_bandwidth;
@@ -261,6 +308,8 @@ namespace Realm {
       virtual bool matches_predicate(MachineImpl *machine, Memory thing,
 				     const MachineMemInfo *info = 0) const;
 
+      virtual bool append_cache_key(std::vector<size_t>& key) const;
+
     protected:
       Processor proc;
       int bandwidth_weight;
@@ -276,6 +325,8 @@ namespace Realm {
       virtual bool matches_predicate(MachineImpl *machine, Memory thing,
 				     const MachineMemInfo *info = 0) const;
 
+      virtual bool append_cache_key(std::vector<size_t>& key) const;
+
     protected:
       Memory memory;
       int bandwidth_weight;
@@ -307,6 +358,11 @@ namespace Realm {
       Memory random_match(void) const;
 
     protected:
+      // all the matches, from the machine's query cache, or 0 if this query
+      //  can't be cached
+      const std::vector<Memory> *cached_matches(void) const;
+      void scan_matches(std::vector<Memory>& found) const;
+
       int references;
       MachineImpl *machine;
       bool is_restricted_node;
@@ -314,6 +370,8 @@ namespace Realm {
       bool is_restricted_kind;
       Memory::Kind restricted_kind;
       std::vector<MemoryQueryPredicate *> predicates;     
+      mutable const std::vector<Memory> *matches;
+      mutable unsigned matches_generation;
     };            
 
     extern MachineImpl *machine_singleton;
@@ -328,6 +386,8 @@ namespace Realm {
     NODE_ANNOUNCE_IB_MEM, // IB_MEM id size
     NODE_ANNOUNCE_PMA,  // PMA proc_id mem_id bw latency
     NODE_ANNOUNCE_MMA,  // MMA mem1_id mem2_id bw latency
+    NODE_ANNOUNCE_PROC_RANGE, // PROC_RANGE first_id count kind num_cores
+    NODE_ANNOUNCE_PMA_RANGE,  // PMA_RANGE first_proc_id count mem_id bw latency
   };
 
   struct NodeAnnounceMessage {
@@ -351,6 +411,32 @@ namespace Realm {
     static void await_all_announcements(void);
   };
 
+  // announcements sent through a tree rooted at node 0 - each message
+  //  carries a sequence of per-node blocks, each of which is a header
+  //  (node_id num_procs num_memories num_ib_memories length) followed by
+  //  'length' words of announcement data
+  struct NodeAnnounceTreeMessage {
+    struct RequestArgs : public BaseMedium {
+      gasnet_node_t sender;
+      int broadcast; // 0 = gathering up the tree, 1 = sending back down
+    };
+
+    static void handle_request(RequestArgs args, const void *data, size_t datalen);
+
+    typedef ActiveMessageMediumNoReply<NODE_ANNOUNCE_TREE_MSGID,
+				       RequestArgs,
+				       handle_request> Message;
+
+    static void send_request(gasnet_node_t target, int broadcast,
+			     const void *data, size_t datalen);
+
+    // sends this node's announcement to every other node, and waits until
+    //  everybody else's has been received and parsed
+    static void exchange_announcements(int radix, unsigned num_procs,
+				       unsigned num_memories, unsigned num_ib_memories,
+				       const void *data, size_t datalen);
+  };
+
 	
 }; // namespace Realm
 
@@ -22,12 +22,20 @@
 #include "runtime_impl.h"
 #include "profiling.h"
 #include "utils.h"
+#include "timers.h"
+#include "realm_config.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
 namespace Realm {
 
   Logger log_malloc("malloc");
   extern Logger log_copy; // in idx_impl.cc
   extern Logger log_inst; // in inst_impl.cc
+  extern Logger log_poison; // in event_impl.cc
 
 
 
@@ -57,6 +65,61 @@ namespace Realm {
       return get_runtime()->get_memory_impl(*this)->size;
     }
 
+    // runs a compaction once its precondition has triggered
+    class DeferredCompaction : public EventWaiter {
+    public:
+      DeferredCompaction(Memory _memory, const std::vector<RegionInstance>& _movable,
+			 UserEvent _after)
+	: memory(_memory), movable(_movable), after(_after) {}
+      virtual ~DeferredCompaction(void) {}
+
+      virtual bool event_triggered(Event e, bool poisoned)
+      {
+	if(poisoned) {
+	  log_poison.info() << "poisoned deferred compaction skipped: mem=" << memory;
+	  after.trigger();  // nothing moved, so the instances are usable again
+	  return true;
+	}
+	get_runtime()->get_memory_impl(memory)->compact_instances(movable);
+	after.trigger();
+	return true;
+      }
+
+      virtual void print(std::ostream& os) const
+      {
+	os << "deferred compaction: mem=" << memory << " after=" << after;
+      }
+
+      virtual Event get_finish_event(void) const
+      {
+	return after;
+      }
+
+    protected:
+      Memory memory;
+      std::vector<RegionInstance> movable;
+      UserEvent after;
+    };
+
+    Event Memory::compact(const std::vector<RegionInstance>& movable,
+			  Event wait_on /*= Event::NO_EVENT*/) const
+    {
+      MemoryImpl *m_impl = get_runtime()->get_memory_impl(*this);
+      if((ID(*this).memory.owner_node != gasnet_mynode()) || m_impl->is_owned_remotely()) {
+	log_malloc.warning() << "compaction of non-local memory " << *this << " ignored";
+	return Event::NO_EVENT;
+      }
+
+      if(!wait_on.has_triggered()) {
+	UserEvent after = UserEvent::create_user_event();
+	EventImpl::add_waiter(wait_on, new DeferredCompaction(*this, movable, after));
+	return after;
+      }
+
+      m_impl->compact_instances(movable);
+      return Event::NO_EVENT;
+    }
+
     // reports a problem with a memory in general (this is primarily for fault injection)
     void Memory::report_memory_fault(int reason,
 				     const void *reason_data,
@@ -68,6 +131,447 @@ namespace Realm {
     /*static*/ const Memory Memory::NO_MEMORY = { 0 };
 
 
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class MemoryAllocator
+  //
+
+  namespace Config {
+    int cpu_memory_allocator = MemoryAllocator::POLICY_SEGREGATED;
+    int gpu_memory_allocator = MemoryAllocator::POLICY_BUDDY;
+    int cpu_memory_huge_page_mb = 0;
+  };
+
+  // index of the highest set bit (val must be non-zero)
+  static inline int floor_log2(unsigned long long val)
+  {
+    return 63 - __builtin_clzll(val);
+  }
+
+  /*static*/ MemoryAllocator *MemoryAllocator::create(int kind, size_t alignment)
+  {
+    int policy = ((kind == MemoryImpl::MKIND_GPUFB) ?
+		    Config::gpu_memory_allocator :
+		    Config::cpu_memory_allocator);
+    switch(policy) {
+    case POLICY_FIRST_FIT: return new FirstFitAllocator;
+    case POLICY_SEGREGATED: return new SegregatedFitAllocator;
+    case POLICY_BUDDY: return new BuddyAllocator(alignment);
+    default:
+      log_malloc.fatal() << "unknown memory allocator policy: " << policy;
+      assert(0);
+    }
+    return 0;
+  }
+
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class FirstFitAllocator
+  //
+
+  void FirstFitAllocator::add_range(off_t offset, size_t size)
+  {
+    if(size > 0)
+      deallocate(offset, size);
+  }
+
+  off_t FirstFitAllocator::allocate(size_t size)
+  {
+    // try to minimize footprint by allocating at the highest address possible
+    if(!free_blocks.empty()) {
+      std::map<off_t, off_t>::iterator it = free_blocks.end();
+      do {
+	--it;  // predecrement since we started at the end
+
+	if(it->second == (off_t)size) {
+	  // perfect match
+	  off_t retval = it->first;
+	  free_blocks.erase(it);
+	  return retval;
+	}
+	
+	if(it->second > (off_t)size) {
+	  // some left over
+	  off_t leftover = it->second - size;
+	  off_t retval = it->first + leftover;
+	  it->second = leftover;
+	  return retval;
+	}
+      } while(it != free_blocks.begin());
+    }
+
+    return -1;
+  }
+
+  void FirstFitAllocator::deallocate(off_t offset, size_t size)
+  {
+    if(free_blocks.size() > 0) {
+      // find the first existing block that comes _after_ us
+      std::map<off_t, off_t>::iterator after = free_blocks.lower_bound(offset);
+      if(after != free_blocks.end()) {
+	// found one - is it the first one?
+	if(after == free_blocks.begin()) {
+	  // yes, so no "before"
+	  assert((offset + (off_t)size) <= after->first); // no overlap!
+	  if((offset + (off_t)size) == after->first) {
+	    // merge the ranges by eating the "after"
+	    size += after->second;
+	    free_blocks.erase(after);
+	  }
+	  free_blocks[offset] = size;
+	} else {
+	  // no, get range that comes before us too
+	  std::map<off_t, off_t>::iterator before = after; before--;
+
+	  // if we're adjacent to the after, merge with it
+	  assert((offset + (off_t)size) <= after->first); // no overlap!
+	  if((offset + (off_t)size) == after->first) {
+	    // merge the ranges by eating the "after"
+	    size += after->second;
+	    free_blocks.erase(after);
+	  }
+
+	  // if we're adjacent with the before, grow it instead of adding
+	  //  a new range
+	  assert((before->first + before->second) <= offset);
+	  if((before->first + before->second) == offset) {
+	    before->second += size;
+	  } else {
+	    free_blocks[offset] = size;
+	  }
+	}
+      } else {
+	// nothing's after us, so just see if we can merge with the range
+	//  that's before us
+
+	std::map<off_t, off_t>::iterator before = after; before--;
+
+	// if we're adjacent with the before, grow it instead of adding
+	//  a new range
+	assert((before->first + before->second) <= offset);
+	if((before->first + before->second) == offset) {
+	  before->second += size;
+	} else {
+	  free_blocks[offset] = size;
+	}
+      }
+    } else {
+      // easy case - nothing was free, so now just our block is
+      free_blocks[offset] = size;
+    }
+  }
+
+  bool FirstFitAllocator::allocate_at(off_t offset, size_t size)
+  {
+    // find the free block that would contain the range
+    std::map<off_t, off_t>::iterator it = free_blocks.upper_bound(offset);
+    if(it == free_blocks.begin())
+      return false;
+    --it;
+    off_t block_ofs = it->first;
+    off_t block_end = it->first + it->second;
+    if((offset + (off_t)size) > block_end)
+      return false;
+
+    // keep whatever is left on either side
+    if(block_ofs < offset)
+      it->second = offset - block_ofs;
+    else
+      free_blocks.erase(it);
+    if((offset + (off_t)size) < block_end)
+      free_blocks[offset + size] = block_end - (offset + size);
+    return true;
+  }
+
+  size_t FirstFitAllocator::free_block_count(void) const
+  {
+    return free_blocks.size();
+  }
+
+  size_t FirstFitAllocator::largest_free_block(void) const
+  {
+    // linear, but only the legacy allocator pays for it
+    off_t largest = 0;
+    for(std::map<off_t, off_t>::const_iterator it = free_blocks.begin();
+	it != free_blocks.end();
+	++it)
+      if(it->second > largest)
+	largest = it->second;
+    return largest;
+  }
+
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class SegregatedFitAllocator
+  //
+
+  SegregatedFitAllocator::SegregatedFitAllocator(void)
+    : class_mask(0)
+  {}
+
+  void SegregatedFitAllocator::insert_block(off_t offset, size_t size)
+  {
+    int c = floor_log2(size);
+    blocks[offset] = size;
+    classes[c].insert(std::make_pair(size, offset));
+    class_mask |= (1ULL << c);
+  }
+
+  void SegregatedFitAllocator::remove_block(off_t offset, size_t size)
+  {
+    int c = floor_log2(size);
+    blocks.erase(offset);
+    classes[c].erase(std::make_pair(size, offset));
+    if(classes[c].empty())
+      class_mask &= ~(1ULL << c);
+  }
+
+  void SegregatedFitAllocator::add_range(off_t offset, size_t size)
+  {
+    if(size > 0)
+      deallocate(offset, size);
+  }
+
+  off_t SegregatedFitAllocator::allocate(size_t size)
+  {
+    int c = floor_log2(size);
+
+    // blocks in our own class may still be too small, so search it for the
+    //  best fit - any block in a higher class fits, so take the smallest
+    std::set<std::pair<size_t, off_t> >::iterator it;
+    it = classes[c].lower_bound(std::make_pair(size, (off_t)0));
+    if(it == classes[c].end()) {
+      unsigned long long higher = ((c < (NUM_CLASSES - 1)) ?
+				     (class_mask & ~((2ULL << c) - 1)) :
+				     0);
+      if(!higher)
+	return -1;
+      c = __builtin_ctzll(higher);
+      it = classes[c].begin();
+    }
+
+    size_t block_size = it->first;
+    off_t block_ofs = it->second;
+    remove_block(block_ofs, block_size);
+
+    // like the first-fit allocator, hand out the top of the block so that
+    //  the remainder keeps its offset
+    if(block_size > size)
+      insert_block(block_ofs, block_size - size);
+    return block_ofs + (block_size - size);
+  }
+
+  void SegregatedFitAllocator::deallocate(off_t offset, size_t size)
+  {
+    std::map<off_t, size_t>::iterator after = blocks.lower_bound(offset);
+    if(after != blocks.end()) {
+      assert((offset + (off_t)size) <= after->first); // no overlap!
+      if((offset + (off_t)size) == after->first) {
+	size += after->second;
+	remove_block(after->first, after->second);
+      }
+    }
+
+    after = blocks.lower_bound(offset);
+    if(after != blocks.begin()) {
+      std::map<off_t, size_t>::iterator before = after; --before;
+      assert((before->first + (off_t)before->second) <= offset);
+      if((before->first + (off_t)before->second) == offset) {
+	offset = before->first;
+	size += before->second;
+	remove_block(before->first, before->second);
+      }
+    }
+
+    insert_block(offset, size);
+  }
+
+  bool SegregatedFitAllocator::allocate_at(off_t offset, size_t size)
+  {
+    std::map<off_t, size_t>::iterator it = blocks.upper_bound(offset);
+    if(it == blocks.begin())
+      return false;
+    --it;
+    off_t block_ofs = it->first;
+    off_t block_end = it->first + it->second;
+    if((offset + (off_t)size) > block_end)
+      return false;
+
+    remove_block(block_ofs, it->second);
+    if(block_ofs < offset)
+      insert_block(block_ofs, offset - block_ofs);
+    if((offset + (off_t)size) < block_end)
+      insert_block(offset + size, block_end - (offset + size));
+    return true;
+  }
+
+  size_t SegregatedFitAllocator::free_block_count(void) const
+  {
+    return blocks.size();
+  }
+
+  size_t SegregatedFitAllocator::largest_free_block(void) const
+  {
+    if(!class_mask)
+      return 0;
+    return classes[floor_log2(class_mask)].rbegin()->first;
+  }
+
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class BuddyAllocator
+  //
+
+  BuddyAllocator::BuddyAllocator(size_t min_block_size)
+    : num_free(0)
+  {
+    // blocks are always at least as large (and as aligned) as the memory's
+    //  alignment requirement
+    min_order = 0;
+    while((1ULL << min_order) < min_block_size)
+      min_order++;
+  }
+
+  int BuddyAllocator::order_for_size(size_t size) const
+  {
+    int order = floor_log2(size);
+    if((1ULL << order) < size)
+      order++;
+    return ((order < min_order) ? min_order : order);
+  }
+
+  bool BuddyAllocator::block_in_range(off_t offset, int order) const
+  {
+    off_t end = offset + ((off_t)1 << order);
+    for(std::vector<std::pair<off_t, off_t> >::const_iterator it = ranges.begin();
+	it != ranges.end();
+	++it)
+      if((it->first <= offset) && (end <= it->second))
+	return true;
+    return false;
+  }
+
+  void BuddyAllocator::add_range(off_t offset, size_t size)
+  {
+    off_t end = offset + size;
+    ranges.push_back(std::make_pair(offset, end));
+
+    // start at the first suitably-aligned offset, and then carve the range
+    //  into the largest aligned power-of-two blocks that fit
+    off_t min_block = (off_t)1 << min_order;
+    off_t cur = ((offset + min_block - 1) / min_block) * min_block;
+    while((end - cur) >= min_block) {
+      int order = min_order;
+      while((order < MAX_ORDER) &&
+	    ((cur & (((off_t)2 << order) - 1)) == 0) &&
+	    ((cur + ((off_t)2 << order)) <= end))
+	order++;
+      free_lists[order].insert(cur);
+      num_free++;
+      cur += (off_t)1 << order;
+    }
+  }
+
+  off_t BuddyAllocator::allocate(size_t size)
+  {
+    int order = order_for_size(size);
+    if(order > MAX_ORDER)
+      return -1;
+
+    int avail = order;
+    while((avail <= MAX_ORDER) && free_lists[avail].empty())
+      avail++;
+    if(avail > MAX_ORDER)
+      return -1;
+
+    off_t offset = *(free_lists[avail].begin());
+    free_lists[avail].erase(free_lists[avail].begin());
+    num_free--;
+
+    // split down to the requested order, returning upper halves to the
+    //  free lists
+    while(avail > order) {
+      avail--;
+      free_lists[avail].insert(offset + ((off_t)1 << avail));
+      num_free++;
+    }
+    return offset;
+  }
+
+  void BuddyAllocator::deallocate(off_t offset, size_t size)
+  {
+    int order = order_for_size(size);
+
+    // coalesce with free buddies for as long as the merged block stays
+    //  within one of the original ranges
+    while(order < MAX_ORDER) {
+      off_t buddy = offset ^ ((off_t)1 << order);
+      off_t merged = ((offset < buddy) ? offset : buddy);
+      if(!block_in_range(merged, order + 1))
+	break;
+      std::set<off_t>::iterator it = free_lists[order].find(buddy);
+      if(it == free_lists[order].end())
+	break;
+      free_lists[order].erase(it);
+      num_free--;
+      offset = merged;
+      order++;
+    }
+
+    assert(free_lists[order].count(offset) == 0);
+    free_lists[order].insert(offset);
+    num_free++;
+  }
+
+  bool BuddyAllocator::allocate_at(off_t offset, size_t size)
+  {
+    int order = order_for_size(size);
+    if((order > MAX_ORDER) || ((offset & (((off_t)1 << order) - 1)) != 0))
+      return false;
+
+    // find the free block (possibly a larger one) that contains the range
+    for(int avail = order; avail <= MAX_ORDER; avail++) {
+      off_t block = offset & ~(((off_t)1 << avail) - 1);
+      std::set<off_t>::iterator it = free_lists[avail].find(block);
+      if(it == free_lists[avail].end())
+	continue;
+
+      free_lists[avail].erase(it);
+      num_free--;
+      // split down, freeing whichever half doesn't contain the range
+      while(avail > order) {
+	avail--;
+	off_t upper = block + ((off_t)1 << avail);
+	if(offset >= upper) {
+	  free_lists[avail].insert(block);
+	  block = upper;
+	} else
+	  free_lists[avail].insert(upper);
+	num_free++;
+      }
+      return true;
+    }
+    return false;
+  }
+
+  size_t BuddyAllocator::free_block_count(void) const
+  {
+    return num_free;
+  }
+
+  size_t BuddyAllocator::largest_free_block(void) const
+  {
+    for(int order = MAX_ORDER; order >= min_order; order--)
+      if(!free_lists[order].empty())
+	return (size_t)1 << order;
+    return 0;
+  }
+
+
   ////////////////////////////////////////////////////////////////////////
   //
   // class MemoryImpl
@@ -81,7 +585,11 @@ namespace Realm {
       , usage(stringbuilder() << "realm/mem " << _me << "/usage")
       , peak_usage(stringbuilder() << "realm/mem " << _me << "/peak_usage")
       , peak_footprint(stringbuilder() << "realm/mem " << _me << "/peak_footprint")
+      , free_block_count(stringbuilder() << "realm/mem " << _me << "/free_blocks")
+      , largest_free_block(stringbuilder() << "realm/mem " << _me << "/largest_free_block")
+      , alloc_latency(stringbuilder() << "realm/mem " << _me << "/alloc_latency")
     {
+      allocator = MemoryAllocator::create(_kind, _alignment);
     }
 
     MemoryImpl::~MemoryImpl(void)
@@ -92,6 +600,7 @@ namespace Realm {
 	     (size_t)peak_usage, peak_usage / 1048576.0,
 	     (size_t)peak_footprint, peak_footprint / 1048576.0);
 #endif
+      delete allocator;
     }
 
     off_t MemoryImpl::alloc_bytes_local(size_t size)
@@ -111,46 +620,26 @@ namespace Realm {
 	  size += (alignment - leftover);
 	}
       }
-      // HACK: pad the size by a bit to see if we have people falling off
-      //  the end of their allocations
-      size += 0;
-
-      // try to minimize footprint by allocating at the highest address possible
-      if(!free_blocks.empty()) {
-	std::map<off_t, off_t>::iterator it = free_blocks.end();
-	do {
-	  --it;  // predecrement since we started at the end
-
-	  if(it->second == (off_t)size) {
-	    // perfect match
-	    off_t retval = it->first;
-	    free_blocks.erase(it);
-	    log_malloc.info("alloc full block: mem=" IDFMT " size=%zd ofs=%zd", me.id, size, (ssize_t)retval);
-	    usage += size;
-	    if(usage > peak_usage) peak_usage = usage;
-	    size_t footprint = this->size - retval;
-	    if(footprint > peak_footprint) peak_footprint = footprint;
-	    return retval;
-	  }
-	
-	  if(it->second > (off_t)size) {
-	    // some left over
-	    off_t leftover = it->second - size;
-	    off_t retval = it->first + leftover;
-	    it->second = leftover;
-	    log_malloc.info("alloc partial block: mem=" IDFMT " size=%zd ofs=%zd", me.id, size, (ssize_t)retval);
-	    usage += size;
-	    if(usage > peak_usage) peak_usage = usage;
-	    size_t footprint = this->size - retval;
-	    if(footprint > peak_footprint) peak_footprint = footprint;
-	    return retval;
-	  }
-	} while(it != free_blocks.begin());
+
+      long long t_start = Clock::current_time_in_nanoseconds();
+      off_t retval = allocator->allocate(size);
+      alloc_latency = (int)(Clock::current_time_in_nanoseconds() - t_start);
+
+      free_block_count = allocator->free_block_count();
+      largest_free_block = allocator->largest_free_block();
+
+      if(retval < 0) {
+	// no blocks large enough - boo hoo
+	log_malloc.info("alloc FAILED: mem=" IDFMT " size=%zd", me.id, size);
+	return -1;
       }
 
-      // no blocks large enough - boo hoo
-      log_malloc.info("alloc FAILED: mem=" IDFMT " size=%zd", me.id, size);
-      return -1;
+      log_malloc.info("alloc block: mem=" IDFMT " size=%zd ofs=%zd", me.id, size, (ssize_t)retval);
+      usage += size;
+      if(usage > peak_usage) peak_usage = usage;
+      size_t footprint = this->size - retval;
+      if(footprint > peak_footprint) peak_footprint = footprint;
+      return retval;
     }
 
     void MemoryImpl::free_bytes_local(off_t offset, size_t size)
@@ -176,60 +665,10 @@ namespace Realm {
       usage -= size;
       // only made things smaller, so can't impact the peak usage
 
-      if(free_blocks.size() > 0) {
-	// find the first existing block that comes _after_ us
-	std::map<off_t, off_t>::iterator after = free_blocks.lower_bound(offset);
-	if(after != free_blocks.end()) {
-	  // found one - is it the first one?
-	  if(after == free_blocks.begin()) {
-	    // yes, so no "before"
-	    assert((offset + (off_t)size) <= after->first); // no overlap!
-	    if((offset + (off_t)size) == after->first) {
-	      // merge the ranges by eating the "after"
-	      size += after->second;
-	      free_blocks.erase(after);
-	    }
-	    free_blocks[offset] = size;
-	  } else {
-	    // no, get range that comes before us too
-	    std::map<off_t, off_t>::iterator before = after; before--;
-
-	    // if we're adjacent to the after, merge with it
-	    assert((offset + (off_t)size) <= after->first); // no overlap!
-	    if((offset + (off_t)size) == after->first) {
-	      // merge the ranges by eating the "after"
-	      size += after->second;
-	      free_blocks.erase(after);
-	    }
-
-	    // if we're adjacent with the before, grow it instead of adding
-	    //  a new range
-	    assert((before->first + before->second) <= offset);
-	    if((before->first + before->second) == offset) {
-	      before->second += size;
-	    } else {
-	      free_blocks[offset] = size;
-	    }
-	  }
-	} else {
-	  // nothing's after us, so just see if we can merge with the range
-	  //  that's before us
-
-	  std::map<off_t, off_t>::iterator before = after; before--;
+      allocator->deallocate(offset, size);
 
-	  // if we're adjacent with the before, grow it instead of adding
-	  //  a new range
-	  assert((before->first + before->second) <= offset);
-	  if((before->first + before->second) == offset) {
-	    before->second += size;
-	  } else {
-	    free_blocks[offset] = size;
-	  }
-	}
-      } else {
-	// easy case - nothing was free, so now just our block is
-	free_blocks[offset] = size;
-      }
+      free_block_count = allocator->free_block_count();
+      largest_free_block = allocator->largest_free_block();
     }
 
     off_t MemoryImpl::alloc_bytes_remote(size_t size)
@@ -257,11 +696,24 @@ namespace Realm {
 						       ReductionOpID redopid,
 						       off_t list_size,
                                                        const ProfilingRequestSet &reqs,
-						       RegionInstance parent_inst)
+						       RegionInstance parent_inst,
+						       void *external_base /*= 0*/)
     {
-      off_t inst_offset = alloc_bytes(bytes_needed);
-      if(inst_offset < 0) {
-        return RegionInstance::NO_INST;
+      off_t inst_offset;
+      if(external_base) {
+	// reduction lists keep their count in a separate allocation
+	assert(list_size <= 0);
+	if(!wrap_external(external_base, bytes_needed, inst_offset)) {
+	  log_inst.warning("memory " IDFMT " cannot address external storage at %p",
+			   me.id, external_base);
+	  return RegionInstance::NO_INST;
+	}
+	get_runtime()->register_external_memory(this, external_base, bytes_needed);
+      } else {
+	inst_offset = alloc_bytes(bytes_needed);
+	if(inst_offset < 0) {
+	  return RegionInstance::NO_INST;
+	}
       }
 
       off_t count_offset = -1;
@@ -292,6 +744,7 @@ namespace Realm {
                                                               element_size, field_sizes, reqs,
 							      count_offset, list_size, 
                                                               parent_inst);
+      i_impl->external = (external_base != 0);
 
       // find/make an available index to store this in
       {
@@ -348,32 +801,179 @@ namespace Realm {
 					  &reqs);
 
       // Only do this if the response succeeds
-      if (resp.i.exists()) {
-        log_inst.debug("created remote instance: inst=" IDFMT " offset=%zd", resp.i.id, (ssize_t)resp.inst_offset);
-
-        DomainLinearization linear;
-        linear.deserialize(linearization_bits);
-
-        RegionInstanceImpl *i_impl = new RegionInstanceImpl(resp.i, r, me, resp.inst_offset, bytes_needed, redopid,
-                                                                linear, block_size, element_size, field_sizes, reqs,
-                                                                resp.count_offset, list_size, parent_inst);
-
-        unsigned index = ID(resp.i).instance.inst_idx;
-        // resize array if needed
-        if(index >= instances.size()) {
-          AutoHSLLock a(mutex);
-          if(index >= instances.size()) {
-            log_inst.debug("resizing instance array: mem=" IDFMT " old=%zd new=%d",
-                     me.id, instances.size(), index+1);
-            for(unsigned i = instances.size(); i <= index; i++)
-              instances.push_back(0);
-          }
-        }
-        instances[index] = i_impl;
-      }
+      if (resp.i.exists())
+	register_remote_instance(resp.i, r, linearization_bits, bytes_needed,
+				 block_size, element_size, field_sizes, redopid,
+				 list_size, reqs, parent_inst,
+				 resp.inst_offset, resp.count_offset);
       return resp.i;
     }
 
+    RegionInstanceImpl *MemoryImpl::register_remote_instance(RegionInstance i, IndexSpace r,
+							     const int *linearization_bits,
+							     size_t bytes_needed,
+							     size_t block_size,
+							     size_t element_size,
+							     const std::vector<size_t>& field_sizes,
+							     ReductionOpID redopid,
+							     off_t list_size,
+							     const ProfilingRequestSet &reqs,
+							     RegionInstance parent_inst,
+							     off_t inst_offset,
+							     off_t count_offset)
+    {
+      log_inst.debug("created remote instance: inst=" IDFMT " offset=%zd", i.id, (ssize_t)inst_offset);
+
+      DomainLinearization linear;
+      linear.deserialize(linearization_bits);
+
+      RegionInstanceImpl *i_impl = new RegionInstanceImpl(i, r, me, inst_offset, bytes_needed, redopid,
+							  linear, block_size, element_size, field_sizes, reqs,
+							  count_offset, list_size, parent_inst);
+
+      unsigned index = ID(i).instance.inst_idx;
+      // resize array if needed
+      if(index >= instances.size()) {
+	AutoHSLLock a(mutex);
+	if(index >= instances.size()) {
+	  log_inst.debug("resizing instance array: mem=" IDFMT " old=%zd new=%d",
+			 me.id, instances.size(), index+1);
+	  for(unsigned i = instances.size(); i <= index; i++)
+	    instances.push_back(0);
+	}
+      }
+      instances[index] = i_impl;
+      return i_impl;
+    }
+
+    size_t MemoryImpl::compact_instances(const std::vector<RegionInstance>& movable)
+    {
+      // the mutex is held across the whole move, so no other allocation can
+      //  interleave with it and the instances' offsets change atomically with
+      //  respect to creation/destruction in this memory
+      AutoHSLLock al(mutex);
+
+      struct Candidate {
+	RegionInstanceImpl *impl;
+	size_t padded_size;
+	off_t new_offset;
+	void *staging;
+      };
+      std::vector<Candidate> cands;
+
+      for(std::vector<RegionInstance>::const_iterator it = movable.begin();
+	  it != movable.end();
+	  ++it) {
+	ID id(*it);
+	if(id.instance.owner_node != gasnet_mynode())
+	  continue;
+	unsigned index = id.instance.inst_idx;
+	if((index >= instances.size()) || !instances[index] ||
+	   (instances[index]->memory != me))
+	  continue;
+	RegionInstanceImpl *impl = instances[index];
+	// instances whose metadata has been sent elsewhere can't be moved
+	//  without an invalidation protocol, and reduction list counts are
+	//  separate allocations we don't chase
+	if(!impl->metadata.is_valid() || impl->external ||
+	   impl->metadata.has_remote_copies() ||
+	   (impl->metadata.count_offset >= 0) ||
+	   (impl->metadata.size == 0))
+	  continue;
+	Candidate c;
+	c.impl = impl;
+	c.padded_size = impl->metadata.size;
+	if(alignment > 0) {
+	  size_t leftover = c.padded_size % alignment;
+	  if(leftover > 0)
+	    c.padded_size += (alignment - leftover);
+	}
+	c.new_offset = -1;
+	c.staging = 0;
+	cands.push_back(c);
+      }
+
+      if(cands.empty())
+	return 0;
+
+      // free everything, then place the largest instances first
+      for(size_t i = 0; i < cands.size(); i++)
+	allocator->deallocate(cands[i].impl->metadata.alloc_offset, cands[i].padded_size);
+
+      std::vector<std::pair<size_t, size_t> > by_size;
+      for(size_t i = 0; i < cands.size(); i++)
+	by_size.push_back(std::make_pair(cands[i].padded_size, i));
+      std::sort(by_size.rbegin(), by_size.rend());
+
+      bool ok = true;
+      for(size_t i = 0; ok && (i < by_size.size()); i++) {
+	Candidate& c = cands[by_size[i].second];
+	c.new_offset = allocator->allocate(c.padded_size);
+	if(c.new_offset < 0)
+	  ok = false;
+      }
+
+      if(!ok) {
+	// the new packing didn't fit - nothing has been written yet, so just
+	//  put every instance's range back where it was
+	for(size_t i = 0; i < cands.size(); i++)
+	  if(cands[i].new_offset >= 0)
+	    allocator->deallocate(cands[i].new_offset, cands[i].padded_size);
+	for(size_t i = 0; i < cands.size(); i++) {
+#ifndef NDEBUG
+	  bool restored =
+#endif
+	    allocator->allocate_at(cands[i].impl->metadata.alloc_offset, cands[i].padded_size);
+	  assert(restored);
+	}
+	log_malloc.info() << "compaction of " << me << " abandoned - no better packing found";
+	return 0;
+      }
+
+      // stage the data of every instance that moves before writing any of
+      //  it, since new ranges may overlap other instances' old ones
+      size_t moved = 0;
+      for(size_t i = 0; i < cands.size(); i++) {
+	Candidate& c = cands[i];
+	if(c.new_offset == c.impl->metadata.alloc_offset)
+	  continue;
+	c.staging = malloc(c.impl->metadata.size);
+	assert(c.staging != 0);
+	get_bytes(c.impl->metadata.alloc_offset, c.staging, c.impl->metadata.size);
+      }
+      for(size_t i = 0; i < cands.size(); i++) {
+	Candidate& c = cands[i];
+	if(!c.staging)
+	  continue;
+	put_bytes(c.new_offset, c.staging, c.impl->metadata.size);
+	free(c.staging);
+	log_malloc.info() << "compaction: inst=" << c.impl->me << " moved from "
+			  << c.impl->metadata.alloc_offset << " to " << c.new_offset;
+	c.impl->metadata.alloc_offset = c.new_offset;
+	size_t footprint = this->size - c.new_offset;
+	if(footprint > peak_footprint) peak_footprint = footprint;
+	moved++;
+      }
+
+      free_block_count = allocator->free_block_count();
+      largest_free_block = allocator->largest_free_block();
+      return moved;
+    }
+
+    bool MemoryImpl::is_owned_remotely(void) const
+    {
+      switch(kind) {
+      case MKIND_REMOTE:
+      case MKIND_RDMA:
+	return true;
+      case MKIND_GLOBAL:
+	// global memory allocations are all handled by node 0
+	return (gasnet_mynode() != 0);
+      default:
+	return false;
+      }
+    }
+
     RegionInstanceImpl *MemoryImpl::get_instance(RegionInstance i)
     {
       ID id(i);
@@ -405,7 +1005,13 @@ namespace Realm {
 
       RegionInstanceImpl *iimpl = instances[index];
 
-      free_bytes(iimpl->metadata.alloc_offset, iimpl->metadata.size);
+      if(iimpl->external)
+	get_runtime()->unregister_external_memory(this,
+						  get_direct_ptr(iimpl->metadata.alloc_offset,
+								 iimpl->metadata.size),
+						  iimpl->metadata.size);
+      else
+	free_bytes(iimpl->metadata.alloc_offset, iimpl->metadata.size);
 
       if(iimpl->metadata.count_offset >= 0)
 	free_bytes(iimpl->metadata.count_offset, sizeof(size_t));
@@ -452,33 +1058,107 @@ namespace Realm {
 				 void *prealloc_base /*= 0*/, bool _registered /*= false*/) 
     : MemoryImpl(_me, _size, MKIND_SYSMEM, ALIGNMENT, 
 		 (_registered ? Memory::REGDMA_MEM : Memory::SYSTEM_MEM))
+    , base(0), base_orig(0), mmap_size(0)
+    , page_size(sysconf(_SC_PAGESIZE)), thp_advised(false)
   {
     if(prealloc_base) {
       base = (char *)prealloc_base;
       prealloced = true;
       registered = _registered;
+      // somebody else (e.g. GASNet) owns the mapping, so advice is all we
+      //  can offer
+      if(Config::cpu_memory_huge_page_mb > 0)
+	advise_huge_pages();
     } else {
-      // allocate our own space
-      // enforce alignment on the whole memory range
-      base_orig = new char[_size + ALIGNMENT - 1];
-      size_t ofs = reinterpret_cast<size_t>(base_orig) % ALIGNMENT;
-      if(ofs > 0) {
-	base = base_orig + (ALIGNMENT - ofs);
-      } else {
-	base = base_orig;
-      }
       prealloced = false;
       assert(!_registered);
       registered = false;
+      if(Config::cpu_memory_huge_page_mb > 0)
+	allocate_huge_pages();
+      if(!base) {
+	// allocate our own space
+	// enforce alignment on the whole memory range
+	base_orig = new char[_size + ALIGNMENT - 1];
+	size_t ofs = reinterpret_cast<size_t>(base_orig) % ALIGNMENT;
+	if(ofs > 0) {
+	  base = base_orig + (ALIGNMENT - ofs);
+	} else {
+	  base = base_orig;
+	}
+      }
     }
     log_malloc.debug("CPU memory at %p, size = %zd%s%s", base, _size, 
 		     prealloced ? " (prealloced)" : "", registered ? " (registered)" : "");
-    free_blocks[0] = _size;
+    if(Config::cpu_memory_huge_page_mb > 0)
+      log_malloc.info() << "CPU memory " << me << ": page size = " << page_size
+			<< (thp_advised ? " (transparent huge pages advised)" : "");
+    allocator->add_range(0, _size);
+  }
+
+  void LocalCPUMemory::allocate_huge_pages(void)
+  {
+    size_t huge_size = ((size_t)Config::cpu_memory_huge_page_mb) << 20;
+    // huge page mappings must be a multiple of the page size
+    size_t len = ((size + huge_size - 1) / huge_size) * huge_size;
+
+#ifdef MAP_HUGETLB
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+#ifdef MAP_HUGE_SHIFT
+    // ask for the specific size rather than the system default
+    int huge_shift = 63 - __builtin_clzll(huge_size);
+    flags |= (huge_shift << MAP_HUGE_SHIFT);
+#endif
+    void *ptr = mmap(0, len, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if(ptr != MAP_FAILED) {
+      base = base_orig = (char *)ptr;
+      mmap_size = len;
+      page_size = huge_size;
+      return;
+    }
+    log_malloc.warning() << "could not map " << len << " bytes of "
+			 << Config::cpu_memory_huge_page_mb << "MB pages for "
+			 << me << " (errno=" << errno << ") - trying transparent huge pages";
+#endif
+
+#if defined(MAP_ANONYMOUS) && defined(MADV_HUGEPAGE)
+    // over-allocate so that the base can be aligned to a huge page boundary,
+    //  which is what lets the kernel use huge pages for the whole range
+    void *ptr2 = mmap(0, len + huge_size, PROT_READ | PROT_WRITE,
+		      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(ptr2 != MAP_FAILED) {
+      base_orig = (char *)ptr2;
+      mmap_size = len + huge_size;
+      size_t ofs = reinterpret_cast<size_t>(base_orig) % huge_size;
+      base = base_orig + (ofs ? (huge_size - ofs) : 0);
+      advise_huge_pages();
+    }
+#endif
+  }
+
+  void LocalCPUMemory::advise_huge_pages(void)
+  {
+#ifdef MADV_HUGEPAGE
+    // madvise needs a page-aligned start
+    size_t pgsize = sysconf(_SC_PAGESIZE);
+    size_t start = ((reinterpret_cast<size_t>(base) + pgsize - 1) / pgsize) * pgsize;
+    size_t end = reinterpret_cast<size_t>(base) + size;
+    if((end > start) && (madvise((void *)start, end - start, MADV_HUGEPAGE) == 0)) {
+      thp_advised = true;
+      return;
+    }
+    log_malloc.warning() << "transparent huge pages not available for " << me
+			 << " (errno=" << errno << ")";
+#else
+    log_malloc.warning() << "huge pages not supported on this system - " << me
+			 << " uses " << page_size << "-byte pages";
+#endif
   }
 
   LocalCPUMemory::~LocalCPUMemory(void)
   {
-    if(!prealloced)
+    if(mmap_size > 0)
+      munmap(base_orig, mmap_size);
+    else if(!prealloced)
       delete[] base_orig;
   }
 
@@ -529,6 +1209,13 @@ namespace Realm {
     return (base + offset);
   }
 
+  bool LocalCPUMemory::wrap_external(void *ptr, size_t size, off_t& offset)
+  {
+    // offsets are just displacements from our base, so any address works
+    offset = (char *)ptr - base;
+    return true;
+  }
+
   int LocalCPUMemory::get_home_node(off_t offset, size_t size)
   {
     return gasnet_mynode();
@@ -640,7 +1327,7 @@ namespace Realm {
       size = size_per_node * num_nodes;
       memory_stride = MEMORY_STRIDE;
       
-      free_blocks[0] = size;
+      allocator->add_range(0, size);
     }
 
     GASNetMemory::~GASNetMemory(void)
@@ -1024,6 +1711,183 @@ namespace Realm {
   }
 
 
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class CreateInstanceBatchMessage
+  //
+
+  // what goes over the wire for each entry (followed by its field sizes)
+  struct CreateInstanceBatchWireEntry {
+    Memory memory;
+    IndexSpace ispace;
+    size_t bytes_needed;
+    size_t block_size;
+    size_t element_size;
+    ReductionOpID redopid;
+    int linearization_bits[32];
+  };
+
+  TYPE_IS_SERIALIZABLE(CreateInstanceBatchWireEntry);
+
+  // requester-side state for an outstanding batch
+  struct PendingInstanceBatch {
+    std::vector<RegionInstance> *results;
+    std::vector<CreateInstanceBatchMessage::Entry> entries;  // grouped by owner
+    UserEvent done;
+    int remaining;  // responses still expected
+  };
+
+  /*static*/ void CreateInstanceBatchMessage::handle_request(RequestArgs args,
+							     const void *data, size_t datalen)
+  {
+    DetailedTimer::ScopedPush sp(TIME_LOW_LEVEL);
+
+    Serialization::FixedBufferDeserializer fbd(data, datalen);
+    std::vector<CreateInstanceRequest::Result> results(args.num_entries);
+    ProfilingRequestSet prs;
+
+    for(int i = 0; i < args.num_entries; i++) {
+      CreateInstanceBatchWireEntry we;
+      std::vector<size_t> field_sizes;
+#ifndef NDEBUG
+      bool ok =
+#endif
+	((fbd >> we) && (fbd >> field_sizes));
+      assert(ok);
+
+      MemoryImpl *m_impl = get_runtime()->get_memory_impl(we.memory);
+      RegionInstance inst = m_impl->create_instance(we.ispace,
+						    we.linearization_bits,
+						    we.bytes_needed,
+						    we.block_size,
+						    we.element_size,
+						    field_sizes,
+						    we.redopid,
+						    -1 /*list size*/,
+						    prs,
+						    RegionInstance::NO_INST);
+      results[i].i = inst;
+      if(inst.exists()) {
+	RegionInstanceImpl *i_impl = get_runtime()->get_instance_impl(inst);
+	results[i].inst_offset = i_impl->metadata.alloc_offset;
+	results[i].count_offset = i_impl->metadata.count_offset;
+      } else {
+	results[i].inst_offset = -1;
+	results[i].count_offset = -1;
+      }
+    }
+    assert(fbd.bytes_left() == 0);
+
+    ResponseArgs r_args;
+    r_args.batch_ptr = args.batch_ptr;
+    r_args.first_entry = args.first_entry;
+    r_args.num_entries = args.num_entries;
+    Response::request(args.sender, r_args,
+		      &results[0], args.num_entries * sizeof(CreateInstanceRequest::Result),
+		      PAYLOAD_COPY);
+  }
+
+  /*static*/ void CreateInstanceBatchMessage::handle_response(ResponseArgs args,
+							      const void *data, size_t datalen)
+  {
+    PendingInstanceBatch *batch = static_cast<PendingInstanceBatch *>(args.batch_ptr);
+    const CreateInstanceRequest::Result *results = static_cast<const CreateInstanceRequest::Result *>(data);
+    assert(datalen == (args.num_entries * sizeof(CreateInstanceRequest::Result)));
+
+    for(int i = 0; i < args.num_entries; i++) {
+      const Entry& e = batch->entries[args.first_entry + i];
+      if(results[i].i.exists()) {
+	MemoryImpl *m_impl = get_runtime()->get_memory_impl(e.memory);
+	m_impl->register_remote_instance(results[i].i, e.ispace, e.linearization_bits,
+					 e.bytes_needed, e.block_size, e.element_size,
+					 e.field_sizes, e.redopid, -1 /*list size*/,
+					 e.reqs, RegionInstance::NO_INST,
+					 results[i].inst_offset, results[i].count_offset);
+      }
+      (*batch->results)[e.index] = results[i].i;
+    }
+
+    // last response wakes up the caller
+    if(__sync_sub_and_fetch(&batch->remaining, 1) == 0) {
+      batch->done.trigger();
+      delete batch;
+    }
+  }
+
+  static bool entry_owner_less(const CreateInstanceBatchMessage::Entry& a,
+			       const CreateInstanceBatchMessage::Entry& b)
+  {
+    return (ID(a.memory).memory.owner_node < ID(b.memory).memory.owner_node);
+  }
+
+  /*static*/ Event CreateInstanceBatchMessage::send_requests(std::vector<RegionInstance>& results,
+							     const std::vector<Entry>& entries)
+  {
+    PendingInstanceBatch *batch = new PendingInstanceBatch;
+    batch->results = &results;
+    batch->entries = entries;
+    std::stable_sort(batch->entries.begin(), batch->entries.end(), entry_owner_less);
+    batch->done = UserEvent::create_user_event();
+    Event e = batch->done;
+
+    // count the nodes up front, since responses may arrive (and free the
+    //  batch) while we're still sending
+    int num_nodes = 0;
+    for(size_t i = 0; i < batch->entries.size(); i++)
+      if((i == 0) || entry_owner_less(batch->entries[i - 1], batch->entries[i]))
+	num_nodes++;
+    batch->remaining = num_nodes;
+
+    // copy out what we need for each message before the first one goes out
+    std::vector<std::pair<int, int> > ranges;  // first entry, count
+    std::vector<void *> payloads;
+    std::vector<size_t> payload_sizes;
+    std::vector<gasnet_node_t> targets;
+    size_t first = 0;
+    while(first < batch->entries.size()) {
+      size_t last = first + 1;
+      while((last < batch->entries.size()) &&
+	    !entry_owner_less(batch->entries[first], batch->entries[last]))
+	last++;
+
+      Serialization::DynamicBufferSerializer dbs(256 * (last - first));
+      for(size_t i = first; i < last; i++) {
+	const Entry& src = batch->entries[i];
+	CreateInstanceBatchWireEntry we;
+	we.memory = src.memory;
+	we.ispace = src.ispace;
+	we.bytes_needed = src.bytes_needed;
+	we.block_size = src.block_size;
+	we.element_size = src.element_size;
+	we.redopid = src.redopid;
+	for(unsigned j = 0; j < 32; j++)
+	  we.linearization_bits[j] = src.linearization_bits[j];
+	dbs << we;
+	dbs << src.field_sizes;
+      }
+
+      ranges.push_back(std::make_pair((int)first, (int)(last - first)));
+      payload_sizes.push_back(dbs.bytes_used());
+      payloads.push_back(dbs.detach_buffer(-1 /*no trim*/));
+      targets.push_back(ID(batch->entries[first].memory).memory.owner_node);
+      first = last;
+    }
+
+    for(size_t i = 0; i < targets.size(); i++) {
+      log_inst.debug() << "creating " << ranges[i].second << " remote instances: node=" << targets[i];
+
+      RequestArgs args;
+      args.sender = gasnet_mynode();
+      args.batch_ptr = batch;
+      args.first_entry = ranges[i].first;
+      args.num_entries = ranges[i].second;
+      Request::request(targets[i], args, payloads[i], payload_sizes[i], PAYLOAD_FREE);
+    }
+
+    return e;
+  }
+
+
   ////////////////////////////////////////////////////////////////////////
   //
   // class DestroyInstanceRequest
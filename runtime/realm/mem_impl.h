@@ -36,7 +36,102 @@
 namespace Realm {
 
   class RegionInstanceImpl;
-  
+
+    // a MemoryAllocator hands out byte ranges within a memory - all calls are
+    //  made with the owning MemoryImpl's mutex held, and sizes have already been
+    //  padded to the memory's alignment
+    class MemoryAllocator {
+    public:
+      enum Policy {
+	POLICY_FIRST_FIT,   // single offset-ordered free list, highest address first
+	POLICY_SEGREGATED,  // best fit within power-of-two size classes
+	POLICY_BUDDY,       // binary buddy blocks
+      };
+
+      virtual ~MemoryAllocator(void) {}
+
+      // picks the allocator for a given kind of memory based on the
+      //  -realm:cpualloc/-realm:gpualloc settings
+      static MemoryAllocator *create(int /*MemoryImpl::MemoryKind*/ kind, size_t alignment);
+
+      // makes [offset, offset+size) available for allocation
+      virtual void add_range(off_t offset, size_t size) = 0;
+
+      // returns -1 if no suitable range is available
+      virtual off_t allocate(size_t size) = 0;
+      virtual void deallocate(off_t offset, size_t size) = 0;
+
+      // claims exactly [offset, offset+size) if it is free - used to put
+      //  things back where they were
+      virtual bool allocate_at(off_t offset, size_t size) = 0;
+
+      // fragmentation statistics
+      virtual size_t free_block_count(void) const = 0;
+      virtual size_t largest_free_block(void) const = 0;
+    };
+
+    class FirstFitAllocator : public MemoryAllocator {
+    public:
+      virtual void add_range(off_t offset, size_t size);
+      virtual off_t allocate(size_t size);
+      virtual void deallocate(off_t offset, size_t size);
+      virtual bool allocate_at(off_t offset, size_t size);
+      virtual size_t free_block_count(void) const;
+      virtual size_t largest_free_block(void) const;
+
+    protected:
+      std::map<off_t, off_t> free_blocks;
+    };
+
+    class SegregatedFitAllocator : public MemoryAllocator {
+    public:
+      SegregatedFitAllocator(void);
+
+      virtual void add_range(off_t offset, size_t size);
+      virtual off_t allocate(size_t size);
+      virtual void deallocate(off_t offset, size_t size);
+      virtual bool allocate_at(off_t offset, size_t size);
+      virtual size_t free_block_count(void) const;
+      virtual size_t largest_free_block(void) const;
+
+    protected:
+      static const int NUM_CLASSES = 64;
+
+      void insert_block(off_t offset, size_t size);
+      void remove_block(off_t offset, size_t size);
+
+      // free blocks by offset (for coalescing) and by (size, offset) in each
+      //  power-of-two size class (for fitting) - class_mask has a bit set for
+      //  each non-empty class
+      std::map<off_t, size_t> blocks;
+      std::set<std::pair<size_t, off_t> > classes[NUM_CLASSES];
+      unsigned long long class_mask;
+    };
+
+    class BuddyAllocator : public MemoryAllocator {
+    public:
+      BuddyAllocator(size_t min_block_size);
+
+      virtual void add_range(off_t offset, size_t size);
+      virtual off_t allocate(size_t size);
+      virtual void deallocate(off_t offset, size_t size);
+      virtual bool allocate_at(off_t offset, size_t size);
+      virtual size_t free_block_count(void) const;
+      virtual size_t largest_free_block(void) const;
+
+    protected:
+      static const int MAX_ORDER = 62;
+
+      int order_for_size(size_t size) const;
+      bool block_in_range(off_t offset, int order) const;
+
+      int min_order;
+      std::set<off_t> free_lists[MAX_ORDER + 1];
+      size_t num_free;
+      // blocks never coalesce across the ranges handed to add_range
+      std::vector<std::pair<off_t, off_t> > ranges;
+    };
+
     class MemoryImpl {
     public:
       enum MemoryKind {
@@ -74,7 +169,8 @@ namespace Realm {
 					   ReductionOpID redopid,
 					   off_t list_size,
                                            const ProfilingRequestSet &reqs,
-					   RegionInstance parent_inst);
+					   RegionInstance parent_inst,
+					   void *external_base = 0);
 
       RegionInstance create_instance_remote(IndexSpace is,
 					    const int *linearization_bits,
@@ -98,6 +194,27 @@ namespace Realm {
                                              const ProfilingRequestSet &reqs,
 					     RegionInstance parent_inst) = 0;
 
+      // records (on the requesting node) an instance the owner has created
+      RegionInstanceImpl *register_remote_instance(RegionInstance i, IndexSpace is,
+						   const int *linearization_bits,
+						   size_t bytes_needed,
+						   size_t block_size,
+						   size_t element_size,
+						   const std::vector<size_t>& field_sizes,
+						   ReductionOpID redopid,
+						   off_t list_size,
+						   const ProfilingRequestSet &reqs,
+						   RegionInstance parent_inst,
+						   off_t inst_offset,
+						   off_t count_offset);
+
+      // true if instances in this memory must be created by its owner node
+      bool is_owned_remotely(void) const;
+
+      // moves the given instances (which must not be in use) within this
+      //  memory to coalesce free space, returning the number moved
+      size_t compact_instances(const std::vector<RegionInstance>& movable);
+
       void destroy_instance_local(RegionInstance i, bool local_destroy);
       void destroy_instance_remote(RegionInstance i, bool local_destroy);
 
@@ -127,6 +244,15 @@ namespace Realm {
 
       virtual void *local_reg_base(void) { return 0; };
 
+      // instances created with an 'external_base' use storage owned by the
+      //  application rather than allocating it - a memory that can address
+      //  such storage returns the offset at which [ptr, ptr+size) appears
+      virtual bool wrap_external(void *ptr, size_t size, off_t& offset) { return false; }
+
+      // a hint that 'target' is about to use [offset, offset+size) - only
+      //  memories that migrate data on demand need to do anything with it
+      virtual void prefetch(off_t offset, size_t size, Processor target) {}
+
       Memory::Kind get_kind(void) const;
 
     public:
@@ -137,8 +263,10 @@ namespace Realm {
       Memory::Kind lowlevel_kind;
       GASNetHSL mutex; // protection for resizing vectors
       std::vector<RegionInstanceImpl *> instances;
-      std::map<off_t, off_t> free_blocks;
+      MemoryAllocator *allocator;
       ProfilingGauges::AbsoluteGauge<size_t> usage, peak_usage, peak_footprint;
+      ProfilingGauges::AbsoluteGauge<size_t> free_block_count, largest_free_block;
+      ProfilingGauges::AbsoluteRangeGauge<int> alloc_latency;  // in ns
     };
 
     class LocalCPUMemory : public MemoryImpl {
@@ -169,10 +297,21 @@ namespace Realm {
       virtual void *get_direct_ptr(off_t offset, size_t size);
       virtual int get_home_node(off_t offset, size_t size);
       virtual void *local_reg_base(void);
+      virtual bool wrap_external(void *ptr, size_t size, off_t& offset);
+
+      // backs [base, base+size) with huge pages if -ll:hugepage was given
+      void allocate_huge_pages(void);
+      void advise_huge_pages(void);
 
     public: //protected:
       char *base, *base_orig;
       bool prealloced, registered;
+      // if non-zero, base_orig came from mmap and is this long
+      size_t mmap_size;
+      // page size actually obtained (transparent huge pages are only advice,
+      //  so those report the base page size along with thp_advised)
+      size_t page_size;
+      bool thp_advised;
     };
 
     class GASNetMemory : public MemoryImpl {
@@ -223,7 +362,6 @@ namespace Realm {
       int num_nodes;
       off_t memory_stride;
       gasnet_seginfo_t *seginfos;
-      //std::map<off_t, off_t> free_blocks;
     };
 
     class DiskMemory : public MemoryImpl {
@@ -320,8 +458,15 @@ namespace Realm {
       virtual int get_home_node(off_t offset, size_t size);
 
       int get_file_des(ID::IDType inst_id);
+
+      // returns the base of the instance's file mapping (and its length), or
+      //  0 if the file is accessed with pread/pwrite
+      char *get_mapping(ID::IDType inst_id, size_t& length);
     public:
       std::vector<int> file_vec;
+      // with -ll:filemmap, each instance's file is mapped MAP_SHARED
+      std::vector<char *> map_vec;
+      std::vector<size_t> map_len_vec;
       pthread_mutex_t vector_lock;
       off_t next_offset;
       std::map<off_t, int> offset_map;
@@ -442,6 +587,53 @@ namespace Realm {
 			       const ProfilingRequestSet *prs);
     };
 
+    // several instance creations for memories owned by a single node, sent
+    //  as one request and answered with one response
+    struct CreateInstanceBatchMessage {
+      struct RequestArgs : public BaseMedium {
+	int sender;
+	void *batch_ptr;
+	int first_entry;
+	int num_entries;
+      };
+
+      struct ResponseArgs : public BaseMedium {
+	void *batch_ptr;
+	int first_entry;
+	int num_entries;
+      };
+
+      // requester-side description of one instance
+      struct Entry {
+	size_t index;  // position in the caller's result vector
+	Memory memory;
+	IndexSpace ispace;
+	size_t bytes_needed;
+	size_t block_size;
+	size_t element_size;
+	ReductionOpID redopid;
+	int linearization_bits[32]; //RegionInstanceImpl::MAX_LINEARIZATION_LEN];
+	std::vector<size_t> field_sizes;
+	ProfilingRequestSet reqs;
+      };
+
+      static void handle_request(RequestArgs args, const void *data, size_t datalen);
+      static void handle_response(ResponseArgs args, const void *data, size_t datalen);
+
+      typedef ActiveMessageMediumNoReply<CREATE_INST_BATCH_MSGID,
+ 	                                 RequestArgs,
+	                                 handle_request> Request;
+
+      typedef ActiveMessageMediumNoReply<CREATE_INST_BATCH_RPLID,
+ 	                                 ResponseArgs,
+	                                 handle_response> Response;
+
+      // sends one request per owner node for the given entries - the returned
+      //  event triggers once every entry's slot in 'results' has been filled in
+      static Event send_requests(std::vector<RegionInstance>& results,
+				 const std::vector<Entry>& entries);
+    };
+
     struct DestroyInstanceMessage {
       struct RequestArgs {
 	Memory m;
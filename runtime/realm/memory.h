@@ -20,13 +20,18 @@
 
 #include "lowlevel_config.h"
 
+#include "event.h"
+
 #include <stddef.h>
 #include <iostream>
+#include <vector>
 
 namespace Realm {
 
     typedef ::legion_lowlevel_address_space_t AddressSpace;
 
+    class RegionInstance;
+
     class Memory {
     public:
       typedef ::legion_lowlevel_id_t id_t;
@@ -56,6 +61,7 @@ namespace Realm {
         LEVEL3_CACHE, // CPU L3 Visible to all processors on the node, better performance to processors on same socket 
         LEVEL2_CACHE, // CPU L2 Visible to all processors on the node, better performance to one processor
         LEVEL1_CACHE, // CPU L1 Visible to all processors on the node, better performance to one processor
+        GPU_MANAGED_MEM, // Managed memory visible to all CPUs within a node and one or more GPUs, migrated on demand
       };
 
       // Return what kind of memory this is
@@ -63,6 +69,13 @@ namespace Realm {
       // Return the maximum capacity of this memory
       size_t capacity(void) const;
 
+      // relocates instances from 'movable' within this (local) memory to
+      //  coalesce its free space - the caller must keep them unused from
+      //  'wait_on' until the returned event triggers, and instances that are
+      //  in other memories or have been shared with other nodes stay put
+      Event compact(const std::vector<RegionInstance>& movable,
+		    Event wait_on = Event::NO_EVENT) const;
+
       // reports a problem with a memory in general (this is primarily for fault injection)
       void report_memory_fault(int reason,
 			       const void *reason_data, size_t reason_size) const;
@@ -20,11 +20,17 @@
 #include "event_impl.h"
 #include "inst_impl.h"
 #include "runtime_impl.h"
+#include "realm_config.h"
 
 namespace Realm {
 
   Logger log_metadata("metadata");
 
+  namespace Config {
+    int metadata_push = 1;
+    int metadata_cache_size = 0;
+  };
+
   ////////////////////////////////////////////////////////////////////////
   //
   // class MetadataBase
@@ -32,6 +38,7 @@ namespace Realm {
 
     MetadataBase::MetadataBase(void)
       : state(STATE_INVALID), valid_event(Event::NO_EVENT)
+      , fetch_owner(-1), fetch_id(0)
     {}
 
     MetadataBase::~MetadataBase(void)
@@ -44,21 +51,26 @@ namespace Realm {
       state = STATE_VALID;
     }
 
-    void MetadataBase::handle_request(int requestor)
+    bool MetadataBase::handle_request(int requestor, bool push /*= false*/)
     {
       // just add the requestor to the list of remote nodes with copies
       AutoHSLLock a(mutex);
 
       assert(is_valid());
-      assert(!remote_copies.contains(requestor));
+      // a pushed copy may cross paths with a request from the same node, so
+      //  an explicit request is always answered
+      if(remote_copies.contains(requestor))
+	return !push;
       remote_copies.add(requestor);
+      return true;
     }
 
-    void MetadataBase::handle_response(void)
+    bool MetadataBase::handle_response(int owner, ID::IDType id)
     {
       // update the state, and
       // if there was an event, we'll trigger it
       Event to_trigger = Event::NO_EVENT;
+      bool newly_valid = false;
       {
 	AutoHSLLock a(mutex);
 
@@ -68,23 +80,46 @@ namespace Realm {
 	    to_trigger = valid_event;
 	    valid_event = Event::NO_EVENT;
 	    state = STATE_VALID;
+	    newly_valid = true;
+	    break;
+	  }
+
+	case STATE_INVALID:
+	  {
+	    // pushed by the owner before anybody here asked for it
+	    state = STATE_VALID;
+	    newly_valid = true;
+	    break;
+	  }
+
+	case STATE_VALID:
+	  {
+	    // a push and the response to our own request both arrived
 	    break;
 	  }
 
 	default:
 	  assert(0);
 	}
+
+	fetch_owner = owner;
+	fetch_id = id;
       }
 
       if(to_trigger.exists())
 	GenEventImpl::trigger(to_trigger, false /*!poisoned*/);
+
+      return newly_valid;
     }
 
     Event MetadataBase::request_data(int owner, ID::IDType id)
     {
       // early out - valid data need not be re-requested
-      if(state == STATE_VALID) 
+      if(state == STATE_VALID) {
+	if((Config::metadata_cache_size > 0) && (((unsigned)owner) != gasnet_mynode()))
+	  metadata_cache.touch(id);
 	return Event::NO_EVENT;
+      }
 
       // sanity-check - should never be requesting data from ourselves
       assert(((unsigned)owner) != gasnet_mynode());
@@ -142,13 +177,21 @@ namespace Realm {
       // take lock to get event - must have already been requested (we don't have enough
       //  information to do that now)
       Event e = Event::NO_EVENT;
+      int refetch_owner = -1;
       {
 	AutoHSLLock a(mutex);
 
-	assert(state != STATE_INVALID);
-	e = valid_event;
+	if(state == STATE_INVALID) {
+	  // only legal if the cache dropped a copy we had before
+	  assert(fetch_owner >= 0);
+	  refetch_owner = fetch_owner;
+	} else
+	  e = valid_event;
       }
 
+      if(refetch_owner >= 0)
+	e = request_data(refetch_owner, fetch_id);
+
       if(!e.has_triggered())
         e.wait(); // FIXME
     }
@@ -198,25 +241,113 @@ namespace Realm {
 	  break;
 	}
 
+      case STATE_INVALID:
+	{
+	  // our copy was evicted while the invalidation was in flight
+	  break;
+	}
+
       default:
 	assert(0);
       }
     }
 
+    bool MetadataBase::evict(void)
+    {
+      AutoHSLLock a(mutex);
+
+      if(state != STATE_VALID)
+	return false;
+
+      state = STATE_INVALID;
+      return true;
+    }
+
     bool MetadataBase::handle_inval_ack(int sender)
     {
       bool last_copy;
       {
 	AutoHSLLock a(mutex);
 
-	assert(remote_copies.contains(sender));
+	// an evicted copy is reported the same way, and may race with an
+	//  invalidation, so a second ack from the same node is ignored
+	if(!remote_copies.contains(sender))
+	  return false;
 	remote_copies.remove(sender);
-	last_copy = remote_copies.empty();
+	last_copy = remote_copies.empty() && (state == STATE_CLEANUP);
       }
 
       return last_copy;
     }
 
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class MetadataCache
+  //
+
+  MetadataCache metadata_cache;
+
+  MetadataCache::MetadataCache(void)
+  {}
+
+  void MetadataCache::insert(ID::IDType id)
+  {
+    std::vector<ID::IDType> to_evict;
+    {
+      AutoHSLLock a(mutex);
+
+      std::map<ID::IDType, std::list<ID::IDType>::iterator>::iterator it = entries.find(id);
+      if(it != entries.end())
+	lru.erase(it->second);
+      lru.push_front(id);
+      entries[id] = lru.begin();
+
+      while(lru.size() > (size_t)Config::metadata_cache_size) {
+	to_evict.push_back(lru.back());
+	entries.erase(lru.back());
+	lru.pop_back();
+      }
+    }
+
+    // evictions are done outside the cache's lock
+    for(std::vector<ID::IDType>::const_iterator it = to_evict.begin();
+	it != to_evict.end();
+	it++) {
+      ID victim(*it);
+      if(victim.is_instance()) {
+	RegionInstanceImpl *impl = get_runtime()->get_instance_impl(*it);
+	if(impl->metadata.evict()) {
+	  log_metadata.debug("evicting metadata for " IDFMT, *it);
+	  // an ack tells the owner we no longer have a copy to invalidate
+	  MetadataInvalidateAckMessage::send_request(victim.instance.owner_node, *it);
+	}
+      } else {
+	assert(0);
+      }
+    }
+  }
+
+  void MetadataCache::touch(ID::IDType id)
+  {
+    AutoHSLLock a(mutex);
+
+    std::map<ID::IDType, std::list<ID::IDType>::iterator>::iterator it = entries.find(id);
+    if(it != entries.end())
+      lru.splice(lru.begin(), lru, it->second);
+  }
+
+  void MetadataCache::remove(ID::IDType id)
+  {
+    AutoHSLLock a(mutex);
+
+    std::map<ID::IDType, std::list<ID::IDType>::iterator>::iterator it = entries.find(id);
+    if(it != entries.end()) {
+      lru.erase(it->second);
+      entries.erase(it);
+    }
+  }
+
   
   ////////////////////////////////////////////////////////////////////////
   //
@@ -232,14 +363,19 @@ namespace Realm {
     ID id(args.id);
     if(id.is_instance()) {
       RegionInstanceImpl *impl = get_runtime()->get_instance_impl(args.id);
-      impl->metadata.handle_request(args.node);
+      if(!impl->metadata.handle_request(args.node, args.push)) {
+	log_metadata.debug("metadata for " IDFMT " already on node %d - push skipped",
+			   args.id, args.node);
+	return;
+      }
       data = impl->metadata.serialize(datalen);
     } else {
       assert(0);
     }
 
-    log_metadata.info("metadata for " IDFMT " requested by %d - %zd bytes",
-		      args.id, args.node, datalen);
+    log_metadata.info("metadata for " IDFMT " %s %d - %zd bytes",
+		      args.id, (args.push ? "pushed to" : "requested by"),
+		      args.node, datalen);
     MetadataResponseMessage::send_request(args.node, args.id, data, datalen, PAYLOAD_FREE);
   }
 
@@ -248,10 +384,26 @@ namespace Realm {
     RequestArgs args;
 
     args.node = gasnet_mynode();
+    args.push = 0;
     args.id = id;
     Message::request(target, args);
   }
 
+  /*static*/ void MetadataRequestMessage::send_push(gasnet_node_t owner, ID::IDType id,
+						   gasnet_node_t target)
+  {
+    RequestArgs args;
+
+    args.node = target;
+    args.push = 1;
+    args.id = id;
+    // the owner can send the data itself
+    if(owner == gasnet_mynode())
+      handle_request(args);
+    else
+      Message::request(owner, args);
+  }
+
   
   ////////////////////////////////////////////////////////////////////////
   //
@@ -270,7 +422,9 @@ namespace Realm {
     if(id.is_instance()) {
       RegionInstanceImpl *impl = get_runtime()->get_instance_impl(args.id);
       impl->metadata.deserialize(data, datalen);
-      impl->metadata.handle_response();
+      if(impl->metadata.handle_response(id.instance.owner_node, args.id) &&
+	 (Config::metadata_cache_size > 0))
+	metadata_cache.insert(args.id);
     } else {
       assert(0);
     }
@@ -304,6 +458,8 @@ namespace Realm {
     if(id.is_instance()) {
       RegionInstanceImpl *impl = get_runtime()->get_instance_impl(args.id);
       impl->metadata.handle_invalidate();
+      if(Config::metadata_cache_size > 0)
+	metadata_cache.remove(args.id);
     } else {
       assert(0);
     }
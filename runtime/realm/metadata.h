@@ -24,6 +24,9 @@
 
 #include "activemsg.h"
 
+#include <list>
+#include <map>
+
 namespace Realm {
 
   class GenEventImpl;
@@ -41,15 +44,25 @@ namespace Realm {
 
       bool is_valid(void) const { return state == STATE_VALID; }
 
+      // true if any other node holds a copy of this metadata
+      bool has_remote_copies(void) const { return !remote_copies.empty(); }
+
       void mark_valid(void); // used by owner
-      void handle_request(int requestor);
+      // returns false if this was an unsolicited push to a node that already
+      //  has (or is being sent) a copy
+      bool handle_request(int requestor, bool push = false);
 
       // returns an Event for when data will be valid
       Event request_data(int owner, ID::IDType id);
       void await_data(bool block = true);  // request must have already been made
-      void handle_response(void);
+      // returns true if the data was not already valid
+      bool handle_response(int owner, ID::IDType id);
       void handle_invalidate(void);
 
+      // drops a valid remote copy (used by the metadata cache) - returns
+      //  true if the owner needs to be told
+      bool evict(void);
+
       // these return true once all remote copies have been invalidated
       bool initiate_cleanup(ID::IDType id);
       bool handle_inval_ack(int sender);
@@ -59,13 +72,41 @@ namespace Realm {
       State state;  // current state
       Event valid_event;
       NodeSet remote_copies;
+      // where a remote copy came from, so that an evicted copy can be re-fetched
+      int fetch_owner;
+      ID::IDType fetch_id;
+    };
+
+    // bounds the number of remote metadata copies a node keeps valid,
+    //  evicting the least recently used ones (see Config::metadata_cache_size)
+    class MetadataCache {
+    public:
+      MetadataCache(void);
+
+      // records that 'id' has just become valid locally, evicting others
+      //  if the cache is now over its limit
+      void insert(ID::IDType id);
+
+      // marks 'id' as recently used
+      void touch(ID::IDType id);
+
+      // forgets about 'id' (e.g. because it was invalidated by its owner)
+      void remove(ID::IDType id);
+
+    protected:
+      GASNetHSL mutex;
+      std::list<ID::IDType> lru;  // most recently used at the front
+      std::map<ID::IDType, std::list<ID::IDType>::iterator> entries;
     };
 
+    extern MetadataCache metadata_cache;
+
     // active messages
     
     struct MetadataRequestMessage {
       struct RequestArgs {
 	int node;
+	int push;
 	ID::IDType id;
       };
 
@@ -76,6 +117,9 @@ namespace Realm {
 					handle_request> Message;
 
       static void send_request(gasnet_node_t target, ID::IDType id);
+
+      // asks 'owner' to send its metadata for 'id' to 'target' unprompted
+      static void send_push(gasnet_node_t owner, ID::IDType id, gasnet_node_t target);
     };
 
     struct MetadataResponseMessage {
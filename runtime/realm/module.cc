@@ -99,6 +99,14 @@ namespace Realm {
     log_module.debug() << "module " << name << " create_code_translators";
   }
 
+  void Module::register_external_memory(MemoryImpl *mem, void *ptr, size_t size)
+  {
+  }
+
+  void Module::unregister_external_memory(MemoryImpl *mem, void *ptr, size_t size)
+  {
+  }
+
   void Module::cleanup(void)
   {
     log_module.debug() << "module " << name << " cleanup";
@@ -31,6 +31,7 @@
 namespace Realm {
 
   class RuntimeImpl;
+  class MemoryImpl;
 
   class Module {
   protected:
@@ -73,6 +74,12 @@ namespace Realm {
     // create any code translators provided by the module (default == do nothing)
     virtual void create_code_translators(RuntimeImpl *runtime);
 
+    // called when an instance is created around (or is done with) storage
+    //  owned by the application in 'mem', e.g. so that a module whose devices
+    //  expect everything in 'mem' to be pinned can pin the new range too
+    virtual void register_external_memory(MemoryImpl *mem, void *ptr, size_t size);
+    virtual void unregister_external_memory(MemoryImpl *mem, void *ptr, size_t size);
+
     // clean up any common resources created by the module - this will be called
     //  after all memories/processors/etc. have been shut down and destroyed
     virtual void cleanup(void);
@@ -88,9 +88,15 @@ namespace Realm {
       : Module("numa")
       , cfg_numa_mem_size_in_mb(0)
       , cfg_numa_nocpu_mem_size_in_mb(-1)
+      , cfg_interleave_mem_size_in_mb(0)
+      , cfg_first_touch_mem_size_in_mb(0)
       , cfg_num_numa_cpus(0)
       , cfg_pin_memory(false)
       , cfg_stack_size_in_mb(2)
+      , interleave_mem_base(0)
+      , first_touch_mem_base(0)
+      , interleave_mem(0)
+      , first_touch_mem(0)
     {
     }
       
@@ -111,6 +117,8 @@ namespace Realm {
 	cp.add_option_int("-ll:nsize", m->cfg_numa_mem_size_in_mb)
 	  .add_option_int("-ll:ncsize", m->cfg_numa_nocpu_mem_size_in_mb)
 	  .add_option_int("-ll:ncpu", m->cfg_num_numa_cpus)
+	  .add_option_int("-numa:isize", m->cfg_interleave_mem_size_in_mb)
+	  .add_option_int("-numa:ftsize", m->cfg_first_touch_mem_size_in_mb)
 	  .add_option_bool("-numa:pin", m->cfg_pin_memory);
 	
 	bool ok = cp.parse_command_line(cmdline);
@@ -121,7 +129,9 @@ namespace Realm {
       }
 
       // if neither NUMA memory nor cpus was requested, there's no point
-      if((m->cfg_numa_mem_size_in_mb == 0) && (m->cfg_numa_nocpu_mem_size_in_mb == 0) && (m->cfg_num_numa_cpus == 0)) {
+      if((m->cfg_numa_mem_size_in_mb == 0) && (m->cfg_numa_nocpu_mem_size_in_mb == 0) &&
+	 (m->cfg_interleave_mem_size_in_mb == 0) && (m->cfg_first_touch_mem_size_in_mb == 0) &&
+	 (m->cfg_num_numa_cpus == 0)) {
 	log_numa.debug() << "no NUMA memory or cpus requested";
 	delete m;
 	return 0;
@@ -151,6 +161,9 @@ namespace Realm {
 	const NumaNodeMemInfo& mi = it->second;
 	log_numa.info() << "NUMA memory node " << mi.node_id << ": " << (mi.bytes_available >> 20) << " MB";
 
+	// the interleaved memory (if any) spreads across every node we can see
+	m->interleave_nodes.push_back(mi.node_id);
+
 	size_t mem_size = (m->cfg_numa_mem_size_in_mb << 20);
 	if(m->cfg_numa_nocpu_mem_size_in_mb >= 0) {
 	  // use this value instead if there are no cpus in this domain
@@ -208,6 +221,29 @@ namespace Realm {
 	}
 	it->second = base;
       }
+
+      if(cfg_interleave_mem_size_in_mb > 0) {
+	size_t mem_size = cfg_interleave_mem_size_in_mb << 20;
+	interleave_mem_base = numasysif_alloc_interleaved_mem(interleave_nodes,
+							      mem_size,
+							      cfg_pin_memory);
+	if(!interleave_mem_base) {
+	  log_numa.fatal() << "allocation of " << mem_size << " bytes interleaved across " << interleave_nodes.size() << " NUMA nodes failed!";
+	  assert(false);
+	}
+      }
+
+      if(cfg_first_touch_mem_size_in_mb > 0) {
+	size_t mem_size = cfg_first_touch_mem_size_in_mb << 20;
+	// pinning would touch every page from this thread
+	if(cfg_pin_memory)
+	  log_numa.warning() << "first-touch NUMA memory cannot be pinned - ignoring -numa:pin for it";
+	first_touch_mem_base = numasysif_alloc_first_touch_mem(mem_size);
+	if(!first_touch_mem_base) {
+	  log_numa.fatal() << "allocation of " << mem_size << " bytes of first-touch NUMA memory failed!";
+	  assert(false);
+	}
+      }
     }
 
     // create any memories provided by this module (default == do nothing)
@@ -232,6 +268,26 @@ namespace Realm {
 	runtime->add_memory(numamem);
 	memories[mem_node] = numamem;
       }
+
+      if(interleave_mem_base) {
+	Memory m = runtime->next_local_memory_id();
+	interleave_mem = new LocalCPUMemory(m,
+					    cfg_interleave_mem_size_in_mb << 20,
+					    interleave_mem_base,
+					    false /*!registered*/);
+	runtime->add_memory(interleave_mem);
+	log_numa.info() << "interleaved NUMA memory: " << m;
+      }
+
+      if(first_touch_mem_base) {
+	Memory m = runtime->next_local_memory_id();
+	first_touch_mem = new LocalCPUMemory(m,
+					     cfg_first_touch_mem_size_in_mb << 20,
+					     first_touch_mem_base,
+					     false /*!registered*/);
+	runtime->add_memory(first_touch_mem);
+	log_numa.info() << "first-touch NUMA memory: " << m;
+      }
     }
 
     // create any processors provided by the module (default == do nothing)
@@ -267,16 +323,7 @@ namespace Realm {
 	    pma.p = p;
 	    pma.m = (*it2)->me;
 
-	    int mem_node = -1;
-	    for(std::map<int, MemoryImpl *>::const_iterator it3 = memories.begin();
-		it3 != memories.end();
-		++it3)
-	      if(it3->second == *it2) {
-		mem_node = it3->first;
-		break;
-	      }
-
-	    if(mem_node == -1) {
+	    if(!get_affinity(cpu_node, *it2, pma)) {
 	      // not one of our memories - use the same made-up numbers as in
 	      //  runtime_impl.cc
 	      if(kind == Memory::SYSTEM_MEM) {
@@ -289,16 +336,6 @@ namespace Realm {
 	      // FIXME: once the stuff in runtime_impl.cc is removed, remove
 	      //  this 'continue' so that we create affinities here
 	      continue;
-	    } else {
-	      int d = numasysif_get_distance(cpu_node, mem_node);
-	      if(d >= 0) {
-		pma.bandwidth = 150 - d;
-		pma.latency = d / 10;     // Linux uses a cost of ~10/hop
-	      } else {
-		// same as random sysmem
-		pma.bandwidth = 100;
-		pma.latency = 5;
-	      }
 	    }
 	    
 	    runtime->add_proc_mem_affinity(pma);
@@ -307,6 +344,67 @@ namespace Realm {
       }
     }
     
+    bool NumaModule::get_affinity(int cpu_node, MemoryImpl *mem,
+				  Machine::ProcessorMemoryAffinity& pma) const
+    {
+      int mem_node = -1;
+      for(std::map<int, MemoryImpl *>::const_iterator it = memories.begin();
+	  it != memories.end();
+	  ++it)
+	if(it->second == mem) {
+	  mem_node = it->first;
+	  break;
+	}
+
+      if(mem == interleave_mem) {
+	// pages are spread evenly, so use the average distance to the
+	//  nodes they come from
+	int total = 0;
+	int count = 0;
+	for(std::vector<int>::const_iterator it = interleave_nodes.begin();
+	    it != interleave_nodes.end();
+	    ++it) {
+	  int d = numasysif_get_distance(cpu_node, *it);
+	  if(d >= 0) {
+	    total += d;
+	    count++;
+	  }
+	}
+	if(count > 0) {
+	  int d = total / count;
+	  pma.bandwidth = 150 - d;
+	  pma.latency = d / 10;
+	} else {
+	  pma.bandwidth = 100;
+	  pma.latency = 5;
+	}
+      } else if(mem == first_touch_mem) {
+	// a processor initializing its own data gets it on its own
+	//  node, so this looks like the local NUMA memory
+	int d = numasysif_get_distance(cpu_node, cpu_node);
+	if(d >= 0) {
+	  pma.bandwidth = 150 - d;
+	  pma.latency = d / 10;
+	} else {
+	  pma.bandwidth = 100;
+	  pma.latency = 5;
+	}
+      } else if(mem_node == -1) {
+	return false;
+      } else {
+	int d = numasysif_get_distance(cpu_node, mem_node);
+	if(d >= 0) {
+	  pma.bandwidth = 150 - d;
+	  pma.latency = d / 10;     // Linux uses a cost of ~10/hop
+	} else {
+	  // same as random sysmem
+	  pma.bandwidth = 100;
+	  pma.latency = 5;
+	}
+      }
+      return true;
+    }
+
     // create any DMA channels provided by the module (default == do nothing)
     void NumaModule::create_dma_channels(RuntimeImpl *runtime)
     {
@@ -335,6 +433,20 @@ namespace Realm {
 	if(!ok)
 	  log_numa.error() << "failed to free memory in NUMA node " << it->first << ": ptr=" << it->second;
       }
+
+      if(interleave_mem_base) {
+	bool ok = numasysif_free_mem(-1, interleave_mem_base,
+				     cfg_interleave_mem_size_in_mb << 20);
+	if(!ok)
+	  log_numa.error() << "failed to free interleaved NUMA memory: ptr=" << interleave_mem_base;
+      }
+
+      if(first_touch_mem_base) {
+	bool ok = numasysif_free_mem(-1, first_touch_mem_base,
+				     cfg_first_touch_mem_size_in_mb << 20);
+	if(!ok)
+	  log_numa.error() << "failed to free first-touch NUMA memory: ptr=" << first_touch_mem_base;
+      }
     }
 
   }; // namespace Numa
@@ -57,9 +57,17 @@ namespace Realm {
       //  after all memories/processors/etc. have been shut down and destroyed
       virtual void cleanup(void);
 
+      // fills in the bandwidth/latency of 'pma' for a processor whose
+      //  cores are in 'cpu_node' accessing 'mem' - returns false if 'mem'
+      //  is not one of this module's memories
+      bool get_affinity(int cpu_node, MemoryImpl *mem,
+			Machine::ProcessorMemoryAffinity& pma) const;
+
     public:
       size_t cfg_numa_mem_size_in_mb;
       ssize_t cfg_numa_nocpu_mem_size_in_mb;
+      size_t cfg_interleave_mem_size_in_mb;
+      size_t cfg_first_touch_mem_size_in_mb;
       int cfg_num_numa_cpus;
       bool cfg_pin_memory;
       size_t cfg_stack_size_in_mb;
@@ -69,6 +77,15 @@ namespace Realm {
       std::map<int, size_t> numa_mem_sizes;
       std::map<int, int> numa_cpu_counts;
       std::map<int, MemoryImpl *> memories;
+
+      // a memory interleaved across all the NUMA nodes (for data shared by
+      //  every socket) and one placed by first touch (for data that is
+      //  initialized by the processor that owns it) - both optional
+      std::vector<int> interleave_nodes;
+      void *interleave_mem_base;
+      void *first_touch_mem_base;
+      MemoryImpl *interleave_mem;
+      MemoryImpl *first_touch_mem;
     };
 
     REGISTER_REALM_MODULE(NumaModule);
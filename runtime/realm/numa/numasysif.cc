@@ -291,6 +291,80 @@ namespace Realm {
 #endif
   }
 
+  // allocate memory whose pages are interleaved across the given NUMA nodes -
+  //  pin if requested
+  void *numasysif_alloc_interleaved_mem(const std::vector<int>& nodes,
+					size_t bytes, bool pin)
+  {
+#ifdef __linux__
+    unsigned long nmask = 0;
+    for(std::vector<int>::const_iterator it = nodes.begin();
+	it != nodes.end();
+	++it)
+      nmask |= (1UL << *it);
+    if(nmask == 0) return 0;
+
+    void *base = mmap(0,
+		      bytes, 
+		      PROT_READ | PROT_WRITE,
+		      MAP_PRIVATE | MAP_ANONYMOUS,
+		      -1,
+		      0);
+    if(base == MAP_FAILED) return 0;
+
+    int ret = mbind(base, bytes,
+		    MPOL_INTERLEAVE, &nmask, 8*sizeof(nmask),
+		    MPOL_MF_STRICT | MPOL_MF_MOVE);
+    if(ret != 0) {
+      fprintf(stderr, "failed to interleave memory across nodes %08lx: %s\n", nmask, strerror(errno));
+      munmap(base, bytes);
+      return 0;
+    }
+
+    if(pin) {
+      int ret = mlock(base, bytes);
+      if(ret != 0) {
+	fprintf(stderr, "mlock failed for interleaved memory: %s\n", strerror(errno));
+	munmap(base, bytes);
+	return 0;
+      }
+    }
+
+    return base;
+#else
+    return 0;
+#endif
+  }
+
+  // allocate memory whose pages are placed on the NUMA node of whichever
+  //  thread touches them first (it can't be pinned without touching it)
+  void *numasysif_alloc_first_touch_mem(size_t bytes)
+  {
+#ifdef __linux__
+    void *base = mmap(0,
+		      bytes, 
+		      PROT_READ | PROT_WRITE,
+		      MAP_PRIVATE | MAP_ANONYMOUS,
+		      -1,
+		      0);
+    if(base == MAP_FAILED) return 0;
+
+    // a preferred policy with an empty mask means "local allocation", which
+    //  overrides any binding inherited from the process (e.g. via numactl)
+    int ret = mbind(base, bytes,
+		    MPOL_PREFERRED, 0, 0, 0);
+    if(ret != 0) {
+      fprintf(stderr, "failed to set local allocation policy: %s\n", strerror(errno));
+      munmap(base, bytes);
+      return 0;
+    }
+
+    return base;
+#else
+    return 0;
+#endif
+  }
+
   // free memory allocated on a given NUMA node
   bool numasysif_free_mem(int node, void *base, size_t bytes)
   {
@@ -23,6 +23,7 @@
 
 #include <cstdlib>
 #include <map>
+#include <vector>
 
 namespace Realm {
 
@@ -54,6 +55,15 @@ namespace Realm {
   // allocate memory on a given NUMA node - pin if requested
   void *numasysif_alloc_mem(int node, size_t bytes, bool pin);
 
+  // allocate memory whose pages are interleaved across the given NUMA nodes -
+  //  pin if requested
+  void *numasysif_alloc_interleaved_mem(const std::vector<int>& nodes,
+					size_t bytes, bool pin);
+
+  // allocate memory whose pages are placed on the NUMA node of whichever
+  //  thread touches them first (it can't be pinned without touching it)
+  void *numasysif_alloc_first_touch_mem(size_t bytes);
+
   // free memory allocated on a given NUMA node
   bool numasysif_free_mem(int node, void *base, size_t bytes);
 
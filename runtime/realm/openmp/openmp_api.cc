@@ -19,6 +19,9 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <alloca.h>
 
 namespace Realm {
   extern Logger log_omp;
@@ -64,12 +67,16 @@ namespace Realm {
 	return;
       }
 
+      // busy-wait team fast path (if enabled)
+      if(wi->pool->start_team(nthreads, fnptr, data))
+	return;
+
       std::set<int> worker_ids;
       wi->pool->claim_workers(nthreads - 1, worker_ids);
       int act_threads = 1 + worker_ids.size();
 
       ThreadPool::WorkItem *work = new ThreadPool::WorkItem;
-      work->remaining_workers = act_threads;
+      work->reset(act_threads);
       wi->push_work_item(work);
 
       wi->thread_id = 0;
@@ -93,6 +100,12 @@ namespace Realm {
       if(!wi)
 	return;
 
+      if(wi->pool->end_team())
+	return;
+
+      // tasks spawned in the region must complete before it ends
+      ThreadPool::drain_tasks();
+
       ThreadPool::WorkItem *work = wi->pop_work_item();
       assert(work != 0);
       // make sure all workers have finished
@@ -110,6 +123,211 @@ namespace Realm {
       fnptr(data);
       GOMP_parallel_end();
     }
+
+    void GOMP_barrier(void)
+    {
+      Realm::ThreadPool::WorkerInfo *wi = Realm::ThreadPool::get_worker_info();
+      if(wi)
+	wi->pool->barrier();
+    }
+
+    // GOMP_TASK_FLAG_DEPEND
+    static const unsigned GOMP_TASK_DEPEND = 8;
+
+    // older compilers pass fewer arguments - 'depend' is only read when
+    //  the flag says it's there, and 'priority' is ignored
+    void GOMP_task(void (*fnptr)(void *data), void *data,
+		   void (*cpyfn)(void *dst, void *src),
+		   long arg_size, long arg_align, bool if_clause,
+		   unsigned flags, void **depend, int priority)
+    {
+      // we don't track dependences - instead wait for all of this task's
+      //  earlier siblings and then run it right away
+      if(flags & GOMP_TASK_DEPEND) {
+	ThreadPool::taskwait();
+	if_clause = false;
+      }
+
+      if(!if_clause) {
+	// undeferred - arguments only need to be copied if there's a
+	//  copy constructor to run
+	if(cpyfn) {
+	  char *buf = (char *)alloca(arg_size + arg_align - 1);
+	  char *arg = (char *)(((uintptr_t)buf + arg_align - 1) &
+			       ~(uintptr_t)(arg_align - 1));
+	  cpyfn(arg, data);
+	  fnptr(arg);
+	} else
+	  fnptr(data);
+	return;
+      }
+
+      char *buf = (char *)malloc(arg_size + arg_align - 1);
+      char *arg = (char *)(((uintptr_t)buf + arg_align - 1) &
+			   ~(uintptr_t)(arg_align - 1));
+      if(cpyfn)
+	cpyfn(arg, data);
+      else
+	memcpy(arg, data, arg_size);
+      ThreadPool::spawn_task(fnptr, arg, buf);
+    }
+
+    void GOMP_taskwait(void)
+    {
+      ThreadPool::taskwait();
+    }
+
+    void GOMP_taskyield(void)
+    {
+      ThreadPool::run_one_task();
+    }
+
+    // loop bounds in GOMP are [start, end) with an arbitrary increment
+    static bool gomp_loop_start(int schedule, long start, long end,
+				long incr, long chunk)
+    {
+      uint64_t count;
+      if(incr > 0)
+	count = (end > start) ? ((uint64_t)(end - start) + incr - 1) / incr : 0;
+      else
+	count = (start > end) ? ((uint64_t)(start - end) - incr - 1) / -incr : 0;
+      ThreadPool::loop_start(schedule, start, incr, count,
+			     (chunk > 0) ? chunk : 1);
+      return true;
+    }
+
+    static bool gomp_loop_next(long *istart, long *iend)
+    {
+      int64_t lo, hi;
+      if(!ThreadPool::loop_next(lo, hi))
+	return false;
+      *istart = lo;
+      *iend = hi;
+      return true;
+    }
+
+    bool GOMP_loop_dynamic_start(long start, long end, long incr, long chunk,
+				 long *istart, long *iend)
+    {
+      gomp_loop_start(ThreadPool::LOOP_DYNAMIC, start, end, incr, chunk);
+      return gomp_loop_next(istart, iend);
+    }
+
+    bool GOMP_loop_dynamic_next(long *istart, long *iend)
+    {
+      return gomp_loop_next(istart, iend);
+    }
+
+    bool GOMP_loop_nonmonotonic_dynamic_start(long start, long end, long incr,
+					      long chunk,
+					      long *istart, long *iend)
+    {
+      return GOMP_loop_dynamic_start(start, end, incr, chunk, istart, iend);
+    }
+
+    bool GOMP_loop_nonmonotonic_dynamic_next(long *istart, long *iend)
+    {
+      return gomp_loop_next(istart, iend);
+    }
+
+    bool GOMP_loop_guided_start(long start, long end, long incr, long chunk,
+				long *istart, long *iend)
+    {
+      gomp_loop_start(ThreadPool::LOOP_GUIDED, start, end, incr, chunk);
+      return gomp_loop_next(istart, iend);
+    }
+
+    bool GOMP_loop_guided_next(long *istart, long *iend)
+    {
+      return gomp_loop_next(istart, iend);
+    }
+
+    bool GOMP_loop_nonmonotonic_guided_start(long start, long end, long incr,
+					     long chunk,
+					     long *istart, long *iend)
+    {
+      return GOMP_loop_guided_start(start, end, incr, chunk, istart, iend);
+    }
+
+    bool GOMP_loop_nonmonotonic_guided_next(long *istart, long *iend)
+    {
+      return gomp_loop_next(istart, iend);
+    }
+
+    // there's no OMP_SCHEDULE support, so 'runtime' means dynamic,1
+    bool GOMP_loop_runtime_start(long start, long end, long incr,
+				 long *istart, long *iend)
+    {
+      return GOMP_loop_dynamic_start(start, end, incr, 1, istart, iend);
+    }
+
+    bool GOMP_loop_runtime_next(long *istart, long *iend)
+    {
+      return gomp_loop_next(istart, iend);
+    }
+
+    void GOMP_loop_end(void)
+    {
+      GOMP_barrier();
+    }
+
+    void GOMP_loop_end_nowait(void)
+    {
+      // nothing to do
+    }
+
+    // combined parallel loops - threads go straight to *_next, so the
+    //  master sets up the loop (on behalf of the team) before running
+    //  its own share
+    void GOMP_parallel_loop_dynamic(void (*fnptr)(void *data), void *data,
+				    unsigned nthreads, long start, long end,
+				    long incr, long chunk, unsigned flags)
+    {
+      GOMP_parallel_start(fnptr, data, nthreads);
+      gomp_loop_start(ThreadPool::LOOP_DYNAMIC, start, end, incr, chunk);
+      fnptr(data);
+      GOMP_parallel_end();
+    }
+
+    void GOMP_parallel_loop_nonmonotonic_dynamic(void (*fnptr)(void *data),
+						 void *data,
+						 unsigned nthreads,
+						 long start, long end,
+						 long incr, long chunk,
+						 unsigned flags)
+    {
+      GOMP_parallel_loop_dynamic(fnptr, data, nthreads,
+				 start, end, incr, chunk, flags);
+    }
+
+    void GOMP_parallel_loop_guided(void (*fnptr)(void *data), void *data,
+				   unsigned nthreads, long start, long end,
+				   long incr, long chunk, unsigned flags)
+    {
+      GOMP_parallel_start(fnptr, data, nthreads);
+      gomp_loop_start(ThreadPool::LOOP_GUIDED, start, end, incr, chunk);
+      fnptr(data);
+      GOMP_parallel_end();
+    }
+
+    void GOMP_parallel_loop_nonmonotonic_guided(void (*fnptr)(void *data),
+						void *data,
+						unsigned nthreads,
+						long start, long end,
+						long incr, long chunk,
+						unsigned flags)
+    {
+      GOMP_parallel_loop_guided(fnptr, data, nthreads,
+				start, end, incr, chunk, flags);
+    }
+
+    void GOMP_parallel_loop_runtime(void (*fnptr)(void *data), void *data,
+				    unsigned nthreads, long start, long end,
+				    long incr, unsigned flags)
+    {
+      GOMP_parallel_loop_dynamic(fnptr, data, nthreads,
+				 start, end, incr, 1, flags);
+    }
   };
 #endif
 
@@ -165,11 +383,87 @@ namespace Realm {
 
     void __kmpc_serialized_parallel(ident_t *loc, kmp_int32 global_tid);
     void __kmpc_end_serialized_parallel(ident_t *loc, kmp_int32 global_tid);
+
+    void __kmpc_barrier(ident_t *loc, kmp_int32 global_tid);
+
+    void __kmpc_dispatch_init_4(ident_t *loc, kmp_int32 gtid,
+				kmp_int32 schedule,
+				kmp_int32 lb, kmp_int32 ub,
+				kmp_int32 st, kmp_int32 chunk);
+    void __kmpc_dispatch_init_4u(ident_t *loc, kmp_int32 gtid,
+				 kmp_int32 schedule,
+				 kmp_uint32 lb, kmp_uint32 ub,
+				 kmp_int32 st, kmp_int32 chunk);
+    void __kmpc_dispatch_init_8(ident_t *loc, kmp_int32 gtid,
+				kmp_int32 schedule,
+				kmp_int64 lb, kmp_int64 ub,
+				kmp_int64 st, kmp_int64 chunk);
+    void __kmpc_dispatch_init_8u(ident_t *loc, kmp_int32 gtid,
+				 kmp_int32 schedule,
+				 kmp_uint64 lb, kmp_uint64 ub,
+				 kmp_int64 st, kmp_int64 chunk);
+    int __kmpc_dispatch_next_4(ident_t *loc, kmp_int32 gtid,
+			       kmp_int32 *p_last,
+			       kmp_int32 *p_lb, kmp_int32 *p_ub,
+			       kmp_int32 *p_st);
+    int __kmpc_dispatch_next_4u(ident_t *loc, kmp_int32 gtid,
+				kmp_int32 *p_last,
+				kmp_uint32 *p_lb, kmp_uint32 *p_ub,
+				kmp_int32 *p_st);
+    int __kmpc_dispatch_next_8(ident_t *loc, kmp_int32 gtid,
+			       kmp_int32 *p_last,
+			       kmp_int64 *p_lb, kmp_int64 *p_ub,
+			       kmp_int64 *p_st);
+    int __kmpc_dispatch_next_8u(ident_t *loc, kmp_int32 gtid,
+				kmp_int32 *p_last,
+				kmp_uint64 *p_lb, kmp_uint64 *p_ub,
+				kmp_int64 *p_st);
+    void __kmpc_dispatch_fini_4(ident_t *loc, kmp_int32 gtid);
+    void __kmpc_dispatch_fini_4u(ident_t *loc, kmp_int32 gtid);
+    void __kmpc_dispatch_fini_8(ident_t *loc, kmp_int32 gtid);
+    void __kmpc_dispatch_fini_8u(ident_t *loc, kmp_int32 gtid);
+
+    struct kmp_task;
+    typedef kmp_int32 (*kmp_routine_entry)(kmp_int32 gtid, void *task);
+
+    kmp_task *__kmpc_omp_task_alloc(ident_t *loc, kmp_int32 gtid,
+				    kmp_int32 flags,
+				    size_t sizeof_kmp_task_t,
+				    size_t sizeof_shareds,
+				    kmp_routine_entry task_entry);
+    kmp_int32 __kmpc_omp_task(ident_t *loc, kmp_int32 gtid,
+			      kmp_task *new_task);
+    void __kmpc_omp_task_begin_if0(ident_t *loc, kmp_int32 gtid,
+				   kmp_task *task);
+    void __kmpc_omp_task_complete_if0(ident_t *loc, kmp_int32 gtid,
+				      kmp_task *task);
+    kmp_int32 __kmpc_omp_task_with_deps(ident_t *loc, kmp_int32 gtid,
+					kmp_task *new_task,
+					kmp_int32 ndeps, void *dep_list,
+					kmp_int32 ndeps_noalias,
+					void *noalias_dep_list);
+    void __kmpc_omp_wait_deps(ident_t *loc, kmp_int32 gtid,
+			      kmp_int32 ndeps, void *dep_list,
+			      kmp_int32 ndeps_noalias,
+			      void *noalias_dep_list);
+    kmp_int32 __kmpc_omp_taskwait(ident_t *loc, kmp_int32 gtid);
+    kmp_int32 __kmpc_omp_taskyield(ident_t *loc, kmp_int32 gtid,
+				   int end_part);
+  };
+
+  // start of the compiler's task descriptor - private data follows
+  struct kmp_task {
+    void *shareds;
+    kmp_routine_entry routine;
+    kmp_int32 part_id;
   };
 
   struct kmp_thunk {
+    static const int MAX_ARGS = 10;
+
     kmpc_micro microtask;
-    std::vector<void *> argv;
+    // fixed-size to keep the fork path free of heap allocation
+    void *argv[MAX_ARGS];
 
     static void invoke_0(void *data)
     {
@@ -329,11 +623,11 @@ namespace Realm {
     // capture variable length arguments into thunk
     kmp_thunk thunk;
     thunk.microtask = microtask;
-    {
+    if(argc <= kmp_thunk::MAX_ARGS) {
       va_list ap;
       va_start(ap, microtask);
       for(int i = 0; i < argc; i++)
-	thunk.argv.push_back(va_arg(ap, void *));
+	thunk.argv[i] = va_arg(ap, void *);
       va_end(ap);
     }
     void (*invoker)(void *data);
@@ -364,13 +658,21 @@ namespace Realm {
       return;
     }
 
+    // busy-wait team fast path (if enabled)
+    if(wi->pool->start_team(-1, invoker, &thunk)) {
+      (*invoker)(&thunk);
+      bool ok = wi->pool->end_team();
+      assert(ok);
+      return;
+    }
+
     std::set<int> worker_ids;
     // TODO: thread limit comes from where?
     wi->pool->claim_workers(-1, worker_ids);
     int act_threads = 1 + worker_ids.size();
 
     ThreadPool::WorkItem *work = new ThreadPool::WorkItem;
-    work->remaining_workers = act_threads;
+    work->reset(act_threads);
     wi->push_work_item(work);
 
     wi->thread_id = 0;
@@ -387,6 +689,7 @@ namespace Realm {
     (*invoker)(&thunk);
 
     // and then we immediately clean things up (c.f. GOMP_parallel_end)
+    ThreadPool::drain_tasks();
     ThreadPool::WorkItem *work2 = wi->pop_work_item();
     assert(work == work2);
     // make sure all workers have finished
@@ -440,6 +743,27 @@ namespace Realm {
 	return;
       }
 
+    case 33 /* kmp_sch_static_chunked */:
+      {
+	// round-robin chunks - the caller clamps *pupper to the loop bound
+	//  and steps both bounds by *pstride
+	if(chunk < 1)
+	  chunk = 1;
+	T iters;
+	if(incr > 0) {
+	  iters = 1 + (*pupper - *plower) / incr;
+	} else {
+	  iters = 1 + (*plower - *pupper) / -incr;
+	}
+	T span = chunk * incr;
+	*plower += span * wi->thread_id;
+	*pupper = *plower + span - incr;
+	*pstride = span * wi->num_threads;
+	*plastiter = ((((iters - 1) / chunk) % wi->num_threads) ==
+		      ((T)(wi->thread_id)));
+	return;
+      }
+
     default: assert(false);
     }
   }
@@ -518,7 +842,7 @@ namespace Realm {
 
     // create a new work item that is just this thread
     ThreadPool::WorkItem *work = new ThreadPool::WorkItem;
-    work->remaining_workers = 1;
+    work->reset(1);
     wi->push_work_item(work);
     wi->thread_id = 0;
     wi->num_threads = 1;
@@ -540,6 +864,228 @@ namespace Realm {
     assert(work->remaining_workers == 1);
     delete work;
   }
+
+  void __kmpc_barrier(ident_t *loc, kmp_int32 global_tid)
+  {
+    Realm::ThreadPool::WorkerInfo *wi = Realm::ThreadPool::get_worker_info();
+    if(wi)
+      wi->pool->barrier();
+  }
+
+  // templated code for __kmpc_dispatch_init_{4,4u,8,8u} - bounds are
+  //  inclusive, and every schedule is served from the shared iteration
+  //  counter (static ones as dynamic with an even split)
+  template <typename T, typename ST>
+  static inline void kmpc_dispatch_init(kmp_int32 schedule,
+					T lb, T ub, ST st, ST chunk)
+  {
+    // strip the monotonic/nonmonotonic modifiers and ordered variants
+    //  (ordered isn't supported, so those are just scheduled normally)
+    schedule &= ~((1 << 29) | (1 << 30));
+    if(schedule > 64)
+      schedule -= 32;
+
+    uint64_t count;
+    if(st > 0)
+      count = (ub < lb) ? 0 : ((uint64_t)ub - (uint64_t)lb) / st + 1;
+    else
+      count = (lb < ub) ? 0 : ((uint64_t)lb - (uint64_t)ub) / -st + 1;
+
+    int kind = ThreadPool::LOOP_DYNAMIC;
+    uint64_t chunk_size = (chunk > 0) ? chunk : 1;
+    switch(schedule) {
+    case 33 /* kmp_sch_static_chunked */:
+    case 35 /* kmp_sch_dynamic_chunked */:
+      break;
+
+    case 34 /* kmp_sch_static */:
+    case 40 /* kmp_sch_static_greedy */:
+    case 41 /* kmp_sch_static_balanced */:
+      {
+	int nthreads = omp_get_num_threads();
+	chunk_size = (count + nthreads - 1) / nthreads;
+	break;
+      }
+
+    case 36 /* kmp_sch_guided_chunked */:
+    case 38 /* kmp_sch_auto */:
+    case 39 /* kmp_sch_trapezoidal */:
+    case 42 /* kmp_sch_guided_iterative_chunked */:
+    case 43 /* kmp_sch_guided_analytical_chunked */:
+      kind = ThreadPool::LOOP_GUIDED;
+      break;
+
+    default:
+      // runtime and anything else - no OMP_SCHEDULE support
+      chunk_size = 1;
+      break;
+    }
+
+    ThreadPool::loop_start(kind, (int64_t)lb, (int64_t)st, count, chunk_size);
+  }
+
+  template <typename T, typename ST>
+  static inline int kmpc_dispatch_next(kmp_int32 *p_last,
+				       T *p_lb, T *p_ub, ST *p_st)
+  {
+    int64_t lo, hi, stride;
+    bool is_last;
+    if(!ThreadPool::loop_next(lo, hi, &stride, &is_last))
+      return 0;
+    // loop_next's range is half-open, kmp's is inclusive
+    *p_lb = (T)lo;
+    *p_ub = (T)((uint64_t)hi - (uint64_t)stride);
+    *p_st = (ST)stride;
+    if(p_last)
+      *p_last = is_last;
+    return 1;
+  }
+
+  void __kmpc_dispatch_init_4(ident_t *loc, kmp_int32 gtid,
+			      kmp_int32 schedule,
+			      kmp_int32 lb, kmp_int32 ub,
+			      kmp_int32 st, kmp_int32 chunk)
+  {
+    kmpc_dispatch_init<kmp_int32, kmp_int32>(schedule, lb, ub, st, chunk);
+  }
+
+  void __kmpc_dispatch_init_4u(ident_t *loc, kmp_int32 gtid,
+			       kmp_int32 schedule,
+			       kmp_uint32 lb, kmp_uint32 ub,
+			       kmp_int32 st, kmp_int32 chunk)
+  {
+    kmpc_dispatch_init<kmp_uint32, kmp_int32>(schedule, lb, ub, st, chunk);
+  }
+
+  void __kmpc_dispatch_init_8(ident_t *loc, kmp_int32 gtid,
+			      kmp_int32 schedule,
+			      kmp_int64 lb, kmp_int64 ub,
+			      kmp_int64 st, kmp_int64 chunk)
+  {
+    kmpc_dispatch_init<kmp_int64, kmp_int64>(schedule, lb, ub, st, chunk);
+  }
+
+  void __kmpc_dispatch_init_8u(ident_t *loc, kmp_int32 gtid,
+			       kmp_int32 schedule,
+			       kmp_uint64 lb, kmp_uint64 ub,
+			       kmp_int64 st, kmp_int64 chunk)
+  {
+    kmpc_dispatch_init<kmp_uint64, kmp_int64>(schedule, lb, ub, st, chunk);
+  }
+
+  int __kmpc_dispatch_next_4(ident_t *loc, kmp_int32 gtid,
+			     kmp_int32 *p_last,
+			     kmp_int32 *p_lb, kmp_int32 *p_ub,
+			     kmp_int32 *p_st)
+  {
+    return kmpc_dispatch_next<kmp_int32, kmp_int32>(p_last, p_lb, p_ub, p_st);
+  }
+
+  int __kmpc_dispatch_next_4u(ident_t *loc, kmp_int32 gtid,
+			      kmp_int32 *p_last,
+			      kmp_uint32 *p_lb, kmp_uint32 *p_ub,
+			      kmp_int32 *p_st)
+  {
+    return kmpc_dispatch_next<kmp_uint32, kmp_int32>(p_last, p_lb, p_ub, p_st);
+  }
+
+  int __kmpc_dispatch_next_8(ident_t *loc, kmp_int32 gtid,
+			     kmp_int32 *p_last,
+			     kmp_int64 *p_lb, kmp_int64 *p_ub,
+			     kmp_int64 *p_st)
+  {
+    return kmpc_dispatch_next<kmp_int64, kmp_int64>(p_last, p_lb, p_ub, p_st);
+  }
+
+  int __kmpc_dispatch_next_8u(ident_t *loc, kmp_int32 gtid,
+			      kmp_int32 *p_last,
+			      kmp_uint64 *p_lb, kmp_uint64 *p_ub,
+			      kmp_int64 *p_st)
+  {
+    return kmpc_dispatch_next<kmp_uint64, kmp_int64>(p_last, p_lb, p_ub, p_st);
+  }
+
+  // only called for ordered loops, which we schedule like any other
+  void __kmpc_dispatch_fini_4(ident_t *loc, kmp_int32 gtid) {}
+  void __kmpc_dispatch_fini_4u(ident_t *loc, kmp_int32 gtid) {}
+  void __kmpc_dispatch_fini_8(ident_t *loc, kmp_int32 gtid) {}
+  void __kmpc_dispatch_fini_8u(ident_t *loc, kmp_int32 gtid) {}
+
+  kmp_task *__kmpc_omp_task_alloc(ident_t *loc, kmp_int32 gtid,
+				  kmp_int32 flags,
+				  size_t sizeof_kmp_task_t,
+				  size_t sizeof_shareds,
+				  kmp_routine_entry task_entry)
+  {
+    // shareds go after the (compiler-sized) descriptor and privates
+    size_t shareds_offset = ((sizeof_kmp_task_t + sizeof(void *) - 1) &
+			     ~(sizeof(void *) - 1));
+    kmp_task *task = (kmp_task *)malloc(shareds_offset + sizeof_shareds);
+    assert(task != 0);
+    task->shareds = (sizeof_shareds ? ((char *)task + shareds_offset) : 0);
+    task->routine = task_entry;
+    task->part_id = 0;
+    return task;
+  }
+
+  static void kmp_task_invoke(void *data)
+  {
+    kmp_task *task = (kmp_task *)data;
+    (task->routine)(__kmpc_global_thread_num(0), task);
+  }
+
+  kmp_int32 __kmpc_omp_task(ident_t *loc, kmp_int32 gtid,
+			    kmp_task *new_task)
+  {
+    ThreadPool::spawn_task(&kmp_task_invoke, new_task, new_task);
+    return 0; // TASK_CURRENT_NOT_QUEUED
+  }
+
+  void __kmpc_omp_task_begin_if0(ident_t *loc, kmp_int32 gtid,
+				 kmp_task *task)
+  {
+    // caller runs the undeferred task itself
+  }
+
+  void __kmpc_omp_task_complete_if0(ident_t *loc, kmp_int32 gtid,
+				    kmp_task *task)
+  {
+    free(task);
+  }
+
+  kmp_int32 __kmpc_omp_task_with_deps(ident_t *loc, kmp_int32 gtid,
+				      kmp_task *new_task,
+				      kmp_int32 ndeps, void *dep_list,
+				      kmp_int32 ndeps_noalias,
+				      void *noalias_dep_list)
+  {
+    // dependences aren't tracked - satisfy them conservatively by waiting
+    //  for every earlier sibling and then running the task right away
+    ThreadPool::taskwait();
+    kmp_task_invoke(new_task);
+    free(new_task);
+    return 0;
+  }
+
+  void __kmpc_omp_wait_deps(ident_t *loc, kmp_int32 gtid,
+			    kmp_int32 ndeps, void *dep_list,
+			    kmp_int32 ndeps_noalias,
+			    void *noalias_dep_list)
+  {
+    ThreadPool::taskwait();
+  }
+
+  kmp_int32 __kmpc_omp_taskwait(ident_t *loc, kmp_int32 gtid)
+  {
+    ThreadPool::taskwait();
+    return 0;
+  }
+
+  kmp_int32 __kmpc_omp_taskyield(ident_t *loc, kmp_int32 gtid, int end_part)
+  {
+    ThreadPool::run_one_task();
+    return 0;
+  }
 #endif
 
 }; // namespace Realm
@@ -18,6 +18,7 @@
 #include "openmp_threadpool.h"
 
 #include "../numa/numasysif.h"
+#include "../numa/numa_module.h"
 #include "logging.h"
 #include "cmdline.h"
 #include "proc_impl.h"
@@ -40,6 +41,7 @@ namespace Realm {
   public:
     LocalOpenMPProcessor(Processor _me, int _numa_node,
 			 int _num_threads, bool _fake_cpukind,
+			 bool _busy_wait_team,
 			 CoreReservationSet& crs, size_t _stack_size);
     virtual ~LocalOpenMPProcessor(void);
 
@@ -58,6 +60,7 @@ namespace Realm {
   LocalOpenMPProcessor::LocalOpenMPProcessor(Processor _me, int _numa_node,
 					     int _num_threads,
 					     bool _fake_cpukind,
+					     bool _busy_wait_team,
 					     CoreReservationSet& crs,
 					     size_t _stack_size)
     : LocalTaskProcessor(_me, (_fake_cpukind ? Processor::LOC_PROC :
@@ -65,7 +68,7 @@ namespace Realm {
     , numa_node(_numa_node)
     , num_threads(_num_threads)
   {
-    pool = new ThreadPool(num_threads - 1);
+    pool = new ThreadPool(num_threads - 1, _busy_wait_team);
 
     // master runs in a user threads if possible
     {
@@ -157,6 +160,7 @@ namespace Realm {
       , cfg_use_numa(true)
       , cfg_fake_cpukind(false)
       , cfg_stack_size_in_mb(2)
+      , cfg_busy_wait_team(false)
     {
     }
       
@@ -178,7 +182,8 @@ namespace Realm {
 	  .add_option_int("-ll:othr", m->cfg_num_threads_per_cpu)
 	  .add_option_int("-ll:onuma", m->cfg_use_numa)
 	  .add_option_int("-ll:ostack", m->cfg_stack_size_in_mb)
-	  .add_option_bool("-ll:okindhack", m->cfg_fake_cpukind);
+	  .add_option_bool("-ll:okindhack", m->cfg_fake_cpukind)
+	  .add_option_bool("-ll:ospin", m->cfg_busy_wait_team);
 	
 	bool ok = cp.parse_command_line(cmdline);
 	if(!ok) {
@@ -243,6 +248,12 @@ namespace Realm {
     {
       Module::create_processors(runtime);
 
+      // if the NUMA module made per-domain memories, our processors should
+      //  see their own domain's memory as the closest one
+      Numa::NumaModule *numa_module = 0;
+      if(cfg_use_numa)
+	numa_module = dynamic_cast<Numa::NumaModule *>(runtime->get_module("numa"));
+
       for(std::set<int>::const_iterator it = active_numa_domains.begin();
 	  it != active_numa_domains.end();
 	  ++it) {
@@ -252,9 +263,11 @@ namespace Realm {
 	  ProcessorImpl *pi = new LocalOpenMPProcessor(p, cpu_node,
 						       cfg_num_threads_per_cpu,
 						       cfg_fake_cpukind,
+						       cfg_busy_wait_team,
 						       runtime->core_reservation_set(),
 						       cfg_stack_size_in_mb << 20);
 	  runtime->add_processor(pi);
+	  log_omp.info() << "OpenMP proc " << p << " placed in NUMA domain " << cpu_node;
 
 	  // FIXME: once the stuff in runtime_impl.cc is removed, remove
 	  //  this 'continue' so that we create affinities here
@@ -275,14 +288,17 @@ namespace Realm {
 	    pma.p = p;
 	    pma.m = (*it2)->me;
 
-	    // use the same made-up numbers as in
-	    //  runtime_impl.cc
-	    if(kind == Memory::SYSTEM_MEM) {
-	      pma.bandwidth = 100;  // "large"
-	      pma.latency = 5;      // "small"
-	    } else {
-	      pma.bandwidth = 80;   // "large"
-	      pma.latency = 10;     // "small"
+	    // NUMA module memories get distance-based numbers - for anything
+	    //  else, use the same made-up numbers as in runtime_impl.cc
+	    if(!numa_module ||
+	       !numa_module->get_affinity(cpu_node, *it2, pma)) {
+	      if(kind == Memory::SYSTEM_MEM) {
+		pma.bandwidth = 100;  // "large"
+		pma.latency = 5;      // "small"
+	      } else {
+		pma.bandwidth = 80;   // "large"
+		pma.latency = 10;     // "small"
+	      }
 	    }
 	    
 	    runtime->add_proc_mem_affinity(pma);
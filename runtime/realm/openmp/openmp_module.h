@@ -65,6 +65,7 @@ namespace Realm {
       bool cfg_use_numa;
       bool cfg_fake_cpukind;
       size_t cfg_stack_size_in_mb;
+      bool cfg_busy_wait_team;
 
       std::set<int> active_numa_domains;
     };
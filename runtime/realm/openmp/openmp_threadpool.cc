@@ -18,14 +18,101 @@
 
 #include "../logging.h"
 
+#include <stdlib.h>
+
 namespace Realm {
 
   Logger log_pool("threadpool");
 
   namespace ThreadLocal {
     __thread ThreadPool::WorkerInfo *threadpool_workerinfo = 0;
+    // loop state for threads that aren't part of a team
+    __thread ThreadPool::LoopState threadpool_private_loop;
   };
 
+  // busy-wait helper - spins for a while and then starts yielding, so that
+  //  an oversubscribed team still makes forward progress
+  static inline void spin_backoff(int& spins)
+  {
+    if(spins < 4096)
+      spins++;
+    else
+      sched_yield();
+  }
+
+  static inline void lock_queue(ThreadPool::TaskQueue& q)
+  {
+    int spins = 0;
+    while(__sync_lock_test_and_set(&q.lock, 1))
+      spin_backoff(spins);
+  }
+
+  static inline void unlock_queue(ThreadPool::TaskQueue& q)
+  {
+    __sync_lock_release(&q.lock);
+  }
+
+  static void release_task(ThreadPool::Task *task)
+  {
+    if(__sync_sub_and_fetch(&(task->refs), 1) == 0)
+      delete task;
+  }
+
+  static void execute_task(ThreadPool::WorkerInfo *wi, ThreadPool::Task *task)
+  {
+    ThreadPool::Task *prev_task = wi->current_task;
+    wi->current_task = task;
+    (task->fnptr)(task->data);
+    wi->current_task = prev_task;
+
+    free(task->data_alloc);
+    if(task->parent)
+      release_task(task->parent);
+    else
+      __sync_fetch_and_sub(task->implicit_count, 1);
+    ThreadPool::WorkItem *work = task->work_item;
+    release_task(task);
+    __sync_fetch_and_sub(&(work->tasks_outstanding), 1);
+  }
+
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class ThreadPool::WorkItem
+
+  ThreadPool::WorkItem::WorkItem(void)
+    : prev_thread_id(0), prev_num_threads(1)
+    , prev_loop_seq(0), prev_loop_active(false)
+    , prev_current_task(0), prev_implicit_children(0)
+    , parent_work_item(0), task_queues(0), num_task_queues(0)
+  {
+    reset(1);
+  }
+
+  ThreadPool::WorkItem::~WorkItem(void)
+  {
+    delete[] task_queues;
+  }
+
+  void ThreadPool::WorkItem::reset(int num_threads)
+  {
+    remaining_workers = num_threads;
+    barrier_count = 0;
+    barrier_gen = 0;
+    tasks_outstanding = 0;
+    // queues are kept (they're empty) unless there are too few of them
+    if(task_queues && (num_task_queues < num_threads)) {
+      delete[] task_queues;
+      task_queues = 0;
+      num_task_queues = 0;
+    }
+    for(int i = 0; i < MAX_ACTIVE_LOOPS; i++) {
+      loops[i].seq = i - MAX_ACTIVE_LOOPS;
+      loops[i].active = 0;
+      loops[i].claimed = 0;
+    }
+  }
+
   ////////////////////////////////////////////////////////////////////////
   //
   // class ThreadPool::WorkerInfo
@@ -34,8 +121,16 @@ namespace Realm {
   {
     new_work->prev_thread_id = thread_id;
     new_work->prev_num_threads = num_threads;
+    new_work->prev_loop_seq = loop_seq;
+    new_work->prev_loop_active = loop_active;
+    new_work->prev_current_task = current_task;
+    new_work->prev_implicit_children = implicit_children;
     new_work->parent_work_item = work_item;
     work_item = new_work;
+    loop_seq = 0;
+    loop_active = false;
+    current_task = 0;
+    implicit_children = 0;
   }
 
   ThreadPool::WorkItem *ThreadPool::WorkerInfo::pop_work_item(void)
@@ -43,6 +138,10 @@ namespace Realm {
     WorkItem *old_item = work_item;
     thread_id = old_item->prev_thread_id;
     num_threads = old_item->prev_num_threads;
+    loop_seq = old_item->prev_loop_seq;
+    loop_active = old_item->prev_loop_active;
+    current_task = old_item->prev_current_task;
+    implicit_children = old_item->prev_implicit_children;
     work_item = old_item->parent_work_item;
     return old_item;
   }
@@ -52,8 +151,15 @@ namespace Realm {
   //
   // class ThreadPool
 
-  ThreadPool::ThreadPool(int _num_workers)
+  ThreadPool::ThreadPool(int _num_workers, bool _busy_wait_team /*= false*/)
     : num_workers(_num_workers)
+    , busy_wait_team(_busy_wait_team)
+    , team_ready(false)
+    , team_generation(0)
+    , team_release(0)
+    , team_size(1)
+    , team_fnptr(0)
+    , team_data(0)
   {
     // these will be filled in as workers show up
     worker_threads.resize(num_workers, 0);
@@ -68,9 +174,19 @@ namespace Realm {
       wi.fnptr = 0;
       wi.data = 0;
       wi.work_item = 0;
+      wi.loop_seq = 0;
+      wi.loop_active = false;
+      wi.current_task = 0;
+      wi.implicit_children = 0;
     }
 
-    log_pool.info() << "pool " << (void *)this << " started - " << num_workers << " workers";
+    team_slots.resize(num_workers + 1);
+    for(int i = 0; i <= num_workers; i++) {
+      team_slots[i].arrived = 0;
+      team_slots[i].joined = 0;
+    }
+
+    log_pool.info() << "pool " << (void *)this << " started - " << num_workers << " workers" << (busy_wait_team ? " (busy-wait team)" : "");
   }
   
   ThreadPool::~ThreadPool(void)
@@ -93,11 +209,18 @@ namespace Realm {
   {
     log_pool.info() << "new worker thread";
 
+    // in team mode, workers go straight into the (persistent) team and
+    //  are never claimed individually - sample the team generation before
+    //  becoming visible so that the first region can't be missed
+    int seen_gen = team_generation;
+    int start_status = (busy_wait_team ? WorkerInfo::WORKER_TEAM :
+			                 WorkerInfo::WORKER_IDLE);
+
     // choose an ID by finding an info to change from STARTING->IDLE
     int id = 1;
     while(!__sync_bool_compare_and_swap(&(worker_infos[id].status),
 					WorkerInfo::WORKER_STARTING,
-					WorkerInfo::WORKER_IDLE)) {
+					start_status)) {
       id++;
       assert(id <= num_workers);
     }
@@ -110,6 +233,11 @@ namespace Realm {
     ThreadLocal::threadpool_workerinfo = wi;
     log_pool.debug() << "worker: " << Thread::self() << " " << (void *)(ThreadLocal::threadpool_workerinfo);
 
+    if(busy_wait_team) {
+      team_worker_loop(wi, id, seen_gen);
+      return;
+    }
+
     bool worker_shutdown = false;
     while(!worker_shutdown) {
       switch(wi->status) {
@@ -124,6 +252,7 @@ namespace Realm {
 	{
 	  log_pool.info() << "worker " << wi->thread_id << "/" << wi->num_threads << " executing: " << (void *)(wi->fnptr) << "(" << wi->data << ")";
 	  (wi->fnptr)(wi->data);
+	  drain_tasks();
 	  log_pool.info() << "worker " << wi->thread_id << "/" << wi->num_threads << " done";
 	  __sync_fetch_and_sub(&(wi->work_item->remaining_workers), 1);
 	  wi->status = WorkerInfo::WORKER_IDLE;
@@ -152,7 +281,9 @@ namespace Realm {
 	++it) {
       if(it->status == WorkerInfo::WORKER_MASTER) continue;
       bool ok = __sync_bool_compare_and_swap(&(it->status),
-					     WorkerInfo::WORKER_IDLE,
+					     (busy_wait_team ?
+					        WorkerInfo::WORKER_TEAM :
+					        WorkerInfo::WORKER_IDLE),
 					     WorkerInfo::WORKER_SHUTDOWN);
       assert(ok);
     }
@@ -197,9 +328,398 @@ namespace Realm {
     wi->fnptr = fnptr;
     wi->data = data;
     wi->work_item = work_item;
+    wi->loop_seq = 0;
+    wi->loop_active = false;
+    wi->current_task = 0;
+    wi->implicit_children = 0;
     __sync_bool_compare_and_swap(&(wi->status),
 				 WorkerInfo::WORKER_CLAIMED,
 				 WorkerInfo::WORKER_ACTIVE);
   }
 
+  bool ThreadPool::start_team(int num_threads,
+			      void (*fnptr)(void *data), void *data)
+  {
+    if(!busy_wait_team)
+      return false;
+
+    // only top-level regions started by the master use the team - nested
+    //  regions fall back to claim_workers (and find no idle workers)
+    WorkerInfo *wi = get_worker_info();
+    if((wi != &worker_infos[0]) || (wi->work_item != 0))
+      return false;
+
+    // every worker must be spinning in the team before the first region
+    if(!team_ready) {
+      for(int i = 1; i <= num_workers; i++)
+	while(*(volatile int *)&(worker_infos[i].status) == WorkerInfo::WORKER_STARTING)
+	  sched_yield();
+      team_ready = true;
+    }
+
+    if((num_threads <= 0) || (num_threads > (num_workers + 1)))
+      num_threads = num_workers + 1;
+
+    team_work.reset(num_threads);
+    wi->push_work_item(&team_work);
+    wi->thread_id = 0;
+    wi->num_threads = num_threads;
+
+    // publish the region parameters, then the new generation
+    team_size = num_threads;
+    team_fnptr = fnptr;
+    team_data = data;
+    __sync_synchronize();
+    team_generation = team_generation + 1;
+
+    log_pool.debug() << "team " << team_generation << " started: " << num_threads << " threads";
+    return true;
+  }
+
+  bool ThreadPool::end_team(void)
+  {
+    if(!busy_wait_team)
+      return false;
+
+    WorkerInfo *wi = get_worker_info();
+    if((wi != &worker_infos[0]) || (wi->work_item != &team_work))
+      return false;
+
+    drain_tasks();
+    tree_join(0, team_generation);
+    wi->pop_work_item();
+    return true;
+  }
+
+  void ThreadPool::barrier(void)
+  {
+    WorkerInfo *wi = get_worker_info();
+    if(!wi || !wi->work_item || (wi->num_threads == 1))
+      return;
+
+    // all tasks of the team must be complete before anybody leaves
+    drain_tasks();
+
+    if(wi->work_item == &team_work) {
+      tree_barrier(wi->thread_id, wi->num_threads);
+      return;
+    }
+
+    // claimed workers: centralized counter barrier on the work item
+    WorkItem *work = wi->work_item;
+    int gen = *(volatile int *)&(work->barrier_gen);
+    if(__sync_add_and_fetch(&(work->barrier_count), 1) == wi->num_threads) {
+      work->barrier_count = 0;
+      __sync_synchronize();
+      *(volatile int *)&(work->barrier_gen) = gen + 1;
+    } else {
+      while(*(volatile int *)&(work->barrier_gen) == gen)
+	sched_yield();
+    }
+  }
+
+  void ThreadPool::team_worker_loop(WorkerInfo *wi, int team_index,
+				    int seen_gen)
+  {
+    int spins = 0;
+    while(true) {
+      int gen = team_generation;
+      if(gen == seen_gen) {
+	if(*(volatile int *)&(wi->status) == WorkerInfo::WORKER_SHUTDOWN) {
+	  log_pool.info() << "worker shutdown received";
+	  break;
+	}
+	spin_backoff(spins);
+	continue;
+      }
+      seen_gen = gen;
+      spins = 0;
+      __sync_synchronize();
+
+      // the parameters can't change until we've joined below
+      if(team_index < team_size) {
+	wi->thread_id = team_index;
+	wi->num_threads = team_size;
+	wi->work_item = &team_work;
+	wi->loop_seq = 0;
+	wi->loop_active = false;
+	wi->current_task = 0;
+	wi->implicit_children = 0;
+	(team_fnptr)(team_data);
+	drain_tasks();
+	wi->thread_id = 0;
+	wi->num_threads = 1;
+	wi->work_item = 0;
+      }
+
+      tree_join(team_index, gen);
+    }
+  }
+
+  void ThreadPool::tree_barrier(int thread_id, int count)
+  {
+    // the release can't advance until we've arrived, so this is stable
+    int target = team_release + 1;
+
+    int first = thread_id * BARRIER_RADIX + 1;
+    for(int c = first; (c < first + BARRIER_RADIX) && (c < count); c++)
+      for(int spins = 0; team_slots[c].arrived != target; )
+	spin_backoff(spins);
+    __sync_synchronize();
+
+    if(thread_id == 0) {
+      team_release = target;
+    } else {
+      team_slots[thread_id].arrived = target;
+      for(int spins = 0; team_release != target; )
+	spin_backoff(spins);
+      __sync_synchronize();
+    }
+  }
+
+  void ThreadPool::tree_join(int team_index, int gen)
+  {
+    int first = team_index * BARRIER_RADIX + 1;
+    for(int c = first; (c < first + BARRIER_RADIX) && (c <= num_workers); c++)
+      for(int spins = 0; team_slots[c].joined != gen; )
+	spin_backoff(spins);
+    __sync_synchronize();
+
+    if(team_index > 0)
+      team_slots[team_index].joined = gen;
+  }
+
+  /*static*/ void ThreadPool::spawn_task(void (*fnptr)(void *data),
+					 void *data, void *data_alloc)
+  {
+    WorkerInfo *wi = get_worker_info();
+    if(!wi || !wi->work_item || (wi->num_threads == 1)) {
+      // nobody to share with - run it now
+      fnptr(data);
+      free(data_alloc);
+      return;
+    }
+
+    WorkItem *work = wi->work_item;
+    if(!work->task_queues) {
+      // first task in this team - whoever wins the race installs queues
+      TaskQueue *queues = new TaskQueue[wi->num_threads];
+      work->num_task_queues = wi->num_threads;
+      if(!__sync_bool_compare_and_swap(&(work->task_queues),
+				       (TaskQueue *)0, queues))
+	delete[] queues;
+    }
+
+    Task *task = new Task;
+    task->fnptr = fnptr;
+    task->data = data;
+    task->data_alloc = data_alloc;
+    task->work_item = work;
+    task->parent = wi->current_task;
+    task->refs = 1;
+    if(task->parent) {
+      task->implicit_count = 0;
+      __sync_fetch_and_add(&(task->parent->refs), 1);
+    } else {
+      task->implicit_count = &(wi->implicit_children);
+      __sync_fetch_and_add(&(wi->implicit_children), 1);
+    }
+    __sync_fetch_and_add(&(work->tasks_outstanding), 1);
+
+    TaskQueue& q = work->task_queues[wi->thread_id];
+    lock_queue(q);
+    q.tasks.push_back(task);
+    unlock_queue(q);
+  }
+
+  /*static*/ bool ThreadPool::run_one_task(void)
+  {
+    WorkerInfo *wi = get_worker_info();
+    if(!wi || !wi->work_item)
+      return false;
+
+    WorkItem *work = wi->work_item;
+    TaskQueue *queues = work->task_queues;
+    if(!queues)
+      return false;
+
+    Task *task = 0;
+    int n = work->num_task_queues;
+    for(int i = 0; (i < n) && !task; i++) {
+      TaskQueue& q = queues[(wi->thread_id + i) % n];
+      lock_queue(q);
+      if(!q.tasks.empty()) {
+	if(i == 0) {
+	  // our own queue - newest first
+	  task = q.tasks.back();
+	  q.tasks.pop_back();
+	} else {
+	  // stealing - oldest first
+	  task = q.tasks.front();
+	  q.tasks.pop_front();
+	}
+      }
+      unlock_queue(q);
+    }
+
+    if(!task)
+      return false;
+
+    execute_task(wi, task);
+    return true;
+  }
+
+  /*static*/ void ThreadPool::taskwait(void)
+  {
+    WorkerInfo *wi = get_worker_info();
+    if(!wi)
+      return;
+
+    int spins = 0;
+    if(wi->current_task) {
+      // the task's own reference remains until it completes
+      while(*(volatile int *)&(wi->current_task->refs) > 1)
+	if(!run_one_task())
+	  spin_backoff(spins);
+    } else {
+      while(*(volatile int *)&(wi->implicit_children) > 0)
+	if(!run_one_task())
+	  spin_backoff(spins);
+    }
+  }
+
+  /*static*/ void ThreadPool::drain_tasks(void)
+  {
+    WorkerInfo *wi = get_worker_info();
+    if(!wi || !wi->work_item)
+      return;
+
+    int spins = 0;
+    while(*(volatile int *)&(wi->work_item->tasks_outstanding) > 0)
+      if(!run_one_task())
+	spin_backoff(spins);
+  }
+
+  /*static*/ void ThreadPool::loop_start(int schedule,
+					 int64_t base, int64_t stride,
+					 uint64_t count, uint64_t chunk)
+  {
+    if(chunk == 0)
+      chunk = 1;
+
+    WorkerInfo *wi = get_worker_info();
+    if(!wi || !wi->work_item || (wi->num_threads == 1)) {
+      LoopState& ls = ThreadLocal::threadpool_private_loop;
+      ls.schedule = schedule;
+      ls.num_threads = 1;
+      ls.base = base;
+      ls.stride = stride;
+      ls.count = count;
+      ls.chunk = chunk;
+      ls.next = 0;
+      return;
+    }
+
+    // the first thread to reach a given loop initializes its slot, once
+    //  the loop that last used the slot has been finished by everybody
+    int seq = wi->loop_seq++;
+    LoopState& ls = wi->work_item->loops[seq % MAX_ACTIVE_LOOPS];
+    int spins = 0;
+    while(ls.seq != seq) {
+      if((ls.seq == (seq - MAX_ACTIVE_LOOPS)) && (ls.active == 0) &&
+	 __sync_bool_compare_and_swap(&ls.claimed, 0, 1)) {
+	// recheck now that we hold the slot
+	if((ls.seq == (seq - MAX_ACTIVE_LOOPS)) && (ls.active == 0)) {
+	  ls.schedule = schedule;
+	  ls.num_threads = wi->num_threads;
+	  ls.base = base;
+	  ls.stride = stride;
+	  ls.count = count;
+	  ls.chunk = chunk;
+	  ls.next = 0;
+	  ls.active = wi->num_threads;
+	  __sync_synchronize();
+	  ls.seq = seq;
+	}
+	__sync_lock_release(&ls.claimed);
+	continue;
+      }
+      spin_backoff(spins);
+    }
+    wi->loop_active = true;
+  }
+
+  /*static*/ bool ThreadPool::loop_next(int64_t& lo, int64_t& hi,
+					int64_t *stride /*= 0*/,
+					bool *is_last /*= 0*/)
+  {
+    WorkerInfo *wi = get_worker_info();
+    LoopState *ls;
+    bool shared;
+    if(!wi || !wi->work_item || (wi->num_threads == 1)) {
+      ls = &ThreadLocal::threadpool_private_loop;
+      shared = false;
+    } else {
+      if(!wi->loop_active) {
+	if(wi->loop_seq != 0)
+	  return false;  // already done with the latest loop
+	// combined parallel loop - the master set up loop 0 for us
+	LoopState& ls0 = wi->work_item->loops[0];
+	int spins = 0;
+	while(ls0.seq != 0)
+	  spin_backoff(spins);
+	wi->loop_seq = 1;
+	wi->loop_active = true;
+      }
+      ls = &(wi->work_item->loops[(wi->loop_seq - 1) % MAX_ACTIVE_LOOPS]);
+      shared = true;
+    }
+
+    uint64_t first, num;
+    bool found = false;
+    if(ls->schedule == LOOP_GUIDED) {
+      // chunks shrink in proportion to the remaining iterations
+      while(true) {
+	first = ls->next;
+	if(first >= ls->count)
+	  break;
+	uint64_t remaining = ls->count - first;
+	num = (remaining + ls->num_threads - 1) / ls->num_threads;
+	if(num < ls->chunk)
+	  num = ls->chunk;
+	if(num > remaining)
+	  num = remaining;
+	if(__sync_bool_compare_and_swap(&(ls->next), first, first + num)) {
+	  found = true;
+	  break;
+	}
+      }
+    } else {
+      first = __sync_fetch_and_add(&(ls->next), ls->chunk);
+      if(first < ls->count) {
+	num = ls->count - first;
+	if(num > ls->chunk)
+	  num = ls->chunk;
+	found = true;
+      }
+    }
+
+    if(!found) {
+      if(shared) {
+	wi->loop_active = false;
+	__sync_fetch_and_sub(&(ls->active), 1);
+      }
+      return false;
+    }
+
+    // unsigned arithmetic so that all index types wrap consistently
+    lo = (int64_t)((uint64_t)(ls->base) + first * (uint64_t)(ls->stride));
+    hi = (int64_t)((uint64_t)lo + num * (uint64_t)(ls->stride));
+    if(stride)
+      *stride = ls->stride;
+    if(is_last)
+      *is_last = ((first + num) == ls->count);
+    return true;
+  }
+
 };
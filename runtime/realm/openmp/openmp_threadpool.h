@@ -19,11 +19,14 @@
 
 #include "../threads.h"
 
+#include <deque>
+#include <stdint.h>
+
 namespace Realm {
 
   class ThreadPool {
   public:
-    ThreadPool(int _num_workers);
+    ThreadPool(int _num_workers, bool _busy_wait_team = false);
     ~ThreadPool(void);
 
     // associates the calling thread as the master of the threadpool
@@ -32,11 +35,71 @@ namespace Realm {
     // entry point for workers - does not return until thread pool is shut down
     void worker_entry(void);
 
+    struct WorkItem;
+
+    // an explicit (i.e. deferred) OpenMP task
+    struct Task {
+      void (*fnptr)(void *data);
+      void *data;
+      void *data_alloc;    // freed (with free()) once the task has run
+      WorkItem *work_item;
+      Task *parent;        // 0 if spawned from an implicit task
+      int *implicit_count; // parent's child count if parent is implicit
+      int refs;            // 1 (until complete) + incomplete children
+    };
+
+    // per-thread task deque - the owner pushes/pops at the back, thieves
+    //  take from the front
+    struct TaskQueue {
+      TaskQueue(void) : lock(0) {}
+      volatile int lock;
+      std::deque<Task *> tasks;
+    };
+
+    enum LoopSchedule {
+      LOOP_DYNAMIC,
+      LOOP_GUIDED,
+    };
+
+    // shared iteration counter for a dynamic/guided loop - iterations are
+    //  numbered [0, count) and mapped back to 'base + i * stride'
+    struct LoopState {
+      volatile int seq;     // loop sequence number (in the work item)
+      volatile int active;  // threads still taking iterations from it
+      volatile int claimed; // set while a thread initializes the slot
+      int schedule;
+      int num_threads;
+      int64_t base;
+      int64_t stride;
+      uint64_t count;
+      uint64_t chunk;
+      volatile uint64_t next;
+    };
+
+    // 'nowait' loops allow threads to run ahead into later loops
+    static const int MAX_ACTIVE_LOOPS = 4;
+
     struct WorkItem {
+      WorkItem(void);
+      ~WorkItem(void);
+
+      // prepares the work item for a team of 'num_threads'
+      void reset(int num_threads);
+
       int prev_thread_id;
       int prev_num_threads;
+      int prev_loop_seq;
+      bool prev_loop_active;
+      Task *prev_current_task;
+      int prev_implicit_children;
       WorkItem *parent_work_item;
       int remaining_workers;
+      int barrier_count;  // arrivals at current barrier (non-team mode)
+      int barrier_gen;    // completed barriers (non-team mode)
+      int tasks_outstanding;
+      TaskQueue *volatile task_queues; // allocated on first spawn
+      int num_task_queues;
+      LoopState loops[MAX_ACTIVE_LOOPS];
     };
 
     struct WorkerInfo {
@@ -46,6 +109,7 @@ namespace Realm {
 	WORKER_IDLE,
 	WORKER_CLAIMED,
 	WORKER_ACTIVE,
+	WORKER_TEAM,      // persistent member of the busy-wait team
 	WORKER_SHUTDOWN,
       };
       int /*Status*/ status; // int allows CAS primitives
@@ -55,6 +119,10 @@ namespace Realm {
       void (*fnptr)(void *data);
       void *data;
       WorkItem *work_item;
+      int loop_seq;         // loops started in the current work item
+      bool loop_active;     // still taking iterations from latest loop
+      Task *current_task;   // 0 when running the implicit task
+      int implicit_children;
 
       void push_work_item(WorkItem *new_work);
       WorkItem *pop_work_item(void);
@@ -76,10 +144,84 @@ namespace Realm {
 
     int get_num_workers() const { return num_workers; }
 
+    // low-latency fork/join for top-level parallel regions when the pool
+    //  was created in busy-wait team mode - workers spin (rather than
+    //  being claimed/started individually), thread ids are statically
+    //  assigned by worker index, and the join is a tree reduction
+    // start_team returns false if the caller must use claim_workers/
+    //  start_worker instead - otherwise the caller runs fnptr itself as
+    //  thread 0 and then calls end_team
+    bool start_team(int num_threads, void (*fnptr)(void *data), void *data);
+
+    // returns false if the caller is not the master of an active team
+    bool end_team(void);
+
+    // waits for all threads in the caller's current team (and for all
+    //  tasks spawned within it)
+    void barrier(void);
+
+    // explicit tasks - spawn_task takes ownership of 'data_alloc' and runs
+    //  the task inline if the caller isn't in a parallel team
+    static void spawn_task(void (*fnptr)(void *data), void *data,
+			   void *data_alloc);
+
+    // waits for the children of the caller's current task, running
+    //  queued tasks in the meantime
+    static void taskwait(void);
+
+    // runs (at most) one queued task from the caller's team, preferring
+    //  the caller's own queue and otherwise stealing - returns false if
+    //  there was nothing to run
+    static bool run_one_task(void);
+
+    // runs queued tasks until none remain outstanding in the caller's team
+    static void drain_tasks(void);
+
+    // dynamic/guided loop scheduling - every thread of the team calls
+    //  loop_start and then loop_next until it returns false - each chunk
+    //  is returned as [lo, hi) in the loop's own (wrapping) arithmetic
+    // (a combined parallel loop may be set up by just the master
+    //  before the team starts - other threads then use loop_next directly)
+    static void loop_start(int schedule, int64_t base, int64_t stride,
+			   uint64_t count, uint64_t chunk);
+    static bool loop_next(int64_t& lo, int64_t& hi,
+			  int64_t *stride = 0, bool *is_last = 0);
+
   protected:
+    void team_worker_loop(WorkerInfo *wi, int team_index, int seen_gen);
+
+    // arrival tree over the first 'count' slots, followed by a single
+    //  broadcast release from thread 0
+    void tree_barrier(int thread_id, int count);
+
+    // wait for every worker (participant in the team or not) to have
+    //  observed generation 'gen' - prevents the master from republishing
+    //  team parameters while a worker might still be reading them
+    void tree_join(int team_index, int gen);
+
+    // fan-in degree of the barrier trees
+    static const int BARRIER_RADIX = 4;
+
+    // padded to avoid false sharing between spinning threads
+    struct TeamSlot {
+      volatile int arrived;
+      volatile int joined;
+      char pad[64 - 2 * sizeof(int)];
+    };
+
     int num_workers;
     std::vector<Thread *> worker_threads;
     std::vector<WorkerInfo> worker_infos;
+
+    bool busy_wait_team;
+    bool team_ready;
+    std::vector<TeamSlot> team_slots;
+    WorkItem team_work;
+    volatile int team_generation;
+    volatile int team_release;
+    int team_size;
+    void (*team_fnptr)(void *data);
+    void *team_data;
   };
 
 }; // namespace Realm
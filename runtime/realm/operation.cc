@@ -149,6 +149,16 @@ namespace Realm {
       mark_completed();    
   }
 
+  Event Operation::get_precondition(void) const
+  {
+    return Event::NO_EVENT;
+  }
+
+  const char *Operation::get_kind_name(void) const
+  {
+    return "operation";
+  }
+
   void Operation::mark_completed(void)
   {
     // don't overwrite a TERMINATED_EARLY or CANCELLED status
@@ -169,6 +179,11 @@ namespace Realm {
 
     send_profiling_data();
 
+    if(CriticalPathRecorder::is_enabled())
+      CriticalPathRecorder::record_operation(finish_event, get_precondition(),
+					     last_wait_event, get_kind_name(),
+					     timeline);
+
     // trigger the finish event last - the OperationTable will delete us shortly after we do
     // poison if there were any failed work items
     trigger_finish_event(failed_work_items != 0);
@@ -230,6 +245,9 @@ namespace Realm {
       if(measurements.wants_measurement<ProfilingMeasurements::OperationEventWaits>())
 	measurements.add_measurement(waits);
 
+      if(wants_gpu_activity)
+	measurements.add_measurement(gpu_activity);
+
       measurements.send_responses(requests);
     }
   }
@@ -499,4 +517,218 @@ namespace Realm {
   }
 
 
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class CriticalPathRecorder
+  //
+
+  Logger log_critpath("critpath");
+
+  /*static*/ bool CriticalPathRecorder::enabled = false;
+
+  namespace {
+    typedef ProfilingMeasurements::OperationTimeline::timestamp_t timestamp_t;
+
+    struct CritPathOp {
+      Event precondition;
+      Event last_wait;  // last event waited on while running (if any)
+      const char *kind;
+      timestamp_t create_time, ready_time, start_time, end_time, complete_time;
+    };
+
+    GASNetHSL critpath_mutex;
+    std::map<Event, timestamp_t> critpath_triggers;
+    std::map<Event, CritPathOp> critpath_ops;
+    std::map<Event, std::vector<Event> > critpath_merges;
+
+    // time accounting for one kind of hop on the path
+    struct CritPathSummary {
+      CritPathSummary(void) : hops(0), dep_wait(0), queue_wait(0), run(0), tail(0) {}
+      int hops;
+      timestamp_t dep_wait;    // input triggered -> operation ready
+      timestamp_t queue_wait;  // ready -> started
+      timestamp_t run;         // started -> ended
+      timestamp_t tail;        // ended -> finish event triggered
+    };
+
+    timestamp_t lookup_trigger(Event e)
+    {
+      std::map<Event, timestamp_t>::const_iterator it = critpath_triggers.find(e);
+      return ((it != critpath_triggers.end()) ?
+	        it->second :
+	        ProfilingMeasurements::OperationTimeline::INVALID_TIMESTAMP);
+    }
+  };
+
+  /*static*/ void CriticalPathRecorder::configure(bool enable)
+  {
+    enabled = enable;
+  }
+
+  /*static*/ void CriticalPathRecorder::shutdown(void)
+  {
+    if(!enabled)
+      return;
+
+    enabled = false;
+    report();
+
+    AutoHSLLock al(critpath_mutex);
+    critpath_triggers.clear();
+    critpath_ops.clear();
+    critpath_merges.clear();
+  }
+
+  /*static*/ void CriticalPathRecorder::record_trigger(Event e)
+  {
+    timestamp_t now = Clock::current_time_in_nanoseconds();
+    AutoHSLLock al(critpath_mutex);
+    critpath_triggers[e] = now;
+  }
+
+  /*static*/ void CriticalPathRecorder::record_merge(Event finish_event,
+						     const Event *inputs, size_t count)
+  {
+    AutoHSLLock al(critpath_mutex);
+    std::vector<Event>& v = critpath_merges[finish_event];
+    for(size_t i = 0; i < count; i++)
+      if(inputs[i].exists())
+	v.push_back(inputs[i]);
+  }
+
+  /*static*/ void CriticalPathRecorder::record_operation(Event finish_event,
+							 Event precondition,
+							 Event last_wait,
+							 const char *kind,
+							 const ProfilingMeasurements::OperationTimeline& timeline)
+  {
+    CritPathOp op;
+    op.precondition = precondition;
+    op.last_wait = last_wait;
+    op.kind = kind;
+    op.create_time = timeline.create_time;
+    op.ready_time = timeline.ready_time;
+    op.start_time = timeline.start_time;
+    op.end_time = timeline.end_time;
+    op.complete_time = timeline.complete_time;
+
+    AutoHSLLock al(critpath_mutex);
+    critpath_ops[finish_event] = op;
+  }
+
+  /*static*/ void CriticalPathRecorder::report(void)
+  {
+    const timestamp_t INVALID = ProfilingMeasurements::OperationTimeline::INVALID_TIMESTAMP;
+
+    AutoHSLLock al(critpath_mutex);
+
+    // the path ends at whichever operation completed last
+    Event cur = Event::NO_EVENT;
+    timestamp_t last_complete = INVALID;
+    for(std::map<Event, CritPathOp>::const_iterator it = critpath_ops.begin();
+	it != critpath_ops.end();
+	it++)
+      if(it->second.complete_time > last_complete) {
+	last_complete = it->second.complete_time;
+	cur = it->first;
+      }
+
+    if(!cur.exists()) {
+      log_critpath.print() << "no operations recorded";
+      return;
+    }
+
+    log_critpath.print() << "critical path (latest first, times in ns):";
+    std::map<std::string, CritPathSummary> summaries;
+    timestamp_t path_start = INVALID;
+    // the hop limit guards against a cycle through recycled event IDs
+    size_t max_hops = critpath_ops.size() + critpath_merges.size();
+    for(size_t hops = 0; cur.exists() && (hops < max_hops); hops++) {
+      timestamp_t cur_trigger = lookup_trigger(cur);
+
+      std::map<Event, CritPathOp>::const_iterator op_it = critpath_ops.find(cur);
+      if(op_it != critpath_ops.end()) {
+	const CritPathOp& op = op_it->second;
+	CritPathSummary& s = summaries[op.kind];
+
+	// if the operation blocked on something that triggered while it was
+	//  running, that's what held it up - only the time after it woke counts
+	timestamp_t wait_trigger = lookup_trigger(op.last_wait);
+	if(op.last_wait.exists() && (wait_trigger != INVALID) &&
+	   (wait_trigger > op.start_time) && (wait_trigger < op.end_time)) {
+	  s.hops++;
+	  s.run += op.end_time - wait_trigger;
+	  if(cur_trigger != INVALID)
+	    s.tail += cur_trigger - op.end_time;
+	  log_critpath.print() << "  " << op.kind << " " << cur
+			       << ": blocked on " << op.last_wait
+			       << ", run after wake=" << (op.end_time - wait_trigger);
+	  cur = op.last_wait;
+	  continue;
+	}
+
+	timestamp_t pre_trigger = lookup_trigger(op.precondition);
+	// an input that triggered before we were created didn't hold us up
+	timestamp_t avail = std::max(pre_trigger, op.create_time);
+	s.hops++;
+	s.dep_wait += op.ready_time - avail;
+	s.queue_wait += op.start_time - op.ready_time;
+	s.run += op.end_time - op.start_time;
+	if(cur_trigger != INVALID)
+	  s.tail += cur_trigger - op.end_time;
+	log_critpath.print() << "  " << op.kind << " " << cur
+			     << ": wait=" << (op.ready_time - avail)
+			     << " queue=" << (op.start_time - op.ready_time)
+			     << " run=" << (op.end_time - op.start_time)
+			     << " pre=" << op.precondition;
+	path_start = avail;
+	cur = op.precondition;
+	continue;
+      }
+
+      std::map<Event, std::vector<Event> >::const_iterator m_it = critpath_merges.find(cur);
+      if(m_it != critpath_merges.end()) {
+	// follow whichever input triggered last
+	Event latest = Event::NO_EVENT;
+	timestamp_t latest_trigger = INVALID;
+	for(std::vector<Event>::const_iterator it = m_it->second.begin();
+	    it != m_it->second.end();
+	    it++) {
+	  timestamp_t t = lookup_trigger(*it);
+	  if(!latest.exists() || (t > latest_trigger)) {
+	    latest = *it;
+	    latest_trigger = t;
+	  }
+	}
+	if((cur_trigger != INVALID) && (latest_trigger != INVALID)) {
+	  CritPathSummary& s = summaries["merge"];
+	  s.hops++;
+	  s.dep_wait += cur_trigger - latest_trigger;
+	}
+	log_critpath.print() << "  merge " << cur << ": inputs=" << m_it->second.size()
+			     << " latest=" << latest;
+	cur = latest;
+	continue;
+      }
+
+      // an event we know nothing else about (e.g. a user event) starts the path
+      log_critpath.print() << "  event " << cur << ": trigger=" << cur_trigger;
+      if(cur_trigger != INVALID)
+	path_start = cur_trigger;
+      break;
+    }
+
+    if(path_start != INVALID)
+      log_critpath.print() << "path length: " << (last_complete - path_start) << " ns";
+    for(std::map<std::string, CritPathSummary>::const_iterator it = summaries.begin();
+	it != summaries.end();
+	it++)
+      log_critpath.print() << "  " << it->first << ": hops=" << it->second.hops
+			   << " wait=" << it->second.dep_wait
+			   << " queue=" << it->second.queue_wait
+			   << " run=" << it->second.run
+			   << " tail=" << it->second.tail;
+  }
+
 }; // namespace Realm
@@ -62,6 +62,11 @@ namespace Realm {
 
     virtual void print(std::ostream& os) const = 0;
 
+    // what the operation waited on before it could start and a short name
+    //  for its kind - used by the CriticalPathRecorder
+    virtual Event get_precondition(void) const;
+    virtual const char *get_kind_name(void) const;
+
     // abstract class to describe asynchronous work started by an operation
     //  that must finish for the operation to become "complete"
     class AsyncWorkItem {
@@ -87,6 +92,10 @@ namespace Realm {
     // used to record event wait intervals, if desired
     ProfilingMeasurements::OperationEventWaits::WaitInterval *create_wait_interval(Event e);
 
+    // filled in by whoever tracks the operation's device work, if desired
+    //  (returns 0 otherwise) - must be done before that work is marked finished
+    ProfilingMeasurements::OperationGPUActivity *get_gpu_activity(void);
+
   protected:
     // called by AsyncWorkItem::mark_finished from an arbitrary thread
     void work_item_finished(AsyncWorkItem *item, bool successful);
@@ -110,6 +119,9 @@ namespace Realm {
     ProfilingMeasurements::OperationTimeline timeline;
     bool wants_event_waits;
     ProfilingMeasurements::OperationEventWaits waits;
+    bool wants_gpu_activity;
+    ProfilingMeasurements::OperationGPUActivity gpu_activity;
+    Event last_wait_event;  // only tracked for the CriticalPathRecorder
     ProfilingRequestSet requests; 
     ProfilingMeasurementCollection measurements;
 
@@ -167,6 +179,32 @@ namespace Realm {
     TableCleaner cleaner;
   };
 
+  // when enabled (-realm:critpath), records when each event triggers, what
+  //  each operation or event merge waited on, and each operation's timeline -
+  //  at shutdown, the chain of operations leading to the last operation to
+  //  complete is reported with a breakdown of where the time went at each hop
+  // everything is kept (behind one mutex) until shutdown, so this is a
+  //  diagnostic mode rather than something to leave on for long runs, and
+  //  only the local node's operations are seen
+  class CriticalPathRecorder {
+  public:
+    static void configure(bool enable);
+    static void shutdown(void);
+
+    static inline bool is_enabled(void) { return enabled; }
+
+    static void record_trigger(Event e);
+    static void record_merge(Event finish_event, const Event *inputs, size_t count);
+    static void record_operation(Event finish_event, Event precondition,
+				 Event last_wait, const char *kind,
+				 const ProfilingMeasurements::OperationTimeline& timeline);
+
+    static void report(void);
+
+  protected:
+    static bool enabled;
+  };
+
 };
 
 #include "operation.inl"
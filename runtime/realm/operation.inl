@@ -29,6 +29,7 @@ namespace Realm {
                               const ProfilingRequestSet &_requests)
     : finish_event(_finish_event)
     , refcount(1)
+    , last_wait_event(Event::NO_EVENT)
     , requests(_requests)
     , pending_work_items(1 /* i.e. the main work item */)
     , failed_work_items(0 /* hopefully it stays that way*/)
@@ -38,6 +39,7 @@ namespace Realm {
     measurements.import_requests(requests); 
     timeline.record_create_time();
     wants_event_waits = measurements.wants_measurement<ProfilingMeasurements::OperationEventWaits>();
+    wants_gpu_activity = measurements.wants_measurement<ProfilingMeasurements::OperationGPUActivity>();
   }
 
   inline void Operation::add_reference(void)
@@ -85,6 +87,8 @@ namespace Realm {
   // used to record event wait intervals, if desired
   inline ProfilingMeasurements::OperationEventWaits::WaitInterval *Operation::create_wait_interval(Event e)
   {
+    if(CriticalPathRecorder::is_enabled())
+      last_wait_event = e;
     if(wants_event_waits) {
       size_t idx = waits.intervals.size();
       waits.intervals.resize(idx + 1);
@@ -95,6 +99,11 @@ namespace Realm {
       return 0;
   }
 
+  inline ProfilingMeasurements::OperationGPUActivity *Operation::get_gpu_activity(void)
+  {
+    return (wants_gpu_activity ? &gpu_activity : 0);
+  }
+
 
   ////////////////////////////////////////////////////////////////////////
   //
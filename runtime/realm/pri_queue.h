@@ -52,6 +52,11 @@ namespace Realm {
     //  2) "unget" adds it to the front of the list (i.e. LIFO order)
     void put(T item, priority_t priority, bool add_to_back = true);
 
+    // adds 'count' items (with corresponding priorities) while holding the lock
+    //  just once - equivalent to calling put() on each item in order
+    void put_multiple(const T *items, const priority_t *priorities, size_t count,
+		      bool add_to_back = true);
+
     // getting an item is always from the front of the list and can be filtered to
     //  ignore things that aren't above a specified priority
     // the priority of the retrieved item (if any) is returned in *item_priority
@@ -65,6 +70,15 @@ namespace Realm {
     // this call is lock-free (and is again of questionable utility with multiple readers)
     bool empty(priority_t higher_than = PRI_NEG_INF) const;
 
+    // returns the priority of the highest-priority item in the queue (or
+    //  PRI_NEG_INF if the queue is empty) - also lock-free, so the answer may be
+    //  stale by the time the caller acts on it
+    priority_t highest_priority_hint(void) const;
+
+    // returns the item get() would currently return (or 0 if the queue is
+    //  empty) - lock-free and possibly stale, like highest_priority_hint
+    T front_hint(void) const;
+
     // it is possible to subscribe to queue updates - notifications are sent when
     //  a new item arrives at a higher priority level than what is already available
     //  and offers the item for immediate retrieval - if a callback returns true, the
@@ -91,6 +105,9 @@ namespace Realm {
     // 'highest_priority' may be read without the lock held, but only written with the lock
     priority_t highest_priority;
 
+    // same rules as 'highest_priority' - a copy of the item at the front of the queue
+    T front_item;
+
     // this lock protects everything else
     mutable LT lock;
 
@@ -104,6 +121,93 @@ namespace Realm {
     ProfilingGauges::AbsoluteRangeGauge<int> *entries_in_queue;
   };
 
+  // a sharded priority queue spreads its contents over several independent
+  //  PriorityQueue's (each with its own lock) to reduce lock contention when
+  //  many producers and consumers share a single queue - the interface is the
+  //  same as PriorityQueue
+  // every item is tagged with a sequence number (increasing for puts to the
+  //  back, decreasing for puts to the front) and ties in priority between
+  //  shards go to the smallest one, so FIFO order within a priority level is
+  //  kept up to races between concurrent puts and gets - puts to the front all
+  //  go to the first shard so that they come back out in LIFO order
+  // with a single shard (the default), behavior is identical to PriorityQueue
+  template <typename T, typename LT>
+  class ShardedPriorityQueue {
+  public:
+    // what actually gets stored in the shards
+    struct Entry {
+      Entry(T _item = 0, long long _seq = 0) : item(_item), seq(_seq) {}
+      T item;
+      long long seq;
+    };
+
+    typedef PriorityQueue<Entry, LT> SHARDTYPE;
+
+    ShardedPriorityQueue(void);
+    ~ShardedPriorityQueue(void);
+
+    typedef T ITEMTYPE;
+    typedef typename SHARDTYPE::priority_t priority_t;
+    static const priority_t PRI_MAX_FINITE = SHARDTYPE::PRI_MAX_FINITE;
+    static const priority_t PRI_MIN_FINITE = SHARDTYPE::PRI_MIN_FINITE;
+    static const priority_t PRI_POS_INF = SHARDTYPE::PRI_POS_INF;
+    static const priority_t PRI_NEG_INF = SHARDTYPE::PRI_NEG_INF;
+
+    // subscribers see plain items, just like with a PriorityQueue
+    typedef typename PriorityQueue<T, LT>::NotificationCallback NotificationCallback;
+
+    // changes the number of shards - may only be called while the queue is empty
+    //  and before any subscriptions or gauges have been added
+    void set_num_shards(int new_num_shards);
+    int get_num_shards(void) const;
+
+    void put(T item, priority_t priority, bool add_to_back = true);
+
+    // all the items go into a single shard, taking its lock once per small
+    //  batch of items
+    void put_multiple(const T *items, const priority_t *priorities, size_t count,
+		      bool add_to_back = true);
+
+    T get(priority_t *item_priority, priority_t higher_than = PRI_NEG_INF);
+
+    T peek(priority_t *item_priority, priority_t higher_than = PRI_NEG_INF) const;
+
+    // lock-free, like PriorityQueue::empty
+    bool empty(priority_t higher_than = PRI_NEG_INF) const;
+
+    // subscriptions are added to every shard - a subscriber may therefore see
+    //  a notification for an item that is not higher priority than an item
+    //  sitting in a different shard
+    void add_subscription(NotificationCallback *callback, priority_t higher_than = PRI_NEG_INF);
+    void remove_subscription(NotificationCallback *callback);
+
+    void set_gauge(ProfilingGauges::AbsoluteRangeGauge<int> *new_gauge);
+
+  protected:
+    // picks the shard a new item goes into and the sequence number(s) for it
+    int choose_put_shard(bool add_to_back, long long *seq, size_t count = 1);
+
+    // picks the shard holding the highest priority item (oldest first for
+    //  ties), or -1 if there is nothing above 'higher_than'
+    int choose_get_shard(priority_t higher_than) const;
+
+    // unwraps the shards' entries for a subscriber
+    class CallbackAdapter : public SHARDTYPE::NotificationCallback {
+    public:
+      CallbackAdapter(NotificationCallback *_callback);
+      virtual ~CallbackAdapter(void);
+      virtual bool item_available(Entry entry, priority_t item_priority);
+      NotificationCallback *callback;
+    };
+
+    int num_shards;
+    SHARDTYPE *shards;
+    unsigned next_put_shard;
+    long long next_back_seq, next_front_seq;
+    LT adapter_lock;  // protects 'adapters'
+    std::map<NotificationCallback *, CallbackAdapter *> adapters;
+  };
+
 }; // namespace Realm
 
 #include "pri_queue.inl"
@@ -27,6 +27,7 @@ namespace Realm {
   template <typename T, typename LT>
   inline PriorityQueue<T, LT>::PriorityQueue(void)
     : highest_priority (PRI_NEG_INF)
+    , front_item (0)
     , entries_in_queue (0)
   {
   }
@@ -86,10 +87,64 @@ namespace Realm {
     else
       dq.push_front(item);
 
+    // it's the new front item if it's at the front of the highest priority list
+    if((priority == highest_priority) && (!add_to_back || (dq.size() == 1)))
+      front_item = item;
+
     // all done
     lock.unlock();
   }
 
+  template <typename T, typename LT>
+  inline void PriorityQueue<T, LT>::put_multiple(const T *items,
+						 const priority_t *priorities,
+						 size_t count,
+						 bool add_to_back /*= true*/)
+  {
+    if(count == 0)
+      return;
+
+    if(entries_in_queue)
+      (*entries_in_queue) += int(count);
+
+    size_t taken = 0;
+
+    lock.lock();
+
+    for(size_t i = 0; i < count; i++) {
+      priority_t priority = priorities[i];
+      if(priority > PRI_MAX_FINITE)
+	priority = PRI_MAX_FINITE;
+      else if(priority < PRI_MIN_FINITE)
+	priority = PRI_MIN_FINITE;
+
+      // same notification logic as put()
+      if(priority > highest_priority) {
+	priority_t orig_highest = highest_priority;
+	highest_priority = priority;
+	if(perform_notifications(items[i], priority)) {
+	  highest_priority = orig_highest;
+	  taken++;
+	  continue;
+	}
+      }
+
+      std::deque<T>& dq = queue[-priority]; // remember negation...
+      if(add_to_back)
+	dq.push_back(items[i]);
+      else
+	dq.push_front(items[i]);
+
+      if((priority == highest_priority) && (!add_to_back || (dq.size() == 1)))
+	front_item = items[i];
+    }
+
+    lock.unlock();
+
+    if(entries_in_queue && (taken > 0))
+      (*entries_in_queue) -= int(taken);
+  }
+
   // getting an item is always from the front of the list and can be filtered to
   //  ignore things that aren't above a specified priority
   // the priority of the retrieved item (if any) is returned in *item_priority
@@ -126,6 +181,10 @@ namespace Realm {
 			    PRI_NEG_INF :
 			    -(queue.begin()->first));
     }
+    if(queue.empty())
+      front_item = 0;
+    else
+      front_item = queue.begin()->second.front();
 
     // release lock and then return result
     lock.unlock();
@@ -182,6 +241,18 @@ namespace Realm {
     return(highest_priority <= higher_than);
   }
 
+  template <typename T, typename LT>
+  inline typename PriorityQueue<T, LT>::priority_t PriorityQueue<T, LT>::highest_priority_hint(void) const
+  {
+    return highest_priority;
+  }
+
+  template <typename T, typename LT>
+  inline T PriorityQueue<T, LT>::front_hint(void) const
+  {
+    return front_item;
+  }
+
   // adds (or modifies) a subscription - only items above the specified priority will
   //  result in callbacks
   template <typename T, typename LT>
@@ -233,4 +304,249 @@ namespace Realm {
     entries_in_queue = new_gauge;
   }
 
+
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class ShardedPriorityQueue<T, LT>
+
+  template <typename T, typename LT>
+  inline ShardedPriorityQueue<T, LT>::CallbackAdapter::CallbackAdapter(NotificationCallback *_callback)
+    : callback(_callback)
+  {
+  }
+
+  template <typename T, typename LT>
+  inline ShardedPriorityQueue<T, LT>::CallbackAdapter::~CallbackAdapter(void)
+  {
+  }
+
+  template <typename T, typename LT>
+  inline bool ShardedPriorityQueue<T, LT>::CallbackAdapter::item_available(Entry entry,
+									   priority_t item_priority)
+  {
+    return callback->item_available(entry.item, item_priority);
+  }
+
+  template <typename T, typename LT>
+  inline ShardedPriorityQueue<T, LT>::ShardedPriorityQueue(void)
+    : num_shards(1)
+    , shards(new SHARDTYPE[1])
+    , next_put_shard(0)
+    , next_back_seq(0)
+    , next_front_seq(-1)
+  {
+  }
+
+  template <typename T, typename LT>
+  inline ShardedPriorityQueue<T, LT>::~ShardedPriorityQueue(void)
+  {
+    delete[] shards;
+    for(typename std::map<NotificationCallback *, CallbackAdapter *>::iterator it = adapters.begin();
+	it != adapters.end();
+	it++)
+      delete it->second;
+  }
+
+  template <typename T, typename LT>
+  inline void ShardedPriorityQueue<T, LT>::set_num_shards(int new_num_shards)
+  {
+    assert(new_num_shards > 0);
+    if(new_num_shards == num_shards)
+      return;
+
+    // can only be done on a queue nobody is using yet
+    for(int i = 0; i < num_shards; i++)
+      assert(shards[i].empty());
+
+    delete[] shards;
+    num_shards = new_num_shards;
+    shards = new SHARDTYPE[num_shards];
+  }
+
+  template <typename T, typename LT>
+  inline int ShardedPriorityQueue<T, LT>::get_num_shards(void) const
+  {
+    return num_shards;
+  }
+
+  template <typename T, typename LT>
+  inline int ShardedPriorityQueue<T, LT>::choose_put_shard(bool add_to_back,
+							   long long *seq,
+							   size_t count /*= 1*/)
+  {
+    // puts to the front all go to shard 0 (so they stay in LIFO order) and
+    //  count down from -1, so they win ties against anything put to the back
+    if(!add_to_back) {
+      *seq = __sync_fetch_and_sub(&next_front_seq, (long long)count);
+      return 0;
+    }
+
+    *seq = __sync_fetch_and_add(&next_back_seq, (long long)count);
+    // simple round-robin - the counter is not protected by any lock, but a
+    //  lost update just means two items land in the same shard
+    return (__sync_fetch_and_add(&next_put_shard, 1) % num_shards);
+  }
+
+  template <typename T, typename LT>
+  inline int ShardedPriorityQueue<T, LT>::choose_get_shard(priority_t higher_than) const
+  {
+    // uses the lock-free hints, so the answer may be stale by the time the
+    //  caller gets to the shard
+    int best = -1;
+    priority_t best_priority = higher_than;
+    long long best_seq = 0;
+    for(int i = 0; i < num_shards; i++) {
+      priority_t p = shards[i].highest_priority_hint();
+      if(p < best_priority)
+	continue;
+      if((p == best_priority) && ((best < 0) ||
+				  (shards[i].front_hint().seq >= best_seq)))
+	continue;
+      best = i;
+      best_priority = p;
+      best_seq = shards[i].front_hint().seq;
+    }
+    return best;
+  }
+
+  template <typename T, typename LT>
+  inline void ShardedPriorityQueue<T, LT>::put(T item,
+					       priority_t priority,
+					       bool add_to_back /*= true*/)
+  {
+    if(num_shards == 1) {
+      shards[0].put(Entry(item), priority, add_to_back);
+      return;
+    }
+
+    long long seq;
+    int shard = choose_put_shard(add_to_back, &seq);
+    shards[shard].put(Entry(item, seq), priority, add_to_back);
+  }
+
+  template <typename T, typename LT>
+  inline void ShardedPriorityQueue<T, LT>::put_multiple(const T *items,
+							const priority_t *priorities,
+							size_t count,
+							bool add_to_back /*= true*/)
+  {
+    if(count == 0)
+      return;
+
+    long long seq = 0;
+    int shard = ((num_shards == 1) ?
+		   0 :
+		   choose_put_shard(add_to_back, &seq, count));
+
+    // wrap the items in batches on the stack - each item gets its own sequence
+    //  number, in the direction the items are added to the shard
+    static const size_t BATCH_SIZE = 16;
+    Entry entries[BATCH_SIZE];
+    for(size_t base = 0; base < count; base += BATCH_SIZE) {
+      size_t batch = (((count - base) < BATCH_SIZE) ? (count - base) : BATCH_SIZE);
+      for(size_t i = 0; i < batch; i++) {
+	long long offset = (long long)(base + i);
+	entries[i] = Entry(items[base + i],
+			   ((num_shards == 1) ? 0 :
+			    add_to_back ? (seq + offset) : (seq - offset)));
+      }
+      shards[shard].put_multiple(entries, priorities + base, batch, add_to_back);
+    }
+  }
+
+  template <typename T, typename LT>
+  inline T ShardedPriorityQueue<T, LT>::get(priority_t *item_priority,
+					    priority_t higher_than /*= PRI_NEG_INF*/)
+  {
+    if(num_shards == 1)
+      return shards[0].get(item_priority, higher_than).item;
+
+    // each pass picks the shard with the highest priority (and then oldest)
+    //  item and tries to get from it - a failed attempt means somebody else
+    //  got there first, so start over with updated information
+    while(true) {
+      int best = choose_get_shard(higher_than);
+
+      // nothing above the threshold anywhere
+      if(best < 0)
+	return 0; // TODO - EMPTY_VAL
+
+      Entry entry = shards[best].get(item_priority, higher_than);
+      if(entry.item)
+	return entry.item;
+    }
+  }
+
+  template <typename T, typename LT>
+  inline T ShardedPriorityQueue<T, LT>::peek(priority_t *item_priority,
+					     priority_t higher_than /*= PRI_NEG_INF*/) const
+  {
+    if(num_shards == 1)
+      return shards[0].peek(item_priority, higher_than).item;
+
+    // same search as get(), but the answer is even less reliable with
+    //  multiple getters
+    while(true) {
+      int best = choose_get_shard(higher_than);
+
+      if(best < 0)
+	return 0; // TODO - EMPTY_VAL
+
+      Entry entry = shards[best].peek(item_priority, higher_than);
+      if(entry.item)
+	return entry.item;
+    }
+  }
+
+  template <typename T, typename LT>
+  inline bool ShardedPriorityQueue<T, LT>::empty(priority_t higher_than /*= PRI_NEG_INF*/) const
+  {
+    for(int i = 0; i < num_shards; i++)
+      if(!shards[i].empty(higher_than))
+	return false;
+    return true;
+  }
+
+  template <typename T, typename LT>
+  inline void ShardedPriorityQueue<T, LT>::add_subscription(NotificationCallback *callback,
+							    priority_t higher_than /*= PRI_NEG_INF*/)
+  {
+    // the shards hold entries, so each subscriber gets an adapter (shared by
+    //  all the shards) that hands it just the item
+    adapter_lock.lock();
+    CallbackAdapter *&adapter = adapters[callback];
+    if(!adapter)
+      adapter = new CallbackAdapter(callback);
+    adapter_lock.unlock();
+
+    for(int i = 0; i < num_shards; i++)
+      shards[i].add_subscription(adapter, higher_than);
+  }
+
+  template <typename T, typename LT>
+  inline void ShardedPriorityQueue<T, LT>::remove_subscription(NotificationCallback *callback)
+  {
+    adapter_lock.lock();
+    typename std::map<NotificationCallback *, CallbackAdapter *>::iterator it = adapters.find(callback);
+    if(it == adapters.end()) {
+      adapter_lock.unlock();
+      return;
+    }
+    CallbackAdapter *adapter = it->second;
+    adapters.erase(it);
+    adapter_lock.unlock();
+
+    for(int i = 0; i < num_shards; i++)
+      shards[i].remove_subscription(adapter);
+    delete adapter;
+  }
+
+  template <typename T, typename LT>
+  inline void ShardedPriorityQueue<T, LT>::set_gauge(ProfilingGauges::AbsoluteRangeGauge<int> *new_gauge)
+  {
+    for(int i = 0; i < num_shards; i++)
+      shards[i].set_gauge(new_gauge);
+  }
+
 }; // namespace Realm
@@ -136,7 +136,7 @@ namespace Realm {
 #endif
 
       p->spawn_task(func_id, args, arglen, ProfilingRequestSet(),
-		    wait_on, e, priority);
+		    wait_on, e, priority, Task::NO_DEADLINE);
       return e;
     }
 
@@ -161,10 +161,41 @@ namespace Realm {
 #endif
 
       p->spawn_task(func_id, args, arglen, reqs,
-		    wait_on, e, priority);
+		    wait_on, e, priority, Task::NO_DEADLINE);
       return e;
     }
 
+    Event Processor::spawn_with_deadline(TaskFuncID func_id, const void *args, size_t arglen,
+					 const ProfilingRequestSet &reqs,
+					 long long deadline,
+					 Event wait_on) const
+    {
+      DetailedTimer::ScopedPush sp(TIME_LOW_LEVEL);
+      ProcessorImpl *p = get_runtime()->get_processor_impl(*this);
+
+      assert(deadline >= 0);
+
+      GenEventImpl *finish_event = GenEventImpl::create_genevent();
+      Event e = finish_event->current_event();
+
+      // the priority is only used for ordering relative to resumed workers
+      p->spawn_task(func_id, args, arglen, reqs,
+		    wait_on, e, 0 /*priority*/, deadline);
+      return e;
+    }
+
+    void Processor::spawn_batch(TaskFuncID func_id, size_t count,
+				const void *const *args, const size_t *arglens,
+				Event *finish_events,
+				Event wait_on, int priority) const
+    {
+      SpawnBatch batch;
+      for(size_t i = 0; i < count; i++)
+	finish_events[i] = batch.spawn(*this, func_id, args[i], arglens[i],
+				       wait_on, priority);
+      batch.submit();
+    }
+
     AddressSpace Processor::address_space(void) const
     {
       // this is a hack for the Legion runtime, which only calls it on processor, not proc groups
@@ -383,6 +414,57 @@ namespace Realm {
     }
 
 
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class SpawnBatch
+  //
+
+    SpawnBatch::SpawnBatch(void)
+    {}
+
+    SpawnBatch::~SpawnBatch(void)
+    {
+      submit();
+    }
+
+    Event SpawnBatch::spawn(Processor target, Processor::TaskFuncID func_id,
+			    const void *args, size_t arglen,
+			    Event wait_on, int priority)
+    {
+      return spawn(target, func_id, args, arglen, ProfilingRequestSet(),
+		   wait_on, priority);
+    }
+
+    Event SpawnBatch::spawn(Processor target, Processor::TaskFuncID func_id,
+			    const void *args, size_t arglen,
+			    const ProfilingRequestSet &requests,
+			    Event wait_on, int priority)
+    {
+      DetailedTimer::ScopedPush sp(TIME_LOW_LEVEL);
+      ProcessorImpl *p = get_runtime()->get_processor_impl(target);
+
+      GenEventImpl *finish_event = GenEventImpl::create_genevent();
+      Event e = finish_event->current_event();
+
+      p->spawn_task_batched(func_id, args, arglen, requests,
+			    wait_on, e, priority, held_tasks[target]);
+      return e;
+    }
+
+    void SpawnBatch::submit(void)
+    {
+      for(std::map<Processor, std::vector<Task *> >::iterator it = held_tasks.begin();
+	  it != held_tasks.end();
+	  it++) {
+	if(it->second.empty())
+	  continue;
+	ProcessorImpl *p = get_runtime()->get_processor_impl(it->first);
+	p->enqueue_tasks(it->second);
+      }
+      held_tasks.clear();
+    }
+
+
   ////////////////////////////////////////////////////////////////////////
   //
   // class ProcessorImpl
@@ -390,12 +472,22 @@ namespace Realm {
 
     ProcessorImpl::ProcessorImpl(Processor _me, Processor::Kind _kind,
                                  int _num_cores)
-      : me(_me), kind(_kind), num_cores(_num_cores)
+      : me(_me), kind(_kind), num_cores(_num_cores), task_free_list(0)
     {
     }
 
     ProcessorImpl::~ProcessorImpl(void)
     {
+      // tasks may still be holding on to storage from the free list, so it
+      //  cleans itself up once they're gone
+      if(task_free_list)
+	task_free_list->retire();
+    }
+
+    void ProcessorImpl::create_task_free_list(void)
+    {
+      if(!task_free_list && (Config::task_free_list_size > 0))
+	task_free_list = new TaskFreeList(Config::task_free_list_size);
     }
 
     void ProcessorImpl::shutdown(void)
@@ -417,6 +509,55 @@ namespace Realm {
       assert(0);
     }
 
+    bool ProcessorImpl::has_task_variant(Processor::TaskFuncID func_id) const
+    {
+      // only local task processors keep a task table
+      return false;
+    }
+
+    void ProcessorImpl::spawn_task_batched(Processor::TaskFuncID func_id,
+					   const void *args, size_t arglen,
+					   const ProfilingRequestSet &reqs,
+					   Event start_event, Event finish_event,
+					   int priority, std::vector<Task *>& ready)
+    {
+      // no batching possible - just spawn it
+      spawn_task(func_id, args, arglen, reqs, start_event, finish_event, priority,
+		 Task::NO_DEADLINE);
+    }
+
+    void ProcessorImpl::enqueue_tasks(const std::vector<Task *>& tasks)
+    {
+      for(std::vector<Task *>::const_iterator it = tasks.begin();
+	  it != tasks.end();
+	  it++)
+	enqueue_task(*it);
+    }
+
+    bool ProcessorImpl::admit_task(Task *task, Event start_event)
+    {
+      get_runtime()->optable.add_local_operation(task->get_finish_event(), task);
+
+      // if the start event has already triggered, we can enqueue right away
+      bool poisoned = false;
+      if (start_event.has_triggered_faultaware(poisoned)) {
+	if(poisoned) {
+	  log_poison.info() << "cancelling poisoned task - task=" << task << " after=" << task->get_finish_event();
+	  task->handle_poisoned_precondition(start_event);
+	  return false;
+	}
+	return true;
+      }
+
+      EventImpl::add_waiter(start_event, new DeferredTaskSpawn(this, task));
+      return false;
+    }
+
+
+  namespace Config {
+    // how long (in us) a group task stays reserved for its preferred member
+    int procgroup_affinity_us = 0;
+  };
 
   ////////////////////////////////////////////////////////////////////////
   //
@@ -426,13 +567,19 @@ namespace Realm {
     ProcessorGroup::ProcessorGroup(void)
       : ProcessorImpl(Processor::NO_PROC, Processor::PROC_GROUP),
 	members_valid(false), members_requested(false), next_free(0)
-      , ready_task_count(0)
+      , ready_task_count(0), affinity_hits(0), affinity_misses(0)
     {
     }
 
     ProcessorGroup::~ProcessorGroup(void)
     {
       delete ready_task_count;
+      for(std::map<Processor, ThreadedTaskScheduler::TaskQueue *>::iterator it = affinity_queues.begin();
+	  it != affinity_queues.end();
+	  it++)
+	delete it->second;
+      delete affinity_hits;
+      delete affinity_misses;
     }
 
     void ProcessorGroup::init(Processor _me, int _owner)
@@ -451,6 +598,18 @@ namespace Realm {
       // can only be done once
       assert(!members_valid);
 
+      // affinity queues have to exist before members hook up to them
+      if(Config::procgroup_affinity_us > 0) {
+	for(std::vector<Processor>::const_iterator it = member_list.begin();
+	    it != member_list.end();
+	    it++)
+	  if(it->kind() != Processor::PROC_GROUP)
+	    affinity_queues[*it] = new ThreadedTaskScheduler::TaskQueue;
+	std::string gname = stringbuilder() << "realm/proc " << me;
+	affinity_hits = new ProfilingGauges::EventCounter<int>(gname + "/affinity hits");
+	affinity_misses = new ProfilingGauges::EventCounter<int>(gname + "/affinity misses");
+      }
+
       for(std::vector<Processor>::const_iterator it = member_list.begin();
 	  it != member_list.end();
 	  it++) {
@@ -462,7 +621,9 @@ namespace Realm {
       members_requested = true;
       members_valid = true;
 
-      // now that we exist, profile our queue depth
+      // now that we exist, size our queue and profile its depth
+      task_queue.set_num_shards(Config::task_queue_shards);
+      create_task_free_list();
       std::string gname = stringbuilder() << "realm/proc " << me << "/ready tasks";
       ready_task_count = new ProfilingGauges::AbsoluteRangeGauge<int>(gname);
       task_queue.set_gauge(ready_task_count);
@@ -478,15 +639,82 @@ namespace Realm {
 	member_list.push_back((*it)->me);
     }
 
+    void ProcessorGroup::record_affinity_result(bool hit)
+    {
+      if(hit)
+	(*affinity_hits) += 1;
+      else
+	(*affinity_misses) += 1;
+    }
+
+    ThreadedTaskScheduler::TaskQueue *ProcessorGroup::choose_affinity_queue(Task *task)
+    {
+      if(affinity_queues.empty() || (task->deadline != Task::NO_DEADLINE) ||
+	 (task->func_id < Processor::TASK_ID_FIRST_AVAILABLE))
+	return 0;
+
+      // the calling thread is usually the one that just finished the task's
+      //  predecessor, so its processor's core has the inputs in cache
+      Processor p = Processor::get_executing_processor();
+      if(!p.exists())
+	return 0;
+      std::map<Processor, ThreadedTaskScheduler::TaskQueue *>::const_iterator it = affinity_queues.find(p);
+      if(it == affinity_queues.end())
+	return 0;
+
+      task->preferred_proc = p;
+      task->preferred_until = (Clock::current_time_in_nanoseconds() +
+			       (long long)Config::procgroup_affinity_us * 1000);
+      return it->second;
+    }
+
     void ProcessorGroup::enqueue_task(Task *task)
     {
       // put it into the task queue - one of the member procs will eventually grab it
-      if(task->mark_ready())
-	task_queue.put(task, task->priority);
-      else
+      if(task->mark_ready()) {
+	if(task->deadline != Task::NO_DEADLINE)
+	  deadline_queue.put(task);
+	else {
+	  ThreadedTaskScheduler::TaskQueue *aq = choose_affinity_queue(task);
+	  if(aq)
+	    aq->put(task, task->priority);
+	  else
+	    task_queue.put(task, task->priority);
+	}
+      } else
 	task->mark_finished(false /*!successful*/);
     }
 
+    void ProcessorGroup::enqueue_tasks(const std::vector<Task *>& tasks)
+    {
+      std::vector<Task *> items;
+      std::vector<int> priorities;
+      items.reserve(tasks.size());
+      priorities.reserve(tasks.size());
+      for(std::vector<Task *>::const_iterator it = tasks.begin();
+	  it != tasks.end();
+	  it++)
+	if((*it)->mark_ready()) {
+	  items.push_back(*it);
+	  priorities.push_back((*it)->priority);
+	} else
+	  (*it)->mark_finished(false /*!successful*/);
+
+      if(items.empty())
+	return;
+
+      // a batch is made ready by a single thread, so it shares one hint
+      ThreadedTaskScheduler::TaskQueue *aq = choose_affinity_queue(items[0]);
+      if(aq) {
+	for(size_t i = 1; i < items.size(); i++) {
+	  items[i]->preferred_proc = items[0]->preferred_proc;
+	  items[i]->preferred_until = items[0]->preferred_until;
+	}
+	aq->put_multiple(&items[0], &priorities[0], items.size());
+      } else
+	task_queue.put_multiple(&items[0], &priorities[0], items.size());
+    }
+
     void ProcessorGroup::add_to_group(ProcessorGroup *group)
     {
       // recursively add all of our members
@@ -502,22 +730,26 @@ namespace Realm {
 						const void *args, size_t arglen,
                                                 const ProfilingRequestSet &reqs,
 						Event start_event, Event finish_event,
-						int priority)
+						int priority, long long deadline)
     {
       // create a task object and insert it into the queue
-      Task *task = new Task(me, func_id, args, arglen, reqs,
-                            start_event, finish_event, priority);
-      get_runtime()->optable.add_local_operation(finish_event, task);
+      Task *task = new(task_free_list) Task(me, func_id, args, arglen, reqs,
+					    start_event, finish_event, priority);
+      task->deadline = deadline;
+      if(admit_task(task, start_event))
+	enqueue_task(task);
+    }
 
-      bool poisoned = false;
-      if (start_event.has_triggered_faultaware(poisoned)) {
-	if(poisoned) {
-	  log_poison.info() << "cancelling poisoned task - task=" << task << " after=" << task->get_finish_event();
-	  task->handle_poisoned_precondition(start_event);
-	} else
-	  enqueue_task(task);
-      } else
-	EventImpl::add_waiter(start_event, new DeferredTaskSpawn(this, task));
+    /*virtual*/ void ProcessorGroup::spawn_task_batched(Processor::TaskFuncID func_id,
+							const void *args, size_t arglen,
+							const ProfilingRequestSet &reqs,
+							Event start_event, Event finish_event,
+							int priority, std::vector<Task *>& ready)
+    {
+      Task *task = new(task_free_list) Task(me, func_id, args, arglen, reqs,
+					    start_event, finish_event, priority);
+      if(admit_task(task, start_event))
+	ready.push_back(task);
     }
 
 
@@ -576,7 +808,7 @@ namespace Realm {
       fbd >> prs;
       
     p->spawn_task(args.func_id, data, args.user_arglen, prs,
-		  args.start_event, args.finish_event, args.priority);
+		  args.start_event, args.finish_event, args.priority, args.deadline);
   }
 
   /*static*/ void SpawnTaskMessage::send_request(gasnet_node_t target, Processor proc,
@@ -584,7 +816,7 @@ namespace Realm {
 						 const void *args, size_t arglen,
 						 const ProfilingRequestSet *prs,
 						 Event start_event, Event finish_event,
-						 int priority)
+						 int priority, long long deadline)
   {
     RequestArgs r_args;
 
@@ -593,6 +825,7 @@ namespace Realm {
     r_args.start_event = start_event;
     r_args.finish_event = finish_event;
     r_args.priority = priority;
+    r_args.deadline = deadline;
     r_args.user_arglen = arglen;
     
     if(!prs || prs->empty()) {
@@ -741,7 +974,7 @@ namespace Realm {
 				     const void *args, size_t arglen,
 				     const ProfilingRequestSet &reqs,
 				     Event start_event, Event finish_event,
-				     int priority)
+				     int priority, long long deadline)
     {
       log_task.debug() << "sending remote spawn request:"
 		       << " func=" << func_id
@@ -762,7 +995,7 @@ namespace Realm {
 
       SpawnTaskMessage::send_request(target, me, func_id,
 				     args, arglen, &reqs,
-				     start_event, finish_event, priority);
+				     start_event, finish_event, priority, deadline);
     }
 
   
@@ -777,12 +1010,19 @@ namespace Realm {
     , sched(0)
     , ready_task_count(stringbuilder() << "realm/proc " << me << "/ready tasks")
   {
+    task_queue.set_num_shards(Config::task_queue_shards);
     task_queue.set_gauge(&ready_task_count);
+    create_task_free_list();
   }
 
   LocalTaskProcessor::~LocalTaskProcessor(void)
   {
     delete sched;
+
+    for(std::map<Processor::TaskFuncID, TaskTableEntry>::iterator it = task_table.begin();
+	it != task_table.end();
+	++it)
+      delete it->second.codedesc;
   }
 
   void LocalTaskProcessor::set_scheduler(ThreadedTaskScheduler *_sched)
@@ -791,6 +1031,7 @@ namespace Realm {
 
     // add our task queue to the scheduler
     sched->add_task_queue(&task_queue);
+    sched->add_deadline_queue(&deadline_queue);
 
     // this should be requested from outside now
 #if 0
@@ -813,41 +1054,149 @@ namespace Realm {
 
   void LocalTaskProcessor::add_to_group(ProcessorGroup *group)
   {
-    // add the group's task queue to our scheduler too
+    // add the group's task queues to our scheduler too
     sched->add_task_queue(&group->task_queue);
+    sched->add_deadline_queue(&group->deadline_queue);
+
+    // our own affinity queue is just another task queue, while the other
+    //  members' are only stolen from
+    for(std::map<Processor, ThreadedTaskScheduler::TaskQueue *>::const_iterator it = group->affinity_queues.begin();
+	it != group->affinity_queues.end();
+	it++)
+      if(it->first == me)
+	sched->add_task_queue(it->second);
+      else
+	sched->add_steal_queue(it->second);
+  }
+
+  void LocalTaskProcessor::add_steal_victim(LocalTaskProcessor *victim)
+  {
+    assert(victim != this);
+    sched->add_steal_queue(&victim->task_queue);
+  }
+
+  void LocalTaskProcessor::enable_spin_waiting(long long max_spin_ns)
+  {
+    sched->configure_spinning(max_spin_ns,
+			      stringbuilder() << "realm/proc " << me);
+  }
+
+  void LocalTaskProcessor::enable_autoscaling(int max_active_workers,
+					      long long interval_ns)
+  {
+    sched->configure_autoscaling(1, max_active_workers, interval_ns,
+				 stringbuilder() << "realm/proc " << me);
   }
 
   void LocalTaskProcessor::enqueue_task(Task *task)
   {
-    // just jam it into the task queue
-    if(task->mark_ready())
-      task_queue.put(task, task->priority);
-    else
+    // just jam it into the right queue
+    if(task->mark_ready()) {
+      if(task->deadline != Task::NO_DEADLINE)
+	deadline_queue.put(task);
+      else
+	task_queue.put(task, task->priority);
+    } else
       task->mark_finished(false /*!successful*/);
   }
 
+  void LocalTaskProcessor::enqueue_tasks(const std::vector<Task *>& tasks)
+  {
+    // same as enqueue_task, but everything goes in under a single queue lock
+    std::vector<Task *> items;
+    std::vector<int> priorities;
+    items.reserve(tasks.size());
+    priorities.reserve(tasks.size());
+    for(std::vector<Task *>::const_iterator it = tasks.begin();
+	it != tasks.end();
+	it++)
+      if((*it)->mark_ready()) {
+	items.push_back(*it);
+	priorities.push_back((*it)->priority);
+      } else
+	(*it)->mark_finished(false /*!successful*/);
+
+    if(!items.empty())
+      task_queue.put_multiple(&items[0], &priorities[0], items.size());
+  }
+
   void LocalTaskProcessor::spawn_task(Processor::TaskFuncID func_id,
 				     const void *args, size_t arglen,
 				     const ProfilingRequestSet &reqs,
 				     Event start_event, Event finish_event,
-				     int priority)
+				     int priority, long long deadline)
   {
     // create a task object for this
-    Task *task = new Task(me, func_id, args, arglen, reqs,
-			  start_event, finish_event, priority);
-    get_runtime()->optable.add_local_operation(finish_event, task);
+    Task *task = new(task_free_list) Task(me, func_id, args, arglen, reqs,
+					  start_event, finish_event, priority);
+    task->deadline = deadline;
+    if(admit_task(task, start_event))
+      enqueue_task(task);
+  }
 
-    // if the start event has already triggered, we can enqueue right away
-    bool poisoned = false;
-    if (start_event.has_triggered_faultaware(poisoned)) {
-      if(poisoned) {
-	log_poison.info() << "cancelling poisoned task - task=" << task << " after=" << task->get_finish_event();
-	task->handle_poisoned_precondition(start_event);
-      } else
-	enqueue_task(task);
-    } else {
-      EventImpl::add_waiter(start_event, new DeferredTaskSpawn(this, task));
+  void LocalTaskProcessor::spawn_task_batched(Processor::TaskFuncID func_id,
+					      const void *args, size_t arglen,
+					      const ProfilingRequestSet &reqs,
+					      Event start_event, Event finish_event,
+					      int priority, std::vector<Task *>& ready)
+  {
+    Task *task = new(task_free_list) Task(me, func_id, args, arglen, reqs,
+					  start_event, finish_event, priority);
+    if(admit_task(task, start_event))
+      ready.push_back(task);
+  }
+
+  namespace Config {
+    int lazy_task_translation = 1;
+  };
+
+  // node-wide cache of translated task code, keyed by the (portable)
+  //  serialization of the code descriptor, so that each distinct piece of
+  //  code is translated once no matter how many processors register it
+  static GASNetHSL translated_code_mutex;
+  static std::map<std::string, Processor::TaskFuncPtr> translated_code;
+
+  static Processor::TaskFuncPtr translate_task_code(CodeDescriptor& codedesc)
+  {
+    std::string key;
+    {
+      Serialization::DynamicBufferSerializer dbs(256);
+      if(dbs << codedesc)
+	key.assign((const char *)(dbs.get_buffer()), dbs.bytes_used());
+    }
+
+    AutoHSLLock al(translated_code_mutex);
+
+    if(!key.empty()) {
+      std::map<std::string, Processor::TaskFuncPtr>::const_iterator it = translated_code.find(key);
+      if(it != translated_code.end())
+	return it->second;
+    }
+
+    const FunctionPointerImplementation *fpi = 0;
+    const std::vector<CodeTranslator *>& translators = get_runtime()->get_code_translators();
+    for(std::vector<CodeTranslator *>::const_iterator it = translators.begin();
+	it != translators.end();
+	it++)
+      if((*it)->can_translate<FunctionPointerImplementation>(codedesc)) {
+	FunctionPointerImplementation *newfpi = (*it)->translate<FunctionPointerImplementation>(codedesc);
+	if(newfpi) {
+	  log_taskreg.info() << "function pointer created: trans=" << (*it)->name << " fnptr=" << (void *)(newfpi->fnptr);
+	  codedesc.add_implementation(newfpi);
+	  fpi = newfpi;
+	  break;
+	}
+      }
+
+    if(!fpi) {
+      log_taskreg.fatal() << "no translation to a function pointer available: " << codedesc;
+      assert(0);
     }
+
+    Processor::TaskFuncPtr fnptr = (Processor::TaskFuncPtr)(fpi->fnptr);
+    if(!key.empty())
+      translated_code[key] = fnptr;
+    return fnptr;
   }
 
   void LocalTaskProcessor::register_task(Processor::TaskFuncID func_id,
@@ -861,41 +1210,50 @@ namespace Realm {
     }
 
     // next, get see if we have a function pointer to register
-    Processor::TaskFuncPtr fnptr;
+    Processor::TaskFuncPtr fnptr = 0;
+    CodeDescriptor *lazy_codedesc = 0;
     const FunctionPointerImplementation *fpi = codedesc.find_impl<FunctionPointerImplementation>();
 
-    // if we don't have a function pointer implementation, see if we can make one
-    if(!fpi) {
+    if(fpi) {
+      fnptr = (Processor::TaskFuncPtr)(fpi->fnptr);
+    } else if(Config::lazy_task_translation) {
+      // a variant that never runs here never gets translated - just make
+      //  sure somebody will be able to do it
+      bool translatable = false;
       const std::vector<CodeTranslator *>& translators = get_runtime()->get_code_translators();
       for(std::vector<CodeTranslator *>::const_iterator it = translators.begin();
 	  it != translators.end();
 	  it++)
 	if((*it)->can_translate<FunctionPointerImplementation>(codedesc)) {
-	  FunctionPointerImplementation *newfpi = (*it)->translate<FunctionPointerImplementation>(codedesc);
-	  if(newfpi) {
-	    log_taskreg.info() << "function pointer created: trans=" << (*it)->name << " fnptr=" << (void *)(newfpi->fnptr);
-	    codedesc.add_implementation(newfpi);
-	    fpi = newfpi;
-	    break;
-	  }
+	  translatable = true;
+	  break;
 	}
+      if(!translatable) {
+	log_taskreg.fatal() << "no translation to a function pointer available: " << codedesc;
+	assert(0);
+      }
+      lazy_codedesc = new CodeDescriptor(codedesc);
+    } else {
+      fnptr = translate_task_code(codedesc);
     }
 
-    assert(fpi != 0);
-
-    fnptr = (Processor::TaskFuncPtr)(fpi->fnptr);
-
-    log_taskreg.info() << "task " << func_id << " registered on " << me << ": " << codedesc;
+    log_taskreg.info() << "task " << func_id << " registered on " << me << ": " << codedesc << (lazy_codedesc ? " (translation deferred)" : "");
 
     TaskTableEntry &tte = task_table[func_id];
     tte.fnptr = fnptr;
     tte.user_data = user_data;
+    tte.codedesc = lazy_codedesc;
+  }
+
+  bool LocalTaskProcessor::has_task_variant(Processor::TaskFuncID func_id) const
+  {
+    return (task_table.count(func_id) > 0);
   }
 
   void LocalTaskProcessor::execute_task(Processor::TaskFuncID func_id,
 					const ByteArrayRef& task_args)
   {
-    std::map<Processor::TaskFuncID, TaskTableEntry>::const_iterator it = task_table.find(func_id);
+    std::map<Processor::TaskFuncID, TaskTableEntry>::iterator it = task_table.find(func_id);
     if(it == task_table.end()) {
       // TODO: remove this hack once the tools are available to the HLR to call these directly
       if(func_id < Processor::TASK_ID_FIRST_AVAILABLE) {
@@ -906,7 +1264,15 @@ namespace Realm {
       assert(0);
     }
 
-    const TaskTableEntry& tte = it->second;
+    TaskTableEntry& tte = it->second;
+
+    // first execution of a lazily-translated variant - racing threads all
+    //  get the same answer from the node-wide cache
+    if(!tte.fnptr) {
+      assert(tte.codedesc != 0);
+      tte.fnptr = translate_task_code(*tte.codedesc);
+      log_taskreg.info() << "task " << func_id << " translated on " << me << ": " << ((void *)(tte.fnptr));
+    }
 
     log_taskreg.debug() << "task " << func_id << " executing on " << me << ": " << ((void *)(tte.fnptr));
 
@@ -943,11 +1309,13 @@ namespace Realm {
   //
 
   LocalCPUProcessor::LocalCPUProcessor(Processor _me, CoreReservationSet& crs,
-				       size_t _stack_size, bool _force_kthreads)
+				       size_t _stack_size, bool _force_kthreads,
+				       int _preferred_numa_domain)
     : LocalTaskProcessor(_me, Processor::LOC_PROC)
   {
     CoreReservationParameters params;
     params.set_num_cores(1);
+    params.set_preferred_numa_domain(_preferred_numa_domain);
     params.set_alu_usage(params.CORE_USAGE_EXCLUSIVE);
     params.set_fpu_usage(params.CORE_USAGE_EXCLUSIVE);
     params.set_ldst_usage(params.CORE_USAGE_SHARED);
@@ -983,11 +1351,13 @@ namespace Realm {
   //
 
   LocalUtilityProcessor::LocalUtilityProcessor(Processor _me, CoreReservationSet& crs,
-					       size_t _stack_size, bool _force_kthreads)
+					       size_t _stack_size, bool _force_kthreads,
+					       int _preferred_numa_domain)
     : LocalTaskProcessor(_me, Processor::UTIL_PROC)
   {
     CoreReservationParameters params;
     params.set_num_cores(1);
+    params.set_preferred_numa_domain(_preferred_numa_domain);
     params.set_alu_usage(params.CORE_USAGE_SHARED);
     params.set_fpu_usage(params.CORE_USAGE_MINIMAL);
     params.set_ldst_usage(params.CORE_USAGE_SHARED);
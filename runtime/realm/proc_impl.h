@@ -49,7 +49,20 @@ namespace Realm {
 			      const void *args, size_t arglen,
                               const ProfilingRequestSet &reqs,
 			      Event start_event, Event finish_event,
-                              int priority) = 0;
+                              int priority, long long deadline) = 0;
+
+      // used by SpawnBatch - like spawn_task, but a task that could be enqueued
+      //  right away is instead appended to 'ready' so that it can be passed to
+      //  enqueue_tasks later (the default just calls spawn_task)
+      virtual void spawn_task_batched(Processor::TaskFuncID func_id,
+				      const void *args, size_t arglen,
+				      const ProfilingRequestSet &reqs,
+				      Event start_event, Event finish_event,
+				      int priority, std::vector<Task *>& ready);
+
+      // enqueues several ready tasks at once (the default enqueues them one
+      //  at a time)
+      virtual void enqueue_tasks(const std::vector<Task *>& tasks);
 
       // blocks until things are cleaned up
       virtual void shutdown(void);
@@ -60,16 +73,29 @@ namespace Realm {
 				 CodeDescriptor& codedesc,
 				 const ByteArrayRef& user_data);
 
+      // returns true if this processor can execute the specified task locally
+      virtual bool has_task_variant(Processor::TaskFuncID func_id) const;
+
     protected:
       friend class Task;
 
       virtual void execute_task(Processor::TaskFuncID func_id,
 				const ByteArrayRef& task_args);
 
+      // registers a newly-created task and checks its precondition - returns
+      //  true if the task can be enqueued now, false if it has been deferred
+      //  (or cancelled because the precondition was poisoned)
+      bool admit_task(Task *task, Event start_event);
+
+      // creates the free list used for this processor's Task objects (unless
+      //  free lists are disabled)
+      void create_task_free_list(void);
+
     public:
       Processor me;
       Processor::Kind kind;
       int num_cores;
+      TaskFreeList *task_free_list;
     }; 
 
     // generic local task processor - subclasses must create and configure a task
@@ -80,32 +106,57 @@ namespace Realm {
       virtual ~LocalTaskProcessor(void);
 
       virtual void enqueue_task(Task *task);
+      virtual void enqueue_tasks(const std::vector<Task *>& tasks);
 
       virtual void spawn_task(Processor::TaskFuncID func_id,
 			      const void *args, size_t arglen,
                               const ProfilingRequestSet &reqs,
 			      Event start_event, Event finish_event,
-                              int priority);
+                              int priority, long long deadline);
+
+      virtual void spawn_task_batched(Processor::TaskFuncID func_id,
+				      const void *args, size_t arglen,
+				      const ProfilingRequestSet &reqs,
+				      Event start_event, Event finish_event,
+				      int priority, std::vector<Task *>& ready);
 
       virtual void register_task(Processor::TaskFuncID func_id,
 				 CodeDescriptor& codedesc,
 				 const ByteArrayRef& user_data);
 
+      virtual bool has_task_variant(Processor::TaskFuncID func_id) const;
+
       // blocks until things are cleaned up
       virtual void shutdown(void);
 
       virtual void add_to_group(ProcessorGroup *group);
 
+      // (opt-in) work stealing - allows our scheduler to take eligible tasks
+      //  from 'victim's queue whenever we have nothing else to do
+      virtual void add_steal_victim(LocalTaskProcessor *victim);
+
+      // lets idle workers spin for up to 'max_spin_ns' before sleeping
+      void enable_spin_waiting(long long max_spin_ns);
+
+      // lets the scheduler adjust its worker limits at runtime (see
+      //  ThreadedTaskScheduler::configure_autoscaling)
+      void enable_autoscaling(int max_active_workers, long long interval_ns);
+
     protected:
       void set_scheduler(ThreadedTaskScheduler *_sched);
 
       ThreadedTaskScheduler *sched;
-      PriorityQueue<Task *, GASNetHSL> task_queue;
+      ThreadedTaskScheduler::TaskQueue task_queue;
+      DeadlineTaskQueue deadline_queue;
       ProfilingGauges::AbsoluteRangeGauge<int> ready_task_count;
 
       struct TaskTableEntry {
 	Processor::TaskFuncPtr fnptr;
 	ByteArray user_data;
+	// code still to be translated (see Config::lazy_task_translation) -
+	//  kept until the processor is destroyed so that concurrent first
+	//  executions never see it freed
+	CodeDescriptor *codedesc;
       };
 
       std::map<Processor::TaskFuncID, TaskTableEntry> task_table;
@@ -128,7 +179,8 @@ namespace Realm {
     class LocalCPUProcessor : public LocalTaskProcessor {
     public:
       LocalCPUProcessor(Processor _me, CoreReservationSet& crs,
-			size_t _stack_size, bool _force_kthreads);
+			size_t _stack_size, bool _force_kthreads,
+			int _preferred_numa_domain = CoreReservationParameters::NUMA_DOMAIN_DONTCARE);
       virtual ~LocalCPUProcessor(void);
     protected:
       CoreReservation *core_rsrv;
@@ -137,7 +189,8 @@ namespace Realm {
     class LocalUtilityProcessor : public LocalTaskProcessor {
     public:
       LocalUtilityProcessor(Processor _me, CoreReservationSet& crs,
-			    size_t _stack_size, bool _force_kthreads);
+			    size_t _stack_size, bool _force_kthreads,
+			    int _preferred_numa_domain = CoreReservationParameters::NUMA_DOMAIN_DONTCARE);
       virtual ~LocalUtilityProcessor(void);
     protected:
       CoreReservation *core_rsrv;
@@ -165,7 +218,7 @@ namespace Realm {
 			      const void *args, size_t arglen,
                               const ProfilingRequestSet &reqs,
 			      Event start_event, Event finish_event,
-                              int priority);
+                              int priority, long long deadline);
     };
 
     class ProcessorGroup : public ProcessorImpl {
@@ -182,7 +235,11 @@ namespace Realm {
 
       void get_group_members(std::vector<Processor>& member_list);
 
+      // called when a task carrying a placement hint starts running
+      void record_affinity_result(bool hit);
+
       virtual void enqueue_task(Task *task);
+      virtual void enqueue_tasks(const std::vector<Task *>& tasks);
 
       virtual void add_to_group(ProcessorGroup *group);
 
@@ -190,7 +247,13 @@ namespace Realm {
 			      const void *args, size_t arglen,
                               const ProfilingRequestSet &reqs,
 			      Event start_event, Event finish_event,
-                              int priority);
+                              int priority, long long deadline);
+
+      virtual void spawn_task_batched(Processor::TaskFuncID func_id,
+				      const void *args, size_t arglen,
+				      const ProfilingRequestSet &reqs,
+				      Event start_event, Event finish_event,
+				      int priority, std::vector<Task *>& ready);
 
     public: //protected:
       bool members_valid;
@@ -201,8 +264,22 @@ namespace Realm {
 
       void request_group_members(void);
 
-      PriorityQueue<Task *, GASNetHSL> task_queue;
+      // picks a placement hint for a task that is becoming ready on the
+      //  calling thread - returns the affinity queue to use, or 0 if none
+      ThreadedTaskScheduler::TaskQueue *choose_affinity_queue(Task *task);
+
+      ThreadedTaskScheduler::TaskQueue task_queue;
+      DeadlineTaskQueue deadline_queue;
       ProfilingGauges::AbsoluteRangeGauge<int> *ready_task_count;
+
+      // with affinity hints enabled, a task that becomes ready on a member
+      //  processor (e.g. because its predecessor just finished there) goes into
+      //  that member's affinity queue - the member treats it as one of its own
+      //  task queues, while the others may only steal from it once the task's
+      //  hint has expired
+      std::map<Processor, ThreadedTaskScheduler::TaskQueue *> affinity_queues;
+      ProfilingGauges::EventCounter<int> *affinity_hits;
+      ProfilingGauges::EventCounter<int> *affinity_misses;
     };
     
     // this is generally useful to all processor implementations, so put it here
@@ -266,6 +343,7 @@ namespace Realm {
 	Event finish_event;
 	size_t user_arglen;
 	int priority;
+	long long deadline;
 	Processor::TaskFuncID func_id;
       };
 
@@ -280,7 +358,7 @@ namespace Realm {
 			       const void *args, size_t arglen,
 			       const ProfilingRequestSet *prs,
 			       Event start_event, Event finish_event,
-			       int priority);
+			       int priority, long long deadline);
     };
     
     struct RegisterTaskMessage {
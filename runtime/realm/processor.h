@@ -31,6 +31,7 @@ namespace Realm {
 
     class ProfilingRequestSet;
     class CodeDescriptor;
+    class Task;
 
     class Processor {
     public:
@@ -90,6 +91,26 @@ namespace Realm {
                   const ProfilingRequestSet &requests,
                   Event wait_on = Event::NO_EVENT, int priority = 0) const;
 
+      // spawns a task in the earliest-deadline-first scheduling class - such
+      //  tasks are picked ahead of all regular tasks on the processor (running
+      //  tasks are not interrupted), in order of their absolute 'deadline', given
+      //  in nanoseconds on the Clock::current_time_in_nanoseconds() timebase
+      // whether the deadline was met can be requested via the
+      //  OperationDeadlineStatus profiling measurement
+      Event spawn_with_deadline(TaskFuncID func_id, const void *args, size_t arglen,
+				const ProfilingRequestSet &requests,
+				long long deadline,
+				Event wait_on = Event::NO_EVENT) const;
+
+      // spawns 'count' instances of the same task, with the i'th instance
+      //  receiving 'args[i]' (of length 'arglens[i]') - tasks that are ready to
+      //  run are added to the processor's queue together, and the finish event of
+      //  each instance is written to 'finish_events[i]'
+      void spawn_batch(TaskFuncID func_id, size_t count,
+		       const void *const *args, const size_t *arglens,
+		       Event *finish_events,
+		       Event wait_on = Event::NO_EVENT, int priority = 0) const;
+
       static Processor get_executing_processor(void);
 
       // dynamic task registration - this may be done for:
@@ -122,6 +143,40 @@ namespace Realm {
       static const char* get_kind_name(Kind kind);
     };
 
+    // a SpawnBatch collects task spawns (possibly for different processors) so
+    //  that they can be handed to the processors' task queues together - each
+    //  spawn returns its finish event right away, but a ready task on a local
+    //  processor is not visible to that processor until submit() is called (or
+    //  the batch is destroyed), at which point all the held tasks for a given
+    //  processor are inserted with a single queue lock acquisition
+    // tasks for remote processors and tasks whose preconditions have not
+    //  triggered are not held - they are spawned just as Processor::spawn would
+    // the caller must not wait on any held task before submitting the batch
+    class SpawnBatch {
+    public:
+      SpawnBatch(void);
+      ~SpawnBatch(void);
+
+      Event spawn(Processor target, Processor::TaskFuncID func_id,
+		  const void *args, size_t arglen,
+		  Event wait_on = Event::NO_EVENT, int priority = 0);
+
+      Event spawn(Processor target, Processor::TaskFuncID func_id,
+		  const void *args, size_t arglen,
+		  const ProfilingRequestSet &requests,
+		  Event wait_on = Event::NO_EVENT, int priority = 0);
+
+      // releases all held tasks - the batch may be reused afterwards
+      void submit(void);
+
+    protected:
+      // not copyable
+      SpawnBatch(const SpawnBatch&);
+      SpawnBatch& operator=(const SpawnBatch&);
+
+      std::map<Processor, std::vector<Task *> > held_tasks;
+    };
+
     inline std::ostream& operator<<(std::ostream& os, Processor p) { return os << std::hex << p.id << std::dec; }
 	
 }; // namespace Realm
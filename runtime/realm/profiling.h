@@ -49,6 +49,9 @@ namespace Realm {
     PMID_PCTRS_IPC,  // instructions/clocks performance counters
     PMID_PCTRS_TLB,  // TLB miss counters
     PMID_PCTRS_BP,   // branch predictor performance counters
+    PMID_OP_DEADLINE, // whether a deadline task finished in time
+    PMID_PCTRS_STALLS, // stalled cycle performance counters
+    PMID_OP_GPU_ACTIVITY, // device work issued by a GPU task
 
     // as the name suggests, this should always be last, allowing apps/runtimes
     // sitting on top of Realm to use some of the ID space
@@ -140,6 +143,43 @@ namespace Realm {
       Processor proc;
     };
 
+    // for tasks spawned with a deadline, when they were due and whether
+    //  they made it (timestamps are on the same clock as OperationTimeline)
+    struct OperationDeadlineStatus {
+      static const ProfilingMeasurementID ID = PMID_OP_DEADLINE;
+
+      typedef long long timestamp_t;
+
+      timestamp_t deadline;
+      timestamp_t complete_time;
+      bool missed;
+    };
+
+    // kernels, copies and fills issued by a GPU task, with the times they
+    //  actually occupied the device - only reported when the CUDA module
+    //  traces device activity (-cuda:cupti)
+    struct OperationGPUActivity {
+      static const ProfilingMeasurementID ID = PMID_OP_GPU_ACTIVITY;
+
+      typedef long long timestamp_t;
+
+      enum Kind {
+	KERNEL,
+	MEMCPY,
+	MEMSET,
+      };
+
+      struct Interval {
+	timestamp_t start;  // same clock as OperationTimeline
+	timestamp_t end;
+	unsigned stream;    // CUDA's id for the stream the work ran on
+	Kind kind;
+	size_t bytes;       // 0 for kernels
+      };
+
+      std::vector<Interval> intervals;
+    };
+
     // Track memories used for copies
     struct OperationMemoryUsage {
       static const ProfilingMeasurementID ID = PMID_OP_MEM_USAGE;
@@ -211,6 +251,12 @@ namespace Realm {
       long long taken_branches;
       long long mispredictions;
     };
+
+    struct StallPerfCounters {
+      static const ProfilingMeasurementID ID = PMID_PCTRS_STALLS;
+      long long stalled_cycles;   // cycles stalled on any resource
+      long long no_issue_cycles;  // cycles with no instruction issue
+    };
   };
 
   class ProfilingRequest {
@@ -23,8 +23,10 @@
 TYPE_IS_SERIALIZABLE(Realm::ProfilingMeasurementID);
 TYPE_IS_SERIALIZABLE(Realm::ProfilingMeasurements::OperationTimeline);
 TYPE_IS_SERIALIZABLE(Realm::ProfilingMeasurements::OperationEventWaits::WaitInterval);
+TYPE_IS_SERIALIZABLE(Realm::ProfilingMeasurements::OperationGPUActivity::Interval);
 TYPE_IS_SERIALIZABLE(Realm::ProfilingMeasurements::OperationMemoryUsage);
 TYPE_IS_SERIALIZABLE(Realm::ProfilingMeasurements::OperationProcessorUsage);
+TYPE_IS_SERIALIZABLE(Realm::ProfilingMeasurements::OperationDeadlineStatus);
 TYPE_IS_SERIALIZABLE(Realm::ProfilingMeasurements::InstanceMemoryUsage);
 TYPE_IS_SERIALIZABLE(Realm::ProfilingMeasurements::InstanceTimeline);
 template <Realm::ProfilingMeasurementID _ID>
@@ -32,6 +34,7 @@ TYPE_IS_SERIALIZABLE(Realm::ProfilingMeasurements::CachePerfCounters<_ID>);
 TYPE_IS_SERIALIZABLE(Realm::ProfilingMeasurements::IPCPerfCounters);
 TYPE_IS_SERIALIZABLE(Realm::ProfilingMeasurements::TLBPerfCounters);
 TYPE_IS_SERIALIZABLE(Realm::ProfilingMeasurements::BranchPredictionPerfCounters);
+TYPE_IS_SERIALIZABLE(Realm::ProfilingMeasurements::StallPerfCounters);
 
 #include "timers.h"
 
@@ -114,6 +117,18 @@ namespace Realm {
     }
 
 
+    ////////////////////////////////////////////////////////////////////////
+    //
+    // struct OperationGPUActivity
+    //
+
+    template <typename S>
+    bool serdez(S& serdez, const OperationGPUActivity& a)
+    {
+      return (serdez & a.intervals);
+    }
+
+
     ////////////////////////////////////////////////////////////////////////
     //
     // struct OperationEventWaits::WaitInterval
@@ -30,6 +30,7 @@
 #include "realm/machine.h"
 #include "realm/runtime.h"
 #include "realm/indexspace.h"
+#include "realm/rect_list.h"
 #include "realm/codedesc.h"
 
 #endif // ifndef REALM_H
@@ -33,6 +33,14 @@
 //define REALM_USE_KERNEL_AIO
 #endif
 
+// if set, an io_uring backend for async file I/O is built in (selected at
+//  runtime with -ll:io_uring) - requires the kernel uapi headers
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define REALM_USE_IO_URING
+#endif
+#endif
+
 // dynamic loading via dlfcn and a not-completely standard dladdr extension
 #define REALM_USE_DLFCN
 #define REALM_USE_DLADDR
@@ -46,6 +54,156 @@ namespace Realm {
     // if non-zero, eagerly checks deferred user event triggers for loops up to the
     //  specified limit
     extern int event_loop_detection_limit;
+
+    // if non-zero, an event trigger (or poison update) that must reach more
+    //  than this many remote nodes is sent down a spanning tree with the
+    //  given fan-out rather than directly from the owner
+    extern int event_broadcast_tree_threshold;
+    extern int event_broadcast_radix;
+
+    // if non-zero, barrier arrivals are combined on their way up a tree of
+    //  nodes with this fan-out, and triggers for many subscribers are sent
+    //  back down a tree with the same fan-out
+    extern int barrier_tree_radix;
+
+    // if non-zero, node announcements at startup are gathered up a tree of
+    //  nodes with this fan-out and the combined set sent back down it,
+    //  rather than every node sending its announcement to every other node
+    extern int announce_tree_radix;
+
+    // up to this many distinct processor (and memory) queries remember their
+    //  matches until the machine changes - 0 re-scans on every query
+    extern int machine_query_cache_size;
+
+    // if non-zero, event subscriptions (and the updates sent in response)
+    //  issued within an EventMessageBatch scope are coalesced into one
+    //  message per remote node
+    extern int event_message_batching;
+
+    // if non-zero, a user event triggered on another untriggered event is
+    //  recorded as an alias of it, and chains/merges wait on the alias directly
+    extern int event_aliasing;
+
+    // if non-zero, uncontended local reservation acquires skip the mutex
+    extern int reservation_fast_path;
+
+    // allocator policy (see MemoryAllocator::Policy) used for most memories
+    //  and for GPU framebuffer memories, respectively
+    extern int cpu_memory_allocator;
+    extern int gpu_memory_allocator;
+
+    // if non-zero, CPU memories are backed by huge pages of this size (in MB,
+    //  e.g. 2 or 1024), falling back to transparent huge page advice
+    extern int cpu_memory_huge_page_mb;
+
+    // if non-zero, files attached to a FileMemory are mmap'd, giving direct
+    //  pointers into the page cache instead of pread/pwrite access
+    extern int file_memory_mmap;
+
+    // if non-zero, a node that hands a copy/fill/reduction to another node
+    //  asks the owners of the instances involved to push their metadata to
+    //  that node rather than waiting for it to be requested
+    extern int metadata_push;
+
+    // if non-zero, at most this many remote instances' metadata are kept
+    //  valid on each node - the least recently used copies are dropped (and
+    //  re-fetched on demand) beyond that
+    extern int metadata_cache_size;
+
+    // intermediate buffers for multi-hop copies come from a pool of this
+    //  many slabs of the given size (in KB) reserved in each IB memory on
+    //  first use - 0 slabs sends them to the memory's general allocator
+    extern int dma_ib_slab_size_kb;
+    extern int dma_ib_pool_slabs;
+
+    // if non-zero, file and disk transfers are driven through io_uring
+    //  (falling back to AIO if the ring cannot be created), optionally with
+    //  a kernel-side submission polling thread - local memories are
+    //  registered as fixed buffers up to the given total size (in MB)
+    extern int aio_use_io_uring;
+    extern int aio_uring_sqpoll;
+    extern int aio_uring_regbuf_mb;
+
+    // number of helper threads that share large local memcpy transfers with
+    //  the DMA thread - requests are striped across them in pieces of at
+    //  least the given size (in KB), smaller requests are copied inline
+    extern int dma_memcpy_threads;
+    extern int dma_memcpy_stripe_kb;
+
+    // fills of at least this many KB of system memory use streaming
+    //  (non-temporal) stores - 0 disables them
+    extern int dma_fill_nt_threshold_kb;
+
+    // up to this many ready copies between the same pair of instances over
+    //  the same domain are merged into a single transfer - values below 2
+    //  disable coalescing (and the extra trip through the DMA queue)
+    extern int dma_coalesce_copies;
+
+    // multi-hop copies move data through their intermediate buffers in
+    //  chunks of this size, so that each hop can work on one chunk while
+    //  the one before it fills the next - 0 keeps the 16MB request limit
+    extern int dma_pipeline_chunk_kb;
+
+    // number of chunks in flight per intermediate buffer (i.e. the buffer
+    //  holds this many chunks) - 0 sizes buffers by the slab/64MB limit
+    extern int dma_pipeline_depth;
+
+    // relative shares of each DMA channel given to latency (priority > 0),
+    //  normal (priority == 0) and bulk (priority < 0) transfers - all 0
+    //  keeps strict priority order
+    extern int dma_share_latency, dma_share_normal, dma_share_bulk;
+
+    // number of dedicated threads performing HDF5 reads and writes - 0
+    //  performs them synchronously on the DMA thread
+    extern int hdf5_io_threads;
+
+    // sparse copies to another node whose index space averages fewer than
+    //  this many elements per run are gathered into an intermediate buffer,
+    //  sent in bulk and scattered on the remote node - 0 disables this
+    extern int dma_sparse_gather_run;
+
+    // size of the memcpys timed at startup to measure the latency and
+    //  bandwidth between local memories for dma path selection - 0 uses
+    //  per-channel defaults instead
+    extern int dma_calibrate_kb;
+
+    // remote writes of at least this many KB are sent zero-run encoded
+    //  (and decoded by the receiving node) whenever that saves at least an
+    //  eighth of the bytes - 0 always sends raw data
+    extern int dma_compress_min_kb;
+
+    // DMA threads busy-poll for new work instead of sleeping when idle,
+    //  and get exclusive cores (as with -ll:pin_dma) to do it on
+    extern int dma_poll_mode;
+
+    // number of independently-locked shards used for each processor's (and
+    //  processor group's) task queue - values above 1 reduce lock contention
+    //  at the cost of relaxing FIFO ordering within a priority level
+    extern int task_queue_shards;
+
+    // task arguments up to this many bytes are stored inside the Task object
+    //  rather than in a separate heap allocation
+    extern int task_inline_arg_size;
+
+    // maximum number of Task objects each processor keeps on a free list for
+    //  reuse - 0 disables the free lists
+    extern int task_free_list_size;
+
+    // if non-zero (and supported on this architecture), user threads are
+    //  switched by saving only callee-saved registers instead of using
+    //  swapcontext, which also saves/restores the signal mask and FP state
+    extern int user_thread_fast_switch;
+
+    // if non-zero, a task that becomes ready on a member of a processor group
+    //  is reserved for that member for up to this many microseconds before the
+    //  other members may take it
+    extern int procgroup_affinity_us;
+
+    // if non-zero, task code that needs translation (e.g. DSO references
+    //  or LLVM IR) is translated the first time the task runs on each
+    //  processor rather than at registration - translations are shared
+    //  by all the processors on a node
+    extern int lazy_task_translation;
   };
 };
 
@@ -0,0 +1,124 @@
+/* Copyright 2017 Stanford University, NVIDIA Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// structured index spaces made of a list of disjoint rectangles
+
+#ifndef REALM_RECT_LIST_H
+#define REALM_RECT_LIST_H
+
+#include "indexspace.h"
+
+#include <vector>
+#include <iostream>
+
+namespace Realm {
+
+  // a RectList describes an irregular but structured set of points (e.g. a
+  //  ghost halo, an L-shape, or a union of partition blocks) exactly, as a
+  //  list of pairwise disjoint rectangles - it is a value type, and copies
+  //  and DMAs over it are performed one rectangle at a time
+  template <int DIM>
+  class RectList {
+  public:
+    typedef LegionRuntime::Arrays::Point<DIM> PointType;
+    typedef LegionRuntime::Arrays::Rect<DIM> RectType;
+
+    RectList(void);
+    explicit RectList(const RectType& r);
+
+    // basic queries
+    bool empty(void) const;
+    size_t volume(void) const;
+    // an empty rectangle (lo > hi) is returned if the list is empty
+    RectType bounds(void) const;
+    const std::vector<RectType>& get_rects(void) const;
+
+    bool contains(const PointType& p) const;
+    bool contains(const RectType& r) const;
+    bool contains(const RectList<DIM>& other) const;
+    bool overlaps(const RectType& r) const;
+    bool overlaps(const RectList<DIM>& other) const;
+
+    // set operations - rectangles stay disjoint, but a sequence of updates
+    //  can fragment the list, so call coalesce() before iterating over
+    //  large lists
+    void add_rect(const RectType& r);
+    void subtract_rect(const RectType& r);
+    void intersect_rect(const RectType& r);
+
+    RectList<DIM>& operator|=(const RectList<DIM>& other);
+    RectList<DIM>& operator-=(const RectList<DIM>& other);
+    RectList<DIM>& operator&=(const RectList<DIM>& other);
+
+    // merges pairs of rectangles that together form a rectangle
+    void coalesce(void);
+
+    // partitioning: intersection with each of a list of blocks (which need
+    //  not be disjoint), or a split into 'count' pieces of (nearly) equal
+    //  volume that each consist of whole slabs of the original rectangles
+    void create_subsets_by_blocks(const std::vector<RectType>& blocks,
+				  std::vector<RectList<DIM> >& subsets) const;
+    void create_equal_subsets(size_t count,
+			      std::vector<RectList<DIM> >& subsets) const;
+
+    // DMA support - one copy/fill is issued per rectangle and the returned
+    //  event is the merge of their completions
+    Event fill(const std::vector<CopySrcDstField>& dsts,
+	       const void *fill_value, size_t fill_value_size,
+	       Event wait_on = Event::NO_EVENT) const;
+
+    Event copy(const std::vector<CopySrcDstField>& srcs,
+	       const std::vector<CopySrcDstField>& dsts,
+	       Event wait_on = Event::NO_EVENT,
+	       ReductionOpID redop_id = 0, bool red_fold = false) const;
+
+    // visits every point of every rectangle, a rectangle at a time
+    class PointIterator {
+    public:
+      PointIterator(const RectList<DIM>& _list);
+
+      bool valid(void) const;
+      bool step(void);
+
+      operator bool(void) const;
+      PointIterator& operator++(/*i am prefix*/);
+      PointIterator operator++(int /*i am postfix*/);
+
+      const PointType& operator*(void) const;
+
+    protected:
+      void skip_empty(void);
+
+      const RectList<DIM>& list;
+      size_t rect_idx;
+      LegionRuntime::Arrays::GenericPointInRectIterator<DIM> pir;
+    };
+
+  protected:
+    static void subtract(const RectType& from, const RectType& r,
+			 std::vector<RectType>& pieces);
+    static bool try_merge(RectType& a, const RectType& b);
+
+    std::vector<RectType> rects;
+  };
+
+  template <int DIM>
+  std::ostream& operator<<(std::ostream& os, const RectList<DIM>& l);
+
+}; // namespace Realm
+
+#include "rect_list.inl"
+
+#endif // ifndef REALM_RECT_LIST_H
@@ -0,0 +1,488 @@
+/* Copyright 2017 Stanford University, NVIDIA Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// INCLDUED FROM rect_list.h - DO NOT INCLUDE THIS DIRECTLY
+
+// this is a nop, but it's for the benefit of IDEs trying to parse this file
+#include "rect_list.h"
+
+#include <assert.h>
+
+#include <set>
+
+namespace Realm {
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class RectList<DIM>
+  //
+
+  template <int DIM>
+  inline RectList<DIM>::RectList(void)
+  {}
+
+  template <int DIM>
+  inline RectList<DIM>::RectList(const RectType& r)
+  {
+    if(r.volume() > 0)
+      rects.push_back(r);
+  }
+
+  template <int DIM>
+  inline bool RectList<DIM>::empty(void) const
+  {
+    return rects.empty();
+  }
+
+  template <int DIM>
+  inline size_t RectList<DIM>::volume(void) const
+  {
+    size_t v = 0;
+    for(typename std::vector<RectType>::const_iterator it = rects.begin();
+	it != rects.end();
+	it++)
+      v += it->volume();
+    return v;
+  }
+
+  template <int DIM>
+  inline typename RectList<DIM>::RectType RectList<DIM>::bounds(void) const
+  {
+    if(rects.empty()) {
+      RectType r;
+      for(int i = 0; i < DIM; i++) {
+	r.lo.x[i] = 1;
+	r.hi.x[i] = 0;
+      }
+      return r;
+    }
+
+    RectType r = rects[0];
+    for(size_t i = 1; i < rects.size(); i++)
+      r = r.convex_hull(rects[i]);
+    return r;
+  }
+
+  template <int DIM>
+  inline const std::vector<typename RectList<DIM>::RectType>& RectList<DIM>::get_rects(void) const
+  {
+    return rects;
+  }
+
+  template <int DIM>
+  inline bool RectList<DIM>::contains(const PointType& p) const
+  {
+    for(typename std::vector<RectType>::const_iterator it = rects.begin();
+	it != rects.end();
+	it++)
+      if(it->contains(p))
+	return true;
+    return false;
+  }
+
+  template <int DIM>
+  inline bool RectList<DIM>::contains(const RectType& r) const
+  {
+    // whatever is left of 'r' after removing all our rectangles is uncovered
+    RectList<DIM> rest(r);
+    for(typename std::vector<RectType>::const_iterator it = rects.begin();
+	(it != rects.end()) && !rest.empty();
+	it++)
+      rest.subtract_rect(*it);
+    return rest.empty();
+  }
+
+  template <int DIM>
+  inline bool RectList<DIM>::contains(const RectList<DIM>& other) const
+  {
+    for(typename std::vector<RectType>::const_iterator it = other.rects.begin();
+	it != other.rects.end();
+	it++)
+      if(!contains(*it))
+	return false;
+    return true;
+  }
+
+  template <int DIM>
+  inline bool RectList<DIM>::overlaps(const RectType& r) const
+  {
+    if(r.volume() == 0)
+      return false;
+    for(typename std::vector<RectType>::const_iterator it = rects.begin();
+	it != rects.end();
+	it++)
+      if(it->overlaps(r))
+	return true;
+    return false;
+  }
+
+  template <int DIM>
+  inline bool RectList<DIM>::overlaps(const RectList<DIM>& other) const
+  {
+    for(typename std::vector<RectType>::const_iterator it = other.rects.begin();
+	it != other.rects.end();
+	it++)
+      if(overlaps(*it))
+	return true;
+    return false;
+  }
+
+  // appends the parts of 'from' that are not in 'r' as at most 2*DIM
+  //  disjoint slabs
+  template <int DIM>
+  /*static*/ inline void RectList<DIM>::subtract(const RectType& from,
+						 const RectType& r,
+						 std::vector<RectType>& pieces)
+  {
+    if(!from.overlaps(r)) {
+      pieces.push_back(from);
+      return;
+    }
+
+    RectType rest = from;
+    for(int i = 0; i < DIM; i++) {
+      if(rest.lo.x[i] < r.lo.x[i]) {
+	RectType piece = rest;
+	piece.hi.x[i] = r.lo.x[i] - 1;
+	pieces.push_back(piece);
+	rest.lo.x[i] = r.lo.x[i];
+      }
+      if(rest.hi.x[i] > r.hi.x[i]) {
+	RectType piece = rest;
+	piece.lo.x[i] = r.hi.x[i] + 1;
+	pieces.push_back(piece);
+	rest.hi.x[i] = r.hi.x[i];
+      }
+    }
+    // what's left of 'rest' is the intersection, which is dropped
+  }
+
+  template <int DIM>
+  inline void RectList<DIM>::add_rect(const RectType& r)
+  {
+    if(r.volume() == 0)
+      return;
+
+    // only the parts of 'r' that we don't already have are added
+    std::vector<RectType> pieces(1, r);
+    for(typename std::vector<RectType>::const_iterator it = rects.begin();
+	(it != rects.end()) && !pieces.empty();
+	it++) {
+      if(!it->overlaps(r))
+	continue;
+      std::vector<RectType> next;
+      for(typename std::vector<RectType>::const_iterator it2 = pieces.begin();
+	  it2 != pieces.end();
+	  it2++)
+	subtract(*it2, *it, next);
+      pieces.swap(next);
+    }
+    rects.insert(rects.end(), pieces.begin(), pieces.end());
+  }
+
+  template <int DIM>
+  inline void RectList<DIM>::subtract_rect(const RectType& r)
+  {
+    if((r.volume() == 0) || !overlaps(r))
+      return;
+
+    std::vector<RectType> next;
+    for(typename std::vector<RectType>::const_iterator it = rects.begin();
+	it != rects.end();
+	it++)
+      subtract(*it, r, next);
+    rects.swap(next);
+  }
+
+  template <int DIM>
+  inline void RectList<DIM>::intersect_rect(const RectType& r)
+  {
+    std::vector<RectType> next;
+    for(typename std::vector<RectType>::iterator it = rects.begin();
+	it != rects.end();
+	it++) {
+      RectType isect = it->intersection(r);
+      if(isect.volume() > 0)
+	next.push_back(isect);
+    }
+    rects.swap(next);
+  }
+
+  template <int DIM>
+  inline RectList<DIM>& RectList<DIM>::operator|=(const RectList<DIM>& other)
+  {
+    if(rects.empty()) {
+      rects = other.rects;
+      return *this;
+    }
+
+    for(typename std::vector<RectType>::const_iterator it = other.rects.begin();
+	it != other.rects.end();
+	it++)
+      add_rect(*it);
+    return *this;
+  }
+
+  template <int DIM>
+  inline RectList<DIM>& RectList<DIM>::operator-=(const RectList<DIM>& other)
+  {
+    for(typename std::vector<RectType>::const_iterator it = other.rects.begin();
+	(it != other.rects.end()) && !rects.empty();
+	it++)
+      subtract_rect(*it);
+    return *this;
+  }
+
+  template <int DIM>
+  inline RectList<DIM>& RectList<DIM>::operator&=(const RectList<DIM>& other)
+  {
+    // both lists are disjoint, so the pairwise intersections are too
+    std::vector<RectType> next;
+    for(typename std::vector<RectType>::iterator it = rects.begin();
+	it != rects.end();
+	it++)
+      for(typename std::vector<RectType>::const_iterator it2 = other.rects.begin();
+	  it2 != other.rects.end();
+	  it2++) {
+	if(!it->overlaps(*it2))
+	  continue;
+	next.push_back(it->intersection(*it2));
+      }
+    rects.swap(next);
+    return *this;
+  }
+
+  // two disjoint rectangles form a rectangle if they match in all but one
+  //  dimension and are adjacent in that one
+  template <int DIM>
+  /*static*/ inline bool RectList<DIM>::try_merge(RectType& a, const RectType& b)
+  {
+    int split = -1;
+    for(int i = 0; i < DIM; i++) {
+      if((a.lo.x[i] == b.lo.x[i]) && (a.hi.x[i] == b.hi.x[i]))
+	continue;
+      if(split >= 0)
+	return false;
+      split = i;
+    }
+    assert(split >= 0);
+
+    if((a.hi.x[split] + 1) == b.lo.x[split]) {
+      a.hi.x[split] = b.hi.x[split];
+      return true;
+    }
+    if((b.hi.x[split] + 1) == a.lo.x[split]) {
+      a.lo.x[split] = b.lo.x[split];
+      return true;
+    }
+    return false;
+  }
+
+  template <int DIM>
+  inline void RectList<DIM>::coalesce(void)
+  {
+    // every merge shrinks the list, so keep going until nothing merges
+    bool merged = true;
+    while(merged) {
+      merged = false;
+      for(size_t i = 0; i < rects.size(); i++)
+	for(size_t j = i + 1; j < rects.size(); /*no increment*/) {
+	  if(try_merge(rects[i], rects[j])) {
+	    rects[j] = rects.back();
+	    rects.pop_back();
+	    merged = true;
+	  } else
+	    j++;
+	}
+    }
+  }
+
+  template <int DIM>
+  inline void RectList<DIM>::create_subsets_by_blocks(const std::vector<RectType>& blocks,
+						       std::vector<RectList<DIM> >& subsets) const
+  {
+    subsets.clear();
+    subsets.resize(blocks.size());
+    for(size_t i = 0; i < blocks.size(); i++) {
+      subsets[i] = *this;
+      subsets[i].intersect_rect(blocks[i]);
+    }
+  }
+
+  template <int DIM>
+  inline void RectList<DIM>::create_equal_subsets(size_t count,
+						   std::vector<RectList<DIM> >& subsets) const
+  {
+    assert(count > 0);
+    subsets.clear();
+    subsets.resize(count);
+
+    // rectangles are cut into slabs along their last dimension, and each
+    //  subset takes whole slabs until it reaches its share of the volume
+    size_t total = volume();
+    size_t cur = 0;
+    size_t cur_volume = 0;
+    for(typename std::vector<RectType>::const_iterator it = rects.begin();
+	it != rects.end();
+	it++) {
+      RectType rest = *it;
+      while(rest.volume() > 0) {
+	size_t target = (total * (cur + 1)) / count;
+	if((cur_volume >= target) && (cur < (count - 1))) {
+	  cur++;
+	  continue;
+	}
+
+	size_t slab = rest.volume() / rest.dim_size(DIM - 1);
+	coord_t rows = rest.dim_size(DIM - 1);
+	if(cur < (count - 1)) {
+	  size_t wanted = (target - cur_volume + (slab / 2)) / slab;
+	  if(wanted == 0)
+	    wanted = 1;
+	  if((coord_t)wanted < rows)
+	    rows = wanted;
+	}
+
+	RectType piece = rest;
+	piece.hi.x[DIM - 1] = piece.lo.x[DIM - 1] + rows - 1;
+	subsets[cur].rects.push_back(piece);
+	cur_volume += piece.volume();
+	rest.lo.x[DIM - 1] += rows;
+      }
+    }
+  }
+
+  template <int DIM>
+  inline Event RectList<DIM>::fill(const std::vector<CopySrcDstField>& dsts,
+				   const void *fill_value, size_t fill_value_size,
+				   Event wait_on /*= Event::NO_EVENT*/) const
+  {
+    std::set<Event> events;
+    for(typename std::vector<RectType>::const_iterator it = rects.begin();
+	it != rects.end();
+	it++) {
+      Event e = Domain::from_rect<DIM>(*it).fill(dsts, fill_value, fill_value_size,
+						 wait_on);
+      if(e.exists())
+	events.insert(e);
+    }
+    // an empty list still has to respect the precondition
+    if(rects.empty())
+      return wait_on;
+    return Event::merge_events(events);
+  }
+
+  template <int DIM>
+  inline Event RectList<DIM>::copy(const std::vector<CopySrcDstField>& srcs,
+				   const std::vector<CopySrcDstField>& dsts,
+				   Event wait_on /*= Event::NO_EVENT*/,
+				   ReductionOpID redop_id /*= 0*/,
+				   bool red_fold /*= false*/) const
+  {
+    std::set<Event> events;
+    for(typename std::vector<RectType>::const_iterator it = rects.begin();
+	it != rects.end();
+	it++) {
+      Event e = Domain::from_rect<DIM>(*it).copy(srcs, dsts, wait_on,
+						 redop_id, red_fold);
+      if(e.exists())
+	events.insert(e);
+    }
+    if(rects.empty())
+      return wait_on;
+    return Event::merge_events(events);
+  }
+
+  template <int DIM>
+  inline std::ostream& operator<<(std::ostream& os, const RectList<DIM>& l)
+  {
+    const std::vector<typename RectList<DIM>::RectType>& rects = l.get_rects();
+    os << '{';
+    for(size_t i = 0; i < rects.size(); i++) {
+      if(i) os << ',';
+      os << rects[i];
+    }
+    os << '}';
+    return os;
+  }
+
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class RectList<DIM>::PointIterator
+  //
+
+  template <int DIM>
+  inline RectList<DIM>::PointIterator::PointIterator(const RectList<DIM>& _list)
+    : list(_list), rect_idx(0)
+    , pir(_list.rects.empty() ? _list.bounds() : _list.rects[0])
+  {
+    skip_empty();
+  }
+
+  template <int DIM>
+  inline void RectList<DIM>::PointIterator::skip_empty(void)
+  {
+    // rectangles in the list are never empty, so this only matters at the end
+    while(!pir.any_left && (rect_idx < list.rects.size())) {
+      rect_idx++;
+      if(rect_idx < list.rects.size())
+	pir = LegionRuntime::Arrays::GenericPointInRectIterator<DIM>(list.rects[rect_idx]);
+    }
+  }
+
+  template <int DIM>
+  inline bool RectList<DIM>::PointIterator::valid(void) const
+  {
+    return (rect_idx < list.rects.size()) && pir.any_left;
+  }
+
+  template <int DIM>
+  inline bool RectList<DIM>::PointIterator::step(void)
+  {
+    assert(valid());
+    pir.step();
+    skip_empty();
+    return valid();
+  }
+
+  template <int DIM>
+  inline RectList<DIM>::PointIterator::operator bool(void) const
+  {
+    return valid();
+  }
+
+  template <int DIM>
+  inline typename RectList<DIM>::PointIterator& RectList<DIM>::PointIterator::operator++(/*i am prefix*/)
+  {
+    step();
+    return *this;
+  }
+
+  template <int DIM>
+  inline typename RectList<DIM>::PointIterator RectList<DIM>::PointIterator::operator++(int /*i am postfix*/)
+  {
+    PointIterator orig = *this;
+    step();
+    return orig;
+  }
+
+  template <int DIM>
+  inline const typename RectList<DIM>::PointType& RectList<DIM>::PointIterator::operator*(void) const
+  {
+    return pir.p;
+  }
+
+}; // namespace Realm
@@ -38,9 +38,56 @@ namespace Realm {
       // both of these are optional
       static const RHS identity;
       static void fold(RHS& rhs1, RHS rhs2);
+
+      // also optional - bulk kernels for dense, exclusive applies and folds
+      //  (e.g. DenseSumKernels<int> below)
+      typedef ... DenseKernels;
     };
 #endif
 
+    // bulk kernels for the common reductions - the loops are written so that
+    //  the compiler can vectorize them, which is only legal when nobody else
+    //  is touching the data, so they are only used for exclusive calls
+#if defined(__GNUC__) && !defined(__clang__) && !defined(__CUDACC__)
+#define REALM_VECTORIZE __attribute__((optimize("tree-vectorize")))
+#else
+#define REALM_VECTORIZE
+#endif
+
+    template <typename T>
+    struct DenseSumKernels {
+      REALM_VECTORIZE
+      static void apply(void *lhs_ptr, const void *rhs_ptr, size_t count)
+      {
+	T *__restrict__ lhs = (T *)lhs_ptr;
+	const T *__restrict__ rhs = (const T *)rhs_ptr;
+	for(size_t i = 0; i < count; i++)
+	  lhs[i] += rhs[i];
+      }
+
+      static void fold(void *rhs1_ptr, const void *rhs2_ptr, size_t count)
+      {
+	apply(rhs1_ptr, rhs2_ptr, count);
+      }
+    };
+
+    template <typename T>
+    struct DenseMaxKernels {
+      REALM_VECTORIZE
+      static void apply(void *lhs_ptr, const void *rhs_ptr, size_t count)
+      {
+	T *__restrict__ lhs = (T *)lhs_ptr;
+	const T *__restrict__ rhs = (const T *)rhs_ptr;
+	for(size_t i = 0; i < count; i++)
+	  lhs[i] = (rhs[i] > lhs[i]) ? rhs[i] : lhs[i];
+      }
+
+      static void fold(void *rhs1_ptr, const void *rhs2_ptr, size_t count)
+      {
+	apply(rhs1_ptr, rhs2_ptr, count);
+      }
+    };
+
     typedef int ReductionOpID;
     class ReductionOpUntyped {
     public:
@@ -50,6 +97,14 @@ namespace Realm {
       bool has_identity;
       bool is_foldable;
 
+      // optional bulk kernels for exclusive applies/folds of densely packed
+      //  elements (NULL if the reduction op didn't supply them)
+      typedef void (*DenseKernel)(void *lhs_ptr, const void *rhs_ptr, size_t count);
+      DenseKernel dense_apply;
+      DenseKernel dense_fold;
+
+      bool has_dense_kernels(void) const { return (dense_apply != 0); }
+
       template <class REDOP>
 	static ReductionOpUntyped *create_reduction_op(void);
 
@@ -79,7 +134,29 @@ namespace Realm {
 			 bool _has_identity, bool _is_foldable)
 	: sizeof_lhs(_sizeof_lhs), sizeof_rhs(_sizeof_rhs),
 	  sizeof_list_entry(_sizeof_list_entry),
-  	  has_identity(_has_identity), is_foldable(_is_foldable) {}
+  	  has_identity(_has_identity), is_foldable(_is_foldable),
+	  dense_apply(0), dense_fold(0) {}
+    };
+
+    // detects whether a reduction op supplies a DenseKernels typedef
+    template <class REDOP>
+    struct ReductionOpDenseKernels {
+      typedef char yes;
+      typedef long no;
+      template <class T> static yes test(typename T::DenseKernels *);
+      template <class T> static no test(...);
+      static const bool present = (sizeof(test<REDOP>(0)) == sizeof(yes));
+
+      template <bool PRESENT, class DUMMY = void>
+      struct Lookup {
+	static ReductionOpUntyped::DenseKernel apply(void) { return 0; }
+	static ReductionOpUntyped::DenseKernel fold(void) { return 0; }
+      };
+      template <class DUMMY>
+      struct Lookup<true, DUMMY> {
+	static ReductionOpUntyped::DenseKernel apply(void) { return &REDOP::DenseKernels::apply; }
+	static ReductionOpUntyped::DenseKernel fold(void) { return &REDOP::DenseKernels::fold; }
+      };
     };
 
     template <class LHS, class RHS>
@@ -96,11 +173,20 @@ namespace Realm {
       ReductionOp(void)
 	: ReductionOpUntyped(sizeof(typename REDOP::LHS), sizeof(typename REDOP::RHS),
 			     sizeof(ReductionListEntry<typename REDOP::LHS,typename REDOP::RHS>),
-			     true, true) {}
+			     true, true)
+      {
+	typedef ReductionOpDenseKernels<REDOP> DK;
+	dense_apply = DK::template Lookup<DK::present>::apply();
+	dense_fold = DK::template Lookup<DK::present>::fold();
+      }
 
       virtual void apply(void *lhs_ptr, const void *rhs_ptr, size_t count,
 			 bool exclusive = false) const
       {
+	if(exclusive && dense_apply) {
+	  (*dense_apply)(lhs_ptr, rhs_ptr, count);
+	  return;
+	}
 	typename REDOP::LHS *lhs = (typename REDOP::LHS *)lhs_ptr;
 	const typename REDOP::RHS *rhs = (const typename REDOP::RHS *)rhs_ptr;
 	if(exclusive) {
@@ -116,6 +202,12 @@ namespace Realm {
 				 off_t lhs_stride, off_t rhs_stride, size_t count,
 				 bool exclusive = false) const
       {
+	if(exclusive && dense_apply &&
+	   (lhs_stride == (off_t)sizeof(typename REDOP::LHS)) &&
+	   (rhs_stride == (off_t)sizeof(typename REDOP::RHS))) {
+	  (*dense_apply)(lhs_ptr, rhs_ptr, count);
+	  return;
+	}
 	char *lhs = (char *)lhs_ptr;
 	const char *rhs = (const char *)rhs_ptr;
 	if(exclusive) {
@@ -138,6 +230,10 @@ namespace Realm {
       virtual void fold(void *rhs1_ptr, const void *rhs2_ptr, size_t count,
 			bool exclusive = false) const
       {
+	if(exclusive && dense_fold) {
+	  (*dense_fold)(rhs1_ptr, rhs2_ptr, count);
+	  return;
+	}
 	typename REDOP::RHS *rhs1 = (typename REDOP::RHS *)rhs1_ptr;
 	const typename REDOP::RHS *rhs2 = (const typename REDOP::RHS *)rhs2_ptr;
 	if(exclusive) {
@@ -153,6 +249,12 @@ namespace Realm {
 				off_t lhs_stride, off_t rhs_stride, size_t count,
 				bool exclusive = false) const
       {
+	if(exclusive && dense_fold &&
+	   (lhs_stride == (off_t)sizeof(typename REDOP::RHS)) &&
+	   (rhs_stride == (off_t)sizeof(typename REDOP::RHS))) {
+	  (*dense_fold)(lhs_ptr, rhs_ptr, count);
+	  return;
+	}
 	char *lhs = (char *)lhs_ptr;
 	const char *rhs = (const char *)rhs_ptr;
 	if(exclusive) {
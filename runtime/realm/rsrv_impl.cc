@@ -23,6 +23,11 @@ namespace Realm {
 
   Logger log_reservation("reservation");
 
+  namespace Config {
+    // allow uncontended local reservations to be acquired/released with a CAS
+    int reservation_fast_path = 1;
+  };
+
   ////////////////////////////////////////////////////////////////////////
   //
   // class DeferredLockRequest
@@ -162,8 +167,15 @@ namespace Realm {
       // early out - if the event has obviously triggered (or is NO_EVENT)
       //  don't build up continuation
       if(wait_on.has_triggered()) {
-	Event e = get_runtime()->get_lock_impl(*this)->acquire(mode, exclusive,
-							       ReservationImpl::ACQUIRE_BLOCKING);
+	ReservationImpl *impl = get_runtime()->get_lock_impl(*this);
+	// mode 0 is exclusive even if not requested as such
+	if((exclusive || (mode == ReservationImpl::MODE_EXCL)) &&
+	   impl->try_fast_acquire()) {
+	  log_reservation.info() << "reservation acquire: rsrv=" << *this << " finish=" << Event::NO_EVENT;
+	  return Event::NO_EVENT;
+	}
+	Event e = impl->acquire(mode, exclusive,
+				ReservationImpl::ACQUIRE_BLOCKING);
 	log_reservation.info() << "reservation acquire: rsrv=" << *this << " finish=" << e;
 	//printf("(" IDFMT "/%d)\n", e.id, e.gen);
 	return e;
@@ -193,6 +205,15 @@ namespace Realm {
 	return wait_on;
       }
 
+      // a fast path success is just like an immediate grant (a retry may
+      //  still need to update the retry counts, but the fast path is
+      //  disabled while any retries are outstanding)
+      if((exclusive || (mode == ReservationImpl::MODE_EXCL)) &&
+	 impl->try_fast_acquire()) {
+	log_reservation.info() << "reservation try_acquire: rsrv=" << *this << " wait_on=" << wait_on << " finish=" << Event::NO_EVENT;
+	return Event::NO_EVENT;
+      }
+
       // attempt the nonblocking acquire
       Event e = impl->acquire(mode, exclusive,
 			      (retry ?
@@ -210,7 +231,9 @@ namespace Realm {
       //  don't build up continuation
       if(wait_on.has_triggered()) {
 	log_reservation.info() << "reservation release: rsrv=" << *this;
-	get_runtime()->get_lock_impl(*this)->release();
+	ReservationImpl *impl = get_runtime()->get_lock_impl(*this);
+	if(!impl->try_fast_release())
+	  impl->release();
       } else {
 	log_reservation.info() << "reservation release: rsrv=" << *this << " wait_on=" << wait_on;
 	EventImpl::add_waiter(wait_on, new DeferredUnlockRequest(*this));
@@ -238,6 +261,7 @@ namespace Realm {
 	assert(!impl->in_use);
 
 	impl->in_use = true;
+	impl->enable_fast_path();
 
 	log_reservation.info() << "reservation created: rsrv=" << impl->me;
 	return impl->me;
@@ -328,6 +352,7 @@ namespace Realm {
       remote_waiter_mask = NodeSet(); 
       remote_sharer_mask = NodeSet();
       requested = false;
+      fast_state = FAST_DISABLED;
       if(_data_size) {
 	local_data = malloc(_data_size);
 	local_data_size = _data_size;
@@ -368,6 +393,7 @@ namespace Realm {
 
       do {
 	AutoHSLLock a(impl->mutex);
+	impl->revoke_fast_path();
 
 	// case 1: we don't even own the lock any more - pass the request on
 	//  to whoever we think the owner is
@@ -548,6 +574,7 @@ namespace Realm {
 
       {
 	AutoHSLLock a(mutex); // hold mutex on lock while we check things
+	revoke_fast_path();
 
 	// it'd be bad if somebody tried to take a lock that had been 
 	//   deleted...  (info is only valid on a lock's home node)
@@ -572,10 +599,13 @@ namespace Realm {
 #endif
 	  // case 1: we own the lock
 	  // can we grant it?  (don't if there is a higher priority waiter)
+	  // (new sharers must also wait behind any remote request, which will
+	  //  want exclusive access)
 	  if((count == ZERO_COUNT) ||
 	     ((mode == new_mode) &&
 	      (mode != MODE_EXCL) &&
-	      (local_waiters.empty() || (local_waiters.begin()->first > mode)))) {
+	      (local_waiters.empty() || (local_waiters.begin()->first > mode)) &&
+	      remote_waiter_mask.empty())) {
 	    mode = new_mode;
 	    count++;
 	    log_reservation.spew("count ++(1) [%p]=%d", &count, count);
@@ -771,6 +801,12 @@ namespace Realm {
 	  // grab the list of events wanting to share the lock
 	  to_wake.swap(it->second);
 	  local_waiters.erase(it);  // actually pull list off map!
+	  // retriers for the same mode can come along for the ride too (as in
+	  //  the shared grant case of acquire())
+	  if((it2 != retry_events.end()) && (it2->first == mode)) {
+	    to_wake.push_back(it2->second);
+	    retry_events.erase(it2);
+	  }
 	  // TODO: can we share with any other nodes?
 	} else {
 	  // wake up one or more folks that will retry their try_acquires
@@ -799,6 +835,7 @@ namespace Realm {
       int release_target = -1;
       int grant_target = -1;
       NodeSet copy_waiters;
+      int rerequest_mode = -1;
 
       do {
 #ifdef RSRV_DEBUG_MSGS
@@ -806,6 +843,7 @@ namespace Realm {
 			me.id, count, mode, owner); //, remote_sharer_mask, remote_waiter_mask);
 #endif
 	AutoHSLLock a(mutex); // hold mutex on lock for entire function
+	revoke_fast_path();
 
 	assert(count > ZERO_COUNT);
 
@@ -829,12 +867,22 @@ namespace Realm {
 	  break;
 	}
 
+	// writer preference: remote requests are always granted exclusively, so a
+	//  pending one goes ahead of local shared waiters (but not local exclusive
+	//  ones) - otherwise a steady stream of local readers starves it
+	bool remote_first = (!remote_waiter_mask.empty() &&
+			     retry_count.empty() &&
+			     retry_events.empty() &&
+			     (local_waiters.find(MODE_EXCL) == local_waiters.end()));
+
 	// case 2: we own the lock, so we can give it to a local waiter (or a retry list)
-	bool any_local = select_local_waiters(to_wake);
-	if(any_local) {
-	  // we'll wake the blocking waiter(s) below
-	  assert(!to_wake.empty());
-	  break;
+	if(!remote_first) {
+	  bool any_local = select_local_waiters(to_wake);
+	  if(any_local) {
+	    // we'll wake the blocking waiter(s) below
+	    assert(!to_wake.empty());
+	    break;
+	  }
 	}
 
 	// case 3: we can grant to a remote waiter (if any) if we don't expect any local retries
@@ -855,12 +903,24 @@ namespace Realm {
 
 	  owner = new_owner;
           remote_waiter_mask = NodeSet();
+
+	  // any local (shared) waiters we passed over now have to ask the new
+	  //  owner for it
+	  if(!local_waiters.empty()) {
+	    assert(!requested);
+	    requested = true;
+	    rerequest_mode = local_waiters.begin()->first;
+	  }
+	  break;
 	}
 
 	// nobody wants it?  just sits in available state
 	assert(local_waiters.empty());
 	assert(retry_events.empty());
 	assert(remote_waiter_mask.empty());
+
+	if(grant_target == -1)
+	  enable_fast_path();
       } while(0);
 
       if(release_target != -1)
@@ -907,6 +967,13 @@ namespace Realm {
 #endif
       }
 
+      if(rerequest_mode != -1) {
+	log_reservation.debug() << "re-requesting reservation: reservation=" << me
+				<< " node=" << grant_target << " mode=" << rerequest_mode;
+	LockRequestMessage::send_request(grant_target, gasnet_mynode(),
+					 me, rerequest_mode);
+      }
+
       if(!to_wake.empty()) {
 	for(WaiterList::iterator it = to_wake.begin();
 	    it != to_wake.end();
@@ -924,6 +991,10 @@ namespace Realm {
       // checking the owner can be done atomically, so doesn't need mutex
       if(owner != gasnet_mynode()) return false;
 
+      // a fast path holder is always exclusive (i.e. mode 0)
+      if(fast_state == FAST_HELD)
+	return ((check_mode == MODE_EXCL) || excl_ok);
+
       // conservative check on lock count also doesn't need mutex
       if(count == ZERO_COUNT) return false;
 
@@ -939,6 +1010,53 @@ namespace Realm {
       return held;
     }
 
+    bool ReservationImpl::try_fast_acquire(void)
+    {
+      // a plain read first avoids bouncing the cache line on contended locks
+      return ((fast_state == FAST_IDLE) &&
+	      __sync_bool_compare_and_swap(&fast_state, FAST_IDLE, FAST_HELD));
+    }
+
+    bool ReservationImpl::try_fast_release(void)
+    {
+      // fails if the fast path was revoked while we held it, in which case we
+      //  are now a normal exclusive holder
+      return __sync_bool_compare_and_swap(&fast_state, FAST_HELD, FAST_IDLE);
+    }
+
+    void ReservationImpl::revoke_fast_path(void)
+    {
+      while(true) {
+	int cur = fast_state;
+	if(cur == FAST_DISABLED)
+	  return;
+	if(__sync_bool_compare_and_swap(&fast_state, cur, FAST_DISABLED)) {
+	  if(cur == FAST_HELD) {
+	    mode = MODE_EXCL;
+	    count = ZERO_COUNT + 1;
+	    log_reservation.spew("count <-fast [%p]=%d", &count, count);
+	  }
+	  return;
+	}
+      }
+    }
+
+    void ReservationImpl::enable_fast_path(void)
+    {
+      // only a completely idle, locally-owned reservation can use the fast path
+      if(Config::reservation_fast_path &&
+	 in_use &&
+	 (owner == gasnet_mynode()) &&
+	 (count == ZERO_COUNT) &&
+	 !requested &&
+	 local_waiters.empty() &&
+	 retry_count.empty() &&
+	 retry_events.empty() &&
+	 remote_waiter_mask.empty() &&
+	 remote_sharer_mask.empty())
+	fast_state = FAST_IDLE;
+    }
+
     void ReservationImpl::release_reservation(void)
     {
       // take the lock's mutex to sanity check it and clear the in_use field
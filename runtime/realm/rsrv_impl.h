@@ -90,6 +90,15 @@ namespace Realm {
       std::map<unsigned, Event> retry_events;
       bool requested; // do we have a request for the lock in flight?
 
+      // uncontended fast path - while the reservation is owned by this node and
+      //  completely idle, exclusive acquires and releases are a single CAS on
+      //  this word and never touch the mutex or any of the state above
+      // anything that needs the real state (while holding the mutex) must
+      //  first call revoke_fast_path(), which turns a fast holder into a normal
+      //  exclusive holder
+      enum { FAST_DISABLED, FAST_IDLE, FAST_HELD };
+      volatile int fast_state;
+
       // local data protected by lock
       void *local_data;
       size_t local_data_size;
@@ -122,6 +131,14 @@ namespace Realm {
 
       void release(void);
 
+      // these return false if the caller must use acquire()/release() instead
+      bool try_fast_acquire(void);
+      bool try_fast_release(void);
+
+      // these must be called while holding the mutex
+      void revoke_fast_path(void);
+      void enable_fast_path(void);
+
       bool is_locked(unsigned check_mode, bool excl_ok);
 
       void release_reservation(void);
@@ -68,6 +68,22 @@ namespace Realm {
 				     bool one_per_node = false,
 				     Event wait_on = Event::NO_EVENT, int priority = 0);
 
+      // collective data exchanges between all nodes - every node must make
+      //  the same sequence of calls with the same sizes (and root), and the
+      //  buffers must remain valid until the returned event has triggered
+      //
+      // broadcast: 'bytes' bytes at 'src' on 'root' are copied to 'dst' on
+      //  every node ('src' is ignored on the other nodes)
+      Event broadcast(AddressSpace root, const void *src, void *dst, size_t bytes);
+
+      // allgather: 'dst' receives every node's 'bytes' bytes, in node order
+      Event allgather(const void *src, void *dst, size_t bytes);
+
+      // allreduce: 'count' RHS values of the given reduction op are folded
+      //  together (in node order, so every node sees the same result)
+      Event allreduce(ReductionOpID redop_id, const void *src, void *dst,
+		      size_t count);
+
       // there are three potentially interesting ways to start the initial
       // tasks:
       enum RunStyle {
@@ -18,6 +18,8 @@
 #include "runtime_impl.h"
 
 #include "proc_impl.h"
+#include "collective_impl.h"
+#include "deppart_impl.h"
 #include "mem_impl.h"
 #include "inst_impl.h"
 
@@ -28,6 +30,7 @@
 #include "codedesc.h"
 
 #include "utils.h"
+#include "timers.h"
 
 // For doing backtraces
 #include <execinfo.h> // symbols
@@ -50,6 +53,7 @@ namespace Realm {
 namespace Realm {
   typedef LegionRuntime::LowLevel::XferDesRemoteWriteMessage XferDesRemoteWriteMessage;
   typedef LegionRuntime::LowLevel::XferDesRemoteWriteAckMessage XferDesRemoteWriteAckMessage;
+  typedef LegionRuntime::LowLevel::XferDesCompressedWriteMessage XferDesCompressedWriteMessage;
   typedef LegionRuntime::LowLevel::XferDesCreateMessage XferDesCreateMessage;
   typedef LegionRuntime::LowLevel::XferDesDestroyMessage XferDesDestroyMessage;
   typedef LegionRuntime::LowLevel::NotifyXferDesCompleteMessage NotifyXferDesCompleteMessage;
@@ -81,6 +85,7 @@ namespace Realm {
 
   Logger log_runtime("realm");
   Logger log_collective("collective");
+  Logger log_deppart("deppart");
   extern Logger log_task; // defined in proc_impl.cc
   extern Logger log_taskreg; // defined in proc_impl.cc
   
@@ -213,6 +218,29 @@ namespace Realm {
 							     wait_on, priority);
     }
 
+    Event Runtime::broadcast(AddressSpace root, const void *src, void *dst,
+			     size_t bytes)
+    {
+      return collective_broadcast(root, src, dst, bytes);
+    }
+
+    Event Runtime::allgather(const void *src, void *dst, size_t bytes)
+    {
+      return collective_allgather(src, dst, bytes);
+    }
+
+    Event Runtime::allreduce(ReductionOpID redop_id, const void *src, void *dst,
+			     size_t count)
+    {
+      std::map<ReductionOpID, const ReductionOpUntyped *>::const_iterator it =
+	((RuntimeImpl *)impl)->reduce_op_table.find(redop_id);
+      if(it == ((RuntimeImpl *)impl)->reduce_op_table.end()) {
+	log_collective.fatal() << "allreduce with unknown reduction op: " << redop_id;
+	assert(0);
+      }
+      return collective_allreduce(it->second, src, dst, count);
+    }
+
     void Runtime::run(Processor::TaskFuncID task_id /*= 0*/,
 		      RunStyle style /*= ONE_TASK_ONLY*/,
 		      const void *args /*= 0*/, size_t arglen /*= 0*/,
@@ -293,6 +321,10 @@ namespace Realm {
     , num_cpu_procs(1), num_util_procs(1), num_io_procs(0)
     , concurrent_io_threads(1)  // Legion does not support values > 1 right now
     , force_kernel_threads(false)
+    , cpu_work_stealing(false)
+    , cpu_spin_wait_us(0)
+    , cpu_autoscale_max_workers(0), cpu_autoscale_interval_ms(10)
+    , numa_placement(false)
     , sysmem_size_in_mb(512), stack_size_in_mb(2)
   {}
 
@@ -311,8 +343,15 @@ namespace Realm {
       .add_option_int("-ll:io", m->num_io_procs)
       .add_option_int("-ll:concurrent_io", m->concurrent_io_threads)
       .add_option_int("-ll:csize", m->sysmem_size_in_mb)
+      .add_option_int("-ll:hugepage", Config::cpu_memory_huge_page_mb)
+      .add_option_int("-ll:filemmap", Config::file_memory_mmap)
       .add_option_int("-ll:stacksize", m->stack_size_in_mb, true /*keep*/)
       .add_option_bool("-ll:force_kthreads", m->force_kernel_threads, true /*keep*/)
+      .add_option_bool("-ll:steal", m->cpu_work_stealing)
+      .add_option_int("-ll:spin", m->cpu_spin_wait_us)
+      .add_option_int("-ll:autoscale", m->cpu_autoscale_max_workers)
+      .add_option_int("-ll:autoscale_ms", m->cpu_autoscale_interval_ms)
+      .add_option_bool("-ll:numa_place", m->numa_placement)
       .parse_command_line(cmdline);
 
     return m;
@@ -334,16 +373,47 @@ namespace Realm {
   // create any processors provided by the module (default == do nothing)
   //  (each new ProcessorImpl should use a Processor from
   //   RuntimeImpl::next_local_processor_id)
+  // with NUMA placement enabled, the i'th of 'count' processors of a kind goes
+  //  in the domain that a block distribution over 'domains' gives it
+  static int choose_numa_domain(const std::vector<int>& domains, int i, int count)
+  {
+    if(domains.empty())
+      return CoreReservationParameters::NUMA_DOMAIN_DONTCARE;
+    return domains[((long long)i * domains.size()) / count];
+  }
+
   void CoreModule::create_processors(RuntimeImpl *runtime)
   {
     Module::create_processors(runtime);
 
+    // figure out which NUMA domains have cores we can use - CPU and utility
+    //  processors are spread over them in blocks (so that neighboring
+    //  processors share a socket), and every other reservation (e.g. DMA and
+    //  network threads) prefers the first one
+    std::vector<int> domains;
+    if(numa_placement) {
+      const CoreMap *cm = runtime->core_reservation_set().get_core_map();
+      for(CoreMap::DomainMap::const_iterator it = cm->by_domain.begin();
+	  it != cm->by_domain.end();
+	  it++)
+	if(!it->second.empty())
+	  domains.push_back(it->first);
+      if(domains.size() > 1)
+	runtime->core_reservation_set().set_default_preferred_numa_domain(domains[0]);
+      else
+	domains.clear();  // nothing to choose between
+    }
+
     for(int i = 0; i < num_util_procs; i++) {
       Processor p = runtime->next_local_processor_id();
+      int domain = choose_numa_domain(domains, i, num_util_procs);
       ProcessorImpl *pi = new LocalUtilityProcessor(p, runtime->core_reservation_set(),
 						    stack_size_in_mb << 20,
-						    force_kernel_threads);
+						    force_kernel_threads,
+						    domain);
       runtime->add_processor(pi);
+      if(!domains.empty())
+	log_runtime.info() << "utility proc " << p << " placed in NUMA domain " << domain;
     }
 
     for(int i = 0; i < num_io_procs; i++) {
@@ -354,13 +424,36 @@ namespace Realm {
       runtime->add_processor(pi);
     }
 
+    std::vector<LocalCPUProcessor *> cpu_procs;
     for(int i = 0; i < num_cpu_procs; i++) {
       Processor p = runtime->next_local_processor_id();
-      ProcessorImpl *pi = new LocalCPUProcessor(p, runtime->core_reservation_set(),
-						stack_size_in_mb << 20,
-						force_kernel_threads);
+      int domain = choose_numa_domain(domains, i, num_cpu_procs);
+      LocalCPUProcessor *pi = new LocalCPUProcessor(p, runtime->core_reservation_set(),
+						    stack_size_in_mb << 20,
+						    force_kernel_threads,
+						    domain);
       runtime->add_processor(pi);
+      cpu_procs.push_back(pi);
+      if(!domains.empty())
+	log_runtime.info() << "CPU proc " << p << " placed in NUMA domain " << domain;
+
+      // on dedicated nodes, idle CPU workers may spin before they sleep
+      if(cpu_spin_wait_us > 0)
+	pi->enable_spin_waiting((long long)cpu_spin_wait_us * 1000);
+
+      // let the worker limits follow the observed blocked/ready pressure
+      if(cpu_autoscale_max_workers > 0)
+	pi->enable_autoscaling(cpu_autoscale_max_workers,
+			       (long long)cpu_autoscale_interval_ms * 1000000);
     }
+
+    // with work stealing enabled, every CPU processor may take work from any
+    //  of its siblings on this node
+    if(cpu_work_stealing)
+      for(size_t i = 0; i < cpu_procs.size(); i++)
+	for(size_t j = 0; j < cpu_procs.size(); j++)
+	  if(i != j)
+	    cpu_procs[i]->add_steal_victim(cpu_procs[j]);
   }
 
   // create any DMA channels provided by the module (default == do nothing)
@@ -509,11 +602,37 @@ namespace Realm {
       return dma_channels;
     }
 
+    void RuntimeImpl::register_external_memory(MemoryImpl *mem, void *ptr, size_t size)
+    {
+      for(std::vector<Module *>::const_iterator it = modules.begin();
+	  it != modules.end();
+	  it++)
+	(*it)->register_external_memory(mem, ptr, size);
+    }
+
+    void RuntimeImpl::unregister_external_memory(MemoryImpl *mem, void *ptr, size_t size)
+    {
+      for(std::vector<Module *>::const_iterator it = modules.begin();
+	  it != modules.end();
+	  it++)
+	(*it)->unregister_external_memory(mem, ptr, size);
+    }
+
     const std::vector<CodeTranslator *>& RuntimeImpl::get_code_translators(void) const
     {
       return code_translators;
     }
 
+    Module *RuntimeImpl::get_module(const std::string& name) const
+    {
+      for(std::vector<Module *>::const_iterator it = modules.begin();
+	  it != modules.end();
+	  it++)
+	if((*it)->get_name() == name)
+	  return *it;
+      return 0;
+    }
+
     static void add_proc_mem_affinities(MachineImpl *machine,
 					const std::set<Processor>& procs,
 					const std::set<Memory>& mems,
@@ -737,6 +856,7 @@ namespace Realm {
       stack_size_in_mb = 2;
       //unsigned cpu_worker_threads = 1;
       unsigned dma_worker_threads = 1;
+      unsigned deppart_worker_threads = 2;
       unsigned active_msg_worker_threads = 1;
       unsigned active_msg_handler_threads = 1;
 #ifdef EVENT_TRACING
@@ -753,6 +873,10 @@ namespace Realm {
       // are hyperthreads considered to share a physical core
       bool hyperthread_sharing = true;
       bool pin_dma_threads = false;
+      // event sampling (1 in N events, 0 = off) and per-thread ring size
+      int event_sample_rate = 0;
+      int event_sample_depth = 4096;
+      bool record_critical_path = false;
 
       CommandLineParser cp;
       cp.add_option_int("-ll:gsize", gasnet_mem_size_in_mb)
@@ -761,7 +885,27 @@ namespace Realm {
 	.add_option_int("-ll:dsize", disk_mem_size_in_mb)
 	.add_option_int("-ll:stacksize", stack_size_in_mb)
 	.add_option_int("-ll:dma", dma_worker_threads)
+	.add_option_int("-ll:deppart", deppart_worker_threads)
         .add_option_bool("-ll:pin_dma", pin_dma_threads)
+	.add_option_int("-ll:ib_slab", Config::dma_ib_slab_size_kb)
+	.add_option_int("-ll:ib_slabs", Config::dma_ib_pool_slabs)
+	.add_option_int("-ll:io_uring", Config::aio_use_io_uring)
+	.add_option_int("-ll:io_uring_sqpoll", Config::aio_uring_sqpoll)
+	.add_option_int("-ll:io_uring_regbuf", Config::aio_uring_regbuf_mb)
+	.add_option_int("-ll:memcpy_threads", Config::dma_memcpy_threads)
+	.add_option_int("-ll:memcpy_stripe", Config::dma_memcpy_stripe_kb)
+	.add_option_int("-ll:fill_nt", Config::dma_fill_nt_threshold_kb)
+	.add_option_int("-ll:dma_coalesce", Config::dma_coalesce_copies)
+	.add_option_int("-ll:pipe_chunk", Config::dma_pipeline_chunk_kb)
+	.add_option_int("-ll:pipe_depth", Config::dma_pipeline_depth)
+	.add_option_int("-ll:dma_share_lat", Config::dma_share_latency)
+	.add_option_int("-ll:dma_share_norm", Config::dma_share_normal)
+	.add_option_int("-ll:dma_share_bulk", Config::dma_share_bulk)
+	.add_option_int("-ll:hdf_threads", Config::hdf5_io_threads)
+	.add_option_int("-ll:sparse_gather", Config::dma_sparse_gather_run)
+	.add_option_int("-ll:dma_calibrate", Config::dma_calibrate_kb)
+	.add_option_int("-ll:dma_compress", Config::dma_compress_min_kb)
+	.add_option_int("-ll:dma_poll", Config::dma_poll_mode)
 	.add_option_int("-ll:amsg", active_msg_worker_threads)
 	.add_option_int("-ll:ahandlers", active_msg_handler_threads)
 	.add_option_int("-ll:dummy_rsrv_ok", dummy_reservation_ok)
@@ -781,6 +925,27 @@ namespace Realm {
 #endif
 
       cp.add_option_int("-realm:eventloopcheck", Config::event_loop_detection_limit);
+      cp.add_option_int("-realm:eventtree", Config::event_broadcast_tree_threshold);
+      cp.add_option_int("-realm:eventradix", Config::event_broadcast_radix);
+      cp.add_option_int("-realm:eventbatch", Config::event_message_batching);
+      cp.add_option_int("-realm:eventalias", Config::event_aliasing);
+      cp.add_option_int("-realm:rsrvfast", Config::reservation_fast_path);
+      cp.add_option_int("-realm:cpualloc", Config::cpu_memory_allocator);
+      cp.add_option_int("-realm:gpualloc", Config::gpu_memory_allocator);
+      cp.add_option_int("-realm:mdpush", Config::metadata_push);
+      cp.add_option_int("-realm:mdcache", Config::metadata_cache_size);
+      cp.add_option_int("-realm:eventsample", event_sample_rate);
+      cp.add_option_int("-realm:eventsampledepth", event_sample_depth);
+      cp.add_option_bool("-realm:critpath", record_critical_path);
+      cp.add_option_int("-realm:barriertree", Config::barrier_tree_radix);
+      cp.add_option_int("-realm:annctree", Config::announce_tree_radix);
+      cp.add_option_int("-realm:querycache", Config::machine_query_cache_size);
+      cp.add_option_int("-realm:taskqueueshards", Config::task_queue_shards);
+      cp.add_option_int("-realm:taskinlineargs", Config::task_inline_arg_size);
+      cp.add_option_int("-realm:taskfreelist", Config::task_free_list_size);
+      cp.add_option_int("-realm:fastuswitch", Config::user_thread_fast_switch);
+      cp.add_option_int("-realm:pgaffinity", Config::procgroup_affinity_us);
+      cp.add_option_int("-realm:lazytranslate", Config::lazy_task_translation);
 
       // these are actually parsed in activemsg.cc, but consume them here for now
       size_t dummy = 0;
@@ -850,6 +1015,9 @@ namespace Realm {
       core_reservations = new CoreReservationSet(core_map);
 
       sampling_profiler.configure_from_cmdline(cmdline, *core_reservations);
+      GenEventImpl::create_merge_gauges();
+      EventSampler::configure(event_sample_rate, event_sample_depth);
+      CriticalPathRecorder::configure(record_critical_path);
 
       // initialize barrier timestamp
       BarrierImpl::barrier_adjustment_timestamp = (((Barrier::timestamp_t)(gasnet_mynode())) << BarrierImpl::BARRIER_TIMESTAMP_NODEID_SHIFT) + 1;
@@ -864,10 +1032,14 @@ namespace Realm {
       hcount += EventSubscribeMessage::Message::add_handler_entries(&handlers[hcount], "Event Subscribe AM");
       hcount += EventTriggerMessage::Message::add_handler_entries(&handlers[hcount], "Event Trigger AM");
       hcount += EventUpdateMessage::Message::add_handler_entries(&handlers[hcount], "Event Update AM");
+      hcount += EventSubscribeBatchMessage::Message::add_handler_entries(&handlers[hcount], "Event Subscribe Batch AM");
+      hcount += EventUpdateBatchMessage::Message::add_handler_entries(&handlers[hcount], "Event Update Batch AM");
       hcount += RemoteMemAllocRequest::Request::add_handler_entries(&handlers[hcount], "Remote Memory Allocation Request AM");
       hcount += RemoteMemAllocRequest::Response::add_handler_entries(&handlers[hcount], "Remote Memory Allocation Response AM");
       hcount += CreateInstanceRequest::Request::add_handler_entries(&handlers[hcount], "Create Instance Request AM");
       hcount += CreateInstanceRequest::Response::add_handler_entries(&handlers[hcount], "Create Instance Response AM");
+      hcount += CreateInstanceBatchMessage::Request::add_handler_entries(&handlers[hcount], "Create Instance Batch Request AM");
+      hcount += CreateInstanceBatchMessage::Response::add_handler_entries(&handlers[hcount], "Create Instance Batch Response AM");
       hcount += RemoteCopyMessage::add_handler_entries(&handlers[hcount], "Remote Copy AM");
       hcount += RemoteFillMessage::add_handler_entries(&handlers[hcount], "Remote Fill AM");
       hcount += ValidMaskRequestMessage::Message::add_handler_entries(&handlers[hcount], "Valid Mask Request AM");
@@ -891,17 +1063,22 @@ namespace Realm {
       hcount += BarrierSubscribeMessage::Message::add_handler_entries(&handlers[hcount], "Barrier Subscribe AM");
       hcount += BarrierTriggerMessage::Message::add_handler_entries(&handlers[hcount], "Barrier Trigger AM");
       hcount += BarrierMigrationMessage::Message::add_handler_entries(&handlers[hcount], "Barrier Migration AM");
+      hcount += BarrierCombineAckMessage::Message::add_handler_entries(&handlers[hcount], "Barrier Combine Ack AM");
       hcount += MetadataRequestMessage::Message::add_handler_entries(&handlers[hcount], "Metadata Request AM");
       hcount += MetadataResponseMessage::Message::add_handler_entries(&handlers[hcount], "Metadata Response AM");
       hcount += MetadataInvalidateMessage::Message::add_handler_entries(&handlers[hcount], "Metadata Invalidate AM");
       hcount += MetadataInvalidateAckMessage::Message::add_handler_entries(&handlers[hcount], "Metadata Inval Ack AM");
       hcount += XferDesRemoteWriteMessage::Message::add_handler_entries(&handlers[hcount], "XferDes Remote Write AM");
       hcount += XferDesRemoteWriteAckMessage::Message::add_handler_entries(&handlers[hcount], "XferDes Remote Write Ack AM");
+      hcount += XferDesCompressedWriteMessage::Message::add_handler_entries(&handlers[hcount], "XferDes Compressed Write AM");
+      hcount += NodeAnnounceTreeMessage::Message::add_handler_entries(&handlers[hcount], "Node Announce Tree AM");
+      hcount += CollectiveMessage::Message::add_handler_entries(&handlers[hcount], "Collective AM");
+      hcount += DeppartDataMessage::Message::add_handler_entries(&handlers[hcount], "Deppart Data AM");
       hcount += XferDesCreateMessage::Message::add_handler_entries(&handlers[hcount], "Create XferDes Request AM");
       hcount += XferDesDestroyMessage::Message::add_handler_entries(&handlers[hcount], "Destroy XferDes Request AM");
       hcount += NotifyXferDesCompleteMessage::Message::add_handler_entries(&handlers[hcount], "Notify XferDes Completion Request AM");
-      hcount += UpdateBytesWriteMessage::Message::add_handler_entries(&handlers[hcount], "Update Bytes Write AM");
-      hcount += UpdateBytesReadMessage::Message::add_handler_entries(&handlers[hcount], "Update Bytes Read AM");
+      hcount += UpdateBytesWriteMessage::Message::add_handler_entries(&handlers[hcount], "Update Bytes Write AM", true /*run_inline*/);
+      hcount += UpdateBytesReadMessage::Message::add_handler_entries(&handlers[hcount], "Update Bytes Read AM", true /*run_inline*/);
       hcount += RegisterTaskMessage::Message::add_handler_entries(&handlers[hcount], "Register Task AM");
       hcount += RegisterTaskCompleteMessage::Message::add_handler_entries(&handlers[hcount], "Register Task Complete AM");
       hcount += RemoteIBAllocRequestAsync::Message::add_handler_entries(&handlers[hcount], "Remote IB Alloc Request AM");
@@ -991,6 +1168,8 @@ namespace Realm {
       LegionRuntime::LowLevel::start_dma_worker_threads(dma_worker_threads,
                                                         *core_reservations);
 
+      start_deppart_worker_threads(deppart_worker_threads, *core_reservations);
+
 #ifdef EVENT_TRACING
       // Always initialize even if we won't dump to file, otherwise segfaults happen
       // when we try to save event info
@@ -1004,10 +1183,16 @@ namespace Realm {
                                         lock_trace_exp_arrv_rate);
 #endif
 	
-      for(std::vector<Module *>::const_iterator it = modules.begin();
-	  it != modules.end();
-	  it++)
-	(*it)->initialize(this);
+      {
+	TimeStamp ts("startup: module initialization", true, &log_runtime);
+	for(std::vector<Module *>::const_iterator it = modules.begin();
+	    it != modules.end();
+	    it++) {
+	  std::string msg = "startup: " + (*it)->get_name() + " initialize";
+	  TimeStamp ts2(msg.c_str(), true, &log_runtime);
+	  (*it)->initialize(this);
+	}
+      }
 
       //gasnet_seginfo_t seginfos = new gasnet_seginfo_t[num_nodes];
       //CHECK_GASNET( gasnet_getSegmentInfo(seginfos, num_nodes) );
@@ -1022,10 +1207,16 @@ namespace Realm {
       Node *n = &nodes[gasnet_mynode()];
 
       // create memories and processors for all loaded modules
-      for(std::vector<Module *>::const_iterator it = modules.begin();
-	  it != modules.end();
-	  it++)
-	(*it)->create_memories(this);
+      {
+	TimeStamp ts("startup: memory creation", true, &log_runtime);
+	for(std::vector<Module *>::const_iterator it = modules.begin();
+	    it != modules.end();
+	    it++) {
+	  std::string msg = "startup: " + (*it)->get_name() + " create_memories";
+	  TimeStamp ts2(msg.c_str(), true, &log_runtime);
+	  (*it)->create_memories(this);
+	}
+      }
 
       LocalCPUMemory *regmem;
       if(reg_mem_size_in_mb > 0) {
@@ -1042,10 +1233,16 @@ namespace Realm {
       } else
 	regmem = 0;
 
-      for(std::vector<Module *>::const_iterator it = modules.begin();
-	  it != modules.end();
-	  it++)
-	(*it)->create_processors(this);
+      {
+	TimeStamp ts("startup: processor creation", true, &log_runtime);
+	for(std::vector<Module *>::const_iterator it = modules.begin();
+	    it != modules.end();
+	    it++) {
+	  std::string msg = "startup: " + (*it)->get_name() + " create_processors";
+	  TimeStamp ts2(msg.c_str(), true, &log_runtime);
+	  (*it)->create_processors(this);
+	}
+      }
 
       LocalCPUMemory *reg_ib_mem;
       if(reg_ib_mem_size_in_mb > 0) {
@@ -1080,26 +1277,45 @@ namespace Realm {
       filemem = new FileMemory(get_runtime()->next_local_memory_id());
       get_runtime()->add_memory(filemem);
 
-      for(std::vector<Module *>::const_iterator it = modules.begin();
-	  it != modules.end();
-	  it++)
-	(*it)->create_dma_channels(this);
+      {
+	TimeStamp ts("startup: dma channel creation", true, &log_runtime);
+	for(std::vector<Module *>::const_iterator it = modules.begin();
+	    it != modules.end();
+	    it++) {
+	  std::string msg = "startup: " + (*it)->get_name() + " create_dma_channels";
+	  TimeStamp ts2(msg.c_str(), true, &log_runtime);
+	  (*it)->create_dma_channels(this);
+	}
+      }
 
-      for(std::vector<Module *>::const_iterator it = modules.begin();
-	  it != modules.end();
-	  it++)
-	(*it)->create_code_translators(this);
+      {
+	TimeStamp ts("startup: code translator creation", true, &log_runtime);
+	for(std::vector<Module *>::const_iterator it = modules.begin();
+	    it != modules.end();
+	    it++) {
+	  std::string msg = "startup: " + (*it)->get_name() + " create_code_translators";
+	  TimeStamp ts2(msg.c_str(), true, &log_runtime);
+	  (*it)->create_code_translators(this);
+	}
+      }
       
       // start dma system at the very ending of initialization
       // since we need list of local gpus to create channels
-      LegionRuntime::LowLevel::start_dma_system(dma_worker_threads,
-                                                pin_dma_threads, 100
-                                                ,*core_reservations);
+      {
+	TimeStamp ts("startup: dma system start", true, &log_runtime);
+	LegionRuntime::LowLevel::start_dma_system(dma_worker_threads,
+						  pin_dma_threads, 100
+						  ,*core_reservations);
+      }
 
       // now that we've created all the processors/etc., we can try to come up with core
       //  allocations that satisfy everybody's requirements - this will also start up any
       //  threads that have already been requested
-      bool ok = core_reservations->satisfy_reservations(dummy_reservation_ok);
+      bool ok;
+      {
+	TimeStamp ts("startup: core reservations", true, &log_runtime);
+	ok = core_reservations->satisfy_reservations(dummy_reservation_ok);
+      }
       if(ok) {
 	if(show_reservations) {
 	  std::cout << *core_map << std::endl;
@@ -1226,18 +1442,26 @@ namespace Realm {
 				  40,  // "large" bandwidth
 				  3   // "small" latency
 				  );
+
+	  add_proc_mem_affinities(machine,
+				  procs_by_kind[k],
+				  mems_by_kind[Memory::GPU_MANAGED_MEM],
+				  40,  // "large" bandwidth
+				  3   // "small" latency
+				  );
 	}
       }
       {
-	const unsigned ADATA_SIZE = 4096;
-	size_t adata[ADATA_SIZE];
-	unsigned apos = 0;
+	std::vector<size_t> adata;
 
 	unsigned num_procs = 0;
 	unsigned num_memories = 0;
 	unsigned num_ib_memories = 0;
 
-	// announce each processor
+	// announce each processor - consecutively-numbered processors of the
+	//  same kind (the common case) are announced as a single range
+	size_t range_pos = 0;
+	Processor range_last = Processor::NO_PROC;
 	for(std::vector<ProcessorImpl *>::const_iterator it = n->processors.begin();
 	    it != n->processors.end();
 	    it++)
@@ -1247,10 +1471,20 @@ namespace Realm {
 	    int num_cores = (*it)->num_cores;
 
 	    num_procs++;
-	    adata[apos++] = NODE_ANNOUNCE_PROC;
-	    adata[apos++] = p.id;
-	    adata[apos++] = k;
-	    adata[apos++] = num_cores;
+	    if(range_last.exists() &&
+	       (adata[range_pos + 3] == (size_t)k) &&
+	       (adata[range_pos + 4] == (size_t)num_cores) &&
+	       (ID(p).proc.proc_idx == (ID(range_last).proc.proc_idx + 1))) {
+	      adata[range_pos + 2]++;
+	    } else {
+	      range_pos = adata.size();
+	      adata.push_back(NODE_ANNOUNCE_PROC_RANGE);
+	      adata.push_back(p.id);
+	      adata.push_back(1);
+	      adata.push_back(k);
+	      adata.push_back(num_cores);
+	    }
+	    range_last = p;
 	  }
 
 	// now each memory
@@ -1262,11 +1496,11 @@ namespace Realm {
 	    Memory::Kind k = (*it)->me.kind();
 
 	    num_memories++;
-	    adata[apos++] = NODE_ANNOUNCE_MEM;
-	    adata[apos++] = m.id;
-	    adata[apos++] = k;
-	    adata[apos++] = (*it)->size;
-	    adata[apos++] = reinterpret_cast<size_t>((*it)->local_reg_base());
+	    adata.push_back(NODE_ANNOUNCE_MEM);
+	    adata.push_back(m.id);
+	    adata.push_back(k);
+	    adata.push_back((*it)->size);
+	    adata.push_back(reinterpret_cast<size_t>((*it)->local_reg_base()));
 	  }
 
         for (std::vector<MemoryImpl *>::const_iterator it = n->ib_memories.begin();
@@ -1277,32 +1511,49 @@ namespace Realm {
             Memory::Kind k = (*it)->me.kind();
 
             num_ib_memories++;
-            adata[apos++] = NODE_ANNOUNCE_IB_MEM;
-            adata[apos++] = m.id;
-            adata[apos++] = k;
-            adata[apos++] = (*it)->size;
-            adata[apos++] = reinterpret_cast<size_t>((*it)->local_reg_base());
+            adata.push_back(NODE_ANNOUNCE_IB_MEM);
+            adata.push_back(m.id);
+            adata.push_back(k);
+            adata.push_back((*it)->size);
+            adata.push_back(reinterpret_cast<size_t>((*it)->local_reg_base()));
           }
 
-	// announce each processor's affinities
-	for(std::vector<ProcessorImpl *>::const_iterator it = n->processors.begin();
-	    it != n->processors.end();
-	    it++)
-	  if(*it) {
-	    Processor p = (*it)->me;
-	    std::vector<Machine::ProcessorMemoryAffinity> pmas;
-	    machine->get_proc_mem_affinity(pmas, p);
-
-	    for(std::vector<Machine::ProcessorMemoryAffinity>::const_iterator it2 = pmas.begin();
-		it2 != pmas.end();
-		it2++) {
-	      adata[apos++] = NODE_ANNOUNCE_PMA;
-	      adata[apos++] = it2->p.id;
-	      adata[apos++] = it2->m.id;
-	      adata[apos++] = it2->bandwidth;
-	      adata[apos++] = it2->latency;
+	// announce each processor's affinities - the same affinity to the
+	//  same memory for a run of consecutively-numbered processors is
+	//  announced as a single range
+	{
+	  typedef std::pair<ID::IDType, std::pair<unsigned, unsigned> > PMAKey;
+	  std::map<PMAKey, size_t> open_ranges;
+	  for(std::vector<ProcessorImpl *>::const_iterator it = n->processors.begin();
+	      it != n->processors.end();
+	      it++)
+	    if(*it) {
+	      Processor p = (*it)->me;
+	      std::vector<Machine::ProcessorMemoryAffinity> pmas;
+	      machine->get_proc_mem_affinity(pmas, p);
+
+	      for(std::vector<Machine::ProcessorMemoryAffinity>::const_iterator it2 = pmas.begin();
+		  it2 != pmas.end();
+		  it2++) {
+		PMAKey key(it2->m.id, std::make_pair(it2->bandwidth, it2->latency));
+		std::map<PMAKey, size_t>::iterator it3 = open_ranges.find(key);
+		if((it3 != open_ranges.end()) &&
+		   (ID(it2->p).proc.proc_idx == (ID((ID::IDType)adata[it3->second + 1]).proc.proc_idx +
+						 adata[it3->second + 2]))) {
+		  adata[it3->second + 2]++;
+		  continue;
+		}
+
+		open_ranges[key] = adata.size();
+		adata.push_back(NODE_ANNOUNCE_PMA_RANGE);
+		adata.push_back(it2->p.id);
+		adata.push_back(1);
+		adata.push_back(it2->m.id);
+		adata.push_back(it2->bandwidth);
+		adata.push_back(it2->latency);
+	      }
 	    }
-	  }
+	}
 
 	// now each memory's affinities with other memories
 	for(std::vector<MemoryImpl *>::const_iterator it = n->memories.begin();
@@ -1321,16 +1572,15 @@ namespace Realm {
 	      if((it2->m1 != m) || (it2->m2.address_space() != gasnet_mynode()))
 		continue;
 
-	      adata[apos++] = NODE_ANNOUNCE_MMA;
-	      adata[apos++] = it2->m1.id;
-	      adata[apos++] = it2->m2.id;
-	      adata[apos++] = it2->bandwidth;
-	      adata[apos++] = it2->latency;
+	      adata.push_back(NODE_ANNOUNCE_MMA);
+	      adata.push_back(it2->m1.id);
+	      adata.push_back(it2->m2.id);
+	      adata.push_back(it2->bandwidth);
+	      adata.push_back(it2->latency);
 	    }
 	  }
 
-	adata[apos++] = NODE_ANNOUNCE_DONE;
-	assert(apos < ADATA_SIZE);
+	adata.push_back(NODE_ANNOUNCE_DONE);
 
 #ifdef DEBUG_REALM_STARTUP
 	if(gasnet_mynode() == 0) {
@@ -1340,16 +1590,29 @@ namespace Realm {
 #endif
 
 	// now announce ourselves to everyone else
-	for(unsigned i = 0; i < gasnet_nodes(); i++)
-	  if(i != gasnet_mynode())
-	    NodeAnnounceMessage::send_request(i,
-						     num_procs,
-						     num_memories,
-						     num_ib_memories,
-						     adata, apos*sizeof(adata[0]),
-						     PAYLOAD_COPY);
-
-	NodeAnnounceMessage::await_all_announcements();
+	{
+	  TimeStamp ts("startup: machine discovery", true, &log_runtime);
+	  if(Config::announce_tree_radix > 0) {
+	    NodeAnnounceTreeMessage::exchange_announcements(Config::announce_tree_radix,
+							    num_procs,
+							    num_memories,
+							    num_ib_memories,
+							    &adata[0],
+							    adata.size() * sizeof(size_t));
+	  } else {
+	    for(unsigned i = 0; i < gasnet_nodes(); i++)
+	      if(i != gasnet_mynode())
+		NodeAnnounceMessage::send_request(i,
+						  num_procs,
+						  num_memories,
+						  num_ib_memories,
+						  &adata[0],
+						  adata.size() * sizeof(size_t),
+						  PAYLOAD_COPY);
+
+	    NodeAnnounceMessage::await_all_announcements();
+	  }
+	}
 
 #ifdef DEBUG_REALM_STARTUP
 	if(gasnet_mynode() == 0) {
@@ -1759,6 +2022,7 @@ namespace Realm {
       // Shutdown all the threads
 
       // threads that cause inter-node communication have to stop first
+      stop_deppart_worker_threads();
       LegionRuntime::LowLevel::stop_dma_worker_threads();
       LegionRuntime::LowLevel::stop_dma_system();
       stop_activemsg_threads();
@@ -1773,6 +2037,9 @@ namespace Realm {
 	  (*it)->shutdown();
       }
 
+      EventSampler::shutdown();
+      CriticalPathRecorder::shutdown();
+
 #ifdef EVENT_TRACING
       if(event_trace_file) {
 	printf("writing event trace to %s\n", event_trace_file);
@@ -1821,6 +2088,7 @@ namespace Realm {
 	delete[] nodes;
 	delete global_memory;
 	delete local_event_free_list;
+	GenEventImpl::destroy_merge_gauges();
 	delete local_barrier_free_list;
 	delete local_reservation_free_list;
 	delete local_index_space_free_list;
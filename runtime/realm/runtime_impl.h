@@ -163,6 +163,10 @@ namespace Realm {
       int num_cpu_procs, num_util_procs, num_io_procs;
       int concurrent_io_threads;
       bool force_kernel_threads;
+      bool cpu_work_stealing;
+      int cpu_spin_wait_us;
+      int cpu_autoscale_max_workers, cpu_autoscale_interval_ms;
+      bool numa_placement;
       size_t sysmem_size_in_mb, stack_size_in_mb;
     };
 
@@ -270,8 +274,15 @@ namespace Realm {
 
       const std::vector<DMAChannel *>& get_dma_channels(void) const;
 
+      // lets every module know about application-owned instance storage
+      void register_external_memory(MemoryImpl *mem, void *ptr, size_t size);
+      void unregister_external_memory(MemoryImpl *mem, void *ptr, size_t size);
+
       const std::vector<CodeTranslator *>& get_code_translators(void) const;
 
+      // returns the loaded module with the given name, or 0 if none
+      Module *get_module(const std::string& name) const;
+
     protected:
       ID::IDType num_local_memories, num_local_ib_memories, num_local_processors;
 
@@ -23,7 +23,12 @@
 #include <errno.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
 
 namespace Realm {
 
@@ -99,6 +104,41 @@ namespace Realm {
   }
 
 
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // struct MetricsExport
+  //
+
+  std::string MetricsExport::labels(const std::string& gauge_name) const
+  {
+    std::ostringstream ss;
+    ss << "{node=\"" << node << "\",gauge=\"";
+    for(std::string::const_iterator it = gauge_name.begin();
+	it != gauge_name.end();
+	++it) {
+      switch(*it) {
+      case '\\': ss << "\\\\"; break;
+      case '"': ss << "\\\""; break;
+      case '\n': ss << "\\n"; break;
+      default: ss << *it;
+      }
+    }
+    ss << "\"}";
+    return ss.str();
+  }
+
+  std::string MetricsExport::text(void) const
+  {
+    std::ostringstream ss;
+    ss << "# TYPE realm_gauge gauge\n" << values.str()
+       << "# TYPE realm_gauge_min gauge\n" << minimums.str()
+       << "# TYPE realm_gauge_max gauge\n" << maximums.str()
+       << "# TYPE realm_events counter\n" << counts.str()
+       << "# EOF\n";
+    return ss.str();
+  }
+
+
   ////////////////////////////////////////////////////////////////////////
   //
   // class GaugeSampler
@@ -109,6 +149,7 @@ namespace Realm {
     , profiler(_profiler)
     , gauge_exists(true)
     , next(0)
+    , total_events(0)
   {}
 
   GaugeSampler::~GaugeSampler(void)
@@ -142,6 +183,37 @@ namespace Realm {
   {
     // need to atomically read the value and write 0 back
     sample.count = __sync_fetch_and_and(&gauge.events, 0);
+    total_events += sample.count;
+  }
+
+  template <typename T>
+  void GaugeSampler::export_sample(MetricsExport& mx,
+				   const ProfilingGauges::AbsoluteGauge<T>& gauge,
+				   const typename ProfilingGauges::AbsoluteGauge<T>::Sample &sample) const
+  {
+    mx.values << "realm_gauge" << mx.labels(name) << ' ' << sample.value << '\n';
+  }
+
+  template <typename T>
+  void GaugeSampler::export_sample(MetricsExport& mx,
+				   const ProfilingGauges::AbsoluteRangeGauge<T>& gauge,
+				   const typename ProfilingGauges::AbsoluteRangeGauge<T>::Sample &sample) const
+  {
+    std::string labels = mx.labels(name);
+    mx.values << "realm_gauge" << labels << ' ' << sample.value << '\n';
+    mx.minimums << "realm_gauge_min" << labels << ' ' << sample.minval << '\n';
+    mx.maximums << "realm_gauge_max" << labels << ' ' << sample.maxval << '\n';
+  }
+
+  template <typename T>
+  void GaugeSampler::export_sample(MetricsExport& mx,
+				   const ProfilingGauges::EventCounter<T>& gauge,
+				   const typename ProfilingGauges::EventCounter<T>::Sample &sample) const
+  {
+    // counters are exported as running totals so that collectors can
+    //  compute rates over whatever window they like
+    mx.counts << "realm_events_total" << mx.labels(name) << ' '
+	      << (long long)total_events << '\n';
   }
 
 
@@ -158,7 +230,9 @@ namespace Realm {
     , gauge(_gauge)
     , buffer_size(0)
     , buffer(0)
+    , has_sample(false)
   {
+    name = gauge->name;
     info->gauge_id = _sampler_id;
     info->gauge_type = T::GAUGE_TYPE;
     strncpy(info->gauge_dtype, typeid(typename T::DATA_TYPE).name(), 8);
@@ -176,6 +250,8 @@ namespace Realm {
     buffer->last_sample = sample_index;
 
     perform_sample(*gauge, buffer->samples[i]);
+    last_sample = buffer->samples[i];
+    has_sample = true;
 
     // see if we can merge with the previous sample (if it exists and isn't full)
     if((i > 0) && (buffer->run_lengths[i - 1] < 0xffff) &&
@@ -206,6 +282,13 @@ namespace Realm {
     return oldbuffer;
   }
 
+  template <typename T>
+  void GaugeSamplerImpl<T>::export_metrics(MetricsExport& mx) const
+  {
+    if(has_sample)
+      export_sample(mx, *gauge, last_sample);
+  }
+
 
   ////////////////////////////////////////////////////////////////////////
   //
@@ -363,6 +446,11 @@ namespace Realm {
     , sampling_thread(0)
     , output_fd(-1)
     , flush_requested(false)
+    , cfg_profile(false)
+    , cfg_metrics_port(-1)
+    , cfg_metrics_interval(250000000) // 250 ms
+    , metrics_fd(-1)
+    , last_export_time(0)
     , sampling_start(0)
     , sampling_time(0)
   {
@@ -409,6 +497,11 @@ namespace Realm {
     for(std::vector<SampleFile::PacketNewGauge *>::iterator it = new_sampler_infos.begin();
 	it != new_sampler_infos.end();
 	++it) {
+      // nothing is written when only exporting metrics
+      if(output_fd < 0) {
+	delete *it;
+	continue;
+      }
       SampleFile::PacketHeader hdr;
       hdr.packet_type = SampleFile::PacketHeader::PACKET_NEWGAUGE;
       hdr.packet_size = sizeof(SampleFile::PacketNewGauge);
@@ -435,7 +528,8 @@ namespace Realm {
     while(sampler) {
       GaugeSampleBuffer *buffer = sampler->buffer_swap(0);
       if(buffer) {
-	if(buffer->compressed_len > 0) buffer->write_data(output_fd);
+	if((buffer->compressed_len > 0) && (output_fd >= 0))
+	  buffer->write_data(output_fd);
 	delete buffer;
       }
       GaugeSampler *next = sampler->next;
@@ -443,7 +537,10 @@ namespace Realm {
       sampler = next;
     }
 
-    close(output_fd);
+    if(output_fd >= 0)
+      close(output_fd);
+    if(metrics_fd >= 0)
+      close(metrics_fd);
 
     log_realmprof.info() << "realm profiler shut down: samples=" << next_sample_index;
   }
@@ -477,11 +574,23 @@ namespace Realm {
       .add_option_int("-realm:prof_buffer_size", cfg_buffer_size)
       .add_option_int("-realm:prof_sample_interval", cfg_sample_interval)
       .add_option_method("-realm:prof_pattern", this, &SamplingProfilerImpl::parse_profile_pattern)
+      .add_option_int("-realm:metrics_port", cfg_metrics_port)
+      .add_option_string("-realm:metrics_file", cfg_metrics_file)
+      .add_option_int("-realm:metrics_interval", cfg_metrics_interval)
       .parse_command_line(cmdline);
 
     assert(ok);
 
-    cfg_enabled = ((int)gasnet_mynode() < nodes_profiled);
+    cfg_profile = ((int)gasnet_mynode() < nodes_profiled);
+    bool cfg_metrics = (cfg_metrics_port >= 0) || !cfg_metrics_file.empty();
+    // metrics export needs the sampler even on nodes that aren't profiled
+    cfg_enabled = cfg_profile || cfg_metrics;
+    if(cfg_metrics && !cfg_profile) {
+      // nothing but the latest sample is needed, so keep buffers small and
+      //  sample only as often as we export
+      cfg_buffer_size = 64;
+      cfg_sample_interval = cfg_metrics_interval;
+    }
 
     // mark that we're configured and processed deferred additions
     DelayedGaugeAddition *dga = 0;
@@ -522,16 +631,7 @@ namespace Realm {
       delete olddga;
     }
 
-    if(cfg_enabled) {
-      CoreReservationParameters params;
-      params.set_num_cores(1);
-      core_rsrv = new CoreReservation("gauge sampler", crs, params);
-      ThreadLaunchParameters tparams;
-      sampling_thread = Thread::create_kernel_thread<SamplingProfilerImpl,
-						     &SamplingProfilerImpl::sampler_loop>(this,
-											  tparams,
-											  *core_rsrv);
-
+    if(cfg_profile) {
       // compute a per-node filename
       size_t pct = logfile.find('%');
       if(pct == std::string::npos) {
@@ -556,6 +656,21 @@ namespace Realm {
 
       log_realmprof.info() << "realm profiler enabled: logfile='" << logfile << "' interval=" << cfg_sample_interval << " ns";
     }
+
+    if(cfg_metrics)
+      open_metrics_endpoint();
+
+    // start the sampler only once the outputs it writes to exist
+    if(cfg_enabled) {
+      CoreReservationParameters params;
+      params.set_num_cores(1);
+      core_rsrv = new CoreReservation("gauge sampler", crs, params);
+      ThreadLaunchParameters tparams;
+      sampling_thread = Thread::create_kernel_thread<SamplingProfilerImpl,
+						     &SamplingProfilerImpl::sampler_loop>(this,
+											  tparams,
+											  *core_rsrv);
+    }
   }
 
   void SamplingProfilerImpl::sampler_loop(void)
@@ -565,7 +680,7 @@ namespace Realm {
       long long wait_time = (cfg_sample_interval -
 			     (Clock::current_time_in_nanoseconds() - last_sample_time));
       if(wait_time >= 1000)
-	usleep(wait_time / 1000);
+	wait_for_next_sample(wait_time);
       
       GaugeSampler *head = 0;
       GaugeSampler **tail = 0;
@@ -583,6 +698,10 @@ namespace Realm {
       for(std::vector<SampleFile::PacketNewGauge *>::iterator it = new_infos.begin();
 	  it != new_infos.end();
 	  ++it) {
+	if(output_fd < 0) {
+	  delete *it;
+	  continue;
+	}
 	SampleFile::PacketHeader hdr;
 	hdr.packet_type = SampleFile::PacketHeader::PACKET_NEWGAUGE;
 	hdr.packet_size = sizeof(SampleFile::PacketNewGauge);
@@ -621,6 +740,10 @@ namespace Realm {
       last_sample_time = t_start;
       (*sampling_start) = t_start;
       int current_sample_index = __sync_fetch_and_add(&next_sample_index, 1);
+      bool export_due = (((metrics_fd >= 0) || !cfg_metrics_file.empty()) &&
+			 ((t_start - last_export_time) >= (long long)cfg_metrics_interval));
+      MetricsExport mx;
+      mx.node = gasnet_mynode();
       GaugeSampler *sampler = head;
       while(sampler) {
 	// take the sampler's mutex while performing the sample to avoid races with
@@ -631,6 +754,8 @@ namespace Realm {
 	  AutoHSLLock al(sampler->mutex);
 	  if(sampler->gauge_exists) {
 	    full = sampler->sample_gauge(current_sample_index);
+	    if(export_due)
+	      sampler->export_metrics(mx);
 	  } else {
 	    deleted = true;
 	  }
@@ -653,6 +778,11 @@ namespace Realm {
       long long t_end = Clock::current_time_in_nanoseconds();
       (*sampling_time) += (t_end - t_start);
 
+      if(export_due) {
+	last_export_time = t_start;
+	publish_metrics(mx);
+      }
+
       // now update head and tail if we changed them
       {
 	AutoHSLLock al(mutex);
@@ -669,7 +799,8 @@ namespace Realm {
 	  it++) {
 	GaugeSampleBuffer *buffer = (*it)->buffer_swap(cfg_buffer_size);
 	assert((buffer != 0) && (buffer->compressed_len > 0));
-	buffer->write_data(output_fd);
+	if(output_fd >= 0)
+	  buffer->write_data(output_fd);
 	delete buffer;
       }
 
@@ -679,7 +810,7 @@ namespace Realm {
 	  it++) {
 	GaugeSampleBuffer *buffer = (*it)->buffer_swap(0);
 	if(buffer) {
-	  if(buffer->compressed_len > 0) 
+	  if((buffer->compressed_len > 0) && (output_fd >= 0))
 	    buffer->write_data(output_fd);
 	  delete buffer;
 	}
@@ -705,7 +836,8 @@ namespace Realm {
 							   true /*non-empty only*/);
 	  if(buffer) {
 	    assert(buffer->compressed_len > 0);
-	    buffer->write_data(output_fd);
+	    if(output_fd >= 0)
+	      buffer->write_data(output_fd);
 	    delete buffer;
 	  }
 
@@ -715,6 +847,121 @@ namespace Realm {
     }
   }
   
+  void SamplingProfilerImpl::open_metrics_endpoint(void)
+  {
+    if(cfg_metrics_port < 0) {
+      log_realmprof.info() << "metrics export enabled: file='" << cfg_metrics_file
+			   << "' interval=" << cfg_metrics_interval << " ns";
+      return;
+    }
+
+    // each node listens on its own port so that several can share a host
+    int port = cfg_metrics_port + gasnet_mynode();
+    metrics_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if(metrics_fd < 0) {
+      log_realmprof.warning() << "could not create metrics socket: " << strerror(errno);
+      return;
+    }
+    int one = 1;
+    setsockopt(metrics_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if((bind(metrics_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) ||
+       (listen(metrics_fd, 8) < 0)) {
+      log_realmprof.warning() << "could not listen for metrics requests on port "
+			      << port << ": " << strerror(errno);
+      close(metrics_fd);
+      metrics_fd = -1;
+      return;
+    }
+    fcntl(metrics_fd, F_SETFL, fcntl(metrics_fd, F_GETFL) | O_NONBLOCK);
+    log_realmprof.info() << "metrics export enabled: port=" << port
+			 << " interval=" << cfg_metrics_interval << " ns";
+  }
+
+  void SamplingProfilerImpl::wait_for_next_sample(long long wait_time)
+  {
+    if(metrics_fd < 0) {
+      usleep(wait_time / 1000);
+      return;
+    }
+
+    // answer any scrapes that arrive while we wait for the next sample
+    long long deadline = Clock::current_time_in_nanoseconds() + wait_time;
+    while(!is_shut_down) {
+      long long remaining = deadline - Clock::current_time_in_nanoseconds();
+      if(remaining < 1000000)
+	break;
+      struct pollfd pfd;
+      pfd.fd = metrics_fd;
+      pfd.events = POLLIN;
+      pfd.revents = 0;
+      if(poll(&pfd, 1, (int)(remaining / 1000000)) > 0)
+	serve_metrics_request();
+    }
+  }
+
+  void SamplingProfilerImpl::serve_metrics_request(void)
+  {
+    int fd = accept(metrics_fd, 0, 0);
+    if(fd < 0)
+      return;
+    // a slow scraper must not stall sampling for long
+    struct timeval timeout;
+    timeout.tv_sec = 0;
+    timeout.tv_usec = 100000;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    // the request itself doesn't matter - every path gets the metrics
+    char request[1024];
+    ssize_t amt = read(fd, request, sizeof(request));
+    (void)amt;
+    std::ostringstream response;
+    response << "HTTP/1.0 200 OK\r\n"
+	     << "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+	     << "Content-Length: " << metrics_text.size() << "\r\n"
+	     << "Connection: close\r\n\r\n"
+	     << metrics_text;
+    std::string data = response.str();
+    size_t written = 0;
+    while(written < data.size()) {
+      amt = write(fd, data.c_str() + written, data.size() - written);
+      if(amt <= 0)
+	break;
+      written += amt;
+    }
+    close(fd);
+  }
+
+  void SamplingProfilerImpl::publish_metrics(const MetricsExport& mx)
+  {
+    metrics_text = mx.text();
+    if(cfg_metrics_file.empty())
+      return;
+
+    // push by rewriting a file that a collector (e.g. a node exporter's
+    //  textfile directory) picks up - renaming makes the update atomic
+    std::string filename = cfg_metrics_file;
+    size_t pct = filename.find('%');
+    if(pct != std::string::npos) {
+      std::ostringstream ss;
+      ss << gasnet_mynode();
+      filename.replace(pct, 1, ss.str());
+    }
+    std::string tmpname = filename + ".tmp";
+    FILE *f = fopen(tmpname.c_str(), "w");
+    if(!f) {
+      log_realmprof.warning() << "could not write metrics to '" << tmpname << "': " << strerror(errno);
+      return;
+    }
+    fwrite(metrics_text.c_str(), 1, metrics_text.size(), f);
+    fclose(f);
+    rename(tmpname.c_str(), filename.c_str());
+  }
+
   template <typename T>
   GaugeSampler *SamplingProfilerImpl::add_gauge(T *gauge)
   {
@@ -815,6 +1062,7 @@ namespace Realm {
     template void Gauge::add_gauge<AbsoluteGauge<unsigned long> >(AbsoluteGauge<unsigned long>*, SamplingProfiler*);
     template void Gauge::add_gauge<AbsoluteGauge<unsigned> >(AbsoluteGauge<unsigned>*, SamplingProfiler*);
     template void Gauge::add_gauge<AbsoluteRangeGauge<int> >(AbsoluteRangeGauge<int>*, SamplingProfiler*);
+    template void Gauge::add_gauge<EventCounter<int> >(EventCounter<int>*, SamplingProfiler*);
 
   };
 
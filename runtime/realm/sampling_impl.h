@@ -21,6 +21,8 @@
 #include "sampling.h"
 #include "threads.h"
 
+#include <sstream>
+
 namespace Realm {
 
   class SamplingProfilerImpl;
@@ -49,6 +51,17 @@ namespace Realm {
     std::vector<unsigned short> run_lengths;
   };
 
+  // latest gauge values in OpenMetrics text form - the format requires all
+  //  the samples of a metric family to be contiguous, so each family gets
+  //  its own stream
+  struct MetricsExport {
+    std::string labels(const std::string& gauge_name) const;
+    std::string text(void) const;
+
+    int node;
+    std::ostringstream values, minimums, maximums, counts;
+  };
+
   class GaugeSampler {
   public:
     GaugeSampler(int _sampler_id, SamplingProfilerImpl *_profiler);
@@ -57,6 +70,7 @@ namespace Realm {
     virtual bool sample_gauge(int sample_index) = 0;
     virtual GaugeSampleBuffer *buffer_swap(size_t new_buffer_size,
 					   bool nonempty_only = false) = 0;
+    virtual void export_metrics(MetricsExport& mx) const = 0;
 
   protected:
     friend class ProfilingGauges::Gauge;
@@ -72,11 +86,28 @@ namespace Realm {
     void perform_sample(ProfilingGauges::EventCounter<T>& gauge, 
 			typename ProfilingGauges::EventCounter<T>::Sample &sample);
 
+    template <typename T>
+    void export_sample(MetricsExport& mx,
+		       const ProfilingGauges::AbsoluteGauge<T>& gauge,
+		       const typename ProfilingGauges::AbsoluteGauge<T>::Sample &sample) const;
+    template <typename T>
+    void export_sample(MetricsExport& mx,
+		       const ProfilingGauges::AbsoluteRangeGauge<T>& gauge,
+		       const typename ProfilingGauges::AbsoluteRangeGauge<T>::Sample &sample) const;
+    template <typename T>
+    void export_sample(MetricsExport& mx,
+		       const ProfilingGauges::EventCounter<T>& gauge,
+		       const typename ProfilingGauges::EventCounter<T>::Sample &sample) const;
+
     int sampler_id;
     SamplingProfilerImpl *profiler;
     GASNetHSL mutex;  // prevents deletion of a gauge during sampling
     bool gauge_exists;
     GaugeSampler *next;
+    // copied so that a gauge can be exported after it has been deleted
+    std::string name;
+    // running total of an event counter's samples for export
+    double total_events;
   };
 
   template <typename T>
@@ -88,11 +119,14 @@ namespace Realm {
     virtual bool sample_gauge(int sample_index);
     virtual GaugeSampleBuffer *buffer_swap(size_t new_buffer_size,
 					   bool nonempty_only = false);
+    virtual void export_metrics(MetricsExport& mx) const;
 
   protected:
     T *gauge;
     size_t buffer_size;
     GaugeSampleBufferImpl<T> *buffer;
+    bool has_sample;
+    typename T::Sample last_sample;  // most recent sample, kept for export
   };
 
   class DelayedGaugeAddition {
@@ -144,6 +178,13 @@ namespace Realm {
   protected:
     bool parse_profile_pattern(const std::string& s);
 
+    // metrics export - either served over HTTP or pushed to a text file
+    //  that a collector picks up
+    void open_metrics_endpoint(void);
+    void wait_for_next_sample(long long wait_time);
+    void serve_metrics_request(void);
+    void publish_metrics(const MetricsExport& mx);
+
     bool is_default;
     GASNetHSL mutex;
     bool is_configured, is_shut_down;
@@ -169,6 +210,13 @@ namespace Realm {
     Thread *sampling_thread;
     int output_fd;
     bool flush_requested;
+    bool cfg_profile;
+    int cfg_metrics_port;
+    std::string cfg_metrics_file;
+    size_t cfg_metrics_interval;
+    int metrics_fd;
+    long long last_export_time;
+    std::string metrics_text;
     ProfilingGauges::AbsoluteGauge<long long> *sampling_start;
     ProfilingGauges::EventCounter<long long> *sampling_time;
   };
@@ -24,6 +24,114 @@ namespace Realm {
   Logger log_task("task");
   Logger log_sched("sched");
 
+  namespace Config {
+    // number of independently-locked shards used for each task queue
+    int task_queue_shards = 1;
+    // task arguments up to this size are stored in the Task allocation
+    int task_inline_arg_size = 64;
+    // maximum number of Task allocations each processor keeps for reuse
+    int task_free_list_size = 1024;
+  };
+
+  // every Task allocation starts with this header, followed by the Task
+  //  object itself and then the inline argument storage
+  struct TaskAllocHeader {
+    TaskFreeList *free_list;
+    size_t inline_bytes;
+  } __attribute__((aligned(16)));
+
+  static size_t task_alloc_size(size_t task_bytes)
+  {
+    size_t inline_bytes = ((Config::task_inline_arg_size > 0) ?
+			     Config::task_inline_arg_size : 0);
+    return sizeof(TaskAllocHeader) + task_bytes + inline_bytes;
+  }
+
+  static void *init_task_alloc(void *raw, TaskFreeList *free_list,
+			       size_t task_bytes)
+  {
+    TaskAllocHeader *hdr = static_cast<TaskAllocHeader *>(raw);
+    hdr->free_list = free_list;
+    hdr->inline_bytes = task_alloc_size(task_bytes) - sizeof(TaskAllocHeader) - task_bytes;
+    return (hdr + 1);
+  }
+
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class TaskFreeList
+  //
+
+  TaskFreeList::TaskFreeList(size_t _max_cached)
+    : max_cached(_max_cached), outstanding(0), retired(false)
+  {}
+
+  TaskFreeList::~TaskFreeList(void)
+  {
+    assert(outstanding == 0);
+    for(std::vector<void *>::iterator it = cached.begin();
+	it != cached.end();
+	it++)
+      free(*it);
+  }
+
+  void *TaskFreeList::alloc_task(size_t bytes)
+  {
+    void *raw = 0;
+    {
+      AutoHSLLock al(mutex);
+      assert(!retired);
+      outstanding++;
+      if(!cached.empty()) {
+	raw = cached.back();
+	cached.pop_back();
+      }
+    }
+    // all Tasks are the same size, and the inline size is fixed at startup
+    if(!raw) {
+      raw = malloc(task_alloc_size(bytes));
+      assert(raw != 0);
+    }
+    return init_task_alloc(raw, this, bytes);
+  }
+
+  void TaskFreeList::free_task(void *ptr)
+  {
+    bool keep = false;
+    bool last = false;
+    {
+      AutoHSLLock al(mutex);
+      outstanding--;
+      if(!retired && (cached.size() < max_cached)) {
+	cached.push_back(ptr);
+	keep = true;
+      }
+      last = retired && (outstanding == 0);
+    }
+    if(!keep)
+      free(ptr);
+    if(last)
+      delete this;
+  }
+
+  void TaskFreeList::retire(void)
+  {
+    std::vector<void *> to_free;
+    bool last = false;
+    {
+      AutoHSLLock al(mutex);
+      retired = true;
+      to_free.swap(cached);
+      last = (outstanding == 0);
+    }
+    for(std::vector<void *>::iterator it = to_free.begin();
+	it != to_free.end();
+	it++)
+      free(*it);
+    if(last)
+      delete this;
+  }
+
   ////////////////////////////////////////////////////////////////////////
   //
   // class Task
@@ -35,9 +143,23 @@ namespace Realm {
 	     Event _before_event,
 	     Event _finish_event, int _priority)
     : Operation(_finish_event, reqs), proc(_proc), func_id(_func_id),
-      args(_args, _arglen), before_event(_before_event), priority(_priority),
-      executing_thread(0)
+      before_event(_before_event), priority(_priority),
+      deadline(NO_DEADLINE), preferred_proc(Processor::NO_PROC),
+      preferred_until(0), executing_thread(0)
   {
+    // small argument payloads are copied into the space that operator new left
+    //  after the Task object (Task has no subclasses, so 'this' is the start of
+    //  that allocation)
+    const TaskAllocHeader *hdr = reinterpret_cast<const TaskAllocHeader *>(this) - 1;
+    if((_arglen > 0) && (_arglen <= hdr->inline_bytes)) {
+      void *inline_args = reinterpret_cast<char *>(this) + sizeof(Task);
+      memcpy(inline_args, _args, _arglen);
+      args.changeref(inline_args, _arglen);
+    } else {
+      overflow_args.set(_args, _arglen);
+      args.changeref(overflow_args.base(), overflow_args.size());
+    }
+
     log_task.info() << "task " << (void *)this << " created: func=" << func_id
 		    << " proc=" << _proc << " arglen=" << _arglen
 		    << " before=" << _before_event << " after=" << _finish_event;
@@ -47,6 +169,34 @@ namespace Realm {
   {
   }
 
+  /*static*/ void *Task::operator new(size_t bytes)
+  {
+    void *raw = malloc(task_alloc_size(bytes));
+    assert(raw != 0);
+    return init_task_alloc(raw, 0, bytes);
+  }
+
+  /*static*/ void *Task::operator new(size_t bytes, TaskFreeList *free_list)
+  {
+    if(!free_list)
+      return Task::operator new(bytes);
+    return free_list->alloc_task(bytes);
+  }
+
+  /*static*/ void Task::operator delete(void *ptr)
+  {
+    TaskAllocHeader *hdr = static_cast<TaskAllocHeader *>(ptr) - 1;
+    if(hdr->free_list)
+      hdr->free_list->free_task(hdr);
+    else
+      free(hdr);
+  }
+
+  /*static*/ void Task::operator delete(void *ptr, TaskFreeList *free_list)
+  {
+    Task::operator delete(ptr);
+  }
+
   void Task::print(std::ostream& os) const
   {
     os << "task(proc=" << proc << ", func=" << func_id << ")";
@@ -73,6 +223,19 @@ namespace Realm {
     log_task.info() << "task " << (void *)this << " completed: func=" << func_id
 		    << " proc=" << proc << " arglen=" << args.size()
 		    << " before=" << before_event << " after=" << finish_event;
+
+    if(deadline != NO_DEADLINE) {
+      ProfilingMeasurements::OperationDeadlineStatus ds;
+      ds.deadline = deadline;
+      ds.complete_time = Clock::current_time_in_nanoseconds();
+      ds.missed = (ds.complete_time > deadline);
+      if(ds.missed)
+	log_task.info() << "task " << (void *)this << " missed deadline: func=" << func_id
+			<< " proc=" << proc << " late=" << (ds.complete_time - deadline) << "ns";
+      if(measurements.wants_measurement<ProfilingMeasurements::OperationDeadlineStatus>())
+	measurements.add_measurement(ds);
+    }
+
     Operation::mark_completed();
   }
 
@@ -126,6 +289,10 @@ namespace Realm {
       measurements.add_measurement(opu);
     }
 
+    // let a processor group know whether its placement hint was honored
+    if(preferred_proc.exists())
+      get_runtime()->get_procgroup_impl(proc)->record_affinity_result(preferred_proc == p);
+
     // indicate which thread will be running this task before we mark it running
     Thread *thread = Thread::self();
     executing_thread = thread;
@@ -190,6 +357,59 @@ namespace Realm {
   }
 
 
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class DeadlineTaskQueue
+  //
+
+  DeadlineTaskQueue::DeadlineTaskQueue(void)
+    : num_tasks(0)
+  {}
+
+  void DeadlineTaskQueue::put(Task *task)
+  {
+    assert(task->deadline != Task::NO_DEADLINE);
+    {
+      AutoHSLLock al(mutex);
+      tasks.insert(std::make_pair(task->deadline, task));
+      num_tasks++;
+    }
+
+    for(std::vector<NotificationCallback *>::const_iterator it = subscriptions.begin();
+	it != subscriptions.end();
+	it++)
+      (*it)->item_available(task, task->priority);
+  }
+
+  Task *DeadlineTaskQueue::get(long long earlier_than)
+  {
+    if(num_tasks == 0)
+      return 0;
+
+    AutoHSLLock al(mutex);
+    if(tasks.empty())
+      return 0;
+    std::multimap<long long, Task *>::iterator it = tasks.begin();
+    if(it->first >= earlier_than)
+      return 0;
+    Task *task = it->second;
+    tasks.erase(it);
+    num_tasks--;
+    return task;
+  }
+
+  bool DeadlineTaskQueue::empty(void) const
+  {
+    return (num_tasks == 0);
+  }
+
+  void DeadlineTaskQueue::add_subscription(NotificationCallback *callback)
+  {
+    // subscriptions are only added during setup, before any tasks show up
+    subscriptions.push_back(callback);
+  }
+
+
   ////////////////////////////////////////////////////////////////////////
   //
   // class ThreadedTaskScheduler::WorkCounter
@@ -197,10 +417,70 @@ namespace Realm {
 
   ThreadedTaskScheduler::WorkCounter::WorkCounter(void)
     : counter(0), wait_value(-1), condvar(mutex)
+    , max_spin_ns(0), spin_budget_ns(0)
+    , spin_hits(0), spin_misses(0), spin_budget_gauge(0)
   {}
 
   ThreadedTaskScheduler::WorkCounter::~WorkCounter(void)
-  {}
+  {
+    delete spin_hits;
+    delete spin_misses;
+    delete spin_budget_gauge;
+  }
+
+  void ThreadedTaskScheduler::WorkCounter::configure_spinning(long long _max_spin_ns,
+							      const std::string& gauge_prefix)
+  {
+    max_spin_ns = _max_spin_ns;
+    // start out optimistic - the budget will shrink quickly if spinning
+    //  doesn't pay off
+    spin_budget_ns = _max_spin_ns;
+
+    if((max_spin_ns > 0) && !spin_hits) {
+      spin_hits = new ProfilingGauges::EventCounter<int>(gauge_prefix + "/spin hits");
+      spin_misses = new ProfilingGauges::EventCounter<int>(gauge_prefix + "/spin misses");
+      spin_budget_gauge = new ProfilingGauges::AbsoluteGauge<unsigned>(gauge_prefix + "/spin budget (ns)",
+								       spin_budget_ns);
+    }
+  }
+
+  bool ThreadedTaskScheduler::WorkCounter::spin_for_work(long long old_counter,
+							 long long start)
+  {
+    long long budget = spin_budget_ns;
+    if(budget <= 0)
+      return false;
+
+    long long now = start;
+    do {
+      // check the counter a few times between each (relatively expensive)
+      //  read of the clock
+      for(int i = 0; i < 64; i++)
+	if(counter != old_counter) {
+	  update_spin_budget(Clock::current_time_in_nanoseconds() - start);
+	  (*spin_hits) += 1;
+	  return true;
+	}
+      now = Clock::current_time_in_nanoseconds();
+    } while((now - start) < budget);
+
+    (*spin_misses) += 1;
+    return false;
+  }
+
+  void ThreadedTaskScheduler::WorkCounter::update_spin_budget(long long wait_ns)
+  {
+    // the spin budget tracks (a moving average of) twice the observed wait
+    //  time, as long as that's within the maximum - waits that are longer
+    //  than that are better served by sleeping, so they pull the budget
+    //  towards zero
+    long long target = ((wait_ns <= max_spin_ns) ?
+			  std::min(2 * wait_ns, max_spin_ns) :
+			  0);
+    long long new_budget = (3 * spin_budget_ns + target) / 4;
+    spin_budget_ns = new_budget;
+    (*spin_budget_gauge) = (unsigned)new_budget;
+  }
 
   inline void ThreadedTaskScheduler::WorkCounter::increment_counter(void)
   {
@@ -263,6 +543,15 @@ namespace Realm {
   // sleep, so should not be called while holding another lock
   void ThreadedTaskScheduler::WorkCounter::wait_for_work(long long old_counter)
   {
+    // if spinning is enabled, give the work a chance to show up before we pay
+    //  for going to sleep
+    long long wait_start = 0;
+    if(max_spin_ns > 0) {
+      wait_start = Clock::current_time_in_nanoseconds();
+      if(spin_for_work(old_counter, wait_start))
+	return;
+    }
+
     // we assume the caller tried check_for_work() before dropping
     //  their locks and calling us, so take and hold the lock the entire time
     AutoHSLLock al(mutex);
@@ -309,6 +598,10 @@ namespace Realm {
 
     // once we're done, clear the wait value, but only if it's for us
     __sync_bool_compare_and_swap(&wait_value, old_counter, -1);
+
+    // a wait that turns out to be short means we should have spun longer
+    if(max_spin_ns > 0)
+      update_spin_budget(Clock::current_time_in_nanoseconds() - wait_start);
   }
 
 
@@ -318,9 +611,16 @@ namespace Realm {
   //
 
   ThreadedTaskScheduler::ThreadedTaskScheduler(void)
-    : shutdown_flag(false)
+    : next_steal_index(0)
+    , steal_deferred(false)
+    , shutdown_flag(false)
     , active_worker_count(0)
     , unassigned_worker_count(0)
+    , as_min_active(0), as_max_active(0)
+    , as_interval_ns(0), as_next_update(0)
+    , as_samples(0), as_saturated_samples(0), as_blocked_sum(0)
+    , as_max_active_gauge(0), as_max_idle_gauge(0)
+    , as_scale_ups(0), as_scale_downs(0)
     , wcu_task_queues(this)
     , wcu_resume_queue(this)
     , cfg_reuse_workers(true)
@@ -338,6 +638,11 @@ namespace Realm {
     assert(active_worker_count == 0);
     assert(unassigned_worker_count == 0);
     assert(idle_workers.empty());
+
+    delete as_max_active_gauge;
+    delete as_max_idle_gauge;
+    delete as_scale_ups;
+    delete as_scale_downs;
   }
 
   void ThreadedTaskScheduler::add_task_queue(TaskQueue *queue)
@@ -350,6 +655,178 @@ namespace Realm {
     queue->add_subscription(&wcu_task_queues);
   }
 
+  void ThreadedTaskScheduler::add_deadline_queue(DeadlineTaskQueue *queue)
+  {
+    AutoHSLLock al(lock);
+
+    deadline_queues.push_back(queue);
+
+    queue->add_subscription(&wcu_task_queues);
+  }
+
+  void ThreadedTaskScheduler::configure_spinning(long long max_spin_ns,
+						 const std::string& gauge_prefix)
+  {
+    work_counter.configure_spinning(max_spin_ns, gauge_prefix);
+  }
+
+  void ThreadedTaskScheduler::configure_autoscaling(int min_active, int max_active,
+						    long long interval_ns,
+						    const std::string& gauge_prefix)
+  {
+    AutoHSLLock al(lock);
+
+    assert((min_active >= 1) && (min_active <= max_active));
+    as_min_active = min_active;
+    as_max_active = max_active;
+    as_interval_ns = interval_ns;
+    as_next_update = Clock::current_time_in_nanoseconds() + interval_ns;
+
+    if((interval_ns > 0) && !as_max_active_gauge) {
+      as_max_active_gauge = new ProfilingGauges::AbsoluteGauge<unsigned>(gauge_prefix + "/autoscale max active",
+									 cfg_max_active_workers);
+      as_max_idle_gauge = new ProfilingGauges::AbsoluteGauge<unsigned>(gauge_prefix + "/autoscale max idle",
+								       cfg_max_idle_workers);
+      as_scale_ups = new ProfilingGauges::EventCounter<int>(gauge_prefix + "/autoscale ups");
+      as_scale_downs = new ProfilingGauges::EventCounter<int>(gauge_prefix + "/autoscale downs");
+    }
+  }
+
+  void ThreadedTaskScheduler::autoscale_workers(void)
+  {
+    // ready work is "waiting" if all active slots are in use, there are no
+    //  spare unassigned workers, and tasks or resumable workers are queued
+    bool work_waiting = !resumable_workers.empty();
+    for(std::vector<TaskQueue *>::const_iterator it = task_queues.begin();
+	!work_waiting && (it != task_queues.end());
+	it++)
+      if(!(*it)->empty())
+	work_waiting = true;
+    as_samples++;
+    if(work_waiting && (active_worker_count >= cfg_max_active_workers))
+      as_saturated_samples++;
+    as_blocked_sum += (int)blocked_workers.size();
+
+    // don't make decisions based on just a handful of samples
+    static const int MIN_AUTOSCALE_SAMPLES = 8;
+    if(as_samples < MIN_AUTOSCALE_SAMPLES)
+      return;
+
+    long long now = Clock::current_time_in_nanoseconds();
+    if(now < as_next_update)
+      return;
+    as_next_update = now + as_interval_ns;
+
+    // keep enough idle workers around to replace the ones that typically
+    //  block, rather than terminating and recreating them
+    int avg_blocked = (as_blocked_sum + as_samples - 1) / as_samples;
+    int new_max_idle = std::max(1, std::min(avg_blocked, as_max_active));
+    if(new_max_idle != cfg_max_idle_workers) {
+      cfg_max_idle_workers = new_max_idle;
+      (*as_max_idle_gauge) = (unsigned)new_max_idle;
+    }
+
+    // grow if ready work was waiting for an active slot in most samples,
+    //  shrink if it (almost) never was - never go below the current active
+    //  count, since the extra workers will go idle on their own
+    int new_max_active = cfg_max_active_workers;
+    if((2 * as_saturated_samples) > as_samples) {
+      if(new_max_active < as_max_active)
+	new_max_active++;
+    } else if((8 * as_saturated_samples) < as_samples) {
+      if((new_max_active > as_min_active) &&
+	 (new_max_active > active_worker_count))
+	new_max_active--;
+    }
+
+    if(new_max_active != cfg_max_active_workers) {
+      log_sched.info() << "autoscale: sched=" << this
+		       << " max_active=" << cfg_max_active_workers << "->" << new_max_active
+		       << " max_idle=" << cfg_max_idle_workers
+		       << " saturated=" << as_saturated_samples << "/" << as_samples
+		       << " avg_blocked=" << avg_blocked;
+      if(new_max_active > cfg_max_active_workers)
+	(*as_scale_ups) += 1;
+      else
+	(*as_scale_downs) += 1;
+      cfg_max_active_workers = new_max_active;
+      (*as_max_active_gauge) = (unsigned)new_max_active;
+    }
+
+    as_samples = 0;
+    as_saturated_samples = 0;
+    as_blocked_sum = 0;
+  }
+
+  void ThreadedTaskScheduler::add_steal_queue(TaskQueue *queue)
+  {
+    AutoHSLLock al(lock);
+
+    steal_queues.push_back(queue);
+
+    // we want to hear about new work in the sibling's queue too, or an idle
+    //  worker here would never wake up to go steal it
+    queue->add_subscription(&wcu_task_queues);
+  }
+
+  bool ThreadedTaskScheduler::is_stealable(Task *task)
+  {
+    // processor init/shutdown (and other legacy) tasks are always pinned to
+    //  the processor they were spawned on
+    return (task->func_id >= Processor::TASK_ID_FIRST_AVAILABLE);
+  }
+
+  // attempts to take an eligible task from one of the steal queues - lock
+  //  should be held by caller
+  Task *ThreadedTaskScheduler::steal_task(int *task_priority)
+  {
+    size_t num_queues = steal_queues.size();
+    long long now = -1;
+    steal_deferred = false;
+    for(size_t i = 0; i < num_queues; i++) {
+      // rotate the starting point so that one sibling isn't always the victim
+      TaskQueue *victim = steal_queues[(next_steal_index + i) % num_queues];
+
+      // peek first so that an ineligible task at the front of a sibling's queue
+      //  doesn't get repeatedly pulled and pushed back (which would generate
+      //  spurious work notifications for everybody)
+      int peek_priority;
+      Task *candidate = victim->peek(&peek_priority);
+      if(!candidate || !is_stealable(candidate))
+	continue;
+
+      // a task with a placement hint is left alone for a little while to
+      //  give its preferred processor a chance to get to it
+      if(candidate->preferred_until > 0) {
+	if(now < 0)
+	  now = Clock::current_time_in_nanoseconds();
+	if(now < candidate->preferred_until) {
+	  steal_deferred = true;
+	  continue;
+	}
+      }
+
+      int new_priority;
+      Task *task = victim->get(&new_priority, peek_priority - 1);
+      if(!task)
+	continue;  // somebody beat us to it
+
+      // it's possible that what we got isn't what we peeked at
+      if(!is_stealable(task)) {
+	victim->put(task, new_priority, false); // back on front of list
+	continue;
+      }
+
+      next_steal_index = (next_steal_index + i + 1) % num_queues;
+      log_sched.debug() << "task stolen: sched=" << this << " task=" << task
+			<< " proc=" << task->proc;
+      *task_priority = new_priority;
+      return task;
+    }
+
+    return 0;
+  }
+
   // helper for tracking/sanity-checking worker counts
   inline void ThreadedTaskScheduler::update_worker_count(int active_delta,
 							 int unassigned_delta,
@@ -544,13 +1021,34 @@ namespace Realm {
 	  old_work_counter = work_counter.read_counter();  // re-read - may have changed while we slept
 	}
 
+	// we're an unassigned worker, so this is a safe point to adjust limits
+	if(as_interval_ns > 0)
+	  autoscale_workers();
+
 	// try to get a new task then
 	// remember where a task has come from in case we want to put it back
 	Task *task = 0;
 	TaskQueue *task_source = 0;
 	int task_priority = TaskQueue::PRI_NEG_INF;
+
+	// deadline tasks come first, earliest deadline wins
+	DeadlineTaskQueue *deadline_source = 0;
+	for(std::vector<DeadlineTaskQueue *>::const_iterator it = deadline_queues.begin();
+	    it != deadline_queues.end();
+	    it++) {
+	  Task *new_task = (*it)->get(task ? task->deadline : LLONG_MAX);
+	  if(new_task) {
+	    if(task)
+	      deadline_source->put(task);
+	    task = new_task;
+	    deadline_source = *it;
+	  }
+	}
+	if(task)
+	  task_priority = TaskQueue::PRI_MAX_FINITE;
+
 	for(std::vector<TaskQueue *>::const_iterator it = task_queues.begin();
-	    it != task_queues.end();
+	    !deadline_source && (it != task_queues.end());
 	    it++) {
 	  int new_priority;
 	  Task *new_task = (*it)->get(&new_priority, task_priority);
@@ -565,6 +1063,10 @@ namespace Realm {
 	  }
 	}
 
+	// if our own queues are dry, see if a sibling has something we can take
+	if(!task && !steal_queues.empty())
+	  task = steal_task(&task_priority);
+
 	// did we find work to do?
 	if(task) {
 	  // we've now got some assigned work, so fire up a new idle worker if we were the last
@@ -620,6 +1122,15 @@ namespace Realm {
 	    }
 	  }
 
+	  // if a hinted task will become stealable shortly, keep polling for
+	  //  it instead of going to sleep
+	  if(steal_deferred) {
+	    lock.unlock();
+	    Thread::yield();
+	    lock.lock();
+	    continue;
+	  }
+
 	  // do we have more unassigned and idle tasks than we need?
 	  int total_idle_count = (unassigned_worker_count +
 				  (int)(idle_workers.size()));
@@ -805,6 +1316,13 @@ namespace Realm {
     return true;
   }
 
+  bool KernelThreadTaskScheduler::is_stealable(Task *task)
+  {
+    // we can only run a stolen task if we have a variant registered for it
+    return (ThreadedTaskScheduler::is_stealable(task) &&
+	    get_runtime()->get_processor_impl(proc)->has_task_variant(task->func_id));
+  }
+
   Thread *KernelThreadTaskScheduler::worker_create(bool make_active)
   {
     // lock is held by caller
@@ -887,24 +1405,6 @@ namespace Realm {
     if(switch_to)
       worker_wake(switch_to);
   }
-  
-  void KernelThreadTaskScheduler::wait_for_work(long long old_work_counter)
-  {
-    // if we have a dedicated core and we don't care about power, we can spin-wait here
-    bool spin_wait = false;
-    if(spin_wait) {
-      while(!work_counter.check_for_work(old_work_counter)) {
-	// don't sleep, but let go of lock and other threads run
-	lock.unlock();
-	Thread::yield();
-	lock.lock();
-      }
-      return;
-    }
-
-    // otherwise fall back to the base (sleeping) implementation
-    ThreadedTaskScheduler::wait_for_work(old_work_counter);
-  }
 
 
   ////////////////////////////////////////////////////////////////////////
@@ -936,6 +1436,17 @@ namespace Realm {
     ThreadedTaskScheduler::add_task_queue(queue);
   }
 
+  void UserThreadTaskScheduler::configure_autoscaling(int min_active, int max_active,
+						      long long interval_ns,
+						      const std::string& gauge_prefix)
+  {
+    // the active worker count is fixed by the number of host threads, so
+    //  only the idle worker pool can be adjusted
+    ThreadedTaskScheduler::configure_autoscaling(cfg_num_host_threads,
+						 cfg_num_host_threads,
+						 interval_ns, gauge_prefix);
+  }
+
   void UserThreadTaskScheduler::start(void)
   {
     // with user threading, active must always match the number of host threads
@@ -1060,6 +1571,13 @@ namespace Realm {
     return true;
   }
 
+  bool UserThreadTaskScheduler::is_stealable(Task *task)
+  {
+    // we can only run a stolen task if we have a variant registered for it
+    return (ThreadedTaskScheduler::is_stealable(task) &&
+	    get_runtime()->get_processor_impl(proc)->has_task_variant(task->func_id));
+  }
+
   Thread *UserThreadTaskScheduler::worker_create(bool make_active)
   {
     // lock held by caller
@@ -1142,24 +1660,6 @@ namespace Realm {
     // we don't expect to ever get control back
     assert(0);
   }
-
-  void UserThreadTaskScheduler::wait_for_work(long long old_work_counter)
-  {
-    // if we have a dedicated core and we don't care about power, we can spin-wait here
-    bool spin_wait = false;
-    if(spin_wait) {
-      while(!work_counter.check_for_work(old_work_counter)) {
-	// don't sleep, but let go of lock and other threads run
-	lock.unlock();
-	Thread::yield();
-	lock.lock();
-      }
-      return;
-    }
-
-    // otherwise fall back to the base (sleeping) implementation
-    ThreadedTaskScheduler::wait_for_work(old_work_counter);
-  }
 #endif
 
 
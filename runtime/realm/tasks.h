@@ -30,6 +30,8 @@
 
 namespace Realm {
 
+    class TaskFreeList;
+
     // information for a task launch
     class Task : public Operation {
     public:
@@ -40,6 +42,14 @@ namespace Realm {
 	   Event _before_event,
 	   Event _finish_event, int _priority);
 
+      // every Task allocation includes room for Config::task_inline_arg_size
+      //  bytes of arguments - allocations from a TaskFreeList are recycled
+      //  instead of being returned to the heap
+      static void *operator new(size_t bytes);
+      static void *operator new(size_t bytes, TaskFreeList *free_list);
+      static void operator delete(void *ptr);
+      static void operator delete(void *ptr, TaskFreeList *free_list);
+
     protected:
       // deletion performed when reference count goes to zero
       virtual ~Task(void);
@@ -50,20 +60,84 @@ namespace Realm {
 
       virtual void print(std::ostream& os) const;
 
+      virtual Event get_precondition(void) const { return before_event; }
+      virtual const char *get_kind_name(void) const { return "task"; }
+
       virtual bool attempt_cancellation(int error_code, const void *reason_data, size_t reason_size);
       
       void execute_on_processor(Processor p);
 
       Processor proc;
       Processor::TaskFuncID func_id;
-      ByteArray args;
+      ByteArrayRef args;  // refers to inline storage or 'overflow_args'
       Event before_event;
       int priority;
+      long long deadline;  // NO_DEADLINE unless in the deadline scheduling class
+
+      // for a task sent to a processor group, the member that should preferably
+      //  run it (NO_PROC if none) - other members may only take the task once
+      //  the current time (in ns) has passed 'preferred_until'
+      Processor preferred_proc;
+      long long preferred_until;
+
+      static const long long NO_DEADLINE = -1;
 
     protected:
       virtual void mark_completed(void);
 
       Thread *executing_thread;
+      ByteArray overflow_args;
+    };
+
+    // a per-processor cache of Task allocations - a task may be freed by any
+    //  thread, so the list is protected by a lock
+    class TaskFreeList {
+    public:
+      TaskFreeList(size_t _max_cached);
+
+      void *alloc_task(size_t bytes);
+      void free_task(void *ptr);
+
+      // called by the owner when it is destroyed - cached storage is released
+      //  right away, but the list itself sticks around until every task
+      //  allocated from it has been freed
+      void retire(void);
+
+    protected:
+      ~TaskFreeList(void);
+
+      GASNetHSL mutex;
+      size_t max_cached;
+      std::vector<void *> cached;
+      size_t outstanding;
+      bool retired;
+    };
+
+    // tasks in the deadline scheduling class wait in one of these rather than a
+    //  regular task queue - they are kept in order of absolute deadline, with
+    //  ties broken by arrival order
+    class DeadlineTaskQueue {
+    public:
+      DeadlineTaskQueue(void);
+
+      typedef ShardedPriorityQueue<Task *, GASNetHSL>::NotificationCallback NotificationCallback;
+
+      void put(Task *task);
+
+      // takes the earliest-deadline task, if any is due before 'earlier_than'
+      Task *get(long long earlier_than);
+
+      // lock-free, so only a hint
+      bool empty(void) const;
+
+      // callbacks are told about every new task (but can't consume it)
+      void add_subscription(NotificationCallback *callback);
+
+    protected:
+      GASNetHSL mutex;
+      std::multimap<long long, Task *> tasks;
+      volatile int num_tasks;
+      std::vector<NotificationCallback *> subscriptions;
     };
 
     // a task scheduler in which one or more worker threads execute tasks from one
@@ -78,13 +152,35 @@ namespace Realm {
 
       virtual ~ThreadedTaskScheduler(void);
 
-      typedef PriorityQueue<Task *, GASNetHSL> TaskQueue;
+      typedef ShardedPriorityQueue<Task *, GASNetHSL> TaskQueue;
 
       virtual void add_task_queue(TaskQueue *queue);
 
+      // tasks in deadline queues are always considered before those in regular
+      //  task queues
+      virtual void add_deadline_queue(DeadlineTaskQueue *queue);
+
+      // (opt-in) work stealing - a steal queue belongs to some other processor
+      //  and is only searched when none of our own task queues have any work
+      virtual void add_steal_queue(TaskQueue *queue);
+
       virtual void start(void) = 0;
       virtual void shutdown(void) = 0;
 
+      // enables adaptive spin-then-park waiting for idle workers (see
+      //  WorkCounter::configure_spinning)
+      void configure_spinning(long long max_spin_ns, const std::string& gauge_prefix);
+
+      // enables a feedback controller that periodically (every 'interval_ns')
+      //  adjusts the maximum number of active workers within
+      //  [min_active, max_active] based on how often ready work had to wait
+      //  for an active slot, and sizes the idle worker pool to cover the
+      //  average number of blocked workers - decisions are exported as gauges
+      //  whose names start with 'gauge_prefix'
+      virtual void configure_autoscaling(int min_active, int max_active,
+					 long long interval_ns,
+					 const std::string& gauge_prefix);
+
       // called when thread status changes
       virtual void thread_blocking(Thread *thread);
       virtual void thread_ready(Thread *thread);
@@ -100,6 +196,13 @@ namespace Realm {
       //   may have been left in a bad state
       virtual bool execute_task(Task *task) = 0;
 
+      // returns true if a task found in a steal queue may be run by this
+      //  scheduler - the default refuses only runtime-internal tasks
+      virtual bool is_stealable(Task *task);
+
+      // attempts to take an eligible task from one of the steal queues
+      Task *steal_task(int *task_priority);
+
       virtual Thread *worker_create(bool make_active) = 0;
       virtual void worker_sleep(Thread *switch_to) = 0;
       virtual void worker_wake(Thread *to_wake) = 0;
@@ -107,6 +210,12 @@ namespace Realm {
 
       GASNetHSL lock;
       std::vector<TaskQueue *> task_queues;
+      std::vector<DeadlineTaskQueue *> deadline_queues;
+      std::vector<TaskQueue *> steal_queues;
+      size_t next_steal_index;  // round-robin starting point for steal attempts
+      // set by steal_task if a task was passed over only because it is still
+      //  reserved for its preferred processor
+      bool steal_deferred;
       std::vector<Thread *> idle_workers;
       std::set<Thread *> blocked_workers;
 
@@ -120,6 +229,21 @@ namespace Realm {
       // helper for tracking/sanity-checking worker counts
       void update_worker_count(int active_delta, int unassigned_delta, bool check = true);
 
+      // samples blocked/ready pressure and, once per interval, updates the
+      //  worker limits - must be called with the lock held by an unassigned
+      //  worker
+      void autoscale_workers(void);
+
+      // autoscaling state (disabled if as_interval_ns == 0)
+      int as_min_active, as_max_active;
+      long long as_interval_ns;
+      long long as_next_update;
+      int as_samples, as_saturated_samples, as_blocked_sum;
+      ProfilingGauges::AbsoluteGauge<unsigned> *as_max_active_gauge;
+      ProfilingGauges::AbsoluteGauge<unsigned> *as_max_idle_gauge;
+      ProfilingGauges::EventCounter<int> *as_scale_ups;
+      ProfilingGauges::EventCounter<int> *as_scale_downs;
+
       // workers that are unassigned and cannot find any work would often (but not
       //  always) like to suspend until work is available - this is done via a "work counter"
       //  that monotonically increments whenever any kind of new work is available and a 
@@ -146,12 +270,35 @@ namespace Realm {
 	// sleep, so should not be called while holding another lock
 	void wait_for_work(long long old_counter);
 
+	// by default, a waiter goes straight to sleep - with spinning enabled, a
+	//  waiter first spins (without the lock) for up to a "spin budget" that
+	//  adapts to the recently observed wait times, but never exceeds
+	//  'max_spin_ns' - a max of 0 disables spinning again
+	// hit/miss counts and the current budget are exported as gauges whose names
+	//  start with 'gauge_prefix'
+	void configure_spinning(long long max_spin_ns, const std::string& gauge_prefix);
+
       protected:
+	// spins until new work arrives or the spin budget is exhausted - returns
+	//  true if new work arrived
+	bool spin_for_work(long long old_counter, long long start);
+
+	// adjusts the spin budget based on how long a wait actually took
+	void update_spin_budget(long long wait_ns);
+
 	// 64-bit counters are used to avoid dealing with wrap-around cases
 	volatile long long counter;
 	volatile long long wait_value;
 	GASNetHSL mutex;
 	GASNetCondVar condvar;
+
+	// adaptive spinning state - budget updates are not synchronized, as an
+	//  occasional lost update is harmless
+	long long max_spin_ns;
+	volatile long long spin_budget_ns;
+	ProfilingGauges::EventCounter<int> *spin_hits;
+	ProfilingGauges::EventCounter<int> *spin_misses;
+	ProfilingGauges::AbsoluteGauge<unsigned> *spin_budget_gauge;
       };
 	
       WorkCounter work_counter;
@@ -204,13 +351,13 @@ namespace Realm {
     protected:
       virtual bool execute_task(Task *task);
 
+      virtual bool is_stealable(Task *task);
+
       virtual Thread *worker_create(bool make_active);
       virtual void worker_sleep(Thread *switch_to);
       virtual void worker_wake(Thread *to_wake);
       virtual void worker_terminate(Thread *switch_to);
 
-      virtual void wait_for_work(long long old_work_counter);
-
       Processor proc;
       CoreReservation &core_rsrv;
 
@@ -232,6 +379,10 @@ namespace Realm {
 
       virtual void add_task_queue(TaskQueue *queue);
 
+      virtual void configure_autoscaling(int min_active, int max_active,
+					 long long interval_ns,
+					 const std::string& gauge_prefix);
+
       virtual void start(void);
       virtual void shutdown(void);
 
@@ -242,6 +393,8 @@ namespace Realm {
     protected:
       virtual bool execute_task(Task *task);
 
+      virtual bool is_stealable(Task *task);
+
       void host_thread_loop(void);
       
       // you can't delete a user thread until you've switched off of it, so
@@ -254,8 +407,6 @@ namespace Realm {
       virtual void worker_wake(Thread *to_wake);
       virtual void worker_terminate(Thread *switch_to);
 
-      virtual void wait_for_work(long long old_work_counter);
-
       Processor proc;
       CoreReservation &core_rsrv;
 
@@ -50,6 +50,87 @@ inline void makecontext_wrap(ucontext_t *u, void (*fn)(), int args, ...) { makec
 #define swapcontext swapcontext_wrap
 #define makecontext makecontext_wrap
 #endif
+
+// on common 64-bit targets, user threads can be switched by saving and
+//  restoring just the callee-saved registers - swapcontext also saves and
+//  restores the signal mask (a system call on every switch) and the full
+//  floating point environment
+#if defined(__x86_64__) || defined(__aarch64__)
+#define REALM_USE_FAST_USER_SWITCH
+
+// saves the callee-saved state of the caller on its stack, stores the
+//  resulting stack pointer in '*save_sp', and resumes the context whose
+//  stack pointer is 'restore_sp'
+extern "C" void realm_uthread_swap(void **save_sp, void *restore_sp)
+  __asm__("realm_uthread_swap");
+
+#if defined(__x86_64__)
+// frame (low to high): mxcsr/x87 cw, r15, r14, r13, r12, rbx, rbp, return addr
+//  - a new thread's frame has an extra zero word above the return address so
+//  that its entry point sees the stack alignment a normal call would produce
+__asm__(".text\n"
+	".p2align 4\n"
+	"realm_uthread_swap:\n"
+	"  pushq %rbp\n"
+	"  pushq %rbx\n"
+	"  pushq %r12\n"
+	"  pushq %r13\n"
+	"  pushq %r14\n"
+	"  pushq %r15\n"
+	"  subq $8, %rsp\n"
+	"  stmxcsr (%rsp)\n"
+	"  fnstcw 4(%rsp)\n"
+	"  movq %rsp, (%rdi)\n"
+	"  movq %rsi, %rsp\n"
+	"  ldmxcsr (%rsp)\n"
+	"  fldcw 4(%rsp)\n"
+	"  addq $8, %rsp\n"
+	"  popq %r15\n"
+	"  popq %r14\n"
+	"  popq %r13\n"
+	"  popq %r12\n"
+	"  popq %rbx\n"
+	"  popq %rbp\n"
+	"  ret\n");
+
+static const size_t FAST_SWITCH_FRAME_WORDS = 9;
+#endif
+
+#if defined(__aarch64__)
+// frame (low to high): x19-x28, x29 (fp), x30 (lr), d8-d15
+__asm__(".text\n"
+	".p2align 4\n"
+	"realm_uthread_swap:\n"
+	"  sub sp, sp, #160\n"
+	"  stp x19, x20, [sp, #0]\n"
+	"  stp x21, x22, [sp, #16]\n"
+	"  stp x23, x24, [sp, #32]\n"
+	"  stp x25, x26, [sp, #48]\n"
+	"  stp x27, x28, [sp, #64]\n"
+	"  stp x29, x30, [sp, #80]\n"
+	"  stp d8, d9, [sp, #96]\n"
+	"  stp d10, d11, [sp, #112]\n"
+	"  stp d12, d13, [sp, #128]\n"
+	"  stp d14, d15, [sp, #144]\n"
+	"  mov x9, sp\n"
+	"  str x9, [x0]\n"
+	"  mov sp, x1\n"
+	"  ldp x19, x20, [sp, #0]\n"
+	"  ldp x21, x22, [sp, #16]\n"
+	"  ldp x23, x24, [sp, #32]\n"
+	"  ldp x25, x26, [sp, #48]\n"
+	"  ldp x27, x28, [sp, #64]\n"
+	"  ldp x29, x30, [sp, #80]\n"
+	"  ldp d8, d9, [sp, #96]\n"
+	"  ldp d10, d11, [sp, #112]\n"
+	"  ldp d12, d13, [sp, #128]\n"
+	"  ldp d14, d15, [sp, #144]\n"
+	"  add sp, sp, #160\n"
+	"  ret\n");
+
+static const size_t FAST_SWITCH_FRAME_WORDS = 20;
+#endif
+#endif
 #endif
 
 #ifdef REALM_USE_HWLOC
@@ -83,6 +164,11 @@ inline void makecontext_wrap(ucontext_t *u, void (*fn)(), int args, ...) { makec
 
 namespace Realm {
 
+  namespace Config {
+    // use the register-only user thread switch where it is available
+    int user_thread_fast_switch = 1;
+  };
+
   Logger log_thread("threads");
 
 #ifdef REALM_USE_PAPI
@@ -140,12 +226,14 @@ namespace Realm {
 
   CoreReservationSet::CoreReservationSet(bool hyperthread_sharing)
     : owns_coremap(true), cm(0)
+    , default_preferred_domain(CoreReservationParameters::NUMA_DOMAIN_DONTCARE)
   {
     cm = CoreMap::discover_core_map(hyperthread_sharing);
   }
 
   CoreReservationSet::CoreReservationSet(const CoreMap *_cm)
     : owns_coremap(false), cm(_cm)
+    , default_preferred_domain(CoreReservationParameters::NUMA_DOMAIN_DONTCARE)
   {
   }
 
@@ -174,6 +262,11 @@ namespace Realm {
     allocations[&rsrv] = 0;
   }
 
+  void CoreReservationSet::set_default_preferred_numa_domain(int domain)
+  {
+    default_preferred_domain = domain;
+  }
+
   static bool can_add_usage(CoreReservationParameters::CoreUsage current,
 			    CoreReservationParameters::CoreUsage reqd)
   {
@@ -258,7 +351,8 @@ namespace Realm {
   //  if any allocations are already present, those are preserved (possibly causing the
   //  allocation attempt to fail)
   static bool attempt_allocation(const CoreMap& cm,
-				 std::map<CoreReservation *, CoreReservation::Allocation *>& allocs)
+				 std::map<CoreReservation *, CoreReservation::Allocation *>& allocs,
+				 int default_preferred_domain)
   {
     // we'll need to keep track of the usage level of each core
     std::map<const CoreMap::Proc *, CoreReservationParameters::CoreUsage> alu_usage, fpu_usage, ldst_usage;
@@ -354,13 +448,45 @@ namespace Realm {
 	CoreReservation *rsrv = *it2;
 	std::set<const CoreMap::Proc *>& procs = assigned_procs[rsrv];
 
+	// a soft domain preference only matters if any domain is acceptable - the
+	//  preferred domain's cores are considered first, and the rest are only
+	//  used if the preferred domain alone can't satisfy the request
+	int pref_domain = rsrv->params.preferred_numa_domain;
+	if(pref_domain < 0)
+	  pref_domain = default_preferred_domain;
+	std::vector<const CoreMap::Proc *> pref_pm;
+	if((req_domain < 0) && (pref_domain >= 0)) {
+	  for(std::vector<const CoreMap::Proc *>::const_iterator it3 = pm.begin();
+	      it3 != pm.end();
+	      it3++)
+	    if((*it3)->domain == pref_domain)
+	      pref_pm.push_back(*it3);
+	  size_t num_pref = pref_pm.size();
+	  for(std::vector<const CoreMap::Proc *>::const_iterator it3 = pm.begin();
+	      it3 != pm.end();
+	      it3++)
+	    if((*it3)->domain != pref_domain)
+	      pref_pm.push_back(*it3);
+	  // remember where the fallback cores begin
+	  pref_pm.insert(pref_pm.begin() + num_pref, (const CoreMap::Proc *)0);
+	}
+	std::vector<const CoreMap::Proc *>& cand = (pref_pm.empty() ? pm : pref_pm);
+
 	// iterate over all the possibly available processors and see if any fit
-	for(std::vector<const CoreMap::Proc *>::iterator it3 = pm.begin();
-	    it3 != pm.end();
+	for(std::vector<const CoreMap::Proc *>::iterator it3 = cand.begin();
+	    it3 != cand.end();
 	    it3++)
 	{
 	  const CoreMap::Proc *p = *it3;
 
+	  // the marker between preferred and fallback cores - stop if the
+	  //  preferred domain already gave us enough
+	  if(!p) {
+	    if((int)(procs.size()) >= rsrv->params.num_cores)
+	      break;
+	    continue;
+	  }
+
 	  // is there already conflicting usage?
 	  if(!(can_add_usage(alu_usage, rsrv->params.alu_usage, p, p->shares_alu) &&
 	       can_add_usage(fpu_usage, rsrv->params.fpu_usage, p, p->shares_fpu) &&
@@ -446,7 +572,8 @@ namespace Realm {
     // one shot for now - eventually allow a reservation to say it's willing to be
     //  adjusted if needed
     bool ok = attempt_allocation(*cm,
-				 allocations);
+				 allocations,
+				 default_preferred_domain);
     if(!ok) {
       if(!dummy_reservation_ok)
 	return false;
@@ -510,6 +637,17 @@ namespace Realm {
       os << rsrv->name << ": ";
       if(alloc) {
 	os << "allocated " << alloc->proc_ids;
+	// also show which NUMA domain(s) those cores live in
+	std::set<int> domains;
+	for(std::set<int>::const_iterator it2 = alloc->proc_ids.begin();
+	    it2 != alloc->proc_ids.end();
+	    it2++) {
+	  CoreMap::ProcMap::const_iterator it3 = cm->all_procs.find(*it2);
+	  if(it3 != cm->all_procs.end())
+	    domains.insert(it3->second->domain);
+	}
+	if(!domains.empty())
+	  os << " domains " << domains;
       } else {
 	os << "not allocated";
       }
@@ -851,6 +989,13 @@ namespace Realm {
     // valgrind says Darwin's getcontext is writing past the end of ctx?
     ucontext_t ctx;
     int padding[512];
+#endif
+#ifdef REALM_USE_FAST_USER_SWITCH
+    // saved stack pointer when switched out using the fast path
+    void *fast_sp;
+    bool fast_switch;
+
+    void init_fast_context(void);
 #endif
     void *stack_base;
     size_t stack_size;
@@ -862,7 +1007,11 @@ namespace Realm {
   UserThread::UserThread(void *_target, void (*_entry_wrapper)(void *),
 			 ThreadScheduler *_scheduler)
     : Thread(_scheduler), target(_target), entry_wrapper(_entry_wrapper)
-    , magic(MAGIC_VALUE), stack_base(0), stack_size(0), ok_to_delete(false)
+    , magic(MAGIC_VALUE)
+#ifdef REALM_USE_FAST_USER_SWITCH
+    , fast_sp(0), fast_switch(false)
+#endif
+    , stack_base(0), stack_size(0), ok_to_delete(false)
     , running(false)
   {
   }
@@ -878,6 +1027,10 @@ namespace Realm {
 
   namespace ThreadLocal {
     __thread ucontext_t *host_context = 0;
+#ifdef REALM_USE_FAST_USER_SWITCH
+    // saved stack pointer of the host thread when the fast path is used
+    __thread void **host_fast_sp = 0;
+#endif
     // current_user_thread is redundant with current_thread, but kept for debugging
     //  purposes for now
     __thread UserThread *current_user_thread = 0;
@@ -932,6 +1085,14 @@ namespace Realm {
     stack_base = malloc(stack_size);
     assert(stack_base != 0);
 
+#ifdef REALM_USE_FAST_USER_SWITCH
+    if(Config::user_thread_fast_switch) {
+      init_fast_context();
+      update_state(STATE_STARTUP);
+      return;
+    }
+#endif
+
     getcontext(&ctx);
 
     ctx.uc_link = 0; // we don't expect it to ever fall through
@@ -946,6 +1107,28 @@ namespace Realm {
     update_state(STATE_STARTUP);    
   }
 
+#ifdef REALM_USE_FAST_USER_SWITCH
+  // builds an initial frame at the top of the stack that looks like a
+  //  suspended call to realm_uthread_swap, "returning" into uthread_entry
+  void UserThread::init_fast_context(void)
+  {
+    uintptr_t top = (reinterpret_cast<uintptr_t>(stack_base) + stack_size) & ~uintptr_t(15);
+    uintptr_t *frame = reinterpret_cast<uintptr_t *>(top) - FAST_SWITCH_FRAME_WORDS;
+    memset(frame, 0, FAST_SWITCH_FRAME_WORDS * sizeof(uintptr_t));
+#if defined(__x86_64__)
+    uint32_t *fpcsr = reinterpret_cast<uint32_t *>(frame);
+    fpcsr[0] = 0x1f80;  // default MXCSR
+    fpcsr[1] = 0x037f;  // default x87 control word
+    frame[7] = reinterpret_cast<uintptr_t>(&uthread_entry);
+#endif
+#if defined(__aarch64__)
+    frame[11] = reinterpret_cast<uintptr_t>(&uthread_entry);  // x30
+#endif
+    fast_sp = frame;
+    fast_switch = true;
+  }
+#endif
+
   void UserThread::join(void)
   {
     assert(0); // not supported yet
@@ -972,6 +1155,28 @@ namespace Realm {
       assert(switch_to->magic == MAGIC_VALUE);
       assert(ThreadLocal::host_context == 0);
 
+#ifdef REALM_USE_FAST_USER_SWITCH
+      if(switch_to->fast_switch) {
+	assert(ThreadLocal::host_fast_sp == 0);
+
+	// this holds the host's stack pointer (the rest of its state is on
+	//  that stack)
+	void *host_sp = 0;
+
+	ThreadLocal::host_fast_sp = &host_sp;
+	ThreadLocal::current_user_thread = switch_to;
+	ThreadLocal::current_host_thread = ThreadLocal::current_thread;
+	ThreadLocal::current_thread = switch_to;
+
+	realm_uthread_swap(&host_sp, switch_to->fast_sp);
+
+	assert(ThreadLocal::current_user_thread == 0);
+	assert(ThreadLocal::host_fast_sp == &host_sp);
+	ThreadLocal::host_fast_sp = 0;
+	return;
+      }
+#endif
+
       // this holds the host's state
       ucontext_t host_ctx;
 
@@ -1006,27 +1211,42 @@ namespace Realm {
 	ThreadLocal::current_thread = switch_to;
 
 	// a switch between two user contexts - nice and simple
+#ifdef REALM_USE_FAST_USER_SWITCH
+	if(switch_from->fast_switch) {
+	  assert(switch_to->fast_switch);
+	  realm_uthread_swap(&switch_from->fast_sp, switch_to->fast_sp);
+	} else
+#endif
+	{
 #ifndef NDEBUG
-	int ret =
+	  int ret =
 #endif
-	  swapcontext(&switch_from->ctx, &switch_to->ctx);
-	assert(ret == 0);
+	    swapcontext(&switch_from->ctx, &switch_to->ctx);
+	  assert(ret == 0);
+	}
 
 	assert(switch_from->running == false);
 	switch_from->host_pthread = pthread_self();
 	switch_from->running = true;
       } else {
 	// a return of control to the host thread
-	assert(ThreadLocal::host_context != 0);
-
 	ThreadLocal::current_thread = ThreadLocal::current_host_thread;
 	ThreadLocal::current_host_thread = 0;
 
+#ifdef REALM_USE_FAST_USER_SWITCH
+	if(switch_from->fast_switch) {
+	  assert(ThreadLocal::host_fast_sp != 0);
+	  realm_uthread_swap(&switch_from->fast_sp, *ThreadLocal::host_fast_sp);
+	} else
+#endif
+	{
+	  assert(ThreadLocal::host_context != 0);
 #ifndef NDEBUG
-	int ret =
+	  int ret =
 #endif
-	  swapcontext(&switch_from->ctx, ThreadLocal::host_context);
-	assert(ret == 0);
+	    swapcontext(&switch_from->ctx, ThreadLocal::host_context);
+	  assert(ret == 0);
+	}
 
 	// if we get control back
 	assert(switch_from->running == false);
@@ -1606,6 +1826,10 @@ namespace Realm {
       desired_events.push_back(PAPI_BR_TKN);
       desired_events.push_back(PAPI_BR_MSP);
     }
+    if(pmc.wants_measurement<ProfilingMeasurements::StallPerfCounters>()) {
+      desired_events.push_back(PAPI_RES_STL);
+      desired_events.push_back(PAPI_STL_ICY);
+    }
 
     // exit early if none present
     if(desired_events.empty()) return 0;
@@ -1762,6 +1986,14 @@ namespace Realm {
       if(found_count > 0)
 	pmc.add_measurement(ctrs);
     }
+    if(pmc.wants_measurement<ProfilingMeasurements::StallPerfCounters>()) {
+      ProfilingMeasurements::StallPerfCounters ctrs;
+      int found_count = 0;
+      ctrs.stalled_cycles  = get_counter_val(PAPI_RES_STL, event_codes, event_counts, found_count);
+      ctrs.no_issue_cycles = get_counter_val(PAPI_STL_ICY, event_codes, event_counts, found_count);
+      if(found_count > 0)
+	pmc.add_measurement(ctrs);
+    }
 
 #ifdef REALM_PAPI_DEBUG
     for(std::map<int, size_t>::const_iterator it = event_codes.begin();
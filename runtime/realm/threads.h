@@ -303,6 +303,8 @@ namespace Realm {
   //  all) it intends to use the integer, floating-point, and load/store datapaths of the core(s).
   //  A reservation with EXCLUSIVE use is compatible with those expecting MINIMAL use of the
   //  same datapath, but not with any other reservation desiring EXCLUSIVE or SHARED access.
+  // A reservation that doesn't require a particular domain may still name a preferred one - its
+  //  cores come from that domain whenever possible, but any domain will do if it doesn't fit.
   class CoreReservationParameters {
   public:
     enum CoreUsage { CORE_USAGE_NONE,
@@ -316,6 +318,7 @@ namespace Realm {
 
     WithDefault<int, 1>                        num_cores;   // how many cores are requested
     WithDefault<int, NUMA_DOMAIN_DONTCARE>     numa_domain; // which NUMA domain the cores should come from
+    WithDefault<int, NUMA_DOMAIN_DONTCARE>     preferred_numa_domain; // soft version of the above
     WithDefault<CoreUsage, CORE_USAGE_SHARED>  alu_usage;   // "integer" datapath usage
     WithDefault<CoreUsage, CORE_USAGE_MINIMAL> fpu_usage;   // floating-point usage
     WithDefault<CoreUsage, CORE_USAGE_SHARED>  ldst_usage;  // "memory" datapath usage
@@ -326,6 +329,7 @@ namespace Realm {
 
     CoreReservationParameters& set_num_cores(int new_num_cores);
     CoreReservationParameters& set_numa_domain(int new_numa_domain);
+    CoreReservationParameters& set_preferred_numa_domain(int new_preferred_numa_domain);
     CoreReservationParameters& set_alu_usage(CoreUsage new_alu_usage);
     CoreReservationParameters& set_fpu_usage(CoreUsage new_fpu_usage);
     CoreReservationParameters& set_ldst_usage(CoreUsage new_ldst_usage);
@@ -419,6 +423,10 @@ namespace Realm {
 
     void add_reservation(CoreReservation& rsrv);
 
+    // reservations that name neither a required nor a preferred NUMA domain will
+    //  prefer this one (e.g. to keep runtime threads near the processors they serve)
+    void set_default_preferred_numa_domain(int domain);
+
     // if 'dummy_reservation_ok' is set, a failed reservation will be "satisfied" with
     //  one that uses dummy (i.e. no assign cores) reservations
     bool satisfy_reservations(bool dummy_reservation_ok = false);
@@ -428,6 +436,7 @@ namespace Realm {
   protected:
     bool owns_coremap;
     const CoreMap *cm;
+    int default_preferred_domain;
     std::map<CoreReservation *, CoreReservation::Allocation *> allocations;
   };
 
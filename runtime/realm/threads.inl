@@ -384,6 +384,12 @@ namespace Realm {
     return *this;
   }
 
+  inline CoreReservationParameters& CoreReservationParameters::set_preferred_numa_domain(int new_preferred_numa_domain)
+  {
+    this->preferred_numa_domain = new_preferred_numa_domain;
+    return *this;
+  }
+
   inline CoreReservationParameters& CoreReservationParameters::set_alu_usage(CoreUsage new_alu_usage)
   {
     this->alu_usage = new_alu_usage;
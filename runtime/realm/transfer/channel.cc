@@ -17,6 +17,11 @@
 #include "channel.h"
 #include "channel_disk.h"
 #include "logger_message_descriptor.h"
+#include "realm/timers.h"
+#include <limits.h>
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#endif
 
 namespace LegionRuntime {
   namespace LowLevel {
@@ -41,7 +46,166 @@ namespace LegionRuntime {
         return (nbytes > 0) && (start / buf_size < (start + nbytes - 1) / buf_size);
       }
 
+      // strided element copies for 2D requests whose lines are a single
+      //  small field (e.g. AOS<->SOA transposes), picked per request in
+      //  MemcpyXferDes::get_requests - a null kernel means a memcpy per line
+      template <typename T>
+      static void strided_copy(char *dst, const char *src, size_t nlines,
+                               off_t dst_str, off_t src_str)
+      {
+        for (size_t i = 0; i < nlines; i++) {
+          T v;
+          memcpy(&v, src, sizeof(T));
+          memcpy(dst, &v, sizeof(T));
+          src += src_str;
+          dst += dst_str;
+        }
+      }
+
+      struct Bytes16 { uint64_t lo, hi; };
+
+#if defined(__x86_64__) && defined(__GNUC__)
+      // gathers from a strided source into a packed destination, and
+      //  scatters a packed source into a strided destination - built with
+      //  target attributes so they're available whenever the cpu has the
+      //  instructions, regardless of the compile flags
+      __attribute__((target("avx2")))
+      static void gather_copy4_avx2(char *dst, const char *src, size_t nlines,
+                                    off_t dst_str, off_t src_str)
+      {
+        const __m256i vindex = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                                                  _mm256_set1_epi32((int)src_str));
+        size_t i = 0;
+        for (; i + 8 <= nlines; i += 8) {
+          __m256i v = _mm256_i32gather_epi32((const int *)src, vindex, 1);
+          _mm256_storeu_si256((__m256i *)dst, v);
+          src += 8 * src_str;
+          dst += 32;
+        }
+        strided_copy<uint32_t>(dst, src, nlines - i, dst_str, src_str);
+      }
+
+      __attribute__((target("avx2")))
+      static void gather_copy8_avx2(char *dst, const char *src, size_t nlines,
+                                    off_t dst_str, off_t src_str)
+      {
+        const __m128i vindex = _mm_mullo_epi32(_mm_setr_epi32(0, 1, 2, 3),
+                                               _mm_set1_epi32((int)src_str));
+        size_t i = 0;
+        for (; i + 4 <= nlines; i += 4) {
+          __m256i v = _mm256_i32gather_epi64((const long long *)src, vindex, 1);
+          _mm256_storeu_si256((__m256i *)dst, v);
+          src += 4 * src_str;
+          dst += 32;
+        }
+        strided_copy<uint64_t>(dst, src, nlines - i, dst_str, src_str);
+      }
+
+      __attribute__((target("avx512f")))
+      static void gather_copy4_avx512(char *dst, const char *src, size_t nlines,
+                                      off_t dst_str, off_t src_str)
+      {
+        const __m512i vindex = _mm512_mullo_epi32(_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7,
+                                                                    8, 9, 10, 11, 12, 13, 14, 15),
+                                                  _mm512_set1_epi32((int)src_str));
+        size_t i = 0;
+        for (; i + 16 <= nlines; i += 16) {
+          __m512i v = _mm512_i32gather_epi32(vindex, src, 1);
+          _mm512_storeu_si512(dst, v);
+          src += 16 * src_str;
+          dst += 64;
+        }
+        strided_copy<uint32_t>(dst, src, nlines - i, dst_str, src_str);
+      }
+
+      __attribute__((target("avx512f")))
+      static void gather_copy8_avx512(char *dst, const char *src, size_t nlines,
+                                      off_t dst_str, off_t src_str)
+      {
+        const __m256i vindex = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                                                  _mm256_set1_epi32((int)src_str));
+        size_t i = 0;
+        for (; i + 8 <= nlines; i += 8) {
+          __m512i v = _mm512_i32gather_epi64(vindex, src, 1);
+          _mm512_storeu_si512(dst, v);
+          src += 8 * src_str;
+          dst += 64;
+        }
+        strided_copy<uint64_t>(dst, src, nlines - i, dst_str, src_str);
+      }
+
+      __attribute__((target("avx512f")))
+      static void scatter_copy4_avx512(char *dst, const char *src, size_t nlines,
+                                       off_t dst_str, off_t src_str)
+      {
+        const __m512i vindex = _mm512_mullo_epi32(_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7,
+                                                                    8, 9, 10, 11, 12, 13, 14, 15),
+                                                  _mm512_set1_epi32((int)dst_str));
+        size_t i = 0;
+        for (; i + 16 <= nlines; i += 16) {
+          __m512i v = _mm512_loadu_si512(src);
+          _mm512_i32scatter_epi32(dst, vindex, v, 1);
+          src += 64;
+          dst += 16 * dst_str;
+        }
+        strided_copy<uint32_t>(dst, src, nlines - i, dst_str, src_str);
+      }
+
+      __attribute__((target("avx512f")))
+      static void scatter_copy8_avx512(char *dst, const char *src, size_t nlines,
+                                       off_t dst_str, off_t src_str)
+      {
+        const __m256i vindex = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                                                  _mm256_set1_epi32((int)dst_str));
+        size_t i = 0;
+        for (; i + 8 <= nlines; i += 8) {
+          __m512i v = _mm512_loadu_si512(src);
+          _mm512_i32scatter_epi64(dst, vindex, v, 1);
+          src += 64;
+          dst += 8 * dst_str;
+        }
+        strided_copy<uint64_t>(dst, src, nlines - i, dst_str, src_str);
+      }
+#endif
+
+      static StridedCopyKernel select_copy_kernel(size_t nbytes,
+                                                  off_t src_str, off_t dst_str)
+      {
+#if defined(__x86_64__) && defined(__GNUC__)
+        // vector indices are 32-bit offsets from the base of each group
+        bool src_gatherable = (dst_str == (off_t)nbytes) && (src_str > 0) &&
+                              (src_str <= (INT_MAX / 16));
+        bool dst_scatterable = (src_str == (off_t)nbytes) && (dst_str > 0) &&
+                               (dst_str <= (INT_MAX / 16));
+        if ((nbytes == 4) || (nbytes == 8)) {
+          static bool has_avx512 = __builtin_cpu_supports("avx512f");
+          static bool has_avx2 = __builtin_cpu_supports("avx2");
+          if (src_gatherable && has_avx512)
+            return (nbytes == 4) ? gather_copy4_avx512 : gather_copy8_avx512;
+          if (dst_scatterable && has_avx512)
+            return (nbytes == 4) ? scatter_copy4_avx512 : scatter_copy8_avx512;
+          if (src_gatherable && has_avx2)
+            return (nbytes == 4) ? gather_copy4_avx2 : gather_copy8_avx2;
+        }
+#endif
+        // everything else (including NEON, which has no gather/scatter)
+        //  gets a fixed-size loop the compiler can keep in registers
+        switch (nbytes) {
+          case 1: return strided_copy<uint8_t>;
+          case 2: return strided_copy<uint16_t>;
+          case 4: return strided_copy<uint32_t>;
+          case 8: return strided_copy<uint64_t>;
+          case 16: return strided_copy<Bytes16>;
+          default: return 0;
+        }
+      }
+
       void XferDes::mark_completed() {
+        if (src_buf.is_ib || dst_buf.is_ib)
+          log_new_dma.info("xd stalls: guid(%llx) kind(%d) bytes(%llu)"
+                           " upstream(%lld ns) downstream(%lld ns)",
+                           guid, kind, (unsigned long long)bytes_total,
+                           stall_upstream_ns, stall_downstream_ns);
         // notify owning DmaRequest upon completion of this XferDes
         //printf("complete XD = %lu\n", guid);
         if (launch_node == gasnet_mynode()) {
@@ -73,6 +237,25 @@ namespace LegionRuntime {
         return offset;
       }
 
+      void XferDes::update_stall_time(long nr_generated, StallReason reason)
+      {
+        if (nr_generated > 0) {
+          // end of a stall (if we were in one)
+          if (stall_reason != STALL_NONE) {
+            long long elapsed = (Realm::Clock::current_time_in_nanoseconds()
+                                 - stall_start);
+            if (stall_reason == STALL_UPSTREAM)
+              stall_upstream_ns += elapsed;
+            else
+              stall_downstream_ns += elapsed;
+            stall_reason = STALL_NONE;
+          }
+        } else if ((reason != STALL_NONE) && (stall_reason == STALL_NONE)) {
+          stall_reason = reason;
+          stall_start = Realm::Clock::current_time_in_nanoseconds();
+        }
+      }
+
 #define MAX_GEN_REQS 3
 
       bool support_2d_xfers(XferDes::XferKind kind)
@@ -99,6 +282,7 @@ namespace LegionRuntime {
         long idx = 0;
         coord_t src_idx, dst_idx, todo, src_str, dst_str;
         size_t nitems, nlines;
+        StallReason reason = STALL_NONE;
         while (idx + MAX_GEN_REQS <= nr && offset_idx < oas_vec.size()
         && MAX_GEN_REQS <= available_reqs.size()) {
           if (DIM == 0) {
@@ -116,7 +300,22 @@ namespace LegionRuntime {
                                - src_idx % src_buf.block_size;
           coord_t dst_in_block = dst_buf.block_size
                                - dst_idx % dst_buf.block_size;
-          todo = min(todo, min(src_in_block, dst_in_block));
+          // an element-interleaved (AOS) side has a block size of one,
+          //  which would limit every request to a single element - for
+          //  local copies a contiguous run of elements becomes a single
+          //  strided request instead
+          bool strided_run = (kind == XferDes::XFER_MEM_CPY)
+                             && !src_buf.is_ib && !dst_buf.is_ib
+                             && ((src_buf.block_size == 1) ||
+                                 (dst_buf.block_size == 1));
+          if (strided_run) {
+            todo = min(todo, (coord_t)nitems);
+            if (src_buf.block_size > 1)
+              todo = min(todo, src_in_block);
+            if (dst_buf.block_size > 1)
+              todo = min(todo, dst_in_block);
+          } else
+            todo = min(todo, min(src_in_block, dst_in_block));
           if (todo == 0)
             break;
           coord_t src_start, dst_start;
@@ -130,6 +329,8 @@ namespace LegionRuntime {
                                         domain.get_volume(), src_idx);
             todo = min(todo, max(0, pre_bytes_write - src_start)
                                     / oas_vec[offset_idx].size);
+            if (todo == 0)
+              reason = STALL_UPSTREAM;
 	    // wrap src_start around within src_buf if needed
 	    src_start %= src_buf.buf_size;
           } else {
@@ -149,6 +350,8 @@ namespace LegionRuntime {
                                         domain.get_volume(), dst_idx);
             todo = min(todo, max(0, next_bytes_read + dst_buf.buf_size - dst_start)
                                     / oas_vec[offset_idx].size);
+            if ((todo == 0) && (reason == STALL_NONE))
+              reason = STALL_DOWNSTREAM;
 	    // wrap dst_start around within dst_buf if needed
 	    dst_start %= dst_buf.buf_size;
           } else {
@@ -160,65 +363,90 @@ namespace LegionRuntime {
           }
           if (todo == 0)
             break;
-          bool cross_src_ib = false, cross_dst_ib = false;
-          if (src_buf.is_ib)
-            cross_src_ib = cross_ib(src_start,
-                                    todo * oas_vec[offset_idx].size,
-                                    src_buf.buf_size);
-          if (dst_buf.is_ib)
-            cross_dst_ib = cross_ib(dst_start,
-                                    todo * oas_vec[offset_idx].size,
-                                    dst_buf.buf_size);
-          // We are crossing ib, fallback to 1d case
-          // We don't support 2D, fallback to 1d case
-          if (cross_src_ib || cross_dst_ib || !support_2d_xfers(kind))
-            todo = min(todo, nitems);
-          if ((size_t)todo <= nitems) {
-            // fallback to 1d case
-            nitems = (size_t)todo;
-            nlines = 1;
-          } else {
-            nlines = todo / nitems;
-            todo = nlines * nitems;
-          }
-          if (nlines == 1) {
-            // 1D case
-            size_t nbytes = todo * oas_vec[offset_idx].size;
-            while (nbytes > 0) {
-              size_t req_size = nbytes;
-              Request* new_req = dequeue_request();
+          if (strided_run) {
+            size_t field_size = oas_vec[offset_idx].size;
+            off_t src_elmt_str = ((src_buf.block_size == 1) ?
+                                  src_buf.elmt_size : field_size);
+            off_t dst_elmt_str = ((dst_buf.block_size == 1) ?
+                                  dst_buf.elmt_size : field_size);
+            Request* new_req = dequeue_request();
+            new_req->src_off = src_start;
+            new_req->dst_off = dst_start;
+            if (((size_t)src_elmt_str == field_size) &&
+                ((size_t)dst_elmt_str == field_size)) {
+              // both sides turned out to be packed
               new_req->dim = Request::DIM_1D;
-              if (src_buf.is_ib) {
-                src_start = src_start % src_buf.buf_size;
-                req_size = umin(req_size, src_buf.buf_size - src_start);
-              }
-              if (dst_buf.is_ib) {
-                dst_start = dst_start % dst_buf.buf_size;
-                req_size = umin(req_size, dst_buf.buf_size - dst_start);
+              new_req->nbytes = todo * field_size;
+              new_req->nlines = 1;
+            } else {
+              new_req->dim = Request::DIM_2D;
+              new_req->src_str = src_elmt_str;
+              new_req->dst_str = dst_elmt_str;
+              new_req->nbytes = field_size;
+              new_req->nlines = todo;
+            }
+            reqs[idx++] = new_req;
+          } else {
+            bool cross_src_ib = false, cross_dst_ib = false;
+            if (src_buf.is_ib)
+              cross_src_ib = cross_ib(src_start,
+                                      todo * oas_vec[offset_idx].size,
+                                      src_buf.buf_size);
+            if (dst_buf.is_ib)
+              cross_dst_ib = cross_ib(dst_start,
+                                      todo * oas_vec[offset_idx].size,
+                                      dst_buf.buf_size);
+            // We are crossing ib, fallback to 1d case
+            // We don't support 2D, fallback to 1d case
+            if (cross_src_ib || cross_dst_ib || !support_2d_xfers(kind))
+              todo = min(todo, nitems);
+            if ((size_t)todo <= nitems) {
+              // fallback to 1d case
+              nitems = (size_t)todo;
+              nlines = 1;
+            } else {
+              nlines = todo / nitems;
+              todo = nlines * nitems;
+            }
+            if (nlines == 1) {
+              // 1D case
+              size_t nbytes = todo * oas_vec[offset_idx].size;
+              while (nbytes > 0) {
+                size_t req_size = nbytes;
+                Request* new_req = dequeue_request();
+                new_req->dim = Request::DIM_1D;
+                if (src_buf.is_ib) {
+                  src_start = src_start % src_buf.buf_size;
+                  req_size = umin(req_size, src_buf.buf_size - src_start);
+                }
+                if (dst_buf.is_ib) {
+                  dst_start = dst_start % dst_buf.buf_size;
+                  req_size = umin(req_size, dst_buf.buf_size - dst_start);
+                }
+                new_req->src_off = src_start;
+                new_req->dst_off = dst_start;
+                new_req->nbytes = req_size;
+                new_req->nlines = 1;
+                log_request.info("[1D] guid(%llx) src_off(%lld) dst_off(%lld)"
+                                 " nbytes(%zu) offset_idx(%u)",
+                                 guid, src_start, dst_start, req_size, offset_idx);
+                reqs[idx++] = new_req;
+                nbytes -= req_size;
+                src_start += req_size;
+                dst_start += req_size;
               }
+            } else {
+              // 2D case
+              Request* new_req = dequeue_request();
+              new_req->dim = Request::DIM_2D;
               new_req->src_off = src_start;
               new_req->dst_off = dst_start;
-              new_req->nbytes = req_size;
-              new_req->nlines = 1;
-              log_request.info("[1D] guid(%llx) src_off(%lld) dst_off(%lld)"
-                               " nbytes(%zu) offset_idx(%u)",
-                               guid, src_start, dst_start, req_size, offset_idx);
+              new_req->src_str = src_str * oas_vec[offset_idx].size;
+              new_req->dst_str = dst_str * oas_vec[offset_idx].size;
+              new_req->nbytes = nitems * oas_vec[offset_idx].size;
+              new_req->nlines = nlines;
               reqs[idx++] = new_req;
-              nbytes -= req_size;
-              src_start += req_size;
-              dst_start += req_size;
             }
-          } else {
-            // 2D case
-            Request* new_req = dequeue_request();
-            new_req->dim = Request::DIM_2D;
-            new_req->src_off = src_start;
-            new_req->dst_off = dst_start;
-            new_req->src_str = src_str * oas_vec[offset_idx].size;
-            new_req->dst_str = dst_str * oas_vec[offset_idx].size;
-            new_req->nbytes = nitems * oas_vec[offset_idx].size;
-            new_req->nlines = nlines;
-            reqs[idx++] = new_req;
           }
           if (DIM == 0) {
             me->move(todo);
@@ -234,6 +462,8 @@ namespace LegionRuntime {
             }
           }
         } // while
+        if (src_buf.is_ib || dst_buf.is_ib)
+          update_stall_time(idx, reason);
         return idx;
       }
 
@@ -351,17 +581,147 @@ namespace LegionRuntime {
           memcpy_reqs[i].xd = this;
           enqueue_request(&memcpy_reqs[i]);
         }
+        // a sparse copy between an instance and an intermediate buffer
+        //  packs each field's elements back to back in the buffer, so a
+        //  single request can gather (or scatter) many runs of the instance
+        //  as long as no element straddles the end of the circular buffer
+        const Buffer& ib_buf = (_src_buf.is_ib ? _src_buf : _dst_buf);
+        packed_runs = ((DIM == 0) && (_src_buf.is_ib != _dst_buf.is_ib) &&
+                       (ib_buf.block_size == (size_t)domain.get_volume()));
+        for (unsigned i = 0; packed_runs && (i < oas_vec.size()); i++) {
+          size_t field_size = oas_vec[i].size;
+          off_t field_start = (_src_buf.is_ib ? oas_vec[i].src_offset :
+                                                oas_vec[i].dst_offset);
+          if (((ib_buf.buf_size % field_size) != 0) ||
+              (((field_start * ib_buf.block_size) % field_size) != 0))
+            packed_runs = false;
+        }
+        memcpy_runs = 0;
+        if (packed_runs)
+          memcpy_runs = (MemcpyRun*) calloc(max_nr * MAX_RUNS_PER_REQUEST,
+                                            sizeof(MemcpyRun));
+      }
+
+      template<unsigned DIM>
+      long MemcpyXferDes<DIM>::get_packed_requests(MemcpyRequest** reqs, long nr)
+      {
+        bool gather = dst_buf.is_ib;
+        const Buffer& ib_buf = (gather ? dst_buf : src_buf);
+        const Buffer& inst_buf = (gather ? src_buf : dst_buf);
+        long idx = 0;
+        StallReason reason = STALL_NONE;
+        while (idx < nr && offset_idx < oas_vec.size() && !available_reqs.empty()) {
+          size_t field_size = oas_vec[offset_idx].size;
+          off_t ib_field = (gather ? oas_vec[offset_idx].dst_offset :
+                                     oas_vec[offset_idx].src_offset);
+          off_t inst_field = (gather ? oas_vec[offset_idx].src_offset :
+                                       oas_vec[offset_idx].dst_offset);
+          MemcpyRequest* req = 0;
+          coord_t packed_start = 0;
+          size_t packed_bytes = 0;
+          while (true) {
+            coord_t src_idx, dst_idx;
+            coord_t todo = me->continuous_steps(src_idx, dst_idx);
+            coord_t ib_idx = (gather ? dst_idx : src_idx);
+            coord_t inst_idx = (gather ? src_idx : dst_idx);
+            todo = min(todo, (coord_t)(inst_buf.block_size
+                                       - inst_idx % inst_buf.block_size));
+            coord_t ib_start = calc_mem_loc_ib(0, ib_field, field_size,
+                                               ib_buf.elmt_size,
+                                               ib_buf.block_size,
+                                               ib_buf.buf_size,
+                                               domain.get_volume(), ib_idx);
+            coord_t room;
+            if (gather)
+              room = max(0, next_bytes_read + ib_buf.buf_size - ib_start)
+                     / field_size;
+            else
+              room = max(0, pre_bytes_write - ib_start) / field_size;
+            if ((room == 0) && (req == 0))
+              reason = (gather ? STALL_DOWNSTREAM : STALL_UPSTREAM);
+            todo = min(todo, room);
+            ib_start %= ib_buf.buf_size;
+            // the packed side of a request is contiguous, so it ends where
+            //  the intermediate buffer wraps around
+            if ((req != 0) && (ib_start != packed_start + (coord_t)packed_bytes))
+              break;
+            todo = min(todo, (coord_t)((ib_buf.buf_size - ib_start) / field_size));
+            todo = min(todo, (coord_t)((max_req_size - packed_bytes) / field_size));
+            if (todo <= 0)
+              break;
+            off_t inst_start = calc_mem_loc(0, inst_field, field_size,
+                                            inst_buf.elmt_size,
+                                            inst_buf.block_size, inst_idx);
+            if (req == 0) {
+              req = (MemcpyRequest*) dequeue_request();
+              req->runs = memcpy_runs + (req - memcpy_reqs) * MAX_RUNS_PER_REQUEST;
+              req->nruns = 0;
+              packed_start = ib_start;
+            }
+            size_t run_bytes = todo * field_size;
+            MemcpyRun* last = ((req->nruns > 0) ? &req->runs[req->nruns - 1] : 0);
+            if ((last != 0) && ((off_t)(last->offset + last->nbytes) == inst_start))
+              last->nbytes += run_bytes;
+            else {
+              req->runs[req->nruns].offset = inst_start;
+              req->runs[req->nruns].nbytes = run_bytes;
+              req->nruns++;
+            }
+            packed_bytes += run_bytes;
+            me->move(todo);
+            if (!me->any_left()) {
+              me->reset();
+              offset_idx++;
+              break;
+            }
+            if (req->nruns == MAX_RUNS_PER_REQUEST)
+              break;
+          }
+          if (req == 0)
+            break;
+          req->dim = Request::DIM_1D;
+          req->nbytes = packed_bytes;
+          req->nlines = 1;
+          req->copy_kernel = 0;
+          req->gather = gather;
+          if (gather) {
+            req->src_off = req->runs[0].offset;
+            req->dst_off = packed_start;
+            req->src_base = (char*)src_buf_base;
+            req->dst_base = (char*)(dst_buf_base + packed_start);
+          } else {
+            req->src_off = packed_start;
+            req->dst_off = req->runs[0].offset;
+            req->src_base = (char*)(src_buf_base + packed_start);
+            req->dst_base = (char*)dst_buf_base;
+          }
+          log_request.info("[gather/scatter] guid(%llx) packed_off(%lld)"
+                           " nbytes(%zu) nruns(%zu) offset_idx(%u)",
+                           guid, packed_start, packed_bytes, req->nruns,
+                           offset_idx);
+          reqs[idx++] = req;
+        }
+        update_stall_time(idx, reason);
+        return idx;
       }
 
       template<unsigned DIM>
       long MemcpyXferDes<DIM>::get_requests(Request** requests, long nr)
       {
         MemcpyRequest** reqs = (MemcpyRequest**) requests;
+        if (packed_runs)
+          return get_packed_requests(reqs, nr);
         long new_nr = default_get_requests<DIM>(requests, nr);
         for (long i = 0; i < new_nr; i++)
         {
+          reqs[i]->nruns = 0;
           reqs[i]->src_base = (char*)(src_buf_base + reqs[i]->src_off);
           reqs[i]->dst_base = (char*)(dst_buf_base + reqs[i]->dst_off);
+          reqs[i]->copy_kernel = ((reqs[i]->dim == Request::DIM_2D) ?
+                                    select_copy_kernel(reqs[i]->nbytes,
+                                                       reqs[i]->src_str,
+                                                       reqs[i]->dst_str) :
+                                    0);
         }
         return new_nr;
 
@@ -797,6 +1157,7 @@ namespace LegionRuntime {
           default:
             assert(0);
         }
+        piece_active = false;
         hdf_reqs = (HDFRequest*) calloc(max_nr, sizeof(HDFRequest));
         for (int i = 0; i < max_nr; i++) {
           hdf_reqs[i].xd = this;
@@ -805,111 +1166,113 @@ namespace LegionRuntime {
         }
      }
 
+      template<unsigned DIM>
+      const std::vector<hsize_t>& HDFXferDes<DIM>::get_chunk_dims(off_t hdf_ofs)
+      {
+        std::map<off_t, std::vector<hsize_t> >::iterator it = chunk_dims.find(hdf_ofs);
+        if (it != chunk_dims.end())
+          return it->second;
+        std::vector<hsize_t>& dims = chunk_dims[hdf_ofs];
+        dims.resize(DIM, 0);
+        hid_t dcpl_id = H5Dget_create_plist(hdf_metadata->dataset_ids[hdf_ofs]);
+        if (H5Pget_layout(dcpl_id) == H5D_CHUNKED) {
+          int ndims = H5Pget_chunk(dcpl_id, DIM, &dims[0]);
+          assert(ndims == (int)DIM);
+        }
+        H5Pclose(dcpl_id);
+        return dims;
+      }
+
       template<unsigned DIM>
       long HDFXferDes<DIM>::get_requests(Request** requests, long nr)
       {
+        // the I/O threads may be in the middle of a read or write - rather
+        //  than wait for it, try again on the next pass
+        if (!HDFChannel::try_lock_api())
+          return 0;
+        bool is_read = (kind == XferDes::XFER_HDF_READ);
+        assert(is_read || (kind == XferDes::XFER_HDF_WRITE));
+        // the side of the transfer that is in memory
+        const Buffer& mem_buf = is_read ? dst_buf : src_buf;
         long ns = 0;
         while (ns < nr && !available_reqs.empty() && fit != oas_vec.end()) {
           requests[ns] = dequeue_request();
-          switch (kind) {
-            case XferDes::XFER_HDF_READ:
-            {
-              off_t hdf_ofs = fit->src_offset;
-              assert(hdf_metadata->dataset_ids.count(hdf_ofs) > 0);
-              //pthread_rwlock_rdlock(&hdf_metadata->hdf_memory->rwlock);
-              size_t elemnt_size = H5Tget_size(hdf_metadata->datatype_ids[hdf_ofs]);
-              HDFRequest* hdf_req = (HDFRequest*) requests[ns];
-              hdf_req->dataset_id = hdf_metadata->dataset_ids[hdf_ofs];
-              //hdf_req->rwlock = &hdf_metadata->dataset_rwlocks[hdf_idx];
-              hdf_req->mem_type_id = hdf_metadata->datatype_ids[hdf_ofs];
-              hsize_t count[DIM], ms_start[DIM], ds_start[DIM], ms_dims[DIM];
-              // assume SOA for now
-              assert(dst_buf.block_size >= lsi->image_lo[0] + domain.get_volume());
-              assert(lsi->strides[0][0] == 1);
-              ms_dims[DIM - 1] = lsi->strides[1][0];
-              for (unsigned i = 1; i < DIM - 1; i++)
-                ms_dims[DIM - 1 - i] = lsi->strides[i+1][0] / lsi->strides[i][0];
-              ms_dims[0] = lsi->subrect.hi[DIM - 1] - lsi->subrect.lo[DIM - 1] + 1;
-              size_t todo = 1;
-              for (unsigned i = 0; i < DIM; i++) {
-                ms_start[i] = 0;
-                count[i] = lsi->subrect.hi[DIM - 1 - i] - lsi->subrect.lo[DIM - 1 - i] + 1;
-                todo *= count[i];
-                ds_start[i] = lsi->subrect.lo[DIM - 1 - i] - hdf_metadata->lo[DIM - 1 - i];
-              }
-              hdf_req->file_space_id = H5Dget_space(hdf_metadata->dataset_ids[hdf_ofs]);
-              // HDF dimension always start with zero, but Legion::Domain may start with any integer
-              // We need to deal with the offset between them here
-              herr_t ret = H5Sselect_hyperslab(hdf_req->file_space_id, H5S_SELECT_SET, ds_start, NULL, count, NULL);
-              assert(ret >= 0);
-              //pthread_rwlock_unlock(&hdf_metadata->hdf_memory->rwlock);
-              //pthread_rwlock_wrlock(&hdf_metadata->hdf_memory->rwlock);
-              hdf_req->mem_space_id = H5Screate_simple(DIM, ms_dims, NULL);
-              ret = H5Sselect_hyperslab(hdf_req->mem_space_id, H5S_SELECT_SET, ms_start, NULL, count, NULL);
-              assert(ret >= 0);
-              //pthread_rwlock_unlock(&hdf_metadata->hdf_memory->rwlock);
-              off_t dst_offset = calc_mem_loc(0, fit->dst_offset, fit->size,
-                                              dst_buf.elmt_size, dst_buf.block_size, lsi->image_lo[0]);
-              hdf_req->mem_base = buf_base + dst_offset;
-              hdf_req->nbytes = todo * elemnt_size;
-              break;
+          off_t hdf_ofs = is_read ? fit->src_offset : fit->dst_offset;
+          off_t mem_ofs = is_read ? fit->dst_offset : fit->src_offset;
+          assert(hdf_metadata->dataset_ids.count(hdf_ofs) > 0);
+          size_t elemnt_size = H5Tget_size(hdf_metadata->datatype_ids[hdf_ofs]);
+          HDFRequest* hdf_req = (HDFRequest*) requests[ns];
+          hdf_req->dataset_id = hdf_metadata->dataset_ids[hdf_ofs];
+          //hdf_req->rwlock = &hdf_metadata->dataset_rwlocks[hdf_idx];
+          hdf_req->mem_type_id = hdf_metadata->datatype_ids[hdf_ofs];
+          hsize_t count[DIM], ms_start[DIM], ds_start[DIM], ms_dims[DIM];
+          hsize_t sub_lo[DIM], sub_hi[DIM];
+          // assume SOA for now
+          assert(mem_buf.block_size >= lsi->image_lo[0] + domain.get_volume());
+          assert(lsi->strides[0][0] == 1);
+          ms_dims[DIM - 1] = lsi->strides[1][0];
+          for (unsigned i = 1; i < DIM - 1; i++)
+            ms_dims[DIM - 1 - i] = lsi->strides[i+1][0] / lsi->strides[i][0];
+          ms_dims[0] = lsi->subrect.hi[DIM - 1] - lsi->subrect.lo[DIM - 1] + 1;
+          // HDF dimension always start with zero, but Legion::Domain may start with any integer
+          // We need to deal with the offset between them here
+          for (unsigned i = 0; i < DIM; i++) {
+            sub_lo[i] = lsi->subrect.lo[DIM - 1 - i] - hdf_metadata->lo[DIM - 1 - i];
+            sub_hi[i] = lsi->subrect.hi[DIM - 1 - i] - hdf_metadata->lo[DIM - 1 - i] + 1;
+          }
+          if (!piece_active) {
+            for (unsigned i = 0; i < DIM; i++)
+              piece_lo[i] = sub_lo[i];
+            piece_active = true;
+          }
+          // the piece ends at the subrect's edge or the chunk's, whichever
+          //  comes first, so HDF5 never has to read a chunk twice or
+          //  decompress one only to use a sliver of it
+          const std::vector<hsize_t>& chunk = get_chunk_dims(hdf_ofs);
+          size_t todo = 1;
+          for (unsigned i = 0; i < DIM; i++) {
+            hsize_t piece_hi = sub_hi[i];
+            if (chunk[i] > 0) {
+              hsize_t chunk_hi = (piece_lo[i] / chunk[i] + 1) * chunk[i];
+              if (chunk_hi < piece_hi)
+                piece_hi = chunk_hi;
             }
-            case XferDes::XFER_HDF_WRITE:
-            {
-              off_t hdf_ofs = fit->dst_offset;
-              assert(hdf_metadata->dataset_ids.count(hdf_ofs) > 0);
-              //pthread_rwlock_rdlock(&hdf_metadata->hdf_memory->rwlock);
-              size_t elemnt_size = H5Tget_size(hdf_metadata->datatype_ids[hdf_ofs]);
-              HDFRequest* hdf_req = (HDFRequest*) requests[ns];
-              hdf_req->dataset_id = hdf_metadata->dataset_ids[hdf_ofs];
-              //hdf_req->rwlock = &hdf_metadata->dataset_rwlocks[hdf_idx];
-              hdf_req->mem_type_id = hdf_metadata->datatype_ids[hdf_ofs];
-              hsize_t count[DIM], ms_start[DIM], ds_start[DIM], ms_dims[DIM];
-              //assume SOA for now
-              assert(src_buf.block_size >= lsi->image_lo[0] + domain.get_volume());
-              assert(lsi->strides[0][0] == 1);
-              ms_dims[DIM - 1] = lsi->strides[1][0];
-              for (unsigned i = 1; i < DIM - 1; i++)
-                ms_dims[DIM - 1 - i] = lsi->strides[i+1][0] / lsi->strides[i][0];
-              ms_dims[0] = lsi->subrect.hi[DIM - 1] - lsi->subrect.lo[DIM - 1] + 1;
-              size_t todo = 1;
-              for (unsigned i = 0; i < DIM; i++) {
-                ms_start[i] = 0;
-                count[i] = lsi->subrect.hi[DIM - 1 - i] - lsi->subrect.lo[DIM - 1 - i] + 1;
-                todo *= count[i];
-                ds_start[i] = lsi->subrect.lo[DIM - 1 - i] - hdf_metadata->lo[DIM - 1 - i];
-              }
-              hdf_req->file_space_id = H5Dget_space(hdf_metadata->dataset_ids[hdf_ofs]);
-              // HDF dimension always start with zero, but Legion::Domain may start with any integer
-              // We need to deal with the offset between them here
-              herr_t ret = H5Sselect_hyperslab(hdf_req->file_space_id, H5S_SELECT_SET, ds_start, NULL, count, NULL);
-              assert(ret >= 0);
-              //pthread_rwlock_unlock(&hdf_metadata->hdf_memory->rwlock);
-              //pthread_rwlock_wrlock(&hdf_metadata->hdf_memory->rwlock);
-              hdf_req->mem_space_id = H5Screate_simple(DIM, ms_dims, NULL);
-              ret = H5Sselect_hyperslab(hdf_req->mem_space_id, H5S_SELECT_SET, ms_start, NULL, count, NULL);
-              assert(ret >= 0);
-              //pthread_rwlock_unlock(&hdf_metadata->hdf_memory->rwlock);
-              off_t src_offset = calc_mem_loc(0, fit->src_offset, fit->size,
-                                              src_buf.elmt_size, src_buf.block_size, lsi->image_lo[0]);
-              hdf_req->mem_base = buf_base + src_offset;
-              hdf_req->nbytes = todo * elemnt_size;
+            ds_start[i] = piece_lo[i];
+            ms_start[i] = piece_lo[i] - sub_lo[i];
+            count[i] = piece_hi - piece_lo[i];
+            todo *= count[i];
+          }
+          hdf_req->file_space_id = H5Dget_space(hdf_metadata->dataset_ids[hdf_ofs]);
+          herr_t ret = H5Sselect_hyperslab(hdf_req->file_space_id, H5S_SELECT_SET, ds_start, NULL, count, NULL);
+          assert(ret >= 0);
+          hdf_req->mem_space_id = H5Screate_simple(DIM, ms_dims, NULL);
+          ret = H5Sselect_hyperslab(hdf_req->mem_space_id, H5S_SELECT_SET, ms_start, NULL, count, NULL);
+          assert(ret >= 0);
+          off_t mem_offset = calc_mem_loc(0, mem_ofs, fit->size,
+                                          mem_buf.elmt_size, mem_buf.block_size, lsi->image_lo[0]);
+          hdf_req->mem_base = buf_base + mem_offset;
+          hdf_req->nbytes = todo * elemnt_size;
+          // advance to the next piece, fastest-varying HDF dimension first
+          piece_active = false;
+          for (int i = DIM - 1; i >= 0; i--) {
+            piece_lo[i] += count[i];
+            if (piece_lo[i] < sub_hi[i]) {
+              piece_active = true;
               break;
             }
-            default:
-              assert(0);
+            piece_lo[i] = sub_lo[i];
           }
-          lsi->step();
-          if (!lsi->any_left) {
-            fit++;
-            delete lsi;
-            if (kind == XferDes::XFER_HDF_READ)
-              lsi = new GenericLinearSubrectIterator<Mapping<DIM, 1> >(domain.get_rect<DIM>(), (*dst_buf.linearization.get_mapping<DIM>()));
-            else
-              lsi = new GenericLinearSubrectIterator<Mapping<DIM, 1> >(domain.get_rect<DIM>(), (*src_buf.linearization.get_mapping<DIM>()));
+          if (!piece_active) {
+            lsi->step();
+            if (!lsi->any_left) {
+              fit++;
+              delete lsi;
+              lsi = new GenericLinearSubrectIterator<Mapping<DIM, 1> >(domain.get_rect<DIM>(), (*mem_buf.linearization.get_mapping<DIM>()));
+            }
           }
           ns ++;
         }
+        HDFChannel::unlock_api();
         return ns;
       }
 
@@ -932,10 +1295,7 @@ namespace LegionRuntime {
         assert(next_xd_guid == XFERDES_NO_GUID);
         HDFRequest* hdf_req = (HDFRequest*) req;
         bytes_write += hdf_req->nbytes;
-        //pthread_rwlock_wrlock(&hdf_metadata->hdf_memory->rwlock);
-        H5Sclose(hdf_req->mem_space_id);
-        H5Sclose(hdf_req->file_space_id);
-        //pthread_rwlock_unlock(&hdf_metadata->hdf_memory->rwlock);
+        // the dataspaces were closed by the channel after the transfer
         enqueue_request(req);
       }
 
@@ -968,24 +1328,9 @@ namespace LegionRuntime {
           channel->get_request(thread_queue);
           if (channel->is_stopped)
             break;
-          std::deque<MemcpyRequest*>::const_iterator it;
-          for (it = thread_queue.begin(); it != thread_queue.end(); it++) {
-            MemcpyRequest* req = *it;
-            //double starttime = Realm::Clock::current_time_in_microseconds();
-            if (req->dim == Request::DIM_1D) {
-              memcpy(req->dst_base, req->src_base, req->nbytes);
-            } else {
-              assert(req->dim == Request::DIM_2D);
-              char *src = req->src_base, *dst = req->dst_base;
-              for (size_t i = 0; i < req->nlines; i++) {
-                memcpy(dst, src, req->nbytes);
-                src += req->src_str;
-                dst += req->dst_str;
-              }
-            }
-            //double stoptime = Realm::Clock::current_time_in_microseconds();
-            //fprintf(stderr, "t = %.2lfus, tp = %.2lfMB/s\n", stoptime - starttime, (req->nbytes / (stoptime - starttime)));
-          }
+          std::deque<MemcpyStripe>::const_iterator it;
+          for (it = thread_queue.begin(); it != thread_queue.end(); it++)
+            MemcpyChannel::copy_stripe(*it);
           channel->return_request(thread_queue);
           thread_queue.clear();
         }
@@ -1002,6 +1347,8 @@ namespace LegionRuntime {
         capacity = max_nr;
         is_stopped = false;
         sleep_threads = false;
+        num_workers = 0;
+        stripe_size = 0;
         pthread_mutex_init(&pending_lock, NULL);
         pthread_mutex_init(&finished_lock, NULL);
         pthread_cond_init(&pending_cond, NULL);
@@ -1025,7 +1372,14 @@ namespace LegionRuntime {
         pthread_mutex_unlock(&pending_lock);
       }
 
-      void MemcpyChannel::get_request(std::deque<MemcpyRequest*>& thread_queue)
+      void MemcpyChannel::enable_striping(int _num_workers, size_t _stripe_size)
+      {
+        assert(_stripe_size > 0);
+        num_workers = _num_workers;
+        stripe_size = _stripe_size;
+      }
+
+      void MemcpyChannel::get_request(std::deque<MemcpyStripe>& thread_queue)
       {
         pthread_mutex_lock(&pending_lock);
         while (pending_queue.empty() && !is_stopped) {
@@ -1033,66 +1387,140 @@ namespace LegionRuntime {
           pthread_cond_wait(&pending_cond, &pending_lock);
         }
         if (!is_stopped) {
-          // TODO: enable the following optimization
-          //thread_queue.insert(thread_queue.end(), pending_queue.begin(), pending_queue.end());
+          // one stripe at a time, so that the stripes of a request spread
+          //  over all the sleeping threads
           thread_queue.push_back(pending_queue.front());
           pending_queue.pop_front();
-          //fprintf(stderr, "[%d] thread_queue.size = %lu\n", gettid(), thread_queue.size());
-          //pending_queue.clear();
         }
         pthread_mutex_unlock(&pending_lock);
       }
 
-      void MemcpyChannel::return_request(std::deque<MemcpyRequest*>& thread_queue)
+      void MemcpyChannel::return_request(std::deque<MemcpyStripe>& thread_queue)
       {
-        pthread_mutex_lock(&finished_lock);
-        finished_queue.insert(finished_queue.end(), thread_queue.begin(), thread_queue.end());
-        pthread_mutex_unlock(&finished_lock);
+        std::deque<MemcpyStripe>::const_iterator it;
+        for (it = thread_queue.begin(); it != thread_queue.end(); it++) {
+          // whoever copies the last stripe hands the request back to the
+          //  DMA thread for completion
+          if (__sync_sub_and_fetch(&it->req->stripes_left, 1) == 0) {
+            pthread_mutex_lock(&finished_lock);
+            finished_queue.push_back(it->req);
+            pthread_mutex_unlock(&finished_lock);
+          }
+        }
       }
 
-      long MemcpyChannel::submit(Request** requests, long nr)
+      /*static*/ void MemcpyChannel::copy_stripe(const MemcpyStripe& stripe)
       {
-        MemcpyRequest** mem_cpy_reqs = (MemcpyRequest**) requests;
-        for (long i = 0; i < nr; i++) {
-          MemcpyRequest* req = mem_cpy_reqs[i];
-          if (req->dim == Request::DIM_1D) {
-            memcpy(req->dst_base, req->src_base, req->nbytes);
+        MemcpyRequest* req = stripe.req;
+        if (req->dim == Request::DIM_1D) {
+          memcpy(stripe.dst, stripe.src, stripe.nbytes);
+        } else {
+          assert(req->dim == Request::DIM_2D);
+          if (req->copy_kernel) {
+            (req->copy_kernel)(stripe.dst, stripe.src, stripe.nlines,
+                               req->dst_str, req->src_str);
           } else {
-            assert(req->dim == Request::DIM_2D);
-            char *src = req->src_base, *dst = req->dst_base;
-            for (size_t i = 0; i < req->nlines; i++) {
-              memcpy(dst, src, req->nbytes);
+            char *src = stripe.src, *dst = stripe.dst;
+            for (size_t i = 0; i < stripe.nlines; i++) {
+              memcpy(dst, src, stripe.nbytes);
               src += req->src_str;
               dst += req->dst_str;
             }
           }
-          req->xd->notify_request_read_done(req);
-          req->xd->notify_request_write_done(req);
         }
-        return nr;
-        /*
-        pthread_mutex_lock(&pending_lock);
-        //if (nr > 0)
-          //printf("MemcpyChannel::submit[nr = %ld]\n", nr);
-        for (long i = 0; i < nr; i++) {
-          pending_queue.push_back(mem_cpy_reqs[i]);
+      }
+
+      static inline void copy_run(char *dst, const char *src, size_t nbytes)
+      {
+        // single elements of common field sizes are fixed-size moves
+        switch (nbytes) {
+        case 4: memcpy(dst, src, 4); break;
+        case 8: memcpy(dst, src, 8); break;
+        case 16: memcpy(dst, src, 16); break;
+        default: memcpy(dst, src, nbytes); break;
         }
-        if (sleep_threads) {
-          pthread_cond_broadcast(&pending_cond);
-          sleep_threads = false;
+      }
+
+      /*static*/ void MemcpyChannel::copy_runs(const MemcpyRequest* req)
+      {
+        if (req->gather) {
+          char *dst = req->dst_base;
+          for (size_t i = 0; i < req->nruns; i++) {
+            copy_run(dst, req->src_base + req->runs[i].offset, req->runs[i].nbytes);
+            dst += req->runs[i].nbytes;
+          }
+        } else {
+          const char *src = req->src_base;
+          for (size_t i = 0; i < req->nruns; i++) {
+            copy_run(req->dst_base + req->runs[i].offset, src, req->runs[i].nbytes);
+            src += req->runs[i].nbytes;
+          }
         }
-        pthread_mutex_unlock(&pending_lock);
-        return nr;
-        */
-        /*
-        for (int i = 0; i < nr; i++) {
-          push_request(mem_cpy_reqs[i]);
-          memcpy(mem_cpy_reqs[i]->dst_buf, mem_cpy_reqs[i]->src_buf, mem_cpy_reqs[i]->nbytes);
-          mem_cpy_reqs[i]->xd->notify_request_read_done(mem_cpy_reqs[i]);
-          mem_cpy_reqs[i]->xd->notify_request_write_done(mem_cpy_reqs[i]);
+      }
+
+      long MemcpyChannel::submit(Request** requests, long nr)
+      {
+        MemcpyRequest** mem_cpy_reqs = (MemcpyRequest**) requests;
+        for (long i = 0; i < nr; i++) {
+          MemcpyRequest* req = mem_cpy_reqs[i];
+          if (req->nruns > 0) {
+            // gathers and scatters are many small runs - not worth striping
+            copy_runs(req);
+            req->xd->notify_request_read_done(req);
+            req->xd->notify_request_write_done(req);
+            continue;
+          }
+          MemcpyStripe whole;
+          whole.req = req;
+          whole.src = req->src_base;
+          whole.dst = req->dst_base;
+          whole.nbytes = req->nbytes;
+          whole.nlines = (req->dim == Request::DIM_1D) ? 1 : req->nlines;
+          size_t total = whole.nbytes * whole.nlines;
+          if ((num_workers == 0) || (total < 2 * stripe_size)) {
+            copy_stripe(whole);
+            req->xd->notify_request_read_done(req);
+            req->xd->notify_request_write_done(req);
+            continue;
+          }
+          // cut the request into (up to) one stripe per worker plus one for
+          //  this thread - 1D requests are cut at cache-line boundaries and
+          //  2D requests between lines
+          std::vector<MemcpyStripe> stripes;
+          size_t pieces = std::min(total / stripe_size, (size_t)num_workers + 1);
+          if (req->dim == Request::DIM_1D) {
+            size_t chunk = ((total / pieces) + 63) & ~(size_t)63;
+            for (size_t offset = 0; offset < total; offset += chunk) {
+              MemcpyStripe s = whole;
+              s.src += offset;
+              s.dst += offset;
+              s.nbytes = std::min(chunk, total - offset);
+              stripes.push_back(s);
+            }
+          } else {
+            size_t chunk = (whole.nlines + pieces - 1) / pieces;
+            for (size_t line = 0; line < whole.nlines; line += chunk) {
+              MemcpyStripe s = whole;
+              s.src += line * req->src_str;
+              s.dst += line * req->dst_str;
+              s.nlines = std::min(chunk, whole.nlines - line);
+              stripes.push_back(s);
+            }
+          }
+          req->stripes_left = stripes.size();
+          pthread_mutex_lock(&pending_lock);
+          pending_queue.insert(pending_queue.end(), stripes.begin() + 1, stripes.end());
+          if (sleep_threads) {
+            pthread_cond_broadcast(&pending_cond);
+            sleep_threads = false;
+          }
+          pthread_mutex_unlock(&pending_lock);
+          // the first stripe is ours
+          copy_stripe(stripes[0]);
+          std::deque<MemcpyStripe> mine(1, stripes[0]);
+          return_request(mine);
         }
         return nr;
-        */
       }
 
       void MemcpyChannel::pull()
@@ -1177,14 +1605,94 @@ namespace LegionRuntime {
 
       RemoteWriteChannel::~RemoteWriteChannel() {}
 
+      // zero-run encoding for remote writes: the data is treated as 8-byte
+      //  words and sent as a series of (zero words, literal words) counts,
+      //  each followed by its literal words, with any trailing bytes last -
+      //  returns 0 if the encoding would not fit in max_bytes
+      static size_t zero_run_encode(const char *src, size_t nbytes,
+                                    char *dst, size_t max_bytes)
+      {
+        size_t nwords = nbytes / 8, i = 0, out = 0;
+        while (i < nwords) {
+          uint32_t zeros = 0, literals = 0;
+          uint64_t w;
+          while ((i < nwords) && (zeros < UINT32_MAX)) {
+            memcpy(&w, src + i * 8, 8);
+            if (w != 0) break;
+            zeros++; i++;
+          }
+          size_t first = i;
+          while ((i < nwords) && (literals < UINT32_MAX)) {
+            memcpy(&w, src + i * 8, 8);
+            if (w == 0) break;
+            literals++; i++;
+          }
+          if ((out + 8 + (size_t)literals * 8) > max_bytes)
+            return 0;
+          memcpy(dst + out, &zeros, 4);
+          memcpy(dst + out + 4, &literals, 4);
+          memcpy(dst + out + 8, src + first * 8, (size_t)literals * 8);
+          out += 8 + (size_t)literals * 8;
+        }
+        size_t tail = nbytes - nwords * 8;
+        if ((out + tail) > max_bytes)
+          return 0;
+        memcpy(dst + out, src + nwords * 8, tail);
+        return out + tail;
+      }
+
+      static void zero_run_decode(const char *src, size_t len,
+                                  char *dst, size_t nbytes)
+      {
+        size_t nwords = nbytes / 8, i = 0, in = 0;
+        while (i < nwords) {
+          uint32_t zeros, literals;
+          memcpy(&zeros, src + in, 4);
+          memcpy(&literals, src + in + 4, 4);
+          in += 8;
+          assert((i + zeros + literals) <= nwords);
+          memset(dst + i * 8, 0, (size_t)zeros * 8);
+          i += zeros;
+          memcpy(dst + i * 8, src + in, (size_t)literals * 8);
+          i += literals;
+          in += (size_t)literals * 8;
+        }
+        assert((in + nbytes - nwords * 8) == len);
+        memcpy(dst + nwords * 8, src + in, nbytes - nwords * 8);
+      }
+
+      // sends a 1D remote write zero-run encoded if that pays off
+      static bool send_compressed_write(RemoteWriteRequest* req)
+      {
+        if ((Realm::Config::dma_compress_min_kb <= 0) ||
+            (req->nbytes < ((size_t)Realm::Config::dma_compress_min_kb << 10)))
+          return false;
+        size_t max_bytes = req->nbytes - (req->nbytes / 8);
+        char *data = (char *)malloc(max_bytes);
+        assert(data != 0);
+        size_t datalen = zero_run_encode(req->src_base, req->nbytes,
+                                         data, max_bytes);
+        if (datalen == 0) {
+          free(data);
+          return false;
+        }
+        log_request.info("compressed remote write: guid(%llx) %zu -> %zu bytes",
+                         req->xd->guid, req->nbytes, datalen);
+        XferDesCompressedWriteMessage::send_request(req->dst_node, req->dst_base,
+                                                    data, datalen, req->nbytes,
+                                                    req);
+        return true;
+      }
+
       long RemoteWriteChannel::submit(Request** requests, long nr)
       {
         assert(nr <= capacity);
         for (long i = 0; i < nr; i ++) {
           RemoteWriteRequest* req = (RemoteWriteRequest*) requests[i];
           if (req->dim == Request::DIM_1D) {
-            XferDesRemoteWriteMessage::send_request(
-                req->dst_node, req->dst_base, req->src_base, req->nbytes, req);
+            if (!send_compressed_write(req))
+              XferDesRemoteWriteMessage::send_request(
+                  req->dst_node, req->dst_base, req->src_base, req->nbytes, req);
           } else {
             assert(req->dim == Request::DIM_2D);
             // dest MUST be continuous
@@ -1323,40 +1831,140 @@ namespace LegionRuntime {
 #endif
 
 #ifdef USE_HDF
+      pthread_mutex_t HDFChannel::io_lock = PTHREAD_MUTEX_INITIALIZER;
+      pthread_mutex_t HDFChannel::api_lock = PTHREAD_MUTEX_INITIALIZER;
+      pthread_cond_t HDFChannel::io_cond = PTHREAD_COND_INITIALIZER;
+      std::deque<HDFRequest*> HDFChannel::io_queue;
+      bool HDFChannel::io_threads_enabled = false;
+      bool HDFChannel::io_threads_stopped = false;
+
       HDFChannel::HDFChannel(long max_nr, XferDes::XferKind _kind)
       {
         kind = _kind;
         capacity = max_nr;
+        in_flight = 0;
       }
 
       HDFChannel::~HDFChannel() {}
 
+      /*static*/ void HDFChannel::perform_request(HDFRequest* req)
+      {
+        //pthread_rwlock_rdlock(req->rwlock);
+        if (req->xd->kind == XferDes::XFER_HDF_READ)
+          H5Dread(req->dataset_id, req->mem_type_id,
+                  req->mem_space_id, req->file_space_id,
+                  H5P_DEFAULT, req->mem_base);
+        else
+          H5Dwrite(req->dataset_id, req->mem_type_id,
+                   req->mem_space_id, req->file_space_id,
+                   H5P_DEFAULT, req->mem_base);
+        //pthread_rwlock_unlock(req->rwlock);
+        H5Sclose(req->mem_space_id);
+        H5Sclose(req->file_space_id);
+      }
+
       long HDFChannel::submit(Request** requests, long nr)
       {
         HDFRequest** hdf_reqs = (HDFRequest**) requests;
-        for (long i = 0; i < nr; i++) {
-          HDFRequest* req = hdf_reqs[i];
-          //pthread_rwlock_rdlock(req->rwlock);
-          if (kind == XferDes::XFER_HDF_READ)
-            H5Dread(req->dataset_id, req->mem_type_id,
-                    req->mem_space_id, req->file_space_id,
-                    H5P_DEFAULT, req->mem_base);
-          else
-            H5Dwrite(req->dataset_id, req->mem_type_id,
-                     req->mem_space_id, req->file_space_id,
-                     H5P_DEFAULT, req->mem_base);
-          //pthread_rwlock_unlock(req->rwlock);
-          req->xd->notify_request_read_done(req);
-          req->xd->notify_request_write_done(req);
+        if (!io_threads_enabled) {
+          for (long i = 0; i < nr; i++) {
+            HDFRequest* req = hdf_reqs[i];
+            perform_request(req);
+            req->xd->notify_request_read_done(req);
+            req->xd->notify_request_write_done(req);
+          }
+          return nr;
         }
+        pthread_mutex_lock(&io_lock);
+        for (long i = 0; i < nr; i++)
+          io_queue.push_back(hdf_reqs[i]);
+        pthread_cond_broadcast(&io_cond);
+        pthread_mutex_unlock(&io_lock);
+        in_flight += nr;
         return nr;
       }
 
-      void HDFChannel::pull() {}
+      void HDFChannel::pull()
+      {
+        if (!io_threads_enabled)
+          return;
+        std::deque<HDFRequest*> finished;
+        pthread_mutex_lock(&io_lock);
+        finished.swap(finished_queue);
+        pthread_mutex_unlock(&io_lock);
+        while (!finished.empty()) {
+          HDFRequest* req = finished.front();
+          finished.pop_front();
+          req->xd->notify_request_read_done(req);
+          req->xd->notify_request_write_done(req);
+          in_flight--;
+        }
+      }
 
       long HDFChannel::available()
       {
-        return capacity;
+        return capacity - in_flight;
+      }
+
+      /*static*/ void HDFChannel::enable_io_threads(void)
+      {
+        io_threads_enabled = true;
+        io_threads_stopped = false;
+      }
+
+      /*static*/ void HDFChannel::stop_io_threads(void)
+      {
+        pthread_mutex_lock(&io_lock);
+        io_threads_stopped = true;
+        pthread_cond_broadcast(&io_cond);
+        pthread_mutex_unlock(&io_lock);
+      }
+
+      /*static*/ void HDFChannel::io_thread_loop(void)
+      {
+        pthread_mutex_lock(&io_lock);
+        while (true) {
+          while (io_queue.empty() && !io_threads_stopped)
+            pthread_cond_wait(&io_cond, &io_lock);
+          if (io_threads_stopped)
+            break;
+          HDFRequest* req = io_queue.front();
+          io_queue.pop_front();
+          pthread_mutex_unlock(&io_lock);
+          lock_api();
+          perform_request(req);
+          unlock_api();
+          pthread_mutex_lock(&io_lock);
+          ((HDFChannel*)(req->xd->channel))->finished_queue.push_back(req);
+        }
+        pthread_mutex_unlock(&io_lock);
+      }
+
+      // without I/O threads, the DMA thread is the only caller and the
+      //  lock is skipped entirely
+      /*static*/ bool HDFChannel::try_lock_api(void)
+      {
+#ifndef H5_HAVE_THREADSAFE
+        if (io_threads_enabled)
+          return (pthread_mutex_trylock(&api_lock) == 0);
+#endif
+        return true;
+      }
+
+      /*static*/ void HDFChannel::lock_api(void)
+      {
+#ifndef H5_HAVE_THREADSAFE
+        if (io_threads_enabled)
+          pthread_mutex_lock(&api_lock);
+#endif
+      }
+
+      /*static*/ void HDFChannel::unlock_api(void)
+      {
+#ifndef H5_HAVE_THREADSAFE
+        if (io_threads_enabled)
+          pthread_mutex_unlock(&api_lock);
+#endif
       }
 #endif
 
@@ -1370,6 +1978,15 @@ namespace LegionRuntime {
         XferDesRemoteWriteAckMessage::send_request(args.sender, args.req);
       }
 
+      /*static*/
+      void XferDesCompressedWriteMessage::handle_request(RequestArgs args,
+                                                         const void *data,
+                                                         size_t datalen)
+      {
+        zero_run_decode((const char *)data, datalen, args.dst_buf, args.nbytes);
+        XferDesRemoteWriteAckMessage::send_request(args.sender, args.req);
+      }
+
       /*static*/
       void XferDesRemoteWriteAckMessage::handle_request(RequestArgs args)
       {
@@ -1442,6 +2059,123 @@ namespace LegionRuntime {
         xferDes_queue->update_next_bytes_read(args.guid, args.bytes_read);
       }
 
+      /*static*/ bool DMAThread::weighted_sharing_enabled(void)
+      {
+        return ((Realm::Config::dma_share_latency > 0) ||
+                (Realm::Config::dma_share_normal > 0) ||
+                (Realm::Config::dma_share_bulk > 0));
+      }
+
+      /*static*/ DMAThread::PriorityClass DMAThread::priority_class(int priority)
+      {
+        if (priority > 0)
+          return CLASS_LATENCY;
+        if (priority < 0)
+          return CLASS_BULK;
+        return CLASS_NORMAL;
+      }
+
+      DMAThread::ChannelShares* DMAThread::get_channel_shares(Channel* channel)
+      {
+        std::map<Channel*, ChannelShares*>::iterator it = channel_shares.find(channel);
+        if (it != channel_shares.end())
+          return it->second;
+        static const char *class_names[NUM_PRIORITY_CLASSES] = { "latency", "normal", "bulk" };
+        static int channel_count = 0;
+        int idx = __sync_fetch_and_add(&channel_count, 1);
+        ChannelShares* shares = new ChannelShares;
+        for (int c = 0; c < NUM_PRIORITY_CLASSES; c++) {
+          char name[80];
+          snprintf(name, sizeof(name), "realm/dma channel %d (kind %d)/%s xds",
+                   idx, channel->kind, class_names[c]);
+          shares->deficit[c] = 0;
+          shares->depth[c] = new Realm::ProfilingGauges::AbsoluteRangeGauge<int>(name);
+        }
+        channel_shares[channel] = shares;
+        return shares;
+      }
+
+      // bytes a class may send per round for each unit of its share
+      static const long long SHARE_QUANTUM = 256 << 10;
+
+      void DMAThread::weighted_schedule(Channel* channel,
+                                        PriorityXferDesQueue* queue,
+                                        long nr,
+                                        std::vector<XferDes*>& finish_xferdes)
+      {
+        ChannelShares* shares = get_channel_shares(channel);
+        int weights[NUM_PRIORITY_CLASSES] = { Realm::Config::dma_share_latency,
+                                              Realm::Config::dma_share_normal,
+                                              Realm::Config::dma_share_bulk };
+        std::vector<XferDes*> members[NUM_PRIORITY_CLASSES];
+        for (PriorityXferDesQueue::iterator it = queue->begin(); it != queue->end(); it++) {
+          assert((*it)->channel == channel);
+          // If we haven't mark started and we are the first xd, mark start
+          if ((*it)->mark_start) {
+            (*it)->dma_request->mark_started();
+            (*it)->mark_start = false;
+          }
+          // Do nothing for empty copies
+          if ((*it)->bytes_total == 0) {
+            finish_xferdes.push_back(*it);
+            continue;
+          }
+          members[priority_class((*it)->priority)].push_back(*it);
+        }
+        for (int c = 0; c < NUM_PRIORITY_CLASSES; c++) {
+          *(shares->depth[c]) = (int)members[c].size();
+          // a class left out of the configuration still gets a minimal share
+          if (weights[c] <= 0)
+            weights[c] = 1;
+          // idle classes do not bank credit
+          if (members[c].empty())
+            shares->deficit[c] = 0;
+        }
+        // deficit round robin: each backlogged class earns its quantum per
+        //  round and spends it on the bytes its requests move, until the
+        //  channel is full or nobody can make progress
+        bool progress = true;
+        while ((nr > 0) && progress) {
+          progress = false;
+          for (int c = 0; (c < NUM_PRIORITY_CLASSES) && (nr > 0); c++) {
+            if (members[c].empty())
+              continue;
+            long long quantum = weights[c] * SHARE_QUANTUM;
+            shares->deficit[c] += quantum;
+            // don't let a class that couldn't spend its credit store up
+            //  more than a few rounds' worth
+            if (shares->deficit[c] > 4 * quantum)
+              shares->deficit[c] = 4 * quantum;
+            bool class_progress = false;
+            std::vector<XferDes*>::iterator it = members[c].begin();
+            while ((it != members[c].end()) && (shares->deficit[c] > 0) && (nr > 0)) {
+              XferDes* xd = *it;
+              long nr_got = xd->get_requests(requests, min(nr, max_nr));
+              long long nbytes = 0;
+              for (long i = 0; i < nr_got; i++)
+                nbytes += ((requests[i]->dim == Request::DIM_2D) ?
+                             requests[i]->nbytes * requests[i]->nlines :
+                             requests[i]->nbytes);
+              long nr_submitted = channel->submit(requests, nr_got);
+              assert(nr_got == nr_submitted);
+              nr -= nr_submitted;
+              shares->deficit[c] -= nbytes;
+              if (nr_got > 0)
+                class_progress = true;
+              if (xd->is_completed()) {
+                finish_xferdes.push_back(xd);
+                it = members[c].erase(it);
+              } else
+                it++;
+            }
+            if (class_progress)
+              progress = true;
+            else
+              shares->deficit[c] = 0;
+          }
+        }
+      }
+
       void DMAThread::dma_thread_loop()
       {
         log_new_dma.info("start dma thread loop");
@@ -1462,29 +2196,33 @@ namespace LegionRuntime {
             if (nr == 0)
               continue;
             std::vector<XferDes*> finish_xferdes;
-            PriorityXferDesQueue::iterator it2;
-            for (it2 = it->second->begin(); it2 != it->second->end(); it2++) {
-              assert((*it2)->channel == it->first);
-              // If we haven't mark started and we are the first xd, mark start
-              if ((*it2)->mark_start) {
-                (*it2)->dma_request->mark_started();
-                (*it2)->mark_start = false;
-              }
-              // Do nothing for empty copies
-              if ((*it2)->bytes_total ==0) {
-                finish_xferdes.push_back(*it2);
-                continue;
-              }
-              long nr_got = (*it2)->get_requests(requests, min(nr, max_nr));
-              long nr_submitted = it->first->submit(requests, nr_got);
-              nr -= nr_submitted;
-              assert(nr_got == nr_submitted);
-              if ((*it2)->is_completed()) {
-                finish_xferdes.push_back(*it2);
-                //printf("finish_xferdes.size() = %lu\n", finish_xferdes.size());
+            if (weighted_sharing_enabled())
+              weighted_schedule(it->first, it->second, nr, finish_xferdes);
+            else {
+              PriorityXferDesQueue::iterator it2;
+              for (it2 = it->second->begin(); it2 != it->second->end(); it2++) {
+                assert((*it2)->channel == it->first);
+                // If we haven't mark started and we are the first xd, mark start
+                if ((*it2)->mark_start) {
+                  (*it2)->dma_request->mark_started();
+                  (*it2)->mark_start = false;
+                }
+                // Do nothing for empty copies
+                if ((*it2)->bytes_total ==0) {
+                  finish_xferdes.push_back(*it2);
+                  continue;
+                }
+                long nr_got = (*it2)->get_requests(requests, min(nr, max_nr));
+                long nr_submitted = it->first->submit(requests, nr_got);
+                nr -= nr_submitted;
+                assert(nr_got == nr_submitted);
+                if ((*it2)->is_completed()) {
+                  finish_xferdes.push_back(*it2);
+                  //printf("finish_xferdes.size() = %lu\n", finish_xferdes.size());
+                }
+                if (nr == 0)
+                  break;
               }
-              if (nr == 0)
-                break;
             }
             while(!finish_xferdes.empty()) {
               XferDes *xd = finish_xferdes.back();
@@ -1656,20 +2394,42 @@ namespace LegionRuntime {
           worker_threads.push_back(t);
         }
 
-#ifdef USE_DEDICATED_MEMCPY_THREADS
         // Next we create memcpy threads
-        memcpy_threads =(MemcpyThread**) calloc(num_memcpy_threads, sizeof(MemcpyThread*));
-        for (int i = 0; i < num_memcpy_threads; i++) {
-          memcpy_threads[i] = new MemcpyThread(memcpy_channel);
-          Realm::Thread *t = Realm::Thread::create_kernel_thread<MemcpyThread,
-                                            &MemcpyThread::thread_loop>(memcpy_threads[i],
-                                                                        tlp,
-                                                                        *core_rsrv,
-                                                                        0 /*default scheduler*/);
-          worker_threads.push_back(t);
+        if (num_memcpy_threads > 0) {
+          memcpy_channel->enable_striping(num_memcpy_threads,
+                                          std::max(Realm::Config::dma_memcpy_stripe_kb, 1) << 10);
+          memcpy_threads =(MemcpyThread**) calloc(num_memcpy_threads, sizeof(MemcpyThread*));
+          for (int i = 0; i < num_memcpy_threads; i++) {
+            log_new_dma.info("Create a DMA memcpy thread");
+            memcpy_threads[i] = new MemcpyThread(memcpy_channel);
+            Realm::Thread *t = Realm::Thread::create_kernel_thread<MemcpyThread,
+                                              &MemcpyThread::thread_loop>(memcpy_threads[i],
+                                                                          tlp,
+                                                                          *memcpy_rsrv,
+                                                                          0 /*default scheduler*/);
+            worker_threads.push_back(t);
+          }
         }
+#ifdef USE_HDF
+        // and finally the HDF5 I/O threads
+        if (num_hdf_threads > 0) {
+          HDFChannel::enable_io_threads();
+          hdf_threads = (HDFIOThread**) calloc(num_hdf_threads, sizeof(HDFIOThread*));
+          for (int i = 0; i < num_hdf_threads; i++) {
+            log_new_dma.info("Create an HDF5 I/O thread");
+            hdf_threads[i] = new HDFIOThread;
+            Realm::Thread *t = Realm::Thread::create_kernel_thread<HDFIOThread,
+                                              &HDFIOThread::thread_loop>(hdf_threads[i],
+                                                                         tlp,
+                                                                         *hdf_rsrv,
+                                                                         0 /*default scheduler*/);
+            worker_threads.push_back(t);
+          }
+        }
+        assert(worker_threads.size() == (size_t)(num_threads + num_memcpy_threads + num_hdf_threads));
+#else
+        assert(worker_threads.size() == (size_t)(num_threads + num_memcpy_threads));
 #endif
-        assert(worker_threads.size() == (size_t)(num_threads));
       }
 
       void stop_channel_manager()
@@ -1684,6 +2444,10 @@ namespace LegionRuntime {
           dma_threads[i]->stop();
         for (int i = 0; i < num_memcpy_threads; i++)
           memcpy_threads[i]->stop();
+#ifdef USE_HDF
+        if (num_hdf_threads > 0)
+          HDFChannel::stop_io_threads();
+#endif
         // reap all the threads
         for(std::vector<Realm::Thread *>::iterator it = worker_threads.begin();
             it != worker_threads.end();
@@ -1696,10 +2460,13 @@ namespace LegionRuntime {
           delete dma_threads[i];
         for (int i = 0; i < num_memcpy_threads; i++)
           delete memcpy_threads[i];
+#ifdef USE_HDF
+        for (int i = 0; i < num_hdf_threads; i++)
+          delete hdf_threads[i];
+        free(hdf_threads);
+#endif
         free(dma_threads);
-#ifdef USE_DEDICATED_MEMCPY_THREADS
         free(memcpy_threads);
-#endif
       }
 
       template<unsigned DIM>
@@ -30,6 +30,7 @@
 #include <string.h>
 #include "lowlevel.h"
 #include "lowlevel_dma.h"
+#include "realm/sampling.h"
 
 #ifdef USE_CUDA
 #include "realm/cuda/cuda_module.h"
@@ -189,9 +190,29 @@ namespace LegionRuntime{
       Dimension dim;
     };
 
+    typedef void (*StridedCopyKernel)(char *dst, const char *src, size_t nlines,
+                                      off_t dst_str, off_t src_str);
+
+    // one contiguous run of elements on the sparse side of a gather or
+    //  scatter request
+    struct MemcpyRun {
+      off_t offset;
+      size_t nbytes;
+    };
+
     class MemcpyRequest : public Request {
     public:
       char *src_base, *dst_base;
+      // specialized copy for 2D requests (null for memcpy per line)
+      StridedCopyKernel copy_kernel;
+      // number of stripes still being copied by memcpy threads
+      int stripes_left;
+      // for gather (packed dst) or scatter (packed src) requests, the runs
+      //  of the sparse side relative to its base - the packed side is the
+      //  nbytes starting at src_off/dst_off
+      MemcpyRun *runs;
+      size_t nruns;
+      bool gather;
       //size_t nbytes;
     };
 
@@ -517,6 +538,16 @@ namespace LegionRuntime{
       LayoutIterator* li;
       MaskEnumerator* me;
       unsigned offset_idx;
+      // time this hop spent unable to issue requests because the previous
+      //  hop had not filled its source buffer yet (upstream) or the next
+      //  hop had not drained its destination buffer yet (downstream)
+      enum StallReason {
+        STALL_NONE,
+        STALL_UPSTREAM,
+        STALL_DOWNSTREAM
+      };
+      StallReason stall_reason;
+      long long stall_start, stall_upstream_ns, stall_downstream_ns;
     public:
       XferDes(DmaRequest* _dma_request, gasnet_node_t _launch_node,
               XferDesID _guid, XferDesID _pre_xd_guid, XferDesID _next_xd_guid,
@@ -553,6 +584,8 @@ namespace LegionRuntime{
           me = NULL;
         }
         offset_idx = 0;
+        stall_reason = STALL_NONE;
+        stall_start = stall_upstream_ns = stall_downstream_ns = 0;
         pthread_mutex_init(&xd_lock, NULL);
         pthread_mutex_init(&update_read_lock, NULL);
         pthread_mutex_init(&update_write_lock, NULL);
@@ -603,6 +636,9 @@ namespace LegionRuntime{
 
       void mark_completed();
 
+      // bookkeeping for the per-hop stall times above
+      void update_stall_time(long nr_generated, StallReason reason);
+
       void update_pre_bytes_write(size_t new_val) {
         pthread_mutex_lock(&update_write_lock);
         if (pre_bytes_write < new_val)
@@ -656,6 +692,7 @@ namespace LegionRuntime{
       ~MemcpyXferDes()
       {
         free(memcpy_reqs);
+        free(memcpy_runs);
       }
 
       long get_requests(Request** requests, long nr);
@@ -663,8 +700,18 @@ namespace LegionRuntime{
       void notify_request_write_done(Request* req);
       void flush();
 
+      enum {
+        MAX_RUNS_PER_REQUEST = 256
+      };
+
     private:
+      // sparse (index space) copies between an instance and an
+      //  intermediate buffer gather/scatter many runs per request
+      long get_packed_requests(MemcpyRequest** reqs, long nr);
+
       MemcpyRequest* memcpy_reqs;
+      MemcpyRun* memcpy_runs;
+      bool packed_runs;
       const char *src_buf_base, *dst_buf_base;
     };
 
@@ -781,6 +828,14 @@ namespace LegionRuntime{
       //GenericPointInRectIterator<DIM>* pir;
       GenericLinearSubrectIterator<Mapping<DIM, 1> >* lsi;
       //Layouts::HDFLayoutIterator<DIM>* hli;
+      // each subrect is transferred in pieces that each stay within one
+      //  chunk of the dataset - piece_lo is the start of the next piece
+      //  (in HDF dimension order) if piece_active is set
+      hsize_t piece_lo[DIM];
+      bool piece_active;
+      // chunk extents of each field's dataset (all zero if not chunked)
+      std::map<off_t, std::vector<hsize_t> > chunk_dims;
+      const std::vector<hsize_t>& get_chunk_dims(off_t hdf_ofs);
     };
 #endif
 
@@ -815,6 +870,14 @@ namespace LegionRuntime{
 
     class MemcpyChannel;
 
+    // a contiguous piece of a MemcpyRequest (a byte range of a 1D request,
+    //  or a range of lines of a 2D one, using the request's strides)
+    struct MemcpyStripe {
+      MemcpyRequest* req;
+      char *src, *dst;
+      size_t nbytes, nlines;
+    };
+
     class MemcpyThread {
     public:
       MemcpyThread(MemcpyChannel* _channel) : channel(_channel) {}
@@ -823,7 +886,7 @@ namespace LegionRuntime{
       void stop();
     private:
       MemcpyChannel* channel;
-      std::deque<MemcpyRequest*> thread_queue;
+      std::deque<MemcpyStripe> thread_queue;
     };
 
     class MemcpyChannel : public Channel {
@@ -831,14 +894,22 @@ namespace LegionRuntime{
       MemcpyChannel(long max_nr);
       ~MemcpyChannel();
       void stop();
-      void get_request(std::deque<MemcpyRequest*>& thread_queue);
-      void return_request(std::deque<MemcpyRequest*>& thread_queue);
+      // requests of at least twice the stripe size are split across
+      //  the DMA thread and this many memcpy threads
+      void enable_striping(int _num_workers, size_t _stripe_size);
+      void get_request(std::deque<MemcpyStripe>& thread_queue);
+      void return_request(std::deque<MemcpyStripe>& thread_queue);
       long submit(Request** requests, long nr);
       void pull();
       long available();
+      static void copy_stripe(const MemcpyStripe& stripe);
+      static void copy_runs(const MemcpyRequest* req);
       bool is_stopped;
     private:
-      std::deque<MemcpyRequest*> pending_queue, finished_queue;
+      std::deque<MemcpyStripe> pending_queue;
+      std::deque<MemcpyRequest*> finished_queue;
+      int num_workers;
+      size_t stripe_size;
       pthread_mutex_t pending_lock, finished_lock;
       pthread_cond_t pending_cond;
       long capacity;
@@ -898,8 +969,33 @@ namespace LegionRuntime{
       long submit(Request** requests, long nr);
       void pull();
       long available();
+
+      // once enabled, reads and writes for both HDF channels are handed
+      //  to a pool of dedicated I/O threads instead of being performed on
+      //  the DMA thread
+      static void enable_io_threads(void);
+      static void stop_io_threads(void);
+      static void io_thread_loop(void);
+
+      // unless HDF5 was built thread-safe, calls into it from the DMA and
+      //  I/O threads must be serialized
+      static bool try_lock_api(void);
+      static void lock_api(void);
+      static void unlock_api(void);
     private:
-      long capacity;
+      static void perform_request(HDFRequest* req);
+      long capacity, in_flight;
+      std::deque<HDFRequest*> finished_queue;
+      // shared by both channels and all I/O threads
+      static pthread_mutex_t io_lock, api_lock;
+      static pthread_cond_t io_cond;
+      static std::deque<HDFRequest*> io_queue;
+      static bool io_threads_enabled, io_threads_stopped;
+    };
+
+    class HDFIOThread {
+    public:
+      void thread_loop() { HDFChannel::io_thread_loop(); }
     };
 #endif
 
@@ -1061,6 +1157,17 @@ namespace LegionRuntime{
     typedef std::set<XferDes*, CompareXferDes> PriorityXferDesQueue;
 
     class XferDesQueue;
+    // body of a busy-wait loop - also keeps the compiler from caching
+    //  the flags being polled
+    static inline void spin_pause(void)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+      __asm__ __volatile__("pause" ::: "memory");
+#else
+      __sync_synchronize();
+#endif
+    }
+
     class DMAThread {
     public:
       DMAThread(long _max_nr, XferDesQueue* _xd_queue, std::vector<Channel*>& _channels) {
@@ -1072,6 +1179,7 @@ namespace LegionRuntime{
         is_stopped = false;
         requests = (Request**) calloc(max_nr, sizeof(Request*));
         sleep = false;
+        has_pending = false;
         pthread_mutex_init(&enqueue_lock, NULL);
         pthread_cond_init(&enqueue_cond, NULL);
       }
@@ -1082,6 +1190,7 @@ namespace LegionRuntime{
         is_stopped = false;
         requests = (Request**) calloc(max_nr, sizeof(Request*));
         sleep = false;
+        has_pending = false;
         pthread_mutex_init(&enqueue_lock, NULL);
         pthread_cond_init(&enqueue_cond, NULL);
       }
@@ -1090,6 +1199,12 @@ namespace LegionRuntime{
         for (it = channel_to_xd_pool.begin(); it != channel_to_xd_pool.end(); it++) {
           delete it->second;
         }
+        std::map<Channel*, ChannelShares*>::iterator it2;
+        for (it2 = channel_shares.begin(); it2 != channel_shares.end(); it2++) {
+          for (int c = 0; c < NUM_PRIORITY_CLASSES; c++)
+            delete it2->second->depth[c];
+          delete it2->second;
+        }
         free(requests);
         pthread_mutex_destroy(&enqueue_lock);
         pthread_cond_destroy(&enqueue_cond);
@@ -1115,8 +1230,30 @@ namespace LegionRuntime{
       pthread_cond_t enqueue_cond;
       std::map<Channel*, PriorityXferDesQueue*> channel_to_xd_pool;
       bool sleep;
+      // set (under enqueue_lock) whenever xds are queued for this thread,
+      //  so that a polling thread can check for work without locking
+      volatile bool has_pending;
       bool is_stopped;
     private:
+      // when shares are configured, each channel's capacity is divided
+      //  between priority classes by deficit round robin (in bytes)
+      enum PriorityClass {
+        CLASS_LATENCY, // XferDes::priority > 0
+        CLASS_NORMAL,  // XferDes::priority == 0
+        CLASS_BULK,    // XferDes::priority < 0
+        NUM_PRIORITY_CLASSES
+      };
+      struct ChannelShares {
+        long long deficit[NUM_PRIORITY_CLASSES];
+        // number of XferDes's of each class waiting on the channel
+        Realm::ProfilingGauges::AbsoluteRangeGauge<int>* depth[NUM_PRIORITY_CLASSES];
+      };
+      static bool weighted_sharing_enabled(void);
+      static PriorityClass priority_class(int priority);
+      ChannelShares* get_channel_shares(Channel* channel);
+      void weighted_schedule(Channel* channel, PriorityXferDesQueue* queue,
+                             long nr, std::vector<XferDes*>& finish_xferdes);
+      std::map<Channel*, ChannelShares*> channel_shares;
       // maximum allowed num of requests for a single
       long max_nr;
       Request** requests;
@@ -1184,6 +1321,36 @@ namespace LegionRuntime{
       }
     };
 
+    // a remote write whose payload is zero-run encoded - the handler
+    //  decodes it into dst_buf and acks like XferDesRemoteWriteMessage
+    struct XferDesCompressedWriteMessage {
+      struct RequestArgs : public BaseMedium {
+        char* dst_buf;
+        size_t nbytes;
+        RemoteWriteRequest* req;
+        gasnet_node_t sender;
+      };
+
+      static void handle_request(RequestArgs args, const void *data, size_t datalen);
+
+      typedef ActiveMessageMediumNoReply<XFERDES_COMPRESSED_WRITE_MSGID,
+                                         RequestArgs,
+                                         handle_request> Message;
+
+      // takes ownership of (malloc'd) 'data'
+      static void send_request(gasnet_node_t target, char* dst_buf,
+                               void* data, size_t datalen, size_t nbytes,
+                               RemoteWriteRequest* req)
+      {
+        RequestArgs args;
+        args.dst_buf = dst_buf;
+        args.nbytes = nbytes;
+        args.req = req;
+        args.sender = gasnet_mynode();
+        Message::request(target, args, data, datalen, PAYLOAD_FREE);
+      }
+    };
+
     struct XferDesRemoteWriteAckMessage {
       struct RequestArgs {
         RemoteWriteRequest* req;
@@ -1346,7 +1513,8 @@ namespace LegionRuntime{
       XferDesQueue(int num_dma_threads, bool pinned, Realm::CoreReservationSet& crs)
       //: core_rsrv("DMA request queue", crs, Realm::CoreReservationParameters())
       {
-        if (pinned) {
+        // a polling DMA thread needs a core to itself
+        if (pinned || Realm::Config::dma_poll_mode) {
           Realm::CoreReservationParameters params;
           params.set_num_cores(num_dma_threads);
           params.set_alu_usage(params.CORE_USAGE_EXCLUSIVE);
@@ -1361,12 +1529,45 @@ namespace LegionRuntime{
         // reserve the first several guid
         next_to_assign_idx = 10;
         num_threads = 0;
-        num_memcpy_threads = 0;
+        num_memcpy_threads = std::max(Realm::Config::dma_memcpy_threads, 0);
+        if (num_memcpy_threads > 0) {
+          // memcpy threads stream through memory rather than compute, so
+          //  they are happy to share cores with each other - they inherit
+          //  the default preferred NUMA domain like the DMA threads do
+          Realm::CoreReservationParameters params;
+          params.set_num_cores(num_memcpy_threads);
+          params.set_alu_usage(params.CORE_USAGE_SHARED);
+          params.set_fpu_usage(params.CORE_USAGE_SHARED);
+          params.set_ldst_usage(params.CORE_USAGE_EXCLUSIVE);
+          memcpy_rsrv = new Realm::CoreReservation("DMA memcpy threads", crs, params);
+        } else
+          memcpy_rsrv = NULL;
         dma_threads = NULL;
+        memcpy_threads = NULL;
+#ifdef USE_HDF
+        // HDF5 I/O threads mostly wait on the file system
+        num_hdf_threads = std::max(Realm::Config::hdf5_io_threads, 0);
+        if (num_hdf_threads > 0) {
+          Realm::CoreReservationParameters params;
+          params.set_num_cores(num_hdf_threads);
+          params.set_alu_usage(params.CORE_USAGE_SHARED);
+          params.set_fpu_usage(params.CORE_USAGE_SHARED);
+          params.set_ldst_usage(params.CORE_USAGE_SHARED);
+          hdf_rsrv = new Realm::CoreReservation("HDF5 I/O threads", crs, params);
+        } else
+          hdf_rsrv = NULL;
+        hdf_threads = NULL;
+#endif
       }
 
       ~XferDesQueue() {
         delete core_rsrv;
+        if (memcpy_rsrv)
+          delete memcpy_rsrv;
+#ifdef USE_HDF
+        if (hdf_rsrv)
+          delete hdf_rsrv;
+#endif
         // clean up the priority queues
         pthread_mutex_lock(&queues_lock);
         std::map<Channel*, PriorityXferDesQueue*>::iterator it2;
@@ -1487,6 +1688,7 @@ namespace LegionRuntime{
         // push ourself into the priority queue
         it2->second->insert(xd);
         pthread_mutex_unlock(&queues_lock);
+        dma_thread->has_pending = true;
         if (dma_thread->sleep) {
           dma_thread->sleep = false;
           pthread_cond_signal(&dma_thread->enqueue_cond);
@@ -1495,7 +1697,18 @@ namespace LegionRuntime{
       }
 
       bool dequeue_xferDes(DMAThread* dma_thread, bool wait_on_empty) {
+        if (Realm::Config::dma_poll_mode) {
+          // spin instead of sleeping on enqueue_cond, and don't take any
+          //  locks unless something new has been queued (completions are
+          //  picked up by the channels' pull() calls in the thread loop)
+          if (wait_on_empty)
+            while (!dma_thread->has_pending && !dma_thread->is_stopped)
+              spin_pause();
+          if (!dma_thread->has_pending)
+            return true;
+        }
         pthread_mutex_lock(&dma_thread->enqueue_lock);
+        dma_thread->has_pending = false;
         std::map<Channel*, PriorityXferDesQueue*>::iterator it;
         if (wait_on_empty) {
           bool empty = true;
@@ -1539,10 +1752,15 @@ namespace LegionRuntime{
       pthread_mutex_t queues_lock;
       pthread_rwlock_t guid_lock;
       XferDesID next_to_assign_idx;
-      Realm::CoreReservation* core_rsrv;
+      Realm::CoreReservation *core_rsrv, *memcpy_rsrv;
       int num_threads, num_memcpy_threads;
       DMAThread** dma_threads;
       MemcpyThread** memcpy_threads;
+#ifdef USE_HDF
+      Realm::CoreReservation *hdf_rsrv;
+      int num_hdf_threads;
+      HDFIOThread** hdf_threads;
+#endif
       std::vector<Realm::Thread*> worker_threads;
     };
 
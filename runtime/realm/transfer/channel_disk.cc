@@ -43,12 +43,14 @@ namespace LegionRuntime {
     {
       MemoryImpl* src_mem_impl = get_runtime()->get_memory_impl(_src_buf.memory);
       MemoryImpl* dst_mem_impl = get_runtime()->get_memory_impl(_dst_buf.memory);
+      file_map_len = 0;
       switch (kind) {
         case XferDes::XFER_FILE_READ:
         {
           ID src_id(inst);
           unsigned src_index = src_id.instance.inst_idx;
           fd = ((FileMemory*)src_mem_impl)->get_file_des(src_index);
+          file_map_base = ((FileMemory*)src_mem_impl)->get_mapping(src_index, file_map_len);
           channel = get_channel_manager()->get_file_read_channel();
           buf_base = (const char*) dst_mem_impl->get_direct_ptr(_dst_buf.alloc_offset, 0);
           assert(src_mem_impl->kind == MemoryImpl::MKIND_FILE);
@@ -59,6 +61,7 @@ namespace LegionRuntime {
           ID dst_id(inst);
           unsigned dst_index = dst_id.instance.inst_idx;
           fd = ((FileMemory*)dst_mem_impl)->get_file_des(dst_index);
+          file_map_base = ((FileMemory*)dst_mem_impl)->get_mapping(dst_index, file_map_len);
           channel = get_channel_manager()->get_file_write_channel();
           buf_base = (const char*) src_mem_impl->get_direct_ptr(_src_buf.alloc_offset, 0);
           assert(dst_mem_impl->kind == MemoryImpl::MKIND_FILE);
@@ -71,6 +74,8 @@ namespace LegionRuntime {
       for (int i = 0; i < max_nr; i++) {
         file_reqs[i].xd = this;
         file_reqs[i].fd = fd;
+        file_reqs[i].file_base = file_map_base;
+        file_reqs[i].file_len = file_map_len;
         enqueue_request(&file_reqs[i]);
       }
     }
@@ -233,6 +238,17 @@ namespace LegionRuntime {
       AsyncFileIOContext* aio_ctx = AsyncFileIOContext::get_singleton();
       for (long i = 0; i < nr; i++) {
         FileRequest* req = (FileRequest*) requests[i];
+        if (req->file_base &&
+            ((size_t)(req->file_off + req->nbytes) <= req->file_len)) {
+          // mapped file - copy straight out of (or into) the page cache
+          if (kind == XferDes::XFER_FILE_READ)
+            memcpy(req->mem_base, req->file_base + req->file_off, req->nbytes);
+          else
+            memcpy(req->file_base + req->file_off, req->mem_base, req->nbytes);
+          req->xd->notify_request_read_done(req);
+          req->xd->notify_request_write_done(req);
+          continue;
+        }
         switch (kind) {
           case XferDes::XFER_FILE_READ:
             aio_ctx->enqueue_read(req->fd, req->file_off,
@@ -246,6 +262,7 @@ namespace LegionRuntime {
             assert(0);
         }
       }
+      aio_ctx->flush_submissions();
       return nr;
     }
 
@@ -286,6 +303,7 @@ namespace LegionRuntime {
             assert(0);
         }
       }
+      aio_ctx->flush_submissions();
       return nr;
     }
 
@@ -25,6 +25,9 @@ namespace LegionRuntime {
       int fd;
       char *mem_base;
       off_t file_off;
+      // if the file is mapped, the request is a memcpy to/from here instead
+      char *file_base;
+      size_t file_len;
     };
     class DiskRequest : public Request {
     public:
@@ -58,6 +61,8 @@ namespace LegionRuntime {
       FileRequest* file_reqs;
       int fd; // The file that stores the physical instance
       const char *buf_base;
+      char *file_map_base; // the file's mapping, if any
+      size_t file_map_len;
     };
 
     template<unsigned DIM>
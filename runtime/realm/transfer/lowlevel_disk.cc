@@ -17,12 +17,21 @@
 #include "realm/realm_config.h"
 #include "lowlevel_impl.h"
 #include "lowlevel.h"
+#include "lowlevel_dma.h"
 #include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 #include <time.h>
 #include <unistd.h>
 #include <errno.h>
 
 namespace Realm {
+
+  extern Logger log_inst; // in inst_impl.cc
+
+  namespace Config {
+    int file_memory_mmap = 0;
+  };
   
     DiskMemory::DiskMemory(Memory _me, size_t _size, std::string _file)
       : MemoryImpl(_me, _size, MKIND_DISK, ALIGNMENT, Memory::DISK_MEM), file(_file)
@@ -38,11 +47,18 @@ namespace Realm {
 #else
       assert(ret == 0);
 #endif
-      free_blocks[0] = _size;
+      allocator->add_range(0, _size);
     }
 
     DiskMemory::~DiskMemory(void)
     {
+      // drop any reference the async I/O backend holds on the file
+      {
+        LegionRuntime::LowLevel::AsyncFileIOContext *aio =
+          LegionRuntime::LowLevel::AsyncFileIOContext::get_singleton();
+        if(aio)
+          aio->forget_file(fd);
+      }
       close(fd);
       // attempt to delete the file
       unlink(file.c_str());
@@ -211,14 +227,38 @@ namespace Realm {
           assert(0);
       }
 
+      // map the whole file if requested - a failure just falls back to
+      //  pread/pwrite
+      char *map_base = 0;
+      size_t map_len = 0;
+      if(Config::file_memory_mmap) {
+        struct stat st;
+        if((fstat(fd, &st) == 0) && (st.st_size > 0)) {
+          int prot = ((file_mode == LEGION_FILE_READ_ONLY) ?
+                        PROT_READ :
+                        (PROT_READ | PROT_WRITE));
+          void *ptr = mmap(0, st.st_size, prot, MAP_SHARED, fd, 0);
+          if(ptr != MAP_FAILED) {
+            map_base = (char *)ptr;
+            map_len = st.st_size;
+          } else
+            log_inst.warning() << "could not map file '" << file_name
+                               << "' (errno=" << errno << ") - using pread/pwrite";
+        }
+      }
+
       pthread_mutex_lock(&vector_lock);
       ID id(inst);
       unsigned index = id.instance.inst_idx;
-      if (index < file_vec.size())
+      if (index < file_vec.size()) {
         file_vec[index] = fd;
-      else {
+        map_vec[index] = map_base;
+        map_len_vec[index] = map_len;
+      } else {
         assert(index == file_vec.size());
         file_vec.push_back(fd);
+        map_vec.push_back(map_base);
+        map_len_vec.push_back(map_len);
       }
       offset_map[inst_offset] = index;
       pthread_mutex_unlock(&vector_lock);
@@ -233,7 +273,20 @@ namespace Realm {
       unsigned index = id.instance.inst_idx;
       assert(index < file_vec.size());
       int fd = file_vec[index];
+      char *map_base = map_vec[index];
+      size_t map_len = map_len_vec[index];
+      map_vec[index] = 0;
+      map_len_vec[index] = 0;
       pthread_mutex_unlock(&vector_lock);
+      if(map_base)
+        munmap(map_base, map_len);
+      // drop any reference the async I/O backend holds on the file
+      {
+        LegionRuntime::LowLevel::AsyncFileIOContext *aio =
+          LegionRuntime::LowLevel::AsyncFileIOContext::get_singleton();
+        if(aio)
+          aio->forget_file(fd);
+      }
       close(fd);
       destroy_instance_local(i, local_destroy);
     }
@@ -272,7 +325,13 @@ namespace Realm {
     {
       pthread_mutex_lock(&vector_lock);
       int fd = file_vec[inst_id];
+      char *map_base = map_vec[inst_id];
+      size_t map_len = map_len_vec[inst_id];
       pthread_mutex_unlock(&vector_lock);
+      if(map_base && ((offset + size) <= map_len)) {
+        memcpy(dst, map_base + offset, size);
+        return;
+      }
       size_t ret = pread(fd, dst, size, offset);
 #ifdef NDEBUG
       (void)ret;
@@ -301,7 +360,13 @@ namespace Realm {
     {
       pthread_mutex_lock(&vector_lock);
       int fd = file_vec[inst_id];
+      char *map_base = map_vec[inst_id];
+      size_t map_len = map_len_vec[inst_id];
       pthread_mutex_unlock(&vector_lock);
+      if(map_base && ((offset + size) <= map_len)) {
+        memcpy(map_base + offset, src, size);
+        return;
+      }
       size_t ret = pwrite(fd, src, size, offset);
 #ifdef NDEBUG
       (void)ret;
@@ -315,7 +380,26 @@ namespace Realm {
 
     void *FileMemory::get_direct_ptr(off_t offset, size_t size)
     {
-      return 0; // cannot provide a pointer for it;
+      // only mapped files can provide a pointer
+      if(!Config::file_memory_mmap || (offset >= next_offset))
+        return 0;
+      pthread_mutex_lock(&vector_lock);
+      // this finds the first entry _AFTER_ the one we want
+      std::map<off_t, int>::const_iterator it = offset_map.upper_bound(offset);
+      if(it == offset_map.begin()) {
+        pthread_mutex_unlock(&vector_lock);
+        return 0;
+      }
+      // back up to the element we want
+      --it;
+      ID::IDType index = it->second;
+      off_t rel_offset = offset - it->first;
+      char *map_base = map_vec[index];
+      size_t map_len = map_len_vec[index];
+      pthread_mutex_unlock(&vector_lock);
+      if(!map_base || ((rel_offset + size) > map_len))
+        return 0;
+      return map_base + rel_offset;
     }
 
     int FileMemory::get_home_node(off_t offset, size_t size)
@@ -330,5 +414,14 @@ namespace Realm {
       pthread_mutex_unlock(&vector_lock);
       return fd;
     }
+
+    char *FileMemory::get_mapping(ID::IDType inst_id, size_t& length)
+    {
+      pthread_mutex_lock(&vector_lock);
+      char *map_base = map_vec[inst_id];
+      length = map_len_vec[inst_id];
+      pthread_mutex_unlock(&vector_lock);
+      return map_base;
+    }
 }
 
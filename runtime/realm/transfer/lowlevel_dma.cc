@@ -28,6 +28,11 @@
 #else
 #include <aio.h>
 #endif
+#ifdef REALM_USE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#endif
 
 #include <queue>
 #include <algorithm>
@@ -50,8 +55,36 @@ using namespace LegionRuntime::Accessor;
 #include "realm/timers.h"
 #include "realm/serialize.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 using namespace Realm::Serialization;
 
+namespace Realm {
+  namespace Config {
+    int dma_ib_slab_size_kb = 4096;
+    int dma_ib_pool_slabs = 8;
+    int aio_use_io_uring = 0;
+    int aio_uring_sqpoll = 0;
+    int aio_uring_regbuf_mb = 256;
+    int dma_fill_nt_threshold_kb = 256;
+    int dma_coalesce_copies = 0;
+    int dma_pipeline_chunk_kb = 0;
+    int dma_pipeline_depth = 0;
+    int dma_share_latency = 0;
+    int dma_share_normal = 0;
+    int dma_share_bulk = 0;
+    int hdf5_io_threads = 0;
+    int dma_sparse_gather_run = 0;
+    int dma_calibrate_kb = 0;
+    int dma_compress_min_kb = 0;
+    int dma_poll_mode = 0;
+    int dma_memcpy_threads = 0;
+    int dma_memcpy_stripe_kb = 1024;
+  };
+};
+
 namespace LegionRuntime {
   namespace LowLevel {
 
@@ -137,17 +170,37 @@ namespace LegionRuntime {
       off_t ib_offset;
     };
 
+    // a set of fixed-size slabs reserved from an IB memory in one piece, so
+    //  that intermediate buffers neither contend with nor fragment the
+    //  memory's instance allocations
+    struct IBSlabPool {
+      off_t base;
+      size_t slab_size;
+      std::vector<int> free_slabs;
+      size_t num_slabs;
+    };
+
     class PendingIBQueue {
     public:
       PendingIBQueue();
+      ~PendingIBQueue();
 
       void enqueue_request(Memory tgt_mem, IBAllocRequest* req);
 
       void dequeue_request(Memory tgt_mem);
 
+      // returns an intermediate buffer to its pool (or memory) and hands
+      //  the space to any requests waiting on it
+      void free_buffer(Memory tgt_mem, off_t offset, size_t size);
+
     protected:
+      // both must be called with queue_mutex held
+      off_t alloc_buffer(Memory tgt_mem, size_t size);
+      IBSlabPool *get_pool(Memory tgt_mem);
+
       GASNetHSL queue_mutex;
       std::map<Memory, std::queue<IBAllocRequest*> *> queues;
+      std::map<Memory, IBSlabPool *> pools;  // NULL if a memory has no pool
     };
 
     class DmaRequest;
@@ -174,6 +227,7 @@ namespace LegionRuntime {
       bool shutdown_flag;
       CoreReservation core_rsrv;
       std::vector<Thread *> worker_threads;
+      Realm::ProfilingGauges::AbsoluteRangeGauge<int> queue_depth;
     };
 
   ////////////////////////////////////////////////////////////////////////
@@ -262,8 +316,19 @@ namespace LegionRuntime {
 
       virtual bool handler_safe(void) { return(false); }
 
+      virtual Event get_precondition(void) const { return before_copy; }
+      virtual const char *get_kind_name(void) const { return "copy"; }
+
+      virtual bool self_completing(void) const { return true; }
+      virtual bool coalesce(DmaRequest *other);
+
+      // can this request be merged with others between the same instances?
+      bool can_coalesce(void) const;
+
       Domain domain;
       OASByInst *oas_by_inst;
+      // requests whose fields were folded into this one by coalesce()
+      std::vector<CopyRequest *> coalesced;
 
       // <NEW_DMA>
       void alloc_intermediate_buffer(InstPair inst_pair, Memory tgt_mem, int idx);
@@ -329,6 +394,9 @@ namespace LegionRuntime {
 
       virtual bool handler_safe(void) { return(false); }
 
+      virtual Event get_precondition(void) const { return before_copy; }
+      virtual const char *get_kind_name(void) const { return "reduce"; }
+
       Domain domain;
       std::vector<Domain::CopySrcDstField> srcs;
       Domain::CopySrcDstField dst;
@@ -370,29 +438,150 @@ namespace LegionRuntime {
 
       virtual bool handler_safe(void) { return(false); }
 
+      virtual Event get_precondition(void) const { return before_fill; }
+      virtual const char *get_kind_name(void) const { return "fill"; }
+
       template<int DIM>
       void perform_dma_rect(MemoryImpl *mem_impl);
 
       size_t optimize_fill_buffer(RegionInstanceImpl *impl, int &fill_elmts);
 
+      // fill 'elems' contiguous elements, or elements 'stride' bytes apart
+      void fill_span(MemoryImpl *mem_impl, off_t dst_start, size_t elems);
+      void fill_strided(MemoryImpl *mem_impl, off_t dst_start, size_t elems,
+                        size_t stride);
+
       Domain domain;
       Domain::CopySrcDstField dst;
       void *fill_buffer;
       size_t fill_size;
+      // replicated copy of the fill value built by optimize_fill_buffer
+      int fill_elmts;
+      size_t fill_elmts_size;
+      // did we queue up asynchronous GPU fills?
+      bool gpu_fence_needed;
       Event before_fill;
       Waiter waiter;
     };
 
     static PendingIBQueue *ib_req_queue = 0;
 
+#define IB_MAX_SIZE (64 * 1024 * 1024)
+
+    // intermediate buffers are circular, so a copy can always use one no
+    //  larger than a slab
+    static size_t ib_size_limit(void)
+    {
+      size_t slab_size = ((size_t)Realm::Config::dma_ib_slab_size_kb) << 10;
+      size_t limit = IB_MAX_SIZE;
+      if((Realm::Config::dma_ib_pool_slabs > 0) && (slab_size > 0) &&
+	 (slab_size < limit))
+	limit = slab_size;
+      // a pipelined chain only needs room for 'depth' chunks
+      size_t chunk_size = ((size_t)Realm::Config::dma_pipeline_chunk_kb) << 10;
+      if((chunk_size > 0) && (Realm::Config::dma_pipeline_depth > 0) &&
+	 (chunk_size * Realm::Config::dma_pipeline_depth < limit))
+	limit = chunk_size * Realm::Config::dma_pipeline_depth;
+      return limit;
+    }
+
+    // largest request an XferDes may issue - hops of a multi-hop chain
+    //  are limited to a pipeline chunk so that progress is handed to the
+    //  next hop as each chunk lands rather than once per 16MB
+    static uint64_t xd_max_req_size(bool multi_hop)
+    {
+      uint64_t chunk_size = ((uint64_t)Realm::Config::dma_pipeline_chunk_kb) << 10;
+      if(multi_hop && (chunk_size > 0))
+	return chunk_size;
+      return 16 * 1024 * 1024;
+    }
+
     PendingIBQueue::PendingIBQueue() {}
 
+    PendingIBQueue::~PendingIBQueue()
+    {
+      // the reserved space goes away with the memories themselves
+      for(std::map<Memory, IBSlabPool *>::iterator it = pools.begin();
+	  it != pools.end();
+	  ++it)
+	delete it->second;
+    }
+
+    IBSlabPool *PendingIBQueue::get_pool(Memory tgt_mem)
+    {
+      std::map<Memory, IBSlabPool *>::iterator it = pools.find(tgt_mem);
+      if(it != pools.end())
+	return it->second;
+
+      // first buffer in this memory - try to reserve a pool, but never
+      //  more than a quarter of the memory
+      IBSlabPool *pool = 0;
+      size_t slab_size = ((size_t)Realm::Config::dma_ib_slab_size_kb) << 10;
+      if((Realm::Config::dma_ib_pool_slabs > 0) && (slab_size > 0)) {
+	MemoryImpl *mem_impl = get_runtime()->get_memory_impl(tgt_mem);
+	size_t num_slabs = std::min((size_t)Realm::Config::dma_ib_pool_slabs,
+				    mem_impl->size / (4 * slab_size));
+	while(num_slabs > 0) {
+	  off_t base = mem_impl->alloc_bytes(num_slabs * slab_size);
+	  if(base >= 0) {
+	    pool = new IBSlabPool;
+	    pool->base = base;
+	    pool->slab_size = slab_size;
+	    pool->num_slabs = num_slabs;
+	    for(int i = num_slabs - 1; i >= 0; i--)
+	      pool->free_slabs.push_back(i);
+	    break;
+	  }
+	  num_slabs >>= 1;
+	}
+	if(pool)
+	  log_ib_alloc.info() << "reserved IB pool in " << tgt_mem << ": "
+			      << pool->num_slabs << " x " << slab_size << " bytes";
+	else
+	  log_ib_alloc.info() << "no IB pool in " << tgt_mem << " - using general allocator";
+      }
+      pools[tgt_mem] = pool;
+      return pool;
+    }
+
+    off_t PendingIBQueue::alloc_buffer(Memory tgt_mem, size_t size)
+    {
+      IBSlabPool *pool = get_pool(tgt_mem);
+      if(pool && (size <= pool->slab_size)) {
+	// an exhausted pool holds the request until a slab is returned
+	if(pool->free_slabs.empty())
+	  return -1;
+	int slab = pool->free_slabs.back();
+	pool->free_slabs.pop_back();
+	return pool->base + (slab * pool->slab_size);
+      }
+
+      return get_runtime()->get_memory_impl(tgt_mem)->alloc_bytes(size);
+    }
+
+    void PendingIBQueue::free_buffer(Memory tgt_mem, off_t offset, size_t size)
+    {
+      {
+	AutoHSLLock al(queue_mutex);
+	std::map<Memory, IBSlabPool *>::iterator it = pools.find(tgt_mem);
+	IBSlabPool *pool = ((it != pools.end()) ? it->second : 0);
+	if(pool && (offset >= pool->base) &&
+	   (offset < (off_t)(pool->base + pool->num_slabs * pool->slab_size))) {
+	  assert(((offset - pool->base) % pool->slab_size) == 0);
+	  pool->free_slabs.push_back((offset - pool->base) / pool->slab_size);
+	} else
+	  get_runtime()->get_memory_impl(tgt_mem)->free_bytes(offset, size);
+      }
+
+      dequeue_request(tgt_mem);
+    }
+
     void PendingIBQueue::enqueue_request(Memory tgt_mem, IBAllocRequest* req)
     {
       AutoHSLLock al(queue_mutex);
       assert(ID(tgt_mem).memory.owner_node == gasnet_mynode());
       // If we can allocate in target memory, no need to pend the request
-      off_t ib_offset = get_runtime()->get_memory_impl(tgt_mem)->alloc_bytes(req->ib_size);
+      off_t ib_offset = alloc_buffer(tgt_mem, req->ib_size);
       if (ib_offset >= 0) {
         if (req->owner == gasnet_mynode()) {
           // local ib alloc request
@@ -436,7 +625,7 @@ namespace LegionRuntime {
       if (it == queues.end()) return;
       while (!it->second->empty()) {
         IBAllocRequest* req = it->second->front();
-        off_t ib_offset = get_runtime()->get_memory_impl(tgt_mem)->alloc_bytes(req->ib_size);
+        off_t ib_offset = alloc_buffer(tgt_mem, req->ib_size);
         if (ib_offset < 0) break;
         //printf("req: src_inst_id(%llx) dst_inst_id(%llx) ib_size(%lu) idx(%d)\n", req->src_inst_id, req->dst_inst_id, req->ib_size, req->idx);
         // deal with the completed ib alloc request
@@ -468,6 +657,7 @@ namespace LegionRuntime {
     DmaRequestQueue::DmaRequestQueue(Realm::CoreReservationSet& crs)
       : queue_condvar(queue_mutex)
       , core_rsrv("DMA request queue", crs, CoreReservationParameters())
+      , queue_depth("realm/dma queue depth")
     {
       queue_sleepers = 0;
       shutdown_flag = false;
@@ -519,6 +709,7 @@ namespace LegionRuntime {
 	// push ourselves onto the back of the existing queue
 	it->second->push_back(r);
       }
+      queue_depth += 1;
 
       // if anybody was sleeping, wake them up
       if(queue_sleepers > 0) {
@@ -551,6 +742,22 @@ namespace LegionRuntime {
       assert(!it->second->empty());
       DmaRequest *r = it->second->front();
       it->second->pop_front();
+      queue_depth -= 1;
+
+      // fold compatible requests waiting at the same priority into this one
+      int limit = Realm::Config::dma_coalesce_copies;
+      if(limit > 1) {
+	int merged = 1;
+	std::list<DmaRequest *>::iterator it2 = it->second->begin();
+	while((merged < limit) && (it2 != it->second->end())) {
+	  if(r->coalesce(*it2)) {
+	    it2 = it->second->erase(it2);
+	    queue_depth -= 1;
+	    merged++;
+	  } else
+	    it2++;
+	}
+      }
       // if queue is empty, delete from list
       if(it->second->empty()) {
 	delete it->second;
@@ -855,8 +1062,7 @@ namespace LegionRuntime {
     /*static*/ void RemoteIBFreeRequestAsync::handle_request(RequestArgs args)
     {
       assert(ID(args.memory).memory.owner_node == gasnet_mynode());
-      get_runtime()->get_memory_impl(args.memory)->free_bytes(args.ib_offset, args.ib_size);
-      ib_req_queue->dequeue_request(args.memory);
+      ib_req_queue->free_buffer(args.memory, args.ib_offset, args.ib_size);
     }
 
     /*static*/ void RemoteIBFreeRequestAsync::send_request(gasnet_node_t target, Memory tgt_mem, off_t ib_offset, size_t ib_size)
@@ -868,16 +1074,12 @@ namespace LegionRuntime {
       Message::request(target, args);
     }
 
-
-#define IB_MAX_SIZE (64 * 1024 * 1024)
-
     void free_intermediate_buffer(DmaRequest* req, Memory mem, off_t offset, size_t size)
     {
       //CopyRequest* cr = (CopyRequest*) req;
       //AutoHSLLock al(cr->ib_mutex);
       if(ID(mem).memory.owner_node == gasnet_mynode()) {
-        get_runtime()->get_memory_impl(mem)->free_bytes(offset, size);
-        ib_req_queue->dequeue_request(mem);
+        ib_req_queue->free_buffer(mem, offset, size);
       } else {
         RemoteIBFreeRequestAsync::send_request(ID(mem).memory.owner_node,
             mem, offset, size);
@@ -914,10 +1116,10 @@ namespace LegionRuntime {
         domain_size = domain.get_volume();
       }
       size_t ib_size;
-      if (domain_size * ib_elmnt_size < IB_MAX_SIZE)
+      if (domain_size * ib_elmnt_size < ib_size_limit())
         ib_size = domain_size * ib_elmnt_size;
       else
-        ib_size = IB_MAX_SIZE;
+        ib_size = ib_size_limit();
       //log_ib_alloc.info("alloc_ib: src_inst_id(%llx) dst_inst_id(%llx) idx(%d) size(%lu) memory(%llx)", inst_pair.first.id, inst_pair.second.id, idx, ib_size, tgt_mem.id);
       if (ID(tgt_mem).memory.owner_node == gasnet_mynode()) {
         // create local intermediate buffer
@@ -1052,6 +1254,8 @@ namespace LegionRuntime {
         Memory src_mem = get_runtime()->get_instance_impl(oas_by_inst->begin()->first.first)->memory;
         Memory dst_mem = get_runtime()->get_instance_impl(oas_by_inst->begin()->first.second)->memory;
         find_shortest_path(src_mem, dst_mem, mem_path);
+        if (domain.get_dim() == 0)
+          add_sparse_gather_hops(domain.get_index_space(), mem_path);
         ib_req->mark_ready();
         ib_req->mark_started();
         // Pass 1: create IBInfo blocks
@@ -1147,6 +1351,14 @@ namespace LegionRuntime {
 
 	state = STATE_QUEUED;
 	// <NEWDMA>
+	// copies that might be merged with other copies between the same
+	//  instances go through the queue (whose worker coalesces them),
+	//  everything else is started right away
+	if(rq && (Realm::Config::dma_coalesce_copies > 1) && can_coalesce()) {
+	  log_dma.debug("request %p enqueued for coalescing", this);
+	  rq->enqueue_request(this);
+	  return true;
+	}
 	mark_ready();
 	perform_dma();
 	return true;
@@ -1167,6 +1379,73 @@ namespace LegionRuntime {
       return false;
     }
 
+    bool CopyRequest::can_coalesce(void) const
+    {
+      // only simple copies - a single instance pair, no intermediate
+      //  buffers, no serdez and nobody asking for profiling data that
+      //  would then describe somebody else's copy
+      if((domain.get_dim() == 0) || (oas_by_inst->size() != 1) ||
+	 (mem_path.size() != 2) || !requests.empty())
+	return false;
+      const OASVec& oasvec = oas_by_inst->begin()->second;
+      for(OASVec::const_iterator it = oasvec.begin(); it != oasvec.end(); it++)
+	if(it->serdez_id != 0)
+	  return false;
+      return true;
+    }
+
+    bool CopyRequest::coalesce(DmaRequest *other_req)
+    {
+      if(!other_req->self_completing())
+	return false;
+      CopyRequest *other = static_cast<CopyRequest *>(other_req);
+      if((other->priority != priority) || !(other->domain == domain) ||
+	 !other->can_coalesce() ||
+	 (other->oas_by_inst->begin()->first != oas_by_inst->begin()->first))
+	return false;
+
+      OASVec& oasvec = oas_by_inst->begin()->second;
+      const OASVec& other_oasvec = other->oas_by_inst->begin()->second;
+      oasvec.insert(oasvec.end(), other_oasvec.begin(), other_oasvec.end());
+      coalesced.push_back(other);
+      log_dma.debug() << "request " << (void *)other << " coalesced into "
+		      << (void *)this << " (" << oasvec.size() << " fields)";
+      return true;
+    }
+
+    // stands in for the work of a coalesced request until the request
+    //  that took it over has finished
+    class CoalescedCopyFence : public EventWaiter,
+			       public Realm::Operation::AsyncWorkItem {
+    public:
+      CoalescedCopyFence(CopyRequest *_req)
+	: Realm::Operation::AsyncWorkItem(_req), req(_req) {}
+
+      virtual bool event_triggered(Event e, bool poisoned)
+      {
+	mark_finished(!poisoned);
+	return false;  // we belong to the request
+      }
+
+      virtual void request_cancellation(void)
+      {
+	// ignored - the copy is somebody else's now
+      }
+
+      virtual void print(std::ostream& os) const
+      {
+	os << "CoalescedCopyFence";
+      }
+
+      virtual Event get_finish_event(void) const
+      {
+	return req->get_finish_event();
+      }
+
+    protected:
+      CopyRequest *req;
+    };
+
     namespace RangeExecutors {
       class Memcpy {
       public:
@@ -1768,6 +2047,9 @@ namespace LegionRuntime {
 
 	redop = get_runtime()->reduce_op_table[redop_id];
 	fold = _fold;
+	// ReduceRequest holds the destination instance's lock whenever the
+	//  reduction op has dense kernels, so we can use them
+	exclusive = redop->has_dense_kernels();
       }
 
       virtual ~LocalReductionMemPairCopier(void) { }
@@ -1785,10 +2067,10 @@ namespace LegionRuntime {
 	assert((bytes % redop->sizeof_rhs) == 0);
 	if(fold)
 	  redop->fold(dst_base + dst_offset, src_base + src_offset,
-		      bytes / redop->sizeof_rhs, false /*non-exclusive*/);
+		      bytes / redop->sizeof_rhs, exclusive);
 	else
 	  redop->apply(dst_base + dst_offset, src_base + src_offset,
-		       bytes / redop->sizeof_rhs, false /*non-exclusive*/);
+		       bytes / redop->sizeof_rhs, exclusive);
       }
 
       // default behavior of 2D copy is to unroll to 1D copies
@@ -1800,10 +2082,10 @@ namespace LegionRuntime {
 	if(bytes == redop->sizeof_rhs) {
 	  if(fold)
 	    redop->fold_strided(dst_base + dst_offset, src_base + src_offset,
-				src_stride, dst_stride, lines, false /*non-exclusive*/);
+				dst_stride, src_stride, lines, exclusive);
 	  else
 	    redop->apply_strided(dst_base + dst_offset, src_base + src_offset,
-				 src_stride, dst_stride, lines, false /*non-exclusive*/);
+				 dst_stride, src_stride, lines, exclusive);
 	  return;
 	}
 
@@ -1819,7 +2101,7 @@ namespace LegionRuntime {
       const char *src_base;
       char *dst_base;
       const ReductionOpUntyped *redop;
-      bool fold;
+      bool fold, exclusive;
     };
 
     class BufferedReductionMemPairCopier : public MemPairCopier {
@@ -2583,9 +2865,381 @@ namespace LegionRuntime {
       return true;
     }
 
+#ifdef REALM_USE_IO_URING
+    inline int io_uring_setup(unsigned entries, struct io_uring_params *p)
+    {
+      return syscall(__NR_io_uring_setup, entries, p);
+    }
+
+    inline int io_uring_enter(int fd, unsigned to_submit,
+                              unsigned min_complete, unsigned flags)
+    {
+      return syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+                     flags, NULL, 0);
+    }
+
+    inline int io_uring_register(int fd, unsigned opcode,
+                                 const void *arg, unsigned nr_args)
+    {
+      return syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+    }
+
+    class IOUringOp;
+
+    // a single submission/completion ring shared by every file and disk
+    //  channel - all methods are called with the AsyncFileIOContext's
+    //  mutex held
+    class IOUringBackend {
+    public:
+      IOUringBackend(void);
+      ~IOUringBackend(void);
+
+      bool init(unsigned entries, bool sq_poll);
+
+      void prepare(IOUringOp *op);
+      void submit(void);
+      void reap(void);
+
+      void register_buffers(const std::vector<std::pair<void *, size_t> >& ranges);
+      void forget_file(int fd);
+
+    protected:
+      int find_fixed_buffer(const void *ptr, size_t bytes) const;
+      int find_fixed_file(int fd);
+
+      int ring_fd;
+      bool sq_poll;
+      void *sq_ring, *cq_ring;
+      size_t sq_ring_size, cq_ring_size;
+      struct io_uring_sqe *sqes;
+      size_t sqes_size;
+      unsigned *sq_head, *sq_tail, *sq_mask, *sq_flags, *sq_array;
+      unsigned *cq_head, *cq_tail, *cq_mask;
+      struct io_uring_cqe *cqes;
+      unsigned to_submit;
+
+      // registered buffers, sorted by base address
+      std::vector<std::pair<char *, size_t> > fixed_buffers;
+      // slots in the registered file table (empty if unsupported)
+      std::map<int, int> fixed_files;
+      std::vector<int> free_file_slots;
+    };
+
+    class IOUringOp : public AsyncFileIOContext::AIOOperation {
+    public:
+      IOUringOp(IOUringBackend *_ring, bool _is_write,
+                int _fd, size_t _offset, size_t _bytes,
+                const void *_buffer, Request* request = NULL);
+      virtual void launch(void);
+      virtual bool check_completion(void);
+
+    public:
+      IOUringBackend *ring;
+      bool is_write;
+      int fd;
+      // advanced as short reads/writes are resubmitted
+      size_t offset, bytes;
+      char *buffer;
+    };
+
+    IOUringOp::IOUringOp(IOUringBackend *_ring, bool _is_write,
+                         int _fd, size_t _offset, size_t _bytes,
+                         const void *_buffer, Request* request)
+      : ring(_ring), is_write(_is_write), fd(_fd)
+      , offset(_offset), bytes(_bytes), buffer((char *)_buffer)
+    {
+      completed = false;
+      req = request;
+    }
+
+    void IOUringOp::launch(void)
+    {
+      log_aio.debug("%s prepared: op=%p fd=%d off=%zd bytes=%zd",
+                    (is_write ? "write" : "read"), this, fd, offset, bytes);
+      ring->prepare(this);
+    }
+
+    bool IOUringOp::check_completion(void)
+    {
+      return completed;
+    }
+
+    IOUringBackend::IOUringBackend(void)
+      : ring_fd(-1), sq_poll(false), sq_ring(MAP_FAILED), cq_ring(MAP_FAILED)
+      , sq_ring_size(0), cq_ring_size(0), sqes((struct io_uring_sqe *)MAP_FAILED)
+      , sqes_size(0), to_submit(0)
+    {}
+
+    IOUringBackend::~IOUringBackend(void)
+    {
+      if(sqes != MAP_FAILED)
+        munmap(sqes, sqes_size);
+      if((cq_ring != MAP_FAILED) && (cq_ring != sq_ring))
+        munmap(cq_ring, cq_ring_size);
+      if(sq_ring != MAP_FAILED)
+        munmap(sq_ring, sq_ring_size);
+      if(ring_fd >= 0)
+        close(ring_fd);
+    }
+
+    bool IOUringBackend::init(unsigned entries, bool _sq_poll)
+    {
+      struct io_uring_params p;
+      memset(&p, 0, sizeof(p));
+      if(_sq_poll) {
+        p.flags |= IORING_SETUP_SQPOLL;
+        p.sq_thread_idle = 2000;  // ms before the kernel thread sleeps
+      }
+      ring_fd = io_uring_setup(entries, &p);
+      if(ring_fd < 0) {
+        log_aio.warning() << "io_uring_setup failed (" << strerror(errno)
+                          << ") - falling back to AIO";
+        return false;
+      }
+      sq_poll = _sq_poll;
+
+      sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+      cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+      bool single_mmap = ((p.features & IORING_FEAT_SINGLE_MMAP) != 0);
+      if(single_mmap)
+        sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+
+      sq_ring = mmap(0, sq_ring_size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+      if(sq_ring == MAP_FAILED) return false;
+      if(single_mmap)
+        cq_ring = sq_ring;
+      else {
+        cq_ring = mmap(0, cq_ring_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+        if(cq_ring == MAP_FAILED) return false;
+      }
+      sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+      sqes = (struct io_uring_sqe *)mmap(0, sqes_size, PROT_READ | PROT_WRITE,
+                                         MAP_SHARED | MAP_POPULATE,
+                                         ring_fd, IORING_OFF_SQES);
+      if(sqes == MAP_FAILED) return false;
+
+      sq_head = (unsigned *)((char *)sq_ring + p.sq_off.head);
+      sq_tail = (unsigned *)((char *)sq_ring + p.sq_off.tail);
+      sq_mask = (unsigned *)((char *)sq_ring + p.sq_off.ring_mask);
+      sq_flags = (unsigned *)((char *)sq_ring + p.sq_off.flags);
+      sq_array = (unsigned *)((char *)sq_ring + p.sq_off.array);
+      cq_head = (unsigned *)((char *)cq_ring + p.cq_off.head);
+      cq_tail = (unsigned *)((char *)cq_ring + p.cq_off.tail);
+      cq_mask = (unsigned *)((char *)cq_ring + p.cq_off.ring_mask);
+      cqes = (struct io_uring_cqe *)((char *)cq_ring + p.cq_off.cqes);
+
+      // a sparse file table lets descriptors be added as they are first
+      //  seen - older kernels reject it and we just use plain descriptors
+      std::vector<int> slots(256, -1);
+      if(io_uring_register(ring_fd, IORING_REGISTER_FILES,
+                           &slots[0], slots.size()) == 0) {
+        for(int i = slots.size() - 1; i >= 0; i--)
+          free_file_slots.push_back(i);
+      } else
+        log_aio.info() << "io_uring: fixed files unavailable ("
+                       << strerror(errno) << ")";
+
+      log_aio.info() << "io_uring: entries=" << p.sq_entries
+                     << " sqpoll=" << sq_poll;
+      return true;
+    }
+
+    void IOUringBackend::register_buffers(const std::vector<std::pair<void *, size_t> >& ranges)
+    {
+      assert(fixed_buffers.empty());
+      // the kernel limits each registered buffer to 1GB
+      const size_t max_chunk = 1 << 30;
+      std::vector<std::pair<char *, size_t> > chunks;
+      for(std::vector<std::pair<void *, size_t> >::const_iterator it = ranges.begin();
+          it != ranges.end();
+          it++) {
+        char *base = (char *)(it->first);
+        size_t left = it->second;
+        while(left > 0) {
+          size_t chunk = std::min(left, max_chunk);
+          chunks.push_back(std::make_pair(base, chunk));
+          base += chunk;
+          left -= chunk;
+        }
+      }
+      if(chunks.empty()) return;
+      std::sort(chunks.begin(), chunks.end());
+
+      std::vector<struct iovec> iovs(chunks.size());
+      for(size_t i = 0; i < chunks.size(); i++) {
+        iovs[i].iov_base = chunks[i].first;
+        iovs[i].iov_len = chunks[i].second;
+      }
+      if(io_uring_register(ring_fd, IORING_REGISTER_BUFFERS,
+                           &iovs[0], iovs.size()) == 0) {
+        fixed_buffers.swap(chunks);
+        log_aio.info() << "io_uring: registered " << fixed_buffers.size()
+                       << " fixed buffers";
+      } else
+        log_aio.info() << "io_uring: buffer registration failed ("
+                       << strerror(errno) << ")";
+    }
+
+    int IOUringBackend::find_fixed_buffer(const void *ptr, size_t bytes) const
+    {
+      if(fixed_buffers.empty()) return -1;
+      // last chunk starting at or before ptr
+      std::vector<std::pair<char *, size_t> >::const_iterator it =
+        std::upper_bound(fixed_buffers.begin(), fixed_buffers.end(),
+                         std::make_pair((char *)ptr, (size_t)-1));
+      if(it == fixed_buffers.begin()) return -1;
+      --it;
+      if(((const char *)ptr + bytes) > (it->first + it->second)) return -1;
+      return it - fixed_buffers.begin();
+    }
+
+    int IOUringBackend::find_fixed_file(int fd)
+    {
+      std::map<int, int>::const_iterator it = fixed_files.find(fd);
+      if(it != fixed_files.end()) return it->second;
+      if(free_file_slots.empty()) return -1;
+
+      int slot = free_file_slots.back();
+      struct io_uring_files_update upd;
+      memset(&upd, 0, sizeof(upd));
+      upd.offset = slot;
+      upd.fds = (uint64_t)&fd;
+      if(io_uring_register(ring_fd, IORING_REGISTER_FILES_UPDATE, &upd, 1) != 1)
+        return -1;
+      free_file_slots.pop_back();
+      fixed_files[fd] = slot;
+      return slot;
+    }
+
+    void IOUringBackend::forget_file(int fd)
+    {
+      std::map<int, int>::iterator it = fixed_files.find(fd);
+      if(it == fixed_files.end()) return;
+      int empty_fd = -1;
+      struct io_uring_files_update upd;
+      memset(&upd, 0, sizeof(upd));
+      upd.offset = it->second;
+      upd.fds = (uint64_t)&empty_fd;
+#ifndef NDEBUG
+      int ret =
+#endif
+        io_uring_register(ring_fd, IORING_REGISTER_FILES_UPDATE, &upd, 1);
+      assert(ret == 1);
+      free_file_slots.push_back(it->second);
+      fixed_files.erase(it);
+    }
+
+    void IOUringBackend::prepare(IOUringOp *op)
+    {
+      // the number of launched operations never exceeds the ring size, so
+      //  there is always room for another entry
+      unsigned tail = *sq_tail;
+      assert((tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE)) <= *sq_mask);
+      unsigned index = tail & *sq_mask;
+      struct io_uring_sqe *sqe = &sqes[index];
+      memset(sqe, 0, sizeof(*sqe));
+
+      // the length field is 32 bits - larger requests come back short
+      //  and the remainder is resubmitted
+      size_t len = std::min(op->bytes, (size_t)(1 << 30));
+      int buf_index = find_fixed_buffer(op->buffer, len);
+      if(buf_index >= 0) {
+        sqe->opcode = (op->is_write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED);
+        sqe->buf_index = buf_index;
+      } else
+        sqe->opcode = (op->is_write ? IORING_OP_WRITE : IORING_OP_READ);
+      int slot = find_fixed_file(op->fd);
+      if(slot >= 0) {
+        sqe->fd = slot;
+        sqe->flags |= IOSQE_FIXED_FILE;
+      } else
+        sqe->fd = op->fd;
+      sqe->off = op->offset;
+      sqe->addr = (uint64_t)(op->buffer);
+      sqe->len = len;
+      sqe->user_data = (uint64_t)op;
+
+      sq_array[index] = index;
+      __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+      to_submit++;
+    }
+
+    void IOUringBackend::submit(void)
+    {
+      if(to_submit == 0) return;
+      if(sq_poll) {
+        // the kernel thread picks up new entries on its own unless it has
+        //  gone to sleep
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if(__atomic_load_n(sq_flags, __ATOMIC_RELAXED) & IORING_SQ_NEED_WAKEUP)
+          io_uring_enter(ring_fd, 0, 0, IORING_ENTER_SQ_WAKEUP);
+        to_submit = 0;
+        return;
+      }
+      int ret = io_uring_enter(ring_fd, to_submit, 0, 0);
+      if(ret < 0) {
+        // transient - the entries stay queued and we try again later
+        if((errno == EINTR) || (errno == EAGAIN) || (errno == EBUSY))
+          return;
+        log_aio.fatal() << "io_uring_enter failed: " << strerror(errno);
+        assert(0);
+      }
+      to_submit -= ret;
+    }
+
+    void IOUringBackend::reap(void)
+    {
+      unsigned head = *cq_head;
+      unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+      while(head != tail) {
+        struct io_uring_cqe *cqe = &cqes[head & *cq_mask];
+        IOUringOp *op = (IOUringOp *)(cqe->user_data);
+        int res = cqe->res;
+        head++;
+        log_aio.debug("io_uring completion: op=%p res=%d", op, res);
+        if(res < 0) {
+          if((res == -EAGAIN) || (res == -EINTR)) {
+            prepare(op);
+            continue;
+          }
+          log_aio.fatal() << "io_uring " << (op->is_write ? "write" : "read")
+                          << " failed: fd=" << op->fd << " off=" << op->offset
+                          << " bytes=" << op->bytes << ": " << strerror(-res);
+          assert(0);
+        }
+        if((res > 0) && ((size_t)res < op->bytes)) {
+          // short transfer - keep going from where it stopped
+          op->offset += res;
+          op->bytes -= res;
+          op->buffer += res;
+          prepare(op);
+          continue;
+        }
+        // a zero-byte result is the end of the file, which the other AIO
+        //  paths also treat as completion
+        op->completed = true;
+      }
+      __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+    }
+#endif
+
     AsyncFileIOContext::AsyncFileIOContext(int _max_depth)
-      : max_depth(_max_depth)
+      : max_depth(_max_depth), uring(0)
     {
+#ifdef REALM_USE_IO_URING
+      if(Realm::Config::aio_use_io_uring) {
+        uring = new IOUringBackend;
+        if(!uring->init(max_depth, Realm::Config::aio_uring_sqpoll != 0)) {
+          delete uring;
+          uring = 0;
+        }
+      }
+#else
+      if(Realm::Config::aio_use_io_uring)
+        log_aio.warning() << "io_uring support not compiled in - using AIO";
+#endif
 #ifdef REALM_USE_KERNEL_AIO
       aio_ctx = 0;
 #ifndef NDEBUG
@@ -2600,6 +3254,9 @@ namespace LegionRuntime {
     {
       assert(pending_operations.empty());
       assert(launched_operations.empty());
+#ifdef REALM_USE_IO_URING
+      delete uring;
+#endif
 #ifdef REALM_USE_KERNEL_AIO
 #ifndef NDEBUG
       int ret =
@@ -2613,11 +3270,16 @@ namespace LegionRuntime {
 					   size_t bytes, const void *buffer,
                                            Request* req)
     {
+      AIOOperation *op;
+#ifdef REALM_USE_IO_URING
+      if(uring)
+        op = new IOUringOp(uring, true /*write*/, fd, offset, bytes, buffer, req);
+      else
+#endif
 #ifdef REALM_USE_KERNEL_AIO
-      KernelAIOWrite *op = new KernelAIOWrite(aio_ctx,
-					      fd, offset, bytes, buffer, req);
+      op = new KernelAIOWrite(aio_ctx, fd, offset, bytes, buffer, req);
 #else
-      PosixAIOWrite *op = new PosixAIOWrite(fd, offset, bytes, buffer, req);
+      op = new PosixAIOWrite(fd, offset, bytes, buffer, req);
 #endif
       {
 	AutoHSLLock al(mutex);
@@ -2634,11 +3296,16 @@ namespace LegionRuntime {
 					  size_t bytes, void *buffer,
                                           Request* req)
     {
+      AIOOperation *op;
+#ifdef REALM_USE_IO_URING
+      if(uring)
+        op = new IOUringOp(uring, false /*!write*/, fd, offset, bytes, buffer, req);
+      else
+#endif
 #ifdef REALM_USE_KERNEL_AIO
-      KernelAIORead *op = new KernelAIORead(aio_ctx,
-					    fd, offset, bytes, buffer, req);
+      op = new KernelAIORead(aio_ctx, fd, offset, bytes, buffer, req);
 #else
-      PosixAIORead *op = new PosixAIORead(fd, offset, bytes, buffer, req);
+      op = new PosixAIORead(fd, offset, bytes, buffer, req);
 #endif
       {
 	AutoHSLLock al(mutex);
@@ -2665,6 +3332,33 @@ namespace LegionRuntime {
       }
     }
 
+    void AsyncFileIOContext::flush_submissions(void)
+    {
+#ifdef REALM_USE_IO_URING
+      if(!uring) return;
+      AutoHSLLock al(mutex);
+      uring->submit();
+#endif
+    }
+
+    void AsyncFileIOContext::register_buffers(const std::vector<std::pair<void *, size_t> >& ranges)
+    {
+#ifdef REALM_USE_IO_URING
+      if(!uring) return;
+      AutoHSLLock al(mutex);
+      uring->register_buffers(ranges);
+#endif
+    }
+
+    void AsyncFileIOContext::forget_file(int fd)
+    {
+#ifdef REALM_USE_IO_URING
+      if(!uring) return;
+      AutoHSLLock al(mutex);
+      uring->forget_file(fd);
+#endif
+    }
+
     bool AsyncFileIOContext::empty(void)
     {
       AutoHSLLock al(mutex);
@@ -2698,6 +3392,10 @@ namespace LegionRuntime {
 	}
       }
 #endif
+#ifdef REALM_USE_IO_URING
+      if(uring)
+        uring->reap();
+#endif
 
       // now actually mark events completed in oldest-first order
       while(!launched_operations.empty()) {
@@ -2723,6 +3421,12 @@ namespace LegionRuntime {
 	op->launch();
 	launched_operations.push_back(op);
       }
+
+#ifdef REALM_USE_IO_URING
+      // one system call for everything prepared since the last batch
+      if(uring)
+        uring->submit();
+#endif
     }
 
     /*static*/
@@ -3379,10 +4083,10 @@ namespace LegionRuntime {
         oasvec_dst.push_back(oas_dst);
       }
       size_t ib_size; /*size of ib (bytes)*/
-      if (domain.get_volume() * ib_elmnt_size < IB_MAX_SIZE)
+      if (domain.get_volume() * ib_elmnt_size < ib_size_limit())
         ib_size = domain.get_volume() * ib_elmnt_size;
       else
-        ib_size = IB_MAX_SIZE;
+        ib_size = ib_size_limit();
       // Make sure the size we want here matches our previous allocation
       assert(ib_size == ib_info.size);
       //off_t ib_offset = get_runtime()->get_memory_impl(tgt_mem)->alloc_bytes(ib_size);
@@ -3401,7 +4105,7 @@ namespace LegionRuntime {
     {
       return (kind == Memory::REGDMA_MEM || kind == Memory::LEVEL3_CACHE || kind == Memory::LEVEL2_CACHE
               || kind == Memory::LEVEL1_CACHE || kind == Memory::SYSTEM_MEM || kind == Memory::SOCKET_MEM
-              || kind == Memory::Z_COPY_MEM);
+              || kind == Memory::Z_COPY_MEM || kind == Memory::GPU_MANAGED_MEM);
     }
 
     XferDes::XferKind get_xfer_des(Memory src_mem, Memory dst_mem)
@@ -3422,6 +4126,7 @@ namespace LegionRuntime {
         case Memory::SYSTEM_MEM:
         case Memory::SOCKET_MEM:
         case Memory::Z_COPY_MEM:
+        case Memory::GPU_MANAGED_MEM:
           if (is_cpu_mem(dst_ll_kind))
             return XferDes::XFER_MEM_CPY;
           else if (dst_ll_kind == Memory::GLOBAL_MEM)
@@ -3476,6 +4181,10 @@ namespace LegionRuntime {
           assert(0);
         }
       } else {
+        // remote writes are GASNet active messages whose payload may be
+        //  memcpy'd by the CPU into bounce buffers, so the source has to be
+        //  CPU-addressable - framebuffer data reaches other nodes by way of
+        //  a zero-copy intermediate buffer (find_shortest_path)
         if (is_cpu_mem(src_ll_kind) && dst_ll_kind == Memory::REGDMA_MEM)
           return XferDes::XFER_REMOTE_WRITE;
         else
@@ -3484,11 +4193,79 @@ namespace LegionRuntime {
       return XferDes::XFER_NONE;
     }
 
-    void find_shortest_path(Memory src_mem, Memory dst_mem, std::vector<Memory>& path)
+    // cost model for path selection: every hop pays a fixed overhead (xd
+    //  setup and the intermediate buffer handoff) plus a latency and
+    //  bandwidth for its channel - node-local memcpy hops can be measured at
+    //  startup (-ll:dma_calibrate), all other hops use per-channel defaults
+    struct HopCost {
+      double latency_us;
+      double bandwidth_mbs; // MB/s is also bytes/us
+    };
+
+    static const double HOP_OVERHEAD_US = 5.0;
+    // paths are chosen (and cached) for a transfer of this size
+    static const size_t PATH_COST_REF_BYTES = 1 << 20;
+
+    static GASNetHSL path_mutex;
+    static std::map<std::pair<Memory, Memory>, HopCost> measured_hop_costs;
+    static std::map<std::pair<Memory, Memory>, std::vector<Memory> > path_cache;
+
+    static HopCost default_hop_cost(XferDes::XferKind kind)
+    {
+      HopCost c;
+      switch(kind) {
+      case XferDes::XFER_MEM_CPY:
+        c.latency_us = 1; c.bandwidth_mbs = 5000; break;
+      case XferDes::XFER_GPU_TO_FB:
+      case XferDes::XFER_GPU_FROM_FB:
+        c.latency_us = 10; c.bandwidth_mbs = 6000; break;
+      case XferDes::XFER_GPU_IN_FB:
+        c.latency_us = 5; c.bandwidth_mbs = 100000; break;
+      case XferDes::XFER_GPU_PEER_FB:
+        c.latency_us = 10; c.bandwidth_mbs = 10000; break;
+      case XferDes::XFER_REMOTE_WRITE:
+        c.latency_us = 10; c.bandwidth_mbs = 3000; break;
+      case XferDes::XFER_GASNET_READ:
+      case XferDes::XFER_GASNET_WRITE:
+        c.latency_us = 20; c.bandwidth_mbs = 1000; break;
+      case XferDes::XFER_HDF_READ:
+      case XferDes::XFER_HDF_WRITE:
+        c.latency_us = 200; c.bandwidth_mbs = 200; break;
+      default:
+        // disk, file and ssd transfers
+        c.latency_us = 100; c.bandwidth_mbs = 500; break;
+      }
+      return c;
+    }
+
+    static double hop_time_us(Memory src_mem, Memory dst_mem,
+                              XferDes::XferKind kind, size_t bytes)
+    {
+      HopCost c = default_hop_cost(kind);
+      {
+        AutoHSLLock al(path_mutex);
+        std::map<std::pair<Memory, Memory>, HopCost>::const_iterator it =
+          measured_hop_costs.find(std::make_pair(src_mem, dst_mem));
+        if (it != measured_hop_costs.end())
+          c = it->second;
+      }
+      return HOP_OVERHEAD_US + c.latency_us + (bytes / c.bandwidth_mbs);
+    }
+
+    // Dijkstra over the two memories and the intermediate buffers of both
+    //  of their nodes
+    static bool find_cheapest_path(Memory src_mem, Memory dst_mem, size_t bytes,
+                                   std::vector<Memory>& path)
     {
-      std::map<Memory, std::vector<Memory> > dist;
+      path.clear();
+      if (src_mem == dst_mem) {
+        if (get_xfer_des(src_mem, dst_mem) == XferDes::XFER_NONE)
+          return false;
+        path.push_back(src_mem);
+        path.push_back(dst_mem);
+        return true;
+      }
       std::set<Memory> all_mem;
-      std::queue<Memory> active_nodes;
       all_mem.insert(src_mem);
       all_mem.insert(dst_mem);
       Node* node = &(get_runtime()->nodes[ID(src_mem).memory.owner_node]);
@@ -3501,30 +4278,215 @@ namespace LegionRuntime {
            it != node->ib_memories.end(); it++) {
         all_mem.insert((*it)->me);
       }
-      for (std::set<Memory>::iterator it = all_mem.begin(); it != all_mem.end(); it++) {
-        if (get_xfer_des(src_mem, *it) != XferDes::XFER_NONE) {
-          dist[*it] = std::vector<Memory>();
-          dist[*it].push_back(src_mem);
-          dist[*it].push_back(*it);
-          active_nodes.push(*it);
+      std::map<Memory, double> dist;
+      std::map<Memory, Memory> prev;
+      std::set<Memory> done;
+      dist[src_mem] = 0;
+      while (true) {
+        Memory cur = Memory::NO_MEMORY;
+        double cur_dist = 0;
+        for (std::map<Memory, double>::const_iterator it = dist.begin();
+             it != dist.end(); it++)
+          if ((done.count(it->first) == 0) &&
+              ((cur == Memory::NO_MEMORY) || (it->second < cur_dist))) {
+            cur = it->first;
+            cur_dist = it->second;
+          }
+        if ((cur == Memory::NO_MEMORY) || (cur == dst_mem))
+          break;
+        done.insert(cur);
+        for (std::set<Memory>::const_iterator it = all_mem.begin();
+             it != all_mem.end(); it++) {
+          if (done.count(*it) != 0)
+            continue;
+          XferDes::XferKind kind = get_xfer_des(cur, *it);
+          if (kind == XferDes::XFER_NONE)
+            continue;
+          double d = cur_dist + hop_time_us(cur, *it, kind, bytes);
+          std::map<Memory, double>::iterator it2 = dist.find(*it);
+          if ((it2 == dist.end()) || (d < it2->second)) {
+            dist[*it] = d;
+            prev[*it] = cur;
+          }
+        }
+      }
+      if (dist.find(dst_mem) == dist.end())
+        return false;
+      for (Memory m = dst_mem; m != src_mem; m = prev[m])
+        path.push_back(m);
+      path.push_back(src_mem);
+      std::reverse(path.begin(), path.end());
+      return true;
+    }
+
+    static bool lookup_path(Memory src_mem, Memory dst_mem, std::vector<Memory>& path)
+    {
+      std::pair<Memory, Memory> key(src_mem, dst_mem);
+      {
+        AutoHSLLock al(path_mutex);
+        std::map<std::pair<Memory, Memory>, std::vector<Memory> >::const_iterator it =
+          path_cache.find(key);
+        if (it != path_cache.end()) {
+          path = it->second;
+          return true;
         }
       }
-      while (!active_nodes.empty()) {
-        Memory cur = active_nodes.front();
-        active_nodes.pop();
-        std::vector<Memory> sub_path = dist[cur];
-        for(std::set<Memory>::iterator it = all_mem.begin(); it != all_mem.end(); it ++) {
-          if (get_xfer_des(cur, *it) != XferDes::XFER_NONE) {
-            if (dist.find(*it) == dist.end()) {
-              dist[*it] = sub_path;
-              dist[*it].push_back(*it);
-              active_nodes.push(*it);
+      // intermediate buffers and measured costs are fixed once the dma
+      //  system is up, so a path never needs to be recomputed
+      if (!find_cheapest_path(src_mem, dst_mem, PATH_COST_REF_BYTES, path))
+        return false;
+      log_dma.info() << "dma path " << src_mem << " -> " << dst_mem
+                     << ": " << (path.size() - 1) << " hop(s)";
+      AutoHSLLock al(path_mutex);
+      path_cache[key] = path;
+      return true;
+    }
+
+    void find_shortest_path(Memory src_mem, Memory dst_mem, std::vector<Memory>& path)
+    {
+#ifndef NDEBUG
+      bool found =
+#endif
+        lookup_path(src_mem, dst_mem, path);
+      assert(found);
+    }
+
+    bool estimate_copy_time(Memory src_mem, Memory dst_mem, size_t bytes, double& usecs)
+    {
+      std::vector<Memory> path;
+      if (!lookup_path(src_mem, dst_mem, path))
+        return false;
+      usecs = 0;
+      for (size_t i = 1; i < path.size(); i++)
+        usecs += hop_time_us(path[i - 1], path[i],
+                             get_xfer_des(path[i - 1], path[i]), bytes);
+      return true;
+    }
+
+    void set_measured_hop_cost(Memory src_mem, Memory dst_mem,
+                               double latency_us, double bandwidth_mbs)
+    {
+      HopCost c;
+      c.latency_us = latency_us;
+      c.bandwidth_mbs = bandwidth_mbs;
+      AutoHSLLock al(path_mutex);
+      measured_hop_costs[std::make_pair(src_mem, dst_mem)] = c;
+      // any path chosen with the old cost may no longer be the cheapest
+      path_cache.clear();
+    }
+
+    // times memcpys between each pair of CPU-addressable local memories
+    //  (including intermediate buffers) - small copies for the latency and
+    //  the best of a few large ones for the bandwidth
+    static void calibrate_hop_costs(size_t bytes)
+    {
+      const Node& n = get_runtime()->nodes[gasnet_mynode()];
+      std::vector<MemoryImpl*> mems(n.memories);
+      mems.insert(mems.end(), n.ib_memories.begin(), n.ib_memories.end());
+      const int SMALL_COPIES = 100;
+      const size_t SMALL_BYTES = 64;
+      const int LARGE_COPIES = 3;
+      for (std::vector<MemoryImpl*>::const_iterator src = mems.begin();
+           src != mems.end(); src++) {
+        if (!is_cpu_mem((*src)->lowlevel_kind))
+          continue;
+        for (std::vector<MemoryImpl*>::const_iterator dst = mems.begin();
+             dst != mems.end(); dst++) {
+          if ((src == dst) || !is_cpu_mem((*dst)->lowlevel_kind))
+            continue;
+          off_t src_off = (*src)->alloc_bytes(bytes);
+          off_t dst_off = (*dst)->alloc_bytes(bytes);
+          char *src_ptr = 0, *dst_ptr = 0;
+          if (src_off >= 0)
+            src_ptr = (char *)((*src)->get_direct_ptr(src_off, bytes));
+          if (dst_off >= 0)
+            dst_ptr = (char *)((*dst)->get_direct_ptr(dst_off, bytes));
+          if (src_ptr && dst_ptr) {
+            // touch both buffers first so that page faults aren't timed
+            memset(src_ptr, 0, bytes);
+            memcpy(dst_ptr, src_ptr, bytes);
+            long long start = Realm::Clock::current_time_in_nanoseconds();
+            for (int i = 0; i < SMALL_COPIES; i++) {
+              size_t ofs = (i * SMALL_BYTES) % (bytes - SMALL_BYTES + 1);
+              memcpy(dst_ptr + ofs, src_ptr + ofs, SMALL_BYTES);
+            }
+            long long small_ns = Realm::Clock::current_time_in_nanoseconds() - start;
+            long long best_ns = -1;
+            for (int i = 0; i < LARGE_COPIES; i++) {
+              start = Realm::Clock::current_time_in_nanoseconds();
+              memcpy(dst_ptr, src_ptr, bytes);
+              long long elapsed = Realm::Clock::current_time_in_nanoseconds() - start;
+              if ((best_ns < 0) || (elapsed < best_ns))
+                best_ns = elapsed;
             }
+            HopCost c;
+            c.latency_us = small_ns * 1e-3 / SMALL_COPIES;
+            c.bandwidth_mbs = bytes * 1e3 / ((best_ns > 0) ? best_ns : 1);
+            log_dma.info() << "calibrated " << (*src)->me << " -> " << (*dst)->me
+                           << ": latency=" << c.latency_us << "us bandwidth="
+                           << c.bandwidth_mbs << "MB/s";
+            AutoHSLLock al(path_mutex);
+            measured_hop_costs[std::make_pair((*src)->me, (*dst)->me)] = c;
           }
+          if (src_off >= 0)
+            (*src)->free_bytes(src_off, bytes);
+          if (dst_off >= 0)
+            (*dst)->free_bytes(dst_off, bytes);
+        }
+      }
+    }
+
+    void add_sparse_gather_hops(IndexSpace is, std::vector<Memory>& path)
+    {
+      if ((Realm::Config::dma_sparse_gather_run <= 0) || (path.size() < 2) ||
+          (get_xfer_des(path[0], path[1]) != XferDes::XFER_REMOTE_WRITE))
+        return;
+      // a remote write straight out of a sparse instance sends a message
+      //  per run of the mask, so if the runs are short we'd rather gather
+      //  them into a local intermediate buffer, send that in bulk to one on
+      //  the other node and scatter it from there
+      ElementMask::Enumerator *e = get_runtime()->get_index_space_impl(is)->valid_mask->enumerate_enabled();
+      coord_t rstart;
+      size_t rlen, elements = 0, runs = 0;
+      while (e->get_next(rstart, rlen)) {
+        elements += rlen;
+        runs++;
+      }
+      delete e;
+      if ((runs == 0) ||
+          (elements >= runs * (size_t)Realm::Config::dma_sparse_gather_run))
+        return;
+      Memory local_ib = Memory::NO_MEMORY, remote_ib = Memory::NO_MEMORY;
+      Node* node = &(get_runtime()->nodes[ID(path[0]).memory.owner_node]);
+      for (std::vector<MemoryImpl*>::const_iterator it = node->ib_memories.begin();
+           it != node->ib_memories.end(); it++)
+        if (is_cpu_mem((*it)->lowlevel_kind)) {
+          local_ib = (*it)->me;
+          break;
         }
+      if (path.size() > 2) {
+        // already going through an intermediate buffer on the other node
+        remote_ib = path[1];
+      } else {
+        node = &(get_runtime()->nodes[ID(path[1]).memory.owner_node]);
+        for (std::vector<MemoryImpl*>::const_iterator it = node->ib_memories.begin();
+             it != node->ib_memories.end(); it++)
+          if (((*it)->lowlevel_kind == Memory::REGDMA_MEM) &&
+              (get_xfer_des((*it)->me, path[1]) != XferDes::XFER_NONE)) {
+            remote_ib = (*it)->me;
+            break;
+          }
       }
-      assert(dist.find(dst_mem) != dist.end());
-      path = dist[dst_mem];
+      if ((local_ib == Memory::NO_MEMORY) || (remote_ib == Memory::NO_MEMORY))
+        return;
+      std::vector<Memory> new_path;
+      new_path.push_back(path[0]);
+      new_path.push_back(local_ib);
+      new_path.push_back(remote_ib);
+      new_path.insert(new_path.end(), path.begin() + ((path.size() > 2) ? 2 : 1), path.end());
+      log_dma.info("sparse copy (%zu elements in %zu runs): gathering through "
+                   IDFMT " and " IDFMT, elements, runs, local_ib.id, remote_ib.id);
+      path.swap(new_path);
     }
 
     template<unsigned DIM>
@@ -3560,6 +4522,7 @@ namespace LegionRuntime {
         Buffer dst_buf(&dst_impl->metadata, dst_mem);
         Buffer pre_buf;
         assert(mem_path.size() - 1 == sub_path.size());
+        bool multi_hop = (mem_path.size() > 2);
         for (unsigned idx = 0; idx < mem_path.size(); idx ++) {
           log_new_dma.info("mem_path[%d]: node(%llu), memory(%d)", idx, ID(mem_path[idx]).memory.owner_node, mem_path[idx].kind());
           if (idx == 0) {
@@ -3622,7 +4585,7 @@ namespace LegionRuntime {
                 create_xfer_des<1>(this, gasnet_mynode(), xd_guid, pre_xd_guid,
                                    next_xd_guid, mark_started, pre_buf, cur_buf,
                                    new_domain, oasvec_src,
-                                   16 * 1024 * 1024/*max_req_size*/, 100/*max_nr*/,
+                                   xd_max_req_size(multi_hop), 100/*max_nr*/,
                                    priority, order, kind, complete_fence, attach_inst);
               } else {
 #endif
@@ -3637,7 +4600,7 @@ namespace LegionRuntime {
                 create_xfer_des<0>(this, gasnet_mynode(), xd_guid, pre_xd_guid,
                                    next_xd_guid, mark_started, pre_buf, cur_buf,
                                    domain, oasvec_src,
-                                   16 * 1024 * 1024 /*max_req_size*/, 100/*max_nr*/,
+                                   xd_max_req_size(multi_hop), 100/*max_nr*/,
                                    priority, order, kind, complete_fence, attach_inst);
 #ifdef COPY_ALL_ELEMENTS_FOR_UNSTRUCTURED
               }
@@ -3655,7 +4618,7 @@ namespace LegionRuntime {
               create_xfer_des<DIM>(this, gasnet_mynode(), xd_guid, pre_xd_guid,
                                    next_xd_guid, mark_started, pre_buf, cur_buf,
                                    domain, oasvec_src,
-                                   16 * 1024 * 1024/*max_req_size*/, 100/*max_nr*/,
+                                   xd_max_req_size(multi_hop), 100/*max_nr*/,
                                    priority, order, kind, complete_fence, attach_inst);
             }
             pre_buf = cur_buf;
@@ -3769,6 +4732,23 @@ namespace LegionRuntime {
     {
       log_dma.debug("request %p executing", this);
 
+      // requests we've taken over finish when we do
+      for(std::vector<CopyRequest *>::iterator it = coalesced.begin();
+	  it != coalesced.end();
+	  it++) {
+	if(!(*it)->mark_started()) {
+	  // cancelled in the meantime - our copy still covers its fields,
+	  //  which is harmless
+	  (*it)->mark_finished(false /*!successful*/);
+	  continue;
+	}
+	CoalescedCopyFence *fence = new CoalescedCopyFence(*it);
+	(*it)->add_async_work_item(fence);
+	EventImpl::add_waiter(get_finish_event(), fence);
+	(*it)->mark_finished(true /*successful*/);
+      }
+      coalesced.clear();
+
       DetailedTimer::ScopedPush sp(TIME_COPY);
 
       // create a copier for the memory used by all of these instance pairs
@@ -4591,6 +5571,8 @@ namespace LegionRuntime {
 	      assert(dst_ok);
 
 	      // if source and dest are ok, we can just walk the index space's spans
+	      // (if we hold the instance lock, nobody else is reducing to the
+	      //  destination and the exclusive versions can be used)
 	      ElementMask::Enumerator *e = ispace->valid_mask->enumerate_enabled();
 	      Arrays::coord_t rstart; size_t rlen;
 	      while(e->get_next(rstart, rlen)) {
@@ -4598,15 +5580,18 @@ namespace LegionRuntime {
 		  redop->fold_strided(((char *)dst_base) + (rstart * dst_stride),
 				      ((const char *)src_base) + (rstart * src_stride),
 				      dst_stride, src_stride, rlen,
-				      false /*not exclusive*/);
+				      inst_lock_needed /*exclusive*/);
 		else
 		  redop->apply_strided(((char *)dst_base) + (rstart * dst_stride),
 				       ((const char *)src_base) + (rstart * src_stride),
 				       dst_stride, src_stride, rlen,
-				       false /*not exclusive*/);
+				       inst_lock_needed /*exclusive*/);
 	      }
 
               delete e;
+
+	      if(inst_lock_needed)
+		get_runtime()->get_instance_impl(dst.inst)->lock.release();
 	      break;
 	    }
 
@@ -4767,7 +5752,8 @@ namespace LegionRuntime {
         // TODO: we don't track the size of reduction on unstructred index spaces
         total_bytes = 0;
       } else {
-	MemPairCopier *mpc = MemPairCopier::create_copier(src_mem, dst_mem, redop_id, red_fold);
+	MemPairCopier *mpc = MemPairCopier::create_copier(src_mem, dst_mem, redop_id,
+							  0 /*serdez*/, red_fold);
 
 	switch(domain.get_dim()) {
 	case 1: perform_dma_rect<1>(mpc); break;
@@ -4827,6 +5813,9 @@ namespace LegionRuntime {
       fill_size = dst.size;
       fill_buffer = malloc(fill_size);
       memcpy(fill_buffer, idata, fill_size);
+      fill_elmts = 1;
+      fill_elmts_size = fill_size;
+      gpu_fence_needed = false;
 
       idata += elmts;
 
@@ -4858,6 +5847,9 @@ namespace LegionRuntime {
       fill_size = _fill_size;
       fill_buffer = malloc(fill_size);
       memcpy(fill_buffer, _fill_value, fill_size);
+      fill_elmts = 1;
+      fill_elmts_size = fill_size;
+      gpu_fence_needed = false;
 
       log_dma.info() << "dma request " << (void *)this << " created - is="
 		     << d << " fill dst=" << dst.inst << "[" << dst.offset << "+" << dst.size << "] size="
@@ -5023,7 +6015,6 @@ namespace LegionRuntime {
       MemoryImpl *mem_impl = get_runtime()->get_memory_impl(dst.inst.get_location());
 
       MemoryImpl::MemoryKind mem_kind = mem_impl->kind;
-      // TODO: optimize transfers for framebuffer to use a memset kernel
       if ((mem_kind == MemoryImpl::MKIND_SYSMEM) ||
           (mem_kind == MemoryImpl::MKIND_ZEROCOPY) ||
           (mem_kind == MemoryImpl::MKIND_RDMA) ||
@@ -5041,15 +6032,25 @@ namespace LegionRuntime {
               find_field_start(inst_impl->metadata.field_sizes, dst.offset,
                                dst.size, field_start, field_size);
               assert(field_size <= int(fill_size));
-              int fill_elmts = 1;
               // Optimize our buffer for the target instance
-              size_t fill_elmts_size = optimize_fill_buffer(inst_impl, fill_elmts);
+              fill_elmts_size = optimize_fill_buffer(inst_impl, fill_elmts);
               Arrays::Mapping<1, 1> *dst_linearization = 
                 inst_impl->metadata.linearization.get_mapping<1>();
               ElementMask::Enumerator *e = ispace->valid_mask->enumerate_enabled();
               Arrays::coord_t rstart; size_t elem_count;
               while(e->get_next(rstart, elem_count)) {
                 int dst_index = dst_linearization->image((Arrays::coord_t)rstart); 
+                // without blocking, the elements are simply elmt_size apart
+                if (inst_impl->metadata.block_size == 1) {
+                  off_t dst_start = calc_mem_loc(inst_impl->metadata.alloc_offset,
+                                                 field_start, field_size, 
+                                                 inst_impl->metadata.elmt_size,
+                                                 inst_impl->metadata.block_size,
+                                                 dst_index);
+                  fill_strided(mem_impl, dst_start, elem_count,
+                               inst_impl->metadata.elmt_size);
+                  continue;
+                }
                 size_t done = 0;
                 while (done < elem_count) {
                   int dst_in_this_block = inst_impl->metadata.block_size - 
@@ -5062,16 +6063,7 @@ namespace LegionRuntime {
                                                  dst_index + done);
                   // Record how many we've done
                   done += todo;
-                  // Now do as many bulk transfers as we can
-                  while (todo >= fill_elmts) {
-                    mem_impl->put_bytes(dst_start, fill_buffer, fill_elmts_size);
-                    dst_start += fill_elmts_size;
-                    todo -= fill_elmts;
-                  }
-                  // Handle any remainder elemts
-                  if (todo > 0) {
-                    mem_impl->put_bytes(dst_start, fill_buffer, todo*fill_size);
-                  }
+                  fill_span(mem_impl, dst_start, todo);
                 }
               }
               delete e;
@@ -5100,6 +6092,12 @@ namespace LegionRuntime {
         assert(false);
       }
 
+#ifdef USE_CUDA
+      // the request isn't done until the GPU has performed the memsets
+      if (gpu_fence_needed)
+        ((GPUFBMemory *)mem_impl)->gpu->fence_within_fb(this);
+#endif
+
       if(measurements.wants_measurement<Realm::ProfilingMeasurements::OperationMemoryUsage>()) {
         Realm::ProfilingMeasurements::OperationMemoryUsage usage;
         usage.source = Memory::NO_MEMORY;
@@ -5124,13 +6122,23 @@ namespace LegionRuntime {
       typename Arrays::Mapping<DIM, 1> *dst_linearization = 
         inst_impl->metadata.linearization.get_mapping<DIM>();
 
-      int fill_elmts = 1;
       // Optimize our buffer for the target instance
-      size_t fill_elmts_size = optimize_fill_buffer(inst_impl, fill_elmts);
+      fill_elmts_size = optimize_fill_buffer(inst_impl, fill_elmts);
       for (typename Arrays::Mapping<DIM, 1>::DenseSubrectIterator dso(rect, 
             *dst_linearization); dso; dso++) {
         int dst_index = dso.image.lo[0];
         int elem_count = dso.subrect.volume();
+        // without blocking, the elements are simply elmt_size apart
+        if (inst_impl->metadata.block_size == 1) {
+          off_t dst_start = calc_mem_loc(inst_impl->metadata.alloc_offset,
+                                         field_start, field_size, 
+                                         inst_impl->metadata.elmt_size,
+                                         inst_impl->metadata.block_size,
+                                         dst_index);
+          fill_strided(mem_impl, dst_start, elem_count,
+                       inst_impl->metadata.elmt_size);
+          continue;
+        }
         int done = 0; 
         while (done < elem_count) {
           int dst_in_this_block = inst_impl->metadata.block_size - 
@@ -5143,18 +6151,118 @@ namespace LegionRuntime {
                                          dst_index + done);
           // Record how many we've done
           done += todo;
-          // Now do as many bulk transfers as we can
-          while (todo >= fill_elmts) {
-            mem_impl->put_bytes(dst_start, fill_buffer, fill_elmts_size); 
-            dst_start += fill_elmts_size;
-            todo -= fill_elmts;
-          }
-          // Handle any remainder elemts
-          if (todo > 0) {
-            mem_impl->put_bytes(dst_start, fill_buffer, todo*fill_size);
-          }
+          fill_span(mem_impl, dst_start, todo);
+        }
+      }
+    }
+
+    // writes 'bytes' bytes of a repeating pattern (whose size divides 64)
+    //  to 'dst' with streaming stores, so that big fills don't evict
+    //  everything else from the cache
+    static void fill_nontemporal(char *dst, const char *pattern,
+                                 size_t pattern_size, size_t bytes)
+    {
+      assert((64 % pattern_size) == 0);
+      // scalar stores up to the first cache line boundary
+      size_t head = (64 - ((uintptr_t)dst & 63)) & 63;
+      if (head > bytes)
+        head = bytes;
+      for (size_t i = 0; i < head; i++)
+        dst[i] = pattern[i % pattern_size];
+      // every cache line after that sees the same (rotated) pattern
+      char line[64] __attribute__((aligned(16)));
+      for (size_t i = 0; i < 64; i++)
+        line[i] = pattern[(head + i) % pattern_size];
+      char *ptr = dst + head;
+      size_t left = bytes - head;
+#ifdef __SSE2__
+      __m128i v0 = _mm_load_si128((const __m128i *)(line));
+      __m128i v1 = _mm_load_si128((const __m128i *)(line + 16));
+      __m128i v2 = _mm_load_si128((const __m128i *)(line + 32));
+      __m128i v3 = _mm_load_si128((const __m128i *)(line + 48));
+      while (left >= 64) {
+        _mm_stream_si128((__m128i *)(ptr), v0);
+        _mm_stream_si128((__m128i *)(ptr + 16), v1);
+        _mm_stream_si128((__m128i *)(ptr + 32), v2);
+        _mm_stream_si128((__m128i *)(ptr + 48), v3);
+        ptr += 64;
+        left -= 64;
+      }
+      // make the streaming stores visible before we report completion
+      _mm_sfence();
+#else
+      while (left >= 64) {
+        memcpy(ptr, line, 64);
+        ptr += 64;
+        left -= 64;
+      }
+#endif
+      memcpy(ptr, line, left);
+    }
+
+    void FillRequest::fill_span(MemoryImpl *mem_impl, off_t dst_start, size_t elems)
+    {
+      size_t bytes = elems * fill_size;
+#ifdef USE_CUDA
+      // framebuffer fills become memsets on the GPU's copy stream
+      if (mem_impl->kind == MemoryImpl::MKIND_GPUFB) {
+        ((GPUFBMemory *)mem_impl)->gpu->fill_within_fb(dst_start, bytes,
+                                                       fill_buffer, fill_size);
+        gpu_fence_needed = true;
+        return;
+      }
+#endif
+      // big fills of system memory bypass the cache
+      if (((mem_impl->kind == MemoryImpl::MKIND_SYSMEM) ||
+           (mem_impl->kind == MemoryImpl::MKIND_ZEROCOPY)) &&
+          (Realm::Config::dma_fill_nt_threshold_kb > 0) &&
+          (bytes >= ((size_t)Realm::Config::dma_fill_nt_threshold_kb << 10)) &&
+          ((64 % fill_size) == 0)) {
+        char *ptr = (char *)(mem_impl->get_direct_ptr(dst_start, bytes));
+        if (ptr) {
+          fill_nontemporal(ptr, (const char *)fill_buffer, fill_size, bytes);
+          return;
+        }
+      }
+      // Now do as many bulk transfers as we can
+      while (elems >= (size_t)fill_elmts) {
+        mem_impl->put_bytes(dst_start, fill_buffer, fill_elmts_size);
+        dst_start += fill_elmts_size;
+        elems -= fill_elmts;
+      }
+      // Handle any remainder elemts
+      if (elems > 0) {
+        mem_impl->put_bytes(dst_start, fill_buffer, elems*fill_size);
+      }
+    }
+
+    void FillRequest::fill_strided(MemoryImpl *mem_impl, off_t dst_start,
+                                   size_t elems, size_t stride)
+    {
+      if (stride == fill_size) {
+        fill_span(mem_impl, dst_start, elems);
+        return;
+      }
+#ifdef USE_CUDA
+      if (mem_impl->kind == MemoryImpl::MKIND_GPUFB) {
+        ((GPUFBMemory *)mem_impl)->gpu->fill_within_fb_2d(dst_start, stride, elems,
+                                                          fill_buffer, fill_size);
+        gpu_fence_needed = true;
+        return;
+      }
+#endif
+      if ((mem_impl->kind == MemoryImpl::MKIND_SYSMEM) ||
+          (mem_impl->kind == MemoryImpl::MKIND_ZEROCOPY)) {
+        char *ptr = (char *)(mem_impl->get_direct_ptr(dst_start,
+                                                      (elems - 1) * stride + fill_size));
+        if (ptr) {
+          for (size_t i = 0; i < elems; i++, ptr += stride)
+            memcpy(ptr, fill_buffer, fill_size);
+          return;
         }
       }
+      for (size_t i = 0; i < elems; i++, dst_start += stride)
+        mem_impl->put_bytes(dst_start, fill_buffer, fill_size);
     }
 
     size_t FillRequest::optimize_fill_buffer(RegionInstanceImpl *inst_impl, int &fill_elmts)
@@ -5169,7 +6277,10 @@ namespace LegionRuntime {
         if ((inst_impl->metadata.elmt_size == fill_size) ||
             (inst_impl->metadata.block_size > 1)) 
         {
-          fill_elmts = min(inst_impl->metadata.block_size,2*max_size/fill_size);
+          // (a single-field instance is contiguous across blocks too)
+          fill_elmts = 2*max_size/fill_size;
+          if (inst_impl->metadata.elmt_size != fill_size)
+            fill_elmts = min(inst_impl->metadata.block_size,2*max_size/fill_size);
           size_t fill_elmts_size = fill_elmts * fill_size;
           char *next_buffer = (char*)malloc(fill_elmts_size);
           char *next_ptr = next_buffer;
@@ -5232,6 +6343,13 @@ namespace LegionRuntime {
 	DmaRequest *r = dequeue_request(aio_idle);
 
 	if(r) {
+	  // a queued copy (possibly coalesced with others) is started and
+	  //  finished by its XferDes chain
+	  if(r->self_completing()) {
+	    r->perform_dma();
+	    continue;
+	  }
+
           bool ok_to_run = r->mark_started();
 	  if(ok_to_run) {
 	    // this will automatically add any necessary AsyncWorkItem's
@@ -5278,6 +6396,30 @@ namespace LegionRuntime {
     {
       //log_dma.add_stream(&std::cerr, Logger::Category::LEVEL_DEBUG, false, false);
       aio_context = new AsyncFileIOContext(256);
+      {
+        // CPU-addressable local memories are the ends of most file and
+        //  disk transfers - offer them to the io_uring backend as fixed
+        //  buffers, as long as they fit in the registration budget
+        std::vector<std::pair<void *, size_t> > ranges;
+        size_t budget = (size_t)Realm::Config::aio_uring_regbuf_mb << 20;
+        const std::vector<MemoryImpl *>& local_mems =
+          get_runtime()->nodes[gasnet_mynode()].memories;
+        for(std::vector<MemoryImpl *>::const_iterator it = local_mems.begin();
+            it != local_mems.end();
+            it++) {
+          if(((*it)->kind != MemoryImpl::MKIND_SYSMEM) &&
+             ((*it)->kind != MemoryImpl::MKIND_ZEROCOPY))
+            continue;
+          if((*it)->size > budget) continue;
+          void *base = (*it)->get_direct_ptr(0, (*it)->size);
+          if(!base) continue;
+          ranges.push_back(std::make_pair(base, (*it)->size));
+          budget -= (*it)->size;
+        }
+        aio_context->register_buffers(ranges);
+      }
+      if (Realm::Config::dma_calibrate_kb > 0)
+        calibrate_hop_costs((size_t)Realm::Config::dma_calibrate_kb << 10);
       start_channel_manager(count, pinned, max_nr, crs);
       ib_req_queue = new PendingIBQueue();
     }
@@ -5621,6 +6763,11 @@ namespace Realm {
 
               r->serialize(msgdata);
 
+	      // start the instances' metadata on its way to the copy's node so
+	      //  that it does not have to be fetched there
+	      get_runtime()->get_instance_impl(ip.first)->push_metadata(dma_node);
+	      get_runtime()->get_instance_impl(ip.second)->push_metadata(dma_node);
+
 	      log_dma.debug("performing copy on remote node (%d), event=" IDFMT, dma_node, args.after_copy.id);
 	      get_runtime()->optable.add_remote_operation(ev, dma_node);
 	      RemoteCopyMessage::request(dma_node, args, msgdata, msglen, PAYLOAD_FREE);
@@ -5663,6 +6810,16 @@ namespace Realm {
 	MemoryImpl::MemoryKind dst_kind = get_runtime()->get_memory_impl(get_runtime()->get_instance_impl(dsts[0].inst)->memory)->kind;
 	bool inst_lock_needed = (dst_kind == MemoryImpl::MKIND_GLOBAL);
 
+	// reductions between local memories normally rely on the reduction
+	//  op's atomic (non-exclusive) apply/fold, but if the op has dense
+	//  bulk kernels, it's much cheaper to take the instance lock and use
+	//  them (LocalReductionMemPairCopier makes the same decision)
+	if(((unsigned)src_node == gasnet_mynode()) &&
+	   ((dst_kind == MemoryImpl::MKIND_SYSMEM) ||
+	    (dst_kind == MemoryImpl::MKIND_ZEROCOPY)) &&
+	   get_runtime()->reduce_op_table[redop_id]->has_dense_kernels())
+	  inst_lock_needed = true;
+
 	Event ev = GenEventImpl::create_genevent()->current_event();
 
 	ReduceRequest *r = new ReduceRequest(*this, 
@@ -5693,6 +6850,8 @@ namespace Realm {
 	  log_dma.debug("performing reduction on remote node (%d), event=" IDFMT,
 		       src_node, args.after_copy.id);
 	  get_runtime()->optable.add_remote_operation(ev, src_node);
+	  // the sources are owned by src_node, but the destination may not be
+	  get_runtime()->get_instance_impl(dsts[0].inst)->push_metadata(src_node);
 	  RemoteCopyMessage::request(src_node, args, msgdata, msglen, PAYLOAD_FREE);
 	  // done with the local copy of the request
 	  r->remove_reference();
@@ -83,6 +83,19 @@ namespace LegionRuntime {
 
     void find_shortest_path(Memory src_mem, Memory dst_mem, std::vector<Memory>& path);
 
+    // estimated time for the dma system to copy 'bytes' bytes along the path
+    //  it uses between the two memories - false if there is no such path
+    bool estimate_copy_time(Memory src_mem, Memory dst_mem, size_t bytes, double& usecs);
+
+    // lets a module that has measured a channel (e.g. GPU peer copies)
+    //  override the default cost of a hop in path selection
+    void set_measured_hop_cost(Memory src_mem, Memory dst_mem,
+                               double latency_us, double bandwidth_mbs);
+
+    // routes sparse remote copies through a gather/scatter pair of
+    //  intermediate buffers (see Config::dma_sparse_gather_run)
+    void add_sparse_gather_hops(IndexSpace is, std::vector<Memory>& path);
+
     struct RemoteCopyArgs : public BaseMedium {
       ReductionOpID redop_id;
       bool red_fold;
@@ -169,6 +182,15 @@ namespace LegionRuntime {
 
       virtual void perform_dma(void) = 0;
 
+      // requests that start and finish themselves (through their XferDes
+      //  chains) rather than being started/finished by the DMA queue
+      virtual bool self_completing(void) const { return false; }
+
+      // attempts to fold another queued request into this one - if this
+      //  returns true, 'other' has been taken over and completes when this
+      //  request does (called with the DMA queue's lock held)
+      virtual bool coalesce(DmaRequest *other) { return false; }
+
       enum State {
 	STATE_INIT,
 	STATE_METADATA_FETCH,
@@ -335,6 +357,7 @@ namespace LegionRuntime {
     };
 
     class Request;
+    class IOUringBackend;
     class AsyncFileIOContext {
     public:
       AsyncFileIOContext(int _max_depth);
@@ -344,6 +367,16 @@ namespace LegionRuntime {
       void enqueue_read(int fd, size_t offset, size_t bytes, void *buffer, Request* req = NULL);
       void enqueue_fence(DmaRequest *req);
 
+      // hands any operations prepared by the enqueue calls to the kernel
+      //  in a single batch (a no-op unless the io_uring backend is in use)
+      void flush_submissions(void);
+
+      // the io_uring backend may register memory ranges for fixed-buffer
+      //  I/O and keeps its own references to files, which must be dropped
+      //  before a file descriptor is closed
+      void register_buffers(const std::vector<std::pair<void *, size_t> >& ranges);
+      void forget_file(int fd);
+
       bool empty(void);
       long available(void);
       void make_progress(void);
@@ -365,6 +398,8 @@ namespace LegionRuntime {
 #ifdef REALM_USE_KERNEL_AIO
       aio_context_t aio_ctx;
 #endif
+      // non-null only when io_uring is in use
+      IOUringBackend *uring;
     };
   };
 };
@@ -257,6 +257,12 @@ NVCC_FLAGS	+= -arch=compute_60 -code=sm_60
 NVCC_FLAGS	+= -DPASCAL_ARCH
 endif
 NVCC_FLAGS	+= -Xptxas "-v" #-abi=no"
+# CUPTI traces the device work of GPU tasks for the profiler (-cuda:cupti)
+ifeq ($(strip $(USE_CUPTI)),1)
+CC_FLAGS	+= -DREALM_USE_CUPTI
+INC_FLAGS	+= -I$(CUDA)/extras/CUPTI/include
+LEGION_LD_FLAGS	+= -L$(CUDA)/extras/CUPTI/lib64 -lcupti -Xlinker -rpath=$(CUDA)/extras/CUPTI/lib64
+endif
 endif
 
 # Realm uses GASNet if requested
@@ -404,6 +410,8 @@ LOW_RUNTIME_SRC += $(LG_RT_DIR)/realm/runtime_impl.cc \
 		   $(LG_RT_DIR)/realm/idx_impl.cc \
 		   $(LG_RT_DIR)/realm/machine_impl.cc \
 		   $(LG_RT_DIR)/realm/sampling_impl.cc \
+		   $(LG_RT_DIR)/realm/collective_impl.cc \
+		   $(LG_RT_DIR)/realm/deppart_impl.cc \
                    $(LG_RT_DIR)/lowlevel.cc \
                    $(LG_RT_DIR)/realm/transfer/lowlevel_disk.cc
 LOW_RUNTIME_SRC += $(LG_RT_DIR)/realm/numa/numa_module.cc \
@@ -3783,6 +3783,11 @@ namespace Realm {
       assert(destroyed_fields.empty());
       destroy(wait_on);
     }
+
+    void RegionInstance::prefetch(Processor target, Event wait_on /*= Event::NO_EVENT*/) const
+    {
+      // no memories here migrate data on demand
+    }
 };
 
 namespace LegionRuntime {
@@ -4669,6 +4674,30 @@ namespace Realm {
       return result;
     }
 
+    Event IndexSpace::update_subspaces_by_field(
+                                        const std::vector<FieldDataDescriptor> &field_data,
+                                        const ElementMask &changed,
+                                        const std::map<DomainPoint, IndexSpace> &previous,
+                                        std::map<DomainPoint, IndexSpace> &subspaces,
+                                        bool mutable_results, Event wait_on) const
+    {
+      // no incremental support here - just recompute the whole partition
+      return create_subspaces_by_field(field_data, subspaces,
+                                       mutable_results, wait_on);
+    }
+
+    Event IndexSpace::update_subspaces_by_field(
+                                        const std::vector<FieldDataDescriptor> &field_data,
+                                        const ElementMask &changed,
+                                        const std::map<DomainPoint, IndexSpace> &previous,
+                                        std::map<DomainPoint, IndexSpace> &subspaces,
+                                        const Realm::ProfilingRequestSet &reqs,
+                                        bool mutable_results, Event wait_on) const
+    {
+      return create_subspaces_by_field(field_data, subspaces, reqs,
+                                       mutable_results, wait_on);
+    }
+
     /*static*/ Event IndexSpace::compute_index_spaces(
                                           std::vector<BinaryOpDescriptor> &pairs,
                                           bool mutable_results, Event wait_on)
@@ -90,6 +90,41 @@ legion_cxx_perf_tests = [
     # Circuit: Light Compute
     ['examples/circuit/circuit',
      ['-l', '10', '-p', '100', '-npp', '2', '-wpp', '4', '-ll:cpu', '2']],
+
+    # CG Solver: without and with tracing
+    ['examples/spmd_cgsolver/spmd_cgsolver',
+     ['-m', '50', '-r', '0', '-g', '64', '-b', '16', '-t', '0', '-ll:cpu', str(app_cores)]],
+    ['examples/spmd_cgsolver/spmd_cgsolver',
+     ['-m', '50', '-r', '0', '-g', '64', '-b', '16', '-t', '1', '-ll:cpu', str(app_cores)]],
+]
+
+realm_gpu_perf_tests = [
+    # GPU task launch latency, with one and several streams
+    ['test/performance/realm/gpu_launch/gpu_launch',
+     ['-ll:gpu', '1', '-ll:streams', '1', '-a', '0', '-A', '0']],
+    ['test/performance/realm/gpu_launch/gpu_launch',
+     ['-ll:gpu', '1', '-ll:streams', '4', '-a', '0', '-A', '0']],
+    ['test/performance/realm/gpu_launch/gpu_launch',
+     ['-ll:gpu', '1', '-ll:streams', '1', '-a', '65536', '-A', '65536']],
+]
+
+legion_micro_perf_tests = [
+    # Runtime lookup table containers, dense and strided distributed IDs
+    ['test/performance/legion/map_lookup/map_lookup',
+     ['-n', '64', '-N', '1048576', '-stride', '1']],
+    ['test/performance/legion/map_lookup/map_lookup',
+     ['-n', '64', '-N', '1048576', '-stride', '16']],
+]
+
+legion_overhead_perf_tests = [
+    # Runtime overhead: empty tasks, analysis, mapping, tracing, futures
+    ['test/performance/legion/runtime_overhead/runtime_overhead', []],
+]
+
+legion_task_graph_perf_tests = [
+    # Synthetic task graphs: stencil, FFT, tree, random DAG, aliasing
+    ['test/performance/legion/task_graph/task_graph',
+     ['-f', 'graphs.cfg', '-ll:cpu', '4']],
 ]
 
 regent_perf_tests = [
@@ -294,6 +329,98 @@ def run_test_perf(launcher, root_dir, tmp_dir, bin_dir, env, thread_count):
             'multiline': True,
         }
     }
+    gpu_launch_measurements = {
+        'benchmark': {
+            'type': 'argv',
+            'index': 0,
+            'filter': 'basename',
+        },
+        'argv': {
+            'type': 'argv',
+            'start': 1,
+        },
+        # Record launch-to-completion latency percentiles in microseconds.
+        'launch_p50_us': {
+            'type': 'regex',
+            'pattern': r'^LAUNCH P50\s*=\s*(.*) us$',
+            'multiline': True,
+        },
+        'launch_p99_us': {
+            'type': 'regex',
+            'pattern': r'^LAUNCH P99\s*=\s*(.*) us$',
+            'multiline': True,
+        },
+    }
+    map_lookup_measurements = {
+        'benchmark': {
+            'type': 'argv',
+            'index': 0,
+            'filter': 'basename',
+        },
+        'argv': {
+            'type': 'argv',
+            'start': 1,
+        },
+        # Record average lookup latency of present keys in nanoseconds.
+        'tree_hit_ns': {
+            'type': 'regex',
+            'pattern': r'^TREE HIT\s*=\s*(.*) ns$',
+            'multiline': True,
+        },
+        'hash_hit_ns': {
+            'type': 'regex',
+            'pattern': r'^HASH HIT\s*=\s*(.*) ns$',
+            'multiline': True,
+        },
+    }
+    runtime_overhead_measurements = {
+        'benchmark': {
+            'type': 'argv',
+            'index': 0,
+            'filter': 'basename',
+        },
+        'argv': {
+            'type': 'argv',
+            'start': 1,
+        },
+    }
+    # Record per-operation overheads in microseconds.
+    for name, label in [('individual_task_us', 'INDIVIDUAL TASK'),
+                        ('index_launch_us', 'INDEX LAUNCH'),
+                        ('index_point_us', 'INDEX POINT'),
+                        ('analysis_deep_us', 'ANALYSIS DEEP'),
+                        ('analysis_wide_us', 'ANALYSIS WIDE'),
+                        ('map_task_us', 'MAP TASK'),
+                        ('trace_replay_us', 'TRACE REPLAY'),
+                        ('future_latency_us', 'FUTURE LATENCY')]:
+        runtime_overhead_measurements[name] = {
+            'type': 'regex',
+            'pattern': r'^%s\s*=\s*(.*) us$' % label,
+            'multiline': True,
+        }
+    task_graph_measurements = {
+        'benchmark': {
+            'type': 'argv',
+            'index': 0,
+            'filter': 'basename',
+        },
+        'argv': {
+            'type': 'argv',
+            'start': 1,
+        },
+    }
+    # Record launch cost, overhead per task on the critical path,
+    # utilization and the critical path of each graph in graphs.cfg.
+    for graph in ['stencil', 'stencil_aliased', 'fft', 'tree', 'random', 'wide_fields']:
+        for name, label, unit in [('launch_us', 'LAUNCH', 'us'),
+                                  ('overhead_us', 'OVERHEAD', 'us'),
+                                  ('utilization_pct', 'UTILIZATION', '%'),
+                                  ('critical_path_ms', 'CRITICAL PATH', 'ms')]:
+            task_graph_measurements['%s_%s' % (graph, name)] = {
+                'type': 'regex',
+                'pattern': r'^%s %s\s*=\s*(.*) %s$' % (graph.upper(), label, unit),
+                'multiline': True,
+            }
     regent_measurements = {
         # Hack: Use the command name as the benchmark name.
         'benchmark': {
@@ -341,6 +468,27 @@ def run_test_perf(launcher, root_dir, tmp_dir, bin_dir, env, thread_count):
     launcher = [runner] # Note: LAUNCHER is still passed via the environment
     run_cxx(legion_cxx_perf_tests, flags, launcher, root_dir, bin_dir, cxx_env, thread_count)
 
+    # Run Realm GPU performance tests.
+    if env['USE_CUDA'] == '1':
+        gpu_launch_env = dict(list(cxx_env.items()) + [
+            ('PERF_MEASUREMENTS', json.dumps(gpu_launch_measurements)),
+        ])
+        run_cxx(realm_gpu_perf_tests, [], launcher, root_dir, None, gpu_launch_env, thread_count)
+
+    # Run Legion runtime microbenchmarks.
+    map_lookup_env = dict(list(cxx_env.items()) + [
+        ('PERF_MEASUREMENTS', json.dumps(map_lookup_measurements)),
+    ])
+    run_cxx(legion_micro_perf_tests, [], launcher, root_dir, None, map_lookup_env, thread_count)
+    runtime_overhead_env = dict(list(cxx_env.items()) + [
+        ('PERF_MEASUREMENTS', json.dumps(runtime_overhead_measurements)),
+    ])
+    run_cxx(legion_overhead_perf_tests, [], launcher, root_dir, None, runtime_overhead_env, thread_count)
+    task_graph_env = dict(list(cxx_env.items()) + [
+        ('PERF_MEASUREMENTS', json.dumps(task_graph_measurements)),
+    ])
+    run_cxx(legion_task_graph_perf_tests, [], launcher, root_dir, None, task_graph_env, thread_count)
+
     # Run Regent performance tests.
     regent_path = os.path.join(root_dir, 'language/regent.py')
     # FIXME: PENNANT can't handle the -logfile flag coming first, so just skip it.
@@ -0,0 +1,180 @@
+/* Copyright 2017 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// compares the runtime's lookup table containers on the access pattern of
+//  the distributed collectable table: keys are distributed IDs handed out
+//  with a fixed stride, and most operations are lookups of present keys
+//  with some inserts, misses, and erases mixed in
+
+#include "legion.h"
+#include "legion_utilities.h"
+#include "realm/timers.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+#include <cstring>
+
+#include <vector>
+#include <algorithm>
+
+using namespace Legion;
+using namespace Legion::Internal;
+
+struct TestConfig {
+  size_t min_entries;
+  size_t max_entries;
+  uint64_t stride;
+  size_t lookups;
+};
+
+static TestConfig config = { 64, 1 << 20, 1, 1 << 22 };
+
+// a stand-in for DistributedCollectable* values
+struct DummyCollectable { int dummy; };
+
+typedef LegionMap<DistributedID,DummyCollectable*,
+                  RUNTIME_DIST_COLLECT_ALLOC>::tracked     TreeMap;
+typedef LegionHashMap<DistributedID,DummyCollectable*,
+                      RUNTIME_DIST_COLLECT_ALLOC>::tracked HashMap;
+typedef LegionFlatMap<DistributedID,DummyCollectable*,
+                      RUNTIME_DIST_COLLECT_ALLOC>::tracked FlatMap;
+
+struct Result {
+  double insert_ns;
+  double hit_ns;
+  double miss_ns;
+  double erase_ns;
+};
+
+template<typename MAP>
+static Result measure(const std::vector<DistributedID>& keys,
+		      const std::vector<size_t>& order)
+{
+  Result r;
+  MAP map;
+  DummyCollectable c;
+  size_t n = keys.size();
+
+  long long t0 = Realm::Clock::current_time_in_nanoseconds();
+  for(size_t i = 0; i < n; i++)
+    map[keys[i]] = &c;
+  long long t1 = Realm::Clock::current_time_in_nanoseconds();
+  r.insert_ns = double(t1 - t0) / n;
+
+  // lookups of present keys in a random order
+  size_t found = 0;
+  t0 = Realm::Clock::current_time_in_nanoseconds();
+  for(size_t i = 0; i < config.lookups; i++) {
+    typename MAP::const_iterator finder = map.find(keys[order[i % n]]);
+    if(finder != map.end())
+      found++;
+  }
+  t1 = Realm::Clock::current_time_in_nanoseconds();
+  assert(found == config.lookups);
+  r.hit_ns = double(t1 - t0) / config.lookups;
+
+  // lookups of keys that were never inserted, the weak find case
+  found = 0;
+  t0 = Realm::Clock::current_time_in_nanoseconds();
+  for(size_t i = 0; i < config.lookups; i++) {
+    typename MAP::const_iterator finder = map.find(keys[order[i % n]] +
+						   (config.stride * n));
+    if(finder != map.end())
+      found++;
+  }
+  t1 = Realm::Clock::current_time_in_nanoseconds();
+  assert(found == 0);
+  r.miss_ns = double(t1 - t0) / config.lookups;
+
+  t0 = Realm::Clock::current_time_in_nanoseconds();
+  for(size_t i = 0; i < n; i++)
+    map.erase(keys[order[i]]);
+  t1 = Realm::Clock::current_time_in_nanoseconds();
+  assert(map.empty());
+  r.erase_ns = double(t1 - t0) / n;
+
+  return r;
+}
+
+static void report(const char *name, size_t n, const Result& r)
+{
+  printf("%-5s entries = %8zd  insert = %7.1f ns  hit = %7.1f ns  miss = %7.1f ns  erase = %7.1f ns\n",
+	 name, n, r.insert_ns, r.hit_ns, r.miss_ns, r.erase_ns);
+}
+
+int main(int argc, char **argv)
+{
+  for(int i = 1; i < argc; i++) {
+    if(!strcmp(argv[i], "-n")) {
+      config.min_entries = strtoll(argv[++i], 0, 10);
+      continue;
+    }
+    if(!strcmp(argv[i], "-N")) {
+      config.max_entries = strtoll(argv[++i], 0, 10);
+      continue;
+    }
+    if(!strcmp(argv[i], "-stride")) {
+      config.stride = strtoll(argv[++i], 0, 10);
+      continue;
+    }
+    if(!strcmp(argv[i], "-l")) {
+      config.lookups = strtoll(argv[++i], 0, 10);
+      continue;
+    }
+  }
+  assert((config.min_entries > 0) && (config.stride > 0));
+  if(config.max_entries < config.min_entries)
+    config.max_entries = config.min_entries;
+
+  double tree_hit = 0, hash_hit = 0;
+  size_t runs = 0;
+  size_t n = config.min_entries;
+  while(true) {
+    std::vector<DistributedID> keys(n);
+    std::vector<size_t> order(n);
+    for(size_t i = 0; i < n; i++) {
+      keys[i] = (i + 1) * config.stride;
+      order[i] = i;
+    }
+    srand(n);
+    for(size_t i = n - 1; i > 0; i--)
+      std::swap(order[i], order[rand() % (i + 1)]);
+
+    Result tree = measure<TreeMap>(keys, order);
+    Result hash = measure<HashMap>(keys, order);
+    report("tree", n, tree);
+    report("hash", n, hash);
+    tree_hit += tree.hit_ns;
+    hash_hit += hash.hit_ns;
+    // sorted vectors are only meant for small maps, so skip them once
+    //  the quadratic cost of random erasure would dominate the run
+    if(n <= 65536) {
+      Result flat = measure<FlatMap>(keys, order);
+      report("flat", n, flat);
+    }
+    runs++;
+
+    if(n >= config.max_entries) break;
+    n = std::min(config.max_entries, n * 16);
+  }
+
+  // summary over everything measured (perf.py picks these up)
+  printf("TREE HIT = %.1f ns\n", tree_hit / runs);
+  printf("HASH HIT = %.1f ns\n", hash_hit / runs);
+  fflush(stdout);
+
+  return 0;
+}
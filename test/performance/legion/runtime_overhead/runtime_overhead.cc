@@ -0,0 +1,408 @@
+/* Copyright 2017 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// measures the per-operation overhead of the Legion runtime with tasks
+//  that do no work: launch throughput of individual and index tasks, the
+//  cost of dependence analysis as the region tree gets deeper and wider,
+//  the time spent in the mapper's map_task call, the cost of replaying a
+//  trace, and the round-trip latency of resolving a future
+
+#include "legion.h"
+#include "default_mapper.h"
+#include "realm/timers.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+#include <cstring>
+
+#include <vector>
+#include <algorithm>
+
+using namespace Legion;
+using namespace Legion::Mapping;
+
+enum {
+  TOP_LEVEL_TASK_ID,
+  EMPTY_TASK_ID,
+  VALUE_TASK_ID
+};
+
+enum {
+  FID_BASE = 100
+};
+
+enum {
+  TRACE_ID = 1
+};
+
+struct TestConfig {
+  int tasks;          // individual task launches
+  int index_launches; // index space launches
+  int points;         // points in each index space launch
+  int max_depth;      // deepest region tree level to analyze
+  int max_fields;     // most fields to analyze
+  int analysis_ops;   // launches per analysis configuration
+  int trace_length;   // tasks in each trace
+  int trace_iters;    // times each trace is issued
+  int futures;        // serial future round trips
+};
+
+static TestConfig config = { 10000, 1000, 64, 8, 32, 256, 16, 100, 1000 };
+
+// wraps the default mapper to time every map_task call it handles
+class TimingMapper : public DefaultMapper {
+public:
+  TimingMapper(MapperRuntime *rt, Machine machine, Processor local)
+    : DefaultMapper(rt, machine, local, "timing_mapper")
+    , map_task_calls(0), map_task_ns(0)
+  {}
+
+  virtual void map_task(const MapperContext ctx,
+                        const Task& task,
+                        const MapTaskInput& input,
+                        MapTaskOutput& output)
+  {
+    long long t0 = Realm::Clock::current_time_in_nanoseconds();
+    DefaultMapper::map_task(ctx, task, input, output);
+    long long t1 = Realm::Clock::current_time_in_nanoseconds();
+    map_task_calls++;
+    map_task_ns += (t1 - t0);
+  }
+
+  // mappers use the default exclusive synchronization model, so these
+  //  are only read once the launches that update them have completed
+  long long map_task_calls;
+  long long map_task_ns;
+};
+
+static std::vector<TimingMapper *> timing_mappers;
+
+static void update_mappers(Machine machine, Runtime *runtime,
+                           const std::set<Processor> &local_procs)
+{
+  for(std::set<Processor>::const_iterator it = local_procs.begin();
+      it != local_procs.end();
+      it++) {
+    TimingMapper *mapper = new TimingMapper(runtime->get_mapper_runtime(),
+                                            machine, *it);
+    timing_mappers.push_back(mapper);
+    runtime->replace_default_mapper(mapper, *it);
+  }
+}
+
+static void map_task_stats(long long &calls, long long &ns)
+{
+  calls = 0;
+  ns = 0;
+  for(size_t i = 0; i < timing_mappers.size(); i++) {
+    calls += timing_mappers[i]->map_task_calls;
+    ns += timing_mappers[i]->map_task_ns;
+  }
+}
+
+void empty_task(const Task *task,
+                const std::vector<PhysicalRegion> &regions,
+                Context ctx, Runtime *runtime)
+{
+}
+
+int value_task(const Task *task,
+               const std::vector<PhysicalRegion> &regions,
+               Context ctx, Runtime *runtime)
+{
+  return 1;
+}
+
+// the fence holds the final task back until everything launched before it
+//  has finished, so waiting on it waits on all of them
+static void wait_for_all(Context ctx, Runtime *runtime)
+{
+  runtime->issue_execution_fence(ctx);
+  TaskLauncher launcher(VALUE_TASK_ID, TaskArgument());
+  Future f = runtime->execute_task(ctx, launcher);
+  f.get_void_result();
+}
+
+static double time_individual_tasks(Context ctx, Runtime *runtime)
+{
+  wait_for_all(ctx, runtime);
+  long long t0 = Realm::Clock::current_time_in_nanoseconds();
+  for(int i = 0; i < config.tasks; i++) {
+    TaskLauncher launcher(EMPTY_TASK_ID, TaskArgument());
+    runtime->execute_task(ctx, launcher);
+  }
+  wait_for_all(ctx, runtime);
+  long long t1 = Realm::Clock::current_time_in_nanoseconds();
+  return double(t1 - t0) / (1000.0 * config.tasks);
+}
+
+static double time_index_launches(Context ctx, Runtime *runtime)
+{
+  Rect<1> rect(Point<1>(0), Point<1>(config.points - 1));
+  Domain domain = Domain::from_rect<1>(rect);
+  wait_for_all(ctx, runtime);
+  long long t0 = Realm::Clock::current_time_in_nanoseconds();
+  for(int i = 0; i < config.index_launches; i++) {
+    IndexLauncher launcher(EMPTY_TASK_ID, domain,
+                           TaskArgument(), ArgumentMap());
+    runtime->execute_index_space(ctx, launcher);
+  }
+  wait_for_all(ctx, runtime);
+  long long t1 = Realm::Clock::current_time_in_nanoseconds();
+  return double(t1 - t0) / (1000.0 * config.index_launches);
+}
+
+// launches read-only tasks on the given region so that the launches don't
+//  serialize on each other and the time is dominated by the analysis
+static double time_analysis(Context ctx, Runtime *runtime,
+                            LogicalRegion region, LogicalRegion root,
+                            int fields)
+{
+  wait_for_all(ctx, runtime);
+  long long t0 = Realm::Clock::current_time_in_nanoseconds();
+  for(int i = 0; i < config.analysis_ops; i++) {
+    TaskLauncher launcher(EMPTY_TASK_ID, TaskArgument());
+    launcher.add_region_requirement(
+        RegionRequirement(region, READ_ONLY, EXCLUSIVE, root));
+    for(int f = 0; f < fields; f++)
+      launcher.add_field(0, FID_BASE + f);
+    runtime->execute_task(ctx, launcher);
+  }
+  wait_for_all(ctx, runtime);
+  long long t1 = Realm::Clock::current_time_in_nanoseconds();
+  return double(t1 - t0) / (1000.0 * config.analysis_ops);
+}
+
+// issues trace_length independent read-write tasks, one per subregion,
+//  and returns the time per task of each of the iterations
+static void time_trace(Context ctx, Runtime *runtime,
+                       LogicalPartition lp, LogicalRegion root, bool traced,
+                       std::vector<double> &per_task_us)
+{
+  per_task_us.clear();
+  for(int iter = 0; iter < config.trace_iters; iter++) {
+    wait_for_all(ctx, runtime);
+    long long t0 = Realm::Clock::current_time_in_nanoseconds();
+    if(traced)
+      runtime->begin_trace(ctx, TRACE_ID);
+    for(int i = 0; i < config.trace_length; i++) {
+      LogicalRegion sub = runtime->get_logical_subregion_by_color(ctx, lp, i);
+      TaskLauncher launcher(EMPTY_TASK_ID, TaskArgument());
+      launcher.add_region_requirement(
+          RegionRequirement(sub, READ_WRITE, EXCLUSIVE, root));
+      launcher.add_field(0, FID_BASE);
+      runtime->execute_task(ctx, launcher);
+    }
+    if(traced)
+      runtime->end_trace(ctx, TRACE_ID);
+    wait_for_all(ctx, runtime);
+    long long t1 = Realm::Clock::current_time_in_nanoseconds();
+    per_task_us.push_back(double(t1 - t0) / (1000.0 * config.trace_length));
+  }
+}
+
+static double time_futures(Context ctx, Runtime *runtime)
+{
+  wait_for_all(ctx, runtime);
+  long long t0 = Realm::Clock::current_time_in_nanoseconds();
+  int total = 0;
+  for(int i = 0; i < config.futures; i++) {
+    TaskLauncher launcher(VALUE_TASK_ID, TaskArgument());
+    Future f = runtime->execute_task(ctx, launcher);
+    total += f.get_result<int>();
+  }
+  long long t1 = Realm::Clock::current_time_in_nanoseconds();
+  assert(total == config.futures);
+  return double(t1 - t0) / (1000.0 * config.futures);
+}
+
+void top_level_task(const Task *task,
+                    const std::vector<PhysicalRegion> &regions,
+                    Context ctx, Runtime *runtime)
+{
+  long long calls_before, ns_before, calls_after, ns_after;
+
+  // empty task throughput
+  double individual_us = time_individual_tasks(ctx, runtime);
+  printf("individual tasks = %8d  time per task = %8.2f us\n",
+         config.tasks, individual_us);
+
+  map_task_stats(calls_before, ns_before);
+  double index_us = time_index_launches(ctx, runtime);
+  map_task_stats(calls_after, ns_after);
+  double point_us = index_us / config.points;
+  printf("index launches = %6d  points = %6d  time per launch = %8.2f us"
+         "  time per point = %8.2f us\n",
+         config.index_launches, config.points, index_us, point_us);
+  double map_task_us = 0;
+  if(calls_after > calls_before)
+    map_task_us = (ns_after - ns_before) / (1000.0 * (calls_after -
+                                                      calls_before));
+  printf("map_task calls = %8lld  time per call = %8.2f us\n",
+         calls_after - calls_before, map_task_us);
+
+  // dependence analysis versus tree depth and field count, the region
+  //  tree is a chain of two-way equal partitions where each level
+  //  descends into the first subregion of the one above
+  Rect<1> elems(Point<1>(0), Point<1>((16 << config.max_depth) - 1));
+  IndexSpace is = runtime->create_index_space(ctx,
+                                              Domain::from_rect<1>(elems));
+  FieldSpace fs = runtime->create_field_space(ctx);
+  {
+    FieldAllocator allocator = runtime->create_field_allocator(ctx, fs);
+    for(int f = 0; f < config.max_fields; f++)
+      allocator.allocate_field(sizeof(int), FID_BASE + f);
+  }
+  LogicalRegion root = runtime->create_logical_region(ctx, is, fs);
+  Rect<1> halves(Point<1>(0), Point<1>(1));
+  std::vector<LogicalRegion> levels(1, root);
+  for(int d = 0; d < config.max_depth; d++) {
+    LogicalRegion parent = levels.back();
+    IndexPartition ip = runtime->create_equal_partition(ctx,
+                              parent.get_index_space(),
+                              Domain::from_rect<1>(halves));
+    LogicalPartition lp = runtime->get_logical_partition(ctx, parent, ip);
+    levels.push_back(runtime->get_logical_subregion_by_color(ctx, lp, 0));
+  }
+  double deep_us = 0, wide_us = 0;
+  for(int d = 0; d <= config.max_depth; d++) {
+    for(int f = 1; ; f = std::min(f * 2, config.max_fields)) {
+      double us = time_analysis(ctx, runtime, levels[d], root, f);
+      printf("analysis depth = %3d  fields = %4d  time per launch = %8.2f us\n",
+             d, f, us);
+      if((d == config.max_depth) && (f == 1))
+        deep_us = us;
+      if((d == 0) && (f == config.max_fields))
+        wide_us = us;
+      if(f >= config.max_fields) break;
+    }
+  }
+
+  // trace replay versus the same launches without a trace
+  Rect<1> pieces(Point<1>(0), Point<1>(config.trace_length - 1));
+  IndexPartition trace_ip = runtime->create_equal_partition(ctx, is,
+                                    Domain::from_rect<1>(pieces));
+  LogicalPartition trace_lp = runtime->get_logical_partition(ctx, root,
+                                                             trace_ip);
+  std::vector<double> untraced, traced;
+  time_trace(ctx, runtime, trace_lp, root, false, untraced);
+  time_trace(ctx, runtime, trace_lp, root, true, traced);
+  double untraced_us = 0, replay_us = 0;
+  for(size_t i = 0; i < untraced.size(); i++)
+    untraced_us += untraced[i];
+  untraced_us /= untraced.size();
+  // the first iteration records the trace, the rest replay it
+  for(size_t i = 1; i < traced.size(); i++)
+    replay_us += traced[i];
+  if(traced.size() > 1)
+    replay_us /= (traced.size() - 1);
+  printf("trace length = %4d  untraced = %8.2f us  record = %8.2f us"
+         "  replay = %8.2f us  (time per task)\n",
+         config.trace_length, untraced_us, traced[0], replay_us);
+
+  // future resolution latency
+  double future_us = time_futures(ctx, runtime);
+  printf("future round trips = %8d  time per round trip = %8.2f us\n",
+         config.futures, future_us);
+
+  runtime->destroy_logical_region(ctx, root);
+  runtime->destroy_field_space(ctx, fs);
+  runtime->destroy_index_space(ctx, is);
+
+  // summary over everything measured (perf.py picks these up)
+  printf("INDIVIDUAL TASK = %.2f us\n", individual_us);
+  printf("INDEX LAUNCH = %.2f us\n", index_us);
+  printf("INDEX POINT = %.2f us\n", point_us);
+  printf("ANALYSIS DEEP = %.2f us\n", deep_us);
+  printf("ANALYSIS WIDE = %.2f us\n", wide_us);
+  printf("MAP TASK = %.2f us\n", map_task_us);
+  printf("TRACE REPLAY = %.2f us\n", replay_us);
+  printf("FUTURE LATENCY = %.2f us\n", future_us);
+  fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+  for(int i = 1; i < argc; i++) {
+    if(!strcmp(argv[i], "-n")) {
+      config.tasks = atoi(argv[++i]);
+      continue;
+    }
+    if(!strcmp(argv[i], "-i")) {
+      config.index_launches = atoi(argv[++i]);
+      continue;
+    }
+    if(!strcmp(argv[i], "-p")) {
+      config.points = atoi(argv[++i]);
+      continue;
+    }
+    if(!strcmp(argv[i], "-depth")) {
+      config.max_depth = atoi(argv[++i]);
+      continue;
+    }
+    if(!strcmp(argv[i], "-fields")) {
+      config.max_fields = atoi(argv[++i]);
+      continue;
+    }
+    if(!strcmp(argv[i], "-a")) {
+      config.analysis_ops = atoi(argv[++i]);
+      continue;
+    }
+    if(!strcmp(argv[i], "-tl")) {
+      config.trace_length = atoi(argv[++i]);
+      continue;
+    }
+    if(!strcmp(argv[i], "-t")) {
+      config.trace_iters = atoi(argv[++i]);
+      continue;
+    }
+    if(!strcmp(argv[i], "-f")) {
+      config.futures = atoi(argv[++i]);
+      continue;
+    }
+  }
+  assert((config.tasks > 0) && (config.index_launches > 0) &&
+         (config.points > 0) && (config.max_depth >= 0) &&
+         (config.max_fields > 0) && (config.analysis_ops > 0) &&
+         (config.trace_length > 0) && (config.trace_iters > 0) &&
+         (config.futures > 0));
+
+  Runtime::set_top_level_task_id(TOP_LEVEL_TASK_ID);
+
+  {
+    TaskVariantRegistrar registrar(TOP_LEVEL_TASK_ID, "top_level");
+    registrar.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
+    Runtime::preregister_task_variant<top_level_task>(registrar, "top_level");
+  }
+
+  {
+    TaskVariantRegistrar registrar(EMPTY_TASK_ID, "empty");
+    registrar.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<empty_task>(registrar, "empty");
+  }
+
+  {
+    TaskVariantRegistrar registrar(VALUE_TASK_ID, "value");
+    registrar.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<int, value_task>(registrar, "value");
+  }
+
+  Runtime::add_registration_callback(update_mappers);
+
+  return Runtime::start(argc, argv);
+}
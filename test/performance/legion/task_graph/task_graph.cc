@@ -0,0 +1,694 @@
+/* Copyright 2017 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// synthetic task graphs for evaluating the runtime's scheduling, mapping
+//  and dependence analysis: each graph is a grid of tasks (width points
+//  by steps timesteps) whose dependences follow a pattern (stencil, FFT
+//  butterfly, reduction/broadcast tree or random DAG), and every task
+//  spins for a configurable duration after writing its piece of a
+//  region.  Dependences are expressed purely through region requirements
+//  on a disjoint partition (or an aliased one that adds overlap), so the
+//  runtime has to discover them.  For each graph we report the time to
+//  launch a task, the runtime overhead per task along the critical path,
+//  processor utilization, and the critical path itself.
+//
+// Graphs are described by a parameter file (see graphs.cfg) with one
+//  [name] section per graph, and any parameter can also be overridden
+//  for every graph on the command line (e.g. -steps 10).
+
+#include "legion.h"
+#include "default_mapper.h"
+#include "realm/timers.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+#include <cstring>
+#include <cctype>
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <algorithm>
+
+using namespace Legion;
+using namespace Legion::Mapping;
+using namespace LegionRuntime::Accessor;
+
+enum {
+  TOP_LEVEL_TASK_ID,
+  GRAPH_TASK_ID
+};
+
+enum {
+  FID_BASE = 100
+};
+
+enum Pattern {
+  PATTERN_TRIVIAL,
+  PATTERN_STENCIL,
+  PATTERN_FFT,
+  PATTERN_TREE,
+  PATTERN_RANDOM
+};
+
+static const char *pattern_names[] = {
+  "trivial", "stencil", "fft", "tree", "random"
+};
+
+struct GraphConfig {
+  std::string name;
+  Pattern pattern;
+  int width;           // points per timestep
+  int steps;           // timesteps
+  double duration_us;  // mean task duration
+  double imbalance;    // durations vary by up to this fraction either way
+  int elements;        // elements in each point's piece of the region
+  int fields;          // fields each task writes (and reads per input)
+  int radius;          // stencil: neighbors on each side
+  int fanin;           // random: inputs per task
+  int fanout;          // tree: branching factor, random: max readers per task
+  int span;            // random: how many steps back an input may come from
+  int overlap;         // inputs read through an aliased partition with this
+                       //  many extra elements on each side of a piece
+  bool blocked;        // map points to processors in blocks (vs. default)
+  unsigned seed;
+
+  GraphConfig(const std::string& _name)
+    : name(_name), pattern(PATTERN_STENCIL), width(16), steps(50),
+      duration_us(100), imbalance(0), elements(1024), fields(1),
+      radius(1), fanin(3), fanout(2), span(1), overlap(0),
+      blocked(true), seed(12345)
+  {}
+
+  // number of field groups the steps rotate through, enough that a group
+  //  isn't rewritten while a later step may still read it
+  int groups(void) const
+  {
+    return (pattern == PATTERN_RANDOM) ? (span + 1) : 2;
+  }
+};
+
+static std::vector<GraphConfig> graphs;
+
+static bool set_param(GraphConfig& config,
+                      const std::string& key, const std::string& value)
+{
+  const char *v = value.c_str();
+  if(key == "pattern") {
+    for(int i = 0; i <= PATTERN_RANDOM; i++)
+      if(value == pattern_names[i]) {
+        config.pattern = (Pattern)i;
+        return true;
+      }
+    fprintf(stderr, "unknown pattern '%s'\n", v);
+    exit(1);
+  }
+  if(key == "width")     { config.width = atoi(v); return true; }
+  if(key == "steps")     { config.steps = atoi(v); return true; }
+  if(key == "duration")  { config.duration_us = atof(v); return true; }
+  if(key == "imbalance") { config.imbalance = atof(v); return true; }
+  if(key == "elements")  { config.elements = atoi(v); return true; }
+  if(key == "fields")    { config.fields = atoi(v); return true; }
+  if(key == "radius")    { config.radius = atoi(v); return true; }
+  if(key == "fanin")     { config.fanin = atoi(v); return true; }
+  if(key == "fanout")    { config.fanout = atoi(v); return true; }
+  if(key == "span")      { config.span = atoi(v); return true; }
+  if(key == "overlap")   { config.overlap = atoi(v); return true; }
+  if(key == "blocked")   { config.blocked = (atoi(v) != 0); return true; }
+  if(key == "seed")      { config.seed = strtoul(v, 0, 0); return true; }
+  return false;
+}
+
+static const char *check_config(const GraphConfig& config)
+{
+  if((config.width < 1) || (config.steps < 1))
+    return "width and steps must be positive";
+  if((config.elements < 1) || (config.fields < 1))
+    return "elements and fields must be positive";
+  if((config.duration_us < 0) || (config.imbalance < 0) ||
+     (config.imbalance > 1))
+    return "duration must be non-negative and imbalance between 0 and 1";
+  if(config.overlap < 0)
+    return "overlap must be non-negative";
+  if((config.groups() * config.fields) > 256)
+    return "too many fields (fields * (span + 1) must be at most 256)";
+  switch(config.pattern) {
+  case PATTERN_STENCIL:
+    if(config.radius < 0)
+      return "stencil radius must be non-negative";
+    break;
+  case PATTERN_FFT:
+    if((config.width & (config.width - 1)) != 0)
+      return "fft width must be a power of two";
+    break;
+  case PATTERN_TREE:
+    if(config.fanout < 2)
+      return "tree fanout must be at least 2";
+    break;
+  case PATTERN_RANDOM:
+    if((config.fanin < 1) || (config.span < 1) || (config.fanout < 0))
+      return "random fanin and span must be positive";
+    break;
+  default:
+    break;
+  }
+  return 0;
+}
+
+// reads "key = value" lines, with a "[name]" line starting each graph
+static void read_param_file(const char *filename)
+{
+  std::ifstream f(filename);
+  if(!f) {
+    fprintf(stderr, "could not open parameter file '%s'\n", filename);
+    exit(1);
+  }
+  std::string line;
+  int lineno = 0;
+  while(std::getline(f, line)) {
+    lineno++;
+    size_t hash = line.find('#');
+    if(hash != std::string::npos)
+      line.erase(hash);
+    size_t start = line.find_first_not_of(" \t\r");
+    if(start == std::string::npos)
+      continue;
+    size_t end = line.find_last_not_of(" \t\r");
+    line = line.substr(start, end - start + 1);
+    if(line[0] == '[') {
+      if(line[line.size() - 1] != ']') {
+        fprintf(stderr, "%s:%d: malformed section header\n", filename, lineno);
+        exit(1);
+      }
+      graphs.push_back(GraphConfig(line.substr(1, line.size() - 2)));
+      continue;
+    }
+    size_t eq = line.find('=');
+    if((eq == std::string::npos) || graphs.empty()) {
+      fprintf(stderr, "%s:%d: expected 'key = value' inside a [graph]\n",
+              filename, lineno);
+      exit(1);
+    }
+    std::string key = line.substr(0, line.find_last_not_of(" \t", eq - 1) + 1);
+    std::string value = line.substr(std::min(line.size(),
+                                             line.find_first_not_of(" \t", eq + 1)));
+    if(!set_param(graphs.back(), key, value)) {
+      fprintf(stderr, "%s:%d: unknown parameter '%s'\n",
+              filename, lineno, key.c_str());
+      exit(1);
+    }
+  }
+}
+
+// deterministic per-task random numbers, independent of launch order
+static unsigned long long mix(unsigned long long x)
+{
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+static unsigned long long task_random(const GraphConfig& config,
+                                      int step, int point, int draw)
+{
+  return mix(mix(mix(config.seed) ^ step) ^ point) ^ mix(draw);
+}
+
+struct GraphNode {
+  int step, point;
+  long long duration_ns;
+  std::vector<int> inputs;  // nodes whose output this one reads
+  std::vector<int> preds;   // every node the runtime must order it after
+  long long busy_ns;        // measured
+};
+
+struct TaskGraph {
+  std::vector<GraphNode> nodes;
+  std::vector<std::vector<int> > ids;  // [step][point] -> node, or -1
+  long long dependences;
+};
+
+// the tree pattern alternates reducing to a single point over 'levels'
+//  steps and broadcasting back out over as many, so the active width
+//  shrinks and grows by the fanout each step
+static int tree_levels(const GraphConfig& config)
+{
+  int levels = 0;
+  for(long long w = 1; w < config.width; w *= config.fanout)
+    levels++;
+  return std::max(levels, 1);
+}
+
+static int ceil_div_pow(int width, int base, int exp)
+{
+  long long div = 1;
+  for(int i = 0; i < exp; i++)
+    div *= base;
+  return (int)((width + div - 1) / div);
+}
+
+static int active_width(const GraphConfig& config, int step)
+{
+  if((config.pattern != PATTERN_TREE) || (step == 0))
+    return config.width;
+  int levels = tree_levels(config);
+  int phase = (step - 1) % (2 * levels);
+  int level = (phase < levels) ? (phase + 1) : (2 * levels - 1 - phase);
+  return ceil_div_pow(config.width, config.fanout, level);
+}
+
+static void pattern_inputs(const GraphConfig& config, const TaskGraph& graph,
+                           std::vector<int>& reader_counts,
+                           int step, int point, std::vector<int>& inputs)
+{
+  inputs.clear();
+  if(step == 0)
+    return;
+  const std::vector<int>& prev = graph.ids[step - 1];
+  int prev_width = active_width(config, step - 1);
+  switch(config.pattern) {
+  case PATTERN_TRIVIAL:
+    break;
+  case PATTERN_STENCIL:
+    for(int j = std::max(0, point - config.radius);
+        j <= std::min(config.width - 1, point + config.radius);
+        j++)
+      inputs.push_back(prev[j]);
+    break;
+  case PATTERN_FFT:
+    {
+      int log_width = 0;
+      while((1 << log_width) < config.width)
+        log_width++;
+      inputs.push_back(prev[point]);
+      if(log_width > 0) {
+        int partner = point ^ (1 << ((step - 1) % log_width));
+        inputs.push_back(prev[partner]);
+      }
+      break;
+    }
+  case PATTERN_TREE:
+    {
+      int levels = tree_levels(config);
+      int phase = (step - 1) % (2 * levels);
+      if(phase < levels) {
+        // reduce: read our children
+        for(int j = point * config.fanout;
+            j < std::min(prev_width, (point + 1) * config.fanout);
+            j++)
+          inputs.push_back(prev[j]);
+      } else {
+        // broadcast: read our parent
+        inputs.push_back(prev[point / config.fanout]);
+      }
+      break;
+    }
+  case PATTERN_RANDOM:
+    {
+      // always depend on our own previous value, then draw the rest from
+      //  the last 'span' steps, skipping any that are already at fanout
+      inputs.push_back(prev[point]);
+      int oldest = std::max(0, step - config.span);
+      int tries = 0;
+      while(((int)inputs.size() < config.fanin) &&
+            (tries < 16 * config.fanin)) {
+        unsigned long long r = task_random(config, step, point, tries++);
+        int s = oldest + (int)(r % (step - oldest));
+        int j = (int)((r >> 32) % config.width);
+        int id = graph.ids[s][j];
+        if(std::find(inputs.begin(), inputs.end(), id) != inputs.end())
+          continue;
+        if((config.fanout > 0) && (reader_counts[id] >= config.fanout))
+          continue;
+        inputs.push_back(id);
+      }
+      for(size_t k = 0; k < inputs.size(); k++)
+        reader_counts[inputs[k]]++;
+      break;
+    }
+  }
+}
+
+// pieces covered by a read of 'point' (more than one with overlap)
+static void read_pieces(const GraphConfig& config, int point,
+                        int& first, int& last)
+{
+  long long lo = (long long)point * config.elements - config.overlap;
+  long long hi = (long long)(point + 1) * config.elements - 1 + config.overlap;
+  first = (int)std::max(0LL, lo / config.elements);
+  last = (int)std::min((long long)(config.width - 1), hi / config.elements);
+}
+
+static void build_graph(const GraphConfig& config, TaskGraph& graph)
+{
+  graph.nodes.clear();
+  graph.ids.assign(config.steps, std::vector<int>(config.width, -1));
+  graph.dependences = 0;
+
+  std::vector<int> reader_counts;
+  int groups = config.groups();
+  // the most recent writer and the readers since then of each piece, from
+  //  which the ordering the runtime has to enforce (true, anti and output
+  //  dependences) follows
+  std::vector<std::vector<int> > last_writer(groups,
+                                             std::vector<int>(config.width, -1));
+  std::vector<std::vector<std::vector<int> > > readers(groups,
+                       std::vector<std::vector<int> >(config.width));
+
+  for(int step = 0; step < config.steps; step++) {
+    int width = active_width(config, step);
+    for(int point = 0; point < width; point++) {
+      int id = graph.nodes.size();
+      graph.ids[step][point] = id;
+      graph.nodes.push_back(GraphNode());
+      reader_counts.push_back(0);
+      GraphNode& node = graph.nodes.back();
+      node.step = step;
+      node.point = point;
+      node.busy_ns = 0;
+      double jitter = 0;
+      if(config.imbalance > 0) {
+        unsigned long long r = task_random(config, step, point, -1);
+        jitter = config.imbalance * (2.0 * (r % 1000001) / 1000000.0 - 1.0);
+      }
+      node.duration_ns = (long long)(1000.0 * config.duration_us *
+                                     (1.0 + jitter));
+
+      pattern_inputs(config, graph, reader_counts, step, point, node.inputs);
+      graph.dependences += node.inputs.size();
+
+      for(size_t k = 0; k < node.inputs.size(); k++) {
+        const GraphNode& input = graph.nodes[node.inputs[k]];
+        int group = input.step % groups;
+        int first, last;
+        read_pieces(config, input.point, first, last);
+        for(int j = first; j <= last; j++) {
+          if(last_writer[group][j] >= 0)
+            node.preds.push_back(last_writer[group][j]);
+          readers[group][j].push_back(id);
+        }
+      }
+      int group = step % groups;
+      if(last_writer[group][point] >= 0)
+        node.preds.push_back(last_writer[group][point]);
+      node.preds.insert(node.preds.end(),
+                        readers[group][point].begin(),
+                        readers[group][point].end());
+      last_writer[group][point] = id;
+      readers[group][point].clear();
+
+      std::sort(node.preds.begin(), node.preds.end());
+      node.preds.erase(std::unique(node.preds.begin(), node.preds.end()),
+                       node.preds.end());
+    }
+  }
+}
+
+// longest path through the graph weighted by the measured task times;
+//  nodes are in launch order so every predecessor comes first
+static long long critical_path(const TaskGraph& graph, int& path_tasks)
+{
+  std::vector<long long> finish(graph.nodes.size(), 0);
+  std::vector<int> length(graph.nodes.size(), 0);
+  long long longest = 0;
+  path_tasks = 0;
+  for(size_t i = 0; i < graph.nodes.size(); i++) {
+    const GraphNode& node = graph.nodes[i];
+    long long start = 0;
+    int count = 0;
+    for(size_t k = 0; k < node.preds.size(); k++)
+      if(finish[node.preds[k]] > start) {
+        start = finish[node.preds[k]];
+        count = length[node.preds[k]];
+      }
+    finish[i] = start + node.busy_ns;
+    length[i] = count + 1;
+    if(finish[i] > longest) {
+      longest = finish[i];
+      path_tasks = length[i];
+    }
+  }
+  return longest;
+}
+
+// places point tasks (tagged with 1 + processor index) on the CPUs of the
+//  whole machine, and leaves everything else to the default mapper
+class GraphMapper : public DefaultMapper {
+public:
+  GraphMapper(MapperRuntime *rt, Machine machine, Processor local)
+    : DefaultMapper(rt, machine, local, "graph_mapper")
+  {
+    Machine::ProcessorQuery pq = Machine::ProcessorQuery(machine)
+      .only_kind(Processor::LOC_PROC);
+    cpus.assign(pq.begin(), pq.end());
+    std::sort(cpus.begin(), cpus.end());
+  }
+
+  virtual Processor default_policy_select_initial_processor(MapperContext ctx,
+                                                            const Task &task)
+  {
+    if((task.task_id == GRAPH_TASK_ID) && (task.tag > 0))
+      return cpus[(task.tag - 1) % cpus.size()];
+    return DefaultMapper::default_policy_select_initial_processor(ctx, task);
+  }
+
+protected:
+  std::vector<Processor> cpus;
+};
+
+static void update_mappers(Machine machine, Runtime *runtime,
+                           const std::set<Processor> &local_procs)
+{
+  for(std::set<Processor>::const_iterator it = local_procs.begin();
+      it != local_procs.end();
+      it++)
+    runtime->replace_default_mapper(new GraphMapper(runtime->get_mapper_runtime(),
+                                                    machine, *it),
+                                    *it);
+}
+
+struct GraphTaskArgs {
+  long long duration_ns;
+  long long value;
+};
+
+// writes our piece of each output field, then spins out the rest of the
+//  duration, and returns how long it was busy
+long long graph_task(const Task *task,
+                     const std::vector<PhysicalRegion> &regions,
+                     Context ctx, Runtime *runtime)
+{
+  const GraphTaskArgs& args = *(const GraphTaskArgs *)(task->args);
+  long long t0 = Realm::Clock::current_time_in_nanoseconds();
+
+  Rect<1> rect = runtime->get_index_space_domain(ctx,
+                    task->regions[0].region.get_index_space()).get_rect<1>();
+  for(std::set<FieldID>::const_iterator it = task->regions[0].privilege_fields.begin();
+      it != task->regions[0].privilege_fields.end();
+      it++) {
+    RegionAccessor<AccessorType::Generic, long long> acc =
+      regions[0].get_field_accessor(*it).typeify<long long>();
+    Rect<1> subrect;
+    ByteOffset offsets[1];
+    long long *ptr = acc.raw_rect_ptr<1>(rect, subrect, offsets);
+    assert((ptr != 0) && (subrect.volume() == rect.volume()));
+    for(coord_t x = rect.lo.x[0]; x <= rect.hi.x[0]; x++) {
+      *ptr = args.value;
+      ptr += offsets[0];
+    }
+  }
+
+  long long t1 = Realm::Clock::current_time_in_nanoseconds();
+  while((t1 - t0) < args.duration_ns)
+    t1 = Realm::Clock::current_time_in_nanoseconds();
+  return t1 - t0;
+}
+
+static void run_graph(const GraphConfig& config, Context ctx, Runtime *runtime)
+{
+  TaskGraph graph;
+  build_graph(config, graph);
+  int num_cpus = Machine::ProcessorQuery(Machine::get_machine())
+    .only_kind(Processor::LOC_PROC).count();
+
+  // one region with a piece per point, and fields for each group
+  int groups = config.groups();
+  Rect<1> elems(Point<1>(0),
+                Point<1>((long long)config.width * config.elements - 1));
+  IndexSpace is = runtime->create_index_space(ctx, Domain::from_rect<1>(elems));
+  FieldSpace fs = runtime->create_field_space(ctx);
+  {
+    FieldAllocator allocator = runtime->create_field_allocator(ctx, fs);
+    for(int f = 0; f < groups * config.fields; f++)
+      allocator.allocate_field(sizeof(long long), FID_BASE + f);
+  }
+  LogicalRegion lr = runtime->create_logical_region(ctx, is, fs);
+  Rect<1> colors(Point<1>(0), Point<1>(config.width - 1));
+  Domain color_space = Domain::from_rect<1>(colors);
+  IndexPartition ip_disjoint = runtime->create_equal_partition(ctx, is,
+                                                               color_space);
+  LogicalPartition lp_disjoint = runtime->get_logical_partition(ctx, lr,
+                                                                ip_disjoint);
+  LogicalPartition lp_read = lp_disjoint;
+  if(config.overlap > 0) {
+    DomainPointColoring coloring;
+    for(int i = 0; i < config.width; i++) {
+      long long lo = (long long)i * config.elements - config.overlap;
+      long long hi = (long long)(i + 1) * config.elements - 1 + config.overlap;
+      Rect<1> piece(Point<1>(std::max(lo, 0LL)),
+                    Point<1>(std::min(hi, (long long)elems.hi.x[0])));
+      coloring[DomainPoint::from_point<1>(Point<1>(i))] =
+        Domain::from_rect<1>(piece);
+    }
+    IndexPartition ip_aliased = runtime->create_index_partition(ctx, is,
+                                                                color_space,
+                                                                coloring,
+                                                                ALIASED_KIND);
+    lp_read = runtime->get_logical_partition(ctx, lr, ip_aliased);
+  }
+
+  std::vector<Future> futures;
+  futures.reserve(graph.nodes.size());
+  long long t0 = Realm::Clock::current_time_in_nanoseconds();
+  for(size_t i = 0; i < graph.nodes.size(); i++) {
+    const GraphNode& node = graph.nodes[i];
+    GraphTaskArgs args;
+    args.duration_ns = node.duration_ns;
+    args.value = i;
+    MappingTagID tag = 0;
+    if(config.blocked)
+      tag = 1 + (((long long)node.point * num_cpus) / config.width);
+    TaskLauncher launcher(GRAPH_TASK_ID, TaskArgument(&args, sizeof(args)),
+                          Predicate::TRUE_PRED, 0 /*default mapper*/, tag);
+    RegionRequirement out(runtime->get_logical_subregion_by_color(ctx,
+                                                  lp_disjoint, node.point),
+                          WRITE_DISCARD, EXCLUSIVE, lr);
+    int out_group = node.step % groups;
+    for(int f = 0; f < config.fields; f++)
+      out.add_field(FID_BASE + out_group * config.fields + f);
+    launcher.add_region_requirement(out);
+    for(size_t k = 0; k < node.inputs.size(); k++) {
+      const GraphNode& input = graph.nodes[node.inputs[k]];
+      RegionRequirement in(runtime->get_logical_subregion_by_color(ctx,
+                                                  lp_read, input.point),
+                           READ_ONLY, EXCLUSIVE, lr);
+      int in_group = input.step % groups;
+      for(int f = 0; f < config.fields; f++)
+        in.add_field(FID_BASE + in_group * config.fields + f);
+      launcher.add_region_requirement(in);
+    }
+    futures.push_back(runtime->execute_task(ctx, launcher));
+  }
+  long long t1 = Realm::Clock::current_time_in_nanoseconds();
+  for(size_t i = 0; i < futures.size(); i++)
+    graph.nodes[i].busy_ns = futures[i].get_result<long long>();
+  long long t2 = Realm::Clock::current_time_in_nanoseconds();
+
+  long long work_ns = 0;
+  for(size_t i = 0; i < graph.nodes.size(); i++)
+    work_ns += graph.nodes[i].busy_ns;
+  int path_tasks;
+  long long path_ns = critical_path(graph, path_tasks);
+  long long elapsed_ns = t2 - t0;
+  double launch_us = (t1 - t0) / (1000.0 * graph.nodes.size());
+  // whatever the elapsed time has beyond the critical path is runtime
+  //  overhead (and, with too few processors, queueing behind other work)
+  double overhead_us = (elapsed_ns - path_ns) / (1000.0 * path_tasks);
+  double utilization = (100.0 * work_ns) / ((double)elapsed_ns * num_cpus);
+  double bound_ns = std::max((double)path_ns, (double)work_ns / num_cpus);
+
+  printf("graph %s: pattern=%s width=%d steps=%d tasks=%d dependences=%lld"
+         " elements=%d fields=%d overlap=%d cpus=%d\n",
+         config.name.c_str(), pattern_names[config.pattern], config.width,
+         config.steps, (int)graph.nodes.size(), graph.dependences,
+         config.elements, config.fields, config.overlap, num_cpus);
+  printf("  elapsed = %10.3f ms  launch = %8.2f us/task  work = %10.3f ms\n",
+         1e-6 * elapsed_ns, launch_us, 1e-6 * work_ns);
+  printf("  critical path = %10.3f ms over %d tasks  overhead = %8.2f us/task\n",
+         1e-6 * path_ns, path_tasks, overhead_us);
+  printf("  utilization = %5.1f%%  efficiency = %5.1f%% of bound %.3f ms\n",
+         utilization, (100.0 * bound_ns) / elapsed_ns, 1e-6 * bound_ns);
+
+  // summary lines for perf.py
+  std::string label = config.name;
+  for(size_t i = 0; i < label.size(); i++)
+    label[i] = toupper(label[i]);
+  printf("%s LAUNCH = %.2f us\n", label.c_str(), launch_us);
+  printf("%s OVERHEAD = %.2f us\n", label.c_str(), overhead_us);
+  printf("%s UTILIZATION = %.1f %%\n", label.c_str(), utilization);
+  printf("%s CRITICAL PATH = %.3f ms\n", label.c_str(), 1e-6 * path_ns);
+  fflush(stdout);
+
+  runtime->destroy_logical_region(ctx, lr);
+  runtime->destroy_field_space(ctx, fs);
+  runtime->destroy_index_space(ctx, is);
+}
+
+void top_level_task(const Task *task,
+                    const std::vector<PhysicalRegion> &regions,
+                    Context ctx, Runtime *runtime)
+{
+  for(size_t i = 0; i < graphs.size(); i++)
+    run_graph(graphs[i], ctx, runtime);
+}
+
+int main(int argc, char **argv)
+{
+  // the parameter file comes first, then overrides apply to every graph
+  for(int i = 1; i < argc; i++)
+    if(!strcmp(argv[i], "-f") && ((i + 1) < argc))
+      read_param_file(argv[i + 1]);
+  if(graphs.empty())
+    graphs.push_back(GraphConfig("default"));
+  for(int i = 1; (i + 1) < argc; i++) {
+    if(argv[i][0] != '-')
+      continue;
+    // Legion and Realm flags are skipped since no parameter matches them
+    bool matched = false;
+    for(size_t g = 0; g < graphs.size(); g++)
+      matched = set_param(graphs[g], argv[i] + 1, argv[i + 1]) || matched;
+    if(matched)
+      i++;
+  }
+  for(size_t g = 0; g < graphs.size(); g++) {
+    const char *error = check_config(graphs[g]);
+    if(error != 0) {
+      fprintf(stderr, "graph %s: %s\n", graphs[g].name.c_str(), error);
+      return 1;
+    }
+  }
+
+  Runtime::set_top_level_task_id(TOP_LEVEL_TASK_ID);
+
+  {
+    TaskVariantRegistrar registrar(TOP_LEVEL_TASK_ID, "top_level");
+    registrar.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
+    Runtime::preregister_task_variant<top_level_task>(registrar, "top_level");
+  }
+
+  {
+    TaskVariantRegistrar registrar(GRAPH_TASK_ID, "graph_task");
+    registrar.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<long long, graph_task>(registrar,
+                                                             "graph_task");
+  }
+
+  Runtime::add_registration_callback(update_mappers);
+
+  return Runtime::start(argc, argv);
+}
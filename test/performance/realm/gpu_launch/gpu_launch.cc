@@ -0,0 +1,187 @@
+/* Copyright 2017 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// measures end-to-end GPU task launch latency: the time from spawning a
+//  task that launches an empty kernel on a GPU processor until the task's
+//  completion event is observed, for a range of task argument sizes
+
+#include "realm/realm.h"
+#include "realm/timers.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+#include <cstring>
+
+#include <vector>
+#include <algorithm>
+
+using namespace Realm;
+
+Logger log_app("app");
+
+// TASK IDs
+enum {
+  TOP_LEVEL_TASK = Processor::TASK_ID_FIRST_AVAILABLE+0,
+  LAUNCH_TASK    = Processor::TASK_ID_FIRST_AVAILABLE+1,
+};
+
+#ifdef USE_CUDA
+extern "C" {
+  void gpu_launch_empty_kernel(void);
+}
+#endif
+
+struct TestConfig {
+  int samples;
+  int warmup;
+  size_t min_arg_size;
+  size_t max_arg_size;
+};
+
+static TestConfig config = { 1000, 100, 0, 65536 };
+
+// samples are taken one at a time, so the launch task can just leave its
+//  start time here
+static volatile long long last_task_start = 0;
+
+void launch_task(const void *args, size_t arglen,
+		 const void *userdata, size_t userlen, Processor p)
+{
+  last_task_start = Clock::current_time_in_nanoseconds();
+#ifdef USE_CUDA
+  gpu_launch_empty_kernel();
+#endif
+}
+
+static double percentile_us(std::vector<long long>& times, int pct)
+{
+  assert(!times.empty());
+  std::sort(times.begin(), times.end());
+  size_t idx = ((times.size() - 1) * pct) / 100;
+  return 1e-3 * times[idx];
+}
+
+void top_level_task(const void *args, size_t arglen,
+		    const void *userdata, size_t userlen, Processor p)
+{
+  std::vector<Processor> gpus;
+  Machine::ProcessorQuery pq = Machine::ProcessorQuery(Machine::get_machine())
+    .only_kind(Processor::TOC_PROC);
+  for(Machine::ProcessorQuery::iterator it = pq.begin(); it; ++it)
+    gpus.push_back(*it);
+
+  if(gpus.empty()) {
+    log_app.print() << "no GPU processors found - nothing to measure";
+    return;
+  }
+
+  std::vector<char> argbuf(config.max_arg_size + 1, 0);
+  std::vector<long long> all_totals;
+
+  for(std::vector<Processor>::const_iterator it = gpus.begin();
+      it != gpus.end();
+      it++) {
+    Processor gpu = *it;
+
+    size_t arg_size = config.min_arg_size;
+    while(arg_size <= config.max_arg_size) {
+      std::vector<long long> to_start, totals;
+      to_start.reserve(config.samples);
+      totals.reserve(config.samples);
+
+      for(int i = -config.warmup; i < config.samples; i++) {
+	long long t_spawn = Clock::current_time_in_nanoseconds();
+	Event e = gpu.spawn(LAUNCH_TASK, &argbuf[0], arg_size);
+	e.wait();
+	long long t_done = Clock::current_time_in_nanoseconds();
+
+	if(i < 0) continue;
+	to_start.push_back(last_task_start - t_spawn);
+	totals.push_back(t_done - t_spawn);
+      }
+
+      all_totals.insert(all_totals.end(), totals.begin(), totals.end());
+
+      printf("gpu %llx: args = %7zd B  start p50 = %8.3f us  p99 = %8.3f us  complete p50 = %8.3f us  p99 = %8.3f us\n",
+	     (unsigned long long)gpu.id, arg_size,
+	     percentile_us(to_start, 50), percentile_us(to_start, 99),
+	     percentile_us(totals, 50), percentile_us(totals, 99));
+
+      if(arg_size == config.max_arg_size) break;
+      arg_size = std::min(config.max_arg_size, (arg_size ? (arg_size * 4) : 64));
+    }
+  }
+
+  // summary over everything measured (perf.py picks these up)
+  printf("LAUNCH P50 = %.3f us\n", percentile_us(all_totals, 50));
+  printf("LAUNCH P99 = %.3f us\n", percentile_us(all_totals, 99));
+  fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+  Runtime rt;
+
+  bool ok = rt.init(&argc, &argv);
+  assert(ok);
+
+  for(int i = 1; i < argc; i++) {
+    if(!strcmp(argv[i], "-n")) {
+      config.samples = atoi(argv[++i]);
+      continue;
+    }
+    if(!strcmp(argv[i], "-w")) {
+      config.warmup = atoi(argv[++i]);
+      continue;
+    }
+    if(!strcmp(argv[i], "-a")) {
+      config.min_arg_size = strtoll(argv[++i], 0, 10);
+      continue;
+    }
+    if(!strcmp(argv[i], "-A")) {
+      config.max_arg_size = strtoll(argv[++i], 0, 10);
+      continue;
+    }
+  }
+  assert(config.samples > 0);
+  if(config.max_arg_size < config.min_arg_size)
+    config.max_arg_size = config.min_arg_size;
+
+  rt.register_task(TOP_LEVEL_TASK, top_level_task);
+
+  Processor::register_task_by_kind(Processor::TOC_PROC, false /*!global*/,
+				   LAUNCH_TASK,
+				   CodeDescriptor(launch_task),
+				   ProfilingRequestSet(),
+				   0, 0).wait();
+
+  // select a processor to run the top level task on
+  Processor p = Machine::ProcessorQuery(Machine::get_machine())
+    .only_kind(Processor::LOC_PROC)
+    .first();
+  assert(p.exists());
+
+  // collective launch of a single task - everybody gets the same finish event
+  Event e = rt.collective_spawn(p, TOP_LEVEL_TASK, 0, 0);
+
+  // request shutdown once that task is complete
+  rt.shutdown(e);
+
+  // now sleep this thread until that shutdown actually happens
+  rt.wait_for_shutdown();
+
+  return 0;
+}
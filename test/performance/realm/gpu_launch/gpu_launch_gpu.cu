@@ -0,0 +1,28 @@
+/* Copyright 2017 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+extern "C" {
+  void gpu_launch_empty_kernel(void);
+}
+
+__global__ void empty_kernel(void)
+{
+}
+
+// launched on the default stream, which Realm maps to the task's stream
+void gpu_launch_empty_kernel(void)
+{
+  empty_kernel<<< 1, 1 >>>();
+}
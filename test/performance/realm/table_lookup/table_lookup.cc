@@ -0,0 +1,175 @@
+/* Copyright 2017 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// measures concurrent lookup throughput of populated entries in a Realm
+//  DynamicTable, the structure behind event, barrier and reservation ID
+//  resolution, for a range of thread counts - the same lookups serialized
+//  by a single lock are measured as a baseline
+
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+#include <cstring>
+
+#include <pthread.h>
+
+#include "realm/dynamic_table.h"
+#include "realm/timers.h"
+
+using namespace Realm;
+
+struct TestConfig {
+  int max_threads;
+  int entries;
+  long long lookups;
+};
+
+static TestConfig config = { 64, 1 << 20, 1 << 22 };
+
+class Mutex {
+public:
+  Mutex(void) { pthread_mutex_init(&mutex, 0); }
+  ~Mutex(void) { pthread_mutex_destroy(&mutex); }
+  void lock(void) { pthread_mutex_lock(&mutex); }
+  void unlock(void) { pthread_mutex_unlock(&mutex); }
+protected:
+  pthread_mutex_t mutex;
+};
+
+struct Entry {
+  int value;
+  Entry *next_free;
+};
+
+// same shape as the runtime's table allocators
+struct TestTableAllocator {
+  typedef Entry ET;
+  static const size_t INNER_BITS = 10;
+  static const size_t LEAF_BITS = 8;
+
+  typedef Mutex LT;
+  typedef int IT;
+  typedef DynamicTableNode<DynamicTableNodeBase<LT, IT> *, 1 << INNER_BITS, LT, IT> INNER_TYPE;
+  typedef DynamicTableNode<ET, 1 << LEAF_BITS, LT, IT> LEAF_TYPE;
+  typedef DynamicTableFreeList<TestTableAllocator> FreeList;
+
+  static LEAF_TYPE *new_leaf_node(IT first_index, IT last_index,
+				  int owner, FreeList *free_list)
+  {
+    LEAF_TYPE *leaf = new LEAF_TYPE(0, first_index, last_index);
+    for(IT i = 0; i <= (last_index - first_index); i++) {
+      leaf->elems[i].value = first_index + i;
+      leaf->elems[i].next_free = 0;
+    }
+    return leaf;
+  }
+};
+
+static DynamicTable<TestTableAllocator> table;
+static Mutex baseline_lock;
+
+struct ThreadArgs {
+  int seed;
+  bool locked;
+  long long checksum;
+};
+
+static void *lookup_thread(void *data)
+{
+  ThreadArgs *args = static_cast<ThreadArgs *>(data);
+  unsigned x = args->seed * 2654435761U + 1;
+  long long checksum = 0;
+  for(long long i = 0; i < config.lookups; i++) {
+    // xorshift, to keep the index stream cheap and unpredictable
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    int index = x % config.entries;
+    if(args->locked)
+      baseline_lock.lock();
+    Entry *e = table.lookup_entry(index, 0 /*owner*/);
+    if(args->locked)
+      baseline_lock.unlock();
+    checksum += e->value;
+  }
+  args->checksum = checksum;
+  return 0;
+}
+
+static double measure(int threads, bool locked)
+{
+  pthread_t *tids = new pthread_t[threads];
+  ThreadArgs *args = new ThreadArgs[threads];
+
+  long long t_start = Clock::current_time_in_nanoseconds();
+  for(int i = 0; i < threads; i++) {
+    args[i].seed = i;
+    args[i].locked = locked;
+    args[i].checksum = 0;
+    int ret = pthread_create(&tids[i], 0, lookup_thread, &args[i]);
+    assert(ret == 0);
+  }
+  for(int i = 0; i < threads; i++)
+    pthread_join(tids[i], 0);
+  long long t_end = Clock::current_time_in_nanoseconds();
+
+  delete[] tids;
+  delete[] args;
+
+  // millions of lookups per second
+  return (1e3 * threads * config.lookups) / (t_end - t_start);
+}
+
+int main(int argc, char **argv)
+{
+  for(int i = 1; i < argc; i++) {
+    if(!strcmp(argv[i], "-t")) {
+      config.max_threads = atoi(argv[++i]);
+      continue;
+    }
+    if(!strcmp(argv[i], "-e")) {
+      config.entries = atoi(argv[++i]);
+      continue;
+    }
+    if(!strcmp(argv[i], "-l")) {
+      config.lookups = strtoll(argv[++i], 0, 10);
+      continue;
+    }
+  }
+  assert((config.max_threads > 0) && (config.entries > 0));
+
+  // populate the whole table up front so every measured lookup hits
+  for(int i = 0; i < config.entries; i++)
+    table.lookup_entry(i, 0 /*owner*/);
+
+  double lockfree_rate = 0, locked_rate = 0;
+  int threads = 1;
+  while(true) {
+    lockfree_rate = measure(threads, false /*!locked*/);
+    locked_rate = measure(threads, true /*locked*/);
+    printf("threads = %3d  lock-free = %9.2f M/s  locked = %9.2f M/s\n",
+	   threads, lockfree_rate, locked_rate);
+
+    if(threads >= config.max_threads) break;
+    threads = ((threads * 2) < config.max_threads) ? (threads * 2) : config.max_threads;
+  }
+
+  // summary at the maximum thread count (perf.py picks these up)
+  printf("LOOKUP RATE = %.2f M/s\n", lockfree_rate);
+  printf("LOCKED RATE = %.2f M/s\n", locked_rate);
+  fflush(stdout);
+
+  return 0;
+}
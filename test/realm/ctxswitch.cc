@@ -91,6 +91,7 @@ static int num_iterations = 100000;
 static int timeout_seconds = 10;
 static int sleep_useconds = 500000;
 static int concurrent_io = 1;
+static int fast_uswitch = 1;
 
 void top_level_task(const void *args, size_t arglen, 
 		    const void *userdata, size_t userlen, Processor p)
@@ -153,8 +154,10 @@ void top_level_task(const void *args, size_t arglen,
 
 	double elapsed = t_end - t_start;
 	double ns_per_switch = 1e9 * elapsed / num_iterations / num_children;
-	printf("switch: proc " IDFMT " (kind=%d) finished: elapsed=%5.2fs time/switch=%6.0fns\n",
-               pp.id, k, elapsed, ns_per_switch);
+	// run with "-realm:fastuswitch 0" to compare against swapcontext
+	printf("switch: proc " IDFMT " (kind=%d) finished: elapsed=%5.2fs time/switch=%6.0fns uswitch=%s\n",
+               pp.id, k, elapsed, ns_per_switch,
+	       (fast_uswitch ? "fast" : "ucontext"));
       }
 
       // now the sleep (i.e. kernel-level switching, if possible) test
@@ -241,6 +244,11 @@ int main(int argc, char **argv)
       concurrent_io = atoi(argv[++i]);
       continue;
     }
+
+    if(!strcmp(argv[i], "-realm:fastuswitch")) {
+      fast_uswitch = atoi(argv[++i]);
+      continue;
+    }
   }
 
   rt.register_task(TOP_LEVEL_TASK, top_level_task);
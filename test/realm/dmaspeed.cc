@@ -0,0 +1,379 @@
+#include "realm/realm.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+#include <cstring>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+
+#include <unistd.h>
+
+using namespace Realm;
+
+// for Point<DIM> and Rect<DIM>
+using namespace LegionRuntime::Arrays;
+
+Logger log_app("app");
+
+// Task IDs, some IDs are reserved so start at first available number
+enum {
+  TOP_LEVEL_TASK = Processor::TASK_ID_FIRST_AVAILABLE+0,
+};
+
+// the shapes of copy that are timed for every pair of memories
+enum CopyLayout {
+  LAYOUT_CONTIGUOUS,  // one field, dense 1-D
+  LAYOUT_STRIDED,     // left half of the columns of a 2-D instance
+  LAYOUT_AOS_TO_SOA,  // four fields, interleaved source, blocked target
+  LAYOUT_SPARSE,      // every other element of an unstructured space
+  NUM_LAYOUTS
+};
+
+static const char *layout_names[NUM_LAYOUTS] = {
+  "contig", "strided", "aos-soa", "sparse"
+};
+
+struct TestConfig {
+  size_t min_size;
+  size_t max_size;
+  int reps;
+  const char *file_dir;
+  const char *csv_file;
+};
+
+static TestConfig config = { 8, 64 << 20, 4, "/tmp", 0 };
+
+static const size_t ELEM_SIZE = sizeof(long long);
+static const size_t AOS_FIELDS = 4;
+static const size_t STRIDED_COLS = 64;
+
+static const char *memory_kind_name(Memory::Kind kind)
+{
+  switch(kind) {
+  case Memory::GLOBAL_MEM: return "global";
+  case Memory::SYSTEM_MEM: return "sysmem";
+  case Memory::REGDMA_MEM: return "regmem";
+  case Memory::SOCKET_MEM: return "socket";
+  case Memory::Z_COPY_MEM: return "zcopy";
+  case Memory::GPU_FB_MEM: return "fb";
+  case Memory::DISK_MEM: return "disk";
+  case Memory::HDF_MEM: return "hdf5";
+  case Memory::FILE_MEM: return "file";
+  case Memory::LEVEL3_CACHE: return "l3";
+  case Memory::LEVEL2_CACHE: return "l2";
+  case Memory::LEVEL1_CACHE: return "l1";
+  case Memory::GPU_MANAGED_MEM: return "managed";
+  default: return "unknown";
+  }
+}
+
+// an instance plus the backing file, if it lives in a file memory
+struct TestInstance {
+  RegionInstance inst;
+  std::string filename;
+};
+
+static TestInstance create_test_instance(Domain d, Memory m,
+					 const std::vector<size_t>& field_sizes,
+					 size_t block_size)
+{
+  TestInstance ti;
+  if(m.kind() == Memory::FILE_MEM) {
+    // file instances are always laid out one field after another
+    static int file_count = 0;
+    char filename[256];
+    snprintf(filename, sizeof(filename), "%s/dmaspeed_%d_%d.dat",
+	     config.file_dir, (int)getpid(), file_count++);
+    ti.filename = filename;
+    ti.inst = d.create_file_instance(filename, field_sizes, LEGION_FILE_CREATE);
+  } else
+    ti.inst = d.create_instance(m, field_sizes, block_size);
+  return ti;
+}
+
+static void destroy_test_instance(TestInstance& ti)
+{
+  ti.inst.destroy();
+  if(!ti.filename.empty())
+    unlink(ti.filename.c_str());
+}
+
+// instance bytes needed for a copy of 'bytes' bytes with the given layout
+static size_t footprint(CopyLayout layout, size_t bytes)
+{
+  switch(layout) {
+  case LAYOUT_STRIDED:
+  case LAYOUT_SPARSE:
+    return 2 * bytes;
+  default:
+    return bytes;
+  }
+}
+
+// times copies of 'bytes' bytes from 'src' to 'dst', returning the
+//  average in microseconds or a negative value if it couldn't be run
+static double time_copy(Memory src, Memory dst, CopyLayout layout,
+			size_t bytes)
+{
+  Domain inst_domain, copy_domain;
+  IndexSpace sparse_parent = IndexSpace::NO_SPACE;
+  IndexSpace sparse_child = IndexSpace::NO_SPACE;
+  size_t num_fields = 1;
+  size_t src_block = 0, dst_block = 0;
+
+  switch(layout) {
+  case LAYOUT_CONTIGUOUS:
+    {
+      size_t n = std::max(bytes / ELEM_SIZE, (size_t)1);
+      inst_domain = Domain::from_rect<1>(Rect<1>(0, n - 1));
+      copy_domain = inst_domain;
+      src_block = dst_block = n;
+      break;
+    }
+  case LAYOUT_STRIDED:
+    {
+      size_t rows = std::max(bytes / (ELEM_SIZE * STRIDED_COLS), (size_t)1);
+      Point<2> lo = make_point(0, 0);
+      inst_domain = Domain::from_rect<2>(Rect<2>(lo, make_point(rows - 1,
+							     2 * STRIDED_COLS - 1)));
+      copy_domain = Domain::from_rect<2>(Rect<2>(lo, make_point(rows - 1,
+							     STRIDED_COLS - 1)));
+      src_block = dst_block = inst_domain.get_volume();
+      break;
+    }
+  case LAYOUT_AOS_TO_SOA:
+    {
+      // file instances can't be interleaved
+      if((src.kind() == Memory::FILE_MEM) || (dst.kind() == Memory::FILE_MEM))
+	return -1;
+      size_t n = std::max(bytes / (ELEM_SIZE * AOS_FIELDS), (size_t)1);
+      inst_domain = Domain::from_rect<1>(Rect<1>(0, n - 1));
+      copy_domain = inst_domain;
+      num_fields = AOS_FIELDS;
+      src_block = 1;
+      dst_block = n;
+      break;
+    }
+  case LAYOUT_SPARSE:
+    {
+      size_t n = std::max(bytes / ELEM_SIZE, (size_t)1);
+      sparse_parent = IndexSpace::create_index_space(2 * n);
+      ElementMask mask(2 * n);
+      for(size_t i = 0; i < n; i++)
+	mask.enable(2 * i);
+      sparse_child = IndexSpace::create_index_space(sparse_parent, mask,
+						    false /*!allocable*/);
+      inst_domain = Domain(sparse_parent);
+      copy_domain = Domain(sparse_child);
+      src_block = dst_block = 2 * n;
+      break;
+    }
+  default:
+    assert(0);
+  }
+
+  std::vector<size_t> field_sizes(num_fields, ELEM_SIZE);
+  TestInstance src_inst = create_test_instance(inst_domain, src, field_sizes,
+					       src_block);
+  TestInstance dst_inst = create_test_instance(inst_domain, dst, field_sizes,
+					       dst_block);
+  double result = -1;
+  if(src_inst.inst.exists() && dst_inst.inst.exists()) {
+    std::vector<Domain::CopySrcDstField> srcs, dsts;
+    for(size_t f = 0; f < num_fields; f++) {
+      srcs.push_back(Domain::CopySrcDstField(src_inst.inst, f * ELEM_SIZE,
+					     ELEM_SIZE));
+      dsts.push_back(Domain::CopySrcDstField(dst_inst.inst, f * ELEM_SIZE,
+					     ELEM_SIZE));
+    }
+    long long fill_value = 0;
+    inst_domain.fill(srcs, &fill_value, sizeof(fill_value)).wait();
+
+    // the first copy pays for any lazy setup in the DMA paths
+    copy_domain.copy(srcs, dsts).wait();
+    long long t1 = Clock::current_time_in_nanoseconds();
+    for(int r = 0; r < config.reps; r++)
+      copy_domain.copy(srcs, dsts).wait();
+    long long t2 = Clock::current_time_in_nanoseconds();
+    result = 1e-3 * (t2 - t1) / config.reps;
+  } else
+    log_app.info() << "could not create instances in " << src << " and " << dst;
+
+  if(src_inst.inst.exists())
+    destroy_test_instance(src_inst);
+  if(dst_inst.inst.exists())
+    destroy_test_instance(dst_inst);
+  if(sparse_child.exists())
+    sparse_child.destroy();
+  if(sparse_parent.exists())
+    sparse_parent.destroy();
+  return result;
+}
+
+static void print_matrix(const char *title, const std::vector<Memory>& mems,
+			 const std::map<std::pair<Memory, Memory>, double>& values)
+{
+  log_app.print() << title;
+  std::string header = "          ";
+  for(size_t j = 0; j < mems.size(); j++) {
+    char label[16], buf[16];
+    snprintf(label, sizeof(label), "M%zd", j);
+    snprintf(buf, sizeof(buf), " %9s", label);
+    header += buf;
+  }
+  log_app.print() << header;
+  for(size_t i = 0; i < mems.size(); i++) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "M%-9zd", i);
+    std::string line = buf;
+    for(size_t j = 0; j < mems.size(); j++) {
+      std::map<std::pair<Memory, Memory>, double>::const_iterator it =
+	values.find(std::make_pair(mems[i], mems[j]));
+      if(it != values.end())
+	snprintf(buf, sizeof(buf), " %9.2f", it->second);
+      else
+	snprintf(buf, sizeof(buf), " %9s", "-");
+      line += buf;
+    }
+    log_app.print() << line;
+  }
+}
+
+void top_level_task(const void *args, size_t arglen,
+		    const void *userdata, size_t userlen, Processor p)
+{
+  log_app.print() << "Realm DMA speed test";
+
+  // every memory in the machine, on every node, is both a source and a
+  //  target - HDF5 memories are skipped since their instances have to be
+  //  backed by existing datasets
+  Machine machine = Machine::get_machine();
+  std::vector<Memory> mems;
+  for(Machine::MemoryQuery::iterator it = Machine::MemoryQuery(machine).begin(); it; ++it) {
+    Memory m = *it;
+    if(m.kind() == Memory::HDF_MEM) {
+      log_app.info() << "skipping memory " << m << " (kind=" << m.kind() << ") - needs HDF5 datasets";
+      continue;
+    }
+    if(m.capacity() < config.min_size * 4) {
+      log_app.info() << "skipping memory " << m << " (kind=" << m.kind() << ") - insufficient capacity";
+      continue;
+    }
+    log_app.print() << "M" << mems.size() << ": " << m
+		    << " kind=" << memory_kind_name(m.kind())
+		    << " node=" << m.address_space()
+		    << " capacity=" << m.capacity();
+    mems.push_back(m);
+  }
+
+  FILE *csv = 0;
+  if(config.csv_file) {
+    csv = fopen(config.csv_file, "w");
+    assert(csv != 0);
+    fprintf(csv, "src,src_kind,src_node,dst,dst_kind,dst_node,layout,bytes,time_us,gb_per_s\n");
+  }
+
+  // per layout: latency of the smallest copy and bandwidth of the largest
+  std::vector<std::map<std::pair<Memory, Memory>, double> > latency(NUM_LAYOUTS);
+  std::vector<std::map<std::pair<Memory, Memory>, double> > bandwidth(NUM_LAYOUTS);
+
+  for(size_t i = 0; i < mems.size(); i++)
+    for(size_t j = 0; j < mems.size(); j++) {
+      Memory src = mems[i];
+      Memory dst = mems[j];
+      // each memory holds its instance, or both of them if src == dst, and
+      //  leave headroom for anything else that's allocated there
+      size_t capacity = std::min(src.capacity(), dst.capacity()) / 4;
+      for(int l = 0; l < NUM_LAYOUTS; l++) {
+	CopyLayout layout = (CopyLayout)l;
+	for(size_t bytes = config.min_size; bytes <= config.max_size; bytes *= 16) {
+	  if(footprint(layout, bytes) > capacity)
+	    break;
+	  double us = time_copy(src, dst, layout, bytes);
+	  if(us < 0)
+	    break;
+	  double gbps = 1e-3 * bytes / us;
+	  log_app.print() << "M" << i << " -> M" << j
+			  << " layout=" << layout_names[l]
+			  << " bytes=" << bytes
+			  << " time=" << us << " us"
+			  << " bw=" << gbps << " GB/s";
+	  if(csv)
+	    fprintf(csv, "%llx,%s,%d,%llx,%s,%d,%s,%zd,%.3f,%.3f\n",
+		    (unsigned long long)src.id, memory_kind_name(src.kind()),
+		    (int)src.address_space(),
+		    (unsigned long long)dst.id, memory_kind_name(dst.kind()),
+		    (int)dst.address_space(),
+		    layout_names[l], bytes, us, gbps);
+	  std::pair<Memory, Memory> key(src, dst);
+	  if(latency[l].count(key) == 0)
+	    latency[l][key] = us;
+	  bandwidth[l][key] = gbps;
+	}
+      }
+    }
+
+  if(csv)
+    fclose(csv);
+
+  for(int l = 0; l < NUM_LAYOUTS; l++) {
+    std::string title = std::string("latency (us), layout=") + layout_names[l] + ", rows are sources:";
+    print_matrix(title.c_str(), mems, latency[l]);
+    title = std::string("bandwidth (GB/s), layout=") + layout_names[l] + ", rows are sources:";
+    print_matrix(title.c_str(), mems, bandwidth[l]);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  Runtime rt;
+
+  rt.init(&argc, &argv);
+
+  for(int i = 1; i < argc; i++) {
+    if(!strcmp(argv[i], "-min")) {
+      config.min_size = strtoll(argv[++i], 0, 10);
+      continue;
+    }
+    if(!strcmp(argv[i], "-max")) {
+      config.max_size = strtoll(argv[++i], 0, 10);
+      continue;
+    }
+    if(!strcmp(argv[i], "-reps")) {
+      config.reps = atoi(argv[++i]);
+      continue;
+    }
+    if(!strcmp(argv[i], "-dir")) {
+      config.file_dir = argv[++i];
+      continue;
+    }
+    if(!strcmp(argv[i], "-csv")) {
+      config.csv_file = argv[++i];
+      continue;
+    }
+  }
+  assert((config.min_size > 0) && (config.reps > 0));
+
+  rt.register_task(TOP_LEVEL_TASK, top_level_task);
+
+  // select a processor to run the top level task on
+  Processor p = Machine::ProcessorQuery(Machine::get_machine())
+    .only_kind(Processor::LOC_PROC)
+    .first();
+  assert(p.exists());
+
+  // collective launch of a single task - everybody gets the same finish event
+  Event e = rt.collective_spawn(p, TOP_LEVEL_TASK, 0, 0);
+
+  // request shutdown once that task is complete
+  rt.shutdown(e);
+
+  // now sleep this thread until that shutdown actually happens
+  rt.wait_for_shutdown();
+
+  return 0;
+}
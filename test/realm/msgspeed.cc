@@ -0,0 +1,382 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+#include <cstring>
+#include <unistd.h>
+#include <csignal>
+
+#include <time.h>
+
+#include <vector>
+#include <map>
+#include <algorithm>
+
+#include "realm/realm.h"
+
+using namespace Realm;
+
+// measures the message and event layers on their own: message rates with
+//  small and medium payloads, ping-pong latency, the latency from
+//  triggering a remote event to the waiter waking up, barrier latency as
+//  more nodes take part, and reservation throughput under contention
+//
+// Realm doesn't let applications send raw active messages, so payloads
+//  travel as the arguments of empty tasks spawned on another node (a
+//  medium message each) and short messages are remote event triggers
+
+// Task IDs, some IDs are reserved so start at first available number
+enum {
+  TOP_LEVEL_TASK = Processor::TASK_ID_FIRST_AVAILABLE+0,
+  EMPTY_TASK     = Processor::TASK_ID_FIRST_AVAILABLE+1,
+  MAKE_EVENTS_TASK = Processor::TASK_ID_FIRST_AVAILABLE+2,
+  STORE_EVENTS_TASK = Processor::TASK_ID_FIRST_AVAILABLE+3,
+  WAITER_TASK    = Processor::TASK_ID_FIRST_AVAILABLE+4,
+  BARRIER_TASK   = Processor::TASK_ID_FIRST_AVAILABLE+5,
+  LOCKER_TASK    = Processor::TASK_ID_FIRST_AVAILABLE+6,
+};
+
+struct TestConfig {
+  int messages;      // messages for each rate test
+  size_t medium_size; // payload of a medium message
+  int pings;         // ping-pong and trigger-to-wake round trips
+  int barrier_iters; // barrier generations for each node count
+  int acquires;      // reservation acquires per contending processor
+};
+
+static TestConfig config = { 10000, 4096, 1000, 1000, 1000 };
+
+struct MakeEventsArgs {
+  int count;
+  Processor home;
+};
+
+struct WaiterArgs {
+  UserEvent ready;
+  UserEvent go;
+  UserEvent done;
+};
+
+struct BarrierArgs {
+  Barrier b;
+  int iters;
+};
+
+struct LockerArgs {
+  Reservation r;
+  int iters;
+};
+
+// remote-owned events handed back to the top level task
+static std::vector<UserEvent> remote_events;
+
+// we're going to use alarm() as a watchdog to detect deadlocks
+void sigalrm_handler(int sig)
+{
+  fprintf(stderr, "HELP!  Alarm triggered - likely hang!\n");
+  exit(1);
+}
+
+void empty_task(const void *args, size_t arglen,
+		const void *userdata, size_t userlen, Processor p)
+{
+}
+
+void store_events_task(const void *args, size_t arglen,
+		       const void *userdata, size_t userlen, Processor p)
+{
+  const UserEvent *events = (const UserEvent *)args;
+  remote_events.assign(events, events + (arglen / sizeof(UserEvent)));
+}
+
+void make_events_task(const void *args, size_t arglen,
+		      const void *userdata, size_t userlen, Processor p)
+{
+  assert(arglen == sizeof(MakeEventsArgs));
+  const MakeEventsArgs& margs = *(const MakeEventsArgs *)args;
+
+  // these are owned by this node, so triggering them anywhere else
+  //  sends a message here
+  std::vector<UserEvent> events(margs.count);
+  for(int i = 0; i < margs.count; i++)
+    events[i] = UserEvent::create_user_event();
+  margs.home.spawn(STORE_EVENTS_TASK, &events[0],
+		   events.size() * sizeof(UserEvent)).wait();
+}
+
+void waiter_task(const void *args, size_t arglen,
+		 const void *userdata, size_t userlen, Processor p)
+{
+  assert(arglen == sizeof(WaiterArgs));
+  const WaiterArgs& wargs = *(const WaiterArgs *)args;
+
+  wargs.ready.trigger();
+  wargs.go.wait();
+  wargs.done.trigger();
+}
+
+void barrier_task(const void *args, size_t arglen,
+		  const void *userdata, size_t userlen, Processor p)
+{
+  assert(arglen == sizeof(BarrierArgs));
+  const BarrierArgs& bargs = *(const BarrierArgs *)args;
+
+  Barrier b = bargs.b;
+  for(int i = 0; i < bargs.iters; i++) {
+    b.arrive();
+    b.wait();
+    b = b.advance_barrier();
+  }
+}
+
+void locker_task(const void *args, size_t arglen,
+		 const void *userdata, size_t userlen, Processor p)
+{
+  assert(arglen == sizeof(LockerArgs));
+  const LockerArgs& largs = *(const LockerArgs *)args;
+
+  for(int i = 0; i < largs.iters; i++) {
+    largs.r.acquire().wait();
+    largs.r.release();
+  }
+}
+
+// spawns 'count' empty tasks with 'size' bytes of arguments on 'target'
+//  and returns the number of messages per second
+static double message_rate(Processor target, size_t size, int count)
+{
+  std::vector<char> payload(size, 0);
+  std::set<Event> events;
+  long long t1 = Clock::current_time_in_nanoseconds();
+  for(int i = 0; i < count; i++)
+    events.insert(target.spawn(EMPTY_TASK, (size > 0) ? &payload[0] : 0, size));
+  Event::merge_events(events).wait();
+  long long t2 = Clock::current_time_in_nanoseconds();
+  return 1e9 * count / (t2 - t1);
+}
+
+void top_level_task(const void *args, size_t arglen,
+		    const void *userdata, size_t userlen, Processor p)
+{
+  printf("top level task - finding a CPU on each node\n");
+
+  Machine machine = Machine::get_machine();
+  std::vector<Processor> all_cpus;
+  std::map<AddressSpace, Processor> node_cpus;
+  {
+    std::set<Processor> all_processors;
+    machine.get_all_processors(all_processors);
+    for(std::set<Processor>::const_iterator it = all_processors.begin();
+	it != all_processors.end();
+	it++)
+      if((*it).kind() == Processor::LOC_PROC) {
+	all_cpus.push_back(*it);
+	if(node_cpus.count(it->address_space()) == 0)
+	  node_cpus[it->address_space()] = *it;
+      }
+  }
+  std::vector<Processor> nodes;
+  nodes.push_back(p);
+  for(std::map<AddressSpace, Processor>::const_iterator it = node_cpus.begin();
+      it != node_cpus.end();
+      it++)
+    if(it->first != p.address_space())
+      nodes.push_back(it->second);
+
+  // the peer for point-to-point tests is on another node if there is one,
+  //  and otherwise another processor on this node
+  Processor peer = p;
+  if(nodes.size() > 1)
+    peer = nodes[1];
+  else
+    for(size_t i = 0; i < all_cpus.size(); i++)
+      if(all_cpus[i] != p) {
+	peer = all_cpus[i];
+	break;
+      }
+  printf("%zd nodes, %zd CPUs, peer processor is " IDFMT " on node %d\n",
+	 nodes.size(), all_cpus.size(), peer.id, (int)peer.address_space());
+
+  // set an alarm so that we turn hangs into error messages
+  alarm(600);
+
+  // message rates
+  double small_rate = message_rate(peer, sizeof(int), config.messages);
+  double medium_rate = message_rate(peer, config.medium_size, config.messages);
+  printf("spawn messages: small (%zd B) = %.0f msgs/s  medium (%zd B) = %.0f msgs/s (%.2f MB/s)\n",
+	 sizeof(int), small_rate, config.medium_size, medium_rate,
+	 1e-6 * medium_rate * config.medium_size);
+
+  {
+    MakeEventsArgs margs;
+    margs.count = config.messages;
+    margs.home = p;
+    peer.spawn(MAKE_EVENTS_TASK, &margs, sizeof(margs)).wait();
+    assert(remote_events.size() == (size_t)config.messages);
+    std::set<Event> events(remote_events.begin(), remote_events.end());
+    long long t1 = Clock::current_time_in_nanoseconds();
+    for(size_t i = 0; i < remote_events.size(); i++)
+      remote_events[i].trigger();
+    Event::merge_events(events).wait();
+    long long t2 = Clock::current_time_in_nanoseconds();
+    double short_rate = 1e9 * remote_events.size() / (t2 - t1);
+    printf("short messages: remote triggers = %.0f msgs/s\n", short_rate);
+    remote_events.clear();
+  }
+
+  // ping-pong latency: each spawn is a message there and its completion
+  //  trigger is a message back
+  {
+    peer.spawn(EMPTY_TASK, 0, 0).wait();
+    long long t1 = Clock::current_time_in_nanoseconds();
+    for(int i = 0; i < config.pings; i++)
+      peer.spawn(EMPTY_TASK, 0, 0).wait();
+    long long t2 = Clock::current_time_in_nanoseconds();
+    double rtt = 1e-3 * (t2 - t1) / config.pings;
+    printf("ping-pong: round trip = %.2f us  one way = %.2f us\n",
+	   rtt, 0.5 * rtt);
+  }
+
+  // trigger-to-wake latency: the peer is blocked in a wait on an event
+  //  we own, and wakes us up in turn with an event we also own
+  {
+    double total = 0;
+    for(int i = 0; i < config.pings; i++) {
+      WaiterArgs wargs;
+      wargs.ready = UserEvent::create_user_event();
+      wargs.go = UserEvent::create_user_event();
+      wargs.done = UserEvent::create_user_event();
+      Event e = peer.spawn(WAITER_TASK, &wargs, sizeof(wargs));
+      wargs.ready.wait();
+      // give the waiter time to actually go to sleep
+      usleep(100);
+      long long t1 = Clock::current_time_in_nanoseconds();
+      wargs.go.trigger();
+      wargs.done.wait();
+      long long t2 = Clock::current_time_in_nanoseconds();
+      total += (t2 - t1);
+      e.wait();
+    }
+    double rtt = 1e-3 * total / config.pings;
+    printf("trigger-to-wake: round trip = %.2f us  one way = %.2f us\n",
+	   rtt, 0.5 * rtt);
+  }
+
+  // barrier latency versus the number of nodes taking part
+  for(size_t n = 1; ; n = std::min(2 * n, nodes.size())) {
+    Barrier b = Barrier::create_barrier(n);
+    UserEvent start = UserEvent::create_user_event();
+    std::set<Event> events;
+    for(size_t i = 0; i < n; i++) {
+      BarrierArgs bargs;
+      bargs.b = b;
+      bargs.iters = config.barrier_iters;
+      events.insert(nodes[i].spawn(BARRIER_TASK, &bargs, sizeof(bargs),
+				   ProfilingRequestSet(), start));
+    }
+    long long t1 = Clock::current_time_in_nanoseconds();
+    start.trigger();
+    Event::merge_events(events).wait();
+    long long t2 = Clock::current_time_in_nanoseconds();
+    b.destroy_barrier();
+    printf("barrier: nodes = %3zd  latency = %.2f us\n",
+	   n, 1e-3 * (t2 - t1) / config.barrier_iters);
+    if(n >= nodes.size()) break;
+  }
+
+  // reservation throughput with one processor and then with every CPU
+  //  in the machine contending for it
+  for(int pass = 0; pass < 2; pass++) {
+    size_t contenders = (pass == 0) ? 1 : all_cpus.size();
+    Reservation r = Reservation::create_reservation();
+    UserEvent start = UserEvent::create_user_event();
+    std::set<Event> events;
+    for(size_t i = 0; i < contenders; i++) {
+      LockerArgs largs;
+      largs.r = r;
+      largs.iters = config.acquires;
+      Processor target = (pass == 0) ? peer : all_cpus[i];
+      events.insert(target.spawn(LOCKER_TASK, &largs, sizeof(largs),
+				 ProfilingRequestSet(), start));
+    }
+    long long t1 = Clock::current_time_in_nanoseconds();
+    start.trigger();
+    Event::merge_events(events).wait();
+    long long t2 = Clock::current_time_in_nanoseconds();
+    r.destroy_reservation();
+    printf("reservation: contenders = %3zd  throughput = %.0f acquires/s\n",
+	   contenders, 1e9 * contenders * config.acquires / (t2 - t1));
+    if(all_cpus.size() == 1) break;
+  }
+
+  alarm(0);
+
+  printf("done!\n");
+}
+
+int main(int argc, char **argv)
+{
+  Runtime rt;
+
+  rt.init(&argc, &argv);
+
+  for(int i = 1; i < argc; i++) {
+    if(!strcmp(argv[i], "-m")) {
+      config.messages = atoi(argv[++i]);
+      continue;
+    }
+    if(!strcmp(argv[i], "-s")) {
+      config.medium_size = strtoll(argv[++i], 0, 10);
+      continue;
+    }
+    if(!strcmp(argv[i], "-p")) {
+      config.pings = atoi(argv[++i]);
+      continue;
+    }
+    if(!strcmp(argv[i], "-b")) {
+      config.barrier_iters = atoi(argv[++i]);
+      continue;
+    }
+    if(!strcmp(argv[i], "-r")) {
+      config.acquires = atoi(argv[++i]);
+      continue;
+    }
+  }
+  assert((config.messages > 0) && (config.pings > 0) &&
+	 (config.barrier_iters > 0) && (config.acquires > 0));
+
+  rt.register_task(TOP_LEVEL_TASK, top_level_task);
+  rt.register_task(EMPTY_TASK, empty_task);
+  rt.register_task(MAKE_EVENTS_TASK, make_events_task);
+  rt.register_task(STORE_EVENTS_TASK, store_events_task);
+  rt.register_task(WAITER_TASK, waiter_task);
+  rt.register_task(BARRIER_TASK, barrier_task);
+  rt.register_task(LOCKER_TASK, locker_task);
+
+  signal(SIGALRM, sigalrm_handler);
+
+  // select a processor to run the top level task on
+  Processor p = Processor::NO_PROC;
+  {
+    std::set<Processor> all_procs;
+    Machine::get_machine().get_all_processors(all_procs);
+    for(std::set<Processor>::const_iterator it = all_procs.begin();
+	it != all_procs.end();
+	it++)
+      if(it->kind() == Processor::LOC_PROC) {
+	p = *it;
+	break;
+      }
+  }
+  assert(p.exists());
+
+  // collective launch of a single task - everybody gets the same finish event
+  Event e = rt.collective_spawn(p, TOP_LEVEL_TASK, 0, 0);
+
+  // request shutdown once that task is complete
+  rt.shutdown(e);
+
+  // now sleep this thread until that shutdown actually happens
+  rt.wait_for_shutdown();
+
+  return 0;
+}
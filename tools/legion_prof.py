@@ -20,13 +20,15 @@ import tempfile
 import legion_spy
 import argparse
 import sys, os, shutil
-import string, re, json, heapq, time, itertools
+import string, re, json, heapq, time, itertools, bisect
 from collections import defaultdict
 from math import sqrt, log
 from cgi import escape
 from operator import itemgetter
 from os.path import dirname, exists, basename
 from legion_serializer import LegionProfASCIIDeserializer, LegionProfBinaryDeserializer, GetFileTypeInfo
+from legion_serializer import collect_log_records, replay_log_records
+import multiprocessing
 
 # Make sure this is up to date with lowlevel.h
 processor_kinds = {
@@ -53,6 +55,7 @@ memory_kinds = {
     9 : 'L3 Cache',
     10 : 'L2 Cache',
     11 : 'L1 Cache',
+    12 : 'Managed',
 }
 
 # Micro-seconds per pixel
@@ -453,10 +456,21 @@ class Memory(object):
         self.time_points = list()
         self.max_live_instances = None
         self.last_time = None
+        # Peak bytes charged to each mapper and task kind
+        self.mapper_peaks = {}
+        self.task_peaks = {}
+        # (time, instance) for each instance the runtime deleted
+        self.deletions = list()
 
     def get_short_text(self):
         return self.kind + " Memory " + str(self.mem_in_node)
 
+    def add_usage(self, mapper_id, mapper_bytes, task_id, task_bytes):
+        if mapper_bytes > self.mapper_peaks.get(mapper_id, 0):
+            self.mapper_peaks[mapper_id] = mapper_bytes
+        if task_bytes > self.task_peaks.get(task_id, 0):
+            self.task_peaks[task_id] = task_bytes
+
     def add_instance(self, inst):
         self.instances.add(inst)
         inst.mem = self
@@ -543,6 +557,12 @@ class Memory(object):
             print("    Total Instances: %d" % len(self.instances))
             print("    Maximum Utilization: %.3f%%" % (100.0 * max_usage))
             print("    Average Utilization: %.3f%%" % (100.0 * average_usage))
+            if self.deletions:
+                evicted = sum(1 for time, inst in self.deletions
+                              if inst.deletion == 'evicted')
+                print("    Instances Collected: %d" % 
+                      (len(self.deletions) - evicted))
+                print("    Instances Evicted: %d" % evicted)
             print()
   
     def __repr__(self):
@@ -653,6 +673,102 @@ class Channel(object):
     def __cmp__(a, b):
         return cmp(a.dst, b.dst)
 
+# Must match OperationGPUActivity::Kind in realm/profiling.h
+gpu_activity_kinds = {
+    0 : "Kernel",
+    1 : "Memcpy",
+    2 : "Memset",
+}
+
+class GPUDevice(object):
+    """
+    The work that the tasks of one GPU processor actually ran on the
+    device, with one row for each CUDA stream
+    """
+    def __init__(self, proc):
+        self.proc = proc
+        self.activities = list()
+        self.streams = list()
+        self.time_points = list()
+        self.last_time = None
+
+    def get_short_text(self):
+        return "GPU Device " + str(self.proc.proc_in_node)
+
+    def add_activity(self, activity):
+        activity.device = self
+        self.activities.append(activity)
+
+    def resolve_ops(self, operations):
+        # Activity records can be read before their task is, so look the
+        # tasks up only once everything has been parsed
+        for activity in self.activities:
+            activity.op = operations.get(activity.op_id)
+
+    def sort_time_range(self):
+        self.streams = sorted(set(a.stream for a in self.activities))
+        rows = dict((stream, idx + 1) for idx, stream in enumerate(self.streams))
+        for activity in self.activities:
+            activity.set_level(rows[activity.stream])
+            self.time_points.append(TimePoint(activity.start, activity, True))
+            self.time_points.append(TimePoint(activity.stop, activity, False))
+        self.time_points.sort(key=lambda p: p.time_key)
+
+    def emit_tsv(self, tsv_file, base_level):
+        max_levels = len(self.streams) + 1
+        for point in self.time_points:
+            if point.first:
+                point.thing.emit_tsv(tsv_file, base_level, max_levels,
+                                     point.thing.level)
+        return base_level + max_levels
+
+    def busy_ranges(self, kinds=None):
+        # The union of the device's activity, as disjoint (start, stop) ranges
+        ranges = list()
+        for activity in sorted(self.activities, key=lambda a: a.start):
+            if kinds is not None and activity.kind not in kinds:
+                continue
+            if ranges and activity.start <= ranges[-1][1]:
+                if activity.stop > ranges[-1][1]:
+                    ranges[-1] = (ranges[-1][0], activity.stop)
+            else:
+                ranges.append((activity.start, activity.stop))
+        return ranges
+
+    def print_stats(self, verbose):
+        busy = self.busy_ranges()
+        busy_time = sum(stop - start for start, stop in busy)
+        kernel_time = sum(stop - start for start, stop in self.busy_ranges((0,)))
+        copy_time = sum(stop - start for start, stop in self.busy_ranges((1, 2)))
+        # Time in which a task was running on the processor but nothing of
+        # it was running on the device is launch overhead (or host work)
+        task_time = 0
+        gap_time = 0
+        for task in self.proc.tasks:
+            if not isinstance(task, Task):
+                continue
+            task_time += task.stop - task.start
+            covered = 0
+            for start, stop in busy:
+                covered += max(0, min(stop, task.stop) - max(start, task.start))
+            gap_time += (task.stop - task.start) - covered
+        print(self)
+        print("    Activities: %d on %d streams" % (len(self.activities),
+                                                   len(self.streams)))
+        print("    Device busy time: %d us" % busy_time)
+        print("    Kernel time: %d us" % kernel_time)
+        print("    Copy and fill time: %d us" % copy_time)
+        if task_time > 0:
+            print("    Device idle during tasks: %d us (%.3f%%)" %
+                  (gap_time, 100.0 * gap_time / task_time))
+        print
+
+    def __repr__(self):
+        return 'GPU Device of ' + repr(self.proc)
+
+    def __cmp__(a, b):
+        return cmp(a.proc, b.proc)
+
 class WaitInterval(object):
     def __init__(self, start, ready, end):
         self.start = start
@@ -1229,10 +1345,21 @@ class Instance(Base, TimeRange, HasInitiationDependencies):
         self.inst_id = inst_id
         self.mem = None
         self.size = None
+        # (field space, field, bytes per element) for each field
+        self.fields = set()
+        # 'collected' or 'evicted' if the runtime deleted it
+        self.deletion = None
 
     def get_owner(self):
         return self.mem
 
+    def get_field_text(self):
+        spaces = {}
+        for fspace_id, field_id, size in self.fields:
+            spaces.setdefault(fspace_id, []).append(field_id)
+        return ' '.join('FS%d[%s]' % (fspace_id, ','.join(map(str, sorted(fids))))
+                        for fspace_id, fids in sorted(spaces.iteritems()))
+
     def get_unique_tuple(self):
         assert self.mem is not None
         cur_level = self.mem.max_live_instances+1 - self.level
@@ -1289,9 +1416,15 @@ class Instance(Base, TimeRange, HasInitiationDependencies):
         else:
             size_pretty = 'Unknown'
 
-        return ("Instance {} Size={}"
-                .format(str(hex(self.inst_id)),
-                        size_pretty))
+        title = ("Instance {} Size={}"
+                 .format(str(hex(self.inst_id)),
+                         size_pretty))
+        if self.fields:
+            title += ' Fields=' + self.get_field_text()
+        title += ' Creator=' + repr(self.initiation_op)
+        if self.deletion is not None:
+            title += ' (' + self.deletion + ')'
+        return title
 
 class MessageKind(StatObject):
     def __init__(self, message_id, name):
@@ -1310,6 +1443,100 @@ class MessageKind(StatObject):
     def __repr__(self):
         return self.name
 
+class MessageStats(object):
+    def __init__(self, source, target, kind):
+        self.source = source
+        self.target = target
+        self.kind = kind
+        self.count = 0
+        self.total_bytes = 0
+        # Bucket 0 is under 1us, bucket b is [2^(b-1),2^b) us, and
+        # the last bucket holds everything longer
+        self.latency = []
+
+    def add(self, count, total_bytes, latency):
+        self.count += count
+        self.total_bytes += total_bytes
+        if len(self.latency) < len(latency):
+            self.latency.extend([0] * (len(latency) - len(self.latency)))
+        for idx, value in enumerate(latency):
+            self.latency[idx] += value
+
+    @staticmethod
+    def bucket_name(idx, num_buckets):
+        if idx == 0:
+            return '< 1 us'
+        if idx == num_buckets - 1:
+            return '>= %d us' % (1 << (idx - 1))
+        return '< %d us' % (1 << idx)
+
+    def percentile_bucket(self, pct):
+        target = self.count * pct / 100.0
+        total = 0
+        for idx, value in enumerate(self.latency):
+            total += value
+            if total >= target:
+                return idx
+        return len(self.latency) - 1
+
+    def print_stats(self, seconds, verbose):
+        print('       Total Messages: %d' % self.count)
+        print('       Total Bytes: %d' % self.total_bytes)
+        if self.count > 0:
+            print('       Average Size: %.2f bytes' %
+                  (float(self.total_bytes) / self.count))
+        if seconds:
+            print('       Message Rate: %.2f messages/s' %
+                  (self.count / seconds))
+        num_buckets = len(self.latency)
+        if num_buckets == 0:
+            return
+        print('       Median Handler Time: %s' % MessageStats.bucket_name(
+                self.percentile_bucket(50), num_buckets))
+        print('       99th Percentile Handler Time: %s' % 
+                MessageStats.bucket_name(self.percentile_bucket(99), num_buckets))
+        if verbose:
+            largest = max(self.latency)
+            for idx, value in enumerate(self.latency):
+                if value == 0:
+                    continue
+                bar = '#' * max(1, int(40 * value / largest))
+                print('         %10s %10d %s' %
+                      (MessageStats.bucket_name(idx, num_buckets), value, bar))
+
+class MapperCallStats(object):
+    def __init__(self):
+        self.count = 0
+        # Times are in us and the total includes the time spent waiting
+        self.total_time = 0
+        self.wait_time = 0
+        self.max_time = 0
+
+    def add(self, duration, wait):
+        self.count += 1
+        self.total_time += duration
+        self.wait_time += wait
+        if duration > self.max_time:
+            self.max_time = duration
+
+    def merge(self, other):
+        self.count += other.count
+        self.total_time += other.total_time
+        self.wait_time += other.wait_time
+        if other.max_time > self.max_time:
+            self.max_time = other.max_time
+
+    def print_stats(self):
+        avg = float(self.total_time) / self.count if self.count > 0 else 0
+        wait_pct = 100.0 * self.wait_time / self.total_time \
+                if self.total_time > 0 else 0.0
+        print('       Total Invocations: %d' % self.count)
+        print('       Total Time: %d us' % self.total_time)
+        print('       Average Time: %.2f us' % avg)
+        print('       Maximum Time: %d us' % self.max_time)
+        print('       Time Waiting on Mapper: %d us (%.1f%%)' %
+              (self.wait_time, wait_pct))
+
 class Message(Base, TimeRange, HasNoDependencies):
     def __init__(self, kind, start, stop):
         Base.__init__(self)
@@ -1350,6 +1577,52 @@ class Message(Base, TimeRange, HasNoDependencies):
     def __repr__(self):
         return 'Message '+str(self.kind)
 
+class GPUActivity(Base, TimeRange, HasNoDependencies):
+    def __init__(self, op_id, stream, kind, size, start, stop):
+        Base.__init__(self)
+        TimeRange.__init__(self, None, None, start, stop)
+        HasNoDependencies.__init__(self)
+        self.op_id = op_id
+        self.op = None
+        self.stream = stream
+        self.kind = kind
+        self.size = size
+        self.device = None
+
+    def get_owner(self):
+        return self.device
+
+    def get_unique_tuple(self):
+        assert self.device is not None
+        return (str(self.device), self.prof_uid)
+
+    def get_color(self):
+        # Share the color of the task that issued the work
+        if self.op is not None:
+            return self.op.get_color()
+        return "#000000"
+
+    def emit_tsv(self, tsv_file, base_level, max_levels, level):
+        tsv_line = data_tsv_str(level = base_level + (max_levels - level),
+                                start = self.start,
+                                end = self.stop,
+                                color = self.get_color(),
+                                opacity = "1.0",
+                                title = repr(self),
+                                initiation = self.op_id,
+                                _in = None,
+                                out = None,
+                                children = None,
+                                parents = None,
+                                prof_uid = self.prof_uid)
+        tsv_file.write(tsv_line)
+
+    def __repr__(self):
+        name = gpu_activity_kinds.get(self.kind, "Activity")
+        if self.size > 0:
+            name += ' size=' + str(self.size)
+        return name + ' stream ' + str(self.stream) + ' of ' + str(self.op)
+
 class MapperCallKind(StatObject):
     def __init__(self, mapper_call_kind, name):
         StatObject.__init__(self)
@@ -1368,11 +1641,12 @@ class MapperCallKind(StatObject):
         self.color = color
 
 class MapperCall(Base, TimeRange, HasInitiationDependencies):
-    def __init__(self, kind, initiation_op, start, stop):
+    def __init__(self, kind, initiation_op, start, stop, wait=0):
         Base.__init__(self)
         TimeRange.__init__(self, None, None, start, stop)
         HasInitiationDependencies.__init__(self, initiation_op)
         self.kind = kind
+        self.wait = wait
 
     def get_color(self):
         assert self.kind is not None and self.kind.color is not None
@@ -1414,9 +1688,12 @@ class MapperCall(Base, TimeRange, HasInitiationDependencies):
 
     def __repr__(self):
         if self.initiation == 0:
-            return 'Mapper Call '+str(self.kind)
+            result = 'Mapper Call '+str(self.kind)
         else:
-            return 'Mapper Call '+str(self.kind)+' for '+str(self.initiation)
+            result = 'Mapper Call '+str(self.kind)+' for '+str(self.initiation)
+        if self.wait > 0:
+            result += ' (waited '+str(self.wait)+' us)'
+        return result
 
 class RuntimeCallKind(StatObject):
     def __init__(self, runtime_call_kind, name):
@@ -1595,6 +1872,7 @@ class State(object):
         self.processors = {}
         self.memories = {}
         self.channels = {}
+        self.gpu_devices = {}
         self.task_kinds = {}
         self.variants = {}
         self.meta_variants = {}
@@ -1607,11 +1885,18 @@ class State(object):
         self.last_time = 0L
         self.message_kinds = {}
         self.messages = {}
+        self.message_stats = {}
+        self.task_windows = {}
+        self.task_counters = {}
+        self.alloc_kinds = {}
+        self.runtime_memory = {}
         self.mapper_call_kinds = {}
         self.mapper_calls = {}
+        self.mapper_call_stats = {}
         self.runtime_call_kinds = {}
         self.runtime_calls = {}
         self.instances = {}
+        self.inst_deletions = []
         self.has_spy_data = False
         self.spy_state = None
         self.callbacks = {
@@ -1622,6 +1907,7 @@ class State(object):
             "OpDesc": self.log_op_desc,
             "ProcDesc": self.log_proc_desc,
             "MemDesc": self.log_mem_desc,
+            "AllocDesc": self.log_alloc_desc,
             "TaskKind": self.log_kind,
             "TaskVariant": self.log_variant,
             "OperationInstance": self.log_operation,
@@ -1630,13 +1916,21 @@ class State(object):
             "TaskWaitInfo": self.log_task_wait_info,
             "MetaWaitInfo": self.log_meta_wait_info,
             "TaskInfo": self.log_task_info,
+            "TaskCounterInfo": self.log_task_counter_info,
+            "GPUActivityInfo": self.log_gpu_activity_info,
             "MetaInfo": self.log_meta_info,
             "CopyInfo": self.log_copy_info,
             "FillInfo": self.log_fill_info,
             "InstCreateInfo": self.log_inst_create,
             "InstUsageInfo": self.log_inst_usage,
             "InstTimelineInfo": self.log_inst_timeline,
+            "InstFieldInfo": self.log_inst_field,
+            "InstDeletionInfo": self.log_inst_deletion,
+            "MemUsageInfo": self.log_mem_usage,
+            "TaskWindowInfo": self.log_task_window,
+            "RuntimeMemoryInfo": self.log_runtime_memory,
             "MessageInfo": self.log_message_info,
+            "MessageStatsInfo": self.log_message_stats,
             "MapperCallInfo": self.log_mapper_call_info,
             "RuntimeCallInfo": self.log_runtime_call_info,
             "ProfTaskInfo": self.log_proftask_info
@@ -1652,6 +1946,27 @@ class State(object):
         proc = self.find_processor(proc_id)
         proc.add_task(task)
 
+    def log_task_counter_info(self, op_id, instructions, cycles,
+                              l2_accesses, l2_misses, l3_accesses,
+                              l3_misses, stalled_cycles):
+        # Counter records carry no timestamp so they can arrive before
+        # the task itself; keep them by operation and resolve the
+        # variant when the statistics are printed
+        self.task_counters[op_id] = (instructions, cycles,
+                                     l2_accesses, l2_misses,
+                                     l3_accesses, l3_misses,
+                                     stalled_cycles)
+
+    def log_gpu_activity_info(self, op_id, proc_id, stream, kind, bytes,
+                              start, stop):
+        if stop > self.last_time:
+            self.last_time = stop
+        activity = GPUActivity(op_id, stream, kind, bytes, start, stop)
+        proc = self.find_processor(proc_id)
+        if proc_id not in self.gpu_devices:
+            self.gpu_devices[proc_id] = GPUDevice(proc)
+        self.gpu_devices[proc_id].add_activity(activity)
+
     def log_meta_info(self, op_id, lg_id, proc_id, 
                       create, ready, start, stop):
         op = self.find_op(op_id)
@@ -1706,6 +2021,62 @@ class State(object):
         if destroy > self.last_time:
             self.last_time = destroy 
 
+    def log_inst_field(self, op_id, inst_id, fspace_id, field_id, size):
+        op = self.find_op(op_id)
+        inst = self.create_instance(inst_id, op)
+        inst.fields.add((fspace_id, field_id, size))
+
+    def log_inst_deletion(self, inst_id, mem_id, evicted, time):
+        # Deletions don't name the creating operation, so they are
+        # matched with their instance once everything has been read
+        self.inst_deletions.append((inst_id, mem_id, evicted, time))
+        if time > self.last_time:
+            self.last_time = time
+
+    def match_instance_deletions(self):
+        by_inst_id = {}
+        for (inst_id, op_id), inst in self.instances.iteritems():
+            by_inst_id.setdefault(inst_id, []).append(inst)
+        for inst_id, mem_id, evicted, time in self.inst_deletions:
+            # Realm reuses instance ids, so pick the most recent
+            # instance with this id that was created before the deletion
+            match = None
+            for inst in by_inst_id.get(inst_id, []):
+                if inst.mem is None or inst.mem.mem_id != mem_id:
+                    continue
+                if inst.start is not None and inst.start > time:
+                    continue
+                if match is None or inst.start > match.start:
+                    match = inst
+            if match is None:
+                continue
+            match.deletion = 'evicted' if evicted else 'collected'
+            match.mem.deletions.append((time, match))
+
+    def log_mem_usage(self, mem_id, mapper_id, mapper_bytes, 
+                      task_id, task_bytes, time):
+        mem = self.find_memory(mem_id)
+        mem.add_usage(mapper_id, mapper_bytes, task_id, task_bytes)
+        if time > self.last_time:
+            self.last_time = time
+
+    def log_task_window(self, op_id, window_size, analysis_lag,
+                        execution_lag, time):
+        if op_id not in self.task_windows:
+            self.task_windows[op_id] = []
+        self.task_windows[op_id].append((time, window_size,
+                                         analysis_lag, execution_lag))
+        if time > self.last_time:
+            self.last_time = time
+
+    def log_runtime_memory(self, node, kind, bytes, allocations, time):
+        key = (node, kind)
+        if key not in self.runtime_memory:
+            self.runtime_memory[key] = []
+        self.runtime_memory[key].append((time, bytes, allocations))
+        if time > self.last_time:
+            self.last_time = time
+
     def log_user_info(self, proc_id, start, stop, name):
         proc = self.find_processor(proc_id)
         user = self.create_user_marker(name)
@@ -1792,6 +2163,10 @@ class State(object):
         if kind not in self.op_kinds:
             self.op_kinds[kind] = name
 
+    def log_alloc_desc(self, kind, name):
+        if kind not in self.alloc_kinds:
+            self.alloc_kinds[kind] = name
+
     def log_message_desc(self, kind, name):
         if kind not in self.message_kinds:
             self.message_kinds[kind] = MessageKind(kind, name) 
@@ -1805,20 +2180,36 @@ class State(object):
         proc = self.find_processor(proc_id)
         proc.add_message(message)
 
+    def log_message_stats(self, source, target, kind, count, total_bytes,
+                          latency=None, **buckets):
+        # The binary format has a separate field for each bucket
+        if latency is None:
+            latency = [buckets['latency%d' % i] for i in xrange(len(buckets))]
+        key = (source, target, kind)
+        if key not in self.message_stats:
+            self.message_stats[key] = MessageStats(source, target, kind)
+        self.message_stats[key].add(count, total_bytes, latency)
+
     def log_mapper_call_desc(self, kind, name):
         if kind not in self.mapper_call_kinds:
             self.mapper_call_kinds[kind] = MapperCallKind(kind, name)
 
-    def log_mapper_call_info(self, kind, proc_id, op_id, start, stop):
+    def log_mapper_call_info(self, kind, proc_id, op_id, start, stop,
+                             mapper_id, mapper_proc, wait):
         assert start <= stop
         assert kind in self.mapper_call_kinds
+        # Every call counts towards the statistics, even the cheap ones
+        key = (mapper_id, mapper_proc, kind)
+        if key not in self.mapper_call_stats:
+            self.mapper_call_stats[key] = MapperCallStats()
+        self.mapper_call_stats[key].add(stop - start, wait)
         # For now we'll only add very expensive mapper calls (more than 100 us)
         if (stop - start) < 100:
             return 
         if stop > self.last_time:
             self.last_time = stop
         call = MapperCall(self.mapper_call_kinds[kind],
-                          self.find_op(op_id), start, stop)
+                          self.find_op(op_id), start, stop, wait)
         # update prof_uid map
         self.prof_uid_map[call.prof_uid] = call
         proc = self.find_processor(proc_id)
@@ -1945,12 +2336,17 @@ class State(object):
         for proc in self.processors.itervalues():
             proc.last_time = self.last_time
             proc.sort_time_range()
+        self.match_instance_deletions()
         for mem in self.memories.itervalues():
             mem.init_time_range(self.last_time)
             mem.sort_time_range()
         for channel in self.channels.itervalues():
             channel.init_time_range(self.last_time)
             channel.sort_time_range()
+        for device in self.gpu_devices.itervalues():
+            device.last_time = self.last_time
+            device.resolve_ops(self.operations)
+            device.sort_time_range()
 
     def print_processor_stats(self, verbose):
         print('****************************************************')
@@ -1968,6 +2364,16 @@ class State(object):
             mem.print_stats(verbose)
         print
 
+    def print_gpu_device_stats(self, verbose):
+        if not self.gpu_devices:
+            return
+        print('****************************************************')
+        print('   GPU DEVICE STATS')
+        print('****************************************************')
+        for device in sorted(self.gpu_devices.itervalues()):
+            device.print_stats(verbose)
+        print
+
     def print_channel_stats(self, verbose):
         print('****************************************************')
         print('   CHANNEL STATS')
@@ -1976,6 +2382,257 @@ class State(object):
             channel.print_stats(verbose)
         print
 
+    def print_message_stats(self, verbose):
+        if not self.message_stats:
+            return
+        print('****************************************************')
+        print('   MESSAGE STATS')
+        print('****************************************************')
+        # Combine the node pairs for each kind of message
+        kinds = {}
+        for stats in self.message_stats.itervalues():
+            if stats.kind not in kinds:
+                kinds[stats.kind] = MessageStats(None, None, stats.kind)
+            kinds[stats.kind].add(stats.count, stats.total_bytes, stats.latency)
+        seconds = self.last_time / 1e6 if self.last_time > 0 else None
+        for stats in sorted(kinds.itervalues(), key=lambda s: -s.count):
+            if stats.kind in self.message_kinds:
+                name = self.message_kinds[stats.kind].name
+            else:
+                name = 'Message Kind ' + str(stats.kind)
+            print(name)
+            stats.print_stats(seconds, verbose)
+        # Then show which pairs of nodes are moving the most data
+        pairs = sorted(self.message_stats.itervalues(),
+                       key=lambda s: -s.total_bytes)
+        if not verbose:
+            pairs = pairs[:10]
+        print('Busiest node pairs (by bytes):')
+        for stats in pairs:
+            if stats.kind in self.message_kinds:
+                name = self.message_kinds[stats.kind].name
+            else:
+                name = 'Message Kind ' + str(stats.kind)
+            print('       Node %d -> Node %d %s: %d messages, %d bytes' %
+                  (stats.source, stats.target, name, stats.count,
+                   stats.total_bytes))
+        print
+
+    def print_mapper_call_stats(self, verbose):
+        if not self.mapper_call_stats:
+            return
+        print('****************************************************')
+        print('   MAPPER CALL STATS')
+        print('****************************************************')
+        # Combine all the mappers for each kind of mapper call
+        kinds = {}
+        mappers = {}
+        for (mapper_id, mapper_proc, kind), stats in \
+                self.mapper_call_stats.iteritems():
+            if kind not in kinds:
+                kinds[kind] = MapperCallStats()
+            kinds[kind].merge(stats)
+            if (mapper_id, mapper_proc) not in mappers:
+                mappers[(mapper_id, mapper_proc)] = MapperCallStats()
+            mappers[(mapper_id, mapper_proc)].merge(stats)
+        for kind, stats in sorted(kinds.iteritems(),
+                                  key=lambda k: -k[1].total_time):
+            print(self.mapper_call_kinds[kind].name)
+            stats.print_stats()
+        # Then show which mappers are the most expensive
+        ranked = sorted(mappers.iteritems(), key=lambda m: -m[1].total_time)
+        if not verbose:
+            ranked = ranked[:10]
+        print('Most expensive mappers (by total time):')
+        for (mapper_id, mapper_proc), stats in ranked:
+            print('       Mapper %d on %s: %d calls, %d us, %d us waiting' %
+                  (mapper_id, hex(mapper_proc), stats.count,
+                   stats.total_time, stats.wait_time))
+            if not verbose:
+                continue
+            for (other_id, other_proc, kind), call_stats in sorted(
+                    self.mapper_call_stats.iteritems(),
+                    key=lambda c: -c[1].total_time):
+                if other_id != mapper_id or other_proc != mapper_proc:
+                    continue
+                print('         %s: %d calls, %d us, %d us waiting' %
+                      (self.mapper_call_kinds[kind].name, call_stats.count,
+                       call_stats.total_time, call_stats.wait_time))
+        print
+
+    def print_task_window_stats(self, verbose):
+        if not self.task_windows:
+            return
+        print('****************************************************')
+        print('   TASK WINDOW STATS')
+        print('****************************************************')
+        for op_id in sorted(self.task_windows.iterkeys()):
+            changes = sorted(self.task_windows[op_id])
+            sizes = [change[1] for change in changes]
+            print('Context of operation %d: %d window changes, '
+                  'min %d, max %d, final %d' %
+                  (op_id, len(changes), min(sizes), max(sizes), sizes[-1]))
+            if verbose:
+                for time, size, analysis, execution in changes:
+                    print('       %d us: window %d (analysis lag %d us, '
+                          'execution lag %d us)' % 
+                          (time, size, analysis, execution))
+        print
+
+    def print_runtime_memory_stats(self, verbose):
+        if not self.runtime_memory:
+            return
+        print('****************************************************')
+        print('   RUNTIME MEMORY STATS')
+        print('****************************************************')
+        nodes = sorted(set(node for node, kind in self.runtime_memory))
+        for node in nodes:
+            # Sort the kinds of allocations by their peak usage
+            peaks = []
+            for (sample_node, kind), samples in \
+                    self.runtime_memory.iteritems():
+                if sample_node != node:
+                    continue
+                samples = sorted(samples)
+                peaks.append((max(sample[1] for sample in samples),
+                              kind, samples))
+            peaks.sort(reverse=True)
+            print('Node %d:' % node)
+            if not verbose:
+                peaks = peaks[:10]
+            for peak, kind, samples in peaks:
+                if kind in self.alloc_kinds:
+                    name = self.alloc_kinds[kind]
+                else:
+                    name = 'Allocation Kind ' + str(kind)
+                time, final, allocations = samples[-1]
+                print('       %s: peak %d bytes, final %d bytes '
+                      '(%d allocations)' % (name, peak, final, allocations))
+        print
+
+    def print_task_counter_stats(self, verbose):
+        if not self.task_counters:
+            return
+        print('****************************************************')
+        print('   TASK HARDWARE COUNTER STATS')
+        print('****************************************************')
+        # Sum the counters of every task by variant, ignoring counters
+        # that were not available on the machine (reported as -1)
+        totals = {}
+        for op_id, counters in self.task_counters.iteritems():
+            task = self.operations.get(op_id)
+            if task is None or not task.is_task:
+                continue
+            total = totals.get(task.variant)
+            if total is None:
+                total = [0, [0L] * len(counters), [0] * len(counters)]
+                totals[task.variant] = total
+            total[0] += 1
+            for index, value in enumerate(counters):
+                if value >= 0:
+                    total[1][index] += value
+                    total[2][index] += 1
+        def ratio(total, num, denom, scale=1.0):
+            if total[2][num] == 0 or total[2][denom] == 0 or \
+                    total[1][denom] == 0:
+                return None
+            return scale * total[1][num] / total[1][denom]
+        def show(value, fmt):
+            return 'n/a' if value is None else fmt % value
+        # Report the variants with the most instructions first
+        ordered = sorted(totals.iteritems(),
+                         key=lambda item: item[1][1][0], reverse=True)
+        if not verbose:
+            ordered = ordered[:10]
+        for variant, total in ordered:
+            ipc = ratio(total, 0, 1)
+            l2_mpki = ratio(total, 3, 0, 1000.0)
+            l3_mpki = ratio(total, 5, 0, 1000.0)
+            stalls = ratio(total, 6, 1, 100.0)
+            print('%s (%d tasks): IPC %s, L2 misses/1k instr %s, '
+                  'L3 misses/1k instr %s, stalled cycles %s' %
+                  (variant, total[0], show(ipc, '%.2f'),
+                   show(l2_mpki, '%.2f'), show(l3_mpki, '%.2f'),
+                   show(stalls, '%.1f%%')))
+            # Low IPC together with many last level cache misses or
+            # stalls is the usual signature of a memory bound kernel
+            if ipc is not None and ipc < 1.0 and \
+                    ((l3_mpki is not None and l3_mpki > 5.0) or
+                     (stalls is not None and stalls > 50.0)):
+                print('       likely memory bound')
+        print
+
+    def find_launch_kind(self, op_id):
+        # Index launches, their slices, and their points are all charged
+        # to the task kind that was launched
+        op = self.operations.get(op_id)
+        while op is not None:
+            owner = op.owner
+            if owner is None and op.is_task and not op.is_meta:
+                owner = op.base_op.owner
+            if owner is None:
+                break
+            op = self.operations.get(owner.op_id, owner)
+        if op is None or op.is_proftask:
+            return None
+        if op.is_task and not op.is_meta:
+            task_kind = op.variant.task_kind
+        elif op.is_multi:
+            task_kind = op.task_kind
+        elif op.kind is not None:
+            return op.kind + ' Operation'
+        else:
+            return None
+        if task_kind is None:
+            return 'unnamed'
+        if task_kind.name is None:
+            return 'Task ' + str(task_kind.task_id)
+        return task_kind.name
+
+    def print_meta_overhead_stats(self, verbose):
+        # Every meta-task is tagged with the application operation that
+        # caused it, so sum the runtime overhead for each kind of launch
+        overheads = {}
+        for proc in self.processors.itervalues():
+            for task in proc.tasks:
+                if not isinstance(task, MetaTask):
+                    continue
+                kind = self.find_launch_kind(task.initiation)
+                if kind is None:
+                    kind = 'Unattributed'
+                overhead = overheads.get(kind)
+                if overhead is None:
+                    overhead = [set(), 0, 0, {}]
+                    overheads[kind] = overhead
+                overhead[0].add(task.initiation)
+                overhead[1] += task.active_time()
+                name = task.variant.name
+                overhead[3][name] = overhead[3].get(name, 0) + task.active_time()
+        if not overheads:
+            return
+        for op in self.operations.itervalues():
+            if op.is_task and not op.is_meta and not op.is_proftask:
+                kind = self.find_launch_kind(op.op_id)
+                if kind in overheads:
+                    overheads[kind][2] += op.active_time()
+        print('****************************************************')
+        print('   RUNTIME OVERHEAD BY OPERATION KIND')
+        print('****************************************************')
+        for kind, (ops, overhead, app_time, by_meta) in \
+                sorted(overheads.iteritems(), key=lambda x: -x[1][1]):
+            print('  ' + kind)
+            print('       Operations: %d' % len(ops))
+            print('       Runtime Overhead: %d us (%.2f us per operation)' %
+                  (overhead, float(overhead) / len(ops)))
+            if app_time > 0:
+                print('       Application Time: %d us (overhead is %.2fx)' %
+                      (app_time, float(overhead) / app_time))
+            if verbose:
+                for name, time in sorted(by_meta.iteritems(),
+                                         key=lambda x: -x[1]):
+                    print('         %s: %d us' % (name, time))
+        print
+
     def print_task_stats(self, verbose):
         print('****************************************************')
         print('   TASK STATS')
@@ -1986,9 +2643,17 @@ class State(object):
 
     def print_stats(self, verbose):
         self.print_processor_stats(verbose)
+        self.print_gpu_device_stats(verbose)
         self.print_memory_stats(verbose)
         self.print_channel_stats(verbose)
+        self.print_message_stats(verbose)
+        self.print_mapper_call_stats(verbose)
+        self.print_task_window_stats(verbose)
+        self.print_runtime_memory_stats(verbose)
         self.print_task_stats(verbose)
+        self.print_meta_overhead_stats(verbose)
+        self.print_task_counter_stats(verbose)
+        self.print_critical_path_stats(verbose)
 
     def assign_colors(self):
         # Subtract out some colors for which we have special colors
@@ -2071,6 +2736,66 @@ class State(object):
                                     repr(tsv_file_name)))
         html_file.close()
 
+    def show_memory_timeline(self, output_prefix):
+        template_file_name = os.path.join(dirname(sys.argv[0]),
+                "legion_prof_mem.html.template")
+        html_file_name = output_prefix + ".html"
+        print('Generating memory timeline files %s_*.tsv and %s' % 
+              (output_prefix, html_file_name))
+        memories = list()
+        for mem in sorted(self.memories.itervalues()):
+            if not mem.instances:
+                continue
+            # Stack the live bytes by the kind of the creating operation
+            kinds = {}
+            for inst in mem.instances:
+                if inst.size is None:
+                    continue
+                kind = self.find_launch_kind(inst.initiation)
+                if kind is None:
+                    kind = 'Unattributed'
+                kinds.setdefault(kind, len(kinds))
+            live = [0] * len(kinds)
+            names = sorted(kinds.iterkeys(), key=lambda k: kinds[k])
+            tsv_file_name = '%s_%x.tsv' % (output_prefix, mem.mem_id)
+            with open(tsv_file_name, "w") as tsv_file:
+                tsv_file.write('time\t' + '\t'.join(names) + '\n')
+                tsv_file.write('0\t' + '\t'.join('0' for k in names) + '\n')
+                last_time = None
+                row = None
+                for point in sorted(mem.time_points, key=lambda p: p.time_key):
+                    inst = point.thing
+                    if inst.size is None:
+                        continue
+                    kind = self.find_launch_kind(inst.initiation)
+                    index = kinds['Unattributed' if kind is None else kind]
+                    live[index] += inst.size if point.first else -inst.size
+                    # Only the last change at any given time matters
+                    if point.time != last_time and row is not None:
+                        tsv_file.write(row)
+                    row = '%d\t%s\n' % (point.time, '\t'.join(map(str, live)))
+                    last_time = point.time
+                if row is not None:
+                    tsv_file.write(row)
+            events_file_name = '%s_%x_events.tsv' % (output_prefix, mem.mem_id)
+            with open(events_file_name, "w") as events_file:
+                events_file.write('time\tkind\ttitle\n')
+                for time, inst in sorted(mem.deletions, key=lambda d: d[0]):
+                    events_file.write('%d\t%s\t%s\n' % 
+                                      (time, inst.deletion, repr(inst)))
+            memories.append({ 'name' : repr(mem),
+                              'tsv' : tsv_file_name,
+                              'events' : events_file_name,
+                              'capacity' : mem.capacity,
+                              'end' : self.last_time })
+
+        template_file = open(template_file_name, "r")
+        template = template_file.read()
+        template_file.close()
+        html_file = open(html_file_name, "w")
+        html_file.write(template % json.dumps(memories))
+        html_file.close()
+
     def find_unique_dirname(self, dirname):
         if (not exists(dirname)):
             return dirname
@@ -2561,6 +3286,205 @@ class State(object):
             simplified_critical_path.add(p.get_unique_tuple())
         return list(simplified_critical_path)
 
+    # The following compute a critical path from the profiling data alone
+    # by walking backwards from the last thing to finish and always
+    # following whatever arrived last: an earlier stage of the same
+    # operation, an explicit dependence, the item that created it, or
+    # the item that was occupying its processor or channel
+    @staticmethod
+    def critical_path_owner(item):
+        if isinstance(item, Copy) or isinstance(item, Fill):
+            return item.chan
+        return item.proc
+
+    @staticmethod
+    def critical_path_node(item):
+        if isinstance(item, Copy) or isinstance(item, Fill):
+            return item.dst.node_id
+        return item.proc.node_id
+
+    @staticmethod
+    def critical_path_name(item):
+        if isinstance(item, Task):
+            kind = item.variant.task_kind
+            if kind is None:
+                return 'unnamed'
+            if kind.name is None:
+                return 'Task ' + str(kind.task_id)
+            return kind.name
+        if isinstance(item, MetaTask):
+            return item.variant.name
+        if isinstance(item, Copy):
+            return 'Copy'
+        if isinstance(item, Fill):
+            return 'Fill'
+        if isinstance(item, Message):
+            return item.kind.name
+        if isinstance(item, MapperCall):
+            return 'Mapper Call ' + item.kind.name
+        if isinstance(item, RuntimeCall):
+            return 'Runtime Call ' + item.kind.name
+        return 'Profiler'
+
+    def build_critical_path_index(self):
+        index = {
+            "ops" : {},                # op_id -> (stops, items)
+            "owners" : {},             # proc/chan -> (stops, items)
+            "spawners" : {},           # proc -> (starts, items, max duration)
+        }
+        items = []
+        for proc in self.processors.itervalues():
+            items.extend(proc.tasks)
+            ordered = sorted(proc.tasks, key=lambda i: i.start)
+            longest = max([i.stop - i.start for i in ordered] or [0])
+            index["spawners"][proc] = (map(lambda i: i.start, ordered), 
+                                       ordered, longest)
+        for chan in self.channels.itervalues():
+            items.extend(chan.copies)
+        for item in items:
+            op_id = None
+            if isinstance(item, Task):
+                op_id = item.op_id
+            elif isinstance(item, HasInitiationDependencies):
+                op_id = item.initiation
+            if op_id is not None:
+                if op_id not in index["ops"]:
+                    index["ops"][op_id] = []
+                index["ops"][op_id].append(item)
+            owner = State.critical_path_owner(item)
+            if owner not in index["owners"]:
+                index["owners"][owner] = []
+            index["owners"][owner].append(item)
+        for op_id, related in index["ops"].iteritems():
+            related.sort(key=lambda i: i.stop)
+            index["ops"][op_id] = (map(lambda i: i.stop, related), related)
+        for owner, owned in index["owners"].iteritems():
+            owned.sort(key=lambda i: i.stop)
+            index["owners"][owner] = (map(lambda i: i.stop, owned), owned)
+        return items, index
+
+    @staticmethod
+    def latest_before(stops, ordered, limit, visited):
+        # Latest item finishing no later than limit that is not on the path
+        i = bisect.bisect_right(stops, limit) - 1
+        while i >= 0 and ordered[i].prof_uid in visited:
+            i -= 1
+        if i < 0:
+            return None
+        return ordered[i]
+
+    def find_critical_predecessor(self, item, index, visited):
+        best, best_time = None, None
+        candidates = list()
+        # Earlier stages of the same operation
+        op_id = None
+        if isinstance(item, Task):
+            op_id = item.op_id
+        elif isinstance(item, HasInitiationDependencies):
+            op_id = item.initiation
+        if op_id is not None and op_id in index["ops"]:
+            stops, related = index["ops"][op_id]
+            candidates.append(State.latest_before(stops, related, item.start,
+                                                  visited))
+        # Explicit dependences from Legion Spy if they have been attached
+        for dep in item.deps["in"]:
+            if dep[-1] in self.prof_uid_map:
+                candidates.append(self.prof_uid_map[dep[-1]])
+        for pred in candidates:
+            if pred is None or pred.prof_uid in visited or \
+               not isinstance(pred, TimeRange) or pred.stop > item.start:
+                continue
+            if best is None or pred.stop > best_time:
+                best, best_time = pred, pred.stop
+        # Whatever was running on the same processor when we were created
+        proc = None if isinstance(item, Copy) or isinstance(item, Fill) \
+               else item.proc
+        if item.create is not None and proc in index["spawners"]:
+            starts, ordered, longest = index["spawners"][proc]
+            i = bisect.bisect_right(starts, item.create) - 1
+            while i >= 0 and starts[i] >= item.create - longest:
+                spawner = ordered[i]
+                if spawner is not item and spawner.stop >= item.create and \
+                   spawner.prof_uid not in visited:
+                    if best is None or item.create > best_time:
+                        best, best_time = spawner, item.create
+                    break
+                i -= 1
+        # If we were ready before the latest of those arrived, we were
+        # waiting on our processor or channel instead
+        stops, owned = index["owners"][State.critical_path_owner(item)]
+        busy = State.latest_before(stops, owned, item.start, visited)
+        if busy is not None and busy is not item:
+            ready = item.ready if item.ready is not None else item.start
+            if best is None or busy.stop >= max(best_time, ready):
+                best, best_time = busy, busy.stop
+        return best, best_time
+
+    def compute_critical_path_breakdown(self):
+        items, index = self.build_critical_path_index()
+        if len(items) == 0:
+            return None, None
+        last = max(items, key=lambda i: i.stop)
+        breakdown = defaultdict(long)
+        path = []
+        visited = set()
+        item, until = last, last.stop
+        while item is not None:
+            path.append(item)
+            visited.add(item.prof_uid)
+            breakdown[State.critical_path_name(item)] += until - item.start
+            pred, when = self.find_critical_predecessor(item, index, visited)
+            if pred is None:
+                break
+            if when < item.start:
+                # Split the gap into the time until we were ready to run 
+                # and the time spent waiting for resources after that
+                ready = item.ready if item.ready is not None else when
+                ready = min(max(ready, when), item.start)
+                if self.critical_path_node(pred) != \
+                   self.critical_path_node(item):
+                    breakdown['Message latency'] += ready - when
+                else:
+                    breakdown['Runtime latency'] += ready - when
+                breakdown['Queueing'] += item.start - ready
+            item, until = pred, when
+        path.reverse()
+        return path, breakdown
+
+    def critical_path_json(self, path):
+        # Same format as the path computed from the Legion Spy dependences
+        result = list()
+        for i,p in enumerate(path):
+            out = [path[i+1].get_unique_tuple()] if i+1 < len(path) else []
+            result.append({"tuple": p.get_unique_tuple(), "obj": out})
+        return result
+
+    def print_critical_path_stats(self, verbose):
+        path, breakdown = self.compute_critical_path_breakdown()
+        if path is None:
+            return
+        print('****************************************************')
+        print('   CRITICAL PATH')
+        print('****************************************************')
+        makespan = path[-1].stop - path[0].start
+        print('Critical path spans %d us (%d us to %d us) across %d items' % 
+              (makespan, path[0].start, path[-1].stop, len(path)))
+        if makespan == 0:
+            return
+        ranked = sorted(breakdown.iteritems(), key=lambda k: -k[1])
+        if not verbose:
+            ranked = ranked[:20]
+        for name, elapsed in ranked:
+            if elapsed == 0:
+                continue
+            print('  %-50s %12d us  %6.2f%%' % 
+                  (name, elapsed, 100.0 * elapsed / makespan))
+        if verbose:
+            print('Critical path items:')
+            for item in path:
+                print('  %12d - %12d us  %s' % 
+                      (item.start, item.stop, State.critical_path_name(item)))
+
 
     def emit_interactive_visualization(self, output_dirname, show_procs,
                                file_names, show_channels, show_instances, force):
@@ -2579,9 +3503,11 @@ class State(object):
         shutil.copytree(src_directory, output_dirname)
 
         proc_list = []
+        device_list = []
         chan_list = []
         mem_list = []
         processor_levels = {}
+        device_levels = {}
         channel_levels = {}
         memory_levels = {}
         base_level = 0
@@ -2651,6 +3577,20 @@ class State(object):
                     proc_list.append(proc)
 
                     last_time = max(last_time, proc.last_time)
+            for device in sorted(self.gpu_devices.itervalues()):
+                device_name = slugify("Device_" + str(hex(device.proc.proc_id)))
+                device_tsv_file_name = os.path.join(tsv_dir, device_name + ".tsv")
+                with open(device_tsv_file_name, "w") as device_tsv_file:
+                    device_tsv_file.write(data_tsv_header)
+                    device_level = device.emit_tsv(device_tsv_file, 0)
+                base_level += device_level
+                device_levels[device] = {
+                    'levels': device_level-1,
+                    'tsv': "tsv/" + device_name + ".tsv"
+                }
+                device_list.append(device)
+
+                last_time = max(last_time, device.last_time)
         if show_channels:
             for c,chan in sorted(self.channels.iteritems(), key=lambda x: x[1]):
                 if len(chan.copies) > 0:
@@ -2689,6 +3629,10 @@ class State(object):
             critical_path = self.compute_critical_path()
             # critical_path = self.simplify_critical_path(critical_path)
             # print("Critical path is " + str(critical_range.elapsed()) + "us")
+        else:
+            path, breakdown = self.compute_critical_path_breakdown()
+            if path is not None:
+                critical_path = self.critical_path_json(path)
 
         # print(str(op) + ", " + str(op.path) + ", " + str(op.path_range))
 
@@ -2705,6 +3649,11 @@ class State(object):
                 levels = processor_levels[proc]['levels']
                 processor_tsv_file.write("%s\t%s\t%s\t%d\n" % 
                                 (repr(proc), proc.get_short_text(), tsv, levels))
+            for device in sorted(device_list):
+                tsv = device_levels[device]['tsv']
+                levels = device_levels[device]['levels']
+                processor_tsv_file.write("%s\t%s\t%s\t%d\n" % 
+                                (repr(device), device.get_short_text(), tsv, levels))
         if show_channels:
             for channel in sorted(chan_list):
                 tsv = channel_levels[channel]['tsv']
@@ -2744,6 +3693,10 @@ def main():
     parser.add_argument(
         '-C', '--copy', dest='show_copy_matrix', action='store_true',
         help='include copy matrix in visualization')
+    parser.add_argument(
+        '-M', '--mem-timeline', dest='show_memory_timeline',
+        action='store_true',
+        help='include stacked timelines of live instances in each memory')
     parser.add_argument(
         '-s', '--statistics', dest='print_stats', action='store_true',
         help='print statistics')
@@ -2761,13 +3714,21 @@ def main():
     parser.add_argument(
         '-f', '--force', dest='force', action='store_true',
         help='overwrite output directory if it exists')
+    parser.add_argument(
+        '-j', '--jobs', dest='jobs', action='store',
+        type=int, default=1,
+        help='number of worker processes used to parse log files (default 1)')
+    parser.add_argument(
+        '--cache', dest='cache_dir', action='store', default=None,
+        help='directory holding parsed records of each log file so that '
+             'later runs over unchanged logs skip parsing')
     parser.add_argument(
         dest='filenames', nargs='+',
         help='input Legion Prof log filenames')
     args = parser.parse_args()
 
     file_names = args.filenames
-    show_all = not args.show_copy_matrix
+    show_all = not (args.show_copy_matrix or args.show_memory_timeline)
     show_procs = show_all
     show_channels = show_all
     show_instances = show_all
@@ -2775,8 +3736,12 @@ def main():
     force = args.force
     output_dirname = args.output
     copy_output_prefix = output_dirname + "_copy"
+    show_memory_timeline = args.show_memory_timeline
+    mem_output_prefix = output_dirname + "_mem"
     print_stats = args.print_stats
     verbose = args.verbose
+    jobs = max(args.jobs, 1)
+    cache_dir = args.cache_dir
 
     state = State()
     has_matches = False
@@ -2791,26 +3756,51 @@ def main():
             has_binary_files = True
             break
 
-    for file_name in file_names:
-        deserializer = None
-        file_type, version = GetFileTypeInfo(file_name)
-        if file_type == "binary":
-            deserializer = binaryDeserializer
-        else:
-            deserializer = asciiDeserializer
-        if has_binary_files == False or file_type == "binary":
-            # only parse the log if it's a binary file, or if all the files
-            # are ascii files
-            print('Reading log file %s...' % file_name)
-            total_matches = deserializer.parse(file_name, verbose)
-            print('Matched %s objects' % total_matches)
-            if total_matches > 0:
-                has_matches = True
+    if jobs > 1 or cache_dir is not None:
+        # Parse every file into columnar records in separate processes
+        # and then merge them into the state by time
+        if cache_dir is not None and not exists(cache_dir):
+            os.makedirs(cache_dir)
+        work = []
+        for file_name in file_names:
+            file_type, version = GetFileTypeInfo(file_name)
+            parse = has_binary_files == False or file_type == "binary"
+            work.append((file_name, parse, verbose, cache_dir))
+        if jobs > 1:
+            pool = multiprocessing.Pool(min(jobs, len(work)))
+            try:
+                collectors = pool.map(collect_log_records, work, chunksize=1)
+            finally:
+                pool.close()
+                pool.join()
         else:
-            # In this case, we have an ascii file passed in but we also have
-            # binary files. All we need to do is check if it has legion spy
-            # data
-            deserializer.search_for_spy_data(file_name)
+            collectors = map(collect_log_records, work)
+        for collector in collectors:
+            if collector.matches > 0:
+                print('Matched %s objects in %s' % 
+                      (collector.matches, collector.filename))
+        has_matches = replay_log_records(collectors, state) > 0
+    else:
+        for file_name in file_names:
+            deserializer = None
+            file_type, version = GetFileTypeInfo(file_name)
+            if file_type == "binary":
+                deserializer = binaryDeserializer
+            else:
+                deserializer = asciiDeserializer
+            if has_binary_files == False or file_type == "binary":
+                # only parse the log if it's a binary file, or if all the files
+                # are ascii files
+                print('Reading log file %s...' % file_name)
+                total_matches = deserializer.parse(file_name, verbose)
+                print('Matched %s objects' % total_matches)
+                if total_matches > 0:
+                    has_matches = True
+            else:
+                # In this case, we have an ascii file passed in but we also have
+                # binary files. All we need to do is check if it has legion spy
+                # data
+                deserializer.search_for_spy_data(file_name)
 
     if not has_matches:
         print('No matches found! Exiting...')
@@ -2826,6 +3816,8 @@ def main():
                              file_names, show_channels, show_instances, force)
         if show_copy_matrix:
             state.show_copy_matrix(copy_output_prefix)
+        if show_memory_timeline:
+            state.show_memory_timeline(mem_output_prefix)
 
 if __name__ == '__main__':
     start = time.time()
@@ -16,11 +16,14 @@
 
 from __future__ import print_function
 import inspect
+import heapq
 import re
 import struct
 import legion_spy
 import gzip
 import io
+import os
+import cPickle as pickle
 
 binary_filetype_pat = re.compile(r"FileType: BinaryLegionProf v: (?P<version>\d+(\.\d+)?)")
 
@@ -71,6 +74,7 @@ class LegionProfASCIIDeserializer(LegionDeserializer):
         "OpDesc": re.compile(prefix + r'Prof Op Desc (?P<kind>[0-9]+) (?P<name>[a-zA-Z0-9_ ]+)'),
         "ProcDesc": re.compile(prefix + r'Prof Proc Desc (?P<proc_id>[a-f0-9]+) (?P<kind>[0-9]+)'),
         "MemDesc": re.compile(prefix + r'Prof Mem Desc (?P<mem_id>[a-f0-9]+) (?P<kind>[0-9]+) (?P<capacity>[0-9]+)'),
+        "AllocDesc": re.compile(prefix + r'Prof Alloc Desc (?P<kind>[0-9]+) (?P<name>[a-zA-Z0-9_ ]+)'),
         "TaskKind": re.compile(prefix + r'Prof Task Kind (?P<task_id>[0-9]+) (?P<name>[$()a-zA-Z0-9_<>.]+) (?P<overwrite>[0-1])'),
         "TaskVariant": re.compile(prefix + r'Prof Task Variant (?P<task_id>[0-9]+) (?P<variant_id>[0-9]+) (?P<name>[$()a-zA-Z0-9_<>.]+)'),
         "OperationInstance": re.compile(prefix + r'Prof Operation (?P<op_id>[0-9]+) (?P<kind>[0-9]+)'),
@@ -79,14 +83,22 @@ class LegionProfASCIIDeserializer(LegionDeserializer):
         "TaskWaitInfo": re.compile(prefix + r'Prof Task Wait Info (?P<op_id>[0-9]+) (?P<variant_id>[0-9]+) (?P<wait_start>[0-9]+) (?P<wait_ready>[0-9]+) (?P<wait_end>[0-9]+)'),
         "MetaWaitInfo": re.compile(prefix + r'Prof Meta Wait Info (?P<op_id>[0-9]+) (?P<lg_id>[0-9]+) (?P<wait_start>[0-9]+) (?P<wait_ready>[0-9]+) (?P<wait_end>[0-9]+)'),
         "TaskInfo": re.compile(prefix + r'Prof Task Info (?P<op_id>[0-9]+) (?P<variant_id>[0-9]+) (?P<proc_id>[a-f0-9]+) (?P<create>[0-9]+) (?P<ready>[0-9]+) (?P<start>[0-9]+) (?P<stop>[0-9]+)'),
+        "TaskCounterInfo": re.compile(prefix + r'Prof Task Counters (?P<op_id>[0-9]+) (?P<instructions>-?[0-9]+) (?P<cycles>-?[0-9]+) (?P<l2_accesses>-?[0-9]+) (?P<l2_misses>-?[0-9]+) (?P<l3_accesses>-?[0-9]+) (?P<l3_misses>-?[0-9]+) (?P<stalled_cycles>-?[0-9]+)'),
+        "GPUActivityInfo": re.compile(prefix + r'Prof GPU Activity (?P<op_id>[0-9]+) (?P<proc_id>[a-f0-9]+) (?P<stream>[0-9]+) (?P<kind>[0-9]+) (?P<bytes>[0-9]+) (?P<start>[0-9]+) (?P<stop>[0-9]+)'),
         "MetaInfo": re.compile(prefix + r'Prof Meta Info (?P<op_id>[0-9]+) (?P<lg_id>[0-9]+) (?P<proc_id>[a-f0-9]+) (?P<create>[0-9]+) (?P<ready>[0-9]+) (?P<start>[0-9]+) (?P<stop>[0-9]+)'),
         "CopyInfo": re.compile(prefix + r'Prof Copy Info (?P<op_id>[0-9]+) (?P<src>[a-f0-9]+) (?P<dst>[a-f0-9]+) (?P<size>[0-9]+) (?P<create>[0-9]+) (?P<ready>[0-9]+) (?P<start>[0-9]+) (?P<stop>[0-9]+)'),
         "FillInfo": re.compile(prefix + r'Prof Fill Info (?P<op_id>[0-9]+) (?P<dst>[a-f0-9]+) (?P<create>[0-9]+) (?P<ready>[0-9]+) (?P<start>[0-9]+) (?P<stop>[0-9]+)'),
         "InstCreateInfo": re.compile(prefix + r'Prof Inst Create (?P<op_id>[0-9]+) (?P<inst_id>[a-f0-9]+) (?P<create>[0-9]+)'),
         "InstUsageInfo": re.compile(prefix + r'Prof Inst Usage (?P<op_id>[0-9]+) (?P<inst_id>[a-f0-9]+) (?P<mem_id>[a-f0-9]+) (?P<size>[0-9]+)'),
         "InstTimelineInfo": re.compile(prefix + r'Prof Inst Timeline (?P<op_id>[0-9]+) (?P<inst_id>[a-f0-9]+) (?P<create>[0-9]+) (?P<destroy>[0-9]+)'),
+        "InstFieldInfo": re.compile(prefix + r'Prof Inst Field (?P<op_id>[0-9]+) (?P<inst_id>[a-f0-9]+) (?P<fspace_id>[0-9]+) (?P<field_id>[0-9]+) (?P<size>[0-9]+)'),
+        "InstDeletionInfo": re.compile(prefix + r'Prof Inst Deletion (?P<inst_id>[a-f0-9]+) (?P<mem_id>[a-f0-9]+) (?P<evicted>[0-9]+) (?P<time>[0-9]+)'),
+        "MemUsageInfo": re.compile(prefix + r'Prof Mem Usage (?P<mem_id>[a-f0-9]+) (?P<mapper_id>[0-9]+) (?P<mapper_bytes>[0-9]+) (?P<task_id>[0-9]+) (?P<task_bytes>[0-9]+) (?P<time>[0-9]+)'),
+        "TaskWindowInfo": re.compile(prefix + r'Prof Task Window (?P<op_id>[0-9]+) (?P<window_size>[0-9]+) (?P<analysis_lag>[0-9]+) (?P<execution_lag>[0-9]+) (?P<time>[0-9]+)'),
+        "RuntimeMemoryInfo": re.compile(prefix + r'Prof Runtime Memory (?P<node>[0-9]+) (?P<kind>[0-9]+) (?P<bytes>[0-9]+) (?P<allocations>[0-9]+) (?P<time>[0-9]+)'),
         "MessageInfo": re.compile(prefix + r'Prof Message Info (?P<kind>[0-9]+) (?P<proc_id>[a-f0-9]+) (?P<start>[0-9]+) (?P<stop>[0-9]+)'),
-        "MapperCallInfo": re.compile(prefix + r'Prof Mapper Call Info (?P<kind>[0-9]+) (?P<proc_id>[a-f0-9]+) (?P<op_id>[0-9]+) (?P<start>[0-9]+) (?P<stop>[0-9]+)'),
+        "MessageStatsInfo": re.compile(prefix + r'Prof Message Stats (?P<source>[0-9]+) (?P<target>[0-9]+) (?P<kind>[0-9]+) (?P<count>[0-9]+) (?P<total_bytes>[0-9]+) (?P<latency>[0-9]+(?: [0-9]+)*)'),
+        "MapperCallInfo": re.compile(prefix + r'Prof Mapper Call Info (?P<kind>[0-9]+) (?P<proc_id>[a-f0-9]+) (?P<op_id>[0-9]+) (?P<start>[0-9]+) (?P<stop>[0-9]+) (?P<mapper_id>[0-9]+) (?P<mapper_proc>[a-f0-9]+) (?P<wait>[0-9]+)'),
         "RuntimeCallInfo": re.compile(prefix + r'Prof Runtime Call Info (?P<kind>[0-9]+) (?P<proc_id>[a-f0-9]+) (?P<start>[0-9]+) (?P<stop>[0-9]+)'),
         "ProfTaskInfo": re.compile(prefix + r'Prof ProfTask Info (?P<proc_id>[a-f0-9]+) (?P<op_id>[0-9]+) (?P<start>[0-9]+) (?P<stop>[0-9]+)')
         # "UserInfo": re.compile(prefix + r'Prof User Info (?P<proc_id>[a-f0-9]+) (?P<start>[0-9]+) (?P<stop>[0-9]+) (?P<name>[$()a-zA-Z0-9_]+)')
@@ -101,9 +113,35 @@ class LegionProfASCIIDeserializer(LegionDeserializer):
         "uid": int,
         "overwrite": int,
         "task_id": int,
+        "mapper_id": int,
+        "mapper_bytes": long,
+        "task_bytes": long,
+        "window_size": int,
+        "analysis_lag": read_time,
+        "execution_lag": read_time,
+        "node": int,
+        "bytes": long,
+        "allocations": long,
+        "source": int,
+        "target": int,
+        "count": long,
+        "total_bytes": long,
+        "latency": lambda x: [long(v) for v in x.split()],
         "kind": int,
         "opkind": int,
+        "instructions": long,
+        "cycles": long,
+        "l2_accesses": long,
+        "l2_misses": long,
+        "l3_accesses": long,
+        "l3_misses": long,
+        "stalled_cycles": long,
+        "stream": int,
+        "fspace_id": int,
+        "field_id": int,
+        "evicted": int,
         "proc_id": lambda x: int(x, 16),
+        "mapper_proc": lambda x: int(x, 16),
         "mem_id": lambda x: int(x, 16),
         "src": lambda x: int(x, 16),
         "dst": lambda x: int(x, 16),
@@ -117,6 +155,8 @@ class LegionProfASCIIDeserializer(LegionDeserializer):
         "wait_start": read_time,
         "wait_ready": read_time,
         "wait_end": read_time,
+        "wait": read_time,
+        "time": read_time,
         "name": lambda x: x,
         "desc": lambda x: x
     }
@@ -195,11 +235,14 @@ class LegionProfBinaryDeserializer(LegionDeserializer):
         "InstID":             "Q", # unsigned long long
         "UniqueID":           "Q", # unsigned long long
         "TaskID":             "I", # unsigned int
+        "MapperID":           "I", # unsigned int
+        "AddressSpaceID":     "I", # unsigned int
         "bool":               "?", # bool
         "VariantID":          "L", # unsigned long
         "unsigned":           "I", # unsigned int
         "timestamp_t":        "Q", # unsigned long long
         "unsigned long long": "Q", # unsigned long long
+        "long long":          "q", # long long
         "ProcKind":           "i", # int (really an enum so this depends)
         "MemKind":            "i", # int (really an enum so this depends)
         "MessageKind":        "i", # int (really an enum so this depends)
@@ -308,3 +351,154 @@ def GetFileTypeInfo(filename):
         else:
             filetype = "ascii" # assume if not binary, it's ascii
     return filetype, version
+
+class LegionProfRecordCollector(object):
+    """
+    Collects the records of one log file in columnar form instead of
+    applying them to a State object directly. Each record kind keeps one
+    list per field, and the order in which records appeared in the file
+    is kept separately so that they can be replayed faithfully later.
+    Collectors are what the parallel workers send back to the main
+    process and what the incremental mode caches on disk.
+    """
+    # Fields used to place a record on the global timeline when merging
+    # the records of several files; records with none of these fields
+    # (descriptors) sort before everything else
+    time_fields = ("create", "start", "time", "wait_start")
+
+    def __init__(self, filename):
+        self.filename = filename
+        self.has_spy_data = False
+        self.matches = 0
+        self.columns = {}
+        self.order = []
+        self.callbacks = {}
+        for name in LegionProfASCIIDeserializer.patterns:
+            self.callbacks[name] = self.make_callback(name)
+
+    def make_callback(self, name):
+        def collect(**kwargs):
+            columns = self.columns.get(name)
+            if columns is None:
+                columns = {}
+                for field in kwargs:
+                    columns[field] = []
+                self.columns[name] = columns
+            for field, value in kwargs.iteritems():
+                columns[field].append(value)
+            self.order.append(name)
+        return collect
+
+    def __getstate__(self):
+        # The callbacks are closures and cannot be pickled
+        state = self.__dict__.copy()
+        del state['callbacks']
+        return state
+
+    def __setstate__(self, state):
+        self.__dict__.update(state)
+        self.callbacks = {}
+
+    def records(self, file_index):
+        """Yield the records in file order as (time, file_index, seq, name,
+        kwargs) tuples suitable for heapq.merge across files"""
+        fields = {}
+        time_field = {}
+        for name, columns in self.columns.iteritems():
+            fields[name] = columns.keys()
+            time_field[name] = None
+            for field in LegionProfRecordCollector.time_fields:
+                if field in columns:
+                    time_field[name] = field
+                    break
+        offsets = dict.fromkeys(self.columns, 0)
+        # The running time never decreases so that every stream handed
+        # to heapq.merge stays sorted even when a file interleaves
+        # descriptors with timed records
+        current = 0L
+        for seq, name in enumerate(self.order):
+            index = offsets[name]
+            offsets[name] = index + 1
+            columns = self.columns[name]
+            kwargs = {}
+            for field in fields[name]:
+                kwargs[field] = columns[field][index]
+            if time_field[name] is not None:
+                current = max(current, kwargs[time_field[name]])
+            yield (current, file_index, seq, name, kwargs)
+
+    def save(self, path):
+        stat = os.stat(self.filename)
+        with open(path, 'wb') as f:
+            pickle.dump((stat.st_size, stat.st_mtime), f, 
+                        pickle.HIGHEST_PROTOCOL)
+            pickle.dump(self, f, pickle.HIGHEST_PROTOCOL)
+
+    @staticmethod
+    def load(path, filename):
+        """Return the cached collector for filename or None if the cache
+        is missing or was produced from a different version of the file"""
+        if not os.path.exists(path):
+            return None
+        stat = os.stat(filename)
+        try:
+            with open(path, 'rb') as f:
+                if pickle.load(f) != (stat.st_size, stat.st_mtime):
+                    return None
+                collector = pickle.load(f)
+        except (EOFError, pickle.UnpicklingError):
+            return None
+        collector.filename = filename
+        return collector
+
+def collect_log_records(job):
+    """
+    Parse one log file into a LegionProfRecordCollector. This runs in a
+    worker process so it only takes and returns picklable objects.
+
+    @param[job]: a (filename, parse, verbose, cache_dir) tuple. When parse
+                 is False the file is only searched for Legion Spy data.
+                 When cache_dir is not None the columnar records are read
+                 from or written to an intermediate file in that directory.
+    """
+    filename, parse, verbose, cache_dir = job
+    cache_path = None
+    if parse and cache_dir is not None:
+        cache_path = os.path.join(cache_dir, 
+                                  os.path.basename(filename) + '.records')
+        collector = LegionProfRecordCollector.load(cache_path, filename)
+        if collector is not None:
+            print('Loaded cached records for %s' % filename)
+            return collector
+    collector = LegionProfRecordCollector(filename)
+    file_type, version = GetFileTypeInfo(filename)
+    if file_type == "binary":
+        deserializer = LegionProfBinaryDeserializer(collector, 
+                                                    collector.callbacks)
+    else:
+        deserializer = LegionProfASCIIDeserializer(collector, 
+                                                   collector.callbacks)
+    if parse:
+        print('Reading log file %s...' % filename)
+        collector.matches = deserializer.parse(filename, verbose)
+        if cache_path is not None:
+            collector.save(cache_path)
+    else:
+        deserializer.search_for_spy_data(filename)
+    return collector
+
+def replay_log_records(collectors, state):
+    """
+    Apply the records of several collectors to a State object, merging
+    the files by time while keeping the order of records within a file.
+    Returns the total number of records applied.
+    """
+    matches = 0
+    streams = [c.records(i) for i,c in enumerate(collectors)]
+    for time, file_index, seq, name, kwargs in heapq.merge(*streams):
+        state.callbacks[name](**kwargs)
+        matches += 1
+    for collector in collectors:
+        if collector.has_spy_data:
+            state.has_spy_data = True
+    return matches
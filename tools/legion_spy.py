@@ -8730,6 +8730,65 @@ barrier_arrive_pat      = re.compile(
 barrier_wait_pat        = re.compile(
     prefix+"Phase Barrier Wait (?P<uid>[0-9]+) (?P<iid>[0-9a-f]+)")
 
+binary_magic = 'LegionSpyBinary'
+binary_conversion_pat = re.compile(
+    "%([-+ #0-9.]*)(?:ll|l|z|j|t|hh|h)?([diuxXocfegsp])")
+binary_arg_formats = { 'i' : '=i', 'I' : '=I', 'q' : '=q', 'Q' : '=Q',
+                       'd' : '=d', 's' : '=I' }
+
+def convert_binary_conversion(match):
+    conversion = match.group(2)
+    if conversion in 'iu':
+        conversion = 'd'
+    elif conversion == 'p':
+        return '0x%' + match.group(1) + 'x'
+    return '%' + match.group(1) + conversion
+
+def read_binary_log_lines(log):
+    # See the description of the format at the top of legion_spy.cc
+    header = log.readline().split()
+    assert header[0] == binary_magic and header[1] == '1'
+    node = int(header[2])
+    formats = dict()
+    strings = collections.defaultdict(dict)
+    while True:
+        kind = log.read(1)
+        if not kind:
+            break
+        if kind == b'F':
+            fmt_id,length = struct.unpack('=HH', log.read(4))
+            types = log.read(length)
+            length, = struct.unpack('=H', log.read(2))
+            fmt = log.read(length)
+            fmt = binary_conversion_pat.sub(convert_binary_conversion, fmt)
+            arg_formats = [struct.Struct(binary_arg_formats[t]) for t in types]
+            formats[fmt_id] = (fmt, types, arg_formats)
+            continue
+        assert kind == b'C'
+        thread,length = struct.unpack('=II', log.read(8))
+        chunk = log.read(length)
+        thread_strings = strings[thread]
+        prefix = '[%d - %x] {2}{legion_spy}: ' % (node, thread)
+        offset = 0
+        while offset < length:
+            fmt_id, = struct.unpack_from('=H', chunk, offset)
+            offset += 2
+            if fmt_id == 0:
+                string_id,size = struct.unpack_from('=IH', chunk, offset)
+                offset += 6
+                thread_strings[string_id] = chunk[offset:offset+size]
+                offset += size
+                continue
+            fmt,types,arg_formats = formats[fmt_id]
+            args = list()
+            for t,arg_format in zip(types, arg_formats):
+                value, = arg_format.unpack_from(chunk, offset)
+                offset += arg_format.size
+                if t == 's':
+                    value = thread_strings[value]
+                args.append(value)
+            yield prefix + (fmt % tuple(args))
+
 def parse_legion_spy_line(line, state):
     # Quick test to see if the line is even worth considering
     m = prefix_pat.match(line)
@@ -9606,7 +9665,7 @@ class State(object):
     def parse_log_file(self, file_name):
         print('Reading log file %s...' % file_name)
         try:
-            log = open(file_name, 'r')
+            log = open(file_name, 'rb')
         except:
             print('ERROR: Unable to find file '+file_name)
             print('Legion Spy will now exit')
@@ -9615,7 +9674,10 @@ class State(object):
             with log:
                 matches = 0
                 skipped = 0
-                for line in log:
+                is_binary = log.read(len(binary_magic)) == binary_magic
+                log.seek(0)
+                lines = read_binary_log_lines(log) if is_binary else log
+                for line in lines:
                     if parse_legion_spy_line(line, self):
                         matches += 1
                     else:
@@ -0,0 +1,280 @@
+#!/usr/bin/env python
+
+# Copyright 2017 Stanford University
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+###
+### Strong and weak scaling sweeps of the circuit and CG solver examples
+###
+
+# Each configuration (application, scaling mode, node count, GPUs per
+# node, problem size, tracing on/off) is run once, either through
+# perf.py (the default, which uploads the measurements like test.py
+# does) or directly with --no-upload, in which case the measurements
+# are only printed. Both applications report ELAPSED TIME and
+# ITERATION TIME, which are the measurements recorded here.
+#
+# Multi-node runs need a launcher; any occurrence of {nodes} in it is
+# replaced by the node count, e.g.:
+#
+#   ./tools/scaling.py --nodes 1,2,4 --gpus 0,1 \
+#       --launcher 'mpirun -n {nodes} -npernode 1 --bind-to none'
+
+from __future__ import print_function
+
+import argparse, json, os, re, subprocess
+
+root_dir = os.path.dirname(os.path.dirname(os.path.realpath(__file__)))
+
+measurement_patterns = {
+    'time_seconds': r'^ELAPSED TIME\s*=\s*(.*) s$',
+    'iteration_us': r'^ITERATION TIME\s*=\s*(.*) us$',
+}
+
+def decode(output):
+    return output if isinstance(output, str) else output.decode('utf-8')
+
+def cmd(command, env=None, cwd=None):
+    print(' '.join(command))
+    return decode(subprocess.check_output(command, env=env, cwd=cwd))
+
+def hostname():
+    return decode(subprocess.check_output(['hostname'])).strip()
+
+def git_commit_id(repo_dir):
+    return decode(subprocess.check_output(
+        ['git', 'rev-parse', 'HEAD'], cwd=repo_dir)).strip()
+
+def git_branch_name(repo_dir):
+    proc = subprocess.Popen(
+        ['git', 'symbolic-ref', '--short', 'HEAD'], cwd=repo_dir,
+        stdin=subprocess.PIPE, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    output, errors = proc.communicate()
+    if proc.returncode == 0:
+        return decode(output).strip()
+    return None
+
+def int_list(value):
+    return [int(x) for x in value.split(',') if x]
+
+# Each application maps a configuration to its command line flags, or
+# None if the problem can't be divided evenly for that configuration.
+# The size is per unit of parallelism (see below) for weak scaling and
+# for the whole machine for strong scaling.
+
+def circuit_flags(mode, nodes, gpus, size, args):
+    # size is circuit nodes (with 4 wires per circuit node), and each GPU
+    # or CPU gets pieces_per_unit pieces
+    units = nodes * (gpus if gpus > 0 else args.cpus)
+    pieces = units * args.pieces_per_unit
+    if mode == 'weak':
+        npp = size
+    else:
+        if size % pieces != 0:
+            return None
+        npp = size // pieces
+    return ['-l', str(args.iterations), '-p', str(pieces),
+            '-npp', str(npp), '-wpp', str(4 * npp)]
+
+def cgsolver_flags(mode, nodes, gpus, size, args):
+    # size is the edge length of the grid, cut along x into one block per
+    # shard (a GPU, or a whole node when using CPUs)
+    units = nodes * max(gpus, 1)
+    if mode == 'weak':
+        gx, bx = size * units, size
+    else:
+        if size % units != 0:
+            return None
+        gx, bx = size, size // units
+    flags = ['-m', str(args.iterations), '-r', '0',
+             '-gx', str(gx), '-gy', str(size), '-gz', str(size),
+             '-bx', str(bx), '-by', str(size), '-bz', str(size)]
+    if gpus > 0:
+        # one shard per GPU, each of which also needs a CPU of its own
+        flags.append('-gpu')
+    return flags
+
+apps = {
+    'circuit': ('examples/circuit/circuit', circuit_flags),
+    'cgsolver': ('examples/spmd_cgsolver/spmd_cgsolver', cgsolver_flags),
+}
+
+def app_command(app, mode, nodes, gpus, size, tracing, args):
+    app_file, make_flags = apps[app]
+    flags = make_flags(mode, nodes, gpus, size, args)
+    if flags is None:
+        return None
+    flags.extend(['-t', '1' if tracing else '0'])
+    flags.extend(['-ll:cpu', str(max(args.cpus, gpus))])
+    if gpus > 0:
+        flags.extend(['-ll:gpu', str(gpus)])
+        flags.extend(args.gpu_flags.split())
+    return [os.path.join(root_dir, app_file)] + flags + args.extra_flags.split()
+
+def build(app, env, thread_count):
+    app_dir = os.path.dirname(os.path.join(root_dir, apps[app][0]))
+    cmd(['make', '-C', app_dir, '-j', str(thread_count)], env=env)
+
+def run_local(launcher, command, env):
+    output = cmd(launcher + command, env=env, cwd=os.path.dirname(command[0]))
+    result = {}
+    for name, pattern in measurement_patterns.items():
+        match = re.search(pattern, output, re.MULTILINE)
+        result[name] = match.group(1).strip() if match else None
+    return result
+
+def run_perf(launcher, command, metadata, env):
+    measurements = {
+        'benchmark': {
+            'type': 'argv',
+            'index': 0,
+            'filter': 'basename',
+        },
+        'argv': {
+            'type': 'argv',
+            'start': 1,
+        },
+    }
+    for name, pattern in measurement_patterns.items():
+        measurements[name] = {
+            'type': 'regex',
+            'pattern': pattern,
+            'multiline': True,
+        }
+    perf_env = dict(list(env.items()) + [
+        ('PERF_OWNER', 'StanfordLegion'),
+        ('PERF_REPOSITORY', 'perf-data'),
+        ('PERF_METADATA', json.dumps(metadata)),
+        ('PERF_MEASUREMENTS', json.dumps(measurements)),
+        ('PERF_LAUNCHER', ' '.join(launcher)),
+    ])
+    subprocess.check_call([os.path.join(root_dir, 'perf.py')] + command,
+                          env=perf_env, cwd=os.path.dirname(command[0]))
+
+def driver():
+    parser = argparse.ArgumentParser(
+        description='Strong/weak scaling sweeps of circuit and spmd_cgsolver')
+    parser.add_argument(
+        '--app', dest='apps', action='append', choices=sorted(apps.keys()),
+        default=None,
+        help='Applications to run (default: all).')
+    parser.add_argument(
+        '--mode', dest='modes', action='append', choices=['strong', 'weak'],
+        default=None,
+        help='Scaling modes to run (default: both).')
+    parser.add_argument(
+        '--nodes', type=int_list, default=[1],
+        help='Comma-separated node counts.')
+    parser.add_argument(
+        '--gpus', type=int_list, default=[0],
+        help='Comma-separated GPUs per node (0 runs on CPUs only).')
+    parser.add_argument(
+        '--sizes', type=int_list, default=None,
+        help='Comma-separated problem sizes (default depends on app).')
+    parser.add_argument(
+        '--iterations', type=int, default=20,
+        help='Iterations (circuit loops, CG iterations) per run.')
+    parser.add_argument(
+        '--cpus', type=int, default=4,
+        help='CPU processors per node.')
+    parser.add_argument(
+        '--pieces-per-unit', dest='pieces_per_unit', type=int, default=1,
+        help='Circuit pieces per GPU (or per node when using CPUs).')
+    parser.add_argument(
+        '--gpu-flags', dest='gpu_flags',
+        default='-ll:fsize 4096 -ll:zsize 1024',
+        help='Extra flags for runs with GPUs.')
+    parser.add_argument(
+        '--flags', dest='extra_flags', default='',
+        help='Extra flags for every run.')
+    parser.add_argument(
+        '--launcher', default=os.environ.get('LAUNCHER', ''),
+        help='Launcher, with {nodes} replaced by the node count (also via LAUNCHER).')
+    parser.add_argument(
+        '--no-upload', dest='upload', action='store_false',
+        help='Run directly and print measurements instead of using perf.py.')
+    parser.add_argument(
+        '--no-build', dest='build', action='store_false',
+        help='Skip building the applications.')
+    parser.add_argument(
+        '-j', dest='thread_count', type=int, default=4,
+        help='Number of threads used to build.')
+    args = parser.parse_args()
+
+    selected_apps = args.apps or sorted(apps.keys())
+    modes = args.modes or ['strong', 'weak']
+    default_sizes = {
+        'circuit': [1 << 12, 1 << 16],
+        'cgsolver': [64, 128],
+    }
+
+    if max(args.nodes) > 1 and not args.launcher:
+        raise Exception('Multi-node runs need a launcher (use --launcher or LAUNCHER)')
+
+    env = dict(list(os.environ.items()) + [
+        ('DEBUG', '0'),
+        ('LG_RT_DIR', os.path.join(root_dir, 'runtime'))] + (
+        [('USE_CUDA', '1')] if max(args.gpus) > 0 else []))
+
+    if args.build:
+        for app in selected_apps:
+            build(app, env, args.thread_count)
+
+    metadata = {
+        'host': os.environ.get('CI_RUNNER_DESCRIPTION') or hostname(),
+        'commit': os.environ.get('CI_BUILD_REF') or git_commit_id(root_dir),
+        'branch': os.environ.get('CI_BUILD_REF_NAME') or git_branch_name(root_dir),
+    }
+
+    results = []
+    for app in selected_apps:
+        for mode in modes:
+            for size in (args.sizes or default_sizes[app]):
+                for nodes in args.nodes:
+                    for gpus in args.gpus:
+                        for tracing in [False, True]:
+                            command = app_command(app, mode, nodes, gpus, size,
+                                                  tracing, args)
+                            if command is None:
+                                print('Skipping %s %s scaling: size %d does not divide over %d nodes x %d GPUs' %
+                                      (app, mode, size, nodes, gpus))
+                                continue
+                            launcher = args.launcher.replace('{nodes}', str(nodes)).split()
+                            config = {
+                                'scaling': mode,
+                                'nodes': nodes,
+                                'gpus_per_node': gpus,
+                                'size': size,
+                                'tracing': tracing,
+                            }
+                            if args.upload:
+                                run_perf(launcher, command,
+                                         dict(list(metadata.items()) + list(config.items())),
+                                         env)
+                            else:
+                                result = run_local(launcher, command, env)
+                                results.append((app, config, result))
+
+    if not args.upload:
+        print()
+        print('app,scaling,nodes,gpus_per_node,size,tracing,time_seconds,iteration_us')
+        for app, config, result in results:
+            print('%s,%s,%d,%d,%d,%d,%s,%s' % (
+                app, config['scaling'], config['nodes'], config['gpus_per_node'],
+                config['size'], 1 if config['tracing'] else 0,
+                result['time_seconds'], result['iteration_us']))
+
+if __name__ == '__main__':
+    driver()